@@ -1229,3 +1229,49 @@ BM_Action_trx_sig_digest(benchmark::State& state) {
     state.SetItemsProcessed(state.iterations());
 }
 BENCHMARK(BM_Action_trx_sig_digest)->Range(1, 8 << 10);
+
+namespace {
+
+template<uint64_t>
+struct version_invoker {
+    template<typename T>
+    static int
+    invoke(int base) {
+        return base + T::get_version();
+    }
+};
+
+static const name bm_act_names[] = { N(transfer), N(transferft), N(everipay), N(newdomain), N(paycharge), N(addmeta) };
+
+template<typename ExecCtx>
+void
+run_dispatch(benchmark::State& state, const ExecCtx& exec_ctx) {
+    auto sum = 0;
+    for(auto _ : state) {
+        for(auto& act : bm_act_names) {
+            auto i = exec_ctx.index_of(act);
+            sum += exec_ctx.template invoke<version_invoker, int>(i, 1);
+        }
+    }
+    benchmark::DoNotOptimize(sum);
+    state.SetItemsProcessed(state.iterations() * std::size(bm_act_names));
+}
+
+}  // namespace
+
+// index_of by binary search and dispatch by walking hana tuple
+static void
+BM_ExecCtx_dispatch_mock(benchmark::State& state) {
+    run_dispatch(state, get_exec_ctx());
+}
+BENCHMARK(BM_ExecCtx_dispatch_mock);
+
+// index_of by perfect hash and dispatch by function table
+static void
+BM_ExecCtx_dispatch(benchmark::State& state) {
+    auto tester = create_tester();
+    auto& exec_ctx = static_cast<evt_execution_context&>(tester->control->get_execution_context());
+
+    run_dispatch(state, exec_ctx);
+}
+BENCHMARK(BM_ExecCtx_dispatch);
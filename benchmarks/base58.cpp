@@ -0,0 +1,62 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+
+#include <benchmark/benchmark.h>
+#include <fc/crypto/base58.hpp>
+#include <fc/crypto/private_key.hpp>
+#include <fc/crypto/public_key.hpp>
+
+/*
+ * Benchmarks for the base58 conversions of keys
+ */
+
+using namespace fc;
+using namespace fc::crypto;
+
+static void
+BM_Base58_Encode(benchmark::State& state) {
+    // compressed key followed by its checksum
+    auto data = std::vector<char>(37);
+    for(auto i = 0u; i < data.size(); i++) {
+        data[i] = (char)(i * 37 + 11);
+    }
+
+    for(auto _ : state) {
+        auto str = fc::to_base58(data);
+        benchmark::DoNotOptimize(str);
+    }
+}
+BENCHMARK(BM_Base58_Encode);
+
+static void
+BM_Base58_Decode(benchmark::State& state) {
+    auto data = std::vector<char>(37);
+    for(auto i = 0u; i < data.size(); i++) {
+        data[i] = (char)(i * 37 + 11);
+    }
+    auto str = fc::to_base58(data);
+
+    for(auto _ : state) {
+        auto bin = fc::from_base58(str);
+        benchmark::DoNotOptimize(bin);
+    }
+}
+BENCHMARK(BM_Base58_Decode);
+
+static void
+BM_Base58_PublicKeyToString(benchmark::State& state) {
+    auto keys = std::vector<public_key>();
+    for(auto i = 0; i < state.range(0); i++) {
+        keys.emplace_back(private_key::generate().get_public_key());
+    }
+
+    auto i = 0u;
+    for(auto _ : state) {
+        auto str = (std::string)keys[i++ % keys.size()];
+        benchmark::DoNotOptimize(str);
+    }
+}
+// a few hot keys hit the cache, a hundred thousand keys mostly miss it
+BENCHMARK(BM_Base58_PublicKeyToString)->Arg(16)->Arg(100000);
@@ -68,3 +68,35 @@ BM_ECC_VerifySignature(benchmark::State& state) {
     state.SetItemsProcessed(state.iterations());
 }
 BENCHMARK(BM_ECC_VerifySignature);
+
+static void
+BM_ECC_RecoverKeys(benchmark::State& state) {
+    auto digest = sha256::hash(std::string("evt"));
+    auto sigs   = std::vector<signature>();
+    for(auto i = 0; i < state.range(0); i++) {
+        sigs.emplace_back(private_key::generate().sign(digest));
+    }
+
+    auto keys = std::vector<public_key>(sigs.size());
+    for(auto _ : state) {
+        public_key::recover_keys(sigs.data(), sigs.size(), digest, keys.data());
+    }
+    state.SetItemsProcessed(state.iterations() * sigs.size());
+}
+BENCHMARK(BM_ECC_RecoverKeys)->Arg(1)->Arg(4)->Arg(16);
+
+static void
+BM_ECC_RecoverKeysR1(benchmark::State& state) {
+    auto digest = sha256::hash(std::string("evt"));
+    auto sigs   = std::vector<signature>();
+    for(auto i = 0; i < state.range(0); i++) {
+        sigs.emplace_back(private_key::generate_r1().sign(digest));
+    }
+
+    auto keys = std::vector<public_key>(sigs.size());
+    for(auto _ : state) {
+        public_key::recover_keys(sigs.data(), sigs.size(), digest, keys.data());
+    }
+    state.SetItemsProcessed(state.iterations() * sigs.size());
+}
+BENCHMARK(BM_ECC_RecoverKeysR1)->Arg(1)->Arg(4)->Arg(16);
@@ -5,6 +5,12 @@
 
 #include <benchmark/benchmark.h>
 #include <fc/io/json.hpp>
+#include <fc/io/json_writer.hpp>
+#include <evt/chain/contracts/types.hpp>
+
+FC_JSON_REFLECTED(evt::chain::contracts::authorizer_weight);
+FC_JSON_REFLECTED(evt::chain::contracts::permission_def);
+FC_JSON_REFLECTED(evt::chain::contracts::domain_def);
 
 /*
  * Benchmarks for the json serizlize & deserizlize between fc library and rapidjson
@@ -161,4 +167,34 @@ BM_Json_Serialize_Pretty_RJ(benchmark::State& state) {
         (void)str;
     }
 }
-BENCHMARK(BM_Json_Serialize_Pretty_RJ)->Arg(1)->Arg(2);
\ No newline at end of file
+BENCHMARK(BM_Json_Serialize_Pretty_RJ)->Arg(1)->Arg(2);
+/*
+ * Benchmarks for writing api responses, through a variant tree or streamed by json_writer
+ */
+static void
+BM_Json_Response_Variant(benchmark::State& state) {
+    auto domain = fc::json::from_string(std::string((const char*)json1)).as<evt::chain::contracts::domain_def>();
+
+    for(auto _ : state) {
+        auto var = fc::variant();
+        fc::to_variant(domain, var);
+
+        auto str = fc::json::to_string(var);
+        (void)str;
+    }
+}
+BENCHMARK(BM_Json_Response_Variant);
+
+static void
+BM_Json_Response_Writer(benchmark::State& state) {
+    auto domain = fc::json::from_string(std::string((const char*)json1)).as<evt::chain::contracts::domain_def>();
+
+    for(auto _ : state) {
+        auto w = fc::json_writer();
+        w.write(domain);
+
+        auto str = w.release();
+        (void)str;
+    }
+}
+BENCHMARK(BM_Json_Response_Writer);
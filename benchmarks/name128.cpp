@@ -0,0 +1,48 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+
+#include <benchmark/benchmark.h>
+#include <evt/chain/name128.hpp>
+
+/*
+ * Benchmarks for the string conversions of name128
+ */
+
+using namespace evt::chain;
+
+static const char* names[] = { "evt", "fungible", ".disable-destroy", "1234567890ABCDEFGHIJK" };
+
+static void
+BM_Name128_FromString(benchmark::State& state) {
+    auto str = std::string(names[state.range(0)]);
+
+    for(auto _ : state) {
+        auto n = name128(str);
+        benchmark::DoNotOptimize(n);
+    }
+}
+BENCHMARK(BM_Name128_FromString)->DenseRange(0, 3);
+
+static void
+BM_Name128_ToString(benchmark::State& state) {
+    auto n = name128(names[state.range(0)]);
+
+    for(auto _ : state) {
+        auto str = n.to_string();
+        benchmark::DoNotOptimize(str);
+    }
+}
+BENCHMARK(BM_Name128_ToString)->DenseRange(0, 3);
+
+static void
+BM_Name128_RoundTrip(benchmark::State& state) {
+    auto n = name128(names[state.range(0)]);
+
+    for(auto _ : state) {
+        auto n2 = name128(n.to_string());
+        benchmark::DoNotOptimize(n2);
+    }
+}
+BENCHMARK(BM_Name128_RoundTrip)->DenseRange(0, 3);
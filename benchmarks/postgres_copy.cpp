@@ -0,0 +1,80 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+
+#include <string>
+#include <benchmark/benchmark.h>
+#include <fmt/format.h>
+#include <fc/time.hpp>
+#include <evt/postgres_plugin/binary_copy_buffer.hpp>
+
+/*
+ * Benchmarks for encoding the rows of the actions table, as text COPY rows the way evt_pg did
+ * before and as binary COPY rows. The data is a transfer action in json with quotes to escape.
+ */
+
+namespace {
+
+auto block_id = std::string(64, 'a');
+auto trx_id   = std::string(64, 'b');
+auto data     = std::string(R"({"domain":"cookie","name":"t1","to":["EVT6MRyAjQq8ud7hVNYcfnVPJqcVpscN5So8BhtHuGYqET5GDW5CV"],"memo":"it's a \"gift\" from C:\\tmp"})");
+
+std::string
+escape_copy_string(const std::string& str) {
+    auto estr = std::string();
+    estr.reserve(str.size() + 8);
+    for(auto c : str) {
+        if(c == '\'') {
+            estr.push_back('\'');
+            estr.push_back('\'');
+            continue;
+        }
+        if(c == '\\') {
+            estr.push_back('\\');
+            estr.push_back('\\');
+            continue;
+        }
+        estr.push_back(c);
+    }
+    return estr;
+}
+
+}  // namespace
+
+static void
+BM_PG_ACTIONS_TEXT_COPY(benchmark::State& state) {
+    for(auto _ : state) {
+        auto buf = fmt::memory_buffer();
+        for(auto i = 0; i < state.range(0); i++) {
+            fmt::format_to(buf,
+                fmt("{}\t{:d}\t{}\t{:d}\t{:d}\t{}\t{}\t{}\t{}\tnow\n"),
+                block_id, 1000, trx_id, i, (int64_t)i, "transfer", "cookie", "t1", escape_copy_string(data));
+        }
+        benchmark::DoNotOptimize(fmt::to_string(buf));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_PG_ACTIONS_TEXT_COPY)->Arg(1'000)->Arg(100'000);
+
+static void
+BM_PG_ACTIONS_BINARY_COPY(benchmark::State& state) {
+    for(auto _ : state) {
+        auto buf = evt::binary_copy_buffer();
+        for(auto i = 0; i < state.range(0); i++) {
+            buf.start_row(9);
+            buf.add_text(block_id);
+            buf.add_int32(1000);
+            buf.add_text(trx_id);
+            buf.add_int32(i);
+            buf.add_int64(i);
+            buf.add_text("transfer");
+            buf.add_text("cookie");
+            buf.add_text("t1");
+            buf.add_jsonb(data);
+        }
+        benchmark::DoNotOptimize(buf.finish());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_PG_ACTIONS_BINARY_COPY)->Arg(1'000)->Arg(100'000);
@@ -0,0 +1,167 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <optional>
+#include <evt/chain/block_log.hpp>
+#include <evt/chain/controller.hpp>
+#include <evt/chain/snapshot.hpp>
+#include <evt/utilities/pooled_allocator.hpp>
+#include <fc/filesystem.hpp>
+#include <fc/log/logger.hpp>
+
+/*
+ * Benchmark of applying recorded blocks on top of a populated state
+ *
+ * The data is given by environment variables, the benchmark is skipped without them:
+ *   EVT_REPLAY_SNAPSHOT   - snapshot written by a node, including the token database
+ *   EVT_REPLAY_BLOCKS_DIR - folder of a blocks.log of the same chain, holding blocks after the snapshot
+ *   EVT_REPLAY_COUNT      - optional, max number of blocks to apply
+ *
+ * Every iteration starts again from the snapshot in a fresh folder, so runs are repeatable:
+ *   evt_benchmarks --benchmark_filter=BM_Replay --benchmark_repetitions=3
+ */
+
+using namespace evt::chain;
+
+namespace {
+
+struct replay_source {
+    fc::path snapshot;
+    fc::path blocks_dir;
+    uint32_t count = std::numeric_limits<uint32_t>::max();
+};
+
+std::optional<replay_source>
+get_replay_source() {
+    auto snapshot   = std::getenv("EVT_REPLAY_SNAPSHOT");
+    auto blocks_dir = std::getenv("EVT_REPLAY_BLOCKS_DIR");
+    if(snapshot == nullptr || blocks_dir == nullptr) {
+        return std::nullopt;
+    }
+
+    auto src       = replay_source();
+    src.snapshot   = snapshot;
+    src.blocks_dir = blocks_dir;
+    if(auto count = std::getenv("EVT_REPLAY_COUNT")) {
+        src.count = std::strtoul(count, nullptr, 10);
+    }
+    return src;
+}
+
+std::unique_ptr<controller>
+create_controller(const replay_source& src) {
+    fc::logger::get().set_log_level(fc::log_level(fc::log_level::error));
+
+    auto dir = fc::path("/tmp/evt_benchmarks/replay");
+    if(fc::exists(dir)) {
+        fc::remove_all(dir);
+    }
+    fc::create_directories(dir);
+
+    auto cfg = controller::config();
+
+    cfg.blocks_dir            = dir / "blocks";
+    cfg.state_dir             = dir / "state";
+    cfg.db_config.db_path     = dir / "tokendb";
+    cfg.state_size            = 1024ull * 1024 * 1024 * 4;
+    cfg.reversible_cache_size = 1024 * 1024 * 340;
+    cfg.contracts_console     = false;
+
+    auto infile = std::ifstream(src.snapshot.generic_string(), (std::ios::in | std::ios::binary));
+    auto reader = std::make_shared<istream_snapshot_reader>(infile);
+    reader->validate();
+    reader->read_section<genesis_state>([&cfg](auto& section) {
+        section.read_row(cfg.genesis);
+    });
+
+    auto control = std::make_unique<controller>(cfg);
+    control->add_indices();
+    control->startup(reader);
+    infile.close();
+
+    return control;
+}
+
+double
+percentile(std::vector<double>& samples, double p) {
+    if(samples.empty()) {
+        return 0;
+    }
+    auto n = std::min(samples.size() - 1, (size_t)(p * samples.size()));
+    std::nth_element(samples.begin(), samples.begin() + n, samples.end());
+    return samples[n];
+}
+
+}  // namespace
+
+static void
+BM_Replay_blocks(benchmark::State& state) {
+    auto src = get_replay_source();
+    if(!src.has_value()) {
+        state.SkipWithError("EVT_REPLAY_SNAPSHOT and EVT_REPLAY_BLOCKS_DIR are not set");
+        return;
+    }
+
+    auto blog      = block_log(src->blocks_dir);
+    auto blocks    = 0ul;
+    auto trxs      = 0ul;
+    auto total     = 0.0;
+    auto durations = std::vector<double>();  // milliseconds to apply each block
+    auto allocs    = evt::utilities::pool_stats();  // pooled allocations made while applying blocks
+
+    for(auto _ : state) {
+        auto control = create_controller(*src);
+
+        auto elapsed = 0.0;
+        auto begin   = control->head_block_num() + 1;
+        for(auto num = begin; num - begin < src->count; num++) {
+            auto b = blog.read_block_by_num(num);
+            if(!b) {
+                break;
+            }
+
+            auto before = evt::utilities::get_pool_stats();
+            auto start  = std::chrono::high_resolution_clock::now();
+            control->push_block(b);
+            auto end    = std::chrono::high_resolution_clock::now();
+            auto after  = evt::utilities::get_pool_stats();
+
+            allocs.allocs += after.allocs - before.allocs;
+            allocs.cache_hits += after.cache_hits - before.cache_hits;
+            allocs.pool_allocs += after.pool_allocs - before.pool_allocs;
+
+            auto ms = std::chrono::duration<double, std::milli>(end - start).count();
+            durations.emplace_back(ms);
+            elapsed += ms;
+            blocks++;
+            trxs += b->transactions.size();
+        }
+        state.SetIterationTime(elapsed / 1000);
+        total += elapsed;
+
+        control.reset();
+    }
+
+    if(blocks == 0) {
+        state.SkipWithError("No block after the head of snapshot is found in the blocks log");
+        return;
+    }
+
+    state.counters["blocks"]   = blocks / state.iterations();
+    state.counters["blocks/s"] = blocks / (total / 1000);
+    state.counters["trx/s"]    = trxs / (total / 1000);
+    state.counters["p50_ms"]   = percentile(durations, 0.5);
+    state.counters["p99_ms"]   = percentile(durations, 0.99);
+    state.counters["pooled_allocs/block"]      = (double)allocs.allocs / blocks;
+    state.counters["pooled_pool_allocs/block"] = (double)allocs.pool_allocs / blocks;
+    state.SetItemsProcessed(trxs);
+}
+BENCHMARK(BM_Replay_blocks)->UseManualTime()->Iterations(1)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,264 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+
+#include <benchmark/benchmark.h>
+#include <random>
+#include <evt/chain/token_database.hpp>
+#include <evt/chain/token_database_cache.hpp>
+#include <evt/chain/contracts/types.hpp>
+#include <evt/testing/tester.hpp>
+#include <fc/filesystem.hpp>
+#include <fc/log/logger.hpp>
+
+/*
+ * Benchmarks for token database to measure the cost of savepoints, reads, writes, object cache
+ * and range scans over each storage profile, heap allocations are counted in tokendb_allocs.cpp
+ */
+
+using namespace evt::chain;
+
+static std::unique_ptr<token_database>
+create_tokendb(storage_profile profile = storage_profile::disk) {
+    fc::logger::get().set_log_level(fc::log_level(fc::log_level::error));
+
+    auto dir = fc::path("/tmp/evt_benchmarks/tokendb_bench");
+    if(fc::exists(dir)) {
+        fc::remove_all(dir);
+    }
+    fc::create_directories(dir);
+
+    auto cfg    = token_database::config();
+    cfg.db_path = dir;
+    cfg.profile = profile;
+
+    auto db = std::make_unique<token_database>(cfg);
+    db->open();
+    return db;
+}
+
+namespace {
+
+const auto kBenchDomain = name128("bench");
+const auto kBenchSymId  = symbol_id_type(1);
+
+name128
+token_key(int i) {
+    return name128::from_number(i);
+}
+
+address
+asset_key(int i) {
+    return address(N(.bench), N128(.asset), i);
+}
+
+std::string
+token_value(int i) {
+    auto tk = contracts::token_def(kBenchDomain, token_key(i), { address(N(.bench), N128(.owner), i) });
+    auto v  = fc::raw::pack(tk);
+    return std::string(v.data(), v.size());
+}
+
+// database of the profile in range(0) filled with range(1) tokens of one domain and
+// range(1) assets of one symbol
+std::unique_ptr<token_database>
+create_filled_tokendb(const benchmark::State& state) {
+    auto db = create_tokendb((storage_profile)state.range(0));
+    auto n  = (int)state.range(1);
+
+    auto asset = std::string(16, 'a');
+    db->begin_bulk_load();
+    for(auto i = 0; i < n; i++) {
+        db->put_token(token_type::token, action_op::add, kBenchDomain, token_key(i), token_value(i));
+        db->put_asset(asset_key(i), kBenchSymId, asset);
+    }
+    db->end_bulk_load();
+    return db;
+}
+
+void
+profiles_and_sizes(benchmark::internal::Benchmark* b) {
+    for(auto profile : { storage_profile::disk, storage_profile::memory }) {
+        for(auto n : { 1 << 10, 1 << 14, 1 << 17 }) {
+            b->Args({ (int)profile, n });
+        }
+    }
+}
+
+void
+profiles_and_depths(benchmark::internal::Benchmark* b) {
+    for(auto profile : { storage_profile::disk, storage_profile::memory }) {
+        for(auto depth : { 1, 8, 64 }) {
+            b->Args({ (int)profile, 1 << 14, depth });
+        }
+    }
+}
+
+}  // namespace
+
+static void
+BM_TokenDB_read_token_hit(benchmark::State& state) {
+    auto db  = create_filled_tokendb(state);
+    auto dre = std::default_random_engine();
+    auto dis = std::uniform_int_distribution<int>(0, state.range(1) - 1);
+    auto out = std::string();
+
+    for(auto _ : state) {
+        db->read_token(token_type::token, kBenchDomain, token_key(dis(dre)), out);
+        benchmark::DoNotOptimize(out);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TokenDB_read_token_hit)->Apply(profiles_and_sizes);
+
+static void
+BM_TokenDB_read_token_miss(benchmark::State& state) {
+    auto db  = create_filled_tokendb(state);
+    auto dre = std::default_random_engine();
+    auto dis = std::uniform_int_distribution<int>(state.range(1), state.range(1) * 2);
+    auto out = std::string();
+
+    for(auto _ : state) {
+        benchmark::DoNotOptimize(db->read_token(token_type::token, kBenchDomain, token_key(dis(dre)), out, true /* no_throw */));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TokenDB_read_token_miss)->Apply(profiles_and_sizes);
+
+static void
+BM_TokenDB_put_token(benchmark::State& state) {
+    auto db  = create_filled_tokendb(state);
+    auto dre = std::default_random_engine();
+    auto dis = std::uniform_int_distribution<int>(0, state.range(1) - 1);
+    auto seq = 1;
+
+    db->add_savepoint(seq++);
+    for(auto _ : state) {
+        auto i = dis(dre);
+        db->put_token(token_type::token, action_op::update, kBenchDomain, token_key(i), token_value(i));
+    }
+    db->rollback_to_latest_savepoint();
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TokenDB_put_token)->Apply(profiles_and_sizes);
+
+static void
+BM_TokenDB_cache_read_hit(benchmark::State& state) {
+    auto db    = create_filled_tokendb(state);
+    auto cache = token_database_cache(*db, 256 * 1024 * 1024);
+    auto dre   = std::default_random_engine();
+    auto dis   = std::uniform_int_distribution<int>(0, state.range(1) - 1);
+
+    for(auto i = 0; i < state.range(1); i++) {
+        cache.read_token<contracts::token_def>(token_type::token, kBenchDomain, token_key(i));
+    }
+    for(auto _ : state) {
+        auto tk = cache.read_token<contracts::token_def>(token_type::token, kBenchDomain, token_key(dis(dre)));
+        benchmark::DoNotOptimize(tk);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TokenDB_cache_read_hit)->Apply(profiles_and_sizes);
+
+// range(2) nested savepoints with one update each, squashed into the outermost one
+static void
+BM_TokenDB_savepoints_squash(benchmark::State& state) {
+    auto db    = create_filled_tokendb(state);
+    auto depth = (int)state.range(2);
+    auto seq   = 1;
+    auto value = token_value(0);
+
+    db->add_savepoint(seq++);
+    for(auto _ : state) {
+        for(auto i = 0; i < depth; i++) {
+            db->add_savepoint(seq++);
+            db->put_token(token_type::token, action_op::update, kBenchDomain, token_key(i), value);
+        }
+        for(auto i = 0; i < depth; i++) {
+            db->squash();
+        }
+    }
+    db->rollback_to_latest_savepoint();
+    state.SetItemsProcessed(state.iterations() * depth);
+}
+BENCHMARK(BM_TokenDB_savepoints_squash)->Apply(profiles_and_depths);
+
+// range(2) nested savepoints with one update each, all rolled back
+static void
+BM_TokenDB_savepoints_rollback(benchmark::State& state) {
+    auto db    = create_filled_tokendb(state);
+    auto depth = (int)state.range(2);
+    auto seq   = 1;
+    auto value = token_value(0);
+
+    for(auto _ : state) {
+        for(auto i = 0; i < depth; i++) {
+            db->add_savepoint(seq++);
+            db->put_token(token_type::token, action_op::update, kBenchDomain, token_key(i), value);
+        }
+        for(auto i = 0; i < depth; i++) {
+            db->rollback_to_latest_savepoint();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * depth);
+}
+BENCHMARK(BM_TokenDB_savepoints_rollback)->Apply(profiles_and_depths);
+
+// range(2) savepoints of 64 updates each are popped and persisted at once
+static void
+BM_TokenDB_pop_savepoints(benchmark::State& state) {
+    auto db    = create_filled_tokendb(state);
+    auto depth = (int)state.range(2);
+    auto dre   = std::default_random_engine();
+    auto dis   = std::uniform_int_distribution<int>(0, state.range(1) - 1);
+    auto seq   = 1;
+
+    for(auto _ : state) {
+        state.PauseTiming();
+        for(auto i = 0; i < depth; i++) {
+            db->add_savepoint(seq++);
+            for(auto j = 0; j < 64; j++) {
+                auto k = dis(dre);
+                db->put_token(token_type::token, action_op::update, kBenchDomain, token_key(k), token_value(k));
+            }
+        }
+        state.ResumeTiming();
+
+        db->pop_savepoints(seq);
+    }
+    state.SetItemsProcessed(state.iterations() * depth);
+}
+BENCHMARK(BM_TokenDB_pop_savepoints)->Apply(profiles_and_depths);
+
+static void
+BM_TokenDB_read_tokens_range(benchmark::State& state) {
+    auto db = create_filled_tokendb(state);
+
+    auto rows = 0ul;
+    for(auto _ : state) {
+        db->read_tokens_range(token_type::token, kBenchDomain, 0, [&rows](auto& key, auto&& value) {
+            benchmark::DoNotOptimize(value);
+            rows++;
+            return true;
+        });
+    }
+    state.SetItemsProcessed(rows);
+}
+BENCHMARK(BM_TokenDB_read_tokens_range)->Apply(profiles_and_sizes);
+
+static void
+BM_TokenDB_read_assets_range(benchmark::State& state) {
+    auto db = create_filled_tokendb(state);
+
+    auto rows = 0ul;
+    for(auto _ : state) {
+        db->read_assets_range(kBenchSymId, 0, [&rows](auto& key, auto&& value) {
+            benchmark::DoNotOptimize(value);
+            rows++;
+            return true;
+        });
+    }
+    state.SetItemsProcessed(rows);
+}
+BENCHMARK(BM_TokenDB_read_assets_range)->Apply(profiles_and_sizes);
@@ -0,0 +1,106 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+
+#include <benchmark/benchmark.h>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <evt/chain/token_database.hpp>
+#include <evt/testing/tester.hpp>
+#include <fc/filesystem.hpp>
+#include <fc/log/logger.hpp>
+
+/*
+ * Benchmarks counting the heap allocations of token database. They're built into their own
+ * executable as the global `operator new` is replaced to count them, which would slow down
+ * all the other benchmarks linked with it.
+ *
+ * Only the public token_database API is used, so this file builds unchanged against the write cache
+ * before per-savepoint arenas were added. To get the baseline figure, add it together with its
+ * `evt_alloc_benchmarks` target in CMakeLists.txt onto that tree and compare `allocs_per_trx`.
+ */
+
+using namespace evt::chain;
+
+namespace {
+
+std::atomic<uint64_t> allocs_count {0};
+
+}  // namespace
+
+void*
+operator new(size_t sz) {
+    allocs_count.fetch_add(1, std::memory_order_relaxed);
+    if(auto p = std::malloc(sz)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void
+operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void
+operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+static std::unique_ptr<token_database>
+create_tokendb() {
+    fc::logger::get().set_log_level(fc::log_level(fc::log_level::error));
+
+    auto dir = fc::path("/tmp/evt_benchmarks/tokendb_allocs_bench");
+    if(fc::exists(dir)) {
+        fc::remove_all(dir);
+    }
+    fc::create_directories(dir);
+
+    auto cfg    = token_database::config();
+    cfg.db_path = dir;
+
+    auto db = std::make_unique<token_database>(cfg);
+    db->open();
+    return db;
+}
+
+// Simulates fungible transfers: every transaction is one savepoint squashed into the block savepoint,
+// it updates the balances of a small set of hot addresses.
+static void
+BM_TokenDB_asset_savepoints(benchmark::State& state) {
+    auto db = create_tokendb();
+
+    auto addrs = std::vector<address>();
+    for(auto i = 0; i < 16; i++) {
+        addrs.emplace_back(evt::testing::tester::get_public_key(name(std::string("bench") + (char)('a' + i))));
+    }
+
+    auto value   = std::string(64, 'v');
+    auto seq     = 1;
+    auto trxs    = 0ul;
+    auto allocs  = 0ul;
+    auto per_blk = (int)state.range(0);
+
+    for(auto _ : state) {
+        db->add_savepoint(seq++);  // block
+        for(auto i = 0; i < per_blk; i++) {
+            auto before = allocs_count.load(std::memory_order_relaxed);
+
+            db->add_savepoint(seq++);  // transaction
+            db->put_asset(addrs[i % addrs.size()], 1, value);
+            db->put_asset(addrs[(i + 1) % addrs.size()], 1, value);
+            db->squash();
+
+            allocs += allocs_count.load(std::memory_order_relaxed) - before;
+            trxs++;
+        }
+        db->pop_savepoints(seq);
+    }
+
+    state.SetItemsProcessed(trxs);
+    state.counters["allocs_per_trx"] = (double)allocs / trxs;
+}
+BENCHMARK(BM_TokenDB_asset_savepoints)->Range(8, 1 << 10);
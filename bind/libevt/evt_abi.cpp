@@ -169,6 +169,74 @@ evt_trx_json_to_digest(void* evt_abi, const char* json,  evt_chain_id_t* chain_i
     return EVT_OK;
 }
 
+int
+evt_abi_json_to_bin_many(void* evt_abi, const char** actions, const char** jsons, size_t n, evt_bin_t** bins /* out, array of n */) {
+    if(actions == nullptr) {
+        return EVT_INVALID_ARGUMENT;
+    }
+    if(jsons == nullptr) {
+        return EVT_INVALID_ARGUMENT;
+    }
+    if(bins == nullptr) {
+        return EVT_INVALID_ARGUMENT;
+    }
+
+    // serializer and execution context are shared, so they're not run in parallel
+    auto r = EVT_OK;
+    for(auto i = 0u; i < n; i++) {
+        bins[i] = nullptr;
+        auto ri = evt_abi_json_to_bin(evt_abi, actions[i], jsons[i], &bins[i]);
+        if(ri != EVT_OK && r == EVT_OK) {
+            r = ri;
+        }
+    }
+    return r;
+}
+
+int
+evt_trx_digest_many(void* evt_abi, const char** jsons, size_t n, evt_chain_id_t* chain_id, evt_checksum_t** digests /* out, array of n */) {
+    if(evt_abi == nullptr) {
+        return EVT_INVALID_ARGUMENT;
+    }
+    if(jsons == nullptr) {
+        return EVT_INVALID_ARGUMENT;
+    }
+    if(digests == nullptr) {
+        return EVT_INVALID_ARGUMENT;
+    }
+    sha256 idhash;
+    if(chain_id == nullptr || extract_data(chain_id, idhash) != EVT_OK) {
+        return EVT_INVALID_HASH;
+    }
+
+    auto& abic = *(abi_context*)evt_abi;
+    auto  id   = chain_id_type(idhash);
+    auto  r    = EVT_OK;
+    for(auto i = 0u; i < n; i++) {
+        digests[i] = nullptr;
+        if(jsons[i] == nullptr) {
+            r = (r == EVT_OK) ? EVT_INVALID_ARGUMENT : r;
+            continue;
+        }
+        try {
+            auto trx = transaction();
+            auto var = fc::json::from_string(jsons[i]);
+            abic.abi->from_variant(var, trx, *abic.exec_ctx);
+
+            digests[i] = get_evt_data(trx.sig_digest(id));
+        }
+        catch(fc::exception& e) {
+            evt_set_last_error(e.code());
+            r = (r == EVT_OK) ? EVT_INTERNAL_ERROR : r;
+        }
+        catch(...) {
+            evt_set_last_error(-1);
+            r = (r == EVT_OK) ? EVT_INTERNAL_ERROR : r;
+        }
+    }
+    return r;
+}
+
 int
 evt_chain_id_from_string(const char* str, evt_chain_id_t** chain_id /* out */) {
     return evt_checksum_from_string(str, chain_id);
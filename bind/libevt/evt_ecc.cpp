@@ -90,6 +90,31 @@ evt_sign_hash(evt_private_key_t* priv_key, evt_checksum_t* hash, evt_signature_t
     return EVT_OK;
 }
 
+int
+evt_sign_many(evt_private_key_t** priv_keys, evt_checksum_t** hashes, size_t n, int threads, evt_signature_t** signs /* out, array of n */) {
+    if(priv_keys == nullptr) {
+        return EVT_INVALID_ARGUMENT;
+    }
+    if(hashes == nullptr) {
+        return EVT_INVALID_ARGUMENT;
+    }
+    if(signs == nullptr) {
+        return EVT_INVALID_ARGUMENT;
+    }
+
+    auto rs = std::vector<int>(n, EVT_OK);
+    parallel_for(n, threads, [&](auto i) {
+        signs[i] = nullptr;
+        rs[i]    = evt_sign_hash(priv_keys[i], hashes[i], &signs[i]);
+    });
+    for(auto r : rs) {
+        if(r != EVT_OK) {
+            return r;
+        }
+    }
+    return EVT_OK;
+}
+
 int
 evt_recover(evt_signature_t* sign, evt_checksum_t* hash, evt_public_key_t** pub_key /* out */) {
     if(sign == nullptr) {
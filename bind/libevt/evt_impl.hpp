@@ -6,7 +6,10 @@
 #include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
+#include <algorithm>
 #include <string>
+#include <thread>
+#include <vector>
 #include <libevt/evt.h>
 #include <fc/io/raw.hpp>
 
@@ -54,3 +57,27 @@ strdup(const std::string& str) {
     s[str.size()] = '\0';
     return s;
 }
+
+// runs `func(i)` for i in [0, n), split into contiguous ranges over `threads` threads
+// the calling thread takes the first range, runs all of them itself when `threads` <= 1
+template <typename Func>
+void
+parallel_for(size_t n, int threads, Func&& func) {
+    auto tn = (size_t)std::clamp<int>(threads, 1, (int)std::max(std::thread::hardware_concurrency(), 1u));
+    tn      = std::min(tn, std::max(n, (size_t)1));
+
+    auto run = [&](size_t t) {
+        for(auto i = n * t / tn; i < n * (t + 1) / tn; i++) {
+            func(i);
+        }
+    };
+
+    auto workers = std::vector<std::thread>();
+    for(auto t = 1u; t < tn; t++) {
+        workers.emplace_back(run, t);
+    }
+    run(0);
+    for(auto& w : workers) {
+        w.join();
+    }
+}
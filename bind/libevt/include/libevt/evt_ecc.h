@@ -20,6 +20,10 @@ int evt_sign_hash(evt_private_key_t* priv_key, evt_checksum_t* hash, evt_signatu
 int evt_recover(evt_signature_t* sign, evt_checksum_t* hash, evt_public_key_t** pub_key /* out */);
 int evt_hash(const char* buf, size_t sz, evt_checksum_t** hash /* out */);
 
+// signs hashes[i] with priv_keys[i] for each i in [0, n), spread over `threads` threads (0 or 1 to sign on the calling thread)
+// returns the error of the first failed one, outputs of failed ones are left NULL and the others should be freed still
+int evt_sign_many(evt_private_key_t** priv_keys, evt_checksum_t** hashes, size_t n, int threads, evt_signature_t** signs /* out, array of n */);
+
 int evt_public_key_string(evt_public_key_t* pub_key, char** str /* out */);
 int evt_private_key_string(evt_private_key_t* priv_key, char** str /* out */);
 int evt_signature_string(evt_signature_t* sign, char** str /* out */);
@@ -208,6 +208,45 @@ TEST_CASE("evtecc") {
     evt_free(pubkey3);
 }
 
+TEST_CASE("evtecc_many") {
+    const auto n = 16u;
+
+    evt_public_key_t*  pubkeys[n];
+    evt_private_key_t* privkeys[n];
+    evt_checksum_t*    hashes[n];
+    for(auto i = 0u; i < n; i++) {
+        REQUIRE(evt_generate_new_pair(&pubkeys[i], &privkeys[i]) == EVT_OK);
+        REQUIRE(evt_hash((const char*)&i, sizeof(i), &hashes[i]) == EVT_OK);
+    }
+
+    evt_signature_t* signs[n];
+    auto r1 = evt_sign_many(privkeys, hashes, n, 4, signs);
+    REQUIRE(r1 == EVT_OK);
+
+    for(auto i = 0u; i < n; i++) {
+        evt_public_key_t* pubkey = nullptr;
+        REQUIRE(evt_recover(signs[i], hashes[i], &pubkey) == EVT_OK);
+        CHECK(evt_equals(pubkey, pubkeys[i]) == EVT_OK);
+        evt_free(pubkey);
+    }
+
+    // same signatures on the calling thread
+    evt_signature_t* signs2[n];
+    auto r2 = evt_sign_many(privkeys, hashes, n, 0, signs2);
+    REQUIRE(r2 == EVT_OK);
+    for(auto i = 0u; i < n; i++) {
+        CHECK(evt_equals(signs[i], signs2[i]) == EVT_OK);
+    }
+
+    for(auto i = 0u; i < n; i++) {
+        evt_free(pubkeys[i]);
+        evt_free(privkeys[i]);
+        evt_free(hashes[i]);
+        evt_free(signs[i]);
+        evt_free(signs2[i]);
+    }
+}
+
 TEST_CASE("evtabi") {
     auto abi = evt_abi();
     REQUIRE(abi != nullptr);
@@ -344,8 +383,36 @@ TEST_CASE("evtabi") {
     REQUIRE(r9 == EVT_OK);
     REQUIRE(digest2 != nullptr);
 
+    const char* actions[] = { "newdomain", "aprvsuspend" };
+    const char* jsons[]   = { j1, j3 };
+    evt_bin_t*  bins[2];
+    auto r10 = evt_abi_json_to_bin_many(abi, actions, jsons, 2, bins);
+    REQUIRE(r10 == EVT_OK);
+    CHECK(evt_equals(bins[0], bin) == EVT_OK);
+    CHECK(evt_equals(bins[1], bin3) == EVT_OK);
+
+    const char*     trxs[] = { j2, j4 };
+    evt_checksum_t* digests[2];
+    auto r11m = evt_trx_digest_many(abi, trxs, 2, chain_id, digests);
+    REQUIRE(r11m == EVT_OK);
+    CHECK(evt_equals(digests[0], digest) == EVT_OK);
+    CHECK(evt_equals(digests[1], digest2) == EVT_OK);
+    evt_free(digests[0]);
+    evt_free(digests[1]);
+
+    // failed ones are left null
+    trxs[1] = "trx";
+    auto r12 = evt_trx_digest_many(abi, trxs, 2, chain_id, digests);
+    CHECK(r12 == EVT_INTERNAL_ERROR);
+    REQUIRE(digests[0] != nullptr);
+    CHECK(digests[1] == nullptr);
+
     REQUIRE(abi != nullptr);
 
+    for(auto b : bins) {
+        evt_free(b);
+    }
+    evt_free(digests[0]);
     evt_free(bin);
     evt_free(j1restore);
     evt_free(chain_id);
@@ -42,6 +42,34 @@ def trx_json_to_digest(json, chain_id):
     return EvtData(digest_c[0])
 
 
+def _wrap_many(evt, ret, outs, n):
+    # wrap the outputs first, so the ones made are freed even if it fails
+    datas = [EvtData(outs[i]) if outs[i] != evt.ffi.NULL else None for i in range(n)]
+    evt_exception.evt_exception_raiser(ret)
+    return datas
+
+
+def json_to_bin_many(actions, jsons):
+    evt = libevt.check_lib_init()
+    n = len(actions)
+    actions_k = [evt.ffi.new('char[]', bytes(a, encoding='utf-8')) for a in actions]
+    jsons_k = [evt.ffi.new('char[]', bytes(j, encoding='utf-8')) for j in jsons]
+    bins_c = evt.ffi.new('evt_bin_t*[]', n)
+    ret = evt.lib.evt_abi_json_to_bin_many(
+        evt.abi, evt.ffi.new('char*[]', actions_k), evt.ffi.new('char*[]', jsons_k), n, bins_c)
+    return _wrap_many(evt, ret, bins_c, n)
+
+
+def trx_json_to_digest_many(jsons, chain_id):
+    evt = libevt.check_lib_init()
+    n = len(jsons)
+    jsons_k = [evt.ffi.new('char[]', bytes(j, encoding='utf-8')) for j in jsons]
+    digests_c = evt.ffi.new('evt_checksum_t*[]', n)
+    ret = evt.lib.evt_trx_digest_many(
+        evt.abi, evt.ffi.new('char*[]', jsons_k), n, chain_id.data, digests_c)
+    return _wrap_many(evt, ret, digests_c, n)
+
+
 class ChainId(EvtData):
     def __init__(self, data):
         super().__init__(data)
@@ -65,6 +65,19 @@ class PrivateKey(EvtData):
         evt_exception.evt_exception_raiser(ret)
         return Signature(signature_c[0])
 
+    @staticmethod
+    def sign_many(private_keys, hashes, threads=0):
+        evt = libevt.check_lib_init()
+        n = len(private_keys)
+        keys_c = evt.ffi.new('evt_private_key_t*[]', [k.data for k in private_keys])
+        hashes_c = evt.ffi.new('evt_checksum_t*[]', [h.data for h in hashes])
+        signatures_c = evt.ffi.new('evt_signature_t*[]', n)
+        ret = evt.lib.evt_sign_many(keys_c, hashes_c, n, threads, signatures_c)
+        # wrap the outputs first, so the ones made are freed even if it fails
+        signatures = [Signature(signatures_c[i]) if signatures_c[i] != evt.ffi.NULL else None for i in range(n)]
+        evt_exception.evt_exception_raiser(ret)
+        return signatures
+
     @staticmethod
     def from_string(str):
         evt = libevt.check_lib_init()
@@ -65,6 +65,8 @@ def init_evt_lib():
             int evt_abi_json_to_bin(void* evt_abi, const char* action, const char* json, evt_bin_t** bin /* out */);
             int evt_abi_bin_to_json(void* evt_abi, const char* action, evt_bin_t* bin, char** json /* out */);
             int evt_trx_json_to_digest(void* evt_abi, const char* json, evt_chain_id_t* chain_id, evt_checksum_t** digest /* out */);
+            int evt_abi_json_to_bin_many(void* evt_abi, const char** actions, const char** jsons, size_t n, evt_bin_t** bins /* out */);
+            int evt_trx_digest_many(void* evt_abi, const char** jsons, size_t n, evt_chain_id_t* chain_id, evt_checksum_t** digests /* out */);
             int evt_chain_id_from_string(const char* str, evt_chain_id_t** chain_id /* out */);
 
 
@@ -73,6 +75,7 @@ def init_evt_lib():
             int evt_sign_hash(evt_private_key_t* priv_key, evt_checksum_t* hash, evt_signature_t** sign /* out */);
             int evt_recover(evt_signature_t* sign, evt_checksum_t* hash, evt_public_key_t** pub_key /* out */);
             int evt_hash(const char* buf, size_t sz, evt_checksum_t** hash /* out */);
+            int evt_sign_many(evt_private_key_t** priv_keys, evt_checksum_t** hashes, size_t n, int threads, evt_signature_t** signs /* out */);
 
             int evt_public_key_string(evt_public_key_t* pub_key, char** str /* out */);
             int evt_private_key_string(evt_private_key_t* priv_key, char** str /* out */);
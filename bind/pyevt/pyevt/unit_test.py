@@ -38,6 +38,11 @@ class TestPyEVT(unittest.TestCase):
         pub_key_string3 = pub_key3.to_string()
         self.assertTrue(pub_key_string3 == pub_key_string)
 
+        signs = PrivateKey.sign_many([priv_key, priv_key2], [check_sum, check_sum], 2)
+        self.assertTrue(len(signs) == 2)
+        self.assertTrue(signs[0].to_string() == sign.to_string())
+        self.assertTrue(signs[1].to_string() == sign.to_string())
+
     def test_evtabi(self):
         j = r'''
         {
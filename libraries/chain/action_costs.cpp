@@ -0,0 +1,114 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#include <evt/chain/action_costs.hpp>
+#include <cmath>
+#include <evt/chain/deadline_timer.hpp>
+#include <evt/chain/execution_context.hpp>
+
+namespace evt { namespace chain {
+
+namespace internal {
+
+size_t
+bucket_of(uint64_t us) {
+    auto i = action_cost_tracker::kFirstBucket;
+    while(i <= action_cost_tracker::kLastBucket && us >= (1ull << i)) {
+        i++;
+    }
+    return i - action_cost_tracker::kFirstBucket;
+}
+
+}  // namespace internal
+
+void
+action_cost_tracker::record(const transaction_trace& trace, const execution_context& exec_ctx) {
+    auto now  = deadline_timer::coarse_now();
+    auto lock = std::unique_lock<std::mutex>(mutex_);
+
+    if(now - window_start_ >= window_) {
+        previous_     = (now - window_start_ >= window_ + window_) ? window_map() : std::move(current_);
+        current_      = window_map();
+        window_start_ = now;
+    }
+
+    for(auto& at : trace.action_traces) {
+        auto  us = (uint64_t)std::max(at.elapsed.count(), (int64_t)0);
+        auto& e  = current_[std::make_pair(at.act.name, exec_ctx.get_current_version(at.act.name))];
+
+        e.count++;
+        e.sum_us += us;
+        e.max_us = std::max(e.max_us, us);
+        e.db_reads += at.db_reads;
+        e.db_writes += at.db_writes;
+        e.db_misses += at.db_misses;
+        e.buckets[internal::bucket_of(us)]++;
+    }
+}
+
+void
+action_cost_tracker::reset() {
+    auto lock = std::unique_lock<std::mutex>(mutex_);
+    current_.clear();
+    previous_.clear();
+    window_start_ = fc::time_point::now();
+}
+
+std::vector<action_cost>
+action_cost_tracker::get_costs() const {
+    auto merged = window_map();
+    {
+        auto lock = std::unique_lock<std::mutex>(mutex_);
+        merged = previous_;
+        for(auto& it : current_) {
+            auto& e = merged[it.first];
+            auto& c = it.second;
+
+            e.count += c.count;
+            e.sum_us += c.sum_us;
+            e.max_us = std::max(e.max_us, c.max_us);
+            e.db_reads += c.db_reads;
+            e.db_writes += c.db_writes;
+            e.db_misses += c.db_misses;
+            for(auto i = 0u; i < e.buckets.size(); i++) {
+                e.buckets[i] += c.buckets[i];
+            }
+        }
+    }
+
+    // upper bound of the bucket holding the q-th quantile
+    auto percentile = [](const entry& e, double q) {
+        auto rank = std::max((uint64_t)std::ceil(q * e.count), (uint64_t)1);
+        auto sum  = uint64_t(0);
+        for(auto i = 0u; i < e.buckets.size() - 1; i++) {
+            sum += e.buckets[i];
+            if(sum >= rank) {
+                return std::min(e.max_us, (uint64_t)1 << (i + kFirstBucket));
+            }
+        }
+        return e.max_us;
+    };
+
+    auto costs = std::vector<action_cost>();
+    costs.reserve(merged.size());
+    for(auto& it : merged) {
+        auto& e = it.second;
+        auto& c = costs.emplace_back();
+
+        c.name       = it.first.first;
+        c.version    = it.first.second;
+        c.count      = e.count;
+        c.sum_us     = e.sum_us;
+        c.max_us     = e.max_us;
+        c.p50_us     = percentile(e, 0.5);
+        c.p99_us     = percentile(e, 0.99);
+        c.db_reads   = e.db_reads;
+        c.db_writes  = e.db_writes;
+        c.db_misses  = e.db_misses;
+        c.latency_us = std::vector<uint64_t>(e.buckets.begin(), e.buckets.end());
+    }
+    return costs;
+}
+
+}}  // namespace evt::chain
@@ -15,9 +15,9 @@ block_header_state::is_active_producer(const account_name& n) const {
 
 const producer_key&
 block_header_state::get_scheduled_producer(block_timestamp_type t) const {
-    auto index = t.slot % (active_schedule.producers.size() * config::producer_repetitions);
+    auto index = t.slot % (active_schedule->producers.size() * config::producer_repetitions);
     index /= config::producer_repetitions;
-    return active_schedule.producers[index];
+    return active_schedule->producers[index];
 }
 
 uint32_t
@@ -53,7 +53,7 @@ block_header_state::generate_next(block_timestamp_type when) const {
     }
     result.header.timestamp        = when;
     result.header.previous         = id;
-    result.header.schedule_version = active_schedule.version;
+    result.header.schedule_version = active_schedule->version;
 
     auto& prokey             = get_scheduled_producer(when);
     result.block_signing_key = prokey.block_signing_key;
@@ -80,7 +80,7 @@ block_header_state::generate_next(block_timestamp_type when) const {
     static_assert(std::numeric_limits<uint8_t>::max() >= (config::max_producers * 2 / 3) + 1, "8bit confirmations may not be able to hold all of the needed confirmations");
 
     // This uses the previous block active_schedule because thats the "schedule" that signs and therefore confirms _this_ block
-    auto     num_active_producers = active_schedule.producers.size();
+    auto     num_active_producers = active_schedule->producers.size();
     uint32_t required_confs       = (uint32_t)(num_active_producers * 2 / 3) + 1;
 
     if(confirm_count.size() < config::maximum_tracked_dpos_confirmations) {
@@ -100,11 +100,13 @@ block_header_state::generate_next(block_timestamp_type when) const {
 
 bool
 block_header_state::maybe_promote_pending() {
-    if(pending_schedule.producers.size() && dpos_irreversible_blocknum >= pending_schedule_lib_num) {
-        active_schedule = move(pending_schedule);
+    if(pending_schedule->producers.size() && dpos_irreversible_blocknum >= pending_schedule_lib_num) {
+        // the promoted schedule is shared, pending one is left with its version like a moved-from one
+        active_schedule = pending_schedule;
+        pending_schedule.mutate().producers.clear();
 
         flat_map<account_name, uint32_t> new_producer_to_last_produced;
-        for(const auto& pro : active_schedule.producers) {
+        for(const auto& pro : active_schedule->producers) {
             auto existing = producer_to_last_produced.find(pro.producer_name);
             if(existing != producer_to_last_produced.end()) {
                 new_producer_to_last_produced[pro.producer_name] = existing->second;
@@ -115,7 +117,7 @@ block_header_state::maybe_promote_pending() {
         }
 
         flat_map<account_name, uint32_t> new_producer_to_last_implied_irb;
-        for(const auto& pro : active_schedule.producers) {
+        for(const auto& pro : active_schedule->producers) {
             auto existing = producer_to_last_implied_irb.find(pro.producer_name);
             if(existing != producer_to_last_implied_irb.end()) {
                 new_producer_to_last_implied_irb[pro.producer_name] = existing->second;
@@ -136,8 +138,8 @@ block_header_state::maybe_promote_pending() {
 
 void
 block_header_state::set_new_producers(producer_schedule_type pending) {
-    EVT_ASSERT(pending.version == active_schedule.version + 1, producer_schedule_exception, "wrong producer schedule version specified");
-    EVT_ASSERT(pending_schedule.producers.size() == 0, producer_schedule_exception,
+    EVT_ASSERT(pending.version == active_schedule->version + 1, producer_schedule_exception, "wrong producer schedule version specified");
+    EVT_ASSERT(pending_schedule->producers.size() == 0, producer_schedule_exception,
               "cannot set new pending producers until last pending is confirmed");
     header.new_producers     = move(pending);
     pending_schedule_hash    = digest_type::hash(*header.new_producers);
@@ -260,7 +262,7 @@ block_header_state::add_confirmation(const header_confirmation& conf) {
     for(const auto& c : confirmations)
         EVT_ASSERT(c.producer != conf.producer, producer_double_confirm, "block already confirmed by this producer");
 
-    auto key = active_schedule.get_producer_key(conf.producer);
+    auto key = active_schedule->get_producer_key(conf.producer);
     EVT_ASSERT(key != public_key_type(), producer_not_in_schedule, "producer not in current schedule");
     auto signer = fc::crypto::public_key(conf.producer_signature, sig_digest(), true);
     EVT_ASSERT(signer == key, wrong_signing_key, "confirmation not signed by expected key");
@@ -4,8 +4,23 @@
  */
 #include <evt/chain/block_log.hpp>
 #include <evt/chain/exceptions.hpp>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+#include <deque>
 #include <fstream>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <thread>
+#include <boost/asio/post.hpp>
+#include <boost/asio/thread_pool.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
 #include <fc/io/raw.hpp>
+#include <zstd.h>
 
 #define LOG_READ  (std::ios::in | std::ios::binary)
 #define LOG_WRITE (std::ios::out | std::ios::binary | std::ios::app)
@@ -20,11 +35,40 @@ const uint32_t block_log::min_supported_version = 1;
  * Version 1: complete block log from genesis
  * Version 2: adds optional partial block log, cannot be used for replay without snapshot
  *            this is in the form of an first_block_num that is written immediately after the version
+ * Version 3: blocks are stored in frames of several blocks, usually zstd compressed; the index points to
+ *            the frame of each block. Produced by `convert_to_frames`, blocks appended later are stored as
+ *            uncompressed frames of one block each
  */
-const uint32_t block_log::max_supported_version = 2;
+const uint32_t block_log::max_supported_version = 3;
 
 namespace detail {
+
+namespace bip = boost::interprocess;
+
+constexpr uint32_t default_version = 2;  // version of newly created logs
+constexpr uint32_t framed_version  = 3;
+
+constexpr uint32_t segments_per_window = 4;  // segments of a pruned log covering the retained blocks
+
+enum frame_flags {
+    frame_compressed = 1
+};
+
+// each frame is followed by its 8 bytes position like block in older versions
+// the (decompressed) payload holds `block_count` entries of [uint32 size][packed block]
+struct frame_header {
+    uint32_t first_block_num;
+    uint16_t block_count;
+    uint16_t flags;
+    uint32_t payload_size;  // bytes stored in log
+    uint32_t raw_size;      // bytes after decompression
+};
+static_assert(sizeof(frame_header) == 16);
+
 class block_log_impl {
+public:
+    using region_ptr = std::shared_ptr<bip::mapped_region>;
+
 public:
     signed_block_ptr head;
     block_id_type    head_id;
@@ -34,10 +78,36 @@ public:
     fc::path         index_file;
     bool             open_files = false;
 
+    // read-only mappings, remapped after the files grow
+    // regions handed out to readers are kept alive by their shared pointers
+    region_ptr       block_region;
+    region_ptr       index_region;
+
+    // guards the mappings and the frame cache, blocks may be read from several api threads
+    std::mutex       read_mtx;
+
+    // last decompressed frame, sequential reads of one frame only decompress it once
+    uint64_t                           frame_pos = block_log::npos;
+    std::shared_ptr<std::vector<char>> frame_data;
+
     bool             genesis_written_to_block_log = false;
     uint32_t         version                      = 0;
     uint32_t         first_block_num              = 0;
 
+    // pruned log, segments are ordered by their blocks
+    // rotating takes the lock exclusively, readers of blocks share it
+    uint32_t                                retained_blocks = 0;
+    fc::path                                segments_dir;
+    std::deque<std::shared_ptr<block_log>>  segments;
+    mutable std::shared_mutex               segments_mtx;
+
+    bool framed() const { return version >= framed_version; }
+
+    // blocks of the active log before it's moved into a segment
+    uint32_t segment_blocks() const { return std::max(retained_blocks / segments_per_window, 1u); }
+
+    std::shared_ptr<block_log> find_segment(uint32_t block_num) const;
+
     inline void
     check_open_files() {
         if(!open_files) {
@@ -46,8 +116,17 @@ public:
     }
     void reopen();
 
+    region_ptr map_file(region_ptr& region, const fc::path& file, uint64_t end);
+
+    std::string_view read_frame(uint64_t pos, frame_header& fh, std::shared_ptr<const void>& holder);
+    std::string_view find_in_frame(const std::string_view& payload, const frame_header& fh, uint32_t block_num) const;
+
     void
     close() {
+        block_region.reset();
+        index_region.reset();
+        frame_pos = block_log::npos;
+        frame_data.reset();
         if(block_stream.is_open()) {
             block_stream.close();
         }
@@ -76,12 +155,292 @@ block_log_impl::reopen() {
     open_files = true;
 }
 
+block_log_impl::region_ptr
+block_log_impl::map_file(region_ptr& region, const fc::path& file, uint64_t end) {
+    auto lock = std::lock_guard(read_mtx);
+    if(!region || region->get_size() < end) {
+        auto size = fc::file_size(file);
+        EVT_ASSERT(end <= size, block_log_exception, "Read beyond the end of ${f}, end: ${e}, size: ${s}",
+                   ("f", file.generic_string())("e", end)("s", size));
+
+        auto mapping = bip::file_mapping(file.generic_string().c_str(), bip::read_only);
+        region = std::make_shared<bip::mapped_region>(mapping, bip::read_only, 0, size);
+    }
+    return region;
+}
+
+std::string_view
+block_log_impl::read_frame(uint64_t pos, frame_header& fh, std::shared_ptr<const void>& holder) {
+    auto region = map_file(block_region, block_file, pos + sizeof(fh));
+    memcpy(&fh, (const char*)region->get_address() + pos, sizeof(fh));
+
+    region = map_file(block_region, block_file, pos + sizeof(fh) + fh.payload_size);
+    auto payload = (const char*)region->get_address() + pos + sizeof(fh);
+    if(!(fh.flags & frame_compressed)) {
+        holder = region;
+        return std::string_view(payload, fh.payload_size);
+    }
+
+    auto lock = std::lock_guard(read_mtx);
+    if(frame_pos != pos) {
+        auto data = std::make_shared<std::vector<char>>(fh.raw_size);
+        auto r    = ZSTD_decompress(data->data(), data->size(), payload, fh.payload_size);
+        EVT_ASSERT(!ZSTD_isError(r) && r == fh.raw_size, block_log_exception, "Cannot decompress frame at ${pos}: ${err}",
+                   ("pos", pos)("err", ZSTD_isError(r) ? ZSTD_getErrorName(r) : "size mismatch"));
+
+        frame_pos  = pos;
+        frame_data = std::move(data);
+    }
+    holder = frame_data;
+    return std::string_view(frame_data->data(), frame_data->size());
+}
+
+std::string_view
+block_log_impl::find_in_frame(const std::string_view& payload, const frame_header& fh, uint32_t block_num) const {
+    EVT_ASSERT(block_num >= fh.first_block_num && block_num - fh.first_block_num < fh.block_count, block_log_exception,
+               "Block ${n} is not in frame starting at block ${f}", ("n", block_num)("f", fh.first_block_num));
+
+    auto offset = size_t(0);
+    for(auto i = fh.first_block_num; ; i++) {
+        uint32_t size;
+        EVT_ASSERT(offset + sizeof(size) <= payload.size(), block_log_exception, "Frame of block ${n} is malformed", ("n", block_num));
+        memcpy(&size, payload.data() + offset, sizeof(size));
+        offset += sizeof(size);
+
+        EVT_ASSERT(offset + size <= payload.size(), block_log_exception, "Frame of block ${n} is malformed", ("n", block_num));
+        if(i == block_num) {
+            return payload.substr(offset, size);
+        }
+        offset += size;
+    }
+}
+
+inline uint64_t
+read_marker(const char* data, uint64_t offset) {
+    uint64_t v;
+    memcpy(&v, data + offset, sizeof(v));
+    return v;
+}
+
+// runs `fn(i)` for i in [0, n) on a few threads and returns whether all of them succeeded
+template<typename Func>
+bool
+run_concurrently(size_t n, Func&& fn) {
+    auto pool    = boost::asio::thread_pool(std::clamp<size_t>(std::thread::hardware_concurrency(), 1, 8));
+    auto results = std::vector<std::future<bool>>();
+    for(auto i = 0u; i < n; i++) {
+        auto task = std::make_shared<std::packaged_task<bool()>>([&fn, i] { return fn(i); });
+        results.emplace_back(task->get_future());
+        boost::asio::post(pool, [task] { (*task)(); });
+    }
+    pool.join();
+
+    auto ok = true;
+    for(auto& r : results) {
+        try {
+            ok &= r.get();
+        }
+        catch(...) {
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+// finds a block boundary at or below `offset` by looking for a position marker whose back links look sane
+// a false match is detected later when the ranges are stitched together
+uint64_t
+find_anchor(const char* data, uint64_t first_pos, uint64_t lower, uint64_t offset) {
+    constexpr auto depth = 4;
+
+    for(auto x = offset; x > lower + sizeof(uint64_t); x--) {
+        auto marker = x - sizeof(uint64_t);  // marker right before the candidate block at `x`
+        auto p      = read_marker(data, marker);
+        if(p < first_pos || p >= marker) {
+            continue;
+        }
+
+        auto ok = true;
+        auto q  = p;
+        for(auto i = 0; i < depth && q > first_pos; i++) {
+            auto prev = read_marker(data, q - sizeof(uint64_t));
+            if(prev < first_pos || prev >= q - sizeof(uint64_t)) {
+                ok = false;
+                break;
+            }
+            q = prev;
+        }
+        if(ok) {
+            return p;
+        }
+    }
+    return block_log::npos;
+}
+
+/**
+ * Collects the positions of all the blocks in [first_pos, end_pos] from the trailing position markers.
+ * The log is split into ranges which are walked backwards concurrently, each range from the boundary
+ * found near its top down to the boundary of the range below. Returns empty vector if the markers
+ * don't form a chain.
+ */
+std::vector<uint64_t>
+collect_block_positions(const char* data, uint64_t first_pos, uint64_t end_pos) {
+    constexpr auto min_range_size = 64 * 1024 * 1024;
+
+    auto ranges  = std::clamp<size_t>((end_pos - first_pos) / min_range_size, 1, std::max(1u, std::thread::hardware_concurrency()));
+    auto anchors = std::vector<uint64_t>{ first_pos };
+    for(auto i = 1u; i < ranges; i++) {
+        auto a = find_anchor(data, first_pos, anchors.back(), first_pos + (end_pos - first_pos) / ranges * i);
+        if(a != block_log::npos && a > anchors.back()) {
+            anchors.emplace_back(a);
+        }
+    }
+    anchors.emplace_back(end_pos);
+
+    // positions in (anchors[i], anchors[i + 1]], descending
+    auto parts = std::vector<std::vector<uint64_t>>(anchors.size() - 1);
+    auto walk  = [&](size_t i) {
+        auto lower = anchors[i];
+        auto p     = anchors[i + 1];
+        while(p > lower) {
+            parts[i].emplace_back(p);
+
+            auto prev = read_marker(data, p - sizeof(uint64_t));
+            if(prev < lower || prev >= p - sizeof(uint64_t)) {
+                return false;
+            }
+            p = prev;
+        }
+        return p == lower;
+    };
+    if(!run_concurrently(parts.size(), walk)) {
+        if(anchors.size() == 2) {
+            return {};
+        }
+        // one of the anchors was a false match, walk the whole log in one go
+        anchors = { first_pos, end_pos };
+        parts   = std::vector<std::vector<uint64_t>>(1);
+        if(!walk(0)) {
+            return {};
+        }
+    }
+
+    auto positions = std::vector<uint64_t>{ first_pos };
+    for(auto& part : parts) {
+        positions.insert(positions.end(), part.crbegin(), part.crend());
+    }
+    return positions;
+}
+
+struct verified_log {
+    uint64_t end;             // end of the last kept block, including its position marker
+    uint32_t last_block_num;
+};
+
+/**
+ * Unpacks and checks all the blocks of an unframed log concurrently in chunks, the chunks are then
+ * checked to link to each other. Returns nothing if anything looks wrong, the caller then needs to
+ * recover block by block.
+ */
+std::optional<verified_log>
+verify_blocks(const char* data, uint64_t size, uint64_t first_pos, uint32_t truncate_at_block) {
+    constexpr auto chunk_size = 1024u;
+
+    if(size < first_pos + sizeof(uint64_t)) {
+        return {};
+    }
+    auto end_pos = read_marker(data, size - sizeof(uint64_t));
+    if(end_pos < first_pos || end_pos >= size - sizeof(uint64_t)) {
+        return {};
+    }
+
+    auto positions = collect_block_positions(data, first_pos, end_pos);
+    if(positions.empty()) {
+        return {};
+    }
+
+    struct chunk_result {
+        block_id_type first_previous;
+        uint32_t      first_num = 0;
+        block_id_type last_id;
+        uint32_t      last_num = 0;
+    };
+
+    auto n      = positions.size();
+    auto chunks = std::vector<chunk_result>((n + chunk_size - 1) / chunk_size);
+    auto ok     = run_concurrently(chunks.size(), [&](size_t c) {
+        auto& r = chunks[c];
+        for(auto i = c * chunk_size; i < std::min<size_t>(n, (c + 1) * chunk_size); i++) {
+            auto start = positions[i];
+            auto stop  = (i + 1 < n ? positions[i + 1] : size) - sizeof(uint64_t);
+            auto ds    = fc::datastream<const char*>(data + start, stop - start);
+
+            auto b = signed_block();
+            fc::raw::unpack(ds, b);
+            if(ds.remaining() != 0) {
+                return false;
+            }
+
+            auto num = b.block_num();
+            if(i == c * chunk_size) {
+                r.first_previous = b.previous;
+                r.first_num      = num;
+            }
+            else if(b.previous != r.last_id || num != r.last_num + 1) {
+                return false;
+            }
+            r.last_id  = b.id();
+            r.last_num = num;
+        }
+        return true;
+    });
+    if(!ok) {
+        return {};
+    }
+
+    for(auto c = 1u; c < chunks.size(); c++) {
+        if(chunks[c].first_previous != chunks[c - 1].last_id || chunks[c].first_num != chunks[c - 1].last_num + 1) {
+            return {};
+        }
+    }
+
+    auto first_num = chunks.front().first_num;
+    auto last_num  = chunks.back().last_num;
+    if(truncate_at_block >= first_num && truncate_at_block < last_num) {
+        return verified_log { .end = positions[truncate_at_block - first_num + 1], .last_block_num = truncate_at_block };
+    }
+    return verified_log { .end = size, .last_block_num = last_num };
+}
+
+std::shared_ptr<block_log>
+block_log_impl::find_segment(uint32_t block_num) const {
+    auto it = std::upper_bound(segments.begin(), segments.end(), block_num, [](auto n, auto& seg) {
+        return n < seg->first_block_num();
+    });
+    if(it == segments.begin()) {
+        return nullptr;
+    }
+    --it;
+    if(!(*it)->head() || block_num > (*it)->head()->block_num()) {
+        return nullptr;
+    }
+    return *it;
+}
+
+std::string
+segment_name(uint32_t first, uint32_t last) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%010u-%010u", first, last);
+    return buf;
+}
+
 }  // namespace detail
 
-block_log::block_log(const fc::path& data_dir)
+block_log::block_log(const fc::path& data_dir, uint32_t retained_blocks)
     : my(new detail::block_log_impl()) {
     my->block_stream.exceptions(std::fstream::failbit | std::fstream::badbit);
     my->index_stream.exceptions(std::fstream::failbit | std::fstream::badbit);
+    my->retained_blocks = retained_blocks;
     open(data_dir);
 }
 
@@ -104,9 +463,11 @@ block_log::open(const fc::path& data_dir) {
     if(!fc::is_directory(data_dir)) {
         fc::create_directories(data_dir);
     }
-    my->block_file = data_dir / "blocks.log";
-    my->index_file = data_dir / "blocks.index";
+    my->block_file   = data_dir / "blocks.log";
+    my->index_file   = data_dir / "blocks.index";
+    my->segments_dir = data_dir / "segments";
 
+    open_segments();
     my->reopen();
 
     /* On startup of the block log, there are several states the log file and the index file can be
@@ -188,6 +549,103 @@ block_log::open(const fc::path& data_dir) {
         fc::remove_all(my->index_file);
         my->reopen();
     }
+
+    if(my->head) {
+        prune_segments(my->head->block_num());
+    }
+}
+
+void
+block_log::open_segments() {
+    my->segments.clear();
+    if(!fc::is_directory(my->segments_dir)) {
+        return;
+    }
+
+    for(auto it = fc::directory_iterator(my->segments_dir); it != fc::directory_iterator(); ++it) {
+        auto dir = *it;
+        if(!fc::is_directory(dir) || !fc::is_regular_file(dir / "blocks.log")) {
+            continue;
+        }
+        auto seg = std::make_shared<block_log>(dir);
+        if(!seg->head()) {
+            wlog("Empty block log segment in ${d}, skipped", ("d", dir));
+            continue;
+        }
+        my->segments.emplace_back(std::move(seg));
+    }
+    std::sort(my->segments.begin(), my->segments.end(), [](auto& a, auto& b) {
+        return a->first_block_num() < b->first_block_num();
+    });
+
+    // crashed right after the active log was moved, the last segment becomes the active log again
+    if(!my->segments.empty() && (!fc::exists(my->block_file) || fc::file_size(my->block_file) == 0)) {
+        auto last = my->segments.back();
+        auto dir  = my->segments_dir / detail::segment_name(last->first_block_num(), last->head()->block_num());
+        my->segments.pop_back();
+        last.reset();
+
+        ilog("Restore block log segment in ${d} as active log", ("d", dir));
+        fc::remove_all(my->block_file);
+        fc::remove_all(my->index_file);
+        fc::rename(dir / "blocks.log", my->block_file);
+        fc::rename(dir / "blocks.index", my->index_file);
+        fc::remove_all(dir);
+    }
+
+    if(!my->segments.empty()) {
+        ilog("Opened ${n} block log segments, first available block: ${b}",
+            ("n", my->segments.size())("b", my->segments.front()->first_block_num()));
+    }
+}
+
+void
+block_log::rotate(uint32_t next_block_num) {
+    auto first = my->first_block_num;
+    auto last  = block_header::num_from_id(my->head_id);
+    auto gs    = extract_genesis_state(my->block_file.parent_path());
+
+    auto lock = std::unique_lock(my->segments_mtx);
+
+    // the files are moved as they are, a crash in between is recovered by `open_segments`
+    // the segment is synced here as later syncs only cover the new active log
+    sync();
+    my->close();
+
+    auto dir = my->segments_dir / detail::segment_name(first, last);
+    fc::create_directories(dir);
+    fc::rename(my->index_file, dir / "blocks.index");
+    fc::rename(my->block_file, dir / "blocks.log");
+    my->segments.emplace_back(std::make_shared<block_log>(dir));
+
+    reset_log(gs, nullptr, next_block_num);
+}
+
+void
+block_log::prune_segments(uint32_t head_block_num) {
+    if(my->retained_blocks == 0) {
+        return;
+    }
+
+    auto removed = std::vector<fc::path>();
+    {
+        auto lock = std::unique_lock(my->segments_mtx);
+        while(!my->segments.empty()) {
+            auto& seg  = my->segments.front();
+            auto  last = seg->head()->block_num();
+            if((uint64_t)last + my->retained_blocks > head_block_num) {
+                break;
+            }
+            removed.emplace_back(my->segments_dir / detail::segment_name(seg->first_block_num(), last));
+            my->segments.pop_front();
+        }
+    }
+
+    // readers still holding a segment keep reading from its unlinked files
+    for(auto& dir : removed) {
+        ilog("Remove pruned block log segment in ${d}", ("d", dir));
+        fc::remove_all(dir);
+    }
 }
 
 uint64_t
@@ -197,6 +655,12 @@ block_log::append(const signed_block_ptr& b) {
 
         my->check_open_files();
 
+        auto rotated = false;
+        if(my->retained_blocks > 0 && my->head && b->block_num() - my->first_block_num >= my->segment_blocks()) {
+            rotate(b->block_num());
+            rotated = true;
+        }
+
         my->block_stream.seekp(0, std::ios::end);
         my->index_stream.seekp(0, std::ios::end);
         uint64_t pos = my->block_stream.tellp();
@@ -205,6 +669,19 @@ block_log::append(const signed_block_ptr& b) {
                    "Append to index file occuring at wrong position.",
                    ("position", (uint64_t)my->index_stream.tellp())("expected", (b->block_num() - my->first_block_num) * sizeof(uint64_t)));
         auto data = fc::raw::pack(*b);
+        if(my->framed()) {
+            // single uncompressed frame
+            auto size = (uint32_t)data.size();
+            auto fh   = detail::frame_header {
+                .first_block_num = b->block_num(),
+                .block_count     = 1,
+                .flags           = 0,
+                .payload_size    = (uint32_t)(sizeof(size) + size),
+                .raw_size        = (uint32_t)(sizeof(size) + size)
+            };
+            my->block_stream.write((char*)&fh, sizeof(fh));
+            my->block_stream.write((char*)&size, sizeof(size));
+        }
         my->block_stream.write(data.data(), data.size());
         my->block_stream.write((char*)&pos, sizeof(pos));
         my->index_stream.write((char*)&pos, sizeof(pos));
@@ -213,6 +690,9 @@ block_log::append(const signed_block_ptr& b) {
 
         flush();
 
+        if(rotated) {
+            prune_segments(b->block_num());
+        }
         return pos;
     }
     FC_LOG_AND_RETHROW()
@@ -224,8 +704,48 @@ block_log::flush() {
     my->index_stream.flush();
 }
 
+namespace detail {
+
+static void
+sync_file(const fc::path& file) {
+    auto fd = ::open(file.generic_string().c_str(), O_RDONLY);
+    EVT_ASSERT(fd >= 0, block_log_exception, "Cannot open ${f} to sync it: ${err}", ("f", file.generic_string())("err", strerror(errno)));
+#if defined(__APPLE__)
+    auto r = ::fcntl(fd, F_FULLFSYNC);
+#else
+    auto r = ::fdatasync(fd);
+#endif
+    auto err = errno;
+    ::close(fd);
+    EVT_ASSERT(r == 0, block_log_exception, "Cannot sync ${f}: ${err}", ("f", file.generic_string())("err", strerror(err)));
+}
+
+}  // namespace detail
+
+void
+block_log::sync() {
+    if(!my->open_files) {
+        return;
+    }
+    flush();
+    // the blocks are synced before the index, which can be reconstructed from them
+    detail::sync_file(my->block_file);
+    detail::sync_file(my->index_file);
+}
+
 void
 block_log::reset(const genesis_state& gs, const signed_block_ptr& first_block, uint32_t first_block_num) {
+    {
+        auto lock = std::unique_lock(my->segments_mtx);
+        my->segments.clear();
+    }
+    fc::remove_all(my->segments_dir);
+
+    reset_log(gs, first_block, first_block_num);
+}
+
+void
+block_log::reset_log(const genesis_state& gs, const signed_block_ptr& first_block, uint32_t first_block_num) {
     my->close();
 
     fc::remove_all(my->block_file);
@@ -252,8 +772,8 @@ block_log::reset(const genesis_state& gs, const signed_block_ptr& first_block, u
 
     auto pos = my->block_stream.tellp();
 
-    static_assert(block_log::max_supported_version > 0, "a version number of zero is not supported");
-    my->version = block_log::max_supported_version;
+    static_assert(detail::default_version > 0, "a version number of zero is not supported");
+    my->version = detail::default_version;
     my->block_stream.seekp(0);
     my->block_stream.write((char*)&my->version, sizeof(my->version));
     my->block_stream.seekp(pos);
@@ -262,23 +782,81 @@ block_log::reset(const genesis_state& gs, const signed_block_ptr& first_block, u
 
 std::pair<signed_block_ptr, uint64_t>
 block_log::read_block(uint64_t pos) const {
+    auto lock = std::shared_lock(my->segments_mtx);
     my->check_open_files();
 
-    my->block_stream.seekg(pos);
+    if(my->framed()) {
+        // returns the first block of the frame at `pos` and position of the next frame
+        auto fh      = detail::frame_header();
+        auto holder  = std::shared_ptr<const void>();
+        auto payload = my->read_frame(pos, fh, holder);
+        auto data    = my->find_in_frame(payload, fh, fh.first_block_num);
+        auto ds      = fc::datastream<const char*>(data.data(), data.size());
+
+        std::pair<signed_block_ptr, uint64_t> result;
+        result.first = make_signed_block();
+        fc::raw::unpack(ds, *result.first);
+        result.second = pos + sizeof(fh) + fh.payload_size + 8;
+        return result;
+    }
+
+    auto  region = my->map_file(my->block_region, my->block_file, pos + 1);
+    auto  ds     = fc::datastream<const char*>((const char*)region->get_address() + pos, region->get_size() - pos);
+
     std::pair<signed_block_ptr, uint64_t> result;
-    result.first = std::make_shared<signed_block>();
-    fc::raw::unpack(my->block_stream, *result.first);
-    result.second = uint64_t(my->block_stream.tellg()) + 8;
+    result.first = make_signed_block();
+    fc::raw::unpack(ds, *result.first);
+    result.second = pos + ds.tellp() + 8;
     return result;
 }
 
+block_log::serialized_block
+block_log::read_serialized_block_by_num(uint32_t block_num) const {
+    try {
+        auto lock = std::shared_lock(my->segments_mtx);
+        if(block_num < my->first_block_num) {
+            auto seg = my->find_segment(block_num);
+            return seg ? seg->read_serialized_block_by_num(block_num) : serialized_block();
+        }
+
+        auto pos = get_block_pos(block_num);
+        if(pos == npos) {
+            return {};
+        }
+
+        if(my->framed()) {
+            auto fh      = detail::frame_header();
+            auto holder  = std::shared_ptr<const void>();
+            auto payload = my->read_frame(pos, fh, holder);
+            return serialized_block { .holder = holder, .data = my->find_in_frame(payload, fh, block_num) };
+        }
+
+        // each block is followed by its 8 bytes position
+        auto end = uint64_t();
+        if(block_num < block_header::num_from_id(my->head_id)) {
+            end = get_block_pos(block_num + 1) - sizeof(uint64_t);
+        }
+        else {
+            end = fc::file_size(my->block_file) - sizeof(uint64_t);
+        }
+        EVT_ASSERT(end > pos, block_log_exception, "Block log is malformed around block ${n}", ("n", block_num));
+
+        auto  region = my->map_file(my->block_region, my->block_file, end);
+        auto  data   = std::string_view((const char*)region->get_address() + pos, end - pos);
+        return serialized_block { .holder = region, .data = data };
+    }
+    FC_LOG_AND_RETHROW()
+}
+
 signed_block_ptr
 block_log::read_block_by_num(uint32_t block_num) const {
     try {
         signed_block_ptr b;
-        uint64_t         pos = get_block_pos(block_num);
-        if(pos != npos) {
-            b = read_block(pos).first;
+        auto             sb = read_serialized_block_by_num(block_num);
+        if(!sb.data.empty()) {
+            auto ds = fc::datastream<const char*>(sb.data.data(), sb.data.size());
+            b = make_signed_block();
+            fc::raw::unpack(ds, *b);
             EVT_ASSERT(b->block_num() == block_num, reversible_blocks_exception,
                        "Wrong block was read from block log.", ("returned", b->block_num())("expected", block_num));
         }
@@ -292,9 +870,11 @@ block_log::get_block_pos(uint32_t block_num) const {
     my->check_open_files();
     if(!(my->head && block_num <= block_header::num_from_id(my->head_id) && block_num >= my->first_block_num))
         return npos;
-    my->index_stream.seekg(sizeof(uint64_t) * (block_num - my->first_block_num));
+    auto  offset = sizeof(uint64_t) * (block_num - my->first_block_num);
+    auto  region = my->map_file(my->index_region, my->index_file, offset + sizeof(uint64_t));
+
     uint64_t pos;
-    my->index_stream.read((char*)&pos, sizeof(pos));
+    memcpy(&pos, (const char*)region->get_address() + offset, sizeof(pos));
     return pos;
 }
 
@@ -311,12 +891,23 @@ block_log::read_head() const {
 
     my->block_stream.seekg(-sizeof(pos), std::ios::end);
     my->block_stream.read((char*)&pos, sizeof(pos));
-    if(pos != npos) {
-        return read_block(pos).first;
-    }
-    else {
+    if(pos == npos) {
         return {};
     }
+
+    if(my->framed()) {
+        // head is the last block of the last frame
+        auto fh      = detail::frame_header();
+        auto holder  = std::shared_ptr<const void>();
+        auto payload = my->read_frame(pos, fh, holder);
+        auto data    = my->find_in_frame(payload, fh, fh.first_block_num + fh.block_count - 1);
+        auto ds      = fc::datastream<const char*>(data.data(), data.size());
+
+        auto b = make_signed_block();
+        fc::raw::unpack(ds, *b);
+        return b;
+    }
+    return read_block(pos).first;
 }
 
 const signed_block_ptr&
@@ -329,6 +920,12 @@ block_log::first_block_num() const {
     return my->first_block_num;
 }
 
+uint32_t
+block_log::first_available_block_num() const {
+    auto lock = std::shared_lock(my->segments_mtx);
+    return my->segments.empty() ? my->first_block_num : my->segments.front()->first_block_num();
+}
+
 void
 block_log::construct_index() {
     ilog("Reconstructing Block Log Index...");
@@ -367,16 +964,37 @@ block_log::construct_index() {
     }
 
     my->index_stream.seekp(0, std::ios::end);
-    while(pos < end_pos) {
-        signed_block tmp;
-        fc::raw::unpack(my->block_stream, tmp);
-        
-        my->block_stream.read((char*)&pos, sizeof(pos));
-        if(tmp.block_num() % 1000 == 0) {
-            ilog2_("Block log index reconstructed for block {:n}", tmp.block_num());
+    if(my->framed()) {
+        // all the blocks of one frame point to it
+        while(true) {
+            pos = my->block_stream.tellg();
+
+            auto fh = detail::frame_header();
+            my->block_stream.read((char*)&fh, sizeof(fh));
+            for(auto i = 0u; i < fh.block_count; i++) {
+                my->index_stream.write((char*)&pos, sizeof(pos));
+            }
+            my->block_stream.seekg(fh.payload_size + sizeof(uint64_t), std::ios::cur);
+
+            if(pos >= end_pos) {
+                break;
+            }
         }
-        my->index_stream.write((char*)&pos, sizeof(pos));
+        my->index_stream.flush();
+        return;
     }
+
+    // positions are taken from the markers concurrently, no block needs to be unpacked
+    auto  first_pos = (uint64_t)my->block_stream.tellg();
+    auto  region    = my->map_file(my->block_region, my->block_file, end_pos + 1);
+    auto  positions = detail::collect_block_positions((const char*)region->get_address(), first_pos, end_pos);
+    EVT_ASSERT(!positions.empty(), block_log_exception, "Position markers in block log are broken, repair the block log first");
+
+    my->index_stream.write((char*)positions.data(), positions.size() * sizeof(uint64_t));
+    ilog2_("Block log index reconstructed for {:n} blocks", positions.size());
+
+    // make the index visible to the mapped reads
+    my->index_stream.flush();
 }  // construct_index
 
 fc::path
@@ -425,6 +1043,9 @@ block_log::repair_log(const fc::path& data_dir, uint32_t truncate_at_block) {
                "Unsupported version of block log. Block log version is ${version} while code supports version(s) [${min},${max}]",
                ("version", version)("min", block_log::min_supported_version)("max", block_log::max_supported_version));
 
+    EVT_ASSERT(version < detail::framed_version, block_log_unsupported_version,
+               "Repairing framed block log is not supported, convert the repaired unframed log again instead");
+
     new_block_stream.write((char*)&version, sizeof(version));
 
     uint32_t first_block_num = 1;
@@ -451,6 +1072,26 @@ block_log::repair_log(const fc::path& data_dir, uint32_t truncate_at_block) {
         new_block_stream.write((char*)&actual_totem, sizeof(actual_totem));
     }
 
+    // intact logs are verified concurrently and copied verbatim,
+    // logs with any damage are recovered block by block below
+    if(uint64_t first_pos = old_block_stream.tellg(); first_pos < end_pos) {
+        auto mapping = detail::bip::file_mapping((backup_dir / "blocks.log").generic_string().c_str(), detail::bip::read_only);
+        auto region  = detail::bip::mapped_region(mapping, detail::bip::read_only, 0, end_pos);
+        auto data    = (const char*)region.get_address();
+
+        if(auto r = detail::verify_blocks(data, end_pos, first_pos, truncate_at_block); r.has_value()) {
+            new_block_stream.write(data + first_pos, r->end - first_pos);
+            if(r->end < end_pos) {
+                ilog("Stopped recovery of block log early at specified block number: ${stop}.", ("stop", truncate_at_block));
+            }
+            else {
+                ilog("Existing block log was undamaged. Recovered all irreversible blocks up to block number ${num}.", ("num", r->last_block_num));
+            }
+            return backup_dir;
+        }
+        ilog("Block log is damaged, recovering block by block");
+    }
+
     std::exception_ptr     except_ptr;
     vector<char>           incomplete_block_data;
     optional<signed_block> bad_block;
@@ -576,4 +1217,88 @@ block_log::extract_genesis_state(const fc::path& data_dir) {
     return gs;
 }
 
+uint32_t
+block_log::convert_to_frames(const fc::path& data_dir, const fc::path& out_dir, uint32_t frame_blocks, int level) {
+    EVT_ASSERT(frame_blocks > 0 && frame_blocks <= std::numeric_limits<uint16_t>::max(), block_log_exception,
+               "Invalid number of blocks per frame: ${n}", ("n", frame_blocks));
+    EVT_ASSERT(!fc::exists(out_dir / "blocks.log"), block_log_exception, "Block log already exists in '${dir}'", ("dir", out_dir));
+
+    auto gs  = extract_genesis_state(data_dir);
+    auto src = block_log(data_dir);
+    EVT_ASSERT(!src.my->framed(), block_log_exception, "Block log in '${dir}' is already framed", ("dir", data_dir));
+
+    if(!fc::is_directory(out_dir)) {
+        fc::create_directories(out_dir);
+    }
+
+    std::fstream block_stream;
+    std::fstream index_stream;
+    block_stream.exceptions(std::fstream::failbit | std::fstream::badbit);
+    index_stream.exceptions(std::fstream::failbit | std::fstream::badbit);
+    block_stream.open((out_dir / "blocks.log").generic_string().c_str(), LOG_WRITE);
+    index_stream.open((out_dir / "blocks.index").generic_string().c_str(), LOG_WRITE);
+
+    auto version         = detail::framed_version;
+    auto first_block_num = src.first_block_num();
+    auto data            = fc::raw::pack(gs);
+    auto totem           = npos;
+    block_stream.write((char*)&version, sizeof(version));
+    block_stream.write((char*)&first_block_num, sizeof(first_block_num));
+    block_stream.write(data.data(), data.size());
+    block_stream.write((char*)&totem, sizeof(totem));
+
+    auto raw        = std::vector<char>();
+    auto compressed = std::vector<char>();
+
+    auto write_frame = [&](uint32_t first, uint16_t count) {
+        compressed.resize(ZSTD_compressBound(raw.size()));
+        auto r = ZSTD_compress(compressed.data(), compressed.size(), raw.data(), raw.size(), level);
+        EVT_ASSERT(!ZSTD_isError(r), block_log_exception, "Cannot compress frame of block ${n}: ${err}", ("n", first)("err", ZSTD_getErrorName(r)));
+
+        uint64_t pos = block_stream.tellp();
+        auto     fh  = detail::frame_header {
+            .first_block_num = first,
+            .block_count     = count,
+            .flags           = detail::frame_compressed,
+            .payload_size    = (uint32_t)r,
+            .raw_size        = (uint32_t)raw.size()
+        };
+        block_stream.write((char*)&fh, sizeof(fh));
+        block_stream.write(compressed.data(), r);
+        block_stream.write((char*)&pos, sizeof(pos));
+        for(auto i = 0u; i < count; i++) {
+            index_stream.write((char*)&pos, sizeof(pos));
+        }
+        raw.clear();
+    };
+
+    auto head_num    = src.head() ? src.head()->block_num() : 0u;
+    auto frame_first = first_block_num;
+    auto count       = uint16_t(0);
+    for(auto num = first_block_num; num <= head_num; num++) {
+        auto sb = src.read_serialized_block_by_num(num);
+        EVT_ASSERT(!sb.data.empty(), block_log_exception, "Block ${n} is missing from block log", ("n", num));
+
+        auto size = (uint32_t)sb.data.size();
+        raw.insert(raw.end(), (char*)&size, (char*)&size + sizeof(size));
+        raw.insert(raw.end(), sb.data.cbegin(), sb.data.cend());
+
+        if(++count == frame_blocks) {
+            write_frame(frame_first, count);
+            frame_first = num + 1;
+            count       = 0;
+        }
+        if(num % 10000 == 0) {
+            ilog2_("Converted block {:n}", num);
+        }
+    }
+    if(count > 0) {
+        write_frame(frame_first, count);
+    }
+
+    block_stream.flush();
+    index_stream.flush();
+    return head_num >= first_block_num ? head_num - first_block_num + 1 : 0;
+}
+
 }}  // namespace evt::chain
@@ -9,7 +9,7 @@ namespace evt { namespace chain {
 
 block_state::block_state(const block_header_state& prev, block_timestamp_type when)
     : block_header_state(prev.generate_next(when))
-    , block(std::make_shared<signed_block>()) {
+    , block(make_signed_block()) {
     static_cast<block_header&>(*block) = header;
 }
 
@@ -17,4 +17,30 @@ block_state::block_state(const block_header_state& prev, signed_block_ptr b, boo
     : block_header_state(prev.next(*b, skip_validate_signee))
     , block(move(b)) {}
 
+void
+block_state::release_trxs() {
+    trxs.clear();
+    trxs.shrink_to_fit();
+    trxs_released = true;
+}
+
+const vector<transaction_metadata_ptr>&
+block_state::get_trxs() {
+    if(!trxs_released) {
+        return trxs;
+    }
+
+    EVT_ASSERT(block, block_validate_exception, "cannot rebuild transactions of a block that was sparsely loaded from a snapshot");
+
+    trxs.reserve(block->transactions.size());
+    for(const auto& receipt : block->transactions) {
+        if(receipt.type != transaction_receipt::input) {
+            continue;
+        }
+        trxs.emplace_back(make_transaction_metadata(receipt.trx));
+    }
+    trxs_released = false;
+    return trxs;
+}
+
 }}  // namespace evt::chain
@@ -129,6 +129,7 @@ abi_serializer::set_abi(const abi_def& abi) {
     structs_.clear();
     variants_.clear();
     enums_.clear();
+    reflected_types_.clear();  // checked against the previous definitions
 
     for(auto& st : abi.structs) {
         structs_[st.name] = st;
@@ -161,6 +162,65 @@ abi_serializer::is_builtin_type(const type_name& type) const {
     return built_in_types_.find(type) != built_in_types_.end();
 }
 
+bool
+abi_serializer::is_reflected_type(const type_name& type) const {
+    return reflected_types_.find(type) != reflected_types_.end();
+}
+
+bool
+abi_serializer::_is_reflectable(const type_name& type, const std::vector<std::pair<string, bool>>& fields) const {
+    auto it = structs_.find(type);
+    if(it == structs_.end() || it->second.base != type_name() || it->second.fields.size() != fields.size()) {
+        return false;
+    }
+
+    auto& st = it->second;
+    for(auto i = 0u; i < fields.size(); i++) {
+        auto& field = st.fields[i];
+        auto  rtype = resolve_type(field.type);
+        auto  ftype = resolve_type(fundamental_type(rtype));
+        if(field.name != fields[i].first || is_optional(rtype) != fields[i].second) {
+            return false;
+        }
+        // bool is packed as uint8 and output as a number by the abi, reflection outputs true or false
+        if(ftype == "bool" || built_in_types_.find(ftype) == built_in_types_.end()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool
+abi_serializer::_reflected_to_variant(const type_name& type, const bytes& binary, fc::variant& var) const {
+    auto it = reflected_types_.find(type);
+    if(it == reflected_types_.end()) {
+        return false;
+    }
+
+    auto ds = fc::datastream<const char*>(binary.data(), binary.size());
+    try {
+        var = it->second.first(ds);
+    }
+    EVT_RETHROW_EXCEPTIONS(unpack_exception, "Unable to unpack struct '${type}'", ("type", type))
+    if(ds.remaining() > 0) {
+        EVT_THROW2(unpack_exception, "Binary buffer is not EOF after unpack variable, remaining: {} bytes.", ds.remaining());
+    }
+    return true;
+}
+
+bool
+abi_serializer::_reflected_to_binary(const type_name& type, const fc::variant& var, bytes& binary) const {
+    // structs given as arrays of fields are left to the abi walk
+    if(!var.is_object()) {
+        return false;
+    }
+    auto it = reflected_types_.find(type);
+    if(it == reflected_types_.end()) {
+        return false;
+    }
+    return it->second.second(var.get_object(), binary);
+}
+
 bool
 abi_serializer::is_integer(const type_name& type) const {
     auto stype = type;
@@ -438,6 +498,11 @@ abi_serializer::_binary_to_variant(const type_name& type, fc::datastream<const c
 fc::variant
 abi_serializer::_binary_to_variant(const type_name& type, const bytes& binary, impl::binary_to_variant_context& ctx) const {
     auto h   = ctx.enter_scope();
+    auto rv  = fc::variant();
+    if(_reflected_to_variant(type, binary, rv)) {
+        return rv;
+    }
+
     auto ds  = fc::datastream(binary.data(), binary.size());
     auto var = _binary_to_variant(type, ds, ctx);
     if(ds.remaining() > 0) {
@@ -607,7 +672,12 @@ abi_serializer::_variant_to_binary(const type_name& type, const fc::variant& var
         auto h = ctx.enter_scope();
         EVT_ASSERT2(_is_type(type), unknown_abi_type_exception, "Unknown type: {} in ABI", type);
 
-        auto temp = bytes(1024 * 1024);
+        auto temp = bytes();
+        if(_reflected_to_binary(type, var, temp)) {
+            return temp;
+        }
+
+        temp.resize(1024 * 1024);
         auto ds   = fc::datastream<char*>(temp.data(), temp.size());
 
         _variant_to_binary(type, var, ds, ctx);
@@ -12,11 +12,12 @@ namespace evt { namespace chain { namespace contracts {
 /**
  * Hisotry
  * 4.1.1: Update memo field in everipass v2 and everipay v2 to be optional
+ * 4.2.0: Add addmeta v2 which keeps metas apart from domains, fungibles and groups
  */
 
 static auto evt_abi_version       = 4;
-static auto evt_abi_minor_version = 1;
-static auto evt_abi_patch_version = 1;
+static auto evt_abi_minor_version = 2;
+static auto evt_abi_patch_version = 0;
 
 version
 evt_contract_abi_version() {
@@ -336,6 +337,14 @@ evt_contract_abi() {
         }
     });
 
+    evt_abi.structs.emplace_back( struct_def {
+        "addmeta_v2", "", {
+            {"key", "meta_key"},
+            {"value", "meta_value"},
+            {"creator", "authorizer_ref"}
+        }
+    });
+
     evt_abi.structs.emplace_back( struct_def {
         "newsuspend", "", {
             {"name", "proposal_name"},
@@ -491,6 +500,15 @@ evt_contract_abi() {
         }
     });
 
+    evt_abi.structs.emplace_back( struct_def {
+        "distpsvbonus_v2", "", {
+           {"sym_id", "symbol_id_type"},
+           {"deadline", "time_point"},
+           {"final_receiver", "address?"},
+           {"max_holders", "uint32"}
+        }
+    });
+
     // abi_def fields
     evt_abi.structs.emplace_back( struct_def {
         "field_def", "", {
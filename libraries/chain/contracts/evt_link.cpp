@@ -13,6 +13,7 @@
 #include <fc/crypto/hex.hpp>
 #include <fc/crypto/elliptic.hpp>
 #include <evt/chain/exceptions.hpp>
+#include <evt/utilities/lru_cache.hpp>
 
 using namespace boost::multiprecision;
 
@@ -137,6 +138,20 @@ parse_signatures(const bytes& b) {
     return sigs;
 }
 
+// links parsed from their text form, by the text
+utilities::lru_cache<evt_link>&
+parsed_links() {
+    static auto cache = utilities::lru_cache<evt_link>(evt_link::kDefaultCacheSize);
+    return cache;
+}
+
+// keys recovered from the signatures, by the bytes of segments and signatures
+utilities::lru_cache<public_keys_set>&
+recovered_keys() {
+    static auto cache = utilities::lru_cache<public_keys_set>(evt_link::kDefaultCacheSize);
+    return cache;
+}
+
 }  // namespace internal
 
 evt_link
@@ -146,6 +161,11 @@ evt_link::parse_from_evtli(const std::string& str) {
     EVT_ASSERT(str.size() < 400, evt_link_exception, "Link is too long, max length allowed: 400");
     EVT_ASSERT(str.size() > 20, evt_link_exception, "Link is too short");
 
+    auto link = evt_link();
+    if(parsed_links().get(str, link)) {
+        return link;
+    }
+
     size_t start = 0;
     if(memcmp(str.data(), URI_SCHEMA, strlen(URI_SCHEMA)) == 0) {
         start = strlen(URI_SCHEMA);
@@ -164,11 +184,10 @@ evt_link::parse_from_evtli(const std::string& str) {
         bsigs = decode<bigint_sigs>(str, d + 1, str.size());
     }
 
-    auto link = evt_link();
-
     link.segments_   = parse_segments(bsegs, link.header_);
     link.signatures_ = parse_signatures(bsigs);
 
+    parsed_links().put(str, link);
     return link;
 }
 
@@ -289,8 +308,35 @@ encode(const bytes& b, size_t sz, std::string& str) {
     std::reverse(str.begin() + i, str.end());
 }
 
+struct string_stream {
+public:
+    string_stream(std::string& str) : str_(str) {}
+
+public:
+    void write(const char* d, size_t s) { str_.append(d, s); }
+
+private:
+    std::string& str_;
+};
+
 }  // namespace internal
 
+void
+evt_link::set_cache_size(size_t size) {
+    internal::parsed_links().set_capacity(size);
+    internal::recovered_keys().set_capacity(size);
+}
+
+evt_link::cache_stats
+evt_link::get_cache_stats() {
+    auto stats         = cache_stats();
+    stats.parse_hits   = internal::parsed_links().hits();
+    stats.parse_misses = internal::parsed_links().misses();
+    stats.keys_hits    = internal::recovered_keys().hits();
+    stats.keys_misses  = internal::recovered_keys().misses();
+    return stats;
+}
+
 fc::sha256
 evt_link::digest() const {
     using namespace internal;
@@ -333,13 +379,28 @@ evt_link::to_string(int prefix) const {
 
 public_keys_set
 evt_link::restore_keys() const {
-    auto hash = digest();
+    using namespace internal;
+
+    // terminals resubmit the same link on timeout and every consumer of an applied
+    // everiPass/everiPay restores its keys again, recover them only once
+    auto key = std::string();
+    auto ss  = string_stream(key);
+    write_segments_bytes(*this, ss);
+    write_signatures_bytes(*this, ss);
+
     auto keys = public_keys_set();
+    if(recovered_keys().get(key, keys)) {
+        return keys;
+    }
+
+    if(!signatures_.empty()) {
+        auto recovered = fc::small_vector<public_key_type, 2>(signatures_.size());
+        public_key_type::recover_keys(&*signatures_.begin(), signatures_.size(), digest(), recovered.data());
 
-    keys.reserve(signatures_.size());
-    for(auto& sig : signatures_) {
-        keys.emplace(public_key_type(sig, hash));
+        keys.reserve(recovered.size());
+        keys.insert(recovered.begin(), recovered.end());
     }
+    recovered_keys().put(key, keys);
     return keys;
 }
 
@@ -4,19 +4,39 @@
  */
 #include <evt/chain/controller.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <future>
+#include <mutex>
+#include <thread>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <boost/filesystem.hpp>
 #include <chainbase/chainbase.hpp>
 #include <fmt/format.h>
 
 #include <fc/io/json.hpp>
+#include <fc/log/trace.hpp>
 #include <fc/scoped_exit.hpp>
 #include <fc/variant_object.hpp>
 
+#include <evt/chain/action_costs.hpp>
 #include <evt/chain/authority_checker.hpp>
+#include <evt/chain/authority_memo.hpp>
 #include <evt/chain/block_log.hpp>
 #include <evt/chain/charge_manager.hpp>
 #include <evt/chain/chain_snapshot.hpp>
 #include <evt/chain/execution_context_impl.hpp>
 #include <evt/chain/fork_database.hpp>
+#include <evt/chain/genesis_initial_state.hpp>
+#include <evt/chain/reversible_block_store.hpp>
+#include <evt/chain/trx_index.hpp>
 #include <evt/chain/snapshot.hpp>
 #include <evt/chain/token_database.hpp>
 #include <evt/chain/token_database_cache.hpp>
@@ -25,11 +45,12 @@
 #include <evt/chain/contracts/abi_serializer.hpp>
 #include <evt/chain/contracts/evt_contract_abi.hpp>
 #include <evt/chain/contracts/evt_org.hpp>
+#include <evt/chain/contracts/types.hpp>
+#include <evt/utilities/task_scheduler.hpp>
 
 #include <evt/chain/block_summary_object.hpp>
 #include <evt/chain/global_property_object.hpp>
 #include <evt/chain/transaction_object.hpp>
-#include <evt/chain/reversible_block_object.hpp>
 #include <evt/chain/contracts/evt_link_object.hpp>
 
 namespace evt { namespace chain {
@@ -41,6 +62,66 @@ using controller_index_set = index_set<
    transaction_multi_index
 >;
 
+/**
+ *  Blocking FIFO with a fixed capacity connecting the stages of replay.
+ *  After `close` pushes fail and pops return false once the queue is drained.
+ */
+/**
+ *  Identity of a checkpoint, it's only usable when the same block is found in block log.
+ */
+struct checkpoint_info {
+    uint32_t      block_num;
+    block_id_type block_id;
+};
+
+template<typename T>
+class bounded_queue {
+public:
+    explicit bounded_queue(size_t capacity)
+        : capacity_(capacity) {}
+
+    bool
+    push(T&& v) {
+        auto lock = std::unique_lock<std::mutex>(mutex_);
+        not_full_.wait(lock, [this] { return closed_ || queue_.size() < capacity_; });
+        if(closed_) {
+            return false;
+        }
+        queue_.emplace_back(std::move(v));
+        not_empty_.notify_one();
+        return true;
+    }
+
+    bool
+    pop(T& v) {
+        auto lock = std::unique_lock<std::mutex>(mutex_);
+        not_empty_.wait(lock, [this] { return closed_ || !queue_.empty(); });
+        if(queue_.empty()) {
+            return false;
+        }
+        v = std::move(queue_.front());
+        queue_.pop_front();
+        not_full_.notify_one();
+        return true;
+    }
+
+    void
+    close() {
+        auto lock = std::unique_lock<std::mutex>(mutex_);
+        closed_ = true;
+        not_full_.notify_all();
+        not_empty_.notify_all();
+    }
+
+private:
+    std::deque<T>           queue_;
+    size_t                  capacity_;
+    bool                    closed_ = false;
+    std::mutex              mutex_;
+    std::condition_variable not_full_;
+    std::condition_variable not_empty_;
+};
+
 class maybe_session {
 public:
     maybe_session() = default;
@@ -112,6 +193,32 @@ private:
     optional<token_database::session> _token_session;
 };
 
+/**
+ *  Durations of the stages of startup, each stage lasts from the previous mark.
+ */
+struct startup_timeline {
+    fc::time_point                                last = fc::time_point::now();
+    std::vector<std::pair<std::string, uint64_t>> stages;
+
+    void
+    mark(std::string stage) {
+        auto now = fc::time_point::now();
+        stages.emplace_back(std::move(stage), (now - last).count() / 1000);
+        last = now;
+    }
+
+    void
+    print() const {
+        auto total = (uint64_t)0;
+        auto s     = std::string();
+        for(auto& it : stages) {
+            s += fmt::format("\n    {:<40} {:>8n} ms", it.first, it.second);
+            total += it.second;
+        }
+        ilog("startup stages, total: ${t} ms${s}", ("t", total)("s", s));
+    }
+};
+
 struct pending_state {
     pending_state(maybe_session&& s)
         : _db_session(move(s)) {}
@@ -124,6 +231,7 @@ struct pending_state {
     small_vector<action_receipt, 4> _actions;
     controller::block_status        _block_status = controller::block_status::incomplete;
     optional<block_id_type>         _producer_block_id;
+    bool                            _finalized = false;
 
     void
     push() {
@@ -133,14 +241,17 @@ struct pending_state {
 
 struct controller_impl {
     controller&              self;
+    startup_timeline         timeline;
+    token_database           token_db;
+    token_database_cache     token_db_cache;
+    std::future<void>        token_db_opening;  ///< token database is opened aside while the others are loaded
     chainbase::database      db;
-    chainbase::database      reversible_blocks; ///< a special database to persist blocks that have successfully been applied but are still reversible
+    reversible_block_store   reversible_blocks; ///< a special file to persist blocks that have successfully been applied but are still reversible
     block_log                blog;
+    std::unique_ptr<trx_index> trx_locations;  ///< transactions of irreversible blocks, optional
     optional<pending_state>  pending;
     block_state_ptr          head;
     fork_database            fork_db;
-    token_database           token_db;
-    token_database_cache     token_db_cache;
     controller::config       conf;
     chain_id_type            chain_id;
     evt_execution_context    exec_ctx;
@@ -152,7 +263,31 @@ struct controller_impl {
     bool                     in_trx_requiring_checks = false; ///< if true, checks that are normally skipped on replay (e.g. auth checks) cannot be skipped
     bool                     trusted_producer_light_validation = false;
     uint32_t                 snapshot_head_block = 0;
-    abi_serializer           system_api;
+    uint32_t                 last_checkpoint_block = 0;
+    uint32_t                 uncommitted_blocks = 0;  ///< irreversible blocks not synced yet, see `commit_durable`
+    fc::time_point           last_commit_time;
+    mutable optional<abi_serializer> system_api;  ///< built on first use, only APIs and plugins need it
+    mutable std::once_flag           system_api_flag;
+    utilities::task_scheduler scheduler;
+    action_cost_tracker      action_costs;
+
+    /**
+     *  Input transactions of the blocks going to be applied, their keys are being
+     *  recovered in thread pool ahead of application.
+     */
+    std::deque<std::pair<signed_block_ptr, std::vector<transaction_metadata_ptr>>> prepared_blocks;
+
+    /**
+     *  Header states of the blocks going to be pushed, verified by `verify_block` on other threads.
+     */
+    std::deque<block_state_ptr> verified_blocks;
+
+    authority_memo                      auth_memo;
+    utilities::scoped_signal_connection auth_memo_conns[2];
+
+    // deltas of the transaction just squashed, only collected when changes are tracked
+    token_database::token_deltas       squashed_deltas;
+    boost::signals2::scoped_connection token_changes_conns[2];
 
     /**
      *  Transactions that were undone by pop_block or abort_block, transactions
@@ -166,13 +301,11 @@ struct controller_impl {
         auto prev = fork_db.get_block(head->header.previous);
         EVT_ASSERT(prev, block_validate_exception, "attempt to pop beyond last irreversible block");
 
-        if(const auto* b = reversible_blocks.find<reversible_block_object,by_num>(head->block_num)) {
-            reversible_blocks.remove(*b);
-        }
+        reversible_blocks.remove_from(head->block_num);
 
         if(read_mode == db_read_mode::SPECULATIVE) {
             EVT_ASSERT(head->block, block_validate_exception, "attempting to pop a block that was sparsely loaded from a snapshot");
-            for(const auto& t : head->trxs) {
+            for(const auto& t : head->get_trxs()) {
                 unapplied_transactions[t->signed_id] = t;
             }
         }
@@ -183,29 +316,124 @@ struct controller_impl {
 
     controller_impl(const controller::config& cfg, controller& s)
         : self(s)
+        , token_db(make_token_db_config(cfg))
+        , token_db_cache(token_db, cfg.db_config.object_cache_size, cfg.db_config.object_cache_shards)
+        , token_db_opening(open_token_db_aside(cfg))
         , db(cfg.state_dir,
              cfg.read_only ? database::read_only : database::read_write,
              cfg.state_size)
-        , reversible_blocks(cfg.blocks_dir / config::reversible_blocks_dir_name,
-             cfg.read_only ? database::read_only : database::read_write,
-             cfg.reversible_cache_size)
-        , blog(cfg.blocks_dir)
-        , fork_db(cfg.state_dir)
-        , token_db(cfg.db_config)
-        , token_db_cache(token_db, cfg.db_config.object_cache_size)
+        , reversible_blocks(cfg.blocks_dir / config::reversible_blocks_dir_name)
+        , blog(cfg.blocks_dir, cfg.blocks_retained)
+        , trx_locations(cfg.trx_index ? std::make_unique<trx_index>(cfg.blocks_dir / config::trx_index_dir_name) : nullptr)
+        , fork_db(cfg.state_dir, cfg.fork_db_retention)
         , conf(cfg)
         , chain_id(cfg.genesis.compute_chain_id())
         , exec_ctx(s)
         , read_mode(cfg.read_mode)
-        , system_api(contracts::evt_contract_abi(), cfg.max_serialization_time) {
+        , scheduler(cfg.thread_pool_size, "chain", cfg.thread_pool_cpus) {
+
+        timeline.mark("load state, block log and fork database");
 
         fork_db.irreversible.connect([&](auto b) {
             on_irreversible(b);
         });
+
+        // memo may refer to the states being reverted
+        auth_memo_conns[0] = token_db.rollback_token_value.connect([&](auto&) {
+            auth_memo.clear();
+        });
+        auth_memo_conns[1] = token_db.remove_token_value.connect([&](auto&) {
+            auth_memo.clear();
+        });
+
+        if(cfg.state_hugepages) {
+            advise_hugepages(db);
+        }
+
+        // watches the deadlines of transactions, stopped in destructor
+        deadline_timer::start_watchdog();
+    }
+
+    // huge pages cut TLB misses of random accesses to state, kernel only backs the mapping with them
+    // if the state file is on a filesystem supporting it (ex. tmpfs mounted with huge=advise)
+    static void
+    advise_hugepages(chainbase::database& d) {
+#ifdef MADV_HUGEPAGE
+        auto sm    = d.get_segment_manager();
+        auto page  = (uintptr_t)sysconf(_SC_PAGESIZE);
+        auto begin = ((uintptr_t)sm + page - 1) & ~(page - 1);
+        auto end   = ((uintptr_t)sm + sm->get_size()) & ~(page - 1);
+        if(end <= begin || madvise((void*)begin, end - begin, MADV_HUGEPAGE) != 0) {
+            wlog("Cannot advise huge pages for chain state: ${e}", ("e", strerror(errno)));
+        }
+#else
+        wlog("Huge pages for chain state are not supported on this platform");
+#endif
+    }
+
+    // popped savepoints are synced by `commit_durable` unless every block is synced
+    static token_database::config
+    make_token_db_config(const controller::config& cfg) {
+        auto c = cfg.db_config;
+        c.group_commit = (cfg.durability != durability_mode::STRICT);
+        return c;
+    }
+
+    /**
+     *  Syncs the block log and then the WAL of token database, so the states are never durable ahead
+     *  of the blocks they're made of. Called after each irreversible block and at shutdown.
+     */
+    void
+    commit_durable(bool shutdown) {
+        if(!shutdown) {
+            uncommitted_blocks++;
+            if(conf.durability == durability_mode::RELAXED) {
+                return;
+            }
+            if(conf.durability == durability_mode::GROUP && uncommitted_blocks < conf.group_commit_blocks
+                && fc::time_point::now() - last_commit_time < fc::milliseconds(conf.group_commit_ms)) {
+                return;
+            }
+        }
+        else if(uncommitted_blocks == 0) {
+            return;
+        }
+
+        blog.sync();
+        if(conf.durability != durability_mode::STRICT) {
+            token_db.sync_wal();
+        }
+        uncommitted_blocks = 0;
+        last_commit_time   = fc::time_point::now();
+    }
+
+    // token database isn't restored from checkpoint when it exists, so it can be opened before `init`
+    std::future<void>
+    open_token_db_aside(const controller::config& cfg) {
+        if(!fc::exists(cfg.db_config.db_path)) {
+            return {};
+        }
+        return std::async(std::launch::async, [this] { token_db.open(); });
+    }
+
+    const abi_serializer&
+    get_system_api() const {
+        std::call_once(system_api_flag, [this] {
+            system_api.emplace(contracts::evt_contract_abi(), conf.max_serialization_time);
+
+            // data of the built-in actions is converted by their reflection, the abi walk is the fallback
+            evt_execution_context::visit_types([&](auto& act) {
+                system_api->add_reflected_type<typename decltype(+act)::type>();
+            });
+        });
+        return *system_api;
     }
 
     ~controller_impl() {
+        scheduler.stop();
+
         pending.reset();
+        deadline_timer::stop_watchdog();
         db.flush();
         reversible_blocks.flush();
     }
@@ -274,14 +502,16 @@ struct controller_impl {
         if(append_to_blog) {
             blog.append(s->block);
         }
-
-        const auto& ubi    = reversible_blocks.get_index<reversible_block_index, by_num>();
-        auto        objitr = ubi.begin();
-        while(objitr != ubi.end() && objitr->blocknum <= s->block_num) {
-            reversible_blocks.remove(*objitr);
-            objitr = ubi.begin();
+        // token database has synced the savepoint itself in strict mode
+        if(append_to_blog || conf.durability != durability_mode::STRICT) {
+            commit_durable(false);
+        }
+        if(trx_locations && s->block) {
+            trx_locations->add(*s->block);
         }
 
+        reversible_blocks.prune(s->block_num);
+
         // the "head" block when a snapshot is loaded is virtual and has no block data, all of its effects
         // should already have been loaded from the snapshot so, it cannot be applied
         if(s->block) {
@@ -316,13 +546,91 @@ struct controller_impl {
         ilog("existing block log, attempting to replay from ${s} to ${n} blocks",
             ("s", fmt::format("{:n}", start_block_num))("n", fmt::format("{:n}", blog_head->block_num())));
 
-        auto start = fc::time_point::now();
-        while(auto next = blog.read_block_by_num(head->block_num + 1)) {
-            replay_push_block(next, controller::block_status::irreversible);
-            if(next->block_num() % 500 == 0) {
-                ilog2_("{:n} of {:n}", next->block_num(), blog_head->block_num());
+        // replay runs as a pipeline:
+        // reader thread reads and unpacks blocks, thread pool creates the transaction metadata
+        // (and recovers the keys when all checks are forced), this thread only applies
+        struct replay_item {
+            signed_block_ptr                                          block;
+            std::shared_future<std::vector<transaction_metadata_ptr>> trxs;
+        };
+
+        auto queue       = bounded_queue<replay_item>(config::default_replay_queue_size);
+        auto recover     = conf.force_all_checks;
+        auto read_time   = fc::microseconds();
+        auto read_except = std::exception_ptr();
+        auto prepare_us  = std::make_shared<std::atomic<int64_t>>(0);  // shared, tasks may outlive an aborted replay
+
+        auto start  = fc::time_point::now();
+        auto reader = std::thread([&] {
+            try {
+                // own instance, block log keeps read state which is not thread safe
+                auto rlog = block_log(conf.blocks_dir);
+                for(auto num = start_block_num; ; num++) {
+                    auto t = fc::time_point::now();
+                    auto b = rlog.read_block_by_num(num);
+                    read_time += fc::time_point::now() - t;
+                    if(!b) {
+                        break;
+                    }
+
+                    auto task = std::make_shared<std::packaged_task<std::vector<transaction_metadata_ptr>()>>([this, b, recover, prepare_us] {
+                        auto t    = fc::time_point::now();
+                        auto trxs = make_block_trxs(b, recover);
+                        *prepare_us += (fc::time_point::now() - t).count();
+                        prefetch_block(trxs);
+                        return trxs;
+                    });
+
+                    auto item = replay_item { .block = b, .trxs = task->get_future().share() };
+                    scheduler.post([task] { (*task)(); });
+                    if(!queue.push(std::move(item))) {
+                        break;
+                    }
+                }
+            }
+            catch(...) {
+                read_except = std::current_exception();
+            }
+            queue.close();
+        });
+        auto stop_reader = fc::make_scoped_exit([&] {
+            queue.close();
+            reader.join();
+        });
+
+        auto apply_time = fc::microseconds();
+        auto wait_time  = fc::microseconds();
+        auto item       = replay_item();
+        while(true) {
+            auto t = fc::time_point::now();
+            if(!queue.pop(item)) {
+                break;
+            }
+            add_prepared_block(item.block, item.trxs.get());
+            auto t2 = fc::time_point::now();
+            wait_time += t2 - t;
+
+            replay_push_block(item.block, controller::block_status::irreversible);
+            apply_time += fc::time_point::now() - t2;
+
+            if(item.block->block_num() % 500 == 0) {
+                ilog2_("{:n} of {:n}", item.block->block_num(), blog_head->block_num());
+            }
+            if(conf.replay_stop_block > 0 && item.block->block_num() >= conf.replay_stop_block) {
+                break;
             }
         }
+        stop_reader.cancel();
+        queue.close();
+        reader.join();
+        if(read_except) {
+            std::rethrow_exception(read_except);
+        }
+
+        ilog("replay stages, read: ${r} ms, prepare: ${p} ms in thread pool, apply: ${a} ms, waited for blocks: ${w} ms",
+            ("r", read_time.count() / 1000)("p", prepare_us->load() / 1000)("a", apply_time.count() / 1000)("w", wait_time.count() / 1000));
+
+        prepared_blocks.clear();
         std::cerr << "\n";
         ilog("${n} blocks replayed", ("n", fmt::format("{:n}", head->block_num - start_block_num)));
 
@@ -331,10 +639,16 @@ struct controller_impl {
         if(self.skip_db_sessions(controller::block_status::irreversible))
             db.set_revision(head->block_num);
 
+        if(conf.replay_stop_block > 0 && head->block_num >= conf.replay_stop_block) {
+            replaying = false;
+            replay_head_time.reset();
+            EVT_THROW(node_management_success, "replay stopped at block ${n}", ("n", head->block_num));
+        }
+
         int rev = 0;
-        while(auto obj = reversible_blocks.find<reversible_block_object, by_num>(head->block_num + 1)) {
+        while(auto b = reversible_blocks.get(head->block_num + 1)) {
             ++rev;
-            replay_push_block(obj->get_block(), controller::block_status::validated);
+            replay_push_block(b, controller::block_status::validated);
         }
 
         ilog("${n} reversible blocks replayed", ("n", fmt::format("{:n}", rev)));
@@ -346,20 +660,67 @@ struct controller_impl {
             );
         replaying = false;
         replay_head_time.reset();
+        timeline.mark("replay blocks");
     }
 
 
+    // blocks in block log are indexed when the index is enabled on an existing node or it's lost
     void
-    init(const snapshot_reader_ptr& snapshot) {
-        token_db.open();
+    catch_up_trx_index() {
+        auto& lh = blog.head();
+        if(!lh) {
+            return;
+        }
+
+        auto start = std::max(trx_locations->last_num() + 1, blog.first_available_block_num());
+        if(start > lh->block_num()) {
+            return;
+        }
+
+        ilog("indexing transactions of blocks from ${s} to ${e}", ("s", fmt::format("{:n}", start))("e", fmt::format("{:n}", lh->block_num())));
+        for(auto n = start; n <= lh->block_num(); n++) {
+            auto b = blog.read_block_by_num(n);
+            EVT_ASSERT(b, block_log_exception, "Cannot read block ${n} from block log", ("n", n));
+            trx_locations->add(*b);
+        }
+        timeline.mark("index transactions");
+    }
 
-        bool report_integrity_hash = !!snapshot;
+    void
+    init(const snapshot_reader_ptr& snapshot, const std::vector<snapshot_reader_ptr>& diffs) {
+        // states are removed together(replay), restart from the latest checkpoint instead of genesis
+        auto checkpoint = optional<fc::path>();
+        if(!snapshot && !head && !fc::exists(conf.db_config.db_path)
+            && db.get_index<global_property_multi_index>().indices().empty()) {
+            checkpoint = find_checkpoint();
+            if(checkpoint) {
+                token_database::restore_checkpoint(*checkpoint / config::default_token_database_dir_name, conf.db_config.db_path);
+            }
+        }
+        if(token_db_opening.valid()) {
+            token_db_opening.get();
+        }
+        else {
+            token_db.open();
+        }
+        timeline.mark("open token database");
+
+        bool report_integrity_hash = !!snapshot || !!checkpoint;
         if(snapshot) {
             EVT_ASSERT(!head, fork_database_exception, "");
             snapshot->validate();
+            for(auto& d : diffs) {
+                d->validate();
+            }
 
-            read_from_snapshot(snapshot);
+            if(diffs.empty()) {
+                read_from_snapshot(snapshot);
+            }
+            else {
+                read_from_diff_snapshots(snapshot, diffs);
+            }
             initialize_execution_context();  // new actions maybe add
+            timeline.mark("read snapshot");
 
             auto end = blog.read_head();
             if(!end) {
@@ -373,12 +734,24 @@ struct controller_impl {
                            "Block log is provided with snapshot but does not contain the head block from the snapshot");
             }
         }
+        else if(checkpoint) {
+            read_from_checkpoint(*checkpoint);
+            initialize_execution_context();
+            timeline.mark("read checkpoint");
+
+            // checkpoint is only chosen when its block is in block log
+            auto end = blog.read_head();
+            if(end->block_num() > head->block_num) {
+                replay();
+            }
+        }
         else {
             if(!head) {
                 initialize_fork_db();  // set head to genesis state
                 initialize_token_db();
             }
             initialize_execution_context();
+            timeline.mark("initialize states");
 
             auto end = blog.read_head();
             if(!end) {
@@ -390,12 +763,17 @@ struct controller_impl {
             }
         }
 
-        const auto& ubi    = reversible_blocks.get_index<reversible_block_index, by_num>();
-        auto        objitr = ubi.rbegin();
-        if(objitr != ubi.rend()) {
-            EVT_ASSERT(objitr->blocknum == head->block_num, fork_database_exception,
+        // pruned blocks are only dropped from the index, they're back after restarting
+        if(auto& lib = blog.head()) {
+            reversible_blocks.prune(lib->block_num());
+        }
+        if(reversible_blocks.recovered_bytes() > 0) {
+            wlog("${n} bytes of an incomplete reversible block were dropped", ("n", reversible_blocks.recovered_bytes()));
+        }
+        if(auto last = reversible_blocks.last_num()) {
+            EVT_ASSERT(*last == head->block_num, fork_database_exception,
                        "reversible block database is inconsistent with fork database, replay blockchain",
-                       ("head", head->block_num)("unconfimed", objitr->blocknum));
+                       ("head", head->block_num)("unconfimed", *last));
         }
         else {
             auto end = blog.read_head();
@@ -404,6 +782,10 @@ struct controller_impl {
                        ("blog_head", end->block_num())("head", head->block_num));
         }
 
+        if(trx_locations) {
+            catch_up_trx_index();
+        }
+
         EVT_ASSERT(db.revision() >= head->block_num, fork_database_exception, "fork database is inconsistent with shared memory",
                    ("db", db.revision())("head", head->block_num));
 
@@ -429,17 +811,20 @@ struct controller_impl {
 
         // add workaround to evt & pevt in evt-3.3.2
         update_evt_org(token_db, conf.genesis);
+
+        last_checkpoint_block = head->block_num;
+
+        timeline.mark("check consistency");
+        timeline.print();
     }
 
     void
     add_indices() {
-        reversible_blocks.add_index<reversible_block_index>(); 
-
         controller_index_set::add_indices(db);
     }
 
     void
-    add_to_snapshot(const snapshot_writer_ptr& snapshot) const {
+    add_header_to_snapshot(const snapshot_writer_ptr& snapshot) const {
         snapshot->write_section<chain_snapshot_header>([this](auto& section) {
             section.add_row(chain_snapshot_header(), db);
         });
@@ -451,22 +836,41 @@ struct controller_impl {
         snapshot->write_section<block_state>([this](auto& section) {
             section.template add_row<block_header_state>(*fork_db.head(), db);
         });
+    }
 
-        controller_index_set::walk_indices([this, &snapshot](auto utils) {
-            using value_t = typename decltype(utils)::index_t::value_type;
-
-            snapshot->write_section<value_t>([this](auto& section) {
-                decltype(utils)::walk(db, [this, &section](const auto& row) {
-                    section.add_row(row, db);
-                });
+    template <typename Utils>
+    void
+    add_index_to_snapshot(const snapshot_writer_ptr& snapshot, Utils) const {
+        using value_t = typename Utils::index_t::value_type;
+
+        snapshot->write_section<value_t>([this](auto& section) {
+            Utils::walk(db, [this, &section](const auto& row) {
+                if constexpr(std::is_same_v<value_t, transaction_object>) {
+                    // expired ones may be left by bounded cleanup, they're skipped so that
+                    // snapshots and integrity hashes don't depend on how far cleanup goes
+                    if(self.head_block_time() > fc::time_point(row.expiration)) {
+                        return;
+                    }
+                }
+                section.add_row(row, db);
             });
         });
+    }
 
-        token_database_snapshot::add_to_snapshot(snapshot, token_db);
+    void
+    add_to_snapshot(const snapshot_writer_ptr& snapshot, bool with_token_db = true) const {
+        add_header_to_snapshot(snapshot);
+        controller_index_set::walk_indices([this, &snapshot](auto utils) {
+            add_index_to_snapshot(snapshot, utils);
+        });
+
+        if(with_token_db) {
+            token_database_snapshot::add_to_snapshot(snapshot, token_db);
+        }
     }
 
     void
-    read_from_snapshot(const snapshot_reader_ptr& snapshot) {
+    read_from_snapshot(const snapshot_reader_ptr& snapshot, bool with_token_db = true) {
         snapshot->read_section<chain_snapshot_header>([this](auto& section) {
             chain_snapshot_header header;
             section.read_row(header, db);
@@ -477,7 +881,7 @@ struct controller_impl {
             block_header_state head_header_state;
             section.read_row(head_header_state, db);
 
-            auto head_state = std::make_shared<block_state>(head_header_state);
+            auto head_state = make_block_state(head_header_state);
             fork_db.set(head_state);
             fork_db.set_validity(head_state, true);
             fork_db.mark_in_current_chain(head_state, true);
@@ -499,17 +903,278 @@ struct controller_impl {
             });
         });
 
-        token_database_snapshot::read_from_snapshot(snapshot, token_db);
+        if(with_token_db) {
+            token_database_snapshot::read_from_snapshot(snapshot, token_db);
+        }
         db.set_revision(head->block_num);
     }
 
+    static block_header_state
+    read_snapshot_head(const snapshot_reader_ptr& snapshot) {
+        auto head_state = block_header_state();
+        snapshot->read_section<block_state>([&head_state](auto& section) {
+            section.read_row(head_state);
+        });
+        return head_state;
+    }
+
+    /**
+     *  Checks the snapshots are a full one followed by the diffs taken after it in order
+     */
+    static void
+    validate_snapshot_chain(const std::vector<snapshot_reader_ptr>& snapshots) {
+        EVT_ASSERT(!snapshots.empty(), snapshot_validation_exception, "Base snapshot is not provided");
+
+        auto prev = block_header_state();
+        for(auto i = 0u; i < snapshots.size(); i++) {
+            auto& s = snapshots[i];
+            if(i == 0) {
+                EVT_ASSERT(!s->has_section<chain_snapshot_diff_header>(), snapshot_validation_exception,
+                           "Base snapshot should be a full one");
+            }
+            else {
+                EVT_ASSERT(s->has_section<chain_snapshot_diff_header>(), snapshot_validation_exception,
+                           "Snapshot #${i} after the base one should be a differential one", ("i", i));
+
+                auto header = chain_snapshot_diff_header();
+                s->read_section<chain_snapshot_diff_header>([&header](auto& section) {
+                    section.read_row(header);
+                });
+                EVT_ASSERT(header.base_block_id == prev.id, snapshot_validation_exception,
+                           "Differential snapshot #${i} is based on block ${b} but the snapshot before it is at block ${p}",
+                           ("i", i)("b", header.base_block_id)("p", prev.id));
+            }
+            prev = read_snapshot_head(s);
+        }
+    }
+
+    void
+    add_diff_to_snapshot(const snapshot_writer_ptr& snapshot, const std::vector<snapshot_reader_ptr>& bases) const {
+        validate_snapshot_chain(bases);
+
+        auto base = read_snapshot_head(bases.back());
+        EVT_ASSERT(base.block_num <= head->block_num, snapshot_exception,
+                   "Base snapshot at block ${b} is ahead of head block ${h}", ("b", base.block_num)("h", head->block_num));
+
+        add_header_to_snapshot(snapshot);
+        snapshot->write_section<chain_snapshot_diff_header>([this, &base](auto& section) {
+            section.add_row(chain_snapshot_diff_header{ base.id, base.block_num }, db);
+        });
+        controller_index_set::walk_indices([this, &snapshot](auto utils) {
+            add_index_to_snapshot(snapshot, utils);
+        });
+        token_database_snapshot::add_diff_to_snapshot(snapshot, token_db, bases);
+    }
+
+    /**
+     *  Token database is restored from the base and then the changes of each diff are put onto it,
+     *  chain state is taken from the last diff as its sections are whole
+     */
+    void
+    read_from_diff_snapshots(const snapshot_reader_ptr& snapshot, const std::vector<snapshot_reader_ptr>& diffs) {
+        auto snapshots = std::vector<snapshot_reader_ptr>{ snapshot };
+        snapshots.insert(snapshots.end(), diffs.begin(), diffs.end());
+        validate_snapshot_chain(snapshots);
+
+        token_database_snapshot::read_from_snapshot(snapshot, token_db);
+        for(auto& d : diffs) {
+            token_database_snapshot::read_diff_from_snapshot(d, token_db);
+        }
+        read_from_snapshot(diffs.back(), false /* with_token_db */);
+    }
+
+    /**
+     *  Lists the completed checkpoints ordered by their block numbers
+     */
+    std::vector<std::pair<uint32_t, fc::path>>
+    list_checkpoints() const {
+        auto checkpoints = std::vector<std::pair<uint32_t, fc::path>>();
+        if(!fc::is_directory(conf.checkpoints_dir)) {
+            return checkpoints;
+        }
+
+        for(auto it = fc::directory_iterator(conf.checkpoints_dir); it != fc::directory_iterator(); ++it) {
+            auto name = (*it).filename().generic_string();
+            // unfinished ones have the '.tmp' suffix
+            if(name.empty() || !std::all_of(name.cbegin(), name.cend(), [](auto c) { return std::isdigit(c); })) {
+                continue;
+            }
+            checkpoints.emplace_back((uint32_t)std::stoul(name), *it);
+        }
+        std::sort(checkpoints.begin(), checkpoints.end());
+        return checkpoints;
+    }
+
+    /**
+     *  Finds the latest checkpoint whose block is already irreversible in block log.
+     *  Checkpoints ahead of block log or on other forks are ignored.
+     */
+    optional<fc::path>
+    find_checkpoint() {
+        if(conf.db_config.profile == storage_profile::ram) {
+            return optional<fc::path>();
+        }
+
+        auto end = blog.read_head();
+        if(!end) {
+            return optional<fc::path>();
+        }
+
+        auto checkpoints = list_checkpoints();
+        for(auto it = checkpoints.crbegin(); it != checkpoints.crend(); it++) {
+            auto& [num, dir] = *it;
+            if(num > end->block_num()) {
+                continue;
+            }
+
+            try {
+                auto info = checkpoint_info();
+                auto fs   = std::ifstream((dir / config::checkpoint_info_filename).generic_string(), (std::ios::in | std::ios::binary));
+                fs.exceptions(std::fstream::failbit | std::fstream::badbit);
+                fc::raw::unpack(fs, info);
+
+                auto b = blog.read_block_by_num(info.block_num);
+                if(info.block_num == num && b && b->id() == info.block_id) {
+                    ilog("Found checkpoint at block ${n} in '${d}'", ("n", fmt::format("{:n}", num))("d", dir.generic_string()));
+                    return dir;
+                }
+                wlog("Checkpoint at block ${n} doesn't match block log, skip it", ("n", fmt::format("{:n}", num)));
+            }
+            catch(const std::exception& e) {
+                wlog("Cannot read checkpoint in '${d}': ${e}", ("d", dir.generic_string())("e", e.what()));
+            }
+        }
+        return optional<fc::path>();
+    }
+
+    /**
+     *  Loads chain states from the checkpoint, token database is restored before it's opened
+     */
+    void
+    read_from_checkpoint(const fc::path& dir) {
+        ilog("Starting initialization from checkpoint in '${d}'", ("d", dir.generic_string()));
+
+        auto infile = std::ifstream((dir / config::checkpoint_state_filename).generic_string(), (std::ios::in | std::ios::binary));
+        auto reader = std::make_shared<istream_snapshot_reader>(infile);
+        reader->validate();
+        read_from_snapshot(reader, false);
+        infile.close();
+
+        // blocks till checkpoint are irreversible, merge their savepoints into database
+        token_db.pop_savepoints(head->block_num + 1);
+        EVT_ASSERT(token_db.savepoints_size() == 0, token_database_exception,
+            "token database is inconsistent with checkpoint, latest savepoint: ${seq}, checkpoint: ${n}",
+            ("seq",token_db.latest_savepoint_seq())("n",head->block_num));
+    }
+
+    /**
+     *  Writes states at head block into a new checkpoint every `checkpoint_interval` blocks.
+     *  Token database is linked by rocksdb and chain states are written as a snapshot without token sections.
+     */
+    void
+    maybe_write_checkpoint() {
+        if(conf.checkpoint_interval == 0 || conf.db_config.profile == storage_profile::ram) {
+            return;
+        }
+        if(head->block_num / conf.checkpoint_interval <= last_checkpoint_block / conf.checkpoint_interval) {
+            return;
+        }
+        // snapshot takes fork database head, skip when states are not at it(irreversible mode)
+        if(pending.has_value() || fork_db.head() != head) {
+            return;
+        }
+        last_checkpoint_block = head->block_num;
+
+        try {
+            write_checkpoint();
+        }
+        catch(const fc::exception& e) {
+            // checkpoints only speed up restarts, don't let them break the chain
+            elog("Failed to write checkpoint at block ${n}: ${e}", ("n", head->block_num)("e", e.to_detail_string()));
+        }
+        catch(const std::exception& e) {
+            elog("Failed to write checkpoint at block ${n}: ${e}", ("n", head->block_num)("e", e.what()));
+        }
+    }
+
+    void
+    write_checkpoint() {
+        auto start = fc::time_point::now();
+        auto name  = fmt::format("{:010d}", head->block_num);
+        auto dir   = conf.checkpoints_dir / name;
+        auto tmp   = conf.checkpoints_dir / (name + ".tmp");
+        if(fc::exists(dir)) {
+            return;
+        }
+        if(fc::exists(tmp)) {
+            fc::remove_all(tmp);
+        }
+        fc::create_directories(tmp);
+
+        token_db.create_checkpoint(tmp / config::default_token_database_dir_name);
+
+        auto state_out = std::ofstream((tmp / config::checkpoint_state_filename).generic_string(), (std::ios::out | std::ios::binary));
+        auto writer    = std::make_shared<ostream_snapshot_writer>(state_out);
+        add_to_snapshot(writer, false);
+        writer->finalize();
+        state_out.flush();
+        state_out.close();
+
+        auto info = checkpoint_info {
+            .block_num = head->block_num,
+            .block_id  = head->id
+        };
+        auto info_out = std::ofstream((tmp / config::checkpoint_info_filename).generic_string(), (std::ios::out | std::ios::binary));
+        fc::raw::pack(info_out, info);
+        info_out.flush();
+        info_out.close();
+
+        // checkpoint is visible only after it's completed
+        fc::rename(tmp, dir);
+
+        auto checkpoints = list_checkpoints();
+        auto keep        = std::max(conf.checkpoints_to_keep, 1u);
+        for(auto i = 0u; i + keep < checkpoints.size(); i++) {
+            fc::remove_all(checkpoints[i].second);
+        }
+
+        ilog("Checkpoint at block ${n} is written in ${t} ms",
+            ("n", fmt::format("{:n}", head->block_num))("t", (fc::time_point::now() - start).count() / 1000));
+    }
+
     sha256
     calculate_integrity_hash() const {
-        auto enc = sha256::encoder();
-        auto hash_writer = std::make_shared<integrity_hash_snapshot_writer>(enc);
-        add_to_snapshot(hash_writer);
-        hash_writer->finalize();
+        // groups of sections are hashed concurrently, states are only read here
+        // the result is the hash of all the group hashes in order
+        auto hash_sections = [](auto f) {
+            return std::async(std::launch::async, [f] {
+                auto enc         = sha256::encoder();
+                auto hash_writer = std::make_shared<integrity_hash_snapshot_writer>(enc);
+                f(hash_writer);
+                hash_writer->finalize();
+
+                return enc.result();
+            });
+        };
 
+        auto hashes = std::vector<std::future<sha256>>();
+        hashes.emplace_back(hash_sections([this](const snapshot_writer_ptr& w) {
+            add_header_to_snapshot(w);
+        }));
+        controller_index_set::walk_indices([&](auto utils) {
+            hashes.emplace_back(hash_sections([this, utils](const snapshot_writer_ptr& w) {
+                add_index_to_snapshot(w, utils);
+            }));
+        });
+        // token database keeps its own partitioned roots and only rehashes the changed ones
+        hashes.emplace_back(std::async(std::launch::async, [this] {
+            return token_db.calculate_integrity_hash();
+        }));
+
+        auto enc = sha256::encoder();
+        for(auto& h : hashes) {
+            fc::raw::pack(enc, h.get());
+        }
         return enc.result();
     }
 
@@ -519,6 +1184,19 @@ struct controller_impl {
     void
     initialize_fork_db() {
         wlog(" Initializing new blockchain with genesis state");
+        auto genheader = genesis_header_state();
+
+        head        = make_block_state(genheader);
+        head->block = make_signed_block(genheader.header);
+
+        fork_db.set(head);
+        db.set_revision(head->block_num);
+
+        initialize_database();
+    }
+
+    block_header_state
+    genesis_header_state() const {
         producer_schedule_type initial_schedule{0, {{config::system_account_name, conf.genesis.initial_key}}};
 
         block_header_state genheader;
@@ -530,14 +1208,76 @@ struct controller_impl {
         genheader.id                    = genheader.header.id();
         genheader.block_num             = genheader.header.block_num();
         genheader.block_signing_key     = conf.genesis.initial_key;
-        
-        head        = std::make_shared<block_state>(genheader);
-        head->block = std::make_shared<signed_block>(genheader.header);
+        return genheader;
+    }
 
-        fork_db.set(head);
-        db.set_revision(head->block_num);
+    optional<block_header_state>
+    block_log_head_state(const optional<block_header_state>& snapshot_head) {
+        auto log_head = blog.read_head();
+        auto log_num  = log_head ? log_head->block_num() : blog.first_block_num() - 1;
 
-        initialize_database();
+        // reversible blocks are replayed after the block log, they may not link to the appended blocks
+        if(auto last = reversible_blocks.last_num(); last.has_value() && *last > log_num) {
+            return optional<block_header_state>();
+        }
+
+        auto fork_head = fork_db.head();
+        auto state     = snapshot_head.has_value() ? *snapshot_head
+                       : fork_head                 ? block_header_state(*fork_head)
+                                                   : genesis_header_state();
+        if(!log_head) {
+            // an empty log starts after the state, see `append_block_log`
+            if(state.block_num < log_num) {
+                return optional<block_header_state>();
+            }
+            return state;
+        }
+        if(state.block_num > log_num || state.block_num + 1 < blog.first_available_block_num()) {
+            return optional<block_header_state>();
+        }
+
+        // blocks in the log after the state are trusted, only their headers are gone through
+        if(state.block_num < log_num) {
+            ilog("going through headers of blocks ${s} to ${n} in block log", ("s", state.block_num + 1)("n", log_num));
+        }
+        for(auto num = state.block_num + 1; num <= log_num; num++) {
+            auto b = blog.read_block_by_num(num);
+            EVT_ASSERT(b, block_log_exception, "block ${n} is missing in block log", ("n", num));
+            state = state.next(*b, true /* skip_validate_signee */);
+        }
+        EVT_ASSERT(state.id == log_head->id(), block_log_exception, "block log head doesn't match the chain state");
+        return state;
+    }
+
+    void
+    append_block_log(const std::vector<signed_block_ptr>& blocks) {
+        if(blocks.empty()) {
+            return;
+        }
+
+        auto& first = blocks.front();
+        if(!blog.read_head() && first->block_num() != blog.first_block_num()) {
+            // a new chain starts with its genesis block, a chain from a snapshot after its head
+            if(first->block_num() == 2 && !fork_db.head()) {
+                blog.reset(conf.genesis, make_signed_block(genesis_header_state().header));
+            }
+            else {
+                blog.reset(conf.genesis, signed_block_ptr(), first->block_num());
+            }
+        }
+
+        for(auto& b : blocks) {
+            if(auto& lh = blog.head()) {
+                EVT_ASSERT(b->previous == lh->id(), unlinkable_block_exception, "block doesn't link to block log head",
+                           ("block_num", b->block_num())("head", lh->block_num()));
+            }
+            else {
+                EVT_ASSERT(b->block_num() == blog.first_block_num(), block_log_exception, "block log is appending the wrong first block",
+                           ("expected", blog.first_block_num())("actual", b->block_num()));
+            }
+            blog.append(b);
+        }
+        blog.flush();
     }
 
     void
@@ -567,6 +1307,12 @@ struct controller_impl {
     void
     initialize_token_db() {
         initialize_evt_org(token_db, conf.genesis);
+
+        if(!conf.genesis_initial_state.empty() || genesis_initial_state::declared_digest(conf.genesis).has_value()) {
+            EVT_ASSERT(!conf.genesis_initial_state.empty(), genesis_initial_state_exception,
+                       "Genesis state declares an initial state, its file is required to start a fresh chain");
+            genesis_initial_state::load(conf.genesis_initial_state, conf.genesis, token_db);
+        }
     }
 
     /**
@@ -588,13 +1334,13 @@ struct controller_impl {
             }
 
             if(!replaying) {
-                reversible_blocks.create<reversible_block_object>([&](auto& ubo) {
-                    ubo.blocknum = pending->_pending_block_state->block_num;
-                    ubo.set_block(pending->_pending_block_state->block);
-                });
+                reversible_blocks.add(pending->_pending_block_state->block);
             }
 
             emit(self.accepted_block, pending->_pending_block_state);
+
+            // signals have consumed the metadata, it's rebuilt from the block if it's popped later
+            pending->_pending_block_state->release_trxs();
         }
         catch (...) {
             // dont bother resetting pending, instead abort the block
@@ -651,9 +1397,8 @@ struct controller_impl {
 
         auto checker = authority_checker(self, exec_ctx, signed_keys, conf.max_authority_depth);
         for(const auto& act : trx.actions) {
-            EVT_ASSERT(checker.satisfied(act), unsatisfied_authorization,
-                       "${name} action in domain: ${domain} with key: ${key} authorized failed",
-                       ("domain", act.domain)("key", act.key)("name", act.name));
+            EVT_ASSERT2(checker.satisfied(act), unsatisfied_authorization,
+                        "{} action in domain: {} with key: {} authorized failed", act.name, act.domain, act.key);
         }
     }
 
@@ -662,9 +1407,8 @@ struct controller_impl {
         auto& conf = db.get<global_property_object>().configuration;
 
         auto checker = authority_checker(self, exec_ctx, signed_keys, conf.max_authority_depth);
-        EVT_ASSERT(checker.satisfied(act), unsatisfied_authorization,
-                   "${name} action in domain: ${domain} with key: ${key} authorized failed",
-                   ("domain", act.domain)("key", act.key)("name", act.name));
+        EVT_ASSERT2(checker.satisfied(act), unsatisfied_authorization,
+                    "{} action in domain: {} with key: {} authorized failed", act.name, act.domain, act.key);
     }
 
     transaction_trace_ptr
@@ -696,6 +1440,7 @@ struct controller_impl {
                 emit(self.applied_transaction, trace);
 
                 trx_context.squash();
+                emit_token_changes(trx->id);
                 restore.cancel();
                 return trace;
             }
@@ -732,6 +1477,7 @@ struct controller_impl {
     transaction_trace_ptr
     push_transaction(const transaction_metadata_ptr& trx,
                      fc::time_point                  deadline) {
+        FC_TRACE_SPAN("chain", "push_transaction");
         EVT_ASSERT(deadline != fc::time_point(), transaction_exception, "deadline cannot be uninitialized");
 
         transaction_trace_ptr trace;
@@ -751,6 +1497,13 @@ struct controller_impl {
                     trx_context.init_for_input_trx(skip_recording);
                 }
 
+                if(!trx->implicit) {
+                    // compression types later than zlib are only accepted once they're voted in
+                    auto comp = (int)(packed_transaction::compression_type)trx->packed_trx->get_compression();
+                    EVT_ASSERT(comp <= self.get_max_trx_compression(), unknown_transaction_compression,
+                        "Compression of transaction: ${c} is not activated", ("c",comp));
+                }
+
                 if(!self.skip_auth_check() && !trx->implicit) {
                     const auto& keys = trx->recover_keys(chain_id);
                     check_authorization(keys, trn);
@@ -790,11 +1543,13 @@ struct controller_impl {
                 else {
                     restore.cancel();
                     trx_context.squash();
+                    emit_token_changes(trx->id);
                 }
 
                 if(!trx->implicit) {
                     unapplied_transactions.erase(trx->signed_id);
                 }
+                action_costs.record(*trace, exec_ctx);
                 return trace;
             }
             catch(const fc::exception& e) {
@@ -813,6 +1568,33 @@ struct controller_impl {
         FC_CAPTURE_AND_RETHROW((trace))
     }  /// push_transaction
 
+    /**
+     *  Pushes a batch of input transactions sharing a single deadline. Signing keys of the whole
+     *  batch are recovered in the thread pool up front so that recovery overlaps with execution.
+     *  Stops once the deadline is exceeded, traces are returned only for the pushed transactions.
+     */
+    std::vector<transaction_trace_ptr>
+    push_transactions(const std::vector<transaction_metadata_ptr>& trxs,
+                      fc::time_point                               deadline) {
+        EVT_ASSERT(deadline != fc::time_point(), transaction_exception, "deadline cannot be uninitialized");
+
+        if(!self.skip_auth_check()) {
+            for(auto& trx : trxs) {
+                transaction_metadata::create_signing_keys_future(trx, scheduler, chain_id);
+            }
+        }
+
+        auto traces = std::vector<transaction_trace_ptr>();
+        traces.reserve(trxs.size());
+        for(auto& trx : trxs) {
+            if(fc::time_point::now() > deadline) {
+                break;
+            }
+            traces.emplace_back(push_transaction(trx, deadline));
+        }
+        return traces;
+    }
+
     void
     start_block(block_timestamp_type when, uint16_t confirm_block_count, controller::block_status s, const optional<block_id_type>& producer_block_id) {
         EVT_ASSERT(!pending.has_value(), block_validate_exception, "pending block already exists");
@@ -821,6 +1603,9 @@ struct controller_impl {
             pending.reset();
         });
 
+        // authority memo only lives within one block
+        auth_memo.clear();
+
         if(!self.skip_db_sessions(s)) {
             EVT_ASSERT(db.revision() == head->block_num, database_exception, "db revision is not on par with head block",
                 ("db.revision()", db.revision())("controller_head_block", head->block_num)("fork_db_head_block", fork_db.head()->block_num) );
@@ -833,7 +1618,7 @@ struct controller_impl {
 
         pending->_block_status                          = s;
         pending->_producer_block_id                     = producer_block_id;
-        pending->_pending_block_state                   = std::make_shared<block_state>(*head, when);  // promotes pending schedule (if any) to active
+        pending->_pending_block_state                   = make_block_state(*head, when);  // promotes pending schedule (if any) to active
         pending->_pending_block_state->in_current_chain = true;
 
         pending->_pending_block_state->set_confirmed(confirm_block_count);
@@ -845,7 +1630,7 @@ struct controller_impl {
             const auto& gpo = db.get<global_property_object>();
             if(gpo.proposed_schedule_block_num.has_value() &&                                                      // if there is a proposed schedule that was proposed in a block ...
                (*gpo.proposed_schedule_block_num <= pending->_pending_block_state->dpos_irreversible_blocknum) &&  // ... that has now become irreversible ...
-               pending->_pending_block_state->pending_schedule.producers.size() == 0 &&                            // ... and there is room for a new pending schedule ...
+               pending->_pending_block_state->pending_schedule->producers.size() == 0 &&                            // ... and there is room for a new pending schedule ...
                !was_pending_promoted                                                                               // ... and not just because it was promoted to active at the start of this block, then:
             ) {
                 // Promote proposed schedule to pending schedule.
@@ -863,7 +1648,7 @@ struct controller_impl {
                 });
             }
 
-            clear_expired_input_transactions();
+            clear_expired_input_transactions(conf.expired_trxs_cleanup);
         }
         guard_pending.cancel();
     }  // start_block
@@ -876,21 +1661,236 @@ struct controller_impl {
         static_cast<signed_block_header&>(*p->block) = p->header;
     }  /// sign_block
 
+    /**
+     *  Creates the metadata of input transactions in block `b` and starts recovering their
+     *  keys in thread pool, so that all the signatures of one block are recovered in parallel.
+     *  The result is picked up by `apply_block` later.
+     */
+    void
+    prepare_block(const signed_block_ptr& b) {
+        for(auto& pb : prepared_blocks) {
+            if(pb.first == b) {
+                return;
+            }
+        }
+        auto trxs = make_block_trxs(b, true /* recover */);
+        prefetch_block(trxs);
+        add_prepared_block(b, std::move(trxs));
+    }
+
+    /**
+     *  Loads the token and asset keys implied by the actions of the transactions into the block cache
+     *  of token database in thread pool, so the execution of them rarely waits for the disk.
+     *  Only the keys declared by `domain` and `key` of the actions, the fungible payloads and the
+     *  balances of payers are known up front, the others are left to the execution.
+     */
+    void
+    prefetch_block(const std::vector<transaction_metadata_ptr>& trxs) {
+        if(trxs.empty() || !conf.db_config.prefetch || conf.db_config.profile != storage_profile::disk) {
+            return;
+        }
+        scheduler.post([this, trxs] {
+            token_db.prefetch(collect_prefetch_keys(trxs));
+        }, utilities::task_scheduler::lane::background);
+    }
+
+    static token_database::prefetch_keys
+    collect_prefetch_keys(const std::vector<transaction_metadata_ptr>& trxs) {
+        using namespace contracts;
+
+        auto keys = token_database::prefetch_keys();
+        auto add_ft = [&](const address& addr, const symbol& sym) {
+            keys.assets.emplace_back(addr, sym.id());
+            keys.tokens.emplace_back(token_type::fungible, std::nullopt, name128(sym.id()));
+        };
+
+        for(auto& mtrx : trxs) {
+            auto& trx = mtrx->packed_trx->get_transaction();
+            keys.assets.emplace_back(trx.payer, PEVT_SYM_ID);
+            keys.assets.emplace_back(trx.payer, EVT_SYM_ID);
+
+            for(auto& act : trx.actions) {
+                if(!act.domain.reserved()) {
+                    keys.tokens.emplace_back(token_type::domain, std::nullopt, act.domain);
+                    if(!act.key.reserved()) {
+                        keys.tokens.emplace_back(token_type::token, act.domain, act.key);
+                    }
+                    continue;
+                }
+                if(act.domain != N128(.fungible)) {
+                    continue;
+                }
+
+                // malformed payloads are left to the execution to be rejected
+                try {
+                    switch(act.name.value) {
+                    case N(transferft): {
+                        auto& tfact = act.data_as<const transferft&>();
+                        add_ft(tfact.from, tfact.number.sym);
+                        add_ft(tfact.to, tfact.number.sym);
+                        break;
+                    }
+                    case N(issuefungible): {
+                        auto& ifact = act.data_as<const issuefungible&>();
+                        add_ft(ifact.address, ifact.number.sym);
+                        break;
+                    }
+                    case N(recycleft): {
+                        auto& rfact = act.data_as<const recycleft&>();
+                        add_ft(rfact.address, rfact.number.sym);
+                        break;
+                    }
+                    case N(destroyft): {
+                        auto& dfact = act.data_as<const destroyft&>();
+                        add_ft(dfact.address, dfact.number.sym);
+                        break;
+                    }
+                    default: {
+                        break;
+                    }
+                    }  // switch
+                }
+                catch(const fc::exception&) {}
+            }
+        }
+        return keys;
+    }
+
+    void
+    add_prepared_block(const signed_block_ptr& b, std::vector<transaction_metadata_ptr>&& trxs) {
+        // keep current and next block at most
+        if(prepared_blocks.size() >= 2) {
+            prepared_blocks.pop_front();
+        }
+        prepared_blocks.emplace_back(b, std::move(trxs));
+    }
+
+    // safe to be called from other threads, only touches `b`, `chain_id` and the thread pool
+    std::vector<transaction_metadata_ptr>
+    make_block_trxs(const signed_block_ptr& b, bool recover) {
+        auto trxs = std::vector<transaction_metadata_ptr>();
+        trxs.reserve(b->transactions.size());
+        for(const auto& receipt : b->transactions) {
+            if(receipt.type != transaction_receipt::input) {
+                continue;
+            }
+            auto mtrx = make_transaction_metadata(receipt.trx);
+            if(recover) {
+                transaction_metadata::create_signing_keys_future(mtrx, scheduler, chain_id);
+            }
+            trxs.emplace_back(std::move(mtrx));
+        }
+        return trxs;
+    }
+
+    std::vector<transaction_metadata_ptr>
+    take_prepared_trxs(const signed_block_ptr& b) {
+        for(auto it = prepared_blocks.begin(); it != prepared_blocks.end(); it++) {
+            if(it->first == b) {
+                auto trxs = std::move(it->second);
+                prepared_blocks.erase(it);
+                return trxs;
+            }
+        }
+        return {};
+    }
+
+    void
+    add_verified_block(const block_state_ptr& bsp) {
+        // blocks are pushed right after they are verified, a few of them are kept at most
+        if(verified_blocks.size() >= 4) {
+            verified_blocks.pop_front();
+        }
+        verified_blocks.emplace_back(bsp);
+    }
+
+    block_state_ptr
+    take_verified_block(const signed_block_ptr& b) {
+        for(auto it = verified_blocks.begin(); it != verified_blocks.end(); it++) {
+            if((*it)->block == b) {
+                auto bsp = std::move(*it);
+                verified_blocks.erase(it);
+                return bsp;
+            }
+        }
+        return nullptr;
+    }
+
+    /**
+     *  Speculative pending block is the beginning of `b` when it's built on the same head with the
+     *  same header fields seen by the transactions, and its receipts are the first ones of `b` in
+     *  the same order. Its effects on both databases are then kept instead of executing them again.
+     */
+    bool
+    pending_is_prefix_of(const signed_block_ptr& b) const {
+        if(!pending.has_value() || read_mode != db_read_mode::SPECULATIVE
+           || pending->_block_status != controller::block_status::incomplete || pending->_finalized) {
+            return false;
+        }
+
+        auto& pbs = *pending->_pending_block_state;
+        if(b->previous != head->id || b->timestamp != pbs.header.timestamp
+           || b->producer != pbs.header.producer || b->confirmed != pbs.header.confirmed) {
+            return false;
+        }
+
+        auto& receipts = pbs.block->transactions;
+        if(receipts.size() > b->transactions.size()) {
+            return false;
+        }
+        for(auto i = 0u; i < receipts.size(); i++) {
+            if(receipts[i].digest() != b->transactions[i].digest()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
     void
     apply_block(const signed_block_ptr& b, controller::block_status s) {
+        FC_TRACE_SPAN("chain", "apply_block");
+        auto reused = 0u;
         try {
             try {
                 EVT_ASSERT(b->block_extensions.size() == 0, block_validate_exception, "no supported extensions");
                 auto producer_block_id = b->id();
-                start_block(b->timestamp, b->confirmed, s, producer_block_id);
+                if(pending_is_prefix_of(b)) {
+                    reused = pending->_pending_block_state->block->transactions.size();
+                    pending->_block_status      = s;
+                    pending->_producer_block_id = producer_block_id;
+                }
+                else {
+                    abort_block();
+                    start_block(b->timestamp, b->confirmed, s, producer_block_id);
+                }
+
+                if(!self.skip_auth_check()) {
+                    prepare_block(b);
+                }
+                auto trxs = take_prepared_trxs(b);
+                auto ti   = 0u;
 
                 auto num_pending_receipts = pending->_pending_block_state->block->transactions.size();
-                for(const auto& receipt : b->transactions) {
+                for(auto ri = 0u; ri < b->transactions.size(); ri++) {
+                    auto& receipt = b->transactions[ri];
+                    if(ri < reused) {
+                        // executed already in the pending block
+                        if(receipt.type == transaction_receipt::input) {
+                            ti++;
+                        }
+                        continue;
+                    }
+
                     auto trace = transaction_trace_ptr();
                     if(receipt.type == transaction_receipt::input) {
-                        auto& pt    = receipt.trx;
-                        auto  mtrx  = std::make_shared<transaction_metadata>(std::make_shared<packed_transaction>(pt));
-                        
+                        auto mtrx = transaction_metadata_ptr();
+                        if(ti < trxs.size()) {
+                            mtrx = trxs[ti++];
+                        }
+                        else {
+                            mtrx = make_transaction_metadata(receipt.trx);
+                        }
+
                         trace = push_transaction(mtrx, fc::time_point::maximum());
                     }
                     else if(receipt.type == transaction_receipt::suspend) {
@@ -946,8 +1946,15 @@ struct controller_impl {
                 return;
             }
             catch(const fc::exception& e) {
-                edump((e.to_detail_string()));
                 abort_block();
+                if(reused > 0) {
+                    // execute the whole block in case the pending one differs in a way not detected
+                    wlog("failed to apply block ${id} on top of ${n} speculative transactions, apply it from scratch: ${e}",
+                         ("id", b->id())("n", reused)("e", e.to_string()));
+                    apply_block(b, s);
+                    return;
+                }
+                edump((e.to_detail_string()));
                 throw;
             }
         }
@@ -957,7 +1964,11 @@ struct controller_impl {
     void
     push_block(const signed_block_ptr& b) {
         auto s = controller::block_status::complete;
-        EVT_ASSERT(!pending.has_value(), block_validate_exception, "it is not valid to push a block when there is a pending block");
+
+        // pending block is only kept when it's the beginning of `b`, see `pending_is_prefix_of`
+        if(!pending_is_prefix_of(b)) {
+            abort_block();
+        }
 
         auto reset_prod_light_validation = fc::make_scoped_exit([old_value=trusted_producer_light_validation, this]() {
             trusted_producer_light_validation = old_value;
@@ -968,7 +1979,13 @@ struct controller_impl {
             EVT_ASSERT(s != controller::block_status::incomplete, block_validate_exception, "invalid block status for a completed block");
             emit(self.pre_accepted_block, b);
 
-            auto new_header_state = fork_db.add(b, false);
+            auto new_header_state = block_state_ptr();
+            if(auto bsp = take_verified_block(b)) {
+                new_header_state = fork_db.add(bsp, false);
+            }
+            else {
+                new_header_state = fork_db.add(b, false);
+            }
 
             if(conf.trusted_producers.count(b->producer)) {
                 trusted_producer_light_validation = true;
@@ -978,6 +1995,7 @@ struct controller_impl {
             if(read_mode != db_read_mode::IRREVERSIBLE) {
                 maybe_switch_forks(s);
             }
+            maybe_write_checkpoint();
         }
         FC_LOG_AND_RETHROW()
     }
@@ -1007,6 +2025,7 @@ struct controller_impl {
             if(s == controller::block_status::irreversible) {
                 emit(self.irreversible_block, new_header_state);
             }
+            maybe_write_checkpoint();
         }
         FC_LOG_AND_RETHROW()
     }
@@ -1028,6 +2047,8 @@ struct controller_impl {
             }
         }
         else if(new_head->id != head->id) {
+            abort_block();
+
             ilog("switching forks from ${current_head_id} (block number ${current_head_num}) to ${new_head_id} (block number ${new_head_num})",
                  ("current_head_id", head->id)("current_head_num", head->block_num)("new_head_id", new_head->id)("new_head_num", new_head->block_num));
             auto branches = fork_db.fetch_branch_from(new_head->id, head->id);
@@ -1042,6 +2063,11 @@ struct controller_impl {
             for(auto ritr = branches.first.rbegin(); ritr != branches.first.rend(); ++ritr) {
                 optional<fc::exception> except;
                 try {
+                    // recover keys of the next block on the branch while applying this one
+                    auto nitr = std::next(ritr);
+                    if(nitr != branches.first.rend() && !(*nitr)->validated && conf.block_validation_mode == validation_mode::FULL) {
+                        prepare_block((*nitr)->block);
+                    }
                     apply_block((*ritr)->block,  (*ritr)->validated ? controller::block_status::validated : controller::block_status::complete);
                     head = *ritr;
                     fork_db.mark_in_current_chain(*ritr, true);
@@ -1105,7 +2131,7 @@ struct controller_impl {
             action_digests.emplace_back(a.digest());
         }
 
-        pending->_pending_block_state->header.action_mroot = merkle(move(action_digests));
+        pending->_pending_block_state->header.action_mroot = merkle(move(action_digests), scheduler);
     }
 
     void
@@ -1117,7 +2143,7 @@ struct controller_impl {
             trx_digests.emplace_back(trx.digest());
         }
 
-        pending->_pending_block_state->header.transaction_mroot = merkle(move(trx_digests));
+        pending->_pending_block_state->header.transaction_mroot = merkle(move(trx_digests), scheduler);
     }
 
     void
@@ -1131,10 +2157,36 @@ struct controller_impl {
             p->id  = p->header.id();
 
             create_block_summary(p->id);
+            pending->_finalized = true;
         }
         FC_CAPTURE_AND_RETHROW()
     }
 
+    void
+    track_token_changes() {
+        token_changes_conns[0] = token_db.squashed_deltas.connect([&](auto, auto& deltas) {
+            squashed_deltas = std::move(deltas);
+        });
+        token_changes_conns[1] = token_db.rolled_back_savepoint.connect([&](auto seq) {
+            emit(self.reverted_token_changes, (uint32_t)seq);
+        });
+    }
+
+    void
+    emit_token_changes(const transaction_id_type& trx_id) {
+        if(squashed_deltas.empty()) {
+            return;
+        }
+
+        auto changes = std::make_shared<token_changes>();
+        changes->block_num = pending->_pending_block_state->block_num;
+        changes->trx_id    = trx_id;
+        changes->deltas    = std::move(squashed_deltas);
+        squashed_deltas.clear();
+
+        emit(self.applied_token_changes, changes);
+    }
+
     void
     create_block_summary(const block_id_type& id) {
         auto block_num = block_header::num_from_id(id);
@@ -1144,15 +2196,24 @@ struct controller_impl {
         });
     }
 
-    void
-    clear_expired_input_transactions() {
+    // at most `max_rows` are removed when it's not 0, after a flood of transactions the rest are
+    // left to the following blocks rather than taking a large share of one block's time.
+    // Expired ones left are ignored by deduplication and snapshots.
+    uint32_t
+    clear_expired_input_transactions(uint32_t max_rows) {
         //Look for expired transactions in the deduplication list, and remove them.
         auto&       transaction_idx = db.get_mutable_index<transaction_multi_index>();
         const auto& dedupe_index    = transaction_idx.indices().get<by_expiration>();
         auto        now             = self.pending_block_time();
+        auto        removed         = 0u;
         while((!dedupe_index.empty()) && (now > fc::time_point(dedupe_index.begin()->expiration))) {
+            if(max_rows > 0 && removed >= max_rows) {
+                break;
+            }
             transaction_idx.remove(*dedupe_index.begin());
+            removed++;
         }
+        return removed;
     }
 
 };  /// controller_impl
@@ -1167,6 +2228,13 @@ controller::~controller() {
     //in case if read-mode == IRREVERSIBLE, we will apply latest irreversible block
     //for that we need 'my' to be valid pointer pointing to valid controller_impl.
     my->fork_db.close();
+
+    try {
+        my->commit_durable(true);
+    }
+    catch(const fc::exception& e) {
+        elog("Failed to sync block log and token database: ${e}", ("e", e.to_detail_string()));
+    }
 }
 
 void
@@ -1175,7 +2243,7 @@ controller::add_indices() {
 }
 
 void
-controller::startup(const snapshot_reader_ptr& snapshot) {
+controller::startup(const snapshot_reader_ptr& snapshot, const std::vector<snapshot_reader_ptr>& diffs) {
     my->head = my->fork_db.head();
     if(snapshot) {
         ilog("Starting initialization from snapshot, this may take a significant amount of time");
@@ -1184,8 +2252,14 @@ controller::startup(const snapshot_reader_ptr& snapshot) {
         wlog("No head block in fork db, perhaps we need to replay");
     }
 
+    // deltas are only collected for the ones listening to them
+    if(!applied_token_changes.empty()) {
+        my->track_token_changes();
+    }
+
     try {
-        my->init(snapshot);
+        EVT_ASSERT(snapshot || diffs.empty(), snapshot_validation_exception, "Differential snapshots need their base snapshot");
+        my->init(snapshot, diffs);
     }
     catch(boost::interprocess::bad_alloc& e) {
         if(snapshot) {
@@ -1203,6 +2277,16 @@ controller::db() const {
     return my->db;
 }
 
+reversible_block_store&
+controller::reversible_blocks() const {
+    return my->reversible_blocks;
+}
+
+const trx_index*
+controller::get_trx_index() const {
+    return my->trx_locations.get();
+}
+
 fork_database&
 controller::fork_db() const {
     return my->fork_db;
@@ -1213,6 +2297,11 @@ controller::token_db() const {
     return my->token_db;
 }
 
+authority_memo&
+controller::get_authority_memo() const {
+    return my->auth_memo;
+}
+
 token_database_cache&
 controller::token_db_cache() const {
     return my->token_db_cache;
@@ -1228,6 +2317,11 @@ controller::get_execution_context() const {
     return my->exec_ctx;
 }
 
+std::vector<action_cost>
+controller::get_action_costs() const {
+    return my->action_costs.get_costs();
+}
+
 void
 controller::start_block(block_timestamp_type when, uint16_t confirm_block_count) {
     validate_db_available_size();
@@ -1250,6 +2344,7 @@ controller::commit_block() {
     validate_db_available_size();
     validate_reversible_available_size();
     my->commit_block(true);
+    my->maybe_write_checkpoint();
 }
 
 void
@@ -1264,6 +2359,38 @@ controller::push_block(const signed_block_ptr& b) {
     my->push_block(b);
 }
 
+block_state_ptr
+controller::verify_block(const block_header_state& prev, const signed_block_ptr& b) {
+    EVT_ASSERT(b, block_validate_exception, "trying to verify empty block");
+    EVT_ASSERT(b->block_extensions.size() == 0, block_validate_exception, "no supported extensions");
+
+    auto bsp = make_block_state(prev, b, false /* skip_validate_signee */);
+
+    auto trx_digests = vector<digest_type>();
+    trx_digests.reserve(b->transactions.size());
+    for(const auto& trx : b->transactions) {
+        trx_digests.emplace_back(trx.digest());
+    }
+    EVT_ASSERT(merkle(move(trx_digests)) == b->transaction_mroot, block_validate_exception,
+        "transaction merkle root of block doesn't match its receipts", ("id", bsp->id));
+    return bsp;
+}
+
+void
+controller::add_verified_block(const block_state_ptr& bsp) {
+    my->add_verified_block(bsp);
+}
+
+optional<block_header_state>
+controller::block_log_head_state(const optional<block_header_state>& snapshot_head) const {
+    return my->block_log_head_state(snapshot_head);
+}
+
+void
+controller::append_block_log(const std::vector<signed_block_ptr>& blocks) {
+    my->append_block_log(blocks);
+}
+
 transaction_trace_ptr
 controller::push_transaction(const transaction_metadata_ptr& trx, fc::time_point deadline) {
     validate_db_available_size();
@@ -1272,6 +2399,16 @@ controller::push_transaction(const transaction_metadata_ptr& trx, fc::time_point
     return my->push_transaction(trx, deadline);
 }
 
+std::vector<transaction_trace_ptr>
+controller::push_transactions(const std::vector<transaction_metadata_ptr>& trxs, fc::time_point deadline) {
+    validate_db_available_size();
+    EVT_ASSERT(get_read_mode() != chain::db_read_mode::READ_ONLY, transaction_type_exception, "push transaction not allowed in read-only mode");
+    for(auto& trx : trxs) {
+        EVT_ASSERT(trx && !trx->implicit, transaction_type_exception, "Implicit transaction not allowed");
+    }
+    return my->push_transactions(trxs, deadline);
+}
+
 transaction_trace_ptr
 controller::push_suspend_transaction(const transaction_metadata_ptr& trx, fc::time_point deadline) {
     validate_db_available_size();
@@ -1361,6 +2498,11 @@ controller::last_irreversible_block_num() const {
     return std::max(std::max(my->head->bft_irreversible_blocknum, my->head->dpos_irreversible_blocknum), my->snapshot_head_block);
 }
 
+uint32_t
+controller::earliest_available_block_num() const {
+    return my->blog.first_available_block_num();
+}
+
 block_id_type
 controller::last_irreversible_block_id() const {
     auto        lib_num             = last_irreversible_block_num();
@@ -1408,6 +2550,19 @@ controller::fetch_block_by_number(uint32_t block_num) const {
     FC_CAPTURE_AND_RETHROW((block_num))
 }
 
+block_log::serialized_block
+controller::fetch_serialized_block_by_number(uint32_t block_num) const {
+    try {
+        auto blk_state = my->fork_db.get_block_in_current_chain_by_num(block_num);
+        if(blk_state && blk_state->block) {
+            return {};
+        }
+
+        return my->blog.read_serialized_block_by_num(block_num);
+    }
+    FC_CAPTURE_AND_RETHROW((block_num))
+}
+
 block_state_ptr
 controller::fetch_block_state_by_id(block_id_type id) const {
     auto state = my->fork_db.get_block(id);
@@ -1432,6 +2587,16 @@ controller::get_block_id_for_num(uint32_t block_num) const {
             return blk_state->id;
         }
 
+        // summaries are a ring of 65536 slots, the slot of a block not produced yet holds an older one
+        EVT_ASSERT(block_num <= head_block_num(), unknown_block_exception,
+                   "Could not find block: ${block}", ("block", block_num));
+
+        // ids of recent blocks are kept in summaries, which saves reading the whole block from log
+        const auto& summary = my->db.get<block_summary_object>((uint16_t)block_num);
+        if(block_header::num_from_id(summary.block_id) == block_num) {
+            return summary.block_id;
+        }
+
         auto signed_blk = my->blog.read_block_by_num(block_num);
 
         EVT_ASSERT(BOOST_LIKELY(signed_blk != nullptr), unknown_block_exception,
@@ -1463,6 +2628,12 @@ controller::get_block_num_for_trx_id(const transaction_id_type& trx_id) const {
     if(const auto* t = my->db.find<transaction_object, by_trx_id>(trx_id)) {
         return t->block_num;
     }
+    // expired ones are only found in the index
+    if(my->trx_locations) {
+        if(auto loc = my->trx_locations->find(trx_id)) {
+            return loc->block_num;
+        }
+    }
     EVT_THROW(unknown_transaction_exception, "Transaction: ${t} is not existed", ("t",trx_id));
 }
 
@@ -1480,6 +2651,15 @@ controller::write_snapshot(const snapshot_writer_ptr& snapshot) const {
     return my->add_to_snapshot(snapshot);
 }
 
+void
+controller::write_diff_snapshot(const snapshot_writer_ptr& snapshot, const std::vector<snapshot_reader_ptr>& bases) const {
+    EVT_ASSERT(!my->pending.has_value(), block_validate_exception, "cannot take a consistent snapshot with a pending block");
+    for(auto& b : bases) {
+        b->validate();
+    }
+    return my->add_diff_to_snapshot(snapshot, bases);
+}
+
 void
 controller::pop_block() {
     my->pop_block();
@@ -1504,14 +2684,14 @@ controller::set_proposed_producers(vector<producer_key> producers) {
     decltype(sch.producers.cend()) end;
     decltype(end)                  begin;
 
-    if(my->pending->_pending_block_state->pending_schedule.producers.size() == 0) {
-        const auto& active_sch = my->pending->_pending_block_state->active_schedule;
+    if(my->pending->_pending_block_state->pending_schedule->producers.size() == 0) {
+        const auto& active_sch = my->pending->_pending_block_state->active_schedule.get();
         begin                  = active_sch.producers.begin();
         end                    = active_sch.producers.end();
         sch.version            = active_sch.version + 1;
     }
     else {
-        const auto& pending_sch = my->pending->_pending_block_state->pending_schedule;
+        const auto& pending_sch = my->pending->_pending_block_state->pending_schedule.get();
         begin                   = pending_sch.producers.begin();
         end                     = pending_sch.producers.end();
         sch.version             = pending_sch.version + 1;
@@ -1562,6 +2742,28 @@ controller::set_action_version(name action, int version) {
     }); 
 }
 
+namespace internal {
+
+// kept in token database so it's rolled back with the votes changing it
+const auto kMaxTrxCompressionKey = N128(.compression);
+
+}  // namespace internal
+
+int
+controller::get_max_trx_compression() const {
+    auto str = std::string();
+    if(!my->token_db.read_token(token_type::prodvote, std::nullopt, internal::kMaxTrxCompressionKey, str, true /* no throw */)) {
+        return packed_transaction::zlib;
+    }
+    return fc::raw::unpack<int32_t>(str.data(), str.size());
+}
+
+void
+controller::set_max_trx_compression(int compression) {
+    auto v = fc::raw::pack((int32_t)compression);
+    my->token_db.put_token(token_type::prodvote, action_op::put, std::nullopt, internal::kMaxTrxCompressionKey, std::string_view(v.data(), v.size()));
+}
+
 const producer_schedule_type&
 controller::active_producers() const {
     if(!(my->pending.has_value())) {
@@ -1663,6 +2865,11 @@ controller::get_chain_id() const {
     return my->chain_id;
 }
 
+utilities::task_scheduler&
+controller::get_task_scheduler() const {
+    return my->scheduler;
+}
+
 const genesis_state&
 controller::get_genesis_state() const {
     return my->conf.genesis;
@@ -1670,7 +2877,7 @@ controller::get_genesis_state() const {
 
 const abi_serializer&
 controller::get_abi_serializer() const {
-    return my->system_api;
+    return my->get_system_api();
 }
 
 unapplied_transactions_type&
@@ -1730,28 +2937,72 @@ controller::validate_db_available_size() const {
 
 void
 controller::validate_reversible_available_size() const {
-   const auto free = my->reversible_blocks.get_segment_manager()->get_free_memory();
+   // blocks are kept on disk now, guard the space left on its volume
+   const auto free = boost::filesystem::space(my->reversible_blocks.path().parent_path()).available;
    const auto guard = my->conf.reversible_guard_size;
    EVT_ASSERT(free >= guard, reversible_guard_exception, "reversible free: ${f}, guard size: ${g}", ("f", free)("g",guard));
 }
 
 bool
 controller::is_known_unexpired_transaction(const transaction_id_type& id) const {
-    return db().find<transaction_object, by_trx_id>(id);
+    auto t = db().find<transaction_object, by_trx_id>(id);
+    if(t == nullptr) {
+        return false;
+    }
+    // expired ones may be still there if cleanup is bounded
+    auto now = my->pending.has_value() ? pending_block_time() : head_block_time();
+    return !(now > fc::time_point(t->expiration));
 }
 
+uint32_t
+controller::clear_expired_transactions(uint32_t max_rows) {
+    EVT_ASSERT(my->pending.has_value(), block_validate_exception, "it is not valid to clear expired transactions when there is no pending block");
+    return my->clear_expired_input_transactions(max_rows);
+}
+
+namespace internal {
+
+// more used keys than this are returned as they are, trials of removing them would cost more than they save
+constexpr size_t kMaxMinimizedKeys = 32;
+
+}  // namespace internal
+
 public_keys_set
 controller::get_required_keys(const transaction& trx, const public_keys_set& candidate_keys) const {
     const static uint32_t max_authority_depth = my->conf.genesis.initial_configuration.max_authority_depth;
-    auto checker = authority_checker(*this, my->exec_ctx, candidate_keys, max_authority_depth);
 
+    auto satisfied = [&](const public_keys_set& keys) {
+        auto checker = authority_checker(*this, my->exec_ctx, keys, max_authority_depth);
+        for(const auto& act : trx.actions) {
+            if(!checker.satisfied(act)) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    // one pass over all the candidates prunes them to the keys mentioned by the permissions
+    // and reached before the thresholds are met, wallets may hold a lot more keys than that
+    auto checker = authority_checker(*this, my->exec_ctx, candidate_keys, max_authority_depth);
     for(const auto& act : trx.actions) {
-        EVT_ASSERT(checker.satisfied(act), unsatisfied_authorization,
-                   "${name} action in domain: ${domain} with key: ${key} authorized failed",
-                   ("domain", act.domain)("key", act.key)("name", act.name));
+        EVT_ASSERT2(checker.satisfied(act), unsatisfied_authorization,
+                    "{} action in domain: {} with key: {} authorized failed", act.name, act.domain, act.key);
     }
 
+    // then drops the keys not needed by the others, leaving a minimal cover so that
+    // no more signatures than required are paid for and verified
+    // checks of the small sets are cheap, groups are flat and results are kept in authority memo
     auto keys = checker.used_keys();
+    if(keys.size() > 1 && keys.size() <= internal::kMaxMinimizedKeys) {
+        for(auto i = (int)keys.size() - 1; i >= 0; i--) {
+            auto trial = keys;
+            trial.erase(trial.begin() + i);
+            if(satisfied(trial)) {
+                keys = std::move(trial);
+            }
+        }
+    }
+
     if(trx.payer.type() == address::public_key_t) {
         keys.emplace(trx.payer.get_public_key());
     }
@@ -1763,8 +3014,14 @@ controller::get_suspend_required_keys(const transaction& trx, const public_keys_
     const static uint32_t max_authority_depth = my->conf.genesis.initial_configuration.max_authority_depth;
     auto checker = authority_checker(*this, my->exec_ctx, candidate_keys, max_authority_depth);
 
+    // keys of approvals are already recovered and kept in the proposal, only the new ones are checked here
+    // used keys only grow and never go beyond the candidates, so the rest of actions cannot add any
+    // once all of them are used, large proposals with one approver per action stop early
     for(const auto& act : trx.actions) {
         checker.satisfied(act);
+        if(checker.all_keys_used()) {
+            break;
+        }
     }
 
     auto keys = checker.used_keys();
@@ -1798,3 +3055,5 @@ controller::get_charge(transaction&& trx, size_t signautres_num) const {
 }
 
 }}  // namespace evt::chain
+
+FC_REFLECT(evt::chain::checkpoint_info, (block_num)(block_id));
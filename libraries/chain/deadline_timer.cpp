@@ -0,0 +1,175 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#include <evt/chain/deadline_timer.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <evt/chain/exceptions.hpp>
+
+namespace evt { namespace chain {
+
+namespace {
+
+constexpr auto coarse_tick = fc::milliseconds(1);
+
+std::chrono::system_clock::time_point
+to_system_clock(const fc::time_point& t) {
+    return std::chrono::system_clock::time_point(std::chrono::microseconds(t.time_since_epoch().count()));
+}
+
+// guards the watchdog, its users and its timers
+std::mutex watchdog_mtx;
+
+// written by the watchdog thread, only valid while it ticks
+std::atomic<int64_t> coarse_us    = 0;
+std::atomic<bool>    coarse_valid = false;
+
+}  // namespace
+
+class deadline_watchdog {
+public:
+    deadline_watchdog()
+        : thread_([this] { run(); }) {}
+
+public:
+    // all below are called with `watchdog_mtx` held
+
+    void
+    add(deadline_timer& t, const fc::time_point& deadline) {
+        auto earliest = timers_.empty() || deadline < timers_.begin()->first;
+
+        t.pos_     = timers_.emplace(deadline, &t);
+        t.running_ = true;
+        if(earliest) {
+            cv_.notify_one();
+        }
+    }
+
+    void
+    remove(deadline_timer& t) {
+        if(t.running_) {
+            timers_.erase(t.pos_);
+            t.running_ = false;
+        }
+    }
+
+    // timers still running are left unraised
+    void
+    stop() {
+        for(auto& it : timers_) {
+            it.second->running_ = false;
+        }
+        timers_.clear();
+        stopped_ = true;
+        cv_.notify_one();
+    }
+
+    void join() { thread_.join(); }
+
+private:
+    void
+    run() {
+        auto lock = std::unique_lock<std::mutex>(watchdog_mtx);
+        while(!stopped_) {
+            if(timers_.empty()) {
+                // parked until a timer starts, `coarse_now` reads the clock meanwhile
+                coarse_valid.store(false, std::memory_order_relaxed);
+                cv_.wait(lock);
+                continue;
+            }
+
+            auto now = fc::time_point::now();
+            coarse_us.store(now.time_since_epoch().count(), std::memory_order_relaxed);
+            coarse_valid.store(true, std::memory_order_release);
+
+            while(!timers_.empty() && timers_.begin()->first <= now) {
+                auto t = timers_.begin()->second;
+                t->expired_.store(true, std::memory_order_relaxed);
+                t->running_ = false;
+                timers_.erase(timers_.begin());
+            }
+
+            auto wake = now + coarse_tick;
+            if(!timers_.empty() && timers_.begin()->first < wake) {
+                wake = timers_.begin()->first;
+            }
+            cv_.wait_until(lock, to_system_clock(wake));
+        }
+        coarse_valid.store(false, std::memory_order_relaxed);
+    }
+
+private:
+    std::condition_variable                        cv_;
+    std::multimap<fc::time_point, deadline_timer*> timers_;
+    bool                                           stopped_ = false;
+    std::thread                                    thread_;
+};
+
+namespace {
+
+deadline_watchdog* watchdog       = nullptr;
+size_t             watchdog_users = 0;
+
+}  // namespace
+
+void
+deadline_timer::start_watchdog() {
+    auto lock = std::unique_lock<std::mutex>(watchdog_mtx);
+    if(watchdog_users++ == 0) {
+        watchdog = new deadline_watchdog();
+    }
+}
+
+void
+deadline_timer::stop_watchdog() {
+    auto w = (deadline_watchdog*)nullptr;
+    {
+        auto lock = std::unique_lock<std::mutex>(watchdog_mtx);
+        if(watchdog_users == 0 || --watchdog_users > 0) {
+            return;
+        }
+        w        = watchdog;
+        watchdog = nullptr;
+        w->stop();
+    }
+    w->join();
+    delete w;
+}
+
+void
+deadline_timer::start(fc::time_point deadline, fc::time_point now) {
+    stop();
+    expired_.store(deadline <= now, std::memory_order_relaxed);
+    if(!expired() && deadline != fc::time_point::maximum()) {
+        auto lock = std::unique_lock<std::mutex>(watchdog_mtx);
+        EVT_ASSERT(watchdog != nullptr, misc_exception, "Deadline timer is started while the watchdog is not");
+        watchdog->add(*this, deadline);
+        armed_ = true;
+    }
+}
+
+void
+deadline_timer::stop() {
+    if(armed_) {
+        auto lock = std::unique_lock<std::mutex>(watchdog_mtx);
+        // `running_` is cleared already when the watchdog stopped
+        if(watchdog != nullptr) {
+            watchdog->remove(*this);
+        }
+        armed_ = false;
+    }
+}
+
+fc::time_point
+deadline_timer::coarse_now() {
+    if(coarse_valid.load(std::memory_order_acquire)) {
+        return fc::time_point(fc::microseconds(coarse_us.load(std::memory_order_relaxed)));
+    }
+    return fc::time_point::now();
+}
+
+}}  // namespace evt::chain
@@ -5,6 +5,7 @@
 #include <evt/chain/fork_database.hpp>
 #include <evt/chain/exceptions.hpp>
 
+#include <unordered_set>
 #include <boost/multi_index/composite_key.hpp>
 #include <boost/multi_index/hashed_index.hpp>
 #include <boost/multi_index/mem_fun.hpp>
@@ -27,8 +28,9 @@ typedef multi_index_container<
     indexed_by<hashed_unique<tag<by_block_id>,
                              member<block_header_state, block_id_type, &block_header_state::id>,
                              std::hash<block_id_type>>,
-               ordered_non_unique<tag<by_prev>,
-                                  const_mem_fun<block_header_state, const block_id_type&, &block_header_state::prev>>,
+               hashed_non_unique<tag<by_prev>,
+                                 const_mem_fun<block_header_state, const block_id_type&, &block_header_state::prev>,
+                                 std::hash<block_id_type>>,
                ordered_non_unique<tag<by_block_num>,
                                   composite_key<block_state,
                                                 member<block_header_state, uint32_t, &block_header_state::block_num>,
@@ -43,63 +45,284 @@ typedef multi_index_container<
                    composite_key_compare<std::greater<uint32_t>, std::greater<uint32_t>, std::greater<uint32_t>>>>>
     fork_multi_index_type;
 
+/**
+ *  Fork database is persisted as an append-only journal, changes are appended when
+ *  they happen and only the mutable flags are written when closing.
+ *  Journal is only valid when it ends with a `close_head` record, otherwise it's discarded.
+ */
+enum class journal_record : uint8_t {
+    add_block = 0,   // block_state
+    remove_block,    // block_id_type
+    update_block,    // block_state_flags
+    close_head       // block_id_type
+};
+
+struct block_state_flags {
+    block_id_type               id;
+    bool                        validated;
+    bool                        in_current_chain;
+    uint32_t                    bft_irreversible_blocknum;
+    vector<header_confirmation> confirmations;
+};
+
 struct fork_database_impl {
     fork_multi_index_type index;
     block_state_ptr       head;
     fc::path              datadir;
+    uint32_t              retention_window = 0;
+    uint32_t              last_stale_prune = 0;
+
+    std::ofstream         journal;
+    uint64_t              journal_adds = 0;  // number of add records in journal, used to decide compaction
+
+    fc::path journal_path() const { return datadir / config::forkdb_journal_filename; }
+
+    void load_legacy(const fc::path& dat);
+    bool load_journal();
+    void open_journal();
+    void compact_journal();
+    void prune_stale_forks();
+
+    template <typename T>
+    void
+    append(journal_record type, const T& v) {
+        if(!journal.is_open()) {
+            return;
+        }
+        fc::raw::pack(journal, (uint8_t)type);
+        fc::raw::pack(journal, v);
+    }
+
+    void
+    insert(const block_state_ptr& s) {
+        auto result = index.insert(s);
+        EVT_ASSERT(result.second, fork_database_exception, "unable to insert block state, duplicate state detected");
+    }
 };
 
-fork_database::fork_database(const fc::path& data_dir)
+void
+fork_database_impl::load_legacy(const fc::path& dat) {
+    string content;
+    fc::read_file_contents(dat, content);
+
+    fc::datastream<const char*> ds(content.data(), content.size());
+    unsigned_int size;
+    fc::raw::unpack(ds, size);
+    for(uint32_t i = 0, n = size.value; i < n; ++i) {
+        block_state s;
+        fc::raw::unpack(ds, s);
+        insert(make_block_state(move(s)));
+    }
+    block_id_type head_id;
+    fc::raw::unpack(ds, head_id);
+
+    auto itr = index.find(head_id);
+    if(itr != index.end()) {
+        head = *itr;
+    }
+}
+
+bool
+fork_database_impl::load_journal() {
+    string content;
+    fc::read_file_contents(journal_path(), content);
+
+    fc::datastream<const char*> ds(content.data(), content.size());
+    auto head_id = optional<block_id_type>();
+    auto adds    = uint64_t(0);
+
+    try {
+        while(ds.remaining() > 0) {
+            uint8_t type;
+            fc::raw::unpack(ds, type);
+            head_id.reset();
+
+            switch((journal_record)type) {
+            case journal_record::add_block: {
+                block_state s;
+                fc::raw::unpack(ds, s);
+                // the same block may be added again after it's removed
+                index.erase(s.id);
+                insert(make_block_state(move(s)));
+                adds++;
+                break;
+            }
+            case journal_record::remove_block: {
+                block_id_type id;
+                fc::raw::unpack(ds, id);
+                index.erase(id);
+                break;
+            }
+            case journal_record::update_block: {
+                block_state_flags f;
+                fc::raw::unpack(ds, f);
+                auto itr = index.find(f.id);
+                if(itr != index.end()) {
+                    index.modify(itr, [&](auto& bsp) {
+                        bsp->validated                 = f.validated;
+                        bsp->in_current_chain          = f.in_current_chain;
+                        bsp->bft_irreversible_blocknum = f.bft_irreversible_blocknum;
+                        bsp->confirmations             = std::move(f.confirmations);
+                    });
+                }
+                break;
+            }
+            case journal_record::close_head: {
+                head_id.emplace();
+                fc::raw::unpack(ds, *head_id);
+                break;
+            }
+            default: {
+                EVT_THROW(fork_database_exception, "Unknown fork database journal record: ${t}", ("t", type));
+            }
+            }  // switch
+        }
+    }
+    catch(const fc::exception& e) {
+        wlog("Fork database journal is corrupted: ${e}", ("e", e.to_string()));
+        head_id.reset();
+    }
+
+    if(!head_id.has_value()) {
+        // not closed properly, states in it are not consistent with others
+        wlog("Fork database journal is not closed properly, discard it");
+        index.clear();
+        return false;
+    }
+
+    auto itr = index.find(*head_id);
+    if(itr != index.end()) {
+        head = *itr;
+    }
+    journal_adds = adds;
+    return true;
+}
+
+void
+fork_database_impl::open_journal() {
+    journal.exceptions(std::ofstream::failbit | std::ofstream::badbit);
+    journal.open(journal_path().generic_string().c_str(), std::ios::out | std::ios::binary | std::ios::app);
+}
+
+void
+fork_database_impl::compact_journal() {
+    // rewrite the live blocks only, it's cheap when there're few blocks left after pruning
+    auto tmp = datadir / (std::string(config::forkdb_journal_filename) + ".tmp");
+    {
+        auto out = std::ofstream(tmp.generic_string().c_str(), std::ios::out | std::ios::binary | std::ofstream::trunc);
+        out.exceptions(std::ofstream::failbit | std::ofstream::badbit);
+        for(const auto& s : index.get<by_block_num>()) {
+            fc::raw::pack(out, (uint8_t)journal_record::add_block);
+            fc::raw::pack(out, *s);
+        }
+        out.flush();
+    }
+
+    journal.close();
+    fc::rename(tmp, journal_path());
+    open_journal();
+    journal_adds = index.size();
+}
+
+/**
+ *  Removes the branches which have fallen behind head by more than the retention window,
+ *  they are not going to become the best chain anymore. Blocks of head's branch are kept.
+ */
+void
+fork_database_impl::prune_stale_forks() {
+    if(retention_window == 0 || !head || head->block_num <= retention_window) {
+        return;
+    }
+    if(head->block_num < last_stale_prune + std::max(retention_window / 4, 1u)) {
+        return;
+    }
+    last_stale_prune = head->block_num;
+
+    auto limit = head->block_num - retention_window;
+    auto& by_bn = index.get<by_block_num>();
+    if(by_bn.empty() || (*by_bn.begin())->block_num >= limit) {
+        return;
+    }
+
+    auto branch = std::unordered_set<block_id_type, std::hash<block_id_type>>();
+    for(auto itr = index.find(head->id); itr != index.end(); itr = index.find((*itr)->header.previous)) {
+        branch.insert((*itr)->id);
+    }
+
+    auto stale = vector<block_id_type>();
+    for(auto itr = by_bn.begin(); itr != by_bn.end() && (*itr)->block_num < limit; itr++) {
+        if(branch.find((*itr)->id) == branch.end()) {
+            stale.push_back((*itr)->id);
+        }
+    }
+    for(auto& id : stale) {
+        auto itr = index.find(id);
+        if(itr != index.end()) {
+            index.erase(itr);
+            append(journal_record::remove_block, id);
+        }
+    }
+    if(!stale.empty()) {
+        wlog("Pruned ${n} blocks of stale forks behind block ${l}", ("n", stale.size())("l", limit));
+    }
+}
+
+fork_database::fork_database(const fc::path& data_dir, uint32_t retention_window)
     : my(new fork_database_impl()) {
-    my->datadir = data_dir;
+    my->datadir          = data_dir;
+    my->retention_window = retention_window;
 
     if(!fc::is_directory(my->datadir))
         fc::create_directories(my->datadir);
 
+    // keeps appending to the journal after it's loaded, new records follow the old ones
+    if(fc::exists(my->journal_path()) && !my->load_journal()) {
+        fc::remove(my->journal_path());
+    }
+
+    my->open_journal();
+
     auto fork_db_dat = my->datadir / config::forkdb_filename;
     if(fc::exists(fork_db_dat)) {
-        string content;
-        fc::read_file_contents(fork_db_dat, content);
-
-        fc::datastream<const char*> ds(content.data(), content.size());
-        unsigned_int size;
-        fc::raw::unpack(ds, size);
-        for(uint32_t i = 0, n = size.value; i < n; ++i) {
-            block_state s;
-            fc::raw::unpack(ds, s);
-            set(std::make_shared<block_state>(move(s)));
+        // written by the versions before journal
+        if(my->index.empty()) {
+            my->load_legacy(fork_db_dat);
+            my->compact_journal();
         }
-        block_id_type head_id;
-        fc::raw::unpack(ds, head_id);
-
-        my->head = get_block(head_id);
-
         fc::remove(fork_db_dat);
     }
 }
 
 void
 fork_database::close() {
+    if(!my->journal.is_open()) {
+        return;
+    }
     if(my->index.size() == 0) {
+        my->journal.close();
+        fc::remove(my->journal_path());
         return;
     }
 
-    auto fork_db_dat = my->datadir / config::forkdb_filename;
-    std::ofstream out(fork_db_dat.generic_string().c_str(), std::ios::out | std::ios::binary | std::ofstream::trunc);
-    uint32_t num_blocks_in_fork_db = my->index.size();
-    fc::raw::pack(out, unsigned_int{num_blocks_in_fork_db});
+    // flags are changed in place without journaling, write them all at last
     for(const auto& s : my->index) {
-        fc::raw::pack(out, *s);
+        my->append(journal_record::update_block, block_state_flags {
+            .id                        = s->id,
+            .validated                 = s->validated,
+            .in_current_chain          = s->in_current_chain,
+            .bft_irreversible_blocknum = s->bft_irreversible_blocknum,
+            .confirmations             = s->confirmations
+        });
     }
-    if(my->head)
-        fc::raw::pack(out, my->head->id);
-    else
-        fc::raw::pack(out, block_id_type());
+    my->append(journal_record::close_head, my->head ? my->head->id : block_id_type());
+    my->journal.flush();
+    my->journal.close();
 
     /// we don't normally indicate the head block as irreversible
     /// we cannot normally prune the lib if it is the head block because
     /// the next block needs to build off of the head block. We are exiting
     /// now so we can prune this block as irreversible before exiting.
+    /// journal is closed above, so the pruned block is still kept in it.
     auto lib    = my->head->dpos_irreversible_blocknum;
     auto oldest = *my->index.get<by_block_num>().begin();
     if(oldest->block_num <= lib) {
@@ -121,6 +344,9 @@ fork_database::set(block_state_ptr s) {
     // EVT_ASSERT( s->block_num == s->header.block_num() );
 
     EVT_ASSERT(result.second, fork_database_exception, "unable to insert block state, duplicate state detected");
+    my->append(journal_record::add_block, *s);
+    my->journal_adds++;
+
     if(!my->head) {
         my->head = s;
     }
@@ -142,6 +368,8 @@ fork_database::add(const block_state_ptr& n, bool skip_validate_previous) {
 
     auto inserted = my->index.insert(n);
     EVT_ASSERT(inserted.second, fork_database_exception, "duplicate block added?");
+    my->append(journal_record::add_block, *n);
+    my->journal_adds++;
 
     my->head = *my->index.get<by_lib_block_num>().begin();
 
@@ -151,6 +379,12 @@ fork_database::add(const block_state_ptr& n, bool skip_validate_previous) {
     if(oldest->block_num < lib) {
         prune(oldest);
     }
+    my->prune_stale_forks();
+
+    // most of the journal is for the blocks already pruned
+    if(my->journal_adds > 4 * my->index.size() + config::forkdb_journal_min_compact_blocks) {
+        my->compact_journal();
+    }
 
     return n;
 }
@@ -167,7 +401,7 @@ fork_database::add(signed_block_ptr b, bool skip_validate_signee) {
     auto prior = by_id_idx.find(b->previous);
     EVT_ASSERT(prior != by_id_idx.end(), unlinkable_block_exception, "unlinkable block", ("id", b->id())("previous", b->previous));
 
-    auto result = std::make_shared<block_state>(**prior, move(b), skip_validate_signee);
+    auto result = make_block_state(**prior, move(b), skip_validate_signee);
     EVT_ASSERT(result, fork_database_exception , "fail to add new block state");
     return add(result, true);
 }
@@ -177,6 +411,22 @@ fork_database::head() const {
     return my->head;
 }
 
+size_t
+fork_database::size() const {
+    return my->index.size();
+}
+
+uint64_t
+fork_database::blocks_size() const {
+    auto n = uint64_t(0);
+    for(auto& s : my->index) {
+        if(s->block) {
+            n += fc::raw::pack_size(*s->block);
+        }
+    }
+    return n;
+}
+
 /**
  *  Given two head blocks, return two branches of the fork graph that
  *  end with a common ancestor (same prior block)
@@ -223,14 +473,15 @@ fork_database::remove(const block_id_type& id) {
 
     for(uint32_t i = 0; i < remove_queue.size(); ++i) {
         auto itr = my->index.find(remove_queue[i]);
-        if(itr != my->index.end())
+        if(itr != my->index.end()) {
             my->index.erase(itr);
+            my->append(journal_record::remove_block, remove_queue[i]);
+        }
 
         auto& previdx = my->index.get<by_prev>();
-        auto  previtr = previdx.lower_bound(remove_queue[i]);
-        while(previtr != previdx.end() && (*previtr)->header.previous == remove_queue[i]) {
+        auto  range   = previdx.equal_range(remove_queue[i]);
+        for(auto previtr = range.first; previtr != range.second; ++previtr) {
             remove_queue.push_back((*previtr)->id);
-            ++previtr;
         }
     }
     // wdump((my->index.size()));
@@ -278,6 +529,7 @@ fork_database::prune(const block_state_ptr& h) {
     if(itr != my->index.end()) {
         irreversible(*itr);
         my->index.erase(itr);
+        my->append(journal_record::remove_block, h->id);
     }
 
     auto& numidx = my->index.get<by_block_num>();
@@ -320,7 +572,7 @@ fork_database::add(const header_confirmation& c) {
     b->add_confirmation(c);
 
     if(b->bft_irreversible_blocknum < b->block_num
-       && b->confirmations.size() >= ((b->active_schedule.producers.size() * 2) / 3 + 1)) {
+       && b->confirmations.size() >= ((b->active_schedule->producers.size() * 2) / 3 + 1)) {
         set_bft_irreversible(c.block_id);
     }
 }
@@ -350,8 +602,9 @@ fork_database::set_bft_irreversible(block_id_type id) {
 
         for(const auto& i : in) {
             auto& pidx  = my->index.get<by_prev>();
-            auto  pitr  = pidx.lower_bound(i);
-            auto  epitr = pidx.upper_bound(i);
+            auto  range = pidx.equal_range(i);
+            auto  pitr  = range.first;
+            auto  epitr = range.second;
             while(pitr != epitr) {
                 pidx.modify(pitr, [&](auto& bsp) {
                     if(bsp->bft_irreversible_blocknum < block_num) {
@@ -372,3 +625,5 @@ fork_database::set_bft_irreversible(block_id_type id) {
 }
 
 }}  // namespace evt::chain
+
+FC_REFLECT(evt::chain::block_state_flags, (id)(validated)(in_current_chain)(bft_irreversible_blocknum)(confirmations));
@@ -0,0 +1,369 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#include <evt/chain/genesis_initial_state.hpp>
+
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <fc/io/json.hpp>
+#include <fc/io/raw.hpp>
+#include <fc/log/logger.hpp>
+#include <evt/chain/exceptions.hpp>
+#include <evt/chain/genesis_state.hpp>
+#include <evt/chain/token_database.hpp>
+
+namespace evt { namespace chain {
+
+namespace internal {
+
+using namespace contracts;
+
+const uint32_t kMaxInitialStateWorkers = 8;
+const uint32_t kBlocksPerWorker        = 4;                // blocks buffered in memory per worker
+const size_t   kInitialStateBlockSize  = 4 * 1024 * 1024;  // blocks are split at line ends
+const size_t   kInitialStateBatchSize  = 1024;             // values per batch put
+
+struct initial_balance {
+    address owner;
+    asset   amount;
+};
+
+struct initial_asset {
+    std::string    key;  // key in token database
+    address        addr;
+    symbol_id_type sym_id;
+    property       prop;
+};
+
+// lines of the file decoded by one worker
+struct initial_state_block {
+    std::string data;
+    size_t      first_line = 0;
+
+    std::vector<domain_def>      domains;
+    std::vector<token_def>       tokens;
+    std::vector<fungible_def>    fungibles;
+    std::vector<initial_balance> balances;
+};
+
+// order of the keys in token database, which compares bytes
+bool
+key_less(const name128& lhs, const name128& rhs) {
+    return memcmp(&lhs, &rhs, sizeof(name128)) < 0;
+}
+
+std::string
+db_asset_key(const address& addr, symbol_id_type sym_id) {
+    auto key = std::string(sizeof(sym_id) + sizeof(fc::ecc::public_key_shim), '\0');
+    memcpy(key.data(), &sym_id, sizeof(sym_id));
+    addr.to_bytes(key.data() + sizeof(sym_id), sizeof(fc::ecc::public_key_shim));
+    return key;
+}
+
+void
+decode_line(initial_state_block& block, const std::string& line) {
+    auto v  = fc::json::from_string(line);
+    auto& o = v.get_object();
+    EVT_ASSERT(o.size() == 1, genesis_initial_state_exception, "Entry should have exactly one of domain, token, fungible or balance");
+
+    auto& e = *o.begin();
+    if(e.key() == "domain") {
+        block.domains.emplace_back(e.value().as<domain_def>());
+    }
+    else if(e.key() == "token") {
+        block.tokens.emplace_back(e.value().as<token_def>());
+    }
+    else if(e.key() == "fungible") {
+        block.fungibles.emplace_back(e.value().as<fungible_def>());
+    }
+    else if(e.key() == "balance") {
+        auto& b = e.value().get_object();
+        block.balances.emplace_back(initial_balance { b["owner"].as<address>(), b["amount"].as<asset>() });
+    }
+    else {
+        EVT_THROW(genesis_initial_state_exception, "Unknown entry: ${k}", ("k", e.key()));
+    }
+}
+
+void
+decode_block(initial_state_block& block) {
+    auto data = std::string_view(block.data);
+    auto line = block.first_line;
+    for(auto begin = 0ul; begin < data.size(); line++) {
+        auto end = std::min(data.find('\n', begin), data.size());
+        auto str = data.substr(begin, end - begin);
+        begin    = end + 1;
+
+        if(str.find_first_not_of(" \t\r") == std::string_view::npos) {
+            continue;
+        }
+        try {
+            decode_line(block, std::string(str));
+        }
+        catch(const fc::exception& e) {
+            EVT_THROW(genesis_initial_state_exception, "Invalid initial state on line ${l}: ${e}", ("l", line)("e", e.to_detail_string()));
+        }
+    }
+}
+
+// decodes blocks in parallel by worker threads, while the caller hashes them
+template<typename Hash>
+void
+decode_blocks_parallel(std::vector<initial_state_block>& blocks, Hash&& hash) {
+    auto workers = std::min((size_t)std::clamp(std::thread::hardware_concurrency(), 1u, kMaxInitialStateWorkers), blocks.size());
+    auto next    = std::atomic<size_t>(0);
+    auto err     = std::exception_ptr();
+    auto mtx     = std::mutex();
+
+    auto threads = std::vector<std::thread>();
+    for(auto i = 0u; i < workers; i++) {
+        threads.emplace_back([&] {
+            try {
+                for(auto j = next++; j < blocks.size(); j = next++) {
+                    decode_block(blocks[j]);
+                }
+            }
+            catch(...) {
+                auto lock = std::lock_guard<std::mutex>(mtx);
+                if(!err) {
+                    err = std::current_exception();
+                }
+            }
+        });
+    }
+    for(auto& b : blocks) {
+        hash(b);
+    }
+    for(auto& t : threads) {
+        t.join();
+    }
+    if(err) {
+        std::rethrow_exception(err);
+    }
+}
+
+}  // namespace internal
+
+namespace genesis_initial_state {
+
+std::optional<fc::sha256>
+declared_digest(const genesis_state& genesis) {
+    for(auto& m : genesis.evt_org.metas_) {
+        if(m.key == N128(.initial-state)) {
+            return fc::sha256(m.value);
+        }
+    }
+    return std::nullopt;
+}
+
+void
+load(const fc::path& path, const genesis_state& genesis, token_database& db) {
+    using namespace internal;
+
+    auto digest = declared_digest(genesis);
+    EVT_ASSERT(digest.has_value(), genesis_initial_state_exception,
+               "Genesis state doesn't declare an initial state, ${f} cannot be loaded", ("f", path.generic_string()));
+
+    auto file = std::ifstream(path.generic_string(), std::ios::binary);
+    EVT_ASSERT(file.is_open(), genesis_initial_state_exception, "Cannot open initial state file ${f}", ("f", path.generic_string()));
+
+    auto domains   = std::vector<domain_def>();
+    auto tokens    = std::vector<token_def>();
+    auto fungibles = std::vector<fungible_def>();
+    auto balances  = std::vector<initial_balance>();
+
+    auto workers = std::clamp(std::thread::hardware_concurrency(), 1u, kMaxInitialStateWorkers);
+    auto window  = (size_t)workers * kBlocksPerWorker;
+    auto enc     = fc::sha256::encoder();
+    auto tail    = std::string();
+    auto line    = size_t(1);
+
+    while(true) {
+        auto blocks = std::vector<initial_state_block>();
+        while(blocks.size() < window && file) {
+            auto data = std::move(tail);
+            auto size = data.size();
+            data.resize(size + kInitialStateBlockSize);
+            file.read(data.data() + size, kInitialStateBlockSize);
+            data.resize(size + file.gcount());
+
+            tail = std::string();
+            if(file) {
+                // the partial line at the end goes to the next block
+                auto pos = data.rfind('\n');
+                if(pos == std::string::npos) {
+                    tail = std::move(data);
+                    continue;
+                }
+                tail.assign(data, pos + 1);
+                data.resize(pos + 1);
+            }
+            if(data.empty()) {
+                continue;
+            }
+
+            auto& b      = blocks.emplace_back();
+            b.first_line = line;
+            line        += std::count(data.begin(), data.end(), '\n');
+            b.data       = std::move(data);
+        }
+        EVT_ASSERT(file || file.eof(), genesis_initial_state_exception, "Cannot read initial state file ${f}", ("f", path.generic_string()));
+        if(blocks.empty()) {
+            break;
+        }
+
+        decode_blocks_parallel(blocks, [&](auto& b) { enc.write(b.data.data(), b.data.size()); });
+
+        for(auto& b : blocks) {
+            std::move(b.domains.begin(), b.domains.end(), std::back_inserter(domains));
+            std::move(b.tokens.begin(), b.tokens.end(), std::back_inserter(tokens));
+            std::move(b.fungibles.begin(), b.fungibles.end(), std::back_inserter(fungibles));
+            std::move(b.balances.begin(), b.balances.end(), std::back_inserter(balances));
+        }
+    }
+
+    auto hash = enc.result();
+    EVT_ASSERT(hash == *digest, genesis_initial_state_exception,
+               "Digest of initial state file ${f} is ${h}, while genesis state declares ${d}",
+               ("f", path.generic_string())("h", hash)("d", *digest));
+
+    // sorted in key order and checked for duplicates, so values are written by few SST files
+    std::sort(domains.begin(), domains.end(), [](auto& l, auto& r) { return key_less(l.name, r.name); });
+    for(auto i = 1u; i < domains.size(); i++) {
+        EVT_ASSERT(domains[i - 1].name != domains[i].name, genesis_initial_state_exception, "Duplicate domain: ${d}", ("d", domains[i].name));
+    }
+
+    std::sort(tokens.begin(), tokens.end(), [](auto& l, auto& r) {
+        return key_less(l.domain, r.domain) || (l.domain == r.domain && key_less(l.name, r.name));
+    });
+    for(auto i = 0u; i < tokens.size(); i++) {
+        auto& t = tokens[i];
+        if(i > 0) {
+            EVT_ASSERT(tokens[i - 1].domain != t.domain || tokens[i - 1].name != t.name, genesis_initial_state_exception,
+                       "Duplicate token: ${n} in domain ${d}", ("n", t.name)("d", t.domain));
+        }
+        if(i == 0 || tokens[i - 1].domain != t.domain) {
+            auto it = std::lower_bound(domains.cbegin(), domains.cend(), t.domain, [](auto& d, auto& n) { return key_less(d.name, n); });
+            EVT_ASSERT(it != domains.cend() && it->name == t.domain, genesis_initial_state_exception,
+                       "Domain ${d} of token ${n} is not in initial state", ("d", t.domain)("n", t.name));
+        }
+    }
+
+    std::sort(fungibles.begin(), fungibles.end(), [](auto& l, auto& r) {
+        return key_less(name128::from_number(l.sym.id()), name128::from_number(r.sym.id()));
+    });
+    for(auto i = 0u; i < fungibles.size(); i++) {
+        auto id = fungibles[i].sym.id();
+        EVT_ASSERT(i == 0 || fungibles[i - 1].sym.id() != id, genesis_initial_state_exception, "Duplicate fungible: ${id}", ("id", id));
+        EVT_ASSERT(!db.exists_token(token_type::fungible, std::nullopt, id), genesis_initial_state_exception,
+                   "Fungible ${id} is reserved", ("id", id));
+    }
+
+    // supplies are checked and the remaining ones are left in the reserved addresses of fungibles
+    auto supplies = std::map<symbol_id_type, std::pair<symbol, int64_t>>();
+    supplies[EVT_SYM_ID] = std::make_pair(evt_sym(), genesis.evt.total_supply.amount());
+    for(auto& f : fungibles) {
+        supplies[f.sym.id()] = std::make_pair(f.sym, f.total_supply.amount());
+    }
+
+    auto assets     = std::vector<initial_asset>();
+    auto created_at = genesis.initial_timestamp.sec_since_epoch();
+    assets.reserve(balances.size() + supplies.size());
+    for(auto& b : balances) {
+        auto it = supplies.find(b.amount.symbol_id());
+        EVT_ASSERT(it != supplies.end() && it->second.first == b.amount.sym(), genesis_initial_state_exception,
+                   "Fungible of balance ${a} of ${o} is not in initial state", ("a", b.amount)("o", b.owner));
+        EVT_ASSERT(b.amount.amount() > 0 && b.amount.amount() <= it->second.second, genesis_initial_state_exception,
+                   "Balance ${a} of ${o} exceeds the remaining supply", ("a", b.amount)("o", b.owner));
+        it->second.second -= b.amount.amount();
+
+        assets.emplace_back(initial_asset {
+                                .key = db_asset_key(b.owner, b.amount.symbol_id()),
+                                .addr = b.owner,
+                                .sym_id = b.amount.symbol_id(),
+                                .prop = property {
+                                    .amount = b.amount.amount(),
+                                    .sym = b.amount.sym(),
+                                    .created_at = created_at,
+                                    .created_index = 0
+                                }
+                            });
+    }
+    for(auto& s : supplies) {
+        auto addr = address(N(.fungible), name128::from_number(s.first), 0);
+        assets.emplace_back(initial_asset {
+                                .key = db_asset_key(addr, s.first),
+                                .addr = addr,
+                                .sym_id = s.first,
+                                .prop = property {
+                                    .amount = s.second.second,
+                                    .sym = s.second.first,
+                                    .created_at = created_at,
+                                    .created_index = 0
+                                }
+                            });
+    }
+    std::sort(assets.begin(), assets.end(), [](auto& l, auto& r) { return l.key < r.key; });
+    for(auto i = 1u; i < assets.size(); i++) {
+        EVT_ASSERT(assets[i - 1].key != assets[i].key, genesis_initial_state_exception,
+                   "Duplicate balance of ${s} of ${o}", ("s", assets[i].prop.sym)("o", assets[i].addr));
+    }
+
+    ilog("Loading initial state of ${d} domains, ${t} tokens, ${f} fungibles and ${b} balances",
+         ("d", domains.size())("t", tokens.size())("f", fungibles.size())("b", balances.size()));
+
+    auto put_tokens = [&db](token_type type, const std::optional<name128>& domain, auto begin, auto end, auto&& key) {
+        while(begin != end) {
+            auto keys   = token_keys_t();
+            auto values = std::vector<std::vector<char>>();
+            for(; begin != end && keys.size() < kInitialStateBatchSize; begin++) {
+                keys.emplace_back(key(*begin));
+                values.emplace_back(fc::raw::pack(*begin));
+            }
+
+            auto data = small_vector<std::string_view, 4>();
+            for(auto& v : values) {
+                data.emplace_back(v.data(), v.size());
+            }
+            db.put_tokens(type, action_op::add, domain, std::move(keys), data);
+        }
+    };
+
+    db.begin_bulk_load();
+    put_tokens(token_type::domain, std::nullopt, domains.cbegin(), domains.cend(), [](auto& d) { return d.name; });
+    put_tokens(token_type::fungible, std::nullopt, fungibles.cbegin(), fungibles.cend(), [](auto& f) { return name128::from_number(f.sym.id()); });
+    for(auto it = tokens.cbegin(); it != tokens.cend();) {
+        auto end = std::find_if(it, tokens.cend(), [&](auto& t) { return t.domain != it->domain; });
+        put_tokens(token_type::token, it->domain, it, end, [](auto& t) { return t.name; });
+        it = end;
+    }
+    for(auto i = 0ul; i < assets.size(); i += kInitialStateBatchSize) {
+        auto keys   = asset_keys_t();
+        auto values = std::vector<std::vector<char>>();
+        for(auto j = i; j < std::min(i + kInitialStateBatchSize, assets.size()); j++) {
+            keys.emplace_back(assets[j].addr, assets[j].sym_id);
+            values.emplace_back(fc::raw::pack(assets[j].prop));
+        }
+
+        auto data = small_vector<std::string_view, 4>();
+        for(auto& v : values) {
+            data.emplace_back(v.data(), v.size());
+        }
+        db.put_assets(keys, data);
+    }
+    db.end_bulk_load();
+}
+
+}  // namespace genesis_initial_state
+
+}}  // namespace evt::chain
@@ -4,6 +4,7 @@
  */
 #pragma once
 #include <any>
+#include <memory>
 #include <type_traits>
 #include <evt/chain/types.hpp>
 #include <evt/chain/exceptions.hpp>
@@ -24,14 +25,14 @@ public:
 public:
     action() : index_(-1) {}
 
-    // don't copy cache_ when in copy ctor.
+    // copies share the decoded data, like the one in `action_trace`
     action(const action& lhs)
         : name(lhs.name)
         , domain(lhs.domain)
         , key(lhs.key)
         , data(lhs.data)
         , index_(lhs.index_)
-        , cache_() {}
+        , cache_(std::atomic_load(&lhs.cache_)) {}
 
     action(action&& lhs) noexcept = default;
 
@@ -42,6 +43,7 @@ public:
             key    = lhs.key;
             data   = lhs.data;
             index_ = lhs.index_;
+            cache_ = std::atomic_load(&lhs.cache_);
         }
         return *this;
     }
@@ -66,7 +68,7 @@ public:
         , key(key)
         , data(fc::raw::pack(value))
         , index_(-1)
-        , cache_(std::make_any<T>(value)) {}
+        , cache_(make_cache(value)) {}
 
     action(const action_name name, const domain_name& domain, const domain_key& key, const bytes& data)
         : name(name)
@@ -79,7 +81,7 @@ public:
     void
     set_data(const T& value) {
         data   = fc::raw::pack(value);
-        cache_ = std::make_any<T>(value);
+        cache_ = make_cache(value);
     }
 
     void
@@ -89,21 +91,62 @@ public:
 
     // if T is a reference, will return the reference to the internal cache value
     // Otherwise if T is a value type, will return new copy. 
+    // Data is decoded once for each version and shared by all the copies of this action, even
+    // across threads, so `data` must only be changed through `set_data` after that.
     template <typename T>
     T
     data_as() const {
-        if(!cache_.has_value()) {
-            using raw_type = std::remove_const_t<std::remove_reference_t<T>>;
-            EVT_ASSERT(name == raw_type::get_action_name(), action_type_exception, "action name is not consistent with action struct");
-            cache_ = std::make_any<raw_type>(fc::raw::unpack<raw_type>(data));
+        using raw_type = std::remove_const_t<std::remove_reference_t<T>>;
+
+        auto head = std::atomic_load(&cache_);
+        if(auto v = find_cache<raw_type>(head)) {
+            return *v;
+        }
+
+        EVT_ASSERT(name == raw_type::get_action_name(), action_type_exception, "action name is not consistent with action struct");
+        auto node  = std::make_shared<cache_node>();
+        node->value.template emplace<raw_type>(fc::raw::unpack<raw_type>(data));
+        node->next = std::move(head);
+
+        // nodes are never removed while the action lives, the references handed out stay valid
+        while(!std::atomic_compare_exchange_weak(&cache_, &node->next, cache_ptr(node))) {
+            if(auto v = find_cache<raw_type>(node->next)) {
+                return *v;  // decoded by another thread meanwhile
+            }
+        }
+        return *std::any_cast<raw_type>(&node->value);
+    }
+
+private:
+    // decoded data, one node for each version of the action struct
+    struct cache_node {
+        std::any                          value;
+        std::shared_ptr<const cache_node> next;
+    };
+    using cache_ptr = std::shared_ptr<const cache_node>;
+
+    template <typename T>
+    static cache_ptr
+    make_cache(const T& value) {
+        auto node = std::make_shared<cache_node>();
+        node->value.template emplace<T>(value);
+        return node;
+    }
+
+    template <typename T>
+    static const T*
+    find_cache(const cache_ptr& head) {
+        for(auto n = head.get(); n != nullptr; n = n->next.get()) {
+            if(auto v = std::any_cast<T>(&n->value)) {
+                return v;
+            }
         }
-        // no need to check name here, `any_cast` will throws exception if types don't match
-        return std::any_cast<T>(cache_);
+        return nullptr;
     }
 
 private:
-    mutable int      index_;
-    mutable std::any cache_;
+    mutable int       index_;
+    mutable cache_ptr cache_;
 
 private:
     friend class apply_context;
@@ -0,0 +1,75 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+#include <array>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include <evt/chain/trace.hpp>
+
+namespace evt { namespace chain {
+
+class execution_context;
+
+// costs of one action name and version in the recent window
+struct action_cost {
+    action_name           name;
+    int                   version   = 0;
+    uint64_t              count     = 0;
+    uint64_t              sum_us    = 0;
+    uint64_t              max_us    = 0;
+    uint64_t              p50_us    = 0;
+    uint64_t              p99_us    = 0;
+    uint64_t              db_reads  = 0;
+    uint64_t              db_writes = 0;
+    uint64_t              db_misses = 0;
+    std::vector<uint64_t> latency_us;  // count of samples under 16, 32, 64 ... us, the last one is the rest
+};
+
+/**
+ * Sums the execution costs of the actions in applied transactions by name and version.
+ * Costs are kept in two windows of `window` each, the older one is dropped when
+ * the current one is full, so reports always cover one to two windows.
+ */
+class action_cost_tracker {
+public:
+    static constexpr size_t kFirstBucket = 4;   // 16us
+    static constexpr size_t kLastBucket  = 20;  // 1s
+
+public:
+    explicit action_cost_tracker(fc::microseconds window = fc::minutes(10))
+        : window_(window) {}
+
+public:
+    void record(const transaction_trace& trace, const execution_context& exec_ctx);
+    void reset();
+
+    std::vector<action_cost> get_costs() const;
+
+private:
+    struct entry {
+        uint64_t count     = 0;
+        uint64_t sum_us    = 0;
+        uint64_t max_us    = 0;
+        uint64_t db_reads  = 0;
+        uint64_t db_writes = 0;
+        uint64_t db_misses = 0;
+
+        std::array<uint64_t, kLastBucket - kFirstBucket + 2> buckets{};
+    };
+    using window_map = std::map<std::pair<action_name, int>, entry>;
+
+private:
+    fc::microseconds   window_;
+    fc::time_point     window_start_;
+    window_map         current_;
+    window_map         previous_;
+    mutable std::mutex mutex_;
+};
+
+}}  // namespace evt::chain
+
+FC_REFLECT(evt::chain::action_cost, (name)(version)(count)(sum_us)(max_us)(p50_us)(p99_us)(db_reads)(db_writes)(db_misses)(latency_us));
@@ -193,6 +193,38 @@ private:
 
 namespace fc {
 
+namespace raw {
+
+// both are packed as they lay in memory: little-endian amount followed by the symbol
+static_assert(sizeof(evt::chain::asset) == 16 && std::is_trivially_copyable_v<evt::chain::asset>);
+
+template<>
+struct fixed_pack_size<evt::chain::symbol> : std::integral_constant<size_t, 8> {};
+
+template<>
+struct fixed_pack_size<evt::chain::asset> : std::integral_constant<size_t, 16> {};
+
+template<>
+struct packer<evt::chain::asset> {
+    template<typename Stream>
+    static void
+    pack(Stream& s, const evt::chain::asset& a) {
+        s.write((const char*)&a, sizeof(a));
+    }
+};
+
+template<>
+struct unpacker<evt::chain::asset> {
+    template<typename Stream>
+    static void
+    unpack(Stream& s, evt::chain::asset& a) {
+        s.read((char*)&a, sizeof(a));
+        a.reflector_init();
+    }
+};
+
+}  // namespace raw
+
 inline void
 to_variant(const evt::chain::symbol& var, fc::variant& vo) {
     vo = var.to_string();
@@ -6,10 +6,13 @@
 #include <functional>
 
 #include <fc/scoped_exit.hpp>
+#include <fc/container/flat.hpp>
+#include <fc/log/trace.hpp>
+#include <fc/crypto/sha256.hpp>
 
 #include <boost/dynamic_bitset.hpp>
-#include <boost/range/algorithm/find.hpp>
 
+#include <evt/chain/authority_memo.hpp>
 #include <evt/chain/controller.hpp>
 #include <evt/chain/config.hpp>
 #include <evt/chain/execution_context_impl.hpp>
@@ -62,6 +65,9 @@ private:
     token_database_cache&           tokendb_cache_;
     boost::dynamic_bitset<uint64_t> used_keys_;
 
+    authority_memo&                 memo_;
+    std::optional<fc::sha256>       keys_digest_;
+
 public:
     struct weight_tally_visitor {
     public:
@@ -84,7 +90,7 @@ public:
 
         uint32_t
         operator()(const public_key_type& key, const weight_type weight) {
-            auto itr = boost::find(checker_->signing_keys_, key);
+            auto itr = checker_->signing_keys_.find(key);
             if(itr != checker_->signing_keys_.end()) {
                 checker_->used_keys_[itr - checker_->signing_keys_.begin()] = true;
                 total_weight_ += weight;
@@ -111,7 +117,8 @@ public:
         , signing_keys_(signing_keys)
         , max_recursion_depth_(max_recursion_depth)
         , tokendb_cache_(control.token_db_cache())
-        , used_keys_(signing_keys.size(), false) {}
+        , used_keys_(signing_keys.size(), false)
+        , memo_(control.get_authority_memo()) {}
 
 private:
     template<int Permission>
@@ -197,6 +204,52 @@ private:
         return;
     } 
 
+private:
+    const fc::sha256&
+    signing_keys_digest() {
+        if(!keys_digest_.has_value()) {
+            keys_digest_ = fc::sha256::hash(signing_keys_);
+        }
+        return *keys_digest_;
+    }
+
+    bool
+    find_memo(authority_memo::owner_type type, int permission, const name128& owner, bool& result) {
+        auto e = memo_.find(type, permission, owner, signing_keys_digest());
+        if(e == nullptr) {
+            return false;
+        }
+        used_keys_ |= e->used_keys;
+        result = e->result;
+        return true;
+    }
+
+    // evaluates with cleared used keys to record all the keys used by this evaluation
+    template<typename Func>
+    bool
+    eval_memo(authority_memo::owner_type type, int permission, const name128& owner, Func&& func) {
+        auto prev = boost::dynamic_bitset<uint64_t>(signing_keys_.size(), false);
+        prev.swap(used_keys_);
+
+        auto merger = fc::make_scoped_exit([this, &prev]() {
+            used_keys_ |= prev;
+        });
+
+        auto result = func();
+        memo_.put(type, permission, owner, signing_keys_digest(), authority_memo::entry{ result, used_keys_ });
+        return result;
+    }
+
+    static bool
+    has_owner_ref(const permission_def& permission) {
+        for(const auto& aw : permission.authorizers) {
+            if(aw.ref.type() == authorizer_ref::owner_t) {
+                return true;
+            }
+        }
+        return false;
+    }
+
 private:
     bool
     satisfied_node(const group& group, const group::node& node, uint32_t depth) {
@@ -224,15 +277,116 @@ private:
         return false;
     }
 
+    /**
+     *  Nodes of group are laid out flat: children of one node are contiguous and placed after their parent.
+     *  So the satisfaction of all nodes is resolved by one reverse pass, then used keys are marked by one
+     *  forward pass which follows the same short-circuit order as `satisfied_node`.
+     *  Falls back to recursive evaluation if the layout is not like that.
+     */
+    bool
+    satisfied_flat_group(const group& group) {
+        auto& nodes = group.nodes_;
+        auto  sz    = nodes.size();
+        FC_ASSERT(sz > 0);
+        FC_ASSERT(!nodes[0].is_leaf());
+
+        auto covered = boost::dynamic_bitset<uint64_t>(sz, false);
+        for(auto i = 0u; i < sz; i++) {
+            auto& n = nodes[i];
+            if(n.is_leaf()) {
+                if(n.index >= group.keys_.size()) {
+                    return satisfied_node(group, group.root(), 0);
+                }
+                continue;
+            }
+            if(n.index <= i || (size_t)n.index + n.size > sz) {
+                return satisfied_node(group, group.root(), 0);
+            }
+            for(auto c = n.index; c < n.index + n.size; c++) {
+                if(covered[c]) {
+                    return satisfied_node(group, group.root(), 0);
+                }
+                covered[c] = true;
+            }
+        }
+
+        // index of each group key in signing keys, -1 if not signed
+        auto key_indexes = small_vector<int, 8>(group.keys_.size(), -1);
+        for(auto i = 0u; i < group.keys_.size(); i++) {
+            auto it = signing_keys_.find(group.keys_[i]);
+            if(it != signing_keys_.end()) {
+                key_indexes[i] = it - signing_keys_.begin();
+            }
+        }
+
+        auto sat = boost::dynamic_bitset<uint64_t>(sz, false);
+        for(auto i = (int)sz - 1; i >= 0; i--) {
+            auto& n = nodes[i];
+            if(n.is_leaf()) {
+                sat[i] = key_indexes[n.index] >= 0;
+                continue;
+            }
+            auto total = 0u;
+            for(auto c = n.index; c < n.index + n.size; c++) {
+                if(sat[c]) {
+                    total += nodes[c].weight;
+                    if(total >= n.threshold) {
+                        break;
+                    }
+                }
+            }
+            sat[i] = total >= n.threshold;
+        }
+
+        auto visited = boost::dynamic_bitset<uint64_t>(sz, false);
+        auto depths  = small_vector<uint32_t, 16>(sz, 0);
+        visited[0] = true;
+        for(auto i = 0u; i < sz; i++) {
+            auto& n = nodes[i];
+            if(!visited[i] || n.is_leaf()) {
+                continue;
+            }
+            FC_ASSERT(depths[i] < max_recursion_depth_);
+
+            auto total = 0u;
+            for(auto c = n.index; c < n.index + n.size; c++) {
+                auto& cn = nodes[c];
+                FC_ASSERT(!cn.is_root());
+
+                visited[c] = true;
+                depths[c]  = depths[i] + 1;
+                if(cn.is_leaf()) {
+                    if(key_indexes[cn.index] >= 0) {
+                        used_keys_[key_indexes[cn.index]] = true;
+                        total += cn.weight;
+                    }
+                }
+                else if(sat[c]) {
+                    total += cn.weight;
+                }
+                if(total >= n.threshold) {
+                    break;  // no need to visit more nodes
+                }
+            }
+        }
+        return sat[0];
+    }
+
     bool
     satisfied_group(const group_name& name) {
         bool result = false;
-        get_group(name, [&](const auto& group) {
-            if(satisfied_node(group, group.root(), 0)) {
-                result = true;
-            }
+        if(find_memo(authority_memo::kGroup, 0, name, result)) {
+            return result;
+        }
+
+        return eval_memo(authority_memo::kGroup, 0, name, [&] {
+            get_group(name, [&](const auto& group) {
+                if(satisfied_flat_group(group)) {
+                    result = true;
+                }
+            });
+            return result;
         });
-        return result;
     }
 
     template<int Token>
@@ -316,8 +470,18 @@ private:
         using namespace internal;
 
         bool result = false;
+        if(find_memo(authority_memo::kDomain, Permission, action.domain, result)) {
+            return result;
+        }
+
         get_domain_permission<Permission>(action.domain, [&](const auto& permission) {
-            result = satisfied_permission<kNFT>(permission, action);
+            if(has_owner_ref(permission)) {
+                result = satisfied_permission<kNFT>(permission, action);
+                return;
+            }
+            result = eval_memo(authority_memo::kDomain, Permission, action.domain, [&] {
+                return satisfied_permission<kNFT>(permission, action);
+            });
         });
         return result;
     }
@@ -328,8 +492,19 @@ private:
         using namespace internal;
 
         bool result = false;
+        auto owner  = name128::from_number(sym_id);
+        if(find_memo(authority_memo::kFungible, Permission, owner, result)) {
+            return result;
+        }
+
         get_fungible_permission<Permission>(sym_id, [&](const auto& permission) {
-            result = satisfied_permission<kFT>(permission, action);
+            if(has_owner_ref(permission)) {
+                result = satisfied_permission<kFT>(permission, action);
+                return;
+            }
+            result = eval_memo(authority_memo::kFungible, Permission, owner, [&] {
+                return satisfied_permission<kFT>(permission, action);
+            });
         });
         return result;
     }
@@ -338,6 +513,7 @@ public:
     bool
     satisfied(const action& act) {
         using namespace internal;
+        FC_TRACE_SPAN("auth", "authority_checker::satisfied");
 
         // Save the current used keys; if we do not satisfy this authority, the newly used keys aren't actually used
         auto KeyReverter = fc::make_scoped_exit([this, keys = used_keys_]() mutable {
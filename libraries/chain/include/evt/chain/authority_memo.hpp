@@ -0,0 +1,102 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+#include <unordered_map>
+#include <boost/noncopyable.hpp>
+#include <boost/dynamic_bitset.hpp>
+#include <fc/crypto/sha256.hpp>
+#include <evt/chain/name128.hpp>
+
+namespace evt { namespace chain {
+
+/**
+ *  Memo of authority check results within one block.
+ *
+ *  Results are keyed by the owner of permission (group, domain or fungible), the permission
+ *  and the digest of signing keys. Only the results which don't depend on the action itself
+ *  are stored, permissions with owner authorizers are always evaluated.
+ *  The keys used by the evaluation are stored as well and are replayed on hit.
+ */
+class authority_memo : boost::noncopyable {
+public:
+    enum owner_type : uint8_t { kGroup = 0, kDomain, kFungible };
+
+    struct entry {
+        bool                            result;
+        boost::dynamic_bitset<uint64_t> used_keys;
+    };
+
+private:
+    struct memo_key {
+        owner_type type;
+        int        permission;
+        name128    owner;
+        fc::sha256 keys;
+
+        friend bool
+        operator==(const memo_key& a, const memo_key& b) {
+            return a.type == b.type && a.permission == b.permission && a.owner == b.owner && a.keys == b.keys;
+        }
+    };
+
+    struct memo_key_hasher {
+        size_t
+        operator()(const memo_key& k) const {
+            auto h = (size_t)k.keys._hash[0];
+            h ^= (size_t)k.owner.value + 0x9e3779b97f4a7c15 + (h << 6) + (h >> 2);
+            h ^= (size_t)(k.owner.value >> 64) + 0x9e3779b97f4a7c15 + (h << 6) + (h >> 2);
+            h ^= ((size_t)k.type << 8 | (size_t)k.permission) + 0x9e3779b97f4a7c15 + (h << 6) + (h >> 2);
+            return h;
+        }
+    };
+
+    // entries are dropped when exceeded, keeps memory bounded for huge blocks
+    static constexpr size_t kMaxEntries = 64 * 1024;
+
+public:
+    const entry*
+    find(owner_type type, int permission, const name128& owner, const fc::sha256& keys) const {
+        auto it = entries_.find(memo_key{ type, permission, owner, keys });
+        if(it == entries_.end()) {
+            return nullptr;
+        }
+        return &it->second;
+    }
+
+    void
+    put(owner_type type, int permission, const name128& owner, const fc::sha256& keys, entry&& e) {
+        if(entries_.size() >= kMaxEntries) {
+            entries_.clear();
+        }
+        entries_.insert_or_assign(memo_key{ type, permission, owner, keys }, std::move(e));
+    }
+
+    // erase all the entries of one owner
+    void
+    erase(owner_type type, const name128& owner) {
+        for(auto it = entries_.begin(); it != entries_.end();) {
+            if(it->first.type == type && it->first.owner == owner) {
+                it = entries_.erase(it);
+            }
+            else {
+                it++;
+            }
+        }
+    }
+
+    void
+    clear() {
+        if(!entries_.empty()) {
+            entries_.clear();
+        }
+    }
+
+    size_t size() const { return entries_.size(); }
+
+private:
+    std::unordered_map<memo_key, entry, memo_key_hasher> entries_;
+};
+
+}}  // namespace evt::chain
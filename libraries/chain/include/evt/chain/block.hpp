@@ -5,6 +5,7 @@
 #pragma once
 #include <evt/chain/block_header.hpp>
 #include <evt/chain/transaction.hpp>
+#include <evt/utilities/pooled_allocator.hpp>
 
 namespace evt { namespace chain {
 
@@ -70,6 +71,13 @@ public:
 };
 using signed_block_ptr = std::shared_ptr<signed_block>;
 
+// blocks are created for every block received, produced or read, they come from pools
+template <typename... Args>
+signed_block_ptr
+make_signed_block(Args&&... args) {
+    return utilities::make_pooled<signed_block>(std::forward<Args>(args)...);
+}
+
 struct producer_confirmation {
     block_id_type  block_id;
     digest_type    block_digest;
@@ -5,6 +5,7 @@
 #pragma once
 #include <evt/chain/block_header.hpp>
 #include <evt/chain/incremental_merkle.hpp>
+#include <evt/chain/shared_value.hpp>
 
 namespace evt { namespace chain {
 
@@ -13,22 +14,22 @@ namespace evt { namespace chain {
  *  @brief defines the minimum state necessary to validate transaction headers
  */
 struct block_header_state {
-    block_id_type                    id;
-    uint32_t                         block_num = 0;
-    signed_block_header              header;
-    uint32_t                         dpos_proposed_irreversible_blocknum = 0;
-    uint32_t                         dpos_irreversible_blocknum = 0;
-    uint32_t                         bft_irreversible_blocknum  = 0;
-    uint32_t                         pending_schedule_lib_num   = 0;  /// last irr block num
-    digest_type                      pending_schedule_hash;
-    producer_schedule_type           pending_schedule;
-    producer_schedule_type           active_schedule;
-    incremental_merkle               blockroot_merkle;
-    flat_map<account_name, uint32_t> producer_to_last_produced;
-    flat_map<account_name, uint32_t> producer_to_last_implied_irb;
-    public_key_type                  block_signing_key;
-    vector<uint8_t>                  confirm_count;
-    vector<header_confirmation>      confirmations;
+    block_id_type                        id;
+    uint32_t                             block_num = 0;
+    signed_block_header                  header;
+    uint32_t                             dpos_proposed_irreversible_blocknum = 0;
+    uint32_t                             dpos_irreversible_blocknum = 0;
+    uint32_t                             bft_irreversible_blocknum  = 0;
+    uint32_t                             pending_schedule_lib_num   = 0;  /// last irr block num
+    digest_type                          pending_schedule_hash;
+    shared_value<producer_schedule_type> pending_schedule;  // schedules are shared by the states until they change
+    shared_value<producer_schedule_type> active_schedule;
+    incremental_merkle                   blockroot_merkle;
+    flat_map<account_name, uint32_t>     producer_to_last_produced;
+    flat_map<account_name, uint32_t>     producer_to_last_implied_irb;
+    public_key_type                      block_signing_key;
+    vector<uint8_t>                      confirm_count;
+    vector<header_confirmation>          confirmations;
 
     block_header_state next(const signed_block_header& h, bool skip_validate_signee = false) const;
     block_header_state generate_next(block_timestamp_type when) const;
@@ -40,7 +41,7 @@ struct block_header_state {
 
     bool
     has_pending_producers() const {
-        return pending_schedule.producers.size();
+        return pending_schedule->producers.size();
     }
 
     uint32_t calc_dpos_last_irreversible() const;
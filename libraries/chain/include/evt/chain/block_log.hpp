@@ -3,6 +3,8 @@
  *  @copyright defined in evt/LICENSE.txt
  */
 #pragma once
+#include <memory>
+#include <string_view>
 #include <fc/filesystem.hpp>
 #include <evt/chain/block.hpp>
 #include <evt/chain/genesis_state.hpp>
@@ -36,16 +38,35 @@ class block_log_impl;
     *
     * The main file is the only file that needs to persist. The index file can be reconstructed during a
     * linear scan of the main file.
+    *
+    * Reads go through read-only memory mappings of both files, writes still go through the streams.
+    *
+    * A pruned log keeps only the latest `retained_blocks` blocks. Once the active log holds a quarter
+    * of them, its files are moved as they are into `segments/<first>-<last>` and a new log starting at
+    * the next block takes its place. Segments whose blocks are all older than the retained ones are
+    * removed as a whole, nothing is ever rewritten.
     */
 
 class block_log {
 public:
-    block_log(const fc::path& data_dir);
+    /**
+     * Packed bytes of one block inside the mapped log, `data` stays valid as long as `holder` is alive
+     */
+    struct serialized_block {
+        std::shared_ptr<const void> holder;
+        std::string_view            data;
+    };
+
+public:
+    // `retained_blocks` of 0 keeps all the blocks
+    block_log(const fc::path& data_dir, uint32_t retained_blocks = 0);
     block_log(block_log&& other);
     ~block_log();
 
     uint64_t append(const signed_block_ptr& b);
     void     flush();
+    // flushes and syncs the files to the disk, `append` only flushes them
+    void     sync();
     void     reset(const genesis_state& gs, const signed_block_ptr& genesis_block, uint32_t first_block_num = 1);
 
     std::pair<signed_block_ptr, uint64_t> read_block(uint64_t file_pos) const;
@@ -55,6 +76,11 @@ public:
         return read_block_by_num(block_header::num_from_id(id));
     }
 
+    /**
+     * Returns the packed block without unpacking it, `data` is empty if the block does not exist.
+     */
+    serialized_block read_serialized_block_by_num(uint32_t block_num) const;
+
     /**
           * Return offset of block in file, or block_log::npos if it does not exist.
           */
@@ -62,6 +88,8 @@ public:
     signed_block_ptr        read_head() const;
     const signed_block_ptr& head() const;
     uint32_t                first_block_num() const;
+    // first block which can be read, the first one of the oldest segment in pruned log
+    uint32_t                first_available_block_num() const;
 
     static const uint64_t npos = std::numeric_limits<uint64_t>::max();
 
@@ -72,10 +100,21 @@ public:
 
     static genesis_state extract_genesis_state(const fc::path& data_dir);
 
+    /**
+     * Writes the unframed block log in `data_dir` as a framed (version 3) log into `out_dir`,
+     * `frame_blocks` blocks are compressed together with zstd `level`. Returns the number of converted blocks.
+     */
+    static uint32_t convert_to_frames(const fc::path& data_dir, const fc::path& out_dir, uint32_t frame_blocks, int level);
+
 private:
     void open(const fc::path& data_dir);
     void construct_index();
 
+    void open_segments();
+    void rotate(uint32_t next_block_num);
+    void prune_segments(uint32_t head_block_num);
+    void reset_log(const genesis_state& gs, const signed_block_ptr& first_block, uint32_t first_block_num);
+
     std::unique_ptr<detail::block_log_impl> my;
 };
 
@@ -15,18 +15,33 @@ struct block_state : public block_header_state {
     block_state(const block_header_state& prev, block_timestamp_type when);
     block_state() = default;
 
+    /// drops the per-trx metadata, it can be rebuilt from `block` via `get_trxs()`
+    void release_trxs();
+
+    /// returns the trx metadata, rebuilding it from `block` if it was released
+    const vector<transaction_metadata_ptr>& get_trxs();
+
     /// weak_ptr prev_block_state....
     signed_block_ptr block;
     bool             validated        = false;
     bool             in_current_chain = false;
+    bool             trxs_released    = false;
 
     /// this data is redundant with the data stored in block, but facilitates
     /// recapturing transactions when we pop a block
+    /// it's released after the block is accepted to save memory
     vector<transaction_metadata_ptr> trxs;
 };
 
 using block_state_ptr = std::shared_ptr<block_state>;
 
+// block states are created and freed for every block, they come from pools
+template <typename... Args>
+block_state_ptr
+make_block_state(Args&&... args) {
+    return utilities::make_pooled<block_state>(std::forward<Args>(args)...);
+}
+
 }}  // namespace evt::chain
 
 FC_REFLECT_DERIVED(evt::chain::block_state, (evt::chain::block_header_state), (block)(validated)(in_current_chain));
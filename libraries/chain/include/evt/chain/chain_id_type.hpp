@@ -16,6 +16,8 @@ namespace evt {
 
 class net_plugin_impl;
 struct handshake_message;
+struct snapshot_query_message;
+struct block_log_segment_request_message;
 
 namespace chain_apis {
 class read_only;
@@ -54,6 +56,8 @@ private:
 
     friend class evt::net_plugin_impl;
     friend struct evt::handshake_message;
+    friend struct evt::snapshot_query_message;
+    friend struct evt::block_log_segment_request_message;
 
     friend struct ::hello; // TODO: Rushed hack to support bnet_plugin. Need a better solution.
 };
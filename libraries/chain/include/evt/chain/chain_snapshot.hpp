@@ -5,6 +5,7 @@
 #pragma once
 
 #include <evt/chain/exceptions.hpp>
+#include <evt/chain/types.hpp>
 
 namespace evt { namespace chain {
 
@@ -30,6 +31,17 @@ struct chain_snapshot_header {
     }
 };
 
+/**
+ * Only differential snapshots have it, their state is the one of the snapshot whose head is `base_block_id`
+ * plus the changes in them. Token database sections hold only the values changed since then, while the
+ * sections of chain state are whole as they're small and bounded.
+ */
+struct chain_snapshot_diff_header {
+    block_id_type base_block_id;
+    uint32_t      base_block_num = 0;
+};
+
 }}  // namespace evt::chain
 
-FC_REFLECT(evt::chain::chain_snapshot_header, (version))
\ No newline at end of file
+FC_REFLECT(evt::chain::chain_snapshot_header, (version))
+FC_REFLECT(evt::chain::chain_snapshot_diff_header, (base_block_id)(base_block_num))
\ No newline at end of file
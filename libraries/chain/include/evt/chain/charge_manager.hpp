@@ -13,6 +13,7 @@
 #include <evt/chain/execution_context_impl.hpp>
 #include <evt/chain/global_property_object.hpp>
 #include <evt/chain/transaction.hpp>
+#include <evt/chain/transaction_metadata.hpp>
 #include <evt/chain/contracts/types.hpp>
 
 namespace evt { namespace chain {
@@ -81,6 +82,15 @@ private:
         return sig_num * 60;
     }
 
+    bool
+    scaled() const {
+#ifdef MAINNET_BUILD
+        return control_.head_block_num() >= 2750000;
+#else
+        return control_.head_block_num() >= 100;
+#endif
+    }
+
 public:
     uint32_t
     calculate(const packed_transaction& ptrx, size_t sig_num = 0) const {
@@ -106,15 +116,33 @@ public:
 
         s *= config_.global_charge_factor;
 
-#ifdef MAINNET_BUILD
-        if(control_.head_block_num() >= 2750000) {
+        if(scaled()) {
             s /= 1000'000;
         }
-#else
-        if(control_.head_block_num() >= 100) {
-            s /= 1000'000;
+        return s;
+    }
+
+    // result is memoized in `mtrx` and reused as long as the signatures number
+    // and charge factors stay the same
+    uint32_t
+    calculate(transaction_metadata& mtrx, size_t sig_num = 0) const {
+        auto& ptrx = *mtrx.packed_trx;
+        sig_num = std::max(sig_num, ptrx.get_signatures().size());
+
+        auto key = transaction_metadata::charge_key_type {
+            (uint32_t)sig_num,
+            (uint32_t)scaled(),
+            config_.base_network_charge_factor,
+            config_.base_storage_charge_factor,
+            config_.base_cpu_charge_factor,
+            config_.global_charge_factor
+        };
+        if(mtrx.charge.has_value() && mtrx.charge->first == key) {
+            return mtrx.charge->second;
         }
-#endif
+
+        auto s = calculate(ptrx, sig_num);
+        mtrx.charge = std::make_pair(key, s);
         return s;
     }
 
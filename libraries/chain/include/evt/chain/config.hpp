@@ -15,16 +15,37 @@ typedef __uint128_t uint128_t;
 
 const static auto default_blocks_dir_name          = "blocks";
 const static auto reversible_blocks_dir_name       = "reversible";
+const static auto trx_index_dir_name               = "trx-index";
 const static auto default_token_database_dir_name  = "tokendb";
 const static auto default_reversible_cache_size    = 340*1024*1024ll;  /// 1MB * 340 blocks based on 21 producer BFT delay
 const static auto default_reversible_guard_size    = 2*1024*1024ll;    /// 1MB * 2 blocks based on 21 producer BFT delay
 const static auto token_database_persisit_filename = "savepoints.log";
+const static auto token_database_bulk_load_dir      = "bulk";
+const static auto token_database_filters_filename  = "key_filters.dat";
 
 const static auto default_state_dir_name        = "state";
 const static auto forkdb_filename               = "forkdb.dat";
+const static auto forkdb_journal_filename       = "forkdb.log";
 const static auto default_state_size            = 1*1024*1024*1024ll;
 const static auto default_state_guard_size      = 128*1024*1024ll;
 
+const static auto     default_checkpoints_dir_name = "checkpoints";
+const static auto     checkpoint_state_filename    = "state.bin";
+const static auto     checkpoint_info_filename     = "checkpoint.dat";
+const static uint32_t default_checkpoint_interval  = 0;  // in blocks, 0 means checkpoints are disabled
+const static uint32_t default_checkpoints_to_keep  = 2;
+
+const static uint32_t default_fork_db_retention_window    = 3600;  // blocks, stale forks behind head are dropped
+const static uint32_t forkdb_journal_min_compact_blocks   = 4096;
+
+const static uint32_t default_expired_trxs_cleanup_rows   = 5000;  // per block, the rest are left to following blocks
+
+const static uint32_t default_group_commit_blocks = 16;   // irreversible blocks synced at once in group durability mode
+const static uint32_t default_group_commit_ms     = 500;  // or the time since the last sync in that mode
+
+const static uint16_t default_controller_thread_pool_size = 2;
+const static uint32_t default_replay_queue_size           = 64;  // blocks read ahead during replay
+
 const static uint128_t system_account_name = N128(evt);
 
 const static int      block_interval_ms     = 500;
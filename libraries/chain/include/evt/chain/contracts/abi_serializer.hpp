@@ -91,6 +91,17 @@ struct abi_serializer : boost::noncopyable {
 
     void add_specialized_unpack_pack(const string& name, std::pair<abi_serializer::unpack_function, abi_serializer::pack_function> unpack_pack);
 
+    /**
+     * Converts the struct named `T::get_type_name()` by the reflection of T instead of walking its
+     * definition in the abi, when it's converted as a whole (action data and the json apis).
+     * Only used if the definition has the same fields as T and all of them are built-in types or
+     * arrays and optionals of them, so the json is the same either way. Returns false otherwise.
+     */
+    template <typename T>
+    bool add_reflected_type();
+
+    bool is_reflected_type(const type_name& type) const;
+
     static const size_t max_recursion_depth = 32;  // arbitrary depth to prevent infinite recursion
 
 private:  
@@ -106,6 +117,11 @@ private:
                              fc::datastream<char*>& ds, impl::variant_to_binary_context& ctx) const;
 
     bool _is_type(const type_name& type) const;
+    bool _is_reflectable(const type_name& type, const std::vector<std::pair<string, bool>>& fields) const;
+
+    // fast paths of the reflected types, return false if the input is left to the abi walk
+    bool _reflected_to_variant(const type_name& type, const bytes& binary, fc::variant& var) const;
+    bool _reflected_to_binary(const type_name& type, const fc::variant& var, bytes& binary) const;
 
     void validate() const;
 
@@ -117,6 +133,11 @@ private:
 
     std::map<type_name, pair<unpack_function, pack_function>> built_in_types_;
 
+    using reflected_unpack_function = std::function<fc::variant(fc::datastream<const char*>&)>;
+    using reflected_pack_function   = std::function<bool(const fc::variant_object&, bytes&)>;
+
+    std::map<type_name, pair<reflected_unpack_function, reflected_pack_function>> reflected_types_;
+
     std::chrono::microseconds max_serialization_time_;
 
 private:
@@ -669,8 +690,98 @@ abi_from_variant::extract(const variant& v, M& o, abi_traverse_context& ctx) {
     fc::reflector<M>::visit(abi_from_variant_visitor<M>(vo, o, ctx));
 }
 
+template <typename T>
+struct is_optional_member : std::false_type {};
+
+template <typename T>
+struct is_optional_member<std::optional<T>> : std::true_type {};
+
+// names of the fields of a reflected struct, with whether each of them is optional
+template <typename T>
+struct reflected_fields_visitor {
+    explicit reflected_fields_visitor(std::vector<std::pair<string, bool>>& fields)
+        : fields(fields) {}
+
+    template <typename Member, class Class, Member(Class::*member)>
+    void
+    operator()(const char* name) const {
+        fields.emplace_back(name, is_optional_member<Member>::value);
+    }
+
+    std::vector<std::pair<string, bool>>& fields;
+};
+
+// same as fc's visitor except that empty optionals are null, as the abi walk outputs them
+template <typename T>
+struct reflected_to_variant_visitor {
+    reflected_to_variant_visitor(mutable_variant_object& mvo, const T& v)
+        : mvo(mvo)
+        , v(v) {}
+
+    template <typename Member, class Class, Member(Class::*member)>
+    void
+    operator()(const char* name) const {
+        mvo(name, fc::variant(v.*member));
+    }
+
+    mutable_variant_object& mvo;
+    const T&                v;
+};
+
+// same as fc's visitor except that missing fields which are not optional are rejected like the abi walk does
+template <typename T>
+struct reflected_from_variant_visitor {
+    reflected_from_variant_visitor(const variant_object& vo, T& v)
+        : vo(vo)
+        , v(v) {}
+
+    template <typename Member, class Class, Member(Class::*member)>
+    void
+    operator()(const char* name) const {
+        auto it = vo.find(name);
+        if(it != vo.end()) {
+            fc::from_variant(it->value(), v.*member);
+            return;
+        }
+        EVT_ASSERT(is_optional_member<Member>::value, pack_exception,
+            "Missing field '${f}' in input object while processing struct '${p}'", ("f", name)("p", T::get_type_name()));
+    }
+
+    const variant_object& vo;
+    T&                    v;
+};
+
 }  // namespace impl
 
+template <typename T>
+bool
+abi_serializer::add_reflected_type() {
+    auto type   = type_name(T::get_type_name());
+    auto fields = std::vector<std::pair<string, bool>>();
+    fc::reflector<T>::visit(impl::reflected_fields_visitor<T>(fields));
+    if(!_is_reflectable(type, fields)) {
+        return false;
+    }
+
+    auto unpack = [](fc::datastream<const char*>& ds) {
+        auto v = T();
+        fc::raw::unpack(ds, v);
+
+        auto mvo = mutable_variant_object();
+        fc::reflector<T>::visit(impl::reflected_to_variant_visitor<T>(mvo, v));
+        return fc::variant(std::move(mvo));
+    };
+    auto pack = [](const fc::variant_object& vo, bytes& binary) {
+        auto v = T();
+        fc::reflector<T>::visit(impl::reflected_from_variant_visitor<T>(vo, v));
+
+        binary = fc::raw::pack(v);
+        return true;
+    };
+    reflected_types_[type] = std::make_pair<reflected_unpack_function, reflected_pack_function>(std::move(unpack), std::move(pack));
+    return true;
+}
+
 template <typename T>
 void
 abi_serializer::to_variant(const T& o, variant& vo, const execution_context& exec_ctx) const {
@@ -20,6 +20,7 @@
 #include <fc/crypto/city.hpp>
 
 #include <evt/chain/apply_context.hpp>
+#include <evt/chain/authority_memo.hpp>
 #include <evt/chain/token_database.hpp>
 #include <evt/chain/token_database_cache.hpp>
 #include <evt/chain/transaction_context.hpp>
@@ -28,6 +29,7 @@
 #include <evt/chain/contracts/types.hpp>
 #include <evt/chain/contracts/evt_link.hpp>
 #include <evt/chain/contracts/evt_link_object.hpp>
+#include <evt/chain/contracts/property_record.hpp>
 #include <evt/chain/contracts/evt_contract_metas.hpp>
 
 namespace evt { namespace chain { namespace contracts {
@@ -165,7 +167,7 @@ get_db_key<evt_link_object>(const evt_link_object& v) {
     return v.link_id;
 }
 
-enum psvbonus_type { kPsvBonus = 0, kPsvBonusSlim };
+enum psvbonus_type { kPsvBonus = 0, kPsvBonusSlim, kPsvBonusBuild, kPsvBonusFreeze };
 
 name128
 get_psvbonus_db_key(symbol_id_type id, uint64_t nonce) {
@@ -215,8 +217,8 @@ get_db_prefix<token_def>(const token_def& v) {
 
 #define PUT_DB_ASSET(ADDR, VALUE)                                     \
     {                                                                 \
-        auto dv = make_db_value(VALUE);                               \
-        tokendb.put_asset(ADDR, VALUE.sym.id(), dv.as_string_view()); \
+        auto pr = property_record(VALUE);                             \
+        tokendb.put_asset(ADDR, VALUE.sym.id(), pr.as_string_view()); \
     }
 
 #define READ_DB_TOKEN(TYPE, PREFIX, KEY, VPTR, EXCEPTION, FORMAT, ...)      \
@@ -245,16 +247,15 @@ get_db_prefix<token_def>(const token_def& v) {
 #define CHECK_SYM(VALUEREF, PROVIDED) \
     EVT_ASSERT2(VALUEREF.sym == PROVIDED, asset_symbol_exception, "Provided symbol({}) is invalid, expected: {}", PROVIDED, VALUEREF.sym);
 
-#define READ_DB_ASSET(ADDR, SYM, VALUEREF)                                                              \
-    try {                                                                                               \
-        auto str = std::string();                                                                       \
-        tokendb.read_asset(ADDR, SYM.id(), str);                                                        \
-                                                                                                        \
-        extract_db_value(str, VALUEREF);                                                                \
-    }                                                                                                   \
-    catch(token_database_exception&) {                                                                  \
-        EVT_THROW2(balance_exception, "There's no balance left in {} with sym id: {}", ADDR, SYM.id()); \
-    }                                                                                                   \
+// missing balance is told by the result rather than a token database exception thrown and translated
+#define READ_DB_ASSET(ADDR, SYM, VALUEREF)                                                                  \
+    {                                                                                                       \
+        auto str = std::string();                                                                           \
+        if(!tokendb.read_asset(ADDR, SYM.id(), str, true /* no throw */)) {                                 \
+            EVT_THROW2(balance_exception, "There's no balance left in {} with sym id: {}", ADDR, SYM.id()); \
+        }                                                                                                   \
+        property_record::extract(str, VALUEREF);                                                            \
+    }                                                                                                       \
     CHECK_SYM(VALUEREF, SYM);
 
 #define READ_DB_ASSET_NO_THROW(ADDR, SYM, VALUEREF)                         \
@@ -266,7 +267,7 @@ get_db_prefix<token_def>(const token_def& v) {
                 ft_holder { .addr = ADDR, .sym_id = SYM.id() });            \
         }                                                                   \
         else {                                                              \
-            extract_db_value(str, VALUEREF);                                \
+            property_record::extract(str, VALUEREF);                        \
             CHECK_SYM(VALUEREF, SYM);                                       \
         }                                                                   \
     }
@@ -278,11 +279,32 @@ get_db_prefix<token_def>(const token_def& v) {
             VALUEREF = MAKE_PROPERTY(0, SYM);                               \
         }                                                                   \
         else {                                                              \
-            extract_db_value(str, VALUEREF);                                \
+            property_record::extract(str, VALUEREF);                        \
             CHECK_SYM(VALUEREF, SYM);                                       \
         }                                                                   \
     }
 
+// read two balances of one address in a single batch
+#define READ_DB_ASSETS_NO_THROW_NO_NEW(ADDR, SYM1, VALUEREF1, SYM2, VALUEREF2)    \
+    {                                                                          \
+        auto keys   = asset_keys_t();                                          \
+        auto values = read_values_t();                                         \
+        keys.emplace_back(ADDR, SYM1.id());                                    \
+        keys.emplace_back(ADDR, SYM2.id());                                    \
+        tokendb.read_assets(keys, values, true /* no throw */);                \
+                                                                               \
+        auto extract = [&](auto& v, const auto& sym, auto& ref) {              \
+            if(!v.has_value()) {                                               \
+                ref = MAKE_PROPERTY(0, sym);                                   \
+                return;                                                        \
+            }                                                                  \
+            property_record::extract(*v, ref);                                 \
+            CHECK_SYM(ref, sym);                                               \
+        };                                                                     \
+        extract(values[0], SYM1, VALUEREF1);                                   \
+        extract(values[1], SYM2, VALUEREF2);                                   \
+    }
+
 #define DECLARE_TOKEN_DB()                       \
     auto& tokendb = context.token_db;            \
     auto& tokendb_cache = context.token_db_cache;
@@ -353,27 +375,46 @@ EVT_ACTION_IMPL_BEGIN(issuetoken) {
         EVT_ASSERT2(tokendb.exists_token(token_type::domain, std::nullopt, itact.domain), unknown_domain_exception,
             "Cannot find domain: {}.", itact.domain);
 
-        auto check_name = [&](const auto& name) {
-            check_name_reserved(name);
-            EVT_ASSERT2(!tokendb.exists_token(token_type::token, itact.domain, name), token_duplicate_exception,
-                "Token: {} in {} is already exists.", name, itact.domain);
-        };
+        // look up all the names with one multi-get, only names already taken have values
+        auto exists = read_values_t();
+        tokendb.read_tokens(token_type::token, itact.domain, itact.names, exists, true /* no_throw */);
+        for(auto i = 0u; i < itact.names.size(); i++) {
+            check_name_reserved(itact.names[i]);
+            EVT_ASSERT2(!exists[i].has_value(), token_duplicate_exception,
+                "Token: {} in {} is already exists.", itact.names[i], itact.domain);
+        }
 
-        auto values  = small_vector<db_value, 4>();
-        auto data    = small_vector<std::string_view, 4>();
-        values.reserve(itact.names.size());
-        data.reserve(itact.names.size());
+        // keys are written in the order of the tokens column family, which is bytewise
+        std::sort(itact.names.begin(), itact.names.end(), [](auto& lhs, auto& rhs) {
+            return memcmp(&lhs, &rhs, sizeof(name128)) < 0;
+        });
 
+        // all the tokens differ only in their names: pack one prototype and patch the name of it
         auto token   = token_def();
         token.domain = itact.domain;
         token.owner  = itact.owner;
 
+        auto proto = fc::raw::pack(token);
+        auto head  = fc::raw::pack_size(token.domain);
+        auto tail  = head + fc::raw::pack_size(token.name);
+        auto rest  = proto.size() - tail;
+
+        auto total = size_t(0);
         for(auto& n : itact.names) {
-            check_name(n);
+            total += head + fc::raw::pack_size(n) + rest;
+        }
+
+        auto buf  = std::string(total, '\0');
+        auto data = small_vector<std::string_view, 4>();
+        data.reserve(itact.names.size());
 
-            token.name = n;
-            values.emplace_back(make_db_value(token));
-            data.emplace_back(values.back().as_string_view());
+        auto ds = fc::datastream<char*>((char*)buf.data(), buf.size());
+        for(auto& n : itact.names) {
+            auto p = ds.pos();
+            ds.write(proto.data(), head);
+            fc::raw::pack(ds, n);
+            ds.write(proto.data() + tail, rest);
+            data.emplace_back(p, ds.pos() - p);
         }
 
         tokendb.put_tokens(token_type::token, action_op::add, itact.domain, std::move(itact.names), data);
@@ -509,6 +550,9 @@ EVT_ACTION_IMPL_BEGIN(updategroup) {
 
         *group = ugact.group;
         UPD_DB_TOKEN(token_type::group, *group);
+
+        // groups may be referred by any permission
+        context.control.get_authority_memo().clear();
     }
     EVT_CAPTURE_AND_RETHROW(tx_apply_exception);
 }
@@ -563,6 +607,7 @@ EVT_ACTION_IMPL_BEGIN(updatedomain) {
         }
 
         UPD_DB_TOKEN(token_type::domain, *domain);
+        context.control.get_authority_memo().erase(authority_memo::kDomain, udact.name);
     }
     EVT_CAPTURE_AND_RETHROW(tx_apply_exception);
 }
@@ -596,7 +641,7 @@ calculate_passive_bonus(token_database_cache& tokendb_cache,
     }
 
     auto bonus = pbs->base_charge;
-    bonus += (int64_t)boost::multiprecision::floor(pbs->rate.value() * amount);  // add trx fees
+    bonus += pbs->rate.floor_of(amount);  // add trx fees
     if(pbs->minimum_charge.has_value()) {
         bonus = std::max(*pbs->minimum_charge, bonus);    // >= minimum
     }
@@ -627,6 +672,94 @@ calculate_passive_bonus(token_database_cache& tokendb_cache,
     return std::make_pair(amount, 0l);
 }
 
+// partition of the amounts frozen of a holder, hashed from its bytes in asset keys
+name128
+get_frozen_holder_prefix(const std::string_view& addr_bytes) {
+    auto enc = fc::sha256::encoder();
+    fc::raw::pack(enc, N128(.psvbonus));
+    enc.write(addr_bytes.data(), addr_bytes.size());
+    auto h = enc.result();
+    auto n = name128();
+    memcpy(&n, h.data(), sizeof(n));
+    return n;
+}
+
+name128
+get_frozen_holder_db_key(symbol_id_type sym_id, symbol_id_type holder_sym_id, uint32_t round) {
+    return get_psvbonus_db_key(sym_id, ((uint64_t)holder_sym_id << 32) | round);
+}
+
+// keeps `amount` of `addr` before it's changed when a round of passive bonus being built hasn't
+// scanned it yet, so the round sees all the holders as of its start whenever they are scanned
+void
+freeze_holder(apply_context& context, const address& addr, symbol sym, int64_t amount) {
+    DECLARE_TOKEN_DB()
+
+    auto fz = make_empty_cache_ptr<passive_bonus_freeze>();
+    READ_DB_TOKEN_NO_THROW(token_type::psvbonus, std::nullopt, get_psvbonus_db_key(sym.id(), kPsvBonusFreeze), fz);
+    if(fz == nullptr || fz->rounds.empty()) {
+        return;
+    }
+
+    auto key = std::string(addr.get_bytes_size(), '\0');
+    addr.to_bytes(key.data(), key.size());
+
+    for(auto& fr : fz->rounds) {
+        auto b = make_empty_cache_ptr<passive_bonus_build>();
+        READ_DB_TOKEN(token_type::psvbonus, std::nullopt, get_psvbonus_db_key(fr.sym_id, kPsvBonusBuild), b, unknown_bonus_exception,
+            "Cannot find passive bonus being built with sym id: {}", fr.sym_id);
+
+        if(b->round == 0 || b->rule_index > fr.last_rule || (b->rule_index == fr.last_rule && key <= b->cursor)) {
+            // the round is done or the holder is scanned by all the rules of the symbol
+            continue;
+        }
+
+        // only the first change in a round is kept
+        auto prefix = get_frozen_holder_prefix(key);
+        auto hkey   = get_frozen_holder_db_key(fr.sym_id, sym.id(), b->round);
+        if(tokendb.exists_token(token_type::psvbonus_dist, prefix, hkey)) {
+            continue;
+        }
+
+        auto fh = frozen_holder { .amount = amount };
+        tokendb_cache.put_token(token_type::psvbonus_dist, action_op::add, prefix, hkey, fh);
+    }
+}
+
+// adds `amount` to the balance of `addr`, patching the cached value in place
+// this is the same as reading the balance with `READ_DB_ASSET_NO_THROW` and putting it back
+void
+credit_asset(apply_context& context, const address& addr, symbol sym, int64_t amount) {
+    using namespace boost::safe_numerics;
+    DECLARE_TOKEN_DB()
+
+    auto created = false;
+    auto before  = int64_t(0);
+    tokendb.update_asset(addr, sym.id(), [&](auto& v) {
+        auto p = property();
+        if(v.empty()) {
+            p       = MAKE_PROPERTY(0, sym);
+            created = true;
+        }
+        else {
+            property_record::extract(v, p);
+            CHECK_SYM(p, sym);
+        }
+
+        auto r = checked::add<int64_t>(p.amount, amount);
+        EVT_ASSERT2(!r.exception(), math_overflow_exception, "Opeartions resulted in overflows.");
+
+        before    = p.amount;
+        p.amount += amount;
+        v.assign(property_record(p).as_string_view());
+    });
+    freeze_holder(context, addr, sym, before);
+
+    if(created) {
+        context.add_new_ft_holder(ft_holder { .addr = addr, .sym_id = sym.id() });
+    }
+}
+
 void
 transfer_fungible(apply_context& context,
                   const address& from,
@@ -637,18 +770,16 @@ transfer_fungible(apply_context& context,
     using namespace boost::safe_numerics;
     DECLARE_TOKEN_DB()
 
-    property pfrom, pto;
+    property pfrom;
 
     auto sym = total.sym();
     if(sym == pevt_sym()) {
         // special process the situciation where sym is pevt_sym()
         // evt2pevt action
         READ_DB_ASSET(from, evt_sym(), pfrom);
-        READ_DB_ASSET_NO_THROW(to, pevt_sym(), pto);
     }
     else {
         READ_DB_ASSET(from, sym, pfrom);
-        READ_DB_ASSET_NO_THROW(to, sym, pto);
     }
 
     // fast path check
@@ -667,28 +798,19 @@ transfer_fungible(apply_context& context,
         "There's not enough balance({}) within address: {}.", asset(actual_amount, sym), from);
 
     auto r1 = checked::subtract<int64_t>(pfrom.amount, actual_amount);
-    auto r2 = checked::add<int64_t>(pto.amount, receive_amount);
-    EVT_ASSERT(!r1.exception() && !r2.exception(), math_overflow_exception, "Opeartions resulted in overflows.");
-    
-    // update payee and payer
-    pfrom.amount -= actual_amount;
-    pto.amount   += receive_amount;
+    EVT_ASSERT(!r1.exception(), math_overflow_exception, "Opeartions resulted in overflows.");
 
-    PUT_DB_ASSET(to, pto);
+    // update payee and payer, payer is written last as before
+    credit_asset(context, to, sym, receive_amount);
+
+    freeze_holder(context, from, pfrom.sym, pfrom.amount);
+    pfrom.amount -= actual_amount;
     PUT_DB_ASSET(from, pfrom);
 
     // update bonus if needed
     if(bonus_amount > 0) {
         auto addr = get_psvbonus_address(sym.id(), 0);
-
-        property pbonus;
-        READ_DB_ASSET_NO_THROW(addr, sym, pbonus);
-
-        auto r = checked::add<int64_t>(pbonus.amount, bonus_amount);
-        EVT_ASSERT2(!r.exception(), math_overflow_exception, "Opeartions resulted in overflows.");
-
-        pbonus.amount += bonus_amount;
-        PUT_DB_ASSET(addr, pbonus);
+        credit_asset(context, addr, sym, bonus_amount);
 
         auto pbact = paybonus {
             .payer  = from,
@@ -832,6 +954,7 @@ EVT_ACTION_IMPL_BEGIN(updfungible) {
         }
 
         UPD_DB_TOKEN(token_type::fungible, *fungible);
+        context.control.get_authority_memo().erase(authority_memo::kFungible, name128::from_number(ufact.sym_id));
     }
     EVT_CAPTURE_AND_RETHROW(tx_apply_exception);
 }
@@ -1058,6 +1181,31 @@ auto check_meta_key_reserved = [](const auto& key) {
     EVT_ASSERT(!key.reserved(), meta_key_exception, "Meta-key is reserved and cannot be used");
 };
 
+// metas added by `addmeta` v2 are kept apart from their domains, fungibles and groups
+// so that the parents stay small, reserved metas are still kept inline to be read along with them
+template<typename ACT>
+bool
+check_duplicate_meta_apart(const token_database& tokendb, const name128& parent_type, const name128& parent, const meta_key& key) {
+    if constexpr(ACT::get_version() > 1) {
+        // colliding keys are taken as duplicated too, they cannot be stored either
+        return tokendb.exists_token(token_type::meta, std::nullopt, get_meta_db_key(parent_type, parent, key));
+    }
+    return false;
+}
+
+template<typename ACT>
+bool
+add_meta_apart(token_database& tokendb, const name128& parent_type, const name128& parent, const meta& m) {
+    if constexpr(ACT::get_version() > 1) {
+        if(!m.key.reserved()) {
+            auto dbv = make_db_value(m);
+            tokendb.put_token(token_type::meta, action_op::add, std::nullopt, get_meta_db_key(parent_type, parent, m.key), dbv.as_string_view());
+            return true;
+        }
+    }
+    return false;
+}
+
 }  // namespace internal
 
 EVT_ACTION_IMPL_BEGIN(addmeta) {
@@ -1074,7 +1222,8 @@ EVT_ACTION_IMPL_BEGIN(addmeta) {
             auto gp = make_empty_cache_ptr<group_def>();
             READ_DB_TOKEN(token_type::group, std::nullopt, act.key, gp, unknown_group_exception, "Cannot find group: {}", act.key);
 
-            EVT_ASSERT2(!check_duplicate_meta(*gp, amact.key), meta_key_exception,"Metadata with key: {} already exists.", amact.key);
+            EVT_ASSERT2(!check_duplicate_meta(*gp, amact.key) && !check_duplicate_meta_apart<ACT>(tokendb, N128(.group), act.key, amact.key),
+                meta_key_exception,"Metadata with key: {} already exists.", amact.key);
             if(amact.creator.is_group_ref()) {
                 EVT_ASSERT(amact.creator.get_group() == gp->name_, meta_involve_exception, "Only group itself can add its own metadata");
             }
@@ -1083,20 +1232,25 @@ EVT_ACTION_IMPL_BEGIN(addmeta) {
                 EVT_ASSERT(check_involved_group(*gp, amact.creator.get_account()), meta_involve_exception,
                     "Creator is not involved in group: ${name}.", ("name",act.key));
             }
-            gp->metas_.emplace_back(meta(amact.key, amact.value, amact.creator));
-            UPD_DB_TOKEN(token_type::group, *gp);
+            auto m = meta(amact.key, amact.value, amact.creator);
+            if(!add_meta_apart<ACT>(tokendb, N128(.group), act.key, m)) {
+                gp->metas_.emplace_back(std::move(m));
+                UPD_DB_TOKEN(token_type::group, *gp);
+            }
         }
         else if(act.domain == N128(.fungible)) {  // fungible
             if(amact.key.reserved()) {
                 EVT_ASSERT(check_reserved_meta(amact, fungible_metas), meta_key_exception, "Meta-key is reserved and cannot be used");
             }
 
+            auto sym_id   = (symbol_id_type)std::stoul((std::string)act.key);
             auto fungible = make_empty_cache_ptr<fungible_def>();
-            READ_DB_TOKEN(token_type::fungible, std::nullopt, (symbol_id_type)std::stoul((std::string)act.key), fungible,
+            READ_DB_TOKEN(token_type::fungible, std::nullopt, sym_id, fungible,
                 unknown_fungible_exception, "Cannot find fungible with symbol id: {}", act.key);
 
-            EVT_ASSERT(!check_duplicate_meta(*fungible, amact.key), meta_key_exception,
-                "Metadata with key ${key} already exists.", ("key",amact.key));
+            auto duplicated = check_duplicate_meta(*fungible, amact.key)
+                || check_duplicate_meta_apart<ACT>(tokendb, N128(.fungible), name128::from_number(sym_id), amact.key);
+            EVT_ASSERT(!duplicated, meta_key_exception, "Metadata with key ${key} already exists.", ("key",amact.key));
             
             if(amact.creator.is_account_ref()) {
                 // check involved, only creator or person in `manage` permission can add meta
@@ -1109,8 +1263,11 @@ EVT_ACTION_IMPL_BEGIN(addmeta) {
                 EVT_ASSERT(check_involved_fungible(tokendb_cache, *fungible, N(manage), amact.creator), meta_involve_exception,
                     "Creator is not involved in fungible: ${name}.", ("name",act.key));
             }
-            fungible->metas.emplace_back(meta(amact.key, amact.value, amact.creator));
-            UPD_DB_TOKEN(token_type::fungible, *fungible);
+            auto m = meta(amact.key, amact.value, amact.creator);
+            if(!add_meta_apart<ACT>(tokendb, N128(.fungible), name128::from_number(sym_id), m)) {
+                fungible->metas.emplace_back(std::move(m));
+                UPD_DB_TOKEN(token_type::fungible, *fungible);
+            }
         }
         else if(act.key == N128(.meta)) {  // domain
             if(amact.key.reserved()) {
@@ -1121,14 +1278,18 @@ EVT_ACTION_IMPL_BEGIN(addmeta) {
             READ_DB_TOKEN(token_type::domain, std::nullopt, act.domain, domain, unknown_domain_exception,
                 "Cannot find domain: {}", act.domain);
 
-            EVT_ASSERT(!check_duplicate_meta(*domain, amact.key), meta_key_exception,
-                "Metadata with key ${key} already exists.", ("key",amact.key));
+            auto duplicated = check_duplicate_meta(*domain, amact.key)
+                || check_duplicate_meta_apart<ACT>(tokendb, N128(.domain), act.domain, amact.key);
+            EVT_ASSERT(!duplicated, meta_key_exception, "Metadata with key ${key} already exists.", ("key",amact.key));
             // check involved, only person involved in `manage` permission can add meta
             EVT_ASSERT(check_involved_domain(tokendb_cache, *domain, N(manage), amact.creator), meta_involve_exception,
                 "Creator is not involved in domain: ${name}.", ("name",act.key));
 
-            domain->metas.emplace_back(meta(amact.key, amact.value, amact.creator));
-            UPD_DB_TOKEN(token_type::domain, *domain);
+            auto m = meta(amact.key, amact.value, amact.creator);
+            if(!add_meta_apart<ACT>(tokendb, N128(.domain), act.domain, m)) {
+                domain->metas.emplace_back(std::move(m));
+                UPD_DB_TOKEN(token_type::domain, *domain);
+            }
         }
         else {  // token
             check_meta_key_reserved(amact.key);
@@ -1320,20 +1481,21 @@ EVT_ACTION_IMPL_BEGIN(paycharge) {
         DECLARE_TOKEN_DB()
 
         property evt, pevt;
-        READ_DB_ASSET_NO_THROW_NO_NEW(pcact.payer, pevt_sym(), pevt);
+        READ_DB_ASSETS_NO_THROW_NO_NEW(pcact.payer, pevt_sym(), pevt, evt_sym(), evt);
         auto paid = std::min((int64_t)pcact.charge, pevt.amount);
         if(paid > 0) {
+            freeze_holder(context, pcact.payer, pevt_sym(), pevt.amount);
             pevt.amount -= paid;
             PUT_DB_ASSET(pcact.payer, pevt);
         }
 
         if(paid < pcact.charge) {
-            READ_DB_ASSET_NO_THROW_NO_NEW(pcact.payer, evt_sym(), evt);
             auto remain = pcact.charge - paid;
             if(evt.amount < (int64_t)remain) {
                 EVT_THROW2(charge_exceeded_exception,"There are only {} and {} left, but charge is {}",
                     asset(evt.amount, evt_sym()), asset(pevt.amount, pevt_sym()), asset(pcact.charge, evt_sym()));
             }
+            freeze_holder(context, pcact.payer, evt_sym(), evt.amount);
             evt.amount -= remain;
             PUT_DB_ASSET(pcact.payer, evt);
         }
@@ -1341,11 +1503,8 @@ EVT_ACTION_IMPL_BEGIN(paycharge) {
         auto  pbs  = context.control.pending_block_state();
         auto& prod = pbs->get_scheduled_producer(pbs->header.timestamp).block_signing_key;
 
-        property bp;
-        READ_DB_ASSET_NO_THROW(address(prod), evt_sym(), bp);
         // give charge to producer
-        bp.amount += pcact.charge;
-        PUT_DB_ASSET(prod, bp);
+        credit_asset(context, address(prod), evt_sym(), pcact.charge);
     }
     EVT_CAPTURE_AND_RETHROW(tx_apply_exception);
 }
@@ -1550,8 +1709,9 @@ EVT_ACTION_IMPL_BEGIN(prodvote) {
 
         DECLARE_TOKEN_DB()
 
-        auto updact = false;
-        auto act    = name();
+        auto updact  = false;
+        auto updcomp = false;
+        auto act     = name();
 
         // test if it's action-upgrade vote and wheather action is valid
         {
@@ -1570,6 +1730,13 @@ EVT_ACTION_IMPL_BEGIN(prodvote) {
                     "Provided version: {} for action: {} is not valid, should be in range ({},{}]", pvact.value, act, cver, mver);
                 updact = true;
             }
+            else if(pvact.key == N128(trx-compression)) {
+                // transaction compression is upgraded the same way as action versions
+                auto cver = context.control.get_max_trx_compression();
+                EVT_ASSERT2(pvact.value >= cver && pvact.value <= packed_transaction::zstd, prodvote_value_exception,
+                    "Provided compression: {} is not valid, should be in range [{},{}]", pvact.value, cver, (int)packed_transaction::zstd);
+                updcomp = true;
+            }
         }
 
         auto pkey = sche.get_producer_key(pvact.producer);
@@ -1621,7 +1788,7 @@ EVT_ACTION_IMPL_BEGIN(prodvote) {
             }
         }
 
-        if(!updact) {
+        if(!updact && !updcomp) {
             // general global config updates, find the median and update
             int64_t nv = 0;
 
@@ -1646,10 +1813,10 @@ EVT_ACTION_IMPL_BEGIN(prodvote) {
             context.control.set_chain_config(conf);
         }
         else {
-            // update action version
+            // update action version or transaction compression
             // find the all the votes which vote-version is large than current version
             // and update version with the version which has more than 2/3 votes of producers
-            auto cver = exec_ctx.get_current_version(act);
+            auto cver = updact ? exec_ctx.get_current_version(act) : context.control.get_max_trx_compression();
             auto map  = flat_map<int, int>();  // maps version to votes
             for(auto& v : values) {
                 if(v > cver) {
@@ -1658,7 +1825,12 @@ EVT_ACTION_IMPL_BEGIN(prodvote) {
             }
             for(auto& it : map) {
                 if(it.second >= limit) {
-                    exec_ctx.set_version(act, it.first);
+                    if(updact) {
+                        exec_ctx.set_version(act, it.first);
+                    }
+                    else {
+                        context.control.set_max_trx_compression(it.first);
+                    }
                     break;
                 }
             }
@@ -1963,6 +2135,17 @@ auto get_percent_string = [](auto& per) {
     return fmt::format("{} %", p.str(5));
 };
 
+// floor(p * amount), percents of v2 rules are fixed-point and go without decimal math
+int64_t
+percent_floor(const percent_slim& p, int64_t amount) {
+    return p.floor_of(amount);
+}
+
+int64_t
+percent_floor(const percent_type& p, int64_t amount) {
+    return (int64_t)boost::multiprecision::floor(p * real_type(amount));
+}
+
 template<typename T>
 void
 check_bonus_rules(const token_database& tokendb, const T& rules, asset amount) {
@@ -1998,7 +2181,7 @@ check_bonus_rules(const token_database& tokendb, const T& rules, asset amount) {
             // check valid precent
             EVT_ASSERT2(p > 0 && p <= 1, bonus_percent_value_exception,
                 "Rule #{} is not valid, precent value should be in range (0,1]", index);
-            auto prv = (int64_t)boost::multiprecision::floor(p * real_type(amount.amount()));
+            auto prv = percent_floor(pr.percent, amount.amount());
             // check large than remain
             EVT_ASSERT2(prv <= remain, bonus_rules_exception,
                 "Rule #{} is not valid, its required amount: {} is large than remainning: {}", index, asset(prv, sym), asset(remain, sym));
@@ -2017,7 +2200,7 @@ check_bonus_rules(const token_database& tokendb, const T& rules, asset amount) {
             auto p = (percent_type)pr.percent;
             // check valid precent
             EVT_ASSERT2(p > 0 && p <= 1, bonus_percent_value_exception, "Precent value should be in range (0,1]");
-            auto prv = (int64_t)boost::multiprecision::floor(p * real_type(remain));
+            auto prv = percent_floor(pr.percent, remain);
             // check percent result is large than minial unit of asset
             EVT_ASSERT2(prv >= 1, bonus_percent_result_exception,
                 "Rule #{} is not valid, the amount for this rule shoule be as least large than one unit of asset, but it's zero now.", index);
@@ -2205,28 +2388,80 @@ public:
     symbol_id_type  sym_id;
     holder_slim_map slim;
     holder_coll_map coll;
-    int64_t         total;
+    int64_t         total = 0;
 };
 
-void
-build_holder_dist(const token_database& tokendb, symbol sym, holder_dist& dist) {
+// it still visits every holder of the symbol, what's saved is unpacking the values
+// keeping an aggregate of holders up to date on every transfer isn't done, the distribution
+// packs the amount of every holder anyway
+//
+// the scan resumes after `cursor` and stops once `limit` holders are visited, 0 for no limit
+// `frozen` may replace the amount read of a holder by its key, returns the number of holders visited
+using frozen_amount_func = std::function<void(const std::string_view&, int64_t&)>;
+
+uint32_t
+build_holder_dist(const token_database& tokendb, symbol sym, holder_dist& dist, std::string& cursor, uint32_t limit,
+                  const frozen_amount_func& frozen) {
+    static_assert(std::is_same_v<decltype(property::amount), int64_t>);
+
+    auto n = 0u;
+
     dist.sym_id = sym.id();
-    tokendb.read_assets_range(sym.id(), 0, [&dist](auto& k, auto&& v) {
-        property prop;
-        extract_db_value(v, prop);
+    tokendb.read_assets_range(sym.id(), cursor, [&dist, &n, limit, &frozen](auto& k, auto&& v) {
+        // amount is the first field of a packed property, the rest is not needed here
+        auto amount = int64_t();
+        EVT_ASSERT(v.size() >= sizeof(amount), token_database_exception, "Invalid property value of asset");
+        memcpy(&amount, v.data(), sizeof(amount));
+        if(frozen) {
+            frozen(k, amount);
+        }
 
         auto h  = fc::city_hash32(k.data(), k.size());
-        auto it = dist.slim.emplace(h, prop.amount);
+        auto it = dist.slim.emplace(h, amount);
         if(it.second == false) {
             // meet collision
-            dist.coll.emplace(std::string(k.data(), k.size()), prop.amount);
+            dist.coll.emplace(std::string(k.data(), k.size()), amount);
         }
-        dist.total += prop.amount;
+        dist.total += amount;
 
-        return true;
+        return ++n != limit;
     });
+    return n;
 };
 
+void
+build_holder_dist(const token_database& tokendb, symbol sym, holder_dist& dist) {
+    auto cursor = std::string();
+    build_holder_dist(tokendb, sym, dist, cursor, 0, nullptr);
+}
+
+// receiver of the rule when it's the holders of a FT
+std::optional<dist_stack_receiver>
+get_ftholders_receiver(const dist_rule_v2& rule) {
+    auto ftrev = std::optional<dist_stack_receiver>();
+
+    switch(rule.type()) {
+    case dist_rule_type::fixed: {
+        auto& fr = rule.get<dist_fixed_rule>();
+        if(fr.receiver.type() == dist_receiver_type::ftholders) {
+            ftrev = fr.receiver.get<dist_stack_receiver>();
+        }
+        break;
+    }
+    case dist_rule_type::percent:
+    case dist_rule_type::remaining_percent: {
+        rule.visit([&ftrev](auto& pr) {
+            if(pr.receiver.type() == dist_receiver_type::ftholders) {
+                ftrev = pr.receiver.template get<dist_stack_receiver>();
+            }
+        });
+        break;
+    }
+    }  // switch
+
+    return ftrev;
+}
+
 using holder_dists = small_vector<holder_dist, 4>;
 
 struct bonusdist {
@@ -2238,6 +2473,13 @@ struct bonusdist {
     optional<address> final_receiver;
 };
 
+// holders scanned by one `distpsvbonus` v2 action, each dist is a part of the holders of its rule
+// the holders of a round are the ones of all its chunks, in the order of chunks
+struct bonusdist_chunk {
+    small_vector<uint32_t, 4> rules;  // indexes of the rules of dists
+    holder_dists              holders;
+};
+
 name128
 get_psvbonus_dist_db_key(uint64_t sym_id, uint64_t round) {
     uint128_t v = round;
@@ -2245,6 +2487,12 @@ get_psvbonus_dist_db_key(uint64_t sym_id, uint64_t round) {
     return v;
 }
 
+// chunks are numbered from 1, round itself is keyed as chunk 0
+name128
+get_psvbonus_chunk_db_key(uint64_t sym_id, uint32_t round, uint32_t chunk) {
+    return get_psvbonus_dist_db_key(sym_id, ((uint64_t)chunk << 32) | round);
+}
+
 }  // namespace internal
 
 EVT_ACTION_IMPL_BEGIN(distpsvbonus) {
@@ -2263,55 +2511,175 @@ EVT_ACTION_IMPL_BEGIN(distpsvbonus) {
 
         auto sym = pb->dist_threshold.sym();
 
-        property pbonus;
-        READ_DB_ASSET_NO_THROW(get_psvbonus_address(spbact.sym_id, 0), sym, pbonus);
-        EVT_ASSERT2(pbonus.amount >= pb->dist_threshold.amount(), bonus_unreached_dist_threshold,
-            "Distribution threshold: {} is unreached, current: {}", pb->dist_threshold, asset(pbonus.amount, sym));
+        auto start_round = [&] {
+            property pbonus;
+            READ_DB_ASSET_NO_THROW(get_psvbonus_address(spbact.sym_id, 0), sym, pbonus);
+            EVT_ASSERT2(pbonus.amount >= pb->dist_threshold.amount(), bonus_unreached_dist_threshold,
+                "Distribution threshold: {} is unreached, current: {}", pb->dist_threshold, asset(pbonus.amount, sym));
 
-        auto bd = bonusdist();
-        for(auto& rule : pb->rules) {
-            auto ftrev = std::optional<dist_stack_receiver>();
+            pb->round++;
+            pb->deadline = spbact.deadline;
+            UPD_DB_TOKEN(token_type::psvbonus, *pb);
+            return pbonus;
+        };
 
-            switch(rule.type()) {
-            case dist_rule_type::fixed: {
-                auto& fr = rule.template get<dist_fixed_rule>();
-                if(fr.receiver.type() == dist_receiver_type::ftholders) {
-                    ftrev = fr.receiver.template get<dist_stack_receiver>();
+        auto transfer_bonus = [&](auto& pbonus) {
+            // transfer all the FTs from cllected address to distribute address of current round
+            transfer_fungible(context, get_psvbonus_address(spbact.sym_id, 0), get_psvbonus_address(spbact.sym_id, pb->round), asset(pbonus.amount, pbonus.sym), N(distpsvbonus), false /* pay bonus */);
+        };
+
+        if constexpr(EVT_ACTION_VER() == 1) {
+            auto pbonus = start_round();
+
+            auto bd = bonusdist();
+            for(auto& rule : pb->rules) {
+                auto ftrev = get_ftholders_receiver(rule);
+                if(ftrev.has_value()) {
+                    // each rule scans on its own, a copied map may be laid out and so packed differently
+                    auto dist = holder_dist();
+                    build_holder_dist(tokendb, ftrev->threshold.sym(), dist);
+                    bd.holders.emplace_back(std::move(dist));
                 }
-                break;
             }
-            case dist_rule_type::percent:
-            case dist_rule_type::remaining_percent: {
-                rule.visit([&ftrev](auto& pr) {
-                    if(pr.receiver.type() == dist_receiver_type::ftholders) {
-                        ftrev = pr.receiver.template get<dist_stack_receiver>();
+
+            bd.created_at     = context.control.pending_block_time().sec_since_epoch();
+            bd.created_index  = context.get_index_of_trx();
+            bd.deadline       = spbact.deadline;
+            bd.final_receiver = spbact.final_receiver;
+
+            auto dbv = make_db_value(bd);
+            tokendb_cache.put_token(token_type::psvbonus_dist, action_op::add, std::nullopt, get_psvbonus_db_key(spbact.sym_id, pb->round), dbv);
+
+            transfer_bonus(pbonus);
+        }
+        else {
+            auto build_key = get_psvbonus_db_key(spbact.sym_id, kPsvBonusBuild);
+
+            auto bb = make_empty_cache_ptr<passive_bonus_build>();
+            READ_DB_TOKEN_NO_THROW(token_type::psvbonus, std::nullopt, build_key, bb);
+
+            // holders of each symbol scanned are frozen while the round is being built, see `freeze_holder`
+            auto update_freezes = [&](bool add) {
+                for(auto i = 0u; i < pb->rules.size(); i++) {
+                    auto ftrev = get_ftholders_receiver(pb->rules[i]);
+                    if(!ftrev.has_value()) {
+                        continue;
                     }
-                });
-                break;
+
+                    auto fkey = get_psvbonus_db_key(ftrev->threshold.sym().id(), kPsvBonusFreeze);
+                    auto fz   = make_empty_cache_ptr<passive_bonus_freeze>();
+                    READ_DB_TOKEN_NO_THROW(token_type::psvbonus, std::nullopt, fkey, fz);
+                    if(fz == nullptr) {
+                        if(add) {
+                            auto nf = passive_bonus_freeze();
+                            nf.rounds.emplace_back(frozen_round { .sym_id = spbact.sym_id, .last_rule = i });
+                            tokendb_cache.put_token(token_type::psvbonus, action_op::add, std::nullopt, fkey, nf);
+                        }
+                        continue;
+                    }
+
+                    auto it = std::find_if(fz->rounds.begin(), fz->rounds.end(), [&](auto& fr) { return fr.sym_id == spbact.sym_id; });
+                    if(!add) {
+                        if(it != fz->rounds.end()) {
+                            fz->rounds.erase(it);
+                            tokendb_cache.put_token(token_type::psvbonus, action_op::put, std::nullopt, fkey, *fz);
+                        }
+                        continue;
+                    }
+                    if(it != fz->rounds.end()) {
+                        // rules are visited in order, the last one of the symbol is kept
+                        it->last_rule = i;
+                    }
+                    else {
+                        fz->rounds.emplace_back(frozen_round { .sym_id = spbact.sym_id, .last_rule = i });
+                    }
+                    tokendb_cache.put_token(token_type::psvbonus, action_op::put, std::nullopt, fkey, *fz);
+                }
+            };
+
+            if(bb == nullptr || bb->round == 0) {
+                // the amount of a round is fixed once it starts, charges later go to the next one
+                auto pbonus = start_round();
+
+                auto nb = passive_bonus_build();
+                auto& b = (bb != nullptr) ? *bb : nb;
+
+                b.round          = pb->round;
+                b.created_at     = context.control.pending_block_time().sec_since_epoch();
+                b.created_index  = context.get_index_of_trx();
+                b.deadline       = spbact.deadline;
+                b.final_receiver = spbact.final_receiver;
+                b.rule_index     = 0;
+                b.cursor.clear();
+                b.chunks         = 0;
+                b.totals.assign(pb->rules.size(), 0);
+
+                tokendb_cache.put_token(token_type::psvbonus, action_op::put, std::nullopt, build_key, b);
+                if(bb == nullptr) {
+                    READ_DB_TOKEN_NO_THROW(token_type::psvbonus, std::nullopt, build_key, bb);
+                }
+
+                // holders are frozen before any of them is changed, the bonus moved included
+                update_freezes(true);
+                transfer_bonus(pbonus);
             }
-            }  // switch
 
-            if(ftrev.has_value()) {
+            auto& b = *bb;
+
+            // the amount of a holder changed in the round is the one it had when the round started
+            auto hsym   = symbol();
+            auto frozen = [&](auto& k, auto& amount) {
+                auto fh = make_empty_cache_ptr<frozen_holder>();
+                READ_DB_TOKEN_NO_THROW(token_type::psvbonus_dist, get_frozen_holder_prefix(k), get_frozen_holder_db_key(spbact.sym_id, hsym.id(), b.round), fh);
+                if(fh != nullptr) {
+                    amount = fh->amount;
+                }
+            };
+
+            auto chunk = bonusdist_chunk();
+            auto left  = spbact.max_holders;
+            for(; b.rule_index < pb->rules.size(); b.rule_index++, b.cursor.clear()) {
+                auto ftrev = get_ftholders_receiver(pb->rules[b.rule_index]);
+                if(!ftrev.has_value()) {
+                    continue;
+                }
+
+                hsym = ftrev->threshold.sym();
+
                 auto dist = holder_dist();
-                build_holder_dist(tokendb, ftrev->threshold.sym(), dist);
-                bd.holders.emplace_back(std::move(dist));
+                auto n    = build_holder_dist(tokendb, hsym, dist, b.cursor, left, frozen);
+                if(n > 0) {
+                    b.totals[b.rule_index] += dist.total;
+                    chunk.rules.emplace_back(b.rule_index);
+                    chunk.holders.emplace_back(std::move(dist));
+                }
+
+                if(left > 0 && (left -= n) == 0) {
+                    // the rule may have more holders, next action resumes after the cursor
+                    break;
+                }
             }
-        }
 
-        bd.created_at     = context.control.pending_block_time().sec_since_epoch();
-        bd.created_index  = context.get_index_of_trx();
-        bd.deadline       = spbact.deadline;
-        bd.final_receiver = spbact.final_receiver;
+            if(!chunk.rules.empty()) {
+                b.chunks++;
 
-        pb->round++;
-        pb->deadline = spbact.deadline;
-        UPD_DB_TOKEN(token_type::psvbonus, *pb);
+                auto dbv = make_db_value(chunk);
+                tokendb_cache.put_token(token_type::psvbonus_dist, action_op::add, std::nullopt, get_psvbonus_chunk_db_key(spbact.sym_id, b.round, b.chunks), dbv);
+            }
 
-        auto dbv = make_db_value(bd);
-        tokendb_cache.put_token(token_type::psvbonus_dist, action_op::add, std::nullopt, get_psvbonus_db_key(spbact.sym_id, pb->round), dbv);
+            if(b.rule_index == pb->rules.size()) {
+                // the state done is kept as the summary of round, its holders are in the chunks
+                auto dbv = make_db_value(b);
+                tokendb_cache.put_token(token_type::psvbonus_dist, action_op::add, std::nullopt, get_psvbonus_chunk_db_key(spbact.sym_id, b.round, 0), dbv);
 
-        // transfer all the FTs from cllected address to distribute address of current round
-        transfer_fungible(context, get_psvbonus_address(spbact.sym_id, 0), get_psvbonus_address(spbact.sym_id, pb->round), asset(pbonus.amount, pbonus.sym), N(distpsvbonus), false /* pay bonus */);
+                update_freezes(false);
+
+                b.round = 0;
+                b.cursor.clear();
+            }
+
+            tokendb_cache.put_token(token_type::psvbonus, action_op::put, std::nullopt, build_key, b);
+        }
     }
     EVT_CAPTURE_AND_RETHROW(tx_apply_exception);
 }
@@ -2321,3 +2689,4 @@ EVT_ACTION_IMPL_END()
 
 FC_REFLECT(evt::chain::contracts::internal::holder_dist, (sym_id)(slim)(coll)(total));
 FC_REFLECT(evt::chain::contracts::internal::bonusdist, (created_at)(created_index)(holders)(deadline)(final_receiver));
+FC_REFLECT(evt::chain::contracts::internal::bonusdist_chunk, (rules)(holders));
@@ -54,6 +54,16 @@ public:
     using segments_type   = fc::flat_map<uint8_t, segment, std::less<uint8_t>, fc::small_vector<std::pair<uint8_t, segment>, 6>>;
     using signatures_type = fc::flat_set<signature_type, std::less<signature_type>, fc::small_vector<signature_type, 2>>;
 
+    // counters of the process wide caches of parsed links and restored keys
+    struct cache_stats {
+        uint64_t parse_hits   = 0;
+        uint64_t parse_misses = 0;
+        uint64_t keys_hits    = 0;
+        uint64_t keys_misses  = 0;
+    };
+
+    static constexpr size_t kDefaultCacheSize = 10000;
+
 public:
     static evt_link parse_from_evtli(const std::string& str);
     std::string to_string(int prefix = 0) const;
@@ -80,6 +90,11 @@ public:
     fc::sha256 digest() const;
     public_keys_set restore_keys() const;
 
+public:
+    // links kept by each cache, 0 disables both of them
+    static void set_cache_size(size_t size);
+    static cache_stats get_cache_stats();
+
 private:
     uint16_t        header_;
     segments_type   segments_;
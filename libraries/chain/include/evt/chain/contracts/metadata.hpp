@@ -3,6 +3,7 @@
  *  @copyright defined in evt/LICENSE.txt
  */
 #pragma once
+#include <fc/crypto/sha256.hpp>
 #include <evt/chain/types.hpp>
 #include <evt/chain/contracts/authorizer_ref.hpp>
 
@@ -24,6 +25,25 @@ struct meta {
 };
 using meta_list = small_vector<meta, 4>;
 
+// metas kept apart from domains, fungibles and groups are keyed by the hash of their parent
+// in the low half and the hash of meta key in the high half, the low half comes first in db
+// so metas of the same parent are adjacent and can be read by the prefix of their keys.
+// `parent_type` is `.domain`, `.fungible` or `.group`
+inline uint64_t
+get_meta_db_key_prefix(const name128& parent_type, const name128& parent) {
+    auto enc = fc::sha256::encoder();
+    fc::raw::pack(enc, parent_type);
+    fc::raw::pack(enc, parent);
+    return enc.result()._hash[0];
+}
+
+inline name128
+get_meta_db_key(const name128& parent_type, const name128& parent, const meta_key& key) {
+    uint128_t v = get_meta_db_key_prefix(parent_type, parent);
+    v |= ((uint128_t)fc::sha256::hash(key)._hash[0] << 64);
+    return v;
+}
+
 }}}  // namespac evt::chain::contracts
 
 FC_REFLECT(evt::chain::contracts::meta, (key)(value)(creator));
@@ -0,0 +1,72 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+
+#include <array>
+#include <cstring>
+#include <string_view>
+#include <type_traits>
+#include <evt/chain/token_database.hpp>
+#include <evt/chain/contracts/types.hpp>
+
+namespace evt { namespace chain { namespace contracts {
+
+/**
+ * Packed form of a `property`, the value of one balance in the assets column family
+ *
+ * Every field of a property has a fixed width and fc::raw packs them one after another in native
+ * order, so a balance is always 24 bytes: amount, symbol, created_at and created_index. A record
+ * copies the fields in and out directly instead of going through a datastream and a `db_value`.
+ */
+class property_record {
+public:
+    static constexpr size_t kSize = sizeof(int64_t) + sizeof(uint64_t) + sizeof(uint32_t) * 2;
+
+public:
+    property_record() = default;
+
+    explicit property_record(const property& p) {
+        auto ptr = data_.data();
+        memcpy(ptr, &p.amount, sizeof(p.amount));
+        memcpy(ptr + 8, &p.sym, sizeof(p.sym));
+        memcpy(ptr + 16, &p.created_at, sizeof(p.created_at));
+        memcpy(ptr + 20, &p.created_index, sizeof(p.created_index));
+    }
+
+public:
+    // values of any other size are unpacked by fc::raw
+    static void
+    extract(const std::string& v, property& p) {
+        if(v.size() != kSize) {
+            extract_db_value(v, p);
+            return;
+        }
+
+        auto ptr = v.data();
+        memcpy(&p.sym, ptr + 8, sizeof(p.sym));
+        if(!p.sym.valid()) {
+            // let fc::raw reject the invalid symbol
+            extract_db_value(v, p);
+            return;
+        }
+
+        memcpy(&p.amount, ptr, sizeof(p.amount));
+        memcpy(&p.created_at, ptr + 16, sizeof(p.created_at));
+        memcpy(&p.created_index, ptr + 20, sizeof(p.created_index));
+    }
+
+public:
+    std::string_view as_string_view() const { return std::string_view(data_.data(), data_.size()); }
+
+private:
+    std::array<char, kSize> data_;
+};
+
+static_assert(std::is_same_v<decltype(property::amount), int64_t>);
+static_assert(std::is_same_v<decltype(property::created_at), uint32_t>);
+static_assert(std::is_same_v<decltype(property::created_index), uint32_t>);
+static_assert(sizeof(symbol) == sizeof(uint64_t) && std::is_trivially_copyable_v<symbol>);
+
+}}}  // namespace evt::chain::contracts
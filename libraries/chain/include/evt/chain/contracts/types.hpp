@@ -317,6 +317,35 @@ struct passive_bonus_slim {
     passive_methods   methods;
 };
 
+// round of a distribution built in chunks by `distpsvbonus` v2, kept between the actions
+// a round is done once the holders of its last rule are scanned, then `round` is reset to 0
+struct passive_bonus_build {
+    uint32_t                 round;          // round being built, 0 when none is
+    uint32_t                 created_at;
+    uint32_t                 created_index;
+    time_point_sec           deadline;
+    optional<address>        final_receiver;
+    uint32_t                 rule_index;     // rule whose holders are being scanned
+    std::string              cursor;         // key of the last holder scanned of that rule
+    uint32_t                 chunks;         // chunks of holders written
+    small_vector<int64_t, 4> totals;         // amounts of the holders as of the start of round for each rule
+};
+
+struct frozen_round {
+    symbol_id_type sym_id;     // symbol of the passive bonus
+    uint32_t       last_rule;  // last rule scanning the holders
+};
+
+// rounds being built which scan the holders of a symbol
+struct passive_bonus_freeze {
+    small_vector<frozen_round, 2> rounds;
+};
+
+// amount of a holder as of the start of a round, kept when it's changed before being scanned
+struct frozen_holder {
+    int64_t amount;
+};
+
 struct newdomain {
     domain_name name;
     user_id     creator;
@@ -474,6 +503,15 @@ struct addmeta {
     EVT_ACTION_VER1(addmeta);
 };
 
+// metas of domains, fungibles and groups are kept apart from them
+struct addmeta_v2 {
+    meta_key       key;
+    meta_value     value;
+    authorizer_ref creator;
+
+    EVT_ACTION_VER2(addmeta, addmeta_v2);
+};
+
 struct newsuspend {
     proposal_name name;
     user_id       proposer;
@@ -624,6 +662,17 @@ struct distpsvbonus {
     EVT_ACTION_VER1(distpsvbonus);
 };
 
+// holders are scanned in chunks of `max_holders` by repeated actions, 0 for all of them at once
+// the first one starts the round and the others continue it until all the holders are scanned
+struct distpsvbonus_v2 {
+    symbol_id_type    sym_id;
+    time_point        deadline;
+    optional<address> final_receiver;
+    uint32_t          max_holders;
+
+    EVT_ACTION_VER2(distpsvbonus, distpsvbonus_v2);
+};
+
 struct recvpsvbonus {
     symbol_id_type                   sym_id;
     small_vector<public_key_type, 2> receivers;
@@ -665,6 +714,10 @@ FC_REFLECT_ENUM(evt::chain::contracts::passive_method_type, (within_amount)(outs
 FC_REFLECT(evt::chain::contracts::passive_method, (action)(method));
 FC_REFLECT(evt::chain::contracts::passive_bonus, (sym_id)(rate)(base_charge)(charge_threshold)(minimum_charge)(dist_threshold)(rules)(methods)(round)(deadline));
 FC_REFLECT(evt::chain::contracts::passive_bonus_slim, (sym_id)(rate)(base_charge)(charge_threshold)(minimum_charge)(methods));
+FC_REFLECT(evt::chain::contracts::passive_bonus_build, (round)(created_at)(created_index)(deadline)(final_receiver)(rule_index)(cursor)(chunks)(totals));
+FC_REFLECT(evt::chain::contracts::frozen_round, (sym_id)(last_rule));
+FC_REFLECT(evt::chain::contracts::passive_bonus_freeze, (rounds));
+FC_REFLECT(evt::chain::contracts::frozen_holder, (amount));
 
 FC_REFLECT(evt::chain::contracts::newdomain, (name)(creator)(issue)(transfer)(manage));
 FC_REFLECT(evt::chain::contracts::issuetoken, (domain)(names)(owner));
@@ -683,6 +736,7 @@ FC_REFLECT(evt::chain::contracts::recycleft, (address)(number)(memo));
 FC_REFLECT(evt::chain::contracts::destroyft, (address)(number)(memo));
 FC_REFLECT(evt::chain::contracts::evt2pevt, (from)(to)(number)(memo));
 FC_REFLECT(evt::chain::contracts::addmeta, (key)(value)(creator));
+FC_REFLECT(evt::chain::contracts::addmeta_v2, (key)(value)(creator));
 FC_REFLECT(evt::chain::contracts::newsuspend, (name)(proposer)(trx));
 FC_REFLECT(evt::chain::contracts::cancelsuspend, (name));
 FC_REFLECT(evt::chain::contracts::aprvsuspend, (name)(signatures));
@@ -701,3 +755,4 @@ FC_REFLECT(evt::chain::contracts::tryunlock, (name)(executor));
 FC_REFLECT(evt::chain::contracts::setpsvbonus, (sym)(rate)(base_charge)(charge_threshold)(minimum_charge)(dist_threshold)(rules)(methods));
 FC_REFLECT(evt::chain::contracts::setpsvbonus_v2, (sym_id)(rate)(base_charge)(charge_threshold)(minimum_charge)(dist_threshold)(rules)(methods));
 FC_REFLECT(evt::chain::contracts::distpsvbonus, (sym_id)(deadline)(final_receiver));
+FC_REFLECT(evt::chain::contracts::distpsvbonus_v2, (sym_id)(deadline)(final_receiver)(max_holders));
@@ -7,24 +7,33 @@
 #include <functional>
 #include <map>
 #include <boost/signals2/signal.hpp>
+#include <evt/chain/block_log.hpp>
 #include <evt/chain/block_state.hpp>
 #include <evt/chain/genesis_state.hpp>
 #include <evt/chain/token_database.hpp>
 #include <evt/chain/execution_context.hpp>
+#include <evt/utilities/fixed_signal.hpp>
 
 namespace chainbase {
 class database;
 }
 
+namespace evt { namespace utilities {
+class task_scheduler;
+}}  // namespace evt::utilities
+
 namespace evt { namespace chain {
 
 using unapplied_transactions_type = map<transaction_id_type, transaction_metadata_ptr>;
 
 class fork_database;
+class reversible_block_store;
+class trx_index;
 class apply_context;
 class charge_manager;
 class execution_context;
 class token_database_cache;
+class authority_memo;
 
 struct controller_impl;
 using boost::signals2::signal;
@@ -36,6 +45,8 @@ class global_property_object;
 class snapshot_writer;
 class snapshot_reader;
 
+struct action_cost;
+
 namespace contracts {
 struct abi_serializer;
 struct evt_link_object;
@@ -56,32 +67,69 @@ enum class validation_mode {
     LIGHT
 };
 
+/**
+ *  When the irreversible blocks in block log and the states of token database are synced to the disk.
+ *  STRICT syncs every block, GROUP syncs blocks together, RELAXED leaves it to the OS until shutdown.
+ */
+enum class durability_mode {
+    STRICT,
+    GROUP,
+    RELAXED
+};
+
+/**
+ *  Changes of the tokens and assets made by one transaction, or by the block itself when `trx_id`
+ *  is empty, in the order they are applied. Changes of a block are reverted altogether.
+ */
+struct token_changes {
+    uint32_t                     block_num;
+    transaction_id_type          trx_id;
+    token_database::token_deltas deltas;
+};
+using token_changes_ptr = std::shared_ptr<const token_changes>;
+
 class controller {
 public:
     struct config {
         path     blocks_dir             = chain::config::default_blocks_dir_name;
         path     state_dir              = chain::config::default_state_dir_name;
+        path     checkpoints_dir        = chain::config::default_checkpoints_dir_name;
         uint64_t state_size             = chain::config::default_state_size;
         uint64_t state_guard_size       = chain::config::default_state_guard_size;
         uint64_t reversible_cache_size  = chain::config::default_reversible_cache_size;
         uint64_t reversible_guard_size  = chain::config::default_reversible_guard_size;
         bool     read_only              = false;
+        bool     state_hugepages        = false;  ///< advises the kernel to back the mapped state with huge pages
         bool     force_all_checks       = false;
         bool     disable_replay_opts    = false;
         bool     loadtest_mode          = false;
         bool     charge_free_mode       = false;
         bool     contracts_console      = false;
+        uint16_t thread_pool_size       = chain::config::default_controller_thread_pool_size;
+        uint32_t fork_db_retention      = chain::config::default_fork_db_retention_window;
+        uint32_t expired_trxs_cleanup   = chain::config::default_expired_trxs_cleanup_rows;  ///< expired transactions erased at most at the start of one block, 0 for all
+        uint32_t checkpoint_interval    = chain::config::default_checkpoint_interval;
+        uint32_t checkpoints_to_keep    = chain::config::default_checkpoints_to_keep;
+        uint32_t replay_stop_block      = 0;  ///< replay stops after this block and startup throws node_management_success, 0 to replay all
+        uint32_t blocks_retained        = 0;  ///< latest irreversible blocks kept in block log, older segments are removed, 0 to keep all
+        uint32_t group_commit_blocks    = chain::config::default_group_commit_blocks;  ///< see `durability_mode::GROUP`
+        uint32_t group_commit_ms        = chain::config::default_group_commit_ms;      ///< see `durability_mode::GROUP`
+        bool     trx_index              = false;  ///< index transactions of irreversible blocks by their ids, see `trx_index`
 
         std::chrono::microseconds max_serialization_time = std::chrono::milliseconds(chain::config::default_abi_serializer_max_time_ms);
 
         db_read_mode    read_mode             = db_read_mode::SPECULATIVE;
         validation_mode block_validation_mode = validation_mode::FULL;
+        durability_mode durability            = durability_mode::STRICT;
 
         flat_set<account_name> trusted_producers;
 
+        std::vector<uint32_t> thread_pool_cpus;  ///< cpus the workers of the task scheduler are pinned to, empty to not pin them
+
         token_database::config db_config;
 
         genesis_state genesis;
+        path          genesis_initial_state;  ///< initial state declared by the genesis, see `genesis_initial_state`
     };
 
     enum class block_status {
@@ -95,7 +143,8 @@ public:
     ~controller();
 
     void add_indices();
-    void startup(const std::shared_ptr<snapshot_reader>& snapshot = nullptr);
+    // `diffs` are the differential snapshots taken after `snapshot` in order, they're applied onto it
+    void startup(const std::shared_ptr<snapshot_reader>& snapshot = nullptr, const std::vector<std::shared_ptr<snapshot_reader>>& diffs = {});
 
     /**
      * Starts a new pending block session upon which new transactions can
@@ -119,6 +168,12 @@ public:
     transaction_trace_ptr push_transaction(const transaction_metadata_ptr& trx, fc::time_point deadline);
     transaction_trace_ptr push_suspend_transaction(const transaction_metadata_ptr& trx, fc::time_point deadline);
 
+    /**
+     *  Pushes transactions in order with one shared deadline, the returned traces match the leading
+     *  transactions of the batch, the ones left over were not pushed because the deadline was exceeded
+     */
+    std::vector<transaction_trace_ptr> push_transactions(const std::vector<transaction_metadata_ptr>& trxs, fc::time_point deadline);
+
     void check_authorization(const public_keys_set& signed_keys, const transaction& trx);
     void check_authorization(const public_keys_set& signed_keys, const action& act);
 
@@ -127,17 +182,42 @@ public:
     void commit_block();
     void pop_block();
 
+    // a speculative pending block is kept and extended when it's the beginning of `b`, it's aborted otherwise
     void push_block(const signed_block_ptr& b);
 
+    /**
+     *  Checks of `b` not depending on the chain state: its header on top of `prev`, its producer
+     *  signature against the schedule of `prev` and the merkle root of its receipts. Safe to be
+     *  called from other threads, the result is handed to `push_block` by `add_verified_block`.
+     */
+    static block_state_ptr verify_block(const block_header_state& prev, const signed_block_ptr& b);
+    // `push_block` of the block of `bsp` takes its header state instead of checking it again
+    void add_verified_block(const block_state_ptr& bsp);
+
+    /**
+     *  Header state of the block log head before `startup`, the irreversible blocks fetched from
+     *  peers are verified on top of it and appended by `append_block_log`, startup replays them.
+     *  A chain starting from a snapshot passes its head as `snapshot_head`. Nothing when the log
+     *  cannot be extended, like when reversible blocks are kept after its head.
+     */
+    optional<block_header_state> block_log_head_state(const optional<block_header_state>& snapshot_head) const;
+    void                         append_block_log(const std::vector<signed_block_ptr>& blocks);
+
     chainbase::database& db() const;
+    reversible_block_store& reversible_blocks() const;
+    const trx_index* get_trx_index() const;  ///< null when it's not enabled
     fork_database& fork_db() const;
     token_database& token_db() const;
     token_database_cache& token_db_cache() const;
+    authority_memo&       get_authority_memo() const;
 
     charge_manager get_charge_manager() const;
 
     execution_context& get_execution_context() const;
 
+    // execution costs of the actions applied in the last 10 to 20 minutes, by name and version
+    std::vector<action_cost> get_action_costs() const;
+
     const global_property_object&         get_global_properties() const;
     const dynamic_global_property_object& get_dynamic_global_properties() const;
 
@@ -163,10 +243,15 @@ public:
 
     uint32_t      last_irreversible_block_num() const;
     block_id_type last_irreversible_block_id() const;
+    // first block which can still be fetched, older ones are pruned from block log
+    uint32_t      earliest_available_block_num() const;
 
     signed_block_ptr fetch_block_by_number(uint32_t block_num) const;
     signed_block_ptr fetch_block_by_id(block_id_type id) const;
 
+    // packed irreversible block from block log, empty if block is not there
+    block_log::serialized_block fetch_serialized_block_by_number(uint32_t block_num) const;
+
     block_state_ptr fetch_block_state_by_number(uint32_t block_num) const;
     block_state_ptr fetch_block_state_by_id(block_id_type id) const;
 
@@ -176,6 +261,8 @@ public:
 
     fc::sha256 calculate_integrity_hash() const;
     void write_snapshot(const std::shared_ptr<snapshot_writer>& snapshot) const;
+    // writes only the changes since `bases`, which are a full snapshot followed by the diffs taken after it in order
+    void write_diff_snapshot(const std::shared_ptr<snapshot_writer>& snapshot, const std::vector<std::shared_ptr<snapshot_reader>>& bases) const;
 
     bool is_producing_block() const;
 
@@ -186,11 +273,19 @@ public:
 
     bool is_known_unexpired_transaction(const transaction_id_type& id) const;
 
+    // erases at most `max_rows` expired transactions from the deduplication list in the pending block,
+    // returns the number of erased ones, less than `max_rows` means none is left
+    uint32_t clear_expired_transactions(uint32_t max_rows);
+
     int64_t set_proposed_producers(vector<producer_key> producers);
     void    set_chain_config(const chain_config&);
     void    set_action_versions(vector<action_ver> vers);
     void    set_action_version(name action, int version);
 
+    // highest compression type of transactions accepted, raised by producers' votes like action versions
+    int     get_max_trx_compression() const;
+    void    set_max_trx_compression(int compression);
+
     bool light_validation_allowed(bool replay_opts_disabled_by_policy) const;
     bool skip_auth_check() const;
     bool skip_db_sessions() const;
@@ -204,16 +299,26 @@ public:
     validation_mode get_validation_mode() const;
 
     const chain_id_type& get_chain_id() const;
+
+    // workers shared by the node for the context-free work like signature recovery,
+    // plugins post their own background work to it as well
+    utilities::task_scheduler& get_task_scheduler() const;
     const genesis_state& get_genesis_state() const;
 
     signal<void(const signed_block_ptr&)>         pre_accepted_block;
     signal<void(const block_state_ptr&)>          accepted_block_header;
-    signal<void(const block_state_ptr&)>          accepted_block;
     signal<void(const block_state_ptr&)>          irreversible_block;
-    signal<void(const transaction_metadata_ptr&)> accepted_transaction;
-    signal<void(const transaction_trace_ptr&)>    applied_transaction;
     signal<void(const int&)>                      bad_alloc;
 
+    // emitted for every block and every transaction, slots are connected at startup
+    utilities::fixed_signal<void(const block_state_ptr&)>          accepted_block;
+    utilities::fixed_signal<void(const transaction_metadata_ptr&)> accepted_transaction;
+    utilities::fixed_signal<void(const transaction_trace_ptr&)>    applied_transaction;
+
+    // only emitted when there are slots connected before startup
+    signal<void(const token_changes_ptr&)>        applied_token_changes;
+    signal<void(uint32_t)>                        reverted_token_changes;
+
     public_keys_set get_required_keys(const transaction& trx, const public_keys_set& candidate_keys) const;
     public_keys_set get_suspend_required_keys(const transaction& trx, const public_keys_set& candidate_keys) const;
     public_keys_set get_suspend_required_keys(const proposal_name& name, const public_keys_set& candidate_keys) const;
@@ -231,6 +336,7 @@ private:
 FC_REFLECT(evt::chain::controller::config,
            (blocks_dir)
            (state_dir)
+           (checkpoints_dir)
            (state_size)
            (reversible_cache_size)
            (read_only)
@@ -239,7 +345,13 @@ FC_REFLECT(evt::chain::controller::config,
            (loadtest_mode)
            (charge_free_mode)
            (contracts_console)
+           (fork_db_retention)
+           (checkpoint_interval)
+           (checkpoints_to_keep)
+           (replay_stop_block)
+           (blocks_retained)
            (trusted_producers)
+           (thread_pool_cpus)
            (db_config)
            (genesis)
            );
@@ -0,0 +1,57 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+#include <atomic>
+#include <map>
+#include <boost/noncopyable.hpp>
+#include <fc/time.hpp>
+
+namespace evt { namespace chain {
+
+/**
+ * Flag raised once a deadline has passed, checked on hot paths instead of reading the clock
+ *
+ * Running timers are watched by one thread of the process, which sleeps until the earliest
+ * deadline and raises the flags of the timers past theirs. Starting a timer only wakes that
+ * thread when its deadline is the earliest one. A flag is never raised early, it may be raised
+ * a scheduling latency late.
+ *
+ * The thread runs between `start_watchdog` and `stop_watchdog`, the controller calls them for
+ * its lifetime. Calls are counted, the last stop joins the thread. While no timer is running
+ * the thread is parked, so validating blocks without deadlines costs no wakeups.
+ *
+ * While timers are running the same thread updates `coarse_now` every millisecond, for the
+ * timestamps which don't need to be precise.
+ */
+class deadline_timer : boost::noncopyable {
+public:
+    deadline_timer() = default;
+    ~deadline_timer() { stop(); }
+
+public:
+    // a deadline not after `now` raises the flag at once, the maximum one is never watched
+    // other deadlines need the watchdog started
+    void start(fc::time_point deadline, fc::time_point now = coarse_now());
+    void stop();
+
+    bool expired() const { return expired_.load(std::memory_order_relaxed); }
+
+    // behind `fc::time_point::now()` by about a millisecond, or precise when the watchdog is parked
+    static fc::time_point coarse_now();
+
+    static void start_watchdog();
+    static void stop_watchdog();
+
+private:
+    friend class deadline_watchdog;
+
+    std::atomic<bool> expired_ = false;
+    bool              armed_   = false;  // owned by the thread using the timer
+    bool              running_ = false;  // guarded by the watchdog, cleared once the flag is raised
+
+    std::multimap<fc::time_point, deadline_timer*>::iterator pos_;
+};
+
+}}  // namespace evt::chain
@@ -19,7 +19,7 @@
     FC_MULTILINE_MACRO_END
 
 #define EVT_THROW(exc_type, FORMAT, ...)  throw exc_type(FC_LOG_MESSAGE(error, FORMAT, __VA_ARGS__));
-#define EVT_THROW2(exc_type, FORMAT, ...) throw exc_type(FC_LOG_MESSAGE2(error, FORMAT, ##__VA_ARGS__));
+#define EVT_THROW2(exc_type, FORMAT, ...) throw exc_type(FC_LAZY_LOG_MESSAGE2(error, FORMAT, ##__VA_ARGS__));
 
 /**
  * Macro inspired from FC_RETHROW_EXCEPTIONS
@@ -51,29 +51,29 @@
         throw fc::unhandled_exception(FC_LOG_MESSAGE(warn, FORMAT, __VA_ARGS__), std::current_exception()); \
     }
 
-#define EVT_RETHROW_EXCEPTIONS2(exception_type, FORMAT, ...)                                                 \
-    catch(const boost::interprocess::bad_alloc&) {                                                           \
-        throw;                                                                                               \
-    }                                                                                                        \
-    catch(const fc::unrecoverable_exception&) {                                                              \
-        throw;                                                                                               \
-    }                                                                                                        \
-    catch(chain_exception& e) {                                                                              \
-        FC_RETHROW_EXCEPTION2(e, warn, FORMAT, __VA_ARGS__);                                                 \
-    }                                                                                                        \
-    catch(fc::exception& e) {                                                                                \
-        exception_type new_exception(FC_LOG_MESSAGE2(warn, FORMAT, __VA_ARGS__));                            \
-        for(const auto& log : e.get_log()) {                                                                 \
-            new_exception.append_log(log);                                                                   \
-        }                                                                                                    \
-        throw new_exception;                                                                                 \
-    }                                                                                                        \
-    catch(const std::exception& e) {                                                                         \
-        exception_type fce(FC_LOG_MESSAGE2(warn, FORMAT " ({})", ##__VA_ARGS__, e.what()));                  \
-        throw fce;                                                                                           \
-    }                                                                                                        \
-    catch(...) {                                                                                             \
-        throw fc::unhandled_exception(FC_LOG_MESSAGE2(warn, FORMAT, __VA_ARGS__), std::current_exception()); \
+#define EVT_RETHROW_EXCEPTIONS2(exception_type, FORMAT, ...)                                                      \
+    catch(const boost::interprocess::bad_alloc&) {                                                                \
+        throw;                                                                                                    \
+    }                                                                                                             \
+    catch(const fc::unrecoverable_exception&) {                                                                   \
+        throw;                                                                                                    \
+    }                                                                                                             \
+    catch(chain_exception& e) {                                                                                   \
+        FC_RETHROW_EXCEPTION2(e, warn, FORMAT, __VA_ARGS__);                                                      \
+    }                                                                                                             \
+    catch(fc::exception& e) {                                                                                     \
+        exception_type new_exception(FC_LAZY_LOG_MESSAGE2(warn, FORMAT, __VA_ARGS__));                            \
+        for(const auto& log : e.get_log()) {                                                                      \
+            new_exception.append_log(log);                                                                        \
+        }                                                                                                         \
+        throw new_exception;                                                                                      \
+    }                                                                                                             \
+    catch(const std::exception& e) {                                                                              \
+        exception_type fce(FC_LAZY_LOG_MESSAGE2(warn, FORMAT " ({})", ##__VA_ARGS__, e.what()));                  \
+        throw fce;                                                                                                \
+    }                                                                                                             \
+    catch(...) {                                                                                                  \
+        throw fc::unhandled_exception(FC_LAZY_LOG_MESSAGE2(warn, FORMAT, __VA_ARGS__), std::current_exception()); \
     }
 
 /**
@@ -143,6 +143,7 @@ FC_DECLARE_DERIVED_EXCEPTION( payer_exception,                 transaction_excep
 FC_DECLARE_DERIVED_EXCEPTION( too_many_tx_at_once,             transaction_exception, 3030013, "Pushing too many transactions at once" );
 FC_DECLARE_DERIVED_EXCEPTION( tx_too_big,                      transaction_exception, 3030014, "Transaction is too big" );
 FC_DECLARE_DERIVED_EXCEPTION( unknown_transaction_compression, transaction_exception, 3030015, "Unknown transaction compression" );
+FC_DECLARE_DERIVED_EXCEPTION( tx_blacklisted,                  transaction_exception, 3030016, "Transaction failed before and is refused until it expires" );
 
 FC_DECLARE_DERIVED_EXCEPTION( action_exception,           chain_exception,  3040000, "action exception" );
 FC_DECLARE_DERIVED_EXCEPTION( action_authorize_exception, action_exception, 3040001, "invalid action authorization" );
@@ -275,6 +276,7 @@ FC_DECLARE_DERIVED_EXCEPTION( fixed_reversible_db_exception,   misc_exception,
 FC_DECLARE_DERIVED_EXCEPTION( extract_genesis_state_exception, misc_exception,  3100005, "extracted genesis state from blocks.log" );
 FC_DECLARE_DERIVED_EXCEPTION( unsupported_feature,             misc_exception,  3100006, "Feature is currently unsupported" );
 FC_DECLARE_DERIVED_EXCEPTION( node_management_success,         misc_exception,  3100007, "Node management operation successfully executed" );
+FC_DECLARE_DERIVED_EXCEPTION( genesis_initial_state_exception, misc_exception,  3100008, "Invalid genesis initial state" );
 
 FC_DECLARE_DERIVED_EXCEPTION( authorization_exception,   chain_exception,         3110000, "Authorization exception");
 FC_DECLARE_DERIVED_EXCEPTION( tx_duplicate_sig,          authorization_exception, 3110001, "Duplicate signature is included." );
@@ -314,6 +316,8 @@ FC_DECLARE_DERIVED_EXCEPTION( missing_chain_plugin_exception,        plugin_exce
 FC_DECLARE_DERIVED_EXCEPTION( missing_producer_api_plugin_exception, plugin_exception, 3130009, "Missing Producer API Plugin" );
 FC_DECLARE_DERIVED_EXCEPTION( missing_postgres_plugin_exception,     plugin_exception, 3130010, "Missing postgres Plugin" );
 FC_DECLARE_DERIVED_EXCEPTION( exceed_query_limit_exception,          plugin_exception, 3130011, "Exceed max query limit" );
+FC_DECLARE_DERIVED_EXCEPTION( invalid_query_params_exception,        plugin_exception, 3130012, "Invalid query parameters" );
+FC_DECLARE_DERIVED_EXCEPTION( history_index_exception,               plugin_exception, 3130013, "History index exception" );
 
 FC_DECLARE_DERIVED_EXCEPTION( wallet_exception,                  chain_exception,  3140000, "wallet exception" );
 FC_DECLARE_DERIVED_EXCEPTION( wallet_exist_exception,            wallet_exception, 3140001, "Wallet already exists" );
@@ -341,6 +345,8 @@ FC_DECLARE_DERIVED_EXCEPTION( token_database_squash_exception,     token_databas
 FC_DECLARE_DERIVED_EXCEPTION( token_database_snapshot_exception,   token_database_exception, 3150009, "Create or restore snapshot failed" );
 FC_DECLARE_DERIVED_EXCEPTION( token_database_persist_exception,    token_database_exception, 3150010, "Persist savepoints failed" );
 FC_DECLARE_DERIVED_EXCEPTION( token_database_cache_exception,      token_database_exception, 3150010, "Invalid cache entry" );
+FC_DECLARE_DERIVED_EXCEPTION( token_database_bulk_load_exception,  token_database_exception, 3150011, "Bulk loading failed" );
+FC_DECLARE_DERIVED_EXCEPTION( token_database_secondary_exception,  token_database_exception, 3150012, "Secondary token database is read-only" );
 
 FC_DECLARE_DERIVED_EXCEPTION( guard_exception,            database_exception, 3160101, "Database exception" );
 FC_DECLARE_DERIVED_EXCEPTION( database_guard_exception,   guard_exception,    3160102, "Database usage is at unsafe levels" );
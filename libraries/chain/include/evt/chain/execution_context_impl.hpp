@@ -42,6 +42,8 @@ public:
         act_names_arr_ = hana::unpack(act_names_, [](auto ...i) {
             return std::array<uint64_t, sizeof...(i)>{{i...}};
         });
+
+        build_names_hash();
     }
 
     ~execution_context_impl() override {}
@@ -86,13 +88,19 @@ public:
     }
 
 public:
+    // calls `func` with the `hana::type_c` of every action type
+    template<typename Func>
+    static void
+    visit_types(Func&& func) {
+        hana::for_each(act_types_, std::forward<Func>(func));
+    }
+
     int
     index_of(name act) const override {
-        auto& arr = act_names_arr_;
-        auto it   = std::lower_bound(std::cbegin(arr), std::cend(arr), act.value);
-        EVT_ASSERT(it != std::cend(arr) && *it == act.value, unknown_action_exception, "Unknown action: ${act}", ("act", act));
+        auto i = hash_indexes_[hash_slot(act.value, hash_seed_)];
+        EVT_ASSERT(i >= 0 && act_names_arr_[i] == act.value, unknown_action_exception, "Unknown action: ${act}", ("act", act));
 
-        return std::distance(std::cbegin(arr), it);
+        return i;
     }
 
     template<typename T>
@@ -148,47 +156,14 @@ public:
     template <template<uint64_t> typename Invoker, typename RType, typename ... Args>
     RType
     invoke(int actindex, Args&&... args) const {
-        using opt_type = std::conditional_t<std::is_void<RType>::value, int, RType>;
-
-        auto fn = [&](auto i) -> std::optional<opt_type> {
-            auto name  = act_names_[i];
-            auto vers  = hana::filter(act_types_,
-                [&](auto& t) { return hana::equal(name, hana::ulong_c<decltype(+t)::type::get_action_name().value>); });
-            auto cver = get_curr_ver(i);
-
-            static_assert(hana::length(vers)() > hana::size_c<0>(), "empty version actions!");
-
-            auto result = std::optional<opt_type>();
-            hana::for_each(vers, [&, cver](auto v) {
-                using ty = typename decltype(+v)::type;
-
-                constexpr auto n = ty::get_action_name().value;
-                if(ty::get_version() == cver) {
-                    if constexpr (std::is_void<RType>::value) {
-                        Invoker<n>::template invoke<ty>(std::forward<Args>(args)...);
-                        result = 1;
-                    }
-                    else {
-                        result = Invoker<n>::template invoke<ty>(std::forward<Args>(args)...);
-                    }
-                }
-            });
-
-            return result;
-        };
+        auto& table = get_invoke_table<Invoker, RType, Args...>();
+        EVT_ASSERT(actindex >= 0 && actindex < (int)table.size(), action_index_exception, "Invalid action index: ${act}", ("act", actindex));
 
-        auto range  = hana::make_range(hana::int_c<0>, hana::length(act_names_));
-        auto result = std::optional<opt_type>();
-        hana::for_each(range, [&](auto i) {
-            if(i() == actindex) {
-                result = fn(i);
-            }
-        });
+        auto cver = get_curr_ver(actindex);
+        auto func = (cver > 0 && cver <= max_version_) ? table[actindex][cver - 1] : nullptr;
+        EVT_ASSERT(func != nullptr, action_index_exception, "Invalid action index: ${act}", ("act", actindex));
 
-        EVT_ASSERT(result.has_value(), action_index_exception, "Invalid action index: ${act}", ("act", actindex));
-        if constexpr (!std::is_void<RType>::value) {
-            return *result;
-        }
+        return func(std::forward<Args>(args)...);
     }
 
     template <typename T, typename Func>
@@ -235,14 +210,81 @@ private:
         return conf.action_vers[index].ver;
     }
 
+    static size_t
+    hash_slot(uint64_t v, uint64_t seed) {
+        return (size_t)((v * seed) >> (64 - hash_bits_));
+    }
+
+    // searches a multiplicative hash seed without collisions over all the action names
+    void
+    build_names_hash() {
+        auto seed = 0x9e3779b97f4a7c15ull;
+        for(auto n = 0; n < 64 * 1024; n++) {
+            hash_indexes_.fill(-1);
+
+            auto perfect = true;
+            for(auto i = 0u; i < act_names_arr_.size(); i++) {
+                auto& slot = hash_indexes_[hash_slot(act_names_arr_[i], seed)];
+                if(slot != -1) {
+                    perfect = false;
+                    break;
+                }
+                slot = (int16_t)i;
+            }
+            if(perfect) {
+                hash_seed_ = seed;
+                return;
+            }
+            seed = (seed * 6364136223846793005ull + 1442695040888963407ull) | 1;
+        }
+        FC_ASSERT(false, "Cannot find perfect hash for action names");
+    }
+
+private:
+    template <template<uint64_t> typename Invoker, typename RType, typename T, typename ... Args>
+    static RType
+    invoke_one(Args&&... args) {
+        return Invoker<T::get_action_name().value>::template invoke<T>(std::forward<Args>(args)...);
+    }
+
+    // function table indexed by action index and version, built once for each invoker
+    template <template<uint64_t> typename Invoker, typename RType, typename ... Args>
+    static const auto&
+    get_invoke_table() {
+        using func_type  = RType(*)(Args&&...);
+        using table_type = std::array<std::array<func_type, max_version_>, hana::length(act_names_)>;
+
+        static const auto table = [] {
+            auto t = table_type();
+            for(auto& vers : t) {
+                vers.fill(nullptr);
+            }
+            hana::for_each(act_types_, [&](auto& act) {
+                using ty = typename decltype(+act)::type;
+
+                auto i = hana::index_if(act_names_, hana::equal.to(hana::ulong_c<ty::get_action_name().value>)).value();
+                t[i][ty::get_version() - 1] = &invoke_one<Invoker, RType, ty, Args...>;
+            });
+            return t;
+        }();
+        return table;
+    }
+
 private:
-    static constexpr auto act_types_ = hana::make_tuple(hana::type_c<ACTTYPE>...);
-    static constexpr auto act_names_ = hana::sort(hana::unique(hana::transform(act_types_, [](auto& a) { return hana::ulong_c<decltype(+a)::type::get_action_name().value>; })));
+    static constexpr auto act_types_   = hana::make_tuple(hana::type_c<ACTTYPE>...);
+    static constexpr auto act_names_   = hana::sort(hana::unique(hana::transform(act_types_, [](auto& a) { return hana::ulong_c<decltype(+a)::type::get_action_name().value>; })));
+    static constexpr int  max_version_ = std::max({ ACTTYPE::get_version()... });
+    static constexpr int  hash_bits_   = 8;
+
+    static_assert(decltype(hana::length(act_names_))::value < (1 << hash_bits_), "Too many actions for names hash");
 
 private:
     controller&                                                        chain_;
     std::array<uint64_t, hana::length(act_names_)>                     act_names_arr_;
     std::array<small_vector<std::string, 4>, hana::length(act_names_)> type_names_;
+
+    uint64_t                                 hash_seed_ = 0;
+    std::array<int16_t, (1 << hash_bits_)>   hash_indexes_;
 };
 
 using evt_execution_context = execution_context_impl<
@@ -263,6 +305,7 @@ using evt_execution_context = execution_context_impl<
                                   contracts::destroyft,
                                   contracts::evt2pevt,
                                   contracts::addmeta,
+                                  contracts::addmeta_v2,
                                   contracts::newsuspend,
                                   contracts::cancelsuspend,
                                   contracts::aprvsuspend,
@@ -280,7 +323,8 @@ using evt_execution_context = execution_context_impl<
                                   contracts::tryunlock,
                                   contracts::setpsvbonus,
                                   contracts::setpsvbonus_v2,
-                                  contracts::distpsvbonus
+                                  contracts::distpsvbonus,
+                                  contracts::distpsvbonus_v2
                               >;
 
 }}  // namespace evt::chain
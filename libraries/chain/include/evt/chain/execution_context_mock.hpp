@@ -223,6 +223,7 @@ using evt_execution_context_mock = execution_context_mock<
                                       contracts::destroyft,
                                       contracts::evt2pevt,
                                       contracts::addmeta,
+                                      contracts::addmeta_v2,
                                       contracts::newsuspend,
                                       contracts::cancelsuspend,
                                       contracts::aprvsuspend,
@@ -240,7 +241,8 @@ using evt_execution_context_mock = execution_context_mock<
                                       contracts::tryunlock,
                                       contracts::setpsvbonus,
                                       contracts::setpsvbonus_v2,
-                                      contracts::distpsvbonus
+                                      contracts::distpsvbonus,
+                                      contracts::distpsvbonus_v2
                                   >;
 
 }}  // namespace evt::chain
@@ -5,6 +5,7 @@
 #pragma once
 #include <boost/signals2/signal.hpp>
 #include <evt/chain/block_state.hpp>
+#include <evt/chain/config.hpp>
 
 namespace evt { namespace chain {
 
@@ -22,10 +23,14 @@ typedef vector<block_state_ptr> branch_type;
  * database tracks the longest chain and the last irreversible block number. All
  * blocks older than the last irreversible block are freed after emitting the
  * irreversible signal.
+ *
+ * Branches fallen behind the head by more than the retention window are
+ * dropped, 0 keeps all of them. Changes are appended into a journal in
+ * data dir, so closing doesn't rewrite all the blocks.
  */
 class fork_database {
 public:
-    fork_database(const fc::path& data_dir);
+    fork_database(const fc::path& data_dir, uint32_t retention_window = config::default_fork_db_retention_window);
     ~fork_database();
 
     void close();
@@ -50,6 +55,8 @@ public:
     void add(const header_confirmation& c);
 
     const block_state_ptr& head() const;
+    size_t                 size() const;  // number of block states kept
+    uint64_t               blocks_size() const;  // packed size of the blocks kept, it walks all of them
 
     /**
      *  Given two head blocks, return two branches of the fork graph that
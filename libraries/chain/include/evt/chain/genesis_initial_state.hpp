@@ -0,0 +1,39 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+#include <optional>
+#include <fc/filesystem.hpp>
+#include <fc/crypto/sha256.hpp>
+
+namespace evt { namespace chain {
+
+class token_database;
+struct genesis_state;
+
+/**
+ * Initial state of a chain besides the reserved tokens, too large to be part of the genesis state
+ *
+ * It's a file of JSON lines, each one is one of:
+ *   {"domain": domain_def}
+ *   {"token": token_def}
+ *   {"fungible": fungible_def}
+ *   {"balance": {"owner": address, "amount": asset}}
+ *
+ * The genesis state declares it by the sha256 digest of the file in the `.initial-state` meta of
+ * the everiToken foundation group, so it's part of the chain id. The remaining supply of each
+ * fungible is left in its reserved address, so is the one of EVT.
+ */
+namespace genesis_initial_state {
+
+// digest of the initial state declared by `genesis`, nothing when it has none
+std::optional<fc::sha256> declared_digest(const genesis_state& genesis);
+
+// lines are decoded by worker threads while the file is read and hashed, then loaded into the
+// token database, which holds only the reserved tokens, by SST files sorted in key order
+void load(const fc::path& path, const genesis_state& genesis, token_database& db);
+
+}  // namespace genesis_initial_state
+
+}}  // namespace evt::chain
@@ -78,6 +78,17 @@ calcluate_max_depth(uint64_t node_count) {
     return clz_power_2(implied_count) + 1;
 }
 
+/**
+ * Hashes the canonical pair of `l` and `r` from one buffer,
+ * same bytes as packing `make_canonical_pair(l, r)`
+ */
+template <typename DigestType>
+inline DigestType
+hash_canonical_pair(const DigestType& l, const DigestType& r) {
+    DigestType pair[2] = { make_canonical_left(l), make_canonical_right(r) };
+    return DigestType::hash((const char*)pair, sizeof(pair));
+}
+
 template <typename ContainerA, typename ContainerB>
 inline void
 move_nodes(ContainerA& to, const ContainerB& from) {
@@ -204,7 +215,7 @@ public:
 
                 // calculate the partially realized node value by implying the "right" value is identical
                 // to the "left" value
-                top     = DigestType::hash(make_canonical_pair(top, top));
+                top     = detail::hash_canonical_pair(top, top);
                 partial = true;
             }
             else {
@@ -221,7 +232,7 @@ public:
                 }
 
                 // calculate the node
-                top = DigestType::hash(make_canonical_pair(left_value, top));
+                top = detail::hash_canonical_pair(left_value, top);
             }
 
             // move up a level in the tree
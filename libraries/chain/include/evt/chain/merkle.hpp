@@ -5,6 +5,10 @@
 #pragma once
 #include <evt/chain/types.hpp>
 
+namespace evt { namespace utilities {
+class task_scheduler;
+}}  // namespace evt::utilities
+
 namespace evt { namespace chain {
 
    digest_type make_canonical_left(const digest_type& val);
@@ -23,4 +27,9 @@ namespace evt { namespace chain {
     */
    digest_type merkle( vector<digest_type> ids );
 
+   /**
+    *  Same root as above, the levels wide enough are hashed in chunks spread to the `scheduler`
+    */
+   digest_type merkle( vector<digest_type> ids, utilities::task_scheduler& scheduler );
+
 } } /// evt::chain
@@ -58,6 +58,9 @@ public:
     static name128 from_number(uint64_t v);
 
     explicit operator std::string() const;
+
+    // writes the chars into `buf` of at least 21 bytes without allocation, returns the length
+    size_t to_string(char* buf) const;
     explicit operator bool() const { return value; }
     explicit operator uint128_t() const { return value; }
 
@@ -178,7 +181,11 @@ string_to_name128(const char* str) {
     return name;
 }
 
-#define N128(X) evt::chain::string_to_name128(#X)
+// forces the encoding to happen at compile time, even where the result is only used at runtime
+template<uint128_t V>
+constexpr uint128_t name128_literal = V;
+
+#define N128(X) evt::chain::name128_literal<evt::chain::string_to_name128(#X)>
 
 inline std::vector<name128>
 sort_names(std::vector<name128>&& names) {
@@ -33,6 +33,17 @@ public:
     uint32_t raw_value() const { return v_.value; }
     explicit operator percent_type() const { return value(); }
 
+    // floor(value() * amount) in 128-bit integers, gives the same results as the decimal math
+    int64_t
+    floor_of(int64_t amount) const {
+        auto p = (__int128)v_.value * amount;
+        auto q = p / kMaxAmount;
+        if(p < 0 && p % kMaxAmount != 0) {
+            q--;
+        }
+        return (int64_t)q;
+    }
+
 public:
     static percent_slim from_string(const string& from);
     string              to_string() const;
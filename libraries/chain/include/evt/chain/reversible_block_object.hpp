@@ -27,7 +27,7 @@ class reversible_block_object : public chainbase::object<reversible_block_object
     signed_block_ptr
     get_block() const {
         fc::datastream<const char*> ds(packedblock.data(), packedblock.size());
-        auto                        result = std::make_shared<signed_block>();
+        auto                        result = make_signed_block();
         fc::raw::unpack(ds, *result);
         return result;
     }
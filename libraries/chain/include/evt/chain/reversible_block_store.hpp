@@ -0,0 +1,69 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+#include <map>
+#include <optional>
+#include <fstream>
+#include <fc/filesystem.hpp>
+#include <evt/chain/block.hpp>
+
+namespace evt { namespace chain {
+
+/**
+ *  Reversible blocks are kept in an append-only file of the blocks applied but not irreversible yet,
+ *  only their positions are held in memory, so memory use stays flat however long LIB stalls.
+ *
+ *  +-----------+------+----------------+-----------+------+----------------+-----+
+ *  | Block num | Size | Packed block 1 | Block num | Size | Packed block 2 | ... |
+ *  +-----------+------+----------------+-----------+------+----------------+-----+
+ *
+ *  Block numbers are always consecutive: adding a block at or below the last one (a fork switch)
+ *  truncates the file there first. Blocks pruned by LIB are only dropped from the index, the file
+ *  is rewritten when the pruned prefix takes most of it. An incomplete record at the end, left by
+ *  a crash, is truncated when opening.
+ */
+class reversible_block_store {
+public:
+    explicit reversible_block_store(const fc::path& dir);
+    ~reversible_block_store();
+
+public:
+    void             add(const signed_block_ptr& b);
+    signed_block_ptr get(uint32_t num) const;
+
+    void remove_from(uint32_t num);   // removes the blocks from `num`
+    void prune(uint32_t lib);         // removes the blocks up to `lib`
+    void flush();
+
+    std::optional<uint32_t> first_num() const;
+    std::optional<uint32_t> last_num() const;
+
+    size_t   size() const { return index_.size(); }
+    uint64_t file_size() const { return end_; }
+    uint64_t recovered_bytes() const { return recovered_bytes_; }  // truncated when opening
+
+    fc::path path() const { return dir_ / filename(); }
+
+    static const char* filename() { return "reversible.log"; }
+
+private:
+    struct position {
+        uint64_t offset;  // of packed block
+        uint32_t size;
+    };
+
+    void open();
+    void truncate(uint64_t offset);
+    void compact();
+
+private:
+    fc::path                     dir_;
+    mutable std::fstream         file_;
+    uint64_t                     end_             = 0;
+    uint64_t                     recovered_bytes_ = 0;
+    std::map<uint32_t, position> index_;
+};
+
+}}  // namespace evt::chain
@@ -0,0 +1,111 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+#include <memory>
+#include <utility>
+#include <fc/io/raw.hpp>
+#include <fc/variant.hpp>
+
+namespace evt { namespace chain {
+
+/**
+ * Immutable value shared by all the copies of it, copied on write
+ *
+ * Used for the large members of header states which rarely change from one block to the
+ * next one, so the states of the blocks in fork database share one copy of them.
+ * Copies made on different threads are fine, a value is only written through its
+ * last owner or through a copy of it.
+ */
+template <typename T>
+class shared_value {
+public:
+    shared_value() : v_(empty()) {}
+    shared_value(const T& v) : v_(std::make_shared<T>(v)) {}
+    shared_value(T&& v) : v_(std::make_shared<T>(std::move(v))) {}
+
+    shared_value(const shared_value&) = default;
+    shared_value(shared_value&& sv) noexcept : v_(std::exchange(sv.v_, empty())) {}
+
+    shared_value& operator=(const shared_value&) = default;
+
+    shared_value&
+    operator=(shared_value&& sv) noexcept {
+        v_ = std::exchange(sv.v_, empty());
+        return *this;
+    }
+
+public:
+    const T& get() const { return *v_; }
+    const T& operator*() const { return *v_; }
+    const T* operator->() const { return v_.get(); }
+    operator const T&() const { return *v_; }
+
+    // copies the value first when it's shared with others
+    T&
+    mutate() {
+        if(v_.use_count() > 1) {
+            v_ = std::make_shared<T>(*v_);
+        }
+        return *v_;
+    }
+
+    bool shares_with(const shared_value& sv) const { return v_ == sv.v_; }
+
+private:
+    // default values share one instance, so default states allocate nothing
+    static const std::shared_ptr<T>&
+    empty() {
+        static const auto e = std::make_shared<T>();
+        return e;
+    }
+
+private:
+    std::shared_ptr<T> v_;
+};
+
+}}  // namespace evt::chain
+
+namespace fc {
+
+namespace raw {
+
+// packed as the value itself
+template<typename T>
+struct packer<evt::chain::shared_value<T>> {
+    template<typename Stream>
+    static void
+    pack(Stream& s, const evt::chain::shared_value<T>& sv) {
+        fc::raw::pack(s, *sv);
+    }
+};
+
+template<typename T>
+struct unpacker<evt::chain::shared_value<T>> {
+    template<typename Stream>
+    static void
+    unpack(Stream& s, evt::chain::shared_value<T>& sv) {
+        auto v = T();
+        fc::raw::unpack(s, v);
+        sv = std::move(v);
+    }
+};
+
+}  // namespace raw
+
+template<typename T>
+void
+to_variant(const evt::chain::shared_value<T>& sv, fc::variant& vo) {
+    to_variant(*sv, vo);
+}
+
+template<typename T>
+void
+from_variant(const fc::variant& var, evt::chain::shared_value<T>& sv) {
+    auto v = T();
+    from_variant(var, v);
+    sv = std::move(v);
+}
+
+}  // namespace fc
@@ -4,6 +4,7 @@
  */
 #pragma once
 
+#include <future>
 #include <ostream>
 #include <optional>
 #include <evt/chain/database_utils.hpp>
@@ -171,6 +172,18 @@ struct snapshot_row_raw_writer : abstract_snapshot_row_writer {
     size_t      sz_;
 };
 
+/**
+ * Entry of the section table in the v2 binary snapshot, the table is written after all the sections
+ * and located by the offset in the header. `checksum` is the SHA256 of the compressed section data.
+ */
+struct snapshot_section_entry {
+    std::string name;
+    uint64_t    pos;
+    uint64_t    row_count;
+    uint64_t    size;
+    fc::sha256  checksum;
+};
+
 }  // namespace detail
 
 class snapshot_writer {
@@ -472,25 +485,24 @@ public:
     void write_end_section() override;
     void finalize();
 
-    static const uint32_t magic_number = 0x30510550;
+    static const uint32_t magic_number    = 0x30510550;  // v1: sections are chained by their sizes
+    static const uint32_t magic_number_v2 = 0x30510551;  // v2: sections are indexed by a table with checksums
 
 private:
     detail::ostream_wrapper                            snapshot;
     std::optional<boost::iostreams::filtering_ostream> row_stream;
 
-    std::streampos          header_pos;
-    std::streampos          section_pos;
-    uint64_t                row_count;
+    std::streampos                              header_pos;
+    std::streampos                              section_pos;
+    uint64_t                                    row_count;
+    std::string                                 section_name;
+    fc::sha256::encoder                         section_enc;
+    std::vector<detail::snapshot_section_entry> sections;
 };
 
 class istream_snapshot_reader : public snapshot_reader {
 public:
-    struct section_index {
-        std::string name;
-        size_t      pos;
-        size_t      row_count;
-        size_t      size;
-    };
+    using section_index = detail::snapshot_section_entry;
 
 public:
     explicit istream_snapshot_reader(std::istream& snapshot);
@@ -508,14 +520,30 @@ public:
 private:
     void build_section_indexes() override;
     bool validate_section() const;
+    void validate_checksums() const;
+
+    std::string read_section_data(const section_index& si) const;
+    void        prefetch_section(size_t i);
+
+    // sections up to this size are decompressed in memory and the next one is prefetched
+    // in background while rows of current section are being read
+    static const uint64_t max_prefetch_size = 64 * 1024 * 1024;
+
+    struct prefetched_section {
+        std::string                     name;
+        std::shared_future<std::string> data;
+    };
 
     std::istream&                                      snapshot;
     std::optional<boost::iostreams::filtering_istream> row_stream;
 
-    std::streampos             header_pos;
-    uint64_t                   num_rows;
-    uint64_t                   cur_row;
-    std::vector<section_index> section_indexes;
+    std::streampos                    header_pos;
+    uint32_t                          format;
+    uint64_t                          num_rows;
+    uint64_t                          cur_row;
+    std::vector<section_index>        section_indexes;
+    std::string                       cur_data;
+    std::optional<prefetched_section> prefetched;
 };
 
 class integrity_hash_snapshot_writer : public snapshot_writer {
@@ -532,3 +560,5 @@ private:
 };
 
 }}  // namespace evt::chain
+
+FC_REFLECT(evt::chain::detail::snapshot_section_entry, (name)(pos)(row_count)(size)(checksum));
@@ -4,17 +4,22 @@
 */
 #pragma once
 #include <functional>
+#include <map>
 #include <memory>
 #include <optional>
 #include <string_view>
+#include <tuple>
+#include <vector>
 #include <boost/noncopyable.hpp>
 #include <boost/signals2/signal.hpp>
 #include <fc/reflect/reflect.hpp>
 #include <fc/filesystem.hpp>
+#include <fc/crypto/sha256.hpp>
 #include <evt/chain/types.hpp>
 #include <evt/chain/asset.hpp>
 #include <evt/chain/address.hpp>
 #include <evt/chain/config.hpp>
+#include <evt/utilities/fixed_signal.hpp>
 
 namespace rocksdb {
 class DB;
@@ -24,10 +29,19 @@ class Slice;
 namespace evt { namespace chain {
 
 using read_value_func = std::function<bool(const std::string_view& key, std::string&&)>;
+using read_owned_func = std::function<bool(const name128& domain, const name128& name)>;
+using read_held_func  = std::function<bool(symbol_id_type sym_id)>;
+using update_value_func = std::function<void(std::string& value)>;
 
 enum class storage_profile {
     disk   = 0,
-    memory = 1
+    memory = 1,
+    ram    = 2   // all the data are kept in RAM and lost after closed, restore from snapshot or replay
+};
+
+enum class compaction_style {
+    universal = 0,
+    level     = 1
 };
 
 enum class token_type {
@@ -42,7 +56,10 @@ enum class token_type {
     evtlink,
     psvbonus,
     psvbonus_dist,
-    max_value = psvbonus_dist
+    owner,  // index of tokens by their owners, partitioned by owner
+    meta,   // metas kept out of their domains, fungibles and groups
+    holding,  // index of symbols held by addresses, partitioned by address
+    max_value = holding
 };
 
 enum class action_op {
@@ -121,18 +138,122 @@ extract_db_value(const std::string& str, T& v) {
     fc::raw::unpack(ds, v);
 }
 
-using token_keys_t = small_vector<name128, 4>;
+using token_keys_t  = small_vector<name128, 4>;
+using asset_key_t   = std::pair<address, symbol_id_type>;
+using asset_keys_t  = small_vector<asset_key_t, 4>;
+using read_values_t = std::vector<std::optional<std::string>>;
+
+// fixed-size key of one token, shares the same layout with the key stored in database
+// used by object cache to avoid building string keys
+struct token_db_key {
+    name128 prefix;
+    name128 key;
+
+    std::string_view as_string_view() const { return std::string_view((const char*)this, sizeof(name128) * 2); }
+};
+static_assert(sizeof(token_db_key) == sizeof(name128) * 2);
+
+/**
+ * Read-only view of the token database right after its last popped savepoint,
+ * which is the irreversible state. It never changes once taken and can be read
+ * from any thread, but it must be released before the database is closed.
+ */
+class token_database_view : boost::noncopyable {
+public:
+    token_database_view(std::unique_ptr<class token_database_view_impl>&& my);
+    ~token_database_view();
+
+public:
+    int read_token(token_type type, const std::optional<name128>& domain, const name128& key, std::string& out, bool no_throw = false) const;
+    int read_asset(const address& addr, const symbol_id_type sym_id, std::string& out, bool no_throw = false) const;
+
+    int read_tokens_prefix(token_type type, const std::optional<name128>& domain, const std::string_view& key_prefix, const read_value_func& func) const;
+    int read_held_symbols(const address& addr, const read_held_func& func) const;
+
+private:
+    std::unique_ptr<class token_database_view_impl> my_;
+};
+using token_database_view_ptr = std::shared_ptr<const token_database_view>;
 
 class token_database : boost::noncopyable {
 public:
+    struct column_family_config {
+        compaction_style compaction           = compaction_style::universal;
+        uint32_t         bloom_bits           = 10;
+        uint32_t         block_cache_share    = 50;    // percentage of `block_cache_size`, only for disk profile, 0 for the default 8M cache of rocksdb
+        bool             pin_index_and_filter = false; // keep index and filter blocks in block cache
+    };
+
+    struct memory_usage {
+        uint64_t block_cache          = 0;
+        uint64_t block_cache_capacity = 0;
+        uint64_t memtables            = 0;
+        uint64_t table_readers        = 0;  // indexes and filters not kept in block cache
+        uint64_t write_cache          = 0;  // asset values and previous values of the savepoints
+        uint64_t key_filters          = 0;  // filters of the keys of the types checked when they're created
+    };
+
+    struct hot_key {
+        token_type  type;
+        std::string prefix;     // domain or reserved prefix of tokens, symbol id of assets
+        std::string key;        // name of tokens, address of assets
+        uint64_t    count = 0;  // estimated from the samples
+        uint64_t    error = 0;  // max overestimation of `count`
+    };
+
+    struct hot_keys {
+        uint32_t             sample_rate = 0;  // one of every `sample_rate` point operations is counted
+        uint64_t             reads       = 0;  // estimated totals
+        uint64_t             writes      = 0;
+        std::vector<hot_key> top_reads;
+        std::vector<hot_key> top_writes;
+    };
+
     struct config {
-        storage_profile profile           = storage_profile::disk;
-        uint32_t        block_cache_size  = 256 * 1024 * 1024; // 256M
-        uint32_t        object_cache_size = 256 * 1024 * 1024; // 256M
-        fc::path        db_path           = ::evt::chain::config::default_token_database_dir_name;
-        bool            enable_stats      = true;
+        storage_profile profile             = storage_profile::disk;
+        uint32_t        block_cache_size    = 256 * 1024 * 1024; // 256M
+        uint32_t        object_cache_size   = 256 * 1024 * 1024; // 256M
+        uint32_t        object_cache_shards = 16;
+        fc::path        db_path             = ::evt::chain::config::default_token_database_dir_name;
+        bool            enable_stats        = true;
+        bool            async_persist       = false;  // sync popped savepoints in background
+        uint32_t        persist_queue_size  = 16;     // max unsynced popped savepoints before blocking
+        bool            group_commit        = false;  // popped savepoints are only synced by `sync_wal`, overrides `async_persist`
+        bool            irreversible_reads  = false;  // keep a view of the irreversible state for readers
+        bool            owner_index         = false;  // index tokens by their owners, fixed when database is created
+        bool            holding_index       = false;  // index symbols by their holders, fixed when database is created
+        uint32_t        hot_keys_sample     = 64;     // sample one of every N point reads and writes for hot keys, 0 to disable
+        uint32_t        hot_keys_capacity   = 256;    // keys tracked for reads and for writes each
+        fc::path        secondary_path;               // opens `db_path` of a primary as read-only secondary when set, keeps its own logs here
+        fc::path        cold_path;                    // tokens beyond `hot_size` are moved here when set, for cheaper disks
+        uint64_t        hot_size            = 8ull * 1024 * 1024 * 1024;  // bytes of tokens kept in `db_path` when `cold_path` is set
+        uint32_t        cold_domain_secs    = 0;      // domains not sampled for this long are compacted into the bottom level, 0 to disable
+        uint32_t        cold_zstd_level     = 0;      // zstd level of the bottom level of tokens, dictionary is trained when set, 0 for default
+        bool            prefetch            = true;   // load the keys of blocks into block cache ahead of execution, only for disk profile
+        uint64_t        io_rate             = 0;      // bytes per second of flushes and compactions while busy, 0 for unlimited, only for disk profile
+        uint64_t        idle_io_rate        = 0;      // bytes per second of them while idle, see `set_background_busy`, 0 for unlimited
+        bool            auto_tune           = false;  // rates follow the demand below the limits, write buffers follow the write rate
+        std::vector<uint32_t> background_cpus;        // cpus of the background threads started when opened, empty to not pin them
+
+        // same split as a single block cache had: all of it for tokens, the default one of rocksdb for assets
+        column_family_config tokens_cf = { compaction_style::universal, 10, 100, true };
+        column_family_config assets_cf = { compaction_style::universal, 10, 0, false };
+    };
+
+    // keys read ahead of execution, see `prefetch`
+    struct prefetch_keys {
+        std::vector<std::tuple<token_type, std::optional<name128>, name128>> tokens;  // type, domain and key
+        std::vector<asset_key_t>                                             assets;
     };
 
+    // change of one token or asset, value is nullopt when it's removed
+    struct token_delta {
+        token_type                 type;
+        std::string                key;  // key in db: prefix and name of tokens, symbol id and public key of assets
+        std::optional<std::string> value;
+    };
+    using token_deltas = std::vector<token_delta>;
+
     class session {
     public:
         session(token_database& token_db, int seq)
@@ -182,14 +303,34 @@ public:
     token_database(const config&);
     ~token_database();
 
+    // point operations done by one thread, used to account the costs of each action
+    struct io_counters {
+        uint64_t reads  = 0;
+        uint64_t writes = 0;
+        uint64_t misses = 0;
+    };
+
 public:
     void open(int load_persistence = true);
     void close(int persist = true);
 
+    static io_counters& thread_io_counters();
+
+public:
+    // secondary instance only sees what primary has written into its files, tokens are there as soon as
+    // they're written while assets are only there after their savepoints are popped(irreversible)
+    bool is_secondary() const;
+    void catch_up_with_primary();
+
 public:
     void put_token(token_type type, action_op op, const std::optional<name128>& domain, const name128& key, const std::string_view& data);
     void put_tokens(token_type type, action_op op, const std::optional<name128>& domain, token_keys_t&& keys, const small_vector_base<std::string_view>& data);
     void put_asset(const address& addr, const symbol_id_type sym_id, const std::string_view& data);
+    void put_assets(const small_vector_base<asset_key_t>& keys, const small_vector_base<std::string_view>& data);
+
+    // changes the value of one asset in place and writes it back, `value` is empty if the asset doesn't exist yet
+    // cached values are patched directly instead of being copied out and put again
+    void update_asset(const address& addr, const symbol_id_type sym_id, const update_value_func& func);
 
     int exists_token(token_type type, const std::optional<name128>& domain, const name128& key) const;
     int exists_asset(const address& addr, const symbol_id_type sym_id) const;
@@ -197,9 +338,38 @@ public:
     int read_token(token_type type, const std::optional<name128>& domain, const name128& key, std::string& out, bool no_throw = false) const;
     int read_asset(const address& addr, const symbol_id_type sym_id, std::string& out, bool no_throw = false) const;
 
+    // batch reads, `outs` is resized to the size of keys and missing values are left empty
+    // returns the number of found values
+    int read_tokens(token_type type, const std::optional<name128>& domain, const small_vector_base<name128>& keys, read_values_t& outs, bool no_throw = false) const;
+    int read_assets(const small_vector_base<asset_key_t>& keys, read_values_t& outs, bool no_throw = false) const;
+
     int read_tokens_range(token_type type, const std::optional<name128>& domain, int skip, const read_value_func& func) const;
     int read_assets_range(const symbol_id_type sym_id, int skip, const read_value_func& func) const;
 
+    // cursor-based range reads, `cursor` is the opaque key(without prefix) of the last visited value
+    // scanning resumes right after it and starts from the beginning when it's empty
+    // pending values in cache are merged into the results without touching the db
+    int read_tokens_range(token_type type, const std::optional<name128>& domain, std::string& cursor, const read_value_func& func) const;
+    int read_assets_range(const symbol_id_type sym_id, std::string& cursor, const read_value_func& func) const;
+
+    // values whose keys(without prefix) begin with `key_prefix`, in the order of keys
+    // returns the number of values visited
+    int read_tokens_prefix(token_type type, const std::optional<name128>& domain, const std::string_view& key_prefix, const read_value_func& func) const;
+
+    // tokens owned by the address read from the owner index, ordered by hashes of them
+    // returns the number of tokens visited, skipped ones are not counted
+    int read_owned_tokens(const address& owner, int skip, const read_owned_func& func) const;
+    bool has_owner_index() const;
+
+    // symbols ever held by the address read from the holding index, ordered by their ids
+    // returns the number of symbols visited
+    int read_held_symbols(const address& addr, const read_held_func& func) const;
+    bool has_holding_index() const;
+
+    // loads the blocks holding the values of `keys` into block cache without returning them
+    // safe to be called from other threads while it's open, pending values in write cache are skipped
+    void prefetch(const prefetch_keys& keys) const;
+
 public:
     void add_savepoint(int64_t seq);
     void rollback_to_latest_savepoint();
@@ -210,22 +380,82 @@ public:
     int64_t latest_savepoint_seq() const;
 
     session new_savepoint_session(int64_t seq);
+    // nested session(transaction), it never takes a snapshot of db, previous values of the
+    // tokens are kept when they're first written instead and it can only be squashed
     session new_savepoint_session();
 
     size_t savepoints_size() const;
 
+public:
+    // bulk loading mode, puts are written into sorted SST files and ingested when ended
+    // it's only allowed when there's no savepoint, and values are not readable until ended
+    void begin_bulk_load();
+    void end_bulk_load();
+
+public:
+    // checkpoint is a consistent copy of the database together with its savepoints
+    // table files are hard linked when possible, `dir` should not exist
+    void create_checkpoint(const fc::path& dir) const;
+
+    // restores the checkpoint in `dir` into `db_path`, it should be called before the database is opened
+    static void restore_checkpoint(const fc::path& dir, const fc::path& db_path);
+
+public:
+    // merkle root over the hashes of token partitions(reserved types and domains) and asset partitions(symbol ids)
+    // partitions touched since last call are rehashed in parallel, it's only consistent when there's no writes
+    fc::sha256 calculate_integrity_hash() const;
+
+public:
+    // view of the irreversible state, refreshed whenever savepoints are popped
+    // null when `irreversible_reads` is off or savepoints loaded from disk are not popped yet
+    token_database_view_ptr get_irreversible_view() const;
+
+public:
+    // deltas of a nested savepoint(transaction) when it's squashed, with the seq of the savepoint it's
+    // squashed into, they're only collected while there are slots connected and slots may move them away
+    boost::signals2::signal<void(int64_t seq, token_deltas&)> squashed_deltas;
+    // a savepoint which is not nested is rolled back, the deltas squashed into it are reverted
+    boost::signals2::signal<void(int64_t seq)>                rolled_back_savepoint;
+
 public:
     std::string stats() const;
+    // values of the rocksdb tickers by their names, only the ones of token database itself are
+    // there when `enable_stats` is off
+    std::map<std::string, uint64_t> tickers() const;
+
+    memory_usage get_memory_usage() const;
+    // capacity of all the block caches, split by their shares, entries above it are evicted at once
+    void set_block_cache_capacity(uint64_t bytes);
+
+    // bytes per second of flushes and compactions while busy and while idle, 0 for unlimited
+    void                          set_io_rates(uint64_t busy, uint64_t idle);
+    std::pair<uint64_t, uint64_t> get_io_rates() const;
+    // background I/O is limited to the busy rate while blocks are being made, and to the idle one
+    // between them, so compactions are deferred into the idle windows; it's busy when opened
+    void set_background_busy(bool busy);
+
+    // syncs the WAL of all the savepoints popped since the last sync, see `group_commit`
+    void sync_wal();
+
+    // most read and written keys by point operations, counted by sampling
+    hot_keys get_hot_keys(size_t top) const;
+    void     reset_hot_keys();
 
 private:
     void flush() const;
     void persist_savepoints(std::ostream&) const;
     void load_savepoints(std::istream&);
 
+    static int count_read(int found);
+
+    void sample_key(int write, token_type type, const name128& prefix, const name128& key) const;
+    void sample_asset(int write, const address& addr, const symbol_id_type sym_id) const;
+
 private:  // for cache usage
-    std::string get_db_key(token_type type, const std::optional<name128>& domain, const name128& key);
-    boost::signals2::signal<void(const rocksdb::Slice&)> rollback_token_value;
-    boost::signals2::signal<void(const rocksdb::Slice&)> remove_token_value;
+    token_db_key get_db_key(token_type type, const std::optional<name128>& domain, const name128& key) const;
+    utilities::fixed_signal<void(const rocksdb::Slice&)> rollback_token_value;
+    utilities::fixed_signal<void(const rocksdb::Slice&)> remove_token_value;
+    boost::signals2::signal<void(std::string&)>          collect_stats;
 
 private:
     std::unique_ptr<class token_database_impl> my_;
@@ -235,4 +465,10 @@ private:
 
 }}  // namespace evt::chain
 
-FC_REFLECT(evt::chain::token_database::config, (profile)(block_cache_size)(object_cache_size)(db_path));
+FC_REFLECT_ENUM(evt::chain::compaction_style, (universal)(level));
+FC_REFLECT_ENUM(evt::chain::token_type, (asset)(domain)(token)(group)(suspend)(lock)(fungible)(prodvote)(evtlink)(psvbonus)(psvbonus_dist)(owner)(meta)(holding));
+FC_REFLECT(evt::chain::token_database::memory_usage, (block_cache)(block_cache_capacity)(memtables)(table_readers)(write_cache)(key_filters));
+FC_REFLECT(evt::chain::token_database::hot_key, (type)(prefix)(key)(count)(error));
+FC_REFLECT(evt::chain::token_database::hot_keys, (sample_rate)(reads)(writes)(top_reads)(top_writes));
+FC_REFLECT(evt::chain::token_database::column_family_config, (compaction)(bloom_bits)(block_cache_share)(pin_index_and_filter));
+FC_REFLECT(evt::chain::token_database::config, (profile)(block_cache_size)(object_cache_size)(object_cache_shards)(db_path)(async_persist)(persist_queue_size)(irreversible_reads)(owner_index)(holding_index)(hot_keys_sample)(hot_keys_capacity)(secondary_path)(background_cpus)(tokens_cf)(assets_cf));
@@ -3,8 +3,12 @@
  *  @copyright defined in evt/LICENSE.txt
 */
 #pragma once
+#include <atomic>
 #include <memory>
+#include <string_view>
 #include <boost/type_index.hpp>
+#include <boost/signals2/connection.hpp>
+#include <fmt/format.h>
 #include <fc/io/datastream.hpp>
 #include <fc/io/raw.hpp>
 #include <rocksdb/cache.h>
@@ -12,26 +16,53 @@
 
 namespace evt { namespace chain {
 
+// Object cache is split into several shards, each one owns its own LRU cache and counters.
+// Key is dispatched to one shard by its hash, so readers(ex. http apis) and block application
+// only contend when they touch the same shard.
 class token_database_cache {
 public:
-    token_database_cache(token_database& db, size_t cache_size)
+    static constexpr size_t kDefaultShardsNum = 16;
+
+public:
+    token_database_cache(token_database& db, size_t cache_size, size_t shards_num = kDefaultShardsNum)
         : db_(db)
-        , cache_(rocksdb::NewLRUCache(cache_size)) {
+        , shards_num_(normalize_shards_num(shards_num))
+        , shards_(new shard[shards_num_]) {
+        for(auto i = 0u; i < shards_num_; i++) {
+            // each shard is protected by a single mutex, it's already sharded here
+            shards_[i].cache = rocksdb::NewLRUCache(std::max(cache_size / shards_num_, (size_t)1), 0 /* num_shard_bits */);
+        }
         watch_db();
     }
 
 private:
+    struct shard {
+        std::atomic<uint64_t>           hits      {0};
+        std::atomic<uint64_t>           misses    {0};
+        std::atomic<uint64_t>           evictions {0};
+        std::shared_ptr<rocksdb::Cache> cache;  // destroyed first, entries may touch counters above
+    };
+
+    struct cache_entry_base {
+    public:
+        cache_entry_base(boost::typeindex::type_index ti) : ti(ti), owner(nullptr), erased(false) {}
+
+    public:
+        boost::typeindex::type_index ti;
+        shard*                       owner;
+        bool                         erased;  // erased by database rather than evicted by cache
+    };
+
     template<typename T>
-    struct cache_entry {
+    struct cache_entry : public cache_entry_base {
     public:
-        cache_entry() : ti(boost::typeindex::type_id<T>()) {}
+        cache_entry() : cache_entry_base(boost::typeindex::type_id<T>()) {}
 
         template<typename U>
-        cache_entry(U&& d) : ti(boost::typeindex::type_id<T>()), data(std::forward<U>(d)) {}
+        cache_entry(U&& d) : cache_entry_base(boost::typeindex::type_id<T>()), data(std::forward<U>(d)) {}
 
     public:
-        boost::typeindex::type_index ti;
-        T                            data;
+        T data;
     };
 
 public:
@@ -39,18 +70,20 @@ public:
     struct cache_deleter {
     public:
         cache_deleter()
-            : self_(nullptr), handle_(nullptr) {}
-        cache_deleter(token_database_cache* self, rocksdb::Cache::Handle* handle)
-            : self_(self), handle_(handle) {}
+            : cache_(nullptr), handle_(nullptr) {}
+        cache_deleter(rocksdb::Cache* cache, rocksdb::Cache::Handle* handle)
+            : cache_(cache), handle_(handle) {}
 
-    void
-    operator()(T* ptr) {
-        assert(handle_);
-        self_->cache_->Release(handle_);
-    }
+        void
+        operator()(T* ptr) {
+            if(handle_ == nullptr) {
+                return;
+            }
+            cache_->Release(handle_);
+        }
 
     private:
-        token_database_cache*   self_;
+        rocksdb::Cache*         cache_;
         rocksdb::Cache::Handle* handle_;
     };
 
@@ -60,14 +93,16 @@ public:
     read_token(token_type type, const std::optional<name128>& domain, const name128& key, bool no_throw = false) {
         static_assert(std::is_class_v<T>, "T should be a class type");
 
-        auto k = db_.get_db_key(type, domain, key);
-        auto h = cache_->Lookup(k);
+        auto  dk = db_.get_db_key(type, domain, key);
+        auto  k  = to_slice(dk);
+        auto& sd = get_shard(dk);
+        auto  h  = sd.cache->Lookup(k);
         if(h != nullptr) {
-            auto entry = (cache_entry<T>*)cache_->Value(h);
-            EVT_ASSERT2(entry->ti == boost::typeindex::type_id<T>(), token_database_cache_exception,
-                "Types are not matched between cache({}) and query({})", entry->ti.pretty_name(), boost::typeindex::type_id<T>().pretty_name());
-            return std::unique_ptr<T, cache_deleter<T>>(&entry->data, cache_deleter<T>(this, h));
+            sd.hits.fetch_add(1, std::memory_order_relaxed);
+            auto entry = get_entry<T>(sd, h);
+            return std::unique_ptr<T, cache_deleter<T>>(&entry->data, cache_deleter<T>(sd.cache.get(), h));
         }
+        sd.misses.fetch_add(1, std::memory_order_relaxed);
 
         auto str = std::string();
         auto r   = db_.read_token(type, domain, key, str, no_throw);
@@ -78,11 +113,8 @@ public:
         auto entry = new cache_entry<T>();
         extract_db_value(str, entry->data);
 
-        auto s = cache_->Insert(k, (void*)entry, str.size(),
-            [](auto& ck, auto cv) { delete (cache_entry<T>*)cv; }, &h);
-        FC_ASSERT(s == rocksdb::Status::OK());
-
-        return std::unique_ptr<T, cache_deleter<T>>(&entry->data, cache_deleter<T>(this, h));
+        insert_entry<T>(sd, k, entry, str.size(), &h);
+        return std::unique_ptr<T, cache_deleter<T>>(&entry->data, cache_deleter<T>(sd.cache.get(), h));
     }
 
     template<typename T>
@@ -90,14 +122,16 @@ public:
     lookup_token(token_type type, const std::optional<name128>& domain, const name128& key, bool no_throw = false) {
         static_assert(std::is_class_v<T>, "T should be a class type");
 
-        auto k = db_.get_db_key(type, domain, key);
-        auto h = cache_->Lookup(k);
+        auto  dk = db_.get_db_key(type, domain, key);
+        auto  k  = to_slice(dk);
+        auto& sd = get_shard(dk);
+        auto  h  = sd.cache->Lookup(k);
         if(h != nullptr) {
-            auto entry = (cache_entry<T>*)cache_->Value(h);
-            EVT_ASSERT2(entry->ti == boost::typeindex::type_id<T>(), token_database_cache_exception,
-                "Types are not matched between cache({}) and query({})", entry->ti.pretty_name(), boost::typeindex::type_id<T>().pretty_name());
-            return std::unique_ptr<T, cache_deleter<T>>(&entry->data, cache_deleter<T>(this, h));
+            sd.hits.fetch_add(1, std::memory_order_relaxed);
+            auto entry = get_entry<T>(sd, h);
+            return std::unique_ptr<T, cache_deleter<T>>(&entry->data, cache_deleter<T>(sd.cache.get(), h));
         }
+        sd.misses.fetch_add(1, std::memory_order_relaxed);
         return nullptr;
     }
 
@@ -107,12 +141,13 @@ public:
         static_assert(std::is_class_v<U>, "Underlying of T should be a class type");
         using entry_t = cache_entry<U>;
 
-        auto k = db_.get_db_key(type, domain, key);
-        auto h = cache_->Lookup(k);
+        auto  dk = db_.get_db_key(type, domain, key);
+        auto  k  = to_slice(dk);
+        auto& sd = get_shard(dk);
+        auto  h  = sd.cache->Lookup(k);
         if(h != nullptr) {
-            auto entry = (entry_t*)cache_->Value(h);
-            EVT_ASSERT2(entry->ti == boost::typeindex::type_id<T>(), token_database_cache_exception,
-                "Types are not matched between cache({}) and query({})", entry->ti.pretty_name(), boost::typeindex::type_id<T>().pretty_name());
+            auto entry = get_entry<U>(sd, h);
+            sd.cache->Release(h);
             EVT_ASSERT2(&entry->data == &data, token_database_cache_exception,
                 "Provided updated data object should be the same as original one in cache");
         }
@@ -132,32 +167,154 @@ public:
 
         auto entry = new entry_t(std::forward<T>(data));
         if constexpr(!RtnPTR) {
-            auto s = cache_->Insert(k, (void*)entry, v.size(),
-                [](auto& ck, auto cv) { delete (cache_entry<U>*)cv; }, nullptr /* handle */);
-            FC_ASSERT(s == rocksdb::Status::OK());
+            insert_entry<U>(sd, k, entry, v.size(), nullptr /* handle */);
         }
         else {
-            auto s = cache_->Insert(k, (void*)entry, v.size(),
-                [](auto& ck, auto cv) { delete (cache_entry<U>*)cv; }, &h);
-            FC_ASSERT(s == rocksdb::Status::OK());
-            return std::unique_ptr<U, cache_deleter<U>>(&entry->data, cache_deleter<U>(this, h));
+            insert_entry<U>(sd, k, entry, v.size(), &h);
+            return std::unique_ptr<U, cache_deleter<U>>(&entry->data, cache_deleter<U>(sd.cache.get(), h));
+        }
+    }
+
+public:
+    size_t
+    usage() const {
+        auto n = (size_t)0;
+        for(auto i = 0u; i < shards_num_; i++) {
+            n += shards_[i].cache->GetUsage();
+        }
+        return n;
+    }
+
+    size_t
+    capacity() const {
+        auto n = (size_t)0;
+        for(auto i = 0u; i < shards_num_; i++) {
+            n += shards_[i].cache->GetCapacity();
+        }
+        return n;
+    }
+
+    // shrinking evicts the unreferenced entries over the new capacity at once
+    void
+    set_capacity(size_t cache_size) {
+        for(auto i = 0u; i < shards_num_; i++) {
+            shards_[i].cache->SetCapacity(std::max(cache_size / shards_num_, (size_t)1));
         }
     }
 
 private:
+    static size_t
+    normalize_shards_num(size_t num) {
+        EVT_ASSERT(num > 0, token_database_cache_exception, "Shards number of object cache should be positive");
+        // round up to power of two in order to select shard by mask
+        auto n = (size_t)1;
+        while(n < num) {
+            n <<= 1;
+        }
+        return n;
+    }
+
+    static rocksdb::Slice
+    to_slice(const token_db_key& dk) {
+        auto sv = dk.as_string_view();
+        return rocksdb::Slice(sv.data(), sv.size());
+    }
+
+    shard&
+    get_shard(const token_db_key& dk) const {
+        // both parts are already well distributed names, fold them instead of hashing bytes
+        auto v = dk.prefix.value ^ (dk.key.value * 0x9E3779B97F4A7C15ull);
+        auto h = (uint64_t)v ^ (uint64_t)(v >> 64);
+        return shards_[(h ^ (h >> 29)) & (shards_num_ - 1)];
+    }
+
+    template<typename T>
+    cache_entry<T>*
+    get_entry(shard& sd, rocksdb::Cache::Handle* h) {
+        auto base = (cache_entry_base*)sd.cache->Value(h);
+        if(base->ti != boost::typeindex::type_id<T>()) {
+            sd.cache->Release(h);
+            EVT_THROW2(token_database_cache_exception, "Types are not matched between cache({}) and query({})",
+                base->ti.pretty_name(), boost::typeindex::type_id<T>().pretty_name());
+        }
+        return static_cast<cache_entry<T>*>(base);
+    }
+
+    template<typename T>
+    void
+    insert_entry(shard& sd, const rocksdb::Slice& k, cache_entry<T>* entry, size_t charge, rocksdb::Cache::Handle** h) {
+        entry->owner = &sd;
+
+        auto s = sd.cache->Insert(k, (void*)static_cast<cache_entry_base*>(entry), charge,
+            [](auto& ck, auto cv) {
+                auto base = (cache_entry_base*)cv;
+                if(!base->erased) {
+                    base->owner->evictions.fetch_add(1, std::memory_order_relaxed);
+                }
+                delete static_cast<cache_entry<T>*>(base);
+            }, h);
+        FC_ASSERT(s == rocksdb::Status::OK());
+    }
+
+    void
+    erase(const rocksdb::Slice& key) {
+        if(key.size() != sizeof(token_db_key)) {
+            // only token keys are cached
+            return;
+        }
+
+        auto  dk = token_db_key();
+        memcpy(&dk, key.data(), sizeof(dk));
+        auto& sd = get_shard(dk);
+        auto  h  = sd.cache->Lookup(key);
+        if(h == nullptr) {
+            return;
+        }
+        ((cache_entry_base*)sd.cache->Value(h))->erased = true;
+        sd.cache->Release(h);
+        sd.cache->Erase(key);
+    }
+
+    void
+    append_stats(std::string& out) const {
+        auto total_hits = 0ul, total_misses = 0ul, total_evictions = 0ul;
+
+        out.append("\n** Object Cache Stats **\n");
+        for(auto i = 0u; i < shards_num_; i++) {
+            auto& sd = shards_[i];
+            auto  h  = sd.hits.load(std::memory_order_relaxed);
+            auto  m  = sd.misses.load(std::memory_order_relaxed);
+            auto  e  = sd.evictions.load(std::memory_order_relaxed);
+            out.append(fmt::format("shard {:>3}: hits: {}, misses: {}, evictions: {}, usage: {}\n",
+                i, h, m, e, sd.cache->GetUsage()));
+
+            total_hits      += h;
+            total_misses    += m;
+            total_evictions += e;
+        }
+        out.append(fmt::format("total    : hits: {}, misses: {}, evictions: {}\n",
+            total_hits, total_misses, total_evictions));
+    }
+
     void
     watch_db() {
-        db_.rollback_token_value.connect([this](auto& key) {
-            cache_->Erase(key);
+        value_conns_[0] = db_.rollback_token_value.connect([this](auto& key) {
+            erase(key);
+        });
+        value_conns_[1] = db_.remove_token_value.connect([this](auto& key) {
+            erase(key);
         });
-        db_.remove_token_value.connect([this](auto& key) {
-            cache_->Erase(key);
+        stats_conn_ = db_.collect_stats.connect([this](auto& out) {
+            append_stats(out);
         });
     }
 
 private:
-    token_database&                 db_;
-    std::shared_ptr<rocksdb::Cache> cache_;
+    token_database&                     db_;
+    size_t                              shards_num_;
+    std::unique_ptr<shard[]>            shards_;
+    utilities::scoped_signal_connection value_conns_[2];
+    boost::signals2::scoped_connection  stats_conn_;
 };
 
 template<typename T>
@@ -14,6 +14,12 @@ namespace token_database_snapshot {
 void add_to_snapshot(snapshot_writer_ptr snapshot, const token_database& db);
 void read_from_snapshot(snapshot_reader_ptr snapshot, token_database& db);
 
+// writes only the values added or changed since the state of `bases`, which are a full snapshot
+// followed by the diffs taken after it in order
+void add_diff_to_snapshot(snapshot_writer_ptr snapshot, const token_database& db, const std::vector<snapshot_reader_ptr>& bases);
+// puts the values of a diff onto the state of its bases, which is restored already
+void read_diff_from_snapshot(snapshot_reader_ptr snapshot, token_database& db);
+
 }  // namespace token_database_snapshot
 
 }}  // namespace evt::chain
@@ -32,6 +32,11 @@ struct action_trace {
     fc::microseconds elapsed;
     string           console;
 
+    // point operations of token database done by the action
+    uint32_t db_reads  = 0;
+    uint32_t db_writes = 0;
+    uint32_t db_misses = 0;
+
     transaction_id_type  trx_id; ///< the transaction that generated this action
     uint32_t             block_num = 0;
     block_timestamp_type block_time;
@@ -63,5 +68,5 @@ struct transaction_trace {
 }}  // namespace evt::chain
 
 FC_REFLECT(evt::chain::ft_holder, (addr)(sym_id));
-FC_REFLECT(evt::chain::action_trace, (receipt)(act)(elapsed)(console)(trx_id)(block_num)(block_time)(producer_block_id)(except)(generated_actions)(new_ft_holders));
+FC_REFLECT(evt::chain::action_trace, (receipt)(act)(elapsed)(console)(db_reads)(db_writes)(db_misses)(trx_id)(block_num)(block_time)(producer_block_id)(except)(generated_actions)(new_ft_holders));
 FC_REFLECT(evt::chain::transaction_trace, (id)(receipt)(elapsed)(is_suspend)(action_traces)(charge)(net_usage)(except));
@@ -4,6 +4,7 @@
  */
 #pragma once
 
+#include <memory>
 #include <numeric>
 #include <evt/chain/action.hpp>
 #include <evt/chain/address.hpp>
@@ -72,6 +73,18 @@ struct transaction : public transaction_header {
     total_actions() const {
         return actions.size();
     }
+
+    // counters of the process wide cache of keys recovered from signatures
+    struct recovery_cache_stats {
+        uint64_t hits   = 0;
+        uint64_t misses = 0;
+    };
+
+    static constexpr size_t kDefaultRecoveryCacheSize = 100000;
+
+    // keys kept by the cache, by signature and digest, 0 disables it
+    static void                 set_recovery_cache_size(size_t size);
+    static recovery_cache_stats get_recovery_cache_stats();
 };
 
 struct signed_transaction : public transaction {
@@ -96,6 +109,7 @@ public:
     enum compression_type {
         none = 0,
         zlib = 1,
+        zstd = 2,  // single frame with content size, no dictionary
     };
 
 public:
@@ -108,31 +122,40 @@ public:
     explicit packed_transaction(const signed_transaction& t, compression_type _compression = none)
         : signatures(t.signatures), compression(_compression), unpacked_trx(t) {
         local_pack_transaction();
+        local_compute_ids();
     }
 
     explicit packed_transaction(signed_transaction&& t, compression_type _compression = none)
         : signatures(std::move(t.signatures)), compression(_compression), unpacked_trx(std::move(t)) {
         local_pack_transaction();
+        local_compute_ids();
     }
 
     // used by abi_serializer
     packed_transaction(bytes&& packed_txn, signatures_type&& sigs, compression_type _compression = none)
         : signatures(std::move(sigs)), compression(_compression), packed_trx(std::move(packed_txn)) {
         local_unpack_transaction();
+        local_compute_ids();
     }
 
     packed_transaction(transaction&& t, signatures_type&& sigs, compression_type _compression = none)
         : signatures(std::move(sigs)), compression(_compression), unpacked_trx(std::move(t), signatures) {
         local_pack_transaction();
+        local_compute_ids();
     }
 
 public:
     uint32_t get_unprunable_size() const;
     uint32_t get_prunable_size() const;
 
+    // computed once along with the ids
     digest_type packed_digest() const;
 
-    transaction_id_type id() const { return unpacked_trx.id(); }
+    // computed once from the packed bytes, no re-pack of the transaction
+    transaction_id_type id() const;
+    transaction_id_type signed_id() const { return signed_trx_id; }
+    digest_type         sig_digest(const chain_id_type& chain_id) const;
+    public_keys_set     get_signature_keys(const chain_id_type& chain_id, bool allow_duplicate_keys = false) const;
     bytes               get_raw_transaction() const;
 
     time_point_sec            expiration() const { return unpacked_trx.expiration; }
@@ -150,6 +173,7 @@ private:
 private:
     void local_unpack_transaction();
     void local_pack_transaction();
+    void local_compute_ids();
 
     friend struct fc::reflector<packed_transaction>;
     friend struct fc::reflector_init_visitor<packed_transaction>;
@@ -159,6 +183,15 @@ private:
 private:
     // cache unpacked trx, for thread safety do not modify after construction
     signed_transaction unpacked_trx;
+
+    // set by local_compute_ids() along with unpacked_trx, do not modify after construction either
+    transaction_id_type trx_id;
+    transaction_id_type signed_trx_id;
+    digest_type         packed_trx_digest;
+    bool                raw_canonical = false;
+
+    // digest to sign for the last chain id asked, swapped atomically
+    mutable std::shared_ptr<const std::pair<chain_id_type, digest_type>> sig_digest_cache;
 };
 
 using packed_transaction_ptr = std::shared_ptr<packed_transaction>;
@@ -169,6 +202,6 @@ FC_REFLECT(evt::chain::transaction_header, (expiration)(ref_block_num)(ref_block
 FC_REFLECT_ENUM(evt::chain::transaction_ext, (suspend_name));
 FC_REFLECT_DERIVED(evt::chain::transaction, (evt::chain::transaction_header), (actions)(payer)(transaction_extensions));
 FC_REFLECT_DERIVED(evt::chain::signed_transaction, (evt::chain::transaction), (signatures));
-FC_REFLECT_ENUM(evt::chain::packed_transaction::compression_type, (none)(zlib));
+FC_REFLECT_ENUM(evt::chain::packed_transaction::compression_type, (none)(zlib)(zstd));
 // @ignore unpacked_trx
 FC_REFLECT(evt::chain::packed_transaction, (signatures)(compression)(packed_trx));
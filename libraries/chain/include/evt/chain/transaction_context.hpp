@@ -3,9 +3,11 @@
  *  @copyright defined in evt/LICENSE.txt
  */
 #pragma once
+#include <evt/chain/deadline_timer.hpp>
 #include <evt/chain/execution_context_impl.hpp>
 #include <evt/chain/trace.hpp>
 #include <evt/chain/token_database.hpp>
+#include <evt/chain/transaction_object.hpp>
 
 namespace evt { namespace chain {
 
@@ -52,8 +54,10 @@ public:
     controller&            control;
     evt_execution_context& exec_ctx;
     
-    optional<chainbase::database::session> undo_session;
-    optional<token_database::session>      undo_token_session;
+    // transactions only record themselves in chainbase, so the session covers that index alone
+    // instead of pushing an undo state onto every index
+    optional<chainbase::generic_index<transaction_multi_index>::session> undo_session;
+    optional<token_database::session>                                    undo_token_session;
 
     const transaction_metadata_ptr trx_meta;
     const signed_transaction&      trx;
@@ -71,7 +75,8 @@ public:
     fc::time_point deadline = fc::time_point::maximum();
 
 private:
-    bool is_initialized = false;
+    deadline_timer timer;  // raised once `deadline` passes, started by `init`
+    bool           is_initialized = false;
 };
 
 }}  // namespace evt::chain
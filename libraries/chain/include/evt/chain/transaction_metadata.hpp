@@ -3,47 +3,94 @@
  *  @copyright defined in evt/LICENSE.txt
  */
 #pragma once
+#include <array>
+#include <future>
 #include <boost/noncopyable.hpp>
 #include <evt/chain/block.hpp>
 #include <evt/chain/trace.hpp>
 #include <evt/chain/transaction.hpp>
+#include <evt/utilities/pooled_allocator.hpp>
+
+namespace evt { namespace utilities {
+class task_scheduler;
+}}  // namespace evt::utilities
 
 namespace evt { namespace chain {
 
+class transaction_metadata;
+using transaction_metadata_ptr = std::shared_ptr<transaction_metadata>;
+
 /**
  *  This data structure should store context-free cached data about a transaction such as
  *  packed/unpacked/compressed and recovered keys
  */
 class transaction_metadata : boost::noncopyable {
+public:
+    using signing_keys_type        = std::pair<chain_id_type, public_keys_set>;
+    using signing_keys_future_type = std::shared_future<signing_keys_type>;
+    // signatures number, whether charge is scaled down and the four charge factors
+    using charge_key_type          = std::array<uint32_t, 6>;
+
 public:
     transaction_id_type                             id;
     transaction_id_type                             signed_id;
     packed_transaction_ptr                          packed_trx;
     optional<pair<chain_id_type, public_keys_set>>  signing_keys;
+    signing_keys_future_type                        signing_keys_future;
+    optional<pair<charge_key_type, uint32_t>>       charge;
     bool                                            accepted = false;
     bool                                            implicit = false;
 
 public:
     explicit transaction_metadata(const signed_transaction& t, packed_transaction::compression_type c = packed_transaction::none)
-        : id(t.id()), packed_trx(std::make_shared<packed_transaction>(t, c)) {
-        signed_id = digest_type::hash(*packed_trx);
+        : packed_trx(std::make_shared<packed_transaction>(t, c)) {
+        id        = packed_trx->id();
+        signed_id = packed_trx->signed_id();
     }
 
     explicit transaction_metadata(const packed_transaction_ptr& ptrx)
-        : id(ptrx->id()), packed_trx(ptrx) {
-        signed_id = digest_type::hash(*packed_trx);
-    }
+        : id(ptrx->id()), signed_id(ptrx->signed_id()), packed_trx(ptrx) {}
+
+public:
+    // starts recovering the signing keys of `mtrx` in `pool`, `recover_keys` only waits for the result then
+    // returns the existing future if recovery is already started
+    static signing_keys_future_type create_signing_keys_future(const transaction_metadata_ptr& mtrx, utilities::task_scheduler& scheduler, const chain_id_type& chain_id);
 
 public:
     const public_keys_set&
     recover_keys(const chain_id_type& chain_id) {
         if(!signing_keys.has_value() || signing_keys->first != chain_id) {  // Unlikely for more than one chain_id to be used in one nodeos instance
-            signing_keys = std::make_pair(chain_id, packed_trx->get_signed_transaction().get_signature_keys(chain_id));
+            if(signing_keys_future.valid()) {
+                // rethrows the exception raised during recovery
+                auto& keys = signing_keys_future.get();
+                if(keys.first == chain_id) {
+                    signing_keys = keys;
+                    return signing_keys->second;
+                }
+            }
+            signing_keys = std::make_pair(chain_id, packed_trx->get_signature_keys(chain_id));
         }
         return signing_keys->second;
     }
 };
 
-using transaction_metadata_ptr = std::shared_ptr<transaction_metadata>;
+/**
+ *  Metadata and packed transaction of each transaction are pooled, they're created and freed
+ *  for every transaction on several threads
+ */
+inline transaction_metadata_ptr
+make_transaction_metadata(const packed_transaction_ptr& ptrx) {
+    return utilities::make_pooled<transaction_metadata>(ptrx);
+}
+
+inline transaction_metadata_ptr
+make_transaction_metadata(const packed_transaction& trx) {
+    return make_transaction_metadata(utilities::make_pooled<packed_transaction>(trx));
+}
+
+inline transaction_metadata_ptr
+make_transaction_metadata(packed_transaction&& trx) {
+    return make_transaction_metadata(utilities::make_pooled<packed_transaction>(std::move(trx)));
+}
 
 }}  // namespace evt::chain
@@ -0,0 +1,50 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <evt/chain/transaction.hpp>
+
+namespace evt { namespace chain {
+
+/**
+ *  Partitions the transactions of one block into groups which don't conflict with each other,
+ *  based on the footprint declared by `domain` and `key` of their actions and the payer.
+ *
+ *  Transactions are added in receipt order. Actions whose footprint cannot be declared up front
+ *  (like `everipay` or `distpsvbonus`) make the transaction serial, which acts as a barrier:
+ *  it closes the current segment and forms a segment by itself.
+ *
+ *  The charge given to producer is a commutative add and is not part of the footprint,
+ *  executor needs to merge it when merging the results.
+ */
+class transaction_partitioner {
+public:
+    struct segment {
+        bool                               serial = false;
+        std::vector<std::vector<uint32_t>> groups;  // indexes of trxs, each group in receipt order
+    };
+
+public:
+    void add(const transaction& trx);
+    std::vector<segment> finalize();
+
+public:
+    static bool is_serial_action(const action& act);
+
+private:
+    void close_segment();
+    uint32_t find_root(uint32_t g);
+
+private:
+    uint32_t                                  index_ = 0;
+    std::vector<segment>                      segments_;
+    std::unordered_map<std::string, uint32_t> keys_;         // footprint key -> group
+    std::vector<uint32_t>                     parents_;      // union-find of groups in current segment
+    std::vector<std::vector<uint32_t>>        groups_;
+};
+
+}}  // namespace evt::chain
@@ -0,0 +1,51 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+#include <memory>
+#include <optional>
+#include <boost/noncopyable.hpp>
+#include <fc/filesystem.hpp>
+#include <evt/chain/block.hpp>
+
+namespace rocksdb {
+class DB;
+}  // namespace rocksdb
+
+namespace evt { namespace chain {
+
+/**
+ *  Optional index of the transactions in irreversible blocks, which is still there after they
+ *  expire and are removed from the state. Keys are the first 16 bytes of transaction ids, values
+ *  are the numbers of blocks and positions of transactions in them.
+ *
+ *  Blocks are added in order along with the number of the last one in one batch, blocks at or
+ *  below it are ignored. A gap (e.g. a node restored from a snapshot) is left unindexed.
+ */
+class trx_index : boost::noncopyable {
+public:
+    struct location {
+        uint32_t block_num;
+        uint32_t trx_pos;  // position in `transactions` of the block
+    };
+
+public:
+    explicit trx_index(const fc::path& dir);
+    ~trx_index();
+
+public:
+    void add(const signed_block& b);
+
+    std::optional<location> find(const transaction_id_type& id) const;
+    uint32_t                last_num() const { return last_num_; }  // 0 when empty
+
+    fc::path path() const { return dir_; }
+
+private:
+    fc::path     dir_;
+    rocksdb::DB* db_       = nullptr;
+    uint32_t     last_num_ = 0;
+};
+
+}}  // namespace evt::chain
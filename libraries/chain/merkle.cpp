@@ -3,7 +3,10 @@
  *  @copyright defined in evt/LICENSE.txt
  */
 #include <evt/chain/merkle.hpp>
+
+#include <future>
 #include <fc/io/raw.hpp>
+#include <evt/utilities/task_scheduler.hpp>
 
 namespace evt { namespace chain {
 
@@ -39,24 +42,76 @@ is_canonical_right(const digest_type& val) {
     return (val._hash[0] & 0x0000000000000080ULL) != 0;
 }
 
+namespace internal {
+
+// pairs of one level hashed by every task when the level is spread to the thread pool
+constexpr auto kMerkleChunkPairs = 1024u;
+
+template <typename HashPairs>
 digest_type
-merkle(vector<digest_type> ids) {
+merkle(vector<digest_type>& ids, HashPairs&& hash_pairs) {
     if(0 == ids.size()) {
         return digest_type();
     }
 
+    // every pair of a level is packed into one buffer and hashed in batches,
+    // same bytes as hashing `make_canonical_pair` of them one by one
+    auto pairs = std::vector<digest_type>();
     while(ids.size() > 1) {
         if(ids.size() % 2)
             ids.push_back(ids.back());
 
-        for(auto i = 0u; i < ids.size() / 2; i++) {
-            ids[i] = digest_type::hash(make_canonical_pair(ids[2 * i], ids[(2 * i) + 1]));
+        pairs.resize(ids.size());
+        for(auto i = 0u; i < ids.size(); i += 2) {
+            pairs[i]     = make_canonical_left(ids[i]);
+            pairs[i + 1] = make_canonical_right(ids[i + 1]);
         }
 
         ids.resize(ids.size() / 2);
+        hash_pairs(pairs.data(), ids.size(), ids.data());
     }
 
     return ids.front();
 }
 
+void
+hash_pairs(const digest_type* pairs, size_t n, digest_type* out) {
+    digest_type::hash_many(pairs->data(), sizeof(digest_type) * 2, n, out);
+}
+
+}  // namespace internal
+
+digest_type
+merkle(vector<digest_type> ids) {
+    return internal::merkle(ids, internal::hash_pairs);
+}
+
+digest_type
+merkle(vector<digest_type> ids, utilities::task_scheduler& scheduler) {
+    using namespace internal;
+
+    return internal::merkle(ids, [&scheduler](auto pairs, auto n, auto out) {
+        if(n < kMerkleChunkPairs * 2) {
+            hash_pairs(pairs, n, out);
+            return;
+        }
+
+        // the last chunk is hashed on this thread while the others run on the workers
+        auto tasks = std::vector<std::future<void>>();
+        auto i     = 0u;
+        for(; i + kMerkleChunkPairs < n; i += kMerkleChunkPairs) {
+            auto task = std::make_shared<std::packaged_task<void()>>([pairs, out, i] {
+                hash_pairs(pairs + i * 2, kMerkleChunkPairs, out + i);
+            });
+            tasks.emplace_back(task->get_future());
+            scheduler.post([task] { (*task)(); });
+        }
+        hash_pairs(pairs + i * 2, n - i, out + i);
+
+        for(auto& t : tasks) {
+            t.get();
+        }
+    });
+}
+
 }}  // namespace evt::chain
@@ -9,6 +9,22 @@
 
 namespace evt { namespace chain {
 
+namespace internal {
+
+// a name is normalized when every char has a symbol and it doesn't end with '.',
+// which are the only names that survive a round trip through to_string()
+inline bool
+is_normalized(const char* str, size_t len) {
+    for(auto i = 0u; i < len; i++) {
+        if(str[i] != '.' && char_to_symbol128(str[i]) == 0) {
+            return false;
+        }
+    }
+    return len == 0 || str[len - 1] != '.';
+}
+
+}  // namespace internal
+
 void
 name128::set(const char* str) {
     const auto len = strnlen(str, 22);
@@ -16,7 +32,7 @@ name128::set(const char* str) {
                ("name", std::string(str)));
     EVT_ASSERT(len > 0, name128_type_exception, "Name128 cannot be empty");
     value = string_to_name128(str);
-    EVT_ASSERT(to_string() == std::string(str), name128_type_exception,
+    EVT_ASSERT(internal::is_normalized(str, len), name128_type_exception,
                "Name128 not properly normalized (name: ${name}, normalized: ${normalized}) ",
                ("name", std::string(str))("normalized", to_string()));
 }
@@ -27,18 +43,16 @@ name128::set(const std::string& str) {
     EVT_ASSERT(len <= 21, name128_type_exception, "Name128 is longer than 21 characters (${name}) ",
                ("name", str));
     value = string_to_name128(str.c_str());
-    EVT_ASSERT(to_string() == str, name128_type_exception,
+    EVT_ASSERT(internal::is_normalized(str.c_str(), len), name128_type_exception,
                "Name128 not properly normalized (name: ${name}, normalized: ${normalized}) ",
                ("name", str)("normalized", to_string()));
 }
 
-name128::operator std::string() const {
+size_t
+name128::to_string(char* buf) const {
     static const char* charmap = ".-0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
 
-    auto str = std::string(21, '.');
-    
     auto stop = 0u;
-    auto tmp  = value >> 2;
     auto tag  = (int)value & 0x03;
 
     switch(tag) {
@@ -60,13 +74,29 @@ name128::operator std::string() const {
     }
     }  // switch
 
-    for(auto i = 0u; i < stop; ++i, tmp >>= 6) {
-        auto c = charmap[tmp & 0x3f];
-        str[i] = c;
+    auto tmp = (value >> 2) & (((uint128_t)1 << (6 * stop)) - 1);
+    if(tmp == 0) {
+        return 0;
     }
 
-    str.erase(str.find_last_not_of('.', stop) + 1);
-    return str;
+    // only the chars up to the last non-zero symbol are kept, trailing dots are dropped
+    auto hi   = (uint64_t)(tmp >> 64);
+    auto bits = hi ? (128 - __builtin_clzll(hi)) : (64 - __builtin_clzll((uint64_t)tmp));
+    auto len  = (size_t)(bits + 5) / 6;
+
+    // extracts 10 symbols at a time from a 64-bit word instead of shifting the 128-bit value each time
+    for(auto i = 0u; i < len; i += 10) {
+        auto w = (uint64_t)(tmp >> (6 * i));
+        for(auto j = i; j < len && j < i + 10; j++, w >>= 6) {
+            buf[j] = charmap[w & 0x3f];
+        }
+    }
+    return len;
+}
+
+name128::operator std::string() const {
+    char buf[21];
+    return std::string(buf, to_string(buf));
 }
 
 name128
@@ -0,0 +1,218 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#include <evt/chain/reversible_block_store.hpp>
+
+#include <boost/filesystem.hpp>
+#include <fc/io/raw.hpp>
+#include <evt/chain/exceptions.hpp>
+
+namespace evt { namespace chain {
+
+namespace internal {
+
+// block number and size before each packed block
+const uint64_t kRecordHeaderSize = sizeof(uint32_t) * 2;
+// pruned prefix is only rewritten once it's worth it
+const uint64_t kMinCompactBytes = 16 * 1024 * 1024;
+
+}  // namespace internal
+
+reversible_block_store::reversible_block_store(const fc::path& dir)
+    : dir_(dir) {
+    open();
+}
+
+reversible_block_store::~reversible_block_store() {
+    try {
+        flush();
+    }
+    catch(...) {}
+}
+
+void
+reversible_block_store::open() {
+    using namespace internal;
+
+    if(!fc::is_directory(dir_)) {
+        fc::create_directories(dir_);
+    }
+    if(!fc::exists(path())) {
+        std::ofstream(path().generic_string().c_str(), std::ios::out | std::ios::binary);
+    }
+
+    auto fsize = (uint64_t)boost::filesystem::file_size(path());
+    auto valid = (uint64_t)0;
+    {
+        auto in = std::ifstream(path().generic_string().c_str(), std::ios::in | std::ios::binary);
+        while(valid + kRecordHeaderSize <= fsize) {
+            auto num  = uint32_t(0);
+            auto size = uint32_t(0);
+            in.seekg(valid);
+            fc::raw::unpack(in, num);
+            fc::raw::unpack(in, size);
+            if(!in || valid + kRecordHeaderSize + size > fsize) {
+                break;
+            }
+
+            // the same as adding it, a fork switch rewrote the blocks from `num`
+            if(!index_.empty() && num != index_.rbegin()->first + 1) {
+                if(num <= index_.rbegin()->first) {
+                    index_.erase(index_.lower_bound(num), index_.end());
+                }
+                else {
+                    index_.clear();
+                }
+            }
+            index_[num] = position{ valid + kRecordHeaderSize, size };
+            valid += kRecordHeaderSize + size;
+        }
+    }
+
+    if(valid < fsize) {
+        wlog("Reversible blocks file has an incomplete record at the end, truncated ${n} bytes", ("n", fsize - valid));
+        boost::filesystem::resize_file(path(), valid);
+        recovered_bytes_ = fsize - valid;
+    }
+    end_ = valid;
+
+    file_.exceptions(std::fstream::failbit | std::fstream::badbit);
+    file_.open(path().generic_string().c_str(), std::ios::in | std::ios::out | std::ios::binary);
+}
+
+void
+reversible_block_store::add(const signed_block_ptr& b) {
+    using namespace internal;
+
+    auto num = b->block_num();
+    if(!index_.empty()) {
+        auto last = index_.rbegin()->first;
+        if(num <= last) {
+            remove_from(num);
+        }
+        else if(num != last + 1) {
+            // blocks are consecutive, older ones can't be reached anymore
+            index_.clear();
+        }
+    }
+
+    auto data = fc::raw::pack(*b);
+    file_.seekp(end_);
+    fc::raw::pack(file_, num);
+    fc::raw::pack(file_, (uint32_t)data.size());
+    file_.write(data.data(), data.size());
+    file_.flush();
+
+    index_[num] = position{ end_ + kRecordHeaderSize, (uint32_t)data.size() };
+    end_ += kRecordHeaderSize + data.size();
+}
+
+signed_block_ptr
+reversible_block_store::get(uint32_t num) const {
+    auto it = index_.find(num);
+    if(it == index_.end()) {
+        return nullptr;
+    }
+
+    auto data = std::vector<char>(it->second.size);
+    file_.seekg(it->second.offset);
+    file_.read(data.data(), data.size());
+
+    auto ds = fc::datastream<const char*>(data.data(), data.size());
+    auto b  = make_signed_block();
+    fc::raw::unpack(ds, *b);
+    EVT_ASSERT(b->block_num() == num, reversible_blocks_exception,
+        "Reversible block ${n} is corrupted, it's #${b} actually", ("n", num)("b", b->block_num()));
+    return b;
+}
+
+void
+reversible_block_store::remove_from(uint32_t num) {
+    auto it = index_.lower_bound(num);
+    if(it == index_.end()) {
+        return;
+    }
+    truncate(it->second.offset - internal::kRecordHeaderSize);
+    index_.erase(it, index_.end());
+}
+
+void
+reversible_block_store::prune(uint32_t lib) {
+    using namespace internal;
+
+    index_.erase(index_.begin(), index_.upper_bound(lib));
+
+    auto dead = index_.empty() ? end_ : index_.begin()->second.offset - kRecordHeaderSize;
+    if(dead >= kMinCompactBytes && dead >= end_ - dead) {
+        compact();
+    }
+}
+
+void
+reversible_block_store::truncate(uint64_t offset) {
+    file_.flush();
+    boost::filesystem::resize_file(path(), offset);
+    end_ = offset;
+}
+
+void
+reversible_block_store::compact() {
+    using namespace internal;
+
+    // only the live blocks are copied, there're few of them once LIB moves
+    auto tmp   = dir_ / (std::string(filename()) + ".tmp");
+    auto index = std::map<uint32_t, position>();
+    auto end   = (uint64_t)0;
+    {
+        auto out = std::ofstream(tmp.generic_string().c_str(), std::ios::out | std::ios::binary | std::ofstream::trunc);
+        out.exceptions(std::ofstream::failbit | std::ofstream::badbit);
+
+        auto data = std::vector<char>();
+        for(auto& it : index_) {
+            data.resize(it.second.size);
+            file_.seekg(it.second.offset);
+            file_.read(data.data(), data.size());
+
+            fc::raw::pack(out, it.first);
+            fc::raw::pack(out, it.second.size);
+            out.write(data.data(), data.size());
+
+            index[it.first] = position{ end + kRecordHeaderSize, it.second.size };
+            end += kRecordHeaderSize + it.second.size;
+        }
+        out.flush();
+    }
+
+    file_.close();
+    fc::rename(tmp, path());
+    file_.open(path().generic_string().c_str(), std::ios::in | std::ios::out | std::ios::binary);
+
+    index_ = std::move(index);
+    end_   = end;
+}
+
+void
+reversible_block_store::flush() {
+    if(file_.is_open()) {
+        file_.flush();
+    }
+}
+
+std::optional<uint32_t>
+reversible_block_store::first_num() const {
+    if(index_.empty()) {
+        return std::nullopt;
+    }
+    return index_.begin()->first;
+}
+
+std::optional<uint32_t>
+reversible_block_store::last_num() const {
+    if(index_.empty()) {
+        return std::nullopt;
+    }
+    return index_.rbegin()->first;
+}
+
+}}  // namespace evt::chain
@@ -1,13 +1,58 @@
 #include <evt/chain/snapshot.hpp>
 
+#include <algorithm>
+#include <deque>
+#include <limits>
+
 #include <boost/algorithm/string/predicate.hpp>
+#include <boost/iostreams/concepts.hpp>
+#include <boost/iostreams/copy.hpp>
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
 #include <boost/iostreams/filter/zlib.hpp>
+#include <boost/iostreams/operations.hpp>
 
 #include <fc/scoped_exit.hpp>
 #include <evt/chain/exceptions.hpp>
 
 namespace evt { namespace chain {
 
+namespace detail {
+
+/**
+ * Passes the data through and feeds it into the encoder
+ */
+struct sha256_output_filter : boost::iostreams::multichar_output_filter {
+    explicit sha256_output_filter(fc::sha256::encoder& enc)
+        : enc(&enc) {}
+
+    template <typename Sink>
+    std::streamsize
+    write(Sink& snk, const char* s, std::streamsize n) {
+        auto r = boost::iostreams::write(snk, s, n);
+        if(r > 0) {
+            enc->write(s, r);
+        }
+        return r;
+    }
+
+    fc::sha256::encoder* enc;
+};
+
+std::string
+inflate(const std::string& data) {
+    namespace io = boost::iostreams;
+
+    auto out = std::string();
+    auto in  = io::filtering_istream();
+    in.push(io::zlib_decompressor());
+    in.push(io::array_source(data.data(), data.size()));
+    io::copy(in, io::back_inserter(out));
+    return out;
+}
+
+}  // namespace detail
+
 variant_snapshot_writer::variant_snapshot_writer(fc::mutable_variant_object& snapshot)
     : snapshot(snapshot) {
     snapshot.set("sections", fc::variants());
@@ -153,12 +198,16 @@ ostream_snapshot_writer::ostream_snapshot_writer(std::ostream& snapshot)
     , section_pos(-1)
     , row_count(0) {
     // write magic number
-    auto totem = magic_number;
+    auto totem = magic_number_v2;
     snapshot.write((char*)&totem, sizeof(totem));
 
     // write version
     auto version = current_snapshot_version;
     snapshot.write((char*)&version, sizeof(version));
+
+    // write a placeholder for the position of section table
+    uint64_t placeholder = std::numeric_limits<uint64_t>::max();
+    snapshot.write((char*)&placeholder, sizeof(placeholder));
 }
 
 void
@@ -166,25 +215,16 @@ ostream_snapshot_writer::write_start_section(const std::string& section_name) {
     namespace io = boost::iostreams;
 
     EVT_ASSERT(section_pos == std::streampos(-1), snapshot_exception, "Attempting to write a new section without closing the previous section");
-    section_pos = snapshot.tellp();
-    row_count   = 0;
-
-    uint64_t placeholder = std::numeric_limits<uint64_t>::max();
-
-    // write a placeholder for the section size
-    snapshot.write((char*)&placeholder, sizeof(placeholder));
+    section_pos        = snapshot.tellp();
+    row_count          = 0;
+    this->section_name = section_name;
+    section_enc.reset();
 
-    // write placeholder for row count
-    snapshot.write((char*)&placeholder, sizeof(placeholder));
-
-    // write the section name (null terminated)
-    snapshot.write(section_name.data(), section_name.size());
-    snapshot.put('\0');
-
-    // setup row stream
+    // setup row stream, compressed data is hashed on the way to the snapshot
     assert(!row_stream.has_value());
     row_stream.emplace();
     row_stream->push(io::zlib_compressor());
+    row_stream->push(detail::sha256_output_filter(section_enc));
     row_stream->push(snapshot.inner);
 }
 
@@ -210,17 +250,13 @@ ostream_snapshot_writer::write_end_section() {
     io::close(*row_stream);
     row_stream.reset();
 
-    // seek to section pos
-    auto restore = snapshot.tellp();
-    uint64_t section_size = restore - section_pos - sizeof(uint64_t);
-    snapshot.seekp(section_pos);
-
-    // write a the section size
-    snapshot.write((char*)&section_size, sizeof(section_size));
-
-    // write the row count
-    snapshot.write((char*)&row_count, sizeof(row_count));
-    snapshot.seekp(restore);
+    sections.emplace_back(detail::snapshot_section_entry {
+        .name      = std::move(section_name),
+        .pos       = (uint64_t)section_pos,
+        .row_count = row_count,
+        .size      = (uint64_t)(snapshot.tellp() - section_pos),
+        .checksum  = section_enc.result()
+    });
 
     // clear state
     section_pos = std::streampos(-1);
@@ -229,15 +265,22 @@ ostream_snapshot_writer::write_end_section() {
 
 void
 ostream_snapshot_writer::finalize() {
-    uint64_t end_marker = std::numeric_limits<uint64_t>::max();
+    EVT_ASSERT(section_pos == std::streampos(-1), snapshot_exception, "Attempting to finalize snapshot without closing the last section");
+
+    // write the section table and then its position into header
+    uint64_t table_pos = snapshot.tellp();
+    fc::raw::pack(snapshot, sections);
 
-    // write a placeholder for the section size
-    snapshot.write((char*)&end_marker, sizeof(end_marker));
+    auto restore = snapshot.tellp();
+    snapshot.seekp(header_pos + std::streamoff(sizeof(magic_number_v2) + sizeof(current_snapshot_version)));
+    snapshot.write((char*)&table_pos, sizeof(table_pos));
+    snapshot.seekp(restore);
 }
 
 istream_snapshot_reader::istream_snapshot_reader(std::istream& snapshot)
     : snapshot(snapshot)
     , header_pos(snapshot.tellg())
+    , format(1)
     , num_rows(0)
     , cur_row(0) {
     build_section_indexes();
@@ -247,6 +290,7 @@ void
 istream_snapshot_reader::validate() const {
     // make sure to restore the read pos
     auto restore_pos = fc::make_scoped_exit([this, pos = snapshot.tellg(), ex = snapshot.exceptions()]() {
+        snapshot.clear();
         snapshot.seekg(pos);
         snapshot.exceptions(ex);
     });
@@ -254,12 +298,13 @@ istream_snapshot_reader::validate() const {
     snapshot.exceptions(std::istream::failbit | std::istream::eofbit);
 
     try {
+        snapshot.seekg(header_pos);
+
         // validate totem
-        auto                     expected_totem = ostream_snapshot_writer::magic_number;
-        decltype(expected_totem) actual_totem;
+        uint32_t actual_totem;
         snapshot.read((char*)&actual_totem, sizeof(actual_totem));
-        EVT_ASSERT(actual_totem == expected_totem, snapshot_exception,
-                   "Binary snapshot has unexpected magic number!");
+        EVT_ASSERT(actual_totem == ostream_snapshot_writer::magic_number || actual_totem == ostream_snapshot_writer::magic_number_v2,
+                   snapshot_exception, "Binary snapshot has unexpected magic number!");
 
         // validate version
         auto                       expected_version = current_snapshot_version;
@@ -269,9 +314,17 @@ istream_snapshot_reader::validate() const {
                    "Binary snapshot is an unsuppored version.  Expected : ${expected}, Got: ${actual}",
                    ("expected", expected_version)("actual", actual_version));
 
+        if(actual_totem == ostream_snapshot_writer::magic_number_v2) {
+            validate_checksums();
+            return;
+        }
+
         while(validate_section()) {
         }
     }
+    catch(const snapshot_exception&) {
+        throw;
+    }
     catch(const std::exception& e) {
         snapshot_exception fce(FC_LOG_MESSAGE(warn, "Binary snapshot validation threw IO exception (${what})", ("what", e.what())));
         throw fce;
@@ -294,6 +347,67 @@ istream_snapshot_reader::validate_section() const {
     return true;
 }
 
+void
+istream_snapshot_reader::validate_checksums() const {
+    // data is read sequentially here and sections are hashed concurrently,
+    // in-flight data is bounded to avoid holding the whole snapshot in memory
+    const uint64_t max_inflight = 4 * max_prefetch_size;
+
+    struct pending_hash {
+        const section_index* si;
+        uint64_t             size;
+        std::future<bool>    ok;
+    };
+
+    auto pendings = std::deque<pending_hash>();
+    auto inflight = uint64_t(0);
+
+    auto wait_front = [&] {
+        auto& p = pendings.front();
+        EVT_ASSERT(p.ok.get(), snapshot_validation_exception,
+                   "Binary snapshot section ${n} has mismatched checksum", ("n", p.si->name));
+        inflight -= p.size;
+        pendings.pop_front();
+    };
+
+    for(auto& si : section_indexes) {
+        if(si.size > max_prefetch_size) {
+            // hash large section in place by chunks
+            auto enc = fc::sha256::encoder();
+            auto buf = std::vector<char>(1024 * 1024);
+            auto rem = si.size;
+
+            snapshot.seekg(si.pos);
+            while(rem > 0) {
+                auto n = std::min<uint64_t>(rem, buf.size());
+                snapshot.read(buf.data(), n);
+                enc.write(buf.data(), n);
+                rem -= n;
+            }
+            EVT_ASSERT(enc.result() == si.checksum, snapshot_validation_exception,
+                       "Binary snapshot section ${n} has mismatched checksum", ("n", si.name));
+            continue;
+        }
+
+        while(!pendings.empty() && inflight + si.size > max_inflight) {
+            wait_front();
+        }
+
+        auto data = std::make_shared<std::string>(read_section_data(si));
+        inflight += si.size;
+        pendings.emplace_back(pending_hash {
+            .si   = &si,
+            .size = si.size,
+            .ok   = std::async(std::launch::async, [data, &si] {
+                return fc::sha256::hash(data->data(), data->size()) == si.checksum;
+            })
+        });
+    }
+    while(!pendings.empty()) {
+        wait_front();
+    }
+}
+
 std::vector<std::string>
 istream_snapshot_reader::get_section_names(const std::string& prefix) const {
     auto names = std::vector<std::string>();
@@ -312,6 +426,37 @@ istream_snapshot_reader::has_section(const string& section_name) {
     }) != section_indexes.cend();
 }
 
+std::string
+istream_snapshot_reader::read_section_data(const section_index& si) const {
+    auto data = std::string();
+    data.resize(si.size);
+
+    snapshot.seekg(si.pos);
+    snapshot.read(data.data(), si.size);
+    EVT_ASSERT(snapshot.gcount() == std::streamsize(si.size), snapshot_validation_exception,
+               "Binary snapshot section ${n} is truncated", ("n", si.name));
+    return data;
+}
+
+void
+istream_snapshot_reader::prefetch_section(size_t i) {
+    if(i >= section_indexes.size() || section_indexes[i].size > max_prefetch_size) {
+        prefetched.reset();
+        return;
+    }
+
+    // reading is done here on the caller's thread, only decompression runs in background
+    auto& si  = section_indexes[i];
+    auto data = std::make_shared<std::string>(read_section_data(si));
+
+    prefetched = prefetched_section {
+        .name = si.name,
+        .data = std::async(std::launch::async, [data] {
+            return detail::inflate(*data);
+        }).share()
+    };
+}
+
 void
 istream_snapshot_reader::set_section(const string& section_name) {
     namespace io = boost::iostreams;
@@ -321,20 +466,39 @@ istream_snapshot_reader::set_section(const string& section_name) {
         row_stream.reset();
     }
 
-    for(auto& si : section_indexes) {
-        if(si.name == section_name) {
-            snapshot.seekg(si.pos);
-            cur_row  = 0;
-            num_rows = si.row_count;
+    for(auto i = 0u; i < section_indexes.size(); i++) {
+        auto& si = section_indexes[i];
+        if(si.name != section_name) {
+            continue;
+        }
+
+        cur_row  = 0;
+        num_rows = si.row_count;
 
-            // setup row stream
-            assert(!row_stream.has_value());
-            row_stream.emplace();
-            row_stream->push(io::zlib_decompressor());
-            row_stream->push(snapshot);
+        // setup row stream
+        assert(!row_stream.has_value());
+        row_stream.emplace();
 
+        if(format == 2 && si.size <= max_prefetch_size) {
+            if(prefetched.has_value() && prefetched->name == section_name) {
+                cur_data = prefetched->data.get();
+            }
+            else {
+                cur_data = detail::inflate(read_section_data(si));
+            }
+            row_stream->push(io::array_source(cur_data.data(), cur_data.size()));
+
+            // stream is free as rows are read from memory, start on next section
+            prefetch_section(i + 1);
             return;
         }
+
+        prefetched.reset();
+        snapshot.seekg(si.pos);
+        row_stream->push(io::zlib_decompressor());
+        row_stream->push(snapshot);
+
+        return;
     }
 
     EVT_THROW(snapshot_exception, "Binary snapshot has no section named ${n}", ("n", section_name));
@@ -379,6 +543,29 @@ istream_snapshot_reader::build_section_indexes() {
         snapshot.seekg(pos);
     });
 
+    uint32_t totem = 0;
+    snapshot.read((char*)&totem, sizeof(totem));
+    if(snapshot.eof()) {
+        snapshot.clear();
+        snapshot.seekg(0);
+        return;
+    }
+    if(totem == ostream_snapshot_writer::magic_number_v2) {
+        // v2 locates all the sections by the table, no needs to walk through them
+        format = 2;
+
+        uint32_t version   = 0;
+        uint64_t table_pos = 0;
+        snapshot.read((char*)&version, sizeof(version));
+        snapshot.read((char*)&table_pos, sizeof(table_pos));
+        EVT_ASSERT(table_pos != std::numeric_limits<uint64_t>::max(), snapshot_validation_exception,
+                   "Binary snapshot is not finalized");
+
+        snapshot.seekg(table_pos);
+        fc::raw::unpack(snapshot, section_indexes);
+        return;
+    }
+
     const std::streamoff header_size = sizeof(ostream_snapshot_writer::magic_number) + sizeof(current_snapshot_version);
 
     auto next_section_pos = header_pos + header_size;
@@ -410,9 +597,9 @@ istream_snapshot_reader::build_section_indexes() {
 
         section_indexes.emplace_back(section_index {
             .name      = name,
-            .pos       = (size_t)snapshot.tellg(),
+            .pos       = (uint64_t)snapshot.tellg(),
             .row_count = row_count,
-            .size      = (size_t)(next_section_pos - snapshot.tellg())
+            .size      = (uint64_t)(next_section_pos - snapshot.tellg())
         });
     }
 }
@@ -8,29 +8,57 @@
 #define __cpp_lib_string_view
 #endif
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
 #include <deque>
 #include <fstream>
+#include <future>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <set>
 #include <string_view>
+#include <thread>
+#include <tuple>
+#include <mutex>
+#include <unordered_map>
 #include <unordered_set>
 
 #include <rocksdb/db.h>
 #include <rocksdb/cache.h>
+#include <rocksdb/env.h>
 #include <rocksdb/options.h>
 #include <rocksdb/filter_policy.h>
+#include <rocksdb/rate_limiter.h>
 #include <rocksdb/slice_transform.h>
+#include <rocksdb/sst_file_writer.h>
 #include <rocksdb/statistics.h>
 #include <rocksdb/table.h>
+#include <rocksdb/utilities/checkpoint.h>
 
 #include <llvm/ADT/StringSet.h>
-#include <llvm/ADT/StringMap.h>
+#include <llvm/Support/Allocator.h>
+
+#include <fmt/format.h>
 
 #include <fc/filesystem.hpp>
+#include <fc/crypto/city.hpp>
 #include <fc/io/datastream.hpp>
 #include <fc/io/raw.hpp>
 #include <fc/container/ring_vector.hpp>
+#include <fc/log/logger.hpp>
+#include <fc/log/trace.hpp>
 
 #include <evt/chain/config.hpp>
+#include <evt/chain/deadline_timer.hpp>
 #include <evt/chain/exceptions.hpp>
+#include <evt/chain/merkle.hpp>
+#include <evt/utilities/cpu_affinity.hpp>
+#include <evt/utilities/cuckoo_filter.hpp>
+#include <evt/utilities/fixed_key_map.hpp>
+#include <evt/utilities/heavy_hitters.hpp>
 
 namespace evt { namespace chain {
 
@@ -53,6 +81,13 @@ const size_t kSymbolIdSize           = sizeof(symbol_id_type);
 const size_t kPublicKeySize          = sizeof(fc::ecc::public_key_shim);
 const size_t kDefaultSavePointsSize  = (4 / 3 * 24 + 1) * 12;
 
+// rate of background I/O taken as unlimited, refills of rate limiter overflow with larger ones
+const uint64_t kUnlimitedIORate = 1ull << 40;
+// write buffers are sized to hold the writes of this long, within the bounds
+const uint64_t kWriteBufferSecs    = 30;
+const uint64_t kMinWriteBufferSize = 32 * 1024 * 1024;
+const uint64_t kMaxWriteBufferSize = 256 * 1024 * 1024;
+
 struct db_token_key : boost::noncopyable {
 public:
     db_token_key(const name128& prefix, const name128& key)
@@ -122,7 +157,10 @@ name128 action_key_prefixes[] = {
     N128(.prodvote),
     N128(.evtlink),
     N128(.psvbonus),
-    N128(.psvbonus-dist)
+    N128(.psvbonus-dist),
+    N128(.owner),
+    N128(.meta),
+    N128(.holding)
 };
 
 static_assert(sizeof(action_key_prefixes) / sizeof(name128) == (int)token_type::max_value + 1);
@@ -175,9 +213,21 @@ public:
     };
 };
 
+// previous values of the tokens by their keys, nullopt if the token didn't exist
+using prev_values_t = std::unordered_map<std::string, std::optional<std::string>>;
+
 struct rt_group {
-    const void*                rb_snapshot;
-    small_vector<rt_action, 4> actions;
+    // snapshot is only taken for the irreversible view, lazily right before the first token write
+    // in this group, it's shared with the view when this is the oldest group
+    std::shared_ptr<const rocksdb::Snapshot> rb_snapshot;
+    small_vector<rt_action, 4>               actions;
+    // journal of the previous values of the tokens when they're first written in this group,
+    // rolling back restores them from here, values of nested groups are merged when squashed
+    std::unique_ptr<prev_values_t>           prev_values;
+    // nested groups(transactions) are only squashed or rolled back, never popped
+    bool                                     nested = false;
+    // generation of key filters when this group is added, see `rollback_rt_group`
+    uint64_t                                 filter_generation = 0;
 };
 
 // persistent action
@@ -239,36 +289,160 @@ struct pd_header {
     int dirty_flag;
 };
 
+// writes sorted runs of one column family into SST files
+// a new file is started whenever the key is not greater than the last one
+struct bulk_writer {
+    std::string                             name;
+    rocksdb::ColumnFamilyHandle*            handle = nullptr;
+    std::unique_ptr<rocksdb::SstFileWriter> writer;
+    std::string                             last_key;
+    std::vector<std::string>                files;
+};
+
+// roots of the partitions of integrity hash
+// tokens are partitioned by key prefix: one per reserved token type and one per domain
+// assets are partitioned by symbol id
+// only dirty partitions are rehashed, all of them are rebuilt when it's not valid
+struct integrity_roots {
+    bool                                 valid = false;
+    std::map<name128, fc::sha256>        tokens;
+    std::map<symbol_id_type, fc::sha256> assets;
+    std::set<name128>                    dirty_tokens;
+    std::set<symbol_id_type>             dirty_assets;
+};
+
+// owner index: one partition per owner, keyed by the hash of domain and name of the token
+// value is domain, name and whether it's still owned, a token leaving its owner is only marked
+const size_t kOwnedValueSize = sizeof(name128) * 2 + 1;
+const auto   kOwnerIndexFlag = N128(.enabled);  // key in the reserved partition, set when index is on
+
+name128
+owner_prefix(const address& addr) {
+    auto buf = fc::raw::pack(addr);
+    auto h   = fc::sha256::hash(buf.data(), buf.size());
+    auto n = name128();
+    memcpy(&n, h.data(), sizeof(n));
+    return n;
+}
+
+// holding index: one partition per address, keyed by the symbol id and valued the same
+// entries are only added, an address keeps its balance record once it has held the symbol
+const auto kHoldingIndexFlag = N128(.enabled);  // key in the reserved partition, set when index is on
+
+// hashed from the address bytes in asset keys, so it can be rebuilt from the assets alone
+name128
+holding_prefix(const char* addr_bytes) {
+    auto enc = fc::sha256::encoder();
+    fc::raw::pack(enc, N128(.holding));
+    enc.write(addr_bytes, kPublicKeySize);
+    auto h = enc.result();
+    auto n = name128();
+    memcpy(&n, h.data(), sizeof(n));
+    return n;
+}
+
+name128
+holding_prefix(const address& addr) {
+    char buf[kPublicKeySize];
+    addr.to_bytes(buf, sizeof(buf));
+    return holding_prefix(buf);
+}
+
+// owner index and holding index are derived from other values, they are not a part of the state
+bool
+is_index_type(int type) {
+    return type == (int)token_type::owner || type == (int)token_type::holding;
+}
+
+// types checked for existence when they're created, their keys are only added and never removed
+bool
+is_filtered_type(int type) {
+    switch(type) {
+    case (int)token_type::domain:
+    case (int)token_type::token:
+    case (int)token_type::group:
+    case (int)token_type::suspend:
+    case (int)token_type::lock:
+    case (int)token_type::fungible:
+    case (int)token_type::evtlink:
+        return true;
+    default:
+        return false;
+    }
+}
+
+uint64_t
+key_hash(const rocksdb::Slice& key) {
+    return fc::city_hash64(key.data(), key.size());
+}
+
+// header of the key filters file, filters are only loaded into the db they were written from
+struct kf_header {
+    uint32_t    version;
+    uint64_t    sequence;  // latest sequence number of db when closed
+    std::string identity;  // identity of db
+};
+const uint32_t kKeyFiltersVersion = 1;
+const size_t   kMinKeyFilterSize  = 1024;
+
+name128
+owned_key(const name128& domain, const name128& name) {
+    char buf[sizeof(name128) * 2];
+    memcpy(buf, &domain, sizeof(name128));
+    memcpy(buf + sizeof(name128), &name, sizeof(name128));
+
+    auto h = fc::sha256::hash(buf, sizeof(buf));
+    auto n = name128();
+    memcpy(&n, h.data(), sizeof(n));
+    return n;
+}
+
+// values of tokens start with their domain, name and owners
+small_vector<address, 4>
+token_owners(const std::string_view& value) {
+    auto owners = small_vector<address, 4>();
+    if(value.empty()) {
+        return owners;
+    }
+
+    auto ds = fc::datastream<const char*>(value.data(), value.size());
+    auto n  = name128();
+    fc::raw::unpack(ds, n);  // domain
+    fc::raw::unpack(ds, n);  // name
+    fc::raw::unpack(ds, owners);
+    return owners;
+}
+
 }  // namespace internal
 
+// only assets are cached, whose keys are all of the same size
 class write_cache_layer : boost::noncopyable {
 private:
     struct cache_entry {
-    public:
-        cache_entry(int32_t used_count, std::string&& value)
-            : used_count(used_count)
-            , value(std::move(value)) {}
-
-    public:
-        int32_t     used_count;
+        int32_t     used_count = 0;
         std::string value;
     };
 
-    using data_map_t = llvm::StringMap<cache_entry>;
+    using data_map_t = utilities::fixed_key_map<internal::kSymbolIdSize + internal::kPublicKeySize, cache_entry>;
+    using arena_t    = llvm::BumpPtrAllocator;
 
     struct data_op {
     public:
-        data_op(data_map_t::iterator& it, std::string&& pv)
-            : it(&(*it)), pv(std::move(pv)) {}
+        data_op(data_map_t::value_type* it, const char* pv, size_t pvsz)
+            : it(it), pv(pv), pvsz(pvsz) {}
 
     public:
         data_map_t::value_type* it;
-        std::string             pv;
+        const char*             pv;  // previous value, allocated in the arena of savepoint
+        size_t                  pvsz;
     };
 
+    // previous values are stored in the arenas and released in one shot with the savepoint
+    // squashed savepoint moves its arenas to the previous one
     struct data_ops {
-        int64_t              seq;
-        std::vector<data_op> vec;
+        int64_t                               seq;
+        std::vector<data_op>                  vec;
+        std::vector<std::unique_ptr<arena_t>> arenas;
     };
 
 public:
@@ -276,6 +450,7 @@ public:
 
 public:
     void put(const std::string_view& key, const std::string_view& value);
+    int update(const std::string_view& key, const update_value_func& func);
     int read(const std::string_view& key, std::string& value) const;
     int exists(const std::string_view& key) const;
 
@@ -283,13 +458,22 @@ public:
     void add_savepoint(int64_t seq);
     void rollback_to_latest_savepoint();
     void squash();
-    void pop_front(std::function<void(const llvm::StringRef&, std::string&&)> persist_func);
+    void pop_front(std::function<void(const std::string_view&, std::string&&)> persist_func);
     void pop_back();
 
-    void clear();
-    void persist_savepoints(std::ostream& os) const;
+    void   clear();
+    size_t memory_usage() const;
+    void   persist_savepoints(std::ostream& os) const;
     void load_savepoints(std::istream& is);
 
+private:
+    // ring_vector doesn't destroy the popped items, release memory here
+    static void
+    release(data_ops& ops) {
+        ops.vec.clear();
+        ops.arenas.clear();
+    }
+
 private:
     data_map_t                data_;
     fc::ring_vector<data_ops> ops_;
@@ -302,21 +486,52 @@ void
 write_cache_layer::put(const std::string_view& key, const std::string_view& value) {
     assert(!ops_.empty());
 
-    auto pair = data_.try_emplace(llvm::StringRef(key.data(), key.size()), 1, std::string(value.data(), value.size()));
+    auto& ops  = ops_.back();
+    auto  pair = data_.try_emplace(key);
     if(!pair.second) {
-        auto pv = std::move(pair.first->second.value);
-        pair.first->second.used_count += 1;
-        pair.first->second.value       = std::string(value.data(), value.size());
-        ops_.back().vec.emplace_back(data_op(pair.first, std::move(pv)));
+        auto& entry = pair.first->second;
+        auto  pvsz  = entry.value.size();
+        auto  pv    = (char*)ops.arenas.back()->Allocate(pvsz, 1);
+        memcpy(pv, entry.value.data(), pvsz);
+
+        entry.used_count += 1;
+        entry.value.assign(value.data(), value.size());  // reuse the buffer of value
+        ops.vec.emplace_back(pair.first, pv, pvsz);
         return;
     }
-    ops_.back().vec.emplace_back(data_op(pair.first, std::string()));
+    pair.first->second.used_count = 1;
+    pair.first->second.value.assign(value.data(), value.size());
+    ops.vec.emplace_back(pair.first, nullptr, 0);
+}
+
+// changes the cached value in place, returns false if the key is not cached
+// the previous value is recorded before `func` runs, so rolling back undoes a `func` that threw halfway
+int
+write_cache_layer::update(const std::string_view& key, const update_value_func& func) {
+    assert(!ops_.empty());
+
+    auto it = data_.find(key);
+    if(it == nullptr) {
+        return false;
+    }
+
+    auto& ops   = ops_.back();
+    auto& entry = it->second;
+    auto  pvsz  = entry.value.size();
+    auto  pv    = (char*)ops.arenas.back()->Allocate(pvsz, 1);
+    memcpy(pv, entry.value.data(), pvsz);
+
+    entry.used_count += 1;
+    ops.vec.emplace_back(it, pv, pvsz);
+
+    func(entry.value);
+    return true;
 }
 
 int
 write_cache_layer::read(const std::string_view& key, std::string& value) const {
-    auto it = data_.find(llvm::StringRef(key.data(), key.size()));
-    if(it == data_.end()) {
+    auto it = data_.find(key);
+    if(it == nullptr) {
         return 0;
     }
     value = it->second.value;
@@ -325,12 +540,15 @@ write_cache_layer::read(const std::string_view& key, std::string& value) const {
 
 int
 write_cache_layer::exists(const std::string_view& key) const {
-    return data_.find(llvm::StringRef(key.data(), key.size())) != data_.end();
+    return data_.find(key) != nullptr;
 }
 
 void
 write_cache_layer::add_savepoint(int64_t seq) {
-    ops_.push_back(data_ops{ .seq = seq, .vec = {} });
+    auto ops = data_ops{ .seq = seq, .vec = {}, .arenas = {} };
+    ops.arenas.emplace_back(std::make_unique<arena_t>());
+
+    ops_.push_back(std::move(ops));
 }
 
 void
@@ -339,13 +557,14 @@ write_cache_layer::rollback_to_latest_savepoint() {
     for(auto it = ops.vec.rbegin(); it != ops.vec.rend(); it++) {
         auto& op = *it;
         if(--op.it->second.used_count == 0) {
-            data_.erase(op.it->first());
+            data_.erase(op.it);
         }
         else {
-            assert(!op.it->second.value.empty());
-            op.it->second.value = std::move(op.pv);
+            assert(op.pv != nullptr);
+            op.it->second.value.assign(op.pv, op.pvsz);
         }
     }
+    release(ops);
     ops_.pop_back();
 }
 
@@ -356,23 +575,30 @@ write_cache_layer::squash() {
     auto& b2 = ops_[ops_.size() - 2];
 
     b2.vec.insert(b2.vec.end(), b1.vec.begin(), b1.vec.end());
+    // previous values of b1 are still referred, hand over its arenas to b2
+    std::move(b1.arenas.begin(), b1.arenas.end(), std::back_inserter(b2.arenas));
+
+    release(b1);
     ops_.pop_back();
 }
 
 void
-write_cache_layer::pop_front(std::function<void(const llvm::StringRef&, std::string&&)> persist_func) {
-    for(auto& op : ops_.front().vec) {
+write_cache_layer::pop_front(std::function<void(const std::string_view&, std::string&&)> persist_func) {
+    auto& ops = ops_.front();
+    for(auto& op : ops.vec) {
         if(--op.it->second.used_count == 0) {
-            persist_func(op.it->first(), std::move(op.it->second.value));
-            data_.erase(op.it->first());
+            persist_func(op.it->key(), std::move(op.it->second.value));
+            data_.erase(op.it);
         }
     }
 
+    release(ops);
     ops_.pop_front();
 }
 
 void
 write_cache_layer::pop_back() {
+    release(ops_.back());
     ops_.pop_back();
 }
 
@@ -392,10 +618,30 @@ struct wc_entry_pack {
 
 void
 write_cache_layer::clear() {
+    for(auto i = 0; i < ops_.size(); i++) {
+        release(ops_[i]);
+    }
     data_.clear();
     ops_.clear();
 }
 
+// approximate, allocator overheads of the entries are not counted
+size_t
+write_cache_layer::memory_usage() const {
+    auto bytes = data_.memory_usage();
+    data_.for_each([&](auto& e) {
+        bytes += e.second.value.capacity();
+    });
+    for(auto i = 0; i < ops_.size(); i++) {
+        auto& ops = ops_[i];
+        bytes += ops.vec.capacity() * sizeof(data_op);
+        for(auto& arena : ops.arenas) {
+            bytes += arena->getTotalMemory();
+        }
+    }
+    return bytes;
+}
+
 void
 write_cache_layer::persist_savepoints(std::ostream& os) const {
     using namespace internal;
@@ -409,7 +655,7 @@ write_cache_layer::persist_savepoints(std::ostream& os) const {
         epack.seq   = ops.seq;
         for(auto& op : ops.vec) {
             epack.vec.emplace_back(wc_entry {
-                .k  = op.it->first().str(),
+                .k  = std::string(op.it->key()),
                 .v  = op.it->second.value
             });
         }
@@ -432,6 +678,41 @@ write_cache_layer::load_savepoints(std::istream& is) {
     }
 }
 
+namespace internal {
+
+// irreversible values of the assets which are carried by later savepoints in write cache
+// their values in db are older than the irreversible ones
+using assets_overlay = std::unordered_map<std::string, std::string>;
+
+// visits the values whose keys begin with `prefix` followed by `key_prefix`, in the order of keys
+int
+read_prefixed_tokens(rocksdb::Iterator* it, const name128& prefix, const std::string_view& key_prefix, const read_value_func& func) {
+    auto start = std::string((char*)&prefix, sizeof(prefix));
+    start.append(key_prefix);
+
+    auto count = 0;
+    for(it->Seek(start); it->Valid() && it->key().starts_with(start); it->Next()) {
+        count++;
+        auto key = it->key();
+        key.remove_prefix(sizeof(prefix));
+        if(!func(key.ToStringView(), it->value().ToString())) {
+            break;
+        }
+    }
+    return count;
+}
+
+}  // namespace internal
+
+class token_database_view_impl {
+public:
+    rocksdb::DB*                                    db;
+    rocksdb::ColumnFamilyHandle*                    assets_handle;
+    std::shared_ptr<const rocksdb::Snapshot>        tokens_snapshot;
+    std::shared_ptr<const rocksdb::Snapshot>        assets_snapshot;
+    std::shared_ptr<const internal::assets_overlay> assets_overlay;
+};
+
 class token_database_impl : boost::noncopyable {
 public:
     token_database_impl(token_database& self, const token_database::config& config);
@@ -440,6 +721,13 @@ public:
     void open(int load_persistence = true);
     void close(int persist = true);
 
+    bool is_secondary() const { return !config_.secondary_path.empty(); }
+    void check_writable() const {
+        EVT_ASSERT(!is_secondary(), token_database_secondary_exception, "Cannot write into secondary token database");
+    }
+    void open_secondary(rocksdb::Options& options, rocksdb::ColumnFamilyOptions& assets_options);
+    void catch_up_with_primary();
+
 public:
     void put_token(token_type type, action_op op, const name128& prefix, const name128& key, const std::string_view& data);
     void put_tokens(token_type type,
@@ -448,18 +736,48 @@ public:
                     token_keys_t&& keys,
                     const small_vector_base<std::string_view>& data);
     void put_asset(const address& addr, const symbol_id_type sym_id, const std::string_view& data);
+    void put_assets(const small_vector_base<asset_key_t>& keys, const small_vector_base<std::string_view>& data);
+    void update_asset(const address& addr, const symbol_id_type sym_id, const update_value_func& func);
 
-    int exists_token(const name128& prefix, const name128& key) const;
+    int exists_token(token_type type, const name128& prefix, const name128& key) const;
     int exists_asset(const address& addr, const symbol_id_type sym_id) const;
 
     int read_token(const name128& prefix, const name128& key, std::string& out, bool no_throw = false) const;
     int read_asset(const address& addr, const symbol_id_type sym_id, std::string& out, bool no_throw = false) const;
 
-    int read_tokens_range(const name128& prefix, int skip, const read_value_func& func) const;
-    int read_assets_range(const symbol_id_type sym_id, int skip, const read_value_func& func) const;
+    int read_tokens(token_type type, const name128& prefix, const small_vector_base<name128>& keys, read_values_t& outs, bool no_throw = false) const;
+    int read_assets(const small_vector_base<asset_key_t>& keys, read_values_t& outs, bool no_throw = false) const;
+
+    void prefetch(const std::vector<std::pair<name128, name128>>& tokens, const std::vector<asset_key_t>& assets) const;
+
+    int read_tokens_range(const name128& prefix, int skip, std::string& cursor, const read_value_func& func) const;
+    int read_assets_range(const symbol_id_type sym_id, int skip, std::string& cursor, const read_value_func& func) const;
+    int read_tokens_prefix(const name128& prefix, const std::string_view& key_prefix, const read_value_func& func) const;
+
+    int read_owned_tokens(const address& owner, int skip, const read_owned_func& func) const;
 
 public:
-    void add_savepoint(int64_t seq);
+    void update_owner_index(const name128& domain, const name128& name, const std::string_view& old_value, const std::string_view& new_value);
+    void put_owned_token(const address& owner, const name128& domain, const name128& name, bool owned);
+    void read_old_token(const rocksdb::Slice& key, std::string& value) const;
+    void check_index(token_type type, bool enabled_now, bool created);
+    void rebuild_owner_index();
+
+    void load_key_filters();
+    void build_key_filter(token_type type, size_t capacity);
+    void build_key_filters();
+    void persist_key_filters() const;
+    int  is_new_filtered_key(token_type type, action_op op, const rocksdb::Slice& key) const;
+    int  add_to_key_filter(token_type type, const rocksdb::Slice& key);
+    void remove_from_key_filter(token_type type, const rocksdb::Slice& key);
+    int  may_exist(token_type type, const rocksdb::Slice& key) const;
+
+    int read_held_symbols(const address& addr, const read_held_func& func) const;
+    void add_holding(const address& addr, const symbol_id_type sym_id);
+    void rebuild_holding_index();
+
+public:
+    void add_savepoint(int64_t seq, bool nested = false);
     void rollback_to_latest_savepoint();
     void pop_savepoints(int64_t until);
     void pop_back_savepoint();
@@ -471,14 +789,50 @@ public:
 
     void rollback_rt_group(internal::rt_group*);
     void rollback_pd_group(internal::pd_group*);
+    token_database::token_deltas collect_deltas(const internal::rt_group*) const;
 
     int should_record() { return !savepoints_.empty(); }
+    void prepare_record();
+    void keep_prev_value(const rocksdb::Slice& key, action_op op);
+    int  read_prev_value(const internal::rt_group* rt, rocksdb::ColumnFamilyHandle* handle, const std::string& key, std::string& value) const;
 
     void record(uint8_t action_type, uint8_t op, uint8_t data_type, void* data);
     void free_savepoint(internal::savepoint&);
     void free_all_savepoints();
 
+    void start_persist_worker();
+    void stop_persist_worker();
+
+    void start_tiering_worker();
+    void stop_tiering_worker();
+    void demote_cold_domains();
+
+    void start_tuning_worker();
+    void stop_tuning_worker();
+    void tune_write_buffers();
+    void apply_io_rate();
+    void request_sync();
+
+    void begin_bulk_load();
+    void end_bulk_load();
+    void bulk_put(internal::bulk_writer& bw, const rocksdb::Slice& key, const rocksdb::Slice& value);
+
+    void create_checkpoint(const fc::path& dir) const;
+
+    std::shared_ptr<const rocksdb::Snapshot> new_snapshot() const;
+    void carry_irreversible_assets();
+    void update_irreversible_view();
+
+    void mark_token_dirty(const name128& prefix);
+    void mark_asset_dirty(symbol_id_type sym_id);
+    void mark_key_dirty(bool asset, const std::string_view& key);
+    void reset_integrity_roots();
+    std::optional<fc::sha256> hash_tokens_partition(const name128& prefix) const;
+    std::optional<fc::sha256> hash_assets_partition(symbol_id_type sym_id) const;
+    fc::sha256 calculate_integrity_hash();
+
     void persist_savepoints() const;
+    void persist_savepoints(const fc::path& filename) const;
     void load_savepoints();
     void persist_savepoints(std::ostream&) const;
     void load_savepoints(std::istream&);
@@ -490,6 +844,8 @@ public:
     token_database&        self_;
     token_database::config config_;
 
+    std::unique_ptr<rocksdb::Env> env_;  // in-memory env for ram profile
+
     rocksdb::DB*          db_;
     rocksdb::ReadOptions  read_opts_;
     rocksdb::WriteOptions write_opts_;
@@ -497,9 +853,78 @@ public:
     rocksdb::ColumnFamilyHandle* tokens_handle_;
     rocksdb::ColumnFamilyHandle* assets_handle_;
 
+    // block caches of tokens and assets with their shares, only for disk profile
+    std::vector<std::pair<std::shared_ptr<rocksdb::Cache>, uint32_t>> block_caches_;
+
     write_cache_layer assets_write_cache_;
 
     fc::ring_vector<internal::savepoint> savepoints_;
+    mutable std::atomic<uint64_t>        snapshots_taken_ = 0;
+    mutable std::atomic<uint64_t>        keys_prefetched_ = 0;
+
+    // background worker which syncs the popped savepoints onto disk
+    std::thread             persist_thread_;
+    std::mutex              persist_mutex_;
+    std::condition_variable persist_cv_;
+    std::condition_variable persist_done_cv_;
+    size_t                  persist_pending_;
+    bool                    persist_stop_;
+    std::string             persist_error_;
+
+    bool                  bulk_mode_;
+    internal::bulk_writer bulk_tokens_;
+    internal::bulk_writer bulk_assets_;
+
+    internal::integrity_roots roots_;
+
+    std::shared_ptr<const internal::assets_overlay> irreversible_assets_;
+    mutable std::mutex                              irreversible_mtx_;
+    token_database_view_ptr                         irreversible_view_;
+
+    // filters of all the keys of the filtered types in db, one per type, absent keys are answered
+    // without reading db. They're only kept by primary, keys added in runtime savepoints are removed
+    // when they're rolled back, or filters are rebuilt if any was since the savepoint was added.
+    // The keys of the persisted savepoints are left in them.
+    // tokens of all the domains share one filter, their keys have the domains as prefixes
+    // persisted into `token_database_filters_filename` when closed, rebuilt by scanning db otherwise
+    std::array<utilities::cuckoo_filter, (int)token_type::max_value + 1> key_filters_;
+    bool                                                                  key_filtered_;
+    mutable std::atomic<uint64_t> filter_negatives_       = 0;  // keys answered absent by filters
+    mutable std::atomic<uint64_t> filter_positives_       = 0;  // keys read from db after filters
+    mutable std::atomic<uint64_t> filter_false_positives_ = 0;  // ones of them not found in db
+    std::atomic<uint64_t>         filter_rebuilds_        = 0;  // filters rebuilt when they're full
+    uint64_t                      filter_generation_      = 0;  // bumped whenever a filter is rebuilt from db
+
+    // keys of the sampled point operations, guarded by `hot_keys_mtx_`
+    using hot_key_id = std::tuple<token_type, std::string, std::string>;
+    mutable std::mutex                               hot_keys_mtx_;
+    mutable utilities::heavy_hitters<hot_key_id>     hot_reads_;
+    mutable utilities::heavy_hitters<hot_key_id>     hot_writes_;
+
+    // last sampled times of the domains of tokens, guarded by `hot_keys_mtx_`
+    // cold ones are forgotten once their tokens are compacted into the bottom level
+    mutable std::unordered_map<name128, fc::time_point> domains_seen_;
+
+    // background worker which demotes the cold domains
+    std::thread             tiering_thread_;
+    std::mutex              tiering_mutex_;
+    std::condition_variable tiering_cv_;
+    std::atomic<bool>       tiering_stop_    = false;
+    std::atomic<uint64_t>   domains_demoted_ = 0;
+
+    // limits the background I/O, to the busy rate or to the idle one, only for disk profile
+    std::shared_ptr<rocksdb::RateLimiter> rate_limiter_;
+    std::mutex                            io_rate_mtx_;
+    bool                                  background_busy_ = true;
+
+    // background worker which sizes the write buffers by the write rate, only with `auto_tune`
+    std::thread             tuning_thread_;
+    std::mutex              tuning_mutex_;
+    std::condition_variable tuning_cv_;
+    bool                    tuning_stop_         = false;
+    uint64_t                bytes_written_       = 0;  // at the last tuning
+    uint64_t                write_buffer_size_   = 0;  // of both column families
+    std::atomic<uint64_t>   write_buffers_tuned_ = 0;
 };
 
 token_database_impl::token_database_impl(token_database& self, const token_database::config& config)
@@ -510,7 +935,13 @@ token_database_impl::token_database_impl(token_database& self, const token_datab
     , write_opts_()
     , tokens_handle_(nullptr)
     , assets_handle_(nullptr)
-    , savepoints_(internal::kDefaultSavePointsSize) {}
+    , savepoints_(internal::kDefaultSavePointsSize)
+    , persist_pending_(0)
+    , persist_stop_(false)
+    , bulk_mode_(false)
+    , key_filtered_(false)
+    , hot_reads_(config.hot_keys_capacity)
+    , hot_writes_(config.hot_keys_capacity) {}
 
 void
 token_database_impl::open(int load_persistence) {
@@ -518,13 +949,16 @@ token_database_impl::open(int load_persistence) {
     using namespace internal;
 
     EVT_ASSERT(db_ == nullptr, token_database_exception, "Token database is already opened");
+    reset_integrity_roots();
+    block_caches_.clear();
+
+    // flush and compaction threads of rocksdb and the persist worker are started while opening,
+    // they inherit the cpus of this thread
+    auto pin = utilities::affinity::scoped_pin(config_.background_cpus);
 
     auto options = Options();
-    options.OptimizeUniversalStyleCompaction();
 
     options.create_if_missing               = true;
-    options.compression                     = CompressionType::kLZ4Compression;
-    options.bottommost_compression          = CompressionType::kZSTD;
     options.allow_concurrent_memtable_write = false;
     options.prefix_extractor.reset(NewFixedPrefixTransform(sizeof(name128)));
     options.memtable_factory.reset(NewHashSkipListRepFactory());
@@ -538,28 +972,111 @@ token_database_impl::open(int load_persistence) {
     }
 
     auto assets_options = ColumnFamilyOptions(options);
+    assets_options.prefix_extractor.reset(NewFixedPrefixTransform(kSymbolIdSize));
+
+    auto set_compaction = [](auto& cf_opts, auto& cf_conf) {
+        switch(cf_conf.compaction) {
+        case compaction_style::universal: {
+            cf_opts.OptimizeUniversalStyleCompaction();
+            break;
+        }
+        case compaction_style::level: {
+            cf_opts.OptimizeLevelStyleCompaction();
+            break;
+        }
+        default: {
+            EVT_THROW(token_database_exception, "Unknown compaction style");
+        }
+        }  // switch
+    };
+    set_compaction(options, config_.tokens_cf);
+    set_compaction(assets_options, config_.assets_cf);
+
+    // set after compaction, which may override compression settings
+    write_buffer_size_                    = options.write_buffer_size;
+    options.compression                   = CompressionType::kLZ4Compression;
+    options.bottommost_compression        = CompressionType::kZSTD;
+    assets_options.compression            = CompressionType::kLZ4Compression;
+    assets_options.bottommost_compression = CompressionType::kZSTD;
 
     if(config_.profile == storage_profile::disk) {
-        auto table_opts = BlockBasedTableOptions();
+        auto make_table_factory = [this](auto& cf_conf) {
+            auto table_opts = BlockBasedTableOptions();
+
+            table_opts.index_type     = BlockBasedTableOptions::kHashSearch;
+            table_opts.checksum       = kxxHash64;
+            table_opts.format_version = 4;
+            if(cf_conf.block_cache_share > 0) {
+                table_opts.block_cache = NewLRUCache((uint64_t)config_.block_cache_size * cf_conf.block_cache_share / 100);
+                block_caches_.emplace_back(table_opts.block_cache, cf_conf.block_cache_share);
+            }
+            if(cf_conf.bloom_bits > 0) {
+                table_opts.filter_policy.reset(NewBloomFilterPolicy(cf_conf.bloom_bits, false));
+            }
+            if(cf_conf.pin_index_and_filter) {
+                table_opts.cache_index_and_filter_blocks                    = true;
+                table_opts.cache_index_and_filter_blocks_with_high_priority = true;
+                table_opts.pin_l0_filter_and_index_blocks_in_cache          = true;
+            }
+            return NewBlockBasedTableFactory(table_opts);
+        };
+
+        options.table_factory.reset(make_table_factory(config_.tokens_cf));
+        assets_options.table_factory.reset(make_table_factory(config_.assets_cf));
+
+        // always there, so the rates can be changed at runtime; auto tuned ones stay between 1/20 of the rate and it
+        rate_limiter_.reset(NewGenericRateLimiter(kUnlimitedIORate, 100 * 1000, 10, RateLimiter::Mode::kWritesOnly, config_.auto_tune));
+        options.rate_limiter = rate_limiter_;
+        apply_io_rate();
+
+        // cold tier of tokens: bottom level is compressed harder and goes to cheaper disks
+        if(config_.cold_zstd_level > 0 || !config_.cold_path.empty()) {
+#if ROCKSDB_MAJOR >= 6
+            if(config_.cold_zstd_level > 0) {
+                options.bottommost_compression_opts.enabled              = true;
+                options.bottommost_compression_opts.level                = config_.cold_zstd_level;
+                options.bottommost_compression_opts.max_dict_bytes       = 16 * 1024;
+                options.bottommost_compression_opts.zstd_max_train_bytes = 100 * 16 * 1024;
+            }
+            if(!config_.cold_path.empty()) {
+                fc::create_directories(config_.cold_path);
+                options.cf_paths.emplace_back(config_.db_path.to_native_ansi_path(), config_.hot_size);
+                options.cf_paths.emplace_back(config_.cold_path.to_native_ansi_path(), std::numeric_limits<uint64_t>::max());
+            }
+#else
+            EVT_THROW(token_database_exception, "Cold tier of token database requires RocksDB 6 or later");
+#endif
+        }
+    }
+    else if(config_.profile == storage_profile::ram) {
+        // files are stored in memory env, no needs for block cache and bloom filters
+        env_.reset(NewMemEnv(Env::Default()));
+        options.env               = env_.get();
+        options.write_buffer_size = 256 * 1024 * 1024;
 
+        auto table_opts = BlockBasedTableOptions();
         table_opts.index_type     = BlockBasedTableOptions::kHashSearch;
-        table_opts.checksum       = kxxHash64;
+        table_opts.checksum       = kNoChecksum;
         table_opts.format_version = 4;
-        table_opts.block_cache    = NewLRUCache(config_.block_cache_size);
-        table_opts.filter_policy.reset(NewBloomFilterPolicy(10, false));
+        table_opts.no_block_cache = true;
 
         options.table_factory.reset(NewBlockBasedTableFactory(table_opts));
-        assets_options.prefix_extractor.reset(NewFixedPrefixTransform(kSymbolIdSize));
+        assets_options.table_factory     = options.table_factory;
+        assets_options.write_buffer_size = options.write_buffer_size;
+
+        // data is not durable at all, no WAL is needed
+        write_opts_.disableWAL = true;
     }
     else if(config_.profile == storage_profile::memory) {
         auto tokens_table_options = PlainTableOptions();
         auto assets_table_options = PlainTableOptions();
-        tokens_table_options.user_key_len = sizeof(name128) + sizeof(name128);
-        assets_table_options.user_key_len = kPublicKeySize + kSymbolIdSize;
+        tokens_table_options.user_key_len       = sizeof(name128) + sizeof(name128);
+        tokens_table_options.bloom_bits_per_key = config_.tokens_cf.bloom_bits;
+        assets_table_options.user_key_len       = kPublicKeySize + kSymbolIdSize;
+        assets_table_options.bloom_bits_per_key = config_.assets_cf.bloom_bits;
 
         options.table_factory.reset(NewPlainTableFactory(tokens_table_options));
         assets_options.table_factory.reset(NewPlainTableFactory(assets_table_options));
-        assets_options.prefix_extractor.reset(NewFixedPrefixTransform(kSymbolIdSize));
     }
     else {
         EVT_THROW(token_database_exception, "Unknown token database profile");
@@ -569,14 +1086,20 @@ token_database_impl::open(int load_persistence) {
     read_opts_.prefix_same_as_start = true;
     read_opts_.tailing              = true;
 
+    if(is_secondary()) {
+        open_secondary(options, assets_options);
+        return;
+    }
+
     auto columns = std::vector<ColumnFamilyDescriptor>();
     auto handles = std::vector<ColumnFamilyHandle*>();
     columns.emplace_back(kDefaultColumnFamilyName, options);
 
-    if(!fc::exists(config_.db_path)) {
-        auto t = config_.db_path.to_native_ansi_path();
+    if(config_.profile == storage_profile::ram || !fc::exists(config_.db_path)) {
         // create new database and open
-        fc::create_directories(config_.db_path);
+        if(config_.profile != storage_profile::ram) {
+            fc::create_directories(config_.db_path);
+        }
         
         auto status  = DB::Open(options, config_.db_path.to_native_ansi_path(), columns, &handles, &db_);
         if(!status.ok()) {
@@ -591,9 +1114,16 @@ token_database_impl::open(int load_persistence) {
             EVT_THROW(token_database_rocksdb_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
         }
 
-        if(load_persistence) {
+        load_key_filters();
+        if(load_persistence && config_.profile != storage_profile::ram) {
             load_savepoints();
         }
+        check_index(token_type::owner, config_.owner_index, true /* created */);
+        check_index(token_type::holding, config_.holding_index, true /* created */);
+        start_persist_worker();
+        start_tiering_worker();
+        start_tuning_worker();
+        update_irreversible_view();
         return;
     }
 
@@ -608,133 +1138,560 @@ token_database_impl::open(int load_persistence) {
     tokens_handle_ = handles[0];
     assets_handle_ = handles[1];
 
+    // before anything is written, the persisted filters are only valid for the db as it's closed
+    load_key_filters();
     if(load_persistence) {
         load_savepoints();
     }
+    check_index(token_type::owner, config_.owner_index, false /* created */);
+    check_index(token_type::holding, config_.holding_index, false /* created */);
+    start_persist_worker();
+    start_tiering_worker();
+    start_tuning_worker();
+    update_irreversible_view();
 }
 
+// secondary instance never writes, neither savepoints nor index flags are touched and
+// there is no irreversible view, its values are the latest ones caught up from primary
 void
-token_database_impl::close(int persist) {
-    if(db_) {
-        if(persist) {
-            persist_savepoints();
-        }
-        if(!savepoints_.empty()) {
-            free_all_savepoints();
-        }
-        
-        delete tokens_handle_;
-        delete assets_handle_;
-        delete db_;
+token_database_impl::open_secondary(rocksdb::Options& options, rocksdb::ColumnFamilyOptions& assets_options) {
+    using namespace rocksdb;
+    using namespace internal;
 
-        db_ = nullptr;
+    EVT_ASSERT(config_.profile != storage_profile::ram && fc::exists(config_.db_path), token_database_secondary_exception,
+        "Secondary token database needs the one of primary on disk: ${path}", ("path", config_.db_path));
+
+    // required by secondary instance, and it doesn't support tailing iterators
+    options.max_open_files = -1;
+    read_opts_.tailing     = false;
+
+    auto columns = std::vector<ColumnFamilyDescriptor>();
+    auto handles = std::vector<ColumnFamilyHandle*>();
+    columns.emplace_back(kDefaultColumnFamilyName, options);
+    columns.emplace_back(kAssetsColumnFamilyName, assets_options);
+
+    fc::create_directories(config_.secondary_path);
+    auto status = DB::OpenAsSecondary(options, config_.db_path.to_native_ansi_path(),
+        config_.secondary_path.to_native_ansi_path(), columns, &handles, &db_);
+    if(!status.ok()) {
+        EVT_THROW(token_database_rocksdb_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
     }
+
+    assert(handles.size() == 2);
+    tokens_handle_ = handles[0];
+    assets_handle_ = handles[1];
 }
 
 void
-token_database_impl::put_token(token_type type, action_op op, const name128& prefix, const name128& key, const std::string_view& data) {
-    using namespace internal;
+token_database_impl::catch_up_with_primary() {
+    EVT_ASSERT(is_secondary(), token_database_secondary_exception, "Only secondary token database can catch up with primary");
 
-    auto dbkey  = db_token_key(prefix, key);
-    auto status = db_->Put(write_opts_, dbkey.as_slice(), data);
+    auto status = db_->TryCatchUpWithPrimary();
     if(!status.ok()) {
-        FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
+        EVT_THROW(token_database_rocksdb_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
     }
-    if(should_record()) {
-        void* data;
+}
 
-        // for `token` action, needs to record both prefix and key, prefix refers to the domain
-        // for `non-token` action, prefix is not necessary which can be inferred by the `type`
-        if(type != token_type::token) {
-            assert(prefix == action_key_prefixes[(int)type]);
-            auto data = (rt_token_key*)malloc(sizeof(rt_token_key));
-            data->key = key;
+// filters persisted when closed are taken when they're written from the same db at the same
+// sequence, the file is removed once read so a crash never leaves stale filters behind
+void
+token_database_impl::load_key_filters() {
+    using namespace internal;
 
-            record((int)type, (int)op, (int)kTokenKey, data);
+    auto start    = fc::time_point::now();
+    auto filename = config_.db_path / config::token_database_filters_filename;
+    auto loaded   = false;
+    if(config_.profile != storage_profile::ram && fc::exists(filename)) {
+        try {
+            auto fs = std::fstream();
+            fs.exceptions(std::fstream::failbit | std::fstream::badbit);
+            fs.open(filename.to_native_ansi_path(), (std::ios::in | std::ios::binary));
+
+            auto h = kf_header();
+            fc::raw::unpack(fs, h);
+
+            auto identity = std::string();
+            db_->GetDbIdentity(identity);
+            if(h.version == kKeyFiltersVersion && h.sequence == db_->GetLatestSequenceNumber() && h.identity == identity) {
+                loaded = true;
+                for(auto i = 0; i <= (int)token_type::max_value && loaded; i++) {
+                    if(is_filtered_type(i)) {
+                        loaded = key_filters_[i].read(fs);
+                    }
+                }
+            }
         }
-        else {
-            auto data    = (rt_token_fullkey*)malloc(sizeof(rt_token_fullkey));
-            data->prefix = prefix;
-            data->key    = key;
-
-            record((int)type, (int)op, (int)kTokenFullKey, data);
+        catch(const std::exception& e) {
+            wlog("Cannot load the key filters of token database: ${e}", ("e", e.what()));
+            loaded = false;
         }
+        catch(const fc::exception& e) {
+            wlog("Cannot load the key filters of token database: ${e}", ("e", e.to_string()));
+            loaded = false;
+        }
+        fc::remove(filename);
+    }
+    if(!loaded) {
+        build_key_filters();
+    }
+    key_filtered_ = true;
+
+    auto keys  = size_t(0);
+    auto bytes = size_t(0);
+    for(auto& f : key_filters_) {
+        keys  += f.size();
+        bytes += f.memory_usage();
+    }
+    if(keys > 0) {
+        ilog("${a} ${n} keys into filters in ${t} ms, ${m} bytes", ("a", loaded ? "Loaded" : "Built")("n", keys)
+            ("t", (fc::time_point::now() - start).count() / 1000)("m", bytes));
     }
 }
 
+// scans the keys of the type in db, it's started over with a larger filter when it's full
+// tokens are all the keys out of the reserved prefixes, they're scanned across prefixes and
+// the entries of owner index and holding index are taken as well, they can't be told apart
 void
-token_database_impl::put_tokens(token_type type,
-                                action_op op,
-                                const name128& prefix,
-                                token_keys_t&& keys,
-                                const small_vector_base<std::string_view>& data){
+token_database_impl::build_key_filter(token_type type, size_t capacity) {
     using namespace internal;
-    assert(keys.size() == data.size());
 
-    for(auto i = 0u; i < keys.size(); i++) {
-        auto dbkey  = db_token_key(prefix, keys[i]);
-        auto status = db_->Put(write_opts_, dbkey.as_slice(), data[i]);
-        if(!status.ok()) {
-            FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
+    auto& filter = key_filters_[(int)type];
+    auto  add    = [&](const rocksdb::Slice& key) { return filter.add(key_hash(key)); };
+
+    auto scan_prefix = [&](const name128& prefix) {
+        auto it    = std::unique_ptr<rocksdb::Iterator>(db_->NewIterator(read_opts_, tokens_handle_));
+        auto slice = rocksdb::Slice((const char*)&prefix, sizeof(prefix));
+        for(it->Seek(slice); it->Valid() && it->key().starts_with(slice); it->Next()) {
+            if(!add(it->key())) {
+                return false;
+            }
         }
-    }
-    if(should_record()) {
-        auto data = (rt_token_keys*)malloc(sizeof(rt_token_keys));
-        data->prefix = prefix;
-        new(&data->keys) token_keys_t(std::move(keys));
+        return true;
+    };
 
-        record((int)type, (int)op, (int)kTokenKeys, data);
+    auto scan_tokens = [&] {
+        auto opts = read_opts_;
+        opts.total_order_seek = true;
+
+        auto it = std::unique_ptr<rocksdb::Iterator>(db_->NewIterator(opts, tokens_handle_));
+        it->SeekToFirst();
+        while(it->Valid()) {
+            auto key      = it->key();
+            auto reserved = std::any_of(std::begin(action_key_prefixes), std::end(action_key_prefixes), [&](auto& p) {
+                return key.size() >= sizeof(p) && memcmp(key.data(), &p, sizeof(p)) == 0;
+            });
+            if(reserved) {
+                // past all the keys of the prefix
+                auto end = std::string(key.data(), sizeof(name128)).append(sizeof(name128) + 1, '\xff');
+                it->Seek(end);
+                continue;
+            }
+            if(!add(key)) {
+                return false;
+            }
+            it->Next();
+        }
+        return true;
+    };
+
+    filter_generation_++;
+    while(true) {
+        filter.reset(std::max(capacity, kMinKeyFilterSize));
+        if(type == token_type::token ? scan_tokens() : scan_prefix(action_key_prefixes[(int)type])) {
+            break;
+        }
+        capacity = filter.capacity() * 2;
     }
 }
 
 void
-token_database_impl::put_asset(const address& addr, const symbol_id_type sym_id, const std::string_view& data) {
+token_database_impl::build_key_filters() {
     using namespace internal;
 
-    auto dbkey = db_asset_key(addr, sym_id);
-    if(should_record()) {
-        assets_write_cache_.put(dbkey.as_string_view(), data);
-        return;
-    }
-    else {
-        auto status = db_->Put(write_opts_, assets_handle_, dbkey.as_slice(), data);
-        if(!status.ok()) {
-            FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
+    for(auto i = 0; i <= (int)token_type::max_value; i++) {
+        if(is_filtered_type(i)) {
+            build_key_filter((token_type)i, 0);
         }
     }
 }
 
-int
-token_database_impl::exists_token(const name128& prefix, const name128& key) const {
+void
+token_database_impl::persist_key_filters() const {
     using namespace internal;
 
-    auto dbkey  = db_token_key(prefix, key);
-    auto value  = std::string();
-    auto status = db_->Get(read_opts_, dbkey.as_slice(), &value);
-    return status.ok();
+    try {
+        auto filename = config_.db_path / config::token_database_filters_filename;
+        auto fs       = std::fstream();
+        fs.exceptions(std::fstream::failbit | std::fstream::badbit);
+        fs.open(filename.to_native_ansi_path(), (std::ios::out | std::ios::binary | std::ios::trunc));
+
+        auto h = kf_header {
+            .version  = kKeyFiltersVersion,
+            .sequence = db_->GetLatestSequenceNumber()
+        };
+        db_->GetDbIdentity(h.identity);
+        fc::raw::pack(fs, h);
+        for(auto i = 0; i <= (int)token_type::max_value; i++) {
+            if(is_filtered_type(i)) {
+                key_filters_[i].write(fs);
+            }
+        }
+        fs.flush();
+        fs.close();
+    }
+    // filters are rebuilt from db next time
+    catch(const std::exception& e) {
+        wlog("Cannot persist the key filters of token database: ${e}", ("e", e.what()));
+    }
+    catch(const fc::exception& e) {
+        wlog("Cannot persist the key filters of token database: ${e}", ("e", e.to_string()));
+    }
 }
 
+// whether the written key is a new one to add into filters, keys of `put` ops are checked in db
 int
-token_database_impl::exists_asset(const address& addr, const symbol_id_type sym_id) const {
+token_database_impl::is_new_filtered_key(token_type type, action_op op, const rocksdb::Slice& key) const {
     using namespace internal;
 
-    auto dbkey  = db_asset_key(addr, sym_id);
-    auto value  = std::string();
-
-    if(assets_write_cache_.exists(dbkey.as_string_view())) {
+    if(!key_filtered_ || !is_filtered_type((int)type)) {
+        return false;
+    }
+    switch(op) {
+    case action_op::add: {
         return true;
     }
-    auto status = db_->Get(read_opts_, assets_handle_, dbkey.as_slice(), &value);
-    return status.ok();
+    case action_op::put: {
+        auto value = std::string();
+        return db_->Get(read_opts_, tokens_handle_, key, &value).IsNotFound();
+    }
+    default: {
+        return false;
+    }
+    }  // switch
 }
 
+// the key is already in db, returns false when the filter is full and rebuilt from db with it
 int
-token_database_impl::read_token(const name128& prefix, const name128& key, std::string& out, bool no_throw) const {
+token_database_impl::add_to_key_filter(token_type type, const rocksdb::Slice& key) {
     using namespace internal;
 
-    auto dbkey  = db_token_key(prefix, key);
-    auto status = db_->Get(read_opts_, dbkey.as_slice(), &out);
-    if(!status.ok()) {
+    auto& filter = key_filters_[(int)type];
+    if(filter.add(key_hash(key))) {
+        return true;
+    }
+
+    auto start = fc::time_point::now();
+    build_key_filter(type, filter.capacity() * 2);
+    filter_rebuilds_++;
+    ilog("Rebuilt full key filter of ${t} for ${n} keys in ${ms} ms", ("t", fc::reflector<token_type>::to_string(type))("n", filter.size())
+        ("ms", (fc::time_point::now() - start).count() / 1000));
+    return false;
+}
+
+// only for the keys added by the runtime savepoint being rolled back, which were added into filter
+void
+token_database_impl::remove_from_key_filter(token_type type, const rocksdb::Slice& key) {
+    using namespace internal;
+
+    if(key_filtered_ && is_filtered_type((int)type)) {
+        key_filters_[(int)type].remove(key_hash(key));
+    }
+}
+
+// false when the key is not in db for sure
+int
+token_database_impl::may_exist(token_type type, const rocksdb::Slice& key) const {
+    using namespace internal;
+
+    if(!key_filtered_ || !is_filtered_type((int)type)) {
+        return true;
+    }
+    if(!key_filters_[(int)type].may_contain(key_hash(key))) {
+        filter_negatives_++;
+        return false;
+    }
+    filter_positives_++;
+    return true;
+}
+
+void
+token_database_impl::close(int persist) {
+    if(db_) {
+        stop_tuning_worker();
+        stop_tiering_worker();
+        stop_persist_worker();
+        if(persist && config_.profile != storage_profile::ram && !is_secondary()) {
+            persist_savepoints();
+            persist_key_filters();
+        }
+        if(!savepoints_.empty()) {
+            free_all_savepoints();
+        }
+        irreversible_view_.reset();
+        irreversible_assets_.reset();
+        for(auto& f : key_filters_) {
+            f.clear();
+        }
+        key_filtered_ = false;
+        
+        delete tokens_handle_;
+        delete assets_handle_;
+        delete db_;
+
+        db_ = nullptr;
+        env_.reset();
+    }
+}
+
+void
+token_database_impl::put_token(token_type type, action_op op, const name128& prefix, const name128& key, const std::string_view& data) {
+    using namespace internal;
+
+    check_writable();
+
+    auto dbkey = db_token_key(prefix, key);
+    if(bulk_mode_) {
+        // owner index and key filters are rebuilt when bulk loading is ended
+        bulk_put(bulk_tokens_, dbkey.as_slice(), rocksdb::Slice(data.data(), data.size()));
+        return;
+    }
+    auto filter = is_new_filtered_key(type, op, dbkey.as_slice());
+    if(type == token_type::token && config_.owner_index) {
+        auto old_value = std::string();
+        if(op != action_op::add) {
+            read_old_token(dbkey.as_slice(), old_value);
+        }
+        update_owner_index(prefix, key, old_value, data);
+    }
+    if(should_record()) {
+        prepare_record();
+        keep_prev_value(dbkey.as_slice(), op);
+    }
+    // indexes are derived from other values, they're not a part of integrity hash
+    if(!is_index_type((int)type)) {
+        mark_token_dirty(prefix);
+    }
+
+    auto status = db_->Put(write_opts_, dbkey.as_slice(), data);
+    if(!status.ok()) {
+        FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
+    }
+    if(filter) {
+        add_to_key_filter(type, dbkey.as_slice());
+    }
+    if(should_record()) {
+        void* data;
+
+        // for `token` action, needs to record both prefix and key, prefix refers to the domain
+        // so do index actions, prefix refers to the indexed address
+        // for other actions, prefix is not necessary which can be inferred by the `type`
+        if(type != token_type::token && !is_index_type((int)type)) {
+            assert(prefix == action_key_prefixes[(int)type]);
+            auto data = (rt_token_key*)malloc(sizeof(rt_token_key));
+            data->key = key;
+
+            record((int)type, (int)op, (int)kTokenKey, data);
+        }
+        else {
+            auto data    = (rt_token_fullkey*)malloc(sizeof(rt_token_fullkey));
+            data->prefix = prefix;
+            data->key    = key;
+
+            record((int)type, (int)op, (int)kTokenFullKey, data);
+        }
+    }
+}
+
+void
+token_database_impl::put_tokens(token_type type,
+                                action_op op,
+                                const name128& prefix,
+                                token_keys_t&& keys,
+                                const small_vector_base<std::string_view>& data){
+    using namespace internal;
+    assert(keys.size() == data.size());
+    check_writable();
+
+    if(bulk_mode_) {
+        for(auto i = 0u; i < keys.size(); i++) {
+            auto dbkey = db_token_key(prefix, keys[i]);
+            bulk_put(bulk_tokens_, dbkey.as_slice(), rocksdb::Slice(data[i].data(), data[i].size()));
+        }
+        return;
+    }
+
+    if(type == token_type::token && config_.owner_index) {
+        auto old_value = std::string();
+        for(auto i = 0u; i < keys.size(); i++) {
+            old_value.clear();
+            if(op != action_op::add) {
+                read_old_token(db_token_key(prefix, keys[i]).as_slice(), old_value);
+            }
+            update_owner_index(prefix, keys[i], old_value, data[i]);
+        }
+    }
+    if(should_record()) {
+        prepare_record();
+        for(auto& k : keys) {
+            keep_prev_value(db_token_key(prefix, k).as_slice(), op);
+        }
+    }
+    if(!is_index_type((int)type)) {
+        mark_token_dirty(prefix);
+    }
+
+    // write all the tokens in one batch
+    auto batch = rocksdb::WriteBatch();
+    auto added = small_vector<uint32_t, 4>();  // indexes of the new keys to add into filter
+    for(auto i = 0u; i < keys.size(); i++) {
+        auto dbkey = db_token_key(prefix, keys[i]);
+        if(is_new_filtered_key(type, op, dbkey.as_slice())) {
+            added.emplace_back(i);
+        }
+        batch.Put(tokens_handle_, dbkey.as_slice(), rocksdb::Slice(data[i].data(), data[i].size()));
+    }
+    auto status = db_->Write(write_opts_, &batch);
+    if(!status.ok()) {
+        FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
+    }
+    // a rebuilt filter already has all of them
+    for(auto i : added) {
+        if(!add_to_key_filter(type, db_token_key(prefix, keys[i]).as_slice())) {
+            break;
+        }
+    }
+    if(should_record()) {
+        auto data = (rt_token_keys*)malloc(sizeof(rt_token_keys));
+        data->prefix = prefix;
+        new(&data->keys) token_keys_t(std::move(keys));
+
+        record((int)type, (int)op, (int)kTokenKeys, data);
+    }
+}
+
+void
+token_database_impl::put_asset(const address& addr, const symbol_id_type sym_id, const std::string_view& data) {
+    using namespace internal;
+
+    check_writable();
+
+    auto dbkey = db_asset_key(addr, sym_id);
+    if(bulk_mode_) {
+        bulk_put(bulk_assets_, dbkey.as_slice(), rocksdb::Slice(data.data(), data.size()));
+        return;
+    }
+    if(config_.holding_index) {
+        add_holding(addr, sym_id);
+    }
+    mark_asset_dirty(sym_id);
+    if(should_record()) {
+        assets_write_cache_.put(dbkey.as_string_view(), data);
+        return;
+    }
+    else {
+        auto status = db_->Put(write_opts_, assets_handle_, dbkey.as_slice(), data);
+        if(!status.ok()) {
+            FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
+        }
+    }
+}
+
+void
+token_database_impl::put_assets(const small_vector_base<asset_key_t>& keys, const small_vector_base<std::string_view>& data) {
+    using namespace internal;
+    assert(keys.size() == data.size());
+    check_writable();
+
+    if(bulk_mode_) {
+        for(auto i = 0u; i < keys.size(); i++) {
+            auto dbkey = db_asset_key(keys[i].first, keys[i].second);
+            bulk_put(bulk_assets_, dbkey.as_slice(), rocksdb::Slice(data[i].data(), data[i].size()));
+        }
+        return;
+    }
+    for(auto& k : keys) {
+        if(config_.holding_index) {
+            add_holding(k.first, k.second);
+        }
+        mark_asset_dirty(k.second);
+    }
+    if(should_record()) {
+        for(auto i = 0u; i < keys.size(); i++) {
+            auto dbkey = db_asset_key(keys[i].first, keys[i].second);
+            assets_write_cache_.put(dbkey.as_string_view(), data[i]);
+        }
+        return;
+    }
+
+    auto batch = rocksdb::WriteBatch();
+    for(auto i = 0u; i < keys.size(); i++) {
+        auto dbkey = db_asset_key(keys[i].first, keys[i].second);
+        batch.Put(assets_handle_, dbkey.as_slice(), rocksdb::Slice(data[i].data(), data[i].size()));
+    }
+    auto status = db_->Write(write_opts_, &batch);
+    if(!status.ok()) {
+        FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
+    }
+}
+
+void
+token_database_impl::update_asset(const address& addr, const symbol_id_type sym_id, const update_value_func& func) {
+    using namespace internal;
+
+    assert(!bulk_mode_);
+
+    auto dbkey = db_asset_key(addr, sym_id);
+    if(should_record()) {
+        mark_asset_dirty(sym_id);
+        if(assets_write_cache_.update(dbkey.as_string_view(), func)) {
+            return;
+        }
+    }
+
+    auto value = std::string();
+    read_asset(addr, sym_id, value, true /* no throw */);
+    func(value);
+    put_asset(addr, sym_id, value);
+}
+
+int
+token_database_impl::exists_token(token_type type, const name128& prefix, const name128& key) const {
+    using namespace internal;
+
+    auto dbkey = db_token_key(prefix, key);
+    if(!may_exist(type, dbkey.as_slice())) {
+        return false;
+    }
+
+    auto value  = std::string();
+    auto status = db_->Get(read_opts_, dbkey.as_slice(), &value);
+    if(!status.ok() && key_filtered_ && is_filtered_type((int)type)) {
+        filter_false_positives_++;
+    }
+    return status.ok();
+}
+
+int
+token_database_impl::exists_asset(const address& addr, const symbol_id_type sym_id) const {
+    using namespace internal;
+
+    auto dbkey  = db_asset_key(addr, sym_id);
+    auto value  = std::string();
+
+    if(assets_write_cache_.exists(dbkey.as_string_view())) {
+        return true;
+    }
+    auto status = db_->Get(read_opts_, assets_handle_, dbkey.as_slice(), &value);
+    return status.ok();
+}
+
+int
+token_database_impl::read_token(const name128& prefix, const name128& key, std::string& out, bool no_throw) const {
+    using namespace internal;
+
+    auto dbkey  = db_token_key(prefix, key);
+    auto status = db_->Get(read_opts_, dbkey.as_slice(), &out);
+    if(!status.ok()) {
         if(!status.IsNotFound()) {
             FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
         }
@@ -769,186 +1726,951 @@ token_database_impl::read_asset(const address& addr, const symbol_id_type sym_id
 }
 
 int
-token_database_impl::read_tokens_range(const name128& prefix, int skip, const read_value_func& func) const {
+token_database_impl::read_tokens(token_type type, const name128& prefix, const small_vector_base<name128>& keys, read_values_t& outs, bool no_throw) const {
     using namespace internal;
 
-    auto it    = db_->NewIterator(read_opts_);
-    auto key   = rocksdb::Slice((char*)&prefix, sizeof(prefix));
-    auto i     = 0;
-    auto count = 0;
-    
-    it->Seek(key);
-    while(it->Valid()) {
-        if(i++ < skip) {
-            it->Next();
+    const auto ksz = sizeof(name128) * 2;
+    const auto sz  = keys.size();
+
+    // keys share the same layout with `db_token_key`, store them continuously
+    // only the ones which may exist are read, see `may_exist`
+    auto buf     = std::string(sz * ksz, '\0');
+    auto slices  = std::vector<rocksdb::Slice>();
+    auto indexes = std::vector<uint32_t>();
+    slices.reserve(sz);
+    indexes.reserve(sz);
+    for(auto i = 0u; i < sz; i++) {
+        auto p = (char*)buf.data() + i * ksz;
+        memcpy(p, &prefix, sizeof(name128));
+        memcpy(p + sizeof(name128), &keys[i], sizeof(name128));
+
+        auto slice = rocksdb::Slice(p, ksz);
+        if(!may_exist(type, slice)) {
+            if(!no_throw) {
+                EVT_THROW(unknown_token_database_key, "Cannot find key: ${k} with prefix: ${p}", ("k",keys[i])("p",prefix));
+            }
             continue;
         }
+        slices.emplace_back(slice);
+        indexes.emplace_back(i);
+    }
 
-        count++;
-        auto value = it->value().ToString();
-        auto key   = it->key();
+    auto handles = std::vector<rocksdb::ColumnFamilyHandle*>(slices.size(), tokens_handle_);
+    auto values  = std::vector<std::string>();
+    auto status  = db_->MultiGet(read_opts_, handles, slices, &values);
 
-        key.remove_prefix(sizeof(prefix));
-        if(!func(key.ToStringView(), std::move(value))) {
-            delete it;
-            return count;
+    outs.clear();
+    outs.resize(sz);
+
+    auto count    = 0;
+    auto filtered = key_filtered_ && is_filtered_type((int)type);
+    for(auto j = 0u; j < slices.size(); j++) {
+        auto i = indexes[j];
+        if(status[j].ok()) {
+            outs[i] = std::move(values[j]);
+            count++;
+            continue;
+        }
+        if(!status[j].IsNotFound()) {
+            FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", status[j].getState()));
+        }
+        if(filtered) {
+            filter_false_positives_++;
+        }
+        if(!no_throw) {
+            EVT_THROW(unknown_token_database_key, "Cannot find key: ${k} with prefix: ${p}", ("k",keys[i])("p",prefix));
         }
-        it->Next();
     }
-    delete it;
     return count;
 }
 
 int
-token_database_impl::read_assets_range(const symbol_id_type sym_id, int skip, const read_value_func& func) const {
+token_database_impl::read_assets(const small_vector_base<asset_key_t>& keys, read_values_t& outs, bool no_throw) const {
     using namespace internal;
 
-    // create snapshot first
-    auto ss = db_->GetSnapshot();
-    
-    // write new values from cache into db
-    for(auto& it : assets_write_cache_.data_) {
-        auto k = rocksdb::Slice(it.first().data(), it.first().size());
-        auto v = rocksdb::Slice(it.second.value.data(), it.second.value.size());
-        db_->Put(write_opts_, assets_handle_, k, v);
-    }
-
-    // scan values
-    auto it    = db_->NewIterator(read_opts_, assets_handle_);
-    auto key   = rocksdb::Slice((char*)&sym_id, sizeof(sym_id));
-    auto count = 0;
-    auto i     = 0;
-    
-    it->Seek(key);
-    while(it->Valid()) {
-        if(i++ < skip) {
-            it->Next();
+    const auto ksz = kSymbolIdSize + kPublicKeySize;
+    const auto sz  = keys.size();
+
+    outs.clear();
+    outs.resize(sz);
+
+    auto count  = 0;
+    auto buf    = std::string(sz * ksz, '\0');
+    auto slices = std::vector<rocksdb::Slice>();
+    auto idxs   = std::vector<size_t>();  // indexes of keys which are missed in write cache
+    slices.reserve(sz);
+    idxs.reserve(sz);
+
+    for(auto i = 0u; i < sz; i++) {
+        auto dbkey = db_asset_key(keys[i].first, keys[i].second);
+        auto str   = std::string();
+        if(assets_write_cache_.read(dbkey.as_string_view(), str)) {
+            outs[i] = std::move(str);
+            count++;
             continue;
         }
 
-        count++;
-        auto value = it->value().ToString();
-        auto key   = it->key();
+        auto p = (char*)buf.data() + i * ksz;
+        memcpy(p, dbkey.as_slice().data(), ksz);
+        slices.emplace_back(p, ksz);
+        idxs.emplace_back(i);
+    }
 
-        key.remove_prefix(sizeof(sym_id));
-        if(!func(key.ToStringView(), std::move(value))) {
-            delete it;
-            return count;
-        }
-        it->Next();
+    if(slices.empty()) {
+        return count;
     }
-    delete it;
 
-    // restore values
-    auto snapshot_read_opts_     = read_opts_;
-    snapshot_read_opts_.snapshot = ss;
+    auto handles = std::vector<rocksdb::ColumnFamilyHandle*>(slices.size(), assets_handle_);
+    auto values  = std::vector<std::string>();
+    auto status  = db_->MultiGet(read_opts_, handles, slices, &values);
 
-    auto batch = rocksdb::WriteBatch();
-    for(auto& it : assets_write_cache_.data_) {
-        auto v = std::string();
-        auto k = rocksdb::Slice(it.first().data(), it.first().size());
-        auto s = db_->Get(snapshot_read_opts_, assets_handle_, k, &v);
-        if(s.ok()) {
-            // put value back
-            batch.Put(assets_handle_, k, v);
-        }
-        else if(s.code() == rocksdb::Status::kNotFound) {
-            // remove value
-            batch.Delete(assets_handle_, k);
+    for(auto j = 0u; j < slices.size(); j++) {
+        auto i = idxs[j];
+        if(status[j].ok()) {
+            outs[i] = std::move(values[j]);
+            count++;
+            continue;
         }
-        else {
-            FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", s.getState()));
+        if(!status[j].IsNotFound()) {
+            FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", status[j].getState()));
+        }
+        if(!no_throw) {
+            EVT_THROW2(unknown_token_database_key, "There's no balance of fungible with sym id: {} in address: {}", keys[i].second, keys[i].first);
         }
     }
-    auto sync_write_opts = write_opts_;
-    sync_write_opts.sync = true;
-    db_->Write(sync_write_opts, &batch);
+    return count;
+}
+
+// values are read and dropped, only the blocks loaded into block cache are kept
+// write cache isn't looked up as it's only touched by the main thread
+void
+token_database_impl::prefetch(const std::vector<std::pair<name128, name128>>& tokens, const std::vector<asset_key_t>& assets) const {
+    using namespace internal;
+
+    const auto tsz = sizeof(name128) * 2;
+    const auto asz = kSymbolIdSize + kPublicKeySize;
+    const auto sz  = tokens.size() + assets.size();
+
+    auto buf     = std::string(tokens.size() * tsz + assets.size() * asz, '\0');
+    auto slices  = std::vector<rocksdb::Slice>();
+    auto handles = std::vector<rocksdb::ColumnFamilyHandle*>();
+    slices.reserve(sz);
+    handles.reserve(sz);
+
+    auto p = (char*)buf.data();
+    for(auto& [prefix, key] : tokens) {
+        memcpy(p, &prefix, sizeof(name128));
+        memcpy(p + sizeof(name128), &key, sizeof(name128));
+        slices.emplace_back(p, tsz);
+        handles.emplace_back(tokens_handle_);
+        p += tsz;
+    }
+    for(auto& [addr, sym_id] : assets) {
+        auto dbkey = db_asset_key(addr, sym_id);
+        memcpy(p, dbkey.as_slice().data(), asz);
+        slices.emplace_back(p, asz);
+        handles.emplace_back(assets_handle_);
+        p += asz;
+    }
+
+    // errors are left to the reads of execution
+    auto values = std::vector<std::string>();
+    db_->MultiGet(read_opts_, handles, slices, &values);
+    keys_prefetched_ += sz;
+}
+
+int
+token_database_impl::read_tokens_range(const name128& prefix, int skip, std::string& cursor, const read_value_func& func) const {
+    using namespace internal;
+
+    auto it    = std::unique_ptr<rocksdb::Iterator>(db_->NewIterator(read_opts_));
+    auto key   = std::string((char*)&prefix, sizeof(prefix));
+    auto i     = 0;
+    auto count = 0;
+
+    // continue right after the cursor key
+    key.append(cursor);
+    it->Seek(key);
+    if(!cursor.empty() && it->Valid() && it->key() == key) {
+        it->Next();
+    }
+
+    while(it->Valid()) {
+        if(i++ < skip) {
+            it->Next();
+            continue;
+        }
+
+        count++;
+        auto value = it->value().ToString();
+        auto key   = it->key();
+
+        key.remove_prefix(sizeof(prefix));
+        cursor.assign(key.data(), key.size());
+        if(!func(key.ToStringView(), std::move(value))) {
+            return count;
+        }
+        it->Next();
+    }
+    return count;
+}
+
+int
+token_database_impl::read_tokens_prefix(const name128& prefix, const std::string_view& key_prefix, const read_value_func& func) const {
+    auto it = std::unique_ptr<rocksdb::Iterator>(db_->NewIterator(read_opts_));
+    return internal::read_prefixed_tokens(it.get(), prefix, key_prefix, func);
+}
+
+int
+token_database_impl::read_assets_range(const symbol_id_type sym_id, int skip, std::string& cursor, const read_value_func& func) const {
+    using namespace internal;
+
+    auto prefix = std::string_view((char*)&sym_id, sizeof(sym_id));
+    auto key    = std::string(prefix);
+    key.append(cursor);
+
+    // collect pending values of this symbol after the cursor from write cache, sorted by key
+    auto pending = std::vector<std::pair<std::string_view, std::string_view>>();
+    assets_write_cache_.data_.for_each([&](auto& it) {
+        auto k = it.key();
+        if(k.compare(0, prefix.size(), prefix) != 0) {
+            return;
+        }
+        if(!cursor.empty() && k <= key) {
+            return;
+        }
+        pending.emplace_back(k, std::string_view(it.second.value.data(), it.second.value.size()));
+    });
+    std::sort(pending.begin(), pending.end());
+
+    // merge pending values with the ones in db, pending values take precedence
+    auto it    = std::unique_ptr<rocksdb::Iterator>(db_->NewIterator(read_opts_, assets_handle_));
+    auto pi    = 0u;
+    auto i     = 0;
+    auto count = 0;
+
+    it->Seek(key);
+    if(!cursor.empty() && it->Valid() && it->key() == key) {
+        it->Next();
+    }
+
+    while(it->Valid() || pi < pending.size()) {
+        auto k = std::string_view();
+        auto v = std::string_view();
+
+        auto c = 1;
+        if(it->Valid()) {
+            c = (pi < pending.size()) ? it->key().ToStringView().compare(pending[pi].first) : -1;
+        }
+        if(c < 0) {
+            k = it->key().ToStringView();
+            v = it->value().ToStringView();
+        }
+        else {
+            k = pending[pi].first;
+            v = pending[pi].second;
+        }
+
+        if(i++ >= skip) {
+            count++;
+            k.remove_prefix(prefix.size());
+            cursor.assign(k.data(), k.size());
+            if(!func(k, std::string(v))) {
+                return count;
+            }
+        }
+
+        if(c <= 0) {
+            it->Next();
+        }
+        if(c >= 0) {
+            pi++;
+        }
+    }
+    return count;
+}
+
+int
+token_database_impl::read_owned_tokens(const address& owner, int skip, const read_owned_func& func) const {
+    using namespace internal;
+
+    // tokens no longer owned are still in the partition, skip them by hand
+    auto cursor = std::string();
+    auto i      = 0;
+    auto count  = 0;
+    read_tokens_range(owner_prefix(owner), 0, cursor, [&](auto&, auto&& value) {
+        if(value.size() != kOwnedValueSize || !value[kOwnedValueSize - 1]) {
+            return true;
+        }
+        if(i++ < skip) {
+            return true;
+        }
+
+        auto domain = name128();
+        auto name   = name128();
+        memcpy(&domain, value.data(), sizeof(name128));
+        memcpy(&name, value.data() + sizeof(name128), sizeof(name128));
+
+        count++;
+        return func(domain, name);
+    });
+    return count;
+}
+
+void
+token_database_impl::update_owner_index(const name128& domain,
+                                        const name128& name,
+                                        const std::string_view& old_value,
+                                        const std::string_view& new_value) {
+    using namespace internal;
+
+    auto olds = token_owners(old_value);
+    auto news = token_owners(new_value);
+
+    // destroyed tokens are owned by the reserved address, they are not indexed
+    for(auto& o : olds) {
+        if(!o.is_reserved() && std::find(news.cbegin(), news.cend(), o) == news.cend()) {
+            put_owned_token(o, domain, name, false);
+        }
+    }
+    for(auto& n : news) {
+        if(!n.is_reserved() && std::find(olds.cbegin(), olds.cend(), n) == olds.cend()) {
+            put_owned_token(n, domain, name, true);
+        }
+    }
+}
+
+void
+token_database_impl::put_owned_token(const address& owner, const name128& domain, const name128& name, bool owned) {
+    using namespace internal;
+
+    char value[kOwnedValueSize];
+    memcpy(value, &domain, sizeof(name128));
+    memcpy(value + sizeof(name128), &name, sizeof(name128));
+    value[kOwnedValueSize - 1] = owned;
+
+    put_token(token_type::owner, action_op::put, owner_prefix(owner), owned_key(domain, name), std::string_view(value, sizeof(value)));
+}
+
+void
+token_database_impl::read_old_token(const rocksdb::Slice& key, std::string& value) const {
+    auto status = db_->Get(read_opts_, key, &value);
+    if(!status.ok() && status.code() != rocksdb::Status::kNotFound) {
+        FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
+    }
+}
+
+void
+token_database_impl::check_index(token_type type, bool enabled_now, bool created) {
+    using namespace internal;
+
+    auto key = db_token_key(action_key_prefixes[(int)type], type == token_type::owner ? kOwnerIndexFlag : kHoldingIndexFlag);
+    if(created) {
+        if(enabled_now) {
+            auto status = db_->Put(write_opts_, key.as_slice(), "1");
+            if(!status.ok()) {
+                FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
+            }
+        }
+        return;
+    }
+
+    // the index is only complete when it's maintained since the database is created
+    auto value   = std::string();
+    auto enabled = db_->Get(read_opts_, key.as_slice(), &value).ok();
+    EVT_ASSERT(enabled == enabled_now, token_database_exception,
+        "${t} index should be the same as when token database was created (${e}), replay or restore from snapshot to change it",
+        ("t",type == token_type::owner ? "Owner" : "Holding")("e",enabled ? "enabled" : "disabled"));
+}
+
+void
+token_database_impl::rebuild_owner_index() {
+    using namespace internal;
+    assert(savepoints_.empty());
+
+    auto domains = std::vector<name128>();
+    auto cursor  = std::string();
+    read_tokens_range(action_key_prefixes[(int)token_type::domain], 0, cursor, [&](auto& key, auto&&) {
+        auto n = name128();
+        memcpy(&n, key.data(), sizeof(n));
+        domains.emplace_back(n);
+        return true;
+    });
+
+    for(auto& d : domains) {
+        cursor.clear();
+        read_tokens_range(d, 0, cursor, [&](auto& key, auto&& value) {
+            auto n = name128();
+            memcpy(&n, key.data(), sizeof(n));
+            update_owner_index(d, n, std::string_view(), value);
+            return true;
+        });
+    }
+}
+
+int
+token_database_impl::read_held_symbols(const address& addr, const read_held_func& func) const {
+    auto cursor = std::string();
+    return read_tokens_range(internal::holding_prefix(addr), 0, cursor, [&](auto&, auto&& value) {
+        auto sym_id = symbol_id_type();
+        memcpy(&sym_id, value.data(), sizeof(sym_id));
+        return func(sym_id);
+    });
+}
+
+void
+token_database_impl::add_holding(const address& addr, const symbol_id_type sym_id) {
+    using namespace internal;
+
+    // the index is checked first, only new holders are written
+    auto prefix = holding_prefix(addr);
+    auto key    = name128::from_number(sym_id);
+    if(exists_token(token_type::holding, prefix, key)) {
+        return;
+    }
+    put_token(token_type::holding, action_op::add, prefix, key, std::string_view((const char*)&sym_id, sizeof(sym_id)));
+}
+
+void
+token_database_impl::rebuild_holding_index() {
+    using namespace internal;
+    assert(savepoints_.empty());
+
+    // asset keys are symbol id followed by address, scan them all across prefixes
+    auto opts = read_opts_;
+    opts.total_order_seek = true;
+
+    auto it = std::unique_ptr<rocksdb::Iterator>(db_->NewIterator(opts, assets_handle_));
+    for(it->SeekToFirst(); it->Valid(); it->Next()) {
+        auto key = it->key();
+        if(key.size() != kSymbolIdSize + kPublicKeySize) {
+            continue;
+        }
+
+        auto sym_id = symbol_id_type();
+        memcpy(&sym_id, key.data(), kSymbolIdSize);
+        put_token(token_type::holding, action_op::put, holding_prefix(key.data() + kSymbolIdSize), name128::from_number(sym_id),
+            std::string_view((const char*)&sym_id, sizeof(sym_id)));
+    }
+}
+
+void
+token_database_impl::add_savepoint(int64_t seq, bool nested) {
+    using namespace internal;
+
+    check_writable();
+
+    if(!savepoints_.empty()) {
+        auto& b = savepoints_.back();
+        if(b.seq >= seq) {
+            EVT_THROW(token_database_seq_not_valid, "Seq is not valid, prev: ${prev}, curr: ${curr}",
+                      ("prev", b.seq)("curr", seq));
+        }
+    }
+    else {
+        // values written without savepoints are irreversible right away
+        update_irreversible_view();
+    }
+
+    // only groups on top of runtime ones are nested, the others may become the oldest one
+    nested = nested && !savepoints_.empty() && savepoints_.back().node.f.type == kRuntime;
+
+    savepoints_.push_back(savepoint(seq, kRuntime));
+    auto rt = new rt_group { .rb_snapshot = nullptr, .actions = {}, .prev_values = std::make_unique<prev_values_t>(), .nested = nested,
+                             .filter_generation = filter_generation_ };
+    SETPOINTER(void, savepoints_.back().node.group, rt);
+
+    assets_write_cache_.add_savepoint(seq);
+}
+
+void
+token_database_impl::free_savepoint(internal::savepoint& sp) {
+    using namespace internal;
+
+    auto n = sp.node;
+
+    switch(n.f.type) {
+    case kRuntime: {
+        auto rt = GETPOINTER(rt_group, n.group);
+        for(auto& act : rt->actions) {
+            switch(act.get_data_type()) {
+            case kTokenKey:
+            case kTokenFullKey:
+            case kAssetKey: {
+                free(GETPOINTER(void, act.data));
+                break;
+            }
+            case kTokenKeys: {
+                auto p = GETPOINTER(rt_token_keys, act.data);
+                //need to call dtor of keys manually
+                p->keys.~token_keys_t();
+                free(p);
+                break;
+            }
+            }  // switch
+        }
+        delete rt;
+        break;
+    }
+    case kPersist: {
+        auto pd = GETPOINTER(pd_group, n.group);
+        delete pd;
+        break;
+    }
+    }  // switch
+}
+
+void
+token_database_impl::free_all_savepoints() {
+    while(!savepoints_.empty()) {
+        free_savepoint(savepoints_.front());
+        savepoints_.pop_front();
+    }
+}
+
+void
+token_database_impl::pop_savepoints(int64_t until) {
+    auto popped = false;
+    while(!savepoints_.empty() && savepoints_.front().seq < until) {
+        auto it = std::move(savepoints_.front());
+        savepoints_.pop_front();
+        free_savepoint(it);
+        popped = true;
+
+        // pop write cache and persist into underlying db
+        assert(assets_write_cache_.ops_.front().seq == it.seq);
+        if(config_.irreversible_reads) {
+            carry_irreversible_assets();
+        }
+        auto batch = rocksdb::WriteBatch();
+        assets_write_cache_.pop_front([&](auto& k, auto&& v) {
+            batch.Put(assets_handle_, rocksdb::Slice(k.data(), k.size()), v);
+        });
+        auto opts = write_opts_;
+        // in async mode, only write into memtable and WAL here, sync is done by worker
+        // in group commit mode, sync is done by the owner with `sync_wal`
+        opts.sync = !config_.async_persist && !config_.group_commit && !opts.disableWAL;
+
+        auto status = db_->Write(opts, &batch);
+        if(!status.ok()) {
+            FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
+        }
+        if(config_.async_persist && !config_.group_commit && !opts.disableWAL) {
+            request_sync();
+        }
+    }
+    if(popped) {
+        update_irreversible_view();
+    }
+}
+
+std::shared_ptr<const rocksdb::Snapshot>
+token_database_impl::new_snapshot() const {
+    auto db = db_;
+    snapshots_taken_++;
+    return std::shared_ptr<const rocksdb::Snapshot>(db_->GetSnapshot(), [db](auto s) { db->ReleaseSnapshot(s); });
+}
+
+// called right before the front layer of write cache is popped and persisted
+void
+token_database_impl::carry_irreversible_assets() {
+    using entry_t = write_cache_layer::data_map_t::value_type;
+
+    auto& cache = assets_write_cache_;
+    auto& front = cache.ops_.front();
+    if(front.vec.empty()) {
+        return;
+    }
+
+    auto overlay = irreversible_assets_ ? std::make_shared<internal::assets_overlay>(*irreversible_assets_)
+                                        : std::make_shared<internal::assets_overlay>();
+    auto to_key  = [](const entry_t* e) { return std::string(e->key()); };
+
+    auto counts = std::unordered_map<entry_t*, int>();
+    for(auto& op : front.vec) {
+        counts[op.it]++;
+    }
+
+    // values still used by later layers are not persisted by this pop,
+    // their irreversible values are the previous values kept by the first later writes
+    auto carried = std::unordered_set<entry_t*>();
+    for(auto& it : counts) {
+        if(it.first->second.used_count > it.second) {
+            carried.emplace(it.first);
+        }
+        else {
+            overlay->erase(to_key(it.first));
+        }
+    }
+    for(auto i = 1u; i < cache.ops_.size() && !carried.empty(); i++) {
+        for(auto& op : cache.ops_[i].vec) {
+            if(carried.erase(op.it)) {
+                assert(op.pv != nullptr);
+                (*overlay)[to_key(op.it)] = std::string(op.pv, op.pvsz);
+            }
+        }
+    }
+    irreversible_assets_ = std::move(overlay);
+}
+
+void
+token_database_impl::update_irreversible_view() {
+    using namespace internal;
+
+    if(!config_.irreversible_reads) {
+        return;
+    }
+
+    auto view = std::make_unique<token_database_view_impl>();
+    view->db              = db_;
+    view->assets_handle   = assets_handle_;
+    view->assets_snapshot = new_snapshot();
+    view->assets_overlay  = irreversible_assets_ ? irreversible_assets_ : std::make_shared<assets_overlay>();
+
+    // tokens are written into db directly, the snapshot of the oldest group
+    // which wrote any tokens still reflects the state before all the savepoints
+    for(auto i = 0u; i < savepoints_.size(); i++) {
+        auto n = savepoints_[i].node;
+        if(n.f.type != kRuntime) {
+            // previous values of persisted savepoints are not kept in snapshots
+            auto lock = std::lock_guard(irreversible_mtx_);
+            irreversible_view_.reset();
+            return;
+        }
+        auto rt = GETPOINTER(rt_group, n.group);
+        if(rt->rb_snapshot != nullptr) {
+            view->tokens_snapshot = rt->rb_snapshot;
+            break;
+        }
+        if(rt->nested && !rt->prev_values->empty()) {
+            // nested group is left without the group it's based on, its values are not in any snapshot
+            auto lock = std::lock_guard(irreversible_mtx_);
+            irreversible_view_.reset();
+            return;
+        }
+    }
+    if(view->tokens_snapshot == nullptr) {
+        view->tokens_snapshot = view->assets_snapshot;
+    }
+
+    auto ptr  = std::make_shared<const token_database_view>(std::move(view));
+    auto lock = std::lock_guard(irreversible_mtx_);
+    irreversible_view_ = std::move(ptr);
+}
+
+void
+token_database_impl::begin_bulk_load() {
+    using namespace internal;
+
+    check_writable();
+    EVT_ASSERT(!bulk_mode_, token_database_bulk_load_exception, "Bulk loading is already started");
+    EVT_ASSERT(savepoints_.empty(), token_database_bulk_load_exception, "Bulk loading is not allowed when there're savepoints");
+    if(config_.profile != storage_profile::disk) {
+        // only block based tables are built offline, simply put values for other profiles
+        return;
+    }
+
+    auto dir = config_.db_path / config::token_database_bulk_load_dir;
+    if(fc::exists(dir)) {
+        fc::remove_all(dir);
+    }
+    fc::create_directories(dir);
+
+    bulk_tokens_ = bulk_writer();
+    bulk_assets_ = bulk_writer();
+
+    bulk_tokens_.name   = "tokens";
+    bulk_tokens_.handle = tokens_handle_;
+    bulk_assets_.name   = "assets";
+    bulk_assets_.handle = assets_handle_;
+
+    bulk_mode_ = true;
+}
+
+void
+token_database_impl::bulk_put(internal::bulk_writer& bw, const rocksdb::Slice& key, const rocksdb::Slice& value) {
+    using namespace internal;
+
+    auto check = [](auto& status) {
+        if(!status.ok()) {
+            EVT_THROW(token_database_bulk_load_exception, "Rocksdb internal error: ${err}", ("err", status.ToString()));
+        }
+    };
+
+    if(bw.writer && key.compare(rocksdb::Slice(bw.last_key)) <= 0) {
+        // current run is ended, finish this file
+        auto status = bw.writer->Finish();
+        check(status);
+        bw.writer.reset();
+    }
+    if(!bw.writer) {
+        auto file = config_.db_path / config::token_database_bulk_load_dir / fmt::format("{}-{}.sst", bw.name, bw.files.size());
+
+        bw.writer = std::make_unique<rocksdb::SstFileWriter>(rocksdb::EnvOptions(), db_->GetOptions(bw.handle), bw.handle);
+        bw.files.emplace_back(file.to_native_ansi_path());
+
+        auto status = bw.writer->Open(bw.files.back());
+        check(status);
+    }
+
+    auto status = bw.writer->Put(key, value);
+    check(status);
+    bw.last_key.assign(key.data(), key.size());
+}
+
+void
+token_database_impl::end_bulk_load() {
+    using namespace internal;
+
+    if(config_.profile != storage_profile::disk) {
+        return;
+    }
+    EVT_ASSERT(bulk_mode_, token_database_bulk_load_exception, "Bulk loading is not started");
+    bulk_mode_ = false;
+
+    auto ingest = [this](auto& bw) {
+        if(bw.writer) {
+            auto status = bw.writer->Finish();
+            if(!status.ok()) {
+                EVT_THROW(token_database_bulk_load_exception, "Rocksdb internal error: ${err}", ("err", status.ToString()));
+            }
+            bw.writer.reset();
+        }
+
+        auto opts = rocksdb::IngestExternalFileOptions();
+        opts.move_files = true;
+        // runs may overlap with each other, ingest them one by one
+        for(auto& file : bw.files) {
+            auto status = db_->IngestExternalFile(bw.handle, { file }, opts);
+            if(!status.ok()) {
+                EVT_THROW(token_database_bulk_load_exception, "Rocksdb internal error: ${err}", ("err", status.ToString()));
+            }
+        }
+        bw.files.clear();
+    };
+
+    ingest(bulk_tokens_);
+    ingest(bulk_assets_);
+    reset_integrity_roots();
+    build_key_filters();
+
+    if(config_.owner_index) {
+        rebuild_owner_index();
+    }
+    if(config_.holding_index) {
+        rebuild_holding_index();
+    }
+
+    fc::remove_all(config_.db_path / config::token_database_bulk_load_dir);
+}
+
+void
+token_database_impl::start_persist_worker() {
+    if(!config_.async_persist || config_.group_commit || config_.profile == storage_profile::ram) {
+        return;
+    }
+    assert(!persist_thread_.joinable());
+
+    persist_pending_ = 0;
+    persist_stop_    = false;
+    persist_error_.clear();
+
+    persist_thread_ = std::thread([this] {
+        auto lock = std::unique_lock<std::mutex>(persist_mutex_);
+        while(true) {
+            persist_cv_.wait(lock, [this] { return persist_stop_ || persist_pending_ > 0; });
+            if(persist_pending_ == 0) {
+                // stopped and all the requests are synced
+                break;
+            }
+
+            // all the pending requests are merged into one sync
+            auto n = persist_pending_;
+            lock.unlock();
+            auto status = db_->SyncWAL();
+            lock.lock();
+
+            if(!status.ok() && persist_error_.empty()) {
+                persist_error_ = status.ToString();
+                elog("Sync token database failed: ${err}", ("err", persist_error_));
+            }
+            persist_pending_ -= n;
+            persist_done_cv_.notify_all();
+        }
+    });
+}
+
+void
+token_database_impl::start_tiering_worker() {
+    // manual compaction of a range only picks the files of that range with level style
+    if(config_.cold_domain_secs == 0 || config_.hot_keys_sample == 0 || config_.profile != storage_profile::disk
+            || config_.tokens_cf.compaction != compaction_style::level) {
+        return;
+    }
+    assert(!tiering_thread_.joinable());
+
+    tiering_stop_   = false;
+    tiering_thread_ = std::thread([this] {
+        auto period = std::chrono::seconds(std::clamp(config_.cold_domain_secs / 4, 1u, 60u));
+        auto lock   = std::unique_lock<std::mutex>(tiering_mutex_);
+        while(!tiering_cv_.wait_for(lock, period, [this] { return tiering_stop_.load(); })) {
+            lock.unlock();
+            demote_cold_domains();
+            lock.lock();
+        }
+    });
+}
+
+void
+token_database_impl::stop_tiering_worker() {
+    if(!tiering_thread_.joinable()) {
+        return;
+    }
+    {
+        auto lock = std::lock_guard<std::mutex>(tiering_mutex_);
+        tiering_stop_ = true;
+    }
+    tiering_cv_.notify_all();
+    tiering_thread_.join();
+    domains_seen_.clear();
+}
+
+/**
+ * Tokens of the domains not sampled for `cold_domain_secs` are compacted into the bottom level,
+ * where they're compressed harder and stored in `cold_path` when it's set. Their blocks then
+ * stop sharing files with the hot ones. A demoted domain is tracked again once it's sampled,
+ * its new writes stay in the upper levels and its reads are served by block cache.
+ */
+void
+token_database_impl::demote_cold_domains() {
+    using namespace internal;
+
+    auto cold = std::vector<name128>();
+    {
+        auto now  = fc::time_point::now();
+        auto lock = std::lock_guard(hot_keys_mtx_);
+        for(auto it = domains_seen_.begin(); it != domains_seen_.end();) {
+            if(now - it->second >= fc::seconds(config_.cold_domain_secs)) {
+                cold.emplace_back(it->first);
+                it = domains_seen_.erase(it);
+                continue;
+            }
+            it++;
+        }
+    }
+
+    auto opts = rocksdb::CompactRangeOptions();
+    opts.exclusive_manual_compaction = false;  // automatic compactions go on meanwhile
+    opts.bottommost_level_compaction = rocksdb::BottommostLevelCompaction::kForce;
+    for(auto& d : cold) {
+        if(tiering_stop_) {
+            return;
+        }
+        auto begin  = db_token_key(d, name128());
+        auto end    = db_token_key(d, name128(std::numeric_limits<uint128_t>::max()));
+        auto status = db_->CompactRange(opts, tokens_handle_, &begin.as_slice(), &end.as_slice());
+        if(!status.ok()) {
+            wlog("Cannot demote cold domain ${d}: ${err}", ("d", d)("err", status.ToString()));
+            continue;
+        }
+        domains_demoted_++;
+    }
+}
+
+void
+token_database_impl::start_tuning_worker() {
+    if(!config_.auto_tune || config_.profile != storage_profile::disk || !config_.enable_stats) {
+        return;
+    }
+    assert(!tuning_thread_.joinable());
+
+    tuning_stop_   = false;
+    bytes_written_ = db_->GetDBOptions().statistics->getTickerCount(rocksdb::BYTES_WRITTEN);
+    tuning_thread_ = std::thread([this] {
+        auto lock = std::unique_lock<std::mutex>(tuning_mutex_);
+        while(!tuning_cv_.wait_for(lock, std::chrono::seconds(internal::kWriteBufferSecs), [this] { return tuning_stop_; })) {
+            lock.unlock();
+            tune_write_buffers();
+            lock.lock();
+        }
+    });
+}
 
-    return count;
+void
+token_database_impl::stop_tuning_worker() {
+    if(!tuning_thread_.joinable()) {
+        return;
+    }
+    {
+        auto lock = std::lock_guard<std::mutex>(tuning_mutex_);
+        tuning_stop_ = true;
+    }
+    tuning_cv_.notify_all();
+    tuning_thread_.join();
 }
 
+/**
+ * Write buffers are sized to hold the writes of the last period, within the bounds. Fewer and larger
+ * flushes under heavy writes keep level 0 small, and small buffers of quiet periods leave memory
+ * to the caches. Only changes of more than a quarter are applied, each one makes new memtables.
+ */
 void
-token_database_impl::add_savepoint(int64_t seq) {
+token_database_impl::tune_write_buffers() {
     using namespace internal;
 
-    if(!savepoints_.empty()) {
-        auto& b = savepoints_.back();
-        if(b.seq >= seq) {
-            EVT_THROW(token_database_seq_not_valid, "Seq is not valid, prev: ${prev}, curr: ${curr}",
-                      ("prev", b.seq)("curr", seq));
-        }
-    }
+    auto written   = db_->GetDBOptions().statistics->getTickerCount(rocksdb::BYTES_WRITTEN);
+    auto rate      = (written - bytes_written_) / kWriteBufferSecs;
+    bytes_written_ = written;
 
-    savepoints_.push_back(savepoint(seq, kRuntime));
-    auto rt = new rt_group { .rb_snapshot = (const void*)db_->GetSnapshot(), .actions = {} }; 
-    SETPOINTER(void, savepoints_.back().node.group, rt);
+    auto size = std::clamp(rate * kWriteBufferSecs, kMinWriteBufferSize, kMaxWriteBufferSize);
+    if(size * 4 > write_buffer_size_ * 3 && size * 4 < write_buffer_size_ * 5) {
+        return;
+    }
 
-    assets_write_cache_.add_savepoint(seq);
+    auto opts = std::unordered_map<std::string, std::string> {{ "write_buffer_size", std::to_string(size) }};
+    for(auto h : { tokens_handle_, assets_handle_ }) {
+        auto status = db_->SetOptions(h, opts);
+        if(!status.ok()) {
+            wlog("Cannot tune write buffers: ${err}", ("err", status.ToString()));
+            return;
+        }
+    }
+    write_buffer_size_ = size;
+    write_buffers_tuned_++;
 }
 
 void
-token_database_impl::free_savepoint(internal::savepoint& sp) {
+token_database_impl::apply_io_rate() {
     using namespace internal;
 
-    auto n = sp.node;
-
-    switch(n.f.type) {
-    case kRuntime: {
-        auto rt = GETPOINTER(rt_group, n.group);
-        for(auto& act : rt->actions) {
-            switch(act.get_data_type()) {
-            case kTokenKey:
-            case kTokenFullKey:
-            case kAssetKey: {
-                free(GETPOINTER(void, act.data));
-                break;
-            }
-            case kTokenKeys: {
-                auto p = GETPOINTER(rt_token_keys, act.data);
-                //need to call dtor of keys manually
-                p->keys.~token_keys_t();
-                free(p);
-                break;
-            }
-            }  // switch
-        }
-        db_->ReleaseSnapshot((const rocksdb::Snapshot*)rt->rb_snapshot);
-        delete rt;
-        break;
-    }
-    case kPersist: {
-        auto pd = GETPOINTER(pd_group, n.group);
-        delete pd;
-        break;
-    }
-    }  // switch
+    auto rate = background_busy_ ? config_.io_rate : config_.idle_io_rate;
+    rate_limiter_->SetBytesPerSecond((int64_t)(rate > 0 ? std::min(rate, kUnlimitedIORate) : kUnlimitedIORate));
 }
 
 void
-token_database_impl::free_all_savepoints() {
-    while(!savepoints_.empty()) {
-        free_savepoint(savepoints_.front());
-        savepoints_.pop_front();
+token_database_impl::stop_persist_worker() {
+    if(!persist_thread_.joinable()) {
+        return;
     }
+    {
+        auto lock = std::lock_guard<std::mutex>(persist_mutex_);
+        persist_stop_ = true;
+    }
+    persist_cv_.notify_one();
+    persist_thread_.join();
 }
 
 void
-token_database_impl::pop_savepoints(int64_t until) {
-    while(!savepoints_.empty() && savepoints_.front().seq < until) {
-        auto it = std::move(savepoints_.front());
-        savepoints_.pop_front();
-        free_savepoint(it);
-
-        // pop write cache and persist into underlying db
-        assert(assets_write_cache_.ops_.front().seq == it.seq);
-        auto batch = rocksdb::WriteBatch();
-        assets_write_cache_.pop_front([&](auto& k, auto&& v) {
-            batch.Put(assets_handle_, rocksdb::Slice(k.data(), k.size()), v);
-        });
-        auto sync_write_opts = write_opts_;
-        sync_write_opts.sync = true;
-        db_->Write(sync_write_opts, &batch);
+token_database_impl::request_sync() {
+    auto lock = std::unique_lock<std::mutex>(persist_mutex_);
+    if(!persist_error_.empty()) {
+        FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", persist_error_));
     }
+
+    // back-pressure: wait for the worker only when there're too many unsynced savepoints
+    persist_done_cv_.wait(lock, [this] { return persist_pending_ < std::max(config_.persist_queue_size, 1u); });
+    persist_pending_++;
+    persist_cv_.notify_one();
 }
 
 void
@@ -977,14 +2699,32 @@ token_database_impl::squash() {
     auto rt1 = GETPOINTER(rt_group, n.group);
     auto rt2 = GETPOINTER(rt_group, n2.group);
 
+    // deltas of transactions are emitted once they are squashed into their blocks
+    auto deltas = std::optional<token_database::token_deltas>();
+    if(rt1->nested && !self_.squashed_deltas.empty()) {
+        deltas = collect_deltas(rt1);
+    }
+
     // add all actions from rt1 into end of rt2
     rt2->actions.insert(rt2->actions.cend(), rt1->actions.cbegin(), rt1->actions.cend());
 
-    // just release rt1's snapshot
-    db_->ReleaseSnapshot((const rocksdb::Snapshot*)rt1->rb_snapshot);
+    EVT_ASSERT(rt1->nested || !rt2->nested, token_database_squash_exception, "Cannot squash a savepoint into a nested one.");
+
+    // values kept by rt2 are earlier ones, merge only adds the keys rt2 hasn't written
+    rt2->prev_values->merge(*rt1->prev_values);
+
+    // keep the earlier snapshot, if rt2 has never written any tokens
+    // rt1's snapshot still reflects the state at the beginning of rt2
+    if(!rt1->nested && rt2->rb_snapshot == nullptr) {
+        rt2->rb_snapshot = std::move(rt1->rb_snapshot);
+    }
     delete rt1;
 
     assets_write_cache_.squash();
+
+    if(deltas.has_value() && !deltas->empty()) {
+        self_.squashed_deltas(savepoints_.back().seq, *deltas);
+    }
 }
 
 int64_t
@@ -1015,6 +2755,90 @@ token_database_impl::record(uint8_t action_type, uint8_t op, uint8_t data_type,
     GETPOINTER(rt_group, n.group)->actions.emplace_back(rt_action(action_type, op, data_type, data));
 }
 
+void
+token_database_impl::prepare_record() {
+    using namespace internal;
+
+    auto n = savepoints_.back().node;
+    assert(n.f.type == kRuntime);
+
+    // journals are enough to roll back, snapshots only serve the irreversible view
+    if(!config_.irreversible_reads) {
+        return;
+    }
+
+    auto rt = GETPOINTER(rt_group, n.group);
+    if(rt->nested) {
+        // the group nested one is based on still needs a snapshot of the state before any
+        // tokens are written above it
+        for(auto i = savepoints_.size() - 1; i-- > 0;) {
+            auto base = GETPOINTER(rt_group, savepoints_[i].node.group);
+            if(!base->nested) {
+                if(base->rb_snapshot == nullptr) {
+                    base->rb_snapshot = new_snapshot();
+                }
+                break;
+            }
+        }
+        return;
+    }
+    if(rt->rb_snapshot == nullptr) {
+        rt->rb_snapshot = new_snapshot();
+    }
+}
+
+void
+token_database_impl::keep_prev_value(const rocksdb::Slice& key, action_op op) {
+    using namespace internal;
+
+    auto rt = GETPOINTER(rt_group, savepoints_.back().node.group);
+    if(rt->prev_values == nullptr) {
+        return;
+    }
+
+    auto r = rt->prev_values->try_emplace(key.ToString());
+    if(!r.second || op == action_op::add) {
+        // only the first value is kept, added token didn't exist
+        return;
+    }
+
+    auto value  = std::string();
+    auto status = db_->Get(read_opts_, tokens_handle_, key, &value);
+    if(status.ok()) {
+        r.first->second = std::move(value);
+    }
+    else if(status.code() != rocksdb::Status::kNotFound) {
+        FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
+    }
+}
+
+// reads the value of `key` before the group `rt`, returns if it existed
+int
+token_database_impl::read_prev_value(const internal::rt_group* rt, rocksdb::ColumnFamilyHandle* handle, const std::string& key, std::string& value) const {
+    if(rt->prev_values != nullptr) {
+        auto it = rt->prev_values->find(key);
+        assert(it != rt->prev_values->end());
+        if(it == rt->prev_values->end() || !it->second.has_value()) {
+            return false;
+        }
+        value = *it->second;
+        return true;
+    }
+
+    assert(rt->rb_snapshot != nullptr);
+    auto snapshot_read_opts     = read_opts_;
+    snapshot_read_opts.snapshot = rt->rb_snapshot.get();
+
+    auto status = db_->Get(snapshot_read_opts, handle, key, &value);
+    if(!status.ok()) {
+        if(status.code() != rocksdb::Status::kNotFound) {
+            FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
+        }
+        return false;
+    }
+    return true;
+}
+
 namespace internal {
 
 std::string
@@ -1046,26 +2870,37 @@ token_database_impl::rollback_rt_group(internal::rt_group* rt) {
     using namespace internal;
 
     if(rt->actions.empty()) {
-        db_->ReleaseSnapshot((const rocksdb::Snapshot*)rt->rb_snapshot);
+        rt->rb_snapshot.reset();
         return;
     }
 
-    auto snapshot_read_opts_     = read_opts_;
-    snapshot_read_opts_.snapshot = (const rocksdb::Snapshot*)rt->rb_snapshot;
-
     auto key_set = keys_hash_set();
     auto batch   = rocksdb::WriteBatch();
+
+    // a filter rebuilt since this group was added has the fingerprints of the keys in db then,
+    // not the ones added by this group, removing its keys may take out the fingerprints shared
+    // with other keys and answer them absent. Filters are rebuilt after the rollback instead.
+    auto rebuilt = (rt->filter_generation != filter_generation_);
+    auto remove_from_filter = [&](auto type, auto& key) {
+        if(!rebuilt) {
+            remove_from_key_filter(type, key);
+        }
+    };
     
     for(auto it = rt->actions.begin(); it < rt->actions.end(); it++) {
         auto data = GETPOINTER(void, it->data);
 
         auto fn = [&](auto& key, auto type, auto op) {
+            if(!is_index_type((int)type)) {
+                mark_key_dirty(type == token_type::asset, key);
+            }
             switch(op) {
             case action_op::add: {
                 assert(key_set.find(key) == key_set.end());
 
                 batch.Delete(key);
                 self_.remove_token_value(key);
+                remove_from_filter(type, key);
             
                 // insert key into key set
                 key_set.insert(key);
@@ -1077,9 +2912,8 @@ token_database_impl::rollback_rt_group(internal::rt_group* rt) {
                     break;
                 }
                 auto old_value = std::string();
-                auto status    = db_->Get(snapshot_read_opts_, key, &old_value);
-                if(!status.ok()) {
-                    FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
+                if(!read_prev_value(rt, tokens_handle_, key, old_value)) {
+                    FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Previous value of updated token is not found");
                 }
                 batch.Put(key, old_value);
                 self_.rollback_token_value(key);
@@ -1097,16 +2931,13 @@ token_database_impl::rollback_rt_group(internal::rt_group* rt) {
                 // Asset type only has put op
                 auto handle    = (type == token_type::asset) ? assets_handle_ : tokens_handle_;
                 auto old_value = std::string();
-                auto status    = db_->Get(snapshot_read_opts_, handle, key, &old_value);
 
-                // key may not existed in latest snapshot, remove it
-                if(!status.ok()) {
-                    if(status.code() != rocksdb::Status::kNotFound) {
-                        FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
-                    }
+                // key may not existed before this group, remove it
+                if(!read_prev_value(rt, handle, key, old_value)) {
                     batch.Delete(handle, key);
                     if(handle == tokens_handle_) {
                         self_.remove_token_value(key);
+                        remove_from_filter(type, key);
                     }
                 }
                 else {
@@ -1156,7 +2987,71 @@ token_database_impl::rollback_rt_group(internal::rt_group* rt) {
     sync_write_opts.sync = true;
     db_->Write(sync_write_opts, &batch);
 
-    db_->ReleaseSnapshot((const rocksdb::Snapshot*)rt->rb_snapshot);
+    if(rebuilt && key_filtered_) {
+        build_key_filters();
+    }
+
+    rt->rb_snapshot.reset();
+}
+
+// deltas made by the group on top, tokens are read from db and assets from the top layer of
+// write cache, so they're the latest values, index tokens are derived ones and left out
+token_database::token_deltas
+token_database_impl::collect_deltas(const internal::rt_group* rt) const {
+    using namespace internal;
+
+    auto deltas  = token_database::token_deltas();
+    auto key_set = keys_hash_set();
+
+    auto add_token = [&](auto type, auto&& key) {
+        if(is_index_type((int)type) || !key_set.insert(key).second) {
+            return;
+        }
+        auto value  = std::string();
+        auto status = db_->Get(read_opts_, tokens_handle_, key, &value);
+        if(!status.ok() && status.code() != rocksdb::Status::kNotFound) {
+            FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
+        }
+        deltas.emplace_back(token_database::token_delta {
+            .type  = type,
+            .key   = std::move(key),
+            .value = status.ok() ? std::make_optional(std::move(value)) : std::nullopt
+        });
+    };
+
+    for(auto& act : rt->actions) {
+        switch(act.get_data_type()) {
+        case kTokenKey:
+        case kTokenFullKey: {
+            add_token(act.get_token_type(), get_sp_key(act));
+            break;
+        }
+        case kAssetKey: {
+            // assets are written into write cache when there are savepoints
+            break;
+        }
+        case kTokenKeys: {
+            auto keys = GETPOINTER(rt_token_keys, act.data);
+            for(auto& k : keys->keys) {
+                add_token(act.get_token_type(), db_token_key(keys->prefix, k).as_string());
+            }
+            break;
+        }
+        }  // switch
+    }
+
+    for(auto& op : assets_write_cache_.ops_.back().vec) {
+        auto key = op.it->key();
+        if(!key_set.insert(llvm::StringRef(key.data(), key.size())).second) {
+            continue;
+        }
+        deltas.emplace_back(token_database::token_delta {
+            .type  = token_type::asset,
+            .key   = std::string(key),
+            .value = op.it->second.value
+        });
+    }
+    return deltas;
 }
 
 void
@@ -1173,6 +3068,9 @@ token_database_impl::rollback_pd_group(internal::pd_group* pd) {
     // because cache cannot have persist value objects
     auto batch = rocksdb::WriteBatch();
     for(auto it = pd->actions.begin(); it < pd->actions.end(); it++) {
+        if(!is_index_type(it->type)) {
+            mark_key_dirty(it->type == (int)token_type::asset, it->key);
+        }
         switch((action_op)it->op) {
         case action_op::add: {
             assert(it->value.empty());
@@ -1204,42 +3102,238 @@ token_database_impl::rollback_pd_group(internal::pd_group* pd) {
 }
 
 void
-token_database_impl::rollback_to_latest_savepoint() {
-    using namespace internal;
-    EVT_ASSERT(!savepoints_.empty(), token_database_no_savepoint, "There's no savepoints anymore");
-
-    auto  seq = savepoints_.back().seq;
-    auto& n   = savepoints_.back().node;
-
-    switch(n.f.type) {
-    case kRuntime: {
-        auto rt = GETPOINTER(rt_group, n.group);
-        rollback_rt_group(rt);
-        delete rt;
-
-        break;
+token_database_impl::rollback_to_latest_savepoint() {
+    using namespace internal;
+    EVT_ASSERT(!savepoints_.empty(), token_database_no_savepoint, "There's no savepoints anymore");
+
+    auto  seq    = savepoints_.back().seq;
+    auto& n      = savepoints_.back().node;
+    auto  nested = false;
+
+    switch(n.f.type) {
+    case kRuntime: {
+        auto rt = GETPOINTER(rt_group, n.group);
+        nested  = rt->nested;
+        rollback_rt_group(rt);
+        delete rt;
+
+        break;
+    }
+    case kPersist: {
+        auto pd = GETPOINTER(pd_group, n.group);
+        rollback_pd_group(pd);
+        delete pd;
+
+        break;
+    }
+    }  // switch
+
+    savepoints_.pop_back();
+
+    assert(seq == assets_write_cache_.ops_.back().seq);
+    for(auto& op : assets_write_cache_.ops_.back().vec) {
+        mark_key_dirty(true, op.it->key());
+    }
+    assets_write_cache_.rollback_to_latest_savepoint();
+
+    // nested ones never emitted their deltas
+    if(!nested) {
+        self_.rolled_back_savepoint(seq);
+    }
+}
+
+void
+token_database_impl::mark_token_dirty(const name128& prefix) {
+    if(roots_.valid) {
+        roots_.dirty_tokens.insert(prefix);
+    }
+}
+
+void
+token_database_impl::mark_asset_dirty(symbol_id_type sym_id) {
+    if(roots_.valid) {
+        roots_.dirty_assets.insert(sym_id);
+    }
+}
+
+void
+token_database_impl::mark_key_dirty(bool asset, const std::string_view& key) {
+    using namespace internal;
+
+    if(asset) {
+        assert(key.size() >= kSymbolIdSize);
+        auto sym_id = symbol_id_type();
+        memcpy(&sym_id, key.data(), kSymbolIdSize);
+        mark_asset_dirty(sym_id);
+    }
+    else {
+        assert(key.size() >= sizeof(name128));
+        auto prefix = name128();
+        memcpy(&prefix, key.data(), sizeof(name128));
+        mark_token_dirty(prefix);
+    }
+}
+
+void
+token_database_impl::reset_integrity_roots() {
+    roots_ = internal::integrity_roots();
+}
+
+namespace internal {
+
+void
+hash_db_value(fc::sha256::encoder& enc, const std::string_view& key, const std::string& value) {
+    fc::raw::pack(enc, (uint32_t)key.size());
+    enc.write(key.data(), key.size());
+    fc::raw::pack(enc, (uint32_t)value.size());
+    enc.write(value.data(), value.size());
+}
+
+}  // namespace internal
+
+std::optional<fc::sha256>
+token_database_impl::hash_tokens_partition(const name128& prefix) const {
+    auto enc    = fc::sha256::encoder();
+    auto cursor = std::string();
+    auto count  = read_tokens_range(prefix, 0, cursor, [&enc](auto& key, auto&& value) {
+        internal::hash_db_value(enc, key, value);
+        return true;
+    });
+    if(count == 0) {
+        return std::nullopt;
+    }
+    return enc.result();
+}
+
+std::optional<fc::sha256>
+token_database_impl::hash_assets_partition(symbol_id_type sym_id) const {
+    auto enc    = fc::sha256::encoder();
+    auto cursor = std::string();
+    auto count  = read_assets_range(sym_id, 0, cursor, [&enc](auto& key, auto&& value) {
+        internal::hash_db_value(enc, key, value);
+        return true;
+    });
+    if(count == 0) {
+        return std::nullopt;
+    }
+    return enc.result();
+}
+
+fc::sha256
+token_database_impl::calculate_integrity_hash() {
+    using namespace internal;
+
+    EVT_ASSERT(db_ != nullptr, token_database_exception, "Token database is not opened");
+    EVT_ASSERT(!bulk_mode_, token_database_bulk_load_exception, "Integrity hash is not available in bulk loading mode");
+
+    if(!roots_.valid) {
+        // partitions are found from the reserved types, domains and fungibles
+        roots_ = integrity_roots();
+        for(auto i = (int)token_type::domain; i <= (int)token_type::max_value; i++) {
+            if(i != (int)token_type::token && !is_index_type(i)) {
+                roots_.dirty_tokens.insert(action_key_prefixes[i]);
+            }
+        }
+
+        auto cursor = std::string();
+        read_tokens_range(action_key_prefixes[(int)token_type::domain], 0, cursor, [this](auto& key, auto&&) {
+            auto n = name128();
+            memcpy(&n, key.data(), sizeof(n));
+            roots_.dirty_tokens.insert(n);
+            return true;
+        });
+        cursor.clear();
+        read_tokens_range(action_key_prefixes[(int)token_type::fungible], 0, cursor, [this](auto& key, auto&&) {
+            auto n = name128();
+            memcpy(&n, key.data(), sizeof(n));
+            roots_.dirty_assets.insert((symbol_id_type)n.value);
+            return true;
+        });
+        roots_.valid = true;
+    }
+
+    // rehash dirty partitions concurrently, there're no writes in the meantime
+    auto tokens = std::vector<name128>(roots_.dirty_tokens.begin(), roots_.dirty_tokens.end());
+    auto assets = std::vector<symbol_id_type>(roots_.dirty_assets.begin(), roots_.dirty_assets.end());
+    auto total  = tokens.size() + assets.size();
+    auto hashes = std::vector<std::optional<fc::sha256>>(total);
+
+    auto threads = std::min<size_t>(std::clamp<size_t>(std::thread::hardware_concurrency(), 1, 16), total);
+    auto tasks   = std::vector<std::future<void>>();
+    for(auto t = 0u; t < threads; t++) {
+        tasks.emplace_back(std::async(std::launch::async, [&, t] {
+            for(auto i = t; i < total; i += threads) {
+                hashes[i] = (i < tokens.size()) ? hash_tokens_partition(tokens[i]) : hash_assets_partition(assets[i - tokens.size()]);
+            }
+        }));
+    }
+    for(auto& task : tasks) {
+        task.get();
+    }
+
+    auto update = [](auto& roots, auto& id, auto& hash) {
+        if(hash.has_value()) {
+            roots[id] = *hash;
+        }
+        else {
+            roots.erase(id);
+        }
+    };
+    for(auto i = 0u; i < tokens.size(); i++) {
+        update(roots_.tokens, tokens[i], hashes[i]);
+    }
+    for(auto i = 0u; i < assets.size(); i++) {
+        update(roots_.assets, assets[i], hashes[tokens.size() + i]);
+    }
+    roots_.dirty_tokens.clear();
+    roots_.dirty_assets.clear();
+
+    // leaves are ordered by partition, tokens go first
+    auto leaves = std::vector<digest_type>();
+    leaves.reserve(roots_.tokens.size() + roots_.assets.size());
+    for(auto& it : roots_.tokens) {
+        leaves.emplace_back(digest_type::hash(std::make_pair(it.first, it.second)));
+    }
+    for(auto& it : roots_.assets) {
+        leaves.emplace_back(digest_type::hash(std::make_pair(it.first, it.second)));
+    }
+    return merkle(std::move(leaves));
+}
+
+void
+token_database_impl::create_checkpoint(const fc::path& dir) const {
+    EVT_ASSERT(db_ != nullptr, token_database_exception, "Token database is not opened");
+    EVT_ASSERT(config_.profile != storage_profile::ram, token_database_exception, "Checkpoint is not supported in ram profile");
+    EVT_ASSERT(!bulk_mode_, token_database_exception, "Checkpoint is not allowed in bulk loading mode");
+    EVT_ASSERT(!fc::exists(dir), token_database_exception, "Checkpoint directory: ${d} already exists", ("d", dir.generic_string()));
+
+    auto cp     = (rocksdb::Checkpoint*)nullptr;
+    auto status = rocksdb::Checkpoint::Create(db_, &cp);
+    if(!status.ok()) {
+        EVT_THROW(token_database_rocksdb_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
     }
-    case kPersist: {
-        auto pd = GETPOINTER(pd_group, n.group);
-        rollback_pd_group(pd);
-        delete pd;
+    auto checkpoint = std::unique_ptr<rocksdb::Checkpoint>(cp);
 
-        break;
+    // memtables are flushed before linking the table files
+    status = checkpoint->CreateCheckpoint(dir.to_native_ansi_path());
+    if(!status.ok()) {
+        EVT_THROW(token_database_rocksdb_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
     }
-    }  // switch
-
-    savepoints_.pop_back();
 
-    assert(seq == assets_write_cache_.ops_.back().seq);
-    assets_write_cache_.rollback_to_latest_savepoint();
+    // savepoints and assets write cache are only kept in memory, write them like closing
+    persist_savepoints(dir / config::token_database_persisit_filename);
 }
 
 void
 token_database_impl::persist_savepoints() const {
+    persist_savepoints(config_.db_path / config::token_database_persisit_filename);
+}
+
+void
+token_database_impl::persist_savepoints(const fc::path& filename) const {
     using namespace internal;
 
     try {
-        auto filename = config_.db_path / config::token_database_persisit_filename;
         if(fc::exists(filename)) {
             fc::remove(filename);
         }
@@ -1318,9 +3412,6 @@ token_database_impl::persist_savepoints(std::ostream& os) const {
 
             auto key_set = keys_hash_set();
 
-            auto snapshot_read_opts_     = read_opts_;
-            snapshot_read_opts_.snapshot = (const rocksdb::Snapshot*)rt->rb_snapshot;
-
             for(auto& act : rt->actions) {
                 auto data = GETPOINTER(void, act.data);
 
@@ -1340,9 +3431,8 @@ token_database_impl::persist_savepoints(std::ostream& os) const {
                             break;
                         }
 
-                        auto status = db_->Get(snapshot_read_opts_, key, &value);
-                        if(!status.ok()) {
-                            FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
+                        if(!read_prev_value(rt, tokens_handle_, key, value)) {
+                            FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Previous value of updated token is not found");
                         }
 
                         key_set.insert(key);
@@ -1353,13 +3443,9 @@ token_database_impl::persist_savepoints(std::ostream& os) const {
                             break;
                         }
 
+                        // key may not existed before this group
                         auto handle = (type == token_type::asset) ? assets_handle_ : tokens_handle_;
-                        auto status = db_->Get(snapshot_read_opts_, handle, key, &value);
-                        
-                        // key may not existed in latest snapshot
-                        if(!status.ok() && status.code() != rocksdb::Status::kNotFound) {
-                            FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
-                        }
+                        read_prev_value(rt, handle, key, value);
 
                         key_set.insert(key);
                         break;
@@ -1442,6 +3528,64 @@ token_database::~token_database() {
     my_->close();
 }
 
+token_database::io_counters&
+token_database::thread_io_counters() {
+    static thread_local auto counters = io_counters();
+    return counters;
+}
+
+int
+token_database::count_read(int found) {
+    auto& counters = thread_io_counters();
+    counters.reads++;
+    if(!found) {
+        counters.misses++;
+    }
+    return found;
+}
+
+namespace internal {
+
+// cheap per-thread random sampling, counting every N-th operation would alias with
+// the regular access patterns of block application
+bool
+sampled(uint32_t rate) {
+    static thread_local auto x = (uint32_t)std::hash<std::thread::id>()(std::this_thread::get_id()) | 1;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return x % rate == 0;
+}
+
+}  // namespace internal
+
+void
+token_database::sample_key(int write, token_type type, const name128& prefix, const name128& key) const {
+    auto rate = my_->config_.hot_keys_sample;
+    if(rate == 0 || !internal::sampled(rate)) {
+        return;
+    }
+
+    auto id   = std::make_tuple(type, prefix.to_string(), key.to_string());
+    auto lock = std::lock_guard(my_->hot_keys_mtx_);
+    (write ? my_->hot_writes_ : my_->hot_reads_).add(id, rate);
+    if(type == token_type::token && my_->tiering_thread_.joinable()) {
+        my_->domains_seen_[prefix] = deadline_timer::coarse_now();
+    }
+}
+
+void
+token_database::sample_asset(int write, const address& addr, const symbol_id_type sym_id) const {
+    auto rate = my_->config_.hot_keys_sample;
+    if(rate == 0 || !internal::sampled(rate)) {
+        return;
+    }
+
+    auto id   = std::make_tuple(token_type::asset, fmt::format("S#{}", sym_id), addr.to_string());
+    auto lock = std::lock_guard(my_->hot_keys_mtx_);
+    (write ? my_->hot_writes_ : my_->hot_reads_).add(id, rate);
+}
+
 void
 token_database::open(int load_persistence) {
     my_->open(load_persistence);
@@ -1452,6 +3596,16 @@ token_database::close(int persist) {
     my_->close(persist);
 }
 
+bool
+token_database::is_secondary() const {
+    return my_->is_secondary();
+}
+
+void
+token_database::catch_up_with_primary() {
+    my_->catch_up_with_primary();
+}
+
 void
 token_database::put_token(token_type type, action_op op, const std::optional<name128>& domain, const name128& key, const std::string_view& data) {
     using namespace internal;
@@ -1459,6 +3613,8 @@ token_database::put_token(token_type type, action_op op, const std::optional<nam
     assert(type != token_type::asset);
     assert((type == token_type::token) != (!domain.has_value()));
     auto& prefix = domain.has_value() ? *domain : action_key_prefixes[(int)type];
+    thread_io_counters().writes++;
+    sample_key(true, type, prefix, key);
     my_->put_token(type, op, prefix, key, data);
 }
 
@@ -1473,14 +3629,39 @@ token_database::put_tokens(token_type type,
     assert(type != token_type::asset);
     assert((type == token_type::token) != (!domain.has_value()));
     auto& prefix = domain.has_value() ? *domain : action_key_prefixes[(int)type];
+    thread_io_counters().writes += keys.size();
+    for(auto& key : keys) {
+        sample_key(true, type, prefix, key);
+    }
     my_->put_tokens(type, op, prefix, std::move(keys), data);
 }
 
 void
 token_database::put_asset(const address& addr, const symbol_id_type sym_id, const std::string_view& data) {
+    thread_io_counters().writes++;
+    sample_asset(true, addr, sym_id);
     my_->put_asset(addr, sym_id, data);
 }
 
+void
+token_database::put_assets(const small_vector_base<asset_key_t>& keys, const small_vector_base<std::string_view>& data) {
+    thread_io_counters().writes += keys.size();
+    for(auto& key : keys) {
+        sample_asset(true, key.first, key.second);
+    }
+    my_->put_assets(keys, data);
+}
+
+void
+token_database::update_asset(const address& addr, const symbol_id_type sym_id, const update_value_func& func) {
+    auto& counters = thread_io_counters();
+    counters.reads++;
+    counters.writes++;
+    sample_asset(false, addr, sym_id);
+    sample_asset(true, addr, sym_id);
+    my_->update_asset(addr, sym_id, func);
+}
+
 int
 token_database::exists_token(token_type type, const std::optional<name128>& domain, const name128& key) const {
     using namespace internal;
@@ -1488,12 +3669,14 @@ token_database::exists_token(token_type type, const std::optional<name128>& doma
     assert(type != token_type::asset);
     assert((type == token_type::token) != (!domain.has_value()));
     auto& prefix = domain.has_value() ? *domain : action_key_prefixes[(int)type];
-    return my_->exists_token(prefix, key);
+    sample_key(false, type, prefix, key);
+    return count_read(my_->exists_token(type, prefix, key));
 }
 
 int
 token_database::exists_asset(const address& addr, const symbol_id_type sym_id) const {
-    return my_->exists_asset(addr, sym_id);
+    sample_asset(false, addr, sym_id);
+    return count_read(my_->exists_asset(addr, sym_id));
 }
 
 int
@@ -1503,12 +3686,77 @@ token_database::read_token(token_type type, const std::optional<name128>& domain
     assert(type != token_type::asset);
     assert((type == token_type::token) != (!domain.has_value()));
     auto& prefix = domain.has_value() ? *domain : action_key_prefixes[(int)type];
-    return my_->read_token(prefix, key, out, no_throw);
+    sample_key(false, type, prefix, key);
+    try {
+        return count_read(my_->read_token(prefix, key, out, no_throw));
+    }
+    catch(const unknown_token_database_key&) {
+        count_read(false);
+        throw;
+    }
 }
 
 int
 token_database::read_asset(const address& addr, const symbol_id_type sym_id, std::string& out, bool no_throw) const {
-    return my_->read_asset(addr, sym_id, out, no_throw);
+    sample_asset(false, addr, sym_id);
+    try {
+        return count_read(my_->read_asset(addr, sym_id, out, no_throw));
+    }
+    catch(const unknown_token_database_key&) {
+        count_read(false);
+        throw;
+    }
+}
+
+int
+token_database::read_tokens(token_type type, const std::optional<name128>& domain, const small_vector_base<name128>& keys, read_values_t& outs, bool no_throw) const {
+    using namespace internal;
+
+    assert(type != token_type::asset);
+    assert((type == token_type::token) != (!domain.has_value()));
+    auto& prefix = domain.has_value() ? *domain : action_key_prefixes[(int)type];
+    for(auto& key : keys) {
+        sample_key(false, type, prefix, key);
+    }
+    auto found = my_->read_tokens(type, prefix, keys, outs, no_throw);
+
+    auto& counters = thread_io_counters();
+    counters.reads += keys.size();
+    counters.misses += keys.size() - found;
+    return found;
+}
+
+int
+token_database::read_assets(const small_vector_base<asset_key_t>& keys, read_values_t& outs, bool no_throw) const {
+    for(auto& key : keys) {
+        sample_asset(false, key.first, key.second);
+    }
+    auto found = my_->read_assets(keys, outs, no_throw);
+
+    auto& counters = thread_io_counters();
+    counters.reads += keys.size();
+    counters.misses += keys.size() - found;
+    return found;
+}
+
+void
+token_database::prefetch(const prefetch_keys& keys) const {
+    using namespace internal;
+
+    if(!my_->config_.prefetch || my_->config_.profile != storage_profile::disk || !my_->db_) {
+        return;
+    }
+    if(keys.tokens.empty() && keys.assets.empty()) {
+        return;
+    }
+
+    auto tokens = std::vector<std::pair<name128, name128>>();
+    tokens.reserve(keys.tokens.size());
+    for(auto& [type, domain, key] : keys.tokens) {
+        assert(type != token_type::asset);
+        tokens.emplace_back(domain.has_value() ? *domain : action_key_prefixes[(int)type], key);
+    }
+    my_->prefetch(tokens, keys.assets);
 }
 
 int
@@ -1518,12 +3766,61 @@ token_database::read_tokens_range(token_type type, const std::optional<name128>&
     assert(type != token_type::asset);
     assert((type == token_type::token) != (!domain.has_value()));
     auto& prefix = domain.has_value() ? *domain : action_key_prefixes[(int)type];
-    return my_->read_tokens_range(prefix, skip, func);
+    auto cursor = std::string();
+    return my_->read_tokens_range(prefix, skip, cursor, func);
+}
+
+int
+token_database::read_tokens_range(token_type type, const std::optional<name128>& domain, std::string& cursor, const read_value_func& func) const {
+    using namespace internal;
+
+    assert(type != token_type::asset);
+    assert((type == token_type::token) != (!domain.has_value()));
+    auto& prefix = domain.has_value() ? *domain : action_key_prefixes[(int)type];
+    return my_->read_tokens_range(prefix, 0, cursor, func);
+}
+
+int
+token_database::read_tokens_prefix(token_type type, const std::optional<name128>& domain, const std::string_view& key_prefix, const read_value_func& func) const {
+    using namespace internal;
+
+    assert(type != token_type::asset);
+    assert((type == token_type::token) != (!domain.has_value()));
+    auto& prefix = domain.has_value() ? *domain : action_key_prefixes[(int)type];
+    return my_->read_tokens_prefix(prefix, key_prefix, func);
 }
 
 int
 token_database::read_assets_range(const symbol_id_type sym_id, int skip, const read_value_func& func) const {
-    return my_->read_assets_range(sym_id, skip, func);
+    auto cursor = std::string();
+    return my_->read_assets_range(sym_id, skip, cursor, func);
+}
+
+int
+token_database::read_assets_range(const symbol_id_type sym_id, std::string& cursor, const read_value_func& func) const {
+    return my_->read_assets_range(sym_id, 0, cursor, func);
+}
+
+int
+token_database::read_owned_tokens(const address& owner, int skip, const read_owned_func& func) const {
+    EVT_ASSERT(my_->config_.owner_index, token_database_exception, "Owner index of token database is not enabled");
+    return my_->read_owned_tokens(owner, skip, func);
+}
+
+bool
+token_database::has_owner_index() const {
+    return my_->config_.owner_index;
+}
+
+int
+token_database::read_held_symbols(const address& addr, const read_held_func& func) const {
+    EVT_ASSERT(my_->config_.holding_index, token_database_exception, "Holding index of token database is not enabled");
+    return my_->read_held_symbols(addr, func);
+}
+
+bool
+token_database::has_holding_index() const {
+    return my_->config_.holding_index;
 }
 
 token_database::session
@@ -1535,7 +3832,7 @@ token_database::new_savepoint_session(int64_t seq) {
 token_database::session
 token_database::new_savepoint_session() {
     auto seq = my_->new_savepoint_session_seq();
-    my_->add_savepoint(seq);
+    my_->add_savepoint(seq, true /* nested */);
     return session(*this, seq);
 }
 
@@ -1546,16 +3843,19 @@ token_database::savepoints_size() const {
 
 void
 token_database::add_savepoint(int64_t seq) {
+    FC_TRACE_SPAN("tokendb", "add_savepoint");
     my_->add_savepoint(seq);
 }
 
 void
 token_database::rollback_to_latest_savepoint() {
+    FC_TRACE_SPAN("tokendb", "rollback_to_latest_savepoint");
     my_->rollback_to_latest_savepoint();
 }
 
 void
 token_database::pop_savepoints(int64_t until) {
+    FC_TRACE_SPAN("tokendb", "pop_savepoints");
     my_->pop_savepoints(until);
 }
 
@@ -1566,6 +3866,7 @@ token_database::pop_back_savepoint() {
 
 void
 token_database::squash() {
+    FC_TRACE_SPAN("tokendb", "squash");
     my_->squash();
 }
 
@@ -1574,13 +3875,267 @@ token_database::latest_savepoint_seq() const {
     return my_->latest_savepoint_seq();
 }
 
+void
+token_database::begin_bulk_load() {
+    my_->begin_bulk_load();
+}
+
+void
+token_database::end_bulk_load() {
+    my_->end_bulk_load();
+}
+
+void
+token_database::create_checkpoint(const fc::path& dir) const {
+    my_->create_checkpoint(dir);
+}
+
+void
+token_database::restore_checkpoint(const fc::path& dir, const fc::path& db_path) {
+    EVT_ASSERT(fc::is_directory(dir), token_database_exception, "Checkpoint directory: ${d} doesn't exist", ("d", dir.generic_string()));
+    EVT_ASSERT(!fc::exists(db_path), token_database_exception, "Token database: ${d} already exists", ("d", db_path.generic_string()));
+
+    try {
+        fc::create_directories(db_path);
+        for(auto it = fc::directory_iterator(dir); it != fc::directory_iterator(); ++it) {
+            auto from = *it;
+            auto to   = db_path / from.filename();
+            // table files are never modified after written, share them with the checkpoint
+            // others like MANIFEST may be appended by rocksdb, copy them instead
+            if(from.extension().generic_string() == ".sst") {
+                fc::create_hard_link(from, to);
+            }
+            else {
+                fc::copy(from, to);
+            }
+        }
+    }
+    EVT_CAPTURE_AND_RETHROW(token_database_exception);
+}
+
+fc::sha256
+token_database::calculate_integrity_hash() const {
+    return my_->calculate_integrity_hash();
+}
+
+token_database_view_ptr
+token_database::get_irreversible_view() const {
+    auto lock = std::lock_guard(my_->irreversible_mtx_);
+    return my_->irreversible_view_;
+}
+
+token_database_view::token_database_view(std::unique_ptr<token_database_view_impl>&& my)
+    : my_(std::move(my)) {}
+
+token_database_view::~token_database_view() {}
+
+int
+token_database_view::read_token(token_type type, const std::optional<name128>& domain, const name128& key, std::string& out, bool no_throw) const {
+    using namespace internal;
+
+    assert(type != token_type::asset);
+    assert((type == token_type::token) != (!domain.has_value()));
+    auto& prefix = domain.has_value() ? *domain : action_key_prefixes[(int)type];
+
+    auto opts     = rocksdb::ReadOptions();
+    opts.snapshot = my_->tokens_snapshot.get();
+
+    auto dbkey  = db_token_key(prefix, key);
+    auto status = my_->db->Get(opts, dbkey.as_slice(), &out);
+    if(!status.ok()) {
+        if(!status.IsNotFound()) {
+            FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
+        }
+        if(!no_throw) {
+            EVT_THROW(unknown_token_database_key, "Cannot find key: ${k} with prefix: ${p}", ("k",key)("p",prefix));
+        }
+        return false;
+    }
+    return true;
+}
+
+int
+token_database_view::read_tokens_prefix(token_type type, const std::optional<name128>& domain, const std::string_view& key_prefix, const read_value_func& func) const {
+    using namespace internal;
+
+    assert(type != token_type::asset);
+    assert((type == token_type::token) != (!domain.has_value()));
+    auto& prefix = domain.has_value() ? *domain : action_key_prefixes[(int)type];
+
+    auto opts     = rocksdb::ReadOptions();
+    opts.snapshot = my_->tokens_snapshot.get();
+
+    auto it = std::unique_ptr<rocksdb::Iterator>(my_->db->NewIterator(opts));
+    return read_prefixed_tokens(it.get(), prefix, key_prefix, func);
+}
+
+int
+token_database_view::read_held_symbols(const address& addr, const read_held_func& func) const {
+    using namespace internal;
+
+    auto opts     = rocksdb::ReadOptions();
+    opts.snapshot = my_->tokens_snapshot.get();
+
+    auto it = std::unique_ptr<rocksdb::Iterator>(my_->db->NewIterator(opts));
+    return read_prefixed_tokens(it.get(), holding_prefix(addr), std::string_view(), [&](auto&, auto&& value) {
+        auto sym_id = symbol_id_type();
+        memcpy(&sym_id, value.data(), sizeof(sym_id));
+        return func(sym_id);
+    });
+}
+
+const address& addr, const symbol_id_type sym_id, std::string& out, bool no_throw) const {
+    using namespace internal;
+
+    auto key = db_asset_key(addr, sym_id);
+    auto it  = my_->assets_overlay->find(std::string(key.as_string_view()));
+    if(it != my_->assets_overlay->end()) {
+        out = it->second;
+        return true;
+    }
+
+    auto opts     = rocksdb::ReadOptions();
+    opts.snapshot = my_->assets_snapshot.get();
+
+    auto status = my_->db->Get(opts, my_->assets_handle, key.as_slice(), &out);
+    if(!status.ok()) {
+        if(!status.IsNotFound()) {
+            FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
+        }
+        if(!no_throw) {
+            EVT_THROW2(unknown_token_database_key, "There's no balance of fungible with sym id: {} in address: {}", sym_id, addr);
+        }
+        return false;
+    }
+    return true;
+}
+
 std::string
 token_database::stats() const {
     auto s = std::string();
-    if(my_->db_->GetProperty(rocksdb::DB::Properties::kStats, &s)) {
-        return s;
+    if(!my_->db_->GetProperty(rocksdb::DB::Properties::kStats, &s)) {
+        s = "NA";
+    }
+    // object cache appends its per-shard stats here
+    collect_stats(s);
+
+    auto hk = get_hot_keys(10);
+    s.append(fmt::format("\n** Hot Keys ** (sample rate: 1/{}, reads: {}, writes: {})\n", hk.sample_rate, hk.reads, hk.writes));
+    for(auto& it : { std::make_pair("read ", &hk.top_reads), std::make_pair("write", &hk.top_writes) }) {
+        for(auto& k : *it.second) {
+            s.append(fmt::format("{}: {:>13} {}/{}: {} (error: {})\n",
+                it.first, fc::reflector<token_type>::to_string(k.type), k.prefix, k.key, k.count, k.error));
+        }
+    }
+    return s;
+}
+
+std::map<std::string, uint64_t>
+token_database::tickers() const {
+    auto m     = std::map<std::string, uint64_t>();
+    auto stats = my_->db_->GetDBOptions().statistics;
+    if(stats) {
+        stats->getTickerMap(&m);
+    }
+    m["evt.tokendb.snapshots"]                   = my_->snapshots_taken_.load();
+    m["evt.tokendb.domains.demoted"]             = my_->domains_demoted_.load();
+    m["evt.tokendb.keys.prefetched"]             = my_->keys_prefetched_.load();
+    m["evt.tokendb.write_buffers.tuned"]         = my_->write_buffers_tuned_.load();
+    m["evt.tokendb.key_filters.negatives"]       = my_->filter_negatives_.load();
+    m["evt.tokendb.key_filters.positives"]       = my_->filter_positives_.load();
+    m["evt.tokendb.key_filters.false_positives"] = my_->filter_false_positives_.load();
+    m["evt.tokendb.key_filters.rebuilds"]        = my_->filter_rebuilds_.load();
+    return m;
+}
+
+token_database::memory_usage
+token_database::get_memory_usage() const {
+    auto u = memory_usage();
+    for(auto& it : my_->block_caches_) {
+        u.block_cache += it.first->GetUsage();
+        u.block_cache_capacity += it.first->GetCapacity();
+    }
+    my_->db_->GetAggregatedIntProperty(rocksdb::DB::Properties::kCurSizeAllMemTables, &u.memtables);
+    my_->db_->GetAggregatedIntProperty(rocksdb::DB::Properties::kEstimateTableReadersMem, &u.table_readers);
+    u.write_cache = my_->assets_write_cache_.memory_usage();
+    for(auto& f : my_->key_filters_) {
+        u.key_filters += f.memory_usage();
+    }
+    return u;
+}
+
+void
+token_database::set_block_cache_capacity(uint64_t bytes) {
+    for(auto& it : my_->block_caches_) {
+        it.first->SetCapacity(bytes * it.second / 100);
+    }
+}
+
+void
+token_database::set_io_rates(uint64_t busy, uint64_t idle) {
+    auto lock = std::lock_guard(my_->io_rate_mtx_);
+    my_->config_.io_rate      = busy;
+    my_->config_.idle_io_rate = idle;
+    if(my_->rate_limiter_) {
+        my_->apply_io_rate();
+    }
+}
+
+std::pair<uint64_t, uint64_t>
+token_database::get_io_rates() const {
+    auto lock = std::lock_guard(my_->io_rate_mtx_);
+    return std::make_pair(my_->config_.io_rate, my_->config_.idle_io_rate);
+}
+
+void
+token_database::sync_wal() {
+    if(my_->write_opts_.disableWAL) {
+        return;
+    }
+    auto status = my_->db_->SyncWAL();
+    if(!status.ok()) {
+        FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
     }
-    return "NA";
+}
+
+void
+token_database::set_background_busy(bool busy) {
+    auto lock = std::lock_guard(my_->io_rate_mtx_);
+    if(my_->background_busy_ == busy) {
+        return;
+    }
+    my_->background_busy_ = busy;
+    if(my_->rate_limiter_) {
+        my_->apply_io_rate();
+    }
+}
+
+token_database::hot_keys
+token_database::get_hot_keys(size_t top) const {
+    auto convert = [](auto& counters) {
+        auto v = std::vector<hot_key>();
+        for(auto& c : counters) {
+            v.emplace_back(hot_key{ std::get<0>(c.key), std::get<1>(c.key), std::get<2>(c.key), c.count, c.error });
+        }
+        return v;
+    };
+
+    auto hk        = hot_keys();
+    hk.sample_rate = my_->config_.hot_keys_sample;
+
+    auto lock     = std::lock_guard(my_->hot_keys_mtx_);
+    hk.reads      = my_->hot_reads_.total();
+    hk.writes     = my_->hot_writes_.total();
+    hk.top_reads  = convert(my_->hot_reads_.top(top));
+    hk.top_writes = convert(my_->hot_writes_.top(top));
+    return hk;
+}
+
+void
+token_database::reset_hot_keys() {
+    auto lock = std::lock_guard(my_->hot_keys_mtx_);
+    my_->hot_reads_.clear();
+    my_->hot_writes_.clear();
 }
 
 void
@@ -1598,18 +4153,18 @@ token_database::load_savepoints(std::istream& is) {
     my_->load_savepoints(is);
 }
 
-std::string
-token_database::get_db_key(token_type type, const std::optional<name128>& domain, const name128& key) {
+token_db_key
+token_database::get_db_key(token_type type, const std::optional<name128>& domain, const name128& key) const {
     using namespace internal;
 
     auto& prefix = domain.has_value() ? *domain : action_key_prefixes[(int)type];
-    auto  dkey   = db_token_key(prefix, key);
-    return dkey.as_string();
+    return token_db_key { prefix, key };
 }
 
 }}  // namespace evt::chain
 
 FC_REFLECT(evt::chain::internal::pd_header, (dirty_flag));
+FC_REFLECT(evt::chain::internal::kf_header, (version)(sequence)(identity));
 FC_REFLECT(evt::chain::internal::pd_action, (op)(type)(key)(value));
 FC_REFLECT(evt::chain::internal::pd_group,  (seq)(actions));
 FC_REFLECT(evt::chain::internal::wc_entry, (k)(v));
@@ -1,6 +1,12 @@
 #include <evt/chain/token_database_snapshot.hpp>
 
 #include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <thread>
 #include <vector>
 #include <fmt/format.h>
 #include <rocksdb/db.h>
@@ -10,6 +16,62 @@ namespace evt { namespace chain {
 
 namespace internal {
 
+const uint32_t kMaxSnapshotWorkers   = 8;
+const uint32_t kSectionsPerWorker    = 16;   // sections buffered in memory per worker
+const size_t   kSnapshotBatchSize    = 1024; // rows per batch write when restoring
+
+using snapshot_rows = std::vector<std::pair<std::string, std::string>>;
+
+// Scans sections in parallel by worker threads and write them in order.
+// Snapshot writer is a sequential stream, so sections are buffered within a window.
+template<typename Scan>
+void
+write_sections_parallel(snapshot_writer_ptr writer, const std::vector<std::string>& names, Scan&& scan) {
+    auto workers = std::clamp(std::thread::hardware_concurrency(), 1u, kMaxSnapshotWorkers);
+    auto window  = (size_t)workers * kSectionsPerWorker;
+
+    for(auto begin = 0ul; begin < names.size(); begin += window) {
+        auto end  = std::min(begin + window, names.size());
+        auto rows = std::vector<snapshot_rows>(end - begin);
+        auto next = std::atomic<size_t>(begin);
+        auto err  = std::exception_ptr();
+        auto mtx  = std::mutex();
+
+        auto threads = std::vector<std::thread>();
+        for(auto i = 0u; i < std::min((size_t)workers, end - begin); i++) {
+            threads.emplace_back([&] {
+                try {
+                    for(auto j = next++; j < end; j = next++) {
+                        scan(j, rows[j - begin]);
+                    }
+                }
+                catch(...) {
+                    auto lock = std::lock_guard<std::mutex>(mtx);
+                    if(!err) {
+                        err = std::current_exception();
+                    }
+                }
+            });
+        }
+        for(auto& t : threads) {
+            t.join();
+        }
+        if(err) {
+            std::rethrow_exception(err);
+        }
+
+        for(auto j = begin; j < end; j++) {
+            writer->write_section(names[j], [&](auto& w) {
+                for(auto& r : rows[j - begin]) {
+                    w.add_row(r.first.data(), r.first.size());
+                    w.add_row(r.second);
+                }
+            });
+            snapshot_rows().swap(rows[j - begin]);
+        }
+    }
+}
+
 // TODO: Replace with values provided by token database class directly
 const char* section_names[] = {
     ".asset",
@@ -22,7 +84,10 @@ const char* section_names[] = {
     ".prodvote",
     ".evtlink",
     ".psvbonus",
-    ".psvbonus-dist"
+    ".psvbonus-dist",
+    ".owner",
+    ".meta",
+    ".holding"
 };
 
 void
@@ -33,7 +98,8 @@ add_reserved_tokens(snapshot_writer_ptr          writer,
     static_assert(sizeof(section_names) / sizeof(char*) == (int)token_type::max_value + 1);
 
     for(auto i = (int)token_type::domain; i <= (int)token_type::max_value; i++) {
-        if(i == (int)token_type::asset || i == (int)token_type::token) {
+        // indexes are rebuilt from tokens and assets when restored
+        if(i == (int)token_type::asset || i == (int)token_type::token || i == (int)token_type::owner || i == (int)token_type::holding) {
             continue;
         }
         writer->write_section(section_names[i], [&](auto& w) {
@@ -63,46 +129,95 @@ add_reserved_tokens(snapshot_writer_ptr          writer,
 }
 
 void
-add_tokens(snapshot_writer_ptr writer, const token_database& db, const std::vector<domain_name> domains) {
+add_tokens(snapshot_writer_ptr writer, const token_database& db, const std::vector<domain_name>& domains) {
+    auto names = std::vector<std::string>();
+    names.reserve(domains.size());
     for(auto& d : domains) {
-        writer->write_section(d.to_string(), [&](auto& w) {
-            db.read_tokens_range(token_type::token, d, 0, [&w](auto& key, auto&& v) {
-                w.add_row(key.data(), key.size());
-                w.add_row(v);
+        names.emplace_back(d.to_string());
+    }
 
-                return true;
-            });
+    write_sections_parallel(writer, names, [&](auto i, auto& rows) {
+        db.read_tokens_range(token_type::token, domains[i], 0, [&rows](auto& key, auto&& v) {
+            rows.emplace_back(std::string(key.data(), key.size()), std::move(v));
+            return true;
         });
-    }
+    });
 }
 
 void
 add_assets(snapshot_writer_ptr writer, const token_database& db, const std::vector<symbol_id_type>& symbol_ids) {
+    auto names = std::vector<std::string>();
+    names.reserve(symbol_ids.size());
     for(auto& id : symbol_ids) {
-        auto sn = fmt::format(".asset-{}", id);
-        writer->write_section(sn, [&](auto& w) {
-            db.read_assets_range(id, 0, [&w](auto& key, auto&& v) {
-                assert(key.size() == sizeof(fc::ecc::public_key_shim));
-                w.add_row(key.data(), key.size());
-                w.add_row(v);
+        names.emplace_back(fmt::format(".asset-{}", id));
+    }
 
-                return true;
-            });
+    write_sections_parallel(writer, names, [&](auto i, auto& rows) {
+        db.read_assets_range(symbol_ids[i], 0, [&rows](auto& key, auto&& v) {
+            assert(key.size() == sizeof(fc::ecc::public_key_shim));
+            rows.emplace_back(std::string(key.data(), key.size()), std::move(v));
+            return true;
         });
-    }
+    });
 }
 
+// restores rows of tokens in batches
+struct tokens_batch {
+public:
+    tokens_batch(token_database& db, token_type type, const std::optional<name128>& domain)
+        : db_(db), type_(type), domain_(domain) {}
+
+public:
+    void
+    add(const name128& key, std::string&& value) {
+        keys_.emplace_back(key);
+        values_.emplace_back(std::move(value));
+        if(keys_.size() >= kSnapshotBatchSize) {
+            flush();
+        }
+    }
+
+    void
+    flush() {
+        if(keys_.empty()) {
+            return;
+        }
+
+        auto data = small_vector<std::string_view, 4>();
+        for(auto& v : values_) {
+            data.emplace_back(v.data(), v.size());
+        }
+        db_.put_tokens(type_, action_op::put, domain_, std::move(keys_), data);
+
+        keys_   = token_keys_t();
+        values_.clear();
+    }
+
+private:
+    token_database&          db_;
+    token_type               type_;
+    std::optional<name128>   domain_;
+    token_keys_t             keys_;
+    std::vector<std::string> values_;
+};
+
 void
 read_reserved_tokens(snapshot_reader_ptr          reader,
                      token_database&              db,
                      std::vector<domain_name>&    domains,
                      std::vector<symbol_id_type>& symbol_ids) {
     for(auto i = (int)token_type::domain; i <= (int)token_type::max_value; i++) {
-        if(i == (int)token_type::asset || i == (int)token_type::token) {
+        // indexes are rebuilt from tokens and assets when restored
+        if(i == (int)token_type::asset || i == (int)token_type::token || i == (int)token_type::owner || i == (int)token_type::holding) {
+            continue;
+        }
+        // snapshots taken before metas were kept apart have no such section
+        if(i == (int)token_type::meta && !reader->has_section(section_names[i])) {
             continue;
         }
 
         reader->read_section(section_names[i], [&](auto& r) {
+            auto batch = tokens_batch(db, (token_type)i, std::nullopt);
             while(!r.eof()) {
                 auto k = uint128_t(0);
                 auto v = std::string();
@@ -110,7 +225,7 @@ read_reserved_tokens(snapshot_reader_ptr          reader,
                 r.read_row((char*)&k, sizeof(k));
                 r.read_row(v);
 
-                db.put_token((token_type)i, action_op::put, std::nullopt, k, std::string_view(v.data(), v.size()));
+                batch.add(k, std::move(v));
 
                 if(i == (int)token_type::domain) {
                     domains.emplace_back(k);
@@ -119,6 +234,7 @@ read_reserved_tokens(snapshot_reader_ptr          reader,
                     symbol_ids.emplace_back((symbol_id_type)k);
                 }
             }
+            batch.flush();
         });
     }
 }
@@ -127,6 +243,7 @@ void
 read_tokens(snapshot_reader_ptr reader, token_database& db, const std::vector<domain_name>& domains) {
     for(auto& d : domains) {
         reader->read_section(d.to_string(), [&](auto& r) {
+            auto batch = tokens_batch(db, token_type::token, d);
             while(!r.eof()) {
                 auto k = name128();
                 auto v = std::string();
@@ -134,8 +251,9 @@ read_tokens(snapshot_reader_ptr reader, token_database& db, const std::vector<do
                 r.read_row((char*)&k, sizeof(k));
                 r.read_row(v);
 
-                db.put_token(token_type::token, action_op::put, d, k, std::string_view(v.data(), v.size()));
+                batch.add(k, std::move(v));
             }
+            batch.flush();
         });
     }
 }
@@ -145,6 +263,20 @@ read_assets(snapshot_reader_ptr reader, token_database& db, const std::vector<sy
     for(auto& id : symbol_ids) {
         auto sn = fmt::format(".asset-{}", id);
         reader->read_section(sn, [&](auto& r) {
+            auto keys   = asset_keys_t();
+            auto values = std::vector<std::string>();
+
+            auto flush = [&] {
+                auto data = small_vector<std::string_view, 4>();
+                for(auto& v : values) {
+                    data.emplace_back(v.data(), v.size());
+                }
+                db.put_assets(keys, data);
+
+                keys.clear();
+                values.clear();
+            };
+
             while(!r.eof()) {
                 auto k = fc::ecc::public_key_shim();
                 auto v = std::string();
@@ -152,11 +284,164 @@ read_assets(snapshot_reader_ptr reader, token_database& db, const std::vector<sy
                 r.read_row((char*)&k, sizeof(k));
                 r.read_row(v);
 
-                auto addr = address(public_key_type(k));
-                db.put_asset(addr, id, std::string_view(v.data(), v.size()));
+                keys.emplace_back(address(public_key_type(k)), id);
+                values.emplace_back(std::move(v));
+                if(keys.size() >= kSnapshotBatchSize) {
+                    flush();
+                }
+            }
+            if(!keys.empty()) {
+                flush();
+            }
+        });
+    }
+}
+
+// sections of diff snapshots listing the domains and symbols whose sections are there
+const char* kDiffDomainsSection = ".diff-domains";
+const char* kDiffSymbolsSection = ".diff-symbols";
+
+using section_rows = std::map<std::string, std::string>;
+
+// rows of a section in the state of `bases`, a full snapshot followed by the diffs taken after it
+section_rows
+read_base_section(const std::vector<snapshot_reader_ptr>& bases, const std::string& name, size_t key_size) {
+    auto rows = section_rows();
+    for(auto& b : bases) {
+        if(!b->has_section(name)) {
+            continue;
+        }
+        b->read_section(name, [&](auto& r) {
+            while(!r.eof()) {
+                auto k = std::string(key_size, '\0');
+                auto v = std::string();
+
+                r.read_row(k.data(), key_size);
+                r.read_row(v);
+
+                rows[std::move(k)] = std::move(v);
+            }
+        });
+    }
+    return rows;
+}
+
+// rows added or changed since `base`, in the order of the scan
+// values are never removed from token database but by rollbacks, so a missing one means the base is not ours
+template<typename Scan>
+snapshot_rows
+changed_rows(const std::string& name, const section_rows& base, Scan&& scan) {
+    auto rows = snapshot_rows();
+    auto seen = 0ul;
+    scan([&](auto& key, auto&& v) {
+        auto k  = std::string(key.data(), key.size());
+        auto it = base.find(k);
+        if(it != base.end()) {
+            seen++;
+            if(it->second == v) {
+                return true;
             }
+        }
+        rows.emplace_back(std::move(k), std::move(v));
+        return true;
+    });
+
+    EVT_ASSERT(seen == base.size(), snapshot_exception,
+        "Values of section ${s} in base snapshot are missing in token database, it's not taken from this chain", ("s", name));
+    return rows;
+}
+
+void
+write_rows(snapshot_writer_ptr writer, const std::string& name, const snapshot_rows& rows) {
+    writer->write_section(name, [&](auto& w) {
+        for(auto& r : rows) {
+            w.add_row(r.first.data(), r.first.size());
+            w.add_row(r.second);
+        }
+    });
+}
+
+void
+add_changed_reserved_tokens(snapshot_writer_ptr                     writer,
+                            const token_database&                   db,
+                            const std::vector<snapshot_reader_ptr>& bases,
+                            std::vector<domain_name>&               domains,
+                            std::vector<symbol_id_type>&            symbol_ids) {
+    for(auto i = (int)token_type::domain; i <= (int)token_type::max_value; i++) {
+        if(i == (int)token_type::asset || i == (int)token_type::token || i == (int)token_type::owner || i == (int)token_type::holding) {
+            continue;
+        }
+
+        auto base = read_base_section(bases, section_names[i], sizeof(name128));
+        auto rows = changed_rows(section_names[i], base, [&](auto&& f) {
+            db.read_tokens_range((token_type)i, std::nullopt, 0, [&](auto& key, auto&& v) {
+                assert(key.size() == sizeof(name128));
+
+                auto n = name128();
+                memcpy(&n, key.data(), sizeof(name128));
+
+                if(i == (int)token_type::domain) {
+                    domains.push_back(n);
+                }
+                else if(i == (int)token_type::fungible) {
+                    symbol_ids.push_back((symbol_id_type)n.value);
+                }
+                return f(key, std::move(v));
+            });
+        });
+        // reserved sections are always there, even empty
+        write_rows(writer, section_names[i], rows);
+    }
+}
+
+void
+add_changed_tokens(snapshot_writer_ptr                     writer,
+                   const token_database&                   db,
+                   const std::vector<snapshot_reader_ptr>& bases,
+                   const std::vector<domain_name>&         domains) {
+    auto changed = std::vector<domain_name>();
+    for(auto& d : domains) {
+        auto name = d.to_string();
+        auto base = read_base_section(bases, name, sizeof(name128));
+        auto rows = changed_rows(name, base, [&](auto&& f) {
+            db.read_tokens_range(token_type::token, d, 0, f);
+        });
+        if(!rows.empty()) {
+            write_rows(writer, name, rows);
+            changed.emplace_back(d);
+        }
+    }
+
+    writer->write_section(kDiffDomainsSection, [&](auto& w) {
+        for(auto& d : changed) {
+            w.add_row((const char*)&d, sizeof(d));
+        }
+    });
+}
+
+void
+add_changed_assets(snapshot_writer_ptr                     writer,
+                   const token_database&                   db,
+                   const std::vector<snapshot_reader_ptr>& bases,
+                   const std::vector<symbol_id_type>&      symbol_ids) {
+    auto changed = std::vector<symbol_id_type>();
+    for(auto& id : symbol_ids) {
+        auto name = fmt::format(".asset-{}", id);
+        auto base = read_base_section(bases, name, sizeof(fc::ecc::public_key_shim));
+        auto rows = changed_rows(name, base, [&](auto&& f) {
+            db.read_assets_range(id, 0, f);
         });
+        if(!rows.empty()) {
+            write_rows(writer, name, rows);
+            changed.emplace_back(id);
+        }
     }
+
+    writer->write_section(kDiffSymbolsSection, [&](auto& w) {
+        for(auto& id : changed) {
+            w.add_row((const char*)&id, sizeof(id));
+        }
+    });
 }
 
 }  // namespace internal
@@ -190,9 +475,66 @@ token_database_snapshot::read_from_snapshot(snapshot_reader_ptr reader, token_da
         auto domains    = std::vector<domain_name>();
         auto symbol_ids = std::vector<symbol_id_type>();
 
+        // rows in sections are sorted, load them by SST files directly
+        db.begin_bulk_load();
         read_reserved_tokens(reader, db, domains, symbol_ids);
         read_tokens(reader, db, domains);
-        read_assets(reader, db, symbol_ids);        
+        read_assets(reader, db, symbol_ids);
+        db.end_bulk_load();
+    }
+    EVT_CAPTURE_AND_RETHROW(token_database_snapshot_exception);
+}
+
+void
+token_database_snapshot::add_diff_to_snapshot(snapshot_writer_ptr writer, const token_database& db, const std::vector<snapshot_reader_ptr>& bases) {
+    using namespace internal;
+
+    try {
+        FC_ASSERT(!bases.empty());
+
+        auto domains    = std::vector<domain_name>();
+        auto symbol_ids = std::vector<symbol_id_type>();
+
+        add_changed_reserved_tokens(writer, db, bases, domains, symbol_ids);
+        add_changed_tokens(writer, db, bases, domains);
+        add_changed_assets(writer, db, bases, symbol_ids);
+    }
+    EVT_CAPTURE_AND_RETHROW(token_database_snapshot_exception);
+}
+
+void
+token_database_snapshot::read_diff_from_snapshot(snapshot_reader_ptr reader, token_database& db) {
+    using namespace internal;
+
+    try {
+        EVT_ASSERT(reader->has_section(kDiffDomainsSection) && reader->has_section(kDiffSymbolsSection), snapshot_validation_exception,
+            "Token database sections of the snapshot are not differential");
+        FC_ASSERT(db.savepoints_size() == 0);
+
+        // values overwrite the ones of base, they're put one by one instead of bulk loaded
+        auto all_domains    = std::vector<domain_name>();
+        auto all_symbol_ids = std::vector<symbol_id_type>();
+        read_reserved_tokens(reader, db, all_domains, all_symbol_ids);
+
+        auto domains = std::vector<domain_name>();
+        reader->read_section(kDiffDomainsSection, [&](auto& r) {
+            while(!r.eof()) {
+                auto d = domain_name();
+                r.read_row((char*)&d, sizeof(d));
+                domains.emplace_back(d);
+            }
+        });
+        read_tokens(reader, db, domains);
+
+        auto symbol_ids = std::vector<symbol_id_type>();
+        reader->read_section(kDiffSymbolsSection, [&](auto& r) {
+            while(!r.eof()) {
+                auto id = symbol_id_type();
+                r.read_row((char*)&id, sizeof(id));
+                symbol_ids.emplace_back(id);
+            }
+        });
+        read_assets(reader, db, symbol_ids);
     }
     EVT_CAPTURE_AND_RETHROW(token_database_snapshot_exception);
 }
@@ -11,9 +11,11 @@
 #include <boost/iostreams/filter/zlib.hpp>
 #include <boost/iostreams/filtering_stream.hpp>
 #include <boost/range/adaptor/transformed.hpp>
+#include <zstd.h>
 
 #include <evt/chain/exceptions.hpp>
 #include <evt/chain/transaction.hpp>
+#include <evt/utilities/lru_cache.hpp>
 #include <evt/chain/config.hpp>
 
 namespace evt { namespace chain {
@@ -48,24 +50,69 @@ transaction::sig_digest(const chain_id_type& chain_id) const {
     return enc.result();
 }
 
+namespace internal {
+
+// keys recovered from the signatures, by the digest followed by the packed signature.
+// a transaction is recovered on receipt, on push and again when its block is applied
+utilities::lru_cache<public_key_type>&
+recovered_keys() {
+    static auto cache = utilities::lru_cache<public_key_type>(transaction::kDefaultRecoveryCacheSize);
+    return cache;
+}
+
+void
+recover_keys(const signatures_base_type& signatures, const digest_type& digest, fc::small_vector_base<public_key_type>& keys) {
+    auto& cache = recovered_keys();
+
+    auto cache_keys = fc::small_vector<std::string, 4>(signatures.size());
+    auto misses     = fc::small_vector<size_t, 4>();
+    for(auto i = 0u; i < signatures.size(); i++) {
+        auto  sb = fc::raw::pack(signatures[i]);
+        auto& ck = cache_keys[i];
+        ck.reserve(digest.data_size() + sb.size());
+        ck.append(digest.data(), digest.data_size());
+        ck.append(sb.data(), sb.size());
+
+        if(!cache.get(ck, keys[i])) {
+            misses.emplace_back(i);
+        }
+    }
+    if(misses.empty()) {
+        return;
+    }
+
+    auto sigs = fc::small_vector<signature_type, 4>();
+    for(auto i : misses) {
+        sigs.emplace_back(signatures[i]);
+    }
+    auto recovered = fc::small_vector<public_key_type, 4>(sigs.size());
+    public_key_type::recover_keys(sigs.data(), sigs.size(), digest, recovered.data());
+
+    for(auto i = 0u; i < misses.size(); i++) {
+        keys[misses[i]] = recovered[i];
+        cache.put(cache_keys[misses[i]], recovered[i]);
+    }
+}
+
 public_keys_set
-transaction::get_signature_keys(const signatures_base_type& signatures, const chain_id_type& chain_id,
-                                bool allow_duplicate_keys) const {
+get_signature_keys(const signatures_base_type& signatures, const digest_type& digest, bool allow_duplicate_keys) {
     if(signatures.empty()) {
         return public_keys_set();
     }
 
     try {
-        auto digest = sig_digest(chain_id);
+        auto keys = fc::small_vector<public_key_type, 4>(signatures.size());
+        internal::recover_keys(signatures, digest, keys);
 
         auto recovered_pub_keys = public_keys_set();
-        for(auto& sig : signatures) {
+        recovered_pub_keys.reserve(keys.size());
+        for(auto& key : keys) {
             auto successful_insertion                   = false;
-            std::tie(std::ignore, successful_insertion) = recovered_pub_keys.emplace(sig, digest);
+            std::tie(std::ignore, successful_insertion) = recovered_pub_keys.emplace(key);
             EVT_ASSERT(allow_duplicate_keys || successful_insertion, tx_duplicate_sig,
                        "transaction includes more than one signature signed using the same key associated with public "
                        "key: ${key}",
-                       ("key", public_key_type(sig, digest)));
+                       ("key", key));
         }
 
         return recovered_pub_keys;
@@ -73,6 +120,30 @@ transaction::get_signature_keys(const signatures_base_type& signatures, const ch
     FC_CAPTURE_AND_RETHROW()
 }
 
+}  // namespace internal
+
+public_keys_set
+transaction::get_signature_keys(const signatures_base_type& signatures, const chain_id_type& chain_id,
+                                bool allow_duplicate_keys) const {
+    if(signatures.empty()) {
+        return public_keys_set();
+    }
+    return internal::get_signature_keys(signatures, sig_digest(chain_id), allow_duplicate_keys);
+}
+
+void
+transaction::set_recovery_cache_size(size_t size) {
+    internal::recovered_keys().set_capacity(size);
+}
+
+transaction::recovery_cache_stats
+transaction::get_recovery_cache_stats() {
+    auto stats   = recovery_cache_stats();
+    stats.hits   = internal::recovered_keys().hits();
+    stats.misses = internal::recovered_keys().misses();
+    return stats;
+}
+
 const signature_type&
 signed_transaction::sign(const private_key_type& key, const chain_id_type& chain_id) {
     signatures.push_back(key.sign(sig_digest(chain_id)));
@@ -89,6 +160,65 @@ signed_transaction::get_signature_keys(const chain_id_type& chain_id, bool allow
     return transaction::get_signature_keys(signatures, chain_id, allow_duplicate_keys);
 }
 
+transaction_id_type
+packed_transaction::id() const {
+    return trx_id;
+}
+
+digest_type
+packed_transaction::sig_digest(const chain_id_type& chain_id) const {
+    auto cached = std::atomic_load(&sig_digest_cache);
+    if(cached && cached->first == chain_id) {
+        return cached->second;
+    }
+
+    auto digest = digest_type();
+    if(raw_canonical) {
+        digest_type::encoder enc;
+        fc::raw::pack(enc, chain_id);
+        enc.write(packed_trx.data(), packed_trx.size());
+        digest = enc.result();
+    }
+    else {
+        digest = unpacked_trx.sig_digest(chain_id);
+    }
+
+    std::atomic_store(&sig_digest_cache, std::make_shared<const std::pair<chain_id_type, digest_type>>(chain_id, digest));
+    return digest;
+}
+
+public_keys_set
+packed_transaction::get_signature_keys(const chain_id_type& chain_id, bool allow_duplicate_keys) const {
+    if(signatures.empty()) {
+        return public_keys_set();
+    }
+    return internal::get_signature_keys(signatures, sig_digest(chain_id), allow_duplicate_keys);
+}
+
+void
+packed_transaction::local_compute_ids() {
+    // uncompressed bytes are the packed transaction itself, unless the sender chose a longer
+    // encoding (like an overlong varint), in which case the ids are still taken from a re-pack
+    raw_canonical = (compression == none) && fc::raw::pack_size((const transaction&)unpacked_trx) == packed_trx.size();
+    if(raw_canonical) {
+        trx_id = transaction_id_type::hash(packed_trx.data(), packed_trx.size());
+    }
+    else {
+        trx_id = unpacked_trx.id();
+    }
+    signed_trx_id = digest_type::hash(*this);
+
+    // leaf of the transaction merkle root once the transaction is in a block
+    digest_type::encoder prunable;
+    fc::raw::pack(prunable, signatures);
+
+    digest_type::encoder enc;
+    fc::raw::pack(enc, compression);
+    fc::raw::pack(enc, packed_trx);
+    fc::raw::pack(enc, prunable.result());
+    packed_trx_digest = enc.result();
+}
+
 void
 packed_transaction::reflector_init() {
     // called after construction, but always on the same thread and before packed_transaction passed to any other threads
@@ -99,6 +229,7 @@ packed_transaction::reflector_init() {
     }
     EVT_ASSERT(unpacked_trx.expiration == time_point_sec(), tx_decompression_error, "packed_transaction already unpacked");
     local_unpack_transaction();
+    local_compute_ids();
 }
 
 uint32_t
@@ -118,15 +249,7 @@ packed_transaction::get_prunable_size() const {
 
 digest_type
 packed_transaction::packed_digest() const {
-    digest_type::encoder prunable;
-    fc::raw::pack(prunable, signatures);
-
-    digest_type::encoder enc;
-    fc::raw::pack(enc, compression);
-    fc::raw::pack(enc, packed_trx);
-    fc::raw::pack(enc, prunable.result());
-
-    return enc.result();
+    return packed_trx_digest;
 }
 
 namespace bio = boost::iostreams;
@@ -180,6 +303,22 @@ zlib_decompress_transaction(const bytes& data) {
     return unpack_transaction(out);
 }
 
+static transaction
+zstd_decompress_transaction(const bytes& data) {
+    const auto limit = 1 * 1024 * 1024;  // same limit as zlib for zip bomb protections
+
+    auto size = ZSTD_getFrameContentSize(data.data(), data.size());
+    EVT_ASSERT(size != ZSTD_CONTENTSIZE_UNKNOWN && size != ZSTD_CONTENTSIZE_ERROR, tx_decompression_error,
+               "Invalid zstd frame of transaction");
+    EVT_ASSERT(size <= limit, tx_decompression_error, "Exceeded maximum decompressed transaction size");
+
+    auto out = bytes(size);
+    auto r   = ZSTD_decompress(out.data(), out.size(), data.data(), data.size());
+    EVT_ASSERT(!ZSTD_isError(r) && r == size, tx_decompression_error, "Cannot decompress transaction: ${err}",
+               ("err", ZSTD_isError(r) ? ZSTD_getErrorName(r) : "size mismatch"));
+    return unpack_transaction(out);
+}
+
 static bytes
 pack_transaction(const transaction& t) {
     return fc::raw::pack(t);
@@ -198,6 +337,18 @@ zlib_compress_transaction(const transaction& t) {
     return out;
 }
 
+static bytes
+zstd_compress_transaction(const transaction& t) {
+    const auto level = 19;
+
+    auto in  = pack_transaction(t);
+    auto out = bytes(ZSTD_compressBound(in.size()));
+    auto r   = ZSTD_compress(out.data(), out.size(), in.data(), in.size(), level);
+    EVT_ASSERT(!ZSTD_isError(r), transaction_exception, "Cannot compress transaction: ${err}", ("err", ZSTD_getErrorName(r)));
+    out.resize(r);
+    return out;
+}
+
 void
 packed_transaction::local_unpack_transaction() {
     try {
@@ -208,6 +359,9 @@ packed_transaction::local_unpack_transaction() {
         case zlib:
             unpacked_trx = signed_transaction(zlib_decompress_transaction(packed_trx), signatures);
             break;
+        case zstd:
+            unpacked_trx = signed_transaction(zstd_decompress_transaction(packed_trx), signatures);
+            break;
         default:
             EVT_THROW(unknown_transaction_compression, "Unknown transaction compression algorithm");
         }
@@ -225,6 +379,9 @@ packed_transaction::local_pack_transaction() {
         case zlib:
             packed_trx = zlib_compress_transaction(unpacked_trx);
             break;
+        case zstd:
+            packed_trx = zstd_compress_transaction(unpacked_trx);
+            break;
         default:
             EVT_THROW(unknown_transaction_compression, "Unknown transaction compression algorithm");
         }
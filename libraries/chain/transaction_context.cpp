@@ -10,6 +10,8 @@
 #include <evt/chain/exceptions.hpp>
 #include <evt/chain/global_property_object.hpp>
 #include <evt/chain/transaction_object.hpp>
+#include <fc/log/trace.hpp>
+#include <fc/scoped_exit.hpp>
 
 namespace evt { namespace chain {
 
@@ -23,11 +25,11 @@ transaction_context::transaction_context(controller&                    control,
     , undo_token_session()
     , trx_meta(trx_meta)
     , trx(trx_meta->packed_trx->get_signed_transaction())
-    , trace(std::make_shared<transaction_trace>())
+    , trace(utilities::make_pooled<transaction_trace>())
     , start(start)
     , net_usage(trace->net_usage) {
     if(!control.skip_db_sessions()) {
-        undo_session       = control.db().start_undo_session(true);
+        undo_session       = control.db().get_mutable_index<transaction_multi_index>().start_undo_session(true);
         undo_token_session = control.token_db().new_savepoint_session();
     }
     trace->id = trx_meta->id;
@@ -51,6 +53,7 @@ transaction_context::init(uint64_t initial_net_usage) {
         act.set_index(exec_ctx.index_of(act.name));
     }
     
+    timer.start(deadline, start);
     check_time();    // Fail early if deadline has already been exceeded
     if(!control.charge_free_mode()) {
         check_charge();  // Fail early if max charge has already been exceeded
@@ -94,6 +97,7 @@ transaction_context::init_for_suspend_trx() {
 
 void
 transaction_context::exec() {
+    FC_TRACE_SPAN("chain", "transaction_context::exec");
     EVT_ASSERT(is_initialized, transaction_exception, "must first initialize");
 
     for(auto& act : trx.actions) {
@@ -113,6 +117,7 @@ transaction_context::exec() {
 void
 transaction_context::finalize() {
     EVT_ASSERT(is_initialized, transaction_exception, "must first initialize");
+    check_time();
 
     if(charge) {
         // in charge-free mode, charge always be zero
@@ -144,8 +149,9 @@ void transaction_context::undo() {
 
 void
 transaction_context::check_time() const {
-    auto now = fc::time_point::now();
-    if(BOOST_UNLIKELY(now > deadline)) {
+    // the clock is only read once the timer has expired
+    if(BOOST_UNLIKELY(timer.expired())) {
+        auto now = fc::time_point::now();
         EVT_THROW(deadline_exception, "deadline exceeded", ("now", now)("deadline", deadline)("start", start));
     }
 }
@@ -153,7 +159,7 @@ transaction_context::check_time() const {
 void
 transaction_context::check_charge() {
     auto cm = control.get_charge_manager();
-    charge = cm.calculate(*trx_meta->packed_trx);
+    charge = cm.calculate(*trx_meta);
     if(charge > trx.max_charge) {
         EVT_THROW(max_charge_exceeded_exception, "max charge exceeded, expected: ${ex}, max provided: ${mp}",
             ("ex",charge)("mp",trx.max_charge));
@@ -275,6 +281,17 @@ transaction_context::check_net_usage() const {
 
 void
 transaction_context::dispatch_action(action_trace& trace, const action& act) {
+    check_time();
+
+    auto& counters = token_database::thread_io_counters();
+    auto  begin    = counters;
+
+    auto io = fc::make_scoped_exit([&] {
+        trace.db_reads  = counters.reads - begin.reads;
+        trace.db_writes = counters.writes - begin.writes;
+        trace.db_misses = counters.misses - begin.misses;
+    });
+
     auto apply = apply_context(control, *this, act);
     apply.exec(trace);
 }
@@ -0,0 +1,29 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#include <evt/chain/transaction_metadata.hpp>
+
+#include <evt/utilities/task_scheduler.hpp>
+
+namespace evt { namespace chain {
+
+transaction_metadata::signing_keys_future_type
+transaction_metadata::create_signing_keys_future(const transaction_metadata_ptr& mtrx, utilities::task_scheduler& scheduler, const chain_id_type& chain_id) {
+    if(mtrx->signing_keys_future.valid()) {
+        return mtrx->signing_keys_future;
+    }
+
+    // packed_trx is immutable after construction, safe to read from the workers
+    auto ptrx = mtrx->packed_trx;
+    auto task = std::make_shared<std::packaged_task<signing_keys_type()>>([ptrx, chain_id] {
+        return std::make_pair(chain_id, ptrx->get_signature_keys(chain_id));
+    });
+
+    mtrx->signing_keys_future = task->get_future().share();
+    scheduler.post([task] { (*task)(); });
+
+    return mtrx->signing_keys_future;
+}
+
+}}  // namespace evt::chain
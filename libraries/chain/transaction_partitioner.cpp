@@ -0,0 +1,179 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#include <evt/chain/transaction_partitioner.hpp>
+
+#include <algorithm>
+#include <fc/io/raw.hpp>
+#include <evt/chain/contracts/types.hpp>
+
+namespace evt { namespace chain {
+
+namespace internal {
+
+enum footprint_type : char {
+    kAction = 0,
+    kPayer
+};
+
+std::string
+action_footprint(const action& act) {
+    auto key = std::string();
+    key.reserve(1 + sizeof(name128) * 2);
+    key.push_back(kAction);
+    key.append((const char*)&act.domain, sizeof(act.domain));
+
+    // reserved domains(.fungible, .group and so on) are keyed by objects
+    // normal domains are keyed as a whole, actions on tokens read domain for authorization
+    if(act.domain.reserved()) {
+        key.append((const char*)&act.key, sizeof(act.key));
+    }
+    return key;
+}
+
+std::string
+payer_footprint(const address& payer) {
+    auto key = std::string(1, kPayer);
+    auto raw = fc::raw::pack(payer);
+    key.append(raw.data(), raw.size());
+    return key;
+}
+
+}  // namespace internal
+
+bool
+transaction_partitioner::is_serial_action(const action& act) {
+    using namespace contracts;
+
+    switch(act.name.value) {
+    // touch objects not declared by domain and key
+    case N(everipay):
+    case N(everipass):
+    case N(distpsvbonus):
+    case N(setpsvbonus):
+    case N(paybonus):
+    case N(paycharge):
+    case N(evt2pevt):
+    case N(newlock):
+    case N(aprvlock):
+    case N(tryunlock):
+    // nested transactions
+    case N(newsuspend):
+    case N(aprvsuspend):
+    case N(cancelsuspend):
+    case N(execsuspend):
+    // global states
+    case N(prodvote):
+    case N(updsched):
+    // groups are read by authority checks of any action
+    case N(newgroup):
+    case N(updategroup): {
+        return true;
+    }
+    default: {
+        break;
+    }
+    }  // switch
+
+    // EVT and PEVT are touched by charges of every transaction
+    if(act.domain == N128(.fungible)) {
+        if(act.key == name128::from_number(EVT_SYM_ID) || act.key == name128::from_number(PEVT_SYM_ID)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint32_t
+transaction_partitioner::find_root(uint32_t g) {
+    while(parents_[g] != g) {
+        parents_[g] = parents_[parents_[g]];
+        g = parents_[g];
+    }
+    return g;
+}
+
+void
+transaction_partitioner::close_segment() {
+    if(groups_.empty()) {
+        return;
+    }
+
+    auto seg = segment();
+    for(auto i = 0u; i < groups_.size(); i++) {
+        if(parents_[i] != i || groups_[i].empty()) {
+            continue;
+        }
+        std::sort(groups_[i].begin(), groups_[i].end());
+        seg.groups.emplace_back(std::move(groups_[i]));
+    }
+    // order groups by their first trx to be deterministic
+    std::sort(seg.groups.begin(), seg.groups.end(), [](auto& a, auto& b) { return a.front() < b.front(); });
+    segments_.emplace_back(std::move(seg));
+
+    keys_.clear();
+    parents_.clear();
+    groups_.clear();
+}
+
+void
+transaction_partitioner::add(const transaction& trx) {
+    using namespace internal;
+
+    auto idx = index_++;
+
+    auto serial = std::any_of(trx.actions.cbegin(), trx.actions.cend(), [](auto& act) { return is_serial_action(act); });
+    if(serial) {
+        close_segment();
+
+        auto seg   = segment();
+        seg.serial = true;
+        seg.groups.emplace_back(std::vector<uint32_t>{ idx });
+        segments_.emplace_back(std::move(seg));
+        return;
+    }
+
+    auto g = (uint32_t)groups_.size();
+    parents_.emplace_back(g);
+    groups_.emplace_back(std::vector<uint32_t>{ idx });
+
+    auto merge = [&](std::string&& key) {
+        auto it = keys_.find(key);
+        if(it == keys_.end()) {
+            keys_.emplace(std::move(key), g);
+            return;
+        }
+
+        auto r1 = find_root(it->second);
+        auto r2 = find_root(g);
+        if(r1 == r2) {
+            return;
+        }
+        // merge smaller group into larger one
+        if(groups_[r1].size() < groups_[r2].size()) {
+            std::swap(r1, r2);
+        }
+        auto& src = groups_[r2];
+        groups_[r1].insert(groups_[r1].end(), src.cbegin(), src.cend());
+        src.clear();
+        parents_[r2] = r1;
+    };
+
+    for(auto& act : trx.actions) {
+        merge(action_footprint(act));
+    }
+    merge(payer_footprint(trx.payer));
+}
+
+std::vector<transaction_partitioner::segment>
+transaction_partitioner::finalize() {
+    close_segment();
+
+    auto segs = std::move(segments_);
+    segments_.clear();
+    index_ = 0;
+    return segs;
+}
+
+}}  // namespace evt::chain
@@ -0,0 +1,103 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#include <evt/chain/trx_index.hpp>
+
+#include <rocksdb/db.h>
+#include <rocksdb/options.h>
+#include <rocksdb/write_batch.h>
+#include <evt/chain/exceptions.hpp>
+
+namespace evt { namespace chain {
+
+namespace internal {
+
+const size_t kTrxKeySize    = 16;
+const char*  kLastNumKey    = ".last";  // shorter than the keys of transactions
+const size_t kPointLookupMB = 32;       // block cache for point lookups
+
+void
+check_status(const rocksdb::Status& status) {
+    if(!status.ok()) {
+        FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
+    }
+}
+
+rocksdb::Slice
+trx_key(const transaction_id_type& id) {
+    static_assert(sizeof(id) >= kTrxKeySize);
+    return rocksdb::Slice(id.data(), kTrxKeySize);
+}
+
+}  // namespace internal
+
+trx_index::trx_index(const fc::path& dir)
+    : dir_(dir) {
+    using namespace internal;
+
+    if(!fc::is_directory(dir_)) {
+        fc::create_directories(dir_);
+    }
+
+    auto options = rocksdb::Options();
+    options.create_if_missing = true;
+    options.OptimizeForPointLookup(kPointLookupMB);
+    options.compression = rocksdb::CompressionType::kNoCompression;  // ids cannot be compressed
+
+    check_status(rocksdb::DB::Open(options, dir_.to_native_ansi_path(), &db_));
+
+    auto value = std::string();
+    auto s     = db_->Get(rocksdb::ReadOptions(), kLastNumKey, &value);
+    if(s.ok()) {
+        EVT_ASSERT(value.size() == sizeof(last_num_), block_log_exception, "Transaction index is corrupted");
+        memcpy(&last_num_, value.data(), sizeof(last_num_));
+    }
+    else if(!s.IsNotFound()) {
+        check_status(s);
+    }
+}
+
+trx_index::~trx_index() {
+    delete db_;
+}
+
+void
+trx_index::add(const signed_block& b) {
+    using namespace internal;
+
+    auto num = b.block_num();
+    if(num <= last_num_) {
+        return;
+    }
+
+    auto batch = rocksdb::WriteBatch();
+    for(auto i = 0u; i < b.transactions.size(); i++) {
+        auto loc = location{ num, i };
+        batch.Put(trx_key(b.transactions[i].trx.id()), rocksdb::Slice((const char*)&loc, sizeof(loc)));
+    }
+    batch.Put(kLastNumKey, rocksdb::Slice((const char*)&num, sizeof(num)));
+
+    // index is rebuilt from block log if it's lost, no need to sync
+    check_status(db_->Write(rocksdb::WriteOptions(), &batch));
+    last_num_ = num;
+}
+
+std::optional<trx_index::location>
+trx_index::find(const transaction_id_type& id) const {
+    using namespace internal;
+
+    auto value = std::string();
+    auto s     = db_->Get(rocksdb::ReadOptions(), trx_key(id), &value);
+    if(s.IsNotFound()) {
+        return std::nullopt;
+    }
+    check_status(s);
+
+    auto loc = location();
+    EVT_ASSERT(value.size() == sizeof(loc), block_log_exception, "Transaction index is corrupted");
+    memcpy(&loc, value.data(), sizeof(loc));
+    return loc;
+}
+
+}}  // namespace evt::chain
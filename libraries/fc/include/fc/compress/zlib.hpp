@@ -5,4 +5,7 @@ namespace fc {
 
 string zlib_compress(const string& in);
 
+// deflate wrapped in a gzip member (RFC 1952), as used by `Content-Encoding: gzip`
+string gzip_compress(const string& in);
+
 }  // namespace fc
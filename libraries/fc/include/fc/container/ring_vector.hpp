@@ -1,5 +1,7 @@
 
 #pragma once
+#include <utility>
+#include <vector>
 
 namespace fc {
 
@@ -28,6 +30,18 @@ public:
         }
     }
 
+    void
+    push_back(T&& item) {
+        buf_[tail_] = std::move(item);
+
+        if(++tail_ >= capacity_) {
+            tail_ = 0;
+        }
+        if(head_ == tail_) {
+            expand();
+        }
+    }
+
     void
     pop_front() {
         assert(head_ != tail_);
@@ -106,7 +120,7 @@ private:
         auto new_vec = std::vector<T>();
         new_vec.resize(capacity_ * 2);
         for(auto i = 0u; i < capacity_; i++) {
-            new_vec[i] = buf_[(head_ + i) % capacity_];
+            new_vec[i] = std::move(buf_[(head_ + i) % capacity_]);
         }
 
         head_      = 0;
@@ -1,5 +1,6 @@
 #pragma once
 #include <fc/variant.hpp>
+#include <fc/exception/exception.hpp>
 #include <fc/container/small_vector_fwd.hpp>
 #include <fc/io/raw_fwd.hpp>
 
@@ -41,6 +41,14 @@ public:
     public_key(const public_key_point_data& v);
     public_key(const compact_signature& c, const fc::sha256& digest, bool check_canonical = true);
 
+    /**
+     * Recovers the serialized keys of `n` signatures over the same digest into `keys`, without
+     * building the keys. The work depending only on the digest is done once and the r values of
+     * all the signatures are inverted together.
+     */
+    static void            recover_data(const compact_signature* const* sigs, size_t n, const fc::sha256& digest, public_key_data* keys);
+    static public_key_data recover_data(const compact_signature& c, const fc::sha256& digest);
+
     bool       valid() const;
     public_key mult(const fc::sha256& offset);
     public_key add(const fc::sha256& offset) const;
@@ -136,7 +144,7 @@ struct signature_shim : public crypto::shim<compact_signature> {
     using crypto::shim<compact_signature>::shim;
 
     public_key_type recover(const sha256& digest, bool check_canonical) const {
-        return public_key_type(public_key(_data, digest, check_canonical).serialize());
+        return public_key_type(public_key::recover_data(_data, digest));
     }
 };
 
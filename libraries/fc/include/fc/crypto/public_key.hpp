@@ -28,6 +28,12 @@ public:
 
     bool valid() const;
 
+    /**
+     * Recovers the keys of `n` signatures over the same digest into `keys`, a signature repeated
+     * within the batch is recovered only once and the r1 signatures are recovered together.
+     */
+    static void recover_keys(const signature* sigs, size_t n, const sha256& digest, public_key* keys, bool check_canonical = true);
+
     // serialize to/from string
     explicit public_key(const string& base58str);
     explicit public_key(const char* base58str);
@@ -54,6 +60,14 @@ private:
 namespace fc {
 void to_variant(const crypto::public_key& var, variant& vo);
 void from_variant(const variant& var, crypto::public_key& vo);
+
+namespace raw {
+
+// one byte of variant index followed by the 33 bytes of the compressed key, same for both curves
+template<>
+struct fixed_pack_size<crypto::public_key> : std::integral_constant<size_t, 34> {};
+
+}  // namespace raw
 }  // namespace fc
 
 FC_REFLECT(fc::crypto::public_key, (_storage));
@@ -24,6 +24,12 @@ public:
     static sha256 hash(const string&);
     static sha256 hash(const sha256&);
 
+    /**
+     * Hashes `n` inputs of `size` bytes each, laid out one after another from `data`, into `out`.
+     * OpenSSL picks the SHA-NI or AVX2 code path for the running CPU on its own.
+     */
+    static void hash_many(const char* data, size_t size, size_t n, sha256* out);
+
     template<typename T>
     static sha256 hash(const T& t) {
         sha256::encoder e;
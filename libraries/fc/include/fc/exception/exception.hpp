@@ -364,7 +364,7 @@ extern bool enable_record_assert_trip;
     EXCEPTION_TYPE(FC_LOG_MESSAGE(error, FORMAT, __VA_ARGS__))
 
 #define FC_EXCEPTION2(EXCEPTION_TYPE, FORMAT, ...) \
-    EXCEPTION_TYPE(FC_LOG_MESSAGE2(error, FORMAT, ##__VA_ARGS__))
+    EXCEPTION_TYPE(FC_LAZY_LOG_MESSAGE2(error, FORMAT, ##__VA_ARGS__))
 
 /**
  *  @def FC_THROW_EXCEPTION( EXCEPTION, FORMAT, ... )
@@ -376,9 +376,9 @@ extern bool enable_record_assert_trip;
     throw EXCEPTION(FC_LOG_MESSAGE(error, FORMAT, __VA_ARGS__)); \
     FC_MULTILINE_MACRO_END
 
-#define FC_THROW_EXCEPTION2(EXCEPTION, FORMAT, ...)                 \
-    FC_MULTILINE_MACRO_BEGIN                                        \
-    throw EXCEPTION(FC_LOG_MESSAGE2(error, FORMAT, ##__VA_ARGS__)); \
+#define FC_THROW_EXCEPTION2(EXCEPTION, FORMAT, ...)                      \
+    FC_MULTILINE_MACRO_BEGIN                                             \
+    throw EXCEPTION(FC_LAZY_LOG_MESSAGE2(error, FORMAT, ##__VA_ARGS__)); \
     FC_MULTILINE_MACRO_END
 
 /**
@@ -391,10 +391,10 @@ extern bool enable_record_assert_trip;
     throw;                                                         \
     FC_MULTILINE_MACRO_END
 
-#define FC_RETHROW_EXCEPTION2(ER, LOG_LEVEL, FORMAT, ...)             \
-    FC_MULTILINE_MACRO_BEGIN                                          \
-    ER.append_log(FC_LOG_MESSAGE2(LOG_LEVEL, FORMAT, ##__VA_ARGS__)); \
-    throw;                                                            \
+#define FC_RETHROW_EXCEPTION2(ER, LOG_LEVEL, FORMAT, ...)                  \
+    FC_MULTILINE_MACRO_BEGIN                                               \
+    ER.append_log(FC_LAZY_LOG_MESSAGE2(LOG_LEVEL, FORMAT, ##__VA_ARGS__)); \
+    throw;                                                                 \
     FC_MULTILINE_MACRO_END
 
 #define FC_LOG_AND_RETHROW()                                               \
@@ -538,28 +538,28 @@ extern bool enable_record_assert_trip;
             std::current_exception());                                                    \
     }
 
-#define FC_RETHROW_EXCEPTIONS2(LOG_LEVEL, FORMAT, ...)                          \
-    catch(const boost::interprocess::bad_alloc&) {                              \
-        throw;                                                                  \
-    }                                                                           \
-    catch(const fc::unrecoverable_exception&) {                                 \
-        throw;                                                                  \
-    }                                                                           \
-    catch(fc::exception & er) {                                                 \
-        FC_RETHROW_EXCEPTION2(er, LOG_LEVEL, FORMAT, ##__VA_ARGS__);            \
-    }                                                                           \
-    catch(const std::exception& e) {                                            \
-        fc::exception fce(                                                      \
-            FC_LOG_MESSAGE2(LOG_LEVEL, "{}: " FORMAT, e.what(), ##__VA_ARGS__), \
-            fc::std_exception_code,                                             \
-            BOOST_CORE_TYPEID(e).name(),                                        \
-            e.what());                                                          \
-        throw fce;                                                              \
-    }                                                                           \
-    catch(...) {                                                                \
-        throw fc::unhandled_exception(                                          \
-            FC_LOG_MESSAGE2(LOG_LEVEL, FORMAT, ##__VA_ARGS__),                  \
-            std::current_exception());                                          \
+#define FC_RETHROW_EXCEPTIONS2(LOG_LEVEL, FORMAT, ...)                               \
+    catch(const boost::interprocess::bad_alloc&) {                                   \
+        throw;                                                                       \
+    }                                                                                \
+    catch(const fc::unrecoverable_exception&) {                                      \
+        throw;                                                                       \
+    }                                                                                \
+    catch(fc::exception & er) {                                                      \
+        FC_RETHROW_EXCEPTION2(er, LOG_LEVEL, FORMAT, ##__VA_ARGS__);                 \
+    }                                                                                \
+    catch(const std::exception& e) {                                                 \
+        fc::exception fce(                                                           \
+            FC_LAZY_LOG_MESSAGE2(LOG_LEVEL, "{}: " FORMAT, e.what(), ##__VA_ARGS__), \
+            fc::std_exception_code,                                                  \
+            BOOST_CORE_TYPEID(e).name(),                                             \
+            e.what());                                                               \
+        throw fce;                                                                   \
+    }                                                                                \
+    catch(...) {                                                                     \
+        throw fc::unhandled_exception(                                               \
+            FC_LAZY_LOG_MESSAGE2(LOG_LEVEL, FORMAT, ##__VA_ARGS__),                  \
+            std::current_exception());                                               \
     }
 
 #define FC_CAPTURE_AND_RETHROW(...)                                                                 \
@@ -38,6 +38,9 @@ public:
     static string   to_string(const variant& v, output_formatting format = rapidjson_generator);
     static string   to_pretty_string(const variant& v, output_formatting format = rapidjson_generator);
 
+    // same as to_string(from_string(utf8_str)) for the objects without duplicated keys, without building the variant
+    static string minify(const string& utf8_str);
+
     static bool is_valid(const std::string& json_str, parse_type ptype = rapidjson_parser, uint32_t max_depth = DEFAULT_MAX_RECURSION_DEPTH);
 
     template<typename T>
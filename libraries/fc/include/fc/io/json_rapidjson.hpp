@@ -11,6 +11,8 @@
 #include <fc/static_variant.hpp>
 #include <rapidjson/document.h>
 #include <rapidjson/reader.h>
+#include <rapidjson/memorystream.h>
+#include <rapidjson/stringbuffer.h>
 #include <rapidjson/writer.h>
 #include <rapidjson/prettywriter.h>
 #include <rapidjson/istreamwrapper.h>
@@ -204,26 +206,64 @@ private:
 
 }  // namespace internal
 
+namespace internal {
+
+template<unsigned flags = kParseDefaultFlags, typename S, typename H>
+void
+parse(S& ss, H& handler) {
+    Reader reader;
+    if(!reader.Parse<flags>(ss, handler)) {
+        auto e = reader.GetParseErrorCode();
+        FC_THROW_EXCEPTION(parse_error_exception, "Unexpected content, err: ${err}, offset: ${offset}",
+            ("err",GetParseError_En(e))("offset",reader.GetErrorOffset()));
+    }
+}
+
+}  // namespace internal
+
 template<typename T, bool strict>
 variant
 variant_from_stream(T& in, uint32_t max_depth) {
     using namespace internal;
 
     variant var;
-
-    Reader reader;
     VariantHandler handler(var, max_depth);
 
     BasicIStreamWrapper<T> ss(in);
-    if(!reader.Parse(ss, handler)) {
-        auto e = reader.GetParseErrorCode();
-        FC_THROW_EXCEPTION(parse_error_exception, "Unexpected content, err: ${err}, offset: ${offset}",
-            ("err",GetParseError_En(e))("offset",reader.GetErrorOffset()));
-    }
+    parse(ss, handler);
+
+    return var;
+}
+
+// reads the memory of the string in place instead of copying it into a stream first
+inline variant
+variant_from_string(const std::string& str, uint32_t max_depth) {
+    using namespace internal;
+
+    variant var;
+    VariantHandler handler(var, max_depth);
+
+    MemoryStream ms(str.data(), str.size());
+    parse(ms, handler);
 
     return var;
 }
 
+// writes the events of the reader straight back in compact form, no variant is built.
+// parses iteratively so that deep nesting cannot exhaust the stack
+inline std::string
+minify(const std::string& str) {
+    using namespace internal;
+
+    StringBuffer buf;
+    Writer<StringBuffer> writer(buf);
+
+    MemoryStream ms(str.data(), str.size());
+    parse<kParseIterativeFlag>(ms, writer);
+
+    return std::string(buf.GetString(), buf.GetSize());
+}
+
 namespace internal {
 
 template<typename W>
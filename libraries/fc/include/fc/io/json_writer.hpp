@@ -0,0 +1,229 @@
+#pragma once
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include <fc/container/small_vector.hpp>
+#include <fc/reflect/reflect.hpp>
+#include <fc/reflect/variant.hpp>
+#include <fc/variant.hpp>
+
+namespace fc {
+
+/**
+ * Marks a reflected type whose json form is exactly its reflected members,
+ * json_writer then streams it field by field without building a variant.
+ * Never mark a type that has its own to_variant.
+ */
+template<typename T>
+struct json_reflected : std::false_type {};
+
+/**
+ * Streams values as json into a reusable buffer.
+ *
+ * The output is the same as `fc::json::to_string(fc::variant(v))`.
+ * Marked reflected types and the vectors of them are written directly,
+ * any other type is converted to a variant first.
+ */
+class json_writer {
+public:
+    json_writer() = default;
+
+public:
+    void
+    clear() {
+        buffer_.clear();
+        levels_.clear();
+        after_key_ = false;
+    }
+
+    const std::string& str() const { return buffer_; }
+    std::string release() { auto s = std::move(buffer_); clear(); return s; }
+
+    void
+    begin_object() {
+        separate();
+        buffer_.push_back('{');
+        levels_.push_back(false);
+    }
+
+    void
+    end_object() {
+        levels_.pop_back();
+        buffer_.push_back('}');
+    }
+
+    void
+    begin_array() {
+        separate();
+        buffer_.push_back('[');
+        levels_.push_back(false);
+    }
+
+    void
+    end_array() {
+        levels_.pop_back();
+        buffer_.push_back(']');
+    }
+
+    void
+    key(std::string_view k) {
+        separate();
+        append_string(k);
+        buffer_.push_back(':');
+        after_key_ = true;
+    }
+
+    template<typename T>
+    void
+    write_member(std::string_view k, const T& v) {
+        key(k);
+        write(v);
+    }
+
+    // writes the members of a reflected value into the current object
+    template<typename T>
+    void
+    write_members(const T& v) {
+        fc::reflector<T>::visit(member_visitor<T>(*this, v));
+    }
+
+    // writes only the members whose names satisfy `pred`
+    template<typename T, typename Pred>
+    void
+    write_members(const T& v, const Pred& pred) {
+        fc::reflector<T>::visit(member_visitor<T, Pred>(*this, v, &pred));
+    }
+
+    void write(const variant& v);
+    void write(const std::string& v) { separate(); append_string(v); }
+    void write(const char* v) { separate(); append_string(v); }
+    void write(bool v) { separate(); buffer_.append(v ? "true" : "false"); }
+
+    // appends an already serialized json value
+    void write_raw(std::string_view json) { separate(); buffer_.append(json); }
+
+    template<typename T>
+    void
+    write(const T& v) {
+        if constexpr(std::is_integral_v<T> && std::is_signed_v<T>) {
+            separate();
+            buffer_.append(std::to_string((int64_t)v));
+        }
+        else if constexpr(std::is_integral_v<T>) {
+            separate();
+            buffer_.append(std::to_string((uint64_t)v));
+        }
+        else if constexpr(json_reflected<T>::value) {
+            begin_object();
+            write_members(v);
+            end_object();
+        }
+        else {
+            write(variant(v));
+        }
+    }
+
+    template<typename T>
+    void
+    write(const std::optional<T>& v) {
+        if(v.has_value()) {
+            write(*v);
+        }
+        else {
+            write(variant());
+        }
+    }
+
+    template<typename T>
+    void
+    write(const std::vector<T>& v) {
+        if constexpr(std::is_same_v<T, char>) {
+            write(variant(v));
+        }
+        else {
+            write_array(v);
+        }
+    }
+
+    template<typename T, std::size_t N>
+    void
+    write(const small_vector<T, N>& v) {
+        write_array(v);
+    }
+
+private:
+    template<typename T, typename Pred = std::nullptr_t>
+    class member_visitor {
+    public:
+        member_visitor(json_writer& w, const T& v, const Pred* pred = nullptr)
+            : w(w)
+            , val(v)
+            , pred(pred) {}
+
+        template<typename Member, class Class, Member(Class::*member)>
+        void
+        operator()(const char* name) const {
+            if constexpr(!std::is_same_v<Pred, std::nullptr_t>) {
+                if(!(*pred)(std::string_view(name))) {
+                    return;
+                }
+            }
+            this->add(name, (val.*member));
+        }
+
+    private:
+        // empty optional members are left out, same as to_variant
+        template<typename M>
+        void
+        add(const char* name, const std::optional<M>& v) const {
+            if(v.has_value()) {
+                w.write_member(name, *v);
+            }
+        }
+
+        template<typename M>
+        void add(const char* name, const M& v) const { w.write_member(name, v); }
+
+        json_writer& w;
+        const T&     val;
+        const Pred*  pred;
+    };
+
+    template<typename C>
+    void
+    write_array(const C& c) {
+        begin_array();
+        for(auto& e : c) {
+            write(e);
+        }
+        end_array();
+    }
+
+    void
+    separate() {
+        if(after_key_) {
+            after_key_ = false;
+            return;
+        }
+        if(!levels_.empty()) {
+            if(levels_.back()) {
+                buffer_.push_back(',');
+            }
+            levels_.back() = true;
+        }
+    }
+
+    void append_string(std::string_view s);
+
+private:
+    std::string       buffer_;
+    std::vector<bool> levels_;  // whether current object or array already has an element
+    bool              after_key_ = false;
+};
+
+}  // namespace fc
+
+#define FC_JSON_REFLECTED(TYPE) \
+    namespace fc { template<> struct json_reflected<TYPE> : std::true_type {}; }
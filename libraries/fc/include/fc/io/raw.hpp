@@ -331,9 +331,15 @@ unpack(Stream& s, std::optional<T>& v) {
         bool b;
         fc::raw::unpack(s, b);
         if(b) {
-            v = T();
+            // unpack into the existing value to reuse its buffers
+            if(!v.has_value()) {
+                v.emplace();
+            }
             fc::raw::unpack(s, *v);
         }
+        else {
+            v.reset();
+        }
     }
     FC_RETHROW_EXCEPTIONS(warn, "optional<${type}>", ("type", fc::get_typename<T>::name()))
 }
@@ -546,16 +552,27 @@ struct if_reflected {
     }
 };
 
+// custom packer of a reflected type takes precedence over its fields, used by fixed-layout types
 template<>
 struct if_reflected<fc::true_type> {
     template<typename Stream, typename T>
     static inline void pack(Stream& s, const T& v) {
-        if_enum<typename fc::reflector<T>::is_enum>::pack(s, v);
+        if constexpr(has_custom_function<T>()) {
+            packer<T>::pack(s, v);
+        }
+        else {
+            if_enum<typename fc::reflector<T>::is_enum>::pack(s, v);
+        }
     }
 
     template<typename Stream, typename T>
     static inline void unpack(Stream& s, T& v) {
-        if_enum<typename fc::reflector<T>::is_enum>::unpack(s, v);
+        if constexpr(has_custom_function<T>()) {
+            unpacker<T>::unpack(s, v);
+        }
+        else {
+            if_enum<typename fc::reflector<T>::is_enum>::unpack(s, v);
+        }
     }
 };
 
@@ -770,6 +787,7 @@ unpack(Stream& s, std::set<T>& value) {
     unsigned_int size;
     fc::raw::unpack(s, size);
     FC_ASSERT(size.value <= MAX_NUM_ARRAY_ELEMENTS);
+    value.clear();
     for(uint64_t i = 0; i < size.value; ++i) {
         T tmp;
         fc::raw::unpack(s, tmp);
@@ -824,12 +842,123 @@ unpack(Stream& s, T& v) {
     FC_RETHROW_EXCEPTIONS(warn, "error unpacking ${type}", ("type", fc::get_typename<T>::name()))
 }
 
+namespace detail {
+
+template<typename T>
+struct is_std_optional : std::false_type {};
+
+template<typename T>
+struct is_std_optional<std::optional<T>> : std::true_type {};
+
+template<typename Stream>
+inline void
+skip_bytes(Stream& s, size_t n) {
+    FC_ASSERT(s.remaining() >= n, "Cannot skip ${n} bytes, only ${r} remaining", ("n", n)("r", s.remaining()));
+    s.skip(n);
+}
+
+template<typename Stream>
+struct skip_object_visitor {
+    template<typename T, typename C, T(C::*p)>
+    inline void operator()(const char* name) const {
+        fc::raw::skip<T>(s);
+    }
+
+    Stream& s;
+};
+
+template<typename Stream, typename Class, typename Pred>
+struct unpack_members_visitor {
+    template<typename T, typename C, T(C::*p)>
+    inline void operator()(const char* name) const {
+        try {
+            if(pred(std::string_view(name))) {
+                fc::raw::unpack(s, obj.*p);
+            }
+            else {
+                fc::raw::skip<T>(s);
+            }
+        }
+        FC_RETHROW_EXCEPTIONS(warn, "Error unpacking field ${field}", ("field", name))
+    }
+
+    Class&  obj;
+    Stream& s;
+    Pred&   pred;
+};
+
+}  // namespace detail
+
+/**
+ * Moves the stream past a packed `T` without keeping it. Fixed-size values, strings and sequences
+ * of fixed-size values are skipped without reading them, other sequences and reflected types are
+ * walked element by element and member by member, and anything else is unpacked into a temporary.
+ */
+template<typename T, typename Stream>
+inline void
+skip(Stream& s) {
+    if constexpr(fixed_pack_size_v<T> > 0) {
+        detail::skip_bytes(s, fixed_pack_size_v<T>);
+    }
+    else if constexpr(std::is_same_v<T, std::string>) {
+        auto size = unsigned_int();
+        fc::raw::unpack(s, size);
+        detail::skip_bytes(s, size.value);
+    }
+    else if constexpr(packed_sequence<T>::value) {
+        using element_type = typename T::value_type;
+
+        auto size = unsigned_int();
+        fc::raw::unpack(s, size);
+        FC_ASSERT(size.value <= MAX_NUM_ARRAY_ELEMENTS);
+        if constexpr(fixed_pack_size_v<element_type> > 0) {
+            detail::skip_bytes(s, (size_t)size.value * fixed_pack_size_v<element_type>);
+        }
+        else {
+            for(auto i = 0u; i < size.value; i++) {
+                fc::raw::skip<element_type>(s);
+            }
+        }
+    }
+    else if constexpr(detail::is_std_optional<T>::value) {
+        bool b;
+        fc::raw::unpack(s, b);
+        if(b) {
+            fc::raw::skip<typename T::value_type>(s);
+        }
+    }
+    else if constexpr(fc::reflector<T>::is_defined::value && !fc::reflector<T>::is_enum::value && !has_custom_function<T>()) {
+        fc::reflector<T>::visit(detail::skip_object_visitor<Stream>{ s });
+    }
+    else {
+        T tmp;
+        fc::raw::unpack(s, tmp);
+    }
+}
+
+/**
+ * Unpacks only the members of a reflected `v` whose names satisfy `pred`, the other members are
+ * skipped and left as they are. Large members nobody asked for are never decoded.
+ */
+template<typename Stream, typename T, typename Pred>
+inline void
+unpack_members(Stream& s, T& v, Pred&& pred) {
+    static_assert(fc::reflector<T>::is_defined::value && !fc::reflector<T>::is_enum::value && !has_custom_function<T>(),
+                  "only the types packed member by member can be partially unpacked");
+    fc::reflector<T>::visit(detail::unpack_members_visitor<Stream, T, std::remove_reference_t<Pred>>{ v, s, pred });
+}
+
 template<typename T>
 inline size_t
 pack_size(const T& v) {
-    datastream<size_t> ps;
-    fc::raw::pack(ps, v);
-    return ps.tellp();
+    if constexpr(fixed_pack_size_v<T> > 0) {
+        return fixed_pack_size_v<T>;
+    }
+    else {
+        datastream<size_t> ps;
+        fc::raw::pack(ps, v);
+        return ps.tellp();
+    }
 }
 
 template<typename T>
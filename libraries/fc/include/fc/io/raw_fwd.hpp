@@ -4,6 +4,7 @@
 #include <map>
 #include <set>
 #include <string>
+#include <type_traits>
 #include <unordered_map>
 #include <unordered_set>
 #include <variant>
@@ -52,6 +53,31 @@ namespace raw {
 template<typename T>
 inline size_t pack_size(const T& v);
 
+// packed size of the types whose layout never depends on the value, 0 for the others.
+// pack_size() returns it directly instead of walking the fields
+template<typename T>
+struct fixed_pack_size : std::integral_constant<size_t, std::is_arithmetic_v<T> ? sizeof(T) : 0> {};
+
+template<typename T, std::size_t S>
+struct fixed_pack_size<std::array<T, S>>
+    : std::integral_constant<size_t, std::is_trivially_copyable_v<T> ? sizeof(T) * S : fixed_pack_size<T>::value * S> {};
+
+template<typename T>
+constexpr size_t fixed_pack_size_v = fixed_pack_size<T>::value;
+
+// containers packed as the number of their elements followed by the elements, see `skip`
+template<typename T>
+struct packed_sequence : std::false_type {};
+
+template<typename T, typename A>
+struct packed_sequence<std::vector<T, A>> : std::true_type {};
+
+template<typename T, std::size_t N>
+struct packed_sequence<small_vector<T, N>> : std::true_type {};
+
+template<typename T, typename Stream>
+inline void skip(Stream& s);
+
 template<typename Stream, typename Storage>
 inline void pack(Stream& s, const fc::fixed_string<Storage>& u);
 template<typename Stream, typename Storage>
@@ -3,7 +3,12 @@
  * @file log_message.hpp
  * @brief Defines types and helper macros necessary for generating log messages.
  */
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
 #include <boost/preprocessor/punctuation/comma_if.hpp>
 #include <boost/preprocessor/variadic/size.hpp>
 #include <fmt/core.h>
@@ -81,6 +86,57 @@ public:
 void to_variant(const log_context& l, variant& v);
 void from_variant(const variant& l, log_context& c);
 
+namespace detail {
+
+/**
+ *  @brief message formatted only when it's first read, copies of the log message share it.
+ *
+ *  Exceptions thrown on failure paths usually get caught and dropped without ever being
+ *  printed, so their messages are not worth formatting up front.
+ */
+class lazy_format {
+public:
+    explicit lazy_format(std::function<std::string()>&& fn)
+        : fn_(std::move(fn)) {}
+
+public:
+    const std::string&
+    get() const {
+        std::call_once(once_, [this] {
+            message_ = fn_();
+            fn_      = nullptr;
+        });
+        return message_;
+    }
+
+private:
+    mutable std::once_flag               once_;
+    mutable std::function<std::string()> fn_;
+    mutable std::string                  message_;
+};
+
+// arguments are kept by value until formatted, strings pointed to may be gone by then
+template <typename T>
+auto
+lazy_format_arg(T&& v) {
+    if constexpr(std::is_convertible_v<T, std::string_view>) {
+        return std::string(std::string_view(v));
+    }
+    else {
+        return std::decay_t<T>(std::forward<T>(v));
+    }
+}
+
+template <typename Fn, typename... Args>
+std::shared_ptr<const lazy_format>
+make_lazy_format(Fn fn, Args&&... args) {
+    return std::make_shared<lazy_format>([fn, args = std::make_tuple(lazy_format_arg(std::forward<Args>(args))...)] {
+        return std::apply(fn, args);
+    });
+}
+
+}  // namespace detail
+
 /**
  *  @brief aggregates a message along with the context and associated meta-information.
  *  @ingroup AthenaSerializable
@@ -123,10 +179,16 @@ public:
         : context(ctx)
         , format(message) {}
 
+    log_message(log_context&& ctx, std::shared_ptr<const detail::lazy_format>&& lazy)
+        : context(std::move(ctx))
+        , lazy(std::move(lazy)) {}
+
     log_message(const variant& v);
 
     variant to_variant() const;
     string  get_message() const;
+    // format of the message, a lazily formatted message is formatted here
+    const std::string& get_format() const { return lazy ? lazy->get() : format; }
     /**
      * A faster version of get_message which does limited formatting and excludes large variants
      * @return formatted message according to format and variant args
@@ -135,8 +197,11 @@ public:
 
 public:
     log_context    context;
-    std::string    format;
     variant_object args;
+
+private:
+    std::string                              format;
+    std::shared_ptr<const detail::lazy_format> lazy;
 };
 
 void to_variant(const log_message& l, variant& v);
@@ -175,3 +240,15 @@ FC_REFLECT_TYPENAME(fc::log_message);
 
 #define FC_LOG_MESSAGE2(LOG_LEVEL, FORMAT, ...) \
     fc::log_message(FC_LOG_CONTEXT(LOG_LEVEL), fmt::format(FORMAT, ##__VA_ARGS__))
+
+/**
+ * @def FC_LAZY_LOG_MESSAGE2(LOG_LEVEL,FORMAT,...)
+ *
+ * @brief Same as FC_LOG_MESSAGE2 but the arguments are copied and formatted only when the
+ *        message is read, used by the exceptions thrown on failure paths.
+ */
+#define FC_LAZY_LOG_MESSAGE2(LOG_LEVEL, FORMAT, ...)                                              \
+    fc::log_message(FC_LOG_CONTEXT(LOG_LEVEL),                                                    \
+                    fc::detail::make_lazy_format(                                                 \
+                        [](const auto&... fmt_args) { return fmt::format(FORMAT, fmt_args...); }, \
+                        ##__VA_ARGS__))
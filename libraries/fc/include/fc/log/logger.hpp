@@ -8,6 +8,7 @@
 namespace fc {
 
 class appender;
+namespace internal { class async_sink; }
 using appender_vec = fc::small_vector<std::shared_ptr<appender>, 4>;
 
 /**
@@ -50,6 +51,19 @@ public:
     bool is_enabled(log_level e) const;
     void log(log_message m);
 
+    // hands the messages to a background thread through a ring of `queue_size` records
+    // instead of writing them on the calling thread, 0 switches back to synchronous logging.
+    // messages are dropped and counted when the ring is full
+    static void     set_async(uint32_t queue_size);
+    static void     flush();
+    static uint64_t dropped_messages();
+
+private:
+    // writes to the appenders on the current thread
+    void dispatch(log_message m);
+
+    friend class internal::async_sink;
+
 private:
     class impl;
     std::shared_ptr<impl> my;
@@ -40,6 +40,8 @@ struct logging_config {
     std::vector<string>          includes;
     std::vector<appender_config> appenders;
     std::vector<logger_config>   loggers;
+    /// records queued for the background logging thread, 0 logs on the calling thread
+    uint32_t                     async_queue_size = 0;
 };
 
 void configure_logging(const fc::path& log_config);
@@ -53,4 +55,4 @@ const string& get_thread_name();
 #include <fc/reflect/reflect.hpp>
 FC_REFLECT(fc::appender_config, (name)(type)(args)(enabled));
 FC_REFLECT(fc::logger_config, (name)(parent)(level)(enabled)(additivity)(appenders));
-FC_REFLECT(fc::logging_config, (includes)(appenders)(loggers));
+FC_REFLECT(fc::logging_config, (includes)(appenders)(loggers)(async_queue_size));
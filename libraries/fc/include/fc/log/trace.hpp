@@ -0,0 +1,62 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <boost/preprocessor/cat.hpp>
+
+namespace fc { namespace trace {
+
+namespace internal {
+
+extern std::atomic<bool> enabled;
+
+int64_t now_ns();
+void    record(const char* category, const char* name, int64_t start_ns, int64_t end_ns);
+
+}  // namespace internal
+
+inline bool
+enabled() {
+    return internal::enabled.load(std::memory_order_relaxed);
+}
+
+// spans of each thread are kept in its own buffer, which holds at most `max_events_per_thread` spans
+// until the next `start`, the spans after it are dropped
+void start(size_t max_events_per_thread = 1024 * 1024);
+void stop();
+
+// writes the recorded spans in the trace event format of chrome://tracing and Perfetto
+// returns the number of spans written
+size_t export_json(std::ostream& out);
+
+/**
+ * Records the span from its construction to its destruction when tracing is on,
+ * `category` and `name` should be string literals, they are kept by pointer.
+ * It's a single relaxed load when tracing is off.
+ */
+class scoped_span {
+public:
+    scoped_span(const char* category, const char* name)
+        : category_(category)
+        , name_(name)
+        , start_(enabled() ? internal::now_ns() : -1) {}
+
+    ~scoped_span() {
+        if(start_ >= 0) {
+            internal::record(category_, name_, start_, internal::now_ns());
+        }
+    }
+
+    scoped_span(const scoped_span&) = delete;
+    scoped_span& operator=(const scoped_span&) = delete;
+
+private:
+    const char* category_;
+    const char* name_;
+    int64_t     start_;
+};
+
+}}  // namespace fc::trace
+
+#define FC_TRACE_SPAN(CATEGORY, NAME) \
+    fc::trace::scoped_span BOOST_PP_CAT(_fc_trace_span_, __LINE__)(CATEGORY, NAME)
@@ -11,609 +11,194 @@
 // - E-mail usually won't line-break if there's no punctuation to break at.
 // - Doubleclicking selects the whole number as one word if it's all alphanumeric.
 //
-#ifndef BITCOIN_BASE58_H
-#define BITCOIN_BASE58_H
-
+#include <string.h>
+#include <algorithm>
 #include <string>
 #include <vector>
-#include <limits>
-#include <algorithm>
-#include <string.h>
 
-#include <fc/log/logger.hpp>
 #include <fc/string.hpp>
 #include <fc/exception/exception.hpp>
+#include <fc/container/small_vector.hpp>
 
-#include <stdexcept>
-#include <vector>
-#include <openssl/bn.h>
-
-/** Errors thrown by the bignum class */
-class bignum_error : public std::runtime_error {
-public:
-    explicit bignum_error(const std::string& str)
-        : std::runtime_error(str) {}
-};
+namespace fc {
 
-/** RAII encapsulated BN_CTX (OpenSSL bignum context) */
-class CAutoBN_CTX {
-protected:
-    BN_CTX* pctx;
-    BN_CTX* operator=(BN_CTX* pnew) { return pctx = pnew; }
+namespace internal {
 
-public:
-    CAutoBN_CTX() {
-        pctx = BN_CTX_new();
-        if(pctx == NULL)
-            throw bignum_error("CAutoBN_CTX : BN_CTX_new() returned NULL");
-    }
-
-    ~CAutoBN_CTX() {
-        if(pctx != NULL)
-            BN_CTX_free(pctx);
-    }
+static const char* pszBase58 = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
 
-    operator BN_CTX*() { return pctx; }
-    BN_CTX&  operator*() { return *pctx; }
-    BN_CTX** operator&() { return &pctx; }
-    bool     operator!() { return (pctx == NULL); }
+static const int8_t mapBase58[256] = {
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1, 0, 1, 2, 3, 4, 5, 6, 7, 8,-1,-1,-1,-1,-1,-1,
+    -1, 9,10,11,12,13,14,15,16,-1,17,18,19,20,21,-1,
+    22,23,24,25,26,27,28,29,30,31,32,-1,-1,-1,-1,-1,
+    -1,33,34,35,36,37,38,39,40,41,42,43,-1,44,45,46,
+    47,48,49,50,51,52,53,54,55,56,57,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
 };
 
-/** C++ wrapper for BIGNUM (OpenSSL bignum) */
-class CBigNum {
-    BIGNUM* bn;
-
-public:
-    CBigNum()
-        : bn(BN_new()) {}
-
-    CBigNum(const CBigNum& b)
-        : CBigNum() {
-        if(!BN_copy(bn, b.bn)) {
-            BN_clear_free(bn);
-            throw bignum_error("CBigNum::CBigNum(const CBigNum&) : BN_copy failed");
-        }
-    }
-
-    CBigNum& operator=(const CBigNum& b) {
-        if(!BN_copy(bn, b.bn))
-            throw bignum_error("CBigNum::operator= : BN_copy failed");
-        return (*this);
-    }
-
-    ~CBigNum() {
-        BN_clear_free(bn);
-    }
-
-    //CBigNum(char n) is not portable.  Use 'signed char' or 'unsigned char'.
-    CBigNum(signed char n)
-        : CBigNum() {
-        if(n >= 0)
-            setulong(n);
-        else
-            setint64(n);
-    }
-    CBigNum(short n)
-        : CBigNum() {
-        if(n >= 0)
-            setulong(n);
-        else
-            setint64(n);
-    }
-    CBigNum(int n)
-        : CBigNum() {
-        if(n >= 0)
-            setulong(n);
-        else
-            setint64(n);
-    }
-    CBigNum(int64_t n)
-        : CBigNum() { setint64(n); }
-    CBigNum(unsigned char n)
-        : CBigNum() { setulong(n); }
-    CBigNum(unsigned short n)
-        : CBigNum() { setulong(n); }
-    CBigNum(unsigned int n)
-        : CBigNum() { setulong(n); }
-    CBigNum(uint64_t n)
-        : CBigNum() { setuint64(n); }
-
-    explicit CBigNum(const std::vector<unsigned char>& vch)
-        : CBigNum() {
-        setvch(vch);
-    }
-
-    void setulong(unsigned long n) {
-        if(!BN_set_word(bn, n))
-            throw bignum_error("CBigNum conversion from unsigned long : BN_set_word failed");
-    }
-
-    unsigned long getulong() const {
-        return BN_get_word(bn);
-    }
-
-    unsigned int getuint() const {
-        return BN_get_word(bn);
-    }
-
-    int getint() const {
-        unsigned long n = BN_get_word(bn);
-        if(!BN_is_negative(bn))
-            return (n > (unsigned long)std::numeric_limits<int>::max() ? std::numeric_limits<int>::max() : n);
-        else
-            return (n > (unsigned long)std::numeric_limits<int>::max() ? std::numeric_limits<int>::min() : -(int)n);
-    }
-
-    void setint64(int64_t n) {
-        unsigned char  pch[sizeof(n) + 6];
-        unsigned char* p         = pch + 4;
-        bool           fNegative = false;
-        if(n < (int64_t)0) {
-            n         = -n;
-            fNegative = true;
-        }
-        bool fLeadingZeroes = true;
-        for(int i = 0; i < 8; i++) {
-            unsigned char c = (n >> 56) & 0xff;
-            n <<= 8;
-            if(fLeadingZeroes) {
-                if(c == 0)
-                    continue;
-                if(c & 0x80)
-                    *p++ = (fNegative ? 0x80 : 0);
-                else if(fNegative)
-                    c |= 0x80;
-                fLeadingZeroes = false;
-            }
-            *p++ = c;
-        }
-        unsigned int nSize = p - (pch + 4);
-        pch[0]             = (nSize >> 24) & 0xff;
-        pch[1]             = (nSize >> 16) & 0xff;
-        pch[2]             = (nSize >> 8) & 0xff;
-        pch[3]             = (nSize)&0xff;
-        BN_mpi2bn(pch, p - pch, bn);
-    }
-
-    void setuint64(uint64_t n) {
-        unsigned char  pch[sizeof(n) + 6];
-        unsigned char* p              = pch + 4;
-        bool           fLeadingZeroes = true;
-        for(int i = 0; i < 8; i++) {
-            unsigned char c = (n >> 56) & 0xff;
-            n <<= 8;
-            if(fLeadingZeroes) {
-                if(c == 0)
-                    continue;
-                if(c & 0x80)
-                    *p++ = 0;
-                fLeadingZeroes = false;
-            }
-            *p++ = c;
-        }
-        unsigned int nSize = p - (pch + 4);
-        pch[0]             = (nSize >> 24) & 0xff;
-        pch[1]             = (nSize >> 16) & 0xff;
-        pch[2]             = (nSize >> 8) & 0xff;
-        pch[3]             = (nSize)&0xff;
-        BN_mpi2bn(pch, p - pch, bn);
-    }
-
-    void setvch(const std::vector<unsigned char>& vch) {
-        std::vector<unsigned char> vch2(vch.size() + 4);
-        unsigned int               nSize = vch.size();
-        // BIGNUM's byte stream format expects 4 bytes of
-        // big endian size data info at the front
-        vch2[0] = (nSize >> 24) & 0xff;
-        vch2[1] = (nSize >> 16) & 0xff;
-        vch2[2] = (nSize >> 8) & 0xff;
-        vch2[3] = (nSize >> 0) & 0xff;
-        // swap data to big endian
-        reverse_copy(vch.begin(), vch.end(), vch2.begin() + 4);
-        BN_mpi2bn(&vch2[0], vch2.size(), bn);
-    }
+// 58^5 is the largest power of 58 below 2^32
+static const uint32_t kBase58Pow5 = 656356768;
 
-    std::vector<unsigned char> getvch() const {
-        unsigned int nSize = BN_bn2mpi(bn, NULL);
-        if(nSize <= 4)
-            return std::vector<unsigned char>();
-        std::vector<unsigned char> vch(nSize);
-        BN_bn2mpi(bn, &vch[0]);
-        vch.erase(vch.begin(), vch.begin() + 4);
-        reverse(vch.begin(), vch.end());
-        return vch;
-    }
+// limbs are kept little endian, enough inline space for keys, signatures and addresses
+using limbs_type = fc::small_vector<uint32_t, 24>;
 
-    CBigNum& SetCompact(unsigned int nCompact) {
-        unsigned int               nSize = nCompact >> 24;
-        std::vector<unsigned char> vch(4 + nSize);
-        vch[3] = nSize;
-        if(nSize >= 1)
-            vch[4] = (nCompact >> 16) & 0xff;
-        if(nSize >= 2)
-            vch[5] = (nCompact >> 8) & 0xff;
-        if(nSize >= 3)
-            vch[6] = (nCompact >> 0) & 0xff;
-        BN_mpi2bn(&vch[0], vch.size(), bn);
-        return *this;
-    }
-
-    unsigned int GetCompact() const {
-        unsigned int               nSize = BN_bn2mpi(bn, NULL);
-        std::vector<unsigned char> vch(nSize);
-        nSize -= 4;
-        BN_bn2mpi(bn, &vch[0]);
-        unsigned int nCompact = nSize << 24;
-        if(nSize >= 1)
-            nCompact |= (vch[4] << 16);
-        if(nSize >= 2)
-            nCompact |= (vch[5] << 8);
-        if(nSize >= 3)
-            nCompact |= (vch[6] << 0);
-        return nCompact;
-    }
-
-    void SetHex(const std::string& str) {
-        // skip 0x
-        const char* psz = str.c_str();
-        while(isspace(*psz))
-            psz++;
-        bool fNegative = false;
-        if(*psz == '-') {
-            fNegative = true;
-            psz++;
+// Encode a byte sequence as a base58-encoded string.
+// The bytes are taken 4 at a time and accumulated into limbs of 5 base58 digits each,
+// instead of dividing a bignum by 58 once per output digit
+inline std::string
+EncodeBase58(const unsigned char* pbegin, const unsigned char* pend) {
+    // Leading zeroes encoded as base58 zeros
+    auto zeros = 0u;
+    while(pbegin != pend && *pbegin == 0) {
+        pbegin++;
+        zeros++;
+    }
+
+    auto len   = (size_t)(pend - pbegin);
+    auto limbs = limbs_type();
+    // every 5 digits of output need more than 3.6 bytes of input
+    limbs.reserve(len * 138 / 100 / 5 + 2);
+
+    auto accumulate = [&limbs](uint64_t mul, uint32_t word) {
+        uint64_t carry = word;
+        for(auto& l : limbs) {
+            carry += (uint64_t)l * mul;
+            l      = (uint32_t)(carry % kBase58Pow5);
+            carry /= kBase58Pow5;
         }
-        if(psz[0] == '0' && tolower(psz[1]) == 'x')
-            psz += 2;
-        while(isspace(*psz))
-            psz++;
-
-        // hex string to bignum
-        static signed char phexdigit[256] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-                                             0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-                                             0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-                                             0, 0, 0, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 0, 0,
-                                             0, 0, 0, 0, 0, 0xa, 0xb, 0xc, 0xd, 0xe, 0xf,
-                                             0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-                                             0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xa, 0xb,
-                                             0xc, 0xd, 0xe, 0xf, 0, 0, 0, 0, 0, 0, 0, 0, 0};
-        *this = 0;
-        while(isxdigit(*psz)) {
-            *this <<= 4;
-            int n = phexdigit[(unsigned char)*psz++];
-            *this += n;
+        while(carry > 0) {
+            limbs.push_back((uint32_t)(carry % kBase58Pow5));
+            carry /= kBase58Pow5;
         }
-        if(fNegative)
-            BN_set_negative(bn, 1);
-    }
-
-    std::string ToString(int nBase = 10) const {
-        CAutoBN_CTX pctx;
-        CBigNum     bnBase = nBase;
-        CBigNum     bn0    = 0;
-        std::string str;
-        CBigNum     bn = *this;
-        BN_set_negative(bn.bn, false);
-        CBigNum dv;
-        CBigNum rem;
-        if(BN_cmp(bn.bn, bn0.bn) == 0)
-            return "0";
-        while(BN_cmp(bn.bn, bn0.bn) > 0) {
-            if(!BN_div(dv.bn, rem.bn, bn.bn, bnBase.bn, pctx))
-                throw bignum_error("CBigNum::ToString() : BN_div failed");
-            bn             = dv;
-            unsigned int c = rem.getulong();
-            str += "0123456789abcdef"[c];
+    };
+
+    // first word takes the bytes left over by the whole words
+    auto head = len % 4;
+    if(head > 0) {
+        auto word = 0u;
+        for(auto i = 0u; i < head; i++) {
+            word = (word << 8) | *pbegin++;
         }
-        if(BN_is_negative(this->bn))
-            str += "-";
-        reverse(str.begin(), str.end());
-        return str;
-    }
-
-    std::string GetHex() const {
-        return ToString(16);
+        accumulate(1ull << (8 * head), word);
     }
-
-    bool operator!() const {
-        return BN_is_zero(bn);
-    }
-
-    CBigNum& operator+=(const CBigNum& b) {
-        if(!BN_add(bn, bn, b.bn))
-            throw bignum_error("CBigNum::operator+= : BN_add failed");
-        return *this;
-    }
-
-    CBigNum& operator-=(const CBigNum& b) {
-        if(!BN_sub(bn, bn, b.bn))
-            throw bignum_error("CBigNum::operator-= : BN_sub failed");
-        return *this;
+    while(pbegin != pend) {
+        auto word = ((uint32_t)pbegin[0] << 24) | ((uint32_t)pbegin[1] << 16) | ((uint32_t)pbegin[2] << 8) | pbegin[3];
+        pbegin += 4;
+        accumulate(1ull << 32, word);
     }
 
-    CBigNum& operator*=(const CBigNum& b) {
-        CAutoBN_CTX pctx;
-        if(!BN_mul(bn, bn, b.bn, pctx))
-            throw bignum_error("CBigNum::operator*= : BN_mul failed");
-        return *this;
-    }
-
-    CBigNum& operator/=(const CBigNum& b) {
-        CAutoBN_CTX pctx;
-        if(!BN_div(bn, NULL, bn, b.bn, pctx))
-            throw bignum_error("CBigNum::operator/= : BN_div failed");
-        return *this;
-    }
-
-    CBigNum& operator%=(const CBigNum& b) {
-        CAutoBN_CTX pctx;
-        if(!BN_div(NULL, bn, bn, b.bn, pctx))
-            throw bignum_error("CBigNum::operator%= : BN_div failed");
-        return *this;
-    }
-
-    CBigNum& operator<<=(unsigned int shift) {
-        if(!BN_lshift(bn, bn, shift))
-            throw bignum_error("CBigNum:operator<<= : BN_lshift failed");
-        return *this;
-    }
-
-    CBigNum& operator>>=(unsigned int shift) {
-        // Note: BN_rshift segfaults on 64-bit if 2^shift is greater than the number
-        //   if built on ubuntu 9.04 or 9.10, probably depends on version of openssl
-        CBigNum a = 1;
-        a <<= shift;
-        if(BN_cmp(a.bn, bn) > 0) {
-            *this = 0;
-            return *this;
+    auto str = std::string(zeros + limbs.size() * 5, pszBase58[0]);
+    auto it  = str.rbegin();
+    for(auto l : limbs) {
+        for(auto i = 0; i < 5; i++) {
+            *it++ = pszBase58[l % 58];
+            l /= 58;
         }
-
-        if(!BN_rshift(bn, bn, shift))
-            throw bignum_error("CBigNum:operator>>= : BN_rshift failed");
-        return *this;
-    }
-
-    CBigNum& operator++() {
-        // prefix operator
-        if(!BN_add(bn, bn, BN_value_one()))
-            throw bignum_error("CBigNum::operator++ : BN_add failed");
-        return *this;
-    }
-
-    const CBigNum operator++(int) {
-        // postfix operator
-        const CBigNum ret = *this;
-        ++(*this);
-        return ret;
-    }
-
-    CBigNum& operator--() {
-        // prefix operator
-        CBigNum r;
-        if(!BN_sub(r.bn, bn, BN_value_one()))
-            throw bignum_error("CBigNum::operator-- : BN_sub failed");
-        *this = r;
-        return *this;
-    }
-
-    const CBigNum operator--(int) {
-        // postfix operator
-        const CBigNum ret = *this;
-        --(*this);
-        return ret;
-    }
-
-    const BIGNUM* to_bignum() const {
-        return bn;
     }
-    BIGNUM* to_bignum() {
-        return bn;
-    }
-};
-
-inline const CBigNum
-operator+(const CBigNum& a, const CBigNum& b) {
-    CBigNum r;
-    if(!BN_add(r.to_bignum(), a.to_bignum(), b.to_bignum()))
-        throw bignum_error("CBigNum::operator+ : BN_add failed");
-    return r;
-}
-
-inline const CBigNum
-operator-(const CBigNum& a, const CBigNum& b) {
-    CBigNum r;
-    if(!BN_sub(r.to_bignum(), a.to_bignum(), b.to_bignum()))
-        throw bignum_error("CBigNum::operator- : BN_sub failed");
-    return r;
-}
-
-inline const CBigNum
-operator-(const CBigNum& a) {
-    CBigNum r(a);
-    BN_set_negative(r.to_bignum(), !BN_is_negative(r.to_bignum()));
-    return r;
-}
-
-inline const CBigNum operator*(const CBigNum& a, const CBigNum& b) {
-    CAutoBN_CTX pctx;
-    CBigNum     r;
-    if(!BN_mul(r.to_bignum(), a.to_bignum(), b.to_bignum(), pctx))
-        throw bignum_error("CBigNum::operator* : BN_mul failed");
-    return r;
-}
-
-inline const CBigNum
-operator/(const CBigNum& a, const CBigNum& b) {
-    CAutoBN_CTX pctx;
-    CBigNum     r;
-    if(!BN_div(r.to_bignum(), NULL, a.to_bignum(), b.to_bignum(), pctx))
-        throw bignum_error("CBigNum::operator/ : BN_div failed");
-    return r;
-}
-
-inline const CBigNum
-operator%(const CBigNum& a, const CBigNum& b) {
-    CAutoBN_CTX pctx;
-    CBigNum     r;
-    if(!BN_mod(r.to_bignum(), a.to_bignum(), b.to_bignum(), pctx))
-        throw bignum_error("CBigNum::operator% : BN_div failed");
-    return r;
-}
-
-inline const CBigNum
-operator<<(const CBigNum& a, unsigned int shift) {
-    CBigNum r;
-    if(!BN_lshift(r.to_bignum(), a.to_bignum(), shift))
-        throw bignum_error("CBigNum:operator<< : BN_lshift failed");
-    return r;
-}
-
-inline const CBigNum
-operator>>(const CBigNum& a, unsigned int shift) {
-    CBigNum r = a;
-    r >>= shift;
-    return r;
-}
-
-inline bool
-operator==(const CBigNum& a, const CBigNum& b) {
-    return (BN_cmp(a.to_bignum(), b.to_bignum()) == 0);
-}
-
-inline bool
-operator!=(const CBigNum& a, const CBigNum& b) {
-    return (BN_cmp(a.to_bignum(), b.to_bignum()) != 0);
-}
-
-inline bool
-operator<=(const CBigNum& a, const CBigNum& b) {
-    return (BN_cmp(a.to_bignum(), b.to_bignum()) <= 0);
-}
-
-inline bool
-operator>=(const CBigNum& a, const CBigNum& b) {
-    return (BN_cmp(a.to_bignum(), b.to_bignum()) >= 0);
-}
-
-inline bool
-operator<(const CBigNum& a, const CBigNum& b) {
-    return (BN_cmp(a.to_bignum(), b.to_bignum()) < 0);
-}
 
-inline bool
-operator>(const CBigNum& a, const CBigNum& b) {
-    return (BN_cmp(a.to_bignum(), b.to_bignum()) > 0);
-}
-
-static const char* pszBase58 = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
-
-// Encode a byte sequence as a base58-encoded string
-inline std::string
-EncodeBase58(const unsigned char* pbegin, const unsigned char* pend) {
-    CAutoBN_CTX pctx;
-    CBigNum     bn58 = 58;
-    CBigNum     bn0  = 0;
-
-    // Convert big endian data to little endian
-    // Extra zero at the end make sure bignum will interpret as a positive number
-    std::vector<unsigned char> vchTmp(pend - pbegin + 1, 0);
-    reverse_copy(pbegin, pend, vchTmp.begin());
-
-    // Convert little endian data to bignum
-    CBigNum bn;
-    bn.setvch(vchTmp);
-
-    // Convert bignum to std::string
-    std::string str;
-    // Expected size increase from base58 conversion is approximately 137%
-    // use 138% to be safe
-    str.reserve((pend - pbegin) * 138 / 100 + 1);
-    CBigNum dv;
-    CBigNum rem;
-    while(bn > bn0) {
-        if(!BN_div(dv.to_bignum(), rem.to_bignum(), bn.to_bignum(), bn58.to_bignum(), pctx))
-            throw bignum_error("EncodeBase58 : BN_div failed");
-        bn             = dv;
-        unsigned int c = rem.getulong();
-        str += pszBase58[c];
+    // Drop the zero digits on top of the highest limb
+    auto first = str.begin() + zeros;
+    auto last  = first;
+    while(last != str.end() && *last == pszBase58[0]) {
+        last++;
     }
-
-    // Leading zeroes encoded as base58 zeros
-    for(const unsigned char* p = pbegin; p < pend && *p == 0; p++)
-        str += pszBase58[0];
-
-    // Convert little endian std::string to big endian
-    reverse(str.begin(), str.end());
-    //    slog( "Encode '%s'", str.c_str() );
+    str.erase(first, last);
     return str;
 }
 
-// Encode a byte vector as a base58-encoded string
-inline std::string
-EncodeBase58(const std::vector<unsigned char>& vch) {
-    return EncodeBase58(&vch[0], &vch[0] + vch.size());
-}
-
 // Decode a base58-encoded string psz into byte vector vchRet
 // returns true if decoding is succesful
 inline bool
 DecodeBase58(const char* psz, std::vector<unsigned char>& vchRet) {
-    CAutoBN_CTX pctx;
     vchRet.clear();
-    CBigNum bn58 = 58;
-    CBigNum bn   = 0;
-    CBigNum bnChar;
     while(isspace(*psz))
         psz++;
 
-    // Convert big endian string to bignum
-    for(const char* p = psz; *p; p++) {
-        const char* p1 = strchr(pszBase58, *p);
-        if(p1 == NULL) {
-            while(isspace(*p))
-                p++;
-            if(*p != '\0') {
-                //slog( "%s  '%c'", pszBase58,*p );
-                return false;
-            }
-            break;
-        }
-        bnChar.setulong(p1 - pszBase58);
-        if(!BN_mul(bn.to_bignum(), bn.to_bignum(), bn58.to_bignum(), pctx))
-            throw bignum_error("DecodeBase58 : BN_mul failed");
-        bn += bnChar;
+    // Restore leading zeros
+    auto zeros = 0u;
+    while(*psz == pszBase58[0]) {
+        psz++;
+        zeros++;
     }
 
-    // Get bignum as little endian data
-    std::vector<unsigned char> vchTmp = bn.getvch();
+    auto end = psz;
+    while(mapBase58[(uint8_t)*end] != -1) {
+        end++;
+    }
+    for(auto p = end; *p; p++) {
+        if(!isspace(*p)) {
+            return false;
+        }
+    }
 
-    // Trim off sign byte if present
-    if(vchTmp.size() >= 2 && vchTmp.end()[-1] == 0 && vchTmp.end()[-2] >= 0x80)
-        vchTmp.erase(vchTmp.end() - 1);
+    auto len   = (size_t)(end - psz);
+    auto limbs = limbs_type();
+    // every digit carries less than 0.74 bytes
+    limbs.reserve(len * 733 / 1000 / 4 + 2);
 
-    // Restore leading zeros
-    int nLeadingZeros = 0;
-    for(const char* p = psz; *p == pszBase58[0]; p++)
-        nLeadingZeros++;
-    vchRet.assign(nLeadingZeros + vchTmp.size(), 0);
+    auto accumulate = [&limbs](uint64_t mul, uint32_t word) {
+        uint64_t carry = word;
+        for(auto& l : limbs) {
+            carry += (uint64_t)l * mul;
+            l      = (uint32_t)carry;
+            carry >>= 32;
+        }
+        if(carry > 0) {
+            limbs.push_back((uint32_t)carry);
+        }
+    };
+
+    // first group takes the digits left over by the whole groups of 5
+    auto head = len % 5;
+    if(head > 0) {
+        auto word = 0u;
+        auto mul  = 1ull;
+        for(auto i = 0u; i < head; i++) {
+            word = word * 58 + mapBase58[(uint8_t)*psz++];
+            mul *= 58;
+        }
+        accumulate(mul, word);
+    }
+    while(psz != end) {
+        auto word = 0u;
+        for(auto i = 0; i < 5; i++) {
+            word = word * 58 + mapBase58[(uint8_t)*psz++];
+        }
+        accumulate(kBase58Pow5, word);
+    }
 
-    // Convert little endian data to big endian
-    reverse_copy(vchTmp.begin(), vchTmp.end(), vchRet.end() - vchTmp.size());
+    // Convert little endian limbs to big endian bytes without the zeros on top
+    vchRet.assign(zeros + limbs.size() * 4, 0);
+    auto it = vchRet.rbegin();
+    for(auto l : limbs) {
+        for(auto i = 0; i < 4; i++) {
+            *it++ = (unsigned char)l;
+            l >>= 8;
+        }
+    }
+    auto first = vchRet.begin() + zeros;
+    auto last  = first;
+    while(last != vchRet.end() && *last == 0) {
+        last++;
+    }
+    vchRet.erase(first, last);
     return true;
 }
 
-// Decode a base58-encoded string str into byte vector vchRet
-// returns true if decoding is succesful
-inline bool
-DecodeBase58(const std::string& str, std::vector<unsigned char>& vchRet) {
-    return DecodeBase58(str.c_str(), vchRet);
-}
-
-namespace fc {
+}  // namespace internal
 
 std::string
 to_base58(const char* d, size_t s) {
-    return EncodeBase58((const unsigned char*)d, (const unsigned char*)d + s).c_str();
+    return internal::EncodeBase58((const unsigned char*)d, (const unsigned char*)d + s);
 }
 
 std::string
@@ -625,7 +210,7 @@ to_base58(const std::vector<char>& d) {
 std::vector<char>
 from_base58(const std::string& base58_str) {
     std::vector<unsigned char> out;
-    if(!DecodeBase58(base58_str.c_str(), out)) {
+    if(!internal::DecodeBase58(base58_str.c_str(), out)) {
         FC_THROW_EXCEPTION(parse_error_exception, "Unable to decode base58 string ${base58_str}", ("base58_str", base58_str));
     }
     return std::vector<char>((const char*)out.data(), ((const char*)out.data()) + out.size());
@@ -637,7 +222,7 @@ size_t
 from_base58(const std::string& base58_str, char* out_data, size_t out_data_len) {
     //slog( "%s", base58_str.c_str() );
     std::vector<unsigned char> out;
-    if(!DecodeBase58(base58_str.c_str(), out)) {
+    if(!internal::DecodeBase58(base58_str.c_str(), out)) {
         FC_THROW_EXCEPTION(parse_error_exception, "Unable to decode base58 string ${base58_str}", ("base58_str", base58_str));
     }
     FC_ASSERT(out.size() <= out_data_len);
@@ -646,5 +231,3 @@ from_base58(const std::string& base58_str, char* out_data, size_t out_data_len)
 }
 
 }  // namespace fc
-
-#endif
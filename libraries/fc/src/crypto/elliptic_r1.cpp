@@ -1,3 +1,4 @@
+#include <vector>
 #include <fc/crypto/elliptic_r1.hpp>
 
 #include <fc/crypto/base58.hpp>
@@ -60,148 +61,179 @@ ecies_key_derivation(const void* input, size_t ilen, void* output, size_t* olen)
     return (void*)SHA512((const unsigned char*)input, ilen, (unsigned char*)output);
 }
 
-// Perform ECDSA key recovery (see SEC1 4.1.6) for curves over (mod p)-fields
-// recid selects which key is recovered
-// if check is non-zero, additional checks are performed
-static int
-ECDSA_SIG_recover_key_GFp(EC_KEY* eckey, ECDSA_SIG* ecsig, const unsigned char* msg, int msglen, int recid, int check) {
-    if(!eckey)
-        FC_THROW_EXCEPTION(exception, "null key");
-
-    int     ret = 0;
-    BN_CTX* ctx = NULL;
-
-    BIGNUM*   x     = NULL;
-    BIGNUM*   e     = NULL;
-    BIGNUM*   order = NULL;
-    BIGNUM*   sor   = NULL;
-    BIGNUM*   eor   = NULL;
-    BIGNUM*   field = NULL;
-    EC_POINT* R     = NULL;
-    EC_POINT* O     = NULL;
-    EC_POINT* Q     = NULL;
-    BIGNUM*   rr    = NULL;
-    BIGNUM*   zero  = NULL;
-    int       n     = 0;
-    int       i     = recid / 2;
-
-    const BIGNUM *r, *s;
-    ECDSA_SIG_get0(ecsig, &r, &s);
+namespace detail {
 
-    const EC_GROUP* group = EC_KEY_get0_group(eckey);
-    if((ctx = BN_CTX_new()) == NULL) {
-        ret = -1;
-        goto err;
+/**
+ * Parameters of the curve, computed once and only read afterwards, so the group is shared by all
+ * the threads instead of being built for every key. Never freed, it lives as long as the process.
+ */
+struct curve_params {
+    curve_params() {
+        init_openssl();
+        group = EC_GROUP_new_by_curve_name(NID_X9_62_prime256v1);
+        FC_ASSERT(group != nullptr);
+
+        bn_ctx ctx(BN_CTX_new());
+        EC_GROUP_precompute_mult(group, ctx);
+        EC_GROUP_get_order(group, order, ctx);
+        BN_rshift1(halforder, order);
+        EC_GROUP_get_curve_GFp(group, field, nullptr, nullptr, ctx);
     }
-    BN_CTX_start(ctx);
-    order = BN_CTX_get(ctx);
-    if(!EC_GROUP_get_order(group, order, ctx)) {
-        ret = -2;
-        goto err;
+
+    EC_GROUP*  group;
+    ssl_bignum order;
+    ssl_bignum halforder;
+    ssl_bignum field;
+};
+
+static const curve_params&
+get_curve() {
+    static auto params = new curve_params();
+    return *params;
+}
+
+// scratch context of the calling thread, shared by all its recoveries
+static BN_CTX*
+get_scratch() {
+    static thread_local bn_ctx ctx(BN_CTX_new());
+    return ctx;
+}
+
+// the bignums got from the context while it's alive are released when it's destroyed
+struct scratch_frame {
+    scratch_frame(BN_CTX* ctx)
+        : ctx(ctx) {
+        BN_CTX_start(ctx);
     }
-    x = BN_CTX_get(ctx);
-    if(!BN_copy(x, order)) {
-        ret = -1;
-        goto err;
+    ~scratch_frame() { BN_CTX_end(ctx); }
+
+    BN_CTX* ctx;
+};
+
+}  // namespace detail
+
+// -e mod n of the digest, shared by the recoveries of all the signatures over it
+// the degree of the curve is 256, so the digest is never truncated
+static void
+digest_term(const detail::curve_params& cp, const fc::sha256& digest, BIGNUM* e, BN_CTX* ctx) {
+    BN_bin2bn((const unsigned char*)&digest, sizeof(digest), e);
+    BN_nnmod(e, e, cp.order, ctx);
+    if(!BN_is_zero(e)) {
+        BN_sub(e, cp.order, e);
     }
-    if(!BN_mul_word(x, i)) {
-        ret = -1;
-        goto err;
+}
+
+// Perform ECDSA key recovery (see SEC1 4.1.6) of Q = r^-1 (sR - eG) for the recovery id `recid`,
+// -e and r^-1 are given by the caller. The cofactor of the curve is 1, R always has the order n.
+static bool
+recover_point(const detail::curve_params& cp, const BIGNUM* r, const BIGNUM* s, const BIGNUM* rinv, const BIGNUM* e,
+              int recid, EC_POINT* Q, BN_CTX* ctx) {
+    detail::scratch_frame frame(ctx);
+
+    auto x   = BN_CTX_get(ctx);
+    auto sor = BN_CTX_get(ctx);
+    auto eor = BN_CTX_get(ctx);
+    if(eor == nullptr) {
+        return false;
     }
-    if(!BN_add(x, x, r)) {
-        ret = -1;
-        goto err;
+
+    if(!BN_copy(x, cp.order) || !BN_mul_word(x, recid / 2) || !BN_add(x, x, r)) {
+        return false;
     }
-    field = BN_CTX_get(ctx);
-    if(!EC_GROUP_get_curve_GFp(group, field, NULL, NULL, ctx)) {
-        ret = -2;
-        goto err;
+    if(BN_cmp(x, cp.field) >= 0) {
+        return false;
     }
-    if(BN_cmp(x, field) >= 0) {
-        ret = 0;
-        goto err;
+
+    ec_point R(EC_POINT_new(cp.group));
+    if(R.obj == nullptr || !EC_POINT_set_compressed_coordinates_GFp(cp.group, R, x, recid % 2, ctx)) {
+        return false;
     }
-    if((R = EC_POINT_new(group)) == NULL) {
-        ret = -2;
-        goto err;
+    if(!BN_mod_mul(sor, s, rinv, cp.order, ctx) || !BN_mod_mul(eor, e, rinv, cp.order, ctx)) {
+        return false;
     }
-    if(!EC_POINT_set_compressed_coordinates_GFp(group, R, x, recid % 2, ctx)) {
-        ret = 0;
-        goto err;
+    return EC_POINT_mul(cp.group, Q, eor, R, sor, ctx) == 1;
+}
+
+static public_key_data
+point_data(const detail::curve_params& cp, const EC_POINT* Q, BN_CTX* ctx) {
+    public_key_data dat;
+    auto            n = EC_POINT_point2oct(cp.group, Q, POINT_CONVERSION_COMPRESSED, (unsigned char*)dat.data(), dat.size(), ctx);
+    FC_ASSERT(n == dat.size());
+    return dat;
+}
+
+// recovers the points of the compact signatures, `f` is called with the index and the point of each
+template<typename Func>
+static void
+recover_points(const compact_signature* const* sigs, size_t n, const fc::sha256& digest, Func&& f) {
+    if(n == 0) {
+        return;
     }
-    if(check) {
-        if((O = EC_POINT_new(group)) == NULL) {
-            ret = -2;
-            goto err;
+
+    auto&                 cp  = detail::get_curve();
+    auto                  ctx = detail::get_scratch();
+    detail::scratch_frame frame(ctx);
+
+    auto rs     = std::vector<BIGNUM*>(n);
+    auto ss     = std::vector<BIGNUM*>(n);
+    auto prods  = std::vector<BIGNUM*>(n);
+    auto recids = std::vector<int>(n);
+    for(auto i = 0u; i < n; i++) {
+        rs[i]    = BN_CTX_get(ctx);
+        ss[i]    = BN_CTX_get(ctx);
+        prods[i] = BN_CTX_get(ctx);
+    }
+    auto e    = BN_CTX_get(ctx);
+    auto inv  = BN_CTX_get(ctx);
+    auto rinv = BN_CTX_get(ctx);
+    FC_ASSERT(rinv != nullptr, "unable to allocate bignums");
+
+    digest_term(cp, digest, e, ctx);
+
+    for(auto i = 0u; i < n; i++) {
+        auto& c  = *sigs[i];
+        int   nV = c[0];
+        if(nV < 27 || nV >= 35) {
+            FC_THROW_EXCEPTION(exception, "unable to reconstruct public key from signature");
         }
-        if(!EC_POINT_mul(group, O, NULL, R, order, ctx)) {
-            ret = -2;
-            goto err;
+        BN_bin2bn(&c[1], 32, rs[i]);
+        BN_bin2bn(&c[33], 32, ss[i]);
+        if(BN_cmp(ss[i], cp.halforder) > 0) {
+            FC_THROW_EXCEPTION(exception, "invalid high s-value encountered in r1 signature");
         }
-        if(!EC_POINT_is_at_infinity(group, O)) {
-            ret = 0;
-            goto err;
+        // r of 0 mod n has no inverse and would zero the product of all of them
+        if(BN_is_zero(rs[i]) || BN_cmp(rs[i], cp.order) == 0) {
+            FC_THROW_EXCEPTION(exception, "unable to reconstruct public key from signature");
+        }
+        recids[i] = (nV >= 31 ? nV - 4 : nV) - 27;
+
+        if(i == 0) {
+            BN_copy(prods[0], rs[0]);
+        }
+        else {
+            BN_mod_mul(prods[i], prods[i - 1], rs[i], cp.order, ctx);
         }
-    }
-    if((Q = EC_POINT_new(group)) == NULL) {
-        ret = -2;
-        goto err;
-    }
-    n = EC_GROUP_get_degree(group);
-    e = BN_CTX_get(ctx);
-    if(!BN_bin2bn(msg, msglen, e)) {
-        ret = -1;
-        goto err;
-    }
-    if(8 * msglen > n)
-        BN_rshift(e, e, 8 - (n & 7));
-    zero = BN_CTX_get(ctx);
-    if(!BN_zero(zero)) {
-        ret = -1;
-        goto err;
-    }
-    if(!BN_mod_sub(e, zero, e, order, ctx)) {
-        ret = -1;
-        goto err;
-    }
-    rr = BN_CTX_get(ctx);
-    if(!BN_mod_inverse(rr, r, order, ctx)) {
-        ret = -1;
-        goto err;
-    }
-    sor = BN_CTX_get(ctx);
-    if(!BN_mod_mul(sor, s, rr, order, ctx)) {
-        ret = -1;
-        goto err;
-    }
-    eor = BN_CTX_get(ctx);
-    if(!BN_mod_mul(eor, e, rr, order, ctx)) {
-        ret = -1;
-        goto err;
-    }
-    if(!EC_POINT_mul(group, Q, eor, R, sor, ctx)) {
-        ret = -2;
-        goto err;
-    }
-    if(!EC_KEY_set_public_key(eckey, Q)) {
-        ret = -2;
-        goto err;
     }
 
-    ret = 1;
+    // inverts all the r values with one inversion: r_i^-1 = (r_0...r_i)^-1 * r_0...r_i-1
+    if(!BN_mod_inverse(inv, prods[n - 1], cp.order, ctx)) {
+        FC_THROW_EXCEPTION(exception, "unable to reconstruct public key from signature");
+    }
 
-err:
-    if(ctx) {
-        BN_CTX_end(ctx);
-        BN_CTX_free(ctx);
+    ec_point Q(EC_POINT_new(cp.group));
+    for(auto i = n; i-- > 0;) {
+        if(i > 0) {
+            BN_mod_mul(rinv, inv, prods[i - 1], cp.order, ctx);
+            BN_mod_mul(inv, inv, rs[i], cp.order, ctx);
+        }
+        else {
+            BN_copy(rinv, inv);
+        }
+        if(!recover_point(cp, rs[i], ss[i], rinv, e, recids[i], Q, ctx)) {
+            FC_THROW_EXCEPTION(exception, "unable to reconstruct public key from signature");
+        }
+        f(i, (const EC_POINT*)Q, cp, ctx);
     }
-    if(R != NULL)
-        EC_POINT_free(R);
-    if(O != NULL)
-        EC_POINT_free(O);
-    if(Q != NULL)
-        EC_POINT_free(Q);
-    return ret;
 }
 
 compact_signature
@@ -214,14 +246,11 @@ signature_from_ecdsa(const EC_KEY* key, const public_key_data& pub_data, fc::ecd
     BN_copy(s, sig_s);
 
     //want to always use the low S value
-    const EC_GROUP* group = EC_KEY_get0_group(key);
-    ssl_bignum      order, halforder;
-    EC_GROUP_get_order(group, order, nullptr);
-    BN_rshift1(halforder, order);
-    if(BN_cmp(s, halforder) > 0)
-        BN_sub(s, order, s);
+    auto& cp = detail::get_curve();
+    if(BN_cmp(s, cp.halforder) > 0)
+        BN_sub(s, cp.order, s);
 
-    compact_signature csig;
+    compact_signature csig = {};
 
     int nBitsR = BN_num_bits(r);
     int nBitsS = BN_num_bits(s);
@@ -230,15 +259,22 @@ signature_from_ecdsa(const EC_KEY* key, const public_key_data& pub_data, fc::ecd
 
     ECDSA_SIG_set0(sig, r, s);
 
-    int nRecId = -1;
+    auto                  ctx = detail::get_scratch();
+    detail::scratch_frame frame(ctx);
+
+    auto e    = BN_CTX_get(ctx);
+    auto rinv = BN_CTX_get(ctx);
+    FC_ASSERT(rinv != nullptr, "unable to allocate bignums");
+    digest_term(cp, d, e, ctx);
+    if(!BN_mod_inverse(rinv, r, cp.order, ctx))
+        FC_THROW_EXCEPTION(exception, "unable to construct recoverable key");
+
+    ec_point Q(EC_POINT_new(cp.group));
+    int      nRecId = -1;
     for(int i = 0; i < 4; i++) {
-        public_key keyRec;
-        keyRec.my->_key = EC_KEY_new_by_curve_name(NID_X9_62_prime256v1);
-        if(ECDSA_SIG_recover_key_GFp(keyRec.my->_key, sig, (unsigned char*)&d, sizeof(d), i, 1) == 1) {
-            if(keyRec.serialize() == pub_data) {
-                nRecId = i;
-                break;
-            }
+        if(recover_point(cp, r, s, rinv, e, i, Q, ctx) && point_data(cp, Q, ctx) == pub_data) {
+            nRecId = i;
+            break;
         }
     }
     if(nRecId == -1)
@@ -584,34 +620,31 @@ private_key::~private_key() {
 }
 
 public_key::public_key(const compact_signature& c, const fc::sha256& digest, bool check_canonical) {
-    int nV = c[0];
-    if(nV < 27 || nV >= 35)
-        FC_THROW_EXCEPTION(exception, "unable to reconstruct public key from signature");
-
-    ecdsa_sig sig = ECDSA_SIG_new();
-    BIGNUM *  r = BN_new(), *s = BN_new();
-    BN_bin2bn(&c[1], 32, r);
-    BN_bin2bn(&c[33], 32, s);
-    ECDSA_SIG_set0(sig, r, s);
-
-    my->_key = EC_KEY_new_by_curve_name(NID_X9_62_prime256v1);
-
-    const EC_GROUP* group = EC_KEY_get0_group(my->_key);
-    ssl_bignum      order, halforder;
-    EC_GROUP_get_order(group, order, nullptr);
-    BN_rshift1(halforder, order);
-    if(BN_cmp(s, halforder) > 0)
-        FC_THROW_EXCEPTION(exception, "invalid high s-value encountered in r1 signature");
+    auto p = &c;
+    recover_points(&p, 1, digest, [&](auto, auto Q, auto& cp, auto) {
+        my->_key = EC_KEY_new();
+        if(my->_key == nullptr || !EC_KEY_set_group(my->_key, cp.group) || !EC_KEY_set_public_key(my->_key, Q)) {
+            FC_THROW_EXCEPTION(exception, "unable to reconstruct public key from signature");
+        }
+        if(c[0] >= 31) {
+            EC_KEY_set_conv_form(my->_key, POINT_CONVERSION_COMPRESSED);
+        }
+    });
+}
 
-    if(nV >= 31) {
-        EC_KEY_set_conv_form(my->_key, POINT_CONVERSION_COMPRESSED);
-        nV -= 4;
-        //            fprintf( stderr, "compressed\n" );
-    }
+void
+public_key::recover_data(const compact_signature* const* sigs, size_t n, const fc::sha256& digest, public_key_data* keys) {
+    recover_points(sigs, n, digest, [&](auto i, auto Q, auto& cp, auto ctx) {
+        keys[i] = point_data(cp, Q, ctx);
+    });
+}
 
-    if(ECDSA_SIG_recover_key_GFp(my->_key, sig, (unsigned char*)&digest, sizeof(digest), nV - 27, 0) == 1)
-        return;
-    FC_THROW_EXCEPTION(exception, "unable to reconstruct public key from signature");
+public_key_data
+public_key::recover_data(const compact_signature& c, const fc::sha256& digest) {
+    auto            p = &c;
+    public_key_data dat;
+    recover_data(&p, 1, digest, &dat);
+    return dat;
 }
 
 compact_signature
@@ -1,3 +1,6 @@
+#include <string.h>
+#include <mutex>
+#include <vector>
 #include <fc/crypto/public_key.hpp>
 #include <fc/crypto/common.hpp>
 #include <fc/exception/exception.hpp>
@@ -24,6 +27,46 @@ public_key::public_key(const ecc::public_key_shim& ecc_key)
 public_key::public_key(const signature& c, const sha256& digest, bool check_canonical)
     : _storage(c._storage.visit(recovery_visitor(digest, check_canonical))) {}
 
+void
+public_key::recover_keys(const signature* sigs, size_t n, const sha256& digest, public_key* keys, bool check_canonical) {
+    auto visitor = recovery_visitor(digest, check_canonical);
+    auto dups    = std::vector<std::pair<size_t, size_t>>();
+
+    // r1 signatures are recovered together once the others are done
+    auto r1_sigs = std::vector<const r1::compact_signature*>();
+    auto r1_idxs = std::vector<size_t>();
+
+    for(auto i = 0u; i < n; i++) {
+        auto j = 0u;
+        for(; j < i; j++) {
+            if(sigs[j] == sigs[i]) {
+                break;
+            }
+        }
+        if(j < i) {
+            dups.emplace_back(i, j);
+            continue;
+        }
+        if(sigs[i]._storage.contains<r1::signature_shim>()) {
+            r1_sigs.emplace_back(&sigs[i]._storage.get<r1::signature_shim>()._data);
+            r1_idxs.emplace_back(i);
+            continue;
+        }
+        keys[i] = public_key(sigs[i]._storage.visit(visitor));
+    }
+
+    if(!r1_sigs.empty()) {
+        auto data = std::vector<r1::public_key_data>(r1_sigs.size());
+        r1::public_key::recover_data(r1_sigs.data(), r1_sigs.size(), digest, data.data());
+        for(auto k = 0u; k < data.size(); k++) {
+            keys[r1_idxs[k]] = public_key(storage_type(r1::public_key_shim(data[k])));
+        }
+    }
+    for(auto& d : dups) {
+        keys[d.first] = keys[d.second];
+    }
+}
+
 static public_key::storage_type
 parse_base58(const std::string& base58str) {
     constexpr auto prefix = config::public_key_evt_prefix;
@@ -58,11 +101,76 @@ public_key::valid() const {
     return _storage.visit(is_valid_visitor());
 }
 
-public_key::operator std::string() const {
-    auto data_str = _storage.visit(base58str_visitor<storage_type, config::public_key_prefix, 0>());
+namespace internal {
+
+/**
+ * Strings of the recently formatted keys, api responses repeat the same few keys many times.
+ * Direct-mapped by the bytes of the key: a new key takes over the slot of the old one.
+ */
+class key_string_cache {
+public:
+    static constexpr size_t kSlotsNum = 4096;
+
+public:
+    bool
+    get(const ecc::public_key_data& key, std::string& str) {
+        auto& sl   = get_slot(key);
+        auto  lock = std::lock_guard(sl.mtx);
+        if(sl.str.empty() || sl.key != key) {
+            return false;
+        }
+        str = sl.str;
+        return true;
+    }
+
+    void
+    put(const ecc::public_key_data& key, const std::string& str) {
+        auto& sl   = get_slot(key);
+        auto  lock = std::lock_guard(sl.mtx);
+        sl.key = key;
+        sl.str = str;
+    }
 
+private:
+    struct slot {
+        std::mutex           mtx;
+        ecc::public_key_data key;
+        std::string          str;
+    };
+
+    slot&
+    get_slot(const ecc::public_key_data& key) {
+        // skips the parity byte, the x coordinate is uniformly distributed
+        auto h = uint64_t();
+        memcpy(&h, key.data() + 1, sizeof(h));
+        return slots_[h % kSlotsNum];
+    }
+
+private:
+    slot slots_[kSlotsNum];
+};
+
+key_string_cache&
+key_strings() {
+    static auto cache = key_string_cache();
+    return cache;
+}
+
+}  // namespace internal
+
+public_key::operator std::string() const {
     FC_ASSERT(_storage.which() == 0);
-    return std::string(config::public_key_evt_prefix) + data_str;
+
+    auto& key = _storage.get<ecc::public_key_shim>().serialize();
+    auto  str = std::string();
+    if(internal::key_strings().get(key, str)) {
+        return str;
+    }
+
+    auto data_str = _storage.visit(base58str_visitor<storage_type, config::public_key_prefix, 0>());
+    str = std::string(config::public_key_evt_prefix) + data_str;
+    internal::key_strings().put(key, str);
+    return str;
 }
 
 std::ostream&
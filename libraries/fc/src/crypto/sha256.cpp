@@ -52,9 +52,16 @@ sha256::encoder::encoder() {
 
 sha256
 sha256::hash(const char* d, uint32_t dlen) {
-    encoder e;
-    e.write(d, dlen);
-    return e.result();
+    sha256 h;
+    SHA256((const uint8_t*)d, dlen, (uint8_t*)h.data());
+    return h;
+}
+
+void
+sha256::hash_many(const char* data, size_t size, size_t n, sha256* out) {
+    for(auto i = 0u; i < n; i++) {
+        SHA256((const uint8_t*)data + i * size, size, (uint8_t*)out[i].data());
+    }
 }
 
 sha256
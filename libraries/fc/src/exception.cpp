@@ -233,7 +233,7 @@ exception::to_string(log_level ll) const {
         }
         for(auto itr = my->_elog.begin(); itr != my->_elog.end(); ++itr) {
             try {
-                ss << fc::format_string(itr->format, itr->args) << "\n";
+                ss << fc::format_string(itr->get_format(), itr->args) << "\n";
                 //      ss << "    " << itr->get_context().to_string() <<"\n";
             }
             catch(std::bad_alloc&) {
@@ -260,7 +260,7 @@ exception::to_string(log_level ll) const {
 string
 exception::top_message() const {
     for(auto itr = my->_elog.begin(); itr != my->_elog.end(); ++itr) {
-        auto s = fc::format_string(itr->format, itr->args);
+        auto s = fc::format_string(itr->get_format(), itr->args);
         if(!s.empty()) {
             return s;
         }
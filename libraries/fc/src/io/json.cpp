@@ -3,6 +3,7 @@
 #include <sstream>
 
 #include <fc/io/json.hpp>
+#include <fc/io/json_writer.hpp>
 #include <fc/exception/exception.hpp>
 //#include <fc/io/fstream.hpp>
 //#include <fc/io/sstream.hpp>
@@ -21,7 +22,7 @@ namespace fc
     template<typename T, json::parse_type parser_type> variants arrayFromStream( T& in, uint32_t max_depth );
     template<typename T, json::parse_type parser_type> variant number_from_stream( T& in );
     template<typename T> variant token_from_stream( T& in );
-    void escape_string( const std::string& str, std::ostream& os );
+    template<typename T> void escape_string( const std::string_view& str, T& os );
     template<typename T> void to_stream( T& os, const variants& a, json::output_formatting format );
     template<typename T> void to_stream( T& os, const variant_object& o, json::output_formatting format );
     template<typename T> void to_stream( T& os, const variant& v, json::output_formatting format );
@@ -443,6 +444,10 @@ namespace fc
 
    variant json::from_string( const std::string& utf8_str, parse_type ptype, uint32_t max_depth )
    { try {
+      if( ptype == rapidjson_parser && (utf8_str.empty() || utf8_str[0] != '"') ) {
+          return rapidjson::variant_from_string( utf8_str, max_depth );
+      }
+
       std::stringstream in( utf8_str );
       //in.exceptions( std::ifstream::eofbit );
       switch( ptype )
@@ -456,18 +461,19 @@ namespace fc
           case relaxed_parser:
               return json_relaxed::variant_from_stream<std::stringstream, false>( in, max_depth );
           case rapidjson_parser: {
-              auto c = in.peek();
-              if(c == '"') {
-                  in.seekg(0);
-                  return variant_from_stream<std::stringstream, legacy_parser>( in, max_depth );
-              }
-              return rapidjson::variant_from_stream<std::stringstream, false>( in, max_depth );
+              // the variant handler of rapidjson does not take a string as root
+              return variant_from_stream<std::stringstream, legacy_parser>( in, max_depth );
           }
           default:
               FC_ASSERT( false, "Unknown JSON parser type {ptype}", ("ptype", ptype) );
       }
    } FC_RETHROW_EXCEPTIONS( warn, "", ("str",utf8_str) ) }
 
+   string json::minify( const string& utf8_str )
+   { try {
+      return rapidjson::minify( utf8_str );
+   } FC_RETHROW_EXCEPTIONS( warn, "", ("str",utf8_str) ) }
+
    variants json::variants_from_string( const std::string& utf8_str, parse_type ptype, uint32_t max_depth )
    { try {
       variants result;
@@ -500,7 +506,8 @@ namespace fc
     *
     *  All other characters are printed as UTF8.
     */
-   void escape_string( const string& str, std::ostream& os )
+   template<typename T>
+   void escape_string( const std::string_view& str, T& os )
    {
       os << '"';
       for( auto itr = str.begin(); itr != str.end(); ++itr )
@@ -670,11 +677,40 @@ namespace fc
       }
    }
 
+   namespace detail
+   {
+      // appends straight to a string, avoids the locale and buffering overhead of stringstream
+      struct string_sink
+      {
+         std::string& s;
+
+         string_sink& operator<<( char c )               { s.push_back(c); return *this; }
+         string_sink& operator<<( const char* v )        { s.append(v); return *this; }
+         string_sink& operator<<( const std::string& v ) { s.append(v); return *this; }
+         string_sink& operator<<( int64_t i )            { s.append(std::to_string(i)); return *this; }
+         string_sink& operator<<( uint64_t i )           { s.append(std::to_string(i)); return *this; }
+      };
+   }
+
    std::string   json::to_string( const variant& v, output_formatting format )
    {
-      std::stringstream ss;
+      std::string str;
+      auto ss = detail::string_sink{ str };
       fc::to_stream( ss, v, format );
-      return ss.str();
+      return str;
+   }
+
+   void json_writer::write( const variant& v )
+   {
+      separate();
+      auto ss = detail::string_sink{ buffer_ };
+      fc::to_stream( ss, v, json::legacy_generator );
+   }
+
+   void json_writer::append_string( std::string_view str )
+   {
+      auto ss = detail::string_sink{ buffer_ };
+      escape_string( str, ss );
    }
 
 
@@ -137,7 +137,7 @@ console_appender::log(const log_message& m) {
     }
     fmt::format_to(line, "{:<5} {} {:<9} {:<28} ",
         context.level.to_string(),
-        (std::string)time_point::now(),
+        (std::string)context.timestamp,
         context.thread_name,
         fmt::format("{}:{}", context.file.substr(0, 22), context.line));
 
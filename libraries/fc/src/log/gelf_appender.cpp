@@ -97,7 +97,7 @@ gelf_appender::log(const log_message& message) {
     mutable_variant_object gelf_message;
     gelf_message["version"]       = "1.1";
     gelf_message["host"]          = my->cfg.host;
-    gelf_message["short_message"] = format_string(message.format, message.args);
+    gelf_message["short_message"] = format_string(message.get_format(), message.args);
 
     // use now() instead of context.get_timestamp() because log_message construction can include user provided long running calls
     const auto time_ns            = time_point::now().time_since_epoch().count();
@@ -1,5 +1,6 @@
 #include <fc/log/log_message.hpp>
 
+#include <string.h>
 #include <fc/exception/exception.hpp>
 #include <fc/variant.hpp>
 #include <fc/time.hpp>
@@ -10,6 +11,17 @@ namespace fc {
 
 const string& get_thread_name();
 
+namespace {
+
+// same as the filename of fc::path but without constructing one, contexts are made for every exception
+const char*
+file_name(const char* file) {
+    auto p = strrchr(file, '/');
+    return p != nullptr ? p + 1 : file;
+}
+
+}  // namespace
+
 log_context::log_context(const variant& v) {
     auto& obj = v.get_object();
 
@@ -131,7 +143,7 @@ log_level::to_string() const {
 
 log_context::log_context(log_level ll, const char* file, uint64_t line, const char* method)
     : level(ll)
-    , file(fc::path(file).filename().generic_string())
+    , file(file_name(file))
     , line(line)
     , method(method)
     , thread_name(fc::get_thread_name())
@@ -165,19 +177,19 @@ log_message::log_message(const variant& v) {
 variant
 log_message::to_variant() const {
     return mutable_variant_object("context", context)
-                                 ("format", format)
+                                 ("format", get_format())
                                  ("data", args);
 }
 
 string
 log_message::get_message() const {
-    return format_string(format, args);
+    return format_string(get_format(), args);
 }
 
 string
 log_message::get_limited_message() const {
     const bool minimize = true;
-    return format_string(format, args, minimize);
+    return format_string(get_format(), args, minimize);
 }
 
 }  // namespace fc
@@ -1,8 +1,14 @@
 #include <fc/log/logger.hpp>
 
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <unordered_map>
 #include <string>
 
+#include <fc/exception/exception.hpp>
 #include <fc/log/log_message.hpp>
 #include <fc/log/appender.hpp>
 #include <fc/log/logger_config.hpp>
@@ -26,6 +32,230 @@ public:
     appender_vec _appenders;
 };
 
+namespace internal {
+
+// bounded multi-producer queue, every cell carries a sequence number which tells
+// the producers and the consumer whose turn it is, so neither side takes a lock
+template<typename T>
+class ring_buffer {
+private:
+    struct cell {
+        std::atomic<size_t> seq;
+        T                   data;
+    };
+
+public:
+    explicit ring_buffer(size_t size)
+        : _mask(size - 1)
+        , _cells(new cell[size]) {
+        FC_ASSERT(size >= 2 && (size & (size - 1)) == 0, "Size of ring buffer should be power of 2");
+        for(auto i = 0u; i < size; i++) {
+            _cells[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+public:
+    bool
+    push(T&& v) {
+        auto pos = _enqueue_pos.load(std::memory_order_relaxed);
+        for(;;) {
+            auto& c   = _cells[pos & _mask];
+            auto  seq = c.seq.load(std::memory_order_acquire);
+            auto  dif = (intptr_t)seq - (intptr_t)pos;
+            if(dif == 0) {
+                if(_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    c.data = std::move(v);
+                    c.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if(dif < 0) {
+                return false;  // full
+            }
+            else {
+                pos = _enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool
+    pop(T& v) {
+        auto pos = _dequeue_pos.load(std::memory_order_relaxed);
+        for(;;) {
+            auto& c   = _cells[pos & _mask];
+            auto  seq = c.seq.load(std::memory_order_acquire);
+            auto  dif = (intptr_t)seq - (intptr_t)(pos + 1);
+            if(dif == 0) {
+                if(_dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    v      = std::move(c.data);
+                    c.data = T();
+                    c.seq.store(pos + _mask + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if(dif < 0) {
+                return false;  // empty
+            }
+            else {
+                pos = _dequeue_pos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    size_t
+    pushed() const {
+        return _enqueue_pos.load(std::memory_order_acquire);
+    }
+
+private:
+    const size_t            _mask;
+    std::unique_ptr<cell[]> _cells;
+
+    alignas(64) std::atomic<size_t> _enqueue_pos{0};
+    alignas(64) std::atomic<size_t> _dequeue_pos{0};
+};
+
+// records are captured on the calling thread and formatted and written by
+// the appenders on a single background thread
+class async_sink {
+public:
+    struct record {
+        logger      lgr = nullptr;
+        log_message msg;
+    };
+
+public:
+    ~async_sink() { stop(); }
+
+public:
+    static async_sink&
+    instance() {
+        static async_sink sink;
+        return sink;
+    }
+
+    bool
+    enabled() const {
+        return _enabled.load(std::memory_order_relaxed);
+    }
+
+    void
+    start(uint32_t queue_size) {
+        auto lock = std::unique_lock<std::mutex>(_mutex);
+        if(!_ring) {
+            // the ring is kept for the lifetime of process, later sizes are ignored
+            auto size = size_t(2);
+            while(size < queue_size) {
+                size <<= 1;
+            }
+            _ring = std::make_unique<ring_buffer<record>>(size);
+        }
+        if(!_thread.joinable()) {
+            _stopping = false;
+            _thread   = std::thread([this] { run(); });
+        }
+        _enabled.store(true, std::memory_order_release);
+    }
+
+    void
+    stop() {
+        _enabled.store(false, std::memory_order_release);
+        {
+            auto lock = std::unique_lock<std::mutex>(_mutex);
+            _stopping = true;
+        }
+        _cv.notify_one();
+        if(_thread.joinable()) {
+            _thread.join();
+        }
+    }
+
+    void
+    push(logger&& l, log_message&& m) {
+        if(!_ring->push(record{std::move(l), std::move(m)})) {
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        if(_sleeping.load(std::memory_order_acquire)) {
+            _cv.notify_one();
+        }
+    }
+
+    void
+    flush() {
+        if(!_ring) {
+            return;
+        }
+        auto target = _ring->pushed();
+        while(_written.load(std::memory_order_acquire) < target && _thread.joinable()) {
+            _cv.notify_one();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    uint64_t
+    dropped() const {
+        return _dropped.load(std::memory_order_relaxed);
+    }
+
+private:
+    void
+    run() {
+        set_thread_name("log");
+
+        auto reported = dropped();
+        auto r        = record();
+        for(;;) {
+            auto any = false;
+            while(_ring->pop(r)) {
+                r.lgr.dispatch(std::move(r.msg));
+                r = record();
+                _written.fetch_add(1, std::memory_order_release);
+                any = true;
+            }
+
+            auto d = dropped();
+            if(d != reported) {
+                logger::get().dispatch(log_message(FC_LOG_CONTEXT(warn), "${n} log messages were dropped, the queue of logging is full",
+                    mutable_variant_object("n", d - reported)));
+                reported = d;
+            }
+            if(any) {
+                continue;
+            }
+
+            auto lock = std::unique_lock<std::mutex>(_mutex);
+            if(_stopping) {
+                break;
+            }
+            _sleeping.store(true, std::memory_order_release);
+            // producers don't take the mutex, a missed wakeup only delays the records until the timeout
+            _cv.wait_for(lock, std::chrono::milliseconds(10));
+            _sleeping.store(false, std::memory_order_release);
+        }
+
+        // drain what was pushed before the sink was disabled
+        while(_ring->pop(r)) {
+            r.lgr.dispatch(std::move(r.msg));
+            _written.fetch_add(1, std::memory_order_release);
+        }
+    }
+
+private:
+    std::unique_ptr<ring_buffer<record>> _ring;
+    std::thread                          _thread;
+    std::mutex                           _mutex;
+    std::condition_variable              _cv;
+    bool                                 _stopping = false;
+
+    std::atomic<bool>     _enabled{false};
+    std::atomic<bool>     _sleeping{false};
+    std::atomic<uint64_t> _written{0};
+    std::atomic<uint64_t> _dropped{0};
+};
+
+}  // namespace internal
+
 logger::logger()
     : my(new impl()) {}
 
@@ -74,6 +304,16 @@ logger::is_enabled(log_level e) const {
 
 void
 logger::log(log_message m) {
+    auto& sink = internal::async_sink::instance();
+    if(sink.enabled()) {
+        sink.push(logger(*this), std::move(m));
+        return;
+    }
+    dispatch(std::move(m));
+}
+
+void
+logger::dispatch(log_message m) {
     m.context.append_context(my->_name);
 
     for(auto itr = my->_appenders.begin(); itr != my->_appenders.end(); ++itr) {
@@ -81,7 +321,7 @@ logger::log(log_message m) {
     }
 
     if(my->_additivity && my->_parent != nullptr) {
-        my->_parent.log(m);
+        my->_parent.dispatch(m);
     }
 }
 
@@ -143,6 +383,27 @@ logger::get_appenders() const {
     return my->_appenders;
 }
 
+void
+logger::set_async(uint32_t queue_size) {
+    auto& sink = internal::async_sink::instance();
+    if(queue_size > 0) {
+        sink.start(queue_size);
+    }
+    else {
+        sink.stop();
+    }
+}
+
+void
+logger::flush() {
+    internal::async_sink::instance().flush();
+}
+
+uint64_t
+logger::dropped_messages() {
+    return internal::async_sink::instance().dropped();
+}
+
 bool configure_logging(const logging_config& cfg);
 bool do_default_config = configure_logging(logging_config::default_config());
 
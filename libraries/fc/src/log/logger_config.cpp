@@ -36,6 +36,9 @@ configure_logging(const logging_config& cfg) {
 #ifndef FCLITE
         static bool reg_gelf_appender = appender::register_appender<gelf_appender>("gelf");
 #endif
+        // records queued before are still written by the old appenders
+        logger::flush();
+
         get_logger_map().clear();
         get_appender_map().clear();
 
@@ -62,6 +65,7 @@ configure_logging(const logging_config& cfg) {
                 }
             }
         }
+        logger::set_async(cfg.async_queue_size);
 #ifndef FCLITE
         return reg_console_appender || reg_gelf_appender;
 #else
@@ -0,0 +1,147 @@
+#include <fc/log/trace.hpp>
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include <fc/log/logger_config.hpp>
+
+namespace fc { namespace trace {
+
+namespace internal {
+
+std::atomic<bool> enabled{false};
+
+namespace {
+
+struct span {
+    const char* category;
+    const char* name;
+    int64_t     start_ns;
+    int64_t     end_ns;
+};
+
+struct thread_buffer {
+    std::mutex        mutex;  // only contended by `start` and `export_json`
+    std::string       thread_name;
+    uint32_t          tid = 0;
+    uint64_t          generation = 0;
+    std::vector<span> spans;
+};
+
+struct registry {
+    std::mutex                                  mutex;
+    std::vector<std::shared_ptr<thread_buffer>> buffers;  // kept after threads exit until exported
+    std::atomic<uint64_t>                       generation{0};
+    std::atomic<size_t>                         max_events{0};
+    std::atomic<uint64_t>                       dropped{0};
+};
+
+registry&
+get_registry() {
+    static auto r = new registry();
+    return *r;
+}
+
+thread_buffer&
+local_buffer() {
+    static thread_local std::shared_ptr<thread_buffer> buf;
+    if(!buf) {
+        auto& r = get_registry();
+
+        buf              = std::make_shared<thread_buffer>();
+        buf->thread_name = fc::get_thread_name();
+
+        auto lock = std::unique_lock<std::mutex>(r.mutex);
+        buf->tid  = r.buffers.size() + 1;
+        r.buffers.emplace_back(buf);
+    }
+    return *buf;
+}
+
+}  // namespace
+
+int64_t
+now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void
+record(const char* category, const char* name, int64_t start_ns, int64_t end_ns) {
+    auto& r   = get_registry();
+    auto& buf = local_buffer();
+    auto  gen = r.generation.load(std::memory_order_acquire);
+
+    auto lock = std::unique_lock<std::mutex>(buf.mutex);
+    if(buf.generation != gen) {
+        buf.spans.clear();
+        buf.generation = gen;
+    }
+    if(buf.spans.size() >= r.max_events.load(std::memory_order_relaxed)) {
+        r.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    buf.spans.emplace_back(span{ category, name, start_ns, end_ns });
+}
+
+}  // namespace internal
+
+void
+start(size_t max_events_per_thread) {
+    using namespace internal;
+
+    auto& r    = get_registry();
+    auto  lock = std::unique_lock<std::mutex>(r.mutex);
+
+    // buffers are cleared lazily by their own threads when they see the new generation
+    r.max_events.store(max_events_per_thread, std::memory_order_relaxed);
+    r.dropped.store(0, std::memory_order_relaxed);
+    r.generation.fetch_add(1, std::memory_order_release);
+    internal::enabled.store(true, std::memory_order_relaxed);
+}
+
+void
+stop() {
+    internal::enabled.store(false, std::memory_order_relaxed);
+}
+
+size_t
+export_json(std::ostream& out) {
+    using namespace internal;
+
+    auto& r    = get_registry();
+    auto  lock = std::unique_lock<std::mutex>(r.mutex);
+    auto  gen  = r.generation.load(std::memory_order_acquire);
+
+    auto n    = size_t(0);
+    auto line = fmt::memory_buffer();
+    auto sep  = "";
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    for(auto& buf : r.buffers) {
+        auto block = std::unique_lock<std::mutex>(buf->mutex);
+        if(buf->generation != gen || buf->spans.empty()) {
+            continue;
+        }
+
+        line.clear();
+        fmt::format_to(line, "{}\n{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":{},\"args\":{{\"name\":\"{}\"}}}}",
+            sep, buf->tid, buf->thread_name);
+        sep = ",";
+        for(auto& s : buf->spans) {
+            fmt::format_to(line, ",\n{{\"name\":\"{}\",\"cat\":\"{}\",\"ph\":\"X\",\"pid\":1,\"tid\":{},\"ts\":{:.3f},\"dur\":{:.3f}}}",
+                s.name, s.category, buf->tid, s.start_ns / 1000.0, (s.end_ns - s.start_ns) / 1000.0);
+        }
+        out.write(line.data(), line.size());
+        n += buf->spans.size();
+    }
+    out << "\n],\"otherData\":{\"dropped\":" << r.dropped.load(std::memory_order_relaxed) << "}}\n";
+
+    return n;
+}
+
+}}  // namespace fc::trace
@@ -44,6 +44,8 @@ public:
 #endif
                                     >;
    using connection_map = std::map<host_key, connection>;
+   using ssl_session_ptr = std::unique_ptr<SSL_SESSION, decltype(&SSL_SESSION_free)>;
+   using ssl_session_map = std::map<host_key, ssl_session_ptr>;
    using unix_url_split_map = std::map<string, fc::url>;
    using error_code = boost::system::error_code;
    using deadline_type = boost::posix_time::ptime;
@@ -211,6 +213,12 @@ public:
 
       ssl_socket->set_verify_callback(boost::asio::ssl::rfc2818_verification(*dest.host()));
 
+      // resume the last session of the host to skip the full handshake when reconnecting
+      auto session_itr = _ssl_sessions.find(key);
+      if (session_itr != _ssl_sessions.end()) {
+         SSL_set_session(ssl_socket->native_handle(), session_itr->second.get());
+      }
+
       error_code ec = sync_connect_with_timeout(ssl_socket->next_layer(), *dest.host(), dest.port() ? std::to_string(*dest.port()) : "443", deadline);
       if (!ec) {
          ec = sync_do_with_deadline(ssl_socket->next_layer(), deadline, [&ssl_socket](std::optional<error_code>& final_ec) {
@@ -221,6 +229,12 @@ public:
       }
       FC_ASSERT(!ec, "Failed to connect: ${message}", ("message",ec.message()));
 
+      auto session = SSL_get1_session(ssl_socket->native_handle());
+      if (session) {
+         _ssl_sessions.erase(key);
+         _ssl_sessions.emplace(key, ssl_session_ptr(session, &SSL_SESSION_free));
+      }
+
       auto res = _connections.emplace(std::piecewise_construct,
                                       std::forward_as_tuple(key),
                                       std::forward_as_tuple(std::move(ssl_socket)));
@@ -433,6 +447,7 @@ public:
    boost::asio::io_context  _ioc;
    ssl::context             _sslc;
    connection_map           _connections;
+   ssl_session_map          _ssl_sessions;
    unix_url_split_map       _unix_url_paths;
 };
 
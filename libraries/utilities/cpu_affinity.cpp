@@ -0,0 +1,249 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#include <evt/utilities/cpu_affinity.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <boost/algorithm/string.hpp>
+#include <boost/filesystem.hpp>
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <fc/exception/exception.hpp>
+
+namespace evt { namespace utilities { namespace affinity {
+
+namespace {
+
+const char* kSysCpu  = "/sys/devices/system/cpu/online";
+const char* kSysNode = "/sys/devices/system/node";
+
+uint32_t
+parse_uint(const std::string& s, const std::string& str) {
+    if(s.empty() || !std::all_of(s.begin(), s.end(), [](auto c) { return c >= '0' && c <= '9'; })) {
+        FC_THROW_EXCEPTION2(fc::parse_error_exception, "Invalid cpu list: '{}'", str);
+    }
+    try {
+        return (uint32_t)std::stoul(s);
+    }
+    catch(...) {
+        FC_THROW_EXCEPTION2(fc::parse_error_exception, "Invalid cpu list: '{}'", str);
+    }
+}
+
+// plain ranges only, the format of sysfs
+void
+parse_ranges(const std::string& str, cpu_list& cpus) {
+    auto parts = std::vector<std::string>();
+    boost::split(parts, str, boost::is_any_of(","));
+    for(auto& p : parts) {
+        boost::trim(p);
+        if(p.empty()) {
+            continue;
+        }
+        auto dash = p.find('-');
+        if(dash == std::string::npos) {
+            cpus.emplace_back(parse_uint(p, str));
+            continue;
+        }
+        auto first = parse_uint(p.substr(0, dash), str);
+        auto last  = parse_uint(p.substr(dash + 1), str);
+        if(first > last) {
+            FC_THROW_EXCEPTION2(fc::parse_error_exception, "Invalid cpu range '{}' in '{}'", p, str);
+        }
+        for(auto i = first; i <= last; i++) {
+            cpus.emplace_back(i);
+        }
+    }
+}
+
+void
+sort_unique(cpu_list& cpus) {
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+}
+
+bool
+read_line(const std::string& path, std::string& line) {
+    auto ifs = std::ifstream(path);
+    if(!ifs || !std::getline(ifs, line)) {
+        return false;
+    }
+    boost::trim(line);
+    return true;
+}
+
+}  // namespace
+
+cpu_list
+parse_cpu_list(const std::string& str) {
+    auto cpus  = cpu_list();
+    auto parts = std::vector<std::string>();
+    boost::split(parts, str, boost::is_any_of(","));
+    for(auto& p : parts) {
+        boost::trim(p);
+        if(!boost::starts_with(p, "node:")) {
+            parse_ranges(p, cpus);
+            continue;
+        }
+
+        auto id    = parse_uint(p.substr(5), str);
+        auto nodes = get_numa_nodes();
+        auto it    = std::find_if(nodes.begin(), nodes.end(), [id](auto& n) { return n.id == id; });
+        if(it == nodes.end()) {
+            FC_THROW_EXCEPTION2(fc::parse_error_exception, "Unknown NUMA node {} in cpu list: '{}'", id, str);
+        }
+        cpus.insert(cpus.end(), it->cpus.begin(), it->cpus.end());
+    }
+    sort_unique(cpus);
+    return cpus;
+}
+
+std::string
+format_cpu_list(const cpu_list& cpus) {
+    auto ss = std::stringstream();
+    for(auto i = 0u; i < cpus.size();) {
+        auto j = i;
+        while(j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1) {
+            j++;
+        }
+        if(i > 0) {
+            ss << ',';
+        }
+        ss << cpus[i];
+        if(j > i) {
+            ss << '-' << cpus[j];
+        }
+        i = j + 1;
+    }
+    return ss.str();
+}
+
+cpu_list
+get_online_cpus() {
+    auto cpus = cpu_list();
+    auto line = std::string();
+    if(read_line(kSysCpu, line)) {
+        try {
+            parse_ranges(line, cpus);
+        }
+        catch(...) {
+            cpus.clear();
+        }
+    }
+    if(cpus.empty()) {
+        auto n = std::max(std::thread::hardware_concurrency(), 1u);
+        for(auto i = 0u; i < n; i++) {
+            cpus.emplace_back(i);
+        }
+    }
+    sort_unique(cpus);
+    return cpus;
+}
+
+std::vector<numa_node>
+get_numa_nodes() {
+    namespace bfs = boost::filesystem;
+
+    auto nodes = std::vector<numa_node>();
+    auto ec    = boost::system::error_code();
+    for(auto it = bfs::directory_iterator(kSysNode, ec); !ec && it != bfs::directory_iterator(); it.increment(ec)) {
+        auto name = it->path().filename().string();
+        if(!boost::starts_with(name, "node") || name.size() == 4
+           || !std::all_of(name.begin() + 4, name.end(), [](auto c) { return c >= '0' && c <= '9'; })) {
+            continue;
+        }
+
+        auto node = numa_node();
+        auto line = std::string();
+        node.id   = (uint32_t)std::stoul(name.substr(4));
+        if(read_line((it->path() / "cpulist").string(), line)) {
+            try {
+                parse_ranges(line, node.cpus);
+            }
+            catch(...) {
+                continue;
+            }
+        }
+        sort_unique(node.cpus);
+        nodes.emplace_back(std::move(node));
+    }
+
+    if(nodes.empty()) {
+        nodes.emplace_back(numa_node { .id = 0, .cpus = get_online_cpus() });
+    }
+    std::sort(nodes.begin(), nodes.end(), [](auto& a, auto& b) { return a.id < b.id; });
+    return nodes;
+}
+
+std::string
+describe_topology() {
+    auto ss    = std::stringstream();
+    auto nodes = get_numa_nodes();
+    ss << get_online_cpus().size() << " online cpus, " << nodes.size() << " NUMA node(s)";
+    for(auto& n : nodes) {
+        ss << "\n  node " << n.id << ": cpus " << format_cpu_list(n.cpus);
+    }
+    return ss.str();
+}
+
+bool
+pin_current_thread(const cpu_list& cpus) {
+    if(cpus.empty()) {
+        return false;
+    }
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for(auto c : cpus) {
+        if(c >= CPU_SETSIZE) {
+            return false;
+        }
+        CPU_SET(c, &set);
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    return false;
+#endif
+}
+
+cpu_list
+get_current_affinity() {
+    auto cpus = cpu_list();
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if(pthread_getaffinity_np(pthread_self(), sizeof(set), &set) == 0) {
+        for(auto i = 0u; i < CPU_SETSIZE; i++) {
+            if(CPU_ISSET(i, &set)) {
+                cpus.emplace_back(i);
+            }
+        }
+    }
+#endif
+    return cpus;
+}
+
+scoped_pin::scoped_pin(const cpu_list& cpus) {
+    if(cpus.empty()) {
+        return;
+    }
+    prev_ = get_current_affinity();
+    if(!pin_current_thread(cpus)) {
+        prev_.clear();
+    }
+}
+
+scoped_pin::~scoped_pin() {
+    if(!prev_.empty()) {
+        pin_current_thread(prev_);
+    }
+}
+
+}}}  // namespace evt::utilities::affinity
@@ -0,0 +1,111 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include <vector>
+
+namespace evt { namespace utilities {
+
+/**
+ * Bloom filter growing with the keys added, keys are given by their 64-bit hashes.
+ * `may_contain` never misses an added key, and is wrong for other keys at a rate
+ * bounded by about 1% however many keys are added.
+ *
+ * Keys go to the last stage, a new stage of twice the capacity with more bits
+ * per key is added when it's full, so the false positive rates of all the stages
+ * sum up to a bounded one. Keys can't be removed, callers confirm positives
+ * with the real set when they must be exact.
+ * It's not thread safe, callers guard it themselves.
+ */
+class scalable_bloom_filter {
+public:
+    explicit scalable_bloom_filter(size_t initial_capacity = 64 * 1024)
+        : initial_capacity_(std::max(initial_capacity, (size_t)64)) {}
+
+public:
+    void
+    add(uint64_t hash) {
+        if(stages_.empty() || stages_.back().count >= stages_.back().capacity) {
+            add_stage();
+        }
+        auto& s = stages_.back();
+        probe(s, hash, [&](auto i) { s.bits[i / 64] |= (uint64_t)1 << (i % 64); return true; });
+        s.count++;
+        size_++;
+    }
+
+    bool
+    may_contain(uint64_t hash) const {
+        for(auto& s : stages_) {
+            if(probe(s, hash, [&](auto i) { return (s.bits[i / 64] & ((uint64_t)1 << (i % 64))) != 0; })) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void
+    clear() {
+        stages_.clear();
+        size_ = 0;
+    }
+
+    size_t size() const { return size_; }
+
+    size_t
+    memory_usage() const {
+        auto n = size_t(0);
+        for(auto& s : stages_) {
+            n += s.bits.size() * sizeof(uint64_t);
+        }
+        return n;
+    }
+
+private:
+    struct stage {
+        std::vector<uint64_t> bits;
+        uint64_t              nbits    = 0;
+        uint32_t              probes   = 0;
+        size_t                capacity = 0;
+        size_t                count    = 0;
+    };
+
+    void
+    add_stage() {
+        // 0.5% of false positives for the first stage, halved by each next one
+        auto n  = stages_.size();
+        auto bk = 11 + 2 * std::min(n, (size_t)8);  // bits per key
+
+        auto s     = stage();
+        s.capacity = initial_capacity_ << std::min(n, (size_t)32);
+        s.nbits    = (uint64_t)s.capacity * bk;
+        s.probes   = (uint32_t)(bk * 69 / 100);  // ln2 * bits per key
+        s.bits.resize((s.nbits + 63) / 64);
+        stages_.emplace_back(std::move(s));
+    }
+
+    // double hashing, the second hash is derived from the first one
+    template<typename Func>
+    static bool
+    probe(const stage& s, uint64_t h1, Func&& f) {
+        auto h2 = ((h1 >> 33) | (h1 << 31)) * 0x9E3779B97F4A7C15ull | 1;
+        for(auto i = 0u; i < s.probes; i++) {
+            if(!f((h1 + i * h2) % s.nbits)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    size_t             initial_capacity_;
+    size_t             size_ = 0;
+    std::vector<stage> stages_;
+};
+
+}}  // namespace evt::utilities
@@ -0,0 +1,54 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <boost/noncopyable.hpp>
+
+namespace evt { namespace utilities { namespace affinity {
+
+using cpu_list = std::vector<uint32_t>;  // sorted and unique
+
+struct numa_node {
+    uint32_t id = 0;
+    cpu_list cpus;
+};
+
+// parses lists like "0-3,8,10-11", "node:N" stands for all the CPUs of NUMA node N
+// throws `fc::parse_error_exception` if the list is malformed or names an unknown node
+cpu_list    parse_cpu_list(const std::string& str);
+std::string format_cpu_list(const cpu_list& cpus);
+
+// read from sysfs, a single node 0 with all the online CPUs where it's not available
+cpu_list               get_online_cpus();
+std::vector<numa_node> get_numa_nodes();
+
+// one line per NUMA node with its CPUs, logged at startup
+std::string describe_topology();
+
+// pins the calling thread to the CPUs, returns false if it failed or isn't supported on this platform
+// memory touched first by a pinned thread is allocated on its NUMA node by the default policy of the kernel
+bool     pin_current_thread(const cpu_list& cpus);
+cpu_list get_current_affinity();
+
+/**
+ * Pins the calling thread for the lifetime of the object and restores its previous affinity afterwards
+ *
+ * Threads created in the meantime inherit the pinned set, that's the way to place the threads
+ * started by third-party libraries (the background threads of RocksDB) without their help.
+ * Empty lists leave the thread alone.
+ */
+class scoped_pin : boost::noncopyable {
+public:
+    explicit scoped_pin(const cpu_list& cpus);
+    ~scoped_pin();
+
+private:
+    cpu_list prev_;
+};
+
+}}}  // namespace evt::utilities::affinity
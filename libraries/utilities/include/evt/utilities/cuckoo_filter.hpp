@@ -0,0 +1,214 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include <vector>
+
+namespace evt { namespace utilities {
+
+/**
+ * Cuckoo filter of a set of keys given by their 64-bit hashes, unlike bloom filters
+ * keys can be removed. `may_contain` never misses a key added and not removed, and
+ * is wrong for other keys at a rate of about 0.01%.
+ *
+ * A key is kept as a 16-bit fingerprint in one of its two buckets of 4 slots, the
+ * other bucket is derived from the fingerprint so keys can be moved around without
+ * their hashes. Only keys which were added can be removed, otherwise the ones of
+ * other keys sharing the fingerprint may be lost.
+ *
+ * It doesn't grow, it's sized for the capacity given at 90% load. `add` fails once
+ * the slots are about full, callers then rebuild a larger one from their keys.
+ * It's not thread safe, callers guard it themselves.
+ */
+class cuckoo_filter {
+public:
+    static constexpr size_t kSlots    = 4;    // slots per bucket
+    static constexpr size_t kMaxKicks = 500;  // moves of other keys before giving up
+
+public:
+    explicit cuckoo_filter(size_t capacity = 64 * 1024) { reset(capacity); }
+
+public:
+    // returns false when it's full, the key is still added but no more keys can be
+    bool
+    add(uint64_t hash) {
+        if(victim_.used) {
+            return false;
+        }
+
+        size_++;
+        return place(index(hash), fingerprint(hash));
+    }
+
+    bool
+    remove(uint64_t hash) {
+        auto fp = fingerprint(hash);
+        auto i1 = index(hash);
+        auto i2 = alt_index(i1, fp);
+        if(victim_.used && victim_.fp == fp && (victim_.index == i1 || victim_.index == i2)) {
+            victim_.used = false;
+            size_--;
+            return true;
+        }
+        if(!erase(i1, fp) && !erase(i2, fp)) {
+            return false;
+        }
+        size_--;
+
+        // the key left out when it was full may have room now
+        if(victim_.used) {
+            victim_.used = false;
+            place(victim_.index, victim_.fp);
+        }
+        return true;
+    }
+
+    bool
+    may_contain(uint64_t hash) const {
+        auto fp = fingerprint(hash);
+        auto i1 = index(hash);
+        auto i2 = alt_index(i1, fp);
+        if(victim_.used && victim_.fp == fp && (victim_.index == i1 || victim_.index == i2)) {
+            return true;
+        }
+        return find(i1, fp) || find(i2, fp);
+    }
+
+    // drops all the keys, sized for `capacity` ones
+    void
+    reset(size_t capacity) {
+        auto buckets = size_t(1);
+        while(buckets * kSlots * 9 / 10 < capacity) {
+            buckets <<= 1;
+        }
+        table_.assign(buckets * kSlots, 0);
+        mask_   = buckets - 1;
+        size_   = 0;
+        victim_ = victim();
+    }
+
+    void clear() { reset(0); }
+
+    size_t size() const { return size_; }
+    size_t capacity() const { return table_.size() * 9 / 10; }
+    bool   full() const { return victim_.used; }
+
+    size_t memory_usage() const { return table_.size() * sizeof(uint16_t); }
+
+public:
+    template<typename Stream>
+    void
+    write(Stream& s) const {
+        uint64_t header[] = { table_.size(), size_, victim_.used, victim_.index, victim_.fp };
+        s.write((const char*)header, sizeof(header));
+        s.write((const char*)table_.data(), table_.size() * sizeof(uint16_t));
+    }
+
+    // returns false when the content is not one written by `write`
+    template<typename Stream>
+    bool
+    read(Stream& s) {
+        uint64_t header[5];
+        s.read((char*)header, sizeof(header));
+
+        auto slots = header[0];
+        if(slots < kSlots || slots % kSlots != 0 || ((slots / kSlots) & (slots / kSlots - 1)) != 0 || header[1] > slots + 1) {
+            return false;
+        }
+        table_.resize(slots);
+        s.read((char*)table_.data(), slots * sizeof(uint16_t));
+
+        mask_   = slots / kSlots - 1;
+        size_   = header[1];
+        victim_ = { header[2] != 0, (size_t)(header[3] & mask_), (uint16_t)header[4] };
+        return true;
+    }
+
+private:
+    struct victim {
+        bool     used  = false;
+        size_t   index = 0;
+        uint16_t fp    = 0;
+    };
+
+    // fingerprint is taken from the high bits and bucket from the low bits, 0 marks a free slot
+    static uint16_t
+    fingerprint(uint64_t hash) {
+        auto fp = (uint16_t)(hash >> 48);
+        return fp ? fp : 1;
+    }
+
+    size_t index(uint64_t hash) const { return hash & mask_; }
+
+    // same function for both buckets, the other one of `alt_index(i)` is `i`
+    size_t alt_index(size_t i, uint16_t fp) const { return (i ^ (fp * 0x5bd1e995ull)) & mask_; }
+
+    // the fingerprint left out is kept as the victim when no slot is found
+    bool
+    place(size_t i, uint16_t fp) {
+        if(insert(i, fp) || insert(alt_index(i, fp), fp)) {
+            return true;
+        }
+
+        // move a random fingerprint of the bucket to its other bucket, until one has a free slot
+        for(auto n = 0u; n < kMaxKicks; n++) {
+            std::swap(fp, table_[i * kSlots + next_random() % kSlots]);
+            i = alt_index(i, fp);
+            if(insert(i, fp)) {
+                return true;
+            }
+        }
+        victim_ = { true, i, fp };
+        return false;
+    }
+
+    bool
+    insert(size_t i, uint16_t fp) {
+        auto b = &table_[i * kSlots];
+        for(auto j = 0u; j < kSlots; j++) {
+            if(b[j] == 0) {
+                b[j] = fp;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool
+    erase(size_t i, uint16_t fp) {
+        auto b = &table_[i * kSlots];
+        for(auto j = 0u; j < kSlots; j++) {
+            if(b[j] == fp) {
+                b[j] = 0;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool
+    find(size_t i, uint16_t fp) const {
+        auto b = &table_[i * kSlots];
+        return std::find(b, b + kSlots, fp) != b + kSlots;
+    }
+
+    uint64_t
+    next_random() {
+        rand_ = rand_ * 6364136223846793005ull + 1442695040888963407ull;
+        return rand_ >> 33;
+    }
+
+private:
+    std::vector<uint16_t> table_;
+    size_t                mask_ = 0;
+    size_t                size_ = 0;
+    victim                victim_;
+    uint64_t              rand_ = 0;
+};
+
+}}  // namespace evt::utilities
@@ -0,0 +1,207 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+
+#include <stdint.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <vector>
+#include <boost/noncopyable.hpp>
+
+namespace evt { namespace utilities {
+
+/**
+ * Bounded ring of one producer and several consumers, each of them reading every item
+ *
+ * Every consumer has its own cursor and its own limit: the producer waits only while some
+ * consumer is that many items behind, so the others keep reading. An item is released once
+ * the slowest consumer read it. A consumer acknowledges what it read after handling it, the
+ * lag is counted from there, which lets others wait until it has caught up.
+ */
+template <typename T>
+class fanout_queue : boost::noncopyable {
+public:
+    using consumer_id = uint32_t;
+
+    struct consumer_stats {
+        uint64_t lag     = 0;  // published and not acknowledged yet
+        uint64_t max_lag = 0;
+        uint64_t read    = 0;
+        uint64_t stalls  = 0;  // times the producer waited for this consumer
+    };
+
+public:
+    explicit fanout_queue(size_t capacity)
+        : ring_(std::max<size_t>(capacity, 1)) {}
+
+public:
+    // the consumer starts at the next published item, limit is clamped to the capacity
+    consumer_id
+    subscribe(size_t limit) {
+        auto lock = std::lock_guard(mtx_);
+
+        auto id = next_id_++;
+        auto& c = consumers_[id];
+        c.cursor = c.acked = head_;
+        c.limit  = std::clamp<size_t>(limit, 1, ring_.size());
+        return id;
+    }
+
+    // wakes the consumer if it is waiting, its pops return nothing afterwards
+    void
+    unsubscribe(consumer_id id) {
+        {
+            auto lock = std::lock_guard(mtx_);
+            consumers_.erase(id);
+            release();
+        }
+        not_empty_.notify_all();
+        not_full_.notify_all();
+        idle_.notify_all();
+    }
+
+    bool
+    has_consumers() const {
+        auto lock = std::lock_guard(mtx_);
+        return !consumers_.empty();
+    }
+
+    void
+    push(T v) {
+        auto lock = std::unique_lock(mtx_);
+        auto full = [&] {
+            return std::any_of(consumers_.begin(), consumers_.end(), [&](auto& it) {
+                return head_ - it.second.cursor >= it.second.limit;
+            });
+        };
+        if(full()) {
+            for(auto& it : consumers_) {
+                if(head_ - it.second.cursor >= it.second.limit) {
+                    it.second.stats.stalls++;
+                }
+            }
+            not_full_.wait(lock, [&] { return !full(); });
+        }
+        if(consumers_.empty()) {
+            return;
+        }
+
+        ring_[head_ % ring_.size()] = std::move(v);
+        head_++;
+        for(auto& it : consumers_) {
+            auto& s   = it.second.stats;
+            s.max_lag = std::max(s.max_lag, head_ - it.second.acked);
+        }
+        lock.unlock();
+        not_empty_.notify_all();
+    }
+
+    /**
+     * Appends up to `max` items for the consumer to `out`, waiting at most `timeout` for the
+     * first one. Returns the number appended, 0 on timeout or once unsubscribed.
+     */
+    template <typename Container, typename Rep, typename Period>
+    size_t
+    pop(consumer_id id, Container& out, size_t max, std::chrono::duration<Rep, Period> timeout) {
+        auto n = size_t(0);
+        {
+            auto lock = std::unique_lock(mtx_);
+            auto it   = consumers_.find(id);
+            if(it == consumers_.end()) {
+                return 0;
+            }
+            auto ready = [&] { return !consumers_.count(id) || it->second.cursor < head_; };
+            if(!not_empty_.wait_for(lock, timeout, ready) || !consumers_.count(id)) {
+                return 0;
+            }
+
+            auto& c = it->second;
+            n = std::min<uint64_t>(max, head_ - c.cursor);
+            for(auto i = 0u; i < n; i++) {
+                out.emplace_back(ring_[(c.cursor + i) % ring_.size()]);
+            }
+            c.cursor += n;
+            c.stats.read += n;
+            release();
+        }
+        not_full_.notify_all();
+        return n;
+    }
+
+    // every item the consumer popped so far was handled
+    void
+    ack(consumer_id id) {
+        {
+            auto lock = std::lock_guard(mtx_);
+            auto it   = consumers_.find(id);
+            if(it == consumers_.end()) {
+                return;
+            }
+            it->second.acked = it->second.cursor;
+        }
+        idle_.notify_all();
+    }
+
+    // waits until the consumer acknowledged every item published so far
+    void
+    wait_idle(consumer_id id) const {
+        auto lock = std::unique_lock(mtx_);
+        idle_.wait(lock, [&] {
+            auto it = consumers_.find(id);
+            return it == consumers_.end() || it->second.acked == head_;
+        });
+    }
+
+    consumer_stats
+    stats(consumer_id id) const {
+        auto lock = std::lock_guard(mtx_);
+        auto it   = consumers_.find(id);
+        if(it == consumers_.end()) {
+            return consumer_stats();
+        }
+        auto s = it->second.stats;
+        s.lag  = head_ - it->second.acked;
+        return s;
+    }
+
+    size_t capacity() const { return ring_.size(); }
+
+private:
+    struct consumer {
+        uint64_t       cursor = 0;  // next item to read
+        uint64_t       acked  = 0;
+        size_t         limit  = 0;
+        consumer_stats stats;
+    };
+
+    // drops the items every consumer has read
+    void
+    release() {
+        auto tail = head_;
+        for(auto& it : consumers_) {
+            tail = std::min(tail, it.second.cursor);
+        }
+        for(; tail_ < tail; tail_++) {
+            ring_[tail_ % ring_.size()] = T();
+        }
+    }
+
+private:
+    mutable std::mutex              mtx_;
+    std::condition_variable         not_empty_;
+    std::condition_variable         not_full_;
+    mutable std::condition_variable idle_;
+
+    std::vector<T>                  ring_;
+    uint64_t                        head_    = 0;  // next item to publish
+    uint64_t                        tail_    = 0;  // oldest item still held
+    consumer_id                     next_id_ = 0;
+    std::map<consumer_id, consumer> consumers_;
+};
+
+}}  // namespace evt::utilities
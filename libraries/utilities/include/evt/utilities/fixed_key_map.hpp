@@ -0,0 +1,279 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <deque>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <boost/noncopyable.hpp>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace evt { namespace utilities {
+
+/**
+ * Hash map whose keys all have `N` bytes, stored inline in the entries along with their hashes.
+ * Lookups hash the fixed-size keys without allocating, and probe the table 16 slots at a time
+ * by comparing one control byte per slot, holding 7 bits of the hash, with SSE2 when available.
+ *
+ * Entries never move once inserted, so pointers to them are stable until they are erased.
+ * Keys of other sizes are never found and can't be inserted. It's not thread safe.
+ */
+template<size_t N, typename T>
+class fixed_key_map : boost::noncopyable {
+public:
+    static constexpr size_t kKeySize = N;
+
+    struct value_type {
+    public:
+        std::string_view key() const { return std::string_view(k, N); }
+
+    public:
+        T second;
+
+    private:
+        char     k[N];
+        uint64_t hash;
+        uint32_t slot;  // kNoSlot when the entry is free
+
+        friend class fixed_key_map;
+    };
+
+public:
+    static uint64_t
+    hash_key(const char* k) {
+        auto h = (uint64_t)N * 0x9E3779B97F4A7C15ull;
+        auto i = size_t(0);
+        for(; i + 8 <= N; i += 8) {
+            auto w = uint64_t(0);
+            memcpy(&w, k + i, 8);
+            h = mix(h ^ w);
+        }
+        if constexpr(N % 8 != 0) {
+            auto w = uint64_t(0);
+            memcpy(&w, k + i, N - i);
+            h = mix(h ^ w);
+        }
+        return h;
+    }
+
+public:
+    value_type*
+    find(const std::string_view& key) {
+        if(key.size() != N || size_ == 0) {
+            return nullptr;
+        }
+        auto s = find_slot(key.data(), hash_key(key.data()));
+        return s == kNoSlot ? nullptr : &entries_[slots_[s]];
+    }
+
+    const value_type*
+    find(const std::string_view& key) const {
+        return const_cast<fixed_key_map*>(this)->find(key);
+    }
+
+    // returns the entry and whether it's inserted, the value of an inserted one is default constructed
+    std::pair<value_type*, bool>
+    try_emplace(const std::string_view& key) {
+        assert(key.size() == N);
+
+        auto h = hash_key(key.data());
+        if(size_ > 0) {
+            auto s = find_slot(key.data(), h);
+            if(s != kNoSlot) {
+                return std::make_pair(&entries_[slots_[s]], false);
+            }
+        }
+        if((size_ + deleted_ + 1) * 8 > ctrl_.size() * 7) {
+            // only rehash in place when most of the used slots are deleted ones
+            rehash(size_ * 2 >= ctrl_.size() * 7 / 8 ? std::max(ctrl_.size() * 2, kGroupSize) : ctrl_.size());
+        }
+
+        auto idx = uint32_t(0);
+        if(!free_.empty()) {
+            idx = free_.back();
+            free_.pop_back();
+        }
+        else {
+            idx = (uint32_t)entries_.size();
+            entries_.emplace_back();
+        }
+
+        auto& e = entries_[idx];
+        memcpy(e.k, key.data(), N);
+        e.hash = h;
+        e.slot = insert_slot(h, idx);
+        size_++;
+        return std::make_pair(&e, true);
+    }
+
+    void
+    erase(value_type* e) {
+        assert(e->slot != kNoSlot);
+
+        ctrl_[e->slot] = kDeleted;
+        deleted_++;
+        size_--;
+
+        free_.emplace_back(slots_[e->slot]);
+        e->slot   = kNoSlot;
+        e->second = T();  // releases the memory held by the value
+    }
+
+    // releases all the memory
+    void
+    clear() {
+        entries_ = decltype(entries_)();
+        free_    = decltype(free_)();
+        ctrl_    = decltype(ctrl_)();
+        slots_   = decltype(slots_)();
+        size_    = 0;
+        deleted_ = 0;
+    }
+
+    template<typename Func>
+    void
+    for_each(Func&& f) const {
+        for(auto& e : entries_) {
+            if(e.slot != kNoSlot) {
+                f(e);
+            }
+        }
+    }
+
+    size_t size() const { return size_; }
+    bool   empty() const { return size_ == 0; }
+
+    // the memory held by values is not counted
+    size_t
+    memory_usage() const {
+        return entries_.size() * sizeof(value_type) + free_.capacity() * sizeof(uint32_t)
+            + ctrl_.capacity() + slots_.capacity() * sizeof(uint32_t);
+    }
+
+private:
+    static constexpr size_t   kGroupSize = 16;
+    static constexpr uint32_t kNoSlot    = (uint32_t)-1;
+    static constexpr int8_t   kEmpty     = -128;
+    static constexpr int8_t   kDeleted   = -2;
+
+    static uint64_t
+    mix(uint64_t h) {
+        h *= 0xbf58476d1ce4e5b9ull;
+        return h ^ (h >> 31);
+    }
+
+    static int8_t h2(uint64_t h) { return (int8_t)(h & 0x7f); }
+
+    // bit i is set when the control byte i of the group is `b`
+    static uint32_t
+    match(const int8_t* g, int8_t b) {
+#if defined(__SSE2__)
+        auto v = _mm_loadu_si128((const __m128i*)g);
+        return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(b)));
+#else
+        auto m = uint32_t(0);
+        for(auto i = 0u; i < kGroupSize; i++) {
+            m |= (uint32_t)(g[i] == b) << i;
+        }
+        return m;
+#endif
+    }
+
+    // bit i is set when the control byte i of the group is empty or deleted, both are negative
+    static uint32_t
+    match_free(const int8_t* g) {
+#if defined(__SSE2__)
+        return (uint32_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)g));
+#else
+        auto m = uint32_t(0);
+        for(auto i = 0u; i < kGroupSize; i++) {
+            m |= (uint32_t)(g[i] < 0) << i;
+        }
+        return m;
+#endif
+    }
+
+    // groups are probed triangularly, which visits all of them as their number is a power of 2
+    template<typename Func>
+    size_t
+    probe(uint64_t h, Func&& f) const {
+        auto mask = ctrl_.size() / kGroupSize - 1;
+        auto g    = (size_t)(h >> 7) & mask;
+        for(auto i = 1u; ; i++) {
+            auto r = f(g * kGroupSize);
+            if(r != kNoSlot) {
+                return r;
+            }
+            g = (g + i) & mask;
+        }
+    }
+
+    size_t
+    find_slot(const char* k, uint64_t h) const {
+        auto b = h2(h);
+        auto s = probe(h, [&](size_t base) -> size_t {
+            auto g = &ctrl_[base];
+            for(auto m = match(g, b); m != 0; m &= m - 1) {
+                auto  s = base + __builtin_ctz(m);
+                auto& e = entries_[slots_[s]];
+                if(e.hash == h && memcmp(e.k, k, N) == 0) {
+                    return s;
+                }
+            }
+            // an empty slot ends the probing, the key would have been put there
+            return match(g, kEmpty) != 0 ? kNotFound : kNoSlot;
+        });
+        return s == kNotFound ? kNoSlot : s;
+    }
+
+    uint32_t
+    insert_slot(uint64_t h, uint32_t idx) {
+        auto s = probe(h, [&](size_t base) -> size_t {
+            auto m = match_free(&ctrl_[base]);
+            return m != 0 ? base + __builtin_ctz(m) : kNoSlot;
+        });
+        if(ctrl_[s] == kDeleted) {
+            deleted_--;
+        }
+        ctrl_[s]  = h2(h);
+        slots_[s] = idx;
+        return (uint32_t)s;
+    }
+
+    void
+    rehash(size_t capacity) {
+        ctrl_.assign(capacity, kEmpty);
+        slots_.assign(capacity, 0);
+        deleted_ = 0;
+        for(auto i = 0u; i < entries_.size(); i++) {
+            auto& e = entries_[i];
+            if(e.slot != kNoSlot) {
+                e.slot = insert_slot(e.hash, i);
+            }
+        }
+    }
+
+private:
+    static constexpr size_t kNotFound = kNoSlot - 1;
+
+    std::deque<value_type> entries_;  // never moved, free ones are reused
+    std::vector<uint32_t>  free_;     // indexes of the free entries
+    std::vector<int8_t>    ctrl_;     // 7 bits of the hash of each slot, or kEmpty or kDeleted
+    std::vector<uint32_t>  slots_;    // index of the entry of each slot
+
+    size_t size_    = 0;
+    size_t deleted_ = 0;
+};
+
+}}  // namespace evt::utilities
@@ -0,0 +1,176 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <boost/noncopyable.hpp>
+#include <fc/exception/exception.hpp>
+
+namespace evt { namespace utilities {
+
+namespace internal {
+
+struct slot_state {
+    std::atomic<uint32_t> gen = 0;  // odd while a slot is connected, bumped by each connect and disconnect
+};
+
+}  // namespace internal
+
+enum class slot_position { at_front, at_back };
+
+class signal_connection {
+public:
+    signal_connection() = default;
+    signal_connection(std::shared_ptr<internal::slot_state> state, uint32_t gen)
+        : state_(std::move(state)), gen_(gen) {}
+
+public:
+    // safe from any thread and after the signal is gone, a slot being called meanwhile still returns
+    void
+    disconnect() {
+        if(state_) {
+            auto g = gen_;
+            state_->gen.compare_exchange_strong(g, gen_ + 1);
+            state_.reset();
+        }
+    }
+
+    bool connected() const { return state_ && state_->gen.load() == gen_; }
+
+private:
+    std::shared_ptr<internal::slot_state> state_;
+    uint32_t                              gen_ = 0;
+};
+
+class scoped_signal_connection : public signal_connection {
+public:
+    scoped_signal_connection() = default;
+    scoped_signal_connection(const signal_connection& c) : signal_connection(c) {}
+    scoped_signal_connection(scoped_signal_connection&&) = default;
+    scoped_signal_connection(const scoped_signal_connection&) = delete;
+    ~scoped_signal_connection() { disconnect(); }
+
+    scoped_signal_connection&
+    operator=(const signal_connection& c) {
+        disconnect();
+        signal_connection::operator=(c);
+        return *this;
+    }
+
+    scoped_signal_connection&
+    operator=(scoped_signal_connection&& c) {
+        if(this != &c) {
+            disconnect();
+            signal_connection::operator=(std::move(c));
+        }
+        return *this;
+    }
+
+    scoped_signal_connection& operator=(const scoped_signal_connection&) = delete;
+};
+
+template<typename Signature, size_t N = 16>
+class fixed_signal;
+
+/**
+ * Signal of at most `N` slots for the events emitted for every transaction or every block.
+ * Emitting calls the connected slots in order without taking any lock or copying the slot list,
+ * a slot costs one atomic load and one indirect call.
+ *
+ * Slots are connected while the signal is not being emitted, like plugins do at startup, which
+ * is not checked. Connections may be disconnected at any time from any thread. Disconnected
+ * slots keep their places until another slot is connected.
+ */
+template<typename... Args, size_t N>
+class fixed_signal<void(Args...), N> : boost::noncopyable {
+public:
+    using slot_type = std::function<void(Args...)>;
+
+    fixed_signal() {
+        for(auto& e : entries_) {
+            e.state = std::make_shared<internal::slot_state>();
+        }
+    }
+
+public:
+    signal_connection
+    connect(slot_type f, slot_position pos = slot_position::at_back) {
+        // drops the disconnected slots first, their entries are reused
+        auto n = size_t(0);
+        for(auto i = 0u; i < size_; i++) {
+            if(connected(order_[i])) {
+                order_[n++] = order_[i];
+            }
+        }
+        size_ = n;
+        FC_ASSERT(size_ < N, "More than ${n} slots are connected to a signal", ("n", N));
+
+        auto idx = 0u;
+        while(connected(idx)) {
+            idx++;
+        }
+
+        auto& e = entries_[idx];
+        e.fn    = std::move(f);
+
+        auto gen = e.state->gen.load() + 1;
+        e.state->gen.store(gen, std::memory_order_release);
+
+        if(pos == slot_position::at_front) {
+            std::move_backward(order_.begin(), order_.begin() + size_, order_.begin() + size_ + 1);
+            order_[0] = (uint8_t)idx;
+        }
+        else {
+            order_[size_] = (uint8_t)idx;
+        }
+        size_++;
+        return signal_connection(e.state, gen);
+    }
+
+    void
+    operator()(Args... args) const {
+        for(auto i = 0u; i < size_; i++) {
+            auto& e = entries_[order_[i]];
+            if(e.state->gen.load(std::memory_order_acquire) & 1) {
+                e.fn(args...);
+            }
+        }
+    }
+
+    size_t
+    num_slots() const {
+        auto n = size_t(0);
+        for(auto i = 0u; i < size_; i++) {
+            n += connected(order_[i]);
+        }
+        return n;
+    }
+
+    bool empty() const { return num_slots() == 0; }
+
+private:
+    static_assert(N <= 256, "slots are ordered by 8-bit indexes");
+
+    bool connected(size_t idx) const { return entries_[idx].state->gen.load() & 1; }
+
+private:
+    struct entry {
+        slot_type                             fn;
+        std::shared_ptr<internal::slot_state> state;  // shared with the connections, which may outlive the signal
+    };
+
+    std::array<entry, N>   entries_;
+    std::array<uint8_t, N> order_;  // indexes of the entries in calling order
+    size_t                 size_ = 0;
+};
+
+}}  // namespace evt::utilities
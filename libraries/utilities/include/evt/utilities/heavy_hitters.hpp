@@ -0,0 +1,89 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+
+#include <stdint.h>
+#include <algorithm>
+#include <map>
+#include <vector>
+
+namespace evt { namespace utilities {
+
+/**
+ * Space-saving counter of the most frequent keys in a stream, it keeps at most `capacity` keys.
+ * When it's full, a new key replaces the least counted one and inherits its count as the error,
+ * so `count` overestimates the real one by at most `error`, and any key seen more than
+ * total / capacity times is guaranteed to be kept.
+ * It's not thread safe, callers guard it themselves.
+ */
+template<typename Key>
+class heavy_hitters {
+public:
+    struct counter {
+        Key      key;
+        uint64_t count = 0;
+        uint64_t error = 0;
+    };
+
+public:
+    explicit heavy_hitters(size_t capacity)
+        : capacity_(std::max(capacity, (size_t)1)) {}
+
+public:
+    void
+    add(const Key& key, uint64_t n = 1) {
+        total_ += n;
+
+        auto it = index_.find(key);
+        if(it != index_.end()) {
+            counters_[it->second].count += n;
+            return;
+        }
+        if(counters_.size() < capacity_) {
+            index_.emplace(key, counters_.size());
+            counters_.emplace_back(counter{ key, n, 0 });
+            return;
+        }
+
+        // capacity is small, a linear scan is cheaper than keeping counters ordered
+        auto i = std::min_element(counters_.begin(), counters_.end(), [](auto& a, auto& b) { return a.count < b.count; }) - counters_.begin();
+        auto& c = counters_[i];
+        index_.erase(c.key);
+        index_.emplace(key, i);
+
+        c.key   = key;
+        c.error = c.count;
+        c.count += n;
+    }
+
+    // the `n` most counted keys in descending order
+    std::vector<counter>
+    top(size_t n) const {
+        auto v = counters_;
+        n = std::min(n, v.size());
+        std::partial_sort(v.begin(), v.begin() + n, v.end(), [](auto& a, auto& b) { return a.count > b.count; });
+        v.resize(n);
+        return v;
+    }
+
+    void
+    clear() {
+        counters_.clear();
+        index_.clear();
+        total_ = 0;
+    }
+
+    size_t   capacity() const { return capacity_; }
+    size_t   size() const { return counters_.size(); }
+    uint64_t total() const { return total_; }
+
+private:
+    size_t                capacity_;
+    uint64_t              total_ = 0;
+    std::vector<counter>  counters_;
+    std::map<Key, size_t> index_;
+};
+
+}}  // namespace evt::utilities
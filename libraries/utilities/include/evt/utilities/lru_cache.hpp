@@ -0,0 +1,104 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <boost/noncopyable.hpp>
+
+namespace evt { namespace utilities {
+
+/**
+ * Bounded LRU map from strings shared by several threads, split into shards by the hash of the
+ * key, each one guarded by its own mutex. A capacity of 0 disables it.
+ */
+template<typename V>
+class lru_cache : boost::noncopyable {
+public:
+    static constexpr size_t kShardsNum = 8;
+
+public:
+    explicit lru_cache(size_t capacity)
+        : capacity_(capacity) {}
+
+public:
+    bool
+    get(const std::string& key, V& v) {
+        if(capacity_.load(std::memory_order_relaxed) == 0) {
+            return false;
+        }
+        auto& sd   = get_shard(key);
+        auto  lock = std::lock_guard(sd.mtx);
+        auto  it   = sd.index.find(key);
+        if(it == sd.index.end()) {
+            misses_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        sd.lru.splice(sd.lru.begin(), sd.lru, it->second);
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        v = it->second->second;
+        return true;
+    }
+
+    void
+    put(const std::string& key, const V& v) {
+        auto capacity = capacity_.load(std::memory_order_relaxed);
+        if(capacity == 0) {
+            return;
+        }
+        auto cap = std::max(capacity / kShardsNum, (size_t)1);
+        auto& sd   = get_shard(key);
+        auto  lock = std::lock_guard(sd.mtx);
+        if(sd.index.find(key) != sd.index.end()) {
+            return;
+        }
+        sd.lru.emplace_front(key, v);
+        sd.index.emplace(key, sd.lru.begin());
+        while(sd.lru.size() > cap) {
+            sd.index.erase(sd.lru.back().first);
+            sd.lru.pop_back();
+        }
+    }
+
+    void
+    set_capacity(size_t capacity) {
+        capacity_ = capacity;
+        for(auto& sd : shards_) {
+            auto lock = std::lock_guard(sd.mtx);
+            sd.lru.clear();
+            sd.index.clear();
+        }
+    }
+
+    uint64_t hits() const { return hits_.load(std::memory_order_relaxed); }
+    uint64_t misses() const { return misses_.load(std::memory_order_relaxed); }
+
+private:
+    using list_type = std::list<std::pair<std::string, V>>;
+
+    struct shard {
+        std::mutex                                                    mtx;
+        list_type                                                     lru;
+        std::unordered_map<std::string, typename list_type::iterator> index;
+    };
+
+    shard&
+    get_shard(const std::string& key) {
+        return shards_[std::hash<std::string>()(key) % kShardsNum];
+    }
+
+private:
+    shard                 shards_[kShardsNum];
+    std::atomic<size_t>   capacity_;
+    std::atomic<uint64_t> hits_     {0};
+    std::atomic<uint64_t> misses_   {0};
+};
+
+}}  // namespace evt::utilities
@@ -0,0 +1,75 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+
+#include <stdint.h>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <boost/noncopyable.hpp>
+
+namespace evt { namespace utilities { namespace memory {
+
+struct component_usage {
+    std::string name;
+    uint64_t    bytes  = 0;
+    uint64_t    items  = 0;  // entries, blocks or messages, whatever the component holds
+    uint64_t    budget = 0;  // soft budget in bytes, 0 means unlimited
+
+    bool over_budget() const { return budget > 0 && bytes > budget; }
+};
+
+// fills `bytes` and `items` of the usage
+using usage_func = std::function<void(component_usage&)>;
+
+// called with the usage whenever budgets are enforced, caches shrink themselves
+// when they're over the budget, queues hold back their producers until they're under it again
+using enforce_func = std::function<void(const component_usage&)>;
+
+using component_id = uint64_t;
+
+/**
+ * Process wide accounting of the memory held by each component
+ *
+ * Components report their own usage, which are counted already in most of them
+ * (sizes of caches and queues), so nothing is tracked per allocation here.
+ * Budgets are set by names and may be set before the components are added.
+ */
+class accountant : boost::noncopyable {
+public:
+    static accountant& get();
+
+public:
+    component_id add_component(const std::string& name, usage_func usage, enforce_func enforce = {});
+    void         remove_component(component_id id);
+
+    void     set_budget(const std::string& name, uint64_t bytes);
+    uint64_t get_budget(const std::string& name) const;
+
+    std::vector<component_usage> get_usage() const;
+
+    // calls the enforce functions of the components with their usage
+    // it's called on the thread owning the components, usually the main one
+    void enforce();
+
+private:
+    struct component {
+        std::string  name;
+        usage_func   usage;
+        enforce_func enforce;
+    };
+
+    component_usage get_usage(const component& c) const;
+
+private:
+    mutable std::mutex                mutex_;
+    std::map<component_id, component> components_;
+    std::map<std::string, uint64_t>   budgets_;
+    component_id                      next_id_ = 1;
+};
+
+}}}  // namespace evt::utilities::memory
@@ -0,0 +1,169 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+
+#include <stdint.h>
+#include <array>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include <boost/noncopyable.hpp>
+
+namespace evt { namespace utilities { namespace metrics {
+
+using labels = std::vector<std::pair<std::string, std::string>>;
+
+namespace internal {
+
+constexpr size_t shard_count = 16;
+
+// threads are spread over the shards in the order they first update any metric
+size_t current_shard();
+
+}  // namespace internal
+
+/**
+ * Monotonic counter, each thread adds to its own cache line so hot paths
+ * don't contend on one atomic, the value is summed up when it's read.
+ */
+class counter : boost::noncopyable {
+public:
+    void
+    add(uint64_t v = 1) {
+        shards_[internal::current_shard()].value.fetch_add(v, std::memory_order_relaxed);
+    }
+
+    uint64_t value() const;
+
+private:
+    struct alignas(64) shard {
+        std::atomic<uint64_t> value{0};
+    };
+    std::array<shard, internal::shard_count> shards_;
+};
+
+// value which may go up and down, it's set as a whole so it's not sharded
+class gauge : boost::noncopyable {
+public:
+    void set(int64_t v) { value_.store(v, std::memory_order_relaxed); }
+    void add(int64_t v) { value_.fetch_add(v, std::memory_order_relaxed); }
+    void sub(int64_t v) { value_.fetch_sub(v, std::memory_order_relaxed); }
+
+    int64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<int64_t> value_{0};
+};
+
+/**
+ * Histogram with fixed upper bounds, sharded like the counter.
+ * A snapshot isn't atomic over the buckets, which is fine for scraping.
+ */
+class histogram : boost::noncopyable {
+public:
+    struct snapshot {
+        std::vector<uint64_t> buckets;  // cumulative count under each bound, the last one is the total count
+        double                sum = 0;
+    };
+
+public:
+    explicit histogram(std::vector<double> bounds);
+
+public:
+    void observe(double v);
+
+    const std::vector<double>& bounds() const { return bounds_; }
+    snapshot                   get_snapshot() const;
+
+    // bounds of `count` buckets, starting at `start` and multiplied by `factor` each
+    static std::vector<double> exponential_bounds(double start, double factor, size_t count);
+
+private:
+    struct alignas(64) shard {
+        std::unique_ptr<std::atomic<uint64_t>[]> buckets;
+        std::atomic<double>                      sum{0};  // added by cas, there's no fetch_add of double before c++20
+    };
+
+private:
+    std::vector<double>                      bounds_;
+    std::array<shard, internal::shard_count> shards_;
+};
+
+/**
+ * Writes samples in the Prometheus text format, samples of the same name are
+ * grouped under one pair of help and type lines, whichever order they're written in.
+ */
+class writer : boost::noncopyable {
+public:
+    void counter(const std::string& name, const std::string& help, double value, const labels& ls = {});
+    void gauge(const std::string& name, const std::string& help, double value, const labels& ls = {});
+    void histogram(const std::string& name, const std::string& help, const metrics::histogram& h, const labels& ls = {});
+
+    std::string text() const;
+
+private:
+    std::string& family(const std::string& name, const std::string& help, const char* type);
+    void         sample(std::string& out, const std::string& name, const labels& ls, double value);
+
+private:
+    std::vector<std::string>           order_;
+    std::map<std::string, std::string> families_;
+};
+
+using collector    = std::function<void(writer&)>;
+using collector_id = uint64_t;
+
+/**
+ * Process wide registry of metrics
+ *
+ * Counters, gauges and histograms are owned by the registry and live until the process exits,
+ * so the references returned may be kept and updated from any thread. Values which are already
+ * kept elsewhere (sizes of queues, stats of databases) are read by collectors when scraped.
+ * Adding one with the same name and labels again returns the existing one.
+ */
+class registry : boost::noncopyable {
+public:
+    static registry& get();
+
+public:
+    metrics::counter&   add_counter(const std::string& name, const std::string& help, const labels& ls = {});
+    metrics::gauge&     add_gauge(const std::string& name, const std::string& help, const labels& ls = {});
+    metrics::histogram& add_histogram(const std::string& name, const std::string& help, std::vector<double> bounds, const labels& ls = {});
+
+    // collectors are called with the registry locked, they must not add metrics
+    collector_id add_collector(collector c);
+    void         remove_collector(collector_id id);
+
+    // all the metrics in the Prometheus text format, version 0.0.4
+    std::string format_text() const;
+
+private:
+    enum class kind { counter, gauge, histogram };
+
+    struct family {
+        kind                       type;
+        std::string                help;
+        std::map<labels, uint32_t> metrics;  // index in the storage of its kind
+    };
+
+    family& get_family(const std::string& name, const std::string& help, kind type);
+
+private:
+    mutable std::mutex                mutex_;
+    std::map<std::string, family>     families_;
+    std::deque<metrics::counter>      counters_;
+    std::deque<metrics::gauge>        gauges_;
+    std::deque<metrics::histogram>    histograms_;
+    std::map<collector_id, collector> collectors_;
+    collector_id                      next_collector_ = 1;
+};
+
+}}}  // namespace evt::utilities::metrics
@@ -0,0 +1,174 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <new>
+#include <vector>
+#include <boost/noncopyable.hpp>
+#include <boost/pool/singleton_pool.hpp>
+
+namespace evt { namespace utilities {
+
+/**
+ * Totals of the allocations made by all the pooled allocators, read before and after
+ * some work to get the number of allocations it made.
+ */
+struct pool_stats {
+    uint64_t allocs      = 0;  // objects allocated
+    uint64_t cache_hits  = 0;  // served by the cache of the calling thread
+    uint64_t pool_allocs = 0;  // taken from the shared pools, the rest of misses
+};
+
+namespace internal {
+
+struct pool_counters {
+    std::atomic<uint64_t> allocs      = 0;
+    std::atomic<uint64_t> cache_hits  = 0;
+    std::atomic<uint64_t> pool_allocs = 0;
+};
+
+inline pool_counters global_pool_counters;
+
+struct pooled_tag {};
+
+constexpr size_t
+pooled_size(size_t size) {
+    return (size + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t);
+}
+
+/**
+ * Free blocks of one size kept by each thread in front of the shared pool of that size
+ *
+ * Blocks of one size are interchangeable, so a block freed on another thread than
+ * the one allocating it simply goes to the cache of the freeing thread. When a cache
+ * is full, half of it goes back to the shared pool for the other threads.
+ */
+template <size_t Size>
+class block_cache : boost::noncopyable {
+public:
+    using pool = boost::singleton_pool<pooled_tag, Size>;
+
+    static constexpr size_t max_blocks = 256;
+
+public:
+    ~block_cache() {
+        for(auto p : blocks_) {
+            pool::free(p);
+        }
+    }
+
+    void*
+    take() {
+        global_pool_counters.allocs.fetch_add(1, std::memory_order_relaxed);
+        if(!blocks_.empty()) {
+            auto p = blocks_.back();
+            blocks_.pop_back();
+            global_pool_counters.cache_hits.fetch_add(1, std::memory_order_relaxed);
+            return p;
+        }
+        global_pool_counters.pool_allocs.fetch_add(1, std::memory_order_relaxed);
+        auto p = pool::malloc();
+        if(p == nullptr) {
+            throw std::bad_alloc();
+        }
+        return p;
+    }
+
+    void
+    give(void* p) {
+        if(blocks_.size() >= max_blocks) {
+            for(auto i = max_blocks / 2; i < blocks_.size(); i++) {
+                pool::free(blocks_[i]);
+            }
+            blocks_.resize(max_blocks / 2);
+        }
+        blocks_.emplace_back(p);
+    }
+
+    static block_cache&
+    local() {
+        thread_local block_cache cache;
+        return cache;
+    }
+
+private:
+    std::vector<void*> blocks_;
+};
+
+}  // namespace internal
+
+inline pool_stats
+get_pool_stats() {
+    auto& c = internal::global_pool_counters;
+    return pool_stats {
+        .allocs      = c.allocs.load(std::memory_order_relaxed),
+        .cache_hits  = c.cache_hits.load(std::memory_order_relaxed),
+        .pool_allocs = c.pool_allocs.load(std::memory_order_relaxed)
+    };
+}
+
+/**
+ * Allocator for objects created and freed at a high rate on several threads (traces and
+ * metadata of transactions), single objects come from per-thread caches backed by
+ * shared pools of each size. Arrays go to the default allocator.
+ *
+ * Used with `std::allocate_shared`, the control block and the object share one pooled block.
+ */
+template <typename T>
+class pooled_allocator {
+public:
+    using value_type = T;
+
+    template <typename U>
+    struct rebind {
+        using other = pooled_allocator<U>;
+    };
+
+public:
+    pooled_allocator() noexcept = default;
+    template <typename U>
+    pooled_allocator(const pooled_allocator<U>&) noexcept {}
+
+    T*
+    allocate(size_t n) {
+        if(n != 1) {
+            return std::allocator<T>().allocate(n);
+        }
+        return static_cast<T*>(cache().take());
+    }
+
+    void
+    deallocate(T* p, size_t n) noexcept {
+        if(n != 1) {
+            std::allocator<T>().deallocate(p, n);
+            return;
+        }
+        cache().give(p);
+    }
+
+    template <typename U>
+    bool operator==(const pooled_allocator<U>&) const noexcept { return true; }
+    template <typename U>
+    bool operator!=(const pooled_allocator<U>&) const noexcept { return false; }
+
+private:
+    static auto&
+    cache() {
+        static_assert(alignof(T) <= alignof(std::max_align_t), "over-aligned types are not supported");
+        return internal::block_cache<internal::pooled_size(sizeof(T))>::local();
+    }
+};
+
+template <typename T, typename... Args>
+std::shared_ptr<T>
+make_pooled(Args&&... args) {
+    return std::allocate_shared<T>(pooled_allocator<T>(), std::forward<Args>(args)...);
+}
+
+}}  // namespace evt::utilities
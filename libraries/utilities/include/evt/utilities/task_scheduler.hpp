@@ -0,0 +1,100 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/noncopyable.hpp>
+#include <evt/utilities/cpu_affinity.hpp>
+
+namespace evt { namespace utilities {
+
+/**
+ * Work-stealing pool of worker threads shared by the subsystems of a node
+ *
+ * Every worker has its own queue per lane. Tasks posted by a worker go to its own queue,
+ * the others are spread over the workers in turn. An idle worker takes from its own queue
+ * first and steals from the others after that, so tasks end up on whichever core is free.
+ * Critical tasks (signature recovery, merkle roots, block signing) are always taken before
+ * the background ones (serialization for history plugins, generated traffic) on every queue.
+ *
+ * Tasks must not block on other tasks of the background lane, these may wait behind them.
+ * Workers are pinned to `cpus` as a whole when it's given, so they still steal from each other.
+ */
+class task_scheduler : boost::noncopyable {
+public:
+    enum class lane {
+        critical = 0,
+        background,
+        max_value = background
+    };
+
+    using task = std::function<void()>;
+
+    struct lane_stats {
+        uint64_t posted = 0;
+        uint64_t done   = 0;
+        uint64_t stolen = 0;  // taken by a worker from the queue of another one
+    };
+
+public:
+    explicit task_scheduler(size_t threads, const std::string& name = "sched", const affinity::cpu_list& cpus = {});
+    ~task_scheduler();
+
+public:
+    // tasks posted after `stop()` are dropped, exceptions thrown by tasks are logged and dropped
+    void post(task&& t, lane l = lane::critical);
+
+    // workers quit after their current tasks, the queued ones are dropped
+    void stop();
+    // workers quit once all the queued tasks are done, waits for them
+    void join();
+
+    size_t     size() const { return workers_.size(); }
+    lane_stats stats(lane l) const;
+
+    // index of the worker of this scheduler running the calling thread, -1 for other threads
+    int current_worker() const;
+
+private:
+    struct worker_queue {
+        std::mutex      mtx;
+        std::deque<task> lanes[(int)lane::max_value + 1];
+    };
+
+    struct lane_counters {
+        std::atomic<uint64_t> posted = 0;
+        std::atomic<uint64_t> done   = 0;
+        std::atomic<uint64_t> stolen = 0;
+    };
+
+    void run(int index);
+    bool take(int index, task& t, lane& l);
+    bool take_from(int index, int victim, lane l, task& t);
+
+private:
+    std::vector<std::unique_ptr<worker_queue>> queues_;
+    std::vector<std::thread>                   workers_;
+    lane_counters                              counters_[(int)lane::max_value + 1];
+
+    std::atomic<uint64_t> next_queue_ = 0;
+    std::atomic<int64_t>  pending_    = 0;  // tasks queued and not taken yet
+
+    std::mutex              sleep_mtx_;
+    std::condition_variable sleep_cv_;
+    std::atomic<bool>       stopping_ = false;
+    std::atomic<bool>       draining_ = false;
+};
+
+}}  // namespace evt::utilities
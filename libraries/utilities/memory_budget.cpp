@@ -0,0 +1,76 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#include <evt/utilities/memory_budget.hpp>
+
+namespace evt { namespace utilities { namespace memory {
+
+accountant&
+accountant::get() {
+    // never destroyed, like the metrics registry
+    static auto a = new accountant();
+    return *a;
+}
+
+component_id
+accountant::add_component(const std::string& name, usage_func usage, enforce_func enforce) {
+    auto lock = std::lock_guard(mutex_);
+    auto id   = next_id_++;
+    components_.emplace(id, component{ name, std::move(usage), std::move(enforce) });
+    return id;
+}
+
+void
+accountant::remove_component(component_id id) {
+    auto lock = std::lock_guard(mutex_);
+    components_.erase(id);
+}
+
+void
+accountant::set_budget(const std::string& name, uint64_t bytes) {
+    auto lock = std::lock_guard(mutex_);
+    budgets_[name] = bytes;
+}
+
+uint64_t
+accountant::get_budget(const std::string& name) const {
+    auto lock = std::lock_guard(mutex_);
+    auto it   = budgets_.find(name);
+    return it != budgets_.end() ? it->second : 0;
+}
+
+component_usage
+accountant::get_usage(const component& c) const {
+    auto u = component_usage();
+    u.name = c.name;
+    c.usage(u);
+
+    auto it  = budgets_.find(c.name);
+    u.budget = it != budgets_.end() ? it->second : 0;
+    return u;
+}
+
+std::vector<component_usage>
+accountant::get_usage() const {
+    auto lock   = std::lock_guard(mutex_);
+    auto usages = std::vector<component_usage>();
+    usages.reserve(components_.size());
+    for(auto& it : components_) {
+        usages.emplace_back(get_usage(it.second));
+    }
+    return usages;
+}
+
+void
+accountant::enforce() {
+    auto lock = std::lock_guard(mutex_);
+    for(auto& it : components_) {
+        auto& c = it.second;
+        if(c.enforce) {
+            c.enforce(get_usage(c));
+        }
+    }
+}
+
+}}}  // namespace evt::utilities::memory
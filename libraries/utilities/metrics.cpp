@@ -0,0 +1,269 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#include <evt/utilities/metrics.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <stdexcept>
+#include <fmt/format.h>
+
+namespace evt { namespace utilities { namespace metrics {
+
+namespace internal {
+
+size_t
+current_shard() {
+    static std::atomic<size_t> next{0};
+    static thread_local size_t shard = next.fetch_add(1, std::memory_order_relaxed) % shard_count;
+    return shard;
+}
+
+std::string
+escape_label(const std::string& v) {
+    auto s = std::string();
+    s.reserve(v.size());
+    for(auto c : v) {
+        switch(c) {
+        case '\\': s += "\\\\"; break;
+        case '"':  s += "\\\""; break;
+        case '\n': s += "\\n"; break;
+        default:   s += c;
+        }
+    }
+    return s;
+}
+
+std::string
+format_value(double v) {
+    if(std::isinf(v)) {
+        return v > 0 ? "+Inf" : "-Inf";
+    }
+    if(std::isnan(v)) {
+        return "NaN";
+    }
+    return fmt::format("{}", v);
+}
+
+}  // namespace internal
+
+uint64_t
+counter::value() const {
+    auto v = uint64_t(0);
+    for(auto& s : shards_) {
+        v += s.value.load(std::memory_order_relaxed);
+    }
+    return v;
+}
+
+histogram::histogram(std::vector<double> bounds)
+    : bounds_(std::move(bounds)) {
+    std::sort(bounds_.begin(), bounds_.end());
+    bounds_.erase(std::unique(bounds_.begin(), bounds_.end()), bounds_.end());
+    for(auto& s : shards_) {
+        // one more for the values above the last bound
+        s.buckets = std::make_unique<std::atomic<uint64_t>[]>(bounds_.size() + 1);
+        for(auto i = 0u; i <= bounds_.size(); i++) {
+            s.buckets[i].store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+void
+histogram::observe(double v) {
+    auto& s = shards_[internal::current_shard()];
+    auto  i = std::lower_bound(bounds_.begin(), bounds_.end(), v) - bounds_.begin();
+    s.buckets[i].fetch_add(1, std::memory_order_relaxed);
+
+    auto sum = s.sum.load(std::memory_order_relaxed);
+    while(!s.sum.compare_exchange_weak(sum, sum + v, std::memory_order_relaxed)) {}
+}
+
+histogram::snapshot
+histogram::get_snapshot() const {
+    auto snap = snapshot();
+    snap.buckets.resize(bounds_.size() + 1);
+    for(auto& s : shards_) {
+        for(auto i = 0u; i <= bounds_.size(); i++) {
+            snap.buckets[i] += s.buckets[i].load(std::memory_order_relaxed);
+        }
+        snap.sum += s.sum.load(std::memory_order_relaxed);
+    }
+    for(auto i = 1u; i < snap.buckets.size(); i++) {
+        snap.buckets[i] += snap.buckets[i - 1];
+    }
+    return snap;
+}
+
+std::vector<double>
+histogram::exponential_bounds(double start, double factor, size_t count) {
+    auto bounds = std::vector<double>();
+    bounds.reserve(count);
+    for(auto i = 0u; i < count; i++, start *= factor) {
+        bounds.emplace_back(start);
+    }
+    return bounds;
+}
+
+std::string&
+writer::family(const std::string& name, const std::string& help, const char* type) {
+    auto it = families_.find(name);
+    if(it == families_.end()) {
+        it = families_.emplace(name, fmt::format("# HELP {} {}\n# TYPE {} {}\n", name, help, name, type)).first;
+        order_.emplace_back(name);
+    }
+    return it->second;
+}
+
+void
+writer::sample(std::string& out, const std::string& name, const labels& ls, double value) {
+    out += name;
+    if(!ls.empty()) {
+        out += '{';
+        for(auto i = 0u; i < ls.size(); i++) {
+            fmt::format_to(std::back_inserter(out), "{}{}=\"{}\"", i > 0 ? "," : "", ls[i].first, internal::escape_label(ls[i].second));
+        }
+        out += '}';
+    }
+    out += ' ';
+    out += internal::format_value(value);
+    out += '\n';
+}
+
+void
+writer::counter(const std::string& name, const std::string& help, double value, const labels& ls) {
+    sample(family(name, help, "counter"), name, ls, value);
+}
+
+void
+writer::gauge(const std::string& name, const std::string& help, double value, const labels& ls) {
+    sample(family(name, help, "gauge"), name, ls, value);
+}
+
+void
+writer::histogram(const std::string& name, const std::string& help, const metrics::histogram& h, const labels& ls) {
+    auto& out    = family(name, help, "histogram");
+    auto  snap   = h.get_snapshot();
+    auto& bounds = h.bounds();
+    auto  bls    = ls;
+    bls.emplace_back("le", "");
+    for(auto i = 0u; i < snap.buckets.size(); i++) {
+        bls.back().second = (i < bounds.size()) ? internal::format_value(bounds[i]) : "+Inf";
+        sample(out, name + "_bucket", bls, snap.buckets[i]);
+    }
+    sample(out, name + "_sum", ls, snap.sum);
+    sample(out, name + "_count", ls, snap.buckets.back());
+}
+
+std::string
+writer::text() const {
+    auto s = std::string();
+    for(auto& name : order_) {
+        s += families_.at(name);
+    }
+    return s;
+}
+
+registry&
+registry::get() {
+    // never destroyed, metrics may still be updated by threads exiting after main
+    static auto r = new registry();
+    return *r;
+}
+
+registry::family&
+registry::get_family(const std::string& name, const std::string& help, kind type) {
+    auto it = families_.find(name);
+    if(it == families_.end()) {
+        it = families_.emplace(name, family{ type, help, {} }).first;
+    }
+    if(it->second.type != type) {
+        throw std::invalid_argument(fmt::format("Metric {} is already added with another type", name));
+    }
+    return it->second;
+}
+
+counter&
+registry::add_counter(const std::string& name, const std::string& help, const labels& ls) {
+    auto lock = std::lock_guard(mutex_);
+    auto& f   = get_family(name, help, kind::counter);
+    auto  it  = f.metrics.find(ls);
+    if(it != f.metrics.end()) {
+        return counters_[it->second];
+    }
+    f.metrics.emplace(ls, counters_.size());
+    return counters_.emplace_back();
+}
+
+gauge&
+registry::add_gauge(const std::string& name, const std::string& help, const labels& ls) {
+    auto lock = std::lock_guard(mutex_);
+    auto& f   = get_family(name, help, kind::gauge);
+    auto  it  = f.metrics.find(ls);
+    if(it != f.metrics.end()) {
+        return gauges_[it->second];
+    }
+    f.metrics.emplace(ls, gauges_.size());
+    return gauges_.emplace_back();
+}
+
+histogram&
+registry::add_histogram(const std::string& name, const std::string& help, std::vector<double> bounds, const labels& ls) {
+    auto lock = std::lock_guard(mutex_);
+    auto& f   = get_family(name, help, kind::histogram);
+    auto  it  = f.metrics.find(ls);
+    if(it != f.metrics.end()) {
+        return histograms_[it->second];
+    }
+    f.metrics.emplace(ls, histograms_.size());
+    return histograms_.emplace_back(std::move(bounds));
+}
+
+collector_id
+registry::add_collector(collector c) {
+    auto lock = std::lock_guard(mutex_);
+    auto id   = next_collector_++;
+    collectors_.emplace(id, std::move(c));
+    return id;
+}
+
+void
+registry::remove_collector(collector_id id) {
+    auto lock = std::lock_guard(mutex_);
+    collectors_.erase(id);
+}
+
+std::string
+registry::format_text() const {
+    auto w    = writer();
+    auto lock = std::lock_guard(mutex_);
+
+    for(auto& it : families_) {
+        auto& name = it.first;
+        auto& f    = it.second;
+        for(auto& m : f.metrics) {
+            switch(f.type) {
+            case kind::counter: {
+                w.counter(name, f.help, counters_[m.second].value(), m.first);
+                break;
+            }
+            case kind::gauge: {
+                w.gauge(name, f.help, gauges_[m.second].value(), m.first);
+                break;
+            }
+            case kind::histogram: {
+                w.histogram(name, f.help, histograms_[m.second], m.first);
+                break;
+            }
+            }  // switch
+        }
+    }
+    for(auto& it : collectors_) {
+        it.second(w);
+    }
+    return w.text();
+}
+
+}}}  // namespace evt::utilities::metrics
@@ -0,0 +1,183 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#include <evt/utilities/task_scheduler.hpp>
+
+#include <algorithm>
+#include <fc/exception/exception.hpp>
+#include <fc/log/logger.hpp>
+#include <fc/log/logger_config.hpp>
+
+namespace evt { namespace utilities {
+
+namespace {
+
+// scheduler and worker index of the calling thread
+thread_local const task_scheduler* tls_scheduler = nullptr;
+thread_local int                   tls_worker    = -1;
+
+}  // namespace
+
+task_scheduler::task_scheduler(size_t threads, const std::string& name, const affinity::cpu_list& cpus) {
+    threads = std::max<size_t>(threads, 1);
+
+    queues_.reserve(threads);
+    for(auto i = 0u; i < threads; i++) {
+        queues_.emplace_back(std::make_unique<worker_queue>());
+    }
+
+    workers_.reserve(threads);
+    for(auto i = 0u; i < threads; i++) {
+        workers_.emplace_back([this, i, name, cpus] {
+            fc::set_thread_name(name + "-" + std::to_string(i));
+            if(!cpus.empty() && !affinity::pin_current_thread(cpus)) {
+                wlog("failed to pin ${n} to cpus ${c}", ("n", name + "-" + std::to_string(i))("c", affinity::format_cpu_list(cpus)));
+            }
+            run((int)i);
+        });
+    }
+}
+
+task_scheduler::~task_scheduler() {
+    stop();
+}
+
+void
+task_scheduler::post(task&& t, lane l) {
+    if(stopping_) {
+        return;
+    }
+
+    // a worker keeps its own tasks, others are spread in turn
+    auto index = (tls_scheduler == this) ? tls_worker : (int)(next_queue_++ % queues_.size());
+    {
+        auto& q    = *queues_[index];
+        auto  lock = std::lock_guard(q.mtx);
+        q.lanes[(int)l].emplace_back(std::move(t));
+    }
+    counters_[(int)l].posted++;
+    pending_++;
+
+    {
+        // pairs with the check of `pending_` by the sleeping workers so no wakeup is lost
+        auto lock = std::lock_guard(sleep_mtx_);
+    }
+    sleep_cv_.notify_one();
+}
+
+void
+task_scheduler::stop() {
+    stopping_ = true;
+    {
+        auto lock = std::lock_guard(sleep_mtx_);
+    }
+    sleep_cv_.notify_all();
+
+    for(auto& w : workers_) {
+        if(w.joinable()) {
+            w.join();
+        }
+    }
+    for(auto& q : queues_) {
+        auto lock = std::lock_guard(q->mtx);
+        for(auto& tasks : q->lanes) {
+            tasks.clear();
+        }
+    }
+    pending_ = 0;
+}
+
+void
+task_scheduler::join() {
+    draining_ = true;
+    {
+        auto lock = std::lock_guard(sleep_mtx_);
+    }
+    sleep_cv_.notify_all();
+
+    for(auto& w : workers_) {
+        if(w.joinable()) {
+            w.join();
+        }
+    }
+}
+
+task_scheduler::lane_stats
+task_scheduler::stats(lane l) const {
+    auto& c = counters_[(int)l];
+    return lane_stats { .posted = c.posted, .done = c.done, .stolen = c.stolen };
+}
+
+int
+task_scheduler::current_worker() const {
+    return (tls_scheduler == this) ? tls_worker : -1;
+}
+
+bool
+task_scheduler::take_from(int index, int victim, lane l, task& t) {
+    auto& q    = *queues_[victim];
+    auto  lock = std::lock_guard(q.mtx);
+
+    auto& tasks = q.lanes[(int)l];
+    if(tasks.empty()) {
+        return false;
+    }
+    // own tasks in order, stolen ones from the other end to keep away from the owner
+    if(victim == index) {
+        t = std::move(tasks.front());
+        tasks.pop_front();
+    }
+    else {
+        t = std::move(tasks.back());
+        tasks.pop_back();
+        counters_[(int)l].stolen++;
+    }
+    return true;
+}
+
+bool
+task_scheduler::take(int index, task& t, lane& l) {
+    auto n = (int)queues_.size();
+    for(auto i = (int)lane::critical; i <= (int)lane::max_value; i++) {
+        for(auto j = 0; j < n; j++) {
+            if(take_from(index, (index + j) % n, (lane)i, t)) {
+                pending_--;
+                l = (lane)i;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void
+task_scheduler::run(int index) {
+    tls_scheduler = this;
+    tls_worker    = index;
+
+    auto t = task();
+    auto l = lane::critical;
+    while(!stopping_) {
+        if(take(index, t, l)) {
+            try {
+                t();
+            }
+            FC_LOG_AND_DROP();
+            t = nullptr;
+            counters_[(int)l].done++;
+            continue;
+        }
+
+        auto lock = std::unique_lock(sleep_mtx_);
+        if(draining_ && pending_ <= 0) {
+            break;
+        }
+        sleep_cv_.wait(lock, [this] { return pending_ > 0 || stopping_ || draining_; });
+        if(draining_ && pending_ <= 0) {
+            break;
+        }
+    }
+}
+
+}}  // namespace evt::utilities
@@ -0,0 +1,324 @@
+import json
+import statistics
+import subprocess
+import tempfile
+import threading
+import time
+
+import click
+import docker
+import requests
+from pyevt import ecc
+from pyevtsdk import action, api, transaction
+
+from launch_nodes import command, free_container
+
+# Throughput and propagation benchmark of a cluster
+#
+# Producers are fully connected, relays form a chain behind the first producer,
+# so relay k is k+1 hops away from it. Every node is shaped by netem with the same
+# delay, jitter and bandwidth. A fixed load is generated and replayed by evtlg,
+# meanwhile the head of every node is polled to see when each block reaches it.
+# The report is json so runs of different builds can be diffed.
+
+signing_key = 'EVT7vuvMYQwm6WYLoopw6DqhBumM4hC7RA5ufK8WSqU7VQyfmoLwA=KEY:5KZ2HeogGk12U2WwU7djVrfcSami4BRtMyNYA7frfcAnhyAGzKM'
+evt_priv_key = '5KQwrPbwdL6PhXujxW37FSSQZ1JiwsST4cqQzDeyXtP79zkvFD3'
+evt_pub_key = 'EVT6MRyAjQq8ud7hVNYcfnVPJqcVpscN5So8BhtHuGYqET5GDW5CV'
+
+
+def producer_name(i):
+    return 'evt' if i == 0 else 'evt{}'.format(i)
+
+
+def topology(producer_number, relay_number):
+    # peers each node connects to
+    peers = {}
+    for i in range(producer_number):
+        peers[i] = [j for j in range(producer_number) if j != i]
+    for k in range(relay_number):
+        i = producer_number + k
+        peers[i] = [0 if k == 0 else i - 1]
+    return peers
+
+
+def hops(peers, src):
+    # breadth first over the links, which are used both ways
+    adj = {i: set() for i in peers}
+    for i, ps in peers.items():
+        for j in ps:
+            adj[i].add(j)
+            adj[j].add(i)
+    dist = {src: 0}
+    q = [src]
+    while q:
+        i = q.pop(0)
+        for j in adj[i]:
+            if j not in dist:
+                dist[j] = dist[i] + 1
+                q.append(j)
+    return dist
+
+
+def launch(client, paras, peers):
+    n = len(peers)
+    try:
+        client.networks.get('evt-net')
+    except docker.errors.NotFound:
+        client.networks.create('evt-net', driver='bridge')
+
+    for i in range(n):
+        cmd = command('evtd.sh')
+        cmd.add_option('--delete-all-blocks')
+        cmd.add_option('--http-validate-host=false')
+        cmd.add_option('--charge-free-mode')
+        cmd.add_option('--plugin=evt::chain_api_plugin')
+        cmd.add_option('--plugin=evt::evt_api_plugin')
+        if i < paras['producer_number']:
+            cmd.add_option('--enable-stale-production')
+            cmd.add_option('--producer-name={}'.format(producer_name(i)))
+            cmd.add_option('--signature-provider={}'.format(signing_key))
+        cmd.add_option('--http-server-address=evtd_{}:{}'.format(i, 8888+i))
+        cmd.add_option('--p2p-listen-endpoint=evtd_{}:{}'.format(i, 9876+i))
+        for j in peers[i]:
+            cmd.add_option('--p2p-peer-address=evtd_{}:{}'.format(j, 9876+j))
+
+        kwargs = {}
+        if paras['use_tmpfs']:
+            kwargs['tmpfs'] = {'/opt/evtd/data': 'size={}M'.format(paras['tmpfs_size'])}
+        client.containers.run(image='everitoken/evt:latest',
+                              name='evtd_{}'.format(i),
+                              command=cmd.get_arguments(),
+                              network='evt-net',
+                              ports={'{}/tcp'.format(8888+i): paras['evtd_port_http']+i,
+                                     '{}/tcp'.format(9876+i): paras['evtd_port_p2p']+i},
+                              detach=True,
+                              **kwargs)
+        click.echo('started evtd_{}, peers: {}'.format(i, peers[i]))
+
+
+def shape(client, n, net):
+    # netem on the egress of each node, the image of pumba is reused for tc
+    args = ['qdisc', 'add', 'dev', 'eth0', 'root', 'netem',
+            'delay', '{}ms'.format(net['delay_ms']), '{}ms'.format(net['jitter_ms'])]
+    if net.get('rate'):
+        args += ['rate', net['rate']]
+    for i in range(n):
+        client.containers.run(image='gaiadocker/iproute2',
+                              command=args,
+                              network_mode='container:evtd_{}'.format(i),
+                              cap_add=['NET_ADMIN'],
+                              remove=True)
+
+
+def update_producers(url, producer_number):
+    priv_evt = ecc.PrivateKey.from_string(evt_priv_key)
+    TG = transaction.TrxGenerator(url=url, payer=evt_pub_key)
+    AG = action.ActionGenerator()
+
+    producers = [{'producer_name': producer_name(i), 'block_signing_key': signing_key.split('=')[0]}
+                 for i in range(producer_number)]
+    updsched = AG.new_action_from_json('updsched', json.dumps({'producers': producers}))
+
+    trx = TG.new_trx()
+    trx.add_action(updsched)
+    trx.add_sign(priv_evt)
+    api.Api(url).push_transaction(trx.dumps())
+
+
+class poller(threading.Thread):
+    """Polls the head of one node, records when each block id is first seen"""
+
+    def __init__(self, url, interval):
+        super().__init__(daemon=True)
+        self.url = url
+        self.interval = interval
+        self.seen = {}      # block id -> (block num, time first seen)
+        self.lib_lags = []
+        self.stopped = False
+
+    def run(self):
+        s = requests.Session()
+        while not self.stopped:
+            try:
+                info = s.get(self.url + '/v1/chain/get_info', timeout=1).json()
+                now = time.time()
+                if info['head_block_id'] not in self.seen:
+                    self.seen[info['head_block_id']] = (info['head_block_num'], now)
+                self.lib_lags.append(info['head_block_num'] - info['last_irreversible_block_num'])
+            except requests.RequestException:
+                pass
+            time.sleep(self.interval)
+
+
+def percentiles(values):
+    if not values:
+        return None
+    values = sorted(values)
+
+    def at(q):
+        return values[min(len(values) - 1, int(q * len(values)))]
+    return {'count': len(values), 'mean': statistics.mean(values), 'p50': at(0.5), 'p90': at(0.9), 'p99': at(0.99), 'max': values[-1]}
+
+
+def block_stats(url, start_num, end_num):
+    # transactions and producers of the irreversible blocks in the window
+    s = requests.Session()
+    trxs = 0
+    producers = {}
+    first = last = None
+    for num in range(start_num, end_num + 1):
+        b = s.post(url + '/v1/chain/get_block', json={'block_num_or_id': num}).json()
+        trxs += len(b.get('transactions', []))
+        producers[b['block_num']] = b['producer']
+        first = first or b['timestamp']
+        last = b['timestamp']
+    return trxs, producers, first, last
+
+
+def report(paras, peers, pollers, trxs, producers, window_secs, lib_num):
+    n = len(peers)
+    producer_index = {producer_name(i): i for i in range(paras['producer_number'])}
+
+    # propagation of a block is measured from the first time its producer is seen having it
+    by_hop = {}
+    per_node = {i: [] for i in range(n)}
+    ids_by_num = {}
+    for i, p in enumerate(pollers):
+        for bid, (num, _) in p.seen.items():
+            ids_by_num.setdefault(num, set()).add(bid)
+    for bid, (num, _) in pollers[0].seen.items():
+        if num not in producers:
+            continue
+        src = producer_index.get(producers[num])
+        if src is None or bid not in pollers[src].seen:
+            continue
+        origin = pollers[src].seen[bid][1]
+        dist = hops(peers, src)
+        for i, p in enumerate(pollers):
+            if i == src or bid not in p.seen:
+                continue
+            ms = (p.seen[bid][1] - origin) * 1000
+            by_hop.setdefault(dist[i], []).append(ms)
+            per_node[i].append(ms)
+
+    # heights where nodes saw more than one block, any of them is a fork
+    forked = [num for num, ids in ids_by_num.items() if len(ids) > 1]
+    heights = len(ids_by_num) or 1
+
+    return {
+        'config': paras,
+        'topology': {str(i): ps for i, ps in peers.items()},
+        'confirmed_trxs': trxs,
+        'confirmed_tps': trxs / window_secs if window_secs > 0 else 0,
+        'last_irreversible_block_num': lib_num,
+        'fork_rate': len(forked) / heights,
+        'forked_heights': sorted(forked),
+        'propagation_ms_by_hop': {str(h): percentiles(v) for h, v in sorted(by_hop.items())},
+        'propagation_ms_by_node': {'evtd_{}'.format(i): percentiles(v) for i, v in per_node.items()},
+        'lib_lag_blocks': {'evtd_{}'.format(i): percentiles(p.lib_lags) for i, p in enumerate(pollers)},
+    }
+
+
+@click.group()
+def run():
+    pass
+
+
+@click.command()
+@click.option('--config', help='the config of the benchmark', default='bench.config')
+@click.option('--evtlg', help='path of evtlg', default='evtlg')
+@click.option('--output', help='file to write the json report into', default='bench_report.json')
+@click.option('--keep', is_flag=True, help='keep the nodes running after the benchmark')
+def bench(config, evtlg, output, keep):
+    with open(config, 'r') as f:
+        paras = json.load(f)
+    peers = topology(paras['producer_number'], paras['relay_number'])
+    n = len(peers)
+    urls = ['http://127.0.0.1:{}'.format(paras['evtd_port_http']+i) for i in range(n)]
+    load = paras['load']
+
+    client = docker.from_env()
+    free_container('evtd_', client)
+    try:
+        launch(client, paras, peers)
+        shape(client, n, paras['network'])
+        time.sleep(5)
+        update_producers(urls[0], paras['producer_number'])
+
+        click.echo('warm up for {}s'.format(paras['warmup_secs']))
+        time.sleep(paras['warmup_secs'])
+
+        # the load is signed against the current head, the expiration covers the whole run
+        info = requests.get(urls[0] + '/v1/chain/get_info').json()
+        folder = tempfile.mkdtemp(prefix='evtbench')
+        gen = [evtlg, 'generate', '--chain-id', info['chain_id'], '--ref-block-id', info['head_block_id'],
+               '--regions', str(load['regions']), '--total', str(load['total']),
+               '--expiration', str(paras['duration_secs'] + 600), '--output-folder', folder]
+        for a in load['actions']:
+            gen += ['--action', a]
+        subprocess.run(gen, check=True)
+
+        pollers = [poller(url, paras['poll_interval_ms'] / 1000) for url in urls]
+        for p in pollers:
+            p.start()
+
+        start_num = requests.get(urls[0] + '/v1/chain/get_info').json()['head_block_num'] + 1
+        start = time.time()
+        lg = subprocess.Popen([evtlg, 'run', '--input-folder', folder,
+                               '--http-endpoint', '127.0.0.1:{}'.format(paras['evtd_port_http']),
+                               '--rate', str(load['rate']), '--batch', str(load['batch']),
+                               '--connections', str(load['connections'])])
+        try:
+            lg.wait(timeout=paras['duration_secs'])
+        except subprocess.TimeoutExpired:
+            lg.terminate()
+            lg.wait()
+        window_secs = time.time() - start
+        end_num = requests.get(urls[0] + '/v1/chain/get_info').json()['head_block_num']
+
+        # wait the window to become irreversible, so only confirmed transactions are counted
+        while True:
+            lib_num = requests.get(urls[0] + '/v1/chain/get_info').json()['last_irreversible_block_num']
+            if lib_num >= end_num:
+                break
+            time.sleep(1)
+        for p in pollers:
+            p.stopped = True
+
+        trxs, producers, _, _ = block_stats(urls[0], start_num, end_num)
+        result = report(paras, peers, pollers, trxs, producers, window_secs, lib_num)
+        with open(output, 'w') as f:
+            json.dump(result, f, indent=4)
+        click.echo('confirmed tps: {:.1f}, fork rate: {:.4f}, report is written to {}'.format(
+            result['confirmed_tps'], result['fork_rate'], output))
+    finally:
+        if not keep:
+            free_container('evtd_', client)
+
+
+@click.command()
+@click.argument('before')
+@click.argument('after')
+def compare(before, after):
+    # key numbers of two reports side by side
+    with open(before) as f:
+        a = json.load(f)
+    with open(after) as f:
+        b = json.load(f)
+
+    def row(name, x, y):
+        change = '' if not x else '{:+.1f}%'.format((y - x) / x * 100)
+        click.echo('{:<32}{:>12.2f}{:>12.2f}{:>10}'.format(name, x, y, change))
+
+    row('confirmed_tps', a['confirmed_tps'], b['confirmed_tps'])
+    row('fork_rate', a['fork_rate'], b['fork_rate'])
+    for h in sorted(set(a['propagation_ms_by_hop']) | set(b['propagation_ms_by_hop'])):
+        x = (a['propagation_ms_by_hop'].get(h) or {}).get('p50', 0)
+        y = (b['propagation_ms_by_hop'].get(h) or {}).get('p50', 0)
+        row('propagation_p50_hop_{}'.format(h), x, y)
+
+
+if __name__ == '__main__':
+    run.add_command(bench)
+    run.add_command(compare)
+    run()
@@ -16,6 +16,12 @@
  *  6. transaction received from remote peer
  *  7. socket ready for next write
  *
+ *  Transactions are relayed to peers of protocol 1.0.2 in batched frames, which are sent
+ *  when they reach the size threshold or the oldest transaction in them waited long enough.
+ *  Each transaction is packed once and the payload is shared by all the sessions. Frames
+ *  also carry the short ids of transactions just received from other peers, so the remote
+ *  peer doesn't send them back while we're applying them.
+ *
  *  Each session is responsible for maintaining the following
  *
  *  1. the most recent block on our current best chain which we know
@@ -51,6 +57,9 @@
 #include <evt/chain/multi_index_includes.hpp>
 #include <evt/chain_plugin/chain_plugin.hpp>
 
+#include <mutex>
+#include <unordered_map>
+
 #include <fc/io/json.hpp>
 
 #include <boost/asio.hpp>
@@ -121,7 +130,7 @@ struct hello {
     public_key_type       peer_id;
     string                network_version;
     string                agent;
-    string                protocol_version = "1.0.1";
+    string                protocol_version = "1.0.2";
     string                user;
     string                password;
     chain_id_type         chain_id;
@@ -170,23 +179,64 @@ struct pong {
 };
 FC_REFLECT(pong, (sent)(code))
 
+/**
+ * Transactions relayed in one frame since protocol 1.0.2, along with the short ids of the ones
+ * the sender has already, which it doesn't want to be sent.
+ */
+struct trx_batch {
+    vector<uint64_t>               known_ids;  ///< first 8 bytes of transaction ids
+    vector<packed_transaction_ptr> trxs;
+};
+FC_REFLECT(trx_batch, (known_ids)(trxs))
+
 using bnet_message = fc::static_variant<hello,
                                         trx_notice,
                                         block_notice,
                                         signed_block_ptr,
                                         packed_transaction_ptr,
-                                        ping, pong>;
+                                        ping, pong,
+                                        trx_batch>;
 
 struct by_id;
 struct by_num;
 struct by_received;
 struct by_expired;
+struct by_short_id;
 
 namespace evt {
 using namespace chain::plugin_interface;
 
 class bnet_plugin_impl;
 
+inline uint64_t
+short_trx_id(const transaction_id_type& id) {
+    return id._hash[0];
+}
+
+/**
+ * Transaction accepted locally, shared by all the sessions relaying it. It's packed as the
+ * payload of a `packed_transaction_ptr` only once, by the first session sending it.
+ */
+class relay_trx : boost::noncopyable {
+public:
+    explicit relay_trx(transaction_metadata_ptr t) : trx(std::move(t)) {}
+
+public:
+    const vector<char>&
+    payload() const {
+        std::call_once(packed_, [this] { payload_ = fc::raw::pack(trx->packed_trx); });
+        return payload_;
+    }
+
+public:
+    const transaction_metadata_ptr trx;
+
+private:
+    mutable std::once_flag packed_;
+    mutable vector<char>   payload_;
+};
+using relay_trx_ptr = std::shared_ptr<const relay_trx>;
+
 template <typename Strand>
 void
 verify_strand_in_this_thread(const Strand& strand, const char* func, int line) {
@@ -233,10 +283,10 @@ public:
         block_status_index;
 
     struct transaction_status {
-        time_point               received;
-        time_point               expired;  /// 5 seconds from last accepted
-        transaction_id_type      id;
-        transaction_metadata_ptr trx;
+        time_point          received;
+        time_point          expired;  /// 5 seconds from last accepted
+        transaction_id_type id;
+        relay_trx_ptr       trx;
 
         void
         mark_known_by_peer() {
@@ -245,18 +295,29 @@ public:
         }
         bool
         known_by_peer() const { return received == fc::time_point::maximum(); }
+
+        uint64_t
+        short_id() const { return short_trx_id(id); }
     };
 
     typedef boost::multi_index_container<transaction_status,
                                          indexed_by<
                                              ordered_unique<tag<by_id>, member<transaction_status, transaction_id_type, &transaction_status::id>>,
                                              ordered_non_unique<tag<by_received>, member<transaction_status, time_point, &transaction_status::received>>,
-                                             ordered_non_unique<tag<by_expired>, member<transaction_status, time_point, &transaction_status::expired>>>>
+                                             ordered_non_unique<tag<by_expired>, member<transaction_status, time_point, &transaction_status::expired>>,
+                                             ordered_non_unique<tag<by_short_id>, const_mem_fun<transaction_status, uint64_t, &transaction_status::short_id>>>>
         transaction_status_index;
 
     block_status_index       _block_status;
     transaction_status_index _transaction_status;
     const uint32_t           _max_block_status_range = 2048; // limit tracked block_status known_by_peer
+    const uint32_t           _max_batch_trxs         = 1024; // limit transactions in one batched frame
+    const uint32_t           _max_peer_known_ids     = 64 * 1024;
+
+    /// short ids the peer told us it has, of transactions we haven't accepted yet, with their expiration
+    std::unordered_map<uint64_t, fc::time_point> _peer_known_ids;
+    /// short ids of transactions received from other peers, to tell the peer in the next frame
+    vector<uint64_t>                             _known_ids_to_send;
 
     public_key_type _local_peer_id;
     uint32_t        _local_lib = 0;
@@ -269,6 +330,7 @@ public:
     block_id_type   _remote_lib_id;
     bool            _remote_request_trx = false;
     bool            _remote_request_irreversible_only = false;
+    bool            _remote_batch_trx = false;  ///< peer of protocol 1.0.2 takes batched frames
 
     uint32_t      _last_sent_block_num = 0;
     block_id_type _last_sent_block_id;  /// the id of the last block sent
@@ -287,6 +349,8 @@ public:
     boost::asio::io_service&                                    _ios;
     unique_ptr<ws::stream<tcp::socket>>                         _ws;
     boost::asio::strand<boost::asio::io_context::executor_type> _strand;
+    boost::asio::steady_timer                                   _batch_timer;
+    bool                                                        _batch_timer_armed = false;
 
     methods::get_block_by_number::method_type& _get_block_by_number;
 
@@ -315,9 +379,12 @@ public:
         , _ios(socket.get_io_service())
         , _ws(new ws::stream<tcp::socket>(move(socket)))
         , _strand(_ws->get_executor())
+        , _batch_timer(_ios)
         , _get_block_by_number(app().get_method<methods::get_block_by_number>()) {
         _session_num = next_session_id();
         set_socket_options();
+        boost::system::error_code ec;
+        set_compression_options(_ws->next_layer().remote_endpoint(ec).address().to_string(), string());
         _ws->binary(true);
         wlog("open session ${n}", ("n", _session_num));
     }
@@ -331,6 +398,7 @@ public:
         , _ios(ioc)
         , _ws(new ws::stream<tcp::socket>(ioc))
         , _strand(_ws->get_executor())
+        , _batch_timer(_ios)
         , _get_block_by_number(app().get_method<methods::get_block_by_number>()) {
         _session_num = next_session_id();
         _ws->binary(true);
@@ -339,6 +407,9 @@ public:
 
     ~session();
 
+    /** enables permessage-deflate when `host`:`port` is listed in bnet-compress-peer */
+    void set_compression_options(const string& host, const string& port);
+
     void
     set_socket_options() {
         try {
@@ -375,6 +446,7 @@ public:
         _peer        = peer;
         _remote_host = host;
         _remote_port = port;
+        set_compression_options(host, port);
 
         _resolver.async_resolve(_remote_host, _remote_port,
                                 boost::asio::bind_executor(_strand,
@@ -436,9 +508,10 @@ public:
          *  transactions that have reached 5 seconds without a new "acceptance".
          */
     void
-    on_accepted_transaction(transaction_metadata_ptr t) {
+    on_accepted_transaction(relay_trx_ptr rt) {
         //ilog( "accepted ${t}", ("t",t->id) );
-        auto itr = _transaction_status.find(t->id);
+        auto& t   = rt->trx;
+        auto  itr = _transaction_status.find(t->id);
         if(itr != _transaction_status.end()) {
             if(!itr->known_by_peer()) {
                 _transaction_status.modify(itr, [&](auto& stat) {
@@ -452,7 +525,13 @@ public:
         stat.received = fc::time_point::now();
         stat.expired  = stat.received + fc::seconds(5);
         stat.id       = t->id;
-        stat.trx      = t;
+        stat.trx      = std::move(rt);
+
+        auto kitr = _peer_known_ids.find(stat.short_id());
+        if(kitr != _peer_known_ids.end()) {
+            _peer_known_ids.erase(kitr);
+            stat.mark_known_by_peer();
+        }
         _transaction_status.insert(stat);
 
         maybe_send_next_message();
@@ -470,6 +549,15 @@ public:
             idx.erase(itr);
             itr = idx.begin();
         }
+
+        for(auto kitr = _peer_known_ids.begin(); kitr != _peer_known_ids.end();) {
+            if(kitr->second < now) {
+                kitr = _peer_known_ids.erase(kitr);
+            }
+            else {
+                ++kitr;
+            }
+        }
     }
 
     /**
@@ -631,6 +719,37 @@ public:
         FC_LOG_AND_RETHROW()
     }
 
+    /// frames of transactions are built from the payloads shared by all the sessions
+    void
+    send(const vector<uint64_t>& known_ids, const vector<relay_trx_ptr>& trxs) {
+        try {
+            auto tag = unsigned_int(_remote_batch_trx ? bnet_message::tag<trx_batch>::value : bnet_message::tag<packed_transaction_ptr>::value);
+            auto ps  = fc::raw::pack_size(tag);
+            if(_remote_batch_trx) {
+                ps += fc::raw::pack_size(known_ids) + fc::raw::pack_size(unsigned_int(trxs.size()));
+            }
+            else {
+                EVT_ASSERT(known_ids.empty() && trxs.size() == 1, plugin_exception, "peer takes only one transaction in a frame");
+            }
+            for(auto& t : trxs) {
+                ps += t->payload().size();
+            }
+
+            _out_buffer.resize(ps);
+            fc::datastream<char*> ds(_out_buffer.data(), ps);
+            fc::raw::pack(ds, tag);
+            if(_remote_batch_trx) {
+                fc::raw::pack(ds, known_ids);
+                fc::raw::pack(ds, unsigned_int(trxs.size()));
+            }
+            for(auto& t : trxs) {
+                ds.write(t->payload().data(), t->payload().size());
+            }
+            send();
+        }
+        FC_LOG_AND_RETHROW()
+    }
+
     template<class T>
     void
     send(const bnet_message& msg, const T& ex) {
@@ -803,31 +922,26 @@ public:
         }
     }
 
-    bool
-    send_next_trx() {
-        try {
-            if(!_remote_request_trx)
-                return false;
+    bool send_next_trx();
 
-            auto& idx   = _transaction_status.get<by_received>();
-            auto  start = idx.begin();
-            if(start == idx.end() || start->known_by_peer())
-                return false;
-
-            auto ptrx_ptr = start->trx->packed_trx;
-
-            idx.modify(start, [&](auto& stat) {
-                stat.mark_known_by_peer();
-            });
-
-            // wlog("sending trx ${id}", ("id",start->id) );
-            send(ptrx_ptr);
+    void
+    start_batch_timer(const fc::time_point& due) {
+        if(_batch_timer_armed)
+            return;
 
-            return true;
-        }
-        FC_LOG_AND_RETHROW()
+        _batch_timer_armed = true;
+        _batch_timer.expires_after(std::chrono::microseconds((due - fc::time_point::now()).count()));
+        _batch_timer.async_wait(boost::asio::bind_executor(
+            _strand,
+            [self = shared_from_this()](boost::system::error_code ec) {
+                self->_batch_timer_armed = false;
+                if(!ec)
+                    self->maybe_send_next_message();
+            }));
     }
 
+    void on_trxs_received_elsewhere(const vector<transaction_id_type>& ids);
+
     void
     on_async_get_block(const signed_block_ptr& nextblock) {
         verify_strand_in_this_thread(_strand, __func__, __LINE__);
@@ -1005,6 +1119,9 @@ public:
             case bnet_message::tag<pong>::value:
                 on(msg.get<pong>());
                 break;
+            case bnet_message::tag<trx_batch>::value:
+                on(msg.get<trx_batch>());
+                break;
             default:
                 wlog("bad message received");
                 _ws->close(boost::beast::websocket::close_code::bad_payload);
@@ -1109,6 +1226,26 @@ public:
     }
 
     void on(const packed_transaction_ptr& p);
+    void on(const trx_batch& b);
+    bool on_incoming_trx(const packed_transaction_ptr& p);
+
+    void
+    mark_short_id_known_by_peer(uint64_t id) {
+        auto& idx   = _transaction_status.get<by_short_id>();
+        auto  range = idx.equal_range(id);
+        if(range.first == range.second) {
+            // not accepted yet, it's checked when it is
+            if(_peer_known_ids.size() < _max_peer_known_ids) {
+                _peer_known_ids.emplace(id, fc::time_point::now() + fc::seconds(5));
+            }
+            return;
+        }
+        for(auto itr = range.first; itr != range.second; ++itr) {
+            idx.modify(itr, [](auto& stat) {
+                stat.mark_known_by_peer();
+            });
+        }
+    }
 
     void
     on_write(boost::system::error_code ec, std::size_t bytes_transferred) {
@@ -1158,14 +1295,13 @@ public:
    */
 class listener : public std::enable_shared_from_this<listener> {
 private:
-    tcp::acceptor     _acceptor;
-    tcp::socket       _socket;
-    bnet_ptr          _net_plugin;
+    tcp::acceptor              _acceptor;
+    std::optional<tcp::socket> _socket;
+    bnet_ptr                   _net_plugin;
 
 public:
     listener(boost::asio::io_context& ioc, tcp::endpoint endpoint, bnet_ptr np)
         : _acceptor(ioc)
-        , _socket(ioc)
         , _net_plugin(std::move(np)) {
         boost::system::error_code ec;
 
@@ -1194,10 +1330,7 @@ public:
         do_accept();
     }
 
-    void
-    do_accept() {
-        _acceptor.async_accept(_socket, [self = shared_from_this()](auto ec) { self->on_accept(ec); });
-    }
+    void do_accept();
 
     void
     on_fail(boost::system::error_code ec, const char* what) {
@@ -1219,11 +1352,16 @@ public:
     bool     _request_trx = true;
     bool     _follow_irreversible = false;
 
+    size_t           _trx_batch_bytes = 64 * 1024;  /// size threshold of batched transaction frames
+    fc::microseconds _trx_batch_delay = fc::microseconds(2000);
+
     std::vector<std::string> _connect_to_peers; /// list of peers to connect to
+    std::vector<std::string> _compress_peers;   /// peers whose sessions are deflate compressed
     std::vector<std::thread> _socket_threads;
     int32_t                  _num_threads = 1;
 
     std::unique_ptr<boost::asio::io_context>         _ioc; // lifetime guarded by shared_ptr of bnet_plugin_impl
+    reactor_plugin*                                  _reactors = nullptr;
     std::shared_ptr<listener>                        _listener;
     std::shared_ptr<boost::asio::deadline_timer>     _timer;    // only access on app io_service
     std::map<const session*, std::weak_ptr<session>> _sessions; // only access on app io_service
@@ -1243,6 +1381,16 @@ public:
         });
     }
 
+    bool
+    compress_peer(const string& host, const string& port) const {
+        for(auto& p : _compress_peers) {
+            if(p == "*" || p == host || (!port.empty() && p == host + ":" + port)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
     void
     on_session_close(const session* s) {
         auto itr = _sessions.find(s);
@@ -1267,7 +1415,22 @@ public:
     void
     on_accepted_transaction(transaction_metadata_ptr trx) {
         if(trx->implicit) return;
-        for_each_session([trx](auto ses) { ses->on_accepted_transaction(trx); });
+        auto rt = std::make_shared<const relay_trx>(std::move(trx));
+        for_each_session([rt](auto ses) { ses->on_accepted_transaction(rt); });
+    }
+
+    /**
+     * Tells the other sessions that transactions are received from session `from`,
+     * called on the strand of that session
+     */
+    void
+    on_trxs_received(const session* from, vector<transaction_id_type> ids) {
+        auto shared_ids = std::make_shared<const vector<transaction_id_type>>(std::move(ids));
+        for_each_session([from, shared_ids](auto ses) {
+            if(ses.get() != from) {
+                ses->on_trxs_received_elsewhere(*shared_ids);
+            }
+        });
     }
 
     /**
@@ -1285,16 +1448,25 @@ public:
     * as a packed bnet_message so the connections can simply relay
     * it on.
     */
+    /**
+     * Context of a new session, the shared reactors are used in turn when they are
+     * enabled. Sessions run on their own strand either way.
+     */
+    boost::asio::io_context&
+    next_ioc() {
+        return _reactors->enabled() ? *_reactors->next() : *_ioc;
+    }
+
     void
     on_accepted_block( block_state_ptr s ) {
-        _ioc->post([s,this] { /// post this to the thread pool because packing can be intensive
+        next_ioc().post([s,this] { /// post this to the thread pool because packing can be intensive
             for_each_session([s](auto ses){ ses->on_accepted_block(s); });
         });
     }
 
     void
     on_accepted_block_header(block_state_ptr s) {
-        _ioc->post([s, this] {  /// post this to the thread pool because packing can be intensive
+        next_ioc().post([s, this] {  /// post this to the thread pool because packing can be intensive
             for_each_session([s](auto ses) { ses->on_accepted_block_header(s); });
         });
     }
@@ -1327,7 +1499,7 @@ public:
 
             if(!found) {
                 wlog("attempt to connect to ${p}", ("p", peer));
-                auto s             = std::make_shared<session>(*_ioc, shared_from_this());
+                auto s             = std::make_shared<session>(next_ioc(), shared_from_this());
                 s->_local_peer_id  = _peer_id;
                 _sessions[s.get()] = s;
                 s->run(peer);
@@ -1351,6 +1523,12 @@ public:
     }
 };
 
+void
+listener::do_accept() {
+    _socket.emplace(_net_plugin->next_ioc());
+    _acceptor.async_accept(*_socket, [self = shared_from_this()](auto ec) { self->on_accept(ec); });
+}
+
 void
 listener::on_accept(boost::system::error_code ec) {
     if(ec) {
@@ -1361,12 +1539,12 @@ listener::on_accept(boost::system::error_code ec) {
     }
     std::shared_ptr<session> newsession;
     try {
-        newsession = std::make_shared<session>(move( _socket ), _net_plugin);
+        newsession = std::make_shared<session>(move( *_socket ), _net_plugin);
     }
     catch(std::exception& e) {
         //making a session creates an instance of std::random_device which may open /dev/urandom
         // for example. Unfortuately the only defined error is a std::exception derivative
-        _socket.close();
+        _socket->close();
     }
     if(newsession) {
         _net_plugin->async_add_session(newsession);
@@ -1388,9 +1566,12 @@ bnet_plugin::set_program_options(options_description& cli, options_description&
     cfg.add_options()
         ("bnet-endpoint", bpo::value<string>()->default_value("0.0.0.0:4321"), "the endpoint upon which to listen for incoming connections")
         ("bnet-follow-irreversible", bpo::value<bool>()->default_value(false), "this peer will request only irreversible blocks from other nodes")
-        ("bnet-threads", bpo::value<uint32_t>(), "the number of threads to use to process network messages")
+        ("bnet-threads", bpo::value<uint32_t>(), "the number of threads to use to process network messages, not used when reactor-threads is set")
         ("bnet-connect", bpo::value<vector<string>>()->composing(), "remote endpoint of other node to connect to; Use multiple bnet-connect options as needed to compose a network")
         ("bnet-no-trx", bpo::bool_switch()->default_value(false), "this peer will request no pending transactions from other nodes")
+        ("bnet-trx-batch-bytes", bpo::value<uint32_t>()->default_value(64 * 1024), "size in bytes at which a batched frame of transactions is sent at once")
+        ("bnet-trx-batch-delay-us", bpo::value<uint32_t>()->default_value(2000), "time in microseconds a transaction waits at most for others to fill its batched frame, 0 to send frames as soon as the connection is idle")
+        ("bnet-compress-peer", bpo::value<vector<string>>()->composing(), "host or host:port of a peer whose session is compressed with websocket permessage-deflate, '*' for every peer; Use multiple bnet-compress-peer options as needed")
         ("bnet-peer-log-format", bpo::value<string>()->default_value( "[\"${_name}\" ${_ip}:${_port}]" ),
             "The string used to format peers when logging messages about them.  Variables are escaped with ${<variable name>}.\n"
             "Available Variables:\n"
@@ -1428,12 +1609,18 @@ bnet_plugin::plugin_initialize(const variables_map& options) {
         if(options.count("bnet-connect")) {
             my->_connect_to_peers = options.at("bnet-connect").as<vector<string>>();
         }
+        if(options.count("bnet-compress-peer")) {
+            my->_compress_peers = options.at("bnet-compress-peer").as<vector<string>>();
+        }
         if(options.count("bnet-threads")) {
             my->_num_threads = options.at("bnet-threads").as<uint32_t>();
             if(my->_num_threads > 8)
                 my->_num_threads = 8;
         }
         my->_request_trx = !options.at("bnet-no-trx").as<bool>();
+
+        my->_trx_batch_bytes = std::max(options.at("bnet-trx-batch-bytes").as<uint32_t>(), 1u);
+        my->_trx_batch_delay = fc::microseconds(options.at("bnet-trx-batch-delay-us").as<uint32_t>());
     }
     FC_LOG_AND_RETHROW();
 }
@@ -1472,25 +1659,30 @@ bnet_plugin::plugin_startup() {
     }
 
     const auto address = boost::asio::ip::make_address(my->_bnet_endpoint_address);
-    my->_ioc.reset(new boost::asio::io_context{my->_num_threads});
+    my->_reactors = app().find_plugin<reactor_plugin>();
+    if(!my->_reactors->enabled()) {
+        my->_ioc.reset(new boost::asio::io_context{my->_num_threads});
+    }
 
-    auto& ioc  = *my->_ioc;
     my->_timer = std::make_shared<boost::asio::deadline_timer>(app().get_io_service());
 
     my->start_reconnect_timer();
 
-    my->_listener = std::make_shared<listener>(ioc,
+    my->_listener = std::make_shared<listener>(my->next_ioc(),
                                                tcp::endpoint{address, my->_bnet_endpoint_port},
                                                my);
     my->_listener->run();
 
-    my->_socket_threads.reserve(my->_num_threads);
-    for(auto i = 0; i < my->_num_threads; ++i) {
-        my->_socket_threads.emplace_back([&ioc] { wlog( "start thread" ); ioc.run(); wlog( "end thread" ); });
+    if(my->_ioc) {
+        auto& ioc = *my->_ioc;
+        my->_socket_threads.reserve(my->_num_threads);
+        for(auto i = 0; i < my->_num_threads; ++i) {
+            my->_socket_threads.emplace_back([&ioc] { wlog( "start thread" ); ioc.run(); wlog( "end thread" ); });
+        }
     }
 
     for(const auto& peer : my->_connect_to_peers) {
-        auto s                 = std::make_shared<session>(ioc, my);
+        auto s                 = std::make_shared<session>(my->next_ioc(), my);
         s->_local_peer_id      = my->_peer_id;
         my->_sessions[s.get()] = s;
         s->run(peer);
@@ -1514,6 +1706,10 @@ bnet_plugin::plugin_shutdown() {
     });
 
     my->_listener.reset();
+    if(!my->_ioc) {
+        // sessions on the shared reactors finish closing before reactor_plugin stops them
+        return;
+    }
     my->_ioc->stop();
 
     wlog("joining bnet threads");
@@ -1536,6 +1732,18 @@ bnet_plugin::handle_sighup() {
     }
 }
 
+void
+session::set_compression_options(const string& host, const string& port) {
+    if(!_net_plugin->compress_peer(host, port)) {
+        return;
+    }
+    // negotiated in the websocket upgrade, a peer without it stays uncompressed
+    auto opt = ws::permessage_deflate();
+    opt.client_enable = true;
+    opt.server_enable = true;
+    _ws->set_option(opt);
+}
+
 session::~session() {
     wlog("close session ${n}", ("n", _session_num));
     std::weak_ptr<bnet_plugin_impl> netp = _net_plugin;
@@ -1624,6 +1832,7 @@ session::on(const hello& hi, fc::datastream<const char*>& ds) {
 
     _last_sent_block_num   = hi.last_irr_block_num;
     _remote_request_trx    = hi.request_transactions;
+    _remote_batch_trx      = hi.protocol_version >= "1.0.2";
     _remote_peer_id        = hi.peer_id;
     _remote_lib            = hi.last_irr_block_num;
 
@@ -1634,9 +1843,119 @@ session::on(const hello& hi, fc::datastream<const char*>& ds) {
     check_for_redundant_connection();
 }
 
+/**
+ *  Sends the transactions not known by peer in the order received, a peer of protocol
+ *  1.0.2 gets them in one frame along with the ids to tell it. A frame not reaching the
+ *  size threshold waits until its oldest transaction was received `bnet-trx-batch-delay-us`
+ *  ago, the ids alone are sent at once.
+ */
+bool
+session::send_next_trx() {
+    try {
+        auto& idx = _transaction_status.get<by_received>();
+        if(!_remote_batch_trx) {
+            if(!_remote_request_trx || idx.begin() == idx.end() || idx.begin()->known_by_peer())
+                return false;
+
+            auto start = idx.begin();
+            auto trxs  = vector<relay_trx_ptr>{ start->trx };
+            idx.modify(start, [&](auto& stat) {
+                stat.mark_known_by_peer();
+            });
+
+            // wlog("sending trx ${id}", ("id",start->id) );
+            send(vector<uint64_t>(), trxs);
+            return true;
+        }
+
+        auto max_bytes = _net_plugin->_trx_batch_bytes;
+        auto count     = 0u;
+        auto bytes     = size_t(0);
+        for(auto itr = idx.begin(); _remote_request_trx && itr != idx.end() && !itr->known_by_peer(); ++itr) {
+            if(count >= _max_batch_trxs || bytes >= max_bytes)
+                break;
+            count++;
+            bytes += itr->trx->payload().size();
+        }
+        if(count == 0 && _known_ids_to_send.empty())
+            return false;
+
+        if(count > 0 && count < _max_batch_trxs && bytes < max_bytes && _known_ids_to_send.empty()) {
+            auto due = idx.begin()->received + _net_plugin->_trx_batch_delay;
+            if(due > fc::time_point::now()) {
+                start_batch_timer(due);
+                return false;
+            }
+        }
+
+        auto trxs = vector<relay_trx_ptr>();
+        trxs.reserve(count);
+        for(auto i = 0u; i < count; i++) {
+            auto start = idx.begin();
+            trxs.emplace_back(start->trx);
+            idx.modify(start, [&](auto& stat) {
+                stat.mark_known_by_peer();
+            });
+        }
+
+        auto ids = vector<uint64_t>();
+        ids.swap(_known_ids_to_send);
+        send(ids, trxs);
+        return true;
+    }
+    FC_LOG_AND_RETHROW()
+}
+
+/**
+ *  Transactions just received from another peer, the peer is told we have them unless it
+ *  knows them already, so that it doesn't send them to us while we're applying them.
+ */
+void
+session::on_trxs_received_elsewhere(const vector<transaction_id_type>& ids) {
+    verify_strand_in_this_thread(_strand, __func__, __LINE__);
+    if(!_remote_batch_trx || !_net_plugin->_request_trx)
+        return;
+
+    for(auto& id : ids) {
+        auto itr = _transaction_status.find(id);
+        if(itr != _transaction_status.end() && itr->known_by_peer())
+            continue;
+        _known_ids_to_send.emplace_back(short_trx_id(id));
+    }
+    maybe_send_next_message();
+}
+
 void
 session::on(const packed_transaction_ptr& p) {
     peer_ilog(this, "received packed_transaction_ptr");
+    if(on_incoming_trx(p)) {
+        _net_plugin->on_trxs_received(this, { p->id() });
+    }
+}
+
+void
+session::on(const trx_batch& b) {
+    peer_ilog(this, "received trx_batch");
+    for(auto id : b.known_ids) {
+        mark_short_id_known_by_peer(id);
+    }
+
+    auto ids = vector<transaction_id_type>();
+    for(auto& p : b.trxs) {
+        if(on_incoming_trx(p)) {
+            ids.emplace_back(p->id());
+        }
+    }
+    if(!ids.empty()) {
+        _net_plugin->on_trxs_received(this, std::move(ids));
+    }
+}
+
+/**
+ * @return true if trx is new to this session and is pushed to the chain
+ */
+bool
+session::on_incoming_trx(const packed_transaction_ptr& p) {
     if(!p) {
         peer_elog(this, "bad packed_transaction_ptr : null pointer");
         EVT_THROW(transaction_exception, "bad transaction");
@@ -1644,15 +1963,16 @@ session::on(const packed_transaction_ptr& p) {
 
     // ilog( "recv trx ${n}", ("n", id) );
     if(p->expiration() < fc::time_point::now())
-        return;
+        return false;
 
     const auto& id = p->id();
     if(mark_transaction_known_by_peer(id)) {
-        return;
+        return false;
     }
 
     auto ptr = std::make_shared<transaction_metadata>(p);
     app().get_channel<incoming::channels::transaction>().publish(priority::low, ptr);
+    return true;
 }
 
 }  // namespace evt
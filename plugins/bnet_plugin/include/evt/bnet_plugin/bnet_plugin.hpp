@@ -6,6 +6,7 @@
 #include <appbase/application.hpp>
 
 #include <evt/chain_plugin/chain_plugin.hpp>
+#include <evt/reactor_plugin/reactor_plugin.hpp>
 
 namespace fc {
 class variant;
@@ -27,7 +28,7 @@ typedef shared_ptr<const class bnet_plugin_impl> bnet_const_ptr;
 
 class bnet_plugin : public plugin<bnet_plugin> {
 public:
-    APPBASE_PLUGIN_REQUIRES((chain_plugin))
+    APPBASE_PLUGIN_REQUIRES((chain_plugin)(reactor_plugin))
 
     bnet_plugin();
     virtual ~bnet_plugin();
@@ -6,6 +6,7 @@
 #include <evt/chain_api_plugin/chain_api_plugin.hpp>
 
 #include <fc/io/json.hpp>
+#include <fc/io/raw.hpp>
 
 namespace evt {
 
@@ -49,6 +50,15 @@ get_json<std::string>(const std::string& value) {
     return value;
 }
 
+// results of blocks past the last irreversible block never change
+template<typename API>
+bool
+is_irreversible(const API& api, const fc::variant& result) {
+    auto& obj = result.get_object();
+    auto  it  = obj.find("block_num");
+    return it != obj.end() && it->value().as_uint64() <= api.db.last_irreversible_block_num();
+}
+
 }  // namespace internal
 
 #define CALL(api_name, api_handle, api_namespace, call_name, http_response_code)                                             \
@@ -69,6 +79,25 @@ get_json<std::string>(const std::string& value) {
             }                                                                                                                \
     }
 
+#define CALL_CACHED(api_name, api_handle, api_namespace, call_name, http_response_code)                                      \
+    {                                                                                                                        \
+        std::string("/v1/" #api_name "/" #call_name),                                                                        \
+            [api_handle](string, string body, url_cacheable_response_callback cb) mutable {                                  \
+                using namespace internal;                                                                                  \
+                try {                                                                                                        \
+                    if(body.empty()) {                                                                                       \
+                        body = "{}";                                                                                         \
+                    }                                                                                                        \
+                    auto result = api_handle.call_name(fc::json::from_string(body).as<api_namespace::call_name##_params>()); \
+                    cb(http_response_code, get_json(result), is_irreversible(api_handle, result));                           \
+                }                                                                                                            \
+                catch(...) {                                                                                                 \
+                    http_plugin::handle_exception(#api_name, #call_name, body,                                               \
+                        [cb](auto code, auto response) { cb(code, std::move(response), false); });                           \
+                }                                                                                                            \
+            }                                                                                                                \
+    }
+
 #define CALL_ASYNC(api_name, api_handle, api_namespace, call_name, call_result, http_response_code)                 \
     {                                                                                                               \
         std::string("/v1/" #api_name "/" #call_name),                                                               \
@@ -94,6 +123,7 @@ get_json<std::string>(const std::string& value) {
 
 #define CHAIN_RO_CALL(call_name, http_response_code) CALL(chain, ro_api, chain_apis::read_only, call_name, http_response_code)
 #define CHAIN_RW_CALL(call_name, http_response_code) CALL(chain, rw_api, chain_apis::read_write, call_name, http_response_code)
+#define CHAIN_RO_CALL_CACHED(call_name, http_response_code) CALL_CACHED(chain, ro_api, chain_apis::read_only, call_name, http_response_code)
 #define CHAIN_RO_CALL_ASYNC(call_name, call_result, http_response_code) CALL_ASYNC(chain, ro_api, chain_apis::read_only, call_name, call_result, http_response_code)
 #define CHAIN_RW_CALL_ASYNC(call_name, call_result, http_response_code) CALL_ASYNC(chain, rw_api, chain_apis::read_write, call_name, call_result, http_response_code)
 
@@ -107,25 +137,80 @@ chain_api_plugin::plugin_startup() {
     auto& _http_plugin = app().get_plugin<http_plugin>();
     ro_api.set_shorten_abi_errors(!_http_plugin.verbose_errors());
 
-    _http_plugin.add_api({CHAIN_RO_CALL(get_info, 200),
-                          CHAIN_RO_CALL(get_block, 200),
-                          CHAIN_RO_CALL(get_block_header_state, 200),
-                          CHAIN_RO_CALL(get_head_block_header_state, 200),
-                          CHAIN_RO_CALL(get_transaction, 200),
-                          CHAIN_RO_CALL(get_trx_id_for_link_id, 200),
-                          CHAIN_RO_CALL(abi_json_to_bin, 200),
-                          CHAIN_RO_CALL(abi_bin_to_json, 200),
-                          CHAIN_RO_CALL(trx_json_to_digest, 200),
-                          CHAIN_RO_CALL(get_required_keys, 200),
-                          CHAIN_RO_CALL(get_suspend_required_keys, 200),
-                          CHAIN_RO_CALL(get_charge, 200),
-                          CHAIN_RO_CALL(get_transaction_ids_for_block, 200),
-                          CHAIN_RO_CALL(get_abi, 200),
-                          CHAIN_RO_CALL(get_actions, 200),
-                          CHAIN_RW_CALL_ASYNC(push_block, chain_apis::read_write::push_block_results, 202),
+    _http_plugin.add_cacheable_api({CHAIN_RO_CALL_CACHED(get_block, 200),
+                                    CHAIN_RO_CALL_CACHED(get_transaction, 200)});
+    _http_plugin.add_read_only_api({CHAIN_RO_CALL(get_info, 200),
+                                    CHAIN_RO_CALL(get_block_header_state, 200),
+                                    CHAIN_RO_CALL(get_head_block_header_state, 200),
+                                    CHAIN_RO_CALL(get_trx_id_for_link_id, 200),
+                                    CHAIN_RO_CALL(abi_json_to_bin, 200),
+                                    CHAIN_RO_CALL(abi_bin_to_json, 200),
+                                    CHAIN_RO_CALL(trx_json_to_digest, 200),
+                                    CHAIN_RO_CALL(get_required_keys, 200),
+                                    CHAIN_RO_CALL(get_suspend_required_keys, 200),
+                                    CHAIN_RO_CALL(get_charge, 200),
+                                    CHAIN_RO_CALL(get_transaction_ids_for_block, 200),
+                                    CHAIN_RO_CALL(get_abi, 200),
+                                    CHAIN_RO_CALL(get_actions, 200)});
+    _http_plugin.add_api({CHAIN_RW_CALL_ASYNC(push_block, chain_apis::read_write::push_block_results, 202),
                           CHAIN_RW_CALL_ASYNC(push_transaction, chain_apis::read_write::push_transaction_results, 202),
-                          CHAIN_RW_CALL_ASYNC(push_transactions, chain_apis::read_write::push_transactions_results, 202)});
-    _http_plugin.add_api({CHAIN_RO_CALL(get_db_info, 200)}, true /* local only API */);
+                          CHAIN_RW_CALL_ASYNC(push_transactions, chain_apis::read_write::push_transactions_results, 202),
+                          // body is either a json array of packed transactions or length-prefixed binary ones
+                          {std::string("/v1/chain/push_packed_transactions"),
+                           [rw_api](string, string body, url_response_callback cb) mutable {
+                               using result_type = chain_apis::read_write::push_packed_transactions_results;
+                               rw_api.push_packed_transactions(chain_apis::read_write::parse_packed_transactions(body),
+                                   [cb](const fc::static_variant<fc::exception_ptr, result_type>& result) {
+                                       if(result.contains<fc::exception_ptr>()) {
+                                           try {
+                                               result.get<fc::exception_ptr>()->dynamic_rethrow_exception();
+                                           }
+                                           catch(...) {
+                                               http_plugin::handle_exception("chain", "push_packed_transactions", "", cb);
+                                           }
+                                       }
+                                       else {
+                                           cb(202, result.visit(async_result_visitor()));
+                                       }
+                                   });
+                           }}});
+    _http_plugin.add_api({CHAIN_RO_CALL(get_db_info, 200),
+                          CHAIN_RO_CALL(get_action_costs, 200),
+                          CHAIN_RO_CALL(get_memory_usage, 200),
+                          CHAIN_RO_CALL(get_hot_keys, 200),
+                          CHAIN_RW_CALL(set_memory_budget, 200)}, true /* local only API */);
+
+    // binary calls for co-located consumers on the unix socket
+    // get_block takes a raw block number and returns the raw signed block
+    _http_plugin.add_binary_handler("/v1/chain/get_block", [this](string, string body, url_response_callback cb) {
+        auto num   = fc::raw::unpack<uint32_t>(body.data(), body.size());
+        auto block = my->db.fetch_block_by_number(num);
+        EVT_ASSERT(block != nullptr, chain::unknown_block_exception, "Could not find block: ${n}", ("n",num));
+
+        auto data = fc::raw::pack(*block);
+        cb(200, string(data.begin(), data.end()));
+    });
+    // push_transaction takes a raw packed transaction and returns the raw transaction id
+    _http_plugin.add_binary_handler("/v1/chain/push_transaction", [](string, string body, url_response_callback cb) {
+        auto trx = fc::raw::unpack<chain::packed_transaction>(body.data(), body.size());
+        app().get_plugin<chain_plugin>().accept_transaction(trx,
+            [cb](const fc::static_variant<fc::exception_ptr, chain::transaction_trace_ptr>& result) {
+                try {
+                    if(result.contains<fc::exception_ptr>()) {
+                        result.get<fc::exception_ptr>()->dynamic_rethrow_exception();
+                    }
+                    auto& trace = result.get<chain::transaction_trace_ptr>();
+                    if(trace->except.has_value()) {
+                        trace->except->dynamic_rethrow_exception();
+                    }
+                    auto id = fc::raw::pack(trace->id);
+                    cb(202, string(id.begin(), id.end()));
+                }
+                catch(...) {
+                    http_plugin::handle_exception("chain", "push_transaction", "", cb);
+                }
+            });
+    });
 }
 
 void
@@ -3,9 +3,11 @@
  *  @copyright defined in evt/LICENSE.txt
  */
 #include <evt/chain_plugin/chain_plugin.hpp>
+#include <evt/chain_plugin/replay_profiler.hpp>
 
 #include <signal.h>
 #include <stdlib.h>
+#include <deque>
 
 #include <boost/signals2/connection.hpp>
 
@@ -17,14 +19,20 @@
 #include <evt/chain/exceptions.hpp>
 #include <evt/chain/fork_database.hpp>
 #include <evt/chain/reversible_block_object.hpp>
+#include <evt/chain/reversible_block_store.hpp>
+#include <evt/chain/trx_index.hpp>
 #include <evt/chain/types.hpp>
 #include <evt/chain/genesis_state.hpp>
 #include <evt/chain/snapshot.hpp>
+#include <evt/chain/token_database_cache.hpp>
 #include <evt/chain/contracts/evt_contract_abi.hpp>
 #include <evt/chain/contracts/evt_link.hpp>
 #include <evt/chain/contracts/evt_link_object.hpp>
 
+#include <evt/utilities/cpu_affinity.hpp>
 #include <evt/utilities/key_conversion.hpp>
+#include <evt/utilities/memory_budget.hpp>
+#include <evt/utilities/metrics.hpp>
 
 namespace evt {
 
@@ -116,6 +124,45 @@ validate(boost::any&                     v,
     }
 }
 
+std::ostream&
+operator<<(std::ostream& osm, evt::chain::durability_mode m) {
+    if(m == evt::chain::durability_mode::STRICT) {
+        osm << "strict";
+    }
+    else if(m == evt::chain::durability_mode::GROUP) {
+        osm << "group";
+    }
+    else if(m == evt::chain::durability_mode::RELAXED) {
+        osm << "relaxed";
+    }
+
+    return osm;
+}
+
+void
+validate(boost::any&                     v,
+         const std::vector<std::string>& values,
+         evt::chain::durability_mode* /* target_type */,
+         int) {
+    using namespace boost::program_options;
+
+    validators::check_first_occurrence(v);
+    std::string const& s = validators::get_single_string(values);
+
+    if(s == "strict") {
+        v = boost::any(evt::chain::durability_mode::STRICT);
+    }
+    else if(s == "group") {
+        v = boost::any(evt::chain::durability_mode::GROUP);
+    }
+    else if(s == "relaxed") {
+        v = boost::any(evt::chain::durability_mode::RELAXED);
+    }
+    else {
+        throw validation_error(validation_error::invalid_option_value);
+    }
+}
+
 std::ostream&
 operator<<(std::ostream& osm, evt::chain::storage_profile m) {
     if(m == evt::chain::storage_profile::disk) {
@@ -124,6 +171,9 @@ operator<<(std::ostream& osm, evt::chain::storage_profile m) {
     else if(m == evt::chain::storage_profile::memory) {
         osm << "memory";
     }
+    else if(m == evt::chain::storage_profile::ram) {
+        osm << "ram";
+    }
 
     return osm;
 }
@@ -148,6 +198,9 @@ validate(boost::any&                     v,
     else if(s == "memory") {
         v = boost::any(evt::chain::storage_profile::memory);
     }
+    else if(s == "ram") {
+        v = boost::any(evt::chain::storage_profile::ram);
+    }
     else {
         throw validation_error(validation_error::invalid_option_value);
     }
@@ -206,6 +259,17 @@ public:
     std::optional<controller>         chain;
     std::optional<chain_id_type>      chain_id;
     std::optional<bfs::path>          snapshot_path;
+    std::vector<bfs::path>            snapshot_diff_paths;
+    bool                              empty_state = false;  // started from genesis unless given a snapshot
+
+    inflight_transactions          inflight_trxs;
+    std::optional<block_trace_bus> trace_bus;
+
+    std::optional<utilities::metrics::collector_id> metrics_collector;
+    std::vector<utilities::memory::component_id>    memory_components;
+
+    std::optional<replay_profiler> profiler;
+    std::optional<bfs::path>       profile_path;
 
     // retained references to channels for easy publication
     channels::pre_accepted_block::channel_type&    pre_accepted_block_channel;
@@ -227,18 +291,80 @@ public:
     methods::get_last_irreversible_block_number::method_type::handle get_last_irreversible_block_number_provider;
 
     // scoped connections for chain controller
-    std::optional<scoped_connection> pre_accepted_block_connection;
-    std::optional<scoped_connection> accepted_block_header_connection;
-    std::optional<scoped_connection> accepted_block_connection;
-    std::optional<scoped_connection> irreversible_block_connection;
-    std::optional<scoped_connection> accepted_transaction_connection;
-    std::optional<scoped_connection> applied_transaction_connection;
+    std::optional<scoped_connection>                    pre_accepted_block_connection;
+    std::optional<scoped_connection>                    accepted_block_header_connection;
+    std::optional<utilities::scoped_signal_connection> accepted_block_connection;
+    std::optional<scoped_connection>                    irreversible_block_connection;
+    std::optional<utilities::scoped_signal_connection> accepted_transaction_connection;
+    std::optional<utilities::scoped_signal_connection> applied_transaction_connection;
+    std::optional<scoped_connection>                    applied_token_changes_connection;
+    std::optional<scoped_connection>                    reverted_token_changes_connection;
+
+    void add_memory_components(const token_database::config& db_config);
 };
 
+void
+chain_plugin_impl::add_memory_components(const token_database::config& db_config) {
+    using namespace utilities::memory;
+    auto& a = accountant::get();
+
+    // chainbase files are mapped with fixed sizes, guards already stop the node before they're full
+    auto add_chainbase = [&](const std::string& name, auto get_db) {
+        memory_components.emplace_back(a.add_component(name, [this, get_db](auto& u) {
+            auto sm = get_db(*chain).get_segment_manager();
+            u.bytes = sm->get_size() - sm->get_free_memory();
+        }));
+    };
+    add_chainbase("chain_state", [](auto& c) -> auto& { return c.db(); });
+
+    // reversible blocks are on disk, only their positions are kept in memory
+    memory_components.emplace_back(a.add_component("reversible_blocks", [this](auto& u) {
+        u.items = chain->reversible_blocks().size();
+    }));
+
+    memory_components.emplace_back(a.add_component("fork_db", [this](auto& u) {
+        u.bytes = chain->fork_db().blocks_size();
+        u.items = chain->fork_db().size();
+    }));
+
+    memory_components.emplace_back(a.add_component("token_db_memtables", [this](auto& u) {
+        auto mu = chain->token_db().get_memory_usage();
+        u.bytes = mu.memtables + mu.table_readers;
+    }));
+    memory_components.emplace_back(a.add_component("token_db_write_cache", [this](auto& u) {
+        u.bytes = chain->token_db().get_memory_usage().write_cache;
+    }));
+    memory_components.emplace_back(a.add_component("token_db_key_filters", [this](auto& u) {
+        u.bytes = chain->token_db().get_memory_usage().key_filters;
+    }));
+
+    // caches shrink to their budgets and grow back to the configured sizes when budgets are lifted
+    auto add_cache = [&](const std::string& name, uint64_t size, auto get_usage, auto set_capacity) {
+        auto applied = std::make_shared<uint64_t>(size);
+        memory_components.emplace_back(a.add_component(name, [this, get_usage](auto& u) {
+            u.bytes = get_usage(*chain);
+        }, [this, size, applied, set_capacity](auto& u) {
+            auto cap = u.budget > 0 ? std::min(u.budget, size) : size;
+            if(cap != *applied) {
+                ilog("Capacity of ${n} is changed to ${c} bytes", ("n", u.name)("c", cap));
+                set_capacity(*chain, cap);
+                *applied = cap;
+            }
+        }));
+    };
+    add_cache("token_db_block_cache", db_config.block_cache_size,
+        [](auto& c) { return c.token_db().get_memory_usage().block_cache; },
+        [](auto& c, auto cap) { c.token_db().set_block_cache_capacity(cap); });
+    add_cache("token_db_object_cache", db_config.object_cache_size,
+        [](auto& c) { return c.token_db_cache().usage(); },
+        [](auto& c, auto cap) { c.token_db_cache().set_capacity(cap); });
+}
+
 chain_plugin::chain_plugin()
     :my(new chain_plugin_impl()) {
     app().register_config_type<evt::chain::db_read_mode>();
     app().register_config_type<evt::chain::validation_mode>();
+    app().register_config_type<evt::chain::durability_mode>();
     app().register_config_type<evt::chain::storage_profile>();
 }
 
@@ -250,17 +376,64 @@ chain_plugin::set_program_options(options_description& cli, options_description&
         ("blocks-dir", bpo::value<bfs::path>()->default_value("blocks"), "the location of the blocks directory (absolute path or relative to application data dir)")
         ("token-db-dir", bpo::value<bfs::path>()->default_value("tokendb"), "the location of the token database directory (absolute path or relative to application data dir)")
         ("token-db-cache-size-mb", bpo::value<uint32_t>()->default_value(512), "the cache size of token database in MBytes")
+        ("token-db-cache-shards", bpo::value<uint32_t>()->default_value(16), "the number of shards of token database object cache, rounded up to power of two")
+        ("token-db-assets-compaction", bpo::value<std::string>()->default_value("universal"), "compaction style of assets in token database (\"universal\" or \"level\"), \"level\" suits high-churn balances")
+        ("token-db-assets-bloom-bits", bpo::value<uint32_t>()->default_value(10), "bits per key of the bloom filter for assets in token database, 0 to disable")
+        ("token-db-tokens-compaction", bpo::value<std::string>()->default_value("universal"), "compaction style of tokens in token database (\"universal\" or \"level\"), \"level\" is required to demote cold domains")
+        ("token-db-cold-dir", bpo::value<bfs::path>(), "the location of the cold tier of tokens, on cheaper disks (absolute path or relative to application data dir)")
+        ("token-db-hot-size-mb", bpo::value<uint32_t>()->default_value(8192), "the size of tokens kept in token-db-dir before they go to token-db-cold-dir in MBytes")
+        ("token-db-cold-domain-secs", bpo::value<uint32_t>()->default_value(0), "compact the tokens of the domains not accessed for this long into the bottom level of token database, 0 to disable")
+        ("token-db-cold-zstd-level", bpo::value<uint32_t>()->default_value(0), "zstd level of the bottom level of tokens with a trained dictionary, 0 for the default compression")
+        ("token-db-prefetch", bpo::value<bool>()->default_value(true), "load the token and asset keys of blocks into block cache of token database ahead of execution")
+        ("token-db-io-rate-mb", bpo::value<uint32_t>()->default_value(0), "MB per second of flushes and compactions of token database while blocks are made, 0 for unlimited")
+        ("token-db-idle-io-rate-mb", bpo::value<uint32_t>()->default_value(0), "MB per second of flushes and compactions of token database between the blocks produced by this node, 0 for unlimited")
+        ("token-db-auto-tune", bpo::bool_switch()->default_value(false), "let background I/O of token database follow the demand below its rates, and size its write buffers by the write rate")
+        ("evt-link-cache-size", bpo::value<uint32_t>()->default_value(contracts::evt_link::kDefaultCacheSize), "the number of parsed EVT-Links and of their restored keys kept in memory, 0 to disable")
+        ("signature-cache-size", bpo::value<uint32_t>()->default_value(transaction::kDefaultRecoveryCacheSize), "the number of public keys recovered from transaction signatures kept in memory, 0 to disable")
+        ("token-db-async-persist", bpo::bool_switch()->default_value(false), "sync irreversible savepoints of token database in background thread")
+        ("fork-db-retention-blocks", bpo::value<uint32_t>()->default_value(config::default_fork_db_retention_window), "drop the forks fallen behind head block by more than this number of blocks from fork database, 0 to keep all")
+        ("state-hugepages", bpo::bool_switch()->default_value(false), "advise the kernel to back the mapped chain state with huge pages, which takes effect when the state directory is on a filesystem supporting them (ex. tmpfs mounted with huge=advise)")
+        ("expired-trxs-cleanup-rows", bpo::value<uint32_t>()->default_value(config::default_expired_trxs_cleanup_rows), "erase at most this number of expired transactions from deduplication list at the start of each block, the rest are left to following blocks, 0 to erase all")
+        ("blocks-log-retained", bpo::value<uint32_t>()->default_value(0), "keep only the latest N irreversible blocks in block log, older blocks are removed a segment at a time and peers are told not to ask for them, 0 to keep all")
+        ("durability", bpo::value<evt::chain::durability_mode>()->default_value(evt::chain::durability_mode::STRICT),
+            "When irreversible blocks and token database are synced to the disk (\"strict\", \"group\" or \"relaxed\").\n"
+            "In \"strict\" mode every block is synced, as producers should.\n"
+            "In \"group\" mode blocks are synced together every group-commit-blocks blocks or group-commit-ms milliseconds.\n"
+            "In \"relaxed\" mode syncing is left to the OS until shutdown, a crash may lose the latest blocks and they're fetched again from peers.\n")
+        ("group-commit-blocks", bpo::value<uint32_t>()->default_value(config::default_group_commit_blocks), "irreversible blocks synced together in group durability mode")
+        ("group-commit-ms", bpo::value<uint32_t>()->default_value(config::default_group_commit_ms), "blocks are synced once this many milliseconds passed since the last sync in group durability mode, even when fewer than group-commit-blocks")
+        ("trx-index", bpo::bool_switch()->default_value(false), "index transactions of irreversible blocks by their ids, so get_transaction finds them after they expire. Blocks in block log are indexed at startup when it's turned on")
+        ("state-checkpoints-dir", bpo::value<bfs::path>()->default_value("checkpoints"), "the location of the state checkpoints directory (absolute path or relative to application data dir)")
+        ("state-checkpoint-interval", bpo::value<uint32_t>()->default_value(config::default_checkpoint_interval), "write a checkpoint of chain state and token database every N blocks, replay starts from the latest one consistent with block log, 0 to disable")
+        ("state-checkpoints-to-keep", bpo::value<uint32_t>()->default_value(config::default_checkpoints_to_keep), "the number of latest state checkpoints to keep")
+        ("token-db-persist-queue-size", bpo::value<uint32_t>()->default_value(16), "the max number of irreversible savepoints waiting for sync before blocking")
+        ("token-db-irreversible-reads", bpo::bool_switch()->default_value(false), "keep a view of the irreversible state of token database for reads with irreversible consistency")
+        ("token-db-owner-index", bpo::bool_switch()->default_value(false), "index tokens by their owners for get_owned_tokens, only can be changed with a new token database")
+        ("token-db-holding-index", bpo::bool_switch()->default_value(false), "index symbols by their holders for get_fungible_balance without sym_id, only can be changed with a new token database")
+        ("token-db-changes", bpo::bool_switch()->default_value(false), "relay the changes of token database made by each transaction to the plugins writing blocks out of the main thread")
+        ("token-db-hot-keys-sample", bpo::value<uint32_t>()->default_value(64), "sample one of every N reads and writes of token database to find the hot keys, 0 to disable")
         ("token-db-profile", boost::program_options::value<evt::chain::storage_profile>()->default_value(evt::chain::storage_profile::disk),
-            "Token database profile (\"disk\", or \"memory\").\n"
+            "Token database profile (\"disk\", \"memory\" or \"ram\").\n"
             "In \"disk\" profile database is optimized for the standard storage devices.\n"
             "In \"memory\" mode database is optimized for the usage in ultra-low latency devices like memory\n"
+            "In \"ram\" mode database is kept in RAM only, state is rebuilt from snapshot or by replaying on every start\n"
         )
+        ("memory-budget", bpo::value<vector<string>>()->composing(),
+            "Soft memory budget (in MiB) of a component in form of 'component=MiB', caches shrink to their budgets and queues hold back their producers above them. "
+            "See get_memory_usage of chain api for the components")
+        ("block-trace-bus-size", bpo::value<uint32_t>()->default_value(16384), "number of controller events kept for the plugins writing blocks out of the main thread")
+        ("chain-threads", bpo::value<uint16_t>()->default_value(config::default_controller_thread_pool_size), "number of worker threads shared by the node for signature recovery, merkle roots and the background work of plugins")
+        ("chain-threads-cpus", bpo::value<string>(), "CPUs the chain threads are pinned to, like '0-3,8' or 'node:0' for all the CPUs of NUMA node 0")
+        ("main-thread-cpus", bpo::value<string>(), "CPUs the main thread is pinned to, like '0-3,8' or 'node:0'. "
+            "It's pinned before the databases are opened, so the memory of chain state and caches touched first by it is allocated on the NUMA node of these CPUs. "
+            "Threads started by it afterwards inherit these CPUs unless they're pinned by their own options")
+        ("token-db-cpus", bpo::value<string>(), "CPUs the flush and compaction threads of token database are pinned to, like '0-3,8' or 'node:0'")
         ("checkpoint", bpo::value<vector<string>>()->composing(), "Pairs of [BLOCK_NUM,BLOCK_ID] that should be enforced as checkpoints.")
         ("abi-serializer-max-time-ms", bpo::value<uint32_t>()->default_value(config::default_abi_serializer_max_time_ms), "Override default maximum ABI serialization time allowed in ms")
         ("chain-state-db-size-mb", bpo::value<uint64_t>()->default_value(config::default_state_size / (1024 * 1024)), "Maximum size (in MiB) of the chain state database")
         ("chain-state-db-guard-size-mb", bpo::value<uint64_t>()->default_value(config::default_state_guard_size / (1024 * 1024)), "Safely shut down node when free space remaining in the chain state database drops below this size (in MiB).")
-        ("reversible-blocks-db-size-mb", bpo::value<uint64_t>()->default_value(config::default_reversible_cache_size / (1024 * 1024)), "Maximum size (in MiB) of the reversible blocks database")
-        ("reversible-blocks-db-guard-size-mb", bpo::value<uint64_t>()->default_value(config::default_reversible_guard_size / (1024 * 1024)), "Safely shut down node when free space remaining in the reverseible blocks database drops below this size (in MiB).")
+        ("reversible-blocks-db-size-mb", bpo::value<uint64_t>()->default_value(config::default_reversible_cache_size / (1024 * 1024)), "Deprecated, reversible blocks are kept in a file which grows as needed")
+        ("reversible-blocks-db-guard-size-mb", bpo::value<uint64_t>()->default_value(config::default_reversible_guard_size / (1024 * 1024)), "Safely shut down node when free disk space remaining for the reversible blocks drops below this size (in MiB).")
         ("contracts-console", bpo::bool_switch()->default_value(false), "print contract's output to console")
         ("read-mode", boost::program_options::value<evt::chain::db_read_mode>()->default_value(evt::chain::db_read_mode::SPECULATIVE),
             "Database read mode (\"speculative\", \"head\", or \"read-only\").\n"// or \"irreversible\").\n"
@@ -279,6 +452,7 @@ chain_plugin::set_program_options(options_description& cli, options_description&
     cli.add_options()
         ("genesis-json", bpo::value<bfs::path>(), "File to read Genesis State from")
         ("genesis-timestamp", bpo::value<string>(), "override the initial timestamp in the Genesis State file")
+        ("genesis-initial-state", bpo::value<bfs::path>(), "File to read the initial state declared by the Genesis State from, required to start a fresh blockchain with it")
         ("print-genesis-json", bpo::bool_switch()->default_value(false), "extract genesis_state from blocks.log as JSON, print to console, and exit")
         ("extract-genesis-json", bpo::value<bfs::path>(), "extract genesis_state from blocks.log as JSON, write into specified file, and exit")
         ("fix-reversible-blocks", bpo::bool_switch()->default_value(false), "recovers reversible block database if that database is in a bad state")
@@ -287,6 +461,11 @@ chain_plugin::set_program_options(options_description& cli, options_description&
         ("loadtest-mode", bpo::bool_switch()->default_value(false), "special for load-testing, skip expiration and reference block checks")
         ("charge-free-mode", bpo::bool_switch()->default_value(false), "do not charge any fees for transactions")
         ("replay-blockchain", bpo::bool_switch()->default_value(false), "clear chain state database and token database and replay all blocks")
+        ("replay-profile", bpo::value<bfs::path>(), "clear chain state database and token database like replay-blockchain, profile the blocks replayed in the range "
+            "and write the report of the slowest blocks, transactions and keys into this json file, then exit")
+        ("replay-profile-first-block", bpo::value<uint32_t>()->default_value(1), "first block profiled by replay-profile")
+        ("replay-profile-last-block", bpo::value<uint32_t>()->default_value(0), "replay stops after this block in replay-profile, 0 to replay the whole block log")
+        ("replay-profile-top", bpo::value<uint32_t>()->default_value(50), "number of the slowest blocks, transactions and the hottest keys in the report")
         ("hard-replay-blockchain", bpo::bool_switch()->default_value(false), "clear chain state database and token database, recover as many blocks as possible from the block log, and then replay those blocks")
         ("delete-all-blocks", bpo::bool_switch()->default_value(false), "clear chain state database, token database and block log")
         ("truncate-at-block", bpo::value<uint32_t>()->default_value(0), "stop hard replay / block log recovery at this block number (if set to non-zero number)")
@@ -294,6 +473,7 @@ chain_plugin::set_program_options(options_description& cli, options_description&
         ("export-reversible-blocks", bpo::value<bfs::path>(), "export reversible block database in portable format into specified file and then exit")
         ("trusted-producer", bpo::value<vector<string>>()->composing(), "Indicate a producer whose blocks headers signed by it will be fully validated, but transactions in those validated blocks will be trusted.")
         ("snapshot", bpo::value<bfs::path>(), "File to read Snapshot State from")
+        ("snapshot-diff", bpo::value<vector<bfs::path>>()->composing(), "Differential snapshots taken after the one of --snapshot, they're applied onto it in the order given")
         ;
 }
 
@@ -339,6 +519,30 @@ clear_directory_contents(const fc::path& p) {
     }
 }
 
+// converts the reversible blocks kept in chainbase by older versions
+void
+upgrade_reversible_blocks(const fc::path& dir) {
+    if(!fc::exists(dir / "shared_memory.bin") || fc::exists(dir / reversible_block_store::filename())) {
+        return;
+    }
+
+    ilog("Converting reversible blocks database in '${dir}' into ${f}", ("dir", dir)("f", reversible_block_store::filename()));
+    auto num = 0u;
+    {
+        chainbase::database old_reversible(dir, database::read_only, 0, true);
+        reversible_block_store new_reversible(dir);
+
+        old_reversible.add_index<reversible_block_index>();
+        for(auto& obj : old_reversible.get_index<reversible_block_index, by_num>()) {
+            new_reversible.add(obj.get_block());
+            ++num;
+        }
+    }
+    fc::remove(dir / "shared_memory.bin");
+    fc::remove(dir / "shared_memory.meta");
+    ilog("Converted ${n} reversible blocks", ("n", num));
+}
+
 void
 chain_plugin::plugin_initialize(const variables_map& options) {
     ilog("initializing chain plugin");
@@ -376,6 +580,27 @@ chain_plugin::plugin_initialize(const variables_map& options) {
             }
         }
 
+        my->chain_config->checkpoints_dir = app().data_dir() / config::default_checkpoints_dir_name;
+        if(options.count("state-checkpoints-dir")) {
+            auto scd = options.at("state-checkpoints-dir").as<bfs::path>();
+            if(scd.is_relative()) {
+                my->chain_config->checkpoints_dir = app().data_dir() / scd;
+            }
+            else {
+                my->chain_config->checkpoints_dir = scd;
+            }
+        }
+        my->chain_config->fork_db_retention   = options.at("fork-db-retention-blocks").as<uint32_t>();
+        my->chain_config->checkpoint_interval = options.at("state-checkpoint-interval").as<uint32_t>();
+        my->chain_config->checkpoints_to_keep = options.at("state-checkpoints-to-keep").as<uint32_t>();
+        my->chain_config->expired_trxs_cleanup = options.at("expired-trxs-cleanup-rows").as<uint32_t>();
+        my->chain_config->trx_index            = options.at("trx-index").as<bool>();
+        my->chain_config->blocks_retained      = options.at("blocks-log-retained").as<uint32_t>();
+        my->chain_config->state_hugepages      = options.at("state-hugepages").as<bool>();
+        my->chain_config->durability           = options.at("durability").as<durability_mode>();
+        my->chain_config->group_commit_blocks  = options.at("group-commit-blocks").as<uint32_t>();
+        my->chain_config->group_commit_ms      = options.at("group-commit-ms").as<uint32_t>();
+
         if(options.count("checkpoint")) {
             auto cps = options.at("checkpoint").as<vector<string>>();
             my->loaded_checkpoints.reserve(cps.size());
@@ -410,10 +635,106 @@ chain_plugin::plugin_initialize(const variables_map& options) {
             my->chain_config->db_config.object_cache_size = sz;
         }
 
+        if(options.count("token-db-cache-shards")) {
+            my->chain_config->db_config.object_cache_shards = options.at("token-db-cache-shards").as<uint32_t>();
+        }
+
+        if(options.count("evt-link-cache-size")) {
+            contracts::evt_link::set_cache_size(options.at("evt-link-cache-size").as<uint32_t>());
+        }
+
+        if(options.count("signature-cache-size")) {
+            transaction::set_recovery_cache_size(options.at("signature-cache-size").as<uint32_t>());
+        }
+
+        if(options.count("token-db-assets-compaction")) {
+            auto style = options.at("token-db-assets-compaction").as<std::string>();
+            if(style == "universal") {
+                my->chain_config->db_config.assets_cf.compaction = compaction_style::universal;
+            }
+            else if(style == "level") {
+                my->chain_config->db_config.assets_cf.compaction = compaction_style::level;
+            }
+            else {
+                EVT_THROW(plugin_config_exception, "Unknown compaction style: ${s}", ("s",style));
+            }
+        }
+        if(options.count("token-db-assets-bloom-bits")) {
+            my->chain_config->db_config.assets_cf.bloom_bits = options.at("token-db-assets-bloom-bits").as<uint32_t>();
+        }
+        if(options.count("token-db-tokens-compaction")) {
+            auto style = options.at("token-db-tokens-compaction").as<std::string>();
+            if(style == "universal") {
+                my->chain_config->db_config.tokens_cf.compaction = compaction_style::universal;
+            }
+            else if(style == "level") {
+                my->chain_config->db_config.tokens_cf.compaction = compaction_style::level;
+            }
+            else {
+                EVT_THROW(plugin_config_exception, "Unknown compaction style: ${s}", ("s",style));
+            }
+        }
+        if(options.count("token-db-cold-dir")) {
+            auto cd = options.at("token-db-cold-dir").as<bfs::path>();
+            my->chain_config->db_config.cold_path = cd.is_relative() ? app().data_dir() / cd : cd;
+        }
+        my->chain_config->db_config.hot_size         = (uint64_t)options.at("token-db-hot-size-mb").as<uint32_t>() * 1024 * 1024;
+        my->chain_config->db_config.cold_domain_secs = options.at("token-db-cold-domain-secs").as<uint32_t>();
+        my->chain_config->db_config.cold_zstd_level  = options.at("token-db-cold-zstd-level").as<uint32_t>();
+        my->chain_config->db_config.prefetch         = options.at("token-db-prefetch").as<bool>();
+        my->chain_config->db_config.io_rate          = (uint64_t)options.at("token-db-io-rate-mb").as<uint32_t>() * 1024 * 1024;
+        my->chain_config->db_config.idle_io_rate     = (uint64_t)options.at("token-db-idle-io-rate-mb").as<uint32_t>() * 1024 * 1024;
+        my->chain_config->db_config.auto_tune        = options.at("token-db-auto-tune").as<bool>();
+        EVT_ASSERT(my->chain_config->db_config.cold_domain_secs == 0 || my->chain_config->db_config.tokens_cf.compaction == compaction_style::level,
+            plugin_config_exception, "token-db-cold-domain-secs requires token-db-tokens-compaction to be \"level\"");
+
+        my->chain_config->db_config.async_persist = options.at("token-db-async-persist").as<bool>();
+        if(options.count("token-db-persist-queue-size")) {
+            my->chain_config->db_config.persist_queue_size = options.at("token-db-persist-queue-size").as<uint32_t>();
+        }
+        my->chain_config->db_config.irreversible_reads = options.at("token-db-irreversible-reads").as<bool>();
+        my->chain_config->db_config.owner_index        = options.at("token-db-owner-index").as<bool>();
+        my->chain_config->db_config.holding_index      = options.at("token-db-holding-index").as<bool>();
+        if(options.count("token-db-hot-keys-sample")) {
+            my->chain_config->db_config.hot_keys_sample = options.at("token-db-hot-keys-sample").as<uint32_t>();
+        }
+
         if(options.count("token-db-profile")) {
             my->chain_config->db_config.profile = options.at("token-db-profile").as<storage_profile>();
         }
 
+        if(options.count("chain-threads")) {
+            my->chain_config->thread_pool_size = options.at("chain-threads").as<uint16_t>();
+            EVT_ASSERT(my->chain_config->thread_pool_size > 0, plugin_config_exception,
+                "chain-threads ${num} must be greater than 0", ("num", my->chain_config->thread_pool_size));
+        }
+
+        auto read_cpus = [&options](const char* name) {
+            auto cpus = utilities::affinity::cpu_list();
+            if(options.count(name)) {
+                try {
+                    cpus = utilities::affinity::parse_cpu_list(options.at(name).as<string>());
+                }
+                EVT_RETHROW_EXCEPTIONS(plugin_config_exception, "Invalid ${name}", ("name", name));
+            }
+            return cpus;
+        };
+        my->chain_config->thread_pool_cpus          = read_cpus("chain-threads-cpus");
+        my->chain_config->db_config.background_cpus = read_cpus("token-db-cpus");
+
+        ilog("CPU topology: ${t}", ("t", utilities::affinity::describe_topology()));
+        if(auto cpus = read_cpus("main-thread-cpus"); !cpus.empty()) {
+            EVT_ASSERT(utilities::affinity::pin_current_thread(cpus), plugin_config_exception,
+                "Cannot pin main thread to cpus ${c}", ("c", utilities::affinity::format_cpu_list(cpus)));
+            ilog("main thread is pinned to cpus ${c}", ("c", utilities::affinity::format_cpu_list(cpus)));
+        }
+        if(!my->chain_config->thread_pool_cpus.empty()) {
+            ilog("chain threads are pinned to cpus ${c}", ("c", utilities::affinity::format_cpu_list(my->chain_config->thread_pool_cpus)));
+        }
+        if(!my->chain_config->db_config.background_cpus.empty()) {
+            ilog("token database threads are pinned to cpus ${c}", ("c", utilities::affinity::format_cpu_list(my->chain_config->db_config.background_cpus)));
+        }
+
         if(options.count("chain-state-db-size-mb")) {
             my->chain_config->state_size = options.at("chain-state-db-size-mb").as<uint64_t>() * 1024 * 1024;
         }
@@ -430,6 +751,14 @@ chain_plugin::plugin_initialize(const variables_map& options) {
             my->chain_config->reversible_guard_size = options.at("reversible-blocks-db-guard-size-mb").as<uint64_t>() * 1024 * 1024;
         }
 
+        if(options.count("memory-budget")) {
+            for(auto& b : options.at("memory-budget").as<vector<string>>()) {
+                auto pos = b.find('=');
+                EVT_ASSERT(pos != string::npos, plugin_config_exception, "Invalid memory-budget: ${b}, should be in form of 'component=MiB'", ("b", b));
+                utilities::memory::accountant::get().set_budget(b.substr(0, pos), std::stoull(b.substr(pos + 1)) * 1024 * 1024);
+            }
+        }
+
         my->chain_config->force_all_checks    = options.at("force-all-checks").as<bool>();
         my->chain_config->disable_replay_opts = options.at("disable-replay-opts").as<bool>();
         my->chain_config->loadtest_mode       = options.at("loadtest-mode").as<bool>();
@@ -465,6 +794,8 @@ chain_plugin::plugin_initialize(const variables_map& options) {
             EVT_THROW(extract_genesis_state_exception, "extracted genesis state from blocks.log");
         }
 
+        upgrade_reversible_blocks(my->chain_config->blocks_dir / config::reversible_blocks_dir_name);
+
         if(options.count("export-reversible-blocks")) {
             auto p = options.at("export-reversible-blocks").as<bfs::path>();
 
@@ -487,6 +818,7 @@ chain_plugin::plugin_initialize(const variables_map& options) {
             clear_directory_contents(my->chain_config->state_dir);
             fc::remove_all(my->tokendb_dir);
             fc::remove_all(my->blocks_dir);
+            fc::remove_all(my->chain_config->checkpoints_dir);
         }
         else if(options.at("hard-replay-blockchain").as<bool>()) {
             ilog("Hard replay requested: deleting state database");
@@ -495,36 +827,32 @@ chain_plugin::plugin_initialize(const variables_map& options) {
             auto backup_dir = block_log::repair_log(my->blocks_dir, options.at("truncate-at-block").as<uint32_t>());
             if(fc::exists(backup_dir / config::reversible_blocks_dir_name) || options.at("fix-reversible-blocks").as<bool>()) {
                 // Do not try to recover reversible blocks if the directory does not exist, unless the option was explicitly provided.
+                upgrade_reversible_blocks(backup_dir / config::reversible_blocks_dir_name);
                 if(!recover_reversible_blocks(backup_dir / config::reversible_blocks_dir_name,
-                                              my->chain_config->reversible_cache_size,
                                               my->chain_config->blocks_dir / config::reversible_blocks_dir_name,
                                               options.at("truncate-at-block").as<uint32_t>())) {
                     ilog("Reversible blocks database was not corrupted. Copying from backup to blocks directory.");
                     fc::copy(backup_dir / config::reversible_blocks_dir_name,
                              my->chain_config->blocks_dir / config::reversible_blocks_dir_name);
-                    fc::copy(backup_dir / config::reversible_blocks_dir_name / "shared_memory.bin",
-                             my->chain_config->blocks_dir / config::reversible_blocks_dir_name / "shared_memory.bin");
-                    fc::copy(backup_dir / config::reversible_blocks_dir_name / "shared_memory.meta",
-                             my->chain_config->blocks_dir / config::reversible_blocks_dir_name / "shared_memory.meta");
+                    fc::copy(backup_dir / config::reversible_blocks_dir_name / reversible_block_store::filename(),
+                             my->chain_config->blocks_dir / config::reversible_blocks_dir_name / reversible_block_store::filename());
                 }
             }
         }
-        else if(options.at("replay-blockchain").as<bool>()) {
+        else if(options.at("replay-blockchain").as<bool>() || options.count("replay-profile")) {
             ilog("Replay requested: deleting state database");
             if(options.at("truncate-at-block").as<uint32_t>() > 0)
                 wlog("The --truncate-at-block option does not work for a regular replay of the blockchain.");
             clear_directory_contents(my->chain_config->state_dir);
             fc::remove_all(my->tokendb_dir);
             if(options.at("fix-reversible-blocks").as<bool>()) {
-                if(!recover_reversible_blocks(my->chain_config->blocks_dir / config::reversible_blocks_dir_name,
-                                              my->chain_config->reversible_cache_size)) {
+                if(!recover_reversible_blocks(my->chain_config->blocks_dir / config::reversible_blocks_dir_name)) {
                     ilog("Reversible blocks database was not corrupted.");
                 }
             }
         }
         else if(options.at("fix-reversible-blocks").as<bool>()) {
             if(!recover_reversible_blocks(my->chain_config->blocks_dir / config::reversible_blocks_dir_name,
-                                          my->chain_config->reversible_cache_size,
                                           optional<fc::path>(),
                                           options.at("truncate-at-block").as<uint32_t>())) {
                 ilog("Reversible blocks database verified to not be corrupted. Now exiting...");
@@ -542,8 +870,7 @@ chain_plugin::plugin_initialize(const variables_map& options) {
             ilog("Importing reversible blocks from '${file}'", ("file", reversible_blocks_file.generic_string()));
             clear_directory_contents(my->chain_config->blocks_dir / config::reversible_blocks_dir_name);
 
-            import_reversible_blocks(my->chain_config->blocks_dir / config::reversible_blocks_dir_name,
-                                     my->chain_config->reversible_cache_size, reversible_blocks_file);
+            import_reversible_blocks(my->chain_config->blocks_dir / config::reversible_blocks_dir_name, reversible_blocks_file);
 
             EVT_THROW(node_management_success, "imported reversible blocks");
         }
@@ -552,6 +879,27 @@ chain_plugin::plugin_initialize(const variables_map& options) {
             wlog("The --import-reversible-blocks option should be used by itself.");
         }
 
+        if(my->chain_config->db_config.profile == storage_profile::ram) {
+            // a token database on disk means the node ran with another profile, the state built with it
+            // is never thrown away by a profile switch, it has to be deleted on purpose
+            for(auto& dir : { my->tokendb_dir, bfs::path(my->chain_config->state_dir / config::default_token_database_dir_name) }) {
+                EVT_ASSERT(!bfs::exists(dir / "CURRENT"), plugin_config_exception,
+                           "Token database on disk found in ${dir}, refusing to discard its state for the ram profile. "
+                           "Remove it or start with --delete-all-blocks or --hard-replay-blockchain to rebuild the state in RAM",
+                           ("dir", dir.generic_string()));
+            }
+
+            // token database doesn't survive restart, state database needs to be rebuilt together
+            auto state_dir = bfs::path(my->chain_config->state_dir);
+            if(bfs::is_directory(state_dir) && !bfs::is_empty(state_dir)) {
+                wlog("Token database is kept in RAM, it doesn't survive restarts: deleting state database in ${dir}, "
+                     "the state is rebuilt from the snapshot or by replaying the block log", ("dir", state_dir.generic_string()));
+            }
+            clear_directory_contents(my->chain_config->state_dir);
+        }
+
+        EVT_ASSERT(options.count("snapshot") || !options.count("snapshot-diff"), plugin_config_exception,
+                   "--snapshot-diff requires --snapshot as the base of the differential snapshots");
         if(options.count("snapshot")) {
             my->snapshot_path = options.at("snapshot").as<bfs::path>();
             EVT_ASSERT(fc::exists(*my->snapshot_path), plugin_config_exception,
@@ -570,6 +918,14 @@ chain_plugin::plugin_initialize(const variables_map& options) {
                        plugin_config_exception,
                        "--snapshot is incompatible with --genesis-json and --genesis-timestamp as the snapshot contains genesis information");
 
+            if(options.count("snapshot-diff")) {
+                my->snapshot_diff_paths = options.at("snapshot-diff").as<vector<bfs::path>>();
+                for(auto& p : my->snapshot_diff_paths) {
+                    EVT_ASSERT(fc::exists(p), plugin_config_exception,
+                               "Cannot load differential snapshot, ${name} does not exist", ("name", p.generic_string()));
+                }
+            }
+
             auto shared_mem_path = my->chain_config->state_dir / "shared_memory.bin";
             EVT_ASSERT(!fc::exists(shared_mem_path),
                        plugin_config_exception,
@@ -611,6 +967,20 @@ chain_plugin::plugin_initialize(const variables_map& options) {
                 my->chain_config->genesis = fc::json::from_file(genesis_file).as<genesis_state>();
             }
 
+            if(options.count("genesis-initial-state")) {
+                auto initial_state_file = options.at("genesis-initial-state").as<bfs::path>();
+                if(initial_state_file.is_relative()) {
+                    initial_state_file = bfs::current_path() / initial_state_file;
+                }
+
+                EVT_ASSERT(fc::is_regular_file(initial_state_file),
+                           plugin_config_exception,
+                           "Specified genesis initial state file '${file}' does not exist.",
+                           ("file", initial_state_file.generic_string()));
+
+                my->chain_config->genesis_initial_state = initial_state_file;
+            }
+
             if(options.count("genesis-timestamp")) {
                 my->chain_config->genesis.initial_timestamp = calculate_genesis_timestamp(
                     options.at("genesis-timestamp").as<string>());
@@ -653,6 +1023,11 @@ chain_plugin::plugin_initialize(const variables_map& options) {
             my->chain_config->block_validation_mode = options.at("validation-mode").as<validation_mode>();
         }
 
+        if(options.count("replay-profile")) {
+            my->chain_config->replay_stop_block = options.at("replay-profile-last-block").as<uint32_t>();
+        }
+        my->empty_state = !my->snapshot_path && !fc::exists(my->chain_config->state_dir / "shared_memory.bin");
+
         my->chain.emplace(*my->chain_config);
         my->chain_id.emplace(my->chain->get_chain_id());
 
@@ -676,6 +1051,8 @@ chain_plugin::plugin_initialize(const variables_map& options) {
                 return my->chain->last_irreversible_block_num();
             });
 
+        my->trace_bus.emplace(options.at("block-trace-bus-size").as<uint32_t>());
+
         // relay signals to channels
         my->pre_accepted_block_connection = my->chain->pre_accepted_block.connect([this](const signed_block_ptr& blk) {
             auto itr = my->loaded_checkpoints.find(blk->block_num());
@@ -695,10 +1072,13 @@ chain_plugin::plugin_initialize(const variables_map& options) {
             });
 
         my->accepted_block_connection = my->chain->accepted_block.connect([this](const block_state_ptr& blk) {
+            my->trace_bus->push(block_trace_event{ block_trace_event::accepted_block, blk, nullptr });
             my->accepted_block_channel.publish(priority::high, blk);
+            utilities::memory::accountant::get().enforce();
         });
 
         my->irreversible_block_connection = my->chain->irreversible_block.connect([this](const block_state_ptr& blk) {
+            my->trace_bus->push(block_trace_event{ block_trace_event::irreversible_block, blk, nullptr });
             my->irreversible_block_channel.publish(priority::low, blk);
         });
 
@@ -709,9 +1089,33 @@ chain_plugin::plugin_initialize(const variables_map& options) {
 
         my->applied_transaction_connection = my->chain->applied_transaction.connect(
             [this](const transaction_trace_ptr& trace) {
+                my->trace_bus->push(block_trace_event{ block_trace_event::applied_transaction, nullptr, trace });
                 my->applied_transaction_channel.publish(priority::low, trace);
             });
 
+        if(options.at("token-db-changes").as<bool>()) {
+            my->applied_token_changes_connection = my->chain->applied_token_changes.connect(
+                [this](const token_changes_ptr& changes) {
+                    my->trace_bus->push(block_trace_event{ block_trace_event::applied_token_changes, nullptr, nullptr, changes });
+                });
+            my->reverted_token_changes_connection = my->chain->reverted_token_changes.connect(
+                [this](uint32_t block_num) {
+                    auto e      = block_trace_event{ block_trace_event::reverted_token_changes };
+                    e.block_num = block_num;
+                    my->trace_bus->push(std::move(e));
+                });
+        }
+
+        // connected after the relays, its timing of blocks starts after theirs and ends before theirs
+        if(options.count("replay-profile")) {
+            my->profile_path = options.at("replay-profile").as<bfs::path>();
+            if(my->profile_path->is_relative()) {
+                my->profile_path = bfs::current_path() / *my->profile_path;
+            }
+            my->profiler.emplace(*my->chain, options.at("replay-profile-first-block").as<uint32_t>(),
+                my->chain_config->replay_stop_block, options.at("replay-profile-top").as<uint32_t>());
+        }
+
         my->chain->add_indices();
     }
     FC_LOG_AND_RETHROW()
@@ -724,7 +1128,14 @@ chain_plugin::plugin_startup() {
             if(my->snapshot_path) {
                 auto infile = std::ifstream(my->snapshot_path->generic_string(), (std::ios::in | std::ios::binary));
                 auto reader = std::make_shared<istream_snapshot_reader>(infile);
-                my->chain->startup(reader);
+
+                auto diff_files = std::deque<std::ifstream>();
+                auto diffs      = std::vector<snapshot_reader_ptr>();
+                for(auto& p : my->snapshot_diff_paths) {
+                    auto& f = diff_files.emplace_back(p.generic_string(), (std::ios::in | std::ios::binary));
+                    diffs.emplace_back(std::make_shared<istream_snapshot_reader>(f));
+                }
+                my->chain->startup(reader, diffs);
                 infile.close();
             }
             else {
@@ -737,6 +1148,18 @@ chain_plugin::plugin_startup() {
             my->chain.reset();
             throw;
         }
+        catch(const node_management_success& e) {
+            // replay is stopped at the last block of profile
+            if(!my->profiler.has_value()) {
+                throw;
+            }
+        }
+
+        if(my->profiler.has_value()) {
+            my->profiler->write_report(*my->profile_path);
+            ilog("Saved replay profile to '${p}'", ("p", my->profile_path->generic_string()));
+            EVT_THROW(node_management_success, "profiled replay");
+        }
 
         if(!my->readonly) {
             ilog("starting chain in read/write mode");
@@ -746,19 +1169,51 @@ chain_plugin::plugin_startup() {
         ilog("Blockchain started; head block is #${num}, genesis timestamp is ${ts}",
              ("num", my->chain->head_block_num())("ts", (std::string)my->chain_config->genesis.initial_timestamp));
 
+        my->add_memory_components(my->chain_config->db_config);
         my->chain_config.reset();
+
+        my->metrics_collector = utilities::metrics::registry::get().add_collector([this](auto& w) {
+            auto& chain = *my->chain;
+            auto  sm    = chain.db().get_segment_manager();
+            w.gauge("evt_chain_state_size_bytes", "Size of the chain state file", sm->get_size());
+            w.gauge("evt_chain_state_free_bytes", "Free memory in the chain state file", sm->get_free_memory());
+            w.gauge("evt_chain_fork_db_blocks", "Block states kept in the fork database", chain.fork_db().size());
+            w.gauge("evt_chain_head_block_num", "Number of the head block", chain.head_block_num());
+            w.gauge("evt_chain_last_irreversible_block_num", "Number of the last irreversible block", chain.last_irreversible_block_num());
+
+            auto inflight = my->inflight_trxs.stats();
+            w.gauge("evt_chain_inflight_transactions", "Incoming transactions not answered yet", inflight.size);
+
+            // tickers are empty when the statistics of token database are disabled
+            for(auto& it : chain.token_db().tickers()) {
+                w.counter("evt_tokendb_rocksdb_ticker_total", "Tickers of the rocksdb statistics of token database", it.second, {{"ticker", it.first}});
+            }
+
+            for(auto& u : utilities::memory::accountant::get().get_usage()) {
+                w.gauge("evt_memory_usage_bytes", "Memory held by the component", u.bytes, {{"component", u.name}});
+                w.gauge("evt_memory_budget_bytes", "Soft memory budget of the component, 0 for no budget", u.budget, {{"component", u.name}});
+            }
+        });
     }
     FC_CAPTURE_AND_RETHROW()
 }
 
 void
 chain_plugin::plugin_shutdown() {
+    if(my->metrics_collector.has_value()) {
+        utilities::metrics::registry::get().remove_collector(*my->metrics_collector);
+    }
+    for(auto id : my->memory_components) {
+        utilities::memory::accountant::get().remove_component(id);
+    }
     my->pre_accepted_block_connection.reset();
     my->accepted_block_header_connection.reset();
     my->accepted_block_connection.reset();
     my->irreversible_block_connection.reset();
     my->accepted_transaction_connection.reset();
     my->applied_transaction_connection.reset();
+    my->applied_token_changes_connection.reset();
+    my->reverted_token_changes_connection.reset();
     my->chain.reset();
 }
 
@@ -779,7 +1234,7 @@ chain_plugin::accept_block(const signed_block_ptr& block) {
 
 void
 chain_plugin::accept_transaction(const chain::packed_transaction& trx, next_function<chain::transaction_trace_ptr> next) {
-    my->incoming_transaction_async_method(std::make_shared<transaction_metadata>(std::make_shared<packed_transaction>(trx)), false, std::forward<decltype(next)>(next));
+    my->incoming_transaction_async_method(make_transaction_metadata(trx), false, std::forward<decltype(next)>(next));
 }
 
 void
@@ -794,28 +1249,19 @@ chain_plugin::block_is_on_preferred_chain(const block_id_type& block_id) {
 }
 
 bool
-chain_plugin::recover_reversible_blocks(const fc::path& db_dir, uint32_t cache_size,
-                                        optional<fc::path> new_db_dir, uint32_t truncate_at_block) {
-    try {
-        chainbase::database reversible(db_dir, database::read_only);  // Test if dirty
-        // If it reaches here, then the reversible database is not dirty
-
-        if(truncate_at_block == 0)
-            return false;
-
-        reversible.add_index<reversible_block_index>();
-        const auto& ubi = reversible.get_index<reversible_block_index, by_num>();
-
-        auto itr = ubi.rbegin();
-        if(itr != ubi.rend() && itr->blocknum <= truncate_at_block)
-            return false;  // Because we are not going to be truncating the reversible database at all.
-    }
-    catch(const std::runtime_error&) {
-    }
-    catch(...) {
-        throw;
+chain_plugin::recover_reversible_blocks(const fc::path& db_dir, optional<fc::path> new_db_dir, uint32_t truncate_at_block) {
+    {
+        reversible_block_store reversible(db_dir);  // Drops an incomplete block at the end if it's dirty
+        if(reversible.recovered_bytes() == 0) {
+            if(truncate_at_block == 0)
+                return false;
+
+            auto last = reversible.last_num();
+            if(!last || *last <= truncate_at_block)
+                return false;  // Because we are not going to be truncating the reversible database at all.
+        }
     }
-    // Reversible block database is dirty. So back it up (unless already moved) and then create a new one.
+    // Reversible block database was dirty or is truncated. So back it up (unless already moved) and then create a new one.
 
     auto reversible_dir = fc::canonical(db_dir);
     if(reversible_dir.filename().generic_string() == ".") {
@@ -847,21 +1293,17 @@ chain_plugin::recover_reversible_blocks(const fc::path& db_dir, uint32_t cache_s
 
     ilog("Reconstructing '${reversible_dir}' from backed up reversible directory", ("reversible_dir", reversible_dir));
 
-    chainbase::database old_reversible(backup_dir, database::read_only, 0, true);
-    chainbase::database new_reversible(reversible_dir, database::read_write, cache_size);
-    std::fstream        reversible_blocks;
+    reversible_block_store old_reversible(backup_dir);
+    reversible_block_store new_reversible(reversible_dir);
+    std::fstream           reversible_blocks;
     reversible_blocks.open((reversible_dir.parent_path() / std::string("portable-reversible-blocks-").append(now)).generic_string().c_str(),
                            std::ios::out | std::ios::binary);
 
     uint32_t num   = 0;
     uint32_t start = 0;
     uint32_t end   = 0;
-    old_reversible.add_index<reversible_block_index>();
-    new_reversible.add_index<reversible_block_index>();
-    const auto& ubi = old_reversible.get_index<reversible_block_index, by_num>();
-    auto        itr = ubi.begin();
-    if(itr != ubi.end()) {
-        start = itr->blocknum;
+    if(auto first = old_reversible.first_num()) {
+        start = *first;
         end   = start - 1;
     }
     if(truncate_at_block > 0 && start > truncate_at_block) {
@@ -870,16 +1312,11 @@ chain_plugin::recover_reversible_blocks(const fc::path& db_dir, uint32_t cache_s
         return true;
     }
     try {
-        for(; itr != ubi.end(); ++itr) {
-            EVT_ASSERT(itr->blocknum == end + 1, gap_in_reversible_blocks_db,
-                       "gap in reversible block database between ${end} and ${blocknum}",
-                       ("end", end)("blocknum", itr->blocknum));
-            reversible_blocks.write(itr->packedblock.data(), itr->packedblock.size());
-            new_reversible.create<reversible_block_object>([&](auto& ubo) {
-                ubo.blocknum = itr->blocknum;
-                ubo.set_block(itr->get_block());  // get_block and set_block rather than copying the packed data acts as additional validation
-            });
-            end = itr->blocknum;
+        while(auto b = old_reversible.get(end + 1)) {  // get unpacks the block and acts as additional validation
+            auto packed = fc::raw::pack(*b);
+            reversible_blocks.write(packed.data(), packed.size());
+            new_reversible.add(b);
+            end = b->block_num();
             ++num;
             if(end == truncate_at_block)
                 break;
@@ -907,10 +1344,9 @@ chain_plugin::recover_reversible_blocks(const fc::path& db_dir, uint32_t cache_s
 
 bool
 chain_plugin::import_reversible_blocks(const fc::path& reversible_dir,
-                                       uint32_t        cache_size,
                                        const fc::path& reversible_blocks_file) {
-    std::fstream        reversible_blocks;
-    chainbase::database new_reversible(reversible_dir, database::read_write, cache_size);
+    std::fstream           reversible_blocks;
+    reversible_block_store new_reversible(reversible_dir);
     reversible_blocks.open(reversible_blocks_file.generic_string().c_str(), std::ios::in | std::ios::binary);
 
     reversible_blocks.seekg(0, std::ios::end);
@@ -920,7 +1356,6 @@ chain_plugin::import_reversible_blocks(const fc::path& reversible_dir,
     uint32_t num   = 0;
     uint32_t start = 0;
     uint32_t end   = 0;
-    new_reversible.add_index<reversible_block_index>();
     try {
         while(reversible_blocks.tellg() < end_pos) {
             signed_block tmp;
@@ -936,10 +1371,7 @@ chain_plugin::import_reversible_blocks(const fc::path& reversible_dir,
                            ("end", end)("num", num));
             }
 
-            new_reversible.create<reversible_block_object>([&](auto& ubo) {
-                ubo.blocknum = num;
-                ubo.set_block(std::make_shared<signed_block>(std::move(tmp)));
-            });
+            new_reversible.add(make_signed_block(std::move(tmp)));
             end = num;
         }
     }
@@ -961,30 +1393,22 @@ chain_plugin::import_reversible_blocks(const fc::path& reversible_dir,
 bool
 chain_plugin::export_reversible_blocks(const fc::path& reversible_dir,
                                        const fc::path& reversible_blocks_file) {
-    chainbase::database reversible(reversible_dir, database::read_only, 0, true);
-    std::fstream        reversible_blocks;
+    reversible_block_store reversible(reversible_dir);
+    std::fstream           reversible_blocks;
     reversible_blocks.open(reversible_blocks_file.generic_string().c_str(), std::ios::out | std::ios::binary);
 
     uint32_t num   = 0;
     uint32_t start = 0;
     uint32_t end   = 0;
-    reversible.add_index<reversible_block_index>();
-    const auto& ubi = reversible.get_index<reversible_block_index, by_num>();
-    auto        itr = ubi.begin();
-    if(itr != ubi.end()) {
-        start = itr->blocknum;
+    if(auto first = reversible.first_num()) {
+        start = *first;
         end   = start - 1;
     }
     try {
-        for(; itr != ubi.end(); ++itr) {
-            EVT_ASSERT(itr->blocknum == end + 1, gap_in_reversible_blocks_db,
-                       "gap in reversible block database between ${end} and ${blocknum}",
-                       ("end", end)("blocknum", itr->blocknum));
-            signed_block                tmp;
-            fc::datastream<const char*> ds(itr->packedblock.data(), itr->packedblock.size());
-            fc::raw::unpack(ds, tmp);  // Verify that packed block has not been corrupted.
-            reversible_blocks.write(itr->packedblock.data(), itr->packedblock.size());
-            end = itr->blocknum;
+        while(auto b = reversible.get(end + 1)) {  // Verify that packed block has not been corrupted.
+            auto packed = fc::raw::pack(*b);
+            reversible_blocks.write(packed.data(), packed.size());
+            end = b->block_num();
             ++num;
         }
     }
@@ -1017,6 +1441,57 @@ chain_plugin::chain() const {
     return *my->chain;
 }
 
+bool
+chain_plugin::can_load_snapshot() const {
+    return my->empty_state;
+}
+
+void
+chain_plugin::set_snapshot(const fc::path& path) {
+    EVT_ASSERT(my->empty_state, plugin_config_exception, "Snapshot can only be used to initialize an empty database.");
+
+    auto infile = std::ifstream(path.generic_string(), (std::ios::in | std::ios::binary));
+    auto reader = std::make_shared<istream_snapshot_reader>(infile);
+    reader->validate();
+
+    auto genesis = genesis_state();
+    reader->read_section<genesis_state>([&](auto& section) {
+        section.read_row(genesis);
+    });
+    EVT_ASSERT(genesis.compute_chain_id() == *my->chain_id, plugin_config_exception,
+               "Chain id of snapshot ${name} doesn't match the one of this node", ("name", path.generic_string()));
+
+    my->snapshot_path = bfs::path(path.generic_string());
+    my->empty_state   = false;
+}
+
+optional<block_header_state>
+chain_plugin::block_log_head_state() const {
+    auto snapshot_head = optional<block_header_state>();
+    if(my->snapshot_path) {
+        // the chain starts from the head of the last differential snapshot
+        auto path   = my->snapshot_diff_paths.empty() ? *my->snapshot_path : my->snapshot_diff_paths.back();
+        auto infile = std::ifstream(path.generic_string(), (std::ios::in | std::ios::binary));
+        auto reader = istream_snapshot_reader(infile);
+        auto head   = block_header_state();
+        reader.read_section<block_state>([&head](auto& section) {
+            section.read_row(head);
+        });
+        snapshot_head = head;
+    }
+    return my->chain->block_log_head_state(snapshot_head);
+}
+
+inflight_transactions&
+chain_plugin::get_inflight_transactions() {
+    return my->inflight_trxs;
+}
+
+block_trace_bus&
+chain_plugin::get_block_trace_bus() {
+    return *my->trace_bus;
+}
+
 chain::chain_id_type
 chain_plugin::get_chain_id() const {
     EVT_ASSERT(my->chain_id.has_value(), chain_id_type_exception, "Chain ID has not been initialized yet");
@@ -1030,8 +1505,8 @@ chain_plugin::log_guard_exception(const chain::guard_exception& e) const {
              "Please increase the value set for \"chain-state-db-size-mb\" and restart the process!");
     }
     else if(e.code() == chain::reversible_guard_exception::code_value) {
-        elog("Reversible block database has reached an unsafe level of usage, shutting down to avoid corrupting the database.  "
-             "Please increase the value set for \"reversible-blocks-db-size-mb\" and restart the process!");
+        elog("Disk space for the reversible blocks has reached an unsafe level, shutting down to avoid corrupting the database.  "
+             "Please free some disk space and restart the process!");
     }
 
     dlog("Details: ${details}", ("details", e.to_detail_string()));
@@ -1047,7 +1522,7 @@ chain_plugin::handle_guard_exception(const chain::guard_exception& e) const {
 
 void
 chain_plugin::handle_db_exhaustion() {
-   elog("database memory exhausted: increase chain-state-db-size-mb and/or reversible-blocks-db-size-mb");
+   elog("database memory exhausted: increase chain-state-db-size-mb");
    //return 1 -- it's what programs/nodeos/main.cpp considers "BAD_ALLOC"
    std::_Exit(1);
 }
@@ -1159,8 +1634,14 @@ read_only::get_head_block_header_state(const get_head_block_header_state_params&
 fc::variant
 read_only::get_transaction(const get_transaction_params& params) {
     auto block_num = 0;
+    auto trx_pos   = optional<uint32_t>();
     if(!params.block_num.has_value()) {
         block_num = db.get_block_num_for_trx_id(params.id);
+        if(auto idx = db.get_trx_index()) {
+            if(auto loc = idx->find(params.id); loc.has_value() && loc->block_num == (uint32_t)block_num) {
+                trx_pos = loc->trx_pos;
+            }
+        }
     }
     else {
         block_num = *params.block_num;
@@ -1168,21 +1649,30 @@ read_only::get_transaction(const get_transaction_params& params) {
     auto block = db.fetch_block_by_number(block_num);
     EVT_ASSERT(block, unknown_block_exception, "Could not find head block");
 
-    for(auto& tx : block->transactions) {
-        if(tx.trx.id() == params.id) {
-            auto var = fc::variant();
-            if(params.raw.has_value() && *params.raw) {
-                fc::to_variant(tx.trx, var);
-            }
-            else {
-                db.get_abi_serializer().to_variant(tx.trx, var, db.get_execution_context());
-            }
+    auto result = [&](auto& tx) {
+        auto var = fc::variant();
+        if(params.raw.has_value() && *params.raw) {
+            fc::to_variant(tx.trx, var);
+        }
+        else {
+            db.get_abi_serializer().to_variant(tx.trx, var, db.get_execution_context());
+        }
 
-            auto mv = fc::mutable_variant_object(var);
-            mv["block_num"] = block_num;
-            mv["block_id"]  = block->id();
+        auto mv = fc::mutable_variant_object(var);
+        mv["block_num"] = block_num;
+        mv["block_id"]  = block->id();
+        return fc::variant(mv);
+    };
 
-            return mv;
+    // position in the index saves scanning the block, ids are only prefixes there so it's checked still
+    if(trx_pos.has_value() && *trx_pos < block->transactions.size()) {
+        if(auto& tx = block->transactions[*trx_pos]; tx.trx.id() == params.id) {
+            return result(tx);
+        }
+    }
+    for(auto& tx : block->transactions) {
+        if(tx.trx.id() == params.id) {
+            return result(tx);
         }
     }
     EVT_THROW(unknown_transaction_exception, "Cannot find transaction");
@@ -1208,7 +1698,7 @@ read_only::get_trx_id_for_link_id(const get_trx_id_for_link_id_params& params) c
 void
 read_write::push_block(read_write::push_block_params&& params, next_function<read_write::push_block_results> next) {
     try {
-        app().get_method<incoming::methods::block_sync>()(std::make_shared<signed_block>(std::move(params)));
+        app().get_method<incoming::methods::block_sync>()(make_signed_block(std::move(params)));
         next(read_write::push_block_results{});
     }
     catch(boost::interprocess::bad_alloc&) {
@@ -1296,6 +1786,96 @@ read_write::push_transactions(const read_write::push_transactions_params& params
     CATCH_AND_CALL(next);
 }
 
+read_write::push_packed_transactions_params
+read_write::parse_packed_transactions(const string& body) {
+    auto params = push_packed_transactions_params();
+    if(!body.empty() && body[0] == '[') {
+        // packed form needs no abi, the actions are kept in binary
+        auto ptrxs = fc::json::from_string(body).as<vector<packed_transaction>>();
+        params.reserve(ptrxs.size());
+        for(auto& ptrx : ptrxs) {
+            params.emplace_back(std::make_shared<packed_transaction>(std::move(ptrx)));
+        }
+        return params;
+    }
+
+    auto pos = size_t(0);
+    while(pos < body.size()) {
+        auto sz = uint32_t();
+        EVT_ASSERT(pos + sizeof(sz) <= body.size(), chain::packed_transaction_type_exception, "Truncated size of packed transaction at offset ${p}", ("p", pos));
+        memcpy(&sz, body.data() + pos, sizeof(sz));
+        pos += sizeof(sz);
+        EVT_ASSERT(pos + sz <= body.size(), chain::packed_transaction_type_exception, "Truncated packed transaction at offset ${p}", ("p", pos));
+
+        auto ds   = fc::datastream<const char*>(body.data() + pos, sz);
+        auto ptrx = std::make_shared<packed_transaction>();
+        fc::raw::unpack(ds, *ptrx);
+        params.emplace_back(std::move(ptrx));
+        pos += sz;
+    }
+    return params;
+}
+
+void
+read_write::push_packed_transactions(push_packed_transactions_params&& params, next_function<push_packed_transactions_results> next) {
+    try {
+        FC_ASSERT(params.size() <= 1000, "Attempt to push too many transactions at once");
+
+        struct push_state {
+            push_packed_transactions_results results;
+            size_t                           pending;
+        };
+        auto state     = std::make_shared<push_state>();
+        state->results.resize(params.size());
+        state->pending = params.size();
+        if(params.empty()) {
+            next(state->results);
+            return;
+        }
+
+        // completions all come back on the main thread
+        auto complete = [state, next](size_t i, push_transaction_results&& r) {
+            state->results[i] = std::move(r);
+            if(--state->pending == 0) {
+                next(state->results);
+            }
+        };
+        auto error_result = [](const transaction_id_type& id, const fc::exception& e) {
+            return push_transaction_results{id, fc::mutable_variant_object("error", e.to_detail_string())};
+        };
+
+        auto& exec_ctx = db.get_execution_context();
+        for(auto i = 0u; i < params.size(); i++) {
+            try {
+                auto trx_meta = std::make_shared<transaction_metadata>(params[i]);
+                app().get_method<incoming::methods::transaction_async>()(trx_meta, true, [this, i, complete, error_result, &exec_ctx](const fc::static_variant<fc::exception_ptr, transaction_trace_ptr>& result) -> void {
+                    if(result.contains<fc::exception_ptr>()) {
+                        complete(i, error_result(transaction_id_type(), *result.get<fc::exception_ptr>()));
+                        return;
+                    }
+
+                    auto trx_trace_ptr = result.get<transaction_trace_ptr>();
+                    try {
+                        auto pretty_output = fc::variant();
+                        db.get_abi_serializer().to_variant(*trx_trace_ptr, pretty_output, exec_ctx);
+                        complete(i, push_transaction_results{trx_trace_ptr->id, pretty_output});
+                    }
+                    catch(const fc::exception& e) {
+                        complete(i, error_result(trx_trace_ptr->id, e));
+                    }
+                });
+            }
+            catch(const fc::exception& e) {
+                complete(i, error_result(transaction_id_type(), e));
+            }
+        }
+    }
+    catch(boost::interprocess::bad_alloc&) {
+        chain_plugin::handle_db_exhaustion();
+    }
+    CATCH_AND_CALL(next);
+}
+
 static variant
 action_abi_to_variant(const abi_serializer& abi, contracts::type_name action_type) {
     auto v = fc::variant();
@@ -1466,5 +2046,26 @@ read_only::get_db_info(const get_db_info_params&) const {
     return db.token_db().stats();
 }
 
+read_only::get_action_costs_results
+read_only::get_action_costs(const get_action_costs_params&) const {
+    return db.get_action_costs();
+}
+
+read_only::get_memory_usage_results
+read_only::get_memory_usage(const get_memory_usage_params&) const {
+    return utilities::memory::accountant::get().get_usage();
+}
+
+read_only::get_hot_keys_results
+read_only::get_hot_keys(const get_hot_keys_params& params) const {
+    return db.token_db().get_hot_keys(params.top);
+}
+
+read_write::set_memory_budget_results
+read_write::set_memory_budget(const set_memory_budget_params& params) {
+    utilities::memory::accountant::get().set_budget(params.component, params.budget_mb * 1024 * 1024);
+    return set_memory_budget_results();
+}
+
 }  // namespace chain_apis
 }  // namespace evt
@@ -0,0 +1,40 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+
+#include <evt/chain/block_state.hpp>
+#include <evt/chain/controller.hpp>
+#include <evt/chain/trace.hpp>
+#include <evt/utilities/fanout_queue.hpp>
+
+namespace evt {
+
+/**
+ * One signal of the controller, as relayed to the plugins writing blocks out of the main thread
+ *
+ * The block state, the trace and the token changes are shared with the controller and between
+ * all the consumers, an event itself is only these pointers.
+ *
+ * Token changes are only relayed with `token-db-changes` on. Changes of a block come after its
+ * transactions' and before the block is accepted, all of them are reverted by one
+ * `reverted_token_changes` when the block is popped or aborted.
+ */
+struct block_trace_event {
+    enum kind_type { accepted_block = 0, irreversible_block, applied_transaction, applied_token_changes, reverted_token_changes };
+
+    kind_type                    kind = accepted_block;
+    chain::block_state_ptr       block;      // of both block kinds
+    chain::transaction_trace_ptr trace;      // of applied transactions
+    chain::token_changes_ptr     changes;    // of applied token changes
+    uint32_t                     block_num = 0;  // of reverted token changes
+};
+
+/**
+ * Events of the controller in the order it emitted them, every subscribed plugin reads all of
+ * them at its own pace. Nothing is queued while no plugin is subscribed.
+ */
+using block_trace_bus = utilities::fanout_queue<block_trace_event>;
+
+}  // namespace evt
@@ -4,6 +4,7 @@
  */
 #pragma once
 #include <appbase/application.hpp>
+#include <evt/chain/action_costs.hpp>
 #include <evt/chain/asset.hpp>
 #include <evt/chain/block.hpp>
 #include <evt/chain/version.hpp>
@@ -11,6 +12,9 @@
 #include <evt/chain/transaction.hpp>
 #include <evt/chain/plugin_interface.hpp>
 #include <evt/chain/contracts/abi_serializer.hpp>
+#include <evt/chain_plugin/block_trace_bus.hpp>
+#include <evt/chain_plugin/inflight_transactions.hpp>
+#include <evt/utilities/memory_budget.hpp>
 
 #include <fc/static_variant.hpp>
 
@@ -170,6 +174,20 @@ public:
 
     using get_db_info_params = empty;
     std::string get_db_info(const get_db_info_params&) const;
+
+    using get_action_costs_params  = empty;
+    using get_action_costs_results = std::vector<chain::action_cost>;
+    get_action_costs_results get_action_costs(const get_action_costs_params&) const;
+
+    using get_memory_usage_params  = empty;
+    using get_memory_usage_results = std::vector<utilities::memory::component_usage>;
+    get_memory_usage_results get_memory_usage(const get_memory_usage_params&) const;
+
+    struct get_hot_keys_params {
+        uint32_t top = 20;
+    };
+    using get_hot_keys_results = chain::token_database::hot_keys;
+    get_hot_keys_results get_hot_keys(const get_hot_keys_params& params) const;
 };
 
 class read_write {
@@ -195,6 +213,24 @@ public:
     using push_transactions_results = vector<push_transaction_results>;
     void push_transactions(const push_transactions_params& params, chain::plugin_interface::next_function<push_transactions_results> next);
 
+    // transactions are pushed all at once so their signatures are recovered in parallel,
+    // results keep the order of the input
+    using push_packed_transactions_params  = vector<packed_transaction_ptr>;
+    using push_packed_transactions_results = push_transactions_results;
+    void push_packed_transactions(push_packed_transactions_params&& params, chain::plugin_interface::next_function<push_packed_transactions_results> next);
+
+    // body is either a json array of packed transactions
+    // or a sequence of raw packed transactions, each prefixed with its size as a little endian uint32
+    static push_packed_transactions_params parse_packed_transactions(const string& body);
+
+    // budgets take effect when the next block is accepted
+    struct set_memory_budget_params {
+        string   component;
+        uint64_t budget_mb;
+    };
+    using set_memory_budget_results = empty;
+    set_memory_budget_results set_memory_budget(const set_memory_budget_params& params);
+
     friend resolver_factory<read_write>;
 };
 }  // namespace chain_apis
@@ -221,9 +257,9 @@ public:
 
     bool block_is_on_preferred_chain(const chain::block_id_type& block_id);
 
-    static bool recover_reversible_blocks(const fc::path& db_dir, uint32_t cache_size, optional<fc::path> new_db_dir = optional<fc::path>(), uint32_t truncate_at_block = 0);
+    static bool recover_reversible_blocks(const fc::path& db_dir, optional<fc::path> new_db_dir = optional<fc::path>(), uint32_t truncate_at_block = 0);
 
-    static bool import_reversible_blocks(const fc::path& reversible_dir, uint32_t cache_size, const fc::path& reversible_blocks_file);
+    static bool import_reversible_blocks(const fc::path& reversible_dir, const fc::path& reversible_blocks_file);
 
     static bool export_reversible_blocks(const fc::path& reversible_dir, const fc::path& reversible_blocks_file);
     // return true if --skip-transaction-signatures passed to evtd
@@ -237,6 +273,22 @@ public:
 
     chain::chain_id_type get_chain_id() const;
 
+    // whether the chain would start from genesis, plugins may still give it a snapshot then
+    bool can_load_snapshot() const;
+
+    // the chain starts from the snapshot instead, only call this before plugin_startup()!
+    void set_snapshot(const fc::path& path);
+
+    // the blocks fetched from peers are appended to the block log after this state, nothing when they can't be
+    // only call this before plugin_startup()!
+    optional<chain::block_header_state> block_log_head_state() const;
+
+    // transactions being processed, whichever plugin they came from
+    inflight_transactions& get_inflight_transactions();
+
+    // Only call this after plugin_initialize()!
+    block_trace_bus& get_block_trace_bus();
+
     void handle_guard_exception(const chain::guard_exception& e) const;
 
     static void handle_db_exhaustion();
@@ -271,3 +323,6 @@ FC_REFLECT(evt::chain_apis::read_only::get_charge_params, (transaction)(sigs_num
 FC_REFLECT(evt::chain_apis::read_only::get_charge_result, (charge));
 FC_REFLECT(evt::chain_apis::read_only::get_transaction_ids_for_block_params, (block_id));
 FC_REFLECT(evt::chain_apis::read_write::push_transaction_results, (transaction_id)(processed));
+FC_REFLECT(evt::chain_apis::read_only::get_hot_keys_params, (top));
+FC_REFLECT(evt::chain_apis::read_write::set_memory_budget_params, (component)(budget_mb));
+FC_REFLECT(evt::utilities::memory::component_usage, (name)(bytes)(items)(budget));
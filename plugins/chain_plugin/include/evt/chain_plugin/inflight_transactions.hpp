@@ -0,0 +1,81 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <unordered_set>
+
+#include <evt/chain/types.hpp>
+
+namespace evt {
+
+/**
+ * Ids of the transactions accepted for processing and not answered yet, shared by all the
+ * plugins feeding transactions to the chain so a copy arriving meanwhile is refused at once.
+ *
+ * Ids are spread over shards by their second word, apart from the first one the hash uses,
+ * each shard has its own lock.
+ */
+class inflight_transactions {
+public:
+    struct stats_type {
+        uint64_t accepted;
+        uint64_t duplicates;
+        uint64_t size;
+    };
+
+public:
+    // false when the same id is already in flight
+    bool
+    insert(const chain::transaction_id_type& id) {
+        auto& s    = shard_of(id);
+        auto  lock = std::lock_guard(s.mtx);
+        if(!s.ids.emplace(id).second) {
+            duplicates_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        accepted_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    void
+    erase(const chain::transaction_id_type& id) {
+        auto& s    = shard_of(id);
+        auto  lock = std::lock_guard(s.mtx);
+        s.ids.erase(id);
+    }
+
+    stats_type
+    stats() const {
+        auto size = uint64_t(0);
+        for(auto& s : shards_) {
+            auto lock = std::lock_guard(s.mtx);
+            size += s.ids.size();
+        }
+        return { accepted_.load(std::memory_order_relaxed), duplicates_.load(std::memory_order_relaxed), size };
+    }
+
+private:
+    static constexpr size_t shard_count = 16;
+
+    struct shard {
+        mutable std::mutex                             mtx;
+        std::unordered_set<chain::transaction_id_type> ids;
+    };
+
+    shard&
+    shard_of(const chain::transaction_id_type& id) {
+        return shards_[id._hash[1] % shard_count];
+    }
+
+private:
+    std::array<shard, shard_count> shards_;
+    std::atomic<uint64_t>          accepted_{0};
+    std::atomic<uint64_t>          duplicates_{0};
+};
+
+}  // namespace evt
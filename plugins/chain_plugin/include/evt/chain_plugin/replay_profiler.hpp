@@ -0,0 +1,124 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+
+#include <map>
+#include <optional>
+#include <boost/signals2/connection.hpp>
+#include <fc/filesystem.hpp>
+#include <evt/chain/controller.hpp>
+#include <evt/chain/trace.hpp>
+
+namespace evt {
+
+/**
+ * Profiles the blocks applied in a range while replaying the block log
+ *
+ * Blocks are timed between the pre-accepted and accepted signals of controller, transactions
+ * and actions are taken from the applied traces, so only the controller is measured. Actions
+ * are counted by their names, by the kinds of their domains (reserved ones like .fungible or
+ * regular token domains) and by their domain and key pairs to find the hottest keys.
+ */
+class replay_profiler {
+public:
+    struct cost_type {
+        uint64_t count     = 0;
+        uint64_t total_us  = 0;
+        uint64_t max_us    = 0;
+        uint64_t db_reads  = 0;
+        uint64_t db_writes = 0;
+        uint64_t db_misses = 0;
+    };
+
+    struct named_cost {
+        std::string name;
+        cost_type   cost;
+    };
+
+    struct key_cost {
+        chain::name128 domain;
+        chain::name128 key;
+        cost_type      cost;
+    };
+
+    struct block_cost {
+        uint32_t             block_num = 0;
+        chain::block_id_type id;
+        uint32_t             trxs       = 0;
+        uint64_t             elapsed_us = 0;
+    };
+
+    struct trx_cost {
+        chain::transaction_id_type id;
+        uint32_t                   block_num  = 0;
+        uint64_t                   elapsed_us = 0;
+        std::vector<std::string>   actions;
+    };
+
+    struct report {
+        uint32_t first_block = 0;
+        uint32_t last_block  = 0;
+        uint64_t blocks      = 0;
+        uint64_t trxs        = 0;
+        uint64_t elapsed_us  = 0;  // sum of the blocks
+
+        std::vector<named_cost>         actions;
+        std::vector<named_cost>         domain_kinds;
+        std::vector<block_cost>         slowest_blocks;
+        std::vector<trx_cost>           slowest_trxs;
+        std::vector<key_cost>           hottest_keys;
+        std::map<std::string, uint64_t> tokendb_tickers;  // changes in the range
+    };
+
+public:
+    // `last` is 0 for the end of block log, `top` is the size of each ranking
+    replay_profiler(chain::controller& chain, uint32_t first, uint32_t last, uint32_t top);
+
+public:
+    report get_report() const;
+    void   write_report(const fc::path& path) const;
+
+private:
+    void on_block_start(const chain::signed_block_ptr& b);
+    void on_block_end(const chain::block_state_ptr& bs);
+    void on_transaction(const chain::transaction_trace_ptr& trace);
+
+    bool in_range(uint32_t num) const { return num >= first_ && (last_ == 0 || num <= last_); }
+
+private:
+    chain::controller& chain_;
+    uint32_t           first_;
+    uint32_t           last_;
+    uint32_t           top_;
+
+    std::optional<fc::time_point>   block_start_;
+    uint32_t                        block_num_  = 0;
+    uint32_t                        block_trxs_ = 0;
+    std::map<std::string, uint64_t> tickers_start_;
+
+    uint32_t first_seen_ = 0;
+    uint32_t last_seen_  = 0;
+    uint64_t blocks_     = 0;
+    uint64_t trxs_       = 0;
+    uint64_t elapsed_us_ = 0;
+
+    std::map<std::string, cost_type>                               actions_;
+    std::map<std::string, cost_type>                               domain_kinds_;
+    std::map<std::pair<chain::name128, chain::name128>, cost_type> keys_;
+    std::vector<block_cost>                                        slowest_blocks_;  // heaps with the fastest one on top
+    std::vector<trx_cost>                                          slowest_trxs_;
+
+    boost::signals2::scoped_connection  block_start_conn_;
+    utilities::scoped_signal_connection conns_[2];
+};
+
+}  // namespace evt
+
+FC_REFLECT(evt::replay_profiler::cost_type, (count)(total_us)(max_us)(db_reads)(db_writes)(db_misses));
+FC_REFLECT(evt::replay_profiler::named_cost, (name)(cost));
+FC_REFLECT(evt::replay_profiler::key_cost, (domain)(key)(cost));
+FC_REFLECT(evt::replay_profiler::block_cost, (block_num)(id)(trxs)(elapsed_us));
+FC_REFLECT(evt::replay_profiler::trx_cost, (id)(block_num)(elapsed_us)(actions));
+FC_REFLECT(evt::replay_profiler::report, (first_block)(last_block)(blocks)(trxs)(elapsed_us)(actions)(domain_kinds)(slowest_blocks)(slowest_trxs)(hottest_keys)(tokendb_tickers));
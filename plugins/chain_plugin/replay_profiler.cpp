@@ -0,0 +1,173 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#include <evt/chain_plugin/replay_profiler.hpp>
+
+#include <algorithm>
+#include <fc/io/json.hpp>
+#include <evt/chain/token_database.hpp>
+
+namespace evt {
+
+using namespace evt::chain;
+
+namespace internal {
+
+void
+add_cost(replay_profiler::cost_type& c, const action_trace& at) {
+    auto us = (uint64_t)std::max(at.elapsed.count(), (int64_t)0);
+
+    c.count++;
+    c.total_us += us;
+    c.max_us = std::max(c.max_us, us);
+    c.db_reads += at.db_reads;
+    c.db_writes += at.db_writes;
+    c.db_misses += at.db_misses;
+}
+
+// reserved domains are named by themselves, all the other ones hold tokens
+std::string
+domain_kind(const name128& domain) {
+    auto s = domain.to_string();
+    return (!s.empty() && s[0] == '.') ? s : "(token domains)";
+}
+
+// keeps the `top` slowest items in a heap whose top is the fastest of them
+template <typename T>
+void
+push_top(std::vector<T>& heap, T&& item, size_t top) {
+    auto cmp = [](auto& a, auto& b) { return a.elapsed_us > b.elapsed_us; };
+    if(heap.size() < top) {
+        heap.emplace_back(std::move(item));
+        std::push_heap(heap.begin(), heap.end(), cmp);
+    }
+    else if(!heap.empty() && item.elapsed_us > heap.front().elapsed_us) {
+        std::pop_heap(heap.begin(), heap.end(), cmp);
+        heap.back() = std::move(item);
+        std::push_heap(heap.begin(), heap.end(), cmp);
+    }
+}
+
+template <typename T>
+std::vector<T>
+sorted_top(std::vector<T> v) {
+    std::sort(v.begin(), v.end(), [](auto& a, auto& b) { return a.elapsed_us > b.elapsed_us; });
+    return v;
+}
+
+std::vector<replay_profiler::named_cost>
+sorted_costs(const std::map<std::string, replay_profiler::cost_type>& m) {
+    auto v = std::vector<replay_profiler::named_cost>();
+    for(auto& it : m) {
+        v.emplace_back(replay_profiler::named_cost{ it.first, it.second });
+    }
+    std::sort(v.begin(), v.end(), [](auto& a, auto& b) { return a.cost.total_us > b.cost.total_us; });
+    return v;
+}
+
+}  // namespace internal
+
+replay_profiler::replay_profiler(controller& chain, uint32_t first, uint32_t last, uint32_t top)
+    : chain_(chain)
+    , first_(first)
+    , last_(last)
+    , top_(top) {
+    block_start_conn_ = chain_.pre_accepted_block.connect([this](auto& b) { on_block_start(b); });
+    conns_[0] = chain_.accepted_block.connect([this](auto& bs) { on_block_end(bs); }, utilities::slot_position::at_front);
+    conns_[1] = chain_.applied_transaction.connect([this](auto& trace) { on_transaction(trace); });
+}
+
+void
+replay_profiler::on_block_start(const signed_block_ptr& b) {
+    block_num_  = b->block_num();
+    block_trxs_ = 0;
+    if(!in_range(block_num_)) {
+        block_start_.reset();
+        return;
+    }
+
+    if(blocks_ == 0) {
+        tickers_start_ = chain_.token_db().tickers();
+        first_seen_    = block_num_;
+    }
+    block_start_ = fc::time_point::now();
+}
+
+void
+replay_profiler::on_block_end(const block_state_ptr& bs) {
+    if(!block_start_.has_value() || bs->block_num != block_num_) {
+        return;
+    }
+
+    auto us = (uint64_t)(fc::time_point::now() - *block_start_).count();
+    block_start_.reset();
+
+    blocks_++;
+    elapsed_us_ += us;
+    last_seen_ = block_num_;
+    internal::push_top(slowest_blocks_, block_cost{ block_num_, bs->id, block_trxs_, us }, top_);
+}
+
+void
+replay_profiler::on_transaction(const transaction_trace_ptr& trace) {
+    if(!block_start_.has_value()) {
+        return;
+    }
+
+    trxs_++;
+    block_trxs_++;
+
+    auto tc       = trx_cost();
+    tc.id         = trace->id;
+    tc.block_num  = block_num_;
+    tc.elapsed_us = (uint64_t)std::max(trace->elapsed.count(), (int64_t)0);
+    for(auto& at : trace->action_traces) {
+        tc.actions.emplace_back(at.act.name.to_string());
+
+        internal::add_cost(actions_[at.act.name.to_string()], at);
+        internal::add_cost(domain_kinds_[internal::domain_kind(at.act.domain)], at);
+        internal::add_cost(keys_[std::make_pair(at.act.domain, at.act.key)], at);
+    }
+    internal::push_top(slowest_trxs_, std::move(tc), top_);
+}
+
+replay_profiler::report
+replay_profiler::get_report() const {
+    auto r           = report();
+    r.first_block    = first_seen_;
+    r.last_block     = last_seen_;
+    r.blocks         = blocks_;
+    r.trxs           = trxs_;
+    r.elapsed_us     = elapsed_us_;
+    r.actions        = internal::sorted_costs(actions_);
+    r.domain_kinds   = internal::sorted_costs(domain_kinds_);
+    r.slowest_blocks = internal::sorted_top(slowest_blocks_);
+    r.slowest_trxs   = internal::sorted_top(slowest_trxs_);
+
+    // hottest by the time spent on them, not by how often they're touched
+    auto keys = std::vector<key_cost>();
+    for(auto& it : keys_) {
+        keys.emplace_back(key_cost{ it.first.first, it.first.second, it.second });
+    }
+    auto n = std::min(keys.size(), (size_t)top_);
+    std::partial_sort(keys.begin(), keys.begin() + n, keys.end(), [](auto& a, auto& b) { return a.cost.total_us > b.cost.total_us; });
+    keys.resize(n);
+    r.hottest_keys = std::move(keys);
+
+    for(auto& it : chain_.token_db().tickers()) {
+        auto s = tickers_start_.find(it.first);
+        auto v = it.second - (s != tickers_start_.end() ? s->second : 0);
+        if(v > 0) {
+            r.tokendb_tickers[it.first] = v;
+        }
+    }
+    return r;
+}
+
+void
+replay_profiler::write_report(const fc::path& path) const {
+    fc::json::save_to_file(get_report(), path, true);
+}
+
+}  // namespace evt
@@ -37,7 +37,7 @@ evt_api_plugin::plugin_initialize(const variables_map&) {}
                     if(body.empty())                                                                                          \
                         body = "{}";                                                                                          \
                     auto result = api_handle.call_name(fc::json::from_string(body).as<api_namespace::call_name##_params>());  \
-                    cb(http_response_code, fc::json::to_string(result));                                                      \
+                    cb(http_response_code, std::move(result));                                                                \
                 }                                                                                                             \
                 catch (...) {                                                                                                 \
                     http_plugin::handle_exception(#api_name, #call_name, body, cb);                                           \
@@ -54,16 +54,18 @@ evt_api_plugin::plugin_startup() {
     my.reset(new evt_api_plugin_impl(app().get_plugin<chain_plugin>().chain()));
     auto ro_api = app().get_plugin<evt_plugin>().get_read_only_api();
 
-    app().get_plugin<http_plugin>().add_api({EVT_RO_CALL(get_domain, 200),
-                                             EVT_RO_CALL(get_group, 200),
-                                             EVT_RO_CALL(get_token, 200),
-                                             EVT_RO_CALL(get_tokens, 200),
-                                             EVT_RO_CALL(get_fungible, 200),
-                                             EVT_RO_CALL(get_fungible_balance, 200),
-                                             EVT_RO_CALL(get_fungible_psvbonus, 200),
-                                             EVT_RO_CALL(get_suspend, 200),
-                                             EVT_RO_CALL(get_lock, 200),
-                                         });
+    app().get_plugin<http_plugin>().add_read_only_api({EVT_RO_CALL(get_domain, 200),
+                                                       EVT_RO_CALL(get_group, 200),
+                                                       EVT_RO_CALL(get_token, 200),
+                                                       EVT_RO_CALL(get_tokens, 200),
+                                                       EVT_RO_CALL(get_owned_tokens, 200),
+                                                       EVT_RO_CALL(get_fungible, 200),
+                                                       EVT_RO_CALL(get_fungible_balance, 200),
+                                                       EVT_RO_CALL(get_fungible_psvbonus, 200),
+                                                       EVT_RO_CALL(get_suspend, 200),
+                                                       EVT_RO_CALL(get_lock, 200),
+                                                       EVT_RO_CALL(batch, 200),
+                                                   });
 }
 
 void
@@ -4,16 +4,18 @@
  */
 #include <evt/evt_link_plugin/evt_link_plugin.hpp>
 
-#include <deque>
-#include <tuple>
+#include <array>
+#include <atomic>
 #include <chrono>
-#include <unordered_map>
+#include <mutex>
 #include <thread>
+#include <unordered_map>
+#include <vector>
 
-#include <boost/asio.hpp>
 #include <fc/io/json.hpp>
 #include <fc/crypto/city.hpp>
 
+#include <evt/chain_plugin/block_trace_bus.hpp>
 #include <evt/chain_plugin/chain_plugin.hpp>
 #include <evt/chain/plugin_interface.hpp>
 #include <evt/chain/exceptions.hpp>
@@ -27,13 +29,12 @@ static appbase::abstract_plugin& _evt_link_plugin = app().register_plugin<evt_li
 
 using evt::chain::bytes;
 using evt::chain::link_id_type;
+using evt::chain::transaction_id_type;
 using evt::chain::block_state_ptr;
-using evt::chain::transaction_trace_ptr;
 using evt::chain::contracts::evt_link;
 using evt::chain::contracts::everipay;
 
-using boost::asio::steady_timer;
-using steady_timer_ptr = std::shared_ptr<steady_timer>;
+namespace internal {
 
 struct evt_link_id_hasher {
     size_t
@@ -42,44 +43,125 @@ struct evt_link_id_hasher {
     }
 };
 
-class evt_link_plugin_impl : public std::enable_shared_from_this<evt_link_plugin_impl> {
+/**
+ * Requests waiting for their link id, split into shards by the id so that the http handlers
+ * registering them and the thread answering them only contend on the same shard.
+ */
+class waiter_registry {
 public:
-    using deferred_pair = std::pair<deferred_id, steady_timer_ptr>;
-    enum { kDeferredId = 0, kTimer };
+    static constexpr size_t kShardsNum = 16;
 
 public:
-    evt_link_plugin_impl(controller& db)
-        : db_(db) {}
-    ~evt_link_plugin_impl();
+    void
+    add(const link_id_type& link_id, deferred_id id) {
+        auto& sd   = get_shard(link_id);
+        auto  lock = std::lock_guard(sd.mtx);
+        sd.ids.emplace(link_id, id);
+        size_.fetch_add(1, std::memory_order_relaxed);
+    }
 
-public:
-    void init();
-    void get_trx_id_for_link_id(const link_id_type& link_id, deferred_id id);
-    void add_and_schedule(const link_id_type& link_id, deferred_id id);
+    // removes all the waiters of the link and appends them to `ids`
+    void
+    take(const link_id_type& link_id, std::vector<deferred_id>& ids) {
+        auto& sd   = get_shard(link_id);
+        auto  lock = std::lock_guard(sd.mtx);
+        auto  r    = sd.ids.equal_range(link_id);
+        for(auto it = r.first; it != r.second; it++) {
+            ids.emplace_back(it->second);
+        }
+        auto n = sd.ids.erase(link_id);
+        size_.fetch_sub(n, std::memory_order_relaxed);
+    }
+
+    // false if the waiter was already answered
+    bool
+    remove(const link_id_type& link_id, deferred_id id) {
+        auto& sd   = get_shard(link_id);
+        auto  lock = std::lock_guard(sd.mtx);
+        auto  r    = sd.ids.equal_range(link_id);
+        for(auto it = r.first; it != r.second; it++) {
+            if(it->second == id) {
+                sd.ids.erase(it);
+                size_.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool empty() const { return size_.load(std::memory_order_relaxed) == 0; }
 
 private:
-    void applied_block(const block_state_ptr& bs);
+    struct shard {
+        std::mutex                                                             mtx;
+        std::unordered_multimap<link_id_type, deferred_id, evt_link_id_hasher> ids;
+    };
+
+    shard&
+    get_shard(const link_id_type& link_id) {
+        return shards_[evt_link_id_hasher()(link_id) % kShardsNum];
+    }
 
-    template<typename T>
-    void response(const link_id_type& link_id, T&& response_fun);
+private:
+    std::array<shard, kShardsNum> shards_;
+    std::atomic<size_t>           size_ = 0;
+};
 
+/**
+ * Expirations of the waiters in slots of one tick each, instead of one timer per request.
+ * A waiter expires between the timeout and one tick after it.
+ */
+class timer_wheel {
 public:
-    controller& db_;
+    using clock_type = std::chrono::steady_clock;
+    using entry      = std::pair<link_id_type, deferred_id>;
 
-    std::atomic_bool init_{false};
-    uint32_t         timeout_;
+public:
+    timer_wheel(std::chrono::milliseconds tick, std::chrono::milliseconds timeout)
+        : tick_(tick)
+        , ticks_((timeout.count() + tick.count() - 1) / tick.count() + 1)
+        , slots_(ticks_ + 1)
+        , next_tick_(clock_type::now() + tick) {}
+
+public:
+    void
+    add(const link_id_type& link_id, deferred_id id) {
+        auto lock = std::lock_guard(mtx_);
+        slots_[(current_ + ticks_) % slots_.size()].emplace_back(link_id, id);
+    }
+
+    // moves the entries of the slots passed until now to `expired`
+    void
+    advance(std::vector<entry>& expired) {
+        auto now  = clock_type::now();
+        auto lock = std::lock_guard(mtx_);
+        while(now >= next_tick_) {
+            current_ = (current_ + 1) % slots_.size();
+
+            auto& slot = slots_[current_];
+            expired.insert(expired.end(), slot.begin(), slot.end());
+            slot.clear();
+            next_tick_ += tick_;
+        }
+    }
 
-    std::unordered_multimap<link_id_type, deferred_pair, evt_link_id_hasher> link_ids_;
+    std::chrono::milliseconds tick() const { return tick_; }
 
-    std::optional<boost::signals2::scoped_connection> accepted_block_connection_;
+private:
+    std::chrono::milliseconds       tick_;
+    size_t                          ticks_;
+    std::mutex                      mtx_;
+    std::vector<std::vector<entry>> slots_;
+    size_t                          current_ = 0;
+    clock_type::time_point          next_tick_;
 };
 
-void
-evt_link_plugin_impl::applied_block(const block_state_ptr& bs) {
-    if(link_ids_.empty()) {
-        return;
-    }
+// everiPay links of one block with the transactions having them
+using block_links = std::vector<std::pair<link_id_type, transaction_id_type>>;
 
+block_links
+extract_links(const block_state_ptr& bs) {
+    auto links = block_links();
     for(auto& trx : bs->trxs) {
         for(auto& act : trx->packed_trx->get_transaction().actions) {
             if(act.name != N(everipay)) {
@@ -87,82 +169,129 @@ evt_link_plugin_impl::applied_block(const block_state_ptr& bs) {
             }
 
             auto& epact = act.data_as<const everipay&>();
+            links.emplace_back(epact.link.get_link_id(), trx->id);
+        }
+    }
+    return links;
+}
 
-            response(epact.link.get_link_id(), [&] {
-                auto vo         = fc::mutable_variant_object();
-                vo["block_num"] = bs->block_num;
-                vo["block_id"]  = bs->id;
-                vo["trx_id"]    = trx->id;
-                vo["err_code"]  = 0;
+}  // namespace internal
 
-                return fc::json::to_string(vo);
-            });
+class evt_link_plugin_impl {
+public:
+    evt_link_plugin_impl(controller& db, uint32_t timeout)
+        : db_(db)
+        , timeout_(timeout)
+        , wheel_(std::chrono::milliseconds(kTickMs), std::chrono::milliseconds(timeout)) {}
+    ~evt_link_plugin_impl();
+
+public:
+    void init(size_t queue_size);
+    void get_trx_id_for_link_id(const link_id_type& link_id, deferred_id id);
+    void add_and_schedule(const link_id_type& link_id, deferred_id id);
+
+private:
+    void consume_blocks();
+    void applied_block(const block_state_ptr& bs);
+    void expire_waiters();
+
+public:
+    static constexpr int kTickMs = 50;
+
+    controller& db_;
+
+    std::atomic_bool init_{false};
+    uint32_t         timeout_;
+
+    internal::waiter_registry waiters_;
+    internal::timer_wheel     wheel_;
+
+    block_trace_bus*             bus_        = nullptr;
+    block_trace_bus::consumer_id consumer_   = 0;
+    size_t                       queue_size_ = 0;
+
+    std::thread      consume_thread_;
+    std::atomic_bool done_ = false;
+};
+
+void
+evt_link_plugin_impl::consume_blocks() {
+    auto events = std::vector<block_trace_event>();
+
+    while(!done_) {
+        events.clear();
+        bus_->pop(consumer_, events, queue_size_, wheel_.tick());
+
+        for(auto& e : events) {
+            if(e.kind == block_trace_event::accepted_block && !waiters_.empty()) {
+                try {
+                    applied_block(e.block);
+                }
+                FC_LOG_AND_DROP();
+            }
+        }
+        if(!events.empty()) {
+            bus_->ack(consumer_);
         }
+        expire_waiters();
     }
 }
 
-template<typename T>
 void
-evt_link_plugin_impl::response(const link_id_type& link_id, T&& response_fun) {
-    auto sz = link_ids_.count(link_id);
-    if(sz == 0) {
-        return;
-    }
-    auto json = response_fun();
-    auto wptr = std::weak_ptr<evt_link_plugin_impl>(shared_from_this());
-    boost::asio::post(app().get_io_service(), [wptr, json, link_id] {
-        auto self = wptr.lock();
-        if(!self) {
-            return;
+evt_link_plugin_impl::applied_block(const block_state_ptr& bs) {
+    auto ids = std::vector<deferred_id>();
+    for(auto& link : internal::extract_links(bs)) {
+        ids.clear();
+        waiters_.take(link.first, ids);
+        if(ids.empty()) {
+            continue;
         }
-        auto pair = self->link_ids_.equal_range(link_id);
-        if(pair.first != self->link_ids_.end()) {
-            std::for_each(pair.first, pair.second, [&](auto& it) {
-                app().get_plugin<http_plugin>().set_deferred_response(std::get<kDeferredId>(it.second), 200, json);
-            });
 
-            self->link_ids_.erase(link_id);
-            return;
+        auto vo         = fc::mutable_variant_object();
+        vo["block_num"] = bs->block_num;
+        vo["block_id"]  = bs->id;
+        vo["trx_id"]    = link.second;
+        vo["err_code"]  = 0;
+
+        auto json = fc::json::to_string(vo);
+        for(auto id : ids) {
+            app().get_plugin<http_plugin>().set_deferred_response(id, 200, json);
         }
-    });
+    }
 }
 
 void
-evt_link_plugin_impl::add_and_schedule(const link_id_type& link_id, deferred_id id) {
-    auto it = link_ids_.emplace(link_id, std::make_pair(id, std::make_shared<steady_timer>(app().get_io_service())));
-
-    auto timer = std::get<kTimer>(it->second);
-    timer->expires_from_now(std::chrono::milliseconds(timeout_));
-    
-    auto wptr = std::weak_ptr<evt_link_plugin_impl>(shared_from_this());
-    timer->async_wait([wptr, link_id](auto& ec) {
-        auto self = wptr.lock();
-        if(self && ec != boost::asio::error::operation_aborted) {
-            auto pair = self->link_ids_.equal_range(link_id);
-            if(pair.first == self->link_ids_.end()) {
-                wlog("Cannot find context for id: ${id}", ("id",link_id));
-                return;
-            }
-            
-            auto ids = std::vector<deferred_id>();
-            std::for_each(pair.first, pair.second, [&ids](auto& it) {
-                ids.emplace_back(std::get<kDeferredId>(it.second));
-            });
-
-            self->link_ids_.erase(link_id);
+evt_link_plugin_impl::expire_waiters() {
+    auto expired = std::vector<internal::timer_wheel::entry>();
+    wheel_.advance(expired);
+
+    auto ids = std::vector<deferred_id>();
+    for(auto& e : expired) {
+        // the ones answered already are still in the wheel
+        if(waiters_.remove(e.first, e.second)) {
+            ids.emplace_back(e.second);
+        }
+    }
+    if(ids.empty()) {
+        return;
+    }
 
-            try {
-                EVT_THROW(chain::exceed_evt_link_watch_time_exception, "Exceed EVT-Link watch time: ${time} ms", ("time",self->timeout_));
-            }
-            catch(...) {
-                http_plugin::handle_exception("evt_link", "get_trx_id_for_link_id", "", [&ids](auto code, auto body) {
-                    for(auto id : ids) {
-                        app().get_plugin<http_plugin>().set_deferred_response(id, code, body);
-                    }
-                });
+    try {
+        EVT_THROW(chain::exceed_evt_link_watch_time_exception, "Exceed EVT-Link watch time: ${time} ms", ("time",timeout_));
+    }
+    catch(...) {
+        http_plugin::handle_exception("evt_link", "get_trx_id_for_link_id", "", [&ids](auto code, auto body) {
+            for(auto id : ids) {
+                app().get_plugin<http_plugin>().set_deferred_response(id, code, body);
             }
-        }
-    });
+        });
+    }
+}
+
+void
+evt_link_plugin_impl::add_and_schedule(const link_id_type& link_id, deferred_id id) {
+    waiters_.add(link_id, id);
+    wheel_.add(link_id, id);
 }
 
 void
@@ -190,18 +319,26 @@ evt_link_plugin_impl::get_trx_id_for_link_id(const link_id_type& link_id, deferr
 }
 
 void
-evt_link_plugin_impl::init() {
+evt_link_plugin_impl::init(size_t queue_size) {
     init_ = true;
 
-    auto& chain_plug = app().get_plugin<chain_plugin>();
-    auto& chain      = chain_plug.chain();
+    // the waiters are registered on the main thread before the block having their link is
+    // accepted there, so the consume thread never misses one
+    queue_size_ = queue_size;
+    bus_        = &app().get_plugin<chain_plugin>().get_block_trace_bus();
+    consumer_   = bus_->subscribe(queue_size_);
 
-    accepted_block_connection_.emplace(chain.accepted_block.connect([&](const chain::block_state_ptr& bs) {
-        applied_block(bs);
-    }));
+    consume_thread_ = std::thread([this] { consume_blocks(); });
 }
 
-evt_link_plugin_impl::~evt_link_plugin_impl() {}
+evt_link_plugin_impl::~evt_link_plugin_impl() {
+    if(!bus_) {
+        return;
+    }
+    done_ = true;
+    bus_->unsubscribe(consumer_);
+    consume_thread_.join();
+}
 
 evt_link_plugin::evt_link_plugin() {}
 evt_link_plugin::~evt_link_plugin() {}
@@ -210,14 +347,14 @@ void
 evt_link_plugin::set_program_options(options_description&, options_description& cfg) {
     cfg.add_options()
         ("evt-link-timeout", bpo::value<uint32_t>()->default_value(5000), "Max time waitting for the deferred request.")
+        ("evt-link-queue-size", bpo::value<uint32_t>()->default_value(1024), "The queue size between evtd and the thread answering the deferred requests.")
     ;
 }
 
 void
 evt_link_plugin::plugin_initialize(const variables_map& options) {
-    my_ = std::make_shared<evt_link_plugin_impl>(app().get_plugin<chain_plugin>().chain());
-    my_->timeout_ = options.at("evt-link-timeout").as<uint32_t>();
-    my_->init();
+    my_ = std::make_shared<evt_link_plugin_impl>(app().get_plugin<chain_plugin>().chain(), options.at("evt-link-timeout").as<uint32_t>());
+    my_->init(options.at("evt-link-queue-size").as<uint32_t>());
 }
 
 void
@@ -251,7 +388,6 @@ evt_link_plugin::plugin_startup() {
 
 void
 evt_link_plugin::plugin_shutdown() {
-    my_->accepted_block_connection_.reset();
     my_.reset();
 }
 
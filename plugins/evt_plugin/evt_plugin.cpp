@@ -7,6 +7,7 @@
 
 #include <fc/container/flat.hpp>
 #include <fc/io/json.hpp>
+#include <fc/io/json_writer.hpp>
 #include <fc/variant.hpp>
 
 #include <evt/chain/types.hpp>
@@ -17,6 +18,15 @@
 #include <evt/chain/token_database_cache.hpp>
 #include <evt/chain/contracts/evt_contract_abi.hpp>
 
+FC_JSON_REFLECTED(evt::chain::contracts::authorizer_weight);
+FC_JSON_REFLECTED(evt::chain::contracts::permission_def);
+FC_JSON_REFLECTED(evt::chain::contracts::meta);
+FC_JSON_REFLECTED(evt::chain::contracts::domain_def);
+FC_JSON_REFLECTED(evt::chain::contracts::token_def);
+FC_JSON_REFLECTED(evt::chain::contracts::fungible_def);
+FC_JSON_REFLECTED(evt::chain::contracts::passive_bonus);
+FC_JSON_REFLECTED(evt::chain::contracts::lock_def);
+
 namespace evt {
 
 static appbase::abstract_plugin& _evt_plugin = app().register_plugin<evt_plugin>();
@@ -59,13 +69,18 @@ evt_plugin::get_read_write_api() {
 
 namespace evt_apis {
 
-#define READ_DB_TOKEN(TYPE, PREFIX, KEY, VPTR, EXCEPTION, FORMAT, ...)      \
-    try {                                                                   \
-        using vtype = typename decltype(VPTR)::element_type;                \
-        VPTR = tokendb_cache.template read_token<vtype>(TYPE, PREFIX, KEY); \
-    }                                                                       \
-    catch(token_database_exception&) {                                      \
-        EVT_THROW2(EXCEPTION, FORMAT, __VA_ARGS__);                         \
+#define READ_DB_TOKEN(TYPE, PREFIX, KEY, VPTR, EXCEPTION, FORMAT, ...)          \
+    try {                                                                       \
+        using vtype = typename decltype(VPTR)::element_type;                    \
+        if(view != nullptr) {                                                   \
+            VPTR.read(*view, TYPE, PREFIX, KEY);                                \
+        }                                                                       \
+        else {                                                                  \
+            VPTR = tokendb_cache.template read_token<vtype>(TYPE, PREFIX, KEY); \
+        }                                                                       \
+    }                                                                           \
+    catch(token_database_exception&) {                                          \
+        EVT_THROW2(EXCEPTION, FORMAT, __VA_ARGS__);                             \
     }
     
 #define MAKE_PROPERTY(AMOUNT, SYM) \
@@ -87,20 +102,126 @@ namespace evt_apis {
         EVT_THROW2(balance_exception, "There's no balance left in {} with sym id: {}", ADDR, SYM); \
     }
 
-#define READ_DB_ASSET_NO_THROW(ADDR, SYM, VALUEREF)                         \
-    {                                                                       \
-        auto str = std::string();                                           \
-        if(!tokendb.read_asset(ADDR, SYM.id(), str, true /* no throw */)) { \
-            VALUEREF = MAKE_PROPERTY(0, SYM);                               \
-        }                                                                   \
-        else {                                                              \
-            extract_db_value(str, VALUEREF);                                \
-        }                                                                   \
+#define READ_DB_ASSET_NO_THROW(ADDR, SYM, VALUEREF)                                      \
+    {                                                                                    \
+        auto str   = std::string();                                                      \
+        auto found = view != nullptr ? view->read_asset(ADDR, SYM.id(), str, true)       \
+                                     : tokendb.read_asset(ADDR, SYM.id(), str, true);    \
+        if(!found) {                                                                     \
+            VALUEREF = MAKE_PROPERTY(0, SYM);                                            \
+        }                                                                                \
+        else {                                                                           \
+            extract_db_value(str, VALUEREF);                                             \
+        }                                                                                \
+    }
+
+// decodes only the members of the stored value selected by PRED, the others are skipped
+#define READ_DB_TOKEN_MEMBERS(TYPE, PREFIX, KEY, VALUE, PRED, EXCEPTION, FORMAT, ...) \
+    try {                                                                         \
+        auto str = std::string();                                                 \
+        if(view != nullptr) {                                                     \
+            view->read_token(TYPE, PREFIX, KEY, str);                             \
+        }                                                                         \
+        else {                                                                    \
+            tokendb.read_token(TYPE, PREFIX, KEY, str);                           \
+        }                                                                         \
+        extract_db_members(str, VALUE, PRED);                                     \
+    }                                                                             \
+    catch(token_database_exception&) {                                            \
+        EVT_THROW2(EXCEPTION, FORMAT, __VA_ARGS__);                               \
+    }
+
+#define DECLARE_TOKEN_DB(CONSISTENCY)                           \
+    auto& tokendb = db_.token_db();                             \
+    auto& tokendb_cache = db_.token_db_cache();                 \
+    auto  view = get_token_db_view(tokendb, CONSISTENCY);
+
+// value read either from the object cache or from an irreversible view
+template<typename T>
+class token_value {
+public:
+    using element_type = T;
+    using cache_ptr    = std::unique_ptr<T, token_database_cache::cache_deleter<T>>;
+
+public:
+    token_value&
+    operator=(cache_ptr&& ptr) {
+        ptr_ = std::move(ptr);
+        return *this;
+    }
+
+    void
+    read(const token_database_view& view, token_type type, const std::optional<name128>& domain, const name128& key) {
+        auto str = std::string();
+        view.read_token(type, domain, key, str);
+
+        value_.emplace();
+        extract_db_value(str, *value_);
     }
 
-#define DECLARE_TOKEN_DB()                     \
-    auto& tokendb = db_.token_db();            \
-    auto& tokendb_cache = db_.token_db_cache();
+    const T& operator*() const { return ptr_ ? *ptr_ : *value_; }
+    const T* operator->() const { return &**this; }
+
+private:
+    cache_ptr        ptr_ = make_empty_cache_ptr<T>();
+    std::optional<T> value_;
+};
+
+// members named by the `fields` of a call, all of them when it's not given
+class field_set {
+public:
+    field_set(const read_only::field_names& fields)
+        : fields_(fields.has_value() ? &*fields : nullptr) {}
+
+    bool all() const { return fields_ == nullptr; }
+
+    bool
+    operator()(std::string_view name) const {
+        return fields_ == nullptr || std::find(fields_->begin(), fields_->end(), name) != fields_->end();
+    }
+
+private:
+    const std::vector<std::string>* fields_;
+};
+
+template<typename T, typename Pred>
+void
+extract_db_members(const std::string& str, T& v, const Pred& pred) {
+    auto ds = fc::datastream<const char*>(str.data(), str.size());
+    fc::raw::unpack_members(ds, v, pred);
+}
+
+// null view means reading the pending state
+token_database_view_ptr
+get_token_db_view(const token_database& tokendb, const std::optional<read_consistency>& consistency) {
+    if(!consistency.has_value() || *consistency == read_consistency::pending) {
+        return nullptr;
+    }
+
+    auto view = tokendb.get_irreversible_view();
+    EVT_ASSERT(view != nullptr, unsupported_feature, "Irreversible reads are not available, enable `token-db-irreversible-reads` or wait for the loaded savepoints to become irreversible");
+    return view;
+}
+
+// metas kept apart from their parents are appended after the inline ones, in the order of their keys
+void
+read_metas_apart(const token_database& tokendb, const token_database_view_ptr& view, const name128& parent_type, const name128& parent, meta_list& metas) {
+    auto prefix = get_meta_db_key_prefix(parent_type, parent);
+    auto kp     = std::string_view((char*)&prefix, sizeof(prefix));
+    auto func   = [&](auto&, auto&& value) {
+        auto m = meta();
+        extract_db_value(value, m);
+        metas.emplace_back(std::move(m));
+        return true;
+    };
+
+    if(view != nullptr) {
+        view->read_tokens_prefix(token_type::meta, std::nullopt, kp, func);
+    }
+    else {
+        tokendb.read_tokens_prefix(token_type::meta, std::nullopt, kp, func);
+    }
+}
 
 enum psvbonus_type { kPsvBonus = 0, kPsvBonusSlim };
 
@@ -111,50 +232,98 @@ get_psvbonus_db_key(symbol_id_type id, uint64_t nonce) {
     return v;
 }
 
-fc::variant
+std::string
 read_only::get_domain(const read_only::get_domain_params& params) {
-    DECLARE_TOKEN_DB();
-
-    auto var    = variant();
-    auto domain = make_empty_cache_ptr<domain_def>();
-    READ_DB_TOKEN(token_type::domain, std::nullopt, params.name, domain, unknown_domain_exception, "Cannot find domain: {}", params.name);
-
-    fc::to_variant(*domain, var);
+    DECLARE_TOKEN_DB(params.consistency);
+
+    auto fields = field_set(params.fields);
+    auto d      = domain_def();
+    if(fields.all()) {
+        auto domain = token_value<domain_def>();
+        READ_DB_TOKEN(token_type::domain, std::nullopt, params.name, domain, unknown_domain_exception, "Cannot find domain: {}", params.name);
+        d = *domain;
+    }
+    else {
+        READ_DB_TOKEN_MEMBERS(token_type::domain, std::nullopt, params.name, d, fields, unknown_domain_exception, "Cannot find domain: {}", params.name);
+    }
+    if(fields("metas")) {
+        read_metas_apart(tokendb, view, N128(.domain), params.name, d.metas);
+    }
 
-    auto mvar = fc::mutable_variant_object(var);
-    mvar["address"] = address(N(.domain), params.name, 0);
-    return mvar;
+    auto w = fc::json_writer();
+    w.begin_object();
+    w.write_members(d, fields);
+    if(fields("address")) {
+        w.write_member("address", address(N(.domain), params.name, 0));
+    }
+    w.end_object();
+    return w.release();
 }
 
-fc::variant
+std::string
 read_only::get_group(const read_only::get_group_params& params) {
-    DECLARE_TOKEN_DB();
+    DECLARE_TOKEN_DB(params.consistency);
+
+    auto fields = field_set(params.fields);
+    auto g      = group_def();
+    if(fields.all()) {
+        auto group = token_value<group_def>();
+        READ_DB_TOKEN(token_type::group, std::nullopt, params.name, group, unknown_group_exception, "Cannot find group: {}", params.name);
+        g = *group;
+    }
+    else {
+        // the tree of the group is returned as `root`, which is made of both its nodes and its keys
+        auto members = [&](std::string_view m) {
+            return (m == "name_" && fields("name")) || (m == "key_" && fields("key"))
+                || ((m == "nodes_" || m == "keys_") && fields("root")) || (m == "metas_" && fields("metas"));
+        };
+        READ_DB_TOKEN_MEMBERS(token_type::group, std::nullopt, params.name, g, members, unknown_group_exception, "Cannot find group: {}", params.name);
+    }
+    if(fields("metas")) {
+        read_metas_apart(tokendb, view, N128(.group), params.name, g.metas_);
+    }
 
-    auto var   = variant();
-    auto group = make_empty_cache_ptr<group_def>();
-    READ_DB_TOKEN(token_type::group, std::nullopt, params.name, group, unknown_group_exception, "Cannot find group: {}", params.name);
+    auto w = fc::json_writer();
+    if(fields.all()) {
+        w.write(g);
+        return w.release();
+    }
 
-    fc::to_variant(*group, var);
-    return var;
+    w.begin_object();
+    if(fields("name")) {
+        w.write_member("name", g.name());
+    }
+    if(fields("key")) {
+        w.write_member("key", g.key());
+    }
+    if(fields("root") && !g.empty()) {
+        auto v = fc::variant(g);
+        w.write_member("root", v["root"]);
+    }
+    if(fields("metas")) {
+        w.write_member("metas", g.metas());
+    }
+    w.end_object();
+    return w.release();
 }
 
-fc::variant
+std::string
 read_only::get_token(const read_only::get_token_params& params) {
-    DECLARE_TOKEN_DB();
+    DECLARE_TOKEN_DB(params.consistency);
 
-    auto var   = variant();
-    auto token = make_empty_cache_ptr<token_def>();
+    auto token = token_value<token_def>();
     READ_DB_TOKEN(token_type::token, params.domain, params.name, token, unknown_token_exception, "Cannot find token: {} in {}", params.name, params.domain);
 
-    fc::to_variant(*token, var);
-    return var;
+    auto w = fc::json_writer();
+    w.write(*token);
+    return w.release();
 }
 
-fc::variant
+std::string
 read_only::get_tokens(const get_tokens_params& params) {
-    DECLARE_TOKEN_DB();
+    DECLARE_TOKEN_DB(params.consistency);
+    EVT_ASSERT(view == nullptr, unsupported_feature, "Irreversible reads are not supported by get_tokens");
 
-    auto vars = fc::variants();
     int s = 0, t = 10;
     if(params.skip.has_value()) {
         s = *params.skip;
@@ -164,15 +333,68 @@ read_only::get_tokens(const get_tokens_params& params) {
         EVT_ASSERT(t <= 100, chain::exceed_query_limit_exception, "Exceed limit of max actions return allowed for each query, limit: 100 per query");
     }
 
-    int i = 0;
-    tokendb.read_tokens_range(token_type::token, params.domain, s, [&](auto& key, auto&& value) {
-        auto var = fc::variant();
+    auto w = fc::json_writer();
+    w.begin_array();
+
+    // unpacks every token into the same object to reuse the buffers of its owners and metas
+    int  i      = 0;
+    auto token  = token_def();
+    auto fields = field_set(params.fields);
+    auto read_func = [&](auto& key, auto&& value) {
+        if(fields.all()) {
+            extract_db_value(value, token);
+            w.write(token);
+        }
+        else {
+            extract_db_members(value, token, fields);
+            w.begin_object();
+            w.write_members(token, fields);
+            w.end_object();
+        }
+
+        if(++i == t) {
+            return false;
+        }
+        return true;
+    };
+
+    if(params.cursor.has_value()) {
+        EVT_ASSERT(!params.skip.has_value(), chain::invalid_query_params_exception, "`skip` cannot be used together with `cursor`");
+
+        auto cursor = std::string((const char*)&(*params.cursor), sizeof(token_name));
+        tokendb.read_tokens_range(token_type::token, params.domain, cursor, read_func);
+    }
+    else {
+        tokendb.read_tokens_range(token_type::token, params.domain, s, read_func);
+    }
+
+    w.end_array();
+    return w.release();
+}
+
+std::string
+read_only::get_owned_tokens(const get_owned_tokens_params& params) {
+    DECLARE_TOKEN_DB(params.consistency);
+    EVT_ASSERT(view == nullptr, unsupported_feature, "Irreversible reads are not supported by get_owned_tokens");
+    EVT_ASSERT(tokendb.has_owner_index(), unsupported_feature, "Owner index of token database is not enabled");
+
+    int s = 0, t = 10;
+    if(params.skip.has_value()) {
+        s = *params.skip;
+    }
+    if(params.take.has_value()) {
+        t = *params.take;
+        EVT_ASSERT(t <= 100, chain::exceed_query_limit_exception, "Exceed limit of max actions return allowed for each query, limit: 100 per query");
+    }
 
-        token_def token;
-        extract_db_value(value, token);
+    auto w = fc::json_writer();
+    w.begin_array();
 
-        fc::to_variant(token, var);
-        vars.emplace_back(std::move(var));
+    int i = 0;
+    tokendb.read_owned_tokens(params.owner, s, [&](auto& domain, auto& name) {
+        auto token = token_value<token_def>();
+        READ_DB_TOKEN(token_type::token, domain, name, token, unknown_token_exception, "Cannot find token: {} in {}", name, domain);
+        w.write(*token);
 
         if(++i == t) {
             return false;
@@ -180,94 +402,321 @@ read_only::get_tokens(const get_tokens_params& params) {
         return true;
     });
 
-    return vars;
+    w.end_array();
+    return w.release();
 }
 
-fc::variant
+std::string
 read_only::get_fungible(const get_fungible_params& params) {
-    DECLARE_TOKEN_DB();
-
-    auto var      = variant();
-    auto fungible = make_empty_cache_ptr<fungible_def>();
-    READ_DB_TOKEN(token_type::fungible, std::nullopt, params.id, fungible, unknown_fungible_exception, "Cannot find fungible with sym id: {}", params.id);
-
-    fc::to_variant(*fungible, var);
+    DECLARE_TOKEN_DB(params.consistency);
+
+    auto fields = field_set(params.fields);
+    auto f      = fungible_def();
+    if(fields.all()) {
+        auto fungible = token_value<fungible_def>();
+        READ_DB_TOKEN(token_type::fungible, std::nullopt, params.id, fungible, unknown_fungible_exception, "Cannot find fungible with sym id: {}", params.id);
+        f = *fungible;
+    }
+    else {
+        // current supply is calculated from the total supply and the symbol
+        auto members = [&](std::string_view m) {
+            return fields(m) || (fields("current_supply") && (m == "total_supply" || m == "sym"));
+        };
+        READ_DB_TOKEN_MEMBERS(token_type::fungible, std::nullopt, params.id, f, members, unknown_fungible_exception, "Cannot find fungible with sym id: {}", params.id);
+    }
+    if(fields("metas")) {
+        read_metas_apart(tokendb, view, N128(.fungible), name128::from_number(params.id), f.metas);
+    }
 
-    auto mvar = fc::mutable_variant_object(var);
     auto addr = address(N(.fungible), name128::from_number(params.id), 0);
 
-    property prop;
-    READ_DB_ASSET_NO_THROW(addr, fungible->sym, prop);
-
-    mvar["current_supply"] = fungible->total_supply - asset(prop.amount, fungible->sym);
-    mvar["address"]        = addr;
-    return mvar;
+    auto w = fc::json_writer();
+    w.begin_object();
+    w.write_members(f, fields);
+    if(fields("current_supply")) {
+        property prop;
+        READ_DB_ASSET_NO_THROW(addr, f.sym, prop);
+        w.write_member("current_supply", f.total_supply - asset(prop.amount, f.sym));
+    }
+    if(fields("address")) {
+        w.write_member("address", addr);
+    }
+    w.end_object();
+    return w.release();
 }
 
-fc::variant
+std::string
 read_only::get_fungible_balance(const get_fungible_balance_params& params) {
-    DECLARE_TOKEN_DB();
+    DECLARE_TOKEN_DB(params.consistency);
 
-    auto vars = variants();
     if(params.sym_id.has_value()) {
-        auto fungible = make_empty_cache_ptr<fungible_def>();
+        auto fungible = token_value<fungible_def>();
         READ_DB_TOKEN(token_type::fungible, std::nullopt, *params.sym_id, fungible,
             unknown_fungible_exception, "Cannot find fungible with sym id: {}", *params.sym_id);
 
         property prop;
         READ_DB_ASSET_NO_THROW(params.address, fungible->sym, prop);
 
-        auto as  = asset(prop.amount, prop.sym);
-        auto var = variant();
-        fc::to_variant(as, var);
+        auto w = fc::json_writer();
+        w.begin_array();
+        w.write(asset(prop.amount, prop.sym));
+        w.end_array();
+        return w.release();
+    }
+
+    EVT_ASSERT(tokendb.has_holding_index(), unsupported_feature,
+        "Read all the balance of fungibles tokens within one address needs the holding index of token database, see `token-db-holding-index`");
+
+    auto w = fc::json_writer();
+    w.begin_array();
 
-        vars.emplace_back(std::move(var));
-        return vars;
+    auto func = [&](auto sym_id) {
+        auto fungible = token_value<fungible_def>();
+        READ_DB_TOKEN(token_type::fungible, std::nullopt, sym_id, fungible,
+            unknown_fungible_exception, "Cannot find fungible with sym id: {}", sym_id);
+
+        property prop;
+        READ_DB_ASSET_NO_THROW(params.address, fungible->sym, prop);
+        if(prop.amount > 0) {
+            w.write(asset(prop.amount, prop.sym));
+        }
+        return true;
+    };
+
+    if(view != nullptr) {
+        view->read_held_symbols(params.address, func);
+    }
+    else {
+        tokendb.read_held_symbols(params.address, func);
     }
-    EVT_THROW(unsupported_feature, "Read all the balance of fungibles tokens within one address is not supported in evt_plugin anymore, please refer to the history_plugin");
+
+    w.end_array();
+    return w.release();
 }
 
-fc::variant
+std::string
 read_only::get_fungible_psvbonus(const get_fungible_psvbonus_params& params) {
-    DECLARE_TOKEN_DB();
+    DECLARE_TOKEN_DB(params.consistency);
 
-    auto pb   = make_empty_cache_ptr<passive_bonus>();
+    auto pb   = token_value<passive_bonus>();
     auto dkey = get_psvbonus_db_key(params.id, kPsvBonus);
     READ_DB_TOKEN(token_type::psvbonus, std::nullopt, dkey, pb, unknown_bonus_exception,
         "Cannot find passive bonus registered for fungible token with sym id: {}.", params.id);
 
-    auto var = variant();
-    fc::to_variant(*pb, var);
-
-    auto mvar = fc::mutable_variant_object(var);
-    auto addr = address(N(.psvbonus), name128::from_number(params.id), 0);
-    mvar["address"] = addr;
-
-    return mvar;
+    auto w = fc::json_writer();
+    w.begin_object();
+    w.write_members(*pb);
+    w.write_member("address", address(N(.psvbonus), name128::from_number(params.id), 0));
+    w.end_object();
+    return w.release();
 }
 
-fc::variant
+std::string
 read_only::get_suspend(const get_suspend_params& params) {
-    DECLARE_TOKEN_DB();
+    DECLARE_TOKEN_DB(params.consistency);
 
     auto var     = variant();
-    auto suspend = make_empty_cache_ptr<suspend_def>();
+    auto suspend = token_value<suspend_def>();
     READ_DB_TOKEN(token_type::suspend, std::nullopt, params.name, suspend, unknown_suspend_exception, "Cannot find suspend proposal: {}", params.name);
 
+    // actions in the proposed transaction are decoded by the abi
     db_.get_abi_serializer().to_variant(*suspend, var, db_.get_execution_context());
-    return var;
+
+    auto w = fc::json_writer();
+    w.write(var);
+    return w.release();
 }
 
-fc::variant
+std::string
 read_only::get_lock(const get_lock_params& params) {
-    DECLARE_TOKEN_DB();
+    DECLARE_TOKEN_DB(params.consistency);
 
-    auto var  = variant();
-    auto lock = make_empty_cache_ptr<lock_def>();
+    auto lock = token_value<lock_def>();
     READ_DB_TOKEN(token_type::lock, std::nullopt, params.name, lock, unknown_lock_exception, "Cannot find lock proposal: {}", params.name);
 
-    fc::to_variant(*lock, var);
-    return var;
+    auto w = fc::json_writer();
+    w.write(*lock);
+    return w.release();
+}
+
+std::string
+read_only::batch(const batch_params& params) {
+    DECLARE_TOKEN_DB(std::nullopt);
+
+    EVT_ASSERT(params.size() <= 100, chain::exceed_query_limit_exception, "Exceed limit of max calls allowed for each batch, limit: 100 per batch");
+
+    auto results = std::vector<std::optional<std::string>>(params.size());
+    auto errors  = std::vector<std::optional<fc::exception>>(params.size());
+
+    // `f` returns the json result, or nothing when the result is filled by the batched reads later
+    auto run = [&](size_t i, auto&& f) {
+        try {
+            auto r = f();
+            if(r.has_value()) {
+                results[i] = std::move(*r);
+            }
+        }
+        catch(const fc::exception& e) {
+            errors[i] = e;
+        }
+        catch(const std::exception& e) {
+            errors[i] = fc::exception(FC_LOG_MESSAGE(error, e.what()));
+        }
+    };
+
+    struct token_group {
+        token_keys_t        keys;
+        std::vector<size_t> calls;
+    };
+    auto tokens = std::map<domain_name, token_group>();
+
+    auto assets     = asset_keys_t();
+    auto asset_syms = std::vector<symbol>();
+    auto asset_idxs = std::vector<size_t>();
+
+    using result_type = std::optional<std::string>;
+    for(auto i = 0u; i < params.size(); i++) {
+        auto& call = params[i];
+        run(i, [&]() -> result_type {
+            if(call.method == "get_token") {
+                auto p = call.params.as<get_token_params>();
+                if(p.consistency.has_value() && *p.consistency != read_consistency::pending) {
+                    return get_token(p);
+                }
+                auto& g = tokens[p.domain];
+                g.keys.emplace_back(p.name);
+                g.calls.emplace_back(i);
+                return std::nullopt;
+            }
+            else if(call.method == "get_fungible_balance") {
+                auto p = call.params.as<get_fungible_balance_params>();
+                // balances of all the symbols are read from the holding index by themselves
+                if((p.consistency.has_value() && *p.consistency != read_consistency::pending) || !p.sym_id.has_value()) {
+                    return get_fungible_balance(p);
+                }
+
+                auto fungible = token_value<fungible_def>();
+                READ_DB_TOKEN(token_type::fungible, std::nullopt, *p.sym_id, fungible,
+                    unknown_fungible_exception, "Cannot find fungible with sym id: {}", *p.sym_id);
+
+                assets.emplace_back(p.address, *p.sym_id);
+                asset_syms.emplace_back(fungible->sym);
+                asset_idxs.emplace_back(i);
+                return std::nullopt;
+            }
+            else if(call.method == "get_domain") {
+                return get_domain(call.params.as<get_domain_params>());
+            }
+            else if(call.method == "get_group") {
+                return get_group(call.params.as<get_group_params>());
+            }
+            else if(call.method == "get_tokens") {
+                return get_tokens(call.params.as<get_tokens_params>());
+            }
+            else if(call.method == "get_owned_tokens") {
+                return get_owned_tokens(call.params.as<get_owned_tokens_params>());
+            }
+            else if(call.method == "get_fungible") {
+                return get_fungible(call.params.as<get_fungible_params>());
+            }
+            else if(call.method == "get_fungible_psvbonus") {
+                return get_fungible_psvbonus(call.params.as<get_fungible_psvbonus_params>());
+            }
+            else if(call.method == "get_suspend") {
+                return get_suspend(call.params.as<get_suspend_params>());
+            }
+            else if(call.method == "get_lock") {
+                return get_lock(call.params.as<get_lock_params>());
+            }
+            EVT_THROW2(chain::invalid_query_params_exception, "Unknown method in batch: {}", call.method);
+        });
+    }
+
+    for(auto& it : tokens) {
+        auto& domain = it.first;
+        auto& g      = it.second;
+
+        auto outs = read_values_t();
+        try {
+            tokendb.read_tokens(token_type::token, domain, g.keys, outs, true /* no throw */);
+        }
+        catch(const fc::exception& e) {
+            for(auto i : g.calls) {
+                errors[i] = e;
+            }
+            continue;
+        }
+
+        for(auto j = 0u; j < g.calls.size(); j++) {
+            run(g.calls[j], [&]() -> result_type {
+                if(!outs[j].has_value()) {
+                    EVT_THROW2(unknown_token_exception, "Cannot find token: {} in {}", g.keys[j], domain);
+                }
+                token_def token;
+                extract_db_value(*outs[j], token);
+
+                auto w = fc::json_writer();
+                w.write(token);
+                return w.release();
+            });
+        }
+    }
+
+    if(!assets.empty()) {
+        auto outs = read_values_t();
+        try {
+            tokendb.read_assets(assets, outs, true /* no throw */);
+        }
+        catch(const fc::exception& e) {
+            for(auto i : asset_idxs) {
+                errors[i] = e;
+            }
+            outs.clear();
+        }
+
+        for(auto j = 0u; j < outs.size(); j++) {
+            run(asset_idxs[j], [&]() -> result_type {
+                property prop;
+                if(outs[j].has_value()) {
+                    extract_db_value(*outs[j], prop);
+                }
+                else {
+                    prop = MAKE_PROPERTY(0, asset_syms[j]);
+                }
+
+                auto w = fc::json_writer();
+                w.begin_array();
+                w.write(asset(prop.amount, prop.sym));
+                w.end_array();
+                return w.release();
+            });
+        }
+    }
+
+    auto w = fc::json_writer();
+    w.begin_array();
+    for(auto i = 0u; i < params.size(); i++) {
+        w.begin_object();
+        if(params[i].id.has_value()) {
+            w.write_member("id", *params[i].id);
+        }
+        if(errors[i].has_value()) {
+            auto& e = *errors[i];
+            w.key("error");
+            w.begin_object();
+            w.write_member("code", e.code());
+            w.write_member("name", e.name());
+            w.write_member("what", e.what());
+            w.end_object();
+        }
+        else {
+            w.key("result");
+            w.write_raw(*results[i]);
+        }
+        w.end_object();
+    }
+    w.end_array();
+    return w.release();
 }
 
 }  // namespace evt_apis
@@ -8,10 +8,6 @@
 #include <evt/chain/types.hpp>
 #include <evt/chain/contracts/types.hpp>
 
-namespace fc {
-class variant;
-}  // namespace fc
-
 namespace evt {
 
 namespace chain {
@@ -25,58 +21,104 @@ namespace evt_apis {
 using namespace evt::chain;
 using namespace evt::chain::contracts;
 
+// state a read is served from, `pending` when not given
+// `irreversible` reads never see values which may still be rolled back
+enum class read_consistency {
+    pending = 0,
+    irreversible
+};
+
+// results are json documents, written directly from the stored values
+// calls taking `fields` only return the members named there, and only decode those from the stored
+// values, all of them are returned when it's not given
 class read_only {
 public:
     read_only(const controller& db)
         : db_(db) {}
 
 public:
+    using field_names = std::optional<std::vector<std::string>>;
+
     struct get_domain_params {
-        domain_name name;
+        domain_name                     name;
+        std::optional<read_consistency> consistency;
+        field_names                     fields;
     };
-    fc::variant get_domain(const get_domain_params& params);
+    std::string get_domain(const get_domain_params& params);
 
     struct get_group_params {
-        group_name name;
+        group_name                      name;
+        std::optional<read_consistency> consistency;
+        field_names                     fields;
     };
-    fc::variant get_group(const get_group_params& params);
+    std::string get_group(const get_group_params& params);
 
     struct get_token_params {
-        domain_name domain;
-        token_name  name;
+        domain_name                     domain;
+        token_name                      name;
+        std::optional<read_consistency> consistency;
     };
-    fc::variant get_token(const get_token_params& params);
+    std::string get_token(const get_token_params& params);
 
     struct get_tokens_params {
-        domain_name        domain;
-        std::optional<int> skip;
-        std::optional<int> take;
+        domain_name                     domain;
+        std::optional<int>              skip;
+        std::optional<int>              take;
+        std::optional<token_name>       cursor;  // name of the last token returned, tokens after it are returned
+        std::optional<read_consistency> consistency;
+        field_names                     fields;
+    };
+    std::string get_tokens(const get_tokens_params& params);
+
+    // needs the owner index of token database, see `token-db-owner-index`
+    struct get_owned_tokens_params {
+        address_type                    owner;
+        std::optional<int>              skip;
+        std::optional<int>              take;
+        std::optional<read_consistency> consistency;
     };
-    fc::variant get_tokens(const get_tokens_params& params);
+    std::string get_owned_tokens(const get_owned_tokens_params& params);
 
     struct get_fungible_params {
-        symbol_id_type id;
+        symbol_id_type                  id;
+        std::optional<read_consistency> consistency;
+        field_names                     fields;
     };
-    fc::variant get_fungible(const get_fungible_params& params);
+    std::string get_fungible(const get_fungible_params& params);
 
+    // balances of all the symbols held by the address when `sym_id` is not provided, zero ones are left out
+    // needs the holding index of token database, see `token-db-holding-index`
     struct get_fungible_balance_params {
-        address_type                  address;
-        std::optional<symbol_id_type> sym_id;
+        address_type                    address;
+        std::optional<symbol_id_type>   sym_id;
+        std::optional<read_consistency> consistency;
     };
-    fc::variant get_fungible_balance(const get_fungible_balance_params& params);
+    std::string get_fungible_balance(const get_fungible_balance_params& params);
 
     struct get_fungible_psvbonus_params {
-        symbol_id_type id;
+        symbol_id_type                  id;
+        std::optional<read_consistency> consistency;
     };
-    fc::variant get_fungible_psvbonus(const get_fungible_psvbonus_params& params);
+    std::string get_fungible_psvbonus(const get_fungible_psvbonus_params& params);
 
     struct get_suspend_params {
-        proposal_name name;
+        proposal_name                   name;
+        std::optional<read_consistency> consistency;
     };
-    fc::variant get_suspend(const get_suspend_params& params);
+    std::string get_suspend(const get_suspend_params& params);
 
     using get_lock_params = get_suspend_params;
-    fc::variant get_lock(const get_lock_params& params);
+    std::string get_lock(const get_lock_params& params);
+
+    // executes several read calls against one view of the token database
+    // tokens and balances of all the calls are read with one multi-get each
+    struct batch_call {
+        std::string                method;
+        fc::variant                params;
+        std::optional<fc::variant> id;  // echoed in the result
+    };
+    using batch_params = std::vector<batch_call>;
+    std::string batch(const batch_params& params);
 
 private:
     const controller& db_;
@@ -108,11 +150,14 @@ private:
 
 }  // namespace evt
 
-FC_REFLECT(evt::evt_apis::read_only::get_domain_params, (name));
-FC_REFLECT(evt::evt_apis::read_only::get_group_params, (name));
-FC_REFLECT(evt::evt_apis::read_only::get_token_params, (domain)(name));
-FC_REFLECT(evt::evt_apis::read_only::get_tokens_params, (domain)(skip)(take));
-FC_REFLECT(evt::evt_apis::read_only::get_fungible_params, (id));
-FC_REFLECT(evt::evt_apis::read_only::get_fungible_balance_params, (address)(sym_id));
-FC_REFLECT(evt::evt_apis::read_only::get_fungible_psvbonus_params, (id));
-FC_REFLECT(evt::evt_apis::read_only::get_suspend_params, (name));
+FC_REFLECT_ENUM(evt::evt_apis::read_consistency, (pending)(irreversible));
+FC_REFLECT(evt::evt_apis::read_only::get_domain_params, (name)(consistency)(fields));
+FC_REFLECT(evt::evt_apis::read_only::get_group_params, (name)(consistency)(fields));
+FC_REFLECT(evt::evt_apis::read_only::get_token_params, (domain)(name)(consistency));
+FC_REFLECT(evt::evt_apis::read_only::get_tokens_params, (domain)(skip)(take)(cursor)(consistency)(fields));
+FC_REFLECT(evt::evt_apis::read_only::get_owned_tokens_params, (owner)(skip)(take)(consistency));
+FC_REFLECT(evt::evt_apis::read_only::get_fungible_params, (id)(consistency)(fields));
+FC_REFLECT(evt::evt_apis::read_only::get_fungible_balance_params, (address)(sym_id)(consistency));
+FC_REFLECT(evt::evt_apis::read_only::get_fungible_psvbonus_params, (id)(consistency));
+FC_REFLECT(evt::evt_apis::read_only::get_suspend_params, (name)(consistency));
+FC_REFLECT(evt::evt_apis::read_only::batch_call, (method)(params)(id));
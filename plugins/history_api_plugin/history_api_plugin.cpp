@@ -81,6 +81,7 @@ history_api_plugin::plugin_startup() {
                                                    HISTORY_RO_ASYNC_CALL(get_transactions),
                                                    HISTORY_RO_ASYNC_CALL(get_fungible_ids),
                                                    HISTORY_RO_ASYNC_CALL(get_transaction_actions),
+                                                   HISTORY_RO_ASYNC_CALL(get_transaction_detail),
                                                   });
 }
 
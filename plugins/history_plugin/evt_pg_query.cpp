@@ -7,6 +7,7 @@
 #pragma GCC diagnostic ignored "-Wunused-local-typedefs"
 
 #include <functional>
+#include <limits>
 #include <fmt/format.h>
 #include <libpq-fe.h>
 #include <boost/lexical_cast.hpp>
@@ -67,7 +68,8 @@ enum task_type {
     kGetTransaction,
     kGetTransactions,
     kGetFungibleIds,
-    kGetTransactionActions
+    kGetTransactionActions,
+    kGetTransactionDetail
 };
 
 const char* call_names[] = {
@@ -81,7 +83,8 @@ const char* call_names[] = {
     "get_transaction",
     "get_transactions",
     "get_fungible_ids",
-    "get_transaction_actions"
+    "get_transaction_actions",
+    "get_transaction_detail"
 };
 
 template<typename T>
@@ -98,6 +101,84 @@ response_ok<std::string>(int id, const std::string& str) {
     return PG_OK;
 }
 
+/**
+ * Queries of one request sent together, `done` runs after the last one of them is handled.
+ * The first failure responds the request, the results after it are dropped.
+ */
+class query_join : public std::enable_shared_from_this<query_join> {
+public:
+    query_join(int id, int type, size_t n, std::function<void()>&& done)
+        : id_(id), type_(type), pending_(n), done_(std::move(done)) {}
+
+public:
+    pg_query::step
+    wrap(pg_query::step&& f) {
+        return [self = shared_from_this(), f = std::move(f)](pg_result const* r) {
+            if(self->failed_) {
+                return;
+            }
+            try {
+                f(r);
+                if(--self->pending_ == 0) {
+                    self->done_();
+                }
+            }
+            catch(...) {
+                self->failed_ = true;
+                app().get_plugin<http_plugin>().handle_async_exception(self->id_, "history", call_names[self->type_], "");
+            }
+        };
+    }
+
+private:
+    int                   id_;
+    int                   type_;
+    size_t                pending_;
+    bool                  failed_ = false;
+    std::function<void()> done_;
+};
+
+// A cursor resumes a query right after the last row returned, whatever was written since.
+// The one of an action is 'block_num:global_seq', the block num only lets postgres skip the partitions
+// out of range, a global sequence alone is accepted as well. The one of a transaction is 'block_num:seq_num'.
+std::string
+parse_action_cursor(const std::optional<std::string>& cursor, bool asc) {
+    auto block_num = asc ? (int64_t)-1 : (int64_t)std::numeric_limits<int32_t>::max();
+    auto seq       = asc ? (int64_t)-1 : std::numeric_limits<int64_t>::max();
+    if(cursor.has_value()) {
+        auto pos = cursor->find(':');
+        try {
+            if(pos == std::string::npos) {
+                seq = boost::lexical_cast<int64_t>(*cursor);
+            }
+            else {
+                block_num = boost::lexical_cast<int32_t>(cursor->substr(0, pos));
+                seq       = boost::lexical_cast<int64_t>(cursor->substr(pos + 1));
+            }
+        }
+        catch(boost::bad_lexical_cast&) {
+            EVT_THROW(chain::invalid_query_params_exception, "Invalid cursor: ${c}", ("c",*cursor));
+        }
+    }
+    return fmt::format("{{{},{}}}", block_num, seq);
+}
+
+std::pair<int32_t, int32_t>
+parse_transaction_cursor(const std::optional<std::string>& cursor, bool asc) {
+    if(!cursor.has_value()) {
+        auto v = asc ? -1 : std::numeric_limits<int32_t>::max();
+        return std::make_pair(v, v);
+    }
+    auto pos = cursor->find(':');
+    EVT_ASSERT(pos != std::string::npos, chain::invalid_query_params_exception, "Invalid cursor: ${c}", ("c",*cursor));
+    try {
+        return std::make_pair(boost::lexical_cast<int32_t>(cursor->substr(0, pos)), boost::lexical_cast<int32_t>(cursor->substr(pos + 1)));
+    }
+    catch(boost::bad_lexical_cast&) {
+        EVT_THROW(chain::invalid_query_params_exception, "Invalid cursor: ${c}", ("c",*cursor));
+    }
+}
+
 // This function is used to fix the representation of timestamp returned by postgres
 // Use 'T' as the separate the date and time to follow the ISO 8601 standard
 char*
@@ -145,72 +226,146 @@ pg_query::prepare_stmts() {
 
 int
 pg_query::begin_poll_read() {
+#ifdef LIBPQ_HAS_PIPELINING
+    if(depth_ > 1) {
+        // from now on only asynchronous queries are sent, each followed by a sync
+        EVT_ASSERT(PQenterPipelineMode(conn_) == 1, chain::postgres_connection_exception,
+            "Enter pipeline mode failed, detail: ${d}", ("d",PQerrorMessage(conn_)));
+    }
+#else
+    depth_ = 1;  // no pipeline before libpq 14, one query in flight
+#endif
     socket_.async_wait(boost::asio::ip::tcp::socket::wait_type::wait_read, std::bind(&pg_query::poll_read, this));
     return PG_OK;
 }
 
 int
 pg_query::queue(int id, int task, std::string&& stmt) {
-    tasks_.emplace(id, task, std::move(stmt));
-    
-    if(!sending_) {
-        send_once();
-    }
+    tasks_.emplace_back(id, task, std::move(stmt));
+    send_pending();
     return PG_OK;
 }
 
 int
-pg_query::send_once() {
-    using namespace internal;
+pg_query::queue_step(int id, int task, std::string&& stmt, step&& next) {
+    tasks_.emplace_back(id, task, std::move(stmt), std::move(next));
+    send_pending();
+    return PG_OK;
+}
 
-    assert(!tasks_.empty());
-    auto& t = tasks_.front();
+int
+pg_query::queue_cached(int id, int task, std::string&& stmt, history_cache::tags_type&& tags, reader read) {
+    using namespace internal;
 
-    auto r = PQsendQuery(conn_, t.stmt.c_str());
-    if(r == 1) {
-        sending_ = true;
-        return PG_OK;
+    if(cache_ == nullptr) {
+        return queue(id, task, std::move(stmt));
     }
 
-    try {
-        EVT_THROW2(chain::postgres_send_exception,
-            "Send '{}' query command failed, try agian later, detail: {}", call_names[t.type], PQerrorMessage(conn_));
-    }
-    catch(...) {
-        app().get_plugin<http_plugin>().handle_async_exception(t.id, "history", call_names[t.type], "");
+    auto str = std::string();
+    if(cache_->get(stmt, str)) {
+        return response_ok(id, str);
     }
 
-    tasks_.pop();
-    if(!tasks_.empty()) {
-        // send next one
-        return send_once();
+    // the statement holds all the normalized params, it's the key
+    auto key = stmt;
+    auto seq = cache_->seq();
+    return queue_step(id, task, std::move(stmt), [this, id, task, key = std::move(key), tags = std::move(tags), seq, read](auto r) mutable {
+        EVT_ASSERT2(r != nullptr, chain::postgres_send_exception,
+            "Send '{}' query command failed, try agian later, detail: {}", call_names[task], PQerrorMessage(conn_));
+
+        auto str = (this->*read)(r);
+        cache_->put(std::move(key), str, std::move(tags), seq);
+        response_ok(id, str);
+    });
+}
+
+int
+pg_query::send_once(const task& t) {
+#ifdef LIBPQ_HAS_PIPELINING
+    if(depth_ > 1) {
+        // a sync after each query so a failed one does not abort the ones behind it
+        return PQsendQueryParams(conn_, t.stmt.c_str(), 0, NULL, NULL, NULL, NULL, 0) == 1 && PQpipelineSync(conn_) == 1;
+    }
+#endif
+    return PQsendQuery(conn_, t.stmt.c_str()) == 1;
+}
+
+void
+pg_query::send_pending() {
+    using namespace internal;
+
+    while(inflight_ < depth_ && inflight_ < tasks_.size()) {
+        auto it = tasks_.begin() + inflight_;
+        if(send_once(*it)) {
+            inflight_++;
+            continue;
+        }
+
+        if(it->next) {
+            // the step reports it, other queries of its request may be in flight
+            auto t = std::move(*it);
+            tasks_.erase(it);
+            try {
+                t.next(nullptr);
+            }
+            catch(...) {
+                app().get_plugin<http_plugin>().handle_async_exception(t.id, "history", call_names[t.type], "");
+            }
+            continue;
+        }
+
+        try {
+            EVT_THROW2(chain::postgres_send_exception,
+                "Send '{}' query command failed, try agian later, detail: {}", call_names[it->type], PQerrorMessage(conn_));
+        }
+        catch(...) {
+            app().get_plugin<http_plugin>().handle_async_exception(it->id, "history", call_names[it->type], "");
+        }
+        tasks_.erase(it);
     }
-    return PG_FAIL;
 }
 
 int
 pg_query::poll_read() {
     using namespace internal;
 
-    bool busy = false;
     while(1) {
         auto r = PQconsumeInput(conn_);
         EVT_ASSERT(r, chain::postgres_poll_exception, "Poll messages from postgres failed, detail: ${d}", ("d",PQerrorMessage(conn_)));
 
         if(PQisBusy(conn_)) {
-            busy = true;
+            // still needs wait next data part
             break;
         }
 
         auto re = PQgetResult(conn_);
         if(re == NULL) {
+            // ends the results of one query, in a pipeline the next ones may be ready already
+            if(depth_ > 1 && inflight_ > 0) {
+                continue;
+            }
             break;
         }
 
-        auto t = tasks_.front();
-        tasks_.pop();
+#ifdef LIBPQ_HAS_PIPELINING
+        if(PQresultStatus(re) == PGRES_PIPELINE_SYNC) {
+            PQclear(re);
+            continue;
+        }
+#endif
+
+        FC_ASSERT(inflight_ > 0, "Result received without any query in flight");
+        auto t = std::move(tasks_.front());
+        tasks_.pop_front();
+        inflight_--;
 
         try {
+            if(t.next) {
+                t.next(re);
+                PQclear(re);
+                continue;
+            }
+
             switch(t.type) {
             case kGetTokens: {
                 get_tokens_resume(t.id, re);
@@ -266,22 +421,7 @@ pg_query::poll_read() {
     }
 
     socket_.async_wait(boost::asio::ip::tcp::socket::wait_type::wait_read, std::bind(&pg_query::poll_read, this));
-    if(busy) {
-        // still needs wait next data part
-        return PG_OK;
-    }
-    if(!tasks_.empty()) {
-        // send next one
-        if(send_once() == PG_FAIL) {
-            // no send
-            FC_ASSERT(tasks_.empty(), "Tasks should be empty");
-            sending_ = false;
-        }
-        // keep sending state
-    }
-    else {  // tasks is empty
-        sending_ = false;
-    }
+    send_pending();
     return PG_OK;
 }
 
@@ -430,49 +570,49 @@ pg_query::get_fungibles_resume(int id, pg_result const* r) {
     return response_ok(id, results);
 }
 
-auto ga_plan0 = R"sql(SELECT actions.trx_id, name, domain, key, data, transactions.timestamp
+auto ga_plan0 = R"sql(SELECT actions.trx_id, name, domain, key, data, transactions.timestamp, actions.global_seq, actions.block_num
                       FROM actions
-                      JOIN transactions ON actions.trx_id = transactions.trx_id
-                      WHERE domain = $1
+                      JOIN transactions ON actions.trx_id = transactions.trx_id AND actions.block_num = transactions.block_num
+                      WHERE domain = $1 AND actions.block_num {2} ($2::bigint[])[1] AND actions.global_seq {1} ($2::bigint[])[2]
                       ORDER BY actions.global_seq {0}
-                      LIMIT $2 OFFSET $3
+                      LIMIT $3 OFFSET $4
                       )sql";
 
 // with key filter
-auto ga_plan1 = R"sql(SELECT actions.trx_id, name, domain, key, data, transactions.timestamp
+auto ga_plan1 = R"sql(SELECT actions.trx_id, name, domain, key, data, transactions.timestamp, actions.global_seq, actions.block_num
                       FROM actions
-                      JOIN transactions ON actions.trx_id = transactions.trx_id
-                      WHERE domain = $1 AND key = $2
+                      JOIN transactions ON actions.trx_id = transactions.trx_id AND actions.block_num = transactions.block_num
+                      WHERE domain = $1 AND key = $2 AND actions.block_num {2} ($3::bigint[])[1] AND actions.global_seq {1} ($3::bigint[])[2]
                       ORDER BY actions.global_seq {0}
-                      LIMIT $3 OFFSET $4
+                      LIMIT $4 OFFSET $5
                       )sql";
 
 // with name filter
-auto ga_plan2 = R"sql(SELECT actions.trx_id, name, domain, key, data, transactions.timestamp
+auto ga_plan2 = R"sql(SELECT actions.trx_id, name, domain, key, data, transactions.timestamp, actions.global_seq, actions.block_num
                       FROM actions
-                      JOIN transactions ON actions.trx_id = transactions.trx_id
-                      WHERE domain = $1 AND name = ANY($2)
+                      JOIN transactions ON actions.trx_id = transactions.trx_id AND actions.block_num = transactions.block_num
+                      WHERE domain = $1 AND name = ANY($2) AND actions.block_num {2} ($3::bigint[])[1] AND actions.global_seq {1} ($3::bigint[])[2]
                       ORDER BY actions.global_seq {0}
-                      LIMIT $3 OFFSET $4
+                      LIMIT $4 OFFSET $5
                       )sql";
 
 // with key and name filter
-auto ga_plan3 = R"sql(SELECT actions.trx_id, name, domain, key, data, transactions.timestamp
+auto ga_plan3 = R"sql(SELECT actions.trx_id, name, domain, key, data, transactions.timestamp, actions.global_seq, actions.block_num
                       FROM actions
-                      JOIN transactions ON actions.trx_id = transactions.trx_id
-                      WHERE domain = $1 AND key = $2 AND name = ANY($3)
+                      JOIN transactions ON actions.trx_id = transactions.trx_id AND actions.block_num = transactions.block_num
+                      WHERE domain = $1 AND key = $2 AND name = ANY($3) AND actions.block_num {2} ($4::bigint[])[1] AND actions.global_seq {1} ($4::bigint[])[2]
                       ORDER BY actions.global_seq {0}
-                      LIMIT $4 OFFSET $5
+                      LIMIT $5 OFFSET $6
                       )sql";
 
-PREPARE_SQL_ONCE(ga_plan01, fmt::format(ga_plan0, "DESC"));
-PREPARE_SQL_ONCE(ga_plan02, fmt::format(ga_plan0, "ASC"));
-PREPARE_SQL_ONCE(ga_plan11, fmt::format(ga_plan1, "DESC"));
-PREPARE_SQL_ONCE(ga_plan12, fmt::format(ga_plan1, "ASC"));
-PREPARE_SQL_ONCE(ga_plan21, fmt::format(ga_plan2, "DESC"));
-PREPARE_SQL_ONCE(ga_plan22, fmt::format(ga_plan2, "ASC"));
-PREPARE_SQL_ONCE(ga_plan31, fmt::format(ga_plan3, "DESC"));
-PREPARE_SQL_ONCE(ga_plan32, fmt::format(ga_plan3, "ASC"));
+PREPARE_SQL_ONCE(ga_plan01, fmt::format(ga_plan0, "DESC", "<", "<="));
+PREPARE_SQL_ONCE(ga_plan02, fmt::format(ga_plan0, "ASC", ">", ">="));
+PREPARE_SQL_ONCE(ga_plan11, fmt::format(ga_plan1, "DESC", "<", "<="));
+PREPARE_SQL_ONCE(ga_plan12, fmt::format(ga_plan1, "ASC", ">", ">="));
+PREPARE_SQL_ONCE(ga_plan21, fmt::format(ga_plan2, "DESC", "<", "<="));
+PREPARE_SQL_ONCE(ga_plan22, fmt::format(ga_plan2, "ASC", ">", ">="));
+PREPARE_SQL_ONCE(ga_plan31, fmt::format(ga_plan3, "DESC", "<", "<="));
+PREPARE_SQL_ONCE(ga_plan32, fmt::format(ga_plan3, "ASC", ">", ">="));
 
 int
 pg_query::get_actions_async(int id, const read_only::get_actions_params& params) {
@@ -500,64 +640,73 @@ pg_query::get_actions_async(int id, const read_only::get_actions_params& params)
         j += 4;
     }
 
+    auto c = parse_action_cursor(params.cursor, j & 1);
+
     switch(j) {
     case 0: { // only domain, desc
-        stmt = fmt::format(fmt("EXECUTE ga_plan01 ('{}',{},{});"), (std::string)params.domain, t, s);
+        stmt = fmt::format(fmt("EXECUTE ga_plan01 ('{}','{}',{},{});"), (std::string)params.domain, c, t, s);
         break;
     }
     case 1: { // only domain, asc
-        stmt = fmt::format(fmt("EXECUTE ga_plan02 ('{}',{},{});"), (std::string)params.domain, t, s);
+        stmt = fmt::format(fmt("EXECUTE ga_plan02 ('{}','{}',{},{});"), (std::string)params.domain, c, t, s);
         break;
     }
     case 2: { // domain + key, desc
-        stmt = fmt::format(fmt("EXECUTE ga_plan11 ('{}','{}',{},{});"), (std::string)params.domain, (std::string)*params.key, t, s);
+        stmt = fmt::format(fmt("EXECUTE ga_plan11 ('{}','{}','{}',{},{});"), (std::string)params.domain, (std::string)*params.key, c, t, s);
         break;
     }
     case 3: { // domain + key, asc
-        stmt = fmt::format(fmt("EXECUTE ga_plan12 ('{}','{}',{},{});"), (std::string)params.domain, (std::string)*params.key, t, s);
+        stmt = fmt::format(fmt("EXECUTE ga_plan12 ('{}','{}','{}',{},{});"), (std::string)params.domain, (std::string)*params.key, c, t, s);
         break;
     }
     case 4: { // domain + name, desc
         auto names_buf = fmt::memory_buffer();
         format_array_to(names_buf, std::begin(params.names), std::end(params.names));
 
-        stmt = fmt::format(fmt("EXECUTE ga_plan21 ('{}','{}',{},{});"), (std::string)params.domain, fmt::to_string(names_buf), t, s);
+        stmt = fmt::format(fmt("EXECUTE ga_plan21 ('{}','{}','{}',{},{});"), (std::string)params.domain, fmt::to_string(names_buf), c, t, s);
         break;
     }
     case 5: { // domain + name, asc
         auto names_buf = fmt::memory_buffer();
         format_array_to(names_buf, std::begin(params.names), std::end(params.names));
 
-        stmt = fmt::format(fmt("EXECUTE ga_plan22 ('{}','{}',{},{});"), (std::string)params.domain, fmt::to_string(names_buf), t, s);
+        stmt = fmt::format(fmt("EXECUTE ga_plan22 ('{}','{}','{}',{},{});"), (std::string)params.domain, fmt::to_string(names_buf), c, t, s);
         break;
     }
     case 6: { // domain + key + name, desc
         auto names_buf = fmt::memory_buffer();
         format_array_to(names_buf, std::begin(params.names), std::end(params.names));
 
-        stmt = fmt::format(fmt("EXECUTE ga_plan31 ('{}','{}','{}',{},{});"), (std::string)params.domain, (std::string)*params.key, fmt::to_string(names_buf), t, s);
+        stmt = fmt::format(fmt("EXECUTE ga_plan31 ('{}','{}','{}','{}',{},{});"), (std::string)params.domain, (std::string)*params.key, fmt::to_string(names_buf), c, t, s);
         break;
     }
     case 7: { // domain + key + name, asc
         auto names_buf = fmt::memory_buffer();
         format_array_to(names_buf, std::begin(params.names), std::end(params.names));
 
-        stmt = fmt::format(fmt("EXECUTE ga_plan32 ('{}','{}','{}',{},{});"), (std::string)params.domain, (std::string)*params.key, fmt::to_string(names_buf), t, s);
+        stmt = fmt::format(fmt("EXECUTE ga_plan32 ('{}','{}','{}','{}',{},{});"), (std::string)params.domain, (std::string)*params.key, fmt::to_string(names_buf), c, t, s);
         break;
     }
     };  // switch
 
-    return queue(id, kGetActions, std::move(stmt));
+    auto tags = params.key.has_value() ? history_cache::tags_type { history_tag::key(params.domain, *params.key) }
+                                       : history_cache::tags_type { history_tag::domain(params.domain) };
+    return queue_cached(id, kGetActions, std::move(stmt), std::move(tags), &pg_query::read_actions);
 }
 
 int
 pg_query::get_actions_resume(int id, pg_result const* r) {
+    return internal::response_ok(id, read_actions(r));
+}
+
+std::string
+pg_query::read_actions(pg_result const* r) {
     using namespace internal;
 
-    EVT_ASSERT(PQresultStatus(r) == PGRES_TUPLES_OK, chain::postgres_query_exception, "Get actions failed, detail: ${s}", ("s",PQerrorMessage(conn_)));
+    EVT_ASSERT(r != nullptr && PQresultStatus(r) == PGRES_TUPLES_OK, chain::postgres_query_exception, "Get actions failed, detail: ${s}", ("s",PQerrorMessage(conn_)));
     auto n = PQntuples(r);
     if(n == 0) {
-        return response_ok(id, std::string("[]")); // return empty
+        return "[]"; // return empty
     }
 
     auto builder = fmt::memory_buffer();
@@ -565,13 +714,15 @@ pg_query::get_actions_resume(int id, pg_result const* r) {
     fmt::format_to(builder, "[");
     for(int i = 0; i < n; i++) {
         fmt::format_to(builder,
-            fmt(R"({{"trx_id":"{}","name":"{}","domain":"{}","key":"{}","data":{},"timestamp":"{}"}})"),
+            fmt(R"({{"trx_id":"{}","name":"{}","domain":"{}","key":"{}","data":{},"timestamp":"{}","cursor":"{}:{}"}})"),
             PQgetvalue(r, i, 0),
             PQgetvalue(r, i, 1),
             PQgetvalue(r, i, 2),
             PQgetvalue(r, i, 3),
             PQgetvalue(r, i, 4),
-            fix_pg_timestamp(PQgetvalue(r, i, 5))
+            fix_pg_timestamp(PQgetvalue(r, i, 5)),
+            PQgetvalue(r, i, 7),
+            PQgetvalue(r, i, 6)
             );
         if(i < n - 1) {
             fmt::format_to(builder, ",");
@@ -579,24 +730,25 @@ pg_query::get_actions_resume(int id, pg_result const* r) {
     }
     fmt::format_to(builder, "]");
 
-    return response_ok(id, fmt::to_string(builder));
+    return fmt::to_string(builder);
 }
 
-auto gfa_plan0 = R"sql(SELECT actions.trx_id, name, domain, key, data, transactions.timestamp
+auto gfa_plan0 = R"sql(SELECT actions.trx_id, name, domain, key, data, transactions.timestamp, actions.global_seq, actions.block_num
                        FROM actions
-                       JOIN transactions ON actions.trx_id = transactions.trx_id
+                       JOIN transactions ON actions.trx_id = transactions.trx_id AND actions.block_num = transactions.block_num
                        WHERE
                            domain = '.fungible'
                            AND key = $1
                            AND name = ANY('{{"issuefungible","transferft","recycleft","evt2pevt","everipay","paybonus"}}')
-                       ORDER BY actions.created_at {0}, actions.seq_num {0}
-                       LIMIT $2 OFFSET $3
+                           AND actions.block_num {2} ($2::bigint[])[1] AND actions.global_seq {1} ($2::bigint[])[2]
+                       ORDER BY actions.global_seq {0}
+                       LIMIT $3 OFFSET $4
                        )sql";
 
 // with address filter
-auto gfa_plan1 = R"sql(SELECT actions.trx_id, name, domain, key, data, transactions.timestamp
+auto gfa_plan1 = R"sql(SELECT actions.trx_id, name, domain, key, data, transactions.timestamp, actions.global_seq, actions.block_num
                        FROM actions
-                       JOIN transactions ON actions.trx_id = transactions.trx_id
+                       JOIN transactions ON actions.trx_id = transactions.trx_id AND actions.block_num = transactions.block_num
                        WHERE
                            domain = '.fungible'
                            AND key = $1
@@ -609,14 +761,15 @@ auto gfa_plan1 = R"sql(SELECT actions.trx_id, name, domain, key, data, transacti
                                data->'link'->'keys' @> $3 OR
                                data->>'payer' = $2
                            )
-                       ORDER BY actions.created_at {0}, actions.seq_num {0}
-                       LIMIT $4 OFFSET $5
+                           AND actions.block_num {2} ($4::bigint[])[1] AND actions.global_seq {1} ($4::bigint[])[2]
+                       ORDER BY actions.global_seq {0}
+                       LIMIT $5 OFFSET $6
                        )sql";
 
-PREPARE_SQL_ONCE(gfa_plan01, fmt::format(gfa_plan0, "DESC"));
-PREPARE_SQL_ONCE(gfa_plan02, fmt::format(gfa_plan0, "ASC"));
-PREPARE_SQL_ONCE(gfa_plan11, fmt::format(gfa_plan1, "DESC"));
-PREPARE_SQL_ONCE(gfa_plan12, fmt::format(gfa_plan1, "ASC"));
+PREPARE_SQL_ONCE(gfa_plan01, fmt::format(gfa_plan0, "DESC", "<", "<="));
+PREPARE_SQL_ONCE(gfa_plan02, fmt::format(gfa_plan0, "ASC", ">", ">="));
+PREPARE_SQL_ONCE(gfa_plan11, fmt::format(gfa_plan1, "DESC", "<", "<="));
+PREPARE_SQL_ONCE(gfa_plan12, fmt::format(gfa_plan1, "ASC", ">", ">="));
 
 int
 pg_query::get_fungible_actions_async(int id, const read_only::get_fungible_actions_params& params) {
@@ -641,37 +794,47 @@ pg_query::get_fungible_actions_async(int id, const read_only::get_fungible_actio
         j += 2;
     }
 
+    auto c = parse_action_cursor(params.cursor, j & 1);
+
     switch(j) {
     case 0: { // only sym id, desc
-        stmt = fmt::format(fmt("EXECUTE gfa_plan01 ('{}',{},{});"), params.sym_id, t, s);
+        stmt = fmt::format(fmt("EXECUTE gfa_plan01 ('{}','{}',{},{});"), params.sym_id, c, t, s);
         break;
     }
     case 1: { // only sym id, asc
-        stmt = fmt::format(fmt("EXECUTE gfa_plan02 ('{}',{},{});"), params.sym_id, t, s);
+        stmt = fmt::format(fmt("EXECUTE gfa_plan02 ('{}','{}',{},{});"), params.sym_id, c, t, s);
         break;
     }
     case 2: { // sym id + address, desc
-        stmt = fmt::format(fmt("EXECUTE gfa_plan11 ('{0}','{1}','\"{1}\"',{2},{3});"), params.sym_id, (std::string)*params.addr, t, s);
+        stmt = fmt::format(fmt("EXECUTE gfa_plan11 ('{0}','{1}','\"{1}\"','{2}',{3},{4});"), params.sym_id, (std::string)*params.addr, c, t, s);
         break;
     }
     case 3: { // sym id + address, asc
-        stmt = fmt::format(fmt("EXECUTE gfa_plan12 ('{0}','{1}','\"{1}\"',{2},{3});"), params.sym_id, (std::string)*params.addr, t, s);
+        stmt = fmt::format(fmt("EXECUTE gfa_plan12 ('{0}','{1}','\"{1}\"','{2}',{3},{4});"), params.sym_id, (std::string)*params.addr, c, t, s);
         break;
     }
     };  // switch
 
-    return queue(id, kGetFungibleActions, std::move(stmt));
+    auto sym_id = std::to_string(params.sym_id);
+    auto tags   = params.addr.has_value() ? history_cache::tags_type { history_tag::address(sym_id, (std::string)*params.addr) }
+                                          : history_cache::tags_type { history_tag::key(".fungible", sym_id) };
+    return queue_cached(id, kGetFungibleActions, std::move(stmt), std::move(tags), &pg_query::read_fungible_actions);
 }
 
 int
 pg_query::get_fungible_actions_resume(int id, pg_result const* r) {
+    return internal::response_ok(id, read_fungible_actions(r));
+}
+
+std::string
+pg_query::read_fungible_actions(pg_result const* r) {
     using namespace internal;
 
-    EVT_ASSERT(PQresultStatus(r) == PGRES_TUPLES_OK, chain::postgres_query_exception, "Get fungible actions failed, detail: ${s}", ("s",PQerrorMessage(conn_)));
+    EVT_ASSERT(r != nullptr && PQresultStatus(r) == PGRES_TUPLES_OK, chain::postgres_query_exception, "Get fungible actions failed, detail: ${s}", ("s",PQerrorMessage(conn_)));
 
     auto n = PQntuples(r);
     if(n == 0) {
-        return response_ok(id, std::string("[]")); // return empty
+        return "[]"; // return empty
     }
 
     auto builder = fmt::memory_buffer();
@@ -679,13 +842,15 @@ pg_query::get_fungible_actions_resume(int id, pg_result const* r) {
     fmt::format_to(builder, "[");
     for(int i = 0; i < n; i++) {
         fmt::format_to(builder,
-            fmt(R"({{"trx_id":"{}","name":"{}","domain":"{}","key":"{}","data":{},"timestamp":"{}"}})"),
+            fmt(R"({{"trx_id":"{}","name":"{}","domain":"{}","key":"{}","data":{},"timestamp":"{}","cursor":"{}:{}"}})"),
             PQgetvalue(r, i, 0),
             PQgetvalue(r, i, 1),
             PQgetvalue(r, i, 2),
             PQgetvalue(r, i, 3),
             PQgetvalue(r, i, 4),
-            fix_pg_timestamp(PQgetvalue(r, i, 5))
+            fix_pg_timestamp(PQgetvalue(r, i, 5)),
+            PQgetvalue(r, i, 7),
+            PQgetvalue(r, i, 6)
             );
         if(i < n - 1) {
             fmt::format_to(builder, ",");
@@ -693,10 +858,11 @@ pg_query::get_fungible_actions_resume(int id, pg_result const* r) {
     }
     fmt::format_to(builder, "]");
 
-    return response_ok(id, fmt::to_string(builder));
+    return fmt::to_string(builder);
 }
 
-PREPARE_SQL_ONCE(gfb_plan, "SELECT address, sym_ids FROM ft_holders WHERE address = $1;");
+// the balances of the last irreversible block, kept by postgres_plugin
+PREPARE_SQL_ONCE(gfb_plan, "SELECT balance FROM ft_balances WHERE address = $1 ORDER BY sym_id ASC;");
 
 int
 pg_query::get_fungibles_balance_async(int id, const read_only::get_fungibles_balance_params& params) {
@@ -706,51 +872,28 @@ pg_query::get_fungibles_balance_async(int id, const read_only::get_fungibles_bal
     return queue(id, kGetFungiblesBalance, std::move(stmt));
 }
 
-#define READ_DB_ASSET(ADDR, SYM_ID, VALUEREF)                                                         \
-    try {                                                                                             \
-        auto str = std::string();                                                                     \
-        tokendb.read_asset(ADDR, SYM_ID, str);                                                        \
-                                                                                                      \
-        extract_db_value(str, VALUEREF);                                                              \
-    }                                                                                                 \
-    catch(token_database_exception&) {                                                                \
-        EVT_THROW2(balance_exception, "There's no balance left in {} with sym id: {}", ADDR, SYM_ID); \
-    }
-
 int
 pg_query::get_fungibles_balance_resume(int id, pg_result const* r) {
     using namespace internal;
-    using namespace boost::algorithm;
-    using namespace chain;
 
-    EVT_ASSERT(PQresultStatus(r) == PGRES_TUPLES_OK, chain::postgres_query_exception, "Get transaction failed, detail: ${s}", ("s",PQerrorMessage(conn_)));
+    EVT_ASSERT(PQresultStatus(r) == PGRES_TUPLES_OK, chain::postgres_query_exception, "Get fungibles balance failed, detail: ${s}", ("s",PQerrorMessage(conn_)));
 
     auto n = PQntuples(r);
     if(n == 0) {
         return response_ok(id, std::string("[]")); // return empty
     }
 
-    auto  addr    = PQgetvalue(r, 0, 0);
-    auto  arr     = PQgetvalue(r, 0, 1);
-    auto  len     = strlen(arr);
-    auto  vars    = variants();
-    auto& tokendb = chain_.token_db();
-
-    auto it = split_iterator(arr + 1, arr + len - 1, first_finder(","));
-    for(; !it.eof(); it++) {
-        auto sym_id = boost::lexical_cast<uint32_t>(it->begin(), it->size());
-
-        property prop;
-        READ_DB_ASSET(address(addr), sym_id, prop);
-
-        auto as  = asset(prop.amount, prop.sym);
-        auto var = fc::variant();
-        fc::to_variant(as, var);
-
-        vars.emplace_back(std::move(var));
+    auto builder = fmt::memory_buffer();
+    fmt::format_to(builder, "[");
+    for(int i = 0; i < n; i++) {
+        fmt::format_to(builder, fmt("\"{}\""), PQgetvalue(r, i, 0));
+        if(i < n - 1) {
+            fmt::format_to(builder, ",");
+        }
     }
+    fmt::format_to(builder, "]");
 
-    return response_ok(id, vars);
+    return response_ok(id, fmt::to_string(builder));
 }
 
 PREPARE_SQL_ONCE(gtrx_plan, "SELECT block_num, trx_id FROM transactions WHERE trx_id = $1;");
@@ -765,9 +908,14 @@ pg_query::get_transaction_async(int id, const read_only::get_transaction_params&
 
 int
 pg_query::get_transaction_resume(int id, pg_result const* r) {
+    return internal::response_ok(id, read_transaction(r));
+}
+
+fc::mutable_variant_object
+pg_query::read_transaction(pg_result const* r) {
     using namespace internal;
 
-    EVT_ASSERT(PQresultStatus(r) == PGRES_TUPLES_OK, chain::postgres_query_exception, "Get transaction failed, detail: ${s}", ("s",PQerrorMessage(conn_)));
+    EVT_ASSERT(r != nullptr && PQresultStatus(r) == PGRES_TUPLES_OK, chain::postgres_query_exception, "Get transaction failed, detail: ${s}", ("s",PQerrorMessage(conn_)));
 
     auto n = PQntuples(r);
     if(n == 0) {
@@ -794,15 +942,22 @@ pg_query::get_transaction_resume(int id, pg_result const* r) {
                 mv["block_num"] = block_num;
                 mv["block_id"]  = block->id();
 
-                return response_ok(id, mv);
+                return mv;
             }
         }
     }    
     EVT_THROW(chain::unknown_transaction_exception, "Cannot find transaction: ${t}", ("t", trx_id));
 }
 
-PREPARE_SQL_ONCE(gtrxs_plan0, "SELECT block_num, trx_id FROM transactions WHERE keys && $1 ORDER BY timestamp DESC LIMIT $2 OFFSET $3;")
-PREPARE_SQL_ONCE(gtrxs_plan1, "SELECT block_num, trx_id FROM transactions WHERE keys && $1 ORDER BY timestamp ASC  LIMIT $2 OFFSET $3;")
+auto gtrxs_plan = R"sql(SELECT block_num, trx_id, seq_num
+                        FROM transactions
+                        WHERE keys && $1 AND (block_num, seq_num) {1} ($2, $3)
+                        ORDER BY block_num {0}, seq_num {0}
+                        LIMIT $4 OFFSET $5
+                        )sql";
+
+PREPARE_SQL_ONCE(gtrxs_plan0, fmt::format(gtrxs_plan, "ASC", ">"));
+PREPARE_SQL_ONCE(gtrxs_plan1, fmt::format(gtrxs_plan, "DESC", "<"));
 
 int
 pg_query::get_transactions_async(int id, const read_only::get_transactions_params& params) {
@@ -820,26 +975,37 @@ pg_query::get_transactions_async(int id, const read_only::get_transactions_param
     auto keys_buf = fmt::memory_buffer();
     format_array_to(keys_buf, std::begin(params.keys), std::end(params.keys));
 
+    auto asc  = params.dire.has_value() && *params.dire == direction::asc;
+    auto c    = parse_transaction_cursor(params.cursor, asc);
     auto stmt = std::string();
-    if(params.dire.has_value() && *params.dire == direction::asc) {
-        stmt = fmt::format(fmt("EXECUTE gtrxs_plan0('{}',{},{});"), fmt::to_string(keys_buf), t, s);
+    if(asc) {
+        stmt = fmt::format(fmt("EXECUTE gtrxs_plan0('{}',{},{},{},{});"), fmt::to_string(keys_buf), c.first, c.second, t, s);
     }
     else {
-        stmt = fmt::format(fmt("EXECUTE gtrxs_plan1('{}',{},{});"), fmt::to_string(keys_buf), t, s);
+        stmt = fmt::format(fmt("EXECUTE gtrxs_plan1('{}',{},{},{},{});"), fmt::to_string(keys_buf), c.first, c.second, t, s);
     }
 
-    return queue(id, kGetTransactions, std::move(stmt));
+    auto tags = history_cache::tags_type();
+    for(auto& key : params.keys) {
+        tags.emplace_back(history_tag::signing_key((std::string)key));
+    }
+    return queue_cached(id, kGetTransactions, std::move(stmt), std::move(tags), &pg_query::read_transactions);
 }
 
 int
 pg_query::get_transactions_resume(int id, pg_result const* r) {
+    return internal::response_ok(id, read_transactions(r));
+}
+
+std::string
+pg_query::read_transactions(pg_result const* r) {
     using namespace internal;
 
-    EVT_ASSERT(PQresultStatus(r) == PGRES_TUPLES_OK, chain::postgres_query_exception, "Get transaction failed, detail: ${s}", ("s",PQerrorMessage(conn_)));
+    EVT_ASSERT(r != nullptr && PQresultStatus(r) == PGRES_TUPLES_OK, chain::postgres_query_exception, "Get transaction failed, detail: ${s}", ("s",PQerrorMessage(conn_)));
 
     auto n = PQntuples(r);
     if(n == 0) {
-        return response_ok(id, std::string("[]")); // return empty
+        return "[]"; // return empty
     }
 
     auto results = fc::variants();
@@ -862,13 +1028,14 @@ pg_query::get_transactions_resume(int id, pg_result const* r) {
                 auto mv = fc::mutable_variant_object(var);
                 mv["block_num"] = block_num;
                 mv["block_id"]  = block->id();
+                mv["cursor"]    = fmt::format("{}:{}", block_num, PQgetvalue(r, i, 2));
 
                 results.emplace_back(mv);
                 break;
             }
         }
     }    
-    return response_ok(id, results);
+    return fc::json::to_string(results);
 }
 
 PREPARE_SQL_ONCE(gfi_plan, "SELECT sym_id FROM fungibles ORDER BY sym_id ASC LIMIT $1 OFFSET $2;");
@@ -916,7 +1083,7 @@ pg_query::get_fungible_ids_resume(int id, pg_result const* r) {
 
 PREPARE_SQL_ONCE(gta_plan, R"sql(SELECT actions.trx_id, name, domain, key, data, transactions.timestamp
                                  FROM actions
-                                 JOIN transactions ON actions.trx_id = transactions.trx_id
+                                 JOIN transactions ON actions.trx_id = transactions.trx_id AND actions.block_num = transactions.block_num
                                  WHERE actions.trx_id = $1
                                  ORDER BY actions.seq_num ASC
                                  )sql");
@@ -931,9 +1098,14 @@ pg_query::get_transaction_actions_async(int id, const read_only::get_transaction
 
 int
 pg_query::get_transaction_actions_resume(int id, pg_result const* r) {
+    return internal::response_ok(id, read_transaction_actions(r));
+}
+
+std::string
+pg_query::read_transaction_actions(pg_result const* r) {
     using namespace internal;
 
-    EVT_ASSERT(PQresultStatus(r) == PGRES_TUPLES_OK, chain::postgres_query_exception, "Get transaction actions failed, detail: ${s}", ("s",PQerrorMessage(conn_)));
+    EVT_ASSERT(r != nullptr && PQresultStatus(r) == PGRES_TUPLES_OK, chain::postgres_query_exception, "Get transaction actions failed, detail: ${s}", ("s",PQerrorMessage(conn_)));
 
     auto n = PQntuples(r);
     if(n == 0) {
@@ -959,7 +1131,33 @@ pg_query::get_transaction_actions_resume(int id, pg_result const* r) {
     }
     fmt::format_to(builder, "]");
 
-    return response_ok(id, fmt::to_string(builder));
+    return fmt::to_string(builder);
+}
+
+int
+pg_query::get_transaction_detail_async(int id, const read_only::get_transaction_detail_params& params) {
+    using namespace internal;
+
+    struct detail {
+        fc::mutable_variant_object trx;
+        std::string                actions;
+    };
+
+    // both only depend on the id, they go out together and come back in one round trip
+    auto d    = std::make_shared<detail>();
+    auto join = std::make_shared<query_join>(id, kGetTransactionDetail, 2, [id, d] {
+        // actions are json already, they're appended as they are
+        auto str = fc::json::to_string(d->trx);
+        str.pop_back();
+        str.append(R"(,"actions":)").append(d->actions).append("}");
+        response_ok(id, str);
+    });
+
+    auto trx_id = (std::string)params.id;
+    queue_step(id, kGetTransactionDetail, fmt::format(fmt("EXECUTE gtrx_plan('{}');"), trx_id),
+        join->wrap([this, d](auto r) { d->trx = read_transaction(r); }));
+    return queue_step(id, kGetTransactionDetail, fmt::format(fmt("EXECUTE gta_plan('{}');"), trx_id),
+        join->wrap([this, d](auto r) { d->actions = read_transaction_actions(r); }));
 }
 
 }  // namepsace evt
@@ -0,0 +1,109 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#include <evt/history_plugin/history_cache.hpp>
+
+#include <algorithm>
+
+namespace evt {
+
+namespace internal {
+
+// tags remembered with their last invalidation, more than that and all the queries in flight are dropped instead
+const size_t kMaxInvalidatedTags = 65536;
+
+}  // namespace internal
+
+bool
+history_cache::get(const std::string& key, std::string& value) {
+    auto it = index_.find(key);
+    if(it == index_.end()) {
+        stats_.misses++;
+        return false;
+    }
+
+    entries_.splice(entries_.begin(), entries_, it->second);
+    value = it->second->value;
+    stats_.hits++;
+    return true;
+}
+
+void
+history_cache::put(std::string&& key, const std::string& value, tags_type&& tags, uint64_t seq) {
+    if(capacity_ == 0) {
+        return;
+    }
+
+    auto stale = seq < floor_ || std::any_of(tags.begin(), tags.end(), [&](auto& t) {
+        auto it = invalidated_.find(t);
+        return it != invalidated_.end() && it->second > seq;
+    });
+    if(stale) {
+        stats_.dropped++;
+        return;
+    }
+
+    auto it = index_.find(key);
+    if(it != index_.end()) {
+        erase(it->second);
+    }
+
+    std::sort(tags.begin(), tags.end());
+    tags.erase(std::unique(tags.begin(), tags.end()), tags.end());
+
+    entries_.emplace_front(entry { .key = std::move(key), .value = value, .tags = std::move(tags) });
+    auto e = entries_.begin();
+    index_.emplace(e->key, e);
+    for(auto& t : e->tags) {
+        auto& l = by_tag_[t];
+        e->tag_its.emplace_back(l.emplace(l.end(), e));
+    }
+
+    while(index_.size() > capacity_) {
+        erase(std::prev(entries_.end()));
+    }
+}
+
+void
+history_cache::invalidate(const tags_type& tags) {
+    seq_++;
+    if(invalidated_.size() + tags.size() > internal::kMaxInvalidatedTags) {
+        invalidated_.clear();
+        floor_ = seq_;
+    }
+
+    for(auto& t : tags) {
+        invalidated_[t] = seq_;
+
+        // the list of the tag goes away with its last entry
+        for(auto it = by_tag_.find(t); it != by_tag_.end(); it = by_tag_.find(t)) {
+            erase(it->second.front());
+        }
+    }
+}
+
+void
+history_cache::clear() {
+    seq_++;
+    floor_ = seq_;
+    invalidated_.clear();
+    by_tag_.clear();
+    index_.clear();
+    entries_.clear();
+}
+
+void
+history_cache::erase(entry_list::iterator it) {
+    for(auto i = 0u; i < it->tags.size(); i++) {
+        auto t = by_tag_.find(it->tags[i]);
+        t->second.erase(it->tag_its[i]);
+        if(t->second.empty()) {
+            by_tag_.erase(t);
+        }
+    }
+    index_.erase(it->key);
+    entries_.erase(it);
+}
+
+}  // namespace evt
@@ -0,0 +1,511 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#include <evt/history_plugin/history_index.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <boost/endian/conversion.hpp>
+#include <boost/lexical_cast.hpp>
+#include <fmt/format.h>
+#include <rocksdb/db.h>
+#include <rocksdb/options.h>
+#include <rocksdb/write_batch.h>
+#include <fc/io/json.hpp>
+#include <fc/io/raw.hpp>
+#include <fc/crypto/sha1.hpp>
+#include <evt/chain/controller.hpp>
+#include <evt/chain/exceptions.hpp>
+#include <evt/chain/execution_context_impl.hpp>
+#include <evt/chain/contracts/abi_serializer.hpp>
+#include <evt/chain/contracts/types.hpp>
+
+namespace evt {
+
+using namespace evt::chain;
+using namespace evt::chain::contracts;
+
+namespace internal {
+
+// an action as written once in the index, the indexes only point to it
+struct history_record {
+    transaction_id_type  trx_id;
+    block_timestamp_type timestamp;
+    action               act;
+};
+
+}  // namespace internal
+}  // namespace evt
+
+FC_REFLECT(evt::internal::history_record, (trx_id)(timestamp)(act));
+
+namespace evt {
+
+namespace internal {
+
+// Keys are a kind byte followed by fixed-size fields, the block num and the sequence of the action
+// in its block end them in big endian, so the entries of a domain, a key or an address are in order.
+//   'm'                                     -> last indexed block
+//   'r' block seq                           -> history_record
+//   'd' domain block seq                    -> ''
+//   'k' domain key block seq                -> ''
+//   'a' sha1(address) key block seq         -> '', fungible actions by the addresses they touch
+//   't' trx_id                              -> block
+const char kMetaKey[]    = "m";
+const char kRecordKind   = 'r';
+const char kDomainKind   = 'd';
+const char kKeyKind      = 'k';
+const char kAddressKind  = 'a';
+const char kTrxKind      = 't';
+const size_t kPosSize    = 8;
+
+void
+append_u32(std::string& s, uint32_t v) {
+    v = boost::endian::native_to_big(v);
+    s.append((const char*)&v, sizeof(v));
+}
+
+uint32_t
+read_u32(const char* p) {
+    auto v = uint32_t(0);
+    memcpy(&v, p, sizeof(v));
+    return boost::endian::big_to_native(v);
+}
+
+void
+append_name(std::string& s, const name128& n) {
+    s.append((const char*)&n.value, sizeof(n.value));
+}
+
+std::string
+record_key(uint32_t block_num, uint32_t seq) {
+    auto k = std::string(1, kRecordKind);
+    append_u32(k, block_num);
+    append_u32(k, seq);
+    return k;
+}
+
+std::string
+domain_prefix(const domain_name& domain) {
+    auto k = std::string(1, kDomainKind);
+    append_name(k, domain);
+    return k;
+}
+
+std::string
+key_prefix(const domain_name& domain, const domain_key& key) {
+    auto k = std::string(1, kKeyKind);
+    append_name(k, domain);
+    append_name(k, key);
+    return k;
+}
+
+std::string
+address_prefix(const address& addr, const domain_key& key) {
+    auto h = fc::sha1::hash(addr);
+    auto k = std::string(1, kAddressKind);
+    k.append(h.data(), h.data_size());
+    append_name(k, key);
+    return k;
+}
+
+std::string
+trx_key(const transaction_id_type& id) {
+    auto k = std::string(1, kTrxKind);
+    k.append(id.data(), id.data_size());
+    return k;
+}
+
+bool
+is_fungible_action(const action& act) {
+    if(act.domain != N128(.fungible)) {
+        return false;
+    }
+    switch((uint64_t)act.name) {
+    case N(issuefungible):
+    case N(transferft):
+    case N(recycleft):
+    case N(evt2pevt):
+    case N(everipay):
+    case N(paybonus): {
+        return true;
+    }
+    default: {
+        return false;
+    }
+    }  // switch
+}
+
+// the addresses get_fungible_actions matches the actions with
+template<typename Func>
+void
+visit_fungible_addresses(const evt_execution_context& exec_ctx, const action& act, Func&& f) {
+    switch((uint64_t)act.name) {
+    case N(issuefungible): {
+        f(act.data_as<const issuefungible&>().address);
+        break;
+    }
+    case N(transferft): {
+        auto& tf = act.data_as<const transferft&>();
+        f(tf.from);
+        f(tf.to);
+        break;
+    }
+    case N(recycleft): {
+        f(act.data_as<const recycleft&>().address);
+        break;
+    }
+    case N(evt2pevt): {
+        auto& ep = act.data_as<const evt2pevt&>();
+        f(ep.from);
+        f(ep.to);
+        break;
+    }
+    case N(everipay): {
+        exec_ctx.invoke_action<everipay>(act, [&](const auto& ep) {
+            f(ep.payee);
+            for(auto& key : ep.link.restore_keys()) {
+                f(address(key));
+            }
+        });
+        break;
+    }
+    case N(paybonus): {
+        f(act.data_as<const paybonus&>().payer);
+        break;
+    }
+    }  // switch
+}
+
+// the cursor of an action is 'block_num:seq', as returned with it
+std::optional<std::string>
+parse_cursor(const std::optional<std::string>& cursor) {
+    if(!cursor.has_value()) {
+        return std::nullopt;
+    }
+    auto pos = cursor->find(':');
+    EVT_ASSERT(pos != std::string::npos, chain::invalid_query_params_exception, "Invalid cursor: ${c}", ("c",*cursor));
+    try {
+        auto k = std::string();
+        append_u32(k, boost::lexical_cast<uint32_t>(cursor->substr(0, pos)));
+        append_u32(k, boost::lexical_cast<uint32_t>(cursor->substr(pos + 1)));
+        return k;
+    }
+    catch(boost::bad_lexical_cast&) {
+        EVT_THROW(chain::invalid_query_params_exception, "Invalid cursor: ${c}", ("c",*cursor));
+    }
+}
+
+std::pair<int, int>
+parse_page(const std::optional<int>& skip, const std::optional<int>& take) {
+    int s = 0, t = 10;
+    if(skip.has_value()) {
+        s = *skip;
+    }
+    if(take.has_value()) {
+        t = *take;
+        EVT_ASSERT(t <= 20, chain::exceed_query_limit_exception, "Exceed limit of max actions return allowed for each query, limit: 20 per query");
+    }
+    return std::make_pair(s, t);
+}
+
+}  // namespace internal
+
+history_index::history_index(const fc::path& dir, const controller& chain)
+    : chain_(chain) {
+    using namespace internal;
+
+    if(!fc::exists(dir)) {
+        fc::create_directories(dir);
+    }
+
+    auto options = rocksdb::Options();
+    options.create_if_missing = true;
+    options.IncreaseParallelism();
+
+    auto status = rocksdb::DB::Open(options, dir.to_native_ansi_path(), &db_);
+    EVT_ASSERT(status.ok(), chain::history_index_exception, "Open history index failed: ${err}", ("err", status.ToString()));
+
+    auto value = std::string();
+    status = db_->Get(rocksdb::ReadOptions(), kMetaKey, &value);
+    if(status.ok()) {
+        last_block_ = read_u32(value.data());
+    }
+    else {
+        EVT_ASSERT(status.IsNotFound(), chain::history_index_exception, "Read history index failed: ${err}", ("err", status.ToString()));
+    }
+}
+
+history_index::~history_index() {
+    stop();
+    delete db_;
+}
+
+void
+history_index::start(block_trace_bus& bus, size_t queue_size) {
+    // subscribed first, the blocks made irreversible while backfilling are skipped by the thread
+    bus_        = &bus;
+    queue_size_ = queue_size;
+    consumer_   = bus_->subscribe(queue_size_);
+
+    auto lib = chain_.last_irreversible_block_num();
+    if(last_block_ < lib) {
+        ilog("indexing the history of blocks ${f} to ${l}", ("f", last_block_ + 1)("l", lib));
+    }
+    for(auto num = last_block_ + 1; num <= lib; num++) {
+        auto block = chain_.fetch_block_by_number(num);
+        EVT_ASSERT(block, chain::history_index_exception, "Block ${n} is not in the block log, cannot index it", ("n", num));
+
+        write_block(*block);
+        if(num % 100000 == 0) {
+            ilog("indexed the history up to block ${n}", ("n", num));
+        }
+    }
+
+    thread_ = std::thread([this] { consume(); });
+}
+
+void
+history_index::stop() {
+    if(!bus_) {
+        return;
+    }
+    done_ = true;
+    bus_->unsubscribe(consumer_);
+    if(thread_.joinable()) {
+        thread_.join();
+    }
+    bus_ = nullptr;
+}
+
+void
+history_index::index_block(const signed_block& block, rocksdb::WriteBatch& batch) {
+    using namespace internal;
+
+    auto& exec_ctx  = dynamic_cast<const evt_execution_context&>(chain_.get_execution_context());
+    auto  block_num = block.block_num();
+    auto  seq       = uint32_t(0);
+
+    for(auto& tx : block.transactions) {
+        if(tx.status != transaction_receipt_header::executed) {
+            continue;
+        }
+
+        auto  id  = tx.trx.id();
+        auto& trx = tx.trx.get_transaction();
+
+        auto num = std::string();
+        append_u32(num, block_num);
+        batch.Put(trx_key(id), num);
+
+        for(auto& act : trx.actions) {
+            auto pos = std::string();
+            append_u32(pos, block_num);
+            append_u32(pos, seq);
+
+            auto rec = history_record { .trx_id = id, .timestamp = block.timestamp, .act = act };
+            auto v   = fc::raw::pack(rec);
+            batch.Put(record_key(block_num, seq), rocksdb::Slice(v.data(), v.size()));
+            batch.Put(domain_prefix(act.domain) + pos, rocksdb::Slice());
+            batch.Put(key_prefix(act.domain, act.key) + pos, rocksdb::Slice());
+
+            if(is_fungible_action(act)) {
+                visit_fungible_addresses(exec_ctx, act, [&](const address& addr) {
+                    batch.Put(address_prefix(addr, act.key) + pos, rocksdb::Slice());
+                });
+            }
+            seq++;
+        }
+    }
+}
+
+void
+history_index::write_block(const signed_block& block) {
+    using namespace internal;
+
+    auto batch = rocksdb::WriteBatch();
+    index_block(block, batch);
+
+    // the last block goes with its actions, a crash never leaves a block half indexed
+    auto num = std::string();
+    append_u32(num, block.block_num());
+    batch.Put(kMetaKey, num);
+
+    auto status = db_->Write(rocksdb::WriteOptions(), &batch);
+    EVT_ASSERT(status.ok(), chain::history_index_exception, "Write history index failed: ${err}", ("err", status.ToString()));
+
+    last_block_ = block.block_num();
+}
+
+void
+history_index::consume() {
+    auto events = std::vector<block_trace_event>();
+    try {
+        while(true) {
+            events.clear();
+            if(bus_->pop(consumer_, events, queue_size_, std::chrono::seconds(1)) == 0) {
+                if(done_) {
+                    break;
+                }
+                continue;
+            }
+
+            for(auto& e : events) {
+                if(e.kind != block_trace_event::irreversible_block || e.block->block_num <= last_block_) {
+                    continue;
+                }
+                if(e.block->block_num != last_block_ + 1) {
+                    wlog("history index misses blocks ${f} to ${l}", ("f", last_block_ + 1)("l", e.block->block_num - 1));
+                }
+                write_block(*e.block->block);
+            }
+            bus_->ack(consumer_);
+        }
+        ilog("history index thread shutdown gracefully");
+    }
+    catch(fc::exception& e) {
+        elog("FC Exception while indexing history ${e}", ("e", e.to_string()));
+    }
+    catch(std::exception& e) {
+        elog("STD Exception while indexing history ${e}", ("e", e.what()));
+    }
+    catch(...) {
+        elog("Unknown exception while indexing history");
+    }
+}
+
+// calls `f` with the positions of the entries under `prefix`, right after the cursor, until it returns false
+template<typename Func>
+void
+history_index::walk(const std::string& prefix, bool asc, const std::optional<std::string>& cursor, Func&& f) const {
+    using namespace internal;
+
+    auto c     = parse_cursor(cursor);
+    auto start = prefix + (c.has_value() ? *c : (asc ? std::string() : std::string(kPosSize, '\xff')));
+
+    auto it = std::unique_ptr<rocksdb::Iterator>(db_->NewIterator(rocksdb::ReadOptions()));
+    if(asc) {
+        it->Seek(start);
+    }
+    else {
+        it->SeekForPrev(start);
+    }
+    if(c.has_value() && it->Valid() && it->key() == start) {
+        asc ? it->Next() : it->Prev();
+    }
+
+    for(; it->Valid(); asc ? it->Next() : it->Prev()) {
+        auto k = it->key();
+        if(k.size() != prefix.size() + kPosSize || !k.starts_with(prefix)) {
+            break;
+        }
+        if(!f(read_u32(k.data() + prefix.size()), read_u32(k.data() + prefix.size() + 4))) {
+            break;
+        }
+    }
+    EVT_ASSERT(it->status().ok(), chain::history_index_exception, "Read history index failed: ${err}", ("err", it->status().ToString()));
+}
+
+std::string
+history_index::read_actions(const std::string& prefix, bool asc, const std::optional<std::string>& cursor,
+                            const std::vector<action_name>& names, int skip, int take) const {
+    using namespace internal;
+
+    auto& abi      = chain_.get_abi_serializer();
+    auto& exec_ctx = chain_.get_execution_context();
+
+    auto actions = fc::variants();
+    if(take <= 0) {
+        return fc::json::to_string(actions);
+    }
+
+    auto value = std::string();
+    walk(prefix, asc, cursor, [&](auto block_num, auto seq) {
+        auto status = db_->Get(rocksdb::ReadOptions(), record_key(block_num, seq), &value);
+        EVT_ASSERT(status.ok(), chain::history_index_exception, "Read history index failed: ${err}", ("err", status.ToString()));
+
+        auto rec = fc::raw::unpack<history_record>(value.data(), value.size());
+        if(!names.empty() && std::find(names.begin(), names.end(), rec.act.name) == names.end()) {
+            return true;
+        }
+        if(skip > 0) {
+            skip--;
+            return true;
+        }
+
+        auto& act = rec.act;
+        actions.emplace_back(fc::mutable_variant_object()
+            ("trx_id", rec.trx_id)
+            ("name", act.name)
+            ("domain", act.domain)
+            ("key", act.key)
+            ("data", abi.binary_to_variant(exec_ctx.get_acttype_name(act.name), act.data, exec_ctx))
+            ("timestamp", rec.timestamp.to_time_point())
+            ("cursor", fmt::format("{}:{}", block_num, seq)));
+        return (int)actions.size() < take;
+    });
+    return fc::json::to_string(actions);
+}
+
+std::string
+history_index::get_actions(const history_apis::read_only::get_actions_params& params) const {
+    using namespace internal;
+
+    auto [s, t] = parse_page(params.skip, params.take);
+    auto asc    = params.dire.has_value() && *params.dire == history_apis::direction::asc;
+    auto prefix = params.key.has_value() ? key_prefix(params.domain, *params.key) : domain_prefix(params.domain);
+
+    return read_actions(prefix, asc, params.cursor, params.names, s, t);
+}
+
+std::string
+history_index::get_fungible_actions(const history_apis::read_only::get_fungible_actions_params& params) const {
+    using namespace internal;
+
+    auto [s, t] = parse_page(params.skip, params.take);
+    auto asc    = params.dire.has_value() && *params.dire == history_apis::direction::asc;
+    auto key    = name128::from_number(params.sym_id);
+
+    if(params.addr.has_value()) {
+        return read_actions(address_prefix(*params.addr, key), asc, params.cursor, {}, s, t);
+    }
+
+    // all the actions on the symbol are under its key, only the fungible ones are returned
+    auto names = std::vector<action_name> { N(issuefungible), N(transferft), N(recycleft), N(evt2pevt), N(everipay), N(paybonus) };
+    return read_actions(key_prefix(N128(.fungible), key), asc, params.cursor, names, s, t);
+}
+
+fc::mutable_variant_object
+history_index::get_transaction(const history_apis::read_only::get_transaction_params& params) const {
+    using namespace internal;
+
+    auto value  = std::string();
+    auto status = db_->Get(rocksdb::ReadOptions(), trx_key(params.id), &value);
+    if(status.IsNotFound()) {
+        EVT_THROW(chain::unknown_transaction_exception, "Cannot find transaction");
+    }
+    EVT_ASSERT(status.ok(), chain::history_index_exception, "Read history index failed: ${err}", ("err", status.ToString()));
+
+    auto block_num = read_u32(value.data());
+    auto block     = chain_.fetch_block_by_number(block_num);
+    EVT_ASSERT(block, chain::unknown_transaction_exception, "Cannot find transaction: ${t}", ("t", params.id));
+
+    auto& abi      = chain_.get_abi_serializer();
+    auto& exec_ctx = chain_.get_execution_context();
+    for(auto& tx : block->transactions) {
+        if(tx.trx.id() == params.id) {
+            auto var = fc::variant();
+            abi.to_variant(tx.trx, var, exec_ctx);
+
+            auto mv = fc::mutable_variant_object(var);
+            mv["block_num"] = block_num;
+            mv["block_id"]  = block->id();
+
+            return mv;
+        }
+    }
+    EVT_THROW(chain::unknown_transaction_exception, "Cannot find transaction: ${t}", ("t", params.id));
+}
+
+}  // namespace evt
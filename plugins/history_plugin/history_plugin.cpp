@@ -1,11 +1,15 @@
 #include <evt/history_plugin/history_plugin.hpp>
 
+#include <algorithm>
+
 #include <fc/io/json.hpp>
 #include <fc/variant.hpp>
 #include <fc/variant_object.hpp>
 
 #include <evt/chain/contracts/evt_contract_abi.hpp>
 #include <evt/history_plugin/evt_pg_query.hpp>
+#include <evt/history_plugin/history_index.hpp>
+#include <evt/http_plugin/http_plugin.hpp>
 
 namespace evt {
 
@@ -13,19 +17,37 @@ static appbase::abstract_plugin& _history_plugin = app().register_plugin<history
 
 class history_plugin_impl {
 public:
-    history_plugin_impl()
-        : pg_query_(app().get_io_service(), app().get_plugin<chain_plugin>().chain()) {
-        pg_query_.connect(app().get_plugin<postgres_plugin>().connstr());
-        pg_query_.prepare_stmts();
-        pg_query_.begin_poll_read();
+    history_plugin_impl(uint32_t connections, uint32_t depth, uint32_t cache_size) {
+        if(cache_size > 0) {
+            cache_ = std::make_unique<history_cache>(cache_size);
+        }
+
+        auto& connstr = app().get_plugin<postgres_plugin>().connstr();
+        for(auto i = 0u; i < connections; i++) {
+            auto& q = pg_queries_.emplace_back(std::make_unique<pg_query>(app().get_io_service(), app().get_plugin<chain_plugin>().chain(), depth, cache_.get()));
+            q->connect(connstr);
+            q->prepare_stmts();
+            q->begin_poll_read();
+        }
     }
 
     ~history_plugin_impl() {
-        pg_query_.close();
+        for(auto& q : pg_queries_) {
+            q->close();
+        }
+    }
+
+public:
+    // all on the main thread, so the loads are read as they are
+    pg_query&
+    least_loaded() {
+        auto it = std::min_element(pg_queries_.begin(), pg_queries_.end(), [](auto& a, auto& b) { return a->load() < b->load(); });
+        return **it;
     }
 
 public:
-    pg_query pg_query_;
+    std::unique_ptr<history_cache>         cache_;
+    std::vector<std::unique_ptr<pg_query>> pg_queries_;
 };
 
 history_plugin::history_plugin() {}
@@ -33,16 +55,58 @@ history_plugin::~history_plugin() {}
 
 void
 history_plugin::set_program_options(options_description& cli, options_description& cfg) {
+    cfg.add_options()
+        ("history-pg-connections", bpo::value<uint32_t>()->default_value(4), "Connections to postgres for the history queries, each one goes to the least loaded")
+        ("history-pg-pipeline-depth", bpo::value<uint32_t>()->default_value(8),
+            "Queries in flight on each connection at once in libpq pipeline mode, 1 sends them one after another; libpq before 14 always sends one")
+        ("history-cache-size", bpo::value<uint32_t>()->default_value(4096),
+            "Results of get_actions, get_fungible_actions and get_transactions kept in memory until blocks touching them are written to postgres, 0 to disable")
+        ("history-local-index", bpo::bool_switch()->default_value(false),
+            "Without postgres, index the actions of irreversible blocks in an embedded database to serve get_actions, get_fungible_actions and get_transaction")
+        ("history-local-index-dir", bpo::value<bfs::path>()->default_value("history-index"),
+            "The location of the local history index (absolute path or relative to application data dir)")
+        ("history-local-index-queue-size", bpo::value<uint32_t>()->default_value(5120), "Events the local history index may fall behind before the chain waits for it")
+        ;
 }
 
 void
 history_plugin::plugin_initialize(const variables_map& options) {
+    connections_    = options.at("history-pg-connections").as<uint32_t>();
+    pipeline_depth_ = options.at("history-pg-pipeline-depth").as<uint32_t>();
+    cache_size_     = options.at("history-cache-size").as<uint32_t>();
+    EVT_ASSERT(connections_ > 0, chain::plugin_config_exception, "history-pg-connections should be at least 1");
+    EVT_ASSERT(pipeline_depth_ > 0, chain::plugin_config_exception, "history-pg-pipeline-depth should be at least 1");
+
+    local_index_            = options.at("history-local-index").as<bool>();
+    local_index_dir_        = options.at("history-local-index-dir").as<bfs::path>();
+    local_index_queue_size_ = options.at("history-local-index-queue-size").as<uint32_t>();
 }
 
 void
 history_plugin::plugin_startup() {
     if(app().get_plugin<postgres_plugin>().enabled()) {
-        my_.reset(new history_plugin_impl());
+        my_.reset(new history_plugin_impl(connections_, pipeline_depth_, cache_size_));
+        if(my_->cache_) {
+            // invalidated on the main thread with the queries, after the rows are visible to them
+            app().get_plugin<postgres_plugin>().set_commit_handler([this](auto&& tags) {
+                app().post(priority::high, [this, tags = std::move(tags)] {
+                    if(my_ && my_->cache_) {
+                        my_->cache_->invalidate(tags);
+                    }
+                });
+            });
+        }
+    }
+    else if(local_index_) {
+        auto dir = local_index_dir_;
+        if(dir.is_relative()) {
+            dir = app().data_dir() / dir;
+        }
+
+        auto& chain_plug = app().get_plugin<chain_plugin>();
+        index_ = std::make_unique<history_index>(dir, chain_plug.chain());
+        index_->start(chain_plug.get_block_trace_bus(), local_index_queue_size_);
+        ilog("history_plugin serving get_actions, get_fungible_actions and get_transaction from the local index");
     }
     else {
         wlog("evt::postgres_plugin configured, but no --postgres-uri specified.");
@@ -52,6 +116,12 @@ history_plugin::plugin_startup() {
 
 void
 history_plugin::plugin_shutdown() {
+    if(my_ && my_->cache_) {
+        app().get_plugin<postgres_plugin>().set_commit_handler(nullptr);
+    }
+    if(index_) {
+        index_->stop();
+    }
 }
 
 namespace history_apis {
@@ -60,77 +130,96 @@ void
 read_only::get_tokens_async(int id, const get_tokens_params& params) {
     EVT_ASSERT(plugin_.my_, chain::postgres_not_enabled_exception, "Postgres plugin is not enabled.");
 
-    plugin_.my_->pg_query_.get_tokens_async(id, params);
+    plugin_.my_->least_loaded().get_tokens_async(id, params);
 }
 
 void
 read_only::get_domains_async(int id, const get_params& params) {
     EVT_ASSERT(plugin_.my_, chain::postgres_not_enabled_exception, "Postgres plugin is not enabled.");
 
-    plugin_.my_->pg_query_.get_domains_async(id, params);
+    plugin_.my_->least_loaded().get_domains_async(id, params);
 }
 
 void
 read_only::get_groups_async(int id, const get_params& params) {
     EVT_ASSERT(plugin_.my_, chain::postgres_not_enabled_exception, "Postgres plugin is not enabled.");
 
-    plugin_.my_->pg_query_.get_groups_async(id, params);
+    plugin_.my_->least_loaded().get_groups_async(id, params);
 }
 
 void
 read_only::get_fungibles_async(int id, const get_params& params) {
     EVT_ASSERT(plugin_.my_, chain::postgres_not_enabled_exception, "Postgres plugin is not enabled.");
 
-    plugin_.my_->pg_query_.get_fungibles_async(id, params);
+    plugin_.my_->least_loaded().get_fungibles_async(id, params);
 }
 
 void
 read_only::get_actions_async(int id, const get_actions_params& params) {
+    if(plugin_.index_) {
+        app().get_plugin<http_plugin>().set_deferred_response(id, 200, plugin_.index_->get_actions(params));
+        return;
+    }
     EVT_ASSERT(plugin_.my_, chain::postgres_not_enabled_exception, "Postgres plugin is not enabled.");
 
-    plugin_.my_->pg_query_.get_actions_async(id, params);
+    plugin_.my_->least_loaded().get_actions_async(id, params);
 }
 
 void
 read_only::get_fungible_actions_async(int id, const get_fungible_actions_params& params) {
+    if(plugin_.index_) {
+        app().get_plugin<http_plugin>().set_deferred_response(id, 200, plugin_.index_->get_fungible_actions(params));
+        return;
+    }
     EVT_ASSERT(plugin_.my_, chain::postgres_not_enabled_exception, "Postgres plugin is not enabled.");
 
-    plugin_.my_->pg_query_.get_fungible_actions_async(id, params);
+    plugin_.my_->least_loaded().get_fungible_actions_async(id, params);
 }
 
 void
 read_only::get_fungibles_balance_async(int id, const get_fungibles_balance_params& params) {
     EVT_ASSERT(plugin_.my_, chain::postgres_not_enabled_exception, "Postgres plugin is not enabled.");
 
-    plugin_.my_->pg_query_.get_fungibles_balance_async(id, params);
+    plugin_.my_->least_loaded().get_fungibles_balance_async(id, params);
 }
 
 void
 read_only::get_transaction_async(int id, const get_transaction_params& params) {
+    if(plugin_.index_) {
+        app().get_plugin<http_plugin>().set_deferred_response(id, 200, fc::json::to_string(plugin_.index_->get_transaction(params)));
+        return;
+    }
     EVT_ASSERT(plugin_.my_, chain::postgres_not_enabled_exception, "Postgres plugin is not enabled.");
 
-    plugin_.my_->pg_query_.get_transaction_async(id, params);
+    plugin_.my_->least_loaded().get_transaction_async(id, params);
 }
 
 void
 read_only::get_transactions_async(int id, const get_transactions_params& params) {
     EVT_ASSERT(plugin_.my_, chain::postgres_not_enabled_exception, "Postgres plugin is not enabled.");
 
-    plugin_.my_->pg_query_.get_transactions_async(id, params);
+    plugin_.my_->least_loaded().get_transactions_async(id, params);
 }
 
 void
 read_only::get_fungible_ids_async(int id, const get_fungible_ids_params& params) {
     EVT_ASSERT(plugin_.my_, chain::postgres_not_enabled_exception, "Postgres plugin is not enabled.");
 
-    plugin_.my_->pg_query_.get_fungible_ids_async(id, params);
+    plugin_.my_->least_loaded().get_fungible_ids_async(id, params);
 }
 
 void
 read_only::get_transaction_actions_async(int id, const get_transaction_actions_params& params) {
     EVT_ASSERT(plugin_.my_, chain::postgres_not_enabled_exception, "Postgres plugin is not enabled.");
 
-    plugin_.my_->pg_query_.get_transaction_actions_async(id, params);
+    plugin_.my_->least_loaded().get_transaction_actions_async(id, params);
+}
+
+void
+read_only::get_transaction_detail_async(int id, const get_transaction_detail_params& params) {
+    EVT_ASSERT(plugin_.my_, chain::postgres_not_enabled_exception, "Postgres plugin is not enabled.");
+
+    plugin_.my_->least_loaded().get_transaction_detail_async(id, params);
 }
 
 }}  // namespace evt::history_apis
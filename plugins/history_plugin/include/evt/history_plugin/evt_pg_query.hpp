@@ -3,14 +3,17 @@
  *  @copyright defined in evt/LICENSE.txt
  */
 #pragma once
-#include <queue>
+#include <deque>
+#include <functional>
 #include <string>
 #include <boost/noncopyable.hpp>
 #include <boost/asio/io_context.hpp>
 #include <boost/asio/ip/tcp.hpp>
+#include <fc/variant_object.hpp>
 #include <evt/chain/block_state.hpp>
 #include <evt/chain/transaction.hpp>
 #include <evt/chain/contracts/types.hpp>
+#include <evt/history_plugin/history_cache.hpp>
 #include <evt/history_plugin/history_plugin.hpp>
 
 struct pg_conn;
@@ -33,21 +36,33 @@ using namespace evt::history_apis;
 
 
 class pg_query : boost::noncopyable {
+public:
+    /**
+     * Continuation of a request made of several queries, called with the result of its statement,
+     * or with null when the statement cannot be sent. It may queue the next steps, dependent queries
+     * then go out without a round trip back to the caller and independent ones share the pipeline.
+     * Steps throwing respond the request with the exception.
+     */
+    using step = std::function<void(pg_result const*)>;
+
 private:
     struct task {
     public:
-        task(int id, int type, std::string&& stmt)
-            : id(id), type(type), stmt(std::move(stmt)) {}
+        task(int id, int type, std::string&& stmt, step&& next = nullptr)
+            : id(id), type(type), stmt(std::move(stmt)), next(std::move(next)) {}
 
     public:
         int         id;
         int         type;
         std::string stmt;
+        step        next;  // called instead of the resume function of `type` when set
     };
 
 public:
-    pg_query(boost::asio::io_context& io_serv, controller& chain)
-        : conn_(nullptr), sending_(false), io_serv_(io_serv), chain_(chain), socket_(io_serv) {}
+    // up to `depth` queries are in flight at once, in a pipeline when more than one
+    // results of the actions and transactions are kept in `cache` when given, it's shared by the connections
+    pg_query(boost::asio::io_context& io_serv, controller& chain, size_t depth = 1, history_cache* cache = nullptr)
+        : conn_(nullptr), depth_(depth), inflight_(0), io_serv_(io_serv), chain_(chain), socket_(io_serv), cache_(cache) {}
 
 public:
     int connect(const std::string& conn);
@@ -55,6 +70,9 @@ public:
     int prepare_stmts();
     int begin_poll_read();
 
+    // queries queued or in flight
+    size_t load() const { return tasks_.size(); }
+
 public:
     int get_tokens_async(int id, const read_only::get_tokens_params& params);
     int get_tokens_resume(int id, pg_result const*);
@@ -89,19 +107,42 @@ public:
     int get_transaction_actions_async(int id, const read_only::get_transaction_actions_params& params);
     int get_transaction_actions_resume(int id, pg_result const*);
 
+    // transaction and its actions, both queries are sent at once
+    int get_transaction_detail_async(int id, const read_only::get_transaction_detail_params& params);
+
+public:
+    int queue_step(int id, int task, std::string&& stmt, step&& next);
+
 private:
-    int queue(int id, int task, std::string&& stmt);
-    int poll_read();
-    int send_once();
+    using reader = std::string (pg_query::*)(pg_result const*);
+
+    int  queue(int id, int task, std::string&& stmt);
+    // responds from the cache or queues the statement, its result read by `read` goes to the cache with `tags`
+    int  queue_cached(int id, int task, std::string&& stmt, history_cache::tags_type&& tags, reader read);
+    int  poll_read();
+
+    // results shared by the single queries and the steps of compound ones
+    fc::mutable_variant_object read_transaction(pg_result const* r);
+    std::string                read_transaction_actions(pg_result const* r);
+
+    // results kept in the cache
+    std::string read_actions(pg_result const* r);
+    std::string read_fungible_actions(pg_result const* r);
+    std::string read_transactions(pg_result const* r);
+
+    int  send_once(const task& t);
+    void send_pending();
 
 private:
     pg_conn* conn_;
 
-    bool                         sending_;
-    std::queue<task>             tasks_;
+    size_t                       depth_;
+    size_t                       inflight_;  // the front ones of tasks_ are sent
+    std::deque<task>             tasks_;
     boost::asio::io_context&     io_serv_;
     chain::controller&           chain_;
     boost::asio::ip::tcp::socket socket_;
+    history_cache*               cache_;
 };
 
 }  // namespace evt
\ No newline at end of file
@@ -0,0 +1,78 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <boost/noncopyable.hpp>
+
+namespace evt {
+
+/**
+ * LRU cache of the serialized results of the history queries, keyed by their statements,
+ * which hold the normalized params. Each entry has the tags of the rows it is read from
+ * (see `history_tag`) and is dropped once rows of any of them are written.
+ *
+ * A result read while rows of its tags are being committed may be older than the commit,
+ * so `put` drops the ones of queries sent before an invalidation of their tags.
+ * Not thread-safe, it's only used on the main thread.
+ */
+class history_cache : boost::noncopyable {
+public:
+    using tags_type = std::vector<std::string>;
+
+    struct stats_type {
+        uint64_t hits    = 0;
+        uint64_t misses  = 0;
+        uint64_t dropped = 0;  // results not stored as their tags were invalidated meanwhile
+    };
+
+public:
+    explicit history_cache(size_t capacity) : capacity_(capacity) {}
+
+public:
+    bool get(const std::string& key, std::string& value);
+
+    // `seq` is the one taken before the query was sent
+    void put(std::string&& key, const std::string& value, tags_type&& tags, uint64_t seq);
+
+    void invalidate(const tags_type& tags);
+    void clear();
+
+    uint64_t   seq() const { return seq_; }
+    size_t     size() const { return index_.size(); }
+    stats_type stats() const { return stats_; }
+
+private:
+    struct entry;
+    using entry_list = std::list<entry>;
+    using tag_list   = std::list<entry_list::iterator>;
+
+    struct entry {
+        std::string                     key;
+        std::string                     value;
+        tags_type                       tags;
+        std::vector<tag_list::iterator> tag_its;  // in the lists of `by_tag_`, one for each of `tags`
+    };
+
+    void erase(entry_list::iterator it);
+
+private:
+    size_t     capacity_;
+    entry_list entries_;  // most recently used first
+
+    std::unordered_map<std::string, entry_list::iterator> index_;
+    std::unordered_map<std::string, tag_list>             by_tag_;
+    std::unordered_map<std::string, uint64_t>             invalidated_;  // seq of the last invalidation of each tag
+
+    uint64_t   seq_   = 0;
+    uint64_t   floor_ = 0;  // results of queries sent before it are dropped, `invalidated_` is cleared at it
+    stats_type stats_;
+};
+
+}  // namespace evt
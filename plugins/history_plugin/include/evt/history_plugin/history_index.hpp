@@ -0,0 +1,84 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/noncopyable.hpp>
+#include <fc/filesystem.hpp>
+#include <fc/variant_object.hpp>
+#include <evt/chain/block.hpp>
+#include <evt/chain_plugin/block_trace_bus.hpp>
+#include <evt/history_plugin/history_plugin.hpp>
+
+namespace rocksdb {
+class DB;
+class WriteBatch;
+}  // namespace rocksdb
+
+namespace evt {
+
+namespace chain {
+class controller;
+}  // namespace chain
+
+/**
+ * Action history kept in an embedded RocksDB, for the nodes running without postgres
+ *
+ * The actions of the irreversible blocks are written once, by block and sequence in the block,
+ * and indexed by domain, by domain and key, and by the addresses of the fungible actions.
+ * Queries walk the indexes from a cursor, so a page costs the same wherever it starts.
+ *
+ * Only the actions of the transactions are indexed, not the ones generated while executing them,
+ * like the charges and the passive bonuses.
+ * Blocks are written by a thread of its own reading the block trace bus, queries are answered
+ * on the main thread.
+ */
+class history_index : boost::noncopyable {
+public:
+    history_index(const fc::path& dir, const chain::controller& chain);
+    ~history_index();
+
+public:
+    // indexes the blocks up to the last irreversible one missing from the index, then follows the bus
+    void start(block_trace_bus& bus, size_t queue_size);
+    void stop();
+
+    uint32_t last_block() const { return last_block_; }
+
+public:
+    std::string get_actions(const history_apis::read_only::get_actions_params& params) const;
+    std::string get_fungible_actions(const history_apis::read_only::get_fungible_actions_params& params) const;
+    fc::mutable_variant_object get_transaction(const history_apis::read_only::get_transaction_params& params) const;
+
+private:
+    void index_block(const chain::signed_block& block, rocksdb::WriteBatch& batch);
+    void write_block(const chain::signed_block& block);
+    void consume();
+
+    template<typename Func>
+    void walk(const std::string& prefix, bool asc, const std::optional<std::string>& cursor, Func&& f) const;
+
+    std::string read_actions(const std::string& prefix, bool asc, const std::optional<std::string>& cursor,
+                             const std::vector<chain::action_name>& names, int skip, int take) const;
+
+private:
+    const chain::controller& chain_;
+    rocksdb::DB*             db_ = nullptr;
+
+    std::atomic<uint32_t> last_block_ = 0;
+
+    block_trace_bus*             bus_      = nullptr;
+    block_trace_bus::consumer_id consumer_ = 0;
+    size_t                       queue_size_ = 0;
+
+    std::thread      thread_;
+    std::atomic_bool done_ = false;
+};
+
+}  // namespace evt
@@ -58,6 +58,7 @@ public:
         optional<std::string>                       key;
         std::vector<action_name>                    names;
         optional<fc::enum_type<uint8_t, direction>> dire;
+        optional<std::string>                       cursor;
         optional<int>                               skip;
         optional<int>                               take;
     };
@@ -67,6 +68,7 @@ public:
         symbol_id_type                              sym_id;
         optional<fc::enum_type<uint8_t, direction>> dire;
         optional<address>                           addr;
+        optional<std::string>                       cursor;
         optional<int>                               skip;
         optional<int>                               take; 
     };
@@ -85,6 +87,7 @@ public:
     struct get_transactions_params {
         std::vector<public_key_type>                keys;
         optional<fc::enum_type<uint8_t, direction>> dire;
+        optional<std::string>                       cursor;
         optional<int>                               skip;
         optional<int>                               take;
     };
@@ -99,6 +102,9 @@ public:
     using get_transaction_actions_params = get_transaction_params;
     void get_transaction_actions_async(int id, const get_transaction_actions_params& params);
 
+    using get_transaction_detail_params = get_transaction_params;
+    void get_transaction_detail_async(int id, const get_transaction_detail_params& params);
+
 private:
     const history_plugin& plugin_;
 };
@@ -123,7 +129,16 @@ public:
 
 private:
     std::unique_ptr<class history_plugin_impl> my_;
+    std::unique_ptr<class history_index>       index_;  // only without postgres
     friend class history_apis::read_only;
+
+    uint32_t connections_    = 4;
+    uint32_t pipeline_depth_ = 8;
+    uint32_t cache_size_     = 4096;
+
+    bool      local_index_            = false;
+    bfs::path local_index_dir_;
+    uint32_t  local_index_queue_size_ = 5120;
 };
 
 }  // namespace evt
@@ -131,9 +146,9 @@ private:
 FC_REFLECT_ENUM(evt::history_apis::direction, (asc)(desc));
 FC_REFLECT(evt::history_apis::read_only::get_params, (keys));
 FC_REFLECT(evt::history_apis::read_only::get_tokens_params, (keys)(domain));
-FC_REFLECT(evt::history_apis::read_only::get_actions_params, (domain)(key)(dire)(names)(skip)(take));
-FC_REFLECT(evt::history_apis::read_only::get_fungible_actions_params, (sym_id)(dire)(addr)(skip)(take));
+FC_REFLECT(evt::history_apis::read_only::get_actions_params, (domain)(key)(dire)(names)(cursor)(skip)(take));
+FC_REFLECT(evt::history_apis::read_only::get_fungible_actions_params, (sym_id)(dire)(addr)(cursor)(skip)(take));
 FC_REFLECT(evt::history_apis::read_only::get_fungibles_balance_params, (addr));
 FC_REFLECT(evt::history_apis::read_only::get_transaction_params, (id));
-FC_REFLECT(evt::history_apis::read_only::get_transactions_params, (keys)(dire)(skip)(take));
+FC_REFLECT(evt::history_apis::read_only::get_transactions_params, (keys)(dire)(cursor)(skip)(take));
 FC_REFLECT(evt::history_apis::read_only::get_fungible_ids_params, (skip)(take));
@@ -3,12 +3,115 @@
  *  @copyright defined in evt/LICENSE.txt
  */
 #include <boost/algorithm/string/predicate.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/thread_pool.hpp>
 #include <evt/http_client_plugin/http_client_plugin.hpp>
 #include <evt/chain/exceptions.hpp>
 #include <fstream>
+#include <map>
+#include <mutex>
 
 namespace evt {
 
+/**
+ * Idle clients grouped by host, a client keeps the connection of its last request open so
+ * taking one of the same host reuses it. Blocking posts run on its own threads.
+ */
+class http_client_pool {
+public:
+    http_client_pool(std::function<std::unique_ptr<http_client>()> factory, size_t max_idle, size_t threads)
+        : factory_(std::move(factory))
+        , max_idle_(max_idle)
+        , threads_(threads) {}
+
+public:
+    fc::variant
+    post_sync(const fc::url& dest, const fc::variant& payload, const fc::time_point& deadline) {
+        auto key    = host_key(dest);
+        auto client = acquire(key);
+        try {
+            auto r = client->post_sync(dest, payload, deadline);
+            release(key, std::move(client));
+            return r;
+        }
+        catch(...) {
+            // failed request already dropped its connection, the client is still fine
+            release(key, std::move(client));
+            throw;
+        }
+    }
+
+    void
+    post_async(const fc::url& dest, const fc::variant& payload, const fc::time_point& deadline,
+               boost::asio::io_context& ioc, http_client_plugin::response_callback cb) {
+        boost::asio::post(threads_, [this, dest, payload, deadline, &ioc, cb = std::move(cb)] {
+            auto e = fc::exception_ptr();
+            auto r = fc::variant();
+            try {
+                r = post_sync(dest, payload, deadline);
+            }
+            catch(const fc::exception& ex) {
+                e = ex.dynamic_copy_exception();
+            }
+            catch(const std::exception& ex) {
+                e = std::make_shared<fc::unhandled_exception>(FC_LOG_MESSAGE(warn, "${what}", ("what", ex.what())), std::current_exception());
+            }
+            catch(...) {
+                e = std::make_shared<fc::unhandled_exception>(FC_LOG_MESSAGE(warn, "unknown error"), std::current_exception());
+            }
+            boost::asio::post(ioc, [cb, e = std::move(e), r = std::move(r)] { cb(e, r); });
+        });
+    }
+
+    // waits for the pending posts, their callbacks are still posted
+    void
+    stop() {
+        threads_.join();
+    }
+
+private:
+    static std::string
+    host_key(const fc::url& dest) {
+        auto key = dest.proto() + "://" + (dest.host() ? *dest.host() : std::string());
+        if(dest.port()) {
+            key += ":" + std::to_string(*dest.port());
+        }
+        return key;
+    }
+
+    std::unique_ptr<http_client>
+    acquire(const std::string& key) {
+        {
+            auto lock = std::lock_guard(mtx_);
+            auto it   = idle_.find(key);
+            if(it != idle_.end() && !it->second.empty()) {
+                auto client = std::move(it->second.back());
+                it->second.pop_back();
+                return client;
+            }
+        }
+        // all busy, a new connection is better than waiting
+        return factory_();
+    }
+
+    void
+    release(const std::string& key, std::unique_ptr<http_client> client) {
+        auto lock = std::lock_guard(mtx_);
+        auto& v   = idle_[key];
+        if(v.size() < max_idle_) {
+            v.emplace_back(std::move(client));
+        }
+    }
+
+private:
+    std::function<std::unique_ptr<http_client>()> factory_;
+    size_t                                        max_idle_;
+
+    std::mutex                                                          mtx_;
+    std::map<std::string, std::vector<std::unique_ptr<http_client>>>    idle_;
+    boost::asio::thread_pool                                            threads_;
+};
+
 http_client_plugin::http_client_plugin()
     : my(new http_client()) {}
 http_client_plugin::~http_client_plugin() {}
@@ -19,15 +122,19 @@ http_client_plugin::set_program_options(options_description&, options_descriptio
         ("https-client-root-cert", boost::program_options::value<vector<string>>()->composing()->multitoken(),
             "PEM encoded trusted root certificate (or path to file containing one) used to validate any TLS connections made.  (may specify multiple times)\n")
         ("https-client-validate-peers", boost::program_options::value<bool>()->default_value(true),
-            "true: validate that the peer certificates are valid and trusted, false: ignore cert errors");
+            "true: validate that the peer certificates are valid and trusted, false: ignore cert errors")
+        ("http-client-threads", boost::program_options::value<uint16_t>()->default_value(2),
+            "Number of threads running the asynchronous requests of other plugins")
+        ("http-client-idle-connections", boost::program_options::value<uint16_t>()->default_value(4),
+            "Maximum idle connections kept alive for each host");
 }
 
 void
 http_client_plugin::plugin_initialize(const variables_map& options) {
     try {
         if(options.count("https-client-root-cert")) {
-            const std::vector<std::string> root_pems = options["https-client-root-cert"].as<std::vector<std::string>>();
-            for(const auto& root_pem : root_pems) {
+            const std::vector<std::string> pems = options["https-client-root-cert"].as<std::vector<std::string>>();
+            for(const auto& root_pem : pems) {
                 std::string pem_str = root_pem;
                 if(!boost::algorithm::starts_with(pem_str, "-----BEGIN CERTIFICATE-----\n")) {
                     try {
@@ -44,6 +151,7 @@ http_client_plugin::plugin_initialize(const variables_map& options) {
 
                 try {
                     my->add_cert(pem_str);
+                    root_pems.emplace_back(pem_str);
                 }
                 catch(const fc::exception& e) {
                     elog("Failed to read PEM : ${e} \n${pem}\n", ("pem", pem_str)("e", e.to_detail_string()));
@@ -51,17 +159,47 @@ http_client_plugin::plugin_initialize(const variables_map& options) {
             }
         }
 
-        my->set_verify_peers(options.at("https-client-validate-peers").as<bool>());
+        verify_peers = options.at("https-client-validate-peers").as<bool>();
+        my->set_verify_peers(verify_peers);
+
+        auto threads = options.at("http-client-threads").as<uint16_t>();
+        EVT_ASSERT(threads > 0, chain::plugin_config_exception, "http-client-threads ${num} must be greater than 0", ("num", threads));
+        pool = std::make_unique<http_client_pool>([this] { return create_client(); },
+            options.at("http-client-idle-connections").as<uint16_t>(), threads);
     }
     FC_LOG_AND_RETHROW();
 }
 
+std::unique_ptr<http_client>
+http_client_plugin::create_client() const {
+    auto client = std::make_unique<http_client>();
+    for(auto& pem : root_pems) {
+        client->add_cert(pem);
+    }
+    client->set_verify_peers(verify_peers);
+    return client;
+}
+
+fc::variant
+http_client_plugin::post_sync(const fc::url& dest, const fc::variant& payload, const fc::time_point& deadline) {
+    return pool->post_sync(dest, payload, deadline);
+}
+
+void
+http_client_plugin::post_async(const fc::url& dest, const fc::variant& payload, const fc::time_point& deadline,
+                               boost::asio::io_context& ioc, response_callback cb) {
+    pool->post_async(dest, payload, deadline, ioc, std::move(cb));
+}
+
 void
 http_client_plugin::plugin_startup() {
 }
 
 void
 http_client_plugin::plugin_shutdown() {
+    if(pool) {
+        pool->stop();
+    }
 }
 
 }  // namespace evt
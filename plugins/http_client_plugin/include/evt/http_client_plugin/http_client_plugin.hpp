@@ -3,6 +3,8 @@
  *  @copyright defined in evt/LICENSE.txt
  */
 #pragma once
+#include <functional>
+#include <boost/asio/io_context.hpp>
 #include <appbase/application.hpp>
 #include <fc/network/http/http_client.hpp>
 
@@ -10,7 +12,13 @@ namespace evt {
 using namespace appbase;
 using fc::http_client;
 
+class http_client_pool;
+
 class http_client_plugin : public appbase::plugin<http_client_plugin> {
+public:
+    // either `e` is set or `result` is the response
+    using response_callback = std::function<void(const fc::exception_ptr& e, const fc::variant& result)>;
+
 public:
     http_client_plugin();
     virtual ~http_client_plugin();
@@ -27,8 +35,22 @@ public:
         return *my;
     }
 
+    // a separate client trusting the same certificates, for a user keeping its own connections
+    std::unique_ptr<http_client> create_client() const;
+
+    // pooled posts, may be called from any thread, each one takes an idle connection to the host
+    // if there's one and opens a new one otherwise. Those going back to pool are kept alive.
+    fc::variant post_sync(const fc::url& dest, const fc::variant& payload, const fc::time_point& deadline = fc::time_point::maximum());
+
+    // runs on the client threads and posts `cb` to `ioc` once it's done, so the caller never blocks
+    void post_async(const fc::url& dest, const fc::variant& payload, const fc::time_point& deadline,
+                    boost::asio::io_context& ioc, response_callback cb);
+
 private:
-    std::unique_ptr<http_client> my;
+    std::unique_ptr<http_client>      my;
+    std::unique_ptr<http_client_pool> pool;
+    std::vector<std::string>          root_pems;
+    bool                              verify_peers = true;
 };
 
 }  // namespace evt
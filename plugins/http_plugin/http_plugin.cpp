@@ -4,19 +4,32 @@
  */
 #include <evt/http_plugin/http_plugin.hpp>
 
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <list>
 #include <memory>
+#include <mutex>
 #include <optional>
+#include <unordered_map>
+#include <string_view>
 #include <thread>
 #include <type_traits>
 #include <regex>
 
+#include <fc/compress/zlib.hpp>
+#include <fc/crypto/city.hpp>
 #include <fc/crypto/openssl.hpp>
 #include <fc/io/json.hpp>
 #include <fc/log/logger_config.hpp>
 #include <fc/network/ip.hpp>
 #include <fc/reflect/variant.hpp>
+#include <fc/time.hpp>
 
+#include <boost/algorithm/string.hpp>
 #include <boost/asio.hpp>
+#include <boost/asio/thread_pool.hpp>
 
 #include <websocketpp/client.hpp>
 #include <websocketpp/config/asio.hpp>
@@ -26,6 +39,10 @@
 
 #include <evt/chain/exceptions.hpp>
 #include <evt/http_plugin/local_endpoint.hpp>
+#include <evt/utilities/memory_budget.hpp>
+#include <evt/utilities/metrics.hpp>
+
+#include <zstd.h>
 
 namespace evt {
 
@@ -100,11 +117,277 @@ using websocket_server_tls_type   = websocketpp::server<https_config>;
 using websocket_server_local_type = websocketpp::server<local_config>;
 using http_connection_ptr_type    = websocketpp::server<http_config>::connection_ptr;
 using https_connection_ptr_type   = websocketpp::server<https_config>::connection_ptr;
+using local_connection_ptr_type   = websocketpp::server<local_config>::connection_ptr;
 using ssl_context_ptr             = websocketpp::lib::shared_ptr<websocketpp::lib::asio::ssl::context>;
 using io_work_t                   = boost::asio::executor_work_guard<boost::asio::io_context::executor_type>;
 
 static bool verbose_http_errors = false;
 
+// ordered by preference, the largest accepted one is used
+enum class content_encoding { identity = 0, deflate, gzip, zstd };
+
+static std::string_view
+trim(std::string_view s) {
+    while(!s.empty() && (s.front() == ' ' || s.front() == '\t')) {
+        s.remove_prefix(1);
+    }
+    while(!s.empty() && (s.back() == ' ' || s.back() == '\t')) {
+        s.remove_suffix(1);
+    }
+    return s;
+}
+
+static content_encoding
+accepted_encoding(std::string_view header) {
+    auto best = content_encoding::identity;
+    while(!header.empty()) {
+        auto end   = std::min(header.find(','), header.size());
+        auto token = header.substr(0, end);
+        header.remove_prefix(std::min(end + 1, header.size()));
+
+        auto semi = token.find(';');
+        auto name = trim(token.substr(0, semi));
+        if(semi != std::string_view::npos) {
+            // "q=0" means not acceptable
+            auto params = token.substr(semi + 1);
+            auto q      = params.find("q=");
+            if(q != std::string_view::npos && std::strtod(std::string(params.substr(q + 2)).c_str(), nullptr) <= 0) {
+                continue;
+            }
+        }
+
+        auto enc = content_encoding::identity;
+        if(name == "zstd") {
+            enc = content_encoding::zstd;
+        }
+        else if(name == "gzip" || name == "x-gzip") {
+            enc = content_encoding::gzip;
+        }
+        else if(name == "deflate") {
+            enc = content_encoding::deflate;
+        }
+        best = std::max(best, enc);
+    }
+    return best;
+}
+
+static std::string
+zstd_compress(const std::string& in, int level) {
+    // one context per http thread, reused by all the responses
+    static thread_local auto ctx = std::unique_ptr<ZSTD_CCtx, decltype(&ZSTD_freeCCtx)>(ZSTD_createCCtx(), &ZSTD_freeCCtx);
+
+    auto out = std::string(ZSTD_compressBound(in.size()), '\0');
+    auto r   = ZSTD_compressCCtx(ctx.get(), out.data(), out.size(), in.data(), in.size(), level);
+    if(ZSTD_isError(r)) {
+        return {};
+    }
+    out.resize(r);
+    return out;
+}
+
+/**
+ * LRU cache of serialized responses which never change, bounded by the total
+ * size of the keys and bodies it holds. Accessed from the http and api threads.
+ */
+class response_cache {
+public:
+    struct entry {
+        std::string body;
+        std::string etag;
+    };
+    using entry_ptr = std::shared_ptr<const entry>;
+
+public:
+    void set_capacity(size_t capacity) { capacity_ = capacity; }
+    bool enabled() const { return capacity_ > 0; }
+
+    entry_ptr
+    get(const std::string& key) {
+        auto lock = std::lock_guard(mtx_);
+        auto it   = index_.find(key);
+        if(it == index_.end()) {
+            return nullptr;
+        }
+        lru_.splice(lru_.begin(), lru_, it->second);
+        return it->second->second;
+    }
+
+    void
+    put(const std::string& key, const std::string& body) {
+        auto size = key.size() + body.size();
+        if(size > capacity_) {
+            return;
+        }
+
+        auto e  = std::make_shared<entry>();
+        e->body = body;
+        e->etag = fmt::format("\"{:016x}\"", fc::city_hash64(body.data(), body.size()));
+
+        auto lock = std::lock_guard(mtx_);
+        if(index_.find(key) != index_.end()) {
+            return;
+        }
+        lru_.emplace_front(key, std::move(e));
+        index_.emplace(key, lru_.begin());
+        size_ += size;
+
+        while(size_ > capacity_) {
+            auto& last = lru_.back();
+            size_ -= last.first.size() + last.second->body.size();
+            index_.erase(last.first);
+            lru_.pop_back();
+        }
+    }
+
+    // requests with the same parameters share one entry regardless of their formatting
+    static std::string
+    make_key(const std::string& url, const std::string& body) {
+        auto key = url + '\n';
+        try {
+            key += body.empty() ? "{}" : fc::json::minify(body);
+        }
+        catch(...) {
+            key += body;
+        }
+        return key;
+    }
+
+private:
+    using list_type = std::list<std::pair<std::string, entry_ptr>>;
+
+    std::mutex                                             mtx_;
+    list_type                                              lru_;
+    std::unordered_map<std::string, list_type::iterator>   index_;
+    size_t                                                 size_     = 0;
+    size_t                                                 capacity_ = 0;
+};
+
+struct endpoint_limits {
+    uint32_t         max_concurrency = 0;  // requests admitted and not yet answered, 0 is unlimited
+    fc::microseconds max_queue_time;       // requests still queued after this are shed, 0 waits forever
+    double           client_rate     = 0;  // requests per second from one client address, 0 is unlimited
+};
+
+/**
+ * Token buckets per client address, each refilled at `rate` per second
+ * and holding at most `burst` tokens.
+ */
+class rate_limiter {
+public:
+    void
+    set_rate(double rate) {
+        rate_  = rate;
+        burst_ = std::max(rate, 1.0);
+    }
+
+    bool
+    take(const std::string& client) {
+        if(rate_ <= 0) {
+            return true;
+        }
+
+        auto now  = fc::time_point::now();
+        auto lock = std::lock_guard(mtx_);
+        if(buckets_.size() >= max_clients) {
+            // full buckets hold no state worth keeping
+            for(auto it = buckets_.begin(); it != buckets_.end();) {
+                it = refill(it->second, now) >= burst_ ? buckets_.erase(it) : std::next(it);
+            }
+        }
+
+        auto it = buckets_.find(client);
+        if(it == buckets_.end()) {
+            it = buckets_.emplace(client, bucket{burst_, now}).first;
+        }
+        if(refill(it->second, now) < 1) {
+            return false;
+        }
+        it->second.tokens -= 1;
+        return true;
+    }
+
+private:
+    struct bucket {
+        double          tokens;
+        fc::time_point  last;
+    };
+
+    double
+    refill(bucket& b, fc::time_point now) {
+        b.tokens = std::min(burst_, b.tokens + (now - b.last).count() * rate_ / 1000000);
+        b.last   = now;
+        return b.tokens;
+    }
+
+    static constexpr size_t max_clients = 100000;
+
+    std::mutex                              mtx_;
+    std::unordered_map<std::string, bucket> buckets_;
+    double                                  rate_  = 0;
+    double                                  burst_ = 0;
+};
+
+/**
+ * Admission state and latency histogram of one endpoint.
+ * Bucket i of the histogram counts responses taking less than 2^i ms,
+ * the last bucket counts all the slower ones.
+ */
+struct endpoint_state {
+    static constexpr size_t latency_buckets = 16;
+
+    endpoint_limits limits;
+    rate_limiter    clients;
+
+    std::atomic<uint32_t> active{0};
+    std::atomic<uint64_t> served{0};
+    std::atomic<uint64_t> shed{0};
+    std::atomic<uint64_t> rate_limited{0};
+    std::atomic<uint64_t> expired{0};
+
+    std::array<std::atomic<uint64_t>, latency_buckets> latency{};
+
+    void
+    record(fc::microseconds elapsed) {
+        auto ms = (uint64_t)std::max<int64_t>(elapsed.count() / 1000, 0);
+        auto i  = size_t(0);
+        while(i < latency_buckets - 1 && ms >= (1ull << i)) {
+            i++;
+        }
+        latency[i]++;
+        served++;
+    }
+};
+
+/**
+ * Held by a request from its admission until its response is queued,
+ * releases the concurrency slot and records the latency when dropped.
+ */
+class admission_ticket {
+public:
+    admission_ticket(endpoint_state& ep)
+        : ep_(ep)
+        , start_(fc::time_point::now()) {
+        ep_.active++;
+    }
+
+    ~admission_ticket() {
+        ep_.active--;
+        ep_.record(fc::time_point::now() - start_);
+    }
+
+    bool
+    expired() const {
+        return ep_.limits.max_queue_time.count() > 0 && fc::time_point::now() - start_ > ep_.limits.max_queue_time;
+    }
+
+    endpoint_state& endpoint() const { return ep_; }
+
+private:
+    endpoint_state& ep_;
+    fc::time_point  start_;
+};
+using admission_ticket_ptr = std::shared_ptr<admission_ticket>;
+
 class http_plugin_impl {
 public:
     http_plugin_impl() {}
@@ -113,6 +396,11 @@ public:
     map<string, url_handler>          url_handlers;
     map<string, url_handler>          url_local_handlers;
     map<string, url_deferred_handler> url_deferred_handlers;
+    map<string, url_handler>          url_read_only_handlers;
+    map<string, url_cacheable_handler> url_cacheable_handlers;
+    map<string, ws_handler>           url_ws_handlers;
+    map<string, url_handler>          url_binary_handlers;
+    response_cache                    cache;
     optional<tcp::endpoint>           listen_endpoint;
     string                            access_control_allow_origin;
     string                            access_control_allow_headers;
@@ -123,11 +411,14 @@ public:
 
     vector<http_connection_ptr_type>  http_conns;
     vector<https_connection_ptr_type> https_conns;
+    vector<local_connection_ptr_type> local_conns;  // only touched from the http thread
 
     size_t http_conn_index  = 0;
     size_t https_conn_index = 0;
     size_t http_conn_count  = 0;
     size_t https_conn_count = 0;
+    size_t local_conn_index = 0;
+    size_t local_conn_count = 0;
 
     websocket_server_type server;
 
@@ -136,12 +427,61 @@ public:
     optional<io_work_t>                      server_ioc_work;
     std::atomic<int64_t>                     bytes_in_flight{0};
     int64_t                                  max_bytes_in_flight = 0;
+    std::atomic<int64_t>                     bytes_in_flight_budget{0};  // memory budget below the max, 0 for no budget
+
+    // read-only calls are executed in windows on their own pool while the main thread waits
+    uint16_t                                 read_only_threads = 0;
+    fc::microseconds                         read_only_window;
+    optional<boost::asio::thread_pool>       read_only_pool;
+
+    // responses at least this large are compressed when the client accepts it, 0 disables
+    size_t                                   compress_min_size = 0;
+    int                                      compress_level    = 0;
+    std::mutex                               read_only_mtx;
+    std::deque<std::function<void()>>        read_only_queue;
+    bool                                     read_only_scheduled = false;
+
+    optional<utilities::metrics::collector_id> metrics_collector;
+    optional<utilities::memory::component_id>  memory_component;
+
+    utilities::metrics::counter& requests_metric = utilities::metrics::registry::get().add_counter(
+        "evt_http_requests_total", "Requests received, excluding the preflight ones");
+    utilities::metrics::counter& busy_metric = utilities::metrics::registry::get().add_counter(
+        "evt_http_busy_total", "Requests refused for too many bytes in flight");
+
+    // limits keyed by "<api>/<call>", "<api>" or "*", resolved when an endpoint is added
+    map<string, endpoint_limits>                   endpoint_limit_configs;
+    std::mutex                                     endpoints_mtx;
+    map<string, std::unique_ptr<endpoint_state>>   endpoints;
+
+    // open websocket connections, only touched from the main thread
+    struct ws_connection {
+        std::function<bool(const string&)> send;
+        std::function<size_t()>            buffered_amount;
+        std::function<void(const string&)> close;
+    };
+    std::unordered_map<ws_connection_id, ws_connection> ws_conns;
+    ws_connection_id                                    next_ws_id = 0;
 
     optional<tcp::endpoint> https_listen_endpoint;
     string                  https_cert_chain;
     string                  https_key;
-
-    websocket_server_tls_type https_server;
+    string                  https_ecdsa_cert_chain;  // presented instead to the clients supporting ECDSA, optional
+    string                  https_ecdsa_key;
+    uint16_t                https_threads         = 0;
+    uint32_t                https_session_cache   = 0;
+    uint32_t                https_session_timeout = 0;  // seconds
+
+    // each thread has a server accepting on the same port, handshakes are spread over them by the kernel
+    struct https_listener {
+        std::shared_ptr<boost::asio::io_context>   ioc;
+        optional<io_work_t>                        ioc_work;
+        optional<std::thread>                      thread;
+        std::unique_ptr<websocket_server_tls_type> server;
+    };
+    vector<https_listener> https_listeners;
+    ssl_context_ptr        https_ctx;  // shared by all the connections, so their sessions resume on any thread
+    std::mutex             deferred_mtx;  // http and https slots of deferred connections, taken on several threads
 
     optional<asio::local::stream_protocol::endpoint> unix_endpoint;
     websocket_server_local_type                      unix_server;
@@ -173,41 +513,58 @@ public:
     }
 
     ssl_context_ptr
-    on_tls_init(websocketpp::connection_hdl hdl) {
-        ssl_context_ptr ctx = websocketpp::lib::make_shared<websocketpp::lib::asio::ssl::context>(asio::ssl::context::sslv23_server);
-
-        try {
-            ctx->set_options(asio::ssl::context::default_workarounds
-                | asio::ssl::context::no_sslv2
-                | asio::ssl::context::no_sslv3
-                | asio::ssl::context::no_tlsv1
-                | asio::ssl::context::no_tlsv1_1
-                | asio::ssl::context::single_dh_use);
-
-            ctx->use_certificate_chain_file(https_cert_chain);
-            ctx->use_private_key_file(https_key, asio::ssl::context::pem);
-
-            //going for the A+! Do a few more things on the native context to get ECDH in use
-
-            fc::ec_key ecdh = EC_KEY_new_by_curve_name(NID_secp384r1);
-            if(!ecdh)
-                EVT_THROW(chain::http_exception, "Failed to set NID_secp384r1");
-            if(SSL_CTX_set_tmp_ecdh(ctx->native_handle(), (EC_KEY*)ecdh) != 1)
-                EVT_THROW(chain::http_exception, "Failed to set ECDH PFS");
-
-            if(SSL_CTX_set_cipher_list(ctx->native_handle(),
-                                       "EECDH+ECDSA+AESGCM:EECDH+aRSA+AESGCM:EECDH+ECDSA+SHA384:EECDH+ECDSA+SHA256:AES256:"
-                                       "!DHE:!RSA:!AES128:!RC4:!DES:!3DES:!DSS:!SRP:!PSK:!EXP:!MD5:!LOW:!aNULL:!eNULL")
-               != 1)
-                EVT_THROW(chain::http_exception, "Failed to set HTTPS cipher list");
-        }
-        catch(const fc::exception& e) {
-            elog("https server initialization error: ${w}", ("w", e.to_detail_string()));
+    make_tls_context() {
+        auto ctx    = websocketpp::lib::make_shared<websocketpp::lib::asio::ssl::context>(asio::ssl::context::sslv23_server);
+        auto native = ctx->native_handle();
+
+        ctx->set_options(asio::ssl::context::default_workarounds
+            | asio::ssl::context::no_sslv2
+            | asio::ssl::context::no_sslv3
+            | asio::ssl::context::no_tlsv1
+            | asio::ssl::context::no_tlsv1_1
+            | asio::ssl::context::single_dh_use);
+
+        // with both, openssl picks the certificate by the signature algorithms of the client
+        ctx->use_certificate_chain_file(https_cert_chain);
+        ctx->use_private_key_file(https_key, asio::ssl::context::pem);
+        if(SSL_CTX_check_private_key(native) != 1) {
+            EVT_THROW2(chain::http_exception, "Private key {} does not match certificate {}", https_key, https_cert_chain);
         }
-        catch(std::exception& e) {
-            elog("https server initialization error: ${w}", ("w", e.what()));
+        if(!https_ecdsa_cert_chain.empty()) {
+            ctx->use_certificate_chain_file(https_ecdsa_cert_chain);
+            ctx->use_private_key_file(https_ecdsa_key, asio::ssl::context::pem);
+            if(SSL_CTX_check_private_key(native) != 1) {
+                EVT_THROW2(chain::http_exception, "Private key {} does not match certificate {}", https_ecdsa_key, https_ecdsa_cert_chain);
+            }
         }
 
+        //going for the A+! Do a few more things on the native context to get ECDH in use
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+        if(SSL_CTX_set1_curves_list(native, "X25519:P-256:P-384") != 1)
+            EVT_THROW(chain::http_exception, "Failed to set ECDH curves");
+#else
+        fc::ec_key ecdh = EC_KEY_new_by_curve_name(NID_secp384r1);
+        if(!ecdh)
+            EVT_THROW(chain::http_exception, "Failed to set NID_secp384r1");
+        if(SSL_CTX_set_tmp_ecdh(native, (EC_KEY*)ecdh) != 1)
+            EVT_THROW(chain::http_exception, "Failed to set ECDH PFS");
+#endif
+
+        if(SSL_CTX_set_cipher_list(native,
+                                   "EECDH+ECDSA+AESGCM:EECDH+aRSA+AESGCM:EECDH+ECDSA+SHA384:EECDH+ECDSA+SHA256:AES256:"
+                                   "!DHE:!RSA:!AES128:!RC4:!DES:!3DES:!DSS:!SRP:!PSK:!EXP:!MD5:!LOW:!aNULL:!eNULL")
+           != 1)
+            EVT_THROW(chain::http_exception, "Failed to set HTTPS cipher list");
+
+        // reconnecting clients skip the full handshake, by session id from the cache or by ticket,
+        // the ticket keys are made along with the context and change on restart
+        static const unsigned char sid_ctx[] = "evt-https";
+        SSL_CTX_set_session_id_context(native, sid_ctx, sizeof(sid_ctx) - 1);
+        SSL_CTX_set_session_cache_mode(native, https_session_cache > 0 ? SSL_SESS_CACHE_SERVER : SSL_SESS_CACHE_OFF);
+        SSL_CTX_sess_set_cache_size(native, https_session_cache);
+        SSL_CTX_set_timeout(native, https_session_timeout);
+        SSL_CTX_clear_options(native, SSL_OP_NO_TICKET);
+
         return ctx;
     }
 
@@ -253,6 +610,23 @@ public:
     template <typename T>
     deferred_id
     alloc_deferred_id(typename websocketpp::server<T>::connection_ptr con) {
+        if constexpr (std::is_same_v<T, local_config>) {
+            // local, counted apart as it is allocated from the http thread
+            if(local_conn_count >= max_deferred_connection_size) {
+                EVT_THROW2(chain::exceed_deferred_request, "Exceed max allowed deferred connections, max: {}", max_deferred_connection_size);
+            }
+            assert(local_conns.size() == max_deferred_connection_size);
+            for(auto i = local_conn_index; i < local_conn_index + max_deferred_connection_size; i++) {
+                auto j = i % max_deferred_connection_size;
+                if(local_conns[j] == nullptr) {
+                    local_conns[j]   = con;
+                    local_conn_index = j + 1; // next slot
+                    local_conn_count++;
+                    return j | (1 << 30);
+                }
+            }
+        }
+        auto lock = std::lock_guard(deferred_mtx);
         if(http_conn_count + https_conn_count >= max_deferred_connection_size) {
             EVT_THROW2(chain::exceed_deferred_request, "Exceed max allowed deferred connections, max: {}", max_deferred_connection_size);
         }
@@ -302,6 +676,311 @@ public:
         return true;
     }
 
+    // called from the http thread, binary calls are only served on the unix socket
+    void
+    handle_binary_request(local_connection_ptr_type con) {
+        con->append_header("Content-Type", "application/octet-stream");
+
+        auto resource    = con->get_uri()->get_resource();
+        auto handler_itr = url_binary_handlers.find(resource);
+        if(handler_itr == url_binary_handlers.end()) {
+            con->set_status(websocketpp::http::status_code::not_found);
+            return;
+        }
+
+        con->defer_http_response();
+        app().post(appbase::priority::low,
+            [this, ioc = this->server_ioc, handler_itr, resource{std::move(resource)}, body{con->get_request_body()}, con] {
+                auto cb = [ioc, con](auto code, auto response_body) {
+                    boost::asio::post(*ioc, [response_body{std::move(response_body)}, con, code]() {
+                        con->set_body(std::move(response_body));
+                        con->set_status(websocketpp::http::status_code::value(code));
+                        con->send_http_response();
+                    });
+                };
+                try {
+                    handler_itr->second(resource, body, cb);
+                }
+                catch(...) {
+                    // errors are still reported in json
+                    http_plugin::handle_exception("binary", resource.c_str(), "", cb);
+                }
+            });
+    }
+
+    // called from the http thread
+    template <typename C>
+    void
+    set_response_body(const C& con, std::string body) {
+        if(compress_min_size > 0 && body.size() >= compress_min_size) {
+            con->append_header("Vary", "Accept-Encoding");
+
+            auto out = std::string();
+            auto enc = accepted_encoding(con->get_request_header("Accept-Encoding"));
+            switch(enc) {
+            case content_encoding::zstd: {
+                out = zstd_compress(body, compress_level);
+                break;
+            }
+            case content_encoding::gzip: {
+                out = fc::gzip_compress(body);
+                break;
+            }
+            case content_encoding::deflate: {
+                out = fc::zlib_compress(body);
+                break;
+            }
+            default: {
+                break;
+            }
+            }  // switch
+
+            if(!out.empty() && out.size() < body.size()) {
+                static const char* names[] = { "identity", "deflate", "gzip", "zstd" };
+                con->append_header("Content-Encoding", names[(int)enc]);
+                body = std::move(out);
+            }
+        }
+        con->set_body(std::move(body));
+    }
+
+    // read-only calls go to the pool when there is one
+    void
+    post_read_only(std::function<void()>&& task) {
+        if(read_only_pool.has_value()) {
+            queue_read_only(std::move(task));
+        }
+        else {
+            app().post(appbase::priority::low, std::move(task));
+        }
+    }
+
+    template <typename C>
+    void
+    set_cache_headers(const C& con, const std::string& etag) {
+        con->append_header("ETag", etag);
+        con->append_header("Cache-Control", "public, max-age=31536000, immutable");
+    }
+
+    template <class T>
+    void
+    handle_cacheable_request(typename websocketpp::server<T>::connection_ptr con, std::map<string, url_cacheable_handler>::const_iterator handler_itr,
+                             std::string resource, std::string body, admission_ticket_ptr ticket) {
+        auto key = response_cache::make_key(resource, body);
+        if(auto e = cache.get(key)) {
+            set_cache_headers(con, e->etag);
+            if(con->get_request_header("If-None-Match") == e->etag) {
+                con->set_status(websocketpp::http::status_code::not_modified);
+                return;
+            }
+            if(!http_no_response) {
+                set_response_body(con, e->body);
+            }
+            con->set_status(websocketpp::http::status_code::ok);
+            return;
+        }
+
+        con->defer_http_response();
+        bytes_in_flight += body.size();
+        post_read_only(
+            [this, ioc = this->server_ioc, handler_itr, resource{std::move(resource)}, body{std::move(body)}, key{std::move(key)}, con, ticket] {
+                this->bytes_in_flight -= body.size();
+                if(shed_expired(ticket, make_response_callback<T>(ioc, con))) {
+                    return;
+                }
+                try {
+                    handler_itr->second(resource, body, [this, ioc, key, con, ticket](auto code, auto response_body, auto cacheable) {
+                        if(cacheable && code == websocketpp::http::status_code::ok) {
+                            this->cache.put(key, response_body);
+                        }
+                        this->bytes_in_flight += response_body.size();
+                        boost::asio::post(*ioc, [this, response_body{std::move(response_body)}, con, code, cacheable, key, ticket]() {
+                            size_t body_size = response_body.size();
+                            if(cacheable && code == websocketpp::http::status_code::ok) {
+                                if(auto e = this->cache.get(key)) {
+                                    this->set_cache_headers(con, e->etag);
+                                }
+                            }
+                            if(!this->http_no_response) {
+                                this->set_response_body(con, std::move(response_body));
+                            }
+                            con->set_status(websocketpp::http::status_code::value(code));
+                            con->send_http_response();
+                            this->bytes_in_flight -= body_size;
+                        });
+                    });
+                }
+                catch(...) {
+                    boost::asio::post(*ioc, [con, e = std::current_exception()] {
+                        try {
+                            std::rethrow_exception(e);
+                        }
+                        catch(...) {
+                            handle_exception<T>(con);
+                        }
+                        con->send_http_response();
+                    });
+                }
+            });
+    }
+
+    void
+    add_endpoint(const string& url) {
+        auto path = std::string_view(url);
+        if(path.substr(0, 4) == "/v1/") {
+            path.remove_prefix(4);
+        }
+        auto limits = endpoint_limits();
+        for(auto& k : { string(path), string(path.substr(0, path.find('/'))), string("*") }) {
+            auto it = endpoint_limit_configs.find(k);
+            if(it != endpoint_limit_configs.end()) {
+                limits = it->second;
+                break;
+            }
+        }
+
+        auto lock = std::lock_guard(endpoints_mtx);
+        auto& ep  = endpoints[url];
+        if(ep == nullptr) {
+            ep = std::make_unique<endpoint_state>();
+            ep->limits = limits;
+            ep->clients.set_rate(limits.client_rate);
+        }
+    }
+
+    endpoint_state*
+    find_endpoint(const string& url) {
+        auto lock = std::lock_guard(endpoints_mtx);
+        auto it   = endpoints.find(url);
+        return it != endpoints.end() ? it->second.get() : nullptr;
+    }
+
+    template <typename C>
+    void
+    reject(const C& con, websocketpp::http::status_code::value code, const char* message) {
+        error_results results{(uint16_t)code, message, error_results::error_info()};
+        con->set_body(fc::json::to_string(results));
+        con->set_status(code);
+    }
+
+    // sheds the request before its body is touched when its endpoint is saturated
+    template <class T>
+    bool
+    admit(typename websocketpp::server<T>::connection_ptr con, const string& resource, admission_ticket_ptr& ticket) {
+        auto ep = find_endpoint(resource);
+        if(ep == nullptr) {
+            return true;
+        }
+        if(ep->limits.client_rate > 0) {
+            auto ec     = boost::system::error_code();
+            auto remote = con->get_raw_socket().remote_endpoint(ec);
+            if(!ec && !ep->clients.take(remote.address().to_string())) {
+                ep->rate_limited++;
+                dlog2("429 - client {} exceeds rate limit of {}", remote.address().to_string(), resource);
+                reject(con, websocketpp::http::status_code::too_many_requests, "Too Many Requests");
+                return false;
+            }
+        }
+        if(ep->limits.max_concurrency > 0 && ep->active >= ep->limits.max_concurrency) {
+            ep->shed++;
+            dlog2("503 - too many concurrent requests of {}", resource);
+            reject(con, websocketpp::http::status_code::service_unavailable, "Service Unavailable");
+            return false;
+        }
+        ticket = std::make_shared<admission_ticket>(*ep);
+        return true;
+    }
+
+    // answers 503 instead of serving a request which waited in queue past its deadline
+    bool
+    shed_expired(const admission_ticket_ptr& ticket, const url_response_callback& cb) {
+        if(ticket == nullptr || !ticket->expired()) {
+            return false;
+        }
+        ticket->endpoint().expired++;
+        error_results results{websocketpp::http::status_code::service_unavailable, "Service Unavailable", error_results::error_info()};
+        cb(websocketpp::http::status_code::service_unavailable, fc::json::to_string(results));
+        return true;
+    }
+
+    template <class T>
+    url_response_callback
+    make_response_callback(std::shared_ptr<boost::asio::io_context> ioc, typename websocketpp::server<T>::connection_ptr con,
+                           admission_ticket_ptr ticket = nullptr) {
+        return [this, ioc{std::move(ioc)}, con, ticket{std::move(ticket)}](auto code, auto response_body) {
+            this->bytes_in_flight += response_body.size();
+            boost::asio::post(*ioc, [this, response_body{std::move(response_body)}, con, code, ticket]() {
+                size_t body_size = response_body.size();
+                if(!this->http_no_response) {
+                    this->set_response_body(con, std::move(response_body));
+                }
+                con->set_status(websocketpp::http::status_code::value(code));
+                con->send_http_response();
+                this->bytes_in_flight -= body_size;
+            });
+        };
+    }
+
+    void
+    queue_read_only(std::function<void()>&& task) {
+        auto lock = std::lock_guard(read_only_mtx);
+        read_only_queue.emplace_back(std::move(task));
+        if(!read_only_scheduled) {
+            read_only_scheduled = true;
+            app().post(appbase::priority::low, [this] { run_read_only_window(); });
+        }
+    }
+
+    // runs on the main thread: chain state cannot change while the window is open,
+    // so every call in it sees the same consistent view and they may run in parallel
+    void
+    run_read_only_window() {
+        if(!read_only_pool.has_value()) {
+            return;
+        }
+
+        auto deadline = fc::time_point::now() + read_only_window;
+        auto batch    = std::deque<std::function<void()>>();
+        do {
+            {
+                auto lock = std::lock_guard(read_only_mtx);
+                // keep each batch small so the window overruns by one batch at most
+                auto n = std::min<size_t>(read_only_queue.size(), read_only_threads * 4u);
+                std::move(read_only_queue.begin(), read_only_queue.begin() + n, std::back_inserter(batch));
+                read_only_queue.erase(read_only_queue.begin(), read_only_queue.begin() + n);
+            }
+            if(batch.empty()) {
+                break;
+            }
+
+            auto mtx     = std::mutex();
+            auto cv      = std::condition_variable();
+            auto pending = batch.size();
+            for(auto& task : batch) {
+                boost::asio::post(*read_only_pool, [&] {
+                    task();
+                    auto lock = std::lock_guard(mtx);
+                    if(--pending == 0) {
+                        cv.notify_one();
+                    }
+                });
+            }
+
+            auto lock = std::unique_lock(mtx);
+            cv.wait(lock, [&] { return pending == 0; });
+            batch.clear();
+        } while(fc::time_point::now() < deadline);
+
+        auto lock = std::lock_guard(read_only_mtx);
+        if(read_only_queue.empty()) {
+            read_only_scheduled = false;
+        }
+        else {
+            // yield to block and transaction processing before opening the next window
+            app().post(appbase::priority::low, [this] { run_read_only_window(); });
+        }
+    }
+
     template <class T>
     void
     handle_http_request(typename websocketpp::server<T>::connection_ptr con) {
@@ -330,19 +1009,75 @@ public:
                 con->set_status(websocketpp::http::status_code::ok);
                 return;
             }
+            requests_metric.add();
+
+            if constexpr (std::is_same_v<T, local_config>) {
+                if(req.get_header("Content-Type") == "application/octet-stream") {
+                    handle_binary_request(con);
+                    return;
+                }
+            }
 
             con->append_header("Content-Type", "application/json");
 
-            if(bytes_in_flight > max_bytes_in_flight) {
+            auto budget = bytes_in_flight_budget.load(std::memory_order_relaxed);
+            if(bytes_in_flight > max_bytes_in_flight || (budget > 0 && bytes_in_flight > budget)) {
                 dlog2("503 - too many bytes in flight: {:n}", bytes_in_flight.load());
+                busy_metric.add();
                 error_results results{websocketpp::http::status_code::too_many_requests, "Busy", error_results::error_info()};
                 con->set_body(fc::json::to_string(results));
                 con->set_status(websocketpp::http::status_code::too_many_requests);
                 return;
             }
 
-            auto body     = con->get_request_body();
             auto resource = con->get_uri()->get_resource();
+            auto ticket   = admission_ticket_ptr();
+            if constexpr (!std::is_same_v<T, local_config>) {
+                if(!admit<T>(con, resource, ticket)) {
+                    return;
+                }
+            }
+            auto body = con->get_request_body();
+
+            {
+                auto handler_itr = url_cacheable_handlers.find(resource);
+                if(handler_itr != url_cacheable_handlers.cend()) {
+                    handle_cacheable_request<T>(con, handler_itr, std::move(resource), std::move(body), std::move(ticket));
+                    return;
+                }
+            }
+
+            {
+                auto handler_itr = url_read_only_handlers.find(resource);
+                if(handler_itr != url_read_only_handlers.cend()) {
+                    con->defer_http_response();
+                    bytes_in_flight += body.size();
+                    queue_read_only(
+                        [this, ioc = this->server_ioc, handler_itr, resource{std::move(resource)}, body{std::move(body)}, con, ticket] {
+                            this->bytes_in_flight -= body.size();
+                            auto cb = make_response_callback<T>(ioc, con, ticket);
+                            if(shed_expired(ticket, cb)) {
+                                return;
+                            }
+                            try {
+                                handler_itr->second(resource, body, std::move(cb));
+                            }
+                            catch(...) {
+                                // connection is owned by the http thread, report from there
+                                boost::asio::post(*ioc, [con, e = std::current_exception()] {
+                                    try {
+                                        std::rethrow_exception(e);
+                                    }
+                                    catch(...) {
+                                        handle_exception<T>(con);
+                                    }
+                                    con->send_http_response();
+                                });
+                            }
+                        });
+                    return;
+                }
+            }
 
             {
                 auto handler_itr = url_handlers.find(resource);
@@ -350,22 +1085,14 @@ public:
                     con->defer_http_response();
                     bytes_in_flight += body.size();
                     app().post(appbase::priority::low,
-                        [this, ioc = this->server_ioc, handler_itr, resource{std::move(resource)}, body{std::move(body)}, con] {
+                        [this, ioc = this->server_ioc, handler_itr, resource{std::move(resource)}, body{std::move(body)}, con, ticket] {
                             this->bytes_in_flight -= body.size();
+                            auto cb = make_response_callback<T>(ioc, con, ticket);
+                            if(shed_expired(ticket, cb)) {
+                                return;
+                            }
                             try {
-                                handler_itr->second(resource, body,
-                                    [this, ioc{std::move(ioc)}, con](auto code, auto response_body) {
-                                        this->bytes_in_flight += response_body.size();
-                                        boost::asio::post(*ioc, [this, response_body{std::move(response_body)}, con, code]() {
-                                            size_t body_size = response_body.size();
-                                            if(!this->http_no_response) {
-                                                con->set_body(std::move(response_body));
-                                            }
-                                            con->set_status(websocketpp::http::status_code::value(code));
-                                            con->send_http_response();
-                                            this->bytes_in_flight -= body_size;
-                                        });
-                                    });
+                                handler_itr->second(resource, body, std::move(cb));
                             }
                             catch(...) {
                                 handle_exception<T>(con);
@@ -376,22 +1103,29 @@ public:
                 }
             }
 
-            if constexpr (!std::is_same_v<T, local_config>) {
+            {
                 // deferred connection
                 auto deferred_handler_it = url_deferred_handlers.find(resource);
                 if(deferred_handler_it != url_deferred_handlers.end()) {
                     auto id = alloc_deferred_id<T>(con); 
 
                     con->defer_http_response();
-                    con->set_close_handler([this, id](auto c) {
+                    // the response is sent from elsewhere, the ticket is released along with the connection
+                    con->set_close_handler([this, id, ticket](auto c) {
                         // clear resources
                         this->visit_connection(id, [](auto) { return false; });
                     });
 
                     bytes_in_flight += body.size();
                     app().post(appbase::priority::low,
-                        [this, deferred_handler_it, resource{std::move(resource)}, body{std::move(body)}, con, id]() {
+                        [this, deferred_handler_it, resource{std::move(resource)}, body{std::move(body)}, con, id, ticket]() {
                             this->bytes_in_flight -= body.size();
+                            if(ticket != nullptr && ticket->expired()) {
+                                ticket->endpoint().expired++;
+                                set_deferred_response(id, websocketpp::http::status_code::service_unavailable,
+                                    fc::json::to_string(error_results{websocketpp::http::status_code::service_unavailable, "Service Unavailable", error_results::error_info()}));
+                                return;
+                            }
                             try {
                                 deferred_handler_it->second(resource, body, id);
                             }
@@ -403,8 +1137,9 @@ public:
                     return;
                 }
             }
-            else {
-                // local unix socket connection
+
+            if constexpr (std::is_same_v<T, local_config>) {
+                // local only handlers
                 auto handler_itr = url_local_handlers.find(resource);
                 if(handler_itr != url_local_handlers.end()) {
                     con->defer_http_response();
@@ -415,7 +1150,7 @@ public:
                                     [this, ioc{std::move(ioc)}, con](auto code, auto response_body) {
                                         boost::asio::post(*ioc, [this, response_body{std::move(response_body)}, con, code]() {
                                             if(!this->http_no_response) {
-                                                con->set_body(std::move(response_body));
+                                                this->set_response_body(con, std::move(response_body));
                                             }
                                             con->set_status(websocketpp::http::status_code::value(code));
                                             con->send_http_response();
@@ -445,27 +1180,53 @@ public:
     template<typename FUNC>
     void
     visit_connection(deferred_id id, FUNC&& vistor) {
-        if((id & (1 << 31)) == 0) {
+        if(id & (1 << 30)) {
+            // local
+            auto index = id & ~(1u << 30);
+            FC_ASSERT(index < max_deferred_connection_size);
+            auto con = local_conns[index];
+            FC_ASSERT(con != nullptr);
+
+            if(!vistor(con)) {
+                local_conns[index] = nullptr;
+                local_conn_count--;
+            }
+        }
+        else if((id & (1 << 31)) == 0) {
             // http
             FC_ASSERT(id < max_deferred_connection_size);
-            auto con = http_conns[id];
+            auto con = http_connection_ptr_type();
+            {
+                auto lock = std::lock_guard(deferred_mtx);
+                con = http_conns[id];
+            }
             FC_ASSERT(con != nullptr);
 
             if(!vistor(con)) {
-                http_conns[id] = nullptr;
-                http_conn_count--;
+                auto lock = std::lock_guard(deferred_mtx);
+                if(http_conns[id] == con) {
+                    http_conns[id] = nullptr;
+                    http_conn_count--;
+                }
             }
         }
         else {
             // https
             auto index = id & (0xFFFFFFFF >> 1);
             FC_ASSERT(index < max_deferred_connection_size);
-            auto con = https_conns[index];
+            auto con = https_connection_ptr_type();
+            {
+                auto lock = std::lock_guard(deferred_mtx);
+                con = https_conns[index];
+            }
             FC_ASSERT(con != nullptr);
 
             if(!vistor(con)) {
-                https_conns[index] = nullptr;
-                https_conn_count--;
+                auto lock = std::lock_guard(deferred_mtx);
+                if(https_conns[index] == con) {
+                    https_conns[index] = nullptr;
+                    https_conn_count--;
+                }
             }
         }
     }
@@ -478,7 +1239,7 @@ public:
                 visit_connection(id, [this, code, body{std::move(body)}](auto con) {
                     auto body_size = body.size();
                     if(!this->http_no_response) {
-                        con->set_body(std::move(body));
+                        this->set_response_body(con, std::move(body));
                     }
                     con->set_status(websocketpp::http::status_code::value(code));
                     con->send_http_response();
@@ -493,15 +1254,34 @@ public:
 
     template <class T>
     void
-    create_server_for_endpoint(const tcp::endpoint& ep, websocketpp::server<T>& ws) {
+    create_server_for_endpoint(const tcp::endpoint& ep, websocketpp::server<T>& ws, boost::asio::io_context& ioc = app().get_io_service()) {
         try {
             ws.clear_access_channels(websocketpp::log::alevel::all);
-            ws.init_asio(&app().get_io_service());
+            ws.init_asio(&ioc);
             ws.set_reuse_addr(true);
             ws.set_max_http_body_size(max_body_size);
             ws.set_http_handler([&](connection_hdl hdl) {
                 handle_http_request<T>(ws.get_con_from_hdl(hdl));
             });
+            ws.set_validate_handler([&](connection_hdl hdl) {
+                auto con = ws.get_con_from_hdl(hdl);
+                if(url_ws_handlers.find(con->get_resource()) == url_ws_handlers.end()) {
+                    con->set_status(websocketpp::http::status_code::not_found);
+                    return false;
+                }
+                return allow_host<T>(con->get_request(), con);
+            });
+            ws.set_open_handler([&](connection_hdl hdl) {
+                if constexpr (std::is_same_v<T, https_config>) {
+                    // websocket connections are kept on the main thread
+                    app().post(appbase::priority::medium, [this, con = ws.get_con_from_hdl(hdl)] {
+                        open_ws_connection<T>(con);
+                    });
+                }
+                else {
+                    open_ws_connection<T>(ws.get_con_from_hdl(hdl));
+                }
+            });
         }
         catch(const fc::exception& e) {
             elog("http: ${e}", ("e", e.to_detail_string()));
@@ -514,6 +1294,84 @@ public:
         }
     }
 
+    template <class T>
+    void
+    open_ws_connection(typename websocketpp::server<T>::connection_ptr con) {
+        auto it = url_ws_handlers.find(con->get_resource());
+        if(it == url_ws_handlers.end()) {
+            return;
+        }
+
+        auto  id      = ++next_ws_id;
+        auto& handler = it->second;
+
+        // https connections run on the tls threads: frames are written from there and their events come back here
+        auto on_conn = [ex = con->get_raw_socket().get_executor()](auto&& f) {
+            if constexpr (std::is_same_v<T, https_config>) {
+                boost::asio::post(ex, std::move(f));
+            }
+            else {
+                f();
+            }
+        };
+        auto on_main = [](auto&& f) {
+            if constexpr (std::is_same_v<T, https_config>) {
+                app().post(appbase::priority::medium, std::move(f));
+            }
+            else {
+                f();
+            }
+        };
+
+        ws_conns.emplace(id, ws_connection {
+            [con, on_conn](const string& frame) {
+                if constexpr (std::is_same_v<T, https_config>) {
+                    // a failed write closes the connection, which is reported by the close handler
+                    on_conn([con, frame] { con->send(frame, websocketpp::frame::opcode::text); });
+                    return true;
+                }
+                else {
+                    return !con->send(frame, websocketpp::frame::opcode::text);
+                }
+            },
+            [con] { return con->get_buffered_amount(); },
+            [con, on_conn](const string& reason) {
+                on_conn([con, reason] {
+                    auto ec = websocketpp::lib::error_code();
+                    con->close(websocketpp::close::status::policy_violation, reason, ec);
+                });
+            }
+        });
+
+        con->set_message_handler([id, &handler, on_main](connection_hdl, typename websocketpp::server<T>::message_ptr msg) {
+            if(handler.on_message) {
+                on_main([id, &handler, payload = std::move(msg->get_raw_payload())]() mutable {
+                    handler.on_message(id, std::move(payload));
+                });
+            }
+        });
+        // drops the connection from ws_conns, which breaks the reference it holds
+        con->set_close_handler([this, id, &handler, on_main](connection_hdl) {
+            on_main([this, id, &handler] {
+                ws_conns.erase(id);
+                if(handler.on_close) {
+                    handler.on_close(id);
+                }
+            });
+        });
+        con->set_fail_handler([this, id, &handler, on_main](connection_hdl) {
+            on_main([this, id, &handler] {
+                if(ws_conns.erase(id) && handler.on_close) {
+                    handler.on_close(id);
+                }
+            });
+        });
+
+        if(handler.on_open) {
+            handler.on_open(id);
+        }
+    }
+
     void
     add_aliases_for_endpoint(const tcp::endpoint& ep, string host, string port) {
         auto resolved_port_str = std::to_string(ep.port());
@@ -537,6 +1395,14 @@ http_plugin::set_program_options(options_description&, options_description& cfg)
         ("https-server-address", bpo::value<string>(), "The local IP and port to listen for incoming https connections; leave blank to disable.")
         ("https-certificate-chain-file", bpo::value<string>(), "Filename with the certificate chain to present on https connections. PEM format. Required for https.")
         ("https-private-key-file", bpo::value<string>(), "Filename with https private key in PEM format. Required for https")
+        ("https-ecdsa-certificate-chain-file", bpo::value<string>(),
+            "Filename with an ECDSA certificate chain presented instead to the clients supporting it, along with the one above. PEM format.")
+        ("https-ecdsa-private-key-file", bpo::value<string>(), "Filename with the private key of the ECDSA certificate in PEM format")
+        ("https-threads", bpo::value<uint16_t>()->default_value(2),
+            "Number of threads accepting https connections and running their TLS handshakes, each one with a listener on the https port")
+        ("https-session-cache-size", bpo::value<uint32_t>()->default_value(20480),
+            "Number of TLS sessions kept for resumption by session id; 0 only resumes by session ticket")
+        ("https-session-timeout-sec", bpo::value<uint32_t>()->default_value(3600), "Seconds a TLS session or ticket can be resumed for")
         ("access-control-allow-origin", bpo::value<string>()->notifier([this](const string& v) {
             my->access_control_allow_origin = v;
             ilog("configured http with Access-Control-Allow-Origin: ${o}", ("o", my->access_control_allow_origin));
@@ -563,6 +1429,19 @@ http_plugin::set_program_options(options_description&, options_description& cfg)
         ("http-alias", bpo::value<std::vector<string>>()->composing(),
             "Additionaly acceptable values for the \"Host\" header of incoming HTTP requests, can be specified multiple times.  Includes http/s_server_address by default.")
         ("http-no-response", bpo::bool_switch()->default_value(false), "special for load-testing, response all the requests with empty body")
+        ("http-compress-min-size", bpo::value<uint32_t>()->default_value(1024),
+            "Minimum size in bytes of a response compressed for clients sending Accept-Encoding (zstd, gzip or deflate); 0 disables compression")
+        ("http-compress-level", bpo::value<int>()->default_value(3), "Compression level of zstd encoded responses")
+        ("http-cache-size-mb", bpo::value<uint32_t>()->default_value(64),
+            "Maximum size in megabytes of cached responses of irreversible chain data; 0 disables the cache")
+        ("http-read-only-threads", bpo::value<uint16_t>()->default_value(0),
+            "Number of threads serving read-only APIs in parallel; 0 serves them on the main thread")
+        ("http-read-only-window-ms", bpo::value<uint32_t>()->default_value(30),
+            "Time in milliseconds the main thread may spend serving one window of read-only API calls")
+        ("http-endpoint-limit", bpo::value<vector<string>>()->composing(),
+            "Admission limits of endpoints as <api>[/<call>]=<max-concurrency>[,<max-queue-ms>[,<client-rate>]], "
+            "e.g. history/get_actions=4,500,20. Use * for endpoints without their own limits, 0 leaves a limit off. "
+            "Can be specified multiple times.")
         ;
 }
 
@@ -633,6 +1512,12 @@ http_plugin::plugin_initialize(const variables_map& options) {
                      ("h", host)("p", port));
                 my->https_cert_chain = options.at("https-certificate-chain-file").as<string>();
                 my->https_key        = options.at("https-private-key-file").as<string>();
+                if(options.count("https-ecdsa-certificate-chain-file")) {
+                    EVT_ASSERT(options.count("https-ecdsa-private-key-file"), chain::plugin_config_exception,
+                        "https-ecdsa-private-key-file is required with https-ecdsa-certificate-chain-file");
+                    my->https_ecdsa_cert_chain = options.at("https-ecdsa-certificate-chain-file").as<string>();
+                    my->https_ecdsa_key        = options.at("https-ecdsa-private-key-file").as<string>();
+                }
             }
             catch(const boost::system::system_error& ec) {
                 elog("failed to configure https to listen on ${h}:${p} (${m})",
@@ -649,9 +1534,52 @@ http_plugin::plugin_initialize(const variables_map& options) {
         my->max_bytes_in_flight          = options.at("http-max-bytes-in-flight-mb").as<uint32_t>() * 1024 * 1024;
         my->max_deferred_connection_size = options.at("max-deferred-connection-size").as<uint32_t>();
         my->http_no_response             = options.at("http-no-response").as<bool>();
+        my->cache.set_capacity((size_t)options.at("http-cache-size-mb").as<uint32_t>() * 1024 * 1024);
+        my->compress_min_size            = options.at("http-compress-min-size").as<uint32_t>();
+        my->compress_level               = options.at("http-compress-level").as<int>();
+        my->read_only_threads            = options.at("http-read-only-threads").as<uint16_t>();
+        my->read_only_window             = fc::milliseconds(options.at("http-read-only-window-ms").as<uint32_t>());
+        my->https_threads                = options.at("https-threads").as<uint16_t>();
+        my->https_session_cache          = options.at("https-session-cache-size").as<uint32_t>();
+        my->https_session_timeout        = options.at("https-session-timeout-sec").as<uint32_t>();
+        EVT_ASSERT(my->https_threads > 0, chain::plugin_config_exception, "https-threads should be at least 1");
+#if !defined(SO_REUSEPORT)
+        if(my->https_threads > 1) {
+            wlog("https listens on a single thread, SO_REUSEPORT is not supported on this platform");
+            my->https_threads = 1;
+        }
+#endif
         verbose_http_errors              = options.at("verbose-http-errors").as<bool>();
 
-        FC_ASSERT(my->max_deferred_connection_size < std::numeric_limits<int32_t>::max());
+        if(options.count("http-endpoint-limit")) {
+            for(auto& spec : options.at("http-endpoint-limit").as<vector<string>>()) {
+                auto eq = spec.find('=');
+                EVT_ASSERT(eq != string::npos && eq > 0, chain::plugin_config_exception, "Invalid http-endpoint-limit: ${s}", ("s", spec));
+
+                auto args   = spec.substr(eq + 1);
+                auto values = vector<string>();
+                boost::split(values, args, boost::is_any_of(","));
+                EVT_ASSERT(values.size() <= 3, chain::plugin_config_exception, "Invalid http-endpoint-limit: ${s}", ("s", spec));
+
+                auto limits = endpoint_limits();
+                try {
+                    limits.max_concurrency = std::stoul(values[0]);
+                    if(values.size() > 1) {
+                        limits.max_queue_time = fc::milliseconds(std::stoul(values[1]));
+                    }
+                    if(values.size() > 2) {
+                        limits.client_rate = std::stod(values[2]);
+                    }
+                }
+                catch(const std::exception&) {
+                    EVT_THROW(chain::plugin_config_exception, "Invalid http-endpoint-limit: ${s}", ("s", spec));
+                }
+                my->endpoint_limit_configs[spec.substr(0, eq)] = limits;
+            }
+        }
+
+        // bit 31 and 30 of deferred ids tell https and local connections apart
+        FC_ASSERT(my->max_deferred_connection_size < (1 << 30));
 
         //watch out for the returns above when adding new code here
     }
@@ -660,11 +1588,23 @@ http_plugin::plugin_initialize(const variables_map& options) {
 
 void
 http_plugin::plugin_startup() {
-    my->server_ioc = std::make_shared<boost::asio::io_context>();
-    my->server_ioc_work.emplace(boost::asio::make_work_guard(*my->server_ioc));
-    my->server_thread.emplace([ioc = my->server_ioc] {
-        ioc->run();
-    });
+    auto& reactors = app().get_plugin<reactor_plugin>();
+    if(reactors.enabled()) {
+        // a single threaded reactor, handlers stay serialized as with our own thread
+        my->server_ioc = reactors.next();
+    }
+    else {
+        my->server_ioc = std::make_shared<boost::asio::io_context>();
+        my->server_ioc_work.emplace(boost::asio::make_work_guard(*my->server_ioc));
+        my->server_thread.emplace([ioc = my->server_ioc] {
+            ioc->run();
+        });
+    }
+
+    if(my->read_only_threads > 0) {
+        ilog("serving read-only apis with ${n} threads", ("n", my->read_only_threads));
+        my->read_only_pool.emplace(my->read_only_threads);
+    }
 
     if(my->listen_endpoint.has_value()) {
         try {
@@ -694,6 +1634,10 @@ http_plugin::plugin_startup() {
 
     if(my->unix_endpoint.has_value()) {
         try {
+            my->local_conns.resize(my->max_deferred_connection_size);
+            my->local_conn_index = 0;
+            my->local_conn_count = 0;
+
             my->unix_server.clear_access_channels(websocketpp::log::alevel::all);
             my->unix_server.init_asio(&(*my->server_ioc));
             my->unix_server.set_max_http_body_size(my->max_body_size);
@@ -723,14 +1667,47 @@ http_plugin::plugin_startup() {
             my->https_conn_index = 0;
             my->https_conn_count = 0;
 
-            my->create_server_for_endpoint(*my->https_listen_endpoint, my->https_server);
-            my->https_server.set_tls_init_handler([this](websocketpp::connection_hdl hdl) -> ssl_context_ptr {
-                return my->on_tls_init(hdl);
-            });
+            // made once, a bad certificate or key fails here instead of on each connection
+            my->https_ctx = my->make_tls_context();
 
-            ilog("start listening for https requests");
-            my->https_server.listen(*my->https_listen_endpoint);
-            my->https_server.start_accept();
+            for(auto i = 0u; i < my->https_threads; i++) {
+                auto& l = my->https_listeners.emplace_back();
+                if(reactors.enabled()) {
+                    l.ioc = reactors.next();
+                }
+                else {
+                    l.ioc = std::make_shared<boost::asio::io_context>();
+                    l.ioc_work.emplace(boost::asio::make_work_guard(*l.ioc));
+                    l.thread.emplace([ioc = l.ioc] {
+                        ioc->run();
+                    });
+                }
+
+                l.server = std::make_unique<websocket_server_tls_type>();
+                my->create_server_for_endpoint(*my->https_listen_endpoint, *l.server, *l.ioc);
+                l.server->set_tls_init_handler([this](websocketpp::connection_hdl) -> ssl_context_ptr {
+                    return my->https_ctx;
+                });
+#if defined(SO_REUSEPORT)
+                l.server->set_tcp_pre_bind_handler([](auto acceptor) {
+                    using reuse_port = boost::asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+                    acceptor->set_option(reuse_port(true));
+                    return websocketpp::lib::error_code();
+                });
+#endif
+                l.server->listen(*my->https_listen_endpoint);
+            }
+
+            // the handler maps are read by the tls threads without a lock, they accept once the main loop runs
+            // and the handlers added at startup are in, some of them are only added from there
+            boost::asio::post(app().get_io_service(), [this] {
+                boost::asio::post(app().get_io_service(), [this] {
+                    for(auto& l : my->https_listeners) {
+                        boost::asio::post(*l.ioc, [s = l.server.get()] { s->start_accept(); });
+                    }
+                    ilog("start listening for https requests on ${n} threads", ("n", my->https_threads));
+                });
+            });
         }
         catch(const fc::exception& e) {
             elog("https service failed to start: ${e}", ("e",e.to_detail_string()));
@@ -758,30 +1735,90 @@ http_plugin::plugin_startup() {
                 handle_exception("node", "get_supported_apis", body, cb);
             }
         }
+    }, {
+        std::string("/v1/node/get_endpoint_stats"),
+        [&](string, string body, url_response_callback cb) mutable {
+            try {
+                auto result = (*this).get_endpoint_stats();
+                cb(200, fc::json::to_string(result));
+            }
+            catch (...) {
+                handle_exception("node", "get_endpoint_stats", body, cb);
+            }
+        }
+    }, {
+        // metrics of all the plugins in the Prometheus text format
+        std::string("/v1/node/metrics"),
+        [&](string, string body, url_response_callback cb) mutable {
+            try {
+                cb(200, utilities::metrics::registry::get().format_text());
+            }
+            catch (...) {
+                handle_exception("node", "metrics", body, cb);
+            }
+        }
     }});
+
+    my->metrics_collector = utilities::metrics::registry::get().add_collector([this](auto& w) {
+        w.gauge("evt_http_bytes_in_flight", "Bytes of requests and responses being handled", my->bytes_in_flight.load());
+        w.gauge("evt_http_max_bytes_in_flight", "Limit of bytes in flight, requests above it are refused", my->max_bytes_in_flight);
+
+        auto lock = std::unique_lock<std::mutex>(my->read_only_mtx);
+        w.gauge("evt_http_read_only_queue", "Read-only calls waiting for their window", my->read_only_queue.size());
+    });
+
+    // requests are refused with 429 above the budget, the same as above the max bytes in flight
+    my->memory_component = utilities::memory::accountant::get().add_component("http_in_flight", [this](auto& u) {
+        u.bytes = my->bytes_in_flight.load();
+    }, [this](auto& u) {
+        my->bytes_in_flight_budget = (int64_t)u.budget;
+    });
 }
 
 void
 http_plugin::plugin_shutdown() {
+    if(my->metrics_collector.has_value()) {
+        utilities::metrics::registry::get().remove_collector(*my->metrics_collector);
+    }
+    if(my->memory_component.has_value()) {
+        utilities::memory::accountant::get().remove_component(*my->memory_component);
+    }
     if(my->server.is_listening()) {
         my->server.stop_listening();
     }
     if(my->unix_server.is_listening()) {
         my->unix_server.stop_listening();
     }
-    if(my->https_server.is_listening()) {
-        my->https_server.stop_listening();
+    for(auto& l : my->https_listeners) {
+        if(l.server && l.server->is_listening()) {
+            l.server->stop_listening();
+        }
+    }
+    if(my->read_only_pool.has_value()) {
+        my->read_only_pool->stop();
+        my->read_only_pool->join();
+        my->read_only_pool.reset();
     }
     if(my->server_ioc_work.has_value()) {
         my->server_ioc_work->reset();
     }
-    if(my->server_ioc) {
+    if(my->server_ioc && my->server_thread.has_value()) {
+        // a shared reactor is stopped by reactor_plugin
         my->server_ioc->stop();
     }
     if(my->server_thread.has_value()) {
         my->server_thread->join();
         my->server_thread.reset();
     }
+    for(auto& l : my->https_listeners) {
+        if(l.thread.has_value()) {
+            // a shared reactor is stopped by reactor_plugin
+            l.ioc_work.reset();
+            l.ioc->stop();
+            l.thread->join();
+            l.thread.reset();
+        }
+    }
 }
 
 void
@@ -793,6 +1830,7 @@ http_plugin::add_handler(const string& url, const url_handler& handler, bool loc
         ilog("add local only api url: ${c}", ("c", url));
     }
     if(!local_only) {
+        my->add_endpoint(url);
         my->url_handlers.insert(std::make_pair(url, handler));
     }
     else {
@@ -803,9 +1841,77 @@ http_plugin::add_handler(const string& url, const url_handler& handler, bool loc
     }
 }
 
+void
+http_plugin::add_binary_handler(const string& url, const url_handler& handler) {
+    ilog("add binary api url: ${c}", ("c", url));
+    if(!my->unix_endpoint) {
+        wlog("Unix server is not enabled, binary ${u} API cannot be used", ("u",url));
+    }
+    my->url_binary_handlers.insert(std::make_pair(url, handler));
+}
+
+void
+http_plugin::add_ws_handler(const string& url, const ws_handler& handler) {
+    ilog("add websocket url: ${c}", ("c", url));
+    my->url_ws_handlers.insert(std::make_pair(url, handler));
+}
+
+bool
+http_plugin::ws_send(ws_connection_id id, const string& frame) {
+    auto it = my->ws_conns.find(id);
+    if(it == my->ws_conns.end()) {
+        return false;
+    }
+    return it->second.send(frame);
+}
+
+size_t
+http_plugin::ws_buffered_amount(ws_connection_id id) const {
+    auto it = my->ws_conns.find(id);
+    if(it == my->ws_conns.end()) {
+        return 0;
+    }
+    return it->second.buffered_amount();
+}
+
+void
+http_plugin::ws_close(ws_connection_id id, const string& reason) {
+    auto it = my->ws_conns.find(id);
+    if(it != my->ws_conns.end()) {
+        it->second.close(reason);
+    }
+}
+
+void
+http_plugin::add_read_only_handler(const string& url, const url_handler& handler) {
+    if(my->read_only_threads == 0) {
+        add_handler(url, handler);
+        return;
+    }
+    ilog("add read-only api url: ${c}", ("c", url));
+    my->add_endpoint(url);
+    my->url_read_only_handlers.insert(std::make_pair(url, handler));
+}
+
+void
+http_plugin::add_cacheable_handler(const string& url, const url_cacheable_handler& handler) {
+    if(!my->cache.enabled()) {
+        add_read_only_handler(url, [handler](string url, string body, url_response_callback cb) {
+            handler(std::move(url), std::move(body), [cb](auto code, auto response_body, auto) {
+                cb(code, std::move(response_body));
+            });
+        });
+        return;
+    }
+    ilog("add cacheable api url: ${c}", ("c", url));
+    my->add_endpoint(url);
+    my->url_cacheable_handlers.insert(std::make_pair(url, handler));
+}
+
 void
 http_plugin::add_deferred_handler(const string& url, const url_deferred_handler& handler) {
     ilog("add deferred api url: ${c}", ("c", url));
+    my->add_endpoint(url);
     boost::asio::post(app().get_io_service(), [=]() {
         my->url_deferred_handlers.insert(std::make_pair(url, handler));
     });
@@ -908,6 +2014,12 @@ http_plugin::get_supported_apis() const {
             result.apis.emplace_back(handler.first);
         }
     }
+    for(const auto& handler : my->url_read_only_handlers) {
+        result.apis.emplace_back(handler.first);
+    }
+    for(const auto& handler : my->url_cacheable_handlers) {
+        result.apis.emplace_back(handler.first);
+    }
     for(const auto& handler : my->url_deferred_handlers) {
         result.apis.emplace_back(handler.first);
     }
@@ -919,4 +2031,20 @@ http_plugin::get_supported_apis() const {
     return result;
 }
 
+http_plugin::get_endpoint_stats_result
+http_plugin::get_endpoint_stats() const {
+    get_endpoint_stats_result result;
+
+    auto lock = std::lock_guard(my->endpoints_mtx);
+    for(auto& it : my->endpoints) {
+        auto& ep    = *it.second;
+        auto  stats = endpoint_stats{it.first, ep.active, ep.served, ep.shed, ep.rate_limited, ep.expired, {}};
+        for(auto& b : ep.latency) {
+            stats.latency_ms.emplace_back(b.load());
+        }
+        result.endpoints.emplace_back(std::move(stats));
+    }
+    return result;
+}
+
 }  // namespace evt
@@ -5,6 +5,7 @@
 #pragma once
 #include <appbase/application.hpp>
 #include <fc/exception/exception.hpp>
+#include <evt/reactor_plugin/reactor_plugin.hpp>
 #include <fc/reflect/reflect.hpp>
 
 namespace evt {
@@ -44,6 +45,22 @@ using url_handler = std::function<void(string, string, url_response_callback)>;
  **/
 using url_deferred_handler = std::function<void(string, string, deferred_id)>;
 
+/**
+ * @brief A callback function provided to a cached URL handler, in addition
+ * to the response it tells whether the response can never change, such
+ * responses are served from the cache for the same request afterwards
+ *
+ * Arguments: response_code, response_body, cacheable
+ */
+using url_cacheable_response_callback = std::function<void(int, string, bool)>;
+
+/**
+ * @brief Callback type for a cached URL handler, it must only read chain state
+ *
+ * Arguments: url, request_body, cacheable_response_callback
+ **/
+using url_cacheable_handler = std::function<void(string, string, url_cacheable_response_callback)>;
+
 /**
  * @brief An API, containing URLs and handlers
  *
@@ -62,6 +79,23 @@ using api_description = std::map<string, url_handler>;
  */
 using async_api_description = std::map<string, url_deferred_handler>;
 
+/**
+ * @brief An API whose responses may be cached, containing URLs and cached handlers
+ */
+using cacheable_api_description = std::map<string, url_cacheable_handler>;
+
+using ws_connection_id = uint64_t;
+
+/**
+ * @brief Callbacks of a websocket endpoint, all of them are called from the
+ * appbase application io_service thread
+ */
+struct ws_handler {
+    std::function<void(ws_connection_id)>                on_open;
+    std::function<void(ws_connection_id, string&&)>      on_message;
+    std::function<void(ws_connection_id)>                on_close;
+};
+
 struct http_plugin_defaults {
     //If empty, unix socket support will be completely disabled. If not empty,
     // unix socket support is enabled with the given default path (treated relative
@@ -94,7 +128,7 @@ public:
     //must be called before initialize
     static void set_defaults(const http_plugin_defaults config);
 
-    APPBASE_PLUGIN_REQUIRES()
+    APPBASE_PLUGIN_REQUIRES((reactor_plugin))
     virtual void set_program_options(options_description&, options_description& cfg) override;
 
     void plugin_initialize(const variables_map& options);
@@ -104,6 +138,10 @@ public:
     void add_handler(const string& url, const url_handler&, bool local_only = false);
     void add_deferred_handler(const string& url, const url_deferred_handler&);
 
+    // handler must only read chain state, it may be called from the read-only pool
+    void add_read_only_handler(const string& url, const url_handler&);
+    void add_cacheable_handler(const string& url, const url_cacheable_handler&);
+
     void
     add_api(const api_description& api, bool local_only = false) {
         for(const auto& call : api) {
@@ -111,6 +149,20 @@ public:
         }
     }
 
+    void
+    add_read_only_api(const api_description& api) {
+        for(const auto& call : api) {
+            add_read_only_handler(call.first, call.second);
+        }
+    }
+
+    void
+    add_cacheable_api(const cacheable_api_description& api) {
+        for(const auto& call : api) {
+            add_cacheable_handler(call.first, call.second);
+        }
+    }
+
     void
     add_async_api(const async_api_description& api) {
         for(const auto& call : api) {
@@ -120,6 +172,20 @@ public:
 
     void set_deferred_response(deferred_id id, int code, const string& body);
 
+    // binary handler takes and returns fc::raw encoded bodies, it is only served on the unix socket
+    // for requests sent with "Content-Type: application/octet-stream", errors are still json
+    void add_binary_handler(const string& url, const url_handler&);
+
+    // websocket endpoints are served on the http and https listeners only
+    void add_ws_handler(const string& url, const ws_handler&);
+
+    // following must be called from the appbase application io_service thread
+    // queues a text frame, returns false when the connection is gone
+    bool   ws_send(ws_connection_id id, const string& frame);
+    // bytes queued but not written to the socket yet
+    size_t ws_buffered_amount(ws_connection_id id) const;
+    void   ws_close(ws_connection_id id, const string& reason);
+
     // standard exception handling for api handlers
     static void handle_exception(const char *api_name, const char *call_name, const string& body, url_response_callback cb);
     static void handle_async_exception(deferred_id id, const char *api_name, const char *call_name, const string& body);
@@ -135,6 +201,22 @@ public:
 
     get_supported_apis_result get_supported_apis() const;
 
+    struct endpoint_stats {
+        string           url;
+        uint32_t         active;
+        uint64_t         served;
+        uint64_t         shed;
+        uint64_t         rate_limited;
+        uint64_t         expired;
+        vector<uint64_t> latency_ms;  // count of responses under 1, 2, 4 ... ms, the last one is the rest
+    };
+
+    struct get_endpoint_stats_result {
+        vector<endpoint_stats> endpoints;
+    };
+
+    get_endpoint_stats_result get_endpoint_stats() const;
+
 private:
     std::unique_ptr<class http_plugin_impl> my;
 };
@@ -194,3 +276,5 @@ FC_REFLECT(evt::error_results::error_info::error_detail, (message)(file)(line_nu
 FC_REFLECT(evt::error_results::error_info, (code)(name)(what)(details));
 FC_REFLECT(evt::error_results, (code)(message)(error));
 FC_REFLECT(evt::http_plugin::get_supported_apis_result, (apis));
+FC_REFLECT(evt::http_plugin::endpoint_stats, (url)(active)(served)(shed)(rate_limited)(expired)(latency_ms));
+FC_REFLECT(evt::http_plugin::get_endpoint_stats_result, (endpoints));
@@ -5,13 +5,17 @@
 #pragma once
 
 #include <string>
+#include <future>
+#include <iterator>
 #include <memory>
 #include <optional>
+#include <vector>
 #include <boost/scope_exit.hpp>
 #include <bsoncxx/exception/exception.hpp>
 #include <bsoncxx/json.hpp>
 #include <mongocxx/database.hpp>
 #include <mongocxx/bulk_write.hpp>
+#include <mongocxx/model/write.hpp>
 #include <mongocxx/exception/operation_exception.hpp>
 #include <mongocxx/exception/logic_error.hpp>
 #include <appbase/application.hpp>
@@ -22,49 +26,124 @@ using mongocxx::database;
 using mongocxx::collection;
 using mongocxx::bulk_write;
 
-#define define_collection(n)                                        \
-    collection                 n##_collection;                       \
-    std::optional<bulk_write>  n##_commits;                          \
-                                                                    \
-    auto& get_##n() {                                               \
-        if(!(n##_commits)) {                                        \
-            n##_commits = n##_collection.create_bulk_write(opts_);  \
-        }                                                           \
-        total_++;                                                   \
-        return *n##_commits;                                        \
+/**
+ * Writes of one collection, owning their documents
+ *
+ * The models copy the documents they are given, so they may be built on any thread and merged in
+ * order from several contexts before being written. Inserts of an append-only collection are
+ * written as an unordered bulk, before the updates, which always keep their order.
+ */
+class write_list {
+public:
+    write_list(bool unordered_inserts)
+        : unordered_inserts_(unordered_inserts) {}
+
+public:
+    void
+    append(const mongocxx::model::insert_one& w) {
+        auto& writes = unordered_inserts_ ? unordered_ : ordered_;
+        writes.emplace_back(mongocxx::model::insert_one(bsoncxx::document::value(w.document().view())));
     }
 
-#define commit_collection(n)            \
-    if(n##_commits.has_value()) {       \
-        BOOST_SCOPE_EXIT_ALL(&) {       \
-            n##_commits.reset();        \
-        };                              \
-        try {                           \
-            n##_commits->execute();     \
-        }                               \
-        catch(...) {                    \
-            handle_mongo_exception(#n); \
-        }                               \
+    void
+    append(const mongocxx::model::update_one& w) {
+        ordered_.emplace_back(mongocxx::model::update_one(bsoncxx::document::value(w.filter().view()),
+                                                          bsoncxx::document::value(w.update().view())));
     }
 
-class write_context {
-public:
-    write_context() {
-        opts_.ordered(true);
+    void
+    append(const mongocxx::model::update_many& w) {
+        ordered_.emplace_back(mongocxx::model::update_many(bsoncxx::document::value(w.filter().view()),
+                                                           bsoncxx::document::value(w.update().view())));
+    }
+
+    void
+    merge(write_list&& other) {
+        std::move(other.unordered_.begin(), other.unordered_.end(), std::back_inserter(unordered_));
+        std::move(other.ordered_.begin(), other.ordered_.end(), std::back_inserter(ordered_));
+        other.clear();
+    }
+
+    bool empty() const { return unordered_.empty() && ordered_.empty(); }
+
+    void
+    clear() {
+        unordered_.clear();
+        ordered_.clear();
+    }
+
+    void
+    execute(collection& col) {
+        execute(col, unordered_, false);
+        execute(col, ordered_, true);
+    }
+
+private:
+    static void
+    execute(collection& col, const std::vector<mongocxx::model::write>& writes, bool ordered) {
+        if(writes.empty()) {
+            return;
+        }
+
+        auto opts = mongocxx::options::bulk_write();
+        opts.ordered(ordered);
+
+        auto bulk = col.create_bulk_write(opts);
+        for(auto& w : writes) {
+            bulk.append(w);
+        }
+        bulk.execute();
+    }
+
+private:
+    bool                                 unordered_inserts_;
+    std::vector<mongocxx::model::write>  unordered_;
+    std::vector<mongocxx::model::write>  ordered_;
+};
+
+#define define_collection(n, unordered_inserts) \
+    collection  n##_collection;                 \
+    write_list  n##_writes{unordered_inserts};  \
+                                                \
+    auto& get_##n() {                           \
+        total_++;                               \
+        return n##_writes;                      \
     }
 
+// each collection is written by its own task, its handle should come from a client of its own
+#define commit_collection(n)                                                                 \
+    if(!n##_writes.empty()) {                                                                \
+        writers.emplace_back(std::async(std::launch::async, [this] {                         \
+            BOOST_SCOPE_EXIT_ALL(&) {                                                        \
+                n##_writes.clear();                                                          \
+            };                                                                               \
+            try {                                                                            \
+                n##_writes.execute(n##_collection);                                          \
+            }                                                                                \
+            catch(...) {                                                                     \
+                handle_mongo_exception(#n);                                                  \
+            }                                                                                \
+        }));                                                                                 \
+    }
+
+#define merge_collection(n) \
+    n##_writes.merge(std::move(other.n##_writes));
+
+class write_context {
 public:
-    define_collection(blocks);
-    define_collection(trxs);
-    define_collection(actions);
-    define_collection(domains);
-    define_collection(tokens);
-    define_collection(groups);
-    define_collection(fungibles);
+    define_collection(blocks, true);
+    define_collection(trxs, true);
+    define_collection(actions, true);
+    define_collection(domains, false);
+    define_collection(tokens, false);
+    define_collection(groups, false);
+    define_collection(fungibles, false);
 
 public:
     void
     execute() {
+        auto writers = std::vector<std::future<void>>();
+
         commit_collection(blocks);
         commit_collection(trxs);
         commit_collection(actions);
@@ -73,9 +152,27 @@ public:
         commit_collection(groups);
         commit_collection(fungibles);
 
+        for(auto& w : writers) {
+            w.wait();
+        }
         total_ = 0;
     }
 
+    // appends the writes of `other`, which were built after the ones of this context
+    void
+    merge(write_context&& other) {
+        merge_collection(blocks);
+        merge_collection(trxs);
+        merge_collection(actions);
+        merge_collection(domains);
+        merge_collection(tokens);
+        merge_collection(groups);
+        merge_collection(fungibles);
+
+        total_ += other.total_;
+        other.total_ = 0;
+    }
+
     size_t
     total() const {
         return total_;
@@ -135,8 +232,7 @@ private:
     }
 
 private:
-    mongocxx::options::bulk_write opts_;
-    size_t                        total_;
+    size_t total_ = 0;
 };
 
 }  // namespace evt
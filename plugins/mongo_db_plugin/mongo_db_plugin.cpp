@@ -6,19 +6,13 @@
 #include <evt/mongo_db_plugin/evt_interpreter.hpp>
 #include <evt/mongo_db_plugin/write_context.hpp>
 
+#include <algorithm>
 #include <functional>
+#include <future>
 #include <queue>
 #include <tuple>
 #include <thread>
 
-#if __has_include(<condition>)
-#include <condition>
-using std::condition_variable_any;
-#else
-#include <boost/thread/condition.hpp>
-using boost::condition_variable_any;
-#endif
-
 #include <evt/chain/config.hpp>
 #include <evt/chain/genesis_state.hpp>
 #include <evt/chain/exceptions.hpp>
@@ -27,8 +21,8 @@ using boost::condition_variable_any;
 #include <evt/chain/types.hpp>
 #include <evt/chain/token_database.hpp>
 #include <evt/chain/contracts/evt_contract_abi.hpp>
-
-#include <evt/utilities/spinlock.hpp>
+#include <evt/utilities/metrics.hpp>
+#include <evt/utilities/task_scheduler.hpp>
 
 #include <fc/io/json.hpp>
 #include <fc/variant.hpp>
@@ -53,14 +47,19 @@ using namespace chain;
 using namespace chain::contracts;
 using namespace chain::plugin_interface;
 
-using evt::utilities::spinlock;
-using evt::utilities::spinlock_guard;
-
 static appbase::abstract_plugin& _mongo_db_plugin = app().register_plugin<mongo_db_plugin>();
 
 class mongo_db_plugin_impl {
 private:
     using inblock_ptr = std::tuple<block_state_ptr, bool>; // true for irreversible block
+    using traces_type = std::vector<transaction_trace_ptr>;
+
+    // one queued block with the traces of its transactions, null for the ones not found
+    struct block_job {
+        block_state_ptr bsp;
+        bool            irreversible;
+        traces_type     traces;
+    };
 
 public:
     mongo_db_plugin_impl(const controller& control)
@@ -73,20 +72,19 @@ public:
 public:
     void consume_queues();
 
-    void applied_block(const block_state_ptr&);
-    void applied_irreversible_block(const block_state_ptr&);
-    void applied_transaction(const transaction_trace_ptr&);
+    traces_type match_traces(const signed_block&, std::deque<transaction_trace_ptr>& traces);
+    void verify_blocks(const signed_block&);
+    void build_writes(const block_job& job, write_context& write_ctx);
 
-    void process_block(const signed_block&, std::deque<transaction_trace_ptr>& traces, write_context& write_ctx);
-    void _process_block(const signed_block&, std::deque<transaction_trace_ptr>& traces, write_context& write_ctx);
-    void process_irreversible_block(const signed_block&, std::deque<transaction_trace_ptr>& traces, write_context& write_ctx);
+    void process_block(const signed_block&, const traces_type& traces, write_context& write_ctx);
+    void _process_block(const signed_block&, const traces_type& traces, write_context& write_ctx);
+    void process_irreversible_block(const signed_block&, const traces_type& traces, write_context& write_ctx);
     void _process_irreversible_block(const signed_block&, write_context& write_ctx);
     void process_transaction(const transaction_trace&, write_context& write_ctx);
     void _process_transaction(const transaction_trace&, write_context& write_ctx);
 
     void add_trx_trace(bsoncxx::builder::basic::document& trx_doc,
-                       const chain::transaction& trx,
-                       std::deque<transaction_trace_ptr>& traces,
+                       const transaction_trace_ptr& trace,
                        std::function<void(action&)>&& on_paycharge_act);
 
     void add_trx_ext(bsoncxx::builder::basic::document& trx_doc, const chain::transaction& trx);
@@ -106,22 +104,21 @@ public:
 
     evt_interpreter    interpreter;
 
-    size_t processed  = 0;
-    size_t queue_size = 0;
+    size_t processed         = 0;
+    size_t queue_size        = 0;
+    size_t batch_size        = 0;
+    size_t serialize_threads = 0;
+
+    block_trace_bus*              bus_      = nullptr;
+    block_trace_bus::consumer_id  consumer_ = 0;
 
-    std::deque<inblock_ptr>           block_state_queue;
-    std::deque<transaction_trace_ptr> transaction_trace_queue;
+    std::optional<utilities::metrics::collector_id> metrics_collector_;
 
-    spinlock                    lock_;
-    condition_variable_any      cond_;
     std::thread                 consume_thread_;
     std::atomic_bool            done_{false};
 
-    write_context write_ctx_;
-
-    std::optional<boost::signals2::scoped_connection> accepted_block_connection;
-    std::optional<boost::signals2::scoped_connection> irreversible_block_connection;
-    std::optional<boost::signals2::scoped_connection> applied_transaction_connection;
+    write_context                          write_ctx_;
+    std::deque<mongocxx::client>           writer_conns_;
 
 public:
     const std::string blocks_col        = "Blocks";
@@ -135,105 +132,107 @@ public:
 
 
 
-template <typename Q, typename V>
-inline void
-queueb(Q& bqueue, V&& v, spinlock& lock, condition_variable_any& cv, size_t queue_size) {
-    lock.lock();
-
-    auto sleep_time = 0ul;
-
-    while(bqueue.size() > queue_size) {
-        lock.unlock();
-        cv.notify_one();
-
-        sleep_time += 100;
-        std::this_thread::sleep_for(std::chrono::milliseconds(sleep_time));
-
-        lock.lock();
-    }
-    bqueue.emplace_back(std::forward<V>(v));
-    lock.unlock();
-    cv.notify_one();
-}
-
-template <typename Q, typename V>
-inline void
-queuet(Q& tqueue, V&& v, spinlock& lock, condition_variable_any& cv) {
-    lock.lock();
-    tqueue.emplace_back(std::forward<V>(v));
-    lock.unlock();
-    cv.notify_one();
-}
-
-void
-mongo_db_plugin_impl::applied_irreversible_block(const block_state_ptr& bsp) {
-    queueb(block_state_queue, std::make_tuple(bsp, true), lock_, cond_, queue_size);
-}
-
-void
-mongo_db_plugin_impl::applied_block(const block_state_ptr& bsp) {
-    queueb(block_state_queue, std::make_tuple(bsp, false), lock_, cond_, queue_size);
-}
-
-void
-mongo_db_plugin_impl::applied_transaction(const transaction_trace_ptr& ttp) {
-    queuet(transaction_trace_queue, ttp, lock_, cond_);
-}
-
 void
 mongo_db_plugin_impl::consume_queues() {
+    // traces arrive before their block, the ones not matched yet are kept over the pops
+    auto traces = std::deque<transaction_trace_ptr>();
+    auto events = std::vector<block_trace_event>();
+
     try {
         while(true) {
-            lock_.lock();
-            while(block_state_queue.empty() && !done_) {
-                cond_.wait(lock_);
+            events.clear();
+            if(bus_->pop(consumer_, events, queue_size, std::chrono::seconds(1)) == 0) {
+                if(done_) {
+                    break;
+                }
+                continue;
             }
 
-            auto bqueue = std::move(block_state_queue);
-            auto traces = std::move(transaction_trace_queue);
-
-            lock_.unlock();
+            auto bqueue = std::deque<inblock_ptr>();
+            for(auto& e : events) {
+                switch(e.kind) {
+                case block_trace_event::accepted_block: {
+                    bqueue.emplace_back(e.block, false);
+                    break;
+                }
+                case block_trace_event::irreversible_block: {
+                    bqueue.emplace_back(e.block, true);
+                    break;
+                }
+                case block_trace_event::applied_transaction: {
+                    traces.emplace_back(e.trace);
+                    break;
+                }
+                default: {
+                    break;
+                }
+                }  // switch
+            }
 
             const int BlockPtr       = 0;
             const int IsIrreversible = 1;
 
-            // warn if queue size greater than 75%
-            if(bqueue.size() > (queue_size * 0.75)) {
-                wlog("queue size: ${q}, head block num: ${b}", ("q", bqueue.size())("b",std::get<BlockPtr>(bqueue.front())->block_num));
+            // warn if lagging more than 75% of the queue
+            auto stats = bus_->stats(consumer_);
+            if(stats.lag > (queue_size * 0.75)) {
+                wlog("queue size: ${q}, producer stalls: ${s}", ("q", stats.lag)("s", stats.stalls));
             }
             else if(done_) {
-                ilog("draining queue, size: ${q}", ("q", bqueue.size()));
+                ilog("draining queue, size: ${q}", ("q", stats.lag));
                 break;
             }
 
-            // process block states
-            while(true) {
-                if(bqueue.empty()) {
-                    break;
-                }
+            // traces are matched in queue order, then the blocks may be serialized in any order
+            auto jobs = std::vector<block_job>();
+            jobs.reserve(bqueue.size());
+            for(auto& b : bqueue) {
+                auto& bsp  = std::get<BlockPtr>(b);
+                auto  irr  = std::get<IsIrreversible>(b);
+                auto  full = !irr || bsp->block_num == 1;
 
-                auto& b = bqueue.front();
-                if(std::get<IsIrreversible>(b)) {
-                    process_irreversible_block(*(std::get<BlockPtr>(b)->block), traces, write_ctx_);
+                if(full && processed++ == 0) {
+                    verify_blocks(*bsp->block);
                 }
-                else {
-                    process_block(*(std::get<BlockPtr>(b)->block), traces, write_ctx_);
+                jobs.emplace_back(block_job{ bsp, irr, full ? match_traces(*bsp->block, traces) : traces_type() });
+            }
+            bqueue.clear();
+
+            auto batch = batch_size > 0 ? batch_size : queue_size * 2;
+            if(serialize_threads == 0) {
+                for(auto& job : jobs) {
+                    build_writes(job, write_ctx_);
+                    if(write_ctx_.total() >= batch) {
+                        write_ctx_.execute();
+                    }
                 }
-
-                if(write_ctx_.total() >= queue_size * 2) {
-                    write_ctx_.execute();
+            }
+            else {
+                // contiguous chunks built by the chain workers, merged back in queue order so updates keep their order
+                auto chunk   = (jobs.size() + serialize_threads - 1) / serialize_threads;
+                auto futures = std::vector<std::future<write_context>>();
+                for(auto i = size_t(0); i < jobs.size(); i += chunk) {
+                    auto end  = std::min(i + chunk, jobs.size());
+                    auto task = std::make_shared<std::packaged_task<write_context()>>([this, &jobs, i, end] {
+                        auto ctx = write_context();
+                        for(auto j = i; j < end; j++) {
+                            build_writes(jobs[j], ctx);
+                        }
+                        return ctx;
+                    });
+                    futures.emplace_back(task->get_future());
+                    control_.get_task_scheduler().post([task] { (*task)(); }, utilities::task_scheduler::lane::background);
+                }
+                for(auto& f : futures) {
+                    write_ctx_.merge(f.get());
+                    if(write_ctx_.total() >= batch) {
+                        write_ctx_.execute();
+                    }
                 }
-
-                bqueue.pop_front();
             }
             if(write_ctx_.total() > 0) {
                 write_ctx_.execute();
             }
-
-            if(!traces.empty()) {
-                spinlock_guard lock(lock_);
-                transaction_trace_queue.insert(transaction_trace_queue.begin(), traces.begin(), traces.end());
-            }
+            bus_->ack(consumer_);
         }
         ilog("mongo_db_plugin consume thread shutdown gracefully");
     }
@@ -308,8 +307,57 @@ verify_no_blocks(mongocxx::collection& blocks) {
 
 }  // namespace internal
 
+mongo_db_plugin_impl::traces_type
+mongo_db_plugin_impl::match_traces(const signed_block& block, std::deque<transaction_trace_ptr>& traces) {
+    auto matched = traces_type();
+    matched.reserve(block.transactions.size());
+
+    for(auto& receipt : block.transactions) {
+        auto id = receipt.trx.id();
+        auto it = std::find_if(traces.begin(), traces.end(), [&id](auto& t) { return t->id == id; });
+        if(it == traces.end()) {
+            matched.emplace_back(nullptr);
+            continue;
+        }
+        // traces before the matched one belong to no queued block anymore
+        matched.emplace_back(*it);
+        traces.erase(traces.begin(), it + 1);
+    }
+    return matched;
+}
+
 void
-mongo_db_plugin_impl::process_irreversible_block(const signed_block& block, std::deque<transaction_trace_ptr>& traces, write_context& write_ctx) {
+mongo_db_plugin_impl::verify_blocks(const signed_block& block) {
+    using namespace evt::internal;
+
+    try {
+        auto blocks = mongo_db[blocks_col];
+        if(block.block_num() <= 2) {
+            // verify on start we have no previous blocks
+            verify_no_blocks(blocks);
+        }
+        else {
+            // verify on restart we have previous block
+            verify_last_block(blocks, block.previous.str());
+        }
+    }
+    catch(fc::exception& e) {
+        elog("FC Exception while verifying blocks ${e}", ("e", e.to_string()));
+    }
+}
+
+void
+mongo_db_plugin_impl::build_writes(const block_job& job, write_context& write_ctx) {
+    if(job.irreversible) {
+        process_irreversible_block(*job.bsp->block, job.traces, write_ctx);
+    }
+    else {
+        process_block(*job.bsp->block, job.traces, write_ctx);
+    }
+}
+
+void
+mongo_db_plugin_impl::process_irreversible_block(const signed_block& block, const traces_type& traces, write_context& write_ctx) {
     try {
         if(block.block_num() == 1) {
             // genesis block will not trigger on_block event
@@ -330,7 +378,7 @@ mongo_db_plugin_impl::process_irreversible_block(const signed_block& block, std:
 }
 
 void
-mongo_db_plugin_impl::process_block(const signed_block& block, std::deque<transaction_trace_ptr>& traces, write_context& write_ctx) {
+mongo_db_plugin_impl::process_block(const signed_block& block, const traces_type& traces, write_context& write_ctx) {
     try {
         _process_block(block, traces, write_ctx);
 
@@ -356,32 +404,19 @@ mongo_db_plugin_impl::process_transaction(const transaction_trace& trace, write_
 }
 
 void
-mongo_db_plugin_impl::_process_block(const signed_block& block, std::deque<transaction_trace_ptr>& traces, write_context& write_ctx) {
+mongo_db_plugin_impl::_process_block(const signed_block& block, const traces_type& traces, write_context& write_ctx) {
     using namespace evt::internal;
     using namespace bsoncxx::types;
     using namespace bsoncxx::builder;
     using namespace mongocxx::model;
     using bsoncxx::builder::basic::kvp;
 
-    auto blocks = mongo_db[blocks_col];
-
     auto       block_doc         = bsoncxx::builder::basic::document{};
     const auto block_id          = block.id();
     const auto block_id_str      = block_id.str();
     const auto prev_block_id_str = block.previous.str();
     auto       block_num         = (int32_t)block.block_num();
 
-    if(processed == 0) {
-        if(block_num <= 2) {
-            // verify on start we have no previous blocks
-            verify_no_blocks(blocks);
-        }
-        else {
-            // verify on restart we have previous block
-            verify_last_block(blocks, prev_block_id_str);
-        }
-    }
-
     auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
         std::chrono::microseconds{fc::time_point::now().time_since_epoch().count()});
 
@@ -418,7 +453,7 @@ mongo_db_plugin_impl::_process_block(const signed_block& block, std::deque<trans
     };
 
     int32_t trx_num  = 0;
-    auto process_trx = [&](const chain::transaction& trx, auto status) -> auto {
+    auto process_trx = [&](const chain::transaction& trx, auto status, auto& trace) -> auto {
         auto       txn_oid      = bsoncxx::oid{};
         auto       doc          = bsoncxx::builder::basic::document{};
         auto       trx_id       = trx.id();
@@ -451,7 +486,7 @@ mongo_db_plugin_impl::_process_block(const signed_block& block, std::deque<trans
         }
 
         // add trace(elapsed and charge) and paycharge action
-        add_trx_trace(doc, trx, traces, [&](auto& act) {
+        add_trx_trace(doc, trace, [&](auto& act) {
             process_action(trans_id_str, act);
         });
 
@@ -461,7 +496,7 @@ mongo_db_plugin_impl::_process_block(const signed_block& block, std::deque<trans
     trx_num = 0;
     for(const auto& trx_receipt : block.transactions) {
         const auto& trx = trx_receipt.trx.get_signed_transaction();
-        auto        doc = process_trx(trx, trx_receipt.status);
+        auto        doc = process_trx(trx, trx_receipt.status, traces[trx_num]);
 
         doc.append(kvp("type", (std::string)trx_receipt.type));
         doc.append(kvp("status", (std::string)trx_receipt.status));
@@ -482,8 +517,6 @@ mongo_db_plugin_impl::_process_block(const signed_block& block, std::deque<trans
         write_ctx.get_trxs().append(insert_one(doc.view()));
         ++trx_num;
     }
-
-    ++processed;
 }
 
 void
@@ -516,8 +549,7 @@ mongo_db_plugin_impl::_process_transaction(const transaction_trace& trace, write
 
 void
 mongo_db_plugin_impl::add_trx_trace(bsoncxx::builder::basic::document& trx_doc,
-                                    const chain::transaction&          trx,
-                                    std::deque<transaction_trace_ptr>& traces,
+                                    const transaction_trace_ptr&       trace,
                                     std::function<void(action&)>&&     on_paycharge_act) {
     using namespace evt::internal;
     using namespace bsoncxx::types;
@@ -525,29 +557,22 @@ mongo_db_plugin_impl::add_trx_trace(bsoncxx::builder::basic::document& trx_doc,
     using namespace mongocxx::model;
     using bsoncxx::builder::basic::kvp;
 
-    auto trace_doc = bsoncxx::builder::basic::document{};
+    if(!trace) {
+        return;
+    }
 
-    auto it = traces.begin();
-    while(it != traces.end()) {
-        auto trace = *it;
-        traces.pop_front();
-
-        if(trace->id == trx.id()) {
-            trace_doc.append(kvp("elapsed", (int64_t)trace->elapsed.count()),
-                             kvp("charge", (int64_t)trace->charge));
-            trx_doc.append(kvp("trace", trace_doc));
-            if(trace->action_traces.empty()) {
-                return;
-            }
-            // because paycharage action is alwasys the latest action
-            // only check latest
-            auto& act = trace->action_traces.back().act;
-            if(act.name == N(paycharge)) {
-                on_paycharge_act(act);
-            }
-            return;
-        }
-        it++;
+    auto trace_doc = bsoncxx::builder::basic::document{};
+    trace_doc.append(kvp("elapsed", (int64_t)trace->elapsed.count()),
+                     kvp("charge", (int64_t)trace->charge));
+    trx_doc.append(kvp("trace", trace_doc));
+    if(trace->action_traces.empty()) {
+        return;
+    }
+    // because paycharage action is alwasys the latest action
+    // only check latest
+    auto& act = trace->action_traces.back().act;
+    if(act.name == N(paycharge)) {
+        on_paycharge_act(act);
     }
 }
 
@@ -577,8 +602,12 @@ mongo_db_plugin_impl::~mongo_db_plugin_impl() {
         return;
     }
     try {
+        if(metrics_collector_.has_value()) {
+            utilities::metrics::registry::get().remove_collector(*metrics_collector_);
+        }
+
         done_ = true;
-        cond_.notify_one();
+        bus_->unsubscribe(consumer_);
 
         consume_thread_.join();
     }
@@ -648,31 +677,33 @@ mongo_db_plugin_impl::init() {
         fungibles.create_index(bsoncxx::from_json(R"xxx({ "sym_id" : 1 })xxx"));
     }
 
-    write_ctx_.blocks_collection    = mongo_db[blocks_col];
-    write_ctx_.trxs_collection      = mongo_db[trxs_col];
-    write_ctx_.actions_collection   = mongo_db[actions_col];
-    write_ctx_.domains_collection   = mongo_db[domains_col];
-    write_ctx_.tokens_collection    = mongo_db[tokens_col];
-    write_ctx_.groups_collection    = mongo_db[groups_col];
-    write_ctx_.fungibles_collection = mongo_db[fungibles_col];
+    // collections are written in parallel, each one through a client of its own
+    auto dbname            = std::string(mongo_db.name().data(), mongo_db.name().size());
+    auto writer_collection = [&](auto& name) {
+        writer_conns_.emplace_back(mongo_uri);
+        return writer_conns_.back()[dbname][name];
+    };
+
+    write_ctx_.blocks_collection    = writer_collection(blocks_col);
+    write_ctx_.trxs_collection      = writer_collection(trxs_col);
+    write_ctx_.actions_collection   = writer_collection(actions_col);
+    write_ctx_.domains_collection   = writer_collection(domains_col);
+    write_ctx_.tokens_collection    = writer_collection(tokens_col);
+    write_ctx_.groups_collection    = writer_collection(groups_col);
+    write_ctx_.fungibles_collection = writer_collection(fungibles_col);
 
     // initilize evt interpreter
     interpreter.initialize_db(mongo_db);
 
-    auto& chain_plug = app().get_plugin<chain_plugin>();
-    auto& chain      = chain_plug.chain();
-
-    accepted_block_connection.emplace(chain.accepted_block.connect([&](const chain::block_state_ptr& bs) {
-        applied_block(bs);
-    }));
-
-    irreversible_block_connection.emplace(chain.irreversible_block.connect([&](const chain::block_state_ptr& bs) {
-        applied_irreversible_block(bs);
-    }));
+    bus_      = &app().get_plugin<chain_plugin>().get_block_trace_bus();
+    consumer_ = bus_->subscribe(queue_size);
 
-    applied_transaction_connection.emplace(chain.applied_transaction.connect([&](const chain::transaction_trace_ptr& t) {
-        applied_transaction(t);
-    }));
+    metrics_collector_ = utilities::metrics::registry::get().add_collector([this](auto& w) {
+        auto stats = bus_->stats(consumer_);
+        w.gauge("evt_consumer_lag", "Events published to the consumer and not handled yet", stats.lag, {{"consumer", "mongodb"}});
+        w.gauge("evt_consumer_queue_size", "Events the consumer may fall behind before the chain waits for it", queue_size, {{"consumer", "mongodb"}});
+        w.counter("evt_consumer_stalls_total", "Times the chain waited for the consumer", stats.stalls, {{"consumer", "mongodb"}});
+    });
 
     if(need_init) {
         // HACK: Add EVT and PEVT manually
@@ -730,6 +761,8 @@ void
 mongo_db_plugin::set_program_options(options_description& cli, options_description& cfg) {
     cfg.add_options()
         ("mongodb-queue-size,q", bpo::value<uint>()->default_value(5120), "The queue size between evtd and MongoDB plugin thread.")
+        ("mongodb-batch-size", bpo::value<uint>()->default_value(0), "The number of writes sent to MongoDB in one batch, 0 for twice the queue size.")
+        ("mongodb-serialize-threads", bpo::value<uint>()->default_value(0), "The number of chunks the documents of queued blocks are split into and built by the chain workers (chain-threads), 0 to build them on the consume thread.")
         ("mongodb-uri,m", bpo::value<std::string>(), "MongoDB URI connection string, see: https://docs.mongodb.com/master/reference/connection-string/."
                                                      " If not specified then plugin is disabled. Default database 'EVT' is used if not specified in URI.")
         ;
@@ -760,6 +793,8 @@ mongo_db_plugin::plugin_initialize(const variables_map& options) {
             auto size       = options.at("mongodb-queue-size").as<uint>();
             my_->queue_size = size;
         }
+        my_->batch_size        = options.at("mongodb-batch-size").as<uint>();
+        my_->serialize_threads = options.at("mongodb-serialize-threads").as<uint>();
 
         std::string uri_str = options.at("mongodb-uri").as<std::string>();
         ilog("connecting to ${u}", ("u", uri_str));
@@ -793,9 +828,6 @@ mongo_db_plugin::plugin_startup() {}
 
 void
 mongo_db_plugin::plugin_shutdown() {
-    my_->accepted_block_connection.reset();
-    my_->irreversible_block_connection.reset();
-    my_->applied_transaction_connection.reset();
     my_.reset();
 }
 
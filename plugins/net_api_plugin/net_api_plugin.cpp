@@ -81,6 +81,8 @@ net_api_plugin::plugin_startup() {
              INVOKE_R_R(net_mgr, status, std::string), 201),
         CALL(net, net_mgr, connections,
              INVOKE_R_V(net_mgr, connections), 201),
+        CALL(net, net_mgr, stats,
+             INVOKE_R_V(net_mgr, stats), 201),
         //   CALL(net, net_mgr, open,
         //        INVOKE_V_R(net_mgr, open, std::string), 200),
     });
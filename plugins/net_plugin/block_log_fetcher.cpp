@@ -0,0 +1,267 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#include <evt/net_plugin/block_log_fetcher.hpp>
+
+#include <evt/net_plugin/peer_session.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include <fc/log/logger.hpp>
+#include <evt/chain/merkle.hpp>
+
+namespace evt {
+
+using namespace chain;
+
+namespace {
+
+struct segment {
+    std::vector<signed_block_ptr> blocks;
+    size_t                        source = 0;  // index of the peer it came from
+};
+
+std::vector<signed_block_ptr>
+unpack_segment(const block_log_segment_message& msg) {
+    auto blocks = std::vector<signed_block_ptr>();
+    auto begin  = 0u;
+    for(auto end : msg.ends) {
+        EVT_ASSERT(end > begin && end <= msg.data.size(), plugin_exception, "Invalid block log segment from block ${n}", ("n", msg.first_block_num));
+
+        auto ds = fc::datastream<const char*>(msg.data.data() + begin, end - begin);
+        auto b  = std::make_shared<signed_block>();
+        fc::raw::unpack(ds, *b);
+        EVT_ASSERT(b->block_num() == msg.first_block_num + blocks.size(), plugin_exception,
+                   "Unexpected block ${b} in block log segment from block ${n}", ("b", b->block_num())("n", msg.first_block_num));
+
+        blocks.emplace_back(std::move(b));
+        begin = end;
+    }
+    return blocks;
+}
+
+// checks done on all the cores, the header states are chained by the caller
+void
+verify_blocks(const std::vector<block_header_state>& states, const std::vector<signed_block_ptr>& blocks) {
+    auto failed  = std::atomic<bool>(false);
+    auto threads = std::min<size_t>(std::max(std::thread::hardware_concurrency(), 1u), blocks.size());
+    for_each_parallel(threads, [&](size_t t) {
+        for(auto i = t; i < blocks.size() && !failed; i += threads) {
+            try {
+                states[i].verify_signee(states[i].signee());
+
+                auto trx_digests = vector<digest_type>();
+                trx_digests.reserve(blocks[i]->transactions.size());
+                for(const auto& trx : blocks[i]->transactions) {
+                    trx_digests.emplace_back(trx.digest());
+                }
+                EVT_ASSERT(merkle(std::move(trx_digests)) == blocks[i]->transaction_mroot, block_validate_exception,
+                           "transaction merkle root of block doesn't match its receipts");
+            }
+            catch(const fc::exception& e) {
+                wlog("Block ${n} is invalid: ${e}", ("n", blocks[i]->block_num())("e", e.to_string()));
+                failed = true;
+            }
+        }
+    });
+    EVT_ASSERT(!failed, block_validate_exception, "Invalid blocks in block log segment");
+}
+
+}  // namespace
+
+block_log_fetcher::block_log_fetcher(const chain_id_type& chain_id, std::vector<std::string> peers, uint32_t segment_blocks, uint32_t segments_in_flight)
+    : chain_id_(chain_id)
+    , peers_(std::move(peers))
+    , segment_blocks_(std::max(segment_blocks, 1u))
+    , segments_in_flight_(std::max(segments_in_flight, 1u)) {}
+
+uint32_t
+block_log_fetcher::fetch(const block_header_state& head, const append_func& append) {
+    auto sessions = std::vector<std::unique_ptr<peer_session>>();
+    for(auto& p : peers_) {
+        sessions.emplace_back(std::make_unique<peer_session>(p));
+    }
+
+    // a request without blocks is answered with the last irreversible block of the peer
+    auto heads = std::vector<uint32_t>(sessions.size());
+    for_each_parallel(sessions.size(), [&](size_t i) {
+        auto& s = *sessions[i];
+        try {
+            s.connect();
+            s.send(block_log_segment_request_message{ chain_id_, head.block_num + 1, 0 });
+            heads[i] = s.receive<block_log_segment_message>().head_block_num;
+        }
+        catch(const fc::exception& e) {
+            wlog("Cannot get the block log head of peer ${p}: ${e}", ("p", s.peer())("e", e.to_string()));
+        }
+        catch(const std::exception& e) {
+            wlog("Cannot get the block log head of peer ${p}: ${e}", ("p", s.peer())("e", e.what()));
+        }
+    });
+
+    auto target = heads.empty() ? 0u : *std::max_element(heads.begin(), heads.end());
+    if(target <= head.block_num) {
+        return 0;
+    }
+    ilog("Fetching blocks ${s} to ${t} from the block logs of peers", ("s", head.block_num + 1)("t", target));
+
+    auto mtx      = std::mutex();
+    auto cv       = std::condition_variable();
+    auto pending  = std::map<uint32_t, uint32_t>();  // first block num -> number of blocks, lowest ones first
+    auto received = std::map<uint32_t, segment>();
+    auto bad      = std::vector<bool>(sessions.size());
+    auto next     = head.block_num + 1;  // first block not verified yet
+    auto active   = 0u;
+    auto done     = false;
+    for(auto n = next; n <= target; n += segment_blocks_) {
+        pending[n] = std::min(segment_blocks_, target - n + 1);
+    }
+
+    // segments verified later are kept, the one verified next is always taken
+    auto max_received = segments_in_flight_ * sessions.size() * 2;
+    auto can_take     = [&](size_t i) {
+        auto it = pending.begin();
+        return it != pending.end() && it->first + it->second - 1 <= heads[i] && (received.size() < max_received || it->first == next);
+    };
+    auto beyond_head = [&](size_t i) {
+        auto it = pending.begin();
+        return it != pending.end() && it->first + it->second - 1 > heads[i];
+    };
+
+    auto worker = [&](size_t i) {
+        auto& s        = *sessions[i];
+        auto  inflight = std::map<uint32_t, uint32_t>();
+        try {
+            while(true) {
+                auto requests = std::vector<std::pair<uint32_t, uint32_t>>();
+                {
+                    auto lock = std::unique_lock<std::mutex>(mtx);
+                    cv.wait(lock, [&] { return done || bad[i] || !inflight.empty() || can_take(i) || beyond_head(i); });
+                    // the peer cannot help anymore once it doesn't have the lowest blocks left
+                    if(done || bad[i] || (inflight.empty() && beyond_head(i))) {
+                        break;
+                    }
+                    while(inflight.size() < segments_in_flight_ && can_take(i)) {
+                        requests.emplace_back(*pending.begin());
+                        inflight.emplace(*pending.begin());
+                        pending.erase(pending.begin());
+                    }
+                }
+                for(auto& [first, count] : requests) {
+                    s.send(block_log_segment_request_message{ chain_id_, first, count });
+                }
+
+                auto msg = s.receive<block_log_segment_message>();
+                auto it  = inflight.find(msg.first_block_num);
+                EVT_ASSERT(it != inflight.end(), plugin_exception, "Unexpected block log segment from block ${n}", ("n", msg.first_block_num));
+                EVT_ASSERT(!msg.ends.empty() && msg.ends.size() <= it->second, plugin_exception,
+                           "Peer doesn't send blocks from ${n}", ("n", msg.first_block_num));
+
+                auto blocks = unpack_segment(msg);
+                auto lock   = std::unique_lock<std::mutex>(mtx);
+                // peers send fewer blocks when they're too large for one message
+                if(blocks.size() < it->second) {
+                    pending.emplace(it->first + (uint32_t)blocks.size(), it->second - (uint32_t)blocks.size());
+                }
+                received[it->first] = segment{ std::move(blocks), i };
+                inflight.erase(it);
+                cv.notify_all();
+            }
+        }
+        catch(const fc::exception& e) {
+            wlog("Stopped fetching blocks from peer ${p}: ${e}", ("p", s.peer())("e", e.to_string()));
+        }
+        catch(const std::exception& e) {
+            wlog("Stopped fetching blocks from peer ${p}: ${e}", ("p", s.peer())("e", e.what()));
+        }
+
+        auto lock = std::unique_lock<std::mutex>(mtx);
+        pending.insert(inflight.begin(), inflight.end());
+        active--;
+        cv.notify_all();
+    };
+
+    auto threads = std::vector<std::thread>();
+    for(auto i = 0u; i < sessions.size(); i++) {
+        if(heads[i] > head.block_num) {
+            active++;
+            threads.emplace_back(worker, i);
+        }
+    }
+    auto stop = [&] {
+        {
+            auto lock = std::unique_lock<std::mutex>(mtx);
+            done      = true;
+            cv.notify_all();
+        }
+        for(auto& t : threads) {
+            t.join();
+        }
+    };
+
+    // segments are verified and appended while the next ones are downloaded
+    auto state  = head;
+    auto logged = 0u;
+    try {
+        while(next <= target) {
+            auto seg = segment();
+            {
+                auto lock = std::unique_lock<std::mutex>(mtx);
+                cv.wait(lock, [&] { return received.count(next) || active == 0; });
+                if(!received.count(next)) {
+                    break;
+                }
+                seg = std::move(received[next]);
+                received.erase(next);
+                cv.notify_all();
+            }
+
+            auto states = std::vector<block_header_state>();
+            try {
+                auto s = state;
+                for(auto& b : seg.blocks) {
+                    s = s.next(*b, true /* skip_validate_signee */);
+                    states.emplace_back(s);
+                }
+                verify_blocks(states, seg.blocks);
+            }
+            catch(const fc::exception& e) {
+                wlog("Peer ${p} sent invalid blocks from ${n}: ${e}", ("p", sessions[seg.source]->peer())("n", next)("e", e.to_string()));
+
+                auto lock = std::unique_lock<std::mutex>(mtx);
+                bad[seg.source] = true;
+                pending.emplace(next, (uint32_t)seg.blocks.size());
+                cv.notify_all();
+                continue;
+            }
+
+            append(seg.blocks);
+            state = std::move(states.back());
+            next += seg.blocks.size();
+
+            auto total = target - head.block_num;
+            if((next - head.block_num - 1) * 20 / total > logged) {
+                logged = (next - head.block_num - 1) * 20 / total;
+                ilog("Fetched ${n} of ${t} blocks", ("n", next - head.block_num - 1)("t", total));
+            }
+        }
+    }
+    catch(...) {
+        stop();
+        throw;
+    }
+    stop();
+
+    if(next <= target) {
+        wlog("Fetched blocks up to ${n} only, the ones after it come from the normal sync", ("n", next - 1));
+    }
+    return next - head.block_num - 1;
+}
+
+}  // namespace evt
@@ -0,0 +1,45 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+#include <functional>
+#include <string>
+#include <vector>
+#include <boost/noncopyable.hpp>
+#include <evt/chain/block_header_state.hpp>
+#include <evt/net_plugin/protocol.hpp>
+
+namespace evt {
+
+/**
+ * Downloads the irreversible blocks a node far behind misses from the block logs of its peers
+ *
+ * The blocks are asked for in segments of consecutive blocks, a few segments in flight per peer,
+ * from all the peers having them at once. A peer sends a segment as the packed blocks are in its
+ * block log and they're unpacked on the thread of that peer. Segments are verified in order on
+ * top of the given header state: the headers chain one to the other, then the producer signature
+ * and the transaction merkle root of the blocks are checked on all the cores. Segments of a peer
+ * sending a bad one are fetched from the others.
+ *
+ * It runs before the chain starts, on its own connections, which don't handshake.
+ */
+class block_log_fetcher : boost::noncopyable {
+public:
+    using append_func = std::function<void(const std::vector<chain::signed_block_ptr>&)>;
+
+public:
+    block_log_fetcher(const chain_id_type& chain_id, std::vector<std::string> peers, uint32_t segment_blocks, uint32_t segments_in_flight);
+
+public:
+    // the verified blocks after `head` are handed to `append` in order, returns the number of them
+    uint32_t fetch(const chain::block_header_state& head, const append_func& append);
+
+private:
+    chain_id_type            chain_id_;
+    std::vector<std::string> peers_;
+    uint32_t                 segment_blocks_;
+    uint32_t                 segments_in_flight_;
+};
+
+}  // namespace evt
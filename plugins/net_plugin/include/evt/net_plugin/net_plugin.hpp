@@ -5,6 +5,7 @@
 #pragma once
 #include <appbase/application.hpp>
 #include <evt/chain_plugin/chain_plugin.hpp>
+#include <evt/reactor_plugin/reactor_plugin.hpp>
 #include <evt/net_plugin/protocol.hpp>
 
 namespace evt {
@@ -15,6 +16,32 @@ struct connection_status {
     bool              connecting = false;
     bool              syncing    = false;
     handshake_message last_handshake;
+
+    uint32_t write_queue_msgs  = 0;  // messages waiting to be written
+    uint32_t write_queue_bytes = 0;
+    uint32_t buffers_in_flight = 0;  // buffers of the write in progress
+    uint32_t bytes_in_flight   = 0;
+
+    double   score               = 0;  // in [0, 1], higher is better
+    int64_t  rtt_us              = 0;  // 0 until measured
+    uint64_t useful_bytes        = 0;  // blocks and transactions new to us
+    uint64_t duplicate_bytes     = 0;
+    double   sync_blocks_per_sec = 0;
+};
+
+struct net_stats {
+    uint64_t block_buffer_hits      = 0;  // block messages reused from the buffer cache instead of being packed again
+    uint64_t block_buffer_misses    = 0;
+    uint64_t block_buffers          = 0;  // number of cached block messages
+    uint64_t block_buffer_bytes     = 0;
+    uint64_t trx_buffer_hits        = 0;  // transaction messages shared with more than one peer
+    uint64_t trx_announced          = 0;  // transaction ids announced instead of pushing the bodies
+    uint64_t trx_requested          = 0;  // announced transactions pulled from peers
+    uint64_t compact_blocks_sent    = 0;
+    uint64_t compact_blocks_rebuilt = 0;  // compact blocks rebuilt without fetching any transaction
+    uint64_t compact_blocks_failed  = 0;  // compact blocks given up for the full block
+    uint64_t compress_bytes_in      = 0;  // size of the messages compressed for peers
+    uint64_t compress_bytes_out     = 0;  // ...and after compression
 };
 
 class net_plugin : public appbase::plugin<net_plugin> {
@@ -22,7 +49,7 @@ public:
     net_plugin();
     virtual ~net_plugin();
 
-    APPBASE_PLUGIN_REQUIRES((chain_plugin))
+    APPBASE_PLUGIN_REQUIRES((chain_plugin)(reactor_plugin))
     virtual void set_program_options(options_description& cli, options_description& cfg) override;
     void handle_sighup() override;
 
@@ -36,6 +63,7 @@ public:
     string                      disconnect(const string& endpoint);
     optional<connection_status> status(const string& endpoint) const;
     vector<connection_status>   connections() const;
+    net_stats                   stats() const;
 
     size_t num_peers() const;
 
@@ -45,4 +73,5 @@ private:
 
 }  // namespace evt
 
-FC_REFLECT(evt::connection_status, (peer)(connecting)(syncing)(last_handshake))
+FC_REFLECT(evt::connection_status, (peer)(connecting)(syncing)(last_handshake)(write_queue_msgs)(write_queue_bytes)(buffers_in_flight)(bytes_in_flight)(score)(rtt_us)(useful_bytes)(duplicate_bytes)(sync_blocks_per_sec))
+FC_REFLECT(evt::net_stats, (block_buffer_hits)(block_buffer_misses)(block_buffers)(block_buffer_bytes)(trx_buffer_hits)(trx_announced)(trx_requested)(compact_blocks_sent)(compact_blocks_rebuilt)(compact_blocks_failed)(compress_bytes_in)(compress_bytes_out))
@@ -0,0 +1,133 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/asio/connect.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/read.hpp>
+#include <boost/asio/write.hpp>
+
+#include <fc/io/raw.hpp>
+#include <evt/chain/exceptions.hpp>
+#include <evt/net_plugin/protocol.hpp>
+
+namespace evt {
+
+/**
+ * Blocking connection to a peer, with its own io_context to time out each operation
+ *
+ * Used by the fetchers running before the net plugin starts, it doesn't handshake.
+ */
+class peer_session {
+public:
+    static constexpr auto message_header_size = 4;
+    static constexpr auto max_message_size    = 8 * 1024 * 1024;  // same limit as the net plugin, compressed ones are above it
+    static constexpr auto io_timeout          = std::chrono::seconds(30);
+
+public:
+    explicit peer_session(const std::string& peer)
+        : peer_(peer), socket_(ioc_) {}
+
+public:
+    const std::string& peer() const { return peer_; }
+
+    void
+    connect() {
+        using boost::asio::ip::tcp;
+
+        auto pos = peer_.find(':');
+        EVT_ASSERT(pos != std::string::npos, plugin_config_exception, "Invalid peer address ${p}, expected host:port", ("p", peer_));
+
+        auto resolver  = tcp::resolver(ioc_);
+        auto endpoints = resolver.resolve(peer_.substr(0, pos), peer_.substr(pos + 1));
+        run([&](auto&& h) { boost::asio::async_connect(socket_, endpoints, h); });
+        socket_.set_option(tcp::no_delay(true));
+    }
+
+    void
+    send(const net_message& m) {
+        auto size   = (uint32_t)fc::raw::pack_size(m);
+        auto buffer = std::vector<char>(message_header_size + size);
+        auto ds     = fc::datastream<char*>(buffer.data(), buffer.size());
+        ds.write((const char*)&size, sizeof(size));
+        fc::raw::pack(ds, m);
+        run([&](auto&& h) { boost::asio::async_write(socket_, boost::asio::buffer(buffer), h); });
+    }
+
+    // the other messages the peer may send meanwhile are skipped
+    template<typename T>
+    T
+    receive() {
+        while(true) {
+            auto size = uint32_t(0);
+            run([&](auto&& h) { boost::asio::async_read(socket_, boost::asio::buffer(&size, sizeof(size)), h); });
+            EVT_ASSERT(size > 0 && size <= max_message_size, plugin_exception,
+                       "Unexpected message length ${s} from ${p}", ("s", size)("p", peer_));
+
+            buffer_.resize(size);
+            run([&](auto&& h) { boost::asio::async_read(socket_, boost::asio::buffer(buffer_), h); });
+
+            auto ds  = fc::datastream<const char*>(buffer_.data(), buffer_.size());
+            auto msg = net_message();
+            fc::raw::unpack(ds, msg);
+            if(msg.contains<T>()) {
+                return std::move(msg.get<T>());
+            }
+            if(msg.contains<go_away_message>()) {
+                EVT_THROW(plugin_exception, "Peer ${p} went away: ${r}",
+                          ("p", peer_)("r", reason_str(msg.get<go_away_message>().reason)));
+            }
+        }
+    }
+
+private:
+    // runs one asynchronous operation, the socket is closed when it takes too long
+    template<typename Op>
+    void
+    run(Op&& op) {
+        auto ec   = boost::system::error_code();
+        auto done = false;
+        op([&](const boost::system::error_code& e, auto&&...) {
+            ec   = e;
+            done = true;
+        });
+
+        ioc_.restart();
+        ioc_.run_for(io_timeout);
+        if(!done) {
+            socket_.close();
+            ioc_.restart();
+            ioc_.run();
+            EVT_THROW(plugin_exception, "Timeout talking to peer ${p}", ("p", peer_));
+        }
+        EVT_ASSERT(!ec, plugin_exception, "Failed talking to peer ${p}: ${e}", ("p", peer_)("e", ec.message()));
+    }
+
+private:
+    std::string                  peer_;
+    boost::asio::io_context      ioc_;
+    boost::asio::ip::tcp::socket socket_;
+    std::vector<char>            buffer_;
+};
+
+// calls `f(i)` for each i in [0, n) on a thread of its own
+template<typename Func>
+void
+for_each_parallel(size_t n, Func&& f) {
+    auto threads = std::vector<std::thread>();
+    for(auto i = 0u; i < n; i++) {
+        threads.emplace_back([&f, i] { f(i); });
+    }
+    for(auto& t : threads) {
+        t.join();
+    }
+}
+
+}  // namespace evt
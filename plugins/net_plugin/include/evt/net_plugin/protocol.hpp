@@ -161,6 +161,134 @@ struct sync_request_message {
     uint32_t end_block;
 };
 
+/**
+ * Compact transaction id used by announcements, the leading 64 bits of the full id
+ */
+using short_trx_id = uint64_t;
+
+inline short_trx_id
+to_short_trx_id(const transaction_id_type& id) {
+    return id._hash[0];
+}
+
+/**
+ * Batch of transactions the sender has accepted, peers pull the ones they miss
+ * with a `trx_request_message`. Only sent to peers from `proto_trx_announce` on.
+ */
+struct trx_announce_message {
+    vector<short_trx_id> ids;
+};
+
+struct trx_request_message {
+    vector<short_trx_id> ids;
+};
+
+struct compact_trx_receipt : public transaction_receipt_header {
+    short_trx_id id = 0;
+};
+
+struct indexed_trx {
+    uint32_t           index = 0;  ///< position of the receipt in the block
+    packed_transaction trx;
+};
+
+/**
+ * Block with the transactions replaced by their short ids, receivers rebuild it
+ * from the transactions they already have and fetch the missing ones with a
+ * `block_trxs_request_message`. Only sent to peers from `proto_compact_block` on.
+ */
+struct compact_block_message {
+    signed_block_header         header;
+    vector<compact_trx_receipt> receipts;
+    vector<indexed_trx>         prefilled;  ///< transactions peers can't have seen, like the suspend ones
+    extensions_type             block_extensions;
+};
+
+struct block_trxs_request_message {
+    block_id_type    id;
+    vector<uint32_t> indexes;
+};
+
+struct block_trxs_message {
+    block_id_type       id;
+    vector<indexed_trx> trxs;
+};
+
+/**
+ * Asks the peer to send the following messages as zstd frames, marked by the top bit of
+ * their length header. `dict_id` identifies the dictionary of the requester, 0 for none,
+ * the peer only uses its own dictionary when the ids match.
+ * Only sent to peers from `proto_compression` on.
+ */
+struct compression_request_message {
+    uint32_t dict_id = 0;
+};
+
+/**
+ * Tells the peer the first block it can still ask for, the ones before it are pruned from
+ * the block log of the sender. Sent after the handshake and again when the peer asks for
+ * blocks older than that. Only sent to peers from `proto_block_range` on.
+ */
+struct block_range_message {
+    uint32_t first_block_num = 0;
+};
+
+/**
+ * Asks the peer for the snapshot it offers, which replies with a `snapshot_offer_message`.
+ * Sent by joining nodes right after connecting, without any handshake.
+ * Only answered by peers from `proto_snapshot_sync` on, older ones drop the connection.
+ */
+struct snapshot_query_message {
+    chain_id_type chain_id;
+};
+
+/**
+ * Latest full snapshot of the peer, split in chunks of `chunk_size` bytes, the last one may be
+ * shorter. `hash` is the digest of the chunk digests and identifies the snapshot.
+ * An offer without chunks means the peer has no snapshot to give.
+ */
+struct snapshot_offer_message {
+    block_id_type      head_id;
+    uint64_t           size       = 0;
+    uint32_t           chunk_size = 0;
+    fc::sha256         hash;
+    vector<fc::sha256> chunk_hashes;
+};
+
+struct snapshot_chunk_request_message {
+    fc::sha256 hash;
+    uint32_t   index = 0;
+};
+
+struct snapshot_chunk_message {
+    fc::sha256   hash;
+    uint32_t     index = 0;
+    vector<char> data;  ///< empty when the peer doesn't offer that snapshot anymore
+};
+
+/**
+ * Asks the peer for up to `count` irreversible blocks of its block log from `first_block_num`,
+ * which replies with a `block_log_segment_message`. Sent by nodes far behind before they start,
+ * without any handshake. Only answered by peers from `proto_block_log_sync` on.
+ */
+struct block_log_segment_request_message {
+    chain_id_type chain_id;
+    uint32_t      first_block_num = 0;
+    uint32_t      count           = 0;  ///< none only asks for `head_block_num`
+};
+
+/**
+ * Packed blocks as they are in the block log of the peer, the i-th one of the segment is in
+ * `data` from `ends[i - 1]` to `ends[i]`. There may be fewer blocks than asked, none when the
+ * peer doesn't have the first one.
+ */
+struct block_log_segment_message {
+    uint32_t         head_block_num  = 0;  ///< last irreversible block of the peer
+    uint32_t         first_block_num = 0;
+    vector<uint32_t> ends;
+    vector<char>     data;
+};
+
 using net_message = static_variant<handshake_message,
                                    chain_size_message,
                                    go_away_message,
@@ -168,8 +296,21 @@ using net_message = static_variant<handshake_message,
                                    notice_message,
                                    request_message,
                                    sync_request_message,
-                                   signed_block,         // which = 7
-                                   packed_transaction>;  // which = 8
+                                   signed_block,                       // which = 7
+                                   packed_transaction,                 // which = 8
+                                   trx_announce_message,               // which = 9
+                                   trx_request_message,                // which = 10
+                                   compact_block_message,              // which = 11
+                                   block_trxs_request_message,         // which = 12
+                                   block_trxs_message,                 // which = 13
+                                   compression_request_message,        // which = 14
+                                   block_range_message,                // which = 15
+                                   snapshot_query_message,             // which = 16
+                                   snapshot_offer_message,             // which = 17
+                                   snapshot_chunk_request_message,     // which = 18
+                                   snapshot_chunk_message,             // which = 19
+                                   block_log_segment_request_message,  // which = 20
+                                   block_log_segment_message>;         // which = 21
 
 }  // namespace evt
 
@@ -183,6 +324,21 @@ FC_REFLECT(evt::time_message, (org)(rec)(xmt)(dst));
 FC_REFLECT(evt::notice_message, (known_trx)(known_blocks));
 FC_REFLECT(evt::request_message, (req_trx)(req_blocks));
 FC_REFLECT(evt::sync_request_message, (start_block)(end_block));
+FC_REFLECT(evt::trx_announce_message, (ids));
+FC_REFLECT(evt::trx_request_message, (ids));
+FC_REFLECT_DERIVED(evt::compact_trx_receipt, (evt::chain::transaction_receipt_header), (id));
+FC_REFLECT(evt::indexed_trx, (index)(trx));
+FC_REFLECT(evt::compact_block_message, (header)(receipts)(prefilled)(block_extensions));
+FC_REFLECT(evt::block_trxs_request_message, (id)(indexes));
+FC_REFLECT(evt::block_trxs_message, (id)(trxs));
+FC_REFLECT(evt::compression_request_message, (dict_id));
+FC_REFLECT(evt::block_range_message, (first_block_num));
+FC_REFLECT(evt::snapshot_query_message, (chain_id));
+FC_REFLECT(evt::snapshot_offer_message, (head_id)(size)(chunk_size)(hash)(chunk_hashes));
+FC_REFLECT(evt::snapshot_chunk_request_message, (hash)(index));
+FC_REFLECT(evt::snapshot_chunk_message, (hash)(index)(data));
+FC_REFLECT(evt::block_log_segment_request_message, (chain_id)(first_block_num)(count));
+FC_REFLECT(evt::block_log_segment_message, (head_block_num)(first_block_num)(ends)(data));
 
 /**
  *
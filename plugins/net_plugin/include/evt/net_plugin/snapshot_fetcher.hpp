@@ -0,0 +1,39 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+#include <optional>
+#include <string>
+#include <vector>
+#include <boost/noncopyable.hpp>
+#include <fc/filesystem.hpp>
+#include <evt/net_plugin/protocol.hpp>
+
+namespace evt {
+
+/**
+ * Downloads the snapshot offered by peers for a node joining the network
+ *
+ * Every peer is asked for its offer, the one with the latest head block is taken and its chunks
+ * are fetched from all the peers offering the same snapshot at once, a few chunks in flight per
+ * peer. Each chunk is checked against its digest in the offer, and the chunk digests against the
+ * digest of the offer. Chunks of a peer failing are fetched from the others.
+ *
+ * It runs before the net plugin starts, on its own connections, which don't handshake.
+ */
+class snapshot_fetcher : boost::noncopyable {
+public:
+    snapshot_fetcher(const chain_id_type& chain_id, std::vector<std::string> peers, uint32_t chunks_in_flight);
+
+public:
+    // writes the snapshot to `path`, returns its head block id or nothing when no peer offers one
+    std::optional<block_id_type> fetch(const fc::path& path);
+
+private:
+    chain_id_type            chain_id_;
+    std::vector<std::string> peers_;
+    uint32_t                 chunks_in_flight_;
+};
+
+}  // namespace evt
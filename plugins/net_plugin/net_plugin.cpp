@@ -4,6 +4,8 @@
  */
 #include <evt/net_plugin/net_plugin.hpp>
 #include <evt/net_plugin/protocol.hpp>
+#include <evt/net_plugin/snapshot_fetcher.hpp>
+#include <evt/net_plugin/block_log_fetcher.hpp>
 
 #include <boost/asio/read.hpp>
 #include <boost/asio/write.hpp>
@@ -16,17 +18,29 @@
 #include <fc/io/json.hpp>
 #include <fc/io/raw.hpp>
 #include <fc/log/appender.hpp>
+#include <fc/log/trace.hpp>
 #include <fc/reflect/variant.hpp>
 #include <fc/crypto/rand.hpp>
 #include <fc/exception/exception.hpp>
+#include <fc/io/fstream.hpp>
+#include <fc/filesystem.hpp>
 
 #include <evt/chain/types.hpp>
 #include <evt/chain/controller.hpp>
 #include <evt/chain/exceptions.hpp>
 #include <evt/chain/block.hpp>
+#include <evt/chain/merkle.hpp>
 #include <evt/chain/plugin_interface.hpp>
 #include <evt/chain/multi_index_includes.hpp>
 #include <evt/producer_plugin/producer_plugin.hpp>
+#include <evt/utilities/memory_budget.hpp>
+#include <evt/utilities/metrics.hpp>
+
+#include <fstream>
+#include <mutex>
+
+#include <zstd.h>
+#include <zdict.h>
 
 using namespace evt::chain::plugin_interface::compat;
 
@@ -64,9 +78,13 @@ struct node_transaction_state {
     time_point_sec                expires;         /// time after which this may be purged.
     uint32_t                      block_num = 0;   /// block transaction was included in
     std::shared_ptr<vector<char>> serialized_txn;  /// the received raw bundle
+    packed_transaction_ptr        packed_trx;      /// used to rebuild compact blocks
+
+    short_trx_id short_id() const { return to_short_trx_id(id); }
 };
 
 struct by_expiry;
+struct by_short_id;
 struct by_block_num;
 
 struct sha256_less {
@@ -93,9 +111,59 @@ typedef multi_index_container<
             tag<by_block_num>,
             member<node_transaction_state,
                    uint32_t,
-                   &node_transaction_state::block_num>>>>
+                   &node_transaction_state::block_num>>,
+        ordered_non_unique<
+            tag<by_short_id>,
+            const_mem_fun<node_transaction_state,
+                          short_trx_id,
+                          &node_transaction_state::short_id>>>>
     node_transaction_index;
 
+/**
+ * Announced transaction pulled from a peer, the other peers which announced it
+ * are asked in turn if the request isn't answered in time.
+ */
+struct trx_pull_state {
+    time_point                   requested;
+    bool                         received = false;
+    std::vector<connection_wptr> sources;
+};
+
+/**
+ * Compact block waiting for its missing transactions
+ */
+struct compact_block_state {
+    connection_wptr  source;
+    signed_block_ptr block;
+    vector<uint32_t> missing;
+    time_point       requested;
+};
+
+/**
+ * Classes of outgoing and incoming traffic, in priority order. Writes give each
+ * class a budget of bytes per round so a flood of one class can't hold the others
+ * back, reads are handled on app thread at the priority of their class.
+ */
+enum traffic_class : uint8_t {
+    block_traffic = 0,  ///< new blocks and what's needed to rebuild them
+    control_traffic,    ///< handshakes, notices and requests
+    sync_traffic,       ///< blocks sent to a syncing peer
+    trx_traffic,        ///< transactions and their announcements
+    traffic_classes
+};
+
+/**
+ * Message unpacked on net threads, blocks and transactions are kept apart
+ * so they don't need to be moved out of `msg` again on app thread.
+ */
+struct decoded_message {
+    net_message              msg;
+    signed_block_ptr         block;
+    block_state_ptr          verified;  ///< header state of `block` checked on net threads, if its previous one is known there
+    fc::exception_ptr        error;     ///< why `block` failed those checks, it's then dropped on app thread
+    transaction_metadata_ptr trx;
+};
+
 class net_plugin_impl {
 public:
     unique_ptr<tcp::acceptor> acceptor;
@@ -130,6 +198,8 @@ public:
     unique_ptr<boost::asio::steady_timer> connector_check;
     unique_ptr<boost::asio::steady_timer> transaction_check;
     unique_ptr<boost::asio::steady_timer> keepalive_timer;
+    unique_ptr<boost::asio::steady_timer> trx_announce_timer;
+    bool                                  trx_announce_scheduled = false;
     boost::asio::steady_timer::duration   connector_period;
     boost::asio::steady_timer::duration   txn_exp_period;
     boost::asio::steady_timer::duration   resp_expected_period;
@@ -147,7 +217,27 @@ public:
     producer_plugin* producer_plug    = nullptr;
     int              started_sessions = 0;
 
-    node_transaction_index local_txns;
+    node_transaction_index                 local_txns;
+    std::map<short_trx_id, trx_pull_state> requested_trxs;
+
+    std::map<block_id_type, compact_block_state> compact_blocks;
+
+    vector<string> compress_peers;  ///< peers asked to compress what they send us
+    int            compress_level    = 0;
+    uint32_t       compress_min_size = 0;
+
+    std::array<uint32_t, traffic_classes> traffic_budgets{};   ///< bytes per write round of each class
+    std::array<uint64_t, traffic_classes> traffic_queued{};    ///< bytes waiting in all the write queues
+    uint64_t                              max_trx_in_progress       = 0;  ///< per connection, reads pause above it
+    uint64_t                              max_trx_in_progress_total = 0;  ///< all connections, announced trxs aren't pulled above it
+    uint64_t                              max_trx_queued_total      = 0;  ///< all connections, trxs aren't relayed above it
+    uint64_t                              trx_in_progress_total     = 0;
+    uint32_t                              trx_relay_fanout          = 0;  ///< peers a transaction is relayed to, 0 for all
+    uint32_t       compress_dict_id  = 0;
+
+    std::unique_ptr<ZSTD_CCtx, decltype(&ZSTD_freeCCtx)>   compress_ctx{nullptr, &ZSTD_freeCCtx};  // only used on app thread
+    std::unique_ptr<ZSTD_CDict, decltype(&ZSTD_freeCDict)> compress_cdict{nullptr, &ZSTD_freeCDict};
+    std::unique_ptr<ZSTD_DDict, decltype(&ZSTD_freeDDict)> compress_ddict{nullptr, &ZSTD_freeDDict};  // shared by net threads, read only
 
     shared_ptr<tcp::resolver> resolver;
 
@@ -155,9 +245,17 @@ public:
 
     channels::transaction_ack::channel_type::handle incoming_transaction_ack_subscription;
 
-    optional<std::thread>                    server_thread;
+    uint16_t                                 thread_pool_size = 2;
+    std::vector<std::thread>                 server_threads;
     std::shared_ptr<boost::asio::io_context> server_ioc;
     optional<io_work_t>                      server_ioc_work;
+    reactor_plugin*                          reactors = nullptr;
+
+    /** context of a new connection, spread over the shared reactors when they are enabled */
+    std::shared_ptr<boost::asio::io_context>
+    next_ioc() {
+        return reactors->enabled() ? reactors->next() : server_ioc;
+    }
 
     void connect(const connection_ptr& c);
     void connect(const connection_ptr& c, tcp::resolver::iterator endpoint_itr);
@@ -165,22 +263,95 @@ public:
     void start_listen_loop();
     void start_read_message(const connection_ptr& c);
 
-    /** \brief Process the next message from the pending message buffer
+    /** \brief Decode the complete messages in the pending message buffer
+     *
+     * Runs on net threads after `bytes_transferred` bytes are read.
+     * Blocks and transactions are unpacked, transaction ids are calculated
+     * and the recovery of signing keys is started here.
+     * Returns false if the connection should be closed after the decoded
+     * messages are processed.
+     */
+    bool decode_messages(const connection_ptr& conn, std::size_t bytes_transferred, std::vector<decoded_message>& msgs);
+    template<typename Stream>
+    void decode_next_message(Stream& ds, std::vector<decoded_message>& msgs);
+
+    /** \brief Stateless checks of a received block on net threads
+     *
+     * Header, producer signature and merkle root of the receipts are checked by
+     * `controller::verify_block` when the header state of the previous block is known
+     * here: the last block accepted or the last one verified from the same peer.
+     * Invalid blocks are dropped before they reach the controller.
+     */
+    void verify_block(const connection_ptr& conn, decoded_message& dm);
+
+    std::mutex                                verify_mtx;
+    std::shared_ptr<const block_header_state> verify_base;  ///< header state of the last accepted block, guarded by `verify_mtx`
+
+    /** \brief Process one decoded message on app thread
      *
-     * Process the next message from the pending_message_buffer.
-     * message_length is the already determined length of the data
-     * part of the message that will handle the message.
      * Returns true is successful. Returns false if an error was
-     * encountered unpacking or processing the message.
+     * encountered processing the message.
      */
-    bool process_next_message(const connection_ptr& conn, uint32_t message_length);
+    bool process_decoded_message(const connection_ptr& conn, decoded_message& msg);
 
     void   close(const connection_ptr& c);
+    bool   evict_client();  ///< closes the worst scored client, if any is bad enough
     size_t count_open_sockets() const;
 
     template<typename VerifierFunc>
     void send_transaction_to_all(const std::shared_ptr<std::vector<char>>& send_buffer, VerifierFunc verify);
 
+    /** \brief Announce a transaction id to a peer instead of sending the body
+     *
+     * Ids are queued per connection and sent in batches of up to
+     * `def_trx_announce_batch`, at most `def_trx_announce_delay` later.
+     */
+    void queue_trx_announce(const connection_ptr& c, short_trx_id id);
+    void send_trx_announces();
+    void retry_trx_pulls();
+
+    /** \brief Rebuild blocks relayed as `compact_block_message`
+     *
+     * Transactions are taken from `local_txns` and the pending block, the
+     * missing ones are fetched from the sender. The rebuilt block is checked
+     * against its `transaction_mroot`, the full block is requested from the
+     * sender if it doesn't match or the missing transactions don't arrive in time.
+     */
+    std::shared_ptr<std::vector<char>> create_compact_block_buffer(const signed_block& sb);
+    void finish_compact_block(const connection_ptr& c, const signed_block_ptr& blk);
+    void request_full_block(const connection_ptr& c, const block_id_type& id);
+    void expire_compact_blocks();
+
+    /** \brief Optional zstd compression of the messages sent to a peer
+     *
+     * A node asks the peers listed in `p2p-compress-peer` to compress with a
+     * `compression_request_message`. Each message is then compressed on its own,
+     * with the shared dictionary when both sides loaded the same one.
+     */
+    bool compress_peer(const connection_ptr& c) const;
+    std::shared_ptr<std::vector<char>> compress_message(const std::shared_ptr<std::vector<char>>& buff, bool use_dict);
+    void decode_compressed_message(const connection_ptr& conn, uint32_t size, std::vector<decoded_message>& msgs);
+
+    /** \brief Serialized block messages shared by all the connections
+     *
+     * Blocks are packed only once no matter how many peers they're sent to,
+     * either broadcasted or replied to sync and fetch requests.
+     * The most recent ones are kept until `def_block_buffer_cache_size` bytes.
+     */
+    std::shared_ptr<std::vector<char>> get_block_send_buffer(const signed_block_ptr& sb, const block_id_type& id);
+    std::shared_ptr<std::vector<char>> get_block_send_buffer(const std::string_view& packed_block);
+    std::shared_ptr<std::vector<char>> get_block_send_buffer(const block_id_type& id, const std::function<std::shared_ptr<std::vector<char>>()>& create);
+
+    std::map<block_id_type, std::shared_ptr<std::vector<char>>> block_buffers;
+    std::deque<block_id_type>                                   block_buffers_order;
+    net_stats                                                   stats;
+
+    std::optional<utilities::metrics::collector_id> metrics_collector;
+    std::optional<utilities::memory::component_id>  memory_component;
+    uint64_t                                        write_queues_budget = 0;  ///< reads of all peers pause above it, 0 for no budget
+
+    uint64_t write_queues_size() const;
+
     void accepted_block(const block_state_ptr&);
     void transaction_ack(const std::pair<fc::exception_ptr, transaction_metadata_ptr>&);
 
@@ -209,8 +380,50 @@ public:
     void handle_message(const connection_ptr& c, const sync_request_message& msg);
     void handle_message(const connection_ptr& c, const signed_block& msg) = delete;  // signed_block_ptr overload used instead
     void handle_message(const connection_ptr& c, const signed_block_ptr& msg);
+    void apply_block(const connection_ptr& c, const signed_block_ptr& msg);  // after sync_manager has seen it
     void handle_message(const connection_ptr& c, const packed_transaction& msg) = delete;  // packed_transaction_ptr overload used instead
     void handle_message(const connection_ptr& c, const packed_transaction_ptr& msg);
+    void handle_message(const connection_ptr& c, const transaction_metadata_ptr& msg);
+    void handle_message(const connection_ptr& c, const trx_announce_message& msg);
+    void handle_message(const connection_ptr& c, const trx_request_message& msg);
+    void handle_message(const connection_ptr& c, const compact_block_message& msg);
+    void handle_message(const connection_ptr& c, const block_trxs_request_message& msg);
+    void handle_message(const connection_ptr& c, const block_trxs_message& msg);
+    void handle_message(const connection_ptr& c, const compression_request_message& msg);
+    void handle_message(const connection_ptr& c, const block_range_message& msg);
+
+    void send_block_range(const connection_ptr& c);
+
+    /** \brief Snapshots offered to joining nodes, see `snapshot_fetcher`
+     *
+     * The latest full snapshot in `snapshots_dir` is offered when `serve_snapshots` is set.
+     * The digests of its chunks are computed on net threads the first time it's asked for,
+     * and kept until a newer snapshot shows up. Chunks are read on net threads as well.
+     */
+    void handle_message(const connection_ptr& c, const snapshot_query_message& msg);
+    void handle_message(const connection_ptr& c, const snapshot_offer_message& msg);
+    void handle_message(const connection_ptr& c, const snapshot_chunk_request_message& msg);
+    void handle_message(const connection_ptr& c, const snapshot_chunk_message& msg);
+
+    optional<fc::path> latest_snapshot() const;
+    void               prepare_snapshot_offer(const fc::path& path);
+    void               fetch_snapshot(uint32_t chunks_in_flight);
+
+    bool                                          serve_snapshots = false;
+    fc::path                                      snapshots_dir;
+    fc::path                                      snapshot_offer_path;
+    std::shared_ptr<const snapshot_offer_message> snapshot_offer;  ///< offer of `snapshot_offer_path`, null while it's prepared
+    std::vector<std::weak_ptr<connection>>        snapshot_waiters;  ///< queries waiting for the offer being prepared
+
+    /** \brief Segments of the block log sent to nodes far behind, see `block_log_fetcher`
+     *
+     * Irreversible blocks are copied from the mapped block log as they are, up to
+     * `def_block_log_segment_size` bytes in one message.
+     */
+    void handle_message(const connection_ptr& c, const block_log_segment_request_message& msg);
+    void handle_message(const connection_ptr& c, const block_log_segment_message& msg);
+
+    void fetch_block_log(uint32_t segment_blocks, uint32_t segments_in_flight);
 
     void start_conn_timer(boost::asio::steady_timer::duration du, std::weak_ptr<connection> from_connection);
     void start_txn_timer();
@@ -297,19 +510,88 @@ static net_plugin_impl* my_impl;
 constexpr auto                              def_send_buffer_size_mb  = 4;
 constexpr auto                              def_send_buffer_size     = 1024 * 1024 * def_send_buffer_size_mb;
 constexpr auto                              def_max_write_queue_size = def_send_buffer_size * 10;
+constexpr auto                              def_slab_size            = 16 * 1024;  // small messages are packed together into slabs
+constexpr auto                              def_small_message_size   = 1024;
+constexpr auto                              def_max_free_slabs       = 4;          // per connection
+constexpr auto                              def_max_write_buffers    = 64;         // per async_write
+constexpr auto                              def_max_write_bytes      = def_send_buffer_size;
+constexpr std::array<uint32_t, traffic_classes> def_traffic_budgets = {{  // bytes per write round
+    1024 * 1024,  // block_traffic
+    256 * 1024,   // control_traffic
+    512 * 1024,   // sync_traffic
+    128 * 1024    // trx_traffic
+}};
 constexpr boost::asio::chrono::milliseconds def_read_delay_for_full_write_queue{100};
 constexpr auto                              def_max_reads_in_flight      = 1000;
 constexpr auto                              def_max_trx_in_progress_size = 100 * 1024 * 1024;  // 100 MB
+constexpr auto                              def_max_trx_in_progress_total = 400 * 1024 * 1024;  // 400 MB
+constexpr auto                              def_max_trx_queued_total     = 200 * 1024 * 1024;  // 200 MB
+constexpr uint64_t                          def_score_prior_bytes        = 64 * 1024;  // peers start as if half of this much was useful
+constexpr int64_t                           def_score_rtt_us             = 100000;     // latency scores 0.5 at 100ms
+constexpr double                            def_score_sync_rate          = 100;        // sync scores 0.5 at 100 blocks/s
+constexpr auto                              def_evict_min_age_secs       = 60;  // clients are scored this long before eviction
+constexpr auto                              def_dead_peer_keepalives     = 4;  // silent for this many keepalive intervals
 constexpr auto                              def_max_clients              = 25;                 // 0 for unlimited clients
 constexpr auto                              def_max_nodes_per_host       = 1;
 constexpr auto                              def_conn_retry_wait          = 30;
 constexpr auto                              def_txn_expire_wait          = std::chrono::seconds(3);
 constexpr auto                              def_resp_expected_wait       = std::chrono::seconds(5);
 constexpr auto                              def_sync_fetch_span          = 100;
+constexpr uint32_t                          def_sync_window_spans        = 4;    // reorder window, in largest adaptive spans
+constexpr uint32_t                          def_sync_span_factor         = 8;    // adaptive span stays within [span / 8, span * 8]
+constexpr auto                              def_sync_chunk_secs          = 1.0;  // a chunk should keep its peer busy this long
+constexpr auto                              def_sync_chunk_rtts          = 4.0;  // ...and cover at least this many round trips
+constexpr auto                              def_sync_straggler_factor    = 4.0;
+constexpr auto                              def_block_buffer_cache_size  = 64 * 1024 * 1024;  // 64 MB
+constexpr auto                              def_trx_announce_batch       = 256;
+constexpr auto                              def_compress_level           = 3;
+constexpr auto                              def_compress_min_size        = 256;  // smaller messages are sent as they are
+constexpr auto                              def_trx_announce_delay       = std::chrono::milliseconds(10);
+constexpr auto                              def_snapshot_chunk_size      = 1024 * 1024;
+constexpr auto                              def_snapshot_chunks_in_flight = 4;  // per peer a snapshot is downloaded from
+constexpr auto                              def_block_log_segment_size   = 4 * 1024 * 1024;
+constexpr auto                              def_block_log_segment_blocks = 1000;
+constexpr auto                              def_block_log_segments_in_flight = 4;  // per peer blocks are fetched from
 
 constexpr auto     message_header_size = 4;
+constexpr uint32_t compressed_message_flag = 0x80000000;  // top bit of the length header, payload is a zstd frame
 constexpr uint32_t signed_block_which = 7;        // see protocol net_message
 constexpr uint32_t packed_transaction_which = 8;  // see protocol net_message
+constexpr uint32_t compact_block_which = 11;      // see protocol net_message
+
+static traffic_class
+message_traffic(const net_message& m) {
+    if(m.contains<signed_block>() || m.contains<compact_block_message>()
+       || m.contains<block_trxs_request_message>() || m.contains<block_trxs_message>()) {
+        return block_traffic;
+    }
+    if(m.contains<packed_transaction>() || m.contains<trx_announce_message>() || m.contains<trx_request_message>()) {
+        return trx_traffic;
+    }
+    if(m.contains<snapshot_offer_message>() || m.contains<snapshot_chunk_message>() || m.contains<block_log_segment_message>()) {
+        return sync_traffic;
+    }
+    return control_traffic;
+}
+
+/**
+ * Priority on app thread of a batch read from a connection, the one of its most
+ * urgent message. Sync blocks can't be told apart from new ones here, both go high.
+ */
+static int
+read_priority(const std::vector<decoded_message>& msgs) {
+    auto cls = trx_traffic;
+    for(auto& m : msgs) {
+        // blocks and transactions are moved out of `msg` when decoded
+        cls = std::min(cls, m.block ? block_traffic : m.trx ? trx_traffic : message_traffic(m.msg));
+    }
+    switch(cls) {
+    case block_traffic:   return priority::high;
+    case control_traffic: return priority::medium;
+    case sync_traffic:    return priority::medium;
+    default:              return priority::low;
+    }
+}
 
 /**
  *  For a while, network version was a 16 bit value equal to the second set of 16 bits
@@ -331,8 +613,14 @@ constexpr uint16_t net_version_range = 106;
  */
 constexpr uint16_t proto_base          = 0;
 constexpr uint16_t proto_explicit_sync = 1;
+constexpr uint16_t proto_trx_announce  = 2;  // transactions are announced by id and pulled on demand
+constexpr uint16_t proto_compact_block = 3;  // blocks are relayed as header and short transaction ids
+constexpr uint16_t proto_compression   = 4;  // messages may be zstd compressed on request
+constexpr uint16_t proto_block_range   = 5;  // peers with pruned block log tell the first block they have
+constexpr uint16_t proto_snapshot_sync = 6;  // snapshots are offered to joining nodes and sent in chunks
+constexpr uint16_t proto_block_log_sync = 7;  // block log segments are sent to nodes far behind
 
-constexpr uint16_t net_version = proto_explicit_sync;
+constexpr uint16_t net_version = proto_block_log_sync;
 
 struct transaction_state {
     transaction_id_type id;
@@ -396,89 +684,197 @@ struct sync_state {
     time_point start_time;  ///< time request made or received
 };
 
+struct sync_peer_stats {
+    double           blocks_per_sec = 0;  ///< smoothed throughput over the completed sync chunks
+    fc::microseconds rtt;                 ///< delay between the last chunk request and its first block
+};
+
+/**
+ * Scorecard of a peer: how fast it answers and how much of what it sends is new
+ * to us, together with its `sync_peer_stats`. Sync prefers the better peers,
+ * transactions are relayed to them first and the worst client makes room for a
+ * new one when `max-clients` is reached.
+ */
+struct peer_score {
+    fc::microseconds rtt;                  ///< smoothed round trip of time_message, 0 until measured
+    uint64_t         useful_bytes    = 0;  ///< blocks and transactions new to us
+    uint64_t         duplicate_bytes = 0;  ///< ...and the ones we had already
+    fc::time_point   connected;
+    fc::time_point   last_recv;
+
+    void
+    add_rtt(fc::microseconds sample) {
+        rtt = rtt.count() > 0 ? fc::microseconds((rtt.count() * 7 + sample.count()) / 8) : sample;
+    }
+
+    /** in [0, 1], a peer nothing is known about yet is at 0.5 */
+    double
+    value(const sync_peer_stats& sync) const {
+        auto useful  = double(useful_bytes + def_score_prior_bytes) / (useful_bytes + duplicate_bytes + 2 * def_score_prior_bytes);
+        auto latency = rtt.count() > 0 ? def_score_rtt_us / double(def_score_rtt_us + rtt.count()) : 0.5;
+        auto speed   = sync.blocks_per_sec > 0 ? sync.blocks_per_sec / (sync.blocks_per_sec + def_score_sync_rate) : 0.5;
+        return (useful + latency + speed) / 3;
+    }
+};
+
 struct handshake_initializer {
     static void populate(handshake_message& hello);
 };
 
+/**
+ * Outgoing messages of a connection, one queue per `traffic_class`. Small messages are
+ * packed next to each other into slabs recycled by the queue, shared buffers like
+ * blocks and transactions are queued as they are. Each `async_write` gathers a
+ * bounded number of them, taking at most the budget of each class in priority order.
+ */
 class queued_buffer : boost::noncopyable {
 public:
+    void init(const std::array<uint32_t, traffic_classes>& budgets, std::array<uint64_t, traffic_classes>& queued) {
+        _budgets = &budgets;
+        _queued  = &queued;
+    }
+
     void clear_write_queue() {
-        _write_queue.clear();
-        _sync_write_queue.clear();
+        for(auto i = 0; i < traffic_classes; i++) {
+            _write_queues[i].clear();
+            (*_queued)[i] -= _queue_bytes[i];
+            _queue_bytes[i] = 0;
+            _credits[i]     = 0;
+        }
         _write_queue_size = 0;
+        _write_queue_msgs = 0;
     }
 
     void clear_out_queue() {
         while(_out_queue.size() > 0) {
+            auto& m = _out_queue.front();
+            // nobody else references a slab once it's written
+            if(m.slab && m.buff.use_count() == 1 && _free_slabs.size() < def_max_free_slabs) {
+                m.buff->clear();
+                _free_slabs.emplace_back(std::move(m.buff));
+            }
             _out_queue.pop_front();
         }
+        _out_queue_size = 0;
     }
 
     uint32_t write_queue_size() const { return _write_queue_size; }
+    uint32_t write_queue_size(traffic_class cls) const { return _queue_bytes[cls]; }
+    uint32_t write_queue_msgs() const { return _write_queue_msgs; }
+    uint32_t out_queue_size() const { return _out_queue_size; }
+    uint32_t out_queue_buffers() const { return _out_queue.size(); }
 
     bool is_out_queue_empty() const { return _out_queue.empty(); }
 
     bool ready_to_send() const {
         // if out_queue is not empty then async_write is in progress
-        return ((!_sync_write_queue.empty() || !_write_queue.empty()) && _out_queue.empty());
+        return _write_queue_msgs > 0 && _out_queue.empty();
     }
 
     bool add_write_queue(const std::shared_ptr<vector<char>>& buff,
                          std::function<void(boost::system::error_code, std::size_t)>
                              callback,
-                         bool to_sync_queue) {
-        if(to_sync_queue) {
-            _sync_write_queue.push_back({buff, callback});
-        }
-        else {
-            _write_queue.push_back({buff, callback});
-        }
-        _write_queue_size += buff->size();
-        if(_write_queue_size > 2 * def_max_write_queue_size) {
-            return false;
+                         traffic_class cls) {
+        _write_queues[cls].push_back({buff, callback, false, 1});
+        return added(cls, buff->size());
+    }
+
+    /**
+     * Appends a message of `size` bytes to the slab at the end of the queue of `cls`,
+     * `pack` writes the message to the memory passed to it.
+     */
+    template<typename Packer>
+    bool add_small_write(uint32_t size, traffic_class cls, Packer&& pack) {
+        auto& w_queue = _write_queues[cls];
+        if(w_queue.empty() || !w_queue.back().slab || w_queue.back().buff->size() + size > def_slab_size) {
+            w_queue.push_back({get_slab(), nullptr, true, 0});
         }
-        return true;
+        w_queue.back().msgs++;
+        auto& buff = *w_queue.back().buff;
+        auto  pos  = buff.size();
+        buff.resize(pos + size);  // within the reserved capacity
+        pack(buff.data() + pos, size);
+
+        return added(cls, size);
     }
 
     void fill_out_buffer(std::vector<boost::asio::const_buffer>& bufs) {
-        if(_sync_write_queue.size() > 0) {  // always send msgs from sync_write_queue first
-            fill_out_buffer(bufs, _sync_write_queue);
-        }
-        else {  // postpone real_time write_queue if sync queue is not empty
-            fill_out_buffer(bufs, _write_queue);
-            EVT_ASSERT(_write_queue_size == 0, plugin_exception, "write queue size expected to be zero");
+        // deficit round robin: each class earns its budget per write and may overdraw it
+        // by one message, what is left over is carried to the next write up to one budget
+        for(auto i = 0; i < traffic_classes; i++) {
+            auto& w_queue = _write_queues[i];
+            if(w_queue.empty()) {
+                _credits[i] = 0;
+                continue;
+            }
+            _credits[i] = std::min<int64_t>(_credits[i] + (*_budgets)[i], (*_budgets)[i]);
+            while(w_queue.size() > 0 && _credits[i] > 0 && bufs.size() < def_max_write_buffers && _out_queue_size < def_max_write_bytes) {
+                auto& m    = w_queue.front();
+                auto  size = m.buff->size();
+                bufs.push_back(boost::asio::buffer(*m.buff));
+                _credits[i] -= size;
+                _queue_bytes[i] -= size;
+                (*_queued)[i] -= size;
+                _write_queue_size -= size;
+                _write_queue_msgs -= m.msgs;
+                _out_queue_size += size;
+                _out_queue.emplace_back(std::move(m));
+                w_queue.pop_front();
+            }
         }
     }
 
     void out_callback(boost::system::error_code ec, std::size_t w) {
         for(auto& m : _out_queue) {
-            m.callback(ec, w);
+            if(m.callback) {
+                m.callback(ec, w);
+            }
         }
     }
 
 private:
-    struct queued_write;
-    void fill_out_buffer(std::vector<boost::asio::const_buffer>& bufs,
-                         deque<queued_write>&                    w_queue) {
-        while(w_queue.size() > 0) {
-            auto& m = w_queue.front();
-            bufs.push_back(boost::asio::buffer(*m.buff));
-            _write_queue_size -= m.buff->size();
-            _out_queue.emplace_back(m);
-            w_queue.pop_front();
+    bool added(traffic_class cls, uint32_t size) {
+        _queue_bytes[cls] += size;
+        (*_queued)[cls] += size;
+        _write_queue_size += size;
+        _write_queue_msgs++;
+        if(_write_queue_size > 2 * def_max_write_queue_size) {
+            return false;
+        }
+        return true;
+    }
+
+    std::shared_ptr<vector<char>> get_slab() {
+        if(!_free_slabs.empty()) {
+            auto slab = std::move(_free_slabs.back());
+            _free_slabs.pop_back();
+            return slab;
         }
+        auto slab = std::make_shared<vector<char>>();
+        slab->reserve(def_slab_size);
+        return slab;
     }
 
 private:
     struct queued_write {
         std::shared_ptr<vector<char>>                               buff;
         std::function<void(boost::system::error_code, std::size_t)> callback;
+        bool                                                        slab;  // small messages packed together
+        uint32_t                                                    msgs;
     };
 
-    uint32_t            _write_queue_size = 0;
-    deque<queued_write> _write_queue;
-    deque<queued_write> _sync_write_queue;  // sync_write_queue will be sent first
-    deque<queued_write> _out_queue;
+    uint32_t                                         _write_queue_size = 0;
+    uint32_t                                         _write_queue_msgs = 0;
+    uint32_t                                         _out_queue_size   = 0;
+    std::array<deque<queued_write>, traffic_classes> _write_queues;
+    std::array<uint32_t, traffic_classes>            _queue_bytes{};
+    std::array<int64_t, traffic_classes>             _credits{};
+    deque<queued_write>                              _out_queue;
+
+    const std::array<uint32_t, traffic_classes>* _budgets = nullptr;
+    std::array<uint64_t, traffic_classes>*       _queued  = nullptr;  // shared by all connections
+
+    std::vector<std::shared_ptr<vector<char>>> _free_slabs;
 
 };  // queued_buffer
 
@@ -486,7 +882,7 @@ class connection : public std::enable_shared_from_this<connection> {
 public:
     explicit connection(string endpoint);
 
-    explicit connection(socket_ptr s);
+    connection(socket_ptr s, std::shared_ptr<boost::asio::io_context> ioc);
     ~connection();
     void initialize();
 
@@ -495,6 +891,7 @@ public:
     optional<sync_state>                     peer_requested;  // this peer is requesting info from us
     std::shared_ptr<boost::asio::io_context> server_ioc; // keep ioc alive
     boost::asio::io_context::strand          strand;
+    boost::asio::io_context::strand          read_strand;  // reads are decoded on net threads
     socket_ptr                               socket;
 
     fc::message_buffer<1024 * 1024> pending_message_buffer;
@@ -518,6 +915,17 @@ public:
     block_id_type                         fork_head;
     uint32_t                              fork_head_num = 0;
     optional<request_message>             last_req;
+    sync_peer_stats                       sync_stats;
+    peer_score                            score;
+
+    double rank() const { return score.value(sync_stats); }
+    vector<short_trx_id>                  trx_announce_queue;
+    bool                                  compress_out      = false;  // peer asked for compressed messages
+    bool                                  compress_out_dict = false;
+    uint32_t                              peer_first_block  = 1;  // blocks before it are pruned from the block log of peer
+
+    std::unique_ptr<ZSTD_DCtx, decltype(&ZSTD_freeDCtx)> decompress_ctx{nullptr, &ZSTD_freeDCtx};  // only used on read_strand
+    std::shared_ptr<const block_header_state>            verified_tip;  // last block verified from this peer, only used on read_strand
 
     connection_status get_status() const {
         connection_status stat;
@@ -525,6 +933,17 @@ public:
         stat.connecting     = connecting;
         stat.syncing        = syncing;
         stat.last_handshake = last_handshake_recv;
+
+        stat.write_queue_msgs  = buffer_queue.write_queue_msgs();
+        stat.write_queue_bytes = buffer_queue.write_queue_size();
+        stat.buffers_in_flight = buffer_queue.out_queue_buffers();
+        stat.bytes_in_flight   = buffer_queue.out_queue_size();
+
+        stat.score               = score.value(sync_stats);
+        stat.rtt_us              = score.rtt.count();
+        stat.useful_bytes        = score.useful_bytes;
+        stat.duplicate_bytes     = score.duplicate_bytes;
+        stat.sync_blocks_per_sec = sync_stats.blocks_per_sec;
         return stat;
     }
 
@@ -579,10 +998,10 @@ public:
     void stop_send();
 
     void enqueue(const net_message& msg, bool trigger_send = true);
-    void enqueue_block(const signed_block_ptr& sb, bool trigger_send = true, bool to_sync_queue = false);
+    void enqueue_block(const signed_block_ptr& sb, bool trigger_send = true, traffic_class cls = block_traffic);
     void enqueue_buffer(const std::shared_ptr<std::vector<char>>& send_buffer,
                         bool trigger_send, int priority, go_away_reason close_after_send,
-                        bool to_sync_queue = false);
+                        traffic_class cls);
     void cancel_sync(go_away_reason);
     void flush_queues();
     bool enqueue_sync_block();
@@ -598,7 +1017,7 @@ public:
                      bool trigger_send,
                      int  priority,
                      std::function<void(boost::system::error_code, std::size_t)> callback,
-                     bool to_sync_queue = false);
+                     traffic_class cls);
     void do_queue_write(int priority);
 
     bool add_peer_block(const peer_block_state& pbs);
@@ -643,7 +1062,7 @@ struct msg_handler : public fc::visitor<void> {
     }
 
     void operator()(signed_block&& msg) const {
-        impl.handle_message(c, std::make_shared<signed_block>(std::move(msg)));
+        impl.handle_message(c, make_signed_block(std::move(msg)));
     }
     void operator()(packed_transaction&& msg) const {
         impl.handle_message(c, std::make_shared<packed_transaction>(std::move(msg)));
@@ -663,17 +1082,42 @@ private:
         in_sync
     };
 
+    /**
+     * A range of blocks requested from one peer. Each peer streams its own chunk in order,
+     * so `next` is the only block accepted from that peer.
+     */
+    struct sync_chunk {
+        uint32_t       start = 0;
+        uint32_t       end   = 0;
+        uint32_t       next  = 0;
+        fc::time_point requested;
+    };
+
     uint32_t       sync_known_lib_num;
     uint32_t       sync_last_requested_num;
     uint32_t       sync_next_expected_num;
     uint32_t       sync_req_span;
-    connection_ptr source;
+    uint32_t       sync_window_size;
+    connection_ptr source;  // last peer a chunk was assigned to, round-robin cursor
     stages         state;
 
+    std::map<connection_ptr, sync_chunk>                            sync_chunks;   // outstanding chunk per peer
+    std::deque<std::pair<uint32_t, uint32_t>>                       sync_gaps;     // ranges released by dropped peers, sorted
+    std::map<uint32_t, std::pair<connection_ptr, signed_block_ptr>> sync_pending;  // blocks received ahead of the next expected one
+    bool                                                            applying_pending = false;
+
     chain_plugin* chain_plug = nullptr;
 
     constexpr auto stage_str(stages s);
 
+    uint32_t chunk_span(const connection_ptr& c) const;
+    bool     assign_chunk(const connection_ptr& c);
+    void     release_chunk(const connection_ptr& c);
+    void     drop_straggler(const connection_ptr& idle);
+    void     apply_pending();
+    void     reset_chunks();
+    uint32_t next_needed_num() const;
+
 public:
     explicit sync_manager(uint32_t span);
     void set_state(stages s);
@@ -687,8 +1131,10 @@ public:
     void verify_catchup(const connection_ptr& c, uint32_t num, const block_id_type& id);
     void rejected_block(const connection_ptr& c, uint32_t blk_num);
     void recv_block(const connection_ptr& c, const block_id_type& blk_id, uint32_t blk_num);
+    bool recv_sync_block(const connection_ptr& c, const signed_block_ptr& blk);
     void recv_handshake(const connection_ptr& c, const handshake_message& msg);
     void recv_notice(const connection_ptr& c, const notice_message& msg);
+    void recv_block_range(const connection_ptr& c);
 };
 
 class dispatch_manager {
@@ -715,9 +1161,10 @@ connection::connection(string endpoint)
     : blk_state()
     , trx_state()
     , peer_requested()
-    , server_ioc(my_impl->server_ioc)
+    , server_ioc(my_impl->next_ioc())
     , strand(app().get_io_service())
-    , socket(std::make_shared<tcp::socket>(std::ref(*my_impl->server_ioc)))
+    , read_strand(*server_ioc)
+    , socket(std::make_shared<tcp::socket>(std::ref(*server_ioc)))
     , node_id()
     , last_handshake_recv()
     , last_handshake_sent()
@@ -736,12 +1183,13 @@ connection::connection(string endpoint)
     initialize();
 }
 
-connection::connection(socket_ptr s)
+connection::connection(socket_ptr s, std::shared_ptr<boost::asio::io_context> ioc)
     : blk_state()
     , trx_state()
     , peer_requested()
-    , server_ioc(my_impl->server_ioc)
+    , server_ioc(std::move(ioc))
     , strand(app().get_io_service())
+    , read_strand(*server_ioc)
     , socket(s)
     , node_id()
     , last_handshake_recv()
@@ -767,8 +1215,9 @@ void
 connection::initialize() {
     auto* rnd = node_id.data();
     rnd[0]    = 0;
-    response_expected.reset(new boost::asio::steady_timer(*my_impl->server_ioc));
-    read_delay_timer.reset(new boost::asio::steady_timer(*my_impl->server_ioc));
+    response_expected.reset(new boost::asio::steady_timer(*server_ioc));
+    read_delay_timer.reset(new boost::asio::steady_timer(*server_ioc));
+    buffer_queue.init(my_impl->traffic_budgets, my_impl->traffic_queued);
 }
 
 bool
@@ -802,8 +1251,10 @@ connection::close() {
         fc_wlog(logger, "no socket to close!");
     }
     flush_queues();
-    connecting = false;
-    syncing    = false;
+    connecting        = false;
+    syncing           = false;
+    compress_out      = false;
+    compress_out_dict = false;
     if(last_req) {
         my_impl->dispatcher->retry_fetch(shared_from_this());
     }
@@ -934,8 +1385,9 @@ connection::queue_write(const std::shared_ptr<vector<char>>& buff,
                         bool trigger_send,
                         int  priority,
                         std::function<void(boost::system::error_code, std::size_t)> callback,
-                        bool to_sync_queue) {
-    if(!buffer_queue.add_write_queue(buff, callback, to_sync_queue)) {
+                        traffic_class cls) {
+    auto compressed = (compress_out && buff->size() >= my_impl->compress_min_size) ? my_impl->compress_message(buff, compress_out_dict) : buff;
+    if(!buffer_queue.add_write_queue(compressed, callback, cls)) {
         fc_wlog(logger, "write_queue full ${s} bytes, giving up on connection ${p}",
                 ("s", buffer_queue.write_queue_size())("p", peer_name()));
         my_impl->close(shared_from_this());
@@ -1031,10 +1483,18 @@ connection::enqueue_sync_block() {
         peer_requested.reset();
     }
     try {
-        controller&      cc = my_impl->chain_plug->chain();
+        controller& cc = my_impl->chain_plug->chain();
+
+        // irreversible blocks are sent straight from the mapped block log without unpacking
+        auto psb = cc.fetch_serialized_block_by_number(num);
+        if(!psb.data.empty()) {
+            enqueue_buffer(my_impl->get_block_send_buffer(psb.data), trigger_send, priority::low, no_reason, sync_traffic);
+            return true;
+        }
+
         signed_block_ptr sb = cc.fetch_block_by_number(num);
         if(sb) {
-            enqueue_block(sb, trigger_send, true);
+            enqueue_block(sb, trigger_send, sync_traffic);
             return true;
         }
     }
@@ -1052,18 +1512,38 @@ connection::enqueue(const net_message& m, bool trigger_send) {
     }
 
     const uint32_t payload_size = fc::raw::pack_size(m);
+    const auto     cls          = message_traffic(m);
 
     const char* const header      = reinterpret_cast<const char* const>(&payload_size); // avoid variable size encoding of uint32_t
     constexpr size_t  header_size = sizeof(payload_size);
     static_assert(header_size == message_header_size, "invalid message_header_size");
     const size_t buffer_size = header_size + payload_size;
 
+    if(buffer_size <= def_small_message_size && close_after_send == no_reason) {
+        // no callback needed, pack it right into the write queue
+        auto ok = buffer_queue.add_small_write(buffer_size, cls, [&](char* data, uint32_t size) {
+            fc::datastream<char*> ds(data, size);
+            ds.write(header, header_size);
+            fc::raw::pack(ds, m);
+        });
+        if(!ok) {
+            fc_wlog(logger, "write_queue full ${s} bytes, giving up on connection ${p}",
+                    ("s", buffer_queue.write_queue_size())("p", peer_name()));
+            my_impl->close(shared_from_this());
+            return;
+        }
+        if(buffer_queue.is_out_queue_empty() && trigger_send) {
+            do_queue_write(priority::low);
+        }
+        return;
+    }
+
     auto                  send_buffer = std::make_shared<vector<char>>(buffer_size);
     fc::datastream<char*> ds(send_buffer->data(), buffer_size);
     ds.write(header, header_size);
     fc::raw::pack(ds, m);
 
-    enqueue_buffer(send_buffer, trigger_send, priority::low, close_after_send);
+    enqueue_buffer(send_buffer, trigger_send, priority::low, close_after_send, cls);
 }
 
 template< typename T>
@@ -1094,6 +1574,25 @@ create_send_buffer(const signed_block_ptr& sb) {
     return create_send_buffer(signed_block_which, *sb);
 }
 
+static std::shared_ptr<std::vector<char>>
+create_send_buffer(const std::string_view& packed_block) {
+    // same layout as create_send_buffer(signed_block_which, *sb), but the block is already packed
+    const uint32_t which_size   = fc::raw::pack_size(unsigned_int(signed_block_which));
+    const uint32_t payload_size = which_size + packed_block.size();
+
+    const char* const header     = reinterpret_cast<const char* const>(&payload_size); // avoid variable size encoding of uint32_t
+    constexpr size_t header_size = sizeof(payload_size);
+    const size_t buffer_size     = header_size + payload_size;
+
+    auto send_buffer = std::make_shared<vector<char>>(buffer_size);
+    fc::datastream<char*> ds(send_buffer->data(), buffer_size);
+    ds.write(header, header_size);
+    fc::raw::pack(ds, unsigned_int(signed_block_which));
+    ds.write(packed_block.data(), packed_block.size());
+
+    return send_buffer;
+}
+
 static std::shared_ptr<std::vector<char>>
 create_send_buffer(const packed_transaction& trx) {
     // this implementation is to avoid copy of packed_transaction to net_message
@@ -1101,15 +1600,55 @@ create_send_buffer(const packed_transaction& trx) {
     return create_send_buffer(packed_transaction_which, trx);
 }
 
+std::shared_ptr<std::vector<char>>
+net_plugin_impl::get_block_send_buffer(const block_id_type& id, const std::function<std::shared_ptr<std::vector<char>>()>& create) {
+    auto it = block_buffers.find(id);
+    if(it != block_buffers.end()) {
+        stats.block_buffer_hits++;
+        return it->second;
+    }
+    stats.block_buffer_misses++;
+
+    auto buffer = create();
+    block_buffers.emplace(id, buffer);
+    block_buffers_order.emplace_back(id);
+    stats.block_buffer_bytes += buffer->size();
+
+    // buffers are refcounted, the dropped ones are still alive in the write queues
+    while(stats.block_buffer_bytes > def_block_buffer_cache_size && block_buffers_order.size() > 1) {
+        auto old = block_buffers.find(block_buffers_order.front());
+        stats.block_buffer_bytes -= old->second->size();
+        block_buffers.erase(old);
+        block_buffers_order.pop_front();
+    }
+    stats.block_buffers = block_buffers.size();
+    return buffer;
+}
+
+std::shared_ptr<std::vector<char>>
+net_plugin_impl::get_block_send_buffer(const signed_block_ptr& sb, const block_id_type& id) {
+    return get_block_send_buffer(id, [&sb] { return create_send_buffer(sb); });
+}
+
+std::shared_ptr<std::vector<char>>
+net_plugin_impl::get_block_send_buffer(const std::string_view& packed_block) {
+    // only the header is unpacked to get the id
+    auto ds = fc::datastream<const char*>(packed_block.data(), packed_block.size());
+    auto bh = block_header();
+    fc::raw::unpack(ds, bh);
+
+    return get_block_send_buffer(bh.id(), [&packed_block] { return create_send_buffer(packed_block); });
+}
+
 void
-connection::enqueue_block(const signed_block_ptr& sb, bool trigger_send, bool to_sync_queue) {
-    enqueue_buffer(create_send_buffer(sb), trigger_send, priority::low, no_reason, to_sync_queue);
+connection::enqueue_block(const signed_block_ptr& sb, bool trigger_send, traffic_class cls) {
+    enqueue_buffer(my_impl->get_block_send_buffer(sb, sb->id()), trigger_send, priority::low, no_reason, cls);
 }
 
 void
 connection::enqueue_buffer(const std::shared_ptr<std::vector<char>>& send_buffer,
                            bool trigger_send, int priority, go_away_reason close_after_send,
-                           bool to_sync_queue) {
+                           traffic_class cls) {
     connection_wptr weak_this = shared_from_this();
     queue_write(send_buffer, trigger_send, priority,
                 [weak_this, close_after_send](boost::system::error_code ec, std::size_t) {
@@ -1125,7 +1664,7 @@ connection::enqueue_buffer(const std::shared_ptr<std::vector<char>>& send_buffer
                         fc_wlog(logger, "connection expired before enqueued net_message called callback!");
                     }
                 },
-                to_sync_queue);
+                cls);
 }
 
 void
@@ -1236,6 +1775,7 @@ sync_manager::sync_manager(uint32_t req_span)
     , sync_last_requested_num(0)
     , sync_next_expected_num(1)
     , sync_req_span(req_span)
+    , sync_window_size(req_span * def_sync_span_factor * def_sync_window_spans)
     , source()
     , state(in_sync) {
     chain_plug = app().find_plugin<chain_plugin>();
@@ -1286,8 +1826,8 @@ sync_manager::reset_lib_num(const connection_ptr& c) {
             sync_known_lib_num = c->last_handshake_recv.last_irreversible_block_num;
         }
     }
-    else if(c == source) {
-        sync_last_requested_num = 0;
+    else if(sync_chunks.count(c)) {
+        release_chunk(c);
         request_next_chunk();
     }
 }
@@ -1300,88 +1840,178 @@ sync_manager::sync_required() {
     return (sync_last_requested_num < sync_known_lib_num || chain_plug->chain().fork_db_head_block_num() < sync_last_requested_num);
 }
 
+uint32_t
+sync_manager::chunk_span(const connection_ptr& c) const {
+    const auto& st = c->sync_stats;
+    if(st.blocks_per_sec <= 0) {
+        return sync_req_span;
+    }
+    // ask for enough blocks to keep the peer busy for a while and to hide a few round trips
+    auto secs = std::max(def_sync_chunk_secs, def_sync_chunk_rtts * st.rtt.count() / 1000000.0);
+    auto span = (uint32_t)std::min(st.blocks_per_sec * secs, (double)sync_req_span * def_sync_span_factor);
+    return std::clamp(span, std::max(sync_req_span / def_sync_span_factor, 1u), sync_req_span * def_sync_span_factor);
+}
+
+bool
+sync_manager::assign_chunk(const connection_ptr& c) {
+    auto span  = chunk_span(c);
+    auto start = uint32_t(0);
+    auto end   = uint32_t(0);
+
+    // ranges given up by other peers come first, they hold the window back
+    while(!sync_gaps.empty()) {
+        auto& gap = sync_gaps.front();
+        gap.first = std::max(gap.first, sync_next_expected_num);
+        if(gap.first > gap.second) {
+            sync_gaps.pop_front();
+            continue;
+        }
+        start = gap.first;
+        end   = std::min(gap.second, start + span - 1);
+        if(end == gap.second) {
+            sync_gaps.pop_front();
+        }
+        else {
+            gap.first = end + 1;
+        }
+        break;
+    }
+
+    if(end == 0) {
+        start = std::max(sync_last_requested_num + 1, sync_next_expected_num);
+        // never request further ahead than the reorder window can hold
+        auto limit = sync_next_expected_num + sync_window_size - 1;
+        if(start > sync_known_lib_num || start > limit) {
+            return false;
+        }
+        end = std::min({start + span - 1, sync_known_lib_num, limit});
+        sync_last_requested_num = end;
+    }
+
+    fc_ilog(logger, "requesting range ${s} to ${e}, from ${n}",
+            ("n", c->peer_name())("s", start)("e", end));
+    sync_chunks[c] = sync_chunk{start, end, start, fc::time_point::now()};
+    c->request_sync_blocks(start, end);
+    return true;
+}
+
 void
-sync_manager::request_next_chunk(const connection_ptr& conn) {
-    uint32_t head_block = chain_plug->chain().fork_db_head_block_num();
+sync_manager::release_chunk(const connection_ptr& c) {
+    auto it = sync_chunks.find(c);
+    if(it == sync_chunks.end()) {
+        return;
+    }
+    auto& chunk = it->second;
+    if(chunk.next <= chunk.end) {
+        auto gap = std::make_pair(chunk.next, chunk.end);
+        sync_gaps.insert(std::lower_bound(sync_gaps.begin(), sync_gaps.end(), gap), gap);
+    }
+    sync_chunks.erase(it);
+    // start the next round-robin scan after this peer so another one picks the range up
+    source = c;
+}
+
+void
+sync_manager::drop_straggler(const connection_ptr& idle) {
+    if(idle->sync_stats.blocks_per_sec <= 0) {
+        return;
+    }
+
+    // the chunk holding the next expected block is the one keeping the window full
+    auto it = std::find_if(sync_chunks.begin(), sync_chunks.end(), [this](auto& sc) {
+        return sc.second.start <= sync_next_expected_num && sync_next_expected_num <= sc.second.end;
+    });
+    if(it == sync_chunks.end() || it->first == idle) {
+        return;
+    }
 
-    if(head_block < sync_last_requested_num && source && source->current()) {
-        fc_ilog(logger, "ignoring request, head is ${h} last req = ${r} source is ${p}",
-                ("h", head_block)("r", sync_last_requested_num)("p", source->peer_name()));
+    auto& chunk = it->second;
+    auto  secs  = (fc::time_point::now() - chunk.requested).count() / 1000000.0;
+    if(secs < def_sync_chunk_secs) {
+        return;
+    }
+    auto rate = (chunk.next - chunk.start) / secs;
+    if(rate * def_sync_straggler_factor >= idle->sync_stats.blocks_per_sec) {
         return;
     }
 
+    auto c = it->first;
+    fc_ilog(logger, "dropping straggler ${p} at ${r} blocks/s, ${i} is idle at ${ir} blocks/s",
+            ("p", c->peer_name())("r", rate)("i", idle->peer_name())("ir", idle->sync_stats.blocks_per_sec));
+    c->sync_stats.blocks_per_sec = rate;
+    reassign_fetch(c, benign_other);
+}
+
+void
+sync_manager::reset_chunks() {
+    for(auto& sc : sync_chunks) {
+        sc.first->cancel_wait();
+    }
+    sync_chunks.clear();
+    sync_gaps.clear();
+    sync_pending.clear();
+}
+
+uint32_t
+sync_manager::next_needed_num() const {
+    if(!sync_gaps.empty()) {
+        return std::max(sync_gaps.front().first, sync_next_expected_num);
+    }
+    return std::max(sync_last_requested_num + 1, sync_next_expected_num);
+}
+
+void
+sync_manager::request_next_chunk(const connection_ptr& conn) {
     /* ----------
      * next chunk provider selection criteria
-     * a provider is supplied and able to be used, use it.
-     * otherwise select the next available from the list, round-robin style.
+     * a provider is supplied and able to be used, it goes first.
+     * then every other current peer without an outstanding chunk gets one, best scored first,
+     * for as long as the reorder window has room. the peer a chunk was just taken from goes last.
+     * peers which pruned the next needed block from their block logs are skipped.
      */
 
-    if(conn && conn->current()) {
-        source = conn;
+    auto has_blocks = [this](auto& c) { return c->peer_first_block <= next_needed_num(); };
+
+    if(conn && conn->current() && !sync_chunks.count(conn) && has_blocks(conn)) {
+        if(assign_chunk(conn)) {
+            source = conn;
+        }
     }
-    else {
-        if(my_impl->connections.size() == 1) {
-            if(!source) {
-                source = *my_impl->connections.begin();
-            }
+
+    auto candidates = std::vector<connection_ptr>();
+    for(auto& c : my_impl->connections) {
+        if(c->current() && !sync_chunks.count(c) && has_blocks(c)) {
+            candidates.emplace_back(c);
         }
-        else {
-            // init to a linear array search
-            auto cptr = my_impl->connections.begin();
-            auto cend = my_impl->connections.end();
-            // do we remember the previous source?
-            if(source) {
-                //try to find it in the list
-                cptr = my_impl->connections.find(source);
-                cend = cptr;
-                if(cptr == my_impl->connections.end()) {
-                    //not there - must have been closed! cend is now connections.end, so just flatten the ring.
-                    source.reset();
-                    cptr = my_impl->connections.begin();
-                }
-                else {
-                    //was found - advance the start to the next. cend is the old source.
-                    if(++cptr == my_impl->connections.end() && cend != my_impl->connections.end()) {
-                        cptr = my_impl->connections.begin();
-                    }
-                }
-            }
+    }
+    std::sort(candidates.begin(), candidates.end(), [last = source](auto& a, auto& b) {
+        if((a == last) != (b == last)) {
+            return b == last;
+        }
+        return a->rank() > b->rank();
+    });
 
-            //scan the list of peers looking for another able to provide sync blocks.
-            auto cstart_it = cptr;
-            do {
-                //select the first one which is current and break out.
-                if((*cptr)->current()) {
-                    source = *cptr;
-                    break;
-                }
-                if(++cptr == my_impl->connections.end())
-                    cptr = my_impl->connections.begin();
-            } while(cptr != cstart_it);
-            // no need to check the result, either source advanced or the whole list was checked and the old source is reused.
+    connection_ptr idle;
+    for(auto& c : candidates) {
+        if(!assign_chunk(c)) {
+            idle = c;
+            break;
         }
+        source = c;
     }
 
     // verify there is an available source
-    if(!source || !source->current()) {
+    if(sync_chunks.empty() && (sync_last_requested_num < sync_known_lib_num || !sync_gaps.empty())) {
         fc_elog(logger, "Unable to continue syncing at this time");
         sync_known_lib_num      = chain_plug->chain().last_irreversible_block_num();
         sync_last_requested_num = 0;
+        reset_chunks();
         set_state(in_sync);  // probably not, but we can't do anything else
         return;
     }
 
-    if(sync_last_requested_num != sync_known_lib_num) {
-        uint32_t start = sync_next_expected_num;
-        uint32_t end   = start + sync_req_span - 1;
-        if(end > sync_known_lib_num)
-            end = sync_known_lib_num;
-        if(end > 0 && end >= start) {
-            fc_ilog(logger, "requesting range ${s} to ${e}, from ${n}",
-                    ("n", source->peer_name())("s", start)("e", end));
-            source->request_sync_blocks(start, end);
-            sync_last_requested_num = end;
-        }
+    if(idle) {
+        drop_straggler(idle);
     }
 }
 
@@ -1424,13 +2054,23 @@ sync_manager::reassign_fetch(const connection_ptr& c, go_away_reason reason) {
     fc_ilog(logger, "reassign_fetch, our last req is ${cc}, next expected is ${ne} peer ${p}",
             ("cc", sync_last_requested_num)("ne", sync_next_expected_num)("p", c->peer_name()));
 
-    if(c == source) {
+    if(sync_chunks.count(c)) {
         c->cancel_sync(reason);
-        sync_last_requested_num = 0;
+        release_chunk(c);
         request_next_chunk();
     }
 }
 
+void
+sync_manager::recv_block_range(const connection_ptr& c) {
+    // the chunk assigned to the peer has pruned blocks, it goes to others
+    auto it = sync_chunks.find(c);
+    if(it != sync_chunks.end() && it->second.next < c->peer_first_block) {
+        fc_ilog(logger, "peer ${p} pruned blocks before ${n}, reassign its chunk", ("p", c->peer_name())("n", c->peer_first_block));
+        reassign_fetch(c, benign_other);
+    }
+}
+
 void
 sync_manager::recv_handshake(const connection_ptr& c, const handshake_message& msg) {
     controller& cc       = chain_plug->chain();
@@ -1562,11 +2202,93 @@ sync_manager::rejected_block(const connection_ptr& c, uint32_t blk_num) {
         fc_ilog(logger, "block ${bn} not accepted from ${p}", ("bn", blk_num)("p", c->peer_name()));
         sync_last_requested_num = 0;
         source.reset();
+        reset_chunks();
         my_impl->close(c);
         set_state(in_sync);
         send_handshakes();
     }
 }
+bool
+sync_manager::recv_sync_block(const connection_ptr& c, const signed_block_ptr& blk) {
+    if(state != lib_catchup) {
+        return false;
+    }
+
+    auto blk_num = blk->block_num();
+    auto it      = sync_chunks.find(c);
+    if(it == sync_chunks.end()) {
+        // a peer whose chunk was reassigned may still be streaming, only take what is immediately useful
+        if(blk_num == sync_next_expected_num) {
+            return false;
+        }
+        fc_dlog(logger, "dropping block ${bn} from ${p}, no chunk assigned", ("bn", blk_num)("p", c->peer_name()));
+        return true;
+    }
+
+    auto& chunk = it->second;
+    if(blk_num != chunk.next) {
+        fc_ilog(logger, "expected block ${ne} but got ${bn}", ("ne", chunk.next)("bn", blk_num));
+        my_impl->close(c);
+        return true;
+    }
+
+    auto  now = fc::time_point::now();
+    auto& st  = c->sync_stats;
+    if(chunk.next == chunk.start) {
+        st.rtt = now - chunk.requested;
+    }
+    ++chunk.next;
+
+    if(chunk.next > chunk.end) {
+        auto secs = std::max((now - chunk.requested).count() / 1000000.0, 0.001);
+        auto rate = (chunk.end - chunk.start + 1) / secs;
+        st.blocks_per_sec = st.blocks_per_sec > 0 ? (st.blocks_per_sec + rate) / 2 : rate;
+        sync_chunks.erase(it);
+        fc_dlog(logger, "chunk done from ${p}, ${r} blocks/s rtt ${rtt}us",
+                ("p", c->peer_name())("r", st.blocks_per_sec)("rtt", st.rtt.count()));
+    }
+    else {
+        fc_dlog(logger, "calling sync_wait on connection ${p}", ("p", c->peer_name()));
+        c->sync_wait();
+    }
+
+    auto consumed = true;
+    if(blk_num == sync_next_expected_num) {
+        consumed = false;
+    }
+    else if(blk_num > sync_next_expected_num) {
+        sync_pending.emplace(blk_num, std::make_pair(c, blk));
+    }
+
+    if(!sync_chunks.count(c)) {
+        request_next_chunk(c);
+    }
+    return consumed;
+}
+
+void
+sync_manager::apply_pending() {
+    // blocks applied from here call back into recv_block, only the outermost call drains
+    if(applying_pending) {
+        return;
+    }
+    applying_pending = true;
+    while(state == lib_catchup && !sync_pending.empty()) {
+        auto it = sync_pending.begin();
+        if(it->first > sync_next_expected_num) {
+            break;
+        }
+        auto c   = it->second.first;
+        auto blk = it->second.second;
+        auto num = it->first;
+        sync_pending.erase(it);
+        if(num == sync_next_expected_num) {
+            my_impl->apply_block(c, blk);
+        }
+    }
+    applying_pending = false;
+}
+
 void
 sync_manager::recv_block(const connection_ptr& c, const block_id_type& blk_id, uint32_t blk_num) {
     fc_dlog(logger, "got block ${bn} from ${p}", ("bn", blk_num)("p", c->peer_name()));
@@ -1605,14 +2327,12 @@ sync_manager::recv_block(const connection_ptr& c, const block_id_type& blk_id, u
         if(blk_num == sync_known_lib_num) {
             fc_dlog(logger, "All caught up with last known last irreversible block resending handshake");
             set_state(in_sync);
+            reset_chunks();
             send_handshakes();
         }
-        else if(blk_num == sync_last_requested_num) {
-            request_next_chunk();
-        }
         else {
-            fc_dlog(logger, "calling sync_wait on connection ${p}", ("p", c->peer_name()));
-            c->sync_wait();
+            apply_pending();
+            request_next_chunk();
         }
     }
 }
@@ -1631,7 +2351,7 @@ dispatch_manager::bcast_block(const block_state_ptr& bs) {
     auto bnum    = bs->block_num;
     auto pbstate = peer_block_state{bs->id, bnum};
 
-    std::shared_ptr<std::vector<char>> send_buffer;
+    std::shared_ptr<std::vector<char>> compact_buffer;
     for(auto& cp : my_impl->connections) {
         if(skips.find(cp) != skips.end() || !cp->current()) {
             continue;
@@ -1641,11 +2361,15 @@ dispatch_manager::bcast_block(const block_state_ptr& bs) {
             if(!cp->add_peer_block(pbstate)) {
                 continue;
             }
-            if(!send_buffer) {
-                send_buffer = create_send_buffer(bs->block);
-            }
             fc_dlog(logger, "bcast block ${b} to ${p}", ("b", bnum)("p", cp->peer_name()));
-            cp->enqueue_buffer(send_buffer, true, priority::high, no_reason);
+            if(cp->protocol_version >= proto_compact_block) {
+                if(!compact_buffer) {
+                    compact_buffer = my_impl->create_compact_block_buffer(*bs->block);
+                }
+                cp->enqueue_buffer(compact_buffer, true, priority::high, no_reason, block_traffic);
+                continue;
+            }
+            cp->enqueue_buffer(my_impl->get_block_send_buffer(bs->block, bs->id), true, priority::high, no_reason, block_traffic);
         }
     }
 }
@@ -1703,17 +2427,25 @@ dispatch_manager::bcast_transaction(const transaction_metadata_ptr& ptrx) {
 
     auto buff = create_send_buffer(trx);
 
-    node_transaction_state nts = {id, trx_expiration, 0, buff};
+    node_transaction_state nts = {id, trx_expiration, 0, buff, ptrx->packed_trx};
     my_impl->local_txns.insert(std::move(nts));
 
-    my_impl->send_transaction_to_all(buff, [&id, &skips, trx_expiration](const connection_ptr& c) -> bool {
-        if(skips.find(c) != skips.end() || c->syncing) {
+    auto relayed = 0u;
+    auto fanout  = my_impl->trx_relay_fanout;
+    my_impl->send_transaction_to_all(buff, [&id, &skips, &relayed, fanout, trx_expiration](const connection_ptr& c) -> bool {
+        if(skips.find(c) != skips.end() || c->syncing || (fanout > 0 && relayed >= fanout)) {
             return false;
         }
         const auto& bs      = c->trx_state.find(id);
         bool        unknown = bs == c->trx_state.end();
         if(unknown) {
             c->trx_state.insert(transaction_state({id, 0, trx_expiration}));
+            ++relayed;
+            if(c->protocol_version >= proto_trx_announce) {
+                // peer pulls the body only if it doesn't have it yet
+                my_impl->queue_trx_announce(c, to_short_trx_id(id));
+                return false;
+            }
             fc_dlog(logger, "sending trx to ${n}", ("n", c->peer_name()));
         }
         return unknown;
@@ -1935,6 +2667,7 @@ net_plugin_impl::start_session(const connection_ptr& con) {
         return false;
     }
     else {
+        con->score.connected = con->score.last_recv = fc::time_point::now();
         start_read_message(con);
         ++started_sessions;
         return true;
@@ -1943,8 +2676,9 @@ net_plugin_impl::start_session(const connection_ptr& con) {
 
 void
 net_plugin_impl::start_listen_loop() {
-    auto socket = std::make_shared<tcp::socket>(std::ref(*server_ioc));
-    acceptor->async_accept(*socket, [socket, this, ioc = server_ioc](boost::system::error_code ec) {
+    auto ioc    = next_ioc();
+    auto socket = std::make_shared<tcp::socket>(std::ref(*ioc));
+    acceptor->async_accept(*socket, [socket, this, ioc](boost::system::error_code ec) {
         app().post(priority::low, [socket, this, ec, ioc{std::move(ioc)}]() {
             if(!ec) {
                 uint32_t visitors  = 0;
@@ -1971,9 +2705,9 @@ net_plugin_impl::start_listen_loop() {
                         fc_ilog(logger, "checking max client, visitors = ${v} num clients ${n}", ("v", visitors)("n", num_clients));
                         num_clients = visitors;
                     }
-                    if(from_addr < max_nodes_per_host && (max_client_count == 0 || num_clients < max_client_count)) {
+                    if(from_addr < max_nodes_per_host && (max_client_count == 0 || num_clients < max_client_count || evict_client())) {
                         ++num_clients;
-                        connection_ptr c = std::make_shared<connection>(socket);
+                        connection_ptr c = std::make_shared<connection>(socket, ioc);
                         connections.insert(c);
                         start_session(c);
                     }
@@ -2036,9 +2770,13 @@ net_plugin_impl::start_read_message(const connection_ptr& conn) {
             }
         };
 
-        if(conn->buffer_queue.write_queue_size() > def_max_write_queue_size || conn->reads_in_flight > def_max_reads_in_flight || conn->trx_in_progress_size > def_max_trx_in_progress_size) {
+        auto over_budget = write_queues_budget > 0 && write_queues_size() > write_queues_budget;
+        if(conn->buffer_queue.write_queue_size() > def_max_write_queue_size || conn->reads_in_flight > def_max_reads_in_flight || conn->trx_in_progress_size > max_trx_in_progress || over_budget) {
             // too much queued up, reschedule
-            if(conn->buffer_queue.write_queue_size() > def_max_write_queue_size) {
+            if(over_budget) {
+                peer_dlog(conn, "write queues of all peers are over the memory budget ${b} bytes", ("b", write_queues_budget));
+            }
+            else if(conn->buffer_queue.write_queue_size() > def_max_write_queue_size) {
                 peer_wlog(conn, "write_queue full ${s} bytes", ("s", conn->buffer_queue.write_queue_size()));
             }
             else if(conn->reads_in_flight > def_max_reads_in_flight) {
@@ -2047,7 +2785,7 @@ net_plugin_impl::start_read_message(const connection_ptr& conn) {
             else {
                 peer_wlog(conn, "max trx in progress ${s} bytes", ("s", conn->trx_in_progress_size));
             }
-            if(conn->buffer_queue.write_queue_size() > 2 * def_max_write_queue_size || conn->reads_in_flight > 2 * def_max_reads_in_flight || conn->trx_in_progress_size > 2 * def_max_trx_in_progress_size) {
+            if(conn->buffer_queue.write_queue_size() > 2 * def_max_write_queue_size || conn->reads_in_flight > 2 * def_max_reads_in_flight || conn->trx_in_progress_size > 2 * max_trx_in_progress) {
                 fc_wlog(logger, "queues over full, giving up on connection ${p}", ("p", conn->peer_name()));
                 my_impl->close(conn);
                 return;
@@ -2070,67 +2808,29 @@ net_plugin_impl::start_read_message(const connection_ptr& conn) {
         ++conn->reads_in_flight;
         boost::asio::async_read(*conn->socket,
             conn->pending_message_buffer.get_buffer_sequence_for_boost_async_read(), completion_handler,
-            boost::asio::bind_executor(conn->strand,
+            boost::asio::bind_executor(conn->read_strand,
             [this, weak_conn](boost::system::error_code ec, std::size_t bytes_transferred) {
-                app().post(priority::medium, [this,weak_conn, ec, bytes_transferred]() {
+                auto conn = weak_conn.lock();
+                if(!conn) {
+                    return;
+                }
+
+                // messages are unpacked here on net threads, app thread only handles them in order
+                auto msgs = std::make_shared<std::vector<decoded_message>>();
+                auto good = ec ? false : decode_messages(conn, bytes_transferred, *msgs);
+
+                // the next read waits for this one, so messages of a connection stay in order
+                app().post(read_priority(*msgs), [this, weak_conn, ec, good, msgs]() {
                     auto conn = weak_conn.lock();
                     if(!conn || !conn->socket || !conn->socket->is_open()) {
                         return;
                     }
 
                     --conn->reads_in_flight;
-                    conn->outstanding_read_bytes.reset();
+                    conn->score.last_recv = fc::time_point::now();
 
                     try {
-                        if(!ec) {
-                            if(bytes_transferred > conn->pending_message_buffer.bytes_to_write()) {
-                                fc_elog(logger, "async_read_some callback: bytes_transfered = ${bt}, buffer.bytes_to_write = ${btw}",
-                                     ("bt", bytes_transferred)("btw", conn->pending_message_buffer.bytes_to_write()));
-                            }
-                            EVT_ASSERT(bytes_transferred <= conn->pending_message_buffer.bytes_to_write(), plugin_exception, "");
-                            conn->pending_message_buffer.advance_write_ptr(bytes_transferred);
-                            while(conn->pending_message_buffer.bytes_to_read() > 0) {
-                                uint32_t bytes_in_buffer = conn->pending_message_buffer.bytes_to_read();
-
-                                if(bytes_in_buffer < message_header_size) {
-                                    conn->outstanding_read_bytes.emplace(message_header_size - bytes_in_buffer);
-                                    break;
-                                }
-                                else {
-                                    uint32_t message_length;
-                                    auto     index = conn->pending_message_buffer.read_index();
-                                    conn->pending_message_buffer.peek(&message_length, sizeof(message_length), index);
-                                    if(message_length > def_send_buffer_size * 2 || message_length == 0) {
-                                        boost::system::error_code ec;
-                                        fc_elog(logger, "incoming message length unexpected (${i}), from ${p}",
-                                             ("i", message_length)("p", boost::lexical_cast<std::string>(conn->socket->remote_endpoint(ec))));
-                                        close(conn);
-                                        return;
-                                    }
-
-                                    auto total_message_bytes = message_length + message_header_size;
-
-                                    if(bytes_in_buffer >= total_message_bytes) {
-                                        conn->pending_message_buffer.advance_read_ptr(message_header_size);
-                                        if(!process_next_message(conn, message_length)) {
-                                            return;
-                                        }
-                                    }
-                                    else {
-                                        auto outstanding_message_bytes = total_message_bytes - bytes_in_buffer;
-                                        auto available_buffer_bytes    = conn->pending_message_buffer.bytes_to_write();
-                                        if(outstanding_message_bytes > available_buffer_bytes) {
-                                            conn->pending_message_buffer.add_space(outstanding_message_bytes - available_buffer_bytes);
-                                        }
-
-                                        conn->outstanding_read_bytes.emplace(outstanding_message_bytes);
-                                        break;
-                                    }
-                                }
-                            }
-                            start_read_message(conn);
-                        }
-                        else {
+                        if(ec) {
                             auto pname = conn->peer_name();
                             if(ec.value() != boost::asio::error::eof) {
                                 fc_elog(logger, "Error reading message from ${p}: ${m}", ("p", pname)("m", ec.message()));
@@ -2139,7 +2839,19 @@ net_plugin_impl::start_read_message(const connection_ptr& conn) {
                                 fc_ilog(logger, "Peer ${p} closed connection", ("p", pname));
                             }
                             close(conn);
+                            return;
                         }
+
+                        for(auto& m : *msgs) {
+                            if(!process_decoded_message(conn, m)) {
+                                return;
+                            }
+                        }
+                        if(!good) {
+                            close(conn);
+                            return;
+                        }
+                        start_read_message(conn);
                     }
                     catch(const std::exception& ex) {
                         string pname = conn ? conn->peer_name() : "no connection name";
@@ -2167,38 +2879,173 @@ net_plugin_impl::start_read_message(const connection_ptr& conn) {
 }
 
 bool
-net_plugin_impl::process_next_message(const connection_ptr& conn, uint32_t message_length) {
+net_plugin_impl::decode_messages(const connection_ptr& conn, std::size_t bytes_transferred, std::vector<decoded_message>& msgs) {
+    conn->outstanding_read_bytes.reset();
+
+    try {
+        if(bytes_transferred > conn->pending_message_buffer.bytes_to_write()) {
+            fc_elog(logger, "async_read_some callback: bytes_transfered = ${bt}, buffer.bytes_to_write = ${btw}",
+                 ("bt", bytes_transferred)("btw", conn->pending_message_buffer.bytes_to_write()));
+        }
+        EVT_ASSERT(bytes_transferred <= conn->pending_message_buffer.bytes_to_write(), plugin_exception, "");
+        conn->pending_message_buffer.advance_write_ptr(bytes_transferred);
+        while(conn->pending_message_buffer.bytes_to_read() > 0) {
+            uint32_t bytes_in_buffer = conn->pending_message_buffer.bytes_to_read();
+
+            if(bytes_in_buffer < message_header_size) {
+                conn->outstanding_read_bytes.emplace(message_header_size - bytes_in_buffer);
+                break;
+            }
+
+            uint32_t message_length;
+            auto     index = conn->pending_message_buffer.read_index();
+            conn->pending_message_buffer.peek(&message_length, sizeof(message_length), index);
+            auto compressed = (message_length & compressed_message_flag) != 0;
+            message_length &= ~compressed_message_flag;
+            if(message_length > def_send_buffer_size * 2 || message_length == 0) {
+                boost::system::error_code ec;
+                fc_elog(logger, "incoming message length unexpected (${i}), from ${p}",
+                     ("i", message_length)("p", boost::lexical_cast<std::string>(conn->socket->remote_endpoint(ec))));
+                return false;
+            }
+
+            auto total_message_bytes = message_length + message_header_size;
+            if(bytes_in_buffer < total_message_bytes) {
+                auto outstanding_message_bytes = total_message_bytes - bytes_in_buffer;
+                auto available_buffer_bytes    = conn->pending_message_buffer.bytes_to_write();
+                if(outstanding_message_bytes > available_buffer_bytes) {
+                    conn->pending_message_buffer.add_space(outstanding_message_bytes - available_buffer_bytes);
+                }
+
+                conn->outstanding_read_bytes.emplace(outstanding_message_bytes);
+                break;
+            }
+
+            conn->pending_message_buffer.advance_read_ptr(message_header_size);
+            if(compressed) {
+                decode_compressed_message(conn, message_length, msgs);
+            }
+            else {
+                auto ds = conn->pending_message_buffer.create_datastream();
+                decode_next_message(ds, msgs);
+            }
+        }
+
+        for(auto& m : msgs) {
+            if(m.block) {
+                verify_block(conn, m);
+            }
+        }
+    }
+    catch(const fc::exception& e) {
+        edump((e.to_detail_string()));
+        return false;
+    }
+    catch(const std::exception& ex) {
+        fc_elog(logger, "Exception in decoding read data ${s}", ("s", ex.what()));
+        return false;
+    }
+    return true;
+}
+
+void
+net_plugin_impl::decode_compressed_message(const connection_ptr& conn, uint32_t size, std::vector<decoded_message>& msgs) {
+    auto frame = std::vector<char>(size);
+    conn->pending_message_buffer.read(frame.data(), size);
+
+    auto content_size = ZSTD_getFrameContentSize(frame.data(), frame.size());
+    EVT_ASSERT(content_size != ZSTD_CONTENTSIZE_UNKNOWN && content_size != ZSTD_CONTENTSIZE_ERROR && content_size <= def_send_buffer_size * 2,
+               plugin_exception, "Invalid compressed message of ${s} bytes", ("s", size));
+
+    if(!conn->decompress_ctx) {
+        conn->decompress_ctx.reset(ZSTD_createDCtx());
+    }
+    auto payload = std::vector<char>(content_size);
+    auto dict_id = ZSTD_getDictID_fromFrame(frame.data(), frame.size());
+    auto r       = size_t(0);
+    if(dict_id != 0) {
+        EVT_ASSERT(compress_ddict && dict_id == compress_dict_id, plugin_exception,
+                   "Compressed message uses unknown dictionary ${d}", ("d", dict_id));
+        r = ZSTD_decompress_usingDDict(conn->decompress_ctx.get(), payload.data(), payload.size(), frame.data(), frame.size(), compress_ddict.get());
+    }
+    else {
+        r = ZSTD_decompressDCtx(conn->decompress_ctx.get(), payload.data(), payload.size(), frame.data(), frame.size());
+    }
+    EVT_ASSERT(!ZSTD_isError(r) && r == payload.size(), plugin_exception,
+               "Failed to decompress message: ${e}", ("e", ZSTD_isError(r) ? ZSTD_getErrorName(r) : "size mismatch"));
+
+    auto ds = fc::datastream<const char*>(payload.data(), payload.size());
+    decode_next_message(ds, msgs);
+}
+
+template<typename Stream>
+void
+net_plugin_impl::decode_next_message(Stream& ds, std::vector<decoded_message>& msgs) {
+    auto msg = net_message();
+    fc::raw::unpack(ds, msg);
+
+    auto dm = decoded_message();
+    if(msg.contains<signed_block>()) {
+        dm.block = make_signed_block(std::move(msg.get<signed_block>()));
+    }
+    else if(msg.contains<packed_transaction>()) {
+        auto& cc = chain_plug->chain();
+
+        dm.trx = make_transaction_metadata(std::move(msg.get<packed_transaction>()));
+        if(cc.get_read_mode() != evt::db_read_mode::READ_ONLY) {
+            transaction_metadata::create_signing_keys_future(dm.trx, cc.get_task_scheduler(), chain_id);
+        }
+    }
+    else {
+        dm.msg = std::move(msg);
+    }
+    msgs.emplace_back(std::move(dm));
+}
+
+void
+net_plugin_impl::verify_block(const connection_ptr& conn, decoded_message& dm) {
+    auto& b    = dm.block;
+    auto  prev = conn->verified_tip;
+    if(!prev || prev->id != b->previous) {
+        std::lock_guard<std::mutex> lock(verify_mtx);
+        prev = verify_base;
+    }
+    if(!prev || prev->id != b->previous) {
+        // checked by the controller on app thread as usual
+        return;
+    }
+
+    try {
+        dm.verified = controller::verify_block(*prev, b);
+        // copied as the controller owns `verified` from now on
+        conn->verified_tip = std::make_shared<const block_header_state>(*dm.verified);
+    }
+    catch(const fc::exception& e) {
+        dm.error = e.dynamic_copy_exception();
+    }
+}
+
+bool
+net_plugin_impl::process_decoded_message(const connection_ptr& conn, decoded_message& msg) {
+    FC_TRACE_SPAN("net", "process_message");
     try {
-        // if next message is a block we already have, exit early
-        auto peek_ds = conn->pending_message_buffer.create_peek_datastream();
-        unsigned_int which{};
-        fc::raw::unpack(peek_ds, which);
-        if(which == signed_block_which) {
-            block_header bh;
-            fc::raw::unpack(peek_ds, bh);
-
-            controller&   cc      = chain_plug->chain();
-            block_id_type blk_id  = bh.id();
-            uint32_t      blk_num = bh.block_num();
-            if(cc.fetch_block_by_id(blk_id)) {
-                sync_master->recv_block(conn, blk_id, blk_num);
-                conn->pending_message_buffer.advance_read_ptr(message_length);
-                return true;
-            }
-        }
-
-        auto ds = conn->pending_message_buffer.create_datastream();
-        net_message msg;
-        fc::raw::unpack(ds, msg);
-        msg_handler m(*this, conn);
-        if(msg.contains<signed_block>()) {
-            m(std::move(msg.get<signed_block>()));
-        }
-        else if(msg.contains<packed_transaction>()) {
-            m(std::move(msg.get<packed_transaction>()));
+        if(msg.block && msg.error) {
+            peer_elog(conn, "bad signed_block : ${m}", ("m", msg.error->to_string()));
+            sync_master->rejected_block(conn, msg.block->block_num());
+            dispatcher->rejected_block(msg.block->id());
+        }
+        else if(msg.block) {
+            if(msg.verified) {
+                chain_plug->chain().add_verified_block(msg.verified);
+            }
+            handle_message(conn, msg.block);
+        }
+        else if(msg.trx) {
+            handle_message(conn, msg.trx);
         }
         else {
-            msg.visit(m);
+            auto m = msg_handler(*this, conn);
+            msg.msg.visit(m);
         }
     }
     catch(const fc::exception& e) {
@@ -2222,10 +3069,118 @@ net_plugin_impl::count_open_sockets() const {
 template<typename VerifierFunc>
 void
 net_plugin_impl::send_transaction_to_all(const std::shared_ptr<std::vector<char>>& send_buffer, VerifierFunc verify) {
+    // transaction is packed once in `bcast_transaction` and shared by all the peers
+    if(traffic_queued[trx_traffic] > max_trx_queued_total) {
+        fc_dlog(logger, "${b} bytes of transactions queued already, not relaying", ("b", traffic_queued[trx_traffic]));
+        return;
+    }
+    // best scored peers first, so a relay fan-out limit keeps the worst ones out
+    auto peers = std::vector<connection_ptr>();
+    for(auto& c : connections) {
+        if(c->current()) {
+            peers.emplace_back(c);
+        }
+    }
+    std::sort(peers.begin(), peers.end(), [](auto& a, auto& b) { return a->rank() > b->rank(); });
+
+    auto sent = false;
+    for(auto& c : peers) {
+        if(verify(c)) {
+            c->enqueue_buffer(send_buffer, true, priority::low, no_reason, trx_traffic);
+            if(sent) {
+                stats.trx_buffer_hits++;
+            }
+            sent = true;
+        }
+    }
+}
+
+void
+net_plugin_impl::queue_trx_announce(const connection_ptr& c, short_trx_id id) {
+    c->trx_announce_queue.push_back(id);
+    stats.trx_announced++;
+    if(c->trx_announce_queue.size() >= def_trx_announce_batch) {
+        auto msg = trx_announce_message();
+        msg.ids  = std::move(c->trx_announce_queue);
+        c->trx_announce_queue.clear();
+        c->enqueue(msg);
+        return;
+    }
+
+    if(trx_announce_scheduled) {
+        return;
+    }
+    trx_announce_scheduled = true;
+    trx_announce_timer->expires_from_now(def_trx_announce_delay);
+    trx_announce_timer->async_wait([this](boost::system::error_code ec) {
+        app().post(priority::low, [this, ec]() {
+            if(ec == boost::asio::error::operation_aborted) {
+                return;
+            }
+            send_trx_announces();
+        });
+    });
+}
+
+void
+net_plugin_impl::send_trx_announces() {
+    trx_announce_scheduled = false;
     for(auto& c : connections) {
-        if(c->current() && verify(c)) {
-            c->enqueue_buffer(send_buffer, true, priority::low, no_reason);
+        if(c->trx_announce_queue.empty()) {
+            continue;
+        }
+        if(c->current()) {
+            auto msg = trx_announce_message();
+            msg.ids  = std::move(c->trx_announce_queue);
+            c->enqueue(msg);
         }
+        c->trx_announce_queue.clear();
+    }
+}
+
+void
+net_plugin_impl::retry_trx_pulls() {
+    if(trx_in_progress_total > max_trx_in_progress_total) {
+        return;
+    }
+    auto now     = time_point::now();
+    auto timeout = fc::microseconds(std::chrono::duration_cast<std::chrono::microseconds>(resp_expected_period).count());
+    auto expired = fc::microseconds(std::chrono::duration_cast<std::chrono::microseconds>(txn_exp_period).count());
+
+    auto retries = std::map<connection_ptr, trx_request_message>();
+    for(auto it = requested_trxs.begin(); it != requested_trxs.end();) {
+        auto& pull = it->second;
+        if(pull.received) {
+            // keep it for a while, late announcements of a transaction still being applied are ignored
+            it = (pull.requested + expired < now) ? requested_trxs.erase(it) : std::next(it);
+            continue;
+        }
+        if(pull.requested + timeout >= now) {
+            ++it;
+            continue;
+        }
+
+        auto source = connection_ptr();
+        while(!source && !pull.sources.empty()) {
+            source = pull.sources.back().lock();
+            pull.sources.pop_back();
+            if(source && !source->current()) {
+                source.reset();
+            }
+        }
+        if(!source) {
+            fc_dlog(logger, "giving up pulling announced trx ${id}", ("id", it->first));
+            it = requested_trxs.erase(it);
+            continue;
+        }
+        pull.requested = now;
+        retries[source].ids.push_back(it->first);
+        ++it;
+    }
+
+    for(auto& r : retries) {
+        stats.trx_requested += r.second.ids.size();
+        r.first->enqueue(r.second);
     }
 }
 
@@ -2362,6 +3317,13 @@ net_plugin_impl::handle_message(const connection_ptr& c, const handshake_message
         if(c->sent_handshake_count == 0) {
             c->send_handshake();
         }
+
+        if(c->protocol_version >= proto_compression && compress_peer(c)) {
+            auto req    = compression_request_message();
+            req.dict_id = compress_dict_id;
+            c->enqueue(req);
+        }
+        send_block_range(c);
     }
 
     c->last_handshake_recv = msg;
@@ -2410,6 +3372,12 @@ net_plugin_impl::handle_message(const connection_ptr& c, const time_message& msg
     c->offset = (double(c->rec - c->org) + double(msg.xmt - c->dst)) / 2;
     double NsecPerUsec{1000};
 
+    // round trip without the time the peer held the message
+    auto rtt = (msg.dst - msg.org) - (msg.xmt - msg.rec);
+    if(rtt > 0) {
+        c->score.add_rtt(fc::microseconds(rtt / (tstamp)NsecPerUsec));
+    }
+
     if(logger.is_enabled(fc::log_level::all))
         logger.log(FC_LOG_MESSAGE(all, "Clock offset is ${o}ns (${us}us)", ("o", c->offset)("us", c->offset / NsecPerUsec)));
     c->org = 0;
@@ -2518,6 +3486,10 @@ net_plugin_impl::handle_message(const connection_ptr& c, const sync_request_mess
         c->flush_queues();
     }
     else {
+        // the peer is behind what we have, it moves on to others after hearing our range
+        if(msg.start_block < chain_plug->chain().earliest_available_block_num()) {
+            send_block_range(c);
+        }
         c->peer_requested = sync_state(msg.start_block, msg.end_block, msg.start_block - 1);
         c->enqueue_sync_block();
     }
@@ -2531,6 +3503,11 @@ calc_trx_size(const packed_transaction_ptr& trx) {
 
 void
 net_plugin_impl::handle_message(const connection_ptr& c, const packed_transaction_ptr& trx) {
+    handle_message(c, make_transaction_metadata(trx));
+}
+
+void
+net_plugin_impl::handle_message(const connection_ptr& c, const transaction_metadata_ptr& ptrx) {
     fc_dlog(logger, "got a packed transaction, cancel wait");
     peer_ilog(c, "received packed_transaction");
     controller& cc = my_impl->chain_plug->chain();
@@ -2543,17 +3520,28 @@ net_plugin_impl::handle_message(const connection_ptr& c, const packed_transactio
         return;
     }
 
-    auto        ptrx = std::make_shared<transaction_metadata>(trx);
-    const auto& tid  = ptrx->id;
+    const auto& tid = ptrx->id;
 
+    auto pit = requested_trxs.find(to_short_trx_id(tid));
+    if(pit != requested_trxs.end()) {
+        pit->second.received = true;
+    }
+
+    auto packed_size = fc::raw::pack_size(*ptrx->packed_trx);
     if(local_txns.get<by_id>().find(tid) != local_txns.end()) {
         fc_dlog(logger, "got a duplicate transaction - dropping");
+        c->score.duplicate_bytes += packed_size;
         return;
     }
+    c->score.useful_bytes += packed_size;
     dispatcher->recv_transaction(c, tid);
-    c->trx_in_progress_size += calc_trx_size(ptrx->packed_trx);
-    chain_plug->accept_transaction(ptrx, [c, this, ptrx](const static_variant<fc::exception_ptr, transaction_trace_ptr>& result) {
-        c->trx_in_progress_size -= calc_trx_size(ptrx->packed_trx);
+    transaction_metadata::create_signing_keys_future(ptrx, cc.get_task_scheduler(), cc.get_chain_id());
+    auto trx_size = calc_trx_size(ptrx->packed_trx);
+    c->trx_in_progress_size += trx_size;
+    trx_in_progress_total += trx_size;
+    chain_plug->accept_transaction(ptrx, [c, this, ptrx, trx_size](const static_variant<fc::exception_ptr, transaction_trace_ptr>& result) {
+        c->trx_in_progress_size -= trx_size;
+        trx_in_progress_total -= trx_size;
         if(result.contains<fc::exception_ptr>()) {
             peer_dlog(c, "bad packed_transaction : ${m}", ("m", result.get<fc::exception_ptr>()->what()));
         }
@@ -2572,16 +3560,554 @@ net_plugin_impl::handle_message(const connection_ptr& c, const packed_transactio
     });
 }
 
+void
+net_plugin_impl::handle_message(const connection_ptr& c, const trx_announce_message& msg) {
+    peer_dlog(c, "received trx_announce_message with ${n} ids", ("n", msg.ids.size()));
+    controller& cc = chain_plug->chain();
+    if(cc.get_read_mode() == evt::db_read_mode::READ_ONLY || sync_master->is_active(c)) {
+        return;
+    }
+
+    auto        now = time_point::now();
+    auto        req = trx_request_message();
+    const auto& idx = local_txns.get<by_short_id>();
+    for(auto id : msg.ids) {
+        if(idx.find(id) != idx.end()) {
+            continue;
+        }
+        auto it = requested_trxs.find(id);
+        if(it != requested_trxs.end()) {
+            // already asked somebody else, remember this peer in case that fails
+            if(!it->second.received) {
+                it->second.sources.emplace_back(c);
+            }
+            continue;
+        }
+        if(trx_in_progress_total > max_trx_in_progress_total) {
+            // too busy applying, pulled by retry_trx_pulls once there's room
+            requested_trxs.emplace(id, trx_pull_state{time_point(), false, {c}});
+            continue;
+        }
+        requested_trxs.emplace(id, trx_pull_state{now, false, {}});
+        req.ids.push_back(id);
+    }
+
+    if(!req.ids.empty()) {
+        stats.trx_requested += req.ids.size();
+        c->enqueue(req);
+    }
+}
+
+void
+net_plugin_impl::handle_message(const connection_ptr& c, const trx_request_message& msg) {
+    peer_dlog(c, "received trx_request_message with ${n} ids", ("n", msg.ids.size()));
+    const auto& idx = local_txns.get<by_short_id>();
+    for(auto id : msg.ids) {
+        auto it = idx.find(id);
+        if(it == idx.end() || !it->serialized_txn) {
+            continue;
+        }
+        if(traffic_queued[trx_traffic] > max_trx_queued_total) {
+            // the peer pulls it again from another source
+            break;
+        }
+        c->enqueue_buffer(it->serialized_txn, true, priority::low, no_reason, trx_traffic);
+    }
+}
+
+std::shared_ptr<std::vector<char>>
+net_plugin_impl::create_compact_block_buffer(const signed_block& sb) {
+    auto msg             = compact_block_message();
+    msg.header           = sb;
+    msg.block_extensions = sb.block_extensions;
+    msg.receipts.reserve(sb.transactions.size());
+    for(auto i = 0u; i < sb.transactions.size(); i++) {
+        auto& r  = sb.transactions[i];
+        auto  cr = compact_trx_receipt();
+        static_cast<transaction_receipt_header&>(cr) = r;
+        cr.id = to_short_trx_id(r.trx.id());
+        msg.receipts.emplace_back(cr);
+
+        if(r.type == transaction_receipt_header::suspend) {
+            // never relayed on its own
+            msg.prefilled.emplace_back(indexed_trx{i, packed_transaction(r.trx)});
+        }
+    }
+    stats.compact_blocks_sent++;
+    return create_send_buffer(compact_block_which, msg);
+}
+
+void
+net_plugin_impl::handle_message(const connection_ptr& c, const compact_block_message& msg) {
+    auto        id  = msg.header.id();
+    auto        num = msg.header.block_num();
+    controller& cc  = chain_plug->chain();
+    peer_dlog(c, "received compact_block_message #${n} with ${t} trxs", ("n", num)("t", msg.receipts.size()));
+
+    c->add_peer_block({id, num});
+    if(compact_blocks.count(id)) {
+        return;
+    }
+    try {
+        if(cc.fetch_block_by_id(id)) {
+            return;
+        }
+    }
+    catch(...) {
+        fc_elog(logger, "Caught an unknown exception trying to recall blockID");
+    }
+
+    auto blk = make_signed_block(msg.header);
+    blk->block_extensions = msg.block_extensions;
+    blk->transactions.resize(msg.receipts.size());
+
+    auto filled = std::vector<bool>(msg.receipts.size());
+    for(auto& p : msg.prefilled) {
+        if(p.index >= msg.receipts.size()) {
+            peer_elog(c, "bad compact_block_message : prefilled index ${i} out of range", ("i", p.index));
+            close(c);
+            return;
+        }
+        blk->transactions[p.index].trx = packed_transaction(p.trx);
+        filled[p.index] = true;
+    }
+
+    // transactions of the block we are producing or applying are not necessarily broadcasted yet
+    auto pending = std::map<short_trx_id, packed_transaction_ptr>();
+    if(auto pbs = cc.pending_block_state()) {
+        for(auto& trx : pbs->trxs) {
+            pending.emplace(to_short_trx_id(trx->id), trx->packed_trx);
+        }
+    }
+
+    auto        missing = vector<uint32_t>();
+    const auto& idx     = local_txns.get<by_short_id>();
+    for(auto i = 0u; i < msg.receipts.size(); i++) {
+        auto& r = msg.receipts[i];
+        static_cast<transaction_receipt_header&>(blk->transactions[i]) = r;
+        if(filled[i]) {
+            continue;
+        }
+
+        auto it = idx.find(r.id);
+        if(it != idx.end() && it->packed_trx) {
+            blk->transactions[i].trx = packed_transaction(*it->packed_trx);
+            continue;
+        }
+        auto pit = pending.find(r.id);
+        if(pit != pending.end()) {
+            blk->transactions[i].trx = packed_transaction(*pit->second);
+            continue;
+        }
+        missing.push_back(i);
+    }
+
+    if(missing.empty()) {
+        stats.compact_blocks_rebuilt++;
+        finish_compact_block(c, blk);
+        return;
+    }
+
+    fc_dlog(logger, "requesting ${m} missing trxs of compact block #${n} from ${p}",
+            ("m", missing.size())("n", num)("p", c->peer_name()));
+    auto req    = block_trxs_request_message();
+    req.id      = id;
+    req.indexes = missing;
+    c->enqueue(req);
+    compact_blocks.emplace(id, compact_block_state{c, blk, std::move(missing), time_point::now()});
+}
+
+void
+net_plugin_impl::handle_message(const connection_ptr& c, const block_trxs_request_message& msg) {
+    peer_dlog(c, "received block_trxs_request_message for ${n} trxs", ("n", msg.indexes.size()));
+    auto blk = signed_block_ptr();
+    try {
+        blk = chain_plug->chain().fetch_block_by_id(msg.id);
+    }
+    catch(const assert_exception& ex) {
+        fc_ilog(logger, "caught assert on fetch_block_by_id, ${ex}", ("ex", ex.what()));
+    }
+    if(!blk) {
+        // requester falls back to ask for the full block once its wait expires
+        return;
+    }
+
+    auto res = block_trxs_message();
+    res.id   = msg.id;
+    for(auto i : msg.indexes) {
+        if(i >= blk->transactions.size()) {
+            peer_elog(c, "bad block_trxs_request_message : index ${i} out of range", ("i", i));
+            close(c);
+            return;
+        }
+        res.trxs.emplace_back(indexed_trx{i, packed_transaction(blk->transactions[i].trx)});
+    }
+    c->enqueue(res);
+}
+
+void
+net_plugin_impl::handle_message(const connection_ptr& c, const block_trxs_message& msg) {
+    auto it = compact_blocks.find(msg.id);
+    if(it == compact_blocks.end() || it->second.source.lock() != c) {
+        return;
+    }
+
+    auto cbs = std::move(it->second);
+    compact_blocks.erase(it);
+
+    auto ok = msg.trxs.size() == cbs.missing.size();
+    for(auto i = 0u; ok && i < msg.trxs.size(); i++) {
+        auto& t = msg.trxs[i];
+        if(t.index != cbs.missing[i]) {
+            ok = false;
+            break;
+        }
+        cbs.block->transactions[t.index].trx = packed_transaction(t.trx);
+    }
+    if(!ok) {
+        peer_elog(c, "bad block_trxs_message : transactions don't match the request");
+        request_full_block(c, msg.id);
+        return;
+    }
+    finish_compact_block(c, cbs.block);
+}
+
+void
+net_plugin_impl::finish_compact_block(const connection_ptr& c, const signed_block_ptr& blk) {
+    // short ids may collide and transactions may be signed or packed differently, so check the root
+    auto digests = vector<digest_type>();
+    digests.reserve(blk->transactions.size());
+    for(auto& r : blk->transactions) {
+        digests.emplace_back(r.digest());
+    }
+    if(merkle(std::move(digests)) != blk->transaction_mroot) {
+        fc_wlog(logger, "compact block #${n} from ${p} rebuilt with a wrong transaction root",
+                ("n", blk->block_num())("p", c->peer_name()));
+        request_full_block(c, blk->id());
+        return;
+    }
+    handle_message(c, blk);
+}
+
+void
+net_plugin_impl::request_full_block(const connection_ptr& c, const block_id_type& id) {
+    stats.compact_blocks_failed++;
+    if(!c->current()) {
+        return;
+    }
+    auto req = request_message();
+    req.req_trx.mode    = none;
+    req.req_blocks.mode = normal;
+    req.req_blocks.ids.push_back(id);
+    c->enqueue(req);
+    c->fetch_wait();
+    c->last_req = std::move(req);
+}
+
+void
+net_plugin_impl::expire_compact_blocks() {
+    auto now     = time_point::now();
+    auto timeout = fc::microseconds(std::chrono::duration_cast<std::chrono::microseconds>(resp_expected_period).count());
+    for(auto it = compact_blocks.begin(); it != compact_blocks.end();) {
+        if(it->second.requested + timeout >= now) {
+            ++it;
+            continue;
+        }
+        if(auto c = it->second.source.lock()) {
+            request_full_block(c, it->first);
+        }
+        it = compact_blocks.erase(it);
+    }
+}
+
+bool
+net_plugin_impl::compress_peer(const connection_ptr& c) const {
+    boost::system::error_code ec;
+    auto ip   = c->socket->remote_endpoint(ec).address().to_string();
+    auto host = c->peer_addr.substr(0, c->peer_addr.find(':'));
+    for(auto& p : compress_peers) {
+        if(p == "*" || p == c->peer_addr || (!host.empty() && p == host) || (!ec && p == ip)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::shared_ptr<std::vector<char>>
+net_plugin_impl::compress_message(const std::shared_ptr<std::vector<char>>& buff, bool use_dict) {
+    auto payload      = buff->data() + message_header_size;
+    auto payload_size = buff->size() - message_header_size;
+    auto bound        = ZSTD_compressBound(payload_size);
+
+    auto out  = std::make_shared<std::vector<char>>(message_header_size + bound);
+    auto dst  = out->data() + message_header_size;
+    auto size = use_dict ? ZSTD_compress_usingCDict(compress_ctx.get(), dst, bound, payload, payload_size, compress_cdict.get())
+                         : ZSTD_compressCCtx(compress_ctx.get(), dst, bound, payload, payload_size, compress_level);
+    if(ZSTD_isError(size) || size >= payload_size) {
+        return buff;
+    }
+    out->resize(message_header_size + size);
+
+    uint32_t header = size | compressed_message_flag;
+    memcpy(out->data(), &header, sizeof(header));
+
+    stats.compress_bytes_in += payload_size;
+    stats.compress_bytes_out += size;
+    return out;
+}
+
+void
+net_plugin_impl::handle_message(const connection_ptr& c, const compression_request_message& msg) {
+    peer_ilog(c, "received compression_request_message, dictionary ${d}", ("d", msg.dict_id));
+    c->compress_out      = true;
+    c->compress_out_dict = compress_cdict && msg.dict_id != 0 && msg.dict_id == compress_dict_id;
+}
+
+void
+net_plugin_impl::send_block_range(const connection_ptr& c) {
+    auto first = chain_plug->chain().earliest_available_block_num();
+    if(c->protocol_version < proto_block_range || first <= 1) {
+        return;
+    }
+    auto msg            = block_range_message();
+    msg.first_block_num = first;
+    c->enqueue(msg);
+}
+
+void
+net_plugin_impl::handle_message(const connection_ptr& c, const block_range_message& msg) {
+    peer_ilog(c, "received block_range_message, first block ${n}", ("n", msg.first_block_num));
+    c->peer_first_block = std::max(msg.first_block_num, 1u);
+    sync_master->recv_block_range(c);
+}
+
+// full snapshots are named after their head block by producer_plugin, differential ones are not offered
+static optional<block_id_type>
+full_snapshot_head(const std::string& name) {
+    static const auto prefix = std::string("snapshot-");
+    static const auto suffix = std::string(".bin");
+    if(name.size() != prefix.size() + 64 + suffix.size() || name.compare(0, prefix.size(), prefix) != 0
+       || name.compare(name.size() - suffix.size(), suffix.size(), suffix) != 0) {
+        return optional<block_id_type>();
+    }
+    try {
+        return block_id_type(name.substr(prefix.size(), 64));
+    }
+    catch(const fc::exception&) {
+        return optional<block_id_type>();
+    }
+}
+
+optional<fc::path>
+net_plugin_impl::latest_snapshot() const {
+    auto latest     = optional<fc::path>();
+    auto latest_num = 0u;
+    if(!fc::is_directory(snapshots_dir)) {
+        return latest;
+    }
+    for(auto it = fc::directory_iterator(snapshots_dir); it != fc::directory_iterator(); ++it) {
+        auto head = full_snapshot_head((*it).filename().generic_string());
+        if(head.has_value() && (!latest.has_value() || block_header::num_from_id(*head) > latest_num)) {
+            latest     = *it;
+            latest_num = block_header::num_from_id(*head);
+        }
+    }
+    return latest;
+}
+
+void
+net_plugin_impl::prepare_snapshot_offer(const fc::path& path) {
+    snapshot_offer_path = path;
+    snapshot_offer.reset();
+
+    boost::asio::post(*server_ioc, [this, path] {
+        auto offer = std::make_shared<snapshot_offer_message>();
+        try {
+            offer->head_id    = *full_snapshot_head(path.filename().generic_string());
+            offer->size       = fc::file_size(path);
+            offer->chunk_size = def_snapshot_chunk_size;
+
+            auto file  = std::ifstream(path.generic_string(), std::ios::in | std::ios::binary);
+            auto chunk = std::vector<char>(def_snapshot_chunk_size);
+            for(auto pos = uint64_t(0); pos < offer->size; pos += def_snapshot_chunk_size) {
+                auto size = std::min<uint64_t>(def_snapshot_chunk_size, offer->size - pos);
+                file.read(chunk.data(), size);
+                EVT_ASSERT(file.good(), plugin_exception, "Cannot read snapshot ${f}", ("f", path.generic_string()));
+                offer->chunk_hashes.emplace_back(fc::sha256::hash(chunk.data(), size));
+            }
+            offer->hash = fc::sha256::hash(offer->chunk_hashes);
+            fc_ilog(logger, "Offering snapshot ${f} to joining nodes in ${n} chunks", ("f", path.generic_string())("n", offer->chunk_hashes.size()));
+        }
+        catch(const fc::exception& e) {
+            fc_elog(logger, "Cannot offer snapshot ${f}: ${e}", ("f", path.generic_string())("e", e.to_string()));
+            offer = std::make_shared<snapshot_offer_message>();
+        }
+
+        app().post(priority::low, [this, path, offer] {
+            if(path != snapshot_offer_path) {
+                return;
+            }
+            snapshot_offer = offer;
+            for(auto& w : snapshot_waiters) {
+                if(auto c = w.lock()) {
+                    c->enqueue(*offer);
+                }
+            }
+            snapshot_waiters.clear();
+        });
+    });
+}
+
+void
+net_plugin_impl::handle_message(const connection_ptr& c, const snapshot_query_message& msg) {
+    peer_ilog(c, "received snapshot_query_message");
+    auto path = serve_snapshots && msg.chain_id == chain_id ? latest_snapshot() : optional<fc::path>();
+    if(!path.has_value()) {
+        c->enqueue(snapshot_offer_message());
+        return;
+    }
+    if(*path != snapshot_offer_path) {
+        prepare_snapshot_offer(*path);
+    }
+    if(!snapshot_offer) {
+        snapshot_waiters.emplace_back(c);
+        return;
+    }
+    c->enqueue(*snapshot_offer);
+}
+
+void
+net_plugin_impl::handle_message(const connection_ptr& c, const snapshot_chunk_request_message& msg) {
+    auto offer = snapshot_offer;
+    if(!offer || offer->hash != msg.hash || msg.index >= offer->chunk_hashes.size()) {
+        auto reply  = snapshot_chunk_message();
+        reply.hash  = msg.hash;
+        reply.index = msg.index;
+        c->enqueue(reply);
+        return;
+    }
+
+    boost::asio::post(*server_ioc, [c, msg, offer, path = snapshot_offer_path] {
+        auto reply  = snapshot_chunk_message();
+        reply.hash  = msg.hash;
+        reply.index = msg.index;
+
+        auto pos  = (uint64_t)msg.index * offer->chunk_size;
+        auto file = std::ifstream(path.generic_string(), std::ios::in | std::ios::binary);
+        reply.data.resize(std::min<uint64_t>(offer->chunk_size, offer->size - pos));
+        file.seekg(pos);
+        file.read(reply.data.data(), reply.data.size());
+        if(!file.good()) {
+            fc_elog(logger, "Cannot read snapshot ${f}", ("f", path.generic_string()));
+            reply.data.clear();
+        }
+
+        app().post(priority::low, [c, reply = std::move(reply)] {
+            c->enqueue(reply);
+        });
+    });
+}
+
+void
+net_plugin_impl::handle_message(const connection_ptr& c, const snapshot_offer_message& msg) {
+    peer_wlog(c, "received unexpected snapshot_offer_message");
+}
+
+void
+net_plugin_impl::handle_message(const connection_ptr& c, const snapshot_chunk_message& msg) {
+    peer_wlog(c, "received unexpected snapshot_chunk_message");
+}
+
+void
+net_plugin_impl::fetch_snapshot(uint32_t chunks_in_flight) {
+    if(!chain_plug->can_load_snapshot()) {
+        fc_ilog(logger, "Chain state exists, snapshot is not fetched from peers");
+        return;
+    }
+    EVT_ASSERT(!supplied_peers.empty(), plugin_config_exception, "snapshot-from-peers requires p2p-peer-address");
+
+    if(!fc::exists(snapshots_dir)) {
+        fc::create_directories(snapshots_dir);
+    }
+    auto path    = snapshots_dir / "snapshot-peers.bin";
+    auto fetcher = snapshot_fetcher(chain_id, supplied_peers, chunks_in_flight);
+    auto head_id = fetcher.fetch(path);
+    if(!head_id.has_value()) {
+        fc_wlog(logger, "No peer offers a snapshot, chain starts from genesis");
+        return;
+    }
+
+    // named like the ones of producer_plugin, so this node offers it as well
+    auto name = fc::format_string("snapshot-${id}.bin", fc::mutable_variant_object()("id", *head_id));
+    fc::rename(path, snapshots_dir / name);
+    chain_plug->set_snapshot(snapshots_dir / name);
+    fc_ilog(logger, "Chain starts from snapshot ${f} fetched from peers", ("f", name));
+}
+
+void
+net_plugin_impl::handle_message(const connection_ptr& c, const block_log_segment_request_message& msg) {
+    peer_dlog(c, "received block_log_segment_request_message from block ${n}", ("n", msg.first_block_num));
+    auto reply            = block_log_segment_message();
+    reply.first_block_num = msg.first_block_num;
+    if(msg.chain_id != chain_id) {
+        c->enqueue(reply);
+        return;
+    }
+
+    auto& cc             = chain_plug->chain();
+    reply.head_block_num = cc.last_irreversible_block_num();
+    for(auto num = msg.first_block_num; num - msg.first_block_num < msg.count && num <= reply.head_block_num; num++) {
+        auto psb = cc.fetch_serialized_block_by_number(num);
+        if(psb.data.empty() || (!reply.data.empty() && reply.data.size() + psb.data.size() > def_block_log_segment_size)) {
+            break;
+        }
+        reply.data.insert(reply.data.end(), psb.data.begin(), psb.data.end());
+        reply.ends.emplace_back(reply.data.size());
+    }
+    c->enqueue(reply);
+}
+
+void
+net_plugin_impl::handle_message(const connection_ptr& c, const block_log_segment_message& msg) {
+    peer_wlog(c, "received unexpected block_log_segment_message");
+}
+
+void
+net_plugin_impl::fetch_block_log(uint32_t segment_blocks, uint32_t segments_in_flight) {
+    auto head = chain_plug->block_log_head_state();
+    if(!head.has_value()) {
+        fc_wlog(logger, "Block log cannot be extended before startup, blocks are not fetched from the block logs of peers");
+        return;
+    }
+    EVT_ASSERT(!supplied_peers.empty(), plugin_config_exception, "block-log-from-peers requires p2p-peer-address");
+
+    auto& cc      = chain_plug->chain();
+    auto  fetcher = block_log_fetcher(chain_id, supplied_peers, segment_blocks, segments_in_flight);
+    auto  n       = fetcher.fetch(*head, [&cc](auto& blocks) { cc.append_block_log(blocks); });
+    fc_ilog(logger, "${n} blocks fetched from the block logs of peers, they're replayed at startup", ("n", n));
+}
+
 void
 net_plugin_impl::handle_message(const connection_ptr& c, const signed_block_ptr& msg) {
+    fc_dlog(logger, "canceling wait on ${p}", ("p", c->peer_name()));
+    c->cancel_wait();
+
+    // blocks arriving ahead of the next expected one are held back by the sync manager
+    if(sync_master->recv_sync_block(c, msg)) {
+        return;
+    }
+    apply_block(c, msg);
+}
+
+void
+net_plugin_impl::apply_block(const connection_ptr& c, const signed_block_ptr& msg) {
     controller&   cc      = chain_plug->chain();
     block_id_type blk_id  = msg->id();
     uint32_t      blk_num = msg->block_num();
-    fc_dlog(logger, "canceling wait on ${p}", ("p", c->peer_name()));
-    c->cancel_wait();
 
     try {
         if(cc.fetch_block_by_id(blk_id)) {
+            c->score.duplicate_bytes += fc::raw::pack_size(*msg);
             sync_master->recv_block(c, blk_id, blk_num);
             return;
         }
@@ -2591,6 +4117,7 @@ net_plugin_impl::handle_message(const connection_ptr& c, const signed_block_ptr&
         fc_elog(logger, "Caught an unknown exception trying to recall blockID");
     }
 
+    c->score.useful_bytes += fc::raw::pack_size(*msg);
     dispatcher->recv_block(c, blk_id, blk_num);
     fc::microseconds age(fc::time_point::now() - msg->timestamp);
     peer_ilog(c, "received signed_block : #${n} block age in secs = ${age}",
@@ -2712,6 +4239,8 @@ net_plugin_impl::expire_txns() {
     auto start_size = local_txns.size();
 
     expire_local_txns();
+    retry_trx_pulls();
+    expire_compact_blocks();
 
     controller& cc  = chain_plug->chain();
     uint32_t    lib = cc.last_irreversible_block_num();
@@ -2743,7 +4272,8 @@ net_plugin_impl::expire_local_txns() {
 
 void
 net_plugin_impl::connection_monitor(std::weak_ptr<connection> from_connection) {
-    auto max_time = fc::time_point::now();
+    auto dead_timeout = fc::microseconds(std::chrono::duration_cast<std::chrono::microseconds>(keepalive_interval).count() * def_dead_peer_keepalives);
+    auto max_time     = fc::time_point::now();
     max_time += fc::milliseconds(max_cleanup_time_ms);
     auto from = from_connection.lock();
     auto it   = (from ? connections.find(from) : connections.begin());
@@ -2763,11 +4293,37 @@ net_plugin_impl::connection_monitor(std::weak_ptr<connection> from_connection) {
                 continue;
             }
         }
+        else if((*it)->socket->is_open() && !(*it)->connecting && (*it)->score.last_recv + dead_timeout < fc::time_point::now()) {
+            // peers send time_message every keepalive interval, this one is gone
+            fc_wlog(logger, "nothing received from ${p} for ${s}s, closing", ("p", (*it)->peer_name())("s", dead_timeout.to_seconds()));
+            close(*it);
+        }
         ++it;
     }
     start_conn_timer(connector_period, std::weak_ptr<connection>());
 }
 
+bool
+net_plugin_impl::evict_client() {
+    // only clients scored for a while and worse than a peer nothing is known about
+    auto now   = fc::time_point::now();
+    auto worst = connection_ptr();
+    for(auto& c : connections) {
+        if(!c->peer_addr.empty() || !c->socket->is_open() || c->score.connected + fc::seconds(def_evict_min_age_secs) > now) {
+            continue;
+        }
+        if(c->rank() < 0.5 && (!worst || c->rank() < worst->rank())) {
+            worst = c;
+        }
+    }
+    if(!worst) {
+        return false;
+    }
+    fc_ilog(logger, "evicting client ${p} with score ${s} to make room for a new one", ("p", worst->peer_name())("s", worst->rank()));
+    close(worst);
+    return true;
+}
+
 void
 net_plugin_impl::close(const connection_ptr& c) {
     if(c->peer_addr.empty() && c->socket->is_open()) {
@@ -2784,6 +4340,12 @@ net_plugin_impl::close(const connection_ptr& c) {
 void
 net_plugin_impl::accepted_block(const block_state_ptr& block) {
     fc_dlog(logger, "signaled, id = ${id}", ("id", block->id));
+    {
+        // blocks built on it are verified on net threads
+        auto base = std::make_shared<const block_header_state>(*block);
+        std::lock_guard<std::mutex> lock(verify_mtx);
+        verify_base = std::move(base);
+    }
     dispatcher->bcast_block(block);
 }
 
@@ -2948,8 +4510,24 @@ net_plugin::set_program_options(options_description& /*cli*/, options_descriptio
         ("connection-cleanup-period", bpo::value<int>()->default_value(def_conn_retry_wait), "number of seconds to wait before cleaning up dead connections")
         ("max-cleanup-time-msec", bpo::value<int>()->default_value(10), "max connection cleanup time per cleanup call in millisec")
         ("network-version-match", bpo::value<bool>()->default_value(false), "True to require exact match of peer network version.")
-        ("sync-fetch-span", bpo::value<uint32_t>()->default_value(def_sync_fetch_span), "number of blocks to retrieve in a chunk from any individual peer during synchronization")
+        ("sync-fetch-span", bpo::value<uint32_t>()->default_value(def_sync_fetch_span), "initial number of blocks to retrieve in a chunk from any individual peer during synchronization, adjusted per peer from its measured throughput")
         ("use-socket-read-watermark", bpo::value<bool>()->default_value(false), "Enable expirimental socket read watermark optimization")
+        ("net-threads", bpo::value<uint16_t>()->default_value(my->thread_pool_size), "Number of worker threads in net_plugin thread pool, messages are decoded there. Not used when reactor-threads is set")
+        ("p2p-traffic-budget", bpo::value<vector<string>>()->composing(), "class=KB, bytes a traffic class may write to a peer per write round before the lower classes get a turn, classes are block, control, sync and trx. Use multiple p2p-traffic-budget options as needed.")
+        ("p2p-max-trx-in-progress", bpo::value<uint32_t>()->default_value(def_max_trx_in_progress_size / (1024 * 1024)), "MB of transactions received from one peer and still being applied before reads from it pause")
+        ("p2p-max-trx-in-progress-total", bpo::value<uint32_t>()->default_value(def_max_trx_in_progress_total / (1024 * 1024)), "MB of transactions from all peers still being applied before announced transactions are no longer pulled")
+        ("p2p-max-trx-queued-total", bpo::value<uint32_t>()->default_value(def_max_trx_queued_total / (1024 * 1024)), "MB of transactions waiting in all the write queues before transactions are no longer relayed")
+        ("p2p-trx-relay-fanout", bpo::value<uint32_t>()->default_value(0), "Number of best scored peers a transaction is relayed to, 0 for all peers")
+        ("p2p-compress-peer", bpo::value<vector<string>>()->composing(), "host:port, host or IP address of a peer asked to zstd compress the messages it sends to this node, '*' for every peer. Use multiple p2p-compress-peer options as needed.")
+        ("p2p-compress-dict", bpo::value<string>(), "zstd dictionary used for p2p compression when the peer loaded the same one, see 'evtbl --train-dict'")
+        ("p2p-compress-level", bpo::value<int>()->default_value(def_compress_level), "zstd level of the messages compressed for peers")
+        ("p2p-serve-snapshots", bpo::value<bool>()->default_value(false), "Offer the latest full snapshot in p2p-snapshots-dir to the nodes joining the network")
+        ("p2p-snapshots-dir", bpo::value<string>()->default_value("snapshots"), "Directory of the snapshots offered to peers and of the ones fetched from them, relative paths are in the data dir. Defaults to the one producer_plugin writes snapshots to")
+        ("snapshot-from-peers", bpo::value<bool>()->default_value(false), "Start a node without chain state from the latest snapshot offered by the p2p-peer-address peers instead of replaying from genesis, it's downloaded from all of them at once")
+        ("snapshot-chunks-in-flight", bpo::value<uint32_t>()->default_value(def_snapshot_chunks_in_flight), "Number of snapshot chunks requested at once from each peer")
+        ("block-log-from-peers", bpo::value<bool>()->default_value(false), "Before the chain starts, append the irreversible blocks it misses from the block logs of the p2p-peer-address peers to the block log, they're replayed at startup. Blocks are fetched in segments from all the peers at once, for nodes far behind")
+        ("block-log-segment-blocks", bpo::value<uint32_t>()->default_value(def_block_log_segment_blocks), "Number of blocks asked for at once from a peer by block-log-from-peers")
+        ("block-log-segments-in-flight", bpo::value<uint32_t>()->default_value(def_block_log_segments_in_flight), "Number of block log segments requested at once from each peer")
         ("peer-log-format", bpo::value<string>()->default_value("[\"${_name}\" ${_ip}:${_port}]"),
             "The string used to format peers when logging messages about them.  Variables are escaped with ${<variable name>}.\n"
             "Available Variables:\n"
@@ -2991,6 +4569,46 @@ net_plugin::plugin_initialize(const variables_map& options) {
 
         my->use_socket_read_watermark = options.at("use-socket-read-watermark").as<bool>();
 
+        my->thread_pool_size = options.at("net-threads").as<uint16_t>();
+        EVT_ASSERT(my->thread_pool_size > 0, plugin_config_exception,
+                   "net-threads ${num} must be greater than 0", ("num", my->thread_pool_size));
+
+        my->traffic_budgets = def_traffic_budgets;
+        if(options.count("p2p-traffic-budget")) {
+            static const auto names = std::array<string, traffic_classes>{{"block", "control", "sync", "trx"}};
+            for(auto& b : options.at("p2p-traffic-budget").as<vector<string>>()) {
+                auto pos = b.find('=');
+                auto it  = std::find(names.begin(), names.end(), b.substr(0, pos));
+                EVT_ASSERT(pos != string::npos && it != names.end(), plugin_config_exception,
+                           "Invalid p2p-traffic-budget ${b}, expected class=KB", ("b", b));
+                auto kb = std::stoul(b.substr(pos + 1));
+                EVT_ASSERT(kb > 0, plugin_config_exception, "p2p-traffic-budget ${b} must be greater than 0", ("b", b));
+                my->traffic_budgets[it - names.begin()] = kb * 1024;
+            }
+        }
+        my->max_trx_in_progress       = options.at("p2p-max-trx-in-progress").as<uint32_t>() * 1024ull * 1024;
+        my->max_trx_in_progress_total = options.at("p2p-max-trx-in-progress-total").as<uint32_t>() * 1024ull * 1024;
+        my->max_trx_queued_total      = options.at("p2p-max-trx-queued-total").as<uint32_t>() * 1024ull * 1024;
+        my->trx_relay_fanout          = options.at("p2p-trx-relay-fanout").as<uint32_t>();
+
+        if(options.count("p2p-compress-peer")) {
+            my->compress_peers = options.at("p2p-compress-peer").as<vector<string>>();
+        }
+        my->compress_level    = options.at("p2p-compress-level").as<int>();
+        my->compress_min_size = def_compress_min_size;
+        my->compress_ctx.reset(ZSTD_createCCtx());
+        if(options.count("p2p-compress-dict")) {
+            auto dict_path = fc::path(options.at("p2p-compress-dict").as<string>());
+            EVT_ASSERT(fc::exists(dict_path), plugin_config_exception, "p2p-compress-dict ${p} doesn't exist", ("p", dict_path.generic_string()));
+
+            auto dict = std::string();
+            fc::read_file_contents(dict_path, dict);
+            my->compress_dict_id = ZDICT_getDictID(dict.data(), dict.size());
+            EVT_ASSERT(my->compress_dict_id != 0, plugin_config_exception, "p2p-compress-dict ${p} is not a zstd dictionary", ("p", dict_path.generic_string()));
+            my->compress_cdict.reset(ZSTD_createCDict(dict.data(), dict.size(), my->compress_level));
+            my->compress_ddict.reset(ZSTD_createDDict(dict.data(), dict.size()));
+        }
+
         if(options.count("p2p-listen-endpoint") && options.at("p2p-listen-endpoint").as<string>().length()) {
             my->p2p_address = options.at("p2p-listen-endpoint").as<string>();
         }
@@ -3044,6 +4662,17 @@ net_plugin::plugin_initialize(const variables_map& options) {
         my->chain_id = my->chain_plug->get_chain_id();
         fc::rand_pseudo_bytes(my->node_id.data(), my->node_id.data_size());
         fc_ilog(logger, "my node_id is ${id}", ("id", my->node_id));
+
+        my->serve_snapshots = options.at("p2p-serve-snapshots").as<bool>();
+        auto snapshots_dir  = boost::filesystem::path(options.at("p2p-snapshots-dir").as<string>());
+        my->snapshots_dir   = snapshots_dir.is_relative() ? app().data_dir() / snapshots_dir : snapshots_dir;
+        // the chain starts after this, from the snapshot fetched
+        if(options.at("snapshot-from-peers").as<bool>()) {
+            my->fetch_snapshot(options.at("snapshot-chunks-in-flight").as<uint32_t>());
+        }
+        if(options.at("block-log-from-peers").as<bool>()) {
+            my->fetch_block_log(options.at("block-log-segment-blocks").as<uint32_t>(), options.at("block-log-segments-in-flight").as<uint32_t>());
+        }
     }
     FC_LOG_AND_RETHROW()
 }
@@ -3052,11 +4681,20 @@ void
 net_plugin::plugin_startup() {
     my->producer_plug = app().find_plugin<producer_plugin>();
 
-    my->server_ioc = std::make_shared<boost::asio::io_context>();
-    my->server_ioc_work.emplace(boost::asio::make_work_guard(*my->server_ioc));
-    my->server_thread.emplace([ioc = my->server_ioc] {
-        ioc->run();
-    });
+    my->reactors = app().find_plugin<reactor_plugin>();
+    if(my->reactors->enabled()) {
+        // connections are spread over the shared reactors, net-threads is not used
+        my->server_ioc = my->reactors->next();
+    }
+    else {
+        my->server_ioc = std::make_shared<boost::asio::io_context>();
+        my->server_ioc_work.emplace(boost::asio::make_work_guard(*my->server_ioc));
+        for(auto i = 0u; i < my->thread_pool_size; i++) {
+            my->server_threads.emplace_back([ioc = my->server_ioc] {
+                ioc->run();
+            });
+        }
+    }
 
     my->resolver = std::make_shared<tcp::resolver>(std::ref(*my->server_ioc));
     if(my->p2p_address.size() > 0) {
@@ -3087,6 +4725,7 @@ net_plugin::plugin_startup() {
     }
 
     my->keepalive_timer.reset(new boost::asio::steady_timer(*my->server_ioc));
+    my->trx_announce_timer.reset(new boost::asio::steady_timer(*my->server_ioc));
     my->ticker();
 
     if(my->acceptor) {
@@ -3122,6 +4761,31 @@ net_plugin::plugin_startup() {
         connect(seed_node);
     }
     handle_sighup();
+
+    my->metrics_collector = utilities::metrics::registry::get().add_collector([this](auto& w) {
+        auto conns = connections();
+        w.gauge("evt_net_peers", "Connections to peers, including the ones connecting", conns.size());
+        for(auto& c : conns) {
+            w.gauge("evt_net_peer_write_queue_bytes", "Bytes queued to be written to the peer", c.write_queue_bytes, {{"peer", c.peer}});
+            w.gauge("evt_net_peer_write_queue_messages", "Messages queued to be written to the peer", c.write_queue_msgs, {{"peer", c.peer}});
+            w.gauge("evt_net_peer_bytes_in_flight", "Bytes being written to the peer", c.bytes_in_flight, {{"peer", c.peer}});
+        }
+
+        auto& s = my->stats;
+        w.counter("evt_net_block_buffer_hits_total", "Block messages reused from the buffer cache", s.block_buffer_hits);
+        w.counter("evt_net_block_buffer_misses_total", "Block messages packed again", s.block_buffer_misses);
+        w.gauge("evt_net_block_buffer_bytes", "Size of the cached block messages", s.block_buffer_bytes);
+        w.counter("evt_net_compress_in_bytes_total", "Size of the messages compressed for peers", s.compress_bytes_in);
+        w.counter("evt_net_compress_out_bytes_total", "Size of the messages after compression", s.compress_bytes_out);
+    });
+
+    // the budget is only recorded here, reads check it themselves so they resume as soon as the queues drain
+    my->memory_component = utilities::memory::accountant::get().add_component("net_write_queues", [this](auto& u) {
+        u.bytes = my->write_queues_size();
+        u.items = my->connections.size();
+    }, [this](auto& u) {
+        my->write_queues_budget = u.budget;
+    });
 }
 
 void
@@ -3135,6 +4799,12 @@ void
 net_plugin::plugin_shutdown() {
     try {
         fc_ilog(logger, "shutdown..");
+        if(my->metrics_collector.has_value()) {
+            utilities::metrics::registry::get().remove_collector(*my->metrics_collector);
+        }
+        if(my->memory_component.has_value()) {
+            utilities::memory::accountant::get().remove_component(*my->memory_component);
+        }
         if(my->server_ioc_work.has_value()) {
             my->server_ioc_work->reset();
         }
@@ -3147,6 +4817,9 @@ net_plugin::plugin_shutdown() {
         if(my->keepalive_timer) {
             my->keepalive_timer->cancel();
         }
+        if(my->trx_announce_timer) {
+            my->trx_announce_timer->cancel();
+        }
 
         my->done = true;
         if(my->acceptor) {
@@ -3161,13 +4834,14 @@ net_plugin::plugin_shutdown() {
             my->connections.clear();
         }
 
-        if(my->server_ioc) {
+        if(my->server_ioc && !my->server_threads.empty()) {
+            // a shared reactor is stopped by reactor_plugin
             my->server_ioc->stop();
         }
-        if(my->server_thread.has_value()) {
-            my->server_thread->join();
-            my->server_thread.reset();
+        for(auto& t : my->server_threads) {
+            t.join();
         }
+        my->server_threads.clear();
         fc_ilog(logger, "exit shutdown");
     }
     FC_CAPTURE_AND_RETHROW()
@@ -3215,6 +4889,11 @@ net_plugin::status(const string& host) const {
     return optional<connection_status>();
 }
 
+net_stats
+net_plugin::stats() const {
+    return my->stats;
+}
+
 vector<connection_status>
 net_plugin::connections() const {
     vector<connection_status> result;
@@ -3224,6 +4903,15 @@ net_plugin::connections() const {
     }
     return result;
 }
+uint64_t
+net_plugin_impl::write_queues_size() const {
+    auto n = uint64_t(0);
+    for(auto& c : connections) {
+        n += c->buffer_queue.write_queue_size() + c->buffer_queue.out_queue_size();
+    }
+    return n;
+}
+
 connection_ptr
 net_plugin_impl::find_connection(const string& host) const {
     for(const auto& c : connections)
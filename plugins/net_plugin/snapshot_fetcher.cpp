@@ -0,0 +1,183 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#include <evt/net_plugin/snapshot_fetcher.hpp>
+
+#include <evt/net_plugin/peer_session.hpp>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+
+#include <fc/log/logger.hpp>
+
+namespace evt {
+
+namespace {
+
+constexpr auto max_chunk_size = 4 * 1024 * 1024;
+
+bool
+valid_offer(const snapshot_offer_message& offer) {
+    if(offer.size == 0 || offer.chunk_size == 0 || offer.chunk_size > max_chunk_size) {
+        return false;
+    }
+    if(offer.chunk_hashes.size() != (offer.size + offer.chunk_size - 1) / offer.chunk_size) {
+        return false;
+    }
+    return fc::sha256::hash(offer.chunk_hashes) == offer.hash;
+}
+
+}  // namespace
+
+snapshot_fetcher::snapshot_fetcher(const chain_id_type& chain_id, std::vector<std::string> peers, uint32_t chunks_in_flight)
+    : chain_id_(chain_id)
+    , peers_(std::move(peers))
+    , chunks_in_flight_(std::max(chunks_in_flight, 1u)) {}
+
+std::optional<block_id_type>
+snapshot_fetcher::fetch(const fc::path& path) {
+    auto sessions = std::vector<std::unique_ptr<peer_session>>();
+    for(auto& p : peers_) {
+        sessions.emplace_back(std::make_unique<peer_session>(p));
+    }
+
+    auto offers = std::vector<std::optional<snapshot_offer_message>>(sessions.size());
+    for_each_parallel(sessions.size(), [&](size_t i) {
+        auto& s = *sessions[i];
+        try {
+            s.connect();
+            s.send(snapshot_query_message{ chain_id_ });
+
+            auto offer = s.receive<snapshot_offer_message>();
+            if(offer.chunk_hashes.empty()) {
+                ilog("Peer ${p} offers no snapshot", ("p", s.peer()));
+            }
+            else if(!valid_offer(offer)) {
+                wlog("Peer ${p} offers an invalid snapshot", ("p", s.peer()));
+            }
+            else {
+                offers[i] = std::move(offer);
+            }
+        }
+        catch(const fc::exception& e) {
+            wlog("Cannot get the snapshot offer of peer ${p}: ${e}", ("p", s.peer())("e", e.to_string()));
+        }
+        catch(const std::exception& e) {
+            wlog("Cannot get the snapshot offer of peer ${p}: ${e}", ("p", s.peer())("e", e.what()));
+        }
+    });
+
+    // latest snapshot wins, then the one offered by most peers
+    auto best    = std::optional<snapshot_offer_message>();
+    auto sources = std::vector<size_t>();
+    for(auto i = 0u; i < offers.size(); i++) {
+        if(!offers[i].has_value()) {
+            continue;
+        }
+        auto peers = std::vector<size_t>();
+        for(auto j = 0u; j < offers.size(); j++) {
+            if(offers[j].has_value() && offers[j]->hash == offers[i]->hash) {
+                peers.emplace_back(j);
+            }
+        }
+        if(!best.has_value() || block_header::num_from_id(offers[i]->head_id) > block_header::num_from_id(best->head_id)
+           || (offers[i]->head_id == best->head_id && peers.size() > sources.size())) {
+            best    = offers[i];
+            sources = std::move(peers);
+        }
+    }
+    if(!best.has_value()) {
+        return std::nullopt;
+    }
+
+    auto& offer = *best;
+    auto  total = (uint32_t)offer.chunk_hashes.size();
+    ilog("Downloading snapshot at block ${n} of ${s} bytes in ${c} chunks from ${p} peers",
+         ("n", block_header::num_from_id(offer.head_id))("s", offer.size)("c", total)("p", sources.size()));
+
+    auto part = fc::path(path.generic_string() + ".part");
+    auto file = std::fstream(part.generic_string(), std::ios::out | std::ios::binary | std::ios::trunc);
+    EVT_ASSERT(file.is_open(), plugin_exception, "Cannot create snapshot file ${f}", ("f", part.generic_string()));
+
+    auto mtx       = std::mutex();
+    auto cv        = std::condition_variable();
+    auto pending   = std::deque<uint32_t>();
+    auto remaining = total;
+    auto logged    = 0u;
+    for(auto i = 0u; i < total; i++) {
+        pending.emplace_back(i);
+    }
+
+    for_each_parallel(sources.size(), [&](size_t i) {
+        auto& s        = *sessions[sources[i]];
+        auto  inflight = std::vector<uint32_t>();
+        try {
+            while(true) {
+                auto first = inflight.size();
+                {
+                    auto lock = std::unique_lock<std::mutex>(mtx);
+                    // idle peers wait for the chunks given back by a failing one
+                    cv.wait(lock, [&] { return remaining == 0 || !pending.empty() || !inflight.empty(); });
+                    if(remaining == 0) {
+                        return;
+                    }
+                    while(inflight.size() < chunks_in_flight_ && !pending.empty()) {
+                        inflight.emplace_back(pending.front());
+                        pending.pop_front();
+                    }
+                }
+                for(auto j = first; j < inflight.size(); j++) {
+                    s.send(snapshot_chunk_request_message{ offer.hash, inflight[j] });
+                }
+
+                // chunks may come back in any order
+                auto chunk = s.receive<snapshot_chunk_message>();
+                auto it    = std::find(inflight.begin(), inflight.end(), chunk.index);
+                EVT_ASSERT(chunk.hash == offer.hash && it != inflight.end(), plugin_exception, "Unexpected snapshot chunk ${i}", ("i", chunk.index));
+                EVT_ASSERT(!chunk.data.empty(), plugin_exception, "Snapshot is no longer offered");
+
+                auto offset = (uint64_t)chunk.index * offer.chunk_size;
+                auto size   = std::min<uint64_t>(offer.chunk_size, offer.size - offset);
+                EVT_ASSERT(chunk.data.size() == size && fc::sha256::hash(chunk.data.data(), size) == offer.chunk_hashes[chunk.index],
+                           plugin_exception, "Snapshot chunk ${i} doesn't match its digest", ("i", chunk.index));
+
+                auto lock = std::unique_lock<std::mutex>(mtx);
+                file.seekp(offset);
+                file.write(chunk.data.data(), size);
+                EVT_ASSERT(file.good(), plugin_exception, "Cannot write snapshot file ${f}", ("f", part.generic_string()));
+
+                inflight.erase(it);
+                if(--remaining == 0) {
+                    cv.notify_all();
+                }
+                if((total - remaining) * 20 / total > logged) {
+                    logged = (total - remaining) * 20 / total;
+                    ilog("Downloaded ${n} of ${t} snapshot chunks", ("n", total - remaining)("t", total));
+                }
+            }
+        }
+        catch(const fc::exception& e) {
+            wlog("Stopped downloading snapshot from peer ${p}: ${e}", ("p", s.peer())("e", e.to_string()));
+        }
+        catch(const std::exception& e) {
+            wlog("Stopped downloading snapshot from peer ${p}: ${e}", ("p", s.peer())("e", e.what()));
+        }
+
+        auto lock = std::unique_lock<std::mutex>(mtx);
+        pending.insert(pending.end(), inflight.begin(), inflight.end());
+        cv.notify_all();
+    });
+
+    file.close();
+    EVT_ASSERT(remaining == 0, plugin_exception, "Failed to download the snapshot, ${n} chunks are missing", ("n", remaining));
+
+    fc::rename(part, path);
+    return offer.head_id;
+}
+
+}  // namespace evt
@@ -6,6 +6,7 @@
 
 #pragma GCC diagnostic ignored "-Wunused-local-typedefs"
 
+#include <future>
 #include <fmt/format.h>
 #include <libpq-fe.h>
 #include <boost/lexical_cast.hpp>
@@ -27,8 +28,10 @@ namespace evt {
  * - 1.3.0  add `ft_holders` table
  * - 1.3.1  add serveral indexes for better query performance
  * - 1.4.0  update `fungibles` to support transfer permission
+ * - 1.5.0  add covering indexes for the cursor paging of `actions` and `transactions`
+ * - 1.6.0  add `ft_balances`, `address_activity` and `domain_stats` summary tables
  */
-static auto pg_version = "1.4.0";
+static auto pg_version = "1.6.0";
 
 namespace internal {
 
@@ -128,6 +131,10 @@ auto create_trxs_table = R"sql(CREATE TABLE IF NOT EXISTS public.transactions
                                    TABLESPACE pg_default;
                                CREATE INDEX IF NOT EXISTS transactions_keys_index
                                    ON public.transactions USING GIN (keys array_ops)
+                                   TABLESPACE pg_default;
+                               CREATE INDEX IF NOT EXISTS transactions_cursor_index
+                                   ON public.transactions USING btree
+                                   (block_num, seq_num)
                                    TABLESPACE pg_default;)sql";
 
 auto create_actions_table = R"sql(CREATE TABLE IF NOT EXISTS public.actions
@@ -162,7 +169,51 @@ auto create_actions_table = R"sql(CREATE TABLE IF NOT EXISTS public.actions
                                   CREATE INDEX IF NOT EXISTS actions_filter_index
                                       ON public.actions USING btree
                                       (domain, key, name)
-                                      TABLESPACE pg_default;)sql";
+                                      TABLESPACE pg_default;
+                                  CREATE INDEX IF NOT EXISTS actions_domain_cursor_index
+                                      ON public.actions USING btree
+                                      (domain, global_seq) INCLUDE (name)
+                                      TABLESPACE pg_default;
+                                  CREATE INDEX IF NOT EXISTS actions_key_cursor_index
+                                      ON public.actions USING btree
+                                      (domain, key, global_seq) INCLUDE (name)
+                                      TABLESPACE pg_default;
+                                  CREATE INDEX IF NOT EXISTS actions_fungible_cursor_index
+                                      ON public.actions USING btree
+                                      (key, global_seq) INCLUDE (name)
+                                      TABLESPACE pg_default
+                                      WHERE domain = '.fungible';)sql";
+
+// declarative range partitions by block num, the indexes of the parent are created on each partition
+auto create_actions_partitioned_table = R"sql(CREATE TABLE IF NOT EXISTS public.actions
+                                              (
+                                                  block_id   character(64)            NOT NULL,
+                                                  block_num  integer                  NOT NULL,
+                                                  trx_id     character(64)            NOT NULL,
+                                                  seq_num    integer                  NOT NULL,
+                                                  global_seq bigint                   NOT NULL,
+                                                  name       character varying(13)    NOT NULL,
+                                                  domain     character varying(21)    NOT NULL,
+                                                  key        character varying(21)    NOT NULL,
+                                                  data       jsonb                    NOT NULL,
+                                                  created_at timestamp with time zone NOT NULL DEFAULT now()
+                                              )
+                                              PARTITION BY RANGE (block_num);
+                                              CREATE INDEX IF NOT EXISTS actions_trx_id_index
+                                                  ON public.actions USING btree (trx_id);
+                                              CREATE INDEX IF NOT EXISTS actions_global_seq_index
+                                                  ON public.actions USING btree (global_seq);
+                                              CREATE INDEX IF NOT EXISTS actions_data_index
+                                                  ON public.actions USING gin (data jsonb_path_ops);
+                                              CREATE INDEX IF NOT EXISTS actions_filter_index
+                                                  ON public.actions USING btree (domain, key, name);
+                                              CREATE INDEX IF NOT EXISTS actions_domain_cursor_index
+                                                  ON public.actions USING btree (domain, global_seq) INCLUDE (name);
+                                              CREATE INDEX IF NOT EXISTS actions_key_cursor_index
+                                                  ON public.actions USING btree (domain, key, global_seq) INCLUDE (name);
+                                              CREATE INDEX IF NOT EXISTS actions_fungible_cursor_index
+                                                  ON public.actions USING btree (key, global_seq) INCLUDE (name)
+                                                  WHERE domain = '.fungible';)sql";
 
 auto create_metas_table = R"sql(CREATE SEQUENCE IF NOT EXISTS metas_id_seq;
                                 CREATE TABLE IF NOT EXISTS metas
@@ -288,6 +339,68 @@ auto create_ft_holders_table = R"sql(CREATE TABLE IF NOT EXISTS public.ft_holder
                                      )
                                      TABLESPACE pg_default;)sql";
 
+// summaries of irreversible blocks, `block_num` is the last block which changed the row
+auto create_ft_balances_table = R"sql(CREATE TABLE IF NOT EXISTS public.ft_balances
+                                      (
+                                          address    character(53)             NOT NULL,
+                                          sym_id     bigint                    NOT NULL,
+                                          balance    character varying(64)     NOT NULL,
+                                          block_num  integer                   NOT NULL,
+                                          updated_at timestamp with time zone  NOT NULL  DEFAULT now(),
+                                          CONSTRAINT ft_balances_pkey PRIMARY KEY (address, sym_id)
+                                      )
+                                      WITH (
+                                          OIDS = FALSE
+                                      )
+                                      TABLESPACE pg_default;)sql";
+
+auto create_address_activity_table = R"sql(CREATE TABLE IF NOT EXISTS public.address_activity
+                                           (
+                                               address      character(53)             NOT NULL,
+                                               block_num    integer                   NOT NULL,
+                                               trx_id       character(64)             NOT NULL,
+                                               action       character varying(13)     NOT NULL,
+                                               action_count bigint                    NOT NULL,
+                                               updated_at   timestamp with time zone  NOT NULL  DEFAULT now(),
+                                               CONSTRAINT   address_activity_pkey PRIMARY KEY (address)
+                                           )
+                                           WITH (
+                                               OIDS = FALSE
+                                           )
+                                           TABLESPACE pg_default;)sql";
+
+auto create_domain_stats_table = R"sql(CREATE TABLE IF NOT EXISTS public.domain_stats
+                                       (
+                                           domain      character varying(21)     NOT NULL,
+                                           token_count bigint                    NOT NULL,
+                                           block_num   integer                   NOT NULL,
+                                           updated_at  timestamp with time zone  NOT NULL  DEFAULT now(),
+                                           CONSTRAINT  domain_stats_pkey PRIMARY KEY (domain)
+                                       )
+                                       WITH (
+                                           OIDS = FALSE
+                                       )
+                                       TABLESPACE pg_default;)sql";
+
+// progress of the backfill jobs from the block log, kept out of `tables` as it is not in snapshots
+auto create_backfill_jobs_table = R"sql(CREATE TABLE IF NOT EXISTS public.backfill_jobs
+                                        (
+                                            id          integer  NOT NULL,
+                                            first_block integer  NOT NULL,
+                                            last_block  integer  NOT NULL,
+                                            done_block  integer  NOT NULL,
+                                            CONSTRAINT  backfill_jobs_pkey PRIMARY KEY (id)
+                                        )
+                                        WITH (
+                                            OIDS = FALSE
+                                        )
+                                        TABLESPACE pg_default;)sql";
+
+// columns written by COPY, created_at is left to its default
+auto blocks_copy_columns  = "blocks (block_id, block_num, prev_block_id, timestamp, trx_merkle_root, trx_count, producer, pending)";
+auto trxs_copy_columns    = "transactions (trx_id, seq_num, block_id, block_num, action_count, timestamp, expiration, max_charge, payer, "
+                            "pending, type, status, signatures, keys, elapsed, charge, suspend_name)";
+auto actions_copy_columns = "actions (block_id, block_num, trx_id, seq_num, global_seq, name, domain, key, data)";
 
 struct table {
     std::string name;
@@ -304,7 +417,10 @@ table tables[] = {
     { "tokens",       false },
     { "groups",       false },
     { "fungibles",    false },
-    { "ft_holders",   false }
+    { "ft_holders",   false },
+    { "ft_balances",      false },
+    { "address_activity", false },
+    { "domain_stats",     false }
 };
 
 template<typename Iterator>
@@ -357,12 +473,58 @@ pg::connect(const std::string& conn) {
     return PG_OK;
 }
 
+int
+pg::connect_writers(const std::string& conn, size_t n) {
+    if(n <= 1) {
+        return PG_OK;
+    }
+
+    auto connect_one = [&conn] {
+        auto c = PQconnectdb(conn.c_str());
+        if(PQstatus(c) != CONNECTION_OK) {
+            PQfinish(c);
+            EVT_THROW(chain::postgres_connection_exception, "Connect writer failed");
+        }
+        return c;
+    };
+    for(auto i = 0; i < 3; i++) {
+        copy_conns_.emplace_back(connect_one());
+    }
+    for(auto i = 0u; i < n; i++) {
+        shard_conns_.emplace_back(connect_one());
+    }
+
+    return PG_OK;
+}
+
+int
+pg::set_async_commit() {
+    auto conns = std::vector<pg_conn*>{ conn_ };
+    conns.insert(conns.end(), copy_conns_.begin(), copy_conns_.end());
+    conns.insert(conns.end(), shard_conns_.begin(), shard_conns_.end());
+
+    // a server crash may lose the last commits but never reorders them, the sync marker stays behind the data
+    for(auto conn : conns) {
+        exec_stmts(conn, "SET synchronous_commit TO OFF;");
+    }
+    return PG_OK;
+}
+
 int
 pg::close() {
     FC_ASSERT(conn_);
     PQfinish(conn_);
     conn_ = nullptr;
 
+    for(auto c : copy_conns_) {
+        PQfinish(c);
+    }
+    for(auto c : shard_conns_) {
+        PQfinish(c);
+    }
+    copy_conns_.clear();
+    shard_conns_.clear();
+
     return PG_OK;
 }
 
@@ -402,6 +564,75 @@ pg::drop_partitions(const std::string& table) {
     return PG_OK;
 }
 
+void
+pg::set_native_partitions(uint interval, uint ahead, uint retain) {
+    part_interval_ = interval;
+    part_ahead_    = ahead;
+    part_retain_   = retain;
+}
+
+int
+pg::is_partitioned_table(const std::string& table) {
+    auto stmt = fmt::format("SELECT relkind FROM pg_class WHERE relname = '{}' AND relkind = 'p';", table);
+
+    auto r = PQexec(conn_, stmt.c_str());
+    EVT_ASSERT(PQresultStatus(r) == PGRES_TUPLES_OK, chain::postgres_exec_exception, "Check if table is partitioned failed, detail: ${s}", ("s",PQerrorMessage(conn_)));
+
+    auto n = PQntuples(r);
+    PQclear(r);
+    return n > 0 ? PG_OK : PG_FAIL;
+}
+
+int
+pg::ensure_partitions(int block_num) {
+    if(part_interval_ == 0) {
+        return PG_OK;
+    }
+
+    // partition k holds the blocks [k * interval, (k + 1) * interval), `ahead` more are always there
+    auto k    = (int64_t)block_num / part_interval_;
+    auto last = k + part_ahead_;
+    if(last <= last_partition_) {
+        return PG_OK;
+    }
+
+    // from the first one after a restart: the cold ones which were detached exist and are left alone
+    for(auto i = last_partition_ + 1; i <= last; i++) {
+        auto stmt = fmt::format("CREATE TABLE IF NOT EXISTS actions_p{0} PARTITION OF actions FOR VALUES FROM ({1}) TO ({2});",
+            i, i * part_interval_, (i + 1) * part_interval_);
+        exec_stmts(conn_, stmt);
+    }
+    last_partition_ = last;
+
+    if(part_retain_ == 0 || k < (int64_t)part_retain_) {
+        return PG_OK;
+    }
+
+    // detached partitions stay as plain tables to be archived, the queries do not see them anymore
+    auto r = PQexec(conn_, R"sql(SELECT c.relname FROM pg_inherits i JOIN pg_class c ON c.oid = i.inhrelid
+                                 WHERE i.inhparent = 'actions'::regclass;)sql");
+    EVT_ASSERT(PQresultStatus(r) == PGRES_TUPLES_OK, chain::postgres_exec_exception, "List partitions failed, detail: ${s}", ("s",PQerrorMessage(conn_)));
+
+    auto cold = std::vector<std::string>();
+    for(auto i = 0; i < PQntuples(r); i++) {
+        auto name = std::string(PQgetvalue(r, i, 0));
+        if(name.compare(0, 9, "actions_p") != 0) {
+            continue;
+        }
+        auto idx = boost::lexical_cast<int64_t>(name.substr(9));
+        if(idx <= k - (int64_t)part_retain_) {
+            cold.emplace_back(std::move(name));
+        }
+    }
+    PQclear(r);
+
+    for(auto& name : cold) {
+        ilog("Detaching cold partition ${p}", ("p",name));
+        exec_stmts(conn_, fmt::format("ALTER TABLE actions DETACH PARTITION {};", name));
+    }
+    return PG_OK;
+}
+
 int
 pg::create_db(const std::string& db) {
     auto sql = R"sql(CREATE DATABASE {}
@@ -523,6 +754,23 @@ pg::drop_all_tables() {
         drop_table(t.name);
     }
 
+    // the detached partitions as well, or new ones with their names would never be attached
+    auto r = PQexec(conn_, "SELECT tablename FROM pg_tables WHERE tablename ~ '^actions_p[0-9]+$';");
+    EVT_ASSERT(PQresultStatus(r) == PGRES_TUPLES_OK, chain::postgres_exec_exception, "List partitions failed, detail: ${s}", ("s",PQerrorMessage(conn_)));
+
+    auto parts = std::vector<std::string>();
+    for(auto i = 0; i < PQntuples(r); i++) {
+        parts.emplace_back(PQgetvalue(r, i, 0));
+    }
+    PQclear(r);
+
+    for(auto& p : parts) {
+        drop_table(p);
+    }
+    last_partition_ = -1;
+
+    drop_table("backfill_jobs");
+
     return PG_OK;
 }
 
@@ -542,12 +790,15 @@ pg::prepare_tables() {
         create_blocks_table,
         create_trxs_table,
         create_metas_table,
-        create_actions_table,
+        part_interval_ > 0 ? create_actions_partitioned_table : create_actions_table,
         create_domains_table,
         create_tokens_table,
         create_groups_table,
         create_fungibles_table,
-        create_ft_holders_table
+        create_ft_holders_table,
+        create_ft_balances_table,
+        create_address_activity_table,
+        create_domain_stats_table
     };
     for(auto stmt : stmts) {
         auto r = PQexec(conn_, stmt);
@@ -564,11 +815,18 @@ pg::prepare_stmts() {
     if(prepared_stmts_) {
         return PG_OK;
     }
-    for(auto it : internal::prepare_register::instance().stmts) {
-        auto r = PQprepare(conn_, it.first.c_str(), it.second.c_str(), 0, NULL);
-        EVT_ASSERT(PQresultStatus(r) == PGRES_COMMAND_OK, chain::postgres_exec_exception,
-            "Prepare sql failed, sql: ${s}, detail: ${d}", ("s",it.second)("d",PQerrorMessage(conn_)));
-        PQclear(r);
+
+    // prepared statements belong to their connection, the shards execute them as well
+    auto conns = std::vector<pg_conn*>{ conn_ };
+    conns.insert(conns.end(), shard_conns_.begin(), shard_conns_.end());
+
+    for(auto conn : conns) {
+        for(auto it : internal::prepare_register::instance().stmts) {
+            auto r = PQprepare(conn, it.first.c_str(), it.second.c_str(), 0, NULL);
+            EVT_ASSERT(PQresultStatus(r) == PGRES_COMMAND_OK, chain::postgres_exec_exception,
+                "Prepare sql failed, sql: ${s}, detail: ${d}", ("s",it.second)("d",PQerrorMessage(conn)));
+            PQclear(r);
+        }
     }
     prepared_stmts_ = 1;
     return PG_OK;
@@ -595,11 +853,18 @@ pg::check_version() {
 }
 
 int
-pg::check_last_sync_block() {
+pg::check_last_sync_block(int backfilled) {
     auto sync_block_id = std::string();
     if(!read_stat("last_sync_block_id", sync_block_id)) {
         EVT_THROW(chain::postgres_sync_exception, "Last sync block id doesn't exist in current database");
     }
+    // the backfilled blocks are ahead of the sync until it reaches them
+    if(backfilled > 0 && (sync_block_id.empty() || (int)chain::block_header::num_from_id(block_id_t(sync_block_id)) <= backfilled)) {
+        EVT_ASSERT(sync_block_id.empty() || exists_block(sync_block_id), chain::postgres_sync_exception,
+            "Sync block ${s} doesn't exist in current database", ("s",sync_block_id));
+        last_sync_block_id_ = sync_block_id;
+        return PG_OK;
+    }
     auto last_block_id = std::string();
     if(get_latest_block_id(last_block_id)) {
         EVT_ASSERT(sync_block_id == last_block_id, chain::postgres_sync_exception, "Sync block and latest block are not match, sync is ${s}, latest is ${l}", ("s",sync_block_id)("l",last_block_id));
@@ -615,21 +880,21 @@ pg::new_copy_context() {
 }
 
 int
-pg::block_copy_to(const std::string& table, const std::string& data) {
-    auto stmt = fmt::format("COPY {} FROM STDIN;", table);
+pg::block_copy_to(pg_conn* conn, const std::string& table, const std::string& data) {
+    auto stmt = fmt::format("COPY {} FROM STDIN WITH BINARY;", table);
 
-    auto r = PQexec(conn_, stmt.c_str());
-    EVT_ASSERT(PQresultStatus(r) == PGRES_COPY_IN, chain::postgres_exec_exception, "Not expected COPY response, detail: ${s}", ("s",PQerrorMessage(conn_)));
+    auto r = PQexec(conn, stmt.c_str());
+    EVT_ASSERT(PQresultStatus(r) == PGRES_COPY_IN, chain::postgres_exec_exception, "Not expected COPY response, detail: ${s}", ("s",PQerrorMessage(conn)));
     PQclear(r);
 
-    auto nr = PQputCopyData(conn_, data.data(), (int)data.size());
-    EVT_ASSERT(nr == 1, chain::postgres_exec_exception, "Put data into COPY stream failed, detail: ${s}", ("s",PQerrorMessage(conn_)));
+    auto nr = PQputCopyData(conn, data.data(), (int)data.size());
+    EVT_ASSERT(nr == 1, chain::postgres_exec_exception, "Put data into COPY stream failed, detail: ${s}", ("s",PQerrorMessage(conn)));
 
-    auto nr2 = PQputCopyEnd(conn_, NULL);
-    EVT_ASSERT(nr2 == 1, chain::postgres_exec_exception, "Close data into COPY stream failed, detail: ${s}", ("s",PQerrorMessage(conn_)));
+    auto nr2 = PQputCopyEnd(conn, NULL);
+    EVT_ASSERT(nr2 == 1, chain::postgres_exec_exception, "Close data into COPY stream failed, detail: ${s}", ("s",PQerrorMessage(conn)));
 
-    auto r2 = PQgetResult(conn_);
-    EVT_ASSERT(PQresultStatus(r2) == PGRES_COMMAND_OK, chain::postgres_exec_exception, "Execute COPY command failed, detail: ${s}", ("s",PQerrorMessage(conn_)));
+    auto r2 = PQgetResult(conn);
+    EVT_ASSERT(PQresultStatus(r2) == PGRES_COMMAND_OK, chain::postgres_exec_exception, "Execute COPY command failed, detail: ${s}", ("s",PQerrorMessage(conn)));
     PQclear(r2);
 
     return PG_OK;
@@ -637,15 +902,82 @@ pg::block_copy_to(const std::string& table, const std::string& data) {
 
 void
 pg::commit_copy_context(copy_context& cctx) {
-    if(cctx.blocks_copy_.size() > 0) {
-        block_copy_to("blocks", fmt::to_string(cctx.blocks_copy_));
+    using namespace internal;
+
+    if(!cctx.blocks_copy_.empty()) {
+        block_copy_to(conn_, blocks_copy_columns, cctx.blocks_copy_.finish());
+    }
+    if(!cctx.trxs_copy_.empty()) {
+        block_copy_to(conn_, trxs_copy_columns, cctx.trxs_copy_.finish());
+    }
+    if(!cctx.actions_copy_.empty()) {
+        block_copy_to(conn_, actions_copy_columns, cctx.actions_copy_.finish());
     }
-    if(cctx.trxs_copy_.size() > 0) {
-        block_copy_to("transactions", fmt::to_string(cctx.trxs_copy_));
+}
+
+int
+pg::create_backfill_jobs(int first_block, int last_block, int njobs) {
+    using namespace internal;
+    exec_stmts(conn_, create_backfill_jobs_table);
+
+    auto jobs = std::vector<backfill_job>();
+    read_backfill_jobs(jobs);
+    if(!jobs.empty()) {
+        return PG_OK;
     }
-    if(cctx.actions_copy_.size() > 0) {
-        block_copy_to("actions", fmt::to_string(cctx.actions_copy_));
+
+    auto total = last_block - first_block + 1;
+    auto size  = (total + njobs - 1) / njobs;
+
+    auto buf = fmt::memory_buffer();
+    fmt::format_to(buf, fmt("INSERT INTO backfill_jobs VALUES "));
+    for(auto i = 0, first = first_block; first <= last_block; i++, first += size) {
+        auto last = std::min(first + size - 1, last_block);
+        fmt::format_to(buf, fmt("{}({},{},{},{})"), i > 0 ? "," : "", i, first, last, first - 1);
     }
+    fmt::format_to(buf, fmt(";"));
+
+    exec_stmts(conn_, fmt::to_string(buf));
+    return PG_OK;
+}
+
+int
+pg::read_backfill_jobs(std::vector<backfill_job>& jobs) {
+    if(!exists_table("backfill_jobs")) {
+        return PG_FAIL;
+    }
+
+    auto r = PQexec(conn_, "SELECT id, first_block, last_block, done_block FROM backfill_jobs ORDER BY id;");
+    EVT_ASSERT(PQresultStatus(r) == PGRES_TUPLES_OK, chain::postgres_exec_exception, "Get backfill jobs failed, detail: ${s}", ("s",PQerrorMessage(conn_)));
+
+    for(auto i = 0; i < PQntuples(r); i++) {
+        auto job        = backfill_job();
+        job.id          = boost::lexical_cast<int>(PQgetvalue(r, i, 0));
+        job.first_block = boost::lexical_cast<int>(PQgetvalue(r, i, 1));
+        job.last_block  = boost::lexical_cast<int>(PQgetvalue(r, i, 2));
+        job.done_block  = boost::lexical_cast<int>(PQgetvalue(r, i, 3));
+        jobs.emplace_back(job);
+    }
+    PQclear(r);
+
+    return jobs.empty() ? PG_FAIL : PG_OK;
+}
+
+int
+pg::commit_backfill(copy_context& cctx, int job, int done_block) {
+    using namespace internal;
+
+    // a job resumes after its last commit, the rows and its progress are written together
+    exec_stmts(conn_, "BEGIN;");
+    if(!cctx.blocks_copy_.empty()) {
+        block_copy_to(conn_, blocks_copy_columns, cctx.blocks_copy_.finish());
+    }
+    if(!cctx.trxs_copy_.empty()) {
+        block_copy_to(conn_, trxs_copy_columns, cctx.trxs_copy_.finish());
+    }
+    exec_stmts(conn_, fmt::format(fmt("UPDATE backfill_jobs SET done_block = {} WHERE id = {}; COMMIT;"), done_block, job));
+
+    return PG_OK;
 }
 
 trx_context
@@ -653,84 +985,153 @@ pg::new_trx_context() {
     return trx_context(*this);
 }
 
+int
+pg::exec_stmts(pg_conn* conn, const std::string& stmts) {
+    auto r = PQexec(conn, stmts.c_str());
+    EVT_ASSERT(PQresultStatus(r) == PGRES_COMMAND_OK, chain::postgres_exec_exception, "Commit transactions failed, detail: ${s}", ("s",PQerrorMessage(conn)));
+
+    PQclear(r);
+    return PG_OK;
+}
+
 void
 pg::commit_trx_context(trx_context& tctx) {
-    if(tctx.trx_buf_.size() == 0) {
+    flush_token_owners(tctx);
+    flush_summaries(tctx);
+
+    // one connection: all the shards and the sync statements in one transaction
+    auto buf = fmt::memory_buffer();
+    for(auto& sbuf : tctx.shard_bufs_) {
+        buf.append(sbuf.data(), sbuf.data() + sbuf.size());
+    }
+    buf.append(tctx.trx_buf_.data(), tctx.trx_buf_.data() + tctx.trx_buf_.size());
+
+    if(buf.size() == 0) {
         return;
     }
+    exec_stmts(conn_, fmt::to_string(buf));
+}
 
-    auto stmts = fmt::to_string(tctx.trx_buf_);
+void
+pg::commit_contexts(copy_context& cctx, trx_context& tctx) {
+    using namespace internal;
 
-    auto r = PQexec(conn_, stmts.c_str());
-    auto s = PQresultStatus(r);
-    EVT_ASSERT(PQresultStatus(r) == PGRES_COMMAND_OK, chain::postgres_exec_exception, "Commit transactions failed, detail: ${s}", ("s",PQerrorMessage(conn_)));
+    if(shard_conns_.empty()) {
+        commit_copy_context(cctx);
+        commit_trx_context(tctx);
+        return;
+    }
+    flush_token_owners(tctx);
+    flush_summaries(tctx);
 
-    PQclear(r);
+    auto tasks = std::vector<std::future<int>>();
+
+    auto copy_to = [&](pg_conn* conn, const char* table, const binary_copy_buffer& buf) {
+        if(!buf.empty()) {
+            tasks.emplace_back(std::async(std::launch::async, [this, conn, table, data = buf.finish()] {
+                return block_copy_to(conn, table, data);
+            }));
+        }
+    };
+    copy_to(copy_conns_[0], blocks_copy_columns, cctx.blocks_copy_);
+    copy_to(copy_conns_[1], trxs_copy_columns, cctx.trxs_copy_);
+    copy_to(copy_conns_[2], actions_copy_columns, cctx.actions_copy_);
+
+    // each shard commits its statements in block order in its own transaction
+    for(auto i = 0u; i < shard_conns_.size(); i++) {
+        auto& sbuf = tctx.shard_bufs_[i];
+        if(sbuf.size() > 0) {
+            tasks.emplace_back(std::async(std::launch::async, [this, conn = shard_conns_[i], stmts = fmt::to_string(sbuf)] {
+                return exec_stmts(conn, stmts);
+            }));
+        }
+    }
+
+    // all of them are waited for before any failure is thrown, the connections are not left busy
+    auto except = std::exception_ptr();
+    for(auto& t : tasks) {
+        try {
+            t.get();
+        }
+        catch(...) {
+            if(!except) {
+                except = std::current_exception();
+            }
+        }
+    }
+    if(except) {
+        std::rethrow_exception(except);
+    }
+
+    // last sync block only moves on once everything of the batch is in, so a partly written one is found on restart
+    if(tctx.trx_buf_.size() > 0) {
+        exec_stmts(conn_, fmt::to_string(tctx.trx_buf_));
+    }
 }
 
 int
-pg::add_block(add_context& actx, const block_ptr block) {
-    fmt::format_to(actx.cctx.blocks_copy_,
-        fmt("{}\t{:d}\t{}\t{}\t{}\t{:d}\t{}\tt\tnow\n"),
-        actx.block_id,
-        actx.block_num,
-        block->header.previous.str(),
-        actx.ts,
-        block->header.transaction_mroot.str(),
-        block->block->transactions.size(),
-        (std::string)block->header.producer
-        );
+pg::add_block(add_context& actx, const block_t& block) {
+    auto& buf = actx.cctx.blocks_copy_;
+
+    buf.start_row(8);
+    buf.add_text(actx.block_id);
+    buf.add_int32(actx.block_num);
+    buf.add_text(block.previous.str());
+    buf.add_timestamp(actx.ts);
+    buf.add_text(block.transaction_mroot.str());
+    buf.add_int32((int32_t)block.transactions.size());
+    buf.add_text((std::string)block.producer);
+    buf.add_bool(actx.pending);
+
     return PG_OK;
 }
 
 int
 pg::add_trx(add_context& actx, const trx_recept_t& trx, const trx_t& strx, int seq_num, int elapsed, int charge) {
-    using namespace internal;
-
-    auto& cctx = actx.cctx;
-    fmt::format_to(cctx.trxs_copy_,
-        fmt("{}\t{:d}\t{}\t{}\t{:d}\t{}\t{}\t{:d}\t{}\tt\t{}\t{}\t"),
-        strx.id().str(),
-        seq_num,
-        actx.block_id,
-        actx.block_num,
-        (int32_t)strx.actions.size(),
-        actx.ts,
-        (std::string)strx.expiration,
-        (int32_t)strx.max_charge,
-        (std::string)strx.payer,
-        (std::string)trx.type,
-        (std::string)trx.status
-        );
+    auto& buf = actx.cctx.trxs_copy_;
+
+    buf.start_row(17);
+    buf.add_text(strx.id().str());
+    buf.add_int32(seq_num);
+    buf.add_text(actx.block_id);
+    buf.add_int32(actx.block_num);
+    buf.add_int32((int32_t)strx.actions.size());
+    buf.add_timestamp(actx.ts);
+    buf.add_timestamp(fc::time_point(strx.expiration));
+    buf.add_int32((int32_t)strx.max_charge);
+    buf.add_text((std::string)strx.payer);
+    buf.add_bool(actx.pending);
+    buf.add_text((std::string)trx.type);
+    buf.add_text((std::string)trx.status);
 
     // signatures
-    format_array_to(cctx.trxs_copy_, std::begin(strx.signatures), std::end(strx.signatures));
+    buf.add_bpchar_array(std::begin(strx.signatures), std::end(strx.signatures));
 
     // keys
     auto keys = strx.get_signature_keys(actx.chain_id);
-    format_array_to(cctx.trxs_copy_, std::begin(keys), std::end(keys));
+    buf.add_bpchar_array(std::begin(keys), std::end(keys));
+    if(actx.signing_keys) {
+        actx.signing_keys->insert(keys.begin(), keys.end());
+    }
 
     // traces
-    fmt::format_to(cctx.trxs_copy_, fmt("{}\t{}\t"), elapsed, charge);
+    buf.add_int32(elapsed);
+    buf.add_int32(charge);
 
     // extenscions
     auto has_ext = 0;
     for(auto& ext : strx.transaction_extensions) {
         if(std::get<0>(ext) == (uint16_t)chain::transaction_ext::suspend_name) {
-            auto& v    = std::get<1>(ext);
-            auto  name = std::string(v.cbegin(), v.cend());
+            auto& v = std::get<1>(ext);
 
-            fmt::format_to(cctx.trxs_copy_, fmt("{}\t"), name);
+            buf.add_text(std::string_view(v.data(), v.size()));
             has_ext = 1;
             break;
         }
     }
 
-    if(has_ext) {
-        fmt::format_to(cctx.trxs_copy_, fmt("now\n"));
-    }
-    else {
-        fmt::format_to(cctx.trxs_copy_, fmt("\\N\tnow\n"));
+    if(!has_ext) {
+        buf.add_null();
     }
 
     return PG_OK;
@@ -738,24 +1139,21 @@ pg::add_trx(add_context& actx, const trx_recept_t& trx, const trx_t& strx, int s
 
 int
 pg::add_action(add_context& actx, const act_trace_t& act_trace, const std::string& trx_id, int seq_num) {
-    using namespace internal;
-
     auto& act     = act_trace.act;
     auto  acttype = actx.exec_ctx.get_acttype_name(act.name);
     auto  data    = actx.abi.binary_to_variant(acttype, act.data, actx.exec_ctx);
-
-    fmt::format_to(actx.cctx.actions_copy_,
-        fmt("{}\t{:d}\t{}\t{:d}\t{:d}\t{}\t{}\t{}\t{}\tnow\n"),
-        actx.block_id,
-        actx.block_num,
-        trx_id,
-        seq_num,
-        act_trace.receipt.global_sequence,
-        act.name.to_string(),
-        act.domain.to_string(),
-        act.key.to_string(),
-        escape_string<true>(fc::json::to_string(data))
-        );
+    auto& buf     = actx.cctx.actions_copy_;
+
+    buf.start_row(9);
+    buf.add_text(actx.block_id);
+    buf.add_int32(actx.block_num);
+    buf.add_text(trx_id);
+    buf.add_int32(seq_num);
+    buf.add_int64((int64_t)act_trace.receipt.global_sequence);
+    buf.add_text(act.name.to_string());
+    buf.add_name128(act.domain);
+    buf.add_name128(act.key);
+    buf.add_jsonb(fc::json::to_string(data));
 
     return PG_OK;
 }
@@ -854,7 +1252,7 @@ pg::add_domain(trx_context& tctx, const newdomain& nd) {
     fc::to_variant(nd.transfer, transfer);
     fc::to_variant(nd.manage, manage);
 
-    fmt::format_to(tctx.trx_buf_,
+    fmt::format_to(tctx.shard_buf((std::string)nd.name),
         fmt("EXECUTE nd_plan('{}','{}','{}','{}','{}','{}');\n"),
         (std::string)nd.name,
         (std::string)nd.creator,
@@ -873,92 +1271,111 @@ PREPARE_SQL_ONCE(udm_plan, "UPDATE domains SET manage   = $1 WHERE name = $2;");
 
 int
 pg::upd_domain(trx_context& tctx, const updatedomain& ud) {
+    auto& buf = tctx.shard_buf((std::string)ud.name);
     if(ud.issue.has_value()) {
         fc::variant u;
         fc::to_variant(*ud.issue, u);
         auto i = fc::json::to_string(u);
 
-        fmt::format_to(tctx.trx_buf_, fmt("EXECUTE udi_plan('{}','{}');\n"), i, (std::string)ud.name);
+        fmt::format_to(buf, fmt("EXECUTE udi_plan('{}','{}');\n"), i, (std::string)ud.name);
     }
     if(ud.transfer.has_value()) {
         fc::variant u;
         fc::to_variant(*ud.transfer, u);
         auto t = fc::json::to_string(u);
 
-        fmt::format_to(tctx.trx_buf_, fmt("EXECUTE udt_plan('{}','{}');\n"), t, (std::string)ud.name);
+        fmt::format_to(buf, fmt("EXECUTE udt_plan('{}','{}');\n"), t, (std::string)ud.name);
     }
     if(ud.manage.has_value()) {
         fc::variant u;
         fc::to_variant(*ud.manage, u);
         auto m = fc::json::to_string(u);
 
-        fmt::format_to(tctx.trx_buf_, fmt("EXECUTE udm_plan('{}','{}');\n"), m, (std::string)ud.name);
+        fmt::format_to(buf, fmt("EXECUTE udm_plan('{}','{}');\n"), m, (std::string)ud.name);
     }
 
     return PG_OK;
 }
 
-PREPARE_SQL_ONCE(it_plan, "INSERT INTO tokens VALUES($1, $2, $3, $4, '{}', $5, now());");
+PREPARE_SQL_ONCE(itb_plan, "INSERT INTO tokens SELECT $1::varchar || ':' || n, $1::varchar, n, $2::character(53)[], '{}', $3::character(64), now() FROM unnest($4::varchar[]) AS n;");
 
 int
 pg::add_tokens(trx_context& tctx, const issuetoken& it) {
-    // cache owners
+    using namespace internal;
+
     auto owners_buf = fmt::memory_buffer();
-    fmt::format_to(owners_buf, fmt("{{"));
-    if(!it.owner.empty()) {
-        for(auto i = 0u; i < it.owner.size() - 1; i++) {
-            fmt::format_to(owners_buf, fmt("\"{}\","), (std::string)it.owner[i]);
-        }
-        fmt::format_to(owners_buf, fmt("\"{}\""), (std::string)it.owner[it.owner.size()-1]);
-    }
-    fmt::format_to(owners_buf, fmt("}}"));
+    format_array_to(owners_buf, std::begin(it.owner), std::end(it.owner));
+
+    auto names_buf = fmt::memory_buffer();
+    format_array_to(names_buf, std::begin(it.names), std::end(it.names));
 
-    auto owners = fmt::to_string(owners_buf);
+    // all the names in one statement, format_array_to ends both with a tab
     auto domain = (std::string)it.domain;
-    for(auto& name : it.names) {
-        fmt::format_to(tctx.trx_buf_,
-            fmt("EXECUTE it_plan('{0}:{1}','{0}','{1}','{2}','{3}');\n"),
-            domain,
-            (std::string)name,
-            owners,
-            tctx.trx_id()
-            );
-    }
+    fmt::format_to(tctx.shard_buf(domain),
+        fmt("EXECUTE itb_plan('{}','{}','{}','{}');\n"),
+        domain,
+        std::string_view(owners_buf.data(), owners_buf.size() - 1),
+        tctx.trx_id(),
+        std::string_view(names_buf.data(), names_buf.size() - 1)
+        );
     return PG_OK;
 }
 
-PREPARE_SQL_ONCE(tf_plan, "UPDATE tokens SET owner = $1 WHERE id = $2;");
+PREPARE_SQL_ONCE(uto_plan, "UPDATE tokens SET owner = u.owner::character(53)[] FROM unnest($1::varchar[], $2::text[]) AS u(id, owner) WHERE tokens.id = u.id;");
 
 int
 pg::upd_token(trx_context& tctx, const transfer& tf) {
-    using namespace internal;
+    auto domain = (std::string)tf.domain;
 
+    // each element is an array literal itself, so the owners are not quoted
     auto owners_buf = fmt::memory_buffer();
-    format_array_to(owners_buf, std::begin(tf.to), std::end(tf.to));
-
-    fmt::format_to(tctx.trx_buf_,
-        fmt("EXECUTE tf_plan('{2}','{0}:{1}');"),
-        (std::string)tf.domain,
-        (std::string)tf.name,
-        fmt::to_string(owners_buf)
-        );
+    fmt::format_to(owners_buf, fmt("{{"));
+    for(auto i = 0u; i < tf.to.size(); i++) {
+        if(i > 0) {
+            owners_buf.push_back(',');
+        }
+        fmt::format_to(owners_buf, fmt("{}"), (std::string)tf.to[i]);
+    }
+    fmt::format_to(owners_buf, fmt("}}"));
 
+    tctx.token_owners_[tctx.shard_of(domain)][fmt::format("{}:{}", domain, (std::string)tf.name)] = fmt::to_string(owners_buf);
     return PG_OK;
 }
 
-PREPARE_SQL_ONCE(dt_plan, "UPDATE tokens SET owner = '{\"EVT00000000000000000000000000000000000000000000000000\"}' WHERE id = $1;");
-
 int
 pg::del_token(trx_context& tctx, const destroytoken& dt) {
-    fmt::format_to(tctx.trx_buf_,
-        fmt("EXECUTE dt_plan('{0}:{1}');"),
-        (std::string)dt.domain,
-        (std::string)dt.name
-        );
+    auto domain = (std::string)dt.domain;
 
+    // the same as a transfer to the null address, so the last change in a batch wins
+    tctx.token_owners_[tctx.shard_of(domain)][fmt::format("{}:{}", domain, (std::string)dt.name)] = "{EVT00000000000000000000000000000000000000000000000000}";
     return PG_OK;
 }
 
+void
+pg::flush_token_owners(trx_context& tctx) {
+    for(auto i = 0u; i < tctx.token_owners_.size(); i++) {
+        auto& owners = tctx.token_owners_[i];
+        if(owners.empty()) {
+            continue;
+        }
+
+        auto ids_buf    = fmt::memory_buffer();
+        auto owners_buf = fmt::memory_buffer();
+        for(auto& it : owners) {
+            if(ids_buf.size() > 0) {
+                ids_buf.push_back(',');
+                owners_buf.push_back(',');
+            }
+            fmt::format_to(ids_buf, fmt("\"{}\""), it.first);
+            fmt::format_to(owners_buf, fmt("\"{}\""), it.second);
+        }
+
+        // after the inserts of the shard, which come in the order of the blocks
+        fmt::format_to(tctx.shard_bufs_[i], fmt("EXECUTE uto_plan('{{{}}}','{{{}}}');\n"), fmt::to_string(ids_buf), fmt::to_string(owners_buf));
+        owners.clear();
+    }
+}
+
 PREPARE_SQL_ONCE(ng_plan, "INSERT INTO groups VALUES($1, $2, $3, '{}', $4, now());");
 
 int
@@ -966,7 +1383,7 @@ pg::add_group(trx_context& tctx, const newgroup& ng) {
     fc::variant def;
     fc::to_variant(ng.group, def);
 
-    fmt::format_to(tctx.trx_buf_,
+    fmt::format_to(tctx.shard_buf((std::string)ng.name),
         fmt("EXECUTE ng_plan('{}','{}','{}','{}');\n"),
         (std::string)ng.name,
         (std::string)ng.group.key(),
@@ -984,7 +1401,7 @@ pg::upd_group(trx_context& tctx, const updategroup& ug) {
     fc::variant u;
     fc::to_variant(ug.group, u);
 
-    fmt::format_to(tctx.trx_buf_,
+    fmt::format_to(tctx.shard_buf((std::string)ug.name),
         fmt("EXECUTE ug_plan('{}','{}');"),
         fc::json::to_string(u["root"]),
         (std::string)ug.name
@@ -1002,7 +1419,7 @@ pg::add_fungible(trx_context& tctx, const fungible_def& ft) {
     fc::to_variant(ft.transfer, transfer);
     fc::to_variant(ft.manage, manage);
 
-    fmt::format_to(tctx.trx_buf_,
+    fmt::format_to(tctx.shard_buf(std::to_string((int64_t)ft.sym.id())),
         fmt("EXECUTE nf_plan('{}','{}','{}',{:d},'{}','{}','{}','{}','{}','{}');\n"),
         (std::string)ft.name,
         (std::string)ft.sym_name,
@@ -1038,40 +1455,42 @@ PREPARE_SQL_ONCE(ufm_plan, "UPDATE fungibles SET manage = $1 WHERE sym_id = $2;"
 
 int
 pg::upd_fungible(trx_context& tctx, const updfungible& uf) {
+    auto& buf = tctx.shard_buf(std::to_string((int64_t)uf.sym_id));
     if(uf.issue.has_value()) {
         fc::variant u;
         fc::to_variant(*uf.issue, u);
 
-        fmt::format_to(tctx.trx_buf_, fmt("EXECUTE ufi_plan('{}',{});\n"), fc::json::to_string(u), (int64_t)uf.sym_id);
+        fmt::format_to(buf, fmt("EXECUTE ufi_plan('{}',{});\n"), fc::json::to_string(u), (int64_t)uf.sym_id);
     }
     if(uf.manage.has_value()) {
         fc::variant u;
         fc::to_variant(*uf.manage, u);
 
-        fmt::format_to(tctx.trx_buf_, fmt("EXECUTE ufm_plan('{}',{});\n"), fc::json::to_string(u), (int64_t)uf.sym_id);
+        fmt::format_to(buf, fmt("EXECUTE ufm_plan('{}',{});\n"), fc::json::to_string(u), (int64_t)uf.sym_id);
     }
     return PG_OK;
 }
 
 int
 pg::upd_fungible(trx_context& tctx, const updfungible_v2& uf) {
+    auto& buf = tctx.shard_buf(std::to_string((int64_t)uf.sym_id));
     if(uf.issue.has_value()) {
         fc::variant u;
         fc::to_variant(*uf.issue, u);
 
-        fmt::format_to(tctx.trx_buf_, fmt("EXECUTE ufi_plan('{}',{});\n"), fc::json::to_string(u), (int64_t)uf.sym_id);
+        fmt::format_to(buf, fmt("EXECUTE ufi_plan('{}',{});\n"), fc::json::to_string(u), (int64_t)uf.sym_id);
     }
     if(uf.transfer.has_value()) {
         fc::variant u;
         fc::to_variant(*uf.transfer, u);
 
-        fmt::format_to(tctx.trx_buf_, fmt("EXECUTE uft_plan('{}',{});\n"), fc::json::to_string(u), (int64_t)uf.sym_id);
+        fmt::format_to(buf, fmt("EXECUTE uft_plan('{}',{});\n"), fc::json::to_string(u), (int64_t)uf.sym_id);
     }
     if(uf.manage.has_value()) {
         fc::variant u;
         fc::to_variant(*uf.manage, u);
 
-        fmt::format_to(tctx.trx_buf_, fmt("EXECUTE ufm_plan('{}',{});\n"), fc::json::to_string(u), (int64_t)uf.sym_id);
+        fmt::format_to(buf, fmt("EXECUTE ufm_plan('{}',{});\n"), fc::json::to_string(u), (int64_t)uf.sym_id);
     }
     return PG_OK;
 }
@@ -1089,22 +1508,34 @@ pg::add_meta(trx_context& tctx, const action_t& act) {
 
     auto& am = act.data_as<const addmeta&>();
 
-    fmt::format_to(tctx.trx_buf_, fmt("EXECUTE am_plan('{}','{}','{}','{}');\n"), (std::string)am.key, escape_string(am.value), am.creator.to_string(), tctx.trx_id());
+    // the meta goes to the shard of its owner: lastval() is per connection
+    auto add_meta_row = [&](fmt::memory_buffer& buf) {
+        fmt::format_to(buf, fmt("EXECUTE am_plan('{}','{}','{}','{}');\n"), (std::string)am.key, escape_string(am.value), am.creator.to_string(), tctx.trx_id());
+    };
     if(act.domain == N128(.fungible)) {
         // fungibles
-        fmt::format_to(tctx.trx_buf_, fmt("EXECUTE amf_plan(lastval(),{});\n"), boost::lexical_cast<int64_t>((std::string)act.key));   
+        auto  sym_id = boost::lexical_cast<int64_t>((std::string)act.key);
+        auto& buf    = tctx.shard_buf(std::to_string(sym_id));
+        add_meta_row(buf);
+        fmt::format_to(buf, fmt("EXECUTE amf_plan(lastval(),{});\n"), sym_id);
     }
     else if(act.domain == N128(.group)) {
         // groups
-        fmt::format_to(tctx.trx_buf_, fmt("EXECUTE amg_plan(lastval(),'{}');\n"), (std::string)act.key); 
+        auto& buf = tctx.shard_buf((std::string)act.key);
+        add_meta_row(buf);
+        fmt::format_to(buf, fmt("EXECUTE amg_plan(lastval(),'{}');\n"), (std::string)act.key); 
     }
     else if(act.key == N128(.meta)) {
         // domains
-        fmt::format_to(tctx.trx_buf_, fmt("EXECUTE amd_plan(lastval(),'{}');\n"), (std::string)act.domain); 
+        auto& buf = tctx.shard_buf((std::string)act.domain);
+        add_meta_row(buf);
+        fmt::format_to(buf, fmt("EXECUTE amd_plan(lastval(),'{}');\n"), (std::string)act.domain); 
     }
     else {
         // tokens
-        fmt::format_to(tctx.trx_buf_, fmt("EXECUTE amt_plan(lastval(),'{}:{}');\n"), (std::string)act.domain, (std::string)act.key); 
+        auto& buf = tctx.shard_buf((std::string)act.domain);
+        add_meta_row(buf);
+        fmt::format_to(buf, fmt("EXECUTE amt_plan(lastval(),'{}:{}');\n"), (std::string)act.domain, (std::string)act.key); 
     }
 
     return PG_OK;
@@ -1115,11 +1546,105 @@ PREPARE_SQL_ONCE(afh_plan, "INSERT INTO ft_holders VALUES($1, $2, now()) ON CONF
 int
 pg::add_ft_holders(trx_context& tctx, const ft_holders_t& holders) {
     for(auto& holder : holders) {
-        fmt::format_to(tctx.trx_buf_, fmt("EXECUTE afh_plan('{}','{{{}}}');"), holder.addr, (int64_t)holder.sym_id);
+        fmt::format_to(tctx.shard_buf((std::string)holder.addr), fmt("EXECUTE afh_plan('{}','{{{}}}');"), holder.addr, (int64_t)holder.sym_id);
     }
     return PG_OK;
 }
 
+int
+pg::upd_ft_balance(trx_context& tctx, const std::string& addr, int64_t sym_id, const std::string& balance, int block_num) {
+    tctx.ft_balances_[tctx.shard_of(addr)][std::make_pair(addr, sym_id)] = trx_context::ft_balance_row { balance, block_num };
+    return PG_OK;
+}
+
+int
+pg::upd_activity(trx_context& tctx, const std::string& addr, int block_num, const std::string& trx_id, const std::string& action, int count) {
+    auto& row = tctx.activities_[tctx.shard_of(addr)][addr];
+
+    row.block_num = block_num;
+    row.trx_id    = trx_id;
+    row.action    = action;
+    row.count    += count;
+    return PG_OK;
+}
+
+int
+pg::upd_token_count(trx_context& tctx, const std::string& domain, int64_t delta, int block_num) {
+    auto& row = tctx.token_counts_[tctx.shard_of(domain)][domain];
+
+    row.delta    += delta;
+    row.block_num = block_num;
+    return PG_OK;
+}
+
+PREPARE_SQL_ONCE(ufb_plan, R"sql(INSERT INTO ft_balances
+                                 SELECT a, s, b, n, now() FROM unnest($1::character(53)[], $2::bigint[], $3::varchar[], $4::integer[]) AS u(a, s, b, n)
+                                 ON CONFLICT (address, sym_id) DO UPDATE SET balance = excluded.balance, block_num = excluded.block_num, updated_at = now();
+                                 )sql");
+PREPARE_SQL_ONCE(uaa_plan, R"sql(INSERT INTO address_activity
+                                 SELECT a, n, t, c, k, now() FROM unnest($1::character(53)[], $2::integer[], $3::character(64)[], $4::varchar[], $5::bigint[]) AS u(a, n, t, c, k)
+                                 ON CONFLICT (address) DO UPDATE SET block_num = excluded.block_num, trx_id = excluded.trx_id, action = excluded.action,
+                                     action_count = address_activity.action_count + excluded.action_count, updated_at = now();
+                                 )sql");
+PREPARE_SQL_ONCE(uds_plan, R"sql(INSERT INTO domain_stats
+                                 SELECT d, c, n, now() FROM unnest($1::varchar[], $2::bigint[], $3::integer[]) AS u(d, c, n)
+                                 ON CONFLICT (domain) DO UPDATE SET token_count = domain_stats.token_count + excluded.token_count,
+                                     block_num = excluded.block_num, updated_at = now();
+                                 )sql");
+
+void
+pg::flush_summaries(trx_context& tctx) {
+    // one upsert of each table for every shard, the values are array literals of unnest
+    auto append = [](fmt::memory_buffer& buf, auto&& v) {
+        buf.push_back(buf.size() == 0 ? '{' : ',');
+        fmt::format_to(buf, fmt("\"{}\""), v);
+    };
+    auto finish = [](fmt::memory_buffer& buf) {
+        buf.push_back('}');
+        return std::string_view(buf.data(), buf.size());
+    };
+
+    for(auto i = 0u; i < tctx.shard_bufs_.size(); i++) {
+        auto& sbuf = tctx.shard_bufs_[i];
+
+        if(!tctx.ft_balances_[i].empty()) {
+            auto addrs = fmt::memory_buffer(), syms = fmt::memory_buffer(), balances = fmt::memory_buffer(), nums = fmt::memory_buffer();
+            for(auto& it : tctx.ft_balances_[i]) {
+                append(addrs, it.first.first);
+                append(syms, it.first.second);
+                append(balances, it.second.balance);
+                append(nums, it.second.block_num);
+            }
+            fmt::format_to(sbuf, fmt("EXECUTE ufb_plan('{}','{}','{}','{}');\n"), finish(addrs), finish(syms), finish(balances), finish(nums));
+            tctx.ft_balances_[i].clear();
+        }
+
+        if(!tctx.activities_[i].empty()) {
+            auto addrs = fmt::memory_buffer(), nums = fmt::memory_buffer(), trxs = fmt::memory_buffer(), acts = fmt::memory_buffer(), counts = fmt::memory_buffer();
+            for(auto& it : tctx.activities_[i]) {
+                append(addrs, it.first);
+                append(nums, it.second.block_num);
+                append(trxs, it.second.trx_id);
+                append(acts, it.second.action);
+                append(counts, it.second.count);
+            }
+            fmt::format_to(sbuf, fmt("EXECUTE uaa_plan('{}','{}','{}','{}','{}');\n"), finish(addrs), finish(nums), finish(trxs), finish(acts), finish(counts));
+            tctx.activities_[i].clear();
+        }
+
+        if(!tctx.token_counts_[i].empty()) {
+            auto domains = fmt::memory_buffer(), deltas = fmt::memory_buffer(), nums = fmt::memory_buffer();
+            for(auto& it : tctx.token_counts_[i]) {
+                append(domains, it.first);
+                append(deltas, it.second.delta);
+                append(nums, it.second.block_num);
+            }
+            fmt::format_to(sbuf, fmt("EXECUTE uds_plan('{}','{}','{}');\n"), finish(domains), finish(deltas), finish(nums));
+            tctx.token_counts_[i].clear();
+        }
+    }
+}
+
 int
 pg::backup(const std::shared_ptr<chain::snapshot_writer>& snapshot) const {
     using namespace internal;
@@ -1171,6 +1696,13 @@ pg::restore(const std::shared_ptr<chain::snapshot_reader>& snapshot) {
 
     for(auto t : tables) {
         dlog("Restoring ${t} table", ("t",t.name));
+        if(part_interval_ > 0 && t.name == "actions") {
+            // blocks are restored before, the partitions for all of their actions are created first
+            auto block_id = std::string();
+            if(get_latest_block_id(block_id)) {
+                ensure_partitions(chain::block_header::num_from_id(block_id_t(block_id)));
+            }
+        }
         snapshot->read_section(fmt::format("pg-{}", t.name), [this, &t](auto& reader) {
             auto stmt = fmt::format("COPY {} FROM STDIN WITH BINARY;", t.name);
 
@@ -0,0 +1,140 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+
+#include <stdint.h>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <boost/endian/conversion.hpp>
+#include <fmt/format.h>
+#include <fc/time.hpp>
+#include <evt/chain/name128.hpp>
+
+namespace evt {
+
+/**
+ * Rows of a `COPY ... FROM STDIN WITH BINARY` stream
+ *
+ * Values are written as the server stores them, so nothing is escaped on this side nor parsed on
+ * the server. The columns of each row are added in the order of the COPY column list.
+ */
+class binary_copy_buffer {
+public:
+    // oid of `character`, the element type of the array columns
+    static constexpr uint32_t bpchar_oid = 1042;
+
+public:
+    bool   empty() const { return rows_ == 0; }
+    size_t rows() const { return rows_; }
+
+    void
+    start_row(int16_t columns) {
+        if(rows_ == 0) {
+            // signature, flags and header extension length
+            buf_.append(signature, signature + sizeof(signature) - 1);
+            put(uint32_t(0));
+            put(uint32_t(0));
+        }
+        put(columns);
+        rows_++;
+    }
+
+    void add_null() { put(int32_t(-1)); }
+
+    void
+    add_text(std::string_view v) {
+        put((int32_t)v.size());
+        buf_.append(v.data(), v.data() + v.size());
+    }
+
+    // decodes the name straight into a stack buffer, no string is built in between
+    void
+    add_name128(const evt::chain::name128& v) {
+        char str[21];
+        add_text(std::string_view(str, v.to_string(str)));
+    }
+
+    void
+    add_int32(int32_t v) {
+        put(int32_t(4));
+        put(v);
+    }
+
+    void
+    add_int64(int64_t v) {
+        put(int32_t(8));
+        put(v);
+    }
+
+    void
+    add_bool(bool v) {
+        put(int32_t(1));
+        buf_.push_back(v ? 1 : 0);
+    }
+
+    // timestamp with time zone, microseconds since 2000-01-01
+    void
+    add_timestamp(const fc::time_point& tp) {
+        put(int32_t(8));
+        put(tp.time_since_epoch().count() - pg_epoch_us);
+    }
+
+    void
+    add_jsonb(std::string_view json) {
+        put((int32_t)json.size() + 1);
+        buf_.push_back(1);  // jsonb version
+        buf_.append(json.data(), json.data() + json.size());
+    }
+
+    // one dimension array of `character`, each element converted to a string
+    template <typename Iterator>
+    void
+    add_bpchar_array(Iterator begin, Iterator end) {
+        auto pos = buf_.size();
+        put(int32_t(0));  // length, written at the end
+
+        auto n = (int32_t)(end - begin);
+        put(int32_t(n > 0 ? 1 : 0));  // dimensions
+        put(int32_t(0));              // no nulls
+        put(bpchar_oid);
+        if(n > 0) {
+            put(n);
+            put(int32_t(1));  // lower bound
+            for(auto it = begin; it != end; it++) {
+                add_text((std::string)*it);
+            }
+        }
+
+        auto len = boost::endian::native_to_big((int32_t)(buf_.size() - pos - sizeof(int32_t)));
+        memcpy(buf_.data() + pos, &len, sizeof(len));
+    }
+
+    // the whole stream with its trailer
+    std::string
+    finish() const {
+        auto data    = fmt::to_string(buf_);
+        auto trailer = boost::endian::native_to_big(int16_t(-1));
+        data.append((const char*)&trailer, sizeof(trailer));
+        return data;
+    }
+
+private:
+    static constexpr char    signature[] = "PGCOPY\n\377\r\n\0";
+    static constexpr int64_t pg_epoch_us = 946'684'800'000'000ll;  // 2000-01-01 in unix time
+
+    template <typename T>
+    void
+    put(T v) {
+        v = boost::endian::native_to_big(v);
+        buf_.append((const char*)&v, (const char*)&v + sizeof(v));
+    }
+
+private:
+    fmt::memory_buffer buf_;
+    size_t             rows_ = 0;
+};
+
+}  // namespace evt
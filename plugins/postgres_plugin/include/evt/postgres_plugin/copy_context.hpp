@@ -6,7 +6,7 @@
 
 #include <string>
 #include <memory>
-#include <fmt/format.h>
+#include <evt/postgres_plugin/binary_copy_buffer.hpp>
 #include <evt/postgres_plugin/evt_pg.hpp>
 
 namespace evt {
@@ -21,10 +21,12 @@ public:
         db_.commit_copy_context(*this);
     }
 
+    size_t rows() const { return blocks_copy_.rows() + trxs_copy_.rows() + actions_copy_.rows(); }
+
 private:
-    fmt::memory_buffer blocks_copy_;
-    fmt::memory_buffer trxs_copy_;
-    fmt::memory_buffer actions_copy_;
+    binary_copy_buffer blocks_copy_;
+    binary_copy_buffer trxs_copy_;
+    binary_copy_buffer actions_copy_;
 
 private:
     pg& db_;
@@ -8,6 +8,7 @@
 #include <ostream>
 #include <string>
 #include <string_view>
+#include <vector>
 #include <boost/noncopyable.hpp>
 #include <evt/chain/block_state.hpp>
 #include <evt/chain/execution_context.hpp>
@@ -36,10 +37,12 @@ using act_trace_t  = chain::action_trace;
 using abi_t        = chain::contracts::abi_serializer;
 using exec_ctx_t   = chain::execution_context;
 using block_ptr    = chain::block_state_ptr;
+using block_t      = chain::signed_block;
 using block_id_t   = chain::block_id_type;
 using chain_id_t   = chain::chain_id_type;
 using trx_recept_t = chain::transaction_receipt;
 using trx_t        = chain::signed_transaction;
+using pub_keys_t   = chain::public_keys_set;
 using ft_holders_t = chain::small_vector_base<chain::ft_holder>;
 
 struct copy_context;
@@ -54,25 +57,47 @@ public:
     copy_context&     cctx;
     std::string_view  block_id;
     int               block_num;
-    std::string       ts;
+    fc::time_point    ts;
+    bool              pending = true;  // false when the block is written once irreversible
+    pub_keys_t*       signing_keys = nullptr;  // gathers the signing keys of the added transactions when set
     const chain_id_t& chain_id;
     const abi_t&      abi;
     const exec_ctx_t& exec_ctx;
 };
 
+// blocks `first_block` to `last_block` copied from the block log, up to `done_block` so far
+struct backfill_job {
+    int id;
+    int first_block;
+    int last_block;
+    int done_block;
+};
+
 class pg : boost::noncopyable {
 public:
     pg() : conn_(nullptr), prepared_stmts_(0) {}
 
 public:
     int connect(const std::string& conn);
+    // with n > 1 opens a connection for each COPY stream and n more for the shards of the state tables
+    int connect_writers(const std::string& conn, size_t n);
+    // commits of all the connections return before they are flushed to disk
+    int set_async_commit();
     int close();
 
+    size_t shards() const { return shard_conns_.empty() ? 1 : shard_conns_.size(); }
+
 public:
     int init_pathman();
     int create_partitions(const std::string& table, const std::string& relation, uint interval, uint part_nums);
     int drop_partitions(const std::string& table);
 
+    // native partitions of `actions` instead of pg_pathman, set before the tables are prepared
+    void set_native_partitions(uint interval, uint ahead, uint retain);
+    int is_partitioned_table(const std::string& table);
+    // creates the partitions up to `ahead` after the one of the block and detaches the ones older than `retain`
+    int ensure_partitions(int block_num);
+
 public:
     int create_db(const std::string& db);
     int drop_db(const std::string& db);
@@ -93,7 +118,8 @@ public:
 
 public:
     int check_version();
-    int check_last_sync_block();
+    // blocks up to `backfilled` may be ahead of the sync block
+    int check_last_sync_block(int backfilled = 0);
 
     void set_last_sync_block_id(const std::string& id) { last_sync_block_id_ = id; }
     std::string last_sync_block_id() const { return last_sync_block_id_; }
@@ -105,8 +131,18 @@ public:
     trx_context new_trx_context();
     void commit_trx_context(trx_context&);
 
+    // commits the copies and the shards in parallel over the writers if any, the sync statements last
+    void commit_contexts(copy_context&, trx_context&);
+
 public:
-    static int add_block(add_context&, const block_ptr);
+    // splits the blocks over `njobs` jobs, unless jobs were already created
+    int create_backfill_jobs(int first_block, int last_block, int njobs);
+    int read_backfill_jobs(std::vector<backfill_job>& jobs);
+    // commits the block and transaction copies of a job along with its progress
+    int commit_backfill(copy_context&, int job, int done_block);
+
+public:
+    static int add_block(add_context&, const block_t&);
     static int add_trx(add_context&, const trx_recept_t&, const trx_t&, int seq_num, int elapsed, int charge);
     static int add_action(add_context&, const act_trace_t&, const std::string& trx_id, int seq_num);
     
@@ -136,13 +172,29 @@ public:
 
     int add_ft_holders(trx_context&, const ft_holders_t&);
 
+    // summary tables, the last values of a batch are written once for each key
+    int upd_ft_balance(trx_context&, const std::string& addr, int64_t sym_id, const std::string& balance, int block_num);
+    int upd_activity(trx_context&, const std::string& addr, int block_num, const std::string& trx_id, const std::string& action, int count);
+    int upd_token_count(trx_context&, const std::string& domain, int64_t delta, int block_num);
+
 private:
-    int block_copy_to(const std::string& table, const std::string& data);
+    int block_copy_to(pg_conn* conn, const std::string& table, const std::string& data);
+    int exec_stmts(pg_conn* conn, const std::string& stmts);
+
+    void flush_token_owners(trx_context&);
+    void flush_summaries(trx_context&);
 
 private:
-    pg_conn*    conn_;
+    pg_conn*              conn_;
+    std::vector<pg_conn*> copy_conns_;   // blocks, transactions and actions
+    std::vector<pg_conn*> shard_conns_;
     std::string last_sync_block_id_;
     int         prepared_stmts_;
+
+    uint    part_interval_  = 0;  // 0 when not natively partitioned
+    uint    part_ahead_     = 0;
+    uint    part_retain_    = 0;
+    int64_t last_partition_ = -1;
 };
 
 }  // namespace evt
@@ -3,7 +3,11 @@
  *  @copyright defined in evt/LICENSE.txt
  */
 #pragma once
+#include <functional>
 #include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
 
 #include <appbase/application.hpp>
 #include <evt/chain_plugin/chain_plugin.hpp>
@@ -17,6 +21,35 @@ class snapshot_reader;
 
 using evt::chain::public_key_type;
 
+/**
+ * Tags of the history rows written for the blocks: the domain and the key of every action,
+ * the addresses in the actions of each fungible and the keys signing the transactions.
+ * Results read from those rows depend on the tags of their filters.
+ */
+namespace history_tag {
+
+inline std::string
+domain(std::string_view domain) {
+    return std::string("d:").append(domain);
+}
+
+inline std::string
+key(std::string_view domain, std::string_view key) {
+    return std::string("k:").append(domain).append(":").append(key);
+}
+
+inline std::string
+address(std::string_view sym_id, std::string_view addr) {
+    return std::string("a:").append(sym_id).append(":").append(addr);
+}
+
+inline std::string
+signing_key(std::string_view key) {
+    return std::string("p:").append(key);
+}
+
+}  // namespace history_tag
+
 class postgres_plugin : public plugin<postgres_plugin> {
 public:
     APPBASE_PLUGIN_REQUIRES((chain_plugin))
@@ -34,6 +67,14 @@ public:
     bool enabled() const;
     const std::string& connstr() const;
 
+public:
+    // tags of the rows written by a batch of blocks, unique and in no particular order
+    using commit_handler = std::function<void(std::vector<std::string>&&)>;
+
+    // called on the thread writing the blocks once each batch is committed, the tags are
+    // only gathered while a handler is set
+    void set_commit_handler(commit_handler&& handler);
+
 public:
     void read_from_snapshot(const std::shared_ptr<chain::snapshot_reader>& snapshot);
     void write_snapshot(const std::shared_ptr<chain::snapshot_writer>& snapshot) const;
@@ -4,8 +4,13 @@
  */
 #pragma once
 
+#include <functional>
+#include <string>
 #include <string_view>
+#include <map>
 #include <memory>
+#include <unordered_map>
+#include <vector>
 #include <fmt/format.h>
 #include <evt/postgres_plugin/evt_pg.hpp>
 
@@ -13,7 +18,13 @@ namespace evt {
 
 struct trx_context : boost::noncopyable {
 public:
-    trx_context(pg& pg) : db_(pg) {}
+    trx_context(pg& pg) : db_(pg) {
+        shard_bufs_.resize(pg.shards());
+        token_owners_.resize(pg.shards());
+        ft_balances_.resize(pg.shards());
+        activities_.resize(pg.shards());
+        token_counts_.resize(pg.shards());
+    }
 
 public:
     void
@@ -24,8 +35,38 @@ public:
     void set_trx_id(const std::string& trx_id) { trx_id_ = trx_id; }
     const std::string_view& trx_id() const { return trx_id_; }
 
+    // statements of one domain, group, fungible or holder always go to the same shard, in order
+    size_t shard_of(std::string_view key) const { return std::hash<std::string_view>()(key) % shard_bufs_.size(); }
+
+    fmt::memory_buffer& shard_buf(std::string_view key) { return shard_bufs_[shard_of(key)]; }
+
 private:
-    fmt::memory_buffer trx_buf_;
+    using token_owners_type = std::unordered_map<std::string, std::string>;  // token id to owners array literal
+
+    struct ft_balance_row {
+        std::string balance;
+        int         block_num;
+    };
+    struct activity_row {
+        int         block_num;
+        std::string trx_id;
+        std::string action;
+        int         count;
+    };
+    struct token_count_row {
+        int64_t delta;
+        int     block_num;
+    };
+    using ft_balances_type  = std::map<std::pair<std::string, int64_t>, ft_balance_row>;  // by address and sym id
+    using activities_type   = std::unordered_map<std::string, activity_row>;              // by address
+    using token_counts_type = std::unordered_map<std::string, token_count_row>;           // by domain
+
+    std::vector<fmt::memory_buffer> shard_bufs_;
+    std::vector<token_owners_type>  token_owners_;  // the last owners changed by shard, one update for each
+    std::vector<ft_balances_type>   ft_balances_;
+    std::vector<activities_type>    activities_;
+    std::vector<token_counts_type>  token_counts_;
+    fmt::memory_buffer              trx_buf_;       // stats and irreversible blocks, the sync marker
 
 private:
     pg&              db_;
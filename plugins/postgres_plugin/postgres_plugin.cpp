@@ -4,22 +4,19 @@
  */
 #include <evt/postgres_plugin/postgres_plugin.hpp>
 
+#include <algorithm>
 #include <functional>
+#include <future>
+#include <map>
 #include <queue>
 #include <optional>
+#include <set>
 #include <tuple>
 #include <thread>
 #include <mutex>
 
-#if __has_include(<condition>)
-#include <condition>
-using std::condition_variable_any;
-#else
-#include <boost/thread/condition.hpp>
-using boost::condition_variable_any;
-#endif
-
 #include <fc/io/json.hpp>
+#include <fc/log/trace.hpp>
 #include <fc/variant.hpp>
 #include <fc/time.hpp>
 #include <fmt/format.h>
@@ -38,7 +35,7 @@ using boost::condition_variable_any;
 #include <evt/chain/token_database_cache.hpp>
 #include <evt/chain/contracts/abi_serializer.hpp>
 #include <evt/chain/contracts/evt_contract_abi.hpp>
-#include <evt/utilities/spinlock.hpp>
+#include <evt/utilities/metrics.hpp>
 
 #include <evt/postgres_plugin/evt_pg.hpp>
 #include <evt/postgres_plugin/copy_context.hpp>
@@ -50,8 +47,6 @@ using namespace chain;
 using namespace chain::contracts;
 using namespace chain::plugin_interface;
 
-using evt::utilities::spinlock;
-using evt::utilities::spinlock_guard;
 
 static appbase::abstract_plugin& _postgres_plugin = app().register_plugin<postgres_plugin>();
 
@@ -59,6 +54,20 @@ class postgres_plugin_impl {
 private:
     using inblock_ptr = std::tuple<block_state_ptr, bool>; // true for irreversible block
 
+    // what a block changes in the summary tables, written once the block is irreversible
+    struct block_summary {
+        struct activity {
+            std::string trx_id;
+            std::string action;
+            int         count = 0;
+        };
+
+        uint32_t                                         block_num = 0;
+        std::set<std::pair<std::string, symbol_id_type>> balances;  // read from token db when written
+        std::map<std::string, activity>                  activities;
+        std::map<std::string, int64_t>                   token_counts;
+    };
+
 public:
     postgres_plugin_impl(const controller& control)
         : control_(control)
@@ -68,16 +77,19 @@ public:
 public:
     void consume_queues();
 
-    void applied_block(const block_state_ptr&);
-    void applied_irreversible_block(const block_state_ptr&);
-    void applied_transaction(const transaction_trace_ptr&);
-
     void process_block(const block_state_ptr, std::deque<transaction_trace_ptr>& traces, copy_context& cctx, trx_context& tctx);
     void _process_block(const block_state_ptr, std::deque<transaction_trace_ptr>& traces, copy_context& cctx, trx_context& tctx);
     void process_irreversible_block(const block_state_ptr, std::deque<transaction_trace_ptr>& traces, copy_context& cctx, trx_context& tctx);
     
     void process_action(const action&, trx_context& tctx);
 
+    void summarize_action(const action&, const std::string& trx_id, block_summary& summary);
+    void tag_action(const action&, const std::string& trx_id);
+    void write_summaries(const block_state_ptr, trx_context& tctx);
+
+    void backfill(int last_block, size_t njobs);
+    void backfill_job(const evt::backfill_job& job);
+
     void verify_last_block(const std::string& prev_block_id);
     void verify_no_blocks();
 
@@ -93,115 +105,149 @@ public:
 
     bool     configured_          = false;
     uint32_t last_sync_block_num_ = 0;
+    int      backfilled_          = 0;  // blocks up to it have their rows from the block log
     uint32_t part_limit_ = 0, part_num_ = 0;
 
     size_t processed_  = 0;
     size_t queue_size_ = 0;
+    size_t writers_    = 1;
 
-    std::deque<inblock_ptr>           block_state_queue_;
-    std::deque<transaction_trace_ptr> transaction_trace_queue_;
+    bool             native_partitions_ = false;
+    bool             irreversible_only_ = false;
+    size_t           batch_rows_        = 0;  // 0 commits each drained queue
+    fc::microseconds batch_interval_;
 
-    spinlock               lock_;
-    condition_variable_any cond_;
+    std::unordered_map<std::string, block_summary> summaries_;  // by block id, of the reversible blocks
 
-    bool                   consuming_ = false;
-    condition_variable_any ss_cond_;
+    block_trace_bus*             bus_      = nullptr;
+    block_trace_bus::consumer_id consumer_ = 0;
+
+    std::optional<utilities::metrics::collector_id> metrics_collector_;
+
+    std::mutex                      commit_mtx_;
+    postgres_plugin::commit_handler commit_handler_;
+    std::atomic_bool                tagging_ = false;
+    std::set<std::string>           tags_;  // of the batch being written, only while tagging
 
     std::thread      consume_thread_;
     std::atomic_bool done_ = false;
-
-    std::optional<boost::signals2::scoped_connection> accepted_block_connection_;
-    std::optional<boost::signals2::scoped_connection> irreversible_block_connection_;
-    std::optional<boost::signals2::scoped_connection> applied_transaction_connection_;
 };
 
-namespace internal {
-
-template <typename Q, typename V>
-inline void
-queueb(Q& bqueue, V&& v, spinlock& lock, condition_variable_any& cv, size_t queue_size) {
-    lock.lock();
-
-    auto sleep_time = 0ul;
-
-    while(bqueue.size() > queue_size) {
-        lock.unlock();
-        cv.notify_one();
-
-        sleep_time += 100;
-        std::this_thread::sleep_for(std::chrono::milliseconds(sleep_time));
+void
+postgres_plugin_impl::consume_queues() {
+    using namespace evt::internal;
 
-        lock.lock();
-    }
-    bqueue.emplace_back(std::forward<V>(v));
-    lock.unlock();
-    cv.notify_one();
-}
+    // a batch may be held over several drained queues until it has enough rows or is old enough
+    auto cctx        = std::optional<copy_context>();
+    auto tctx        = std::optional<trx_context>();
+    auto back        = block_state_ptr();
+    auto batch_start = fc::time_point();
 
-template <typename Q, typename V>
-inline void
-queuet(Q& tqueue, V&& v, spinlock& lock, condition_variable_any& cv) {
-    lock.lock();
-    tqueue.emplace_back(std::forward<V>(v));
-    lock.unlock();
-    cv.notify_one();
-}
+    auto commit_batch = [&] {
+        // every action of the batch needs its partition before the copy
+        db_.ensure_partitions(back->block_num);
 
-}  // namespace internal
+        // update last sync block in postgres
+        db_.upd_stat(*tctx, "last_sync_block_id", back->id.str());
 
-void
-postgres_plugin_impl::applied_irreversible_block(const block_state_ptr& bsp) {
-    evt::internal::queueb(block_state_queue_, std::make_tuple(bsp, true), lock_, cond_, queue_size_);
-}
+        db_.commit_contexts(*cctx, *tctx);
+        back.reset();
 
-void
-postgres_plugin_impl::applied_block(const block_state_ptr& bsp) {
-    evt::internal::queueb(block_state_queue_, std::make_tuple(bsp, false), lock_, cond_, queue_size_);
-}
-
-void
-postgres_plugin_impl::applied_transaction(const transaction_trace_ptr& ttp) {
-    if(!ttp->receipt.has_value() || (ttp->receipt->status != transaction_receipt_header::executed &&
-        ttp->receipt->status != transaction_receipt_header::soft_fail)) {
-        return;
-    }
-    evt::internal::queuet(transaction_trace_queue_, ttp, lock_, cond_);
-}
+        if(!tags_.empty()) {
+            auto handler = postgres_plugin::commit_handler();
+            {
+                std::lock_guard lock(commit_mtx_);
+                handler = commit_handler_;
+            }
+            if(handler) {
+                handler(std::vector<std::string>(tags_.begin(), tags_.end()));
+            }
+            tags_.clear();
+        }
+    };
 
-void
-postgres_plugin_impl::consume_queues() {
-    using namespace evt::internal;
+    // traces arrive before their block, the ones not matched yet are kept over the pops
+    auto traces = std::deque<transaction_trace_ptr>();
+    auto events = std::vector<block_trace_event>();
 
     try {
         while(true) {
-            lock_.lock();
-            while(block_state_queue_.empty() && !done_) {
-                consuming_ = false;
-                ss_cond_.notify_all();
-                cond_.wait(lock_);
+            // wait for blocks, or until the held batch is due
+            auto timeout = std::chrono::microseconds(std::chrono::seconds(1));
+            if(back) {
+                auto left = batch_start + batch_interval_ - fc::time_point::now();
+                if(left.count() <= 0) {
+                    commit_batch();
+                    bus_->ack(consumer_);
+                    continue;
+                }
+                timeout = std::chrono::microseconds(left.count());
             }
 
-            auto bqueue = std::move(block_state_queue_);
-            auto traces = std::move(transaction_trace_queue_);
+            events.clear();
+            if(bus_->pop(consumer_, events, queue_size_, timeout) == 0) {
+                if(done_) {
+                    break;
+                }
+                continue;
+            }
 
-            consuming_ = true;
-            lock_.unlock();
+            auto bqueue = std::deque<inblock_ptr>();
+            for(auto& e : events) {
+                switch(e.kind) {
+                case block_trace_event::accepted_block: {
+                    // speculative blocks are not written at all in irreversible only mode, their traces wait in the queue
+                    if(!irreversible_only_) {
+                        bqueue.emplace_back(e.block, false);
+                    }
+                    break;
+                }
+                case block_trace_event::irreversible_block: {
+                    bqueue.emplace_back(e.block, true);
+                    break;
+                }
+                case block_trace_event::applied_transaction: {
+                    auto& r = e.trace->receipt;
+                    if(r.has_value() && (r->status == transaction_receipt_header::executed
+                                         || r->status == transaction_receipt_header::soft_fail)) {
+                        traces.emplace_back(e.trace);
+                    }
+                    break;
+                }
+                default: {
+                    break;
+                }
+                }  // switch
+            }
+            if(bqueue.empty()) {
+                if(!back) {
+                    bus_->ack(consumer_);
+                }
+                continue;
+            }
 
             const int BlockPtr       = 0;
             const int IsIrreversible = 1;
 
-            // warn if queue size greater than 75%
-            if(bqueue.size() > (queue_size_ * 0.75)) {
-                wlog("queue size: ${q}, head block num: ${b}", ("q", fmt::format("{:n}",bqueue.size()))("b",fmt::format("{:n}",std::get<BlockPtr>(bqueue.front())->block_num)));
+            // warn if lagging more than 75% of the queue
+            auto stats = bus_->stats(consumer_);
+            if(stats.lag > (queue_size_ * 0.75)) {
+                wlog("queue size: ${q}, head block num: ${b}, producer stalls: ${s}", ("q", fmt::format("{:n}",stats.lag))
+                    ("b",fmt::format("{:n}",std::get<BlockPtr>(bqueue.front())->block_num))("s", fmt::format("{:n}",stats.stalls)));
             }
             else if(done_) {
-                ilog("draining queue, size: ${q}", ("q", fmt::format("{:n}",bqueue.size())));
+                ilog("draining queue, size: ${q}", ("q", fmt::format("{:n}",stats.lag)));
                 break;
             }
 
-            auto cctx = db_.new_copy_context();
-            auto tctx = db_.new_trx_context();
-            auto back = std::get<BlockPtr>(bqueue.back()); 
+            if(!back) {
+                cctx.emplace(db_);
+                tctx.emplace(db_);
+                batch_start = fc::time_point::now();
+            }
+            back = std::get<BlockPtr>(bqueue.back());
+
+            FC_TRACE_SPAN("postgres", "consume_blocks");
             // process block states
             while(true) {
                 if(bqueue.empty()) {
@@ -210,25 +256,24 @@ postgres_plugin_impl::consume_queues() {
 
                 auto& b = bqueue.front();
                 if(std::get<IsIrreversible>(b)) {
-                    process_irreversible_block(std::get<BlockPtr>(b), traces, cctx, tctx);
+                    process_irreversible_block(std::get<BlockPtr>(b), traces, *cctx, *tctx);
                 }
                 else {
-                    process_block(std::get<BlockPtr>(b), traces, cctx, tctx);
+                    process_block(std::get<BlockPtr>(b), traces, *cctx, *tctx);
                 }
 
                 bqueue.pop_front();
             }
-            // update last sync block in postgres
-            db_.upd_stat(tctx, "last_sync_block_id", back->id.str());
-
-            cctx.commit();
-            tctx.commit();
 
-            if(!traces.empty()) {
-                spinlock_guard lock(lock_);
-                transaction_trace_queue_.insert(transaction_trace_queue_.begin(), traces.begin(), traces.end());
+            if(batch_rows_ == 0 || cctx->rows() >= batch_rows_ || fc::time_point::now() >= batch_start + batch_interval_) {
+                FC_TRACE_SPAN("postgres", "commit_batch");
+                commit_batch();
+                bus_->ack(consumer_);
             }
         }
+        if(back) {
+            commit_batch();
+        }
         ilog("postgres_plugin consume thread shutdown gracefully");
     }
     catch(fc::exception& e) {
@@ -263,12 +308,15 @@ postgres_plugin_impl::verify_no_blocks() {
 void
 postgres_plugin_impl::process_irreversible_block(const block_state_ptr block, std::deque<transaction_trace_ptr>& traces, copy_context& cctx, trx_context& tctx) {
     try {
-        if(block->block_num == 1) {
+        if(block->block_num == 1 || irreversible_only_) {
             // genesis block will not trigger on_block event
             // add it manually
             _process_block(block, traces, cctx, tctx);
         }
-        db_.set_block_irreversible(tctx, block->id);
+        if(!irreversible_only_) {
+            db_.set_block_irreversible(tctx, block->id);
+        }
+        write_summaries(block, tctx);
     }
     catch(fc::exception& e) {
         elog("Exception while processing irreversible block ${e}", ("e", e.to_string()));
@@ -370,6 +418,149 @@ postgres_plugin_impl::process_action(const action& act, trx_context& tctx) {
     }; // switch
 }
 
+void
+postgres_plugin_impl::summarize_action(const action& act, const std::string& trx_id, block_summary& summary) {
+    auto touch = [&](const address& addr, symbol_id_type sym_id) {
+        auto str = (std::string)addr;
+        summary.balances.emplace(str, sym_id);
+
+        auto& a  = summary.activities[str];
+        a.trx_id = trx_id;
+        a.action = act.name.to_string();
+        a.count++;
+    };
+
+    switch((uint64_t)act.name) {
+    case N(issuefungible): {
+        auto& ift = act.data_as<const issuefungible&>();
+        touch(ift.address, ift.number.sym.id());
+        break;
+    }
+    case N(transferft): {
+        auto& tf = act.data_as<const transferft&>();
+        touch(tf.from, tf.number.sym.id());
+        touch(tf.to, tf.number.sym.id());
+        break;
+    }
+    case N(recycleft): {
+        auto& rf = act.data_as<const recycleft&>();
+        touch(rf.address, rf.number.sym.id());
+        break;
+    }
+    case N(destroyft): {
+        auto& df = act.data_as<const destroyft&>();
+        touch(df.address, df.number.sym.id());
+        break;
+    }
+    case N(evt2pevt): {
+        auto& ep = act.data_as<const evt2pevt&>();
+        touch(ep.from, evt_sym().id());
+        touch(ep.to, pevt_sym().id());
+        break;
+    }
+    case N(everipay): {
+        exec_ctx_.invoke_action<everipay>(act, [&](const auto& ep) {
+            touch(ep.payee, ep.number.sym.id());
+            for(auto& key : ep.link.restore_keys()) {
+                touch(address(key), ep.number.sym.id());
+            }
+        });
+        break;
+    }
+    case N(paybonus): {
+        auto& pb = act.data_as<const paybonus&>();
+        touch(pb.payer, pb.amount.sym.id());
+        break;
+    }
+    case N(paycharge): {
+        // charges are paid in PEVT first, then in EVT; not counted as an activity
+        auto& pc  = act.data_as<const paycharge&>();
+        auto  str = (std::string)pc.payer;
+        summary.balances.emplace(str, evt_sym().id());
+        summary.balances.emplace(str, pevt_sym().id());
+        break;
+    }
+    case N(issuetoken): {
+        auto& it = act.data_as<const issuetoken&>();
+        summary.token_counts[(std::string)it.domain] += (int64_t)it.names.size();
+        break;
+    }
+    case N(destroytoken): {
+        auto& dt = act.data_as<const destroytoken&>();
+        summary.token_counts[(std::string)dt.domain] -= 1;
+        break;
+    }
+    case N(everipass): {
+        exec_ctx_.invoke_action<everipass>(act, [&](const auto& ep) {
+            auto& link = ep.link;
+            if(link.get_header() & evt_link::destroy) {
+                summary.token_counts[*link.get_segment(evt_link::domain).strv] -= 1;
+            }
+        });
+        break;
+    }
+    }; // switch
+}
+
+void
+postgres_plugin_impl::tag_action(const action& act, const std::string& trx_id) {
+    auto domain = (std::string)act.domain;
+    auto key    = (std::string)act.key;
+    tags_.emplace(history_tag::domain(domain));
+    tags_.emplace(history_tag::key(domain, key));
+
+    if(act.domain != N128(.fungible)) {
+        return;
+    }
+    // the addresses are matched in any field of the actions of the fungible, the ones summarized cover them all
+    auto summary = block_summary();
+    summarize_action(act, trx_id, summary);
+    for(auto& b : summary.balances) {
+        tags_.emplace(history_tag::address(key, b.first));
+    }
+}
+
+void
+postgres_plugin_impl::write_summaries(const block_state_ptr block, trx_context& tctx) {
+    auto it = summaries_.find(block->id.str());
+    if(it != summaries_.end()) {
+        auto& s   = it->second;
+        auto  num = (int)s.block_num;
+
+        // the balances of the irreversible state, the pending one when those reads are disabled
+        auto& tokendb = control_.token_db();
+        auto  view    = tokendb.get_irreversible_view();
+        for(auto& b : s.balances) {
+            auto addr = address(b.first);
+            auto str  = std::string();
+            auto r    = view ? view->read_asset(addr, b.second, str, true) : tokendb.read_asset(addr, b.second, str, true);
+            if(!r) {
+                continue;
+            }
+
+            auto prop = property();
+            extract_db_value(str, prop);
+            db_.upd_ft_balance(tctx, b.first, b.second, asset(prop.amount, prop.sym).to_string(), num);
+        }
+        for(auto& a : s.activities) {
+            db_.upd_activity(tctx, a.first, num, a.second.trx_id, a.second.action, a.second.count);
+        }
+        for(auto& c : s.token_counts) {
+            db_.upd_token_count(tctx, c.first, c.second, num);
+        }
+    }
+
+    // the blocks of the abandoned forks never become irreversible
+    for(auto it = summaries_.begin(); it != summaries_.end();) {
+        if(it->second.block_num <= block->block_num) {
+            it = summaries_.erase(it);
+        }
+        else {
+            it++;
+        }
+    }
+}
+
 void
 postgres_plugin_impl::_process_block(const block_state_ptr block, std::deque<transaction_trace_ptr>& traces, copy_context& cctx, trx_context& tctx) {
     using namespace evt::internal;
@@ -381,7 +572,8 @@ postgres_plugin_impl::_process_block(const block_state_ptr block, std::deque<tra
         return;
     }
 
-    if(processed_ == 0) {
+    auto backfilled = (int)block->block_num <= backfilled_;
+    if(processed_ == 0 && !backfilled) {
         if(block->block_num <= 2) {
             // verify on start we have no previous blocks
             verify_no_blocks();
@@ -395,9 +587,21 @@ postgres_plugin_impl::_process_block(const block_state_ptr block, std::deque<tra
     auto actx      = add_context(cctx, control_.get_chain_id(), control_.get_abi_serializer(), control_.get_execution_context());
     actx.block_id  = id;
     actx.block_num = (int)block->block_num;
-    actx.ts        = (std::string)block->header.timestamp.to_time_point();
+    actx.ts        = block->header.timestamp.to_time_point();
+    actx.pending   = !irreversible_only_;
 
-    db_.add_block(actx, block);
+    if(!backfilled) {
+        db_.add_block(actx, *block->block);
+    }
+
+    auto& summary     = summaries_[id];
+    summary.block_num = block->block_num;
+
+    auto tagging = tagging_.load();
+    auto keys    = public_keys_set();
+    if(tagging) {
+        actx.signing_keys = &keys;
+    }
 
     // transactions
     auto trx_num = 0;
@@ -428,6 +632,10 @@ postgres_plugin_impl::_process_block(const block_state_ptr block, std::deque<tra
                     for(auto& act_trace : trace->action_traces) {
                         db_.add_action(actx, act_trace, str_trx_id, act_num);
                         process_action(act_trace.act, tctx);
+                        summarize_action(act_trace.act, str_trx_id, summary);
+                        if(tagging) {
+                            tag_action(act_trace.act, str_trx_id);
+                        }
                         if(!act_trace.new_ft_holders.empty()) {
                             db_.add_ft_holders(tctx, act_trace.new_ft_holders);
                         }
@@ -439,13 +647,89 @@ postgres_plugin_impl::_process_block(const block_state_ptr block, std::deque<tra
             }
         }
 
-        db_.add_trx(actx, trx, strx, trx_num, elapsed, charge);
+        if(!backfilled) {
+            db_.add_trx(actx, trx, strx, trx_num, elapsed, charge);
+        }
         ++trx_num;
     }
 
+    for(auto& key : keys) {
+        tags_.emplace(history_tag::signing_key((std::string)key));
+    }
+
     ++processed_;
 }
 
+void
+postgres_plugin_impl::backfill(int last_block, size_t njobs) {
+    if(last_block > 0) {
+        db_.create_backfill_jobs(1, last_block, (int)njobs);
+    }
+
+    auto jobs = std::vector<evt::backfill_job>();
+    if(!db_.read_backfill_jobs(jobs)) {
+        return;
+    }
+    if(last_block > 0 && jobs.back().last_block != last_block) {
+        wlog("Backfill up to block ${b} was started before, resuming it", ("b", jobs.back().last_block));
+    }
+    backfilled_ = jobs.back().last_block;
+
+    auto left = std::count_if(jobs.begin(), jobs.end(), [](auto& job) { return job.done_block < job.last_block; });
+    if(left == 0) {
+        return;
+    }
+    ilog("backfilling blocks and transactions up to block ${b} in ${n} jobs", ("b", backfilled_)("n", left));
+
+    auto futures = std::vector<std::future<void>>();
+    for(auto& job : jobs) {
+        if(job.done_block < job.last_block) {
+            futures.emplace_back(std::async(std::launch::async, [this, job] { backfill_job(job); }));
+        }
+    }
+    for(auto& f : futures) {
+        f.get();
+    }
+    ilog("backfill done");
+}
+
+void
+postgres_plugin_impl::backfill_job(const evt::backfill_job& job) {
+    // blocks of each commit, the most a failed job writes again when resumed
+    const int chunk_blocks = 1000;
+
+    auto db = pg();
+    db.connect(connstr_);
+
+    auto num = job.done_block + 1;
+    while(num <= job.last_block) {
+        auto cctx = db.new_copy_context();
+        auto end  = std::min(num + chunk_blocks - 1, job.last_block);
+
+        for(; num <= end; num++) {
+            auto block = control_.fetch_block_by_number(num);
+            EVT_ASSERT(block, postgres_plugin_exception, "Block ${n} is not in the block log, cannot backfill it", ("n", num));
+
+            auto id   = block->id().str();
+            auto actx = add_context(cctx, control_.get_chain_id(), control_.get_abi_serializer(), control_.get_execution_context());
+            actx.block_id  = id;
+            actx.block_num = num;
+            actx.ts        = block->timestamp.to_time_point();
+            actx.pending   = false;
+
+            db.add_block(actx, *block);
+
+            // no traces in the block log, elapsed and charge are left 0
+            auto trx_num = 0;
+            for(auto& trx : block->transactions) {
+                db.add_trx(actx, trx, trx.trx.get_signed_transaction(), trx_num++, 0, 0);
+            }
+        }
+        db.commit_backfill(cctx, job.id, end);
+    }
+    db.close();
+}
+
 void
 postgres_plugin_impl::wipe_database() {
     ilog("wipe database");
@@ -459,28 +743,33 @@ postgres_plugin_impl::init(bool init_db) {
         try {
             db_.prepare_stmts();
             db_.check_version();
-            db_.check_last_sync_block();
 
-            last_sync_block_num_ = block_header::num_from_id(block_id_type(db_.last_sync_block_id()));
+            auto jobs = std::vector<evt::backfill_job>();
+            if(db_.read_backfill_jobs(jobs)) {
+                backfilled_ = jobs.back().last_block;
+            }
+            db_.check_last_sync_block(backfilled_);
+
+            EVT_ASSERT((bool)db_.is_partitioned_table("actions") == native_partitions_, postgres_plugin_exception,
+                "postgres-native-partitions should be the same as when the database was created");
+
+            if(!db_.last_sync_block_id().empty()) {
+                last_sync_block_num_ = block_header::num_from_id(block_id_type(db_.last_sync_block_id()));
+            }
         }
         EVT_RETHROW_EXCEPTIONS(evt::postgres_plugin_exception,
             "Check integrity of postgres database failed, please use --clear-postgres to clear database");
     }
 
-    auto& chain_plug = app().get_plugin<chain_plugin>();
-    auto& chain      = chain_plug.chain();
-
-    accepted_block_connection_.emplace(chain.accepted_block.connect([&](const chain::block_state_ptr& bs) {
-        applied_block(bs);
-    }));
-
-    irreversible_block_connection_.emplace(chain.irreversible_block.connect([&](const chain::block_state_ptr& bs) {
-        applied_irreversible_block(bs);
-    }));
+    bus_      = &app().get_plugin<chain_plugin>().get_block_trace_bus();
+    consumer_ = bus_->subscribe(queue_size_);
 
-    applied_transaction_connection_.emplace(chain.applied_transaction.connect([&](const chain::transaction_trace_ptr& t) {
-        applied_transaction(t);
-    }));
+    metrics_collector_ = utilities::metrics::registry::get().add_collector([this](auto& w) {
+        auto stats = bus_->stats(consumer_);
+        w.gauge("evt_consumer_lag", "Events published to the consumer and not handled yet", stats.lag, {{"consumer", "postgres"}});
+        w.gauge("evt_consumer_queue_size", "Events the consumer may fall behind before the chain waits for it", queue_size_, {{"consumer", "postgres"}});
+        w.counter("evt_consumer_stalls_total", "Times the chain waited for the consumer", stats.stalls, {{"consumer", "postgres"}});
+    });
 
     if(init_db) {
         db_.init_pathman();
@@ -492,7 +781,9 @@ postgres_plugin_impl::init(bool init_db) {
         if(part_limit_ != 0) {
             db_.create_partitions("public.blocks", "block_num", part_limit_, part_num_);
             db_.create_partitions("public.transactions", "block_num", part_limit_, part_num_);
-            db_.create_partitions("public.actions", "block_num", part_limit_, part_num_);
+            if(!native_partitions_) {
+                db_.create_partitions("public.actions", "block_num", part_limit_, part_num_);
+            }
         }
 
         // HACK: Add EVT and PEVT manually
@@ -516,8 +807,12 @@ postgres_plugin_impl::~postgres_plugin_impl() {
         return;
     }
     try {
+        if(metrics_collector_.has_value()) {
+            utilities::metrics::registry::get().remove_collector(*metrics_collector_);
+        }
+
         done_ = true;
-        cond_.notify_one();
+        bus_->unsubscribe(consumer_);
 
         consume_thread_.join();
         db_.close();
@@ -541,6 +836,13 @@ postgres_plugin::connstr() const {
     return my_->connstr_;
 }
 
+void
+postgres_plugin::set_commit_handler(commit_handler&& handler) {
+    std::lock_guard lock(my_->commit_mtx_);
+    my_->tagging_        = (bool)handler;
+    my_->commit_handler_ = std::move(handler);
+}
+
 void
 postgres_plugin::read_from_snapshot(const std::shared_ptr<chain::snapshot_reader>& snapshot) {
     my_->db_.restore(snapshot);
@@ -548,11 +850,8 @@ postgres_plugin::read_from_snapshot(const std::shared_ptr<chain::snapshot_reader
 
 void
 postgres_plugin::write_snapshot(const std::shared_ptr<chain::snapshot_writer>& snapshot) const {
-    my_->lock_.lock();
-    while(my_->consuming_ || !my_->block_state_queue_.empty()) {
-        my_->ss_cond_.wait(my_->lock_);
-    }
-    my_->lock_.unlock();
+    // everything before the snapshot block is committed
+    my_->bus_->wait_idle(my_->consumer_);
 
     my_->db_.backup(snapshot);
 }
@@ -566,6 +865,22 @@ postgres_plugin::set_program_options(options_description& cli, options_descripti
         ("clear-postgres", bpo::bool_switch()->default_value(false), "clear postgres database, use --delete-all-blocks option will force set this option")
         ("postgres-partition-limit", bpo::value<uint>()->default_value(30000000), "The partition limit")
         ("postgres-partition-num", bpo::value<uint>()->default_value(10), "The number of partitions")
+        ("postgres-native-partitions", bpo::bool_switch()->default_value(false),
+            "Partition actions with declarative partitions of postgres-partition-limit blocks, created ahead while writing, instead of pg_pathman")
+        ("postgres-partitions-ahead", bpo::value<uint>()->default_value(2), "The number of native partitions created ahead of the one being written")
+        ("postgres-partitions-retain", bpo::value<uint>()->default_value(0),
+            "Detach the native partitions older than this many, to be archived; 0 to keep all of them")
+        ("postgres-writers", bpo::value<uint>()->default_value(1),
+            "Number of connections writing domains, tokens, groups, fungibles and holders in parallel, sharded by key. When more than one, blocks, transactions and actions are also copied over three more connections")
+        ("postgres-irreversible-only", bpo::bool_switch()->default_value(false),
+            "Write blocks only once they are irreversible, for replicas which never need the speculative ones. Commits are also made asynchronous")
+        ("postgres-batch-rows", bpo::value<uint>()->default_value(0),
+            "Hold the blocks in one COPY and one commit until they have this many block, transaction and action rows, 0 to commit each drained queue")
+        ("postgres-batch-interval-ms", bpo::value<uint>()->default_value(1000), "The longest a held batch waits before it is committed")
+        ("postgres-backfill-to", bpo::value<uint>()->default_value(0),
+            "Copy the blocks and transactions up to this block from the block log before syncing, in parallel jobs which resume where they stopped. "
+            "The sync then only writes actions and states for them")
+        ("postgres-backfill-jobs", bpo::value<uint>()->default_value(4), "The number of parallel backfill jobs, each with its own connection")
         ;
 }
 
@@ -602,16 +917,38 @@ postgres_plugin::plugin_initialize(const variables_map& options) {
             my_->part_num_ = options.at("postgres-partition-num").as<uint>();
         }
 
+        my_->native_partitions_ = options.at("postgres-native-partitions").as<bool>();
+        EVT_ASSERT(!my_->native_partitions_ || my_->part_limit_ > 0, plugin_config_exception,
+            "postgres-native-partitions needs a postgres-partition-limit");
+
         if(options.count("postgres-queue-size")) {
             my_->queue_size_ = options.at("postgres-queue-size").as<uint>();
         }
 
+        my_->writers_ = options.at("postgres-writers").as<uint>();
+        EVT_ASSERT(my_->writers_ > 0, plugin_config_exception, "postgres-writers should be at least 1");
+
+        my_->irreversible_only_ = options.at("postgres-irreversible-only").as<bool>();
+        my_->batch_rows_        = options.at("postgres-batch-rows").as<uint>();
+        my_->batch_interval_    = fc::milliseconds(options.at("postgres-batch-interval-ms").as<uint>());
+
         auto uri = options.at("postgres-uri").as<std::string>();
         ilog("connecting to ${u}", ("u", uri));
         
         my_->db_.connect(uri);
+        my_->db_.connect_writers(uri, my_->writers_);
         my_->connstr_ = uri;
 
+        if(my_->native_partitions_) {
+            my_->db_.set_native_partitions(my_->part_limit_, options.at("postgres-partitions-ahead").as<uint>(),
+                options.at("postgres-partitions-retain").as<uint>());
+        }
+
+        if(my_->irreversible_only_) {
+            ilog("postgres_plugin writes irreversible blocks only");
+            my_->db_.set_async_commit();
+        }
+
         if(!my_->db_.exists_table("blocks") || delete_state) {
             my_->wipe_database();
         }
@@ -640,6 +977,11 @@ postgres_plugin::plugin_initialize(const variables_map& options) {
 
         my_->init(delete_state);
 
+        // before the chain starts, nothing is appended to the block log meanwhile
+        auto backfill_jobs = options.at("postgres-backfill-jobs").as<uint>();
+        EVT_ASSERT(backfill_jobs > 0, plugin_config_exception, "postgres-backfill-jobs should be at least 1");
+        my_->backfill(options.at("postgres-backfill-to").as<uint>(), backfill_jobs);
+
         my_->consume_thread_ = std::thread([this] { my_->consume_queues(); });
     }
     else {
@@ -653,9 +995,6 @@ postgres_plugin::plugin_startup() {}
 
 void
 postgres_plugin::plugin_shutdown() {
-    my_->accepted_block_connection_.reset();
-    my_->irreversible_block_connection_.reset();
-    my_->applied_transaction_connection_.reset();
     my_.reset();
 }
 
@@ -10,6 +10,8 @@
 
 #include <chrono>
 
+#include <fmt/format.h>
+
 namespace evt { namespace detail {
 
 struct producer_api_plugin_response {
@@ -42,6 +44,54 @@ using namespace evt;
             }                                                                       \
     }
 
+namespace __internal {
+
+// producer stats in the Prometheus text format
+std::string
+format_metrics(const producer_plugin::production_stats& stats) {
+    auto buf = fmt::memory_buffer();
+
+    fmt::format_to(buf, "# HELP evt_producer_stage_latency_seconds Latency of each stage in building a block\n");
+    fmt::format_to(buf, "# TYPE evt_producer_stage_latency_seconds histogram\n");
+    for(auto& s : stats.stages) {
+        auto under = uint64_t(0);
+        for(auto i = 0u; i < s.latency_us.size() - 1; i++) {
+            under += s.latency_us[i];
+            fmt::format_to(buf, "evt_producer_stage_latency_seconds_bucket{{stage=\"{}\",le=\"{}\"}} {}\n",
+                           s.stage, (double)(16ull << i) / 1'000'000, under);
+        }
+        fmt::format_to(buf, "evt_producer_stage_latency_seconds_bucket{{stage=\"{}\",le=\"+Inf\"}} {}\n", s.stage, s.count);
+        fmt::format_to(buf, "evt_producer_stage_latency_seconds_sum{{stage=\"{}\"}} {}\n", s.stage, (double)s.sum_us / 1'000'000);
+        fmt::format_to(buf, "evt_producer_stage_latency_seconds_count{{stage=\"{}\"}} {}\n", s.stage, s.count);
+    }
+
+    fmt::format_to(buf, "# HELP evt_producer_produced_blocks_total Blocks produced by this node\n");
+    fmt::format_to(buf, "# TYPE evt_producer_produced_blocks_total counter\n");
+    fmt::format_to(buf, "evt_producer_produced_blocks_total {}\n", stats.produced_blocks);
+
+    auto counts = [&](auto name, auto help, auto type, auto& c) {
+        fmt::format_to(buf, "# HELP {} {}\n", name, help);
+        fmt::format_to(buf, "# TYPE {} {}\n", name, type);
+        fmt::format_to(buf, "{}{{result=\"applied\"}} {}\n", name, c.applied);
+        fmt::format_to(buf, "{}{{result=\"failed\"}} {}\n", name, c.failed);
+        fmt::format_to(buf, "{}{{result=\"deferred\"}} {}\n", name, c.deferred);
+    };
+    counts("evt_producer_transactions_total", "Transactions in produced blocks by result", "counter", stats.total);
+    counts("evt_producer_last_block_transactions", "Transactions in the last produced block by result", "gauge", stats.last_block);
+
+    fmt::format_to(buf, "# HELP evt_producer_incoming_transactions_total Incoming transactions by whether they were taken or refused as a copy of one in flight\n");
+    fmt::format_to(buf, "# TYPE evt_producer_incoming_transactions_total counter\n");
+    fmt::format_to(buf, "evt_producer_incoming_transactions_total{{result=\"accepted\"}} {}\n", stats.accepted_transactions);
+    fmt::format_to(buf, "evt_producer_incoming_transactions_total{{result=\"duplicate\"}} {}\n", stats.duplicate_transactions);
+    fmt::format_to(buf, "# HELP evt_producer_inflight_transactions Incoming transactions not answered yet\n");
+    fmt::format_to(buf, "# TYPE evt_producer_inflight_transactions gauge\n");
+    fmt::format_to(buf, "evt_producer_inflight_transactions {}\n", stats.inflight_transactions);
+
+    return fmt::to_string(buf);
+}
+
+}  // namespace __internal
+
 #define INVOKE_R_R(api_handle, call_name, in_param) \
     auto result = api_handle.call_name(fc::json::from_string(body).as<in_param>());
 
@@ -85,7 +135,22 @@ producer_api_plugin::plugin_startup() {
         CALL(producer, producer, get_integrity_hash,
              INVOKE_R_V(producer, get_integrity_hash), 201),
         CALL(producer, producer, create_snapshot,
-             INVOKE_R_R(producer, create_snapshot, producer_plugin::create_snapshot_options), 201)},
+             INVOKE_R_R(producer, create_snapshot, producer_plugin::create_snapshot_options), 201),
+        CALL(producer, producer, get_production_stats,
+             INVOKE_R_V(producer, get_production_stats), 201),
+        CALL(producer, producer, start_tracing,
+             INVOKE_V_R(producer, start_tracing, producer_plugin::start_tracing_options), 201),
+        CALL(producer, producer, stop_tracing,
+             INVOKE_R_V(producer, stop_tracing), 201),
+        {std::string("/v1/producer/metrics"),
+            [&producer](string, string body, url_response_callback cb) {
+                try {
+                    cb(200, __internal::format_metrics(producer.get_production_stats()));
+                }
+                catch(...) {
+                    http_plugin::handle_exception("producer", "metrics", body, cb);
+                }
+            }}},
         true /* local only API */);
 }
 
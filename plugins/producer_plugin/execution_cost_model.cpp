@@ -0,0 +1,54 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#include <evt/producer_plugin/execution_cost_model.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace evt {
+
+namespace __internal {
+
+// weight of a new sample, about the last 16 samples of an action matter
+constexpr double sample_weight = 1.0 / 16;
+
+}  // namespace __internal
+
+using namespace __internal;
+
+void
+execution_cost_model::estimate::update(double us) {
+    if(samples++ == 0) {
+        mean_us = us;
+        dev_us  = 0;
+        return;
+    }
+    dev_us  += (std::abs(us - mean_us) - dev_us) * sample_weight;
+    mean_us += (us - mean_us) * sample_weight;
+}
+
+void
+execution_cost_model::observe(const chain::transaction_trace& trace) {
+    auto actions_us = int64_t(0);
+    for(auto& at : trace.action_traces) {
+        auto us = std::max<int64_t>(at.elapsed.count(), 0);
+        actions_[at.act.name].update(us);
+        any_action_.update(us);
+        actions_us += us;
+    }
+    overhead_.update(std::max<int64_t>(trace.elapsed.count() - actions_us, 0));
+}
+
+fc::microseconds
+execution_cost_model::predict(const chain::transaction& trx) const {
+    auto us = overhead_.upper();
+    for(auto& act : trx.actions) {
+        auto it = actions_.find(act.name);
+        us += (it != actions_.end()) ? it->second.upper() : any_action_.upper();
+    }
+    return fc::microseconds((int64_t)us);
+}
+
+}  // namespace evt
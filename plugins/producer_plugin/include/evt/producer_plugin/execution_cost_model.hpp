@@ -0,0 +1,43 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+
+#include <unordered_map>
+
+#include <evt/chain/trace.hpp>
+#include <evt/chain/transaction.hpp>
+
+namespace evt {
+
+/**
+ * Online estimate of how long a transaction takes to apply
+ *
+ * Every applied transaction updates a moving mean and deviation of the time taken by each
+ * action name, and of what the transaction took beyond its actions. A prediction is the sum
+ * over the actions of mean plus twice the deviation, actions never seen count as the average
+ * of all the actions.
+ */
+class execution_cost_model {
+public:
+    void             observe(const chain::transaction_trace& trace);
+    fc::microseconds predict(const chain::transaction& trx) const;
+
+private:
+    struct estimate {
+        double   mean_us = 0;
+        double   dev_us  = 0;
+        uint64_t samples = 0;
+
+        void   update(double us);
+        double upper() const { return mean_us + 2 * dev_us; }
+    };
+
+private:
+    std::unordered_map<chain::action_name, estimate> actions_;
+    estimate                                         any_action_;
+    estimate                                         overhead_;
+};
+
+}  // namespace evt
@@ -0,0 +1,55 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <fc/time.hpp>
+
+namespace evt {
+
+/**
+ * Lock-free histogram of latencies in microseconds, may be recorded from any thread.
+ *
+ * Like HdrHistogram each power of two range is split into `sub_buckets` linear buckets,
+ * so any value is kept with a precision of 1/16 up to 2^30 us, larger ones count as 2^30 us.
+ * Readers see a consistent enough view for reporting, but not a snapshot.
+ */
+class latency_histogram {
+public:
+    static constexpr size_t sub_bucket_bits = 4;
+    static constexpr size_t sub_buckets     = 1 << sub_bucket_bits;
+    static constexpr size_t max_magnitude   = 30;
+    static constexpr size_t bucket_count    = (max_magnitude - sub_bucket_bits + 2) * sub_buckets;
+
+public:
+    void record(fc::microseconds elapsed);
+
+    uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+    uint64_t sum() const { return sum_.load(std::memory_order_relaxed); }
+    uint64_t max() const { return max_.load(std::memory_order_relaxed); }
+
+    // highest value in the bucket holding the q-th quantile, q in [0, 1]
+    uint64_t percentile(double q) const;
+
+    // count of values under 2^i us for each i in [first, last], the last element is the rest
+    std::vector<uint64_t> power_buckets(size_t first, size_t last) const;
+
+private:
+    static size_t   bucket_of(uint64_t us);
+    static uint64_t lowest_of(size_t bucket);
+
+private:
+    std::array<std::atomic<uint64_t>, bucket_count> buckets_{};
+    std::atomic<uint64_t>                           count_{0};
+    std::atomic<uint64_t>                           sum_{0};
+    std::atomic<uint64_t>                           max_{0};
+};
+
+}  // namespace evt
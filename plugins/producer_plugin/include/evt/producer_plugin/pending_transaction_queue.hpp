@@ -0,0 +1,97 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/multi_index/composite_key.hpp>
+#include <boost/multi_index/member.hpp>
+#include <boost/multi_index/ordered_index.hpp>
+#include <boost/multi_index_container.hpp>
+
+#include <evt/chain/plugin_interface.hpp>
+#include <evt/chain/trace.hpp>
+#include <evt/chain/transaction_metadata.hpp>
+
+namespace evt {
+
+/**
+ * Incoming transactions waiting to be applied to a pending block
+ *
+ * In fifo order they are taken as they came. In charge order the one paying the most per byte goes
+ * first, and each `age_boost` spent waiting counts as one more charge per KB so cheap ones still get in.
+ * With a `payer_cap` no more than that many transactions of one payer are taken in a round, the others
+ * wait for the next round.
+ */
+class pending_transaction_queue {
+public:
+    enum class order_type { fifo, charge };
+
+    struct config_type {
+        order_type       order     = order_type::fifo;
+        fc::microseconds age_boost = fc::seconds(1);
+        uint32_t         payer_cap = 0;
+    };
+
+    struct entry_type {
+        chain::transaction_metadata_ptr                                      trx;
+        bool                                                                 persist_until_expired;
+        chain::plugin_interface::next_function<chain::transaction_trace_ptr> next;
+    };
+
+public:
+    pending_transaction_queue();
+
+public:
+    void               set_config(const config_type& config) { config_ = config; }
+    const config_type& config() const { return config_; }
+
+    // charge is only used in charge order, 0 if it is unknown
+    void push(entry_type&& entry, uint32_t charge);
+    std::optional<entry_type> pop();
+
+    // a round is one pass for a pending block, transactions pushed during a round wait for the next one
+    void start_round();
+    void end_round();
+
+    size_t size() const { return queue_.size() + deferred_.size(); }
+    bool   empty() const { return size() == 0; }
+
+private:
+    struct item_type {
+        entry_type  entry;
+        double      priority;
+        uint64_t    seq;
+        std::string payer;
+    };
+
+    struct by_priority;
+
+    using queue_type = boost::multi_index_container<
+        item_type,
+        boost::multi_index::indexed_by<
+            boost::multi_index::ordered_non_unique<
+                boost::multi_index::tag<by_priority>,
+                boost::multi_index::composite_key<
+                    item_type,
+                    BOOST_MULTI_INDEX_MEMBER(item_type, double, priority),
+                    BOOST_MULTI_INDEX_MEMBER(item_type, uint64_t, seq)>,
+                boost::multi_index::composite_key_compare<std::greater<double>, std::less<uint64_t>>>>>;
+
+private:
+    config_type    config_;
+    fc::time_point epoch_;
+    uint64_t       next_seq_ = 0;
+    bool           in_round_ = false;
+
+    queue_type                                queue_;
+    std::vector<item_type>                    deferred_;  // pushed during the round or over the payer cap
+    std::unordered_map<std::string, uint32_t> taken_;     // transactions taken in this round by payer
+};
+
+}  // namespace evt
@@ -22,6 +22,9 @@ public:
         optional<int32_t> max_irreversible_block_age;
         optional<int32_t> produce_time_offset_us;
         optional<int32_t> last_block_time_offset_us;
+        optional<int32_t> block_cpu_fill_percent;
+        optional<int32_t> token_db_io_rate_mb;       // of flushes and compactions while producing, 0 for unlimited
+        optional<int32_t> token_db_idle_io_rate_mb;  // of them between the blocks produced, 0 for unlimited
     };
 
     struct integrity_hash_information {
@@ -42,6 +45,46 @@ public:
 
     struct create_snapshot_options {
         bool postgres = false;
+        // file names in the snapshots directory of a full snapshot followed by the diffs taken after it,
+        // a differential snapshot with only the changes since them is created when it's not empty
+        std::vector<std::string> bases;
+    };
+
+    struct start_tracing_options {
+        uint32_t max_events_per_thread = 1024 * 1024;
+    };
+
+    struct trace_information {
+        std::string trace_name;
+        size_t      events;
+    };
+
+    struct stage_latency {
+        std::string           stage;
+        uint64_t              count;
+        uint64_t              sum_us;
+        uint64_t              max_us;
+        uint64_t              p50_us;
+        uint64_t              p90_us;
+        uint64_t              p99_us;
+        std::vector<uint64_t> latency_us;  // count of samples under 16, 32, 64 ... us, the last one is the rest
+    };
+
+    struct block_transaction_counts {
+        uint32_t block_num = 0;
+        uint64_t applied   = 0;
+        uint64_t failed    = 0;  // objective failures, refused for good
+        uint64_t deferred  = 0;  // subjective failures, left for a later block
+    };
+
+    struct production_stats {
+        std::vector<stage_latency> stages;
+        uint64_t                   produced_blocks;
+        block_transaction_counts   total;
+        block_transaction_counts   last_block;
+        uint64_t                   accepted_transactions;   // incoming ones taken for processing
+        uint64_t                   duplicate_transactions;  // incoming ones refused as a copy of one in flight
+        uint64_t                   inflight_transactions;
     };
 
     producer_plugin();
@@ -67,6 +110,18 @@ public:
     integrity_hash_information get_integrity_hash() const;
     snapshot_information create_snapshot(const create_snapshot_options& options) const;
 
+    production_stats get_production_stats() const;
+
+    // spans of the hot paths are recorded from start until stop, then written to a trace event
+    // json file in the `traces` folder of data dir, which can be opened by chrome://tracing or Perfetto
+    void              start_tracing(const start_tracing_options& options);
+    trace_information stop_tracing();
+
+    // for load generators on the main thread: queues transactions whose keys are already recovered
+    // without the checks done on incoming ones, each is answered through `next` once applied or failed
+    void push_transactions(const std::vector<chain::transaction_metadata_ptr>& trxs,
+                           chain::plugin_interface::next_function<chain::transaction_trace_ptr> next);
+
     signal<void(const chain::producer_confirmation&)> confirmed_block;
 
 private:
@@ -75,7 +130,12 @@ private:
 
 }  // namespace evt
 
-FC_REFLECT(evt::producer_plugin::runtime_options, (max_transaction_time)(max_irreversible_block_age)(produce_time_offset_us)(last_block_time_offset_us));
+FC_REFLECT(evt::producer_plugin::runtime_options, (max_transaction_time)(max_irreversible_block_age)(produce_time_offset_us)(last_block_time_offset_us)(block_cpu_fill_percent)(token_db_io_rate_mb)(token_db_idle_io_rate_mb));
 FC_REFLECT(evt::producer_plugin::integrity_hash_information, (head_block_num)(head_block_id)(head_block_time)(integrity_hash));
 FC_REFLECT(evt::producer_plugin::snapshot_information, (head_block_num)(head_block_id)(head_block_time)(snapshot_name)(snapshot_size)(postgres));
-FC_REFLECT(evt::producer_plugin::create_snapshot_options, (postgres));
+FC_REFLECT(evt::producer_plugin::create_snapshot_options, (postgres)(bases));
+FC_REFLECT(evt::producer_plugin::start_tracing_options, (max_events_per_thread));
+FC_REFLECT(evt::producer_plugin::trace_information, (trace_name)(events));
+FC_REFLECT(evt::producer_plugin::stage_latency, (stage)(count)(sum_us)(max_us)(p50_us)(p90_us)(p99_us)(latency_us));
+FC_REFLECT(evt::producer_plugin::block_transaction_counts, (block_num)(applied)(failed)(deferred));
+FC_REFLECT(evt::producer_plugin::production_stats, (stages)(produced_blocks)(total)(last_block)(accepted_transactions)(duplicate_transactions)(inflight_transactions));
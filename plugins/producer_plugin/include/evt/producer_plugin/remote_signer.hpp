@@ -0,0 +1,74 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include <fc/network/http/http_client.hpp>
+#include <fc/network/url.hpp>
+
+#include <evt/chain/types.hpp>
+
+namespace evt {
+
+/**
+ * Signs digests with a key held by an evtwd, may be used from any thread
+ *
+ * Each signing takes an idle client from the pool, so it reuses one of the connections kept
+ * open and concurrent signings never wait on each other. While running, the idle connections
+ * are kept warm with a cheap request every `keepalive`. When the evtwd fails or does not answer
+ * before `timeout`, the fallback key signs instead if there is one.
+ */
+class remote_signer {
+public:
+    struct config_type {
+        size_t           connections = 2;
+        fc::microseconds timeout     = fc::milliseconds(5);  // negative for none
+        fc::microseconds keepalive   = fc::seconds(5);       // 0 disables
+    };
+
+    using client_factory = std::function<std::unique_ptr<fc::http_client>()>;
+
+public:
+    remote_signer(const fc::url& url, const chain::public_key_type& key, const config_type& config,
+                  client_factory factory, std::optional<chain::private_key_type> fallback);
+    ~remote_signer();
+
+public:
+    chain::signature_type sign(const chain::digest_type& digest);
+
+    // opens the connections in the background and keeps them warm until stopped
+    void start();
+    void stop();
+
+private:
+    std::unique_ptr<fc::http_client> acquire();
+    void                             release(std::unique_ptr<fc::http_client> client);
+
+    bool ping(fc::http_client& client);
+    void keepalive_loop();
+
+private:
+    fc::url                                url_;
+    fc::url                                ping_url_;
+    chain::public_key_type                 key_;
+    config_type                            config_;
+    client_factory                         factory_;
+    std::optional<chain::private_key_type> fallback_;
+
+    std::mutex                                    mtx_;
+    std::condition_variable                       cv_;
+    std::vector<std::unique_ptr<fc::http_client>> idle_;
+    std::thread                                   keepalive_thread_;
+    bool                                          stopping_ = false;
+};
+
+}  // namespace evt
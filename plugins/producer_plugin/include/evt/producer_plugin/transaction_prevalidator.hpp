@@ -0,0 +1,41 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <memory>
+
+#include <evt/chain/chain_config.hpp>
+#include <evt/chain/controller.hpp>
+#include <evt/chain/transaction_metadata.hpp>
+
+namespace evt {
+
+/**
+ * Stateless checks of incoming transactions which may run on any thread
+ *
+ * The main thread publishes what the checks need after each accepted block: the chain config,
+ * the head block time and the prefix of each block id of the TaPoS table. A transaction failing
+ * here would fail the same way when applied, the checks are kept loose enough for that: a pending
+ * block is never earlier than the head block, nor more than two block intervals from now.
+ */
+class transaction_prevalidator {
+public:
+    // reads the whole TaPoS table and the config, on the main thread
+    void load(const chain::controller& chain);
+    // on the main thread, after a block was applied
+    void on_block(const chain::controller& chain, const chain::block_state_ptr& bsp);
+
+    // the exception the transaction would fail with, null if none is known yet
+    fc::exception_ptr check(const chain::transaction_metadata& trx) const;
+
+private:
+    std::array<std::atomic<uint32_t>, 0x10000> tapos_prefixes_{};
+    std::shared_ptr<const chain::chain_config> config_;
+    std::atomic<int64_t>                       head_block_time_us_{0};
+};
+
+}  // namespace evt
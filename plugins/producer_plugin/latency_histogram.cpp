@@ -0,0 +1,81 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#include <evt/producer_plugin/latency_histogram.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace evt {
+
+size_t
+latency_histogram::bucket_of(uint64_t us) {
+    us = std::min<uint64_t>(us, (1ull << (max_magnitude + 1)) - 1);
+    if(us < sub_buckets) {
+        return us;
+    }
+    auto magnitude = (size_t)(63 - __builtin_clzll(us));
+    auto sub       = (us >> (magnitude - sub_bucket_bits)) & (sub_buckets - 1);
+    return (magnitude - sub_bucket_bits + 1) * sub_buckets + sub;
+}
+
+uint64_t
+latency_histogram::lowest_of(size_t bucket) {
+    if(bucket < sub_buckets) {
+        return bucket;
+    }
+    auto magnitude = bucket / sub_buckets + sub_bucket_bits - 1;
+    auto sub       = bucket % sub_buckets;
+    return (sub_buckets + sub) << (magnitude - sub_bucket_bits);
+}
+
+void
+latency_histogram::record(fc::microseconds elapsed) {
+    auto us = (uint64_t)std::max<int64_t>(elapsed.count(), 0);
+
+    buckets_[bucket_of(us)].fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(us, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+
+    auto max = max_.load(std::memory_order_relaxed);
+    while(us > max && !max_.compare_exchange_weak(max, us, std::memory_order_relaxed)) {}
+}
+
+uint64_t
+latency_histogram::percentile(double q) const {
+    auto total = uint64_t(0);
+    for(auto& b : buckets_) {
+        total += b.load(std::memory_order_relaxed);
+    }
+    if(total == 0) {
+        return 0;
+    }
+
+    auto rank = std::max<uint64_t>((uint64_t)std::ceil(std::clamp(q, 0.0, 1.0) * total), 1);
+    auto seen = uint64_t(0);
+    for(auto i = size_t(0); i < bucket_count - 1; i++) {
+        seen += buckets_[i].load(std::memory_order_relaxed);
+        if(seen >= rank) {
+            return std::min(lowest_of(i + 1) - 1, max());
+        }
+    }
+    return max();
+}
+
+std::vector<uint64_t>
+latency_histogram::power_buckets(size_t first, size_t last) const {
+    auto result = std::vector<uint64_t>(last - first + 2, 0);
+    // bucket bounds are aligned to powers of two, so a bucket is under 2^i once its lowest value is
+    auto slot = size_t(0);
+    for(auto i = size_t(0); i < bucket_count; i++) {
+        auto low = lowest_of(i);
+        while(slot <= last - first && low >= (1ull << (first + slot))) {
+            slot++;
+        }
+        result[slot] += buckets_[i].load(std::memory_order_relaxed);
+    }
+    return result;
+}
+
+}  // namespace evt
@@ -0,0 +1,77 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#include <evt/producer_plugin/pending_transaction_queue.hpp>
+
+#include <algorithm>
+
+namespace evt {
+
+pending_transaction_queue::pending_transaction_queue()
+    : epoch_(fc::time_point::now()) {}
+
+void
+pending_transaction_queue::push(entry_type&& entry, uint32_t charge) {
+    auto item     = item_type();
+    item.seq      = next_seq_++;
+    item.priority = 0;
+
+    if(config_.order == order_type::charge) {
+        auto size = std::max<size_t>(entry.trx->packed_trx->get_unprunable_size(), 1);
+        auto wait = (double)(fc::time_point::now() - epoch_).count() / std::max<int64_t>(config_.age_boost.count(), 1);
+        // waiting longer raises the effective priority of every queued one by the same amount,
+        // so arriving later is the same as a lower fixed priority
+        item.priority = (double)charge * 1024 / size - wait;
+    }
+    if(config_.payer_cap > 0) {
+        item.payer = entry.trx->packed_trx->get_transaction().payer.to_string();
+    }
+    item.entry = std::move(entry);
+
+    if(in_round_) {
+        deferred_.emplace_back(std::move(item));
+    }
+    else {
+        queue_.emplace(std::move(item));
+    }
+}
+
+std::optional<pending_transaction_queue::entry_type>
+pending_transaction_queue::pop() {
+    auto& idx = queue_.get<by_priority>();
+    while(!idx.empty()) {
+        auto item = *idx.begin();
+        idx.erase(idx.begin());
+
+        if(config_.payer_cap > 0) {
+            auto& taken = taken_[item.payer];
+            if(taken >= config_.payer_cap) {
+                deferred_.emplace_back(std::move(item));
+                continue;
+            }
+            taken++;
+        }
+        return std::move(item.entry);
+    }
+    return std::nullopt;
+}
+
+void
+pending_transaction_queue::start_round() {
+    // a round which ended early leaves its deferred transactions behind
+    end_round();
+    in_round_ = true;
+}
+
+void
+pending_transaction_queue::end_round() {
+    for(auto& item : deferred_) {
+        queue_.emplace(std::move(item));
+    }
+    deferred_.clear();
+    taken_.clear();
+    in_round_ = false;
+}
+
+}  // namespace evt
@@ -3,11 +3,20 @@
  *  @copyright defined in evt/LICENSE.txt
  */
 #include <evt/producer_plugin/producer_plugin.hpp>
+#include <evt/producer_plugin/pending_transaction_queue.hpp>
+#include <evt/producer_plugin/latency_histogram.hpp>
+#include <evt/producer_plugin/execution_cost_model.hpp>
+#include <evt/producer_plugin/remote_signer.hpp>
+#include <evt/producer_plugin/transaction_prevalidator.hpp>
 
 #include <algorithm>
+#include <array>
+#include <deque>
+#include <fstream>
 #include <iostream>
 
 #include <boost/asio.hpp>
+#include <boost/asio/thread_pool.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/function_output_iterator.hpp>
 #include <boost/multi_index/hashed_index.hpp>
@@ -18,12 +27,16 @@
 #include <boost/signals2/connection.hpp>
 
 #include <fc/io/json.hpp>
+#include <fc/log/trace.hpp>
 #include <fc/scoped_exit.hpp>
 #include <fc/smart_ref_impl.hpp>
 
+#include <evt/chain/deadline_timer.hpp>
 #include <evt/chain/global_property_object.hpp>
 #include <evt/chain/plugin_interface.hpp>
 #include <evt/chain/snapshot.hpp>
+#include <evt/chain/token_database.hpp>
+#include <evt/utilities/task_scheduler.hpp>
 
 #ifdef POSTGRES_SUPPORT
 #include <evt/postgres_plugin/postgres_plugin.hpp>
@@ -117,8 +130,12 @@ public:
 
     optional<fc::time_point> calculate_next_block_time(const account_name& producer_name, const block_timestamp_type& current_block_time) const;
     void                     schedule_production_loop();
-    void                     produce_block();
+    bool                     produce_block();
     bool                     maybe_produce_block();
+    void                     on_block_signed(const block_state_ptr& bs, const fc::static_variant<fc::exception_ptr, signature_type>& result, fc::microseconds elapsed);
+    void                     on_block_produced();
+    void                     schedule_maybe_produce_block(const fc::time_point& at);
+    void                     schedule_expired_trxs_sweep();
 
     boost::program_options::variables_map _options;
     bool                                  _production_enabled    = false;
@@ -127,6 +144,7 @@ public:
 
     using signature_provider_type = std::function<chain::signature_type(chain::digest_type)>;
     std::map<chain::public_key_type, signature_provider_type> _signature_providers;
+    std::vector<std::shared_ptr<remote_signer>>               _remote_signers;
     std::set<chain::account_name>                             _producers;
     boost::asio::deadline_timer                               _timer;
     std::map<chain::account_name, uint32_t>                   _producer_watermarks;
@@ -137,9 +155,40 @@ public:
     fc::microseconds _max_irreversible_block_age_us;
     int32_t          _produce_time_offset_us = 0;
     int32_t          _last_block_time_offset_us = 0;
+    fc::microseconds _prebuild_lead_us;
+    uint32_t         _block_cpu_fill_percent = 0;
     fc::time_point   _irreversible_block_time;
     fc::microseconds _evtwd_provider_timeout_us;
 
+    // finalized blocks are signed here when signing is asynchronous, the block is committed
+    // back on the main thread only if it is still the pending one by then
+    optional<boost::asio::thread_pool> _signing_pool;
+    block_state_ptr                    _signing_block;
+
+    enum production_stage {
+        stage_start_block,
+        stage_incoming_trx,
+        stage_retry_trx,
+        stage_finalize,
+        stage_sign,
+        stage_commit,
+        stage_count
+    };
+
+    // latency of each stage in building a block, transactions are counted for the pending block
+    // and added to the totals once it is produced
+    std::array<latency_histogram, stage_count> _stage_latency;
+    uint64_t                                   _produced_blocks = 0;
+    producer_plugin::block_transaction_counts  _pending_block_counts;
+    producer_plugin::block_transaction_counts  _total_block_counts;
+    producer_plugin::block_transaction_counts  _last_block_counts;
+
+    // with a fill target a produced block takes transactions only while their predicted time fits in
+    // its share of the block interval, and goes out as soon as one does not
+    execution_cost_model _cost_model;
+    fc::microseconds     _pending_block_cpu_us;
+    bool                 _pending_block_full = false;
+
     time_point _last_signed_block_time;
     time_point _start_time            = fc::time_point::now();
     uint32_t   _last_signed_block_num = 0;
@@ -155,10 +204,15 @@ public:
     incoming::methods::block_sync::method_type::handle        _incoming_block_sync_provider;
     incoming::methods::transaction_async::method_type::handle _incoming_transaction_async_provider;
 
+    // checks done in the thread pool before a transaction is posted to the main thread, if enabled
+    optional<transaction_prevalidator> _prevalidator;
+
+    // signed ids of the transactions failed for objective reasons, refused until they expire
     transaction_id_with_expiry_index _blacklisted_transactions;
+    uint32_t                         _max_blacklisted_transactions = 0;
 
-    optional<scoped_connection> _accepted_block_connection;
-    optional<scoped_connection> _irreversible_block_connection;
+    optional<utilities::scoped_signal_connection> _accepted_block_connection;
+    optional<scoped_connection>                   _irreversible_block_connection;
 
     /*
        * HACK ALERT
@@ -184,11 +238,11 @@ public:
         if(bsp->block_num <= _last_signed_block_num)
             return;
 
-        const auto& active_producer_to_signing_key = bsp->active_schedule.producers;
+        const auto& active_producer_to_signing_key = bsp->active_schedule->producers;
 
         flat_set<account_name> active_producers;
-        active_producers.reserve(bsp->active_schedule.producers.size());
-        for(const auto& p : bsp->active_schedule.producers) {
+        active_producers.reserve(bsp->active_schedule->producers.size());
+        for(const auto& p : bsp->active_schedule->producers) {
             active_producers.insert(p.producer_name);
         }
 
@@ -223,15 +277,15 @@ public:
         auto new_bs                         = bsp -> generate_next(new_block_header.timestamp);
 
         // for newly installed producers we can set their watermarks to the block they became active
-        if(new_bs.maybe_promote_pending() && bsp->active_schedule.version != new_bs.active_schedule.version) {
+        if(new_bs.maybe_promote_pending() && bsp->active_schedule->version != new_bs.active_schedule->version) {
             flat_set<account_name> new_producers;
-            new_producers.reserve(new_bs.active_schedule.producers.size());
-            for(const auto& p : new_bs.active_schedule.producers) {
+            new_producers.reserve(new_bs.active_schedule->producers.size());
+            for(const auto& p : new_bs.active_schedule->producers) {
                 if(_producers.count(p.producer_name) > 0)
                     new_producers.insert(p.producer_name);
             }
 
-            for(const auto& p : bsp->active_schedule.producers) {
+            for(const auto& p : bsp->active_schedule->producers) {
                 new_producers.erase(p.producer_name);
             }
 
@@ -304,8 +358,9 @@ public:
             return;
         }
 
-        // abort the pending block
-        chain.abort_block();
+        // pending block is aborted by the controller unless the block extends it, a block still
+        // being signed is dropped either way
+        _signing_block.reset();
 
         // exceptions throw out, make sure we restart our loop
         auto ensure = fc::make_scoped_exit([this]() {
@@ -353,23 +408,155 @@ public:
         }
     }
     
-    std::deque<std::tuple<transaction_metadata_ptr, bool, next_function<transaction_trace_ptr>>> _pending_incoming_transactions;
+    pending_transaction_queue _pending_incoming_transactions;
+
+    auto
+    time_stage(production_stage stage) {
+        return fc::make_scoped_exit([this, stage, start = fc::time_point::now()] {
+            _stage_latency[stage].record(fc::time_point::now() - start);
+        });
+    }
+
+    bool
+    fill_target_enabled() const {
+        return _block_cpu_fill_percent > 0 && _pending_block_mode == pending_block_mode::producing;
+    }
+
+    fc::microseconds
+    remaining_block_cpu() const {
+        auto target = fc::microseconds((int64_t)config::block_interval_us * _block_cpu_fill_percent / 100);
+        return std::max(target - _pending_block_cpu_us, fc::microseconds(0));
+    }
+
+    bool
+    fits_in_pending_block(const transaction_metadata_ptr& trx) {
+        if(!fill_target_enabled() || _pending_block_cpu_us.count() == 0) {
+            // the first one always gets in, or one predicted longer than the target would never be
+            return true;
+        }
+        if(_cost_model.predict(trx->packed_trx->get_transaction()) <= remaining_block_cpu()) {
+            return true;
+        }
+        if(!_pending_block_full) {
+            _pending_block_full = true;
+            fc_dlog(_log, "Block #${num} reached its fill target", ("num", chain_plug->chain().pending_block_state()->block_num));
+            // ship it off up to 1 block time earlier, as an exhausted one
+            auto expect_time = chain_plug->chain().pending_block_time() - fc::microseconds(config::block_interval_us);
+            schedule_maybe_produce_block(std::max(fc::time_point::now(), expect_time));
+        }
+        return false;
+    }
+
+    // a transaction may take no more than what is left to the fill target, which is subjective
+    void
+    limit_to_fill_target(fc::time_point& deadline, bool& deadline_is_subjective) const {
+        if(!fill_target_enabled()) {
+            return;
+        }
+        auto fill_deadline = fc::time_point::now() + remaining_block_cpu();
+        if(fill_deadline < deadline) {
+            deadline               = fill_deadline;
+            deadline_is_subjective = true;
+        }
+    }
+
+    void
+    on_transaction_applied(const transaction_trace_ptr& trace) {
+        _pending_block_counts.applied++;
+        _pending_block_cpu_us += trace->elapsed;
+        _cost_model.observe(*trace);
+    }
+
+    void
+    queue_incoming_transaction(const transaction_metadata_ptr& trx, bool persist_until_expired, next_function<transaction_trace_ptr> next) {
+        auto charge = uint32_t(0);
+        if(_pending_incoming_transactions.config().order == pending_transaction_queue::order_type::charge) {
+            if(trx->charge.has_value()) {
+                charge = trx->charge->second;
+            }
+            else {
+                try {
+                    charge = chain_plug->chain().get_charge_manager().calculate(*trx->packed_trx);
+                }
+                catch(const fc::exception&) {
+                    // invalid ones are rejected when applied
+                }
+            }
+        }
+        _pending_incoming_transactions.push({trx, persist_until_expired, std::move(next)}, charge);
+    }
+
+    void
+    blacklist_transaction(const transaction_metadata_ptr& trx, const fc::exception& e) {
+        // duplicates are already refused cheaply
+        if(_max_blacklisted_transactions == 0 || e.code() == tx_duplicate::code_value) {
+            return;
+        }
+
+        auto& blacklist_by_expiry = _blacklisted_transactions.get<by_expiry>();
+        auto  now                 = fc::time_point::now();
+        while(!blacklist_by_expiry.empty()
+              && (blacklist_by_expiry.begin()->expiry <= now || _blacklisted_transactions.size() >= _max_blacklisted_transactions)) {
+            blacklist_by_expiry.erase(blacklist_by_expiry.begin());
+        }
+        _blacklisted_transactions.insert(transaction_id_with_expiry{trx->signed_id, trx->packed_trx->expiration()});
+    }
 
     void
     on_incoming_transaction_async(const transaction_metadata_ptr& trx, bool persist_until_expired, next_function<transaction_trace_ptr> next) {
         chain::controller& chain = chain_plug->chain();
         const auto&        cfg   = chain.get_global_properties().configuration;
 
-        app().get_io_service().post([self = this, trx, persist_until_expired, next]() {
-            self->process_incoming_transaction_async(trx, persist_until_expired, next);
+        // signed id covers the signatures, so the same transaction signed properly is still accepted
+        auto& blacklist_by_id = _blacklisted_transactions.get<by_id>();
+        auto  blacklist_itr   = blacklist_by_id.find(trx->signed_id);
+        if(blacklist_itr != blacklist_by_id.end() && blacklist_itr->expiry > fc::time_point::now()) {
+            next(std::static_pointer_cast<fc::exception>(std::make_shared<tx_blacklisted>(FC_LOG_MESSAGE(error, "blacklisted transaction ${id}", ("id", trx->id)))));
+            return;
+        }
+
+        // a copy still being processed would only be found duplicate once applied
+        auto& inflight = chain_plug->get_inflight_transactions();
+        if(!inflight.insert(trx->id)) {
+            next(std::static_pointer_cast<fc::exception>(std::make_shared<tx_duplicate>(FC_LOG_MESSAGE(error, "duplicate transaction ${id} in flight", ("id", trx->id)))));
+            return;
+        }
+        next = [&inflight, id = trx->id, next = std::move(next)](const fc::static_variant<fc::exception_ptr, transaction_trace_ptr>& response) {
+            inflight.erase(id);
+            next(response);
+        };
+
+        if(!_prevalidator.has_value()) {
+            // recover keys on the chain workers while waiting to be processed
+            transaction_metadata::create_signing_keys_future(trx, chain.get_task_scheduler(), chain.get_chain_id());
+
+            app().get_io_service().post([self = this, trx, persist_until_expired, next]() {
+                self->process_incoming_transaction_async(trx, persist_until_expired, next);
+            });
+            return;
+        }
+
+        chain.get_task_scheduler().post([self = this, &chain, trx, persist_until_expired, next]() {
+            // only the answer of an invalid one goes through the main thread, its callers expect it there
+            if(auto e = self->_prevalidator->check(*trx)) {
+                app().get_io_service().post([e, next]() {
+                    next(e);
+                });
+                return;
+            }
+
+            transaction_metadata::create_signing_keys_future(trx, chain.get_task_scheduler(), chain.get_chain_id());
+            app().get_io_service().post([self, trx, persist_until_expired, next]() {
+                self->process_incoming_transaction_async(trx, persist_until_expired, next);
+            });
         });
     }
 
     void
     process_incoming_transaction_async(const transaction_metadata_ptr& trx, bool persist_until_expired, next_function<transaction_trace_ptr> next) {
         chain::controller& chain = chain_plug->chain();
-        if(!chain.pending_block_state()) {
-            _pending_incoming_transactions.emplace_back(trx, persist_until_expired, next);
+        if(!chain.pending_block_state() || _signing_block) {
+            queue_incoming_transaction(trx, persist_until_expired, next);
             return;
         }
 
@@ -412,6 +599,12 @@ public:
             return;
         }
 
+        if(!fits_in_pending_block(trx)) {
+            _pending_block_counts.deferred++;
+            queue_incoming_transaction(trx, persist_until_expired, next);
+            return;
+        }
+
         auto deadline               = fc::time_point::now() + fc::milliseconds(_max_transaction_time_ms);
         bool deadline_is_subjective = false;
 
@@ -420,12 +613,18 @@ public:
             deadline_is_subjective = true;
             deadline               = block_deadline;
         }
+        limit_to_fill_target(deadline, deadline_is_subjective);
 
         try {
-            auto trace = chain.push_transaction(trx, deadline);
+            auto trace = transaction_trace_ptr();
+            {
+                auto timer = time_stage(stage_incoming_trx);
+                trace      = chain.push_transaction(trx, deadline);
+            }
             if(trace->except) {
                 if(failure_is_subjective(*trace->except, deadline_is_subjective)) {
-                    _pending_incoming_transactions.emplace_back(trx, persist_until_expired, next);
+                    _pending_block_counts.deferred++;
+                    queue_incoming_transaction(trx, persist_until_expired, next);
                     if(_pending_block_mode == pending_block_mode::producing) {
                         fc_dlog(_trx_trace_log, "[TRX_TRACE] Block ${block_num} for producer ${prod} COULD NOT FIT, tx: ${txid} RETRYING ",
                                 ("block_num", chain.head_block_num() + 1)("prod", chain.pending_block_state()->header.producer)("txid", trx->id));
@@ -436,11 +635,14 @@ public:
                     }
                 }
                 else {
+                    _pending_block_counts.failed++;
+                    blacklist_transaction(trx, *trace->except);
                     auto e_ptr = trace->except->dynamic_copy_exception();
                     send_response(e_ptr);
                 }
             }
             else {
+                on_transaction_applied(trace);
                 if(persist_until_expired) {
                     // if this trx didnt fail/soft-fail and the persist flag is set, store its ID so that we can
                     // ensure its applied to all future speculative blocks as well.
@@ -544,12 +746,34 @@ producer_plugin::set_program_options(
             "   KEY:<data>      \tis a string form of a valid EVT private key which maps to the provided public key\n\n"
             "   EVTWD:<data>    \tis the URL where evtwd is available and the approptiate wallet(s) are unlocked")
          ("evtwd-provider-timeout", boost::program_options::value<int32_t>()->default_value(5), "Limits the maximum time (in milliseconds) that is allowed for sending blocks to a evtwd provider for signing")
+         ("evtwd-provider-connections", bpo::value<uint32_t>()->default_value(2),
+            "Number of connections kept open to each evtwd provider")
+         ("evtwd-provider-keepalive-ms", bpo::value<uint32_t>()->default_value(5000),
+            "Interval of the requests keeping the idle connections to evtwd providers warm, 0 only opens them at startup")
+         ("signature-provider-fallback", bpo::value<vector<string>>()->composing()->multitoken(),
+            "<public-key>=KEY:<private-key> pairs signing instead of the EVTWD provider of the same public key when it fails or times out (may specify multiple times)")
          ("produce-time-offset-us", boost::program_options::value<int32_t>()->default_value(0),
             "offset of non last block producing time in microseconds. Negative number results in blocks to go out sooner, and positive number results in blocks to go out later")
          ("last-block-time-offset-us", boost::program_options::value<int32_t>()->default_value(0),
             "offset of last block producing time in microseconds. Negative number results in blocks to go out sooner, and positive number results in blocks to go out later")
          ("snapshots-dir", bpo::value<bfs::path>()->default_value("snapshots"),
             "the location of the snapshots directory (absolute path or relative to application data dir)")
+         ("producer-prebuild-lead-ms", bpo::value<uint32_t>()->default_value(0),
+            "Start building the block of a local producer's slot this many milliseconds earlier on the current head, it is rebuilt only when the head changes; 0 disables")
+         ("max-blacklisted-transactions", bpo::value<uint32_t>()->default_value(100000),
+            "Maximum number of objectively failed transactions refused on arrival until they expire, 0 disables")
+         ("producer-async-signing", bpo::bool_switch()->default_value(false),
+            "Sign produced blocks on a worker thread so the main thread stays free while a remote signature provider answers")
+         ("pending-trx-order", bpo::value<string>()->default_value("fifo"),
+            "Order in which queued incoming transactions are applied: fifo, or charge for the highest charge per byte first")
+         ("pending-trx-age-boost-ms", bpo::value<uint32_t>()->default_value(1000),
+            "In charge order, each this many milliseconds a transaction waits weighs as one more charge per KB")
+         ("pending-trx-payer-cap", bpo::value<uint32_t>()->default_value(0),
+            "Maximum queued transactions of one payer applied to each pending block, 0 means unlimited")
+         ("prevalidate-transactions", bpo::value<bool>()->default_value(true),
+            "Reject incoming transactions which are expired, too large, empty or from another fork in the thread pool before they reach the main thread")
+         ("block-cpu-fill-percent", bpo::value<uint32_t>()->default_value(0),
+            "Percentage of the block interval produced blocks may spend applying transactions, a transaction predicted not to fit waits for the next block and the block goes out early; 0 disables")
          ;
     config_file_options.add(producer_options); 
 }
@@ -595,21 +819,14 @@ make_key_signature_provider(const private_key_type& key) {
 }
 
 static producer_plugin_impl::signature_provider_type
-make_evtwd_signature_provider(const std::shared_ptr<producer_plugin_impl>& impl, const string& url_str, const public_key_type pubkey) {
-    auto evtwd_url = fc::url(url_str);
-    std::weak_ptr<producer_plugin_impl> weak_impl = impl;
-
-    return [weak_impl, evtwd_url, pubkey](const chain::digest_type& digest) {
-        auto impl = weak_impl.lock();
-        if(impl) {
-            fc::variant params;
-            fc::to_variant(std::make_pair(digest, pubkey), params);
-            auto deadline = impl->_evtwd_provider_timeout_us.count() >= 0 ? fc::time_point::now() + impl->_evtwd_provider_timeout_us : fc::time_point::maximum();
-            return app().get_plugin<http_client_plugin>().get_client().post_sync(evtwd_url, params, deadline).as<chain::signature_type>();
-        }
-        else {
-            return signature_type();
-        }
+make_evtwd_signature_provider(const std::shared_ptr<producer_plugin_impl>& impl, const string& url_str, const public_key_type pubkey,
+                              const remote_signer::config_type& config, const std::optional<private_key_type>& fallback) {
+    auto factory = [] { return app().get_plugin<http_client_plugin>().create_client(); };
+    auto signer  = std::make_shared<remote_signer>(fc::url(url_str), pubkey, config, factory, fallback);
+    impl->_remote_signers.emplace_back(signer);
+
+    return [signer](const chain::digest_type& digest) {
+        return signer->sign(digest);
     };
 }
 
@@ -640,6 +857,28 @@ producer_plugin::plugin_initialize(const boost::program_options::variables_map&
             }
         }
 
+        my->_evtwd_provider_timeout_us = fc::milliseconds(options.at("evtwd-provider-timeout").as<int32_t>());
+
+        auto remote_config        = remote_signer::config_type();
+        remote_config.connections = std::max<uint32_t>(options.at("evtwd-provider-connections").as<uint32_t>(), 1);
+        remote_config.timeout     = my->_evtwd_provider_timeout_us;
+        remote_config.keepalive   = fc::milliseconds(options.at("evtwd-provider-keepalive-ms").as<uint32_t>());
+
+        auto fallback_keys = std::map<public_key_type, private_key_type>();
+        if(options.count("signature-provider-fallback")) {
+            const std::vector<std::string> key_spec_pairs = options["signature-provider-fallback"].as<std::vector<std::string>>();
+            for(const auto& key_spec_pair : key_spec_pairs) {
+                try {
+                    auto delim = key_spec_pair.find("=KEY:");
+                    EVT_ASSERT(delim != std::string::npos, plugin_config_exception, "Missing \"=KEY:\" in the fallback key spec pair");
+                    fallback_keys.emplace(public_key_type(key_spec_pair.substr(0, delim)), private_key_type(key_spec_pair.substr(delim + 5)));
+                }
+                catch(...) {
+                    elog("Malformed signature provider fallback, ignoring!");
+                }
+            }
+        }
+
         if(options.count("signature-provider")) {
             const std::vector<std::string> key_spec_pairs = options["signature-provider"].as<std::vector<std::string>>();
             for(const auto& key_spec_pair : key_spec_pairs) {
@@ -660,7 +899,11 @@ producer_plugin::plugin_initialize(const boost::program_options::variables_map&
                         my->_signature_providers[pubkey] = make_key_signature_provider(private_key_type(spec_data));
                     }
                     else if(spec_type_str == "EVTWD") {
-                        my->_signature_providers[pubkey] = make_evtwd_signature_provider(my, spec_data, pubkey);
+                        auto fallback = std::optional<private_key_type>();
+                        if(auto it = fallback_keys.find(pubkey); it != fallback_keys.end()) {
+                            fallback = it->second;
+                        }
+                        my->_signature_providers[pubkey] = make_evtwd_signature_provider(my, spec_data, pubkey, remote_config, fallback);
                     }
                 }
                 catch(...) {
@@ -669,16 +912,44 @@ producer_plugin::plugin_initialize(const boost::program_options::variables_map&
             }
         }
 
-        my->_evtwd_provider_timeout_us = fc::milliseconds(options.at("evtwd-provider-timeout").as<int32_t>());
-
         my->_produce_time_offset_us = options.at("produce-time-offset-us").as<int32_t>();
 
         my->_last_block_time_offset_us = options.at("last-block-time-offset-us").as<int32_t>();
 
+        my->_max_blacklisted_transactions = options.at("max-blacklisted-transactions").as<uint32_t>();
+
+        if(options.at("producer-async-signing").as<bool>()) {
+            my->_signing_pool.emplace(1);
+        }
+
+        // only the slot right after the pending one is built ahead, so the lead is at most one block interval
+        my->_prebuild_lead_us = fc::milliseconds(std::min<uint32_t>(options.at("producer-prebuild-lead-ms").as<uint32_t>(), config::block_interval_ms));
+
         my->_max_transaction_time_ms = options.at("max-transaction-time").as<int32_t>();
 
+        if(options.at("prevalidate-transactions").as<bool>()) {
+            my->_prevalidator.emplace();
+        }
+
+        my->_block_cpu_fill_percent = options.at("block-cpu-fill-percent").as<uint32_t>();
+        EVT_ASSERT(my->_block_cpu_fill_percent <= 100, plugin_config_exception, "block-cpu-fill-percent should be no more than 100");
+
         my->_max_irreversible_block_age_us = fc::seconds(options.at("max-irreversible-block-age").as<int32_t>());
 
+        {
+            auto queue_config = pending_transaction_queue::config_type();
+            auto order        = options.at("pending-trx-order").as<string>();
+            if(order == "charge") {
+                queue_config.order = pending_transaction_queue::order_type::charge;
+            }
+            else {
+                EVT_ASSERT(order == "fifo", plugin_config_exception, "Unknown pending-trx-order: ${o}", ("o",order));
+            }
+            queue_config.age_boost = fc::milliseconds(std::max<uint32_t>(options.at("pending-trx-age-boost-ms").as<uint32_t>(), 1));
+            queue_config.payer_cap = options.at("pending-trx-payer-cap").as<uint32_t>();
+            my->_pending_incoming_transactions.set_config(queue_config);
+        }
+
         if(options.count("snapshots-dir")) {
             auto sd = options.at("snapshots-dir").as<bfs::path>();
             if(sd.is_relative()) {
@@ -733,7 +1004,22 @@ producer_plugin::plugin_startup() {
         EVT_ASSERT(my->_producers.empty() || chain.get_validation_mode() == chain::validation_mode::FULL, plugin_config_exception,
             "node cannot have any producer-name configured because block production is not safe when validation_mode is not \"full\"");
 
-        my->_accepted_block_connection.emplace(chain.accepted_block.connect([this](const auto& bsp) { my->on_block(bsp); }));
+        if(my->_prevalidator.has_value()) {
+            if(chain.skip_trx_checks()) {
+                // the chain does not check them all either
+                my->_prevalidator.reset();
+            }
+            else {
+                my->_prevalidator->load(chain);
+            }
+        }
+
+        my->_accepted_block_connection.emplace(chain.accepted_block.connect([this](const auto& bsp) {
+            if(my->_prevalidator.has_value()) {
+                my->_prevalidator->on_block(my->chain_plug->chain(), bsp);
+            }
+            my->on_block(bsp);
+        }));
         my->_irreversible_block_connection.emplace(chain.irreversible_block.connect([this](const auto& bsp) { my->on_irreversible_block(bsp->block); }));
 
         const auto lib_num = chain.last_irreversible_block_num();
@@ -756,6 +1042,10 @@ producer_plugin::plugin_startup() {
             }
         }
 
+        for(auto& signer : my->_remote_signers) {
+            signer->start();
+        }
+
         my->schedule_production_loop();
 
         ilog("producer plugin:  plugin_startup() end");
@@ -774,6 +1064,16 @@ producer_plugin::plugin_shutdown() {
 
     my->_accepted_block_connection.reset();
     my->_irreversible_block_connection.reset();
+
+    if(my->_signing_pool.has_value()) {
+        my->_signing_pool->join();
+        my->_signing_pool.reset();
+    }
+    my->_signing_block.reset();
+
+    for(auto& signer : my->_remote_signers) {
+        signer->stop();
+    }
 }
 
 void
@@ -831,6 +1131,26 @@ producer_plugin::update_runtime_options(const runtime_options& options) {
         my->_last_block_time_offset_us = *options.last_block_time_offset_us;
     }
 
+    if(options.block_cpu_fill_percent) {
+        EVT_ASSERT(*options.block_cpu_fill_percent >= 0 && *options.block_cpu_fill_percent <= 100, plugin_config_exception,
+                   "block_cpu_fill_percent should be between 0 and 100");
+        my->_block_cpu_fill_percent = *options.block_cpu_fill_percent;
+    }
+
+    if(options.token_db_io_rate_mb || options.token_db_idle_io_rate_mb) {
+        auto& tokendb = my->chain_plug->chain().token_db();
+        auto  rates   = tokendb.get_io_rates();
+        if(options.token_db_io_rate_mb) {
+            EVT_ASSERT(*options.token_db_io_rate_mb >= 0, plugin_config_exception, "token_db_io_rate_mb should not be negative");
+            rates.first = (uint64_t)*options.token_db_io_rate_mb * 1024 * 1024;
+        }
+        if(options.token_db_idle_io_rate_mb) {
+            EVT_ASSERT(*options.token_db_idle_io_rate_mb >= 0, plugin_config_exception, "token_db_idle_io_rate_mb should not be negative");
+            rates.second = (uint64_t)*options.token_db_idle_io_rate_mb * 1024 * 1024;
+        }
+        tokendb.set_io_rates(rates.first, rates.second);
+    }
+
     if(check_speculating && my->_pending_block_mode == pending_block_mode::speculating) {
         chain::controller& chain = my->chain_plug->chain();
         chain.abort_block();
@@ -840,11 +1160,15 @@ producer_plugin::update_runtime_options(const runtime_options& options) {
 
 producer_plugin::runtime_options
 producer_plugin::get_runtime_options() const {
+    auto rates = my->chain_plug->chain().token_db().get_io_rates();
     return {
         my->_max_transaction_time_ms,
         my->_max_irreversible_block_age_us.count() < 0 ? -1 : my->_max_irreversible_block_age_us.count() / 1'000'000,
         my->_produce_time_offset_us,
-        my->_last_block_time_offset_us
+        my->_last_block_time_offset_us,
+        (int32_t)my->_block_cpu_fill_percent,
+        (int32_t)(rates.first / 1024 / 1024),
+        (int32_t)(rates.second / 1024 / 1024)
     };
 }
 
@@ -857,8 +1181,9 @@ producer_plugin::get_integrity_hash() const {
     });
 
     if(chain.pending_block_state()) {
-        // abort the pending block
+        // abort the pending block, a block still being signed is dropped as well
         chain.abort_block();
+        my->_signing_block.reset();
     }
     else {
         reschedule.cancel();
@@ -876,25 +1201,46 @@ producer_plugin::create_snapshot(const create_snapshot_options& options) const {
     });
 
     if(chain.pending_block_state()) {
-        // abort the pending block
+        // abort the pending block, a block still being signed is dropped as well
         chain.abort_block();
+        my->_signing_block.reset();
     }
     else {
         reschedule.cancel();
     }
 
+    auto diff          = !options.bases.empty();
     auto head_id       = chain.head_block_id();
-    auto snapshot_path = (my->_snapshots_dir / fc::format_string("snapshot-${id}.bin", fc::mutable_variant_object()("id", head_id))).generic_string();
+    auto snapshot_name = diff ? "snapshot-diff-${id}.bin" : "snapshot-${id}.bin";
+    auto snapshot_path = (my->_snapshots_dir / fc::format_string(snapshot_name, fc::mutable_variant_object()("id", head_id))).generic_string();
 
     EVT_ASSERT(!fc::is_regular_file(snapshot_path), snapshot_exists_exception,
                "snapshot named ${name} already exists", ("name", snapshot_path));
+    EVT_ASSERT(!diff || !options.postgres, invalid_query_params_exception,
+               "postgres cannot be written into differential snapshots");
+
+    auto base_files = std::deque<std::ifstream>();
+    auto bases      = std::vector<snapshot_reader_ptr>();
+    for(auto& b : options.bases) {
+        auto base_path = my->_snapshots_dir / b;
+        EVT_ASSERT(b.find('/') == std::string::npos && fc::is_regular_file(base_path), invalid_query_params_exception,
+                   "base snapshot ${name} doesn't exist in snapshots directory", ("name", b));
+
+        auto& f = base_files.emplace_back(base_path.generic_string(), (std::ios::in | std::ios::binary));
+        bases.emplace_back(std::make_shared<istream_snapshot_reader>(f));
+    }
 
     auto snap_out = std::ofstream(snapshot_path, (std::ios::out | std::ios::binary));
     auto writer   = std::make_shared<ostream_snapshot_writer>(snap_out);
 
     bool postgres = false;
 
-    chain.write_snapshot(writer);
+    if(diff) {
+        chain.write_diff_snapshot(writer, bases);
+    }
+    else {
+        chain.write_snapshot(writer);
+    }
     if(options.postgres) {
 #ifdef POSTGRES_SUPPORT
         if(app().find_plugin("evt::postgres_plugin") == nullptr) {
@@ -924,11 +1270,70 @@ producer_plugin::create_snapshot(const create_snapshot_options& options) const {
     return {chain.head_block_num(), head_id, chain.head_block_time(), snapshot_path, sz, postgres};
 }
 
+void
+producer_plugin::start_tracing(const start_tracing_options& options) {
+    EVT_ASSERT(options.max_events_per_thread > 0, invalid_query_params_exception, "max_events_per_thread should be positive");
+    fc::trace::start(options.max_events_per_thread);
+    ilog("tracing started");
+}
+
+producer_plugin::trace_information
+producer_plugin::stop_tracing() {
+    fc::trace::stop();
+
+    auto dir = app().data_dir() / "traces";
+    if(!fc::exists(dir)) {
+        fc::create_directories(dir);
+    }
+
+    auto now        = fc::time_point::now().time_since_epoch().count();
+    auto trace_path = (dir / fc::format_string("trace-${t}.json", fc::mutable_variant_object()("t", now))).generic_string();
+
+    auto out    = std::ofstream(trace_path, std::ios::out);
+    auto events = fc::trace::export_json(out);
+    out.close();
+
+    ilog("tracing stopped, ${n} spans are written to ${f}", ("n", events)("f", trace_path));
+    return { trace_path, events };
+}
+
+producer_plugin::production_stats
+producer_plugin::get_production_stats() const {
+    static const char* stage_names[] = {"start_block", "incoming_trx", "retry_trx", "finalize", "sign", "commit"};
+    static_assert(sizeof(stage_names) / sizeof(stage_names[0]) == producer_plugin_impl::stage_count);
+
+    auto stats = production_stats();
+    for(auto i = 0u; i < producer_plugin_impl::stage_count; i++) {
+        auto& h = my->_stage_latency[i];
+        stats.stages.emplace_back(stage_latency {
+            stage_names[i], h.count(), h.sum(), h.max(),
+            h.percentile(0.5), h.percentile(0.9), h.percentile(0.99), h.power_buckets(4, 27)
+        });
+    }
+    stats.produced_blocks = my->_produced_blocks;
+    stats.total           = my->_total_block_counts;
+    stats.last_block      = my->_last_block_counts;
+
+    auto inflight                = my->chain_plug->get_inflight_transactions().stats();
+    stats.accepted_transactions  = inflight.accepted;
+    stats.duplicate_transactions = inflight.duplicates;
+    stats.inflight_transactions  = inflight.size;
+    return stats;
+}
+
+void
+producer_plugin::push_transactions(const std::vector<transaction_metadata_ptr>& trxs, next_function<transaction_trace_ptr> next) {
+    // applied from the queue when the next pending block starts, within its time budget
+    for(auto& trx : trxs) {
+        my->queue_incoming_transaction(trx, false, next);
+    }
+}
+
 optional<fc::time_point>
 producer_plugin_impl::calculate_next_block_time(const account_name& producer_name, const block_timestamp_type& current_block_time) const {
     chain::controller& chain           = chain_plug->chain();
     const auto&        hbs             = chain.head_block_state();
-    const auto&        active_schedule = hbs->active_schedule.producers;
+    const auto&        active_schedule = hbs->active_schedule->producers;
 
     const auto& pbs = chain.pending_block_state();
     const auto& pbt = pbs->header.timestamp;
@@ -1027,8 +1432,18 @@ producer_plugin_impl::start_block() {
     //Schedule for the next second's tick regardless of chain state
     // If we would wait less than 50ms (1/10 of block_interval), wait for the whole block interval.
     const fc::time_point now = fc::time_point::now();
-    const fc::time_point block_time = calculate_pending_block_time();
+    fc::time_point block_time = calculate_pending_block_time();
+
+    // when the next slot belongs to us and starts within the lead, build its block now instead of a speculative one
+    if(_prebuild_lead_us.count() > 0 && _producers.find(hbs->get_scheduled_producer(block_time).producer_name) == _producers.end()) {
+        auto next_block_time = block_time + fc::microseconds(config::block_interval_us);
+        if(next_block_time - now <= _prebuild_lead_us + fc::microseconds(config::block_interval_us)
+           && _producers.find(hbs->get_scheduled_producer(next_block_time).producer_name) != _producers.end()) {
+            block_time = next_block_time;
+        }
+    }
 
+    const auto prev_block_mode = _pending_block_mode;
     _pending_block_mode = pending_block_mode::producing;
 
     // Not our turn
@@ -1076,6 +1491,8 @@ producer_plugin_impl::start_block() {
         }
     }
 
+    auto start_timer = time_stage(stage_start_block);
+
     try {
         uint16_t blocks_to_confirm = 0;
 
@@ -1094,14 +1511,29 @@ producer_plugin_impl::start_block() {
             }
         }
 
-        chain.abort_block();
-        chain.start_block(block_time, blocks_to_confirm);
+        // a block already being built for this slot on the same head is kept, only new transactions are added to it
+        const auto& current_pbs = chain.pending_block_state();
+        if(current_pbs && prev_block_mode == pending_block_mode::producing && _pending_block_mode == pending_block_mode::producing
+           && current_pbs->header.previous == hbs->id && current_pbs->header.timestamp.to_time_point() == block_time
+           && current_pbs->header.confirmed == blocks_to_confirm) {
+            fc_dlog(_log, "Continuing block #${num} built on the same head", ("num", current_pbs->block_num));
+        }
+        else {
+            chain.abort_block();
+            chain.start_block(block_time, blocks_to_confirm);
+            _pending_block_counts = producer_plugin::block_transaction_counts();
+            _pending_block_cpu_us = fc::microseconds(0);
+            _pending_block_full   = false;
+        }
     }
     FC_LOG_AND_DROP();
 
     const auto& pbs = chain.pending_block_state();
     if(pbs) {
         const fc::time_point preprocess_deadline = calculate_block_deadline(block_time);
+        // polled between transactions instead of reading the clock
+        auto preprocess_timer = deadline_timer();
+        preprocess_timer.start(preprocess_deadline, fc::time_point::now());
         if(_pending_block_mode == pending_block_mode::producing && pbs->block_signing_key != scheduled_producer.block_signing_key) {
             elog("Block Signing Key is not expected value, reverting to speculative mode! [expected: \"${expected}\", actual: \"${actual}\"", 
                 ("expected", scheduled_producer.block_signing_key)("actual", pbs->block_signing_key));
@@ -1119,7 +1551,7 @@ producer_plugin_impl::start_block() {
             int orig_count             = _persistent_transactions.size();
 
             while(!persisted_by_expiry.empty() && persisted_by_expiry.begin()->expiry <= pbs->header.timestamp.to_time_point()) {
-                if(preprocess_deadline <= fc::time_point::now()) {
+                if(preprocess_timer.expired()) {
                     exhausted = true;
                     break;
                 }
@@ -1164,6 +1596,7 @@ producer_plugin_impl::start_block() {
                 // derive appliable transactions from unapplied_transactions and drop droppable transactions
                 unapplied_transactions_type& unapplied_trxs = chain.get_unapplied_transactions();
                 if(!unapplied_trxs.empty()) {
+                    auto retry_timer                    = time_stage(stage_retry_trx);
                     auto unapplied_trxs_size            = unapplied_trxs.size();
                     int  num_applied                    = 0;
                     int  num_failed                     = 0;
@@ -1185,7 +1618,7 @@ producer_plugin_impl::start_block() {
                         auto itr_next = itr;  // save off next since itr may be invalidated by loop
                         ++itr_next;
 
-                        if(preprocess_deadline <= fc::time_point::now()) {
+                        if(preprocess_timer.expired()) {
                             exhausted = true;
                         }
                         if(exhausted) {
@@ -1202,6 +1635,11 @@ producer_plugin_impl::start_block() {
                             continue;
                         }
                         else if(category == tx_category::PERSISTED || (category == tx_category::UNEXPIRED_UNPERSISTED && _pending_block_mode == pending_block_mode::producing)) {
+                            if(!fits_in_pending_block(trx)) {
+                                _pending_block_counts.deferred++;
+                                exhausted = true;
+                                break;
+                            }
                             ++num_processed;
 
                             try {
@@ -1211,22 +1649,27 @@ producer_plugin_impl::start_block() {
                                     deadline_is_subjective = true;
                                     deadline               = preprocess_deadline;
                                 }
+                                limit_to_fill_target(deadline, deadline_is_subjective);
 
                                 auto trace = chain.push_transaction(trx, deadline);
                                 if(trace->except) {
                                     if(failure_is_subjective(*trace->except, deadline_is_subjective)) {
+                                        _pending_block_counts.deferred++;
                                         exhausted = true;
                                         break;
                                     }
                                     else {
                                         // this failed our configured maximum transaction time, we don't want to replay it
+                                        blacklist_transaction(trx, *trace->except);
                                         // chain.plus_transactions can modify unapplied_trxs, so erase by id
                                         unapplied_trxs.erase(trx->signed_id);
                                         ++num_failed;
+                                        _pending_block_counts.failed++;
                                     }
                                 }
                                 else {
                                     ++num_applied;
+                                    on_transaction_applied(trace);
                                 }
                             }
                             catch(const guard_exception& e) {
@@ -1253,7 +1696,7 @@ producer_plugin_impl::start_block() {
                     int orig_count  = _blacklisted_transactions.size();
 
                     while(!blacklist_by_expiry.empty() && blacklist_by_expiry.begin()->expiry <= now) {
-                        if (preprocess_deadline <= fc::time_point::now()) break;
+                        if (preprocess_timer.expired()) break;
                         blacklist_by_expiry.erase(blacklist_by_expiry.begin());
                         num_expired++;
                     }
@@ -1263,20 +1706,24 @@ producer_plugin_impl::start_block() {
                 }
             }
 
-            if(exhausted || preprocess_deadline <= fc::time_point::now()) {
+            if(exhausted || preprocess_timer.expired()) {
                 return start_block_result::exhausted;
             }
             else {
                 // attempt to apply any pending incoming transactions
                 if(!_pending_incoming_transactions.empty()) {
                     fc_dlog(_log, "Processing ${n} pending transactions", ("n", _pending_incoming_transactions.size()));
-                    while(orig_pending_txn_size && _pending_incoming_transactions.size()) {
-                        if (preprocess_deadline <= fc::time_point::now()) return start_block_result::exhausted;
-                        auto e = _pending_incoming_transactions.front();
-                        _pending_incoming_transactions.pop_front();
+                    _pending_incoming_transactions.start_round();
+                    while(orig_pending_txn_size) {
+                        if (preprocess_timer.expired()) return start_block_result::exhausted;
+                        auto e = _pending_incoming_transactions.pop();
+                        if(!e.has_value()) {
+                            break;
+                        }
                         --orig_pending_txn_size;
-                        process_incoming_transaction_async(std::get<0>(e), std::get<1>(e), std::get<2>(e));
+                        process_incoming_transaction_async(e->trx, e->persist_until_expired, e->next);
                     }
+                    _pending_incoming_transactions.end_round();
                 }
                 return start_block_result::succeeded;
             }
@@ -1298,9 +1745,17 @@ void
 producer_plugin_impl::schedule_production_loop() {
     chain::controller& chain = chain_plug->chain();
     _timer.cancel();
+    if(_signing_block) {
+        // restarted once the block is signed
+        return;
+    }
     std::weak_ptr<producer_plugin_impl> weak_this = shared_from_this();
 
     auto result = start_block();
+    if(!_producers.empty()) {
+        // compactions of token database are deferred into the windows between the blocks of this node
+        chain.token_db().set_background_busy(result != start_block_result::failed && _pending_block_mode == pending_block_mode::producing);
+    }
 
     if(result == start_block_result::failed) {
         elog("Failed to start a pending block, will try again later");
@@ -1327,39 +1782,28 @@ producer_plugin_impl::schedule_production_loop() {
     }
     else if(_pending_block_mode == pending_block_mode::producing) {
         // we succeeded but block may be exhausted
-        static const boost::posix_time::ptime epoch(boost::gregorian::date(1970, 1, 1));
         auto deadline = calculate_block_deadline(chain.pending_block_time());
 
-        if(deadline > fc::time_point::now()) {
+        if(deadline > fc::time_point::now() && !_pending_block_full) {
             // ship this block off no later than its deadline
             EVT_ASSERT(chain.pending_block_state(), missing_pending_block_state, "producing without pending_block_state, start_block succeeded");
-            _timer.expires_at(epoch + boost::posix_time::microseconds( deadline.time_since_epoch().count()));
             fc_dlog(_log, "Scheduling Block Production on Normal Block #${num} for ${time}", ("num", chain.pending_block_state()->block_num)("time", deadline));
+            schedule_maybe_produce_block(deadline);
+            schedule_expired_trxs_sweep();
         }
         else {
             EVT_ASSERT(chain.pending_block_state(), missing_pending_block_state, "producing without pending_block_state");
             auto expect_time = chain.pending_block_time() - fc::microseconds(config::block_interval_us);
             // ship this block off up to 1 block time earlier or immediately
             if(fc::time_point::now() >= expect_time) {
-                _timer.expires_from_now(boost::posix_time::microseconds(0));
                 fc_dlog(_log, "Scheduling Block Production on Exhausted Block #${num} immediately", ("num", chain.pending_block_state()->block_num));
+                schedule_maybe_produce_block(fc::time_point::now());
             }
             else {
-                _timer.expires_at(epoch + boost::posix_time::microseconds(expect_time.time_since_epoch().count()));
                 fc_dlog(_log, "Scheduling Block Production on Exhausted Block #${num} at ${time}", ("num", chain.pending_block_state()->block_num)("time", expect_time));
+                schedule_maybe_produce_block(expect_time);
             }
         }
-
-        _timer.async_wait(app().get_priority_queue().wrap(priority::high,
-            [&chain, weak_this, cid = ++_timer_corelation_id](const boost::system::error_code& ec) {
-            auto self = weak_this.lock();
-            if(self && ec != boost::asio::error::operation_aborted && cid == self->_timer_corelation_id) {
-                // pending_block_state expected, but can't assert inside async_wait
-                auto block_num = chain.pending_block_state() ? chain.pending_block_state()->block_num : 0;
-                auto res       = self->maybe_produce_block();
-                fc_dlog(_log, "Producing Block #${num} returned: ${res}", ("num", block_num)("res", res));
-            }
-        }));
     }
     else if(_pending_block_mode == pending_block_mode::speculating && !_producers.empty() && !production_disabled_by_policy()) {
         fc_dlog(_log, "Specualtive Block Created; Scheduling Speculative/Production Change");
@@ -1380,6 +1824,10 @@ producer_plugin_impl::schedule_delayed_production_loop(const std::weak_ptr<produ
         auto next_producer_block_time = calculate_next_block_time(p, current_block_time);
         if(next_producer_block_time) {
             auto producer_wake_up_time = *next_producer_block_time - fc::microseconds(config::block_interval_us);
+            // waking earlier only helps once, a lead already passed would spin the loop
+            if(producer_wake_up_time - _prebuild_lead_us > fc::time_point::now()) {
+                producer_wake_up_time -= _prebuild_lead_us;
+            }
             if(wake_up_time) {
                 // wake up with a full block interval to the deadline
                 wake_up_time = std::min<fc::time_point>(*wake_up_time, producer_wake_up_time);
@@ -1406,6 +1854,44 @@ producer_plugin_impl::schedule_delayed_production_loop(const std::weak_ptr<produ
     }
 }
 
+void
+producer_plugin_impl::schedule_maybe_produce_block(const fc::time_point& at) {
+    static const boost::posix_time::ptime epoch(boost::gregorian::date(1970, 1, 1));
+    chain::controller& chain = chain_plug->chain();
+
+    _timer.expires_at(epoch + boost::posix_time::microseconds(at.time_since_epoch().count()));
+    _timer.async_wait(app().get_priority_queue().wrap(priority::high,
+        [&chain, weak_this = std::weak_ptr<producer_plugin_impl>(shared_from_this()), cid = ++_timer_corelation_id](const boost::system::error_code& ec) {
+        auto self = weak_this.lock();
+        if(self && ec != boost::asio::error::operation_aborted && cid == self->_timer_corelation_id) {
+            // pending_block_state expected, but can't assert inside async_wait
+            auto block_num = chain.pending_block_state() ? chain.pending_block_state()->block_num : 0;
+            auto res       = self->maybe_produce_block();
+            fc_dlog(_log, "Producing Block #${num} returned: ${res}", ("num", block_num)("res", res));
+        }
+    }));
+}
+
+void
+producer_plugin_impl::schedule_expired_trxs_sweep() {
+    // expired transactions left by the bounded cleanup at the start of block are swept here in
+    // small steps while waiting for the deadline, incoming transactions and blocks go first
+    const uint32_t rows_per_step = 500;
+
+    chain::controller& chain = chain_plug->chain();
+    app().post(priority::low, [&chain, weak_this = std::weak_ptr<producer_plugin_impl>(shared_from_this()),
+                               block_num = chain.pending_block_state()->block_num, rows_per_step] {
+        auto self = weak_this.lock();
+        if(!self || self->_pending_block_mode != pending_block_mode::producing
+           || !chain.pending_block_state() || chain.pending_block_state()->block_num != block_num) {
+            return;
+        }
+        if(chain.clear_expired_transactions(rows_per_step) == rows_per_step) {
+            self->schedule_expired_trxs_sweep();
+        }
+    });
+}
+
 bool
 producer_plugin_impl::maybe_produce_block() {
     auto reschedule = fc::make_scoped_exit([this] {
@@ -1414,7 +1900,10 @@ producer_plugin_impl::maybe_produce_block() {
 
     try {
         try {
-            produce_block();
+            if(produce_block()) {
+                // the loop goes on after the block is signed
+                reschedule.cancel();
+            }
             return true;
         }
         catch(const guard_exception& e) {
@@ -1456,7 +1945,8 @@ maybe_make_debug_time_logger() -> optional<decltype(make_debug_time_logger())> {
     }
 }
 
-void
+// returns true when the block is left to be signed in the signing pool
+bool
 producer_plugin_impl::produce_block() {
     EVT_ASSERT(_pending_block_mode == pending_block_mode::producing, producer_exception, "called produce_block while not actually producing");
 
@@ -1469,18 +1959,116 @@ producer_plugin_impl::produce_block() {
     EVT_ASSERT(signature_provider_itr != _signature_providers.end(), producer_priv_key_not_found, "Attempting to produce a block for which we don't have the private key");
 
     //idump( (fc::time_point::now() - chain.pending_block_time()) );
-    chain.finalize_block();
-    chain.sign_block([&](const digest_type& d) {
-        auto debug_logger = maybe_make_debug_time_logger();
-        return signature_provider_itr->second(d);
+    {
+        auto timer = time_stage(stage_finalize);
+        chain.finalize_block();
+    }
+
+    if(_signing_pool.has_value()) {
+        _signing_block = pbs;
+        boost::asio::post(*_signing_pool, [weak_this = std::weak_ptr<producer_plugin_impl>(shared_from_this()), bs = _signing_block,
+                                           digest = _signing_block->sig_digest(), signer = signature_provider_itr->second] {
+            auto result = fc::static_variant<fc::exception_ptr, signature_type>();
+            auto start  = fc::time_point::now();
+            try {
+                auto debug_logger = maybe_make_debug_time_logger();
+                result = signer(digest);
+            }
+            CATCH_AND_CALL([&result](const fc::exception_ptr& e) { result = e; });
+
+            app().post(priority::high, [weak_this, bs, result, elapsed = fc::time_point::now() - start] {
+                if(auto self = weak_this.lock()) {
+                    self->on_block_signed(bs, result, elapsed);
+                }
+            });
+        });
+        return true;
+    }
+
+    {
+        auto timer = time_stage(stage_sign);
+        chain.sign_block([&](const digest_type& d) {
+            auto debug_logger = maybe_make_debug_time_logger();
+            return signature_provider_itr->second(d);
+        });
+    }
+    {
+        auto timer = time_stage(stage_commit);
+        chain.commit_block();
+    }
+    on_block_produced();
+    return false;
+}
+
+void
+producer_plugin_impl::on_block_signed(const block_state_ptr& bs, const fc::static_variant<fc::exception_ptr, signature_type>& result, fc::microseconds elapsed) {
+    if(_signing_block != bs) {
+        // dropped along with the pending block, whoever aborted it restarted the loop
+        return;
+    }
+    _signing_block.reset();
+
+    auto reschedule = fc::make_scoped_exit([this] {
+        schedule_production_loop();
     });
-    chain.commit_block();
+
+    chain::controller& chain = chain_plug->chain();
+    if(chain.pending_block_state() != bs) {
+        return;
+    }
+
+    try {
+        try {
+            if(result.contains<fc::exception_ptr>()) {
+                result.get<fc::exception_ptr>()->dynamic_rethrow_exception();
+            }
+            // the signee is checked against the signing key, a bad signature aborts the block
+            _stage_latency[stage_sign].record(elapsed);
+            chain.sign_block([&](const digest_type&) {
+                return result.get<signature_type>();
+            });
+            {
+                auto timer = time_stage(stage_commit);
+                chain.commit_block();
+            }
+            on_block_produced();
+            return;
+        }
+        catch(const guard_exception& e) {
+            chain_plug->handle_guard_exception(e);
+        }
+        FC_LOG_AND_DROP();
+    }
+    catch(boost::interprocess::bad_alloc&) {
+        raise(SIGUSR1);
+    }
+    catch(fc::unrecoverable_exception&) {
+        raise(SIGUSR1);
+    }
+
+    fc_dlog(_log, "Aborting block due to signing error");
+    chain.abort_block();
+}
+
+void
+producer_plugin_impl::on_block_produced() {
+    chain::controller& chain = chain_plug->chain();
+
     auto hbt [[maybe_unused]] = chain.head_block_time();
     //idump((fc::time_point::now() - hbt));
 
     block_state_ptr new_bs = chain.head_block_state();
     _producer_watermarks[new_bs->header.producer] = chain.head_block_num();
 
+    _pending_block_counts.block_num = new_bs->block_num;
+    _last_block_counts              = _pending_block_counts;
+    _total_block_counts.block_num   = new_bs->block_num;
+    _total_block_counts.applied    += _pending_block_counts.applied;
+    _total_block_counts.failed     += _pending_block_counts.failed;
+    _total_block_counts.deferred   += _pending_block_counts.deferred;
+    _pending_block_counts           = producer_plugin::block_transaction_counts();
+    _produced_blocks++;
+
     ilog("Produced block ${id}... #${n} @ ${t} signed by ${p} [trxs: ${count}, lib: ${lib}, confirmed: ${confs}]",
          ("p", new_bs->header.producer)
          ("id", fc::variant(new_bs->id).as_string().substr(0, 16))
@@ -0,0 +1,163 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#include <evt/producer_plugin/remote_signer.hpp>
+
+#include <fc/log/logger.hpp>
+#include <fc/variant_object.hpp>
+
+namespace evt {
+
+namespace __internal {
+
+// the same evtwd lists its wallets next to sign_digest, cheap and touching no key
+fc::url
+make_ping_url(const fc::url& url) {
+    auto str = (std::string)url;
+    auto pos = str.rfind('/');
+    return fc::url(str.substr(0, pos + 1) + "list_wallets");
+}
+
+}  // namespace __internal
+
+using namespace __internal;
+
+remote_signer::remote_signer(const fc::url& url, const chain::public_key_type& key, const config_type& config,
+                             client_factory factory, std::optional<chain::private_key_type> fallback)
+    : url_(url)
+    , ping_url_(make_ping_url(url))
+    , key_(key)
+    , config_(config)
+    , factory_(std::move(factory))
+    , fallback_(std::move(fallback)) {}
+
+remote_signer::~remote_signer() {
+    stop();
+}
+
+std::unique_ptr<fc::http_client>
+remote_signer::acquire() {
+    {
+        auto lock = std::lock_guard(mtx_);
+        if(!idle_.empty()) {
+            auto client = std::move(idle_.back());
+            idle_.pop_back();
+            return client;
+        }
+    }
+    // all busy, a new connection is better than waiting
+    return factory_();
+}
+
+void
+remote_signer::release(std::unique_ptr<fc::http_client> client) {
+    auto lock = std::lock_guard(mtx_);
+    if(idle_.size() < config_.connections) {
+        idle_.emplace_back(std::move(client));
+    }
+}
+
+chain::signature_type
+remote_signer::sign(const chain::digest_type& digest) {
+    auto client   = acquire();
+    auto deadline = config_.timeout.count() >= 0 ? fc::time_point::now() + config_.timeout : fc::time_point::maximum();
+
+    try {
+        auto params = fc::variant();
+        fc::to_variant(std::make_pair(digest, key_), params);
+
+        auto sig = client->post_sync(url_, params, deadline).as<chain::signature_type>();
+        release(std::move(client));
+        return sig;
+    }
+    catch(const fc::exception& e) {
+        // a failed request drops its connection, the client itself is still fine
+        release(std::move(client));
+        if(!fallback_.has_value()) {
+            throw;
+        }
+        wlog("Signing with evtwd ${url} failed, signed with the fallback key: ${e}", ("url", (std::string)url_)("e", e.to_string()));
+    }
+    return fallback_->sign(digest);
+}
+
+bool
+remote_signer::ping(fc::http_client& client) {
+    try {
+        auto deadline = config_.timeout.count() >= 0 ? fc::time_point::now() + config_.timeout : fc::time_point::maximum();
+        client.post_sync(ping_url_, fc::variant(fc::variant_object()), deadline);
+        return true;
+    }
+    catch(const fc::exception& e) {
+        dlog("Keepalive to evtwd ${url} failed: ${e}", ("url", (std::string)ping_url_)("e", e.to_string()));
+        return false;
+    }
+}
+
+void
+remote_signer::start() {
+    if(keepalive_thread_.joinable()) {
+        return;
+    }
+    stopping_         = false;
+    keepalive_thread_ = std::thread([this] { keepalive_loop(); });
+}
+
+void
+remote_signer::stop() {
+    {
+        auto lock = std::lock_guard(mtx_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    if(keepalive_thread_.joinable()) {
+        keepalive_thread_.join();
+    }
+}
+
+void
+remote_signer::keepalive_loop() {
+    // warm up: open all the connections before the first block needs one
+    for(auto i = 0u; i < config_.connections; i++) {
+        {
+            auto lock = std::lock_guard(mtx_);
+            if(stopping_) {
+                return;
+            }
+        }
+        auto client = factory_();
+        ping(*client);
+        release(std::move(client));
+    }
+
+    if(config_.keepalive.count() <= 0) {
+        return;
+    }
+    for(;;) {
+        auto n = size_t(0);
+        {
+            auto lock = std::unique_lock(mtx_);
+            if(cv_.wait_for(lock, std::chrono::microseconds(config_.keepalive.count()), [this] { return stopping_; })) {
+                return;
+            }
+            n = idle_.size();
+        }
+        // only the idle ones, one at a time, so signing always finds the others free
+        for(auto i = 0u; i < n; i++) {
+            auto client = std::unique_ptr<fc::http_client>();
+            {
+                auto lock = std::lock_guard(mtx_);
+                if(stopping_ || idle_.empty()) {
+                    break;
+                }
+                client = std::move(idle_.front());
+                idle_.erase(idle_.begin());
+            }
+            ping(*client);
+            release(std::move(client));
+        }
+    }
+}
+
+}  // namespace evt
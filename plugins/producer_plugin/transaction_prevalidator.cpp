@@ -0,0 +1,79 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#include <evt/producer_plugin/transaction_prevalidator.hpp>
+
+#include <evt/chain/block_summary_object.hpp>
+#include <evt/chain/config.hpp>
+#include <evt/chain/exceptions.hpp>
+#include <evt/chain/global_property_object.hpp>
+
+namespace evt {
+
+using namespace evt::chain;
+
+void
+transaction_prevalidator::load(const controller& chain) {
+    for(auto i = 0u; i < tapos_prefixes_.size(); i++) {
+        auto& bs = chain.db().get<block_summary_object>((uint16_t)i);
+        tapos_prefixes_[i].store((uint32_t)bs.block_id._hash[1], std::memory_order_relaxed);
+    }
+    std::atomic_store(&config_, std::make_shared<const chain_config>(chain.get_global_properties().configuration));
+    head_block_time_us_.store(chain.head_block_time().time_since_epoch().count(), std::memory_order_release);
+}
+
+void
+transaction_prevalidator::on_block(const controller& chain, const block_state_ptr& bsp) {
+    // the same entry the chain writes in its block summary
+    tapos_prefixes_[bsp->block_num & 0xffff].store((uint32_t)bsp->id._hash[1], std::memory_order_relaxed);
+
+    auto& cfg = chain.get_global_properties().configuration;
+    if(!(*std::atomic_load(&config_) == cfg)) {
+        std::atomic_store(&config_, std::make_shared<const chain_config>(cfg));
+    }
+    head_block_time_us_.store(bsp->header.timestamp.to_time_point().time_since_epoch().count(), std::memory_order_release);
+}
+
+fc::exception_ptr
+transaction_prevalidator::check(const transaction_metadata& mtrx) const {
+    auto cfg = std::atomic_load(&config_);
+    if(!cfg) {
+        return nullptr;
+    }
+
+    auto& ptrx = *mtrx.packed_trx;
+    auto& trx  = ptrx.get_transaction();
+
+    if(trx.actions.empty()) {
+        return std::make_shared<tx_no_action>(FC_LOG_MESSAGE(error, "There isn't any actions in this transaction"));
+    }
+
+    auto size = ptrx.get_unprunable_size() + ptrx.get_prunable_size();
+    if(size >= cfg->max_transaction_net_usage) {
+        return std::make_shared<tx_net_usage_exceeded>(FC_LOG_MESSAGE(error, "transaction net usage is too high: ${net_usage} > ${net_limit}",
+            ("net_usage", size)("net_limit", cfg->max_transaction_net_usage)));
+    }
+
+    auto expiration = fc::time_point(trx.expiration);
+    auto head_time  = fc::time_point(fc::microseconds(head_block_time_us_.load(std::memory_order_acquire)));
+    if(expiration < head_time) {
+        return std::make_shared<expired_tx_exception>(FC_LOG_MESSAGE(error, "transaction has expired, expiration is ${exp} and head block time is ${head}",
+            ("exp", trx.expiration)("head", head_time)));
+    }
+    auto latest_time = fc::time_point::now() + fc::microseconds(2 * config::block_interval_us);
+    if(expiration > latest_time + fc::seconds(cfg->max_transaction_lifetime)) {
+        return std::make_shared<tx_exp_too_far_exception>(FC_LOG_MESSAGE(error, "Transaction expiration is too far in the future, "
+            "expiration is ${exp} and the maximum transaction lifetime is ${max_til_exp} seconds",
+            ("exp", trx.expiration)("max_til_exp", cfg->max_transaction_lifetime)));
+    }
+
+    if(tapos_prefixes_[trx.ref_block_num].load(std::memory_order_relaxed) != trx.ref_block_prefix) {
+        return std::make_shared<invalid_ref_block_exception>(FC_LOG_MESSAGE(error, "Transaction's reference block did not match. Is this transaction from a different fork?",
+            ("ref_block_num", trx.ref_block_num)("ref_block_prefix", trx.ref_block_prefix)));
+    }
+
+    return nullptr;
+}
+
+}  // namespace evt
@@ -0,0 +1,47 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+#include <appbase/application.hpp>
+#include <boost/asio/io_context.hpp>
+
+namespace evt {
+using namespace appbase;
+
+/**
+ * Shared pool of I/O reactors for the network plugins
+ *
+ * Each reactor is an `io_context` run by a single thread, optionally pinned to a
+ * CPU, so the handlers of one reactor never run concurrently. Plugins take the
+ * reactors they need with `next()` instead of starting threads of their own.
+ * With `reactor-threads` set to 0 the pool is disabled and every plugin keeps
+ * running its own threads.
+ */
+class reactor_plugin : public appbase::plugin<reactor_plugin> {
+public:
+    using ioc_ptr = std::shared_ptr<boost::asio::io_context>;
+
+public:
+    reactor_plugin();
+    virtual ~reactor_plugin();
+
+    APPBASE_PLUGIN_REQUIRES()
+    virtual void set_program_options(options_description&, options_description& cfg) override;
+
+    void plugin_initialize(const variables_map& options);
+    void plugin_startup();
+    void plugin_shutdown();
+
+    bool   enabled() const;
+    size_t size() const;
+
+    /** next reactor in round robin order, available from `plugin_initialize` on */
+    ioc_ptr next();
+    ioc_ptr at(size_t i) const;
+
+private:
+    std::unique_ptr<class reactor_plugin_impl> my;
+};
+
+}  // namespace evt
@@ -0,0 +1,133 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#include <evt/reactor_plugin/reactor_plugin.hpp>
+
+#include <atomic>
+#include <thread>
+#include <boost/asio/executor_work_guard.hpp>
+#if defined(__linux__)
+#include <pthread.h>
+#endif
+
+#include <fc/log/logger.hpp>
+#include <evt/chain/exceptions.hpp>
+
+namespace evt {
+
+static appbase::abstract_plugin& _reactor_plugin = app().register_plugin<reactor_plugin>();
+
+using io_work_t = boost::asio::executor_work_guard<boost::asio::io_context::executor_type>;
+
+class reactor_plugin_impl {
+public:
+    void
+    pin_thread(size_t i) {
+        if(cpus.empty()) {
+            return;
+        }
+        auto cpu = cpus[i % cpus.size()];
+#if defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        if(pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) {
+            wlog("failed to pin reactor ${i} to cpu ${c}", ("i", i)("c", cpu));
+        }
+#else
+        wlog("reactor-cpu-affinity is not supported on this platform, reactor ${i} is not pinned to cpu ${c}", ("i", i)("c", cpu));
+#endif
+    }
+
+public:
+    std::vector<reactor_plugin::ioc_ptr> reactors;
+    std::vector<io_work_t>               works;
+    std::vector<std::thread>             threads;
+    std::vector<uint32_t>                cpus;
+    std::atomic<size_t>                  next_reactor{0};
+};
+
+reactor_plugin::reactor_plugin()
+    : my(new reactor_plugin_impl()) {}
+reactor_plugin::~reactor_plugin() {}
+
+void
+reactor_plugin::set_program_options(options_description&, options_description& cfg) {
+    cfg.add_options()
+        ("reactor-threads", bpo::value<uint16_t>()->default_value(0), "Number of I/O reactor threads shared by http_plugin, net_plugin and bnet_plugin, 0 to let each plugin run its own threads")
+        ("reactor-cpu-affinity", bpo::value<vector<uint32_t>>()->composing()->multitoken(), "CPUs the reactor threads are pinned to in turn, leave empty to not pin them")
+        ;
+}
+
+void
+reactor_plugin::plugin_initialize(const variables_map& options) {
+    try {
+        auto threads = options.at("reactor-threads").as<uint16_t>();
+        if(options.count("reactor-cpu-affinity")) {
+            my->cpus = options.at("reactor-cpu-affinity").as<vector<uint32_t>>();
+            EVT_ASSERT(threads > 0 || my->cpus.empty(), chain::plugin_config_exception,
+                       "reactor-cpu-affinity requires reactor-threads to be greater than 0");
+        }
+
+        // created here so plugins can take them while they are initialized
+        for(auto i = 0u; i < threads; i++) {
+            auto ioc = std::make_shared<boost::asio::io_context>(1);
+            my->works.emplace_back(boost::asio::make_work_guard(*ioc));
+            my->reactors.emplace_back(std::move(ioc));
+        }
+    }
+    FC_LOG_AND_RETHROW()
+}
+
+void
+reactor_plugin::plugin_startup() {
+    for(auto i = 0u; i < my->reactors.size(); i++) {
+        my->threads.emplace_back([this, i, ioc = my->reactors[i]] {
+            my->pin_thread(i);
+            ioc->run();
+        });
+    }
+    if(!my->reactors.empty()) {
+        ilog("started ${n} reactor threads", ("n", my->reactors.size()));
+    }
+}
+
+void
+reactor_plugin::plugin_shutdown() {
+    // the plugins using the reactors are shut down already, let them finish what they posted
+    for(auto& w : my->works) {
+        w.reset();
+    }
+    for(auto& ioc : my->reactors) {
+        ioc->stop();
+    }
+    for(auto& t : my->threads) {
+        t.join();
+    }
+    my->threads.clear();
+}
+
+bool
+reactor_plugin::enabled() const {
+    return !my->reactors.empty();
+}
+
+size_t
+reactor_plugin::size() const {
+    return my->reactors.size();
+}
+
+reactor_plugin::ioc_ptr
+reactor_plugin::next() {
+    EVT_ASSERT(enabled(), chain::plugin_exception, "reactor pool is disabled");
+    return my->reactors[my->next_reactor++ % my->reactors.size()];
+}
+
+reactor_plugin::ioc_ptr
+reactor_plugin::at(size_t i) const {
+    EVT_ASSERT(i < my->reactors.size(), chain::plugin_exception, "reactor ${i} doesn't exist", ("i", i));
+    return my->reactors[i];
+}
+
+}  // namespace evt
@@ -0,0 +1,80 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+#include <atomic>
+#include <string>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+namespace evt {
+
+/**
+ * Ring of records in a memory mapped file, written by evtd and read by local processes.
+ *
+ * The file is a shm_ring_header followed by `capacity` bytes. Each record is a uint32 size,
+ * a uint8 kind and the payload, padded to 8 bytes. A record which does not fit before the
+ * end starts over at offset 0, behind a wrap marker when there is room for one.
+ *
+ * `head` counts all the bytes ever written and moves once a record is complete, `reserve`
+ * moves before the writer touches any byte. A reader copies the record at its position
+ * and drops the copy when `reserve` has gone more than `capacity` past it meanwhile.
+ */
+struct shm_ring_header {
+    static constexpr uint64_t magic_value = 0x474e495254564521;  // "!EVTRING"
+    static constexpr uint32_t wrap_marker = 0xFFFFFFFF;
+
+    uint64_t              magic;
+    uint64_t              capacity;
+    std::atomic<uint64_t> head;
+    std::atomic<uint64_t> reserve;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free);
+
+enum class shm_record_kind : uint8_t {
+    block        = 1,  // raw signed_block
+    irreversible = 2,  // raw block number and block id
+    trace        = 3   // raw transaction_trace
+};
+
+class shm_ring_writer {
+public:
+    // creates or truncates the file, capacity is rounded up to 8 bytes
+    shm_ring_writer(const std::string& path, uint64_t capacity);
+
+public:
+    // returns false when the record is too large for the ring
+    bool write(shm_record_kind kind, const char* data, size_t size);
+
+private:
+    boost::interprocess::file_mapping  file_;
+    boost::interprocess::mapped_region region_;
+    shm_ring_header*                   header_;
+    char*                              data_;
+};
+
+class shm_ring_reader {
+public:
+    enum read_result { ok, empty, lagged };
+
+public:
+    // starts reading at the current head
+    explicit shm_ring_reader(const std::string& path);
+
+public:
+    // lagged means records were overwritten before being read, reading goes on from the head
+    read_result read(shm_record_kind& kind, std::string& payload);
+
+    uint64_t position() const { return pos_; }
+
+private:
+    boost::interprocess::file_mapping  file_;
+    boost::interprocess::mapped_region region_;
+    const shm_ring_header*             header_;
+    const char*                        data_;
+    uint64_t                           pos_ = 0;
+};
+
+}  // namespace evt
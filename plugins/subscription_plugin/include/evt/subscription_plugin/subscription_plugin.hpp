@@ -0,0 +1,42 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+
+#include <evt/chain_plugin/chain_plugin.hpp>
+#include <evt/http_plugin/http_plugin.hpp>
+
+#include <appbase/application.hpp>
+
+namespace evt {
+
+using namespace appbase;
+
+/**
+ *  Pushes accepted blocks, irreversible blocks and filtered transaction traces
+ *  to the clients subscribed over the websocket endpoint /v1/subscribe, and
+ *  optionally streams all of them to local readers through a shm_ring
+ */
+class subscription_plugin : public plugin<subscription_plugin> {
+public:
+    APPBASE_PLUGIN_REQUIRES((chain_plugin)(http_plugin))
+
+    subscription_plugin();
+    subscription_plugin(const subscription_plugin&) = delete;
+    subscription_plugin(subscription_plugin&&)      = delete;
+    subscription_plugin& operator=(const subscription_plugin&) = delete;
+    subscription_plugin& operator=(subscription_plugin&&) = delete;
+    virtual ~subscription_plugin();
+
+    virtual void set_program_options(options_description& cli, options_description& cfg) override;
+
+    void plugin_initialize(const variables_map& vm);
+    void plugin_startup();
+    void plugin_shutdown();
+
+private:
+    std::unique_ptr<class subscription_plugin_impl> my_;
+};
+
+}  // namespace evt
@@ -0,0 +1,143 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#include <evt/subscription_plugin/shm_ring.hpp>
+
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <boost/filesystem.hpp>
+
+#include <fc/exception/exception.hpp>
+
+namespace evt {
+
+namespace bip = boost::interprocess;
+
+namespace __internal {
+
+constexpr size_t record_header_size = sizeof(uint32_t) + sizeof(uint8_t);
+
+uint64_t
+record_size(size_t payload_size) {
+    return (record_header_size + payload_size + 7) & ~7ull;
+}
+
+bip::file_mapping
+create_file(const std::string& path, uint64_t size) {
+    {
+        auto fs = std::ofstream(path, std::ios::out | std::ios::binary | std::ios::trunc);
+        FC_ASSERT(fs.good(), "Cannot create shared memory ring: ${p}", ("p", path));
+    }
+    boost::filesystem::resize_file(path, size);
+    return bip::file_mapping(path.c_str(), bip::read_write);
+}
+
+}  // namespace __internal
+
+using namespace __internal;
+
+shm_ring_writer::shm_ring_writer(const std::string& path, uint64_t capacity)
+    : file_(create_file(path, sizeof(shm_ring_header) + ((capacity + 7) & ~7ull)))
+    , region_(file_, bip::read_write) {
+    header_ = new (region_.get_address()) shm_ring_header();
+    data_   = (char*)region_.get_address() + sizeof(shm_ring_header);
+
+    header_->capacity = (capacity + 7) & ~7ull;
+    header_->head.store(0);
+    header_->reserve.store(0);
+    // magic goes last so readers never see a half initialized header
+    std::atomic_thread_fence(std::memory_order_release);
+    header_->magic = shm_ring_header::magic_value;
+}
+
+bool
+shm_ring_writer::write(shm_record_kind kind, const char* data, size_t size) {
+    auto cap = header_->capacity;
+    auto len = record_size(size);
+    if(len > cap) {
+        return false;
+    }
+
+    auto head = header_->head.load(std::memory_order_relaxed);
+    auto off  = head % cap;
+    auto skip = (cap - off < len) ? cap - off : 0;
+
+    header_->reserve.store(head + skip + len, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    if(skip > 0) {
+        // offset is 8 bytes aligned, so there is always room for the marker
+        auto marker = shm_ring_header::wrap_marker;
+        memcpy(data_ + off, &marker, sizeof(marker));
+        head += skip;
+        off = 0;
+    }
+
+    auto size32 = (uint32_t)size;
+    memcpy(data_ + off, &size32, sizeof(size32));
+    data_[off + sizeof(size32)] = (char)kind;
+    memcpy(data_ + off + record_header_size, data, size);
+
+    header_->head.store(head + len, std::memory_order_release);
+    return true;
+}
+
+shm_ring_reader::shm_ring_reader(const std::string& path)
+    : file_(path.c_str(), bip::read_only)
+    , region_(file_, bip::read_only) {
+    header_ = (const shm_ring_header*)region_.get_address();
+    data_   = (const char*)region_.get_address() + sizeof(shm_ring_header);
+
+    FC_ASSERT(header_->magic == shm_ring_header::magic_value, "Not a shared memory ring: ${p}", ("p", path));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    FC_ASSERT(region_.get_size() >= sizeof(shm_ring_header) + header_->capacity, "Truncated shared memory ring: ${p}", ("p", path));
+
+    pos_ = header_->head.load(std::memory_order_acquire);
+}
+
+shm_ring_reader::read_result
+shm_ring_reader::read(shm_record_kind& kind, std::string& payload) {
+    auto cap = header_->capacity;
+    for(;;) {
+        auto head = header_->head.load(std::memory_order_acquire);
+        // the writer restarted or went a whole ring past us
+        if(pos_ > head || head - pos_ > cap) {
+            pos_ = head;
+            return lagged;
+        }
+        if(pos_ == head) {
+            return empty;
+        }
+
+        auto off  = pos_ % cap;
+        // offsets are 8 bytes aligned, the size always fits before the end
+        auto size = uint32_t();
+        memcpy(&size, data_ + off, sizeof(size));
+
+        auto len = uint64_t(0);
+        if(size == shm_ring_header::wrap_marker || record_size(size) > cap - off) {
+            // either a marker or a torn read, which the check below tells apart
+            len = cap - off;
+        }
+        else {
+            kind = (shm_record_kind)data_[off + sizeof(size)];
+            payload.assign(data_ + off + record_header_size, size);
+            len = record_size(size);
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if(header_->reserve.load(std::memory_order_relaxed) - pos_ > cap) {
+            pos_ = header_->head.load(std::memory_order_acquire);
+            return lagged;
+        }
+
+        pos_ += len;
+        if(size != shm_ring_header::wrap_marker && record_size(size) <= cap - off) {
+            return ok;
+        }
+    }
+}
+
+}  // namespace evt
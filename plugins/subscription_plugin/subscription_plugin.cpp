@@ -0,0 +1,501 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#include <evt/subscription_plugin/subscription_plugin.hpp>
+#include <evt/subscription_plugin/shm_ring.hpp>
+
+#include <set>
+#include <unordered_map>
+#include <boost/filesystem.hpp>
+#include <boost/signals2/connection.hpp>
+
+#include <fc/io/json.hpp>
+#include <fc/io/json_writer.hpp>
+#include <fc/io/raw.hpp>
+#include <fc/variant_object.hpp>
+
+#include <evt/chain/block_state.hpp>
+#include <evt/chain/exceptions.hpp>
+#include <evt/chain/trace.hpp>
+#include <evt/chain/types.hpp>
+
+namespace evt {
+
+static appbase::abstract_plugin& _subscription_plugin = app().register_plugin<subscription_plugin>();
+
+using namespace evt::chain;
+using boost::signals2::scoped_connection;
+
+namespace __internal {
+
+// all the non-empty sets must match, an empty filter matches every transaction
+struct trace_filter {
+    std::set<action_name>    actions;
+    std::set<domain_name>    domains;
+    std::set<symbol_id_type> sym_ids;
+    std::set<std::string>    addresses;
+
+    bool empty() const { return actions.empty() && domains.empty() && sym_ids.empty() && addresses.empty(); }
+};
+
+struct subscribe_request {
+    std::optional<std::string>  subscribe;
+    std::optional<std::string>  unsubscribe;
+    std::optional<trace_filter> filter;
+};
+
+struct subscriber {
+    bool                        blocks       = false;
+    bool                        irreversible = false;
+    std::optional<trace_filter> traces;
+
+    uint64_t       dropped = 0;     // frames dropped since the client fell behind
+    fc::time_point lagging_since;
+};
+
+}  // namespace __internal
+
+}  // namespace evt
+
+FC_REFLECT(evt::__internal::trace_filter, (actions)(domains)(sym_ids)(addresses));
+FC_REFLECT(evt::__internal::subscribe_request, (subscribe)(unsubscribe)(filter));
+
+namespace evt {
+
+using namespace __internal;
+
+class subscription_plugin_impl {
+public:
+    subscription_plugin_impl(controller& db, http_plugin& http)
+        : db_(db)
+        , http_(http) {}
+
+public:
+    void on_open(ws_connection_id id);
+    void on_message(ws_connection_id id, std::string&& msg);
+    void on_close(ws_connection_id id);
+
+    void applied_transaction(const transaction_trace_ptr& trace);
+    void accepted_block(const block_state_ptr& bs);
+    void irreversible_block(const block_state_ptr& bs);
+
+private:
+    void emit_trace(const transaction_trace_ptr& trace);
+    bool match(const trace_filter& filter, const transaction_trace& trace, const fc::variant& var) const;
+    void send(ws_connection_id id, subscriber& s, const std::string& frame);
+    void send_reply(ws_connection_id id, const char* type, const std::string& message);
+    void close_slow_consumers();
+    void write_ring(shm_record_kind kind, const std::vector<char>& data);
+
+    bool has_trace_subscribers() const;
+    bool wants_traces() const { return ring_.has_value() || has_trace_subscribers(); }
+
+public:
+    controller&  db_;
+    http_plugin& http_;
+
+    size_t           max_buffered_ = 0;
+    fc::microseconds slow_timeout_;
+    uint32_t         max_connections_ = 0;
+
+    std::unordered_map<ws_connection_id, subscriber> subscribers_;
+    std::vector<ws_connection_id>                    slow_consumers_;
+
+    // every block, irreversible block and trace also goes to the ring when it is enabled
+    std::optional<shm_ring_writer> ring_;
+
+    // traces of the pending block, emitted in block order once the block is accepted
+    std::unordered_map<transaction_id_type, transaction_trace_ptr> pending_traces_;
+
+    std::optional<utilities::scoped_signal_connection> applied_transaction_connection_;
+    std::optional<utilities::scoped_signal_connection> accepted_block_connection_;
+    std::optional<scoped_connection>                    irreversible_block_connection_;
+};
+
+void
+subscription_plugin_impl::on_open(ws_connection_id id) {
+    if(max_connections_ > 0 && subscribers_.size() >= max_connections_) {
+        http_.ws_close(id, "Too many subscribers");
+        return;
+    }
+    subscribers_.emplace(id, subscriber());
+}
+
+void
+subscription_plugin_impl::on_message(ws_connection_id id, std::string&& msg) {
+    auto it = subscribers_.find(id);
+    if(it == subscribers_.end()) {
+        return;
+    }
+    auto& s = it->second;
+
+    auto req = subscribe_request();
+    try {
+        fc::from_variant(fc::json::from_string(msg), req);
+    }
+    catch(const fc::exception& e) {
+        send_reply(id, "error", e.to_string());
+        return;
+    }
+    catch(const std::exception& e) {
+        send_reply(id, "error", e.what());
+        return;
+    }
+
+    auto subscribe = req.subscribe.has_value();
+    auto channel   = subscribe ? *req.subscribe : req.unsubscribe.value_or("");
+    if(channel == "blocks") {
+        s.blocks = subscribe;
+    }
+    else if(channel == "irreversible") {
+        s.irreversible = subscribe;
+    }
+    else if(channel == "traces") {
+        if(subscribe) {
+            s.traces = req.filter.value_or(trace_filter());
+        }
+        else {
+            s.traces.reset();
+            if(!wants_traces()) {
+                pending_traces_.clear();
+            }
+        }
+    }
+    else {
+        send_reply(id, "error", "Unknown channel: " + channel);
+        return;
+    }
+    send_reply(id, subscribe ? "subscribed" : "unsubscribed", channel);
+}
+
+void
+subscription_plugin_impl::on_close(ws_connection_id id) {
+    subscribers_.erase(id);
+    if(!wants_traces()) {
+        pending_traces_.clear();
+    }
+}
+
+bool
+subscription_plugin_impl::has_trace_subscribers() const {
+    for(auto& it : subscribers_) {
+        if(it.second.traces.has_value()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void
+subscription_plugin_impl::applied_transaction(const transaction_trace_ptr& trace) {
+    if(!trace->receipt.has_value()) {
+        return;
+    }
+    auto status = trace->receipt->status;
+    if(status != transaction_receipt_header::executed && status != transaction_receipt_header::soft_fail) {
+        return;
+    }
+    if(!wants_traces()) {
+        return;
+    }
+    // a transaction applied again after its speculative block was dropped replaces the old trace
+    pending_traces_[trace->id] = trace;
+}
+
+void
+subscription_plugin_impl::accepted_block(const block_state_ptr& bs) {
+    auto& block = *bs->block;
+
+    if(ring_.has_value()) {
+        write_ring(shm_record_kind::block, fc::raw::pack(block));
+    }
+    if(!pending_traces_.empty()) {
+        for(auto& receipt : block.transactions) {
+            auto it = pending_traces_.find(receipt.trx.id());
+            if(it != pending_traces_.end()) {
+                emit_trace(it->second);
+            }
+        }
+        pending_traces_.clear();
+    }
+
+    auto frame = std::string();
+    for(auto& it : subscribers_) {
+        if(!it.second.blocks) {
+            continue;
+        }
+        if(frame.empty()) {
+            auto w = fc::json_writer();
+            w.begin_object();
+            w.write_member("type", "block");
+            w.key("data");
+            w.begin_object();
+            w.write_member("block_num", bs->block_num);
+            w.write_member("id", bs->id);
+            w.write_member("previous", block.previous);
+            w.write_member("timestamp", block.timestamp);
+            w.write_member("producer", block.producer);
+            w.key("transactions");
+            w.begin_array();
+            for(auto& receipt : block.transactions) {
+                w.write(receipt.trx.id());
+            }
+            w.end_array();
+            w.end_object();
+            w.end_object();
+            frame = w.release();
+        }
+        send(it.first, it.second, frame);
+    }
+    close_slow_consumers();
+}
+
+void
+subscription_plugin_impl::irreversible_block(const block_state_ptr& bs) {
+    if(ring_.has_value()) {
+        write_ring(shm_record_kind::irreversible, fc::raw::pack(std::make_pair(bs->block_num, bs->id)));
+    }
+
+    auto frame = std::string();
+    for(auto& it : subscribers_) {
+        if(!it.second.irreversible) {
+            continue;
+        }
+        if(frame.empty()) {
+            auto w = fc::json_writer();
+            w.begin_object();
+            w.write_member("type", "irreversible");
+            w.key("data");
+            w.begin_object();
+            w.write_member("block_num", bs->block_num);
+            w.write_member("id", bs->id);
+            w.end_object();
+            w.end_object();
+            frame = w.release();
+        }
+        send(it.first, it.second, frame);
+    }
+    close_slow_consumers();
+}
+
+void
+subscription_plugin_impl::emit_trace(const transaction_trace_ptr& trace) {
+    if(ring_.has_value()) {
+        write_ring(shm_record_kind::trace, fc::raw::pack(*trace));
+    }
+
+    // serialized once and shared by all the matching subscribers
+    auto var   = fc::variant();
+    auto frame = std::string();
+    for(auto& it : subscribers_) {
+        auto& s = it.second;
+        if(!s.traces.has_value()) {
+            continue;
+        }
+        if(var.is_null()) {
+            db_.get_abi_serializer().to_variant(*trace, var, db_.get_execution_context());
+        }
+        if(!match(*s.traces, *trace, var)) {
+            continue;
+        }
+        if(frame.empty()) {
+            auto w = fc::json_writer();
+            w.begin_object();
+            w.write_member("type", "trace");
+            w.write_member("data", var);
+            w.end_object();
+            frame = w.release();
+        }
+        send(it.first, s, frame);
+    }
+}
+
+namespace __internal {
+
+bool
+has_address(const fc::variant& v, const std::set<std::string>& addrs) {
+    if(v.is_string()) {
+        return addrs.find(v.get_string()) != addrs.end();
+    }
+    if(v.is_array()) {
+        for(auto& e : v.get_array()) {
+            if(has_address(e, addrs)) {
+                return true;
+            }
+        }
+    }
+    else if(v.is_object()) {
+        for(auto& e : v.get_object()) {
+            if(has_address(e.value(), addrs)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+}  // namespace __internal
+
+bool
+subscription_plugin_impl::match(const trace_filter& filter, const transaction_trace& trace, const fc::variant& var) const {
+    if(filter.empty()) {
+        return true;
+    }
+
+    auto& vtraces = var["action_traces"].get_array();
+    for(auto i = 0u; i < trace.action_traces.size(); i++) {
+        auto& act = trace.action_traces[i].act;
+        if(!filter.actions.empty() && filter.actions.find(act.name) == filter.actions.end()) {
+            continue;
+        }
+        if(!filter.domains.empty() && filter.domains.find(act.domain) == filter.domains.end()) {
+            continue;
+        }
+        if(!filter.sym_ids.empty()) {
+            if(act.domain != N128(.fungible)) {
+                continue;
+            }
+            auto found = false;
+            for(auto id : filter.sym_ids) {
+                if(act.key == name128::from_number(id)) {
+                    found = true;
+                    break;
+                }
+            }
+            if(!found) {
+                continue;
+            }
+        }
+        if(!filter.addresses.empty() && !has_address(vtraces[i], filter.addresses)) {
+            continue;
+        }
+        return true;
+    }
+    return false;
+}
+
+void
+subscription_plugin_impl::send(ws_connection_id id, subscriber& s, const std::string& frame) {
+    // frames are dropped while the client is behind, it is told how many once it catches up
+    if(http_.ws_buffered_amount(id) > max_buffered_) {
+        auto now = fc::time_point::now();
+        if(s.dropped++ == 0) {
+            s.lagging_since = now;
+        }
+        else if(now - s.lagging_since > slow_timeout_) {
+            slow_consumers_.emplace_back(id);
+        }
+        return;
+    }
+    if(s.dropped > 0) {
+        auto w = fc::json_writer();
+        w.begin_object();
+        w.write_member("type", "lagged");
+        w.write_member("dropped", s.dropped);
+        w.end_object();
+        http_.ws_send(id, w.str());
+        s.dropped = 0;
+    }
+    http_.ws_send(id, frame);
+}
+
+void
+subscription_plugin_impl::send_reply(ws_connection_id id, const char* type, const std::string& message) {
+    auto w = fc::json_writer();
+    w.begin_object();
+    w.write_member("type", type);
+    w.write_member("message", message);
+    w.end_object();
+    http_.ws_send(id, w.str());
+}
+
+void
+subscription_plugin_impl::write_ring(shm_record_kind kind, const std::vector<char>& data) {
+    if(!ring_->write(kind, data.data(), data.size())) {
+        wlog("Record of ${s} bytes does not fit in the shared memory ring", ("s",data.size()));
+    }
+}
+
+void
+subscription_plugin_impl::close_slow_consumers() {
+    for(auto id : slow_consumers_) {
+        if(subscribers_.erase(id)) {
+            wlog("Disconnect slow subscriber: ${id}", ("id",id));
+            http_.ws_close(id, "Slow consumer");
+        }
+    }
+    slow_consumers_.clear();
+}
+
+subscription_plugin::subscription_plugin() {}
+subscription_plugin::~subscription_plugin() {}
+
+void
+subscription_plugin::set_program_options(options_description& cli, options_description& cfg) {
+    cfg.add_options()
+        ("subscription-max-buffered-kb", bpo::value<uint32_t>()->default_value(1024),
+            "Frames are dropped for a subscriber while more than this many KB are waiting to be sent to it")
+        ("subscription-slow-timeout-ms", bpo::value<uint32_t>()->default_value(10000),
+            "A subscriber which keeps dropping frames for this long is disconnected")
+        ("subscription-max-connections", bpo::value<uint32_t>()->default_value(1000),
+            "Maximum number of websocket subscribers, 0 means unlimited")
+        ("subscription-shm-ring-file", bpo::value<std::string>()->default_value(""),
+            "File (relative to data-dir) of the shared memory ring which local readers stream blocks and traces from; set blank to disable")
+        ("subscription-shm-ring-mb", bpo::value<uint32_t>()->default_value(64),
+            "Size of the shared memory ring in MB")
+        ;
+}
+
+void
+subscription_plugin::plugin_initialize(const variables_map& options) {
+    my_ = std::make_unique<subscription_plugin_impl>(app().get_plugin<chain_plugin>().chain(), app().get_plugin<http_plugin>());
+
+    my_->max_buffered_    = options.at("subscription-max-buffered-kb").as<uint32_t>() * 1024;
+    my_->slow_timeout_    = fc::milliseconds(options.at("subscription-slow-timeout-ms").as<uint32_t>());
+    my_->max_connections_ = options.at("subscription-max-connections").as<uint32_t>();
+
+    auto ring_file = boost::filesystem::path(options.at("subscription-shm-ring-file").as<std::string>());
+    if(!ring_file.empty()) {
+        if(ring_file.is_relative()) {
+            ring_file = app().data_dir() / ring_file;
+        }
+        auto size = (uint64_t)options.at("subscription-shm-ring-mb").as<uint32_t>() * 1024 * 1024;
+        EVT_ASSERT(size > 0, plugin_config_exception, "subscription-shm-ring-mb must be positive");
+
+        ilog("streaming blocks and traces to shared memory ring: ${f}", ("f",ring_file.generic_string()));
+        my_->ring_.emplace(ring_file.generic_string(), size);
+    }
+}
+
+void
+subscription_plugin::plugin_startup() {
+    auto& chain = my_->db_;
+
+    my_->applied_transaction_connection_.emplace(chain.applied_transaction.connect([this](const transaction_trace_ptr& trace) {
+        my_->applied_transaction(trace);
+    }));
+    my_->accepted_block_connection_.emplace(chain.accepted_block.connect([this](const block_state_ptr& bs) {
+        my_->accepted_block(bs);
+    }));
+    my_->irreversible_block_connection_.emplace(chain.irreversible_block.connect([this](const block_state_ptr& bs) {
+        my_->irreversible_block(bs);
+    }));
+
+    my_->http_.add_ws_handler("/v1/subscribe", ws_handler {
+        [this](ws_connection_id id) { my_->on_open(id); },
+        [this](ws_connection_id id, std::string&& msg) { my_->on_message(id, std::move(msg)); },
+        [this](ws_connection_id id) { my_->on_close(id); }
+    });
+}
+
+void
+subscription_plugin::plugin_shutdown() {
+    my_->applied_transaction_connection_.reset();
+    my_->accepted_block_connection_.reset();
+    my_->irreversible_block_connection_.reset();
+    my_->subscribers_.clear();
+    my_->pending_traces_.clear();
+}
+
+}  // namespace evt
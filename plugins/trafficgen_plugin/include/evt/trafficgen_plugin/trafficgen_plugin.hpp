@@ -5,6 +5,7 @@
 #pragma once
 
 #include <evt/chain_plugin/chain_plugin.hpp>
+#include <evt/producer_plugin/producer_plugin.hpp>
 
 #include <appbase/application.hpp>
 
@@ -14,7 +15,7 @@ using namespace appbase;
 
 class trafficgen_plugin : public plugin<trafficgen_plugin> {
 public:
-    APPBASE_PLUGIN_REQUIRES((chain_plugin))
+    APPBASE_PLUGIN_REQUIRES((chain_plugin)(producer_plugin))
 
     trafficgen_plugin()                         = default;
     trafficgen_plugin(const trafficgen_plugin&) = delete;
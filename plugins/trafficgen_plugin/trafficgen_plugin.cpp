@@ -5,11 +5,12 @@
 #include <evt/trafficgen_plugin/trafficgen_plugin.hpp>
 
 #include <signal.h>
-#include <boost/asio/post.hpp>
+#include <atomic>
 
 #include <evt/chain/exceptions.hpp>
 #include <evt/chain/transaction.hpp>
 #include <evt/chain/token_database.hpp>
+#include <evt/utilities/task_scheduler.hpp>
 
 #include <fc/io/json.hpp>
 #include <fc/variant.hpp>
@@ -30,6 +31,7 @@ using evt::chain::block_state_ptr;
 using evt::chain::packed_transaction_ptr;
 using evt::chain::private_key_type;
 using evt::chain::transaction_metadata;
+using evt::chain::transaction_metadata_ptr;
 
 class trafficgen_plugin_impl : public std::enable_shared_from_this<trafficgen_plugin_impl> {
 public:
@@ -47,6 +49,13 @@ private:
     void push_once(int index);
     void push_trx(const action& act, const block_id_type& id);
 
+    transaction_metadata_ptr make_metadata(const packed_transaction_ptr& ptrx) const;
+
+    void start_round();
+    void push_batch(size_t begin);
+    void on_answered(bool failed);
+    void mutate_round();
+
 public:
     controller& db_;
 
@@ -59,9 +68,21 @@ public:
 
     std::string type_;
 
-    std::vector<packed_transaction_ptr> packed_trxs_;
+    size_t   batch_size_ = 0;  // 0 pushes them one by one as incoming transactions
+    uint32_t rounds_     = 1;
+
+    std::vector<packed_transaction_ptr>   packed_trxs_;
+    std::vector<transaction_metadata_ptr> metas_;
 
-    std::optional<boost::signals2::scoped_connection> accepted_block_connection_;
+    uint32_t       round_         = 0;
+    size_t         answered_      = 0;
+    size_t         failed_        = 0;
+    size_t         total_applied_ = 0;
+    fc::time_point first_round_start_;
+    fc::time_point round_start_;
+    fc::time_point last_expiration_;
+
+    std::optional<utilities::scoped_signal_connection> accepted_block_connection_;
 };
 
 void
@@ -195,6 +216,7 @@ trafficgen_plugin_impl::pre_ft_generate(const block_id_type& id) {
 
         packed_trxs_.emplace_back(std::make_shared<packed_transaction>(trx));
     }
+    last_expiration_ = now + fc::minutes(10);
 
     ilog("Generating ft ptrxs... Done");
 }
@@ -234,6 +256,7 @@ trafficgen_plugin_impl::pre_nft_generate(const block_id_type& id) {
 
         packed_trxs_.emplace_back(std::make_shared<packed_transaction>(trx));
     }
+    last_expiration_ = now + fc::minutes(10);
 
     ilog("Generating nft ptrxs... Done");
 }
@@ -254,9 +277,19 @@ trafficgen_plugin_impl::applied_block(const block_state_ptr& bs) {
         else {
             auto now = fc::time_point::now();
             if(!pushed_ && std::abs((db_.head_block_time() - now).to_seconds()) < 1) {
-                const auto& exec = app().get_io_service().get_executor();
-                for(auto i = 0u; i < total_num_; i++) {
-                    boost::asio::post(exec, std::bind(&trafficgen_plugin_impl::push_once, this, (int)i));
+                if(batch_size_ > 0) {
+                    metas_.reserve(packed_trxs_.size());
+                    for(auto& ptrx : packed_trxs_) {
+                        metas_.emplace_back(make_metadata(ptrx));
+                    }
+                    first_round_start_ = now;
+                    start_round();
+                }
+                else {
+                    const auto& exec = app().get_io_service().get_executor();
+                    for(auto i = 0u; i < total_num_; i++) {
+                        boost::asio::post(exec, std::bind(&trafficgen_plugin_impl::push_once, this, (int)i));
+                    }
                 }
                 pushed_ = true;
             }
@@ -285,6 +318,110 @@ trafficgen_plugin_impl::push_once(int index) {
     }
 }
 
+transaction_metadata_ptr
+trafficgen_plugin_impl::make_metadata(const packed_transaction_ptr& ptrx) const {
+    // all are signed by the sender only, so there is nothing to recover
+    auto mtrx = std::make_shared<transaction_metadata>(ptrx);
+    auto keys = chain::public_keys_set();
+    keys.insert(from_priv_.get_public_key());
+    mtrx->signing_keys.emplace(db_.get_chain_id(), std::move(keys));
+    return mtrx;
+}
+
+void
+trafficgen_plugin_impl::start_round() {
+    answered_    = 0;
+    failed_      = 0;
+    round_start_ = fc::time_point::now();
+
+    // one post per batch so blocks and the network still get their turn on the main thread
+    for(auto i = 0u; i < metas_.size(); i += batch_size_) {
+        app().post(priority::low, [self = shared_from_this(), i] { self->push_batch(i); });
+    }
+}
+
+void
+trafficgen_plugin_impl::push_batch(size_t begin) {
+    auto end   = std::min(begin + batch_size_, metas_.size());
+    auto batch = std::vector<transaction_metadata_ptr>(metas_.begin() + begin, metas_.begin() + end);
+
+    try {
+        app().get_plugin<producer_plugin>().push_transactions(batch, [self = shared_from_this()](const auto& result) {
+            self->on_answered(result.template contains<fc::exception_ptr>());
+        });
+    }
+    catch(boost::interprocess::bad_alloc&) {
+        raise(SIGUSR1);
+    }
+    catch(fc::unrecoverable_exception&) {
+        raise(SIGUSR1);
+    }
+
+    if(end == metas_.size()) {
+        auto elapsed = fc::time_point::now() - round_start_;
+        ilog("Round ${r}: injected ${n} trxs in ${t} ms, ${rate} trxs/s",
+            ("r",round_)("n",metas_.size())("t",elapsed.count() / 1000)("rate",metas_.size() * 1'000'000 / std::max<int64_t>(elapsed.count(), 1)));
+    }
+}
+
+void
+trafficgen_plugin_impl::on_answered(bool failed) {
+    answered_++;
+    if(failed) {
+        failed_++;
+    }
+    if(answered_ < metas_.size()) {
+        return;
+    }
+
+    auto now     = fc::time_point::now();
+    auto elapsed = now - round_start_;
+    total_applied_ += answered_ - failed_;
+    ilog("Round ${r}: ${a} trxs applied and ${f} failed in ${t} ms, ${rate} trxs/s",
+        ("r",round_)("a",answered_ - failed_)("f",failed_)("t",elapsed.count() / 1000)
+        ("rate",(answered_ - failed_) * 1'000'000 / std::max<int64_t>(elapsed.count(), 1)));
+
+    if(++round_ < rounds_) {
+        mutate_round();
+        return;
+    }
+
+    auto total = now - first_round_start_;
+    ilog("Trafficgen done: ${a} trxs applied in ${r} rounds and ${t} ms, sustained ${rate} trxs/s",
+        ("a",total_applied_)("r",rounds_)("t",total.count() / 1000)("rate",total_applied_ * 1'000'000 / std::max<int64_t>(total.count(), 1)));
+}
+
+void
+trafficgen_plugin_impl::mutate_round() {
+    using namespace evt::chain;
+
+    // moving the expiration one second on is enough for new ids, only signing is left to do
+    auto expiration = std::max(fc::time_point::now() + fc::minutes(10), last_expiration_ + fc::seconds(1));
+    auto ref_id     = db_.head_block_id();
+    last_expiration_ = expiration;
+
+    auto chunks  = (metas_.size() + batch_size_ - 1) / batch_size_;
+    auto pending = std::make_shared<std::atomic<size_t>>(chunks);
+    for(auto i = 0u; i < metas_.size(); i += batch_size_) {
+        db_.get_task_scheduler().post([self = shared_from_this(), i, expiration, ref_id, pending] {
+            auto end = std::min(i + self->batch_size_, self->metas_.size());
+            for(auto j = i; j < end; j++) {
+                auto trx = self->packed_trxs_[j]->get_signed_transaction();
+                trx.set_reference_block(ref_id);
+                trx.expiration = expiration;
+                trx.signatures.clear();
+                trx.sign(self->from_priv_, self->db_.get_chain_id());
+
+                self->packed_trxs_[j] = std::make_shared<packed_transaction>(trx);
+                self->metas_[j]       = self->make_metadata(self->packed_trxs_[j]);
+            }
+            if(pending->fetch_sub(1) == 1) {
+                app().post(priority::low, [self] { self->start_round(); });
+            }
+        }, utilities::task_scheduler::lane::background);
+    }
+}
+
 void
 trafficgen_plugin::set_program_options(options_description&, options_description& cfg) {
     cfg.add_options()
@@ -293,6 +430,8 @@ trafficgen_plugin::set_program_options(options_description&, options_description
         ("traffic-from", bpo::value<std::string>(), "Address of sender when generating")
         ("traffic-from-priv", bpo::value<std::string>(), "Private key of sender when generating")
         ("traffic-type", bpo::value<std::string>()->default_value("ft"), "Type of transactions, can be 'nft' or 'ft'")
+        ("traffic-batch-size", bpo::value<size_t>()->default_value(0), "Transactions handed to the producer queue at once, their keys known already; 0 pushes them one by one as incoming transactions")
+        ("traffic-rounds", bpo::value<uint32_t>()->default_value(1), "Rounds of pushing the generated transactions, each one re-signed with a new expiration; needs traffic-batch-size and 'ft' type")
     ;
 }
 
@@ -315,6 +454,13 @@ trafficgen_plugin::plugin_initialize(const variables_map& options) {
         EVT_ASSERT(type == "ft" || type == "nft", chain::plugin_config_exception, "Not valid value for --traffic-type option");
         my_->type_ = type;
     }
+
+    my_->batch_size_ = options.at("traffic-batch-size").as<size_t>();
+    my_->rounds_     = options.at("traffic-rounds").as<uint32_t>();
+    EVT_ASSERT(my_->rounds_ > 0, chain::plugin_config_exception, "traffic-rounds should be at least 1");
+    // nft tokens are owned by the receivers after the first round
+    EVT_ASSERT(my_->rounds_ == 1 || (my_->batch_size_ > 0 && my_->type_ == "ft"), chain::plugin_config_exception,
+        "More than one traffic round needs traffic-batch-size and 'ft' traffic type");
 }
 
 void
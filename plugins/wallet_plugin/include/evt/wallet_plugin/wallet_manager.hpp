@@ -4,6 +4,7 @@
  */
 #pragma once
 #include <boost/asio/deadline_timer.hpp>
+#include <boost/asio/thread_pool.hpp>
 #include <boost/filesystem/path.hpp>
 #include <boost/interprocess/sync/file_lock.hpp>
 #include <chrono>
@@ -48,6 +49,10 @@ public:
     void
     set_timeout(int64_t secs) { set_timeout(std::chrono::seconds(secs)); }
 
+    /// Set the number of threads signing with software keys in parallel.
+    /// @param threads 0 to sign on the calling thread only.
+    void set_signing_threads(uint32_t threads);
+
 
     /// Sign transaction with the private keys specified via their public keys.
     /// Use chain_controller::get_required_keys to determine which keys are needed for txn.
@@ -59,6 +64,17 @@ public:
     chain::signed_transaction sign_transaction(const chain::signed_transaction& txn, const flat_set<public_key_type>& keys,
                                                const chain::chain_id_type& id);
 
+    /// Sign several transactions at once, each one with its own keys.
+    /// Signatures of all the transactions are made in parallel, see set_signing_threads.
+    /// @param txns the transactions to sign.
+    /// @param keys the public keys to sign each transaction with, one set for each transaction
+    /// @param id the chain_id to sign transactions with.
+    /// @return txns signed
+    /// @throws fc::exception if any of the private keys not found in unlocked wallets
+    std::vector<chain::signed_transaction> sign_transactions(const std::vector<chain::signed_transaction>& txns,
+                                                             const std::vector<flat_set<public_key_type>>& keys,
+                                                             const chain::chain_id_type& id);
+
     /// Sign digest with the private keys specified via their public keys.
     /// @param digest the digest to sign.
     /// @param key the public key of the corresponding private key to sign the digest with
@@ -141,6 +157,20 @@ private:
     /// Calls lock_all() if timeout has passed.
     void check_timeout();
 
+    struct sign_job {
+        const chain::digest_type* digest;
+        public_key_type           key;
+        wallet_api*               wallet;
+        signature_type            signature;
+    };
+
+    /// Find the unlocked wallet holding the key by the key index, rebuilt when it's invalidated.
+    wallet_api* find_wallet(const public_key_type& key);
+    void        invalidate_key_index() { key_index_valid = false; }
+
+    /// Sign the jobs, the ones of soft wallets are spread across signing threads.
+    void sign(std::vector<sign_job>& jobs);
+
 private:
     using timepoint_t = std::chrono::time_point<std::chrono::system_clock>;
     std::map<std::string, std::unique_ptr<wallet_api>> wallets;
@@ -152,6 +182,10 @@ private:
     
     std::unique_ptr<boost::interprocess::file_lock> wallet_dir_lock;
 
+    std::map<public_key_type, wallet_api*>    key_index;  ///< keys of unlocked wallets
+    bool                                      key_index_valid = false;
+    std::unique_ptr<boost::asio::thread_pool> signing_pool;
+
     void start_lock_watch(std::shared_ptr<boost::asio::deadline_timer> t);
     void initialize_lock();
 };
@@ -2,8 +2,10 @@
  *  @file
  *  @copyright defined in evt/LICENSE.txt
  */
+#include <future>
 #include <fc/crypto/sha256.hpp>
 #include <boost/algorithm/string.hpp>
+#include <boost/asio/post.hpp>
 #include <appbase/application.hpp>
 #include <evt/chain/exceptions.hpp>
 #include <evt/wallet_plugin/wallet_manager.hpp>
@@ -39,6 +41,9 @@ wallet_manager::wallet_manager() {
 }
 
 wallet_manager::~wallet_manager() {
+    if(signing_pool) {
+        signing_pool->join();
+    }
     //not really required, but may spook users
     if(wallet_dir_lock) {
         boost::filesystem::remove(lock_path);
@@ -54,6 +59,17 @@ wallet_manager::set_timeout(const std::chrono::seconds& t) {
         ("t", t.count())("now", now.time_since_epoch().count())("timeout_time", timeout_time.time_since_epoch().count()));
 }
 
+void
+wallet_manager::set_signing_threads(uint32_t threads) {
+    if(signing_pool) {
+        signing_pool->join();
+        signing_pool.reset();
+    }
+    if(threads > 0) {
+        signing_pool = std::make_unique<boost::asio::thread_pool>(threads);
+    }
+}
+
 void
 wallet_manager::check_timeout() {
     if(timeout_time != timepoint_t::max()) {
@@ -97,6 +113,7 @@ wallet_manager::create(const std::string& name) {
         wallets.erase(it);
     }
     wallets.emplace(name, std::move(wallet));
+    invalidate_key_index();
 
     return password;
 }
@@ -122,6 +139,7 @@ wallet_manager::open(const std::string& name) {
         wallets.erase(it);
     }
     wallets.emplace(name, std::move(wallet));
+    invalidate_key_index();
 }
 
 std::vector<std::string>
@@ -196,6 +214,7 @@ wallet_manager::lock_all() {
             i.second->lock();
         }
     }
+    invalidate_key_index();
 }
 
 void
@@ -209,6 +228,7 @@ wallet_manager::lock(const std::string& name) {
         return;
     }
     w->lock();
+    invalidate_key_index();
 }
 
 void
@@ -223,6 +243,7 @@ wallet_manager::unlock(const std::string& name, const std::string& password) {
         return;
     }
     w->unlock(password);
+    invalidate_key_index();
 }
 
 void
@@ -236,6 +257,7 @@ wallet_manager::import_key(const std::string& name, const std::string& wif_key)
         EVT_THROW(chain::wallet_locked_exception, "Wallet is locked: ${w}", ("w", name));
     }
     w->import_key(wif_key);
+    invalidate_key_index();
 }
 
 void
@@ -250,6 +272,7 @@ wallet_manager::remove_key(const std::string& name, const std::string& password,
     }
     w->check_password(password); //throws if bad password
     w->remove_key(key);
+    invalidate_key_index();
 }
 
 string
@@ -264,32 +287,98 @@ wallet_manager::create_key(const std::string& name, const std::string& key_type)
     }
 
     string upper_key_type = boost::to_upper_copy<std::string>(key_type);
-    return w->create_key(upper_key_type);
+    auto   key            = w->create_key(upper_key_type);
+    invalidate_key_index();
+    return key;
 }
 
-chain::signed_transaction
-wallet_manager::sign_transaction(const chain::signed_transaction& txn, const flat_set<public_key_type>& keys, const chain::chain_id_type& id) {
-    check_timeout();
-    chain::signed_transaction stxn(txn);
-
-    for(const auto& pk : keys) {
-        bool found = false;
+wallet_api*
+wallet_manager::find_wallet(const public_key_type& key) {
+    if(!key_index_valid) {
+        key_index.clear();
         for(const auto& i : wallets) {
             if(!i.second->is_locked()) {
-                auto sig = i.second->try_sign_digest(stxn.sig_digest(id), pk);
-                if(sig.has_value()) {
-                    stxn.signatures.push_back(*sig);
-                    found = true;
-                    break;  // inner for
+                for(const auto& pk : i.second->list_public_keys()) {
+                    key_index.emplace(pk, i.second.get());
                 }
             }
         }
-        if(!found) {
-            EVT_THROW(chain::wallet_missing_pub_key_exception, "Public key not found in unlocked wallets ${k}", ("k", pk));
+        key_index_valid = true;
+    }
+
+    auto it = key_index.find(key);
+    if(it != key_index.end()) {
+        return it->second;
+    }
+    return nullptr;
+}
+
+void
+wallet_manager::sign(std::vector<sign_job>& jobs) {
+    auto sign_one = [](auto& job) {
+        auto sig = job.wallet->try_sign_digest(*job.digest, job.key);
+        if(!sig.has_value()) {
+            EVT_THROW(chain::wallet_missing_pub_key_exception, "Public key not found in unlocked wallets ${k}", ("k", job.key));
+        }
+        job.signature = std::move(*sig);
+    };
+
+    // only soft wallets sign in the pool, hardware ones are driven one request after another
+    auto tasks = std::vector<std::future<void>>();
+    for(auto& job : jobs) {
+        if(signing_pool && jobs.size() > 1 && dynamic_cast<soft_wallet*>(job.wallet) != nullptr) {
+            auto task = std::make_shared<std::packaged_task<void()>>([&sign_one, &job] { sign_one(job); });
+            tasks.emplace_back(task->get_future());
+            boost::asio::post(*signing_pool, [task] { (*task)(); });
+        }
+        else {
+            sign_one(job);
+        }
+    }
+    // jobs are referenced by the tasks, all of them have to be finished before any error is thrown
+    for(auto& t : tasks) {
+        t.wait();
+    }
+    for(auto& t : tasks) {
+        t.get();
+    }
+}
+
+chain::signed_transaction
+wallet_manager::sign_transaction(const chain::signed_transaction& txn, const flat_set<public_key_type>& keys, const chain::chain_id_type& id) {
+    return sign_transactions({ txn }, { keys }, id)[0];
+}
+
+std::vector<chain::signed_transaction>
+wallet_manager::sign_transactions(const std::vector<chain::signed_transaction>& txns, const std::vector<flat_set<public_key_type>>& keys, const chain::chain_id_type& id) {
+    check_timeout();
+    EVT_ASSERT(txns.size() == keys.size(), wallet_exception, "Sets of keys should be provided for each transaction, ${t} transactions but ${k} sets of keys",
+        ("t", txns.size())("k", keys.size()));
+
+    // reserved, so jobs can point to the digests
+    auto digests = std::vector<chain::digest_type>();
+    auto jobs    = std::vector<sign_job>();
+    digests.reserve(txns.size());
+    for(auto i = 0u; i < txns.size(); i++) {
+        digests.emplace_back(txns[i].sig_digest(id));
+        for(const auto& pk : keys[i]) {
+            auto w = find_wallet(pk);
+            if(w == nullptr) {
+                EVT_THROW(chain::wallet_missing_pub_key_exception, "Public key not found in unlocked wallets ${k}", ("k", pk));
+            }
+            jobs.emplace_back(sign_job{ &digests.back(), pk, w, signature_type() });
         }
     }
+    sign(jobs);
 
-    return stxn;
+    auto stxns = txns;
+    auto n     = 0u;
+    for(auto i = 0u; i < stxns.size(); i++) {
+        for(auto j = 0u; j < keys[i].size(); j++) {
+            stxns[i].signatures.emplace_back(std::move(jobs[n++].signature));
+        }
+    }
+    return stxns;
 }
 
 chain::signature_type
@@ -297,12 +386,11 @@ wallet_manager::sign_digest(const chain::digest_type& digest, const public_key_t
     check_timeout();
 
     try {
-        for(const auto& i : wallets) {
-            if(!i.second->is_locked()) {
-                auto sig = i.second->try_sign_digest(digest, key);
-                if(sig.has_value()) {
-                    return *sig;
-                }
+        auto w = find_wallet(key);
+        if(w != nullptr) {
+            auto sig = w->try_sign_digest(digest, key);
+            if(sig.has_value()) {
+                return *sig;
             }
         }
     }
@@ -317,6 +405,7 @@ wallet_manager::own_and_use_wallet(const string& name, std::unique_ptr<wallet_ap
         EVT_THROW(wallet_exception, "Tried to use wallet name that already exists.");
     }
     wallets.emplace(name, std::move(wallet));
+    invalidate_key_index();
 }
 
 void
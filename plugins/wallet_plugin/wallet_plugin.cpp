@@ -5,6 +5,7 @@
 #include <evt/wallet_plugin/wallet_plugin.hpp>
 
 #include <chrono>
+#include <thread>
 
 #include <boost/filesystem/path.hpp>
 #include <fc/io/json.hpp>
@@ -36,6 +37,8 @@ wallet_plugin::set_program_options(options_description& cli, options_description
             "Timeout for unlocked wallet in seconds (default 900 (15 minutes)). "
             "Wallets will automatically lock after specified number of seconds of inactivity. "
             "Activity is defined as any wallet command e.g. list-wallets.")
+        ("signing-threads", bpo::value<uint32_t>()->default_value(std::max(std::thread::hardware_concurrency(), 1u)),
+            "Number of threads signing with the keys of soft wallets in parallel, 0 to sign on the main thread")
         ("yubihsm-url", bpo::value<string>()->value_name("URL"), "Override default URL of http://localhost:12345 for connecting to yubihsm-connector")
         ("yubihsm-authkey", bpo::value<uint16_t>()->value_name("key_num"), "Enables YubiHSM support using given Authkey")
         ;
@@ -65,6 +68,9 @@ wallet_plugin::plugin_initialize(const variables_map& options) {
             std::chrono::seconds t(timeout);
             wallet_manager_ptr->set_timeout(t);
         }
+        if(options.count("signing-threads")) {
+            wallet_manager_ptr->set_signing_threads(options.at("signing-threads").as<uint32_t>());
+        }
         if(options.count("yubihsm-authkey")) {
             uint16_t key                = options.at("yubihsm-authkey").as<uint16_t>();
             string   connector_endpoint = "http://localhost:12345";
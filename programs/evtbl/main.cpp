@@ -0,0 +1,109 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#include <iostream>
+#include <fstream>
+#include <boost/program_options.hpp>
+#include <boost/exception/diagnostic_information.hpp>
+
+#include <fc/exception/exception.hpp>
+#include <fc/io/raw.hpp>
+#include <evt/chain/block_log.hpp>
+#include <evt/chain/exceptions.hpp>
+
+#include <zdict.h>
+
+namespace bpo = boost::program_options;
+using evt::chain::block_log;
+
+namespace {
+
+// samples the packed transactions of the latest blocks and trains a zstd dictionary
+// for `p2p-compress-dict`, stops once the samples are about 100 times the dictionary
+size_t
+train_dict(const std::string& blocks_dir, const std::string& path, size_t dict_size, uint32_t max_blocks) {
+    auto log  = block_log(blocks_dir);
+    auto head = log.read_head();
+    EVT_ASSERT(head, fc::invalid_arg_exception, "Block log in '${d}' is empty", ("d", blocks_dir));
+
+    auto samples = std::vector<char>();
+    auto sizes   = std::vector<size_t>();
+    auto limit   = dict_size * 100;
+    for(auto num = head->block_num(), blocks = 0u; num > 0 && blocks < max_blocks && samples.size() < limit; --num, ++blocks) {
+        auto b = log.read_block_by_num(num);
+        if(!b) {
+            break;
+        }
+        for(auto& r : b->transactions) {
+            auto data = fc::raw::pack(r.trx);
+            samples.insert(samples.end(), data.begin(), data.end());
+            sizes.emplace_back(data.size());
+        }
+    }
+    EVT_ASSERT(!sizes.empty(), fc::invalid_arg_exception, "No transactions found to train the dictionary");
+
+    auto dict = std::vector<char>(dict_size);
+    auto r    = ZDICT_trainFromBuffer(dict.data(), dict.size(), samples.data(), sizes.data(), sizes.size());
+    EVT_ASSERT(!ZDICT_isError(r), fc::invalid_arg_exception, "Failed to train the dictionary: ${e}", ("e", ZDICT_getErrorName(r)));
+
+    auto out = std::ofstream(path, std::ios::out | std::ios::binary);
+    out.write(dict.data(), r);
+    out.close();
+    return sizes.size();
+}
+
+}  // namespace
+
+int
+main(int argc, char** argv) {
+    auto blocks_dir   = std::string();
+    auto output_dir   = std::string();
+    auto frame_blocks = uint32_t();
+    auto level        = int();
+    auto dict_path    = std::string();
+    auto dict_size    = size_t();
+    auto dict_blocks  = uint32_t();
+
+    auto desc = bpo::options_description("Converts blocks.log into the framed and compressed format");
+    desc.add_options()
+        ("help,h", "print this help message and exit")
+        ("blocks-dir", bpo::value<std::string>(&blocks_dir)->default_value("blocks"), "the directory containing the block log to convert")
+        ("output-dir", bpo::value<std::string>(&output_dir), "the directory to write the converted block log and index into")
+        ("frame-blocks", bpo::value<uint32_t>(&frame_blocks)->default_value(64), "number of blocks compressed together in one frame")
+        ("level", bpo::value<int>(&level)->default_value(19), "zstd compression level")
+        ("train-dict", bpo::value<std::string>(&dict_path), "train a zstd dictionary for p2p-compress-dict from the latest transactions and write it to this path instead of converting")
+        ("dict-size", bpo::value<size_t>(&dict_size)->default_value(112640), "size in bytes of the trained dictionary")
+        ("dict-blocks", bpo::value<uint32_t>(&dict_blocks)->default_value(100000), "maximum number of blocks sampled for the dictionary");
+
+    try {
+        auto vm = bpo::variables_map();
+        bpo::store(bpo::parse_command_line(argc, argv, desc), vm);
+        if(vm.count("help")) {
+            std::cout << desc << std::endl;
+            return 0;
+        }
+        bpo::notify(vm);
+
+        if(!dict_path.empty()) {
+            auto n = train_dict(blocks_dir, dict_path, dict_size, dict_blocks);
+            std::cout << "Trained dictionary '" << dict_path << "' from " << n << " transactions" << std::endl;
+            return 0;
+        }
+
+        EVT_ASSERT(!output_dir.empty(), fc::invalid_arg_exception, "output-dir is required to convert the block log");
+        auto n = block_log::convert_to_frames(blocks_dir, output_dir, frame_blocks, level);
+        std::cout << "Converted " << n << " blocks into '" << output_dir << "'" << std::endl;
+        return 0;
+    }
+    catch(const fc::exception& e) {
+        std::cerr << e.to_detail_string() << std::endl;
+    }
+    catch(const boost::exception& e) {
+        std::cerr << boost::diagnostic_information(e) << std::endl;
+    }
+    catch(const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+    }
+    return 1;
+}
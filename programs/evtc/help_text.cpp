@@ -46,9 +46,9 @@ bool print_recognized_errors(const fc::exception& e, const bool verbose_errors)
       // Get explanation from log, if any
       for (auto &log : e.get_log()) {
          // Check if there's a log to display
-         if (!log.format.empty()) {
+         if (!log.get_format().empty()) {
             // Localize the message as needed
-            explanation += "\n" + localized_with_variant(log.format.data(), log.args);
+            explanation += "\n" + localized_with_variant(log.get_format().data(), log.args);
          } else if (log.args.size() > 0 && verbose_errors) {
             // Show data-only log only if verbose_errors option is enabled
             explanation += "\n" + fc::json::to_string(log.args);
@@ -12,8 +12,11 @@
 
 #include <iostream>
 #include <istream>
+#include <map>
+#include <memory>
 #include <ostream>
 #include <regex>
+#include <sstream>
 #include <string>
 
 #include <boost/algorithm/string.hpp>
@@ -32,9 +35,23 @@ using boost::asio::ip::tcp;
 namespace evt { namespace client { namespace http {
 
 namespace detail {
+
+// one kept-alive connection to a server, `buffer` holds the bytes read beyond the last response,
+// which are the beginning of next pipelined response
+struct http_connection {
+    std::unique_ptr<tcp::socket>                                    tcp_socket;
+    std::unique_ptr<boost::asio::ssl::stream<tcp::socket>>          ssl_socket;
+    std::unique_ptr<boost::asio::local::stream_protocol::socket>    unix_socket;
+    boost::asio::streambuf                                          buffer;
+    bool                                                            reused = false;
+};
+
 class http_context_impl {
 public:
     boost::asio::io_service ios;
+
+    std::unique_ptr<boost::asio::ssl::context>              ssl_context;  // created by first https connection
+    std::map<string, std::unique_ptr<http_connection>>      connections;  // keyed by scheme, server, port and verify
 };
 
 void
@@ -59,53 +76,185 @@ do_connect(tcp::socket& sock, const resolved_url& url) {
     boost::asio::connect(sock, endpoints);
 }
 
+namespace internal {
+
+using detail::http_connection;
+
+struct http_response {
+    unsigned int status_code = 0;
+    bool         keep_alive  = false;
+    std::string  body;
+};
+
 template <class T>
-std::string
-do_txrx(T& socket, boost::asio::streambuf& request_buff, unsigned int& status_code) {
-    // Send the request.
-    boost::asio::write(socket, request_buff);
-
-    // Read the response status line. The response streambuf will automatically
-    // grow to accommodate the entire line. The growth may be limited by passing
-    // a maximum size to the streambuf constructor.
-    boost::asio::streambuf response;
-    boost::asio::read_until(socket, response, "\r\n");
-
-    // Check that response is OK.
-    std::istream response_stream(&response);
-    std::string  http_version;
-    response_stream >> http_version;
-    response_stream >> status_code;
+void
+write_request(T& socket, const std::string& request) {
+    boost::asio::write(socket, boost::asio::buffer(request));
+}
+
+template <class T>
+http_response
+read_response(T& socket, boost::asio::streambuf& buffer) {
+    auto res = http_response();
+
+    // Read the response status line and headers, which are terminated by a blank line.
+    // The buffer may already hold them if the responses are pipelined.
+    auto n      = boost::asio::read_until(socket, buffer, "\r\n\r\n");
+    auto header = std::string(boost::asio::buffers_begin(buffer.data()), boost::asio::buffers_begin(buffer.data()) + n);
+    buffer.consume(n);
+
+    std::istringstream header_stream(header);
+    std::string        http_version;
+    header_stream >> http_version;
+    header_stream >> res.status_code;
     std::string status_message;
-    std::getline(response_stream, status_message);
-    FC_ASSERT(!(!response_stream || http_version.substr(0, 5) != "HTTP/"), "Invalid Response");
+    std::getline(header_stream, status_message);
+    FC_ASSERT(!(!header_stream || http_version.substr(0, 5) != "HTTP/"), "Invalid Response");
 
-    // Read the response headers, which are terminated by a blank line.
-    boost::asio::read_until(socket, response, "\r\n\r\n");
+    // HTTP/1.1 keeps connection alive unless told not to, HTTP/1.0 the other way round
+    res.keep_alive = (http_version != "HTTP/1.0");
 
     // Process the response headers.
-    std::string header;
+    std::string line;
     int         response_content_length = -1;
     std::regex  clregex(R"xx(^Content-Length:\s+(\d+))xx", std::regex_constants::icase);
-    while(std::getline(response_stream, header) && header != "\r") {
+    std::regex  connregex(R"xx(^Connection:\s+([\w-]+))xx", std::regex_constants::icase);
+    while(std::getline(header_stream, line) && line != "\r") {
         std::smatch match;
-        if(std::regex_search(header, match, clregex))
+        if(std::regex_search(line, match, clregex)) {
             response_content_length = std::stoi(match[1]);
+        }
+        else if(std::regex_search(line, match, connregex)) {
+            res.keep_alive = boost::algorithm::iequals(match[1].str(), "keep-alive");
+        }
+    }
+    FC_ASSERT(response_content_length >= 0, "Invalid Content-Length response, header: ${h}", ("h",line));
+
+    if(buffer.size() < (size_t)response_content_length) {
+        boost::asio::read(socket, buffer, boost::asio::transfer_exactly(response_content_length - buffer.size()));
     }
-    FC_ASSERT(response_content_length >= 0, "Invalid Content-Length response, header: ${h}", ("h",header));
+    res.body = std::string(boost::asio::buffers_begin(buffer.data()), boost::asio::buffers_begin(buffer.data()) + response_content_length);
+    buffer.consume(response_content_length);
+
+    return res;
+}
 
-    std::stringstream re;
-    // Write whatever content we already have to output.
-    response_content_length -= response.size();
-    if(response.size() > 0)
-        re << &response;
+http_connection&
+get_connection(const connection_param& cp) {
+    const auto& url = cp.url;
 
-    boost::asio::read(socket, response, boost::asio::transfer_exactly(response_content_length));
-    re << &response;
+    auto& conns = cp.context->connections;
+    auto  key   = url.scheme + "://" + url.server + ":" + url.port + (cp.verify_cert ? "" : "#noverify");
+    auto  it    = conns.find(key);
+    if(it != conns.end()) {
+        it->second->reused = true;
+        return *it->second;
+    }
 
-    return re.str();
+    auto  conn = std::make_unique<http_connection>();
+    auto& ios  = cp.context->ios;
+    if(url.scheme == "unix") {
+        conn->unix_socket = std::make_unique<boost::asio::local::stream_protocol::socket>(ios);
+        conn->unix_socket->connect(boost::asio::local::stream_protocol::endpoint(url.server));
+    }
+    else if(url.scheme == "http") {
+        conn->tcp_socket = std::make_unique<tcp::socket>(ios);
+        do_connect(*conn->tcp_socket, url);
+        conn->tcp_socket->set_option(tcp::no_delay(true));
+    }
+    else {  //https
+        auto& sslc = cp.context->ssl_context;
+        if(!sslc) {
+            sslc = std::make_unique<boost::asio::ssl::context>(boost::asio::ssl::context::sslv23_client);
+            fc::add_platform_root_cas_to_context(*sslc);
+        }
+
+        conn->ssl_socket = std::make_unique<boost::asio::ssl::stream<tcp::socket>>(ios, *sslc);
+        auto& socket = *conn->ssl_socket;
+        SSL_set_tlsext_host_name(socket.native_handle(), url.server.c_str());
+        if(cp.verify_cert) {
+            socket.set_verify_mode(boost::asio::ssl::verify_peer);
+            socket.set_verify_callback(boost::asio::ssl::rfc2818_verification(url.server));
+        }
+        do_connect(socket.next_layer(), url);
+        socket.next_layer().set_option(tcp::no_delay(true));
+        socket.handshake(boost::asio::ssl::stream_base::client);
+    }
+    return *conns.emplace(key, std::move(conn)).first->second;
+}
+
+void
+close_connection(const connection_param& cp, http_connection& conn) {
+    if(conn.ssl_socket) {
+        //try and do a clean shutdown; but swallow if this fails (other side could have already gave TCP the ax)
+        try {conn.ssl_socket->shutdown();} catch(...) {}
+    }
+
+    auto& conns = cp.context->connections;
+    for(auto it = conns.begin(); it != conns.end(); it++) {
+        if(it->second.get() == &conn) {
+            conns.erase(it);
+            return;
+        }
+    }
 }
 
+// sends all the requests at once over one connection and then reads the responses in order.
+// If the server closes the connection before answering all of them, the rest are sent again
+// on a new one, so a server which doesn't support keep-alive only costs a connection per request.
+std::vector<http_response>
+do_txrx(const connection_param& cp, const std::vector<std::string>& requests) {
+    auto responses = std::vector<http_response>();
+    responses.reserve(requests.size());
+
+    auto retried = false;
+    while(responses.size() < requests.size()) {
+        auto& conn  = get_connection(cp);
+        auto  first = responses.size();
+
+        auto run = [&](auto& socket) {
+            for(auto i = first; i < requests.size(); i++) {
+                write_request(socket, requests[i]);
+            }
+            for(auto i = first; i < requests.size(); i++) {
+                responses.emplace_back(read_response(socket, conn.buffer));
+                if(!responses.back().keep_alive) {
+                    break;
+                }
+            }
+        };
+
+        try {
+            if(conn.unix_socket) {
+                run(*conn.unix_socket);
+            }
+            else if(conn.tcp_socket) {
+                run(*conn.tcp_socket);
+            }
+            else {
+                run(*conn.ssl_socket);
+            }
+        }
+        catch(boost::system::system_error&) {
+            // a kept-alive connection may be closed by server meanwhile, retry once on a new one
+            auto reused = conn.reused;
+            close_connection(cp, conn);
+            if(!reused || retried) {
+                throw;
+            }
+            retried = true;
+            continue;
+        }
+
+        if(responses.empty() || !responses.back().keep_alive) {
+            close_connection(cp, conn);
+        }
+    }
+    return responses;
+}
+
+}  // namespace internal
+
 parsed_url
 parse_url(const string& server_url) {
     parsed_url res;
@@ -187,11 +336,10 @@ format_host_header(const resolved_url& url) {
     }
 }
 
-fc::variant
-do_http_call(const connection_param& cp,
-             const fc::variant&      postdata,
-             bool                    print_request,
-             bool                    print_response) {
+namespace internal {
+
+std::string
+format_request(const connection_param& cp, const fc::variant& postdata, bool print_request) {
     std::string postjson;
     if(!postdata.is_null()) {
         postjson = print_request ? fc::json::to_pretty_string(postdata) : fc::json::to_string(postdata);
@@ -199,15 +347,14 @@ do_http_call(const connection_param& cp,
 
     const auto& url = cp.url;
 
-    boost::asio::streambuf request;
-    std::ostream           request_stream(&request);
+    std::ostringstream request_stream;
 
     auto host_header_value = format_host_header(url);
-    request_stream << "POST " << url.path << " HTTP/1.0\r\n";
+    request_stream << "POST " << url.path << " HTTP/1.1\r\n";
     request_stream << "Host: " << host_header_value << "\r\n";
     request_stream << "Content-Length: " << postjson.size() << "\r\n";
     request_stream << "Accept: */*\r\n";
-    request_stream << "Connection: close\r\n";
+    request_stream << "Connection: keep-alive\r\n";
     // append more customized headers
     std::vector<string>::iterator itr;
     for(itr = cp.headers.begin(); itr != cp.headers.end(); itr++) {
@@ -216,51 +363,21 @@ do_http_call(const connection_param& cp,
     request_stream << "\r\n";
     request_stream << postjson;
 
+    auto request = request_stream.str();
     if(print_request) {
-        string s(request.size(), '\0');
-        buffer_copy(boost::asio::buffer(s), request.data());
         std::cerr << "REQUEST:" << std::endl
                   << "---------------------" << std::endl
-                  << s << std::endl
+                  << request << std::endl
                   << "---------------------" << std::endl;
     }
+    return request;
+}
 
-    unsigned int status_code;
-    std::string  re;
-
-    try {
-        if(url.scheme == "unix") {
-            boost::asio::local::stream_protocol::socket unix_socket(cp.context->ios);
-            unix_socket.connect(boost::asio::local::stream_protocol::endpoint(url.server));
-            re = do_txrx(unix_socket, request, status_code);
-        }
-        else if(url.scheme == "http") {
-            tcp::socket socket(cp.context->ios);
-            do_connect(socket, url);
-            re = do_txrx(socket, request, status_code);
-        }
-        else {  //https
-            boost::asio::ssl::context ssl_context(boost::asio::ssl::context::sslv23_client);
-            fc::add_platform_root_cas_to_context(ssl_context);
-
-            boost::asio::ssl::stream<boost::asio::ip::tcp::socket> socket(cp.context->ios, ssl_context);
-            SSL_set_tlsext_host_name(socket.native_handle(), url.server.c_str());
-            if(cp.verify_cert) {
-                socket.set_verify_mode(boost::asio::ssl::verify_peer);
-                socket.set_verify_callback(boost::asio::ssl::rfc2818_verification(url.server));
-            }
-            do_connect(socket.next_layer(), url);
-            socket.handshake(boost::asio::ssl::stream_base::client);
-            re = do_txrx(socket, request, status_code);
-            //try and do a clean shutdown; but swallow if this fails (other side could have already gave TCP the ax)
-            try {socket.shutdown();} catch(...) {}
-        }
-    }
-    catch(chain::invalid_http_request& e) {
-        e.append_log(FC_LOG_MESSAGE(info, "Please verify this url is valid: ${url}", ("url", url.scheme + "://" + url.server + ":" + url.port + url.path)));
-        e.append_log(FC_LOG_MESSAGE(info, "If the condition persists, please contact the RPC server administrator for ${server}!", ("server", url.server)));
-        throw;
-    }
+fc::variant
+handle_response(const connection_param& cp, const http_response& res, bool print_response) {
+    const auto& url         = cp.url;
+    const auto& re          = res.body;
+    auto        status_code = res.status_code;
 
     auto response_result = fc::variant();
     if(!cp.raw_response) {
@@ -337,4 +454,45 @@ do_http_call(const connection_param& cp,
     return response_result;
 }
 
+}  // namespace internal
+
+fc::variant
+do_http_call(const connection_param& cp,
+             const fc::variant&      postdata,
+             bool                    print_request,
+             bool                    print_response) {
+    return do_http_calls(cp, { postdata }, print_request, print_response)[0];
+}
+
+std::vector<fc::variant>
+do_http_calls(const connection_param&         cp,
+              const std::vector<fc::variant>& postdatas,
+              bool                            print_request,
+              bool                            print_response) {
+    const auto& url = cp.url;
+
+    auto requests = std::vector<std::string>();
+    requests.reserve(postdatas.size());
+    for(auto& postdata : postdatas) {
+        requests.emplace_back(internal::format_request(cp, postdata, print_request));
+    }
+
+    auto responses = std::vector<internal::http_response>();
+    try {
+        responses = internal::do_txrx(cp, requests);
+    }
+    catch(chain::invalid_http_request& e) {
+        e.append_log(FC_LOG_MESSAGE(info, "Please verify this url is valid: ${url}", ("url", url.scheme + "://" + url.server + ":" + url.port + url.path)));
+        e.append_log(FC_LOG_MESSAGE(info, "If the condition persists, please contact the RPC server administrator for ${server}!", ("server", url.server)));
+        throw;
+    }
+
+    auto results = std::vector<fc::variant>();
+    results.reserve(responses.size());
+    for(auto& res : responses) {
+        results.emplace_back(internal::handle_response(cp, res, print_response));
+    }
+    return results;
+}
+
 }}}  // namespace evt::client::http
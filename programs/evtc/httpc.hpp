@@ -99,6 +99,13 @@ fc::variant do_http_call(
     bool                    print_request  = false,
     bool                    print_response = false);
 
+// pipelines the requests over one kept-alive connection, results are in the same order
+std::vector<fc::variant> do_http_calls(
+    const connection_param&         cp,
+    const std::vector<fc::variant>& postdatas,
+    bool                            print_request  = false,
+    bool                            print_response = false);
+
 const std::string chain_func_base             = "/v1/chain";
 const std::string get_info_func               = chain_func_base + "/get_info";
 const std::string get_db_info_func            = chain_func_base + "/get_db_info";
@@ -310,6 +310,62 @@ call(const std::string& url,
     return call(url, path, fc::variant(), raw_response); 
 }
 
+// pipelines the calls to the same path over one connection
+std::vector<fc::variant>
+calls(const std::string& path, const std::vector<fc::variant>& vs) {
+    try {
+        auto cp = evt::client::http::connection_param(context, parse_url(url) + path, no_verify ? false : true, headers);
+        return evt::client::http::do_http_calls(cp, vs, print_request, print_response);
+    }
+    catch(boost::system::system_error& e) {
+        std::cerr << localized("Failed to connect to evtd at ${u}; is evtd running?", ("u", url)) << std::endl;
+        throw connection_exception(fc::log_messages{FC_LOG_MESSAGE(error, e.what())});
+    }
+}
+
+// splits concatenated JSON values, like the pretty printed outputs of `--dont-broadcast`
+std::vector<std::string>
+split_json_values(std::istream& in) {
+    auto values  = std::vector<std::string>();
+    auto current = std::string();
+    auto depth   = 0;
+    auto in_str  = false;
+    auto escaped = false;
+
+    char c;
+    while(in.get(c)) {
+        if(depth == 0 && c != '{' && c != '[') {
+            continue;
+        }
+        current.push_back(c);
+        if(in_str) {
+            if(escaped) {
+                escaped = false;
+            }
+            else if(c == '\\') {
+                escaped = true;
+            }
+            else if(c == '"') {
+                in_str = false;
+            }
+            continue;
+        }
+        switch(c) {
+        case '"': in_str = true; break;
+        case '{': case '[': depth++; break;
+        case '}': case ']': {
+            if(--depth == 0) {
+                values.emplace_back(std::move(current));
+                current.clear();
+            }
+            break;
+        }
+        }  // switch
+    }
+    EVT_ASSERT(depth == 0, transaction_type_exception, "Incomplete JSON value at the end of input");
+    return values;
+}
+
 void
 set_execution_context(execution_context& exec_ctx) {
     auto acts = call(get_evt_actions, fc::variant()).as<std::vector<action_ver_type>>();
@@ -1272,6 +1328,7 @@ struct set_producer_subcommands {
     string  prodsjson;
 
     vector<string> prodkeys;
+    vector<string> snapshot_bases;
 
     set_producer_subcommands(CLI::App* actionRoot) {
         auto pvcmd = actionRoot->add_subcommand("prodvote", localized("Producer votes for chain configuration"));
@@ -1340,9 +1397,11 @@ struct set_producer_subcommands {
 
         auto cscmd = actionRoot->add_subcommand("snapshot", localized("Create a snapshot till current head block"));
         cscmd->add_flag("-p,--postgres", postgres, localized("Add postgres to snapshot"));
+        cscmd->add_option("-b,--bases", snapshot_bases, localized("File names of a full snapshot and the diffs taken after it, creates a differential snapshot with only the changes since them"));
         cscmd->callback([this] {
             auto arg = fc::mutable_variant_object();
             arg["postgres"] = postgres;
+            arg["bases"]    = snapshot_bases;
 
             const auto& v = call(url, create_snapshot, arg);
             print_info(v);
@@ -2166,6 +2225,48 @@ main(int argc, char** argv) {
         std::cout << fc::json::to_pretty_string(trxs_result) << std::endl;
     });
 
+    // push batch
+    auto batch_size   = 100u;
+    auto batch_window = 4u;
+    auto batchSubcommand = push->add_subcommand("batch", localized("Push signed JSON transactions read from STDIN in batches"));
+    batchSubcommand->add_option("-s,--size", batch_size, localized("Number of transactions in one push request"))->capture_default_str();
+    batchSubcommand->add_option("-w,--window", batch_window, localized("Number of push requests pipelined over one connection"))->capture_default_str();
+    batchSubcommand->callback([&] {
+        EVT_ASSERT(batch_size > 0 && batch_window > 0, transaction_type_exception, "Size and window of batch should be positive");
+
+        auto trxs = fc::variants();
+        try {
+            for(auto& v : split_json_values(std::cin)) {
+                auto trx_var = fc::json::from_string(v);
+                if(trx_var.is_array()) {
+                    for(auto& t : trx_var.get_array()) {
+                        trxs.emplace_back(packed_transaction(t.as<signed_transaction>(), packed_transaction::none));
+                    }
+                }
+                else {
+                    trxs.emplace_back(packed_transaction(trx_var.as<signed_transaction>(), packed_transaction::none));
+                }
+            }
+        }
+        EVT_RETHROW_EXCEPTIONS(transaction_type_exception, "Fail to parse transaction JSON")
+
+        auto requests = std::vector<fc::variant>();
+        for(auto i = 0u; i < trxs.size(); i += batch_size) {
+            auto end = std::min((size_t)i + batch_size, trxs.size());
+            requests.emplace_back(fc::variants(trxs.begin() + i, trxs.begin() + end));
+        }
+
+        auto results = fc::variants();
+        for(auto i = 0u; i < requests.size(); i += batch_window) {
+            auto end = std::min((size_t)i + batch_window, requests.size());
+            for(auto& r : calls(push_txns_func, std::vector<fc::variant>(requests.begin() + i, requests.begin() + end))) {
+                auto& rs = r.get_array();
+                results.insert(results.end(), rs.begin(), rs.end());
+            }
+        }
+        std::cout << fc::json::to_pretty_string(results) << std::endl;
+    });
+
     try {
         app.parse(argc, argv);
     }
@@ -118,7 +118,8 @@ enum return_codes {
     BAD_ALLOC         = 1,
     DATABASE_DIRTY    = 2,
     FIXED_REVERSIBLE  = 3,
-    EXTRACTED_GENESIS = 4
+    EXTRACTED_GENESIS = 4,
+    NODE_MANAGEMENT_SUCCESS = 5
 };
 
 int
@@ -162,6 +163,9 @@ main(int argc, char** argv) {
     catch(const fixed_reversible_db_exception& e) {
         return FIXED_REVERSIBLE;
     }
+    catch(const node_management_success& e) {
+        return NODE_MANAGEMENT_SUCCESS;
+    }
     catch(const fc::exception& e) {
         elog("${e}", ("e", e.to_detail_string()));
         return OTHER_FAIL;
@@ -0,0 +1,338 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#include <algorithm>
+#include <deque>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <map>
+#include <thread>
+#include <boost/program_options.hpp>
+#include <boost/exception/diagnostic_information.hpp>
+
+#include <fc/filesystem.hpp>
+#include <fc/io/json.hpp>
+#include <fc/exception/exception.hpp>
+#include <evt/chain/block_log.hpp>
+#include <evt/chain/execution_context_mock.hpp>
+#include <evt/chain/contracts/abi_serializer.hpp>
+#include <evt/chain/contracts/evt_contract_abi.hpp>
+
+namespace bpo = boost::program_options;
+using namespace evt::chain;
+using evt::chain::contracts::abi_serializer;
+
+namespace {
+
+/**
+ * Rows of one action name decoded from a batch of blocks, kept column by column
+ */
+struct action_columns {
+    std::vector<uint32_t>            block_nums;
+    std::vector<int64_t>             timestamps;
+    std::vector<transaction_id_type> trx_ids;
+    std::vector<uint16_t>            action_indexes;
+    std::vector<std::string>         domains;
+    std::vector<std::string>         keys;
+    std::vector<std::string>         datas;
+};
+
+using batch_result = std::map<std::string, action_columns>;
+
+/**
+ * Column files of one partition (action name), strings are stored Arrow-style
+ * as an array of end offsets plus a contiguous data file
+ */
+class partition_writer {
+public:
+    partition_writer(const fc::path& dir)
+        : dir_(dir) {
+        fc::create_directories(dir);
+
+        block_nums_.open(path("block_num.u32"), std::ios::binary);
+        timestamps_.open(path("timestamp.i64"), std::ios::binary);
+        trx_ids_.open(path("trx_id.b32"), std::ios::binary);
+        action_indexes_.open(path("action_index.u16"), std::ios::binary);
+        for(auto i = 0u; i < strs_.size(); i++) {
+            strs_[i].offsets.open(path(str_names_[i] + ".offsets"), std::ios::binary);
+            strs_[i].data.open(path(str_names_[i] + ".data"), std::ios::binary);
+        }
+    }
+
+public:
+    void
+    append(const action_columns& cols) {
+        write_vector(block_nums_, cols.block_nums);
+        write_vector(timestamps_, cols.timestamps);
+        write_vector(trx_ids_, cols.trx_ids);
+        write_vector(action_indexes_, cols.action_indexes);
+        write_strings(strs_[0], cols.domains);
+        write_strings(strs_[1], cols.keys);
+        write_strings(strs_[2], cols.datas);
+
+        rows_ += cols.block_nums.size();
+    }
+
+    void
+    finalize() {
+        auto columns = fc::variants();
+        auto add_col = [&](auto name, auto type, auto file) {
+            columns.emplace_back(fc::mutable_variant_object("name", name)("type", type)("file", file));
+        };
+        add_col("block_num", "uint32", "block_num.u32");
+        add_col("timestamp", "int64", "timestamp.i64");
+        add_col("trx_id", "fixed_binary[32]", "trx_id.b32");
+        add_col("action_index", "uint16", "action_index.u16");
+        for(auto& n : str_names_) {
+            columns.emplace_back(fc::mutable_variant_object("name", n)("type", n == "data" ? "json" : "utf8")
+                                 ("offsets", n + ".offsets")("file", n + ".data"));
+        }
+
+        auto schema = fc::mutable_variant_object("rows", rows_)("endianness", "little")("columns", columns);
+        fc::json::save_to_file(schema, path("schema.json"), true);
+    }
+
+private:
+    struct string_column {
+        std::ofstream offsets;
+        std::ofstream data;
+        uint64_t      end = 0;
+    };
+
+    std::string
+    path(const std::string& file) const {
+        return (dir_ / file).generic_string();
+    }
+
+    template<typename T>
+    static void
+    write_vector(std::ofstream& fs, const std::vector<T>& v) {
+        fs.write((const char*)v.data(), v.size() * sizeof(T));
+    }
+
+    static void
+    write_strings(string_column& col, const std::vector<std::string>& v) {
+        auto offsets = std::vector<uint64_t>();
+        offsets.reserve(v.size());
+        for(auto& s : v) {
+            col.data.write(s.data(), s.size());
+            col.end += s.size();
+            offsets.emplace_back(col.end);
+        }
+        write_vector(col.offsets, offsets);
+    }
+
+private:
+    fc::path      dir_;
+    uint64_t      rows_ = 0;
+    std::ofstream block_nums_;
+    std::ofstream timestamps_;
+    std::ofstream trx_ids_;
+    std::ofstream action_indexes_;
+
+    std::array<string_column, 3>                 strs_;
+    static inline const std::array<std::string, 3> str_names_ = { "domain", "key", "data" };
+};
+
+/**
+ * Decodes the action data with the abi, the version of each action active at the time of the block
+ * is unknown without replaying the chain, so unless it's pinned the versions are tried from the
+ * latest one downwards. Data of another version almost always fails to consume the buffer exactly,
+ * so the first version that decodes is taken, use `--action-version` where that's ambiguous.
+ */
+class action_decoder {
+public:
+    action_decoder(const abi_serializer& abi, const std::map<name, int>& pinned)
+        : abi_(abi), pinned_(pinned) {}
+
+public:
+    std::string
+    decode(const action& act) {
+        auto it   = pinned_.find(act.name);
+        auto maxv = it != pinned_.end() ? it->second : exec_ctx_.get_max_version(act.name);
+        auto minv = it != pinned_.end() ? it->second : 1;
+
+        for(auto v = maxv; v >= minv; v--) {
+            try {
+                exec_ctx_.set_version_unsafe(act.name, v);
+                auto var = abi_.binary_to_variant(exec_ctx_.get_acttype_name(act.name), act.data, exec_ctx_);
+                return fc::json::to_string(var);
+            }
+            catch(const fc::exception&) {
+                if(v == minv) {
+                    throw;
+                }
+            }
+        }
+        return std::string();
+    }
+
+private:
+    const abi_serializer&       abi_;
+    const std::map<name, int>&  pinned_;
+    evt_execution_context_mock  exec_ctx_;
+};
+
+batch_result
+decode_blocks(const std::vector<block_log::serialized_block>& sblocks, const abi_serializer& abi, const std::map<name, int>& pinned) {
+    auto result  = batch_result();
+    auto decoder = action_decoder(abi, pinned);
+
+    for(auto& sb : sblocks) {
+        auto ds = fc::datastream<const char*>(sb.data.data(), sb.data.size());
+        auto b  = signed_block();
+        fc::raw::unpack(ds, b);
+
+        auto block_num = b.block_num();
+        auto timestamp = b.timestamp.to_time_point().time_since_epoch().count();
+
+        for(auto& receipt : b.transactions) {
+            auto& trx    = receipt.trx.get_transaction();
+            auto  trx_id = receipt.trx.id();
+
+            for(auto i = 0u; i < trx.actions.size(); i++) {
+                auto& act  = trx.actions[i];
+                auto& cols = result[act.name.to_string()];
+
+                cols.block_nums.emplace_back(block_num);
+                cols.timestamps.emplace_back(timestamp);
+                cols.trx_ids.emplace_back(trx_id);
+                cols.action_indexes.emplace_back((uint16_t)i);
+                cols.domains.emplace_back(act.domain.to_string());
+                cols.keys.emplace_back(act.key.to_string());
+                try {
+                    cols.datas.emplace_back(decoder.decode(act));
+                }
+                catch(const fc::exception& e) {
+                    std::cerr << "Cannot decode action " << act.name.to_string() << " in block " << block_num
+                              << ": " << e.to_string() << std::endl;
+                    cols.datas.emplace_back("null");
+                }
+            }
+        }
+    }
+    return result;
+}
+
+std::map<name, int>
+parse_action_versions(const std::vector<std::string>& args) {
+    auto exec_ctx = evt_execution_context_mock();
+    auto vers     = std::map<name, int>();
+    for(auto& arg : args) {
+        auto pos = arg.find('=');
+        FC_ASSERT(pos != std::string::npos, "Invalid action version: ${a}, should be in form of 'action=version'", ("a", arg));
+
+        auto act = name(arg.substr(0, pos));
+        auto ver = std::stoi(arg.substr(pos + 1));
+        FC_ASSERT(ver >= 1 && ver <= exec_ctx.get_max_version(act), "Invalid version of action: ${a}", ("a", arg));
+
+        vers[act] = ver;
+    }
+    return vers;
+}
+
+}  // namespace
+
+int
+main(int argc, char** argv) {
+    auto blocks_dir   = std::string();
+    auto output_dir   = std::string();
+    auto start_block  = uint32_t();
+    auto end_block    = uint32_t();
+    auto threads      = uint32_t();
+    auto batch_blocks = uint32_t();
+    auto act_vers     = std::vector<std::string>();
+
+    auto desc = bpo::options_description("Exports the actions of a block range in blocks.log into columnar files partitioned by action name");
+    desc.add_options()
+        ("help,h", "print this help message and exit")
+        ("blocks-dir", bpo::value<std::string>(&blocks_dir)->default_value("blocks"), "the directory containing the block log to export")
+        ("output-dir", bpo::value<std::string>(&output_dir)->required(), "the directory to write the partitions into")
+        ("start-block", bpo::value<uint32_t>(&start_block)->default_value(1), "the first block to export")
+        ("end-block", bpo::value<uint32_t>(&end_block)->default_value(0), "the last block to export, 0 means the head of the log")
+        ("threads", bpo::value<uint32_t>(&threads)->default_value(std::max(1u, std::thread::hardware_concurrency())), "number of threads decoding blocks")
+        ("batch-blocks", bpo::value<uint32_t>(&batch_blocks)->default_value(1000), "number of blocks decoded together by one thread")
+        ("action-version", bpo::value<std::vector<std::string>>(&act_vers)->composing(), "pin the version of one action instead of detecting it, in form of 'action=version'");
+
+    try {
+        auto vm = bpo::variables_map();
+        bpo::store(bpo::parse_command_line(argc, argv, desc), vm);
+        if(vm.count("help")) {
+            std::cout << desc << std::endl;
+            return 0;
+        }
+        bpo::notify(vm);
+
+        FC_ASSERT(threads > 0 && batch_blocks > 0, "'threads' and 'batch-blocks' should be positive");
+
+        auto pinned = parse_action_versions(act_vers);
+        auto abi    = abi_serializer(contracts::evt_contract_abi(), std::chrono::hours(1));
+        auto blog   = block_log(blocks_dir);
+        auto head   = blog.read_head();
+        EVT_ASSERT(head, block_log_exception, "Block log is empty");
+
+        start_block = std::max(start_block, blog.first_block_num());
+        end_block   = end_block == 0 ? head->block_num() : std::min(end_block, head->block_num());
+        FC_ASSERT(start_block <= end_block, "Invalid block range: [${s}, ${e}]", ("s", start_block)("e", end_block));
+
+        // block log is read on this thread, decoding runs on the others and
+        // results are written back in order so each partition stays sorted by block
+        auto partitions = std::map<std::string, std::unique_ptr<partition_writer>>();
+        auto pending    = std::deque<std::future<batch_result>>();
+        auto rows       = uint64_t();
+
+        auto write_front = [&] {
+            auto result = pending.front().get();
+            pending.pop_front();
+
+            for(auto& [act, cols] : result) {
+                auto& pw = partitions[act];
+                if(!pw) {
+                    pw = std::make_unique<partition_writer>(fc::path(output_dir) / act);
+                }
+                pw->append(cols);
+                rows += cols.block_nums.size();
+            }
+        };
+
+        for(auto n = (uint64_t)start_block; n <= end_block; n += batch_blocks) {
+            auto last    = std::min<uint64_t>(n + batch_blocks - 1, end_block);
+            auto sblocks = std::vector<block_log::serialized_block>();
+            sblocks.reserve(last - n + 1);
+            for(auto i = n; i <= last; i++) {
+                auto sb = blog.read_serialized_block_by_num((uint32_t)i);
+                EVT_ASSERT(!sb.data.empty(), block_log_exception, "Block ${n} is missing in block log", ("n", i));
+                sblocks.emplace_back(std::move(sb));
+            }
+
+            if(pending.size() >= threads) {
+                write_front();
+            }
+            pending.emplace_back(std::async(std::launch::async, [&abi, &pinned, sblocks = std::move(sblocks)] {
+                return decode_blocks(sblocks, abi, pinned);
+            }));
+        }
+        while(!pending.empty()) {
+            write_front();
+        }
+
+        for(auto& it : partitions) {
+            it.second->finalize();
+        }
+        std::cout << "Exported " << rows << " actions of blocks [" << start_block << ", " << end_block << "] into "
+                  << partitions.size() << " partitions in '" << output_dir << "'" << std::endl;
+        return 0;
+    }
+    catch(const fc::exception& e) {
+        std::cerr << e.to_detail_string() << std::endl;
+    }
+    catch(const boost::exception& e) {
+        std::cerr << boost::diagnostic_information(e) << std::endl;
+    }
+    catch(const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+    }
+    return 1;
+}
@@ -0,0 +1,890 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <random>
+#include <set>
+#include <thread>
+#include <boost/algorithm/string.hpp>
+#include <boost/asio/connect.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/read.hpp>
+#include <boost/asio/write.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/program_options.hpp>
+#include <boost/exception/diagnostic_information.hpp>
+
+#include <lz4.h>
+
+#include <fc/filesystem.hpp>
+#include <fc/io/json.hpp>
+#include <fc/exception/exception.hpp>
+#include <evt/chain/transaction.hpp>
+#include <evt/chain/contracts/types.hpp>
+#include <evt/net_plugin/protocol.hpp>
+
+/*
+ * Load generator of evtd
+ *
+ * `generate` pre-signs transactions into region files, in the same format as the ones
+ * of loadtest/trafficgen: a sequence of records, each one is the uint16 size of the json
+ * of a packed transaction, the uint16 size of it compressed and the lz4 block.
+ * Regions are generated in parallel, actions of one region depend on the earlier ones
+ * (tokens are issued in a domain created before), so each region is kept in order.
+ *
+ * `run` replays the regions at a fixed rate, open loop: a request is sent when it's due
+ * no matter how many are still waiting for responses, and its latency is counted from then.
+ *   evtlg generate --chain-id <id> --ref-block-id <id> --regions 8 --total 100000 --action newdomain=1 --action issuetoken=20 ...
+ *   evtlg run --input-folder . --rate 5000 --batch 10
+ *
+ * everipay links carry the time they're signed at (`--link-time`), evtd refuses them once older
+ * than `evt_link_expired_secs` of the chain config, so runs with everipay need a large one in genesis.
+ */
+
+namespace bpo   = boost::program_options;
+namespace beast = boost::beast;
+namespace http  = boost::beast::http;
+using boost::asio::ip::tcp;
+using namespace evt::chain;
+using namespace evt::chain::contracts;
+
+namespace {
+
+using steady_clock = std::chrono::steady_clock;
+
+/**
+ * Region file of lz4 compressed records
+ */
+class region_writer {
+public:
+    region_writer(const fc::path& path)
+        : fs_(path.generic_string(), std::ios::binary) {
+        FC_ASSERT(fs_, "Cannot open ${p} to write", ("p", path));
+    }
+
+public:
+    void
+    write(const std::string& record) {
+        FC_ASSERT(record.size() <= std::numeric_limits<uint16_t>::max(), "Record is too large");
+
+        buf_.resize(LZ4_compressBound((int)record.size()));
+        auto csize = LZ4_compress_default(record.data(), buf_.data(), (int)record.size(), (int)buf_.size());
+        FC_ASSERT(csize > 0 && csize <= std::numeric_limits<uint16_t>::max(), "Cannot compress record");
+
+        auto sizes = std::array<uint16_t, 2>{ (uint16_t)record.size(), (uint16_t)csize };
+        fs_.write((const char*)sizes.data(), sizeof(sizes));
+        fs_.write(buf_.data(), csize);
+    }
+
+private:
+    std::ofstream     fs_;
+    std::vector<char> buf_;
+};
+
+std::vector<std::string>
+read_region(const fc::path& path) {
+    auto fs = std::ifstream(path.generic_string(), std::ios::binary);
+    FC_ASSERT(fs, "Cannot open ${p} to read", ("p", path));
+
+    auto records = std::vector<std::string>();
+    auto buf     = std::vector<char>();
+    auto sizes   = std::array<uint16_t, 2>();
+    while(fs.read((char*)sizes.data(), sizeof(sizes))) {
+        buf.resize(sizes[1]);
+        FC_ASSERT(fs.read(buf.data(), sizes[1]), "Truncated record in ${p}", ("p", path));
+
+        auto& r = records.emplace_back(sizes[0], '\0');
+        auto  n = LZ4_decompress_safe(buf.data(), r.data(), sizes[1], sizes[0]);
+        FC_ASSERT(n == sizes[0], "Invalid record in ${p}", ("p", path));
+    }
+    return records;
+}
+
+/**
+ * Parameters shared by all the regions when generating
+ */
+struct generate_config {
+    chain_id_type                 chain_id = chain_id_type(fc::sha256());
+    block_id_type                 ref_block_id;
+    fc::time_point_sec            expiration;
+    fc::time_point_sec            link_time;
+    std::optional<private_key_type> payer_key;
+    uint32_t                      max_charge = 0;
+    uint32_t                      total      = 0;
+    uint32_t                      max_users  = 0;
+    uint32_t                      symbol_id_base = 0;
+    std::map<std::string, uint32_t> weights;
+};
+
+/**
+ * Items created in one region so far, later actions pick from them like trafficgen does
+ */
+class region_generator {
+public:
+    region_generator(const generate_config& conf, const std::string& name, uint32_t index)
+        : conf_(conf)
+        , name_(name)
+        , next_sym_id_(conf.symbol_id_base + index * conf.total)
+        , rng_(std::hash<std::string>()(name) ^ fc::time_point::now().time_since_epoch().count()) {
+        for(auto i = 0u; i < conf.max_users; i++) {
+            auto key = private_key_type::generate();
+            users_.emplace_back(user{ key, key.get_public_key() });
+        }
+    }
+
+public:
+    // actions are drawn at random until each one reaches its share of the total
+    uint32_t
+    generate(region_writer& writer) {
+        auto sum = 0u;
+        for(auto& it : conf_.weights) {
+            sum += it.second;
+        }
+
+        auto left = std::map<std::string, uint32_t>();
+        for(auto& it : conf_.weights) {
+            auto n = (uint32_t)std::llround((double)it.second / sum * conf_.total);
+            if(n > 0) {
+                left[it.first] = n;
+            }
+        }
+
+        auto n = 0u;
+        while(!left.empty()) {
+            auto ready = std::vector<std::string>();
+            for(auto& it : left) {
+                if(satisfied(it.first)) {
+                    ready.emplace_back(it.first);
+                }
+            }
+            FC_ASSERT(!ready.empty(), "Actions left cannot be generated without their prerequisites: ${a}", ("a", left));
+
+            auto& act = ready[pick(ready.size())];
+            writer.write(make_transaction(act));
+            n++;
+
+            if(--left[act] == 0) {
+                left.erase(act);
+            }
+        }
+        return n;
+    }
+
+private:
+    struct user {
+        private_key_type priv;
+        public_key_type  pub;
+    };
+
+    struct domain_item {
+        name128 name;
+        size_t  creator;
+    };
+
+    struct token_item {
+        name128 domain;
+        name128 name;
+        size_t  owner;
+    };
+
+    struct fungible_item {
+        symbol              sym;
+        size_t              creator;
+        std::vector<size_t> holders;
+    };
+
+    size_t pick(size_t n) { return std::uniform_int_distribution<size_t>(0, n - 1)(rng_); }
+
+    std::string
+    fake_name(const std::string& prefix, size_t len = 8) {
+        static const char chars[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+
+        auto s = prefix;
+        for(auto i = 0u; i < len; i++) {
+            s += chars[pick(sizeof(chars) - 1)];
+        }
+        return s;
+    }
+
+    static permission_def
+    make_permission(name pname, const authorizer_ref& ref) {
+        auto p      = permission_def();
+        p.name      = pname;
+        p.threshold = 1;
+        p.authorizers.emplace_back(ref, 1);
+        return p;
+    }
+
+    static authorizer_ref
+    account_ref(const public_key_type& key) {
+        auto ref = authorizer_ref();
+        ref.set_account(key);
+        return ref;
+    }
+
+    bool
+    satisfied(const std::string& act) const {
+        if(act == "issuetoken") {
+            return !domains_.empty();
+        }
+        if(act == "transfer") {
+            return !tokens_.empty();
+        }
+        if(act == "issuefungible") {
+            return !fungibles_.empty();
+        }
+        if(act == "transferft" || act == "everipay") {
+            return std::any_of(fungibles_.begin(), fungibles_.end(), [](auto& f) { return !f.holders.empty(); });
+        }
+        return true;
+    }
+
+    fungible_item&
+    pick_held_fungible() {
+        auto held = std::vector<size_t>();
+        for(auto i = 0u; i < fungibles_.size(); i++) {
+            if(!fungibles_[i].holders.empty()) {
+                held.emplace_back(i);
+            }
+        }
+        return fungibles_[held[pick(held.size())]];
+    }
+
+    // returns the action and the users who sign it
+    std::pair<action, std::vector<size_t>>
+    make_action(const std::string& act) {
+        if(act == "newdomain") {
+            auto creator = pick(users_.size());
+            auto nd      = newdomain();
+            nd.name      = name128(fake_name(name_));
+            nd.creator   = users_[creator].pub;
+            nd.issue     = make_permission(N(issue), account_ref(nd.creator));
+            nd.manage    = make_permission(N(manage), account_ref(nd.creator));
+
+            auto owner = authorizer_ref();
+            owner.set_owner();
+            nd.transfer = make_permission(N(transfer), owner);
+
+            domains_.emplace_back(domain_item{ nd.name, creator });
+            return { action(nd.name, N128(.create), nd), { creator } };
+        }
+        if(act == "issuetoken") {
+            auto& d     = domains_[pick(domains_.size())];
+            auto  owner = pick(users_.size());
+            auto  it    = issuetoken();
+            it.domain   = d.name;
+            it.names.emplace_back(name128(fake_name("tk")));
+            it.owner.emplace_back(users_[owner].pub);
+
+            tokens_.emplace_back(token_item{ d.name, it.names[0], owner });
+            return { action(d.name, N128(.issue), it), { d.creator } };
+        }
+        if(act == "transfer") {
+            auto& t   = tokens_[pick(tokens_.size())];
+            auto  old = t.owner;
+            auto  tt  = transfer();
+            tt.domain = t.domain;
+            tt.name   = t.name;
+            tt.memo   = fake_name("memo");
+
+            t.owner = pick(users_.size());
+            tt.to.emplace_back(users_[t.owner].pub);
+            return { action(t.domain, t.name, tt), { old } };
+        }
+        if(act == "newfungible") {
+            auto creator = pick(users_.size());
+            auto sym     = symbol(5, next_sym_id_++);
+            auto nf      = newfungible();
+            nf.name      = name128(fake_name(name_));
+            nf.sym_name  = name128(fake_name(name_, 4));
+            nf.sym       = sym;
+            nf.creator   = users_[creator].pub;
+            nf.issue     = make_permission(N(issue), account_ref(nf.creator));
+            nf.manage    = make_permission(N(manage), account_ref(nf.creator));
+            nf.total_supply = asset(1'000'000'000'000'000, sym);
+
+            fungibles_.emplace_back(fungible_item{ sym, creator, {} });
+            return { action(N128(.fungible), name128::from_number(sym.id()), nf), { creator } };
+        }
+        if(act == "issuefungible") {
+            auto& f      = fungibles_[pick(fungibles_.size())];
+            auto  holder = pick(users_.size());
+            auto  isf    = issuefungible();
+            isf.address  = users_[holder].pub;
+            isf.number   = asset(100'000'000, f.sym);
+            isf.memo     = fake_name("memo");
+
+            f.holders.emplace_back(holder);
+            return { action(N128(.fungible), name128::from_number(f.sym.id()), isf), { f.creator } };
+        }
+        if(act == "transferft") {
+            auto& f    = pick_held_fungible();
+            auto  from = f.holders[pick(f.holders.size())];
+            auto  tf   = transferft();
+            tf.from    = users_[from].pub;
+            tf.to      = users_[pick(users_.size())].pub;
+            tf.number  = asset(1, f.sym);
+            tf.memo    = fake_name("memo");
+            return { action(N128(.fungible), name128::from_number(f.sym.id()), tf), { from } };
+        }
+        if(act == "everipay") {
+            auto& f     = pick_held_fungible();
+            auto  payer = f.holders[pick(f.holders.size())];
+
+            auto link = evt_link();
+            link.set_header(evt_link::version1 | evt_link::everiPay);
+            link.add_segment(evt_link::segment(evt_link::timestamp, conf_.link_time.sec_since_epoch()));
+            link.add_segment(evt_link::segment(evt_link::max_pay, 1000));
+            link.add_segment(evt_link::segment(evt_link::symbol_id, f.sym.id()));
+            link.add_segment(evt_link::segment(evt_link::link_id, fake_name("", 16)));
+            link.sign(users_[payer].priv);
+
+            auto ep   = everipay();
+            ep.link   = std::move(link);
+            ep.payee  = users_[(payer + 1 + pick(users_.size() - 1)) % users_.size()].pub;
+            ep.number = asset(1, f.sym);
+            return { action(N128(.fungible), name128::from_number(f.sym.id()), ep), { payer } };
+        }
+        FC_THROW("Unknown action: ${a}", ("a", act));
+    }
+
+    std::string
+    make_transaction(const std::string& act) {
+        auto [a, signers] = make_action(act);
+
+        auto trx = signed_transaction();
+        trx.expiration = conf_.expiration;
+        trx.set_reference_block(conf_.ref_block_id);
+        trx.max_charge = conf_.max_charge;
+        trx.payer      = conf_.payer_key.has_value() ? conf_.payer_key->get_public_key() : users_[signers[0]].pub;
+        trx.actions.emplace_back(std::move(a));
+
+        std::sort(signers.begin(), signers.end());
+        signers.erase(std::unique(signers.begin(), signers.end()), signers.end());
+        for(auto s : signers) {
+            trx.sign(users_[s].priv, conf_.chain_id);
+        }
+        if(conf_.payer_key.has_value()) {
+            trx.sign(*conf_.payer_key, conf_.chain_id);
+        }
+        return fc::json::to_string(fc::variant(packed_transaction(std::move(trx))));
+    }
+
+private:
+    const generate_config& conf_;
+    std::string            name_;
+    uint32_t               next_sym_id_;
+    std::mt19937_64        rng_;
+
+    std::vector<user>          users_;
+    std::vector<domain_item>   domains_;
+    std::vector<token_item>    tokens_;
+    std::vector<fungible_item> fungibles_;
+};
+
+int
+generate(int argc, char** argv) {
+    auto chain_id     = std::string();
+    auto ref_block_id = std::string();
+    auto payer_key    = std::string();
+    auto folder       = std::string();
+    auto expiration   = uint32_t();
+    auto link_time    = uint32_t();
+    auto regions      = uint32_t();
+    auto threads      = uint32_t();
+    auto actions      = std::vector<std::string>();
+    auto conf         = generate_config();
+
+    auto desc = bpo::options_description("Pre-signs transactions of several regions into lz4 region files");
+    desc.add_options()
+        ("help,h", "print this help message and exit")
+        ("chain-id", bpo::value<std::string>(&chain_id)->required(), "id of the chain to sign for")
+        ("ref-block-id", bpo::value<std::string>(&ref_block_id)->required(), "id of a recent block the transactions refer to")
+        ("expiration", bpo::value<uint32_t>(&expiration)->default_value(3000), "seconds from now the transactions expire at")
+        ("link-time", bpo::value<uint32_t>(&link_time)->default_value(0), "unix time of everipay links, 0 means now")
+        ("payer-key", bpo::value<std::string>(&payer_key), "private key of the payer of all transactions, otherwise the first signer pays")
+        ("max-charge", bpo::value<uint32_t>(&conf.max_charge)->default_value(10000), "max charge of each transaction")
+        ("regions,r", bpo::value<uint32_t>(&regions)->default_value(1), "number of regions")
+        ("total,n", bpo::value<uint32_t>(&conf.total)->default_value(10), "number of transactions in each region")
+        ("max-users,m", bpo::value<uint32_t>(&conf.max_users)->default_value(10), "number of users in each region")
+        ("symbol-id-base", bpo::value<uint32_t>(&conf.symbol_id_base)->default_value(100000), "first symbol id of the fungibles created")
+        ("threads,j", bpo::value<uint32_t>(&threads)->default_value(std::max(1u, std::thread::hardware_concurrency())), "number of threads generating regions")
+        ("output-folder,o", bpo::value<std::string>(&folder)->default_value("./"), "folder to write the region files into")
+        ("action", bpo::value<std::vector<std::string>>(&actions)->composing(),
+            "weight of an action in form of 'action=weight', one of newdomain, issuetoken, transfer, newfungible, issuefungible, transferft and everipay");
+
+    auto vm = bpo::variables_map();
+    bpo::store(bpo::parse_command_line(argc, argv, desc), vm);
+    if(vm.count("help")) {
+        std::cout << desc << std::endl;
+        return 0;
+    }
+    bpo::notify(vm);
+
+    static const auto known = std::set<std::string>{ "newdomain", "issuetoken", "transfer", "newfungible", "issuefungible", "transferft", "everipay" };
+    for(auto& a : actions) {
+        auto pos = a.find('=');
+        FC_ASSERT(pos != std::string::npos, "Invalid action: ${a}, should be in form of 'action=weight'", ("a", a));
+
+        auto act = a.substr(0, pos);
+        FC_ASSERT(known.count(act), "Unknown action: ${a}", ("a", act));
+        conf.weights[act] = std::stoul(a.substr(pos + 1));
+    }
+    FC_ASSERT(!conf.weights.empty(), "No action is configured");
+    FC_ASSERT(conf.max_users >= 2 && threads > 0, "'max-users' should be at least 2 and 'threads' should be positive");
+
+    conf.chain_id     = chain_id_type(fc::sha256(chain_id));
+    conf.ref_block_id = block_id_type(ref_block_id);
+    conf.expiration   = fc::time_point_sec(fc::time_point::now()) + expiration;
+    conf.link_time    = link_time > 0 ? fc::time_point_sec(link_time) : fc::time_point_sec(fc::time_point::now());
+    if(!payer_key.empty()) {
+        conf.payer_key = private_key_type(payer_key);
+    }
+    fc::create_directories(folder);
+
+    // two letters names like trafficgen, so the files may be replayed by the wrk script too
+    auto names = std::vector<std::string>();
+    for(auto i = 0u; i < regions; i++) {
+        names.emplace_back(std::string{ (char)('A' + i / 26 % 26), (char)('A' + i % 26) });
+    }
+
+    auto next  = std::atomic<uint32_t>(0);
+    auto total = std::atomic<uint64_t>(0);
+    auto error = std::exception_ptr();
+    auto mtx   = std::mutex();
+    auto start = steady_clock::now();
+
+    auto workers = std::vector<std::thread>();
+    for(auto t = 0u; t < std::min(threads, regions); t++) {
+        workers.emplace_back([&] {
+            for(auto i = next++; i < regions; i = next++) {
+                try {
+                    auto writer = region_writer(fc::path(folder) / (names[i] + "_traffic_data.lz4"));
+                    auto gen    = region_generator(conf, names[i], i);
+                    total += gen.generate(writer);
+                }
+                catch(...) {
+                    auto lock = std::lock_guard(mtx);
+                    error     = std::current_exception();
+                    return;
+                }
+            }
+        });
+    }
+    for(auto& w : workers) {
+        w.join();
+    }
+    if(error) {
+        std::rethrow_exception(error);
+    }
+
+    auto secs = std::chrono::duration<double>(steady_clock::now() - start).count();
+    std::cout << "Generated " << total << " transactions of " << regions << " regions in " << std::fixed << std::setprecision(2)
+              << secs << "s (" << (uint64_t)(total / secs) << " trx/s) into '" << folder << "'" << std::endl;
+    return 0;
+}
+
+/**
+ * Requests due to be sent, shared by the senders
+ */
+struct request {
+    std::string                body;
+    uint32_t                   trxs = 0;
+    steady_clock::time_point   due;
+};
+
+class request_queue {
+public:
+    void
+    push(request&& r) {
+        {
+            auto lock = std::lock_guard(mtx_);
+            queue_.emplace_back(std::move(r));
+        }
+        cv_.notify_one();
+    }
+
+    bool
+    pop(request& r) {
+        auto lock = std::unique_lock(mtx_);
+        cv_.wait(lock, [&] { return !queue_.empty() || closed_; });
+        if(queue_.empty()) {
+            return false;
+        }
+        r = std::move(queue_.front());
+        queue_.pop_front();
+        return true;
+    }
+
+    void
+    close() {
+        {
+            auto lock = std::lock_guard(mtx_);
+            closed_   = true;
+        }
+        cv_.notify_all();
+    }
+
+private:
+    std::mutex              mtx_;
+    std::condition_variable cv_;
+    std::deque<request>     queue_;
+    bool                    closed_ = false;
+};
+
+struct run_stats {
+    std::vector<uint64_t>   latencies_us;
+    std::map<int, uint64_t> statuses;  // by http status, 0 for connection errors
+
+    void
+    merge(const run_stats& o) {
+        latencies_us.insert(latencies_us.end(), o.latencies_us.begin(), o.latencies_us.end());
+        for(auto& it : o.statuses) {
+            statuses[it.first] += it.second;
+        }
+    }
+};
+
+// sends requests over one keep-alive connection, reconnects after errors
+void
+http_sender(const tcp::resolver::results_type& endpoints, const std::string& host, const std::string& target,
+            request_queue& queue, run_stats& stats) {
+    auto ioc    = boost::asio::io_context();
+    auto socket = std::optional<tcp::socket>();
+    auto buffer = beast::flat_buffer();
+
+    auto r = request();
+    while(queue.pop(r)) {
+        auto status = 0;
+        try {
+            if(!socket.has_value()) {
+                socket.emplace(ioc);
+                boost::asio::connect(*socket, endpoints);
+                socket->set_option(tcp::no_delay(true));
+            }
+
+            auto req = http::request<http::string_body>(http::verb::post, target, 11);
+            req.set(http::field::host, host);
+            req.set(http::field::content_type, "application/json");
+            req.keep_alive(true);
+            req.body() = std::move(r.body);
+            req.prepare_payload();
+            http::write(*socket, req);
+
+            auto res = http::response<http::string_body>();
+            http::read(*socket, buffer, res);
+            status = res.result_int();
+            if(!res.keep_alive()) {
+                socket.reset();
+            }
+        }
+        catch(const std::exception&) {
+            socket.reset();
+            buffer.consume(buffer.size());
+        }
+
+        auto latency = std::chrono::duration_cast<std::chrono::microseconds>(steady_clock::now() - r.due).count();
+        stats.latencies_us.emplace_back(latency);
+        stats.statuses[status] += r.trxs;
+    }
+}
+
+// reads and drops whatever the peer sends, stops at its go away message
+void
+p2p_reader(tcp::socket& socket, std::atomic<bool>& stopped) {
+    try {
+        auto payload = std::vector<char>();
+        while(!stopped) {
+            auto size = uint32_t();
+            boost::asio::read(socket, boost::asio::buffer(&size, sizeof(size)));
+            payload.resize(size);
+            boost::asio::read(socket, boost::asio::buffer(payload));
+
+            auto ds    = fc::datastream<const char*>(payload.data(), payload.size());
+            auto which = fc::unsigned_int();
+            fc::raw::unpack(ds, which);
+            if(which.value == evt::net_message::tag<evt::go_away_message>::value) {
+                auto msg = evt::go_away_message();
+                fc::raw::unpack(ds, msg);
+                std::cerr << "Peer closed the connection: " << evt::reason_str(msg.reason) << std::endl;
+                stopped = true;
+            }
+        }
+    }
+    catch(const std::exception& e) {
+        if(!stopped) {
+            std::cerr << "Connection to peer is lost: " << e.what() << std::endl;
+            stopped = true;
+        }
+    }
+}
+
+std::string
+pack_message(const evt::net_message& msg) {
+    auto payload = fc::raw::pack(msg);
+    auto size    = (uint32_t)payload.size();
+
+    auto buf = std::string((const char*)&size, sizeof(size));
+    buf.append(payload.data(), payload.size());
+    return buf;
+}
+
+void
+print_results(const run_stats& stats, uint64_t trxs, uint64_t requests, double secs, double rate) {
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Sent " << trxs << " transactions in " << requests << " requests over " << secs << "s, "
+              << (uint64_t)(trxs / secs) << " trx/s of " << (uint64_t)rate << " trx/s targeted" << std::endl;
+    if(stats.latencies_us.empty()) {
+        return;
+    }
+
+    std::cout << "Transactions by status:";
+    for(auto& it : stats.statuses) {
+        std::cout << " " << (it.first == 0 ? std::string("error") : std::to_string(it.first)) << "=" << it.second;
+    }
+    std::cout << std::endl;
+
+    auto lats = stats.latencies_us;
+    std::sort(lats.begin(), lats.end());
+    auto pct = [&](double q) { return lats[std::min(lats.size() - 1, (size_t)(q * lats.size()))] / 1000.0; };
+    std::cout << "Latency of requests (ms): p50=" << pct(0.5) << " p90=" << pct(0.9) << " p99=" << pct(0.99)
+              << " p99.9=" << pct(0.999) << " max=" << lats.back() / 1000.0 << std::endl;
+
+    // requests under each power of two of milliseconds
+    auto buckets = std::map<uint64_t, uint64_t>();
+    for(auto us : lats) {
+        auto bound = uint64_t(1);
+        while(bound * 1000 < us) {
+            bound *= 2;
+        }
+        buckets[bound]++;
+    }
+    auto most = std::max_element(buckets.begin(), buckets.end(), [](auto& a, auto& b) { return a.second < b.second; })->second;
+    for(auto& it : buckets) {
+        std::cout << std::setw(8) << it.first << "ms |" << std::left << std::setw(50) << std::string(it.second * 50 / most, '#')
+                  << std::right << " " << it.second << std::endl;
+    }
+}
+
+std::pair<std::string, std::string>
+split_endpoint(const std::string& ep) {
+    auto pos = ep.rfind(':');
+    FC_ASSERT(pos != std::string::npos, "Invalid endpoint: ${e}, should be in form of 'host:port'", ("e", ep));
+    return { ep.substr(0, pos), ep.substr(pos + 1) };
+}
+
+int
+run(int argc, char** argv) {
+    auto folder      = std::string();
+    auto mode        = std::string();
+    auto http_ep     = std::string();
+    auto p2p_ep      = std::string();
+    auto chain_id    = std::string();
+    auto rate        = double();
+    auto batch       = uint32_t();
+    auto connections = uint32_t();
+    auto limit       = uint64_t();
+    auto regions     = std::vector<std::string>();
+
+    auto desc = bpo::options_description("Replays region files to evtd at a fixed rate");
+    desc.add_options()
+        ("help,h", "print this help message and exit")
+        ("input-folder,i", bpo::value<std::string>(&folder)->default_value("./"), "folder of the region files")
+        ("region", bpo::value<std::vector<std::string>>(&regions)->composing(), "names of the regions to replay, all files in the folder by default")
+        ("mode", bpo::value<std::string>(&mode)->default_value("http"), "'http' pushes the transactions through chain api, 'p2p' sends them as a peer")
+        ("http-endpoint", bpo::value<std::string>(&http_ep)->default_value("127.0.0.1:8888"), "http endpoint of evtd")
+        ("p2p-endpoint", bpo::value<std::string>(&p2p_ep)->default_value("127.0.0.1:7888"), "p2p endpoint of evtd")
+        ("chain-id", bpo::value<std::string>(&chain_id), "id of the chain, required by the p2p handshake")
+        ("rate", bpo::value<double>(&rate)->default_value(1000), "transactions sent per second")
+        ("batch", bpo::value<uint32_t>(&batch)->default_value(1), "transactions in each request, more than one are sent to push_transactions")
+        ("connections", bpo::value<uint32_t>(&connections)->default_value(64), "http connections sending requests")
+        ("limit", bpo::value<uint64_t>(&limit)->default_value(0), "max number of transactions to send, 0 sends all of them");
+
+    auto vm = bpo::variables_map();
+    bpo::store(bpo::parse_command_line(argc, argv, desc), vm);
+    if(vm.count("help")) {
+        std::cout << desc << std::endl;
+        return 0;
+    }
+    bpo::notify(vm);
+
+    FC_ASSERT(mode == "http" || mode == "p2p", "Invalid mode: ${m}", ("m", mode));
+    FC_ASSERT(rate > 0 && batch > 0 && connections > 0, "'rate', 'batch' and 'connections' should be positive");
+
+    if(regions.empty()) {
+        for(auto it = fc::directory_iterator(folder); it != fc::directory_iterator(); it++) {
+            auto f = it->filename().generic_string();
+            if(boost::algorithm::ends_with(f, "_traffic_data.lz4")) {
+                regions.emplace_back(f.substr(0, f.find('_')));
+            }
+        }
+        std::sort(regions.begin(), regions.end());
+    }
+    FC_ASSERT(!regions.empty(), "No region file is found in '${f}'", ("f", folder));
+
+    // regions are interleaved, transactions of each one keep their order
+    auto per_region = std::vector<std::vector<std::string>>();
+    for(auto& r : regions) {
+        per_region.emplace_back(read_region(fc::path(folder) / (r + "_traffic_data.lz4")));
+    }
+    auto records = std::vector<std::string>();
+    for(auto i = 0u; ; i++) {
+        auto any = false;
+        for(auto& r : per_region) {
+            if(i < r.size()) {
+                records.emplace_back(std::move(r[i]));
+                any = true;
+            }
+        }
+        if(!any || (limit > 0 && records.size() >= limit)) {
+            break;
+        }
+    }
+    if(limit > 0 && records.size() > limit) {
+        records.resize(limit);
+    }
+    std::cout << "Loaded " << records.size() << " transactions of " << regions.size() << " regions" << std::endl;
+
+    auto ioc      = boost::asio::io_context();
+    auto resolver = tcp::resolver(ioc);
+    auto stats    = run_stats();
+    auto requests = uint64_t(0);
+    auto sent     = uint64_t(0);
+    auto interval = std::chrono::duration<double>(1.0 / rate);
+    auto start    = steady_clock::now();
+
+    if(mode == "http") {
+        auto [host, port] = split_endpoint(http_ep);
+        auto endpoints    = resolver.resolve(host, port);
+        auto target       = std::string(batch > 1 ? "/v1/chain/push_transactions" : "/v1/chain/push_transaction");
+
+        auto queue   = request_queue();
+        auto results = std::vector<run_stats>(connections);
+        auto senders = std::vector<std::thread>();
+        for(auto i = 0u; i < connections; i++) {
+            senders.emplace_back([&, i, host = host] {
+                http_sender(endpoints, host, target, queue, results[i]);
+            });
+        }
+
+        start = steady_clock::now();
+        for(auto i = 0ul; i < records.size(); i += batch) {
+            auto r = request();
+            r.trxs = (uint32_t)std::min<size_t>(batch, records.size() - i);
+            r.due  = start + std::chrono::duration_cast<steady_clock::duration>(interval * i);
+            if(batch > 1) {
+                r.body = "[";
+                for(auto j = 0u; j < r.trxs; j++) {
+                    r.body += (j > 0 ? "," : "") + records[i + j];
+                }
+                r.body += "]";
+            }
+            else {
+                r.body = std::move(records[i]);
+            }
+
+            requests++;
+            sent += r.trxs;
+            std::this_thread::sleep_until(r.due);
+            queue.push(std::move(r));
+        }
+        queue.close();
+        for(auto& s : senders) {
+            s.join();
+        }
+        for(auto& r : results) {
+            stats.merge(r);
+        }
+    }
+    else {
+        FC_ASSERT(!chain_id.empty(), "'chain-id' is required in p2p mode");
+
+        auto buffers = std::vector<std::string>();
+        buffers.reserve(records.size());
+        for(auto& r : records) {
+            auto ptrx = fc::json::from_string(r).as<packed_transaction>();
+            buffers.emplace_back(pack_message(ptrx));
+        }
+
+        auto [host, port] = split_endpoint(p2p_ep);
+        auto socket       = tcp::socket(ioc);
+        boost::asio::connect(socket, resolver.resolve(host, port));
+        socket.set_option(tcp::no_delay(true));
+
+        // an empty chain, so the peer only tries to sync from itself
+        auto hs             = evt::handshake_message();
+        hs.network_version  = 0x04b5;  // net_version_base of net_plugin with the base protocol
+        hs.chain_id         = chain_id_type(fc::sha256(chain_id));
+        hs.node_id          = fc::sha256::hash(fc::to_string(fc::time_point::now().time_since_epoch().count()));
+        hs.time             = std::chrono::system_clock::now().time_since_epoch().count();
+        hs.p2p_address      = "evtlg:0 - " + hs.node_id.str().substr(0, 7);
+        hs.os               = "linux";
+        hs.agent            = "evtlg";
+        hs.generation       = 1;
+        boost::asio::write(socket, boost::asio::buffer(pack_message(hs)));
+
+        auto stopped = std::atomic<bool>(false);
+        auto reader  = std::thread([&] { p2p_reader(socket, stopped); });
+
+        start = steady_clock::now();
+        for(auto i = 0ul; i < buffers.size() && !stopped; i++) {
+            std::this_thread::sleep_until(start + std::chrono::duration_cast<steady_clock::duration>(interval * i));
+            boost::asio::write(socket, boost::asio::buffer(buffers[i]));
+            requests++;
+            sent++;
+        }
+
+        stopped = true;
+        boost::system::error_code ec;
+        socket.shutdown(tcp::socket::shutdown_both, ec);
+        socket.close(ec);
+        reader.join();
+    }
+
+    auto secs = std::chrono::duration<double>(steady_clock::now() - start).count();
+    print_results(stats, sent, requests, secs, rate);
+    return 0;
+}
+
+}  // namespace
+
+int
+main(int argc, char** argv) {
+    auto usage = "Usage: evtlg <generate|run> [options], see evtlg <command> --help";
+    if(argc < 2) {
+        std::cerr << usage << std::endl;
+        return 1;
+    }
+
+    try {
+        auto cmd = std::string(argv[1]);
+        if(cmd == "generate") {
+            return generate(argc - 1, argv + 1);
+        }
+        if(cmd == "run") {
+            return run(argc - 1, argv + 1);
+        }
+        std::cerr << usage << std::endl;
+    }
+    catch(const fc::exception& e) {
+        std::cerr << e.to_detail_string() << std::endl;
+    }
+    catch(const boost::exception& e) {
+        std::cerr << boost::diagnostic_information(e) << std::endl;
+    }
+    catch(const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+    }
+    return 1;
+}
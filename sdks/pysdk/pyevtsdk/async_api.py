@@ -0,0 +1,87 @@
+import asyncio
+import json
+
+import aiohttp
+
+from . import transaction
+from .api import URLS
+
+# limit of the node on transactions pushed in one request
+MAX_BATCH_SIZE = 1000
+
+
+class AsyncApi:
+    '''
+    Asyncio client of a node, requests share a pool of `connections` keep-alive connections.
+    Use it as an async context manager, or call `close` when done
+    '''
+
+    def __init__(self, host='https://testnet1.everitoken.io:8888', connections=16):
+        self.host = host
+        self.urls = URLS
+        self.session = aiohttp.ClientSession(
+            connector=aiohttp.TCPConnector(limit=connections))
+
+    async def __aenter__(self):
+        return self
+
+    async def __aexit__(self, *args):
+        await self.close()
+
+    async def close(self):
+        await self.session.close()
+
+    async def post(self, url, data):
+        async with self.session.post(url, data=data) as resp:
+            return resp.status, await resp.text()
+
+    def __getattr__(self, api_name):
+        url = self.host + self.urls[api_name]
+
+        async def ret_func(data):
+            return await self.post(url, data)
+        return ret_func
+
+    async def get_info(self):
+        async with self.session.get(self.host + '/v1/chain/get_info') as resp:
+            return await resp.text()
+
+    async def push_transactions(self, trxs, batch_size=100, pipeline=4, threads=0):
+        '''
+        Pushes `trxs` in batches of `batch_size`, with up to `pipeline` batches in flight.
+        Unsigned `transaction.Transaction`s are signed in bulk a batch at a time by up to `threads`
+        workers of libevt, off the event loop so the next batch is signed while the previous ones
+        are pushed. Signed ones may also be given as dicts or JSON strings.
+
+        Returns the result of each transaction in order, the ones of a failed batch are
+        {'error': response of the node}
+        '''
+        batch_size = max(1, min(batch_size, MAX_BATCH_SIZE))
+        batches = [trxs[i:i + batch_size]
+                   for i in range(0, len(trxs), batch_size)]
+        slots = asyncio.Semaphore(max(1, pipeline))
+        loop = asyncio.get_event_loop()
+        url = self.host + self.urls['push_transactions']
+
+        async def push(batch):
+            async with slots:
+                unsigned = [trx for trx in batch if isinstance(
+                    trx, transaction.Transaction)]
+                if unsigned:
+                    signed = iter(await loop.run_in_executor(None, transaction.sign_transactions, unsigned, threads))
+                    batch = [next(signed) if isinstance(
+                        trx, transaction.Transaction) else trx for trx in batch]
+
+                data = '[' + ','.join(trx if isinstance(trx, str)
+                                      else json.dumps(trx) for trx in batch) + ']'
+                status, text = await self.post(url, data)
+                if status == 202:
+                    return json.loads(text)
+                try:
+                    error = json.loads(text)
+                except ValueError:
+                    error = text
+                return [{'error': error}] * len(batch)
+
+        results = await asyncio.gather(*[push(batch) for batch in batches])
+        return [r for rs in results for r in rs]
@@ -60,6 +60,13 @@ class Transaction:
             del ret['payer']
         return ret
 
+    def signed_dict(self):
+        return {
+            'signatures': self.signatures,
+            'compression': 'none',
+            'transaction': self.dict()
+        }
+
     def dumps(self):
         try:
             digest = abi.trx_json_to_digest(
@@ -70,12 +77,7 @@ class Transaction:
 
         self.signatures = [priv_key.sign_hash(
             digest).to_string() for priv_key in self.priv_keys]
-        ret = {
-            'signatures': self.signatures,
-            'compression': 'none',
-            'transaction': self.dict()
-        }
-        return json.dumps(ret)
+        return json.dumps(self.signed_dict())
 
 
 class TrxGenerator:
@@ -95,6 +97,39 @@ class TrxGenerator:
         return trx
 
 
+def sign_transactions(trxs, threads=0):
+    # Signs transactions in bulk: digests of the ones sharing a chain id are
+    # computed in one call, then all signatures are made in one call by up to
+    # `threads` workers of libevt. Returns the signed transactions as dicts
+    groups = {}
+    for i, trx in enumerate(trxs):
+        groups.setdefault(id(trx.chain_id), []).append(i)
+
+    digests = [None] * len(trxs)
+    for idx in groups.values():
+        jsons = [json.dumps(trxs[i].dict()) for i in idx]
+        try:
+            results = abi.trx_json_to_digest_many(jsons, trxs[idx[0]].chain_id)
+        except:
+            raise Exception('Invalid transactions', jsons)
+        for i, digest in zip(idx, results):
+            digests[i] = digest
+
+    keys, hashes = [], []
+    for trx, digest in zip(trxs, digests):
+        keys.extend(trx.priv_keys)
+        hashes.extend([digest] * len(trx.priv_keys))
+    signs = ecc.PrivateKey.sign_many(keys, hashes, threads) if keys else []
+
+    ret, pos = [], 0
+    for trx in trxs:
+        n = len(trx.priv_keys)
+        trx.signatures = [sign.to_string() for sign in signs[pos:pos + n]]
+        pos += n
+        ret.append(trx.signed_dict())
+    return ret
+
+
 def get_sign_transaction(priv_keys, transaction):
     digest = abi.trx_json_to_digest(transaction.dumps(), transaction.chain_id)
     signs = [each_priv_key.sign_hash(digest) for each_priv_key in priv_keys]
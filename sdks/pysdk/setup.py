@@ -2,7 +2,7 @@ from setuptools import find_packages, setup
 
 setup(
     name='pyevtsdk',
-    version='0.3',
+    version='0.4',
     author='everiToken',
     author_email='help@everitoken.io',
     description='Python SDK library for everiToken',
@@ -10,7 +10,7 @@ setup(
     license='MIT',
     url='https://github.com/everitoken/evt/tree/master/sdks/pysdk',
     packages=find_packages(),
-    install_requires=['pyevt', 'requests'],
+    install_requires=['pyevt', 'requests', 'aiohttp'],
     classifiers=[
         'Programming Language :: Python :: 3',
         'License :: OSI Approved :: MIT License',
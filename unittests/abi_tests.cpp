@@ -1742,3 +1742,59 @@ TEST_CASE_METHOD(abi_test, "setpsvbonus_v2_abi_test", "[abis]") {
     // restore back
     get_exec_ctx().set_version_unsafe("setpsvbonus", 1);
 }
+
+TEST_CASE_METHOD(abi_test, "reflected_abi_test", "[abis]") {
+    auto& abis = get_evt_abi();
+    auto& exec_ctx = get_exec_ctx();
+
+    // the same abi without any reflected type
+    auto walk = abi_serializer(evt_contract_abi(), std::chrono::hours(1));
+
+    CHECK(abis.is_reflected_type("transfer"));
+    CHECK(abis.is_reflected_type("transferft"));
+    CHECK(abis.is_reflected_type("everipay_v2"));
+    CHECK(!abis.is_reflected_type("newdomain"));  // has permissions
+    CHECK(!walk.is_reflected_type("transfer"));
+
+    auto check_same = [&](auto type, auto json) {
+        auto var = fc::json::from_string(json);
+
+        auto b1 = abis.variant_to_binary(type, var, exec_ctx);
+        auto b2 = walk.variant_to_binary(type, var, exec_ctx);
+        CHECK(fc::to_hex(b1) == fc::to_hex(b2));
+
+        auto v1 = abis.binary_to_variant(type, b1, exec_ctx);
+        auto v2 = walk.binary_to_variant(type, b2, exec_ctx);
+        CHECK(fc::json::to_string(v1) == fc::json::to_string(v2));
+    };
+
+    check_same("transfer", R"=====(
+    {
+      "domain": "cookie",
+      "name": "t1",
+      "to": ["EVT546WaW3zFAxEEEkYKjDiMvg3CHRjmWX2XdNxEhi69RpdKuQRSK"],
+      "memo": "memo"
+    }
+    )=====");
+    check_same("transferft", R"=====(
+    {
+      "from": "EVT546WaW3zFAxEEEkYKjDiMvg3CHRjmWX2XdNxEhi69RpdKuQRSK",
+      "to": "EVT546WaW3zFAxEEEkYKjDiMvg3CHRjmWX2XdNxEhi69RpdKuQRSK",
+      "number" : "12.00000 S#1",
+      "memo": "memo"
+    }
+    )=====");
+    // empty optional is null in both
+    check_same("everipay_v2", R"=====(
+    {
+      "link": "0UKDRJZA4Z9IR9TK4Q7BJP0SV-/$$XDADD03/37BOI3FPJ9C3_QUQ4A1GS9VJX-3MIKFBYFYHLZODIRRUAFEGFS6+*ZKN40BOMIY6/2CJGC04:VZFB8H3FZ91/TW*-8M02/GKDLUFE80HC8*LI",
+      "payee": "EVT8HdQYD1xfKyD7Hyu2fpBUneamLMBXmP3qsYX6HoTw7yonpjWyC",
+      "number": "5.00000 S#1"
+    }
+    )=====");
+
+    // missing fields are still rejected
+    auto missing = fc::json::from_string(R"=====({"domain": "cookie", "name": "t1", "memo": "memo"})=====");
+    CHECK_THROWS_AS(abis.variant_to_binary("transfer", missing, exec_ctx), pack_exception);
+    CHECK_THROWS_AS(walk.variant_to_binary("transfer", missing, exec_ctx), pack_exception);
+}
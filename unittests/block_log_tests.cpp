@@ -0,0 +1,161 @@
+#include <catch/catch.hpp>
+#include <fc/filesystem.hpp>
+
+#include <evt/chain/block_log.hpp>
+
+using namespace evt;
+using namespace chain;
+
+extern std::string evt_unittests_dir;
+
+namespace {
+
+std::vector<signed_block_ptr>
+make_blocks(uint32_t n) {
+    auto blocks = std::vector<signed_block_ptr>();
+    auto prev   = block_id_type();
+    for(auto i = 0u; i < n; i++) {
+        auto b       = std::make_shared<signed_block>();
+        b->previous  = prev;
+        b->timestamp = block_timestamp_type(i + 1);
+        prev         = b->id();
+        blocks.emplace_back(std::move(b));
+    }
+    return blocks;
+}
+
+}  // namespace
+
+TEST_CASE("framed_block_log_test", "[block_log]") {
+    auto src_dir = fc::path(evt_unittests_dir) / "block_log_tests" / "src";
+    auto dst_dir = fc::path(evt_unittests_dir) / "block_log_tests" / "dst";
+    fc::remove_all(src_dir);
+    fc::remove_all(dst_dir);
+
+    auto blocks = make_blocks(20);
+    {
+        auto blog = block_log(src_dir);
+        blog.reset(genesis_state(), blocks[0]);
+        for(auto i = 1u; i < blocks.size(); i++) {
+            blog.append(blocks[i]);
+        }
+    }
+
+    CHECK(block_log::convert_to_frames(src_dir, dst_dir, 8, 3) == 20);
+
+    auto extra = std::make_shared<signed_block>();
+    extra->previous  = blocks.back()->id();
+    extra->timestamp = block_timestamp_type(21);
+    {
+        auto blog = block_log(dst_dir);
+        CHECK(blog.head()->id() == blocks.back()->id());
+        for(auto& b : blocks) {
+            CHECK(blog.read_block_by_num(b->block_num())->id() == b->id());
+        }
+
+        // appended blocks go into frames of their own
+        blog.append(extra);
+        CHECK(blog.read_block_by_num(21)->id() == extra->id());
+        CHECK(!blog.read_serialized_block_by_num(21).data.empty());
+        CHECK(blog.read_serialized_block_by_num(22).data.empty());
+    }
+
+    // index rebuilt from the frames
+    fc::remove_all(dst_dir / "blocks.index");
+    {
+        auto blog = block_log(dst_dir);
+        CHECK(blog.read_head()->id() == extra->id());
+        CHECK(blog.read_block_by_num(9)->id() == blocks[8]->id());
+        CHECK(blog.read_block_by_num(21)->id() == extra->id());
+    }
+}
+
+TEST_CASE("construct_index_test", "[block_log]") {
+    auto dir = fc::path(evt_unittests_dir) / "block_log_tests" / "index";
+    fc::remove_all(dir);
+
+    auto blocks = make_blocks(50);
+    {
+        auto blog = block_log(dir);
+        blog.reset(genesis_state(), blocks[0]);
+        for(auto i = 1u; i < blocks.size(); i++) {
+            blog.append(blocks[i]);
+        }
+    }
+
+    fc::remove_all(dir / "blocks.index");
+    {
+        auto blog = block_log(dir);
+        for(auto& b : blocks) {
+            CHECK(blog.read_block_by_num(b->block_num())->id() == b->id());
+        }
+    }
+
+    // intact log is copied as is
+    auto backup = block_log::repair_log(dir);
+    CHECK(fc::file_size(backup / "blocks.log") == fc::file_size(dir / "blocks.log"));
+
+    // repairs the backup in place and keeps blocks up to 30
+    block_log::repair_log(backup, 30);
+    {
+        auto blog = block_log(backup);
+        CHECK(blog.head()->block_num() == 30);
+        CHECK(blog.read_block_by_num(30)->id() == blocks[29]->id());
+    }
+}
+
+TEST_CASE("pruned_block_log_test", "[block_log]") {
+    auto dir = fc::path(evt_unittests_dir) / "block_log_tests" / "pruned";
+    fc::remove_all(dir);
+
+    // segments of 2 blocks, the ones all older than the latest 8 blocks are removed
+    auto blocks = make_blocks(20);
+    {
+        auto blog = block_log(dir, 8);
+        blog.reset(genesis_state(), blocks[0]);
+        for(auto i = 1u; i < blocks.size(); i++) {
+            blog.append(blocks[i]);
+        }
+
+        CHECK(blog.first_block_num() == 19);
+        CHECK(blog.first_available_block_num() == 11);
+        CHECK(blog.read_block_by_num(10) == nullptr);
+        for(auto n = 11u; n <= 20; n++) {
+            CHECK(blog.read_block_by_num(n)->id() == blocks[n - 1]->id());
+        }
+    }
+    CHECK(!fc::exists(dir / "segments" / "0000000009-0000000010"));
+
+    {
+        auto blog = block_log(dir, 8);
+        CHECK(blog.head()->id() == blocks.back()->id());
+        CHECK(blog.first_available_block_num() == 11);
+        CHECK(blog.read_block_by_num(12)->id() == blocks[11]->id());
+
+        // a new log drops all the segments
+        blog.reset(genesis_state(), blocks[0]);
+        CHECK(blog.first_available_block_num() == 1);
+        CHECK(blog.read_block_by_num(12) == nullptr);
+    }
+    CHECK(!fc::exists(dir / "segments"));
+}
+
+TEST_CASE("sync_block_log_test", "[block_log]") {
+    auto dir = fc::path(evt_unittests_dir) / "block_log_tests" / "sync";
+    fc::remove_all(dir);
+
+    auto blocks = make_blocks(4);
+    {
+        auto blog = block_log(dir);
+        blog.reset(genesis_state(), blocks[0]);
+        blog.append(blocks[1]);
+        CHECK_NOTHROW(blog.sync());
+        blog.append(blocks[2]);
+        blog.append(blocks[3]);
+        CHECK_NOTHROW(blog.sync());
+    }
+
+    auto blog = block_log(dir);
+    CHECK(blog.read_head()->id() == blocks[3]->id());
+    CHECK(blog.read_block_by_num(2)->id() == blocks[1]->id());
+}
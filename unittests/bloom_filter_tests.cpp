@@ -0,0 +1,40 @@
+#include <catch/catch.hpp>
+
+#include <fc/crypto/city.hpp>
+#include <evt/utilities/bloom_filter.hpp>
+
+using evt::utilities::scalable_bloom_filter;
+
+namespace {
+
+uint64_t
+hash_of(uint64_t v) {
+    return fc::city_hash64((const char*)&v, sizeof(v));
+}
+
+}  // namespace
+
+TEST_CASE("test_scalable_bloom_filter", "[bloom_filter]") {
+    auto bf = scalable_bloom_filter(1000);
+    CHECK(!bf.may_contain(hash_of(1)));
+
+    // grows over several stages, never misses an added key
+    for(auto i = 0u; i < 100000; i++) {
+        bf.add(hash_of(i));
+    }
+    CHECK(bf.size() == 100000);
+    for(auto i = 0u; i < 100000; i++) {
+        REQUIRE(bf.may_contain(hash_of(i)));
+    }
+
+    auto fp = 0u;
+    for(auto i = 100000u; i < 200000; i++) {
+        fp += bf.may_contain(hash_of(i));
+    }
+    CHECK(fp < 2000);
+
+    bf.clear();
+    CHECK(bf.size() == 0);
+    CHECK(bf.memory_usage() == 0);
+    CHECK(!bf.may_contain(hash_of(1)));
+}
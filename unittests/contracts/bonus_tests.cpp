@@ -407,4 +407,110 @@ TEST_CASE_METHOD(contracts_test, "passive_bonus_dist_test", "[contracts]") {
     CHECK(pb.methods.size() == pb2->methods.size());
     CHECK(pb.round == pb2->round);
     CHECK(pb.deadline == pb2->deadline);
-}
\ No newline at end of file
+}
+
+TEST_CASE_METHOD(contracts_test, "passive_bonus_dist_v2_test", "[contracts]") {
+    auto& tokendb = my_tester->control->token_db();
+
+    auto actkey     = name128::from_number(get_sym_id());
+    auto bonus_addr = address(N(.psvbonus), actkey, 0);
+    auto keyseeds   = std::vector<name>{ N(key2), N(payer) };
+
+    my_tester->control->get_execution_context().set_version(N(distpsvbonus), 2);
+
+    auto dpb        = distpsvbonus_v2();
+    dpb.sym_id      = get_sym().id();
+    dpb.deadline    = my_tester->control->head_block_time();
+    dpb.max_holders = 1;
+
+    CHECK_THROWS_AS(my_tester->push_action(action(N128(.psvbonus), actkey, dpb), keyseeds, payer), bonus_unreached_dist_threshold);
+
+    auto transfer_evt = [&] {
+        auto tf   = transferft();
+        tf.from   = payer;
+        tf.to     = tester::get_public_key(N(to3));
+        tf.number = asset(1'00000, evt_sym());
+
+        my_tester->push_action(action(N128(.fungible), name128::from_number(evt_sym().id()), tf), key_seeds, payer);
+    };
+
+    auto transfer_sym = [&] {
+        auto tf   = transferft();
+        tf.from   = key;
+        tf.to     = tester::get_public_key(N(to3));
+        tf.number = asset(2'00000, get_sym());
+
+        my_tester->push_action(action(N128(.fungible), actkey, tf), key_seeds, payer);
+    };
+
+    // total: 0.2 * 300 = 60
+    for(int i = 0; i < 300; i++) {
+        transfer_sym();
+        my_tester->produce_block();
+    }
+    transfer_evt();
+    my_tester->produce_block();
+
+    auto collected = property();
+    READ_DB_ASSET(bonus_addr, get_sym(), collected);
+    CHECK(collected.amount >= 50'00000);
+
+    auto sum_holders = [&](symbol sym) {
+        auto total = int64_t(0);
+        tokendb.read_assets_range(sym.id(), 0, [&](auto&, auto&& v) {
+            auto p = property();
+            extract_db_value(v, p);
+            total += p.amount;
+            return true;
+        });
+        return total;
+    };
+
+    // holders of rule 2 and rule 4 when the round starts
+    auto evt_total = sum_holders(evt_sym());
+    auto sym_total = sum_holders(get_sym());
+
+    // the first action starts the round and moves the collected bonus at once
+    my_tester->push_action(action(N128(.psvbonus), actkey, dpb), keyseeds, payer);
+    my_tester->produce_block();
+
+    {
+        property bonus;
+        READ_DB_ASSET(bonus_addr, get_sym(), bonus);
+        CHECK(bonus.amount == 0);
+    }
+
+    {
+        property bonus;
+        READ_DB_ASSET(address(N(.psvbonus), actkey, 2), get_sym(), bonus);
+        CHECK(bonus.amount == collected.amount);
+    }
+
+    // each chunk has one holder, holders scanned and not yet are changed between the chunks
+    auto chunks = 1;
+    while(!tokendb.exists_token(token_type::psvbonus_dist, std::nullopt, get_psvbonus_db_key(get_sym_id(), 2))) {
+        REQUIRE(chunks < 10000);
+
+        transfer_evt();
+        transfer_sym();
+        my_tester->push_action(action(N128(.psvbonus), actkey, dpb), keyseeds, payer);
+        my_tester->produce_block();
+        chunks++;
+    }
+    CHECK(chunks > 1);
+    CHECK(tokendb.exists_token(token_type::psvbonus_dist, std::nullopt, get_psvbonus_db_key(get_sym_id(), (1ull << 32) | 2)));
+
+    // totals are the ones of the holders when the round started
+    auto summary = passive_bonus_build();
+    READ_TOKEN2(psvbonus_dist, std::nullopt, get_psvbonus_db_key(get_sym_id(), 2), summary);
+    CHECK(summary.round == 2);
+    CHECK(summary.chunks + 1 == (uint32_t)chunks);  // the last action finds no holders left
+    CHECK(summary.totals.size() == 5);
+    CHECK(summary.totals[2] == evt_total);
+    CHECK(summary.totals[4] == sym_total);
+
+    // next round starts only when the threshold is reached again
+    CHECK_THROWS_AS(my_tester->push_action(action(N128(.psvbonus), actkey, dpb), keyseeds, payer), bonus_unreached_dist_threshold);
+
+    my_tester->control->get_execution_context().set_version_unsafe(N(distpsvbonus), 1);
+}
@@ -243,3 +243,66 @@ TEST_CASE_METHOD(contracts_test, "everipay_test", "[contracts]") {
     // restore everiPay version
     my_tester->control->get_execution_context().set_version_unsafe(N(everipay), 0);
 }
+
+TEST_CASE("evt_link_cache_test", "[contracts]") {
+    auto key1 = private_key_type::generate();
+    auto key2 = private_key_type::generate();
+
+    auto link = evt_link();
+    link.set_header(evt_link::version1 | evt_link::everiPay);
+    link.add_segment(evt_link::segment(evt_link::timestamp, 1532465234));
+    link.add_segment(evt_link::segment(evt_link::symbol_id, 1));
+    link.add_segment(evt_link::segment(evt_link::link_id, "KIJHNHFMJDUKJUAB"));
+    link.sign(key1);
+
+    auto stats = evt_link::get_cache_stats();
+    CHECK(link.restore_keys() == public_keys_set{ key1.get_public_key() });
+    CHECK(link.restore_keys() == public_keys_set{ key1.get_public_key() });
+    CHECK(evt_link::get_cache_stats().keys_hits == stats.keys_hits + 1);
+
+    // signed by another key, recovered again
+    link.clear_signatures();
+    link.sign(key2);
+    CHECK(link.restore_keys() == public_keys_set{ key2.get_public_key() });
+    CHECK(evt_link::get_cache_stats().keys_hits == stats.keys_hits + 1);
+
+    // other segments under the same signature
+    link.add_segment(evt_link::segment(evt_link::link_id, "KIJHNHFMJDUKJUAC"));
+    CHECK(link.restore_keys() != public_keys_set{ key2.get_public_key() });
+    CHECK(evt_link::get_cache_stats().keys_hits == stats.keys_hits + 1);
+
+    link.clear_signatures();
+    link.sign(key1);
+    auto str = link.to_string();
+    auto l1  = evt_link::parse_from_evtli(str);
+    auto l2  = evt_link::parse_from_evtli(str);
+    CHECK(evt_link::get_cache_stats().parse_hits == stats.parse_hits + 1);
+    CHECK(l2.get_link_id() == link.get_link_id());
+    CHECK(l2.get_signatures() == link.get_signatures());
+    CHECK(l1.restore_keys() == l2.restore_keys());
+
+    // disabled
+    evt_link::set_cache_size(0);
+    stats = evt_link::get_cache_stats();
+    CHECK(link.restore_keys() == public_keys_set{ key1.get_public_key() });
+    CHECK(link.restore_keys() == public_keys_set{ key1.get_public_key() });
+    CHECK_NOTHROW(evt_link::parse_from_evtli(str));
+    CHECK(evt_link::get_cache_stats().keys_hits == stats.keys_hits);
+    CHECK(evt_link::get_cache_stats().parse_hits == stats.parse_hits);
+
+    evt_link::set_cache_size(evt_link::kDefaultCacheSize);
+}
+
+TEST_CASE_METHOD(contracts_test, "block_id_for_num_test", "[contracts]") {
+    my_tester->produce_blocks(3);
+
+    auto head = my_tester->control->head_block_num();
+    for(auto n = head - 2; n <= head; n++) {
+        CHECK(my_tester->control->get_block_id_for_num(n) == my_tester->control->fetch_block_by_number(n)->id());
+    }
+
+    // not produced yet, the slots of these in block summaries hold older blocks
+    CHECK_THROWS_AS(my_tester->control->get_block_id_for_num(head + 1), unknown_block_exception);
+    CHECK_THROWS_AS(my_tester->control->get_block_id_for_num(head + 65536), unknown_block_exception);
+    CHECK_THROWS_AS(my_tester->control->get_block_id_for_num(head - 1 + 65536), unknown_block_exception);
+}
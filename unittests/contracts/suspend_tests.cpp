@@ -271,3 +271,93 @@ TEST_CASE_METHOD(contracts_test, "successsuspend_test", "[contracts]") {
     CHECK(suspend2 != nullptr);
     CHECK_EQUAL(suspend, *suspend2);
 }
+
+TEST_CASE_METHOD(contracts_test, "suspend_required_keys_test", "[contracts]") {
+    const char* newdomain_test_data = R"=====(
+        {
+          "name" : "domain",
+          "creator" : "EVT5ve9Ezv9vLZKp1NmRzvB5ZoZ21YZ533BSB2Ai2jLzzMep6biU2",
+          "issue" : {
+            "name" : "issue",
+            "threshold" : 1,
+            "authorizers": [{
+                "ref": "[G] .OWNER",
+                "weight": 1
+              }
+            ]
+          },
+          "transfer": {
+            "name": "transfer",
+            "threshold": 1,
+            "authorizers": [{
+                "ref": "[G] .OWNER",
+                "weight": 1
+              }
+            ]
+          },
+          "manage": {
+            "name": "manage",
+            "threshold": 1,
+            "authorizers": [{
+                "ref": "[G] .OWNER",
+                "weight": 1
+              }
+            ]
+          }
+        }
+        )=====";
+
+    auto key1 = tester::get_public_key(N(key1));
+    auto key2 = tester::get_public_key(N(key2));
+
+    auto make_newdomain = [&](auto name, auto& creator) {
+        auto var    = fc::json::from_string(newdomain_test_data);
+        auto nd     = var.as<newdomain>();
+        nd.name     = name;
+        nd.creator  = creator;
+        to_variant(nd, var);
+        return my_tester->get_action(N(newdomain), name, N128(.create), var.get_object());
+    };
+
+    auto act1 = make_newdomain(N128(domain1), key1);
+    auto act2 = make_newdomain(N128(domain2), key1);
+    auto act3 = make_newdomain(N128(domain3), key2);
+
+    auto trx = transaction();
+    trx.payer = address(N(.domain), N128(domain1), 0);
+
+    // keys required by evaluating every action on its own
+    auto required_each = [&](auto& candidates) {
+        auto keys = public_keys_set();
+        for(auto& act : trx.actions) {
+            auto t = trx;
+            t.actions = { act };
+            auto k = my_tester->control->get_suspend_required_keys(t, candidates);
+            keys.insert(k.cbegin(), k.cend());
+        }
+        return keys;
+    };
+
+    // all candidates used by the first action, the rest are skipped
+    trx.actions = { act1, act2, act3 };
+    auto candidates = public_keys_set{ key1 };
+    CHECK(my_tester->control->get_suspend_required_keys(trx, candidates) == public_keys_set{ key1 });
+    CHECK(my_tester->control->get_suspend_required_keys(trx, candidates) == required_each(candidates));
+
+    // all candidates used only after the last action
+    candidates = public_keys_set{ key1, key2 };
+    CHECK(my_tester->control->get_suspend_required_keys(trx, candidates) == public_keys_set{ key1, key2 });
+    CHECK(my_tester->control->get_suspend_required_keys(trx, candidates) == required_each(candidates));
+
+    // used in the middle with actions left which need other keys
+    trx.actions = { act3, act1, act2 };
+    candidates  = public_keys_set{ key2 };
+    CHECK(my_tester->control->get_suspend_required_keys(trx, candidates) == public_keys_set{ key2 });
+    CHECK(my_tester->control->get_suspend_required_keys(trx, candidates) == required_each(candidates));
+
+    // payer's key is always required
+    trx.payer = address(key2);
+    candidates = public_keys_set{ key1 };
+    CHECK(my_tester->control->get_suspend_required_keys(trx, candidates) == public_keys_set{ key1, key2 });
+    CHECK(my_tester->control->get_suspend_required_keys(trx, candidates) == required_each(candidates));
+}
@@ -64,6 +64,46 @@ TEST_CASE_METHOD(contracts_test, "prodvote_test", "[contracts]") {
     my_tester->produce_blocks();
 }
 
+TEST_CASE_METHOD(contracts_test, "prodvote_trx_compression_test", "[contracts]") {
+    auto make_trx = [&](auto num) {
+        auto tf   = transferft();
+        tf.from   = payer;
+        tf.to     = tester::get_public_key(N(to3));
+        tf.number = asset(num, evt_sym());
+
+        auto trx = signed_transaction();
+        trx.actions.emplace_back(action(N128(.fungible), name128::from_number(evt_sym().id()), tf));
+        my_tester->set_transaction_headers(trx, payer);
+        trx.sign(tester::get_private_key(N(payer)), my_tester->control->get_chain_id());
+        return trx;
+    };
+
+    CHECK(my_tester->control->get_max_trx_compression() == packed_transaction::zlib);
+
+    auto ptrx1 = packed_transaction(make_trx(1), packed_transaction::zlib);
+    CHECK_NOTHROW(my_tester->push_transaction(ptrx1));
+
+    // zstd is rejected before it's voted in
+    auto ptrx2 = packed_transaction(make_trx(2), packed_transaction::zstd);
+    CHECK_THROWS_AS(my_tester->push_transaction(ptrx2), unknown_transaction_compression);
+
+    auto pv     = prodvote();
+    pv.producer = N(evt);
+    pv.key      = N128(trx-compression);
+    pv.value    = packed_transaction::zstd + 1;
+
+    auto prodkeys = std::vector<name>{ N(evt), N(payer) };
+    CHECK_THROWS_AS(my_tester->push_action(action(N128(.prodvote), pv.key, pv), prodkeys, payer), prodvote_value_exception);
+
+    pv.value = packed_transaction::zstd;
+    my_tester->push_action(action(N128(.prodvote), pv.key, pv), prodkeys, payer);
+    CHECK(my_tester->control->get_max_trx_compression() == packed_transaction::zstd);
+
+    CHECK_NOTHROW(my_tester->push_transaction(ptrx2));
+
+    my_tester->produce_blocks();
+}
+
 TEST_CASE_METHOD(contracts_test, "charge_test", "[contracts]") {
     const char* test_data = R"=====(
     {
@@ -279,6 +319,75 @@ TEST_CASE_METHOD(contracts_test, "addmeta_test", "[contracts]") {
     my_tester->produce_blocks();
 }
 
+TEST_CASE_METHOD(contracts_test, "addmeta_v2_test", "[contracts]") {
+    const char* test_data = R"=====(
+    {
+      "key": "key3",
+      "value": "value3",
+      "creator": "[A] EVT6MRyAjQq8ud7hVNYcfnVPJqcVpscN5So8BhtHuGYqET5GDW5CV"
+    }
+    )=====";
+
+    auto var  = fc::json::from_string(test_data);
+    auto admt = var.as<addmeta_v2>();
+    auto& tokendb = my_tester->control->token_db();
+
+    admt.creator = key;
+    to_variant(admt, var);
+
+    my_tester->control->get_execution_context().set_version(N(addmeta), 2);
+
+    auto domain = domain_def();
+    READ_TOKEN(domain, get_domain_name(), domain);
+    auto fungible = fungible_def();
+    READ_TOKEN(fungible, get_sym_id(), fungible);
+    auto group = group_def();
+    READ_TOKEN(group, get_group_name(), group);
+
+    my_tester->push_action(N(addmeta), name128(get_domain_name()), N128(.meta), var.get_object(), key_seeds, payer, 5'000'000);
+    my_tester->push_action(N(addmeta), N128(.group), name128(get_group_name()), var.get_object(), key_seeds, payer, 5'000'000);
+    my_tester->push_action(N(addmeta), N128(.fungible), (name128)std::to_string(get_sym_id()), var.get_object(), key_seeds, payer, 5'000'000);
+
+    // parents are left untouched
+    auto domain2 = domain_def();
+    READ_TOKEN(domain, get_domain_name(), domain2);
+    CHECK(domain2.metas.size() == domain.metas.size());
+    auto fungible2 = fungible_def();
+    READ_TOKEN(fungible, get_sym_id(), fungible2);
+    CHECK(fungible2.metas.size() == fungible.metas.size());
+    auto group2 = group_def();
+    READ_TOKEN(group, get_group_name(), group2);
+    CHECK(group2.metas_.size() == group.metas_.size());
+
+    CHECK(EXISTS_TOKEN(meta, get_meta_db_key(N128(.domain), get_domain_name(), N128(key3))));
+    CHECK(EXISTS_TOKEN(meta, get_meta_db_key(N128(.group), get_group_name(), N128(key3))));
+    CHECK(EXISTS_TOKEN(meta, get_meta_db_key(N128(.fungible), name128::from_number(get_sym_id()), N128(key3))));
+
+    auto m = meta();
+    READ_TOKEN(meta, get_meta_db_key(N128(.domain), get_domain_name(), N128(key3)), m);
+    CHECK(m.key == N128(key3));
+    CHECK(m.value == "value3");
+
+    auto prefix = get_meta_db_key_prefix(N128(.domain), get_domain_name());
+    auto count  = tokendb.read_tokens_prefix(token_type::meta, std::nullopt, std::string_view((char*)&prefix, sizeof(prefix)), [](auto&, auto&&) { return true; });
+    CHECK(count == 1);
+
+    // duplicates are found either kept apart or inline
+    admt.value = "value4";
+    to_variant(admt, var);
+    CHECK_THROWS_AS(my_tester->push_action(N(addmeta), name128(get_domain_name()), N128(.meta), var.get_object(), key_seeds, payer, 5'000'000), meta_key_exception);
+    CHECK_THROWS_AS(my_tester->push_action(N(addmeta), N128(.group), name128(get_group_name()), var.get_object(), key_seeds, payer, 5'000'000), meta_key_exception);
+    CHECK_THROWS_AS(my_tester->push_action(N(addmeta), N128(.fungible), (name128)std::to_string(get_sym_id()), var.get_object(), key_seeds, payer, 5'000'000), meta_key_exception);
+
+    admt.key = N128(key);
+    to_variant(admt, var);
+    CHECK_THROWS_AS(my_tester->push_action(N(addmeta), name128(get_domain_name()), N128(.meta), var.get_object(), key_seeds, payer, 5'000'000), meta_key_exception);
+    CHECK_THROWS_AS(my_tester->push_action(N(addmeta), N128(.group), name128(get_group_name()), var.get_object(), key_seeds, payer, 5'000'000), meta_key_exception);
+
+    my_tester->control->get_execution_context().set_version_unsafe(N(addmeta), 1);
+    my_tester->produce_blocks();
+}
+
 TEST_CASE_METHOD(contracts_test, "updsched_test", "[contracts]") {
     const char* test_data = R"=======(
     {
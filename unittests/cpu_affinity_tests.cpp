@@ -0,0 +1,55 @@
+#include <catch/catch.hpp>
+
+#include <thread>
+#include <fc/exception/exception.hpp>
+#include <evt/utilities/cpu_affinity.hpp>
+
+using namespace evt::utilities::affinity;
+
+TEST_CASE("test_parse_cpu_list", "[cpu_affinity]") {
+    CHECK(parse_cpu_list("") == cpu_list{});
+    CHECK(parse_cpu_list("3") == cpu_list{ 3 });
+    CHECK(parse_cpu_list("0-3,8") == cpu_list{ 0, 1, 2, 3, 8 });
+    CHECK(parse_cpu_list(" 8, 2-3 ,3,0 ") == cpu_list{ 0, 2, 3, 8 });
+
+    CHECK_THROWS_AS(parse_cpu_list("a"), fc::parse_error_exception);
+    CHECK_THROWS_AS(parse_cpu_list("3-1"), fc::parse_error_exception);
+    CHECK_THROWS_AS(parse_cpu_list("1-"), fc::parse_error_exception);
+    CHECK_THROWS_AS(parse_cpu_list("-1"), fc::parse_error_exception);
+    CHECK_THROWS_AS(parse_cpu_list("node:100000"), fc::parse_error_exception);
+
+    CHECK(format_cpu_list({}) == "");
+    CHECK(format_cpu_list({ 0, 1, 2, 3, 8 }) == "0-3,8");
+    CHECK(format_cpu_list({ 1, 3, 4, 6 }) == "1,3-4,6");
+}
+
+TEST_CASE("test_numa_nodes", "[cpu_affinity]") {
+    auto online = get_online_cpus();
+    auto nodes  = get_numa_nodes();
+    REQUIRE(!online.empty());
+    REQUIRE(!nodes.empty());
+
+    // node list resolves to the cpus of that node
+    auto& n = nodes.front();
+    CHECK(parse_cpu_list("node:" + std::to_string(n.id)) == n.cpus);
+    CHECK(!describe_topology().empty());
+}
+
+TEST_CASE("test_scoped_pin", "[cpu_affinity]") {
+    auto prev = get_current_affinity();
+    if(prev.empty()) {
+        return;  // not supported on this platform
+    }
+
+    auto one = cpu_list{ prev.front() };
+    {
+        auto pin = scoped_pin(one);
+        CHECK(get_current_affinity() == one);
+
+        // threads created inside inherit the pinned cpus
+        auto inherited = cpu_list();
+        std::thread([&] { inherited = get_current_affinity(); }).join();
+        CHECK(inherited == one);
+    }
+    CHECK(get_current_affinity() == prev);
+}
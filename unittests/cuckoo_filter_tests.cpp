@@ -0,0 +1,100 @@
+#include <catch/catch.hpp>
+
+#include <sstream>
+#include <fc/crypto/city.hpp>
+#include <evt/utilities/cuckoo_filter.hpp>
+
+using evt::utilities::cuckoo_filter;
+
+namespace {
+
+uint64_t
+hash_of(uint64_t v) {
+    return fc::city_hash64((const char*)&v, sizeof(v));
+}
+
+}  // namespace
+
+TEST_CASE("test_cuckoo_filter", "[cuckoo_filter]") {
+    auto cf = cuckoo_filter(100000);
+    CHECK(cf.capacity() >= 100000);
+    CHECK(!cf.may_contain(hash_of(1)));
+
+    for(auto i = 0u; i < 100000; i++) {
+        REQUIRE(cf.add(hash_of(i)));
+    }
+    CHECK(cf.size() == 100000);
+    for(auto i = 0u; i < 100000; i++) {
+        REQUIRE(cf.may_contain(hash_of(i)));
+    }
+
+    auto fp = 0u;
+    for(auto i = 100000u; i < 200000; i++) {
+        fp += cf.may_contain(hash_of(i));
+    }
+    CHECK(fp < 100);
+
+    // removed keys are gone, the others are kept
+    for(auto i = 0u; i < 100000; i += 2) {
+        REQUIRE(cf.remove(hash_of(i)));
+    }
+    CHECK(cf.size() == 50000);
+    for(auto i = 1u; i < 100000; i += 2) {
+        REQUIRE(cf.may_contain(hash_of(i)));
+    }
+    auto left = 0u;
+    for(auto i = 0u; i < 100000; i += 2) {
+        left += cf.may_contain(hash_of(i));
+    }
+    CHECK(left < 50);
+
+    cf.clear();
+    CHECK(cf.size() == 0);
+    CHECK(!cf.may_contain(hash_of(1)));
+}
+
+TEST_CASE("test_cuckoo_filter_full", "[cuckoo_filter]") {
+    auto cf = cuckoo_filter(1000);
+
+    // added keys are never missed, even the one left out when it's full
+    auto n = 0u;
+    while(cf.add(hash_of(n))) {
+        n++;
+    }
+    CHECK(cf.full());
+    CHECK(n >= cf.capacity());
+    CHECK(!cf.add(hash_of(n + 1)));
+    for(auto i = 0u; i <= n; i++) {
+        REQUIRE(cf.may_contain(hash_of(i)));
+    }
+
+    // removing keys makes room again
+    for(auto i = 0u; i < n / 4; i++) {
+        REQUIRE(cf.remove(hash_of(i)));
+    }
+    CHECK(!cf.full());
+    for(auto i = n / 4; i <= n; i++) {
+        REQUIRE(cf.may_contain(hash_of(i)));
+    }
+}
+
+TEST_CASE("test_cuckoo_filter_serialize", "[cuckoo_filter]") {
+    auto cf = cuckoo_filter(10000);
+    for(auto i = 0u; i < 10000; i++) {
+        cf.add(hash_of(i));
+    }
+
+    auto ss = std::stringstream();
+    cf.write(ss);
+
+    auto cf2 = cuckoo_filter(0);
+    REQUIRE(cf2.read(ss));
+    CHECK(cf2.size() == cf.size());
+    CHECK(cf2.memory_usage() == cf.memory_usage());
+    for(auto i = 0u; i < 10000; i++) {
+        REQUIRE(cf2.may_contain(hash_of(i)));
+    }
+
+    auto bad = std::stringstream(std::string(64, '\x3'));
+    CHECK(!cf2.read(bad));
+}
@@ -0,0 +1,116 @@
+#include <catch/catch.hpp>
+
+#include <chrono>
+#include <thread>
+#include <evt/chain/deadline_timer.hpp>
+#include <evt/chain/exceptions.hpp>
+
+using evt::chain::deadline_timer;
+
+namespace {
+
+struct watchdog_test {
+    watchdog_test() { deadline_timer::start_watchdog(); }
+    ~watchdog_test() { deadline_timer::stop_watchdog(); }
+};
+
+}  // namespace
+
+TEST_CASE_METHOD(watchdog_test, "test_deadline_timer_expires", "[deadline_timer]") {
+    auto t     = deadline_timer();
+    auto start = fc::time_point::now();
+    t.start(start + fc::milliseconds(20));
+    CHECK(!t.expired());
+
+    while(!t.expired()) {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+        REQUIRE(fc::time_point::now() - start < fc::seconds(5));
+    }
+    // never raised early
+    CHECK(fc::time_point::now() - start >= fc::milliseconds(20));
+
+    // restarting lowers the flag
+    t.start(fc::time_point::now() + fc::seconds(60));
+    CHECK(!t.expired());
+}
+
+TEST_CASE_METHOD(watchdog_test, "test_deadline_timer_passed_and_maximum", "[deadline_timer]") {
+    auto t   = deadline_timer();
+    auto now = fc::time_point::now();
+    t.start(now - fc::milliseconds(1), now);
+    CHECK(t.expired());
+
+    t.start(fc::time_point::maximum());
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    CHECK(!t.expired());
+}
+
+TEST_CASE_METHOD(watchdog_test, "test_deadline_timer_stop", "[deadline_timer]") {
+    auto t1 = deadline_timer();
+    auto t2 = deadline_timer();
+    t1.start(fc::time_point::now() + fc::milliseconds(5));
+    t2.start(fc::time_point::now() + fc::milliseconds(10));
+    t1.stop();
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    CHECK(!t1.expired());
+    CHECK(t2.expired());
+
+    {
+        // destroyed while running
+        auto t3 = deadline_timer();
+        t3.start(fc::time_point::now() + fc::milliseconds(1));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+}
+
+TEST_CASE("test_deadline_timer_watchdog", "[deadline_timer]") {
+    auto t = deadline_timer();
+
+    // deadlines which are not passed need the watchdog
+    auto now = fc::time_point::now();
+    CHECK_THROWS_AS(t.start(now + fc::seconds(60), now), evt::chain::misc_exception);
+    t.start(now - fc::milliseconds(1), now);
+    CHECK(t.expired());
+    t.start(fc::time_point::maximum());
+    CHECK(!t.expired());
+
+    // starts are counted
+    deadline_timer::start_watchdog();
+    deadline_timer::start_watchdog();
+    deadline_timer::stop_watchdog();
+    t.start(fc::time_point::now() + fc::milliseconds(1));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    CHECK(t.expired());
+
+    // stopped with a timer running, which is left unraised
+    t.start(fc::time_point::now() + fc::milliseconds(5));
+    deadline_timer::stop_watchdog();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    CHECK(!t.expired());
+    t.stop();
+
+    // and restarted
+    deadline_timer::start_watchdog();
+    t.start(fc::time_point::now() + fc::milliseconds(1));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    CHECK(t.expired());
+    deadline_timer::stop_watchdog();
+}
+
+TEST_CASE_METHOD(watchdog_test, "test_deadline_timer_coarse_now", "[deadline_timer]") {
+    // parked without timers, read from the clock
+    auto before = fc::time_point::now();
+    auto coarse = deadline_timer::coarse_now();
+    CHECK(coarse >= before);
+    CHECK(coarse <= fc::time_point::now());
+
+    auto t = deadline_timer();
+    t.start(fc::time_point::now() + fc::seconds(60));
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+    coarse   = deadline_timer::coarse_now();
+    auto now = fc::time_point::now();
+    CHECK(coarse <= now);
+    CHECK(now - coarse < fc::milliseconds(100));
+}
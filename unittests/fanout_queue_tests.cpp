@@ -0,0 +1,101 @@
+#include <catch/catch.hpp>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <evt/utilities/fanout_queue.hpp>
+
+using evt::utilities::fanout_queue;
+
+TEST_CASE("test_fanout_every_consumer", "[fanout_queue]") {
+    auto q = fanout_queue<int>(8);
+    q.push(0);  // no consumer, dropped
+
+    auto c1 = q.subscribe(8);
+    auto c2 = q.subscribe(8);
+    for(auto i = 1; i <= 5; i++) {
+        q.push(i);
+    }
+
+    auto r1 = std::vector<int>();
+    auto r2 = std::vector<int>();
+    CHECK(q.pop(c1, r1, 3, std::chrono::milliseconds(0)) == 3);
+    CHECK(q.pop(c1, r1, 10, std::chrono::milliseconds(0)) == 2);
+    CHECK(q.pop(c1, r1, 10, std::chrono::milliseconds(0)) == 0);
+    CHECK(q.pop(c2, r2, 10, std::chrono::milliseconds(0)) == 5);
+    CHECK(r1 == std::vector<int>{ 1, 2, 3, 4, 5 });
+    CHECK(r1 == r2);
+
+    // lag counts until acknowledged
+    CHECK(q.stats(c1).lag == 5);
+    CHECK(q.stats(c1).max_lag == 5);
+    q.ack(c1);
+    CHECK(q.stats(c1).lag == 0);
+    CHECK(q.stats(c1).read == 5);
+
+    // a late consumer starts at the next item
+    auto c3 = q.subscribe(8);
+    q.push(6);
+    auto r3 = std::vector<int>();
+    CHECK(q.pop(c3, r3, 10, std::chrono::milliseconds(0)) == 1);
+    CHECK(r3 == std::vector<int>{ 6 });
+
+    q.unsubscribe(c2);
+    CHECK(q.pop(c2, r2, 10, std::chrono::milliseconds(0)) == 0);
+    CHECK(q.stats(c2).read == 0);
+}
+
+TEST_CASE("test_fanout_back_pressure", "[fanout_queue]") {
+    auto q    = fanout_queue<int>(16);
+    auto fast = q.subscribe(16);
+    auto slow = q.subscribe(2);
+
+    auto producer = std::thread([&] {
+        for(auto i = 0; i < 100; i++) {
+            q.push(i);
+        }
+    });
+
+    auto got_fast = std::vector<int>();
+    auto got_slow = std::vector<int>();
+    while(got_fast.size() < 100 || got_slow.size() < 100) {
+        if(got_fast.size() < 100) {
+            q.pop(fast, got_fast, 100, std::chrono::milliseconds(1));
+        }
+        if(got_slow.size() < 100) {
+            q.pop(slow, got_slow, 1, std::chrono::milliseconds(1));
+        }
+        // the producer never runs more than the limit ahead of the slow consumer
+        CHECK(q.stats(slow).lag <= 2 + got_slow.size());
+    }
+    producer.join();
+
+    for(auto i = 0; i < 100; i++) {
+        REQUIRE(got_fast[i] == i);
+        REQUIRE(got_slow[i] == i);
+    }
+    q.ack(slow);
+    CHECK(q.stats(slow).lag == 0);
+    CHECK(q.stats(slow).max_lag == 100);
+}
+
+TEST_CASE("test_fanout_wait_idle", "[fanout_queue]") {
+    auto q = fanout_queue<int>(4);
+    auto c = q.subscribe(4);
+    q.push(1);
+    q.push(2);
+
+    auto handled = std::atomic_int(0);
+    auto consumer = std::thread([&] {
+        auto r = std::vector<int>();
+        while(r.size() < 2) {
+            q.pop(c, r, 1, std::chrono::milliseconds(10));
+        }
+        handled = 2;
+        q.ack(c);
+    });
+
+    q.wait_idle(c);
+    CHECK(handled == 2);
+    consumer.join();
+}
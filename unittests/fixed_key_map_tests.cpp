@@ -0,0 +1,75 @@
+#include <catch/catch.hpp>
+
+#include <map>
+#include <string>
+#include <evt/utilities/fixed_key_map.hpp>
+
+using evt::utilities::fixed_key_map;
+
+namespace {
+
+std::string
+key_of(uint32_t v) {
+    auto k = std::string(37, 'k');
+    memcpy(&k[3], &v, sizeof(v));
+    return k;
+}
+
+}  // namespace
+
+TEST_CASE("test_fixed_key_map", "[fixed_key_map]") {
+    auto m = fixed_key_map<37, std::string>();
+    CHECK(m.find(key_of(1)) == nullptr);
+    CHECK(m.find("short") == nullptr);
+
+    auto p = m.try_emplace(key_of(1));
+    CHECK(p.second);
+    p.first->second = "v1";
+    CHECK(p.first->key() == key_of(1));
+
+    auto p2 = m.try_emplace(key_of(1));
+    CHECK(!p2.second);
+    CHECK(p2.first == p.first);
+    CHECK(m.size() == 1);
+
+    // entries are not moved while the table grows
+    auto e1 = p.first;
+    for(auto i = 2u; i < 20000; i++) {
+        m.try_emplace(key_of(i)).first->second = std::to_string(i);
+    }
+    CHECK(m.size() == 19999);
+    CHECK(m.find(key_of(1)) == e1);
+    CHECK(e1->second == "v1");
+    for(auto i = 2u; i < 20000; i++) {
+        auto e = m.find(key_of(i));
+        REQUIRE(e != nullptr);
+        REQUIRE(e->second == std::to_string(i));
+    }
+    CHECK(m.find(key_of(20000)) == nullptr);
+
+    // erased entries are reused and the deleted slots are reclaimed
+    for(auto round = 0; round < 10; round++) {
+        for(auto i = 2u; i < 20000; i += 2) {
+            m.erase(m.find(key_of(i)));
+        }
+        for(auto i = 2u; i < 20000; i += 2) {
+            REQUIRE(m.find(key_of(i)) == nullptr);
+            REQUIRE(m.find(key_of(i + 1))->second == std::to_string(i + 1));
+        }
+        for(auto i = 2u; i < 20000; i += 2) {
+            REQUIRE(m.try_emplace(key_of(i)).second);
+            m.find(key_of(i))->second = std::to_string(i);
+        }
+    }
+    CHECK(m.size() == 19999);
+
+    auto seen = std::map<std::string, std::string>();
+    m.for_each([&](auto& e) { seen.emplace(e.key(), e.second); });
+    CHECK(seen.size() == 19999);
+    CHECK(seen[key_of(1)] == "v1");
+
+    m.clear();
+    CHECK(m.empty());
+    CHECK(m.memory_usage() == 0);
+    CHECK(m.find(key_of(1)) == nullptr);
+}
@@ -0,0 +1,67 @@
+#include <catch/catch.hpp>
+
+#include <optional>
+#include <string>
+#include <vector>
+#include <evt/utilities/fixed_signal.hpp>
+
+using evt::utilities::fixed_signal;
+using evt::utilities::scoped_signal_connection;
+using evt::utilities::signal_connection;
+using evt::utilities::slot_position;
+
+TEST_CASE("test_fixed_signal", "[fixed_signal]") {
+    auto sig   = fixed_signal<void(const std::string&), 4>();
+    auto calls = std::vector<std::string>();
+    CHECK(sig.empty());
+    sig("nothing");
+
+    auto c1 = sig.connect([&](auto& s) { calls.emplace_back("1" + s); });
+    auto c2 = sig.connect([&](auto& s) { calls.emplace_back("2" + s); });
+    auto c0 = sig.connect([&](auto& s) { calls.emplace_back("0" + s); }, slot_position::at_front);
+    CHECK(sig.num_slots() == 3);
+
+    sig("a");
+    CHECK(calls == std::vector<std::string>{ "0a", "1a", "2a" });
+
+    // disconnected slots are skipped, their entries are reused by the next ones
+    c1.disconnect();
+    CHECK(!c1.connected());
+    CHECK(c2.connected());
+    calls.clear();
+    sig("b");
+    CHECK(calls == std::vector<std::string>{ "0b", "2b" });
+
+    auto c3 = sig.connect([&](auto& s) { calls.emplace_back("3" + s); });
+    auto c4 = sig.connect([&](auto& s) { calls.emplace_back("4" + s); });
+    CHECK(sig.num_slots() == 4);
+    CHECK_THROWS(sig.connect([](auto&) {}));
+
+    // an old connection doesn't disconnect the slot reusing its entry
+    c1.disconnect();
+    calls.clear();
+    sig("c");
+    CHECK(calls == std::vector<std::string>{ "0c", "2c", "3c", "4c" });
+
+    {
+        auto sc = scoped_signal_connection(c2);
+        CHECK(sc.connected());
+    }
+    CHECK(!c2.connected());
+    CHECK(sig.num_slots() == 3);
+}
+
+TEST_CASE("test_fixed_signal_outlived", "[fixed_signal]") {
+    auto conn = std::optional<scoped_signal_connection>();
+    {
+        auto sig   = fixed_signal<void(int)>();
+        auto total = 0;
+        conn = sig.connect([&](int v) { total += v; });
+        sig(1);
+        sig(2);
+        CHECK(total == 3);
+    }
+    // the connection outlives the signal, disconnecting it is fine
+    CHECK(conn->connected());
+    conn.reset();
+}
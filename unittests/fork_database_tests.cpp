@@ -0,0 +1,139 @@
+#include <catch/catch.hpp>
+#include <fc/filesystem.hpp>
+
+#include <evt/chain/fork_database.hpp>
+
+using namespace evt;
+using namespace chain;
+
+extern std::string evt_unittests_dir;
+
+namespace {
+
+block_state_ptr
+new_block_state(const block_state_ptr& prev, uint32_t ts) {
+    auto h      = signed_block_header();
+    h.timestamp = block_timestamp_type(ts);
+    if(prev) {
+        h.previous = prev->id;
+    }
+
+    auto s       = std::make_shared<block_state>();
+    s->header    = h;
+    s->id        = h.id();
+    s->block_num = h.block_num();
+    s->block     = std::make_shared<signed_block>(h);
+    return s;
+}
+
+}  // namespace
+
+TEST_CASE("fork_database_journal_test", "[fork_database]") {
+    auto dir = fc::path(evt_unittests_dir) / "fork_database_tests";
+    fc::remove_all(dir);
+
+    auto main_chain = std::vector<block_state_ptr>();
+    auto side_chain = std::vector<block_state_ptr>();
+    {
+        auto fork_db = fork_database(dir, 10);
+
+        main_chain.emplace_back(new_block_state(nullptr, 1));
+        fork_db.set(main_chain.back());
+
+        // side fork starts from block 2
+        main_chain.emplace_back(new_block_state(main_chain.back(), 2));
+        fork_db.add(main_chain.back(), true);
+        side_chain.emplace_back(new_block_state(main_chain.back(), 1000));
+        fork_db.add(side_chain.back(), true);
+        for(auto i = 0; i < 3; i++) {
+            side_chain.emplace_back(new_block_state(side_chain.back(), 1001 + i));
+            fork_db.add(side_chain.back(), true);
+        }
+
+        for(auto i = 3u; i <= 30; i++) {
+            main_chain.emplace_back(new_block_state(main_chain.back(), i));
+            fork_db.add(main_chain.back(), true);
+        }
+        CHECK(fork_db.head()->id == main_chain.back()->id);
+
+        // side fork is behind head by more than retention window
+        for(auto& s : side_chain) {
+            CHECK(!fork_db.get_block(s->id));
+        }
+        for(auto& s : main_chain) {
+            CHECK(fork_db.get_block(s->id));
+        }
+
+        fork_db.mark_in_current_chain(fork_db.get_block(main_chain[20]->id), true);
+        fork_db.close();
+    }
+    CHECK(fc::exists(dir / config::forkdb_journal_filename));
+    {
+        auto fork_db = fork_database(dir, 10);
+        REQUIRE(fork_db.head());
+        CHECK(fork_db.head()->id == main_chain.back()->id);
+        for(auto& s : main_chain) {
+            CHECK(fork_db.get_block(s->id));
+        }
+        CHECK(fork_db.get_block_in_current_chain_by_num(main_chain[20]->block_num)->id == main_chain[20]->id);
+
+        // appended after reopened
+        main_chain.emplace_back(new_block_state(main_chain.back(), 31));
+        fork_db.add(main_chain.back(), true);
+        fork_db.remove(main_chain.back()->id);
+        fork_db.close();
+    }
+    {
+        auto fork_db = fork_database(dir, 10);
+        CHECK(!fork_db.get_block(main_chain.back()->id));
+        CHECK(fork_db.get_block(main_chain[main_chain.size() - 2]->id));
+    }
+}
+
+TEST_CASE("block_header_state_shared_schedule_test", "[fork_database]") {
+    auto sch = producer_schedule_type{0, {{N128(evt), public_key_type()}}};
+
+    auto s = block_header_state();
+    s.active_schedule  = sch;
+    s.pending_schedule = sch;
+    s.header.timestamp = block_timestamp_type(1);
+
+    // states of the next blocks share the schedules
+    auto n1 = s.generate_next(block_timestamp_type(2));
+    auto n2 = n1.generate_next(block_timestamp_type(3));
+    CHECK(n2.active_schedule.shares_with(s.active_schedule));
+    CHECK(n2.pending_schedule.shares_with(s.pending_schedule));
+
+    // pending one is left empty with its version on promotion, the others keep theirs
+    n2.dpos_irreversible_blocknum = n2.pending_schedule_lib_num;
+    CHECK(n2.maybe_promote_pending());
+    CHECK(n2.active_schedule.shares_with(s.active_schedule));
+    CHECK(n2.pending_schedule->producers.empty());
+    CHECK(n2.pending_schedule->version == 0);
+    CHECK(n1.pending_schedule->producers.size() == 1);
+
+    auto s2 = fc::raw::unpack<block_header_state>(fc::raw::pack(n2));
+    CHECK(fc::raw::pack(s2) == fc::raw::pack(n2));
+    CHECK(s2.active_schedule->producers.size() == 1);
+    CHECK(s2.pending_schedule->producers.empty());
+}
+
+TEST_CASE("block_state_pooled_test", "[fork_database]") {
+    auto s = block_header_state();
+    s.active_schedule  = producer_schedule_type{0, {{N128(evt), public_key_type()}}};
+    s.header.timestamp = block_timestamp_type(1);
+
+    // freed ones go back to the cache of this thread and are taken again
+    make_block_state(s, block_timestamp_type(2)).reset();
+    make_signed_block().reset();
+
+    auto before = utilities::get_pool_stats();
+    auto bs     = make_block_state(s, block_timestamp_type(2));
+    auto b      = make_signed_block(bs->header);
+    auto after  = utilities::get_pool_stats();
+
+    CHECK(bs->block != nullptr);
+    CHECK(b->timestamp == bs->header.timestamp);
+    CHECK(after.allocs - before.allocs == 3);  // block state, its block and the other block
+    CHECK(after.cache_hits - before.cache_hits >= 2);
+}
@@ -0,0 +1,136 @@
+#include <fstream>
+
+#include <catch/catch.hpp>
+#include <fc/filesystem.hpp>
+#include <fc/io/json.hpp>
+#include <fc/variant_object.hpp>
+
+#include <evt/chain/exceptions.hpp>
+#include <evt/chain/genesis_initial_state.hpp>
+#include <evt/chain/genesis_state.hpp>
+#include <evt/chain/token_database.hpp>
+#include <evt/chain/contracts/evt_org.hpp>
+#include <evt/chain/contracts/types.hpp>
+
+using namespace evt;
+using namespace chain;
+using namespace contracts;
+
+extern std::string evt_unittests_dir;
+
+namespace {
+
+struct initial_state_test {
+public:
+    using token_database_ptr_t = std::unique_ptr<token_database>;
+
+    initial_state_test() {
+        basedir = evt_unittests_dir + "/genesis_initial_state_tests";
+        if(fc::exists(basedir)) {
+            fc::remove_all(basedir);
+        }
+        fc::create_directories(basedir);
+
+        key = public_key_type(std::string("EVT8MGU4aKiVzqMtWi9zLpu8KuTHZWjQQrX475ycSxEkLd6aBpraX"));
+
+        auto dm = domain_def();
+        dm.name    = "genesis-dm";
+        dm.creator = key;
+        add("domain", dm);
+        add("token", token_def("genesis-dm", "t2", { key }));
+        add("token", token_def("genesis-dm", "t1", { key }));
+
+        auto ft = fungible_def();
+        ft.name         = "GFT";
+        ft.sym_name     = "GFT";
+        ft.sym          = symbol(5, 1000);
+        ft.creator      = key;
+        ft.total_supply = asset::from_string("100.00000 S#1000");
+        add("fungible", ft);
+        add("balance", fc::mutable_variant_object("owner", address(key))("amount", "10.00000 S#1000"));
+        add("balance", fc::mutable_variant_object("owner", address(key))("amount", "1.00000 S#1"));
+    }
+
+    template<typename T>
+    void
+    add(const char* type, const T& v) {
+        lines += fc::json::to_string(fc::mutable_variant_object(type, v)) + "\n";
+    }
+
+    fc::path
+    write(genesis_state& genesis) {
+        auto path = basedir / "initial-state.json";
+        std::ofstream(path.generic_string()) << lines;
+
+        genesis.evt_org.metas_.emplace_back(N128(.initial-state), fc::sha256::hash(lines.data(), lines.size()).str(), authorizer_ref());
+        return path;
+    }
+
+    token_database_ptr_t
+    open_db() {
+        auto c    = token_database::config();
+        c.db_path = basedir / "tokendb";
+
+        auto db = std::make_unique<token_database>(c);
+        db->open();
+        return db;
+    }
+
+protected:
+    fc::path        basedir;
+    public_key_type key;
+    std::string     lines;
+};
+
+}  // namespace
+
+TEST_CASE_METHOD(initial_state_test, "genesis_initial_state_load_test", "[genesis]") {
+    auto genesis = genesis_state();
+    auto path    = write(genesis);
+    auto db      = open_db();
+
+    initialize_evt_org(*db, genesis);
+    genesis_initial_state::load(path, genesis, *db);
+
+    CHECK(db->exists_token(token_type::domain, std::nullopt, N128(genesis-dm)));
+    CHECK(db->exists_token(token_type::token, N128(genesis-dm), N128(t1)));
+    CHECK(db->exists_token(token_type::token, N128(genesis-dm), N128(t2)));
+    CHECK(db->exists_token(token_type::fungible, std::nullopt, 1000));
+
+    auto balance = [&](const address& addr, symbol_id_type id) {
+        auto str  = std::string();
+        auto prop = property();
+        db->read_asset(addr, id, str);
+        extract_db_value(str, prop);
+        return prop.amount;
+    };
+    CHECK(balance(key, 1000) == 10'00000);
+    CHECK(balance(key, EVT_SYM_ID) == 1'00000);
+    CHECK(balance(address(N(.fungible), name128::from_number(1000), 0), 1000) == 90'00000);
+    CHECK(balance(address(N(.fungible), name128::from_number(EVT_SYM_ID), 0), EVT_SYM_ID) == genesis.evt.total_supply.amount() - 1'00000);
+}
+
+TEST_CASE_METHOD(initial_state_test, "genesis_initial_state_digest_test", "[genesis]") {
+    auto genesis = genesis_state();
+    auto path    = write(genesis);
+    auto db      = open_db();
+
+    initialize_evt_org(*db, genesis);
+    std::ofstream(path.generic_string(), std::ios::app) << "\n";
+    CHECK_THROWS_AS(genesis_initial_state::load(path, genesis, *db), genesis_initial_state_exception);
+    CHECK(!db->exists_token(token_type::domain, std::nullopt, N128(genesis-dm)));
+
+    auto genesis2 = genesis_state();
+    CHECK(!genesis_initial_state::declared_digest(genesis2).has_value());
+    CHECK_THROWS_AS(genesis_initial_state::load(path, genesis2, *db), genesis_initial_state_exception);
+}
+
+TEST_CASE_METHOD(initial_state_test, "genesis_initial_state_invalid_test", "[genesis]") {
+    auto genesis = genesis_state();
+    add("token", token_def("genesis-dm", "t1", { key }));
+    auto path = write(genesis);
+    auto db   = open_db();
+
+    initialize_evt_org(*db, genesis);
+    CHECK_THROWS_AS(genesis_initial_state::load(path, genesis, *db), genesis_initial_state_exception);
+}
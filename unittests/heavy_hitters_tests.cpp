@@ -0,0 +1,41 @@
+#include <catch/catch.hpp>
+
+#include <string>
+#include <evt/utilities/heavy_hitters.hpp>
+
+using evt::utilities::heavy_hitters;
+
+TEST_CASE("test_heavy_hitters", "[heavy_hitters]") {
+    auto hh = heavy_hitters<std::string>(4);
+
+    // two heavy keys among many light ones
+    for(auto i = 0; i < 1000; i++) {
+        hh.add("hot1");
+        if(i % 2 == 0) {
+            hh.add("hot2");
+        }
+        hh.add("cold" + std::to_string(i));
+    }
+    CHECK(hh.size() == 4);
+    CHECK(hh.total() == 2500);
+
+    auto top = hh.top(2);
+    REQUIRE(top.size() == 2);
+    CHECK(top[0].key == "hot1");
+    CHECK(top[1].key == "hot2");
+
+    // real counts are bounded by the estimations
+    CHECK(top[0].count >= 1000);
+    CHECK(top[0].count - top[0].error <= 1000);
+    CHECK(top[1].count >= 500);
+    CHECK(top[1].count - top[1].error <= 500);
+
+    // weighted adds from sampling
+    hh.add("hot2", 2000);
+    CHECK(hh.top(1)[0].key == "hot2");
+    CHECK(hh.top(10).size() == 4);
+
+    hh.clear();
+    CHECK(hh.size() == 0);
+    CHECK(hh.total() == 0);
+}
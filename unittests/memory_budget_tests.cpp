@@ -0,0 +1,53 @@
+#include <catch/catch.hpp>
+
+#include <evt/utilities/memory_budget.hpp>
+
+using namespace evt::utilities::memory;
+
+TEST_CASE("test_memory_budget", "[memory]") {
+    auto& a = accountant::get();
+
+    auto bytes    = uint64_t(100);
+    auto capacity = uint64_t(0);
+    a.set_budget("test_cache", 64);
+
+    auto id = a.add_component("test_cache", [&](auto& u) {
+        u.bytes = bytes;
+        u.items = 2;
+    }, [&](auto& u) {
+        // shrinks like a cache
+        capacity = u.over_budget() ? u.budget : 0;
+        bytes    = std::min(bytes, u.budget);
+    });
+
+    auto find = [&] {
+        for(auto& u : a.get_usage()) {
+            if(u.name == "test_cache") {
+                return u;
+            }
+        }
+        FAIL("component is not found");
+        return component_usage();
+    };
+
+    auto u = find();
+    CHECK(u.bytes == 100);
+    CHECK(u.items == 2);
+    CHECK(u.budget == 64);
+    CHECK(u.over_budget());
+
+    a.enforce();
+    CHECK(capacity == 64);
+    CHECK(!find().over_budget());
+
+    // lifted budget
+    a.set_budget("test_cache", 0);
+    CHECK(a.get_budget("test_cache") == 0);
+    a.enforce();
+    CHECK(capacity == 0);
+
+    a.remove_component(id);
+    for(auto& u : a.get_usage()) {
+        CHECK(u.name != "test_cache");
+    }
+}
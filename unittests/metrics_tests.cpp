@@ -0,0 +1,54 @@
+#include <catch/catch.hpp>
+
+#include <thread>
+#include <vector>
+#include <evt/utilities/metrics.hpp>
+
+using namespace evt::utilities::metrics;
+
+TEST_CASE("test_metrics_sharded_updates", "[metrics]") {
+    auto& r = registry::get();
+    auto& c = r.add_counter("evt_test_updates_total", "Updates of the test", {{"kind", "sharded"}});
+    auto& h = r.add_histogram("evt_test_values", "Values of the test", { 1, 10, 100 });
+
+    auto threads = std::vector<std::thread>();
+    for(auto i = 0; i < 8; i++) {
+        threads.emplace_back([&] {
+            for(auto j = 0; j < 10000; j++) {
+                c.add();
+                h.observe(j % 2 == 0 ? 5 : 50);
+            }
+        });
+    }
+    for(auto& t : threads) {
+        t.join();
+    }
+
+    CHECK(c.value() == 80000);
+    CHECK(&c == &r.add_counter("evt_test_updates_total", "Updates of the test", {{"kind", "sharded"}}));
+    CHECK_THROWS(r.add_gauge("evt_test_updates_total", "Updates of the test"));
+
+    auto snap = h.get_snapshot();
+    CHECK(snap.buckets == std::vector<uint64_t>{ 0, 40000, 80000, 80000 });
+    CHECK(snap.sum == 40000 * 5 + 40000 * 50);
+}
+
+TEST_CASE("test_metrics_text_format", "[metrics]") {
+    auto& r = registry::get();
+    r.add_gauge("evt_test_level", "Level of the test").set(-3);
+    r.add_histogram("evt_test_latency", "Latency of the test", histogram::exponential_bounds(0.001, 10, 3)).observe(0.5);
+
+    // samples of one name from several collectors are grouped together
+    auto c1 = r.add_collector([](auto& w) { w.gauge("evt_test_lag", "Lag of the test", 1, {{"consumer", "a"}}); });
+    auto c2 = r.add_collector([](auto& w) { w.gauge("evt_test_lag", "Lag of the test", 2, {{"consumer", "b\"c"}}); });
+
+    auto text = r.format_text();
+    CHECK(text.find("# TYPE evt_test_level gauge\nevt_test_level -3\n") != std::string::npos);
+    CHECK(text.find("# HELP evt_test_lag Lag of the test\n# TYPE evt_test_lag gauge\n"
+                    "evt_test_lag{consumer=\"a\"} 1\nevt_test_lag{consumer=\"b\\\"c\"} 2\n") != std::string::npos);
+    CHECK(text.find("evt_test_latency_bucket{le=\"0.1\"} 0\nevt_test_latency_bucket{le=\"+Inf\"} 1\n") != std::string::npos);
+
+    r.remove_collector(c1);
+    r.remove_collector(c2);
+    CHECK(r.format_text().find("evt_test_lag") == std::string::npos);
+}
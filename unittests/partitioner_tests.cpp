@@ -0,0 +1,68 @@
+#include <catch/catch.hpp>
+
+#include <evt/chain/transaction_partitioner.hpp>
+#include <evt/chain/contracts/types.hpp>
+
+using namespace evt::chain;
+using namespace evt::chain::contracts;
+
+namespace {
+
+transaction
+make_trx(const address& payer, std::initializer_list<action> acts) {
+    auto trx  = transaction();
+    trx.payer = payer;
+    for(auto& act : acts) {
+        trx.actions.emplace_back(act);
+    }
+    return trx;
+}
+
+action
+make_act(name act, name128 domain, name128 key) {
+    return action(act, domain, key, bytes());
+}
+
+}  // namespace
+
+TEST_CASE("test_partition", "[partitioner]") {
+    auto p1 = address(N(.domain), N128(d1), 0);
+    auto p2 = address(N(.domain), N128(d2), 0);
+    auto p3 = address(N(.fungible), name128::from_number(5), 0);
+
+    auto partitioner = transaction_partitioner();
+    partitioner.add(make_trx(p1, { make_act(N(transfer), N128(d1), N128(t1)) }));          // 0
+    partitioner.add(make_trx(p2, { make_act(N(transfer), N128(d2), N128(t1)) }));          // 1
+    partitioner.add(make_trx(p1, { make_act(N(transfer), N128(d1), N128(t2)) }));          // 2, conflicts with 0
+    partitioner.add(make_trx(p3, { make_act(N(transferft), N128(.fungible), name128::from_number(5)) }));  // 3
+    partitioner.add(make_trx(p1, { make_act(N(everipay), N128(.fungible), name128::from_number(5)) }));    // 4, serial
+    partitioner.add(make_trx(p2, { make_act(N(transfer), N128(d2), N128(t2)),
+                                   make_act(N(transfer), N128(d1), N128(t3)) }));          // 5
+    partitioner.add(make_trx(p1, { make_act(N(transfer), N128(d1), N128(t4)) }));          // 6, conflicts with 5
+    partitioner.add(make_trx(p3, { make_act(N(transferft), N128(.fungible), name128::from_number(1)) }));  // 7, EVT is serial
+
+    auto segs = partitioner.finalize();
+    REQUIRE(segs.size() == 4);
+
+    CHECK(!segs[0].serial);
+    REQUIRE(segs[0].groups.size() == 3);
+    CHECK(segs[0].groups[0] == std::vector<uint32_t>{ 0, 2 });
+    CHECK(segs[0].groups[1] == std::vector<uint32_t>{ 1 });
+    CHECK(segs[0].groups[2] == std::vector<uint32_t>{ 3 });
+
+    CHECK(segs[1].serial);
+    CHECK(segs[1].groups[0] == std::vector<uint32_t>{ 4 });
+
+    CHECK(!segs[2].serial);
+    REQUIRE(segs[2].groups.size() == 1);
+    CHECK(segs[2].groups[0] == std::vector<uint32_t>{ 5, 6 });
+
+    CHECK(segs[3].serial);
+    CHECK(segs[3].groups[0] == std::vector<uint32_t>{ 7 });
+
+    // partitioner is reset after finalize
+    partitioner.add(make_trx(p1, { make_act(N(transfer), N128(d1), N128(t1)) }));
+    segs = partitioner.finalize();
+    REQUIRE(segs.size() == 1);
+    CHECK(segs[0].groups[0] == std::vector<uint32_t>{ 0 });
+}
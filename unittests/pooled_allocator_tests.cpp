@@ -0,0 +1,71 @@
+#include <catch/catch.hpp>
+
+#include <string>
+#include <thread>
+#include <vector>
+#include <evt/utilities/pooled_allocator.hpp>
+
+using namespace evt::utilities;
+
+namespace {
+
+struct pooled_obj {
+    pooled_obj(int v) : value(v) {}
+
+    int         value;
+    std::string name;
+};
+
+}  // namespace
+
+TEST_CASE("test_pooled_reuse", "[pooled_allocator]") {
+    auto begin = get_pool_stats();
+    {
+        auto objs = std::vector<std::shared_ptr<pooled_obj>>();
+        for(auto i = 0; i < 100; i++) {
+            objs.emplace_back(make_pooled<pooled_obj>(i));
+        }
+        for(auto i = 0; i < 100; i++) {
+            CHECK(objs[i]->value == i);
+        }
+    }
+
+    // freed blocks stay in the cache of this thread
+    auto mid = get_pool_stats();
+    for(auto i = 0; i < 100; i++) {
+        auto p = make_pooled<pooled_obj>(i);
+        CHECK(p->value == i);
+    }
+    auto end = get_pool_stats();
+    CHECK(mid.allocs - begin.allocs == 100);
+    CHECK(end.allocs - mid.allocs == 100);
+    CHECK(end.cache_hits - mid.cache_hits == 100);
+    CHECK(end.pool_allocs == mid.pool_allocs);
+}
+
+TEST_CASE("test_pooled_cross_thread", "[pooled_allocator]") {
+    auto objs = std::vector<std::shared_ptr<pooled_obj>>();
+    for(auto i = 0; i < 1000; i++) {
+        objs.emplace_back(make_pooled<pooled_obj>(i));
+    }
+
+    // freed on other threads, their caches go back to the shared pool when they exit
+    auto threads = std::vector<std::thread>();
+    for(auto t = 0; t < 4; t++) {
+        threads.emplace_back([&objs, t] {
+            for(auto i = t; i < 1000; i += 4) {
+                objs[i].reset();
+            }
+            for(auto i = 0; i < 100; i++) {
+                auto p = make_pooled<pooled_obj>(i);
+                p->name = std::to_string(i);
+            }
+        });
+    }
+    for(auto& t : threads) {
+        t.join();
+    }
+    for(auto& o : objs) {
+        CHECK(o == nullptr);
+    }
+}
@@ -0,0 +1,90 @@
+#include <catch/catch.hpp>
+#include <boost/filesystem.hpp>
+#include <fc/filesystem.hpp>
+
+#include <evt/chain/reversible_block_store.hpp>
+
+using namespace evt;
+using namespace chain;
+
+extern std::string evt_unittests_dir;
+
+namespace {
+
+// blocks from 1 to n, `ts` tells forks apart
+std::vector<signed_block_ptr>
+make_blocks(uint32_t n, uint32_t ts, const std::vector<signed_block_ptr>& base = {}) {
+    auto blocks = base;
+    while(blocks.size() < n) {
+        auto b       = std::make_shared<signed_block>();
+        b->timestamp = block_timestamp_type(ts + blocks.size());
+        if(!blocks.empty()) {
+            b->previous = blocks.back()->id();
+        }
+        blocks.emplace_back(b);
+    }
+    return blocks;
+}
+
+}  // namespace
+
+TEST_CASE("reversible_block_store_test", "[reversible_block_store]") {
+    auto dir = fc::path(evt_unittests_dir) / "reversible_block_store_tests";
+    fc::remove_all(dir);
+
+    auto main_chain = make_blocks(20, 1);
+    auto side_chain = make_blocks(25, 1000, std::vector<signed_block_ptr>(main_chain.begin(), main_chain.begin() + 15));
+    {
+        auto store = reversible_block_store(dir);
+        CHECK(!store.last_num().has_value());
+
+        for(auto& b : main_chain) {
+            store.add(b);
+        }
+        CHECK(*store.first_num() == 1);
+        CHECK(*store.last_num() == 20);
+        CHECK(store.get(7)->id() == main_chain[6]->id());
+        CHECK(store.get(21) == nullptr);
+
+        // switches to the side fork from block 16
+        store.remove_from(16);
+        CHECK(*store.last_num() == 15);
+        for(auto i = 15u; i < side_chain.size(); i++) {
+            store.add(side_chain[i]);
+        }
+
+        store.prune(10);
+        CHECK(*store.first_num() == 11);
+        CHECK(store.get(10) == nullptr);
+        CHECK(store.size() == 15);
+    }
+
+    // append a torn record as if crashed while writing
+    auto path = dir / reversible_block_store::filename();
+    {
+        auto f = std::ofstream(path.generic_string().c_str(), std::ios::out | std::ios::binary | std::ios::app);
+        auto num = uint32_t(26), size = uint32_t(100);
+        f.write((char*)&num, sizeof(num));
+        f.write((char*)&size, sizeof(size));
+        f.write("torn", 4);
+    }
+    {
+        auto store = reversible_block_store(dir);
+        CHECK(store.recovered_bytes() == 12);
+        CHECK(*store.last_num() == 25);
+        CHECK(store.get(20)->id() == side_chain[19]->id());
+        CHECK(store.get(25)->id() == side_chain[24]->id());
+        // pruned blocks are still in the file but not indexed
+        CHECK(*store.first_num() == 1);
+
+        store.prune(24);
+        store.add(make_blocks(26, 1000, side_chain).back());
+        CHECK(*store.last_num() == 26);
+    }
+    {
+        auto store = reversible_block_store(dir);
+        CHECK(store.recovered_bytes() == 0);
+        CHECK(*store.last_num() == 26);
+        CHECK((uint64_t)boost::filesystem::file_size(path) == store.file_size());
+    }
+}
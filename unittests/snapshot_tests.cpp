@@ -89,6 +89,7 @@ TEST_CASE("snapshot_save_test", "[snapshot]") {
     PUT_DB_TOKEN(domain, std::nullopt, d.name, d);
 
     token_database_snapshot::add_to_snapshot(writer, tokendb);
+    writer->finalize();
     token_db_snapshot_ = ss.str();
 }
 
@@ -113,3 +114,157 @@ TEST_CASE("snapshot_load_test", "[snapshot]") {
     CHECK(EXISTS_ASSET(addr, 3));
     CHECK(EXISTS_TOKEN(domain, "snapshot-domain"));
 }
+
+TEST_CASE("snapshot_diff_test", "[snapshot]") {
+    auto tokendb = token_database(get_db_config());
+    tokendb.open();
+
+    REQUIRE(tokendb.savepoints_size() == 0);
+
+    auto write_snapshot = [&](auto&& f) {
+        auto ss     = std::stringstream();
+        auto writer = std::make_shared<ostream_snapshot_writer>(ss);
+        f(writer);
+        writer->finalize();
+        return ss.str();
+    };
+    auto make_reader = [](auto& ss) {
+        return std::make_shared<istream_snapshot_reader>(ss);
+    };
+
+    auto full = write_snapshot([&](auto& w) {
+        token_database_snapshot::add_to_snapshot(w, tokendb);
+    });
+
+    // new domain and new token in an existing domain
+    auto d = domain_def();
+    d.name = "diff-domain";
+    PUT_DB_TOKEN(domain, std::nullopt, d.name, d);
+
+    auto addr = public_key_type(std::string("EVT8MGU4aKiVzqMtWi9zLpu8KuTHZWjQQrX475ycSxEkLd6aBpraX"));
+    auto t    = token_def(N128(dm-tkdb-test), N128(diff-token), { address(addr) });
+    PUT_DB_TOKEN(token, "dm-tkdb-test", t.name, t);
+
+    auto diff1 = std::string();
+    {
+        auto fs = std::stringstream(full);
+        diff1   = write_snapshot([&](auto& w) {
+            token_database_snapshot::add_diff_to_snapshot(w, tokendb, { make_reader(fs) });
+        });
+    }
+    CHECK(diff1.size() < full.size());
+    {
+        auto ds     = std::stringstream(diff1);
+        auto reader = make_reader(ds);
+        CHECK(reader->has_section("dm-tkdb-test"));
+        CHECK(!reader->has_section("diff-domain"));
+        CHECK(!reader->has_section(".asset-3"));
+        reader->read_section(".domain", [](auto& section) {
+            auto k = name128();
+            auto v = std::string();
+            REQUIRE(!section.eof());
+            section.read_row((char*)&k, sizeof(k));
+            section.read_row(v);
+            CHECK(k == name128("diff-domain"));
+            CHECK(section.eof());
+        });
+    }
+
+    // changed value of the domain, diff is taken against the full one and the first diff
+    d.creator = addr;
+    PUT_DB_TOKEN(domain, std::nullopt, d.name, d);
+
+    auto diff2 = std::string();
+    {
+        auto fs = std::stringstream(full);
+        auto ds = std::stringstream(diff1);
+        diff2   = write_snapshot([&](auto& w) {
+            token_database_snapshot::add_diff_to_snapshot(w, tokendb, { make_reader(fs), make_reader(ds) });
+        });
+    }
+    {
+        auto ds     = std::stringstream(diff2);
+        auto reader = make_reader(ds);
+        CHECK(!reader->has_section("dm-tkdb-test"));
+    }
+
+    // full snapshot is not a diff
+    {
+        auto fs = std::stringstream(full);
+        CHECK_THROWS_AS(token_database_snapshot::read_diff_from_snapshot(make_reader(fs), tokendb), snapshot_validation_exception);
+    }
+
+    // restore the full one and apply the diffs in order
+    {
+        auto fs  = std::stringstream(full);
+        auto ds1 = std::stringstream(diff1);
+        auto ds2 = std::stringstream(diff2);
+        token_database_snapshot::read_from_snapshot(make_reader(fs), tokendb);
+        CHECK(!EXISTS_TOKEN(domain, "diff-domain"));
+
+        token_database_snapshot::read_diff_from_snapshot(make_reader(ds1), tokendb);
+        token_database_snapshot::read_diff_from_snapshot(make_reader(ds2), tokendb);
+    }
+
+    CHECK(EXISTS_TOKEN(domain, "dm-tkdb-test"));
+    CHECK(EXISTS_TOKEN(domain, "snapshot-domain"));
+    CHECK(EXISTS_TOKEN2(token, "dm-tkdb-test", "basic-1"));
+    CHECK(EXISTS_TOKEN2(token, "dm-tkdb-test", "diff-token"));
+    CHECK(EXISTS_ASSET(addr, 3));
+
+    auto d2 = domain_def();
+    READ_TOKEN(domain, "diff-domain", d2);
+    CHECK(d2.creator == addr);
+}
+
+TEST_CASE("snapshot_section_table_test", "[snapshot]") {
+    auto ss     = std::stringstream();
+    auto writer = std::make_shared<ostream_snapshot_writer>(ss);
+
+    for(auto i = 0u; i < 4; i++) {
+        writer->write_section("section-" + std::to_string(i), [i](auto& section) {
+            for(auto j = 0u; j < 100; j++) {
+                section.add_row((uint64_t)(i * 1000 + j));
+            }
+        });
+    }
+    writer->write_section("section-empty", [](auto&) {});
+    writer->finalize();
+
+    auto data = ss.str();
+    {
+        auto is     = std::stringstream(data);
+        auto reader = std::make_shared<istream_snapshot_reader>(is);
+        CHECK_NOTHROW(reader->validate());
+        CHECK(reader->get_section_names("section-").size() == 5);
+
+        // sections are located by table, order doesn't matter
+        for(auto i : { 2u, 0u, 1u, 3u }) {
+            reader->read_section("section-" + std::to_string(i), [i](auto& section) {
+                auto v = uint64_t();
+                for(auto j = 0u; j < 100; j++) {
+                    CHECK(!section.eof());
+                    section.read_row(v);
+                    CHECK(v == i * 1000 + j);
+                }
+                CHECK(section.eof());
+            });
+        }
+        reader->read_section("section-empty", [](auto& section) {
+            CHECK(section.empty());
+        });
+    }
+    {
+        // corrupt one byte in the middle of the first section
+        auto is     = std::stringstream(data);
+        auto reader = std::make_shared<istream_snapshot_reader>(is);
+        auto pos    = 16 + reader->get_section_size("section-0") / 2;
+
+        auto corrupted = data;
+        corrupted[pos] = ~corrupted[pos];
+
+        auto cs  = std::stringstream(corrupted);
+        auto bad = std::make_shared<istream_snapshot_reader>(cs);
+        CHECK_THROWS_AS(bad->validate(), snapshot_validation_exception);
+    }
+}
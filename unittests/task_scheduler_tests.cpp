@@ -0,0 +1,105 @@
+#include <catch/catch.hpp>
+
+#include <atomic>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <evt/utilities/task_scheduler.hpp>
+
+using evt::utilities::task_scheduler;
+
+TEST_CASE("test_scheduler_runs_all", "[task_scheduler]") {
+    auto s = task_scheduler(4);
+    CHECK(s.size() == 4);
+    CHECK(s.current_worker() == -1);
+
+    auto n       = std::atomic<int>(0);
+    auto extra   = std::atomic<int>(0);
+    auto workers = std::vector<std::future<int>>();
+    for(auto i = 0; i < 1000; i++) {
+        auto task = std::make_shared<std::packaged_task<int()>>([&, i] {
+            n++;
+            // tasks posted by a worker go to its own queue
+            if(i % 10 == 0) {
+                s.post([&] { extra++; }, task_scheduler::lane::background);
+            }
+            return s.current_worker();
+        });
+        workers.emplace_back(task->get_future());
+        s.post([task] { (*task)(); }, (i % 2) ? task_scheduler::lane::critical : task_scheduler::lane::background);
+    }
+    for(auto& w : workers) {
+        auto i = w.get();
+        CHECK(i >= 0);
+        CHECK(i < 4);
+    }
+    s.join();
+
+    auto c = s.stats(task_scheduler::lane::critical);
+    auto b = s.stats(task_scheduler::lane::background);
+    CHECK(c.posted == 500);
+    CHECK(c.done == c.posted);
+    CHECK(b.posted == 600);
+    CHECK(b.done == b.posted);
+    CHECK(n == 1000);
+    CHECK(extra == 100);
+}
+
+TEST_CASE("test_scheduler_critical_first", "[task_scheduler]") {
+    auto s = task_scheduler(1);
+
+    auto release = std::promise<void>();
+    auto started = std::promise<void>();
+    s.post([&, f = release.get_future().share()] {
+        started.set_value();
+        f.wait();
+    });
+    started.get_future().wait();
+
+    // queued while the only worker is busy
+    auto mtx   = std::mutex();
+    auto order = std::vector<int>();
+    auto push  = [&](int v) {
+        auto lock = std::lock_guard(mtx);
+        order.push_back(v);
+    };
+    s.post([&] { push(1); }, task_scheduler::lane::background);
+    s.post([&] { push(2); }, task_scheduler::lane::background);
+    s.post([&] { push(3); }, task_scheduler::lane::critical);
+    s.post([&] { push(4); }, task_scheduler::lane::critical);
+
+    release.set_value();
+    s.join();
+    CHECK(order == std::vector<int>{ 3, 4, 1, 2 });
+}
+
+TEST_CASE("test_scheduler_stop", "[task_scheduler]") {
+    auto s = task_scheduler(1);
+
+    auto release = std::promise<void>();
+    auto started = std::promise<void>();
+    s.post([&, f = release.get_future().share()] {
+        started.set_value();
+        f.wait();
+    });
+    started.get_future().wait();
+
+    // queued ones are dropped, their futures are broken
+    auto task = std::make_shared<std::packaged_task<void()>>([] {});
+    auto f    = task->get_future();
+    s.post([task] { (*task)(); });
+    task.reset();
+
+    // the worker quits once the running task returns
+    auto stopper = std::thread([&] { s.stop(); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    release.set_value();
+    stopper.join();
+    CHECK_THROWS_AS(f.get(), std::future_error);
+
+    // tasks posted after stopped are dropped as well
+    auto ran = false;
+    s.post([&] { ran = true; });
+    CHECK(!ran);
+}
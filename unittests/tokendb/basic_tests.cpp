@@ -235,3 +235,86 @@ TEST_CASE_METHOD(tokendb_test, "put_tokens_test", "[tokendb]") {
     CHECK(EXISTS_TOKEN2(token, "dm-tkdb-test", "basic-1"));
     CHECK(EXISTS_TOKEN2(token, "dm-tkdb-test", "basic-2"));
 }
+
+TEST_CASE_METHOD(tokendb_test, "read_batch_test", "[tokendb]") {
+    auto& tokendb = my_tester->control->token_db();
+
+    CHECK(EXISTS_TOKEN2(token, "dm-tkdb-test", "basic-1"));
+    CHECK(EXISTS_TOKEN2(token, "dm-tkdb-test", "basic-2"));
+
+    auto tkeys = evt::chain::token_keys_t();
+    tkeys.push_back("basic-1");
+    tkeys.push_back("basic-none");
+    tkeys.push_back("basic-2");
+
+    auto values = evt::chain::read_values_t();
+    CHECK_THROWS_AS(tokendb.read_tokens(evt::chain::token_type::token, "dm-tkdb-test", tkeys, values), unknown_token_database_key);
+    CHECK(tokendb.read_tokens(evt::chain::token_type::token, "dm-tkdb-test", tkeys, values, true) == 2);
+    REQUIRE(values.size() == 3);
+    CHECK(values[0].has_value());
+    CHECK(!values[1].has_value());
+    CHECK(values[2].has_value());
+
+    auto tk = token_def();
+    READ_TOKEN2(token, "dm-tkdb-test", "basic-2", tk);
+    CHECK(evt::chain::make_db_value(tk).as_string_view() == *values[2]);
+
+    auto addr  = public_key_type(std::string("EVT8MGU4aKiVzqMtWi9zLpu8KuTHZWjQQrX475ycSxEkLd6aBpraX"));
+    auto akeys = evt::chain::asset_keys_t();
+    akeys.emplace_back(addr, 3);
+    akeys.emplace_back(addr, 4);
+
+    CHECK(tokendb.read_assets(akeys, values, true) == 1);
+    REQUIRE(values.size() == 2);
+    CHECK(values[0].has_value());
+    CHECK(!values[1].has_value());
+
+    auto str = std::string();
+    tokendb.read_asset(addr, 3, str);
+    CHECK(str == *values[0]);
+}
+
+TEST_CASE_METHOD(tokendb_test, "read_range_cursor_test", "[tokendb]") {
+    auto& tokendb = my_tester->control->token_db();
+
+    auto all = std::vector<std::string>();
+    tokendb.read_tokens_range(evt::chain::token_type::token, "dm-tkdb-test", 0, [&](auto& k, auto&&) {
+        all.emplace_back(k);
+        return true;
+    });
+    REQUIRE(all.size() >= 2);
+
+    // page through tokens one by one
+    auto cursor = std::string();
+    auto paged  = std::vector<std::string>();
+    while(tokendb.read_tokens_range(evt::chain::token_type::token, "dm-tkdb-test", cursor, [&](auto& k, auto&&) {
+        paged.emplace_back(k);
+        return false;
+    }) > 0) {
+        CHECK(cursor == paged.back());
+    }
+    CHECK(paged == all);
+
+    // pending assets in cache should be merged into results
+    auto addr  = tester::get_public_key(N(range));
+    auto count = tokendb.read_assets_range(3, 0, [](auto&, auto&&) { return true; });
+    CHECK(!EXISTS_ASSET(addr, 3));
+
+    ADD_SAVEPOINT();
+    PUT_ASSET(addr, 3, asset::from_string("2.00000 S#3"));
+
+    auto assets = std::vector<std::string>();
+    cursor.clear();
+    while(tokendb.read_assets_range(3, cursor, [&](auto& k, auto&&) {
+        assets.emplace_back(k);
+        return false;
+    }) > 0);
+
+    CHECK((int)assets.size() == count + 1);
+    CHECK(std::is_sorted(assets.begin(), assets.end()));
+    CHECK(tokendb.read_assets_range(3, 0, [](auto&, auto&&) { return true; }) == count + 1);
+
+    ROLLBACK();
+    CHECK(!EXISTS_ASSET(addr, 3));
+    CHECK(tokendb.read_assets_range(3, 0, [](auto&, auto&&) { return true; }) == count);
+}
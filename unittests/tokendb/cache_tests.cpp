@@ -87,4 +87,18 @@ TEST_CASE_METHOD(tokendb_test, "cache_test", "[tokendb]") {
         CHECK(cache.lookup_token<domain_def>(token_type::domain, std::nullopt, "dm-tkdb-cache-2") == nullptr);
         CHECK_THROWS_AS(cache.read_token<domain_def>(token_type::domain, std::nullopt, "dm-tkdb-cache-2") == nullptr, unknown_token_database_key);
     }
+
+    SECTION("stats_test") {
+        auto cache2 = token_database_cache(tokendb, 1024 * 1024, 3 /* rounded up to 4 */);
+
+        CHECK(cache2.lookup_token<domain_def>(token_type::domain, std::nullopt, "dm-tkdb-test") == nullptr);
+        CHECK(cache2.read_token<domain_def>(token_type::domain, std::nullopt, "dm-tkdb-test") != nullptr);
+        CHECK(cache2.read_token<domain_def>(token_type::domain, std::nullopt, "dm-tkdb-test") != nullptr);
+
+        auto stats = tokendb.stats();
+        CHECK(stats.find("** Object Cache Stats **") != std::string::npos);
+        CHECK(stats.find("total    : hits: 1, misses: 2, evictions: 0") != std::string::npos);
+
+        CHECK_THROWS_AS(token_database_cache(tokendb, 1024 * 1024, 0), token_database_cache_exception);
+    }
 }
@@ -1,4 +1,6 @@
 #include "tokendb_tests.hpp"
+#include <set>
+#include <thread>
 
 /*
  * Persist Tests: add token
@@ -296,3 +298,746 @@ TEST_CASE_METHOD(tokendb_test, "squash_prst_rlbk", "[tokendb]") {
     CHECK(!EXISTS_TOKEN(domain, "domain-prst-sq"));
 }
 
+/*
+ * Persist Tests: async persist
+ */
+TEST_CASE("async_persist_test", "[tokendb]") {
+    auto dir = fc::path(evt_unittests_dir + "/tokendb_async_tests");
+    if(fc::exists(dir)) {
+        fc::remove_all(dir);
+    }
+
+    auto cfg               = token_database::config();
+    cfg.db_path            = dir;
+    cfg.async_persist      = true;
+    cfg.persist_queue_size = 2;
+
+    auto addr = public_key_type(std::string("EVT8MGU4aKiVzqMtWi9zLpu8KuTHZWjQQrX475ycSxEkLd6aBpraX"));
+    {
+        auto tokendb = token_database(cfg);
+        tokendb.open();
+
+        for(auto i = 1; i <= 8; i++) {
+            tokendb.add_savepoint(i);
+            PUT_ASSET(addr, 4, asset(i, symbol(5, 4)));
+            tokendb.pop_savepoints(i + 1);
+
+            // popped values can be read before they're synced
+            auto as = asset();
+            READ_ASSET(addr, 4, as);
+            CHECK(as.amount() == i);
+        }
+        tokendb.close();
+    }
+    {
+        auto tokendb = token_database(cfg);
+        tokendb.open();
+
+        auto as = asset();
+        READ_ASSET(addr, 4, as);
+        CHECK(as.amount() == 8);
+    }
+}
+
+/*
+ * Persist Tests: irreversible view
+ */
+TEST_CASE("irreversible_view_test", "[tokendb]") {
+    auto dir = fc::path(evt_unittests_dir + "/tokendb_irreversible_tests");
+    if(fc::exists(dir)) {
+        fc::remove_all(dir);
+    }
+
+    auto cfg               = token_database::config();
+    cfg.db_path            = dir;
+    cfg.irreversible_reads = true;
+
+    auto addr = public_key_type(std::string("EVT8MGU4aKiVzqMtWi9zLpu8KuTHZWjQQrX475ycSxEkLd6aBpraX"));
+    auto tokendb = token_database(cfg);
+    tokendb.open();
+
+    auto read_view_asset = [&](auto& view) {
+        auto str = std::string();
+        auto as  = asset();
+        if(!view->read_asset(addr, 4, str, true /* no throw */)) {
+            return (int64_t)-1;
+        }
+        extract_db_value(str, as);
+        return as.amount();
+    };
+
+    auto dom = domain_def();
+    dom.name = "dm-irr";
+
+    auto v0 = tokendb.get_irreversible_view();
+    REQUIRE(v0 != nullptr);
+
+    tokendb.add_savepoint(1);
+    PUT_ASSET(addr, 4, asset(1, symbol(5, 4)));
+    PUT_TOKEN(domain, dom.name, dom);
+    tokendb.add_savepoint(2);
+    PUT_ASSET(addr, 4, asset(2, symbol(5, 4)));
+    tokendb.add_savepoint(3);
+    PUT_ASSET(addr, 4, asset(3, symbol(5, 4)));
+
+    // nothing is irreversible yet
+    auto v1 = tokendb.get_irreversible_view();
+    auto str = std::string();
+    CHECK(read_view_asset(v1) == -1);
+    CHECK(!v1->read_token(token_type::domain, std::nullopt, dom.name, str, true /* no throw */));
+
+    // balance written in 1 is carried by later savepoints and not persisted yet
+    tokendb.pop_savepoints(2);
+    auto v2 = tokendb.get_irreversible_view();
+    CHECK(read_view_asset(v2) == 1);
+    CHECK(v2->read_token(token_type::domain, std::nullopt, dom.name, str, true /* no throw */));
+
+    // views taken earlier never change
+    CHECK(read_view_asset(v1) == -1);
+
+    ROLLBACK();
+    tokendb.pop_savepoints(3);
+    auto v3 = tokendb.get_irreversible_view();
+    CHECK(read_view_asset(v3) == 2);
+    CHECK(read_view_asset(v2) == 1);
+
+    auto as = asset();
+    READ_ASSET(addr, 4, as);
+    CHECK(as.amount() == 2);
+
+    v0.reset();
+    v1.reset();
+    v2.reset();
+    v3.reset();
+    tokendb.close();
+}
+
+/*
+ * Persist Tests: ram profile
+ */
+TEST_CASE("ram_profile_test", "[tokendb]") {
+    auto cfg    = token_database::config();
+    cfg.db_path = fc::path(evt_unittests_dir + "/tokendb_ram_tests");
+    cfg.profile = storage_profile::ram;
+
+    auto addr = public_key_type(std::string("EVT8MGU4aKiVzqMtWi9zLpu8KuTHZWjQQrX475ycSxEkLd6aBpraX"));
+    {
+        auto tokendb = token_database(cfg);
+        tokendb.open();
+
+        tokendb.add_savepoint(1);
+        PUT_ASSET(addr, 4, asset(1, symbol(5, 4)));
+        tokendb.add_savepoint(2);
+        PUT_ASSET(addr, 4, asset(2, symbol(5, 4)));
+        ROLLBACK();
+
+        auto as = asset();
+        READ_ASSET(addr, 4, as);
+        CHECK(as.amount() == 1);
+
+        tokendb.pop_savepoints(2);
+        CHECK(EXISTS_ASSET(addr, 4));
+        tokendb.close();
+    }
+    CHECK(!fc::exists(cfg.db_path));
+    {
+        // nothing survives after closed
+        auto tokendb = token_database(cfg);
+        tokendb.open();
+        CHECK(!EXISTS_ASSET(addr, 4));
+    }
+}
+
+/*
+ * Persist Tests: bulk load
+ */
+TEST_CASE("bulk_load_test", "[tokendb]") {
+    auto dir = fc::path(evt_unittests_dir + "/tokendb_bulk_tests");
+    if(fc::exists(dir)) {
+        fc::remove_all(dir);
+    }
+
+    auto cfg    = token_database::config();
+    cfg.db_path = dir;
+
+    auto tokendb = token_database(cfg);
+    tokendb.open();
+
+    auto addr = public_key_type(std::string("EVT8MGU4aKiVzqMtWi9zLpu8KuTHZWjQQrX475ycSxEkLd6aBpraX"));
+    auto var  = fc::json::from_string(token_data);
+    auto tk   = var.as<token_def>();
+
+    tokendb.begin_bulk_load();
+    CHECK_THROWS_AS(tokendb.begin_bulk_load(), token_database_bulk_load_exception);
+
+    // keys are not in order, needs more than one file
+    PUT_TOKEN2(token, "dm-bulk", "t3", tk);
+    PUT_TOKEN2(token, "dm-bulk", "t1", tk);
+    PUT_TOKEN2(token, "dm-bulk", "t2", tk);
+    PUT_ASSET(addr, 4, asset(8, symbol(5, 4)));
+
+    tokendb.end_bulk_load();
+    CHECK(!fc::exists(dir / config::token_database_bulk_load_dir));
+
+    CHECK(EXISTS_TOKEN2(token, "dm-bulk", "t1"));
+    CHECK(EXISTS_TOKEN2(token, "dm-bulk", "t2"));
+    CHECK(EXISTS_TOKEN2(token, "dm-bulk", "t3"));
+
+    auto as = asset();
+    READ_ASSET(addr, 4, as);
+    CHECK(as.amount() == 8);
+
+    tokendb.add_savepoint(1);
+    CHECK_THROWS_AS(tokendb.begin_bulk_load(), token_database_bulk_load_exception);
+}
+
+/*
+ * Persist Tests: key filters
+ */
+TEST_CASE("key_filters_test", "[tokendb]") {
+    auto dir = fc::path(evt_unittests_dir + "/tokendb_filters_tests");
+    if(fc::exists(dir)) {
+        fc::remove_all(dir);
+    }
+
+    auto cfg    = token_database::config();
+    cfg.db_path = dir;
+
+    auto ticker = [](auto& tokendb, auto name) {
+        return tokendb.tickers()[std::string("evt.tokendb.key_filters.") + name];
+    };
+    {
+        auto tokendb = token_database(cfg);
+        tokendb.open();
+
+        tokendb.add_savepoint(1);
+        ADD_TOKEN(evtlink, name128::from_number(1), std::string("link1"));
+        tokendb.add_savepoint(2);
+        ADD_TOKEN(evtlink, name128::from_number(2), std::string("link2"));
+        ADD_TOKEN2(token, N128(dm-filter), name128::from_number(1), std::string("token1"));
+        CHECK(EXISTS_TOKEN(evtlink, name128::from_number(2)));
+        CHECK(EXISTS_TOKEN2(token, N128(dm-filter), name128::from_number(1)));
+        CHECK(tokendb.get_memory_usage().key_filters > 0);
+
+        // keys of the rolled back savepoint are removed from filters
+        auto negatives = ticker(tokendb, "negatives");
+        ROLLBACK();
+        CHECK(EXISTS_TOKEN(evtlink, name128::from_number(1)));
+        CHECK(!EXISTS_TOKEN(evtlink, name128::from_number(2)));
+        CHECK(!EXISTS_TOKEN(evtlink, name128::from_number(3)));
+        CHECK(!EXISTS_TOKEN2(token, N128(dm-filter), name128::from_number(1)));
+        CHECK(ticker(tokendb, "negatives") >= negatives + 3);
+
+        // full filter is rebuilt from db
+        tokendb.add_savepoint(2);
+        for(auto i = 0u; i < 3000; i++) {
+            ADD_TOKEN2(token, N128(dm-filter), name128::from_number(i), std::string("token"));
+        }
+        CHECK(ticker(tokendb, "rebuilds") > 0);
+        for(auto i = 0u; i < 3000; i++) {
+            REQUIRE(EXISTS_TOKEN2(token, N128(dm-filter), name128::from_number(i)));
+        }
+        CHECK(!EXISTS_TOKEN2(token, N128(dm-filter), name128::from_number(3000)));
+
+        // rebuilt in a savepoint which is rolled back, no key left is answered absent
+        auto rebuilds = ticker(tokendb, "rebuilds");
+        tokendb.add_savepoint(3);
+        for(auto i = 3000u; i < 12000; i++) {
+            ADD_TOKEN2(token, N128(dm-filter), name128::from_number(i), std::string("token"));
+        }
+        CHECK(ticker(tokendb, "rebuilds") > rebuilds);
+        ROLLBACK();
+        for(auto i = 0u; i < 3000; i++) {
+            REQUIRE(EXISTS_TOKEN2(token, N128(dm-filter), name128::from_number(i)));
+        }
+        negatives = ticker(tokendb, "negatives");
+        for(auto i = 3000u; i < 12000; i++) {
+            REQUIRE(!EXISTS_TOKEN2(token, N128(dm-filter), name128::from_number(i)));
+        }
+        CHECK(ticker(tokendb, "negatives") > negatives);
+        CHECK(EXISTS_TOKEN(evtlink, name128::from_number(1)));
+
+        tokendb.pop_savepoints(3);
+        tokendb.close();
+    }
+    CHECK(fc::exists(dir / config::token_database_filters_filename));
+    {
+        // filters persisted are loaded once
+        auto tokendb = token_database(cfg);
+        tokendb.open();
+        CHECK(!fc::exists(dir / config::token_database_filters_filename));
+        CHECK(EXISTS_TOKEN(evtlink, name128::from_number(1)));
+        CHECK(!EXISTS_TOKEN(evtlink, name128::from_number(2)));
+        CHECK(EXISTS_TOKEN2(token, N128(dm-filter), name128::from_number(2999)));
+
+        ADD_TOKEN(evtlink, name128::from_number(3), std::string("link3"));
+        CHECK(EXISTS_TOKEN(evtlink, name128::from_number(3)));
+
+        // only misses of positives are false ones
+        CHECK(ticker(tokendb, "false_positives") <= ticker(tokendb, "positives"));
+        tokendb.close(false /* persist */);
+    }
+    CHECK(!fc::exists(dir / config::token_database_filters_filename));
+    {
+        // filters are rebuilt from db without the persisted ones
+        auto tokendb = token_database(cfg);
+        tokendb.open();
+        CHECK(EXISTS_TOKEN(evtlink, name128::from_number(3)));
+        CHECK(EXISTS_TOKEN2(token, N128(dm-filter), name128::from_number(0)));
+        CHECK(!EXISTS_TOKEN2(token, N128(dm-filter), name128::from_number(3000)));
+    }
+}
+
+TEST_CASE("prefetch_test", "[tokendb]") {
+    auto dir = fc::path(evt_unittests_dir + "/tokendb_prefetch_tests");
+    if(fc::exists(dir)) {
+        fc::remove_all(dir);
+    }
+
+    auto cfg    = token_database::config();
+    cfg.db_path = dir;
+
+    auto tokendb = token_database(cfg);
+    tokendb.open();
+
+    auto addr = address(public_key_type(std::string("EVT8MGU4aKiVzqMtWi9zLpu8KuTHZWjQQrX475ycSxEkLd6aBpraX")));
+    tokendb.add_savepoint(1);
+    ADD_TOKEN(evtlink, name128::from_number(1), std::string("link1"));
+    PUT_ASSET(addr, 3, asset(10, symbol(5, 3)));
+    tokendb.pop_savepoints(2);
+
+    // pending asset isn't in db and missing keys are fine
+    tokendb.add_savepoint(2);
+    PUT_ASSET(addr, 4, asset(10, symbol(5, 4)));
+
+    auto keys = token_database::prefetch_keys();
+    keys.tokens.emplace_back(token_type::evtlink, std::nullopt, name128::from_number(1));
+    keys.tokens.emplace_back(token_type::token, N128(dom), N128(missing));
+    keys.assets.emplace_back(addr, 3);
+    keys.assets.emplace_back(addr, 4);
+
+    // done by another thread while this one keeps reading
+    auto t = std::thread([&] { tokendb.prefetch(keys); });
+    CHECK(EXISTS_TOKEN(evtlink, name128::from_number(1)));
+    t.join();
+    CHECK(tokendb.tickers()["evt.tokendb.keys.prefetched"] == 4);
+
+    CHECK(EXISTS_ASSET(addr, 3));
+    CHECK(EXISTS_ASSET(addr, 4));
+    CHECK(!EXISTS_TOKEN2(token, N128(dom), N128(missing)));
+}
+
+TEST_CASE("io_rates_test", "[tokendb]") {
+    auto dir = fc::path(evt_unittests_dir + "/tokendb_io_rates_tests");
+    if(fc::exists(dir)) {
+        fc::remove_all(dir);
+    }
+
+    auto cfg      = token_database::config();
+    cfg.db_path   = dir;
+    cfg.io_rate   = 16 * 1024 * 1024;
+    cfg.auto_tune = true;
+
+    auto tokendb = token_database(cfg);
+    tokendb.open();
+    CHECK(tokendb.get_io_rates() == std::make_pair((uint64_t)16 * 1024 * 1024, (uint64_t)0));
+
+    // writes go on whatever the rates are
+    tokendb.set_background_busy(false);
+    tokendb.set_io_rates(1024 * 1024, 8 * 1024 * 1024);
+    CHECK(tokendb.get_io_rates() == std::make_pair((uint64_t)1024 * 1024, (uint64_t)8 * 1024 * 1024));
+
+    tokendb.add_savepoint(1);
+    ADD_TOKEN(evtlink, name128::from_number(1), std::string("link1"));
+    tokendb.pop_savepoints(2);
+
+    tokendb.set_background_busy(true);
+    CHECK(EXISTS_TOKEN(evtlink, name128::from_number(1)));
+
+    tokendb.close();
+    tokendb.open();
+    CHECK(EXISTS_TOKEN(evtlink, name128::from_number(1)));
+}
+
+/*
+ * Persist Tests: checkpoint
+ */
+TEST_CASE("checkpoint_test", "[tokendb]") {
+    auto dir     = fc::path(evt_unittests_dir + "/tokendb_checkpoint_tests");
+    auto cp_dir  = fc::path(evt_unittests_dir + "/tokendb_checkpoint_tests_cp");
+    auto rst_dir = fc::path(evt_unittests_dir + "/tokendb_checkpoint_tests_rst");
+    for(auto& d : { dir, cp_dir, rst_dir }) {
+        if(fc::exists(d)) {
+            fc::remove_all(d);
+        }
+    }
+
+    auto cfg    = token_database::config();
+    cfg.db_path = dir;
+
+    auto addr = public_key_type(std::string("EVT8MGU4aKiVzqMtWi9zLpu8KuTHZWjQQrX475ycSxEkLd6aBpraX"));
+    {
+        auto tokendb = token_database(cfg);
+        tokendb.open();
+
+        tokendb.add_savepoint(1);
+        PUT_ASSET(addr, 4, asset(1, symbol(5, 4)));
+        tokendb.pop_savepoints(2);
+
+        // savepoint 2 is still reversible when checkpoint is taken
+        tokendb.add_savepoint(2);
+        PUT_ASSET(addr, 4, asset(2, symbol(5, 4)));
+        tokendb.create_checkpoint(cp_dir);
+        CHECK_THROWS_AS(tokendb.create_checkpoint(cp_dir), token_database_exception);
+
+        // changes after checkpoint are not included
+        tokendb.add_savepoint(3);
+        PUT_ASSET(addr, 4, asset(3, symbol(5, 4)));
+        tokendb.pop_savepoints(4);
+        tokendb.close();
+    }
+
+    CHECK_THROWS_AS(token_database::restore_checkpoint(cp_dir, dir), token_database_exception);
+    token_database::restore_checkpoint(cp_dir, rst_dir);
+
+    cfg.db_path = rst_dir;
+    {
+        auto tokendb = token_database(cfg);
+        tokendb.open();
+        CHECK(tokendb.savepoints_size() == 1);
+        CHECK(tokendb.latest_savepoint_seq() == 2);
+
+        auto as = asset();
+        READ_ASSET(addr, 4, as);
+        CHECK(as.amount() == 2);
+
+        ROLLBACK();
+        READ_ASSET(addr, 4, as);
+        CHECK(as.amount() == 1);
+        tokendb.close();
+    }
+
+    // checkpoint itself is untouched by the restored database
+    cfg.db_path = cp_dir;
+    {
+        auto tokendb = token_database(cfg);
+        tokendb.open();
+        CHECK(tokendb.savepoints_size() == 1);
+    }
+}
+
+/*
+ * Persist Tests: integrity hash
+ */
+TEST_CASE("integrity_hash_test", "[tokendb]") {
+    auto dir = fc::path(evt_unittests_dir + "/tokendb_hash_tests");
+    if(fc::exists(dir)) {
+        fc::remove_all(dir);
+    }
+
+    auto cfg    = token_database::config();
+    cfg.db_path = dir;
+
+    auto addr = public_key_type(std::string("EVT8MGU4aKiVzqMtWi9zLpu8KuTHZWjQQrX475ycSxEkLd6aBpraX"));
+    auto dom  = fc::json::from_string(domain_data).as<domain_def>();
+    auto fg   = fc::json::from_string(fungible_data).as<fungible_def>();
+    auto tk   = fc::json::from_string(token_data).as<token_def>();
+
+    auto h1 = fc::sha256();
+    auto h2 = fc::sha256();
+    {
+        auto tokendb = token_database(cfg);
+        tokendb.open();
+
+        dom.name = "dm-hash";
+        PUT_TOKEN(domain, dom.name, dom);
+        PUT_TOKEN(fungible, 4, fg);
+        PUT_TOKEN2(token, "dm-hash", "t1", tk);
+        PUT_ASSET(addr, 4, asset(1, symbol(5, 4)));
+
+        h1 = tokendb.calculate_integrity_hash();
+        CHECK(tokendb.calculate_integrity_hash() == h1);
+
+        tokendb.add_savepoint(1);
+        PUT_TOKEN2(token, "dm-hash", "t2", tk);
+        PUT_ASSET(addr, 4, asset(2, symbol(5, 4)));
+        h2 = tokendb.calculate_integrity_hash();
+        CHECK(h2 != h1);
+
+        // rolled back partitions are rehashed
+        ROLLBACK();
+        CHECK(tokendb.calculate_integrity_hash() == h1);
+
+        tokendb.add_savepoint(2);
+        PUT_TOKEN2(token, "dm-hash", "t2", tk);
+        PUT_ASSET(addr, 4, asset(2, symbol(5, 4)));
+        CHECK(tokendb.calculate_integrity_hash() == h2);
+
+        // persisting savepoints doesn't change the state
+        tokendb.pop_savepoints(3);
+        CHECK(tokendb.calculate_integrity_hash() == h2);
+        tokendb.close();
+    }
+
+    // rebuilt roots are the same as the incremental ones
+    {
+        auto tokendb = token_database(cfg);
+        tokendb.open();
+        CHECK(tokendb.calculate_integrity_hash() == h2);
+        tokendb.close();
+    }
+}
+
+/*
+ * Persist Tests: owner index
+ */
+TEST_CASE("owner_index_test", "[tokendb]") {
+    auto dir      = fc::path(evt_unittests_dir + "/tokendb_owner_tests");
+    auto bulk_dir = fc::path(evt_unittests_dir + "/tokendb_owner_tests_bulk");
+    for(auto& d : { dir, bulk_dir }) {
+        if(fc::exists(d)) {
+            fc::remove_all(d);
+        }
+    }
+
+    auto cfg        = token_database::config();
+    cfg.db_path     = dir;
+    cfg.owner_index = true;
+
+    auto a1  = address(tester::get_public_key(N(o1)));
+    auto a2  = address(tester::get_public_key(N(o2)));
+    auto dom = fc::json::from_string(domain_data).as<domain_def>();
+    auto tk  = fc::json::from_string(token_data).as<token_def>();
+    dom.name  = "dm-owner";
+    tk.domain = dom.name;
+
+    auto owned = [](auto& tokendb, auto& addr) {
+        auto names = std::set<std::string>();
+        tokendb.read_owned_tokens(addr, 0, [&](auto& domain, auto& name) {
+            CHECK(domain == N128(dm-owner));
+            names.emplace((std::string)name);
+            return true;
+        });
+        return names;
+    };
+
+    auto h = fc::sha256();
+    {
+        auto tokendb = token_database(cfg);
+        tokendb.open();
+        CHECK(tokendb.has_owner_index());
+
+        PUT_TOKEN(domain, dom.name, dom);
+
+        tk.name  = "t1";
+        tk.owner = { a1 };
+        ADD_TOKEN2(token, tk.domain, tk.name, tk);
+        tk.name  = "t2";
+        tk.owner = { a1, a2 };
+        ADD_TOKEN2(token, tk.domain, tk.name, tk);
+
+        CHECK(owned(tokendb, a1) == std::set<std::string>{ "t1", "t2" });
+        CHECK(owned(tokendb, a2) == std::set<std::string>{ "t2" });
+
+        // transfer is rolled back together with the index
+        tokendb.add_savepoint(1);
+        tk.name  = "t1";
+        tk.owner = { a2 };
+        UPDATE_TOKEN2(token, tk.domain, tk.name, tk);
+        CHECK(owned(tokendb, a1) == std::set<std::string>{ "t2" });
+        CHECK(owned(tokendb, a2) == std::set<std::string>{ "t1", "t2" });
+        ROLLBACK();
+        CHECK(owned(tokendb, a1) == std::set<std::string>{ "t1", "t2" });
+        CHECK(owned(tokendb, a2) == std::set<std::string>{ "t2" });
+
+        // destroyed tokens are not listed
+        tk.name  = "t2";
+        tk.owner = { address() };
+        UPDATE_TOKEN2(token, tk.domain, tk.name, tk);
+        CHECK(owned(tokendb, a1) == std::set<std::string>{ "t1" });
+        CHECK(owned(tokendb, a2).empty());
+
+        // index is not a part of the state
+        h = tokendb.calculate_integrity_hash();
+        tokendb.close();
+    }
+    {
+        auto tokendb = token_database(cfg);
+        tokendb.open();
+        CHECK(tokendb.calculate_integrity_hash() == h);
+        tokendb.close();
+    }
+    {
+        // index cannot be turned off on the same database
+        cfg.owner_index = false;
+        auto tokendb = token_database(cfg);
+        CHECK_THROWS_AS(tokendb.open(), token_database_exception);
+    }
+    {
+        // index is rebuilt from loaded tokens
+        cfg.db_path     = bulk_dir;
+        cfg.owner_index = true;
+        auto tokendb = token_database(cfg);
+        tokendb.open();
+
+        tokendb.begin_bulk_load();
+        PUT_TOKEN(domain, dom.name, dom);
+        tk.name  = "t3";
+        tk.owner = { a2 };
+        PUT_TOKEN2(token, tk.domain, tk.name, tk);
+        tokendb.end_bulk_load();
+
+        CHECK(owned(tokendb, a2) == std::set<std::string>{ "t3" });
+    }
+}
+
+/*
+ * Persist Tests: holding index
+ */
+TEST_CASE("holding_index_test", "[tokendb]") {
+    auto dir      = fc::path(evt_unittests_dir + "/tokendb_holding_tests");
+    auto bulk_dir = fc::path(evt_unittests_dir + "/tokendb_holding_tests_bulk");
+    for(auto& d : { dir, bulk_dir }) {
+        if(fc::exists(d)) {
+            fc::remove_all(d);
+        }
+    }
+
+    auto cfg          = token_database::config();
+    cfg.db_path       = dir;
+    cfg.holding_index = true;
+
+    auto a1 = address(tester::get_public_key(N(h1)));
+    auto a2 = address(tester::get_public_key(N(h2)));
+    auto as = asset::from_string("1.00000 S#4");
+
+    auto held = [](auto& tokendb, auto& addr) {
+        auto ids = std::set<symbol_id_type>();
+        tokendb.read_held_symbols(addr, [&](auto sym_id) {
+            ids.emplace(sym_id);
+            return true;
+        });
+        return ids;
+    };
+
+    auto h = fc::sha256();
+    {
+        auto tokendb = token_database(cfg);
+        tokendb.open();
+        CHECK(tokendb.has_holding_index());
+
+        PUT_ASSET(a1, 4, as);
+        PUT_ASSET(a1, 5, as);
+        PUT_ASSET(a1, 4, as);
+        CHECK(held(tokendb, a1) == std::set<symbol_id_type>{ 4, 5 });
+        CHECK(held(tokendb, a2).empty());
+
+        // new holders are rolled back together with the assets
+        tokendb.add_savepoint(1);
+        PUT_ASSET(a2, 5, as);
+        CHECK(held(tokendb, a2) == std::set<symbol_id_type>{ 5 });
+        ROLLBACK();
+        CHECK(held(tokendb, a2).empty());
+
+        tokendb.add_savepoint(2);
+        PUT_ASSET(a2, 4, as);
+        tokendb.pop_savepoints(3);
+        CHECK(held(tokendb, a2) == std::set<symbol_id_type>{ 4 });
+
+        // index is not a part of the state
+        h = tokendb.calculate_integrity_hash();
+        tokendb.close();
+    }
+    {
+        auto tokendb = token_database(cfg);
+        tokendb.open();
+        CHECK(tokendb.calculate_integrity_hash() == h);
+        CHECK(held(tokendb, a1) == std::set<symbol_id_type>{ 4, 5 });
+        tokendb.close();
+    }
+    {
+        // index cannot be turned off on the same database
+        cfg.holding_index = false;
+        auto tokendb = token_database(cfg);
+        CHECK_THROWS_AS(tokendb.open(), token_database_exception);
+    }
+    {
+        // index is rebuilt from loaded assets
+        cfg.db_path       = bulk_dir;
+        cfg.holding_index = true;
+        auto tokendb = token_database(cfg);
+        tokendb.open();
+
+        tokendb.begin_bulk_load();
+        PUT_ASSET(a1, 6, as);
+        PUT_ASSET(a2, 6, as);
+        PUT_ASSET(a2, 7, as);
+        tokendb.end_bulk_load();
+
+        CHECK(held(tokendb, a1) == std::set<symbol_id_type>{ 6 });
+        CHECK(held(tokendb, a2) == std::set<symbol_id_type>{ 6, 7 });
+    }
+}
+
+/*
+ * Persist Tests: secondary instance
+ */
+TEST_CASE("secondary_test", "[tokendb]") {
+    auto dir = fc::path(evt_unittests_dir + "/tokendb_secondary_tests");
+    if(fc::exists(dir)) {
+        fc::remove_all(dir);
+    }
+
+    auto cfg    = token_database::config();
+    cfg.db_path = dir / "primary";
+
+    auto scfg           = cfg;
+    scfg.secondary_path = dir / "secondary";
+
+    auto var  = fc::json::from_string(domain_data);
+    auto dom  = var.as<domain_def>();
+    auto addr = public_key_type(std::string("EVT8MGU4aKiVzqMtWi9zLpu8KuTHZWjQQrX475ycSxEkLd6aBpraX"));
+
+    auto primary = token_database(cfg);
+    primary.open();
+
+    // primary has to be there first
+    {
+        auto bad = scfg;
+        bad.db_path = dir / "missing";
+        auto db = token_database(bad);
+        CHECK_THROWS_AS(db.open(), token_database_secondary_exception);
+    }
+
+    auto secondary = token_database(scfg);
+    secondary.open();
+    CHECK(secondary.is_secondary());
+    CHECK(!primary.is_secondary());
+    CHECK_THROWS_AS(primary.catch_up_with_primary(), token_database_secondary_exception);
+
+    {
+        auto& tokendb = primary;
+        tokendb.add_savepoint(1);
+        PUT_TOKEN(domain, dom.name, dom);
+        PUT_ASSET(addr, 4, asset(100, symbol(5, 4)));
+    }
+    {
+        auto& tokendb = secondary;
+        CHECK(!EXISTS_TOKEN(domain, dom.name));
+
+        // tokens are seen once written, assets once their savepoints are popped
+        secondary.catch_up_with_primary();
+        CHECK(EXISTS_TOKEN(domain, dom.name));
+        CHECK(!EXISTS_ASSET(addr, 4));
+
+        primary.pop_savepoints(2);
+        secondary.catch_up_with_primary();
+        auto as = asset();
+        READ_ASSET(addr, 4, as);
+        CHECK(as.amount() == 100);
+
+        // never written
+        CHECK_THROWS_AS(tokendb.put_token(token_type::domain, action_op::put, std::nullopt, dom.name, "v"), token_database_secondary_exception);
+        CHECK_THROWS_AS(tokendb.add_savepoint(3), token_database_secondary_exception);
+    }
+}
@@ -142,6 +142,54 @@ TEST_CASE_METHOD(tokendb_test, "put_asset_svpt_test", "[tokendb]") {
     my_tester->produce_block();
 }
 
+TEST_CASE_METHOD(tokendb_test, "update_asset_svpt_test", "[tokendb]") {
+    auto& tokendb = my_tester->control->token_db();
+    my_tester->produce_block();
+
+    auto addr = public_key_type(std::string("EVT8MGU4aKiVzqMtWi9zLpu8KuTHZWjQQrX475ycSxEkLd6aBpraX"));
+    auto add  = [&](auto amount) {
+        tokendb.update_asset(addr, 4, [&](auto& v) {
+            auto as = asset(0, symbol(5, 4));
+            if(!v.empty()) {
+                extract_db_value(v, as);
+            }
+            auto dv = make_db_value(asset(as.amount() + amount, as.sym()));
+            v.assign(dv.as_string_view());
+        });
+    };
+
+    ADD_SAVEPOINT();
+
+    // missing asset starts empty
+    CHECK(!EXISTS_ASSET(addr, 4));
+    add(100);
+    CHECK(EXISTS_ASSET(addr, 4));
+
+    ADD_SAVEPOINT();
+
+    // cached asset is patched in place
+    add(50);
+    add(25);
+    auto as = asset();
+    READ_ASSET(addr, 4, as);
+    CHECK(as.amount() == 175);
+
+    // a throwing update is undone by rollback
+    CHECK_THROWS(tokendb.update_asset(addr, 4, [&](auto& v) {
+        v.assign("broken");
+        throw std::runtime_error("failed");
+    }));
+
+    ROLLBACK();
+    READ_ASSET(addr, 4, as);
+    CHECK(as.amount() == 100);
+
+    ROLLBACK();
+    CHECK(!EXISTS_ASSET(addr, 4));
+
+    my_tester->produce_block();
+}
+
 TEST_CASE_METHOD(tokendb_test, "put_tokens_svpt_test", "[tokendb]") {
     auto& tokendb = my_tester->control->token_db();
     my_tester->produce_block();
@@ -236,3 +284,145 @@ TEST_CASE_METHOD(tokendb_test, "squansh_test", "[tokendb]") {
 
     my_tester->produce_block();
 }
+
+TEST_CASE_METHOD(tokendb_test, "squash_empty_svpt_test", "[tokendb]") {
+    auto& tokendb = my_tester->control->token_db();
+    my_tester->produce_block();
+
+    auto var = fc::json::from_string(domain_data);
+    auto dom = var.as<domain_def>();
+    dom.name = "domain-sq-empty";
+
+    // savepoint without any token writes, then rollback
+    ADD_SAVEPOINT();
+    ROLLBACK();
+    CHECK(!EXISTS_TOKEN(domain, dom.name));
+
+    // outer savepoint stays clean, inner one writes tokens
+    ADD_SAVEPOINT();
+    auto n = tokendb.savepoints_size();
+
+    ADD_SAVEPOINT();
+    PUT_TOKEN(domain, dom.name, dom);
+    CHECK(EXISTS_TOKEN(domain, dom.name));
+
+    tokendb.squash();
+    CHECK(tokendb.savepoints_size() == n);
+    CHECK(EXISTS_TOKEN(domain, dom.name));
+
+    ROLLBACK();
+    CHECK(!EXISTS_TOKEN(domain, dom.name));
+
+    my_tester->produce_block();
+}
+
+TEST_CASE_METHOD(tokendb_test, "nested_svpt_test", "[tokendb]") {
+    auto& tokendb = my_tester->control->token_db();
+    my_tester->produce_block();
+
+    auto snapshots = [&] { return tokendb.tickers()["evt.tokendb.snapshots"]; };
+
+    auto var = fc::json::from_string(domain_data);
+    auto dom = var.as<domain_def>();
+    dom.name = "domain-nested";
+
+    // block level
+    ADD_SAVEPOINT();
+    auto n     = tokendb.savepoints_size();
+    auto start = snapshots();
+
+    // transactions: the first one adds the domain, the others update it
+    for(auto i = 0; i < 10; i++) {
+        auto s = tokendb.new_savepoint_session();
+        dom.metas[0].key = "key-" + std::to_string(i);
+        PUT_TOKEN(domain, dom.name, dom);
+        s.squash();
+    }
+    CHECK(tokendb.savepoints_size() == n);
+    // savepoints are rolled back from their journals, snapshots are only taken for irreversible reads
+    CHECK(snapshots() - start == 0);
+
+    // failed transaction restores the value before it
+    {
+        auto s = tokendb.new_savepoint_session();
+        dom.metas[0].key = "key-failed";
+        PUT_TOKEN(domain, dom.name, dom);
+        PUT_TOKEN(domain, dom.name, dom);
+    }
+    auto _dom = domain_def();
+    READ_TOKEN(domain, dom.name, _dom);
+    CHECK(_dom.metas[0].key == "key-9");
+    CHECK(snapshots() - start == 0);
+
+    ROLLBACK();
+    CHECK(!EXISTS_TOKEN(domain, dom.name));
+
+    my_tester->produce_block();
+}
+
+TEST_CASE_METHOD(tokendb_test, "squashed_deltas_test", "[tokendb]") {
+    auto& tokendb = my_tester->control->token_db();
+    my_tester->produce_block();
+
+    auto var  = fc::json::from_string(domain_data);
+    auto dom  = var.as<domain_def>();
+    dom.name  = "domain-deltas";
+    auto addr = public_key_type(std::string("EVT8MGU4aKiVzqMtWi9zLpu8KuTHZWjQQrX475ycSxEkLd6aBpraX"));
+
+    auto seqs     = std::vector<int64_t>();
+    auto deltas   = token_database::token_deltas();
+    auto reverted = std::vector<int64_t>();
+
+    auto c1 = boost::signals2::scoped_connection(tokendb.squashed_deltas.connect([&](auto seq, auto& d) {
+        seqs.emplace_back(seq);
+        deltas = std::move(d);
+    }));
+    auto c2 = boost::signals2::scoped_connection(tokendb.rolled_back_savepoint.connect([&](auto seq) {
+        reverted.emplace_back(seq);
+    }));
+
+    // block level
+    ADD_SAVEPOINT();
+    auto seq = tokendb.latest_savepoint_seq();
+
+    // the token is written twice and the asset once, deltas have their latest values
+    {
+        auto s = tokendb.new_savepoint_session();
+        PUT_TOKEN(domain, dom.name, dom);
+        dom.metas[0].key = "key-latest";
+        PUT_TOKEN(domain, dom.name, dom);
+        PUT_ASSET(addr, 4, asset(100, symbol(5, 4)));
+        s.squash();
+    }
+    REQUIRE(seqs.size() == 1);
+    CHECK(seqs[0] == seq);
+    REQUIRE(deltas.size() == 2);
+
+    CHECK(deltas[0].type == token_type::domain);
+    REQUIRE(deltas[0].value.has_value());
+    auto _dom = domain_def();
+    extract_db_value(*deltas[0].value, _dom);
+    CHECK(_dom.metas[0].key == "key-latest");
+
+    CHECK(deltas[1].type == token_type::asset);
+    REQUIRE(deltas[1].value.has_value());
+    auto as = asset();
+    extract_db_value(*deltas[1].value, as);
+    CHECK(as.amount() == 100);
+
+    // failed transaction emits nothing
+    {
+        auto s = tokendb.new_savepoint_session();
+        PUT_ASSET(addr, 4, asset(200, symbol(5, 4)));
+    }
+    CHECK(seqs.size() == 1);
+    CHECK(reverted.empty());
+
+    // the block is reverted altogether
+    ROLLBACK();
+    CHECK(!EXISTS_TOKEN(domain, dom.name));
+    REQUIRE(reverted.size() == 1);
+    CHECK(reverted[0] == seq);
+
+    my_tester->produce_block();
+}
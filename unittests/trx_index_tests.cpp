@@ -0,0 +1,63 @@
+#include <catch/catch.hpp>
+#include <fc/bitutil.hpp>
+#include <fc/filesystem.hpp>
+
+#include <evt/chain/trx_index.hpp>
+
+using namespace evt;
+using namespace chain;
+
+extern std::string evt_unittests_dir;
+
+namespace {
+
+// block `num` with `n` transactions told apart by their expirations
+signed_block
+make_block(uint32_t num, uint32_t n) {
+    auto b = signed_block();
+    b.previous._hash[0] = fc::endian_reverse_u32(num - 1);
+    for(auto i = 0u; i < n; i++) {
+        auto trx = signed_transaction();
+        trx.expiration = fc::time_point_sec(num * 1000 + i);
+        b.transactions.emplace_back(packed_transaction(trx));
+    }
+    return b;
+}
+
+}  // namespace
+
+TEST_CASE("trx_index_test", "[trx_index]") {
+    auto dir = fc::path(evt_unittests_dir) / "trx_index_tests";
+    fc::remove_all(dir);
+
+    auto b1 = make_block(1, 3);
+    auto b2 = make_block(2, 2);
+    auto b3 = make_block(3, 1);
+    {
+        auto idx = trx_index(dir);
+        CHECK(idx.last_num() == 0);
+
+        idx.add(b1);
+        idx.add(b2);
+        CHECK(idx.last_num() == 2);
+
+        auto loc = idx.find(b2.transactions[1].trx.id());
+        REQUIRE(loc.has_value());
+        CHECK(loc->block_num == 2);
+        CHECK(loc->trx_pos == 1);
+        CHECK(!idx.find(b3.transactions[0].trx.id()).has_value());
+
+        // blocks already indexed are ignored
+        idx.add(b1);
+        CHECK(idx.last_num() == 2);
+    }
+    {
+        // reopened with the last block indexed
+        auto idx = trx_index(dir);
+        CHECK(idx.last_num() == 2);
+        CHECK(idx.find(b1.transactions[0].trx.id())->block_num == 1);
+
+        idx.add(b3);
+        CHECK(idx.find(b3.transactions[0].trx.id())->block_num == 3);
+    }
+}
@@ -1,11 +1,29 @@
 #include <catch/catch.hpp>
 
+#include <random>
+
+#include <fc/crypto/base58.hpp>
+#include <fc/io/json.hpp>
+#include <fc/io/json_writer.hpp>
+#include <evt/chain/action.hpp>
+#include <evt/chain/action_costs.hpp>
 #include <evt/chain/address.hpp>
+#include <evt/chain/incremental_merkle.hpp>
+#include <evt/chain/merkle.hpp>
 #include <evt/chain/types.hpp>
 #include <evt/chain/token_database.hpp>
+#include <evt/chain/transaction.hpp>
 #include <evt/chain/contracts/authorizer_ref.hpp>
 #include <evt/chain/contracts/evt_link.hpp>
+#include <evt/chain/contracts/property_record.hpp>
 #include <evt/chain/contracts/types.hpp>
+#include <evt/chain/execution_context_mock.hpp>
+#include <evt/utilities/task_scheduler.hpp>
+
+FC_JSON_REFLECTED(evt::chain::contracts::authorizer_weight);
+FC_JSON_REFLECTED(evt::chain::contracts::permission_def);
+FC_JSON_REFLECTED(evt::chain::contracts::meta);
+FC_JSON_REFLECTED(evt::chain::contracts::domain_def);
 
 using namespace evt::chain;
 using namespace evt::chain::contracts;
@@ -272,6 +290,16 @@ TEST_CASE("test_name128", "[types]") {
     auto n4 = name128(N128(ABCDEFGZZ));
     CHECK((std::string)n4 == "ABCDEFGZZ");
 
+    CHECK_THROWS_AS(name128("abc."), name128_type_exception);
+    CHECK_THROWS_AS(name128("ab c"), name128_type_exception);
+    CHECK_THROWS_AS(name128(std::string("ab\0c", 4)), name128_type_exception);
+    CHECK_THROWS_AS(name128("1234567890ABCDEFGHIJKL"), name128_type_exception);
+
+    char buf[21];
+    auto n5 = name128(N128(1234567890ABCDEFGHIJK));
+    CHECK(std::string(buf, n5.to_string(buf)) == "1234567890ABCDEFGHIJK");
+    CHECK(name128().to_string(buf) == 0);
+
     auto CHECK_NUM = [](auto v) {
         auto n1 = name128::from_number(v);
         auto n2 = name128(std::to_string(v));
@@ -369,6 +397,40 @@ TEST_CASE("test_asset", "[types]") {
     CHECK_THROWS_AS(asset::from_string("0.100a S#1"), asset_type_exception);
 }
 
+TEST_CASE("test_fixed_pack", "[types]") {
+    auto a = asset(-12345, symbol(5, 1));
+    auto b = fc::raw::pack(a);
+    CHECK(b.size() == 16);
+    CHECK(fc::raw::pack_size(a) == 16);
+    CHECK(memcmp(b.data(), &a, sizeof(a)) == 0);
+    CHECK(fc::raw::unpack<asset>(b) == a);
+
+    // invalid symbol is still rejected
+    b[15] = 1;
+    CHECK_THROWS_AS(fc::raw::unpack<asset>(b), asset_type_exception);
+
+    auto key = private_key_type::generate().get_public_key();
+    CHECK(fc::raw::pack_size(key) == fc::raw::pack(key).size());
+
+    // unpacking into an existing value
+    auto t1 = token_def(N128(domain), N128(t1), { address(key) });
+    t1.metas.emplace_back(N128(meta), "value", authorizer_ref(key));
+    auto t2 = token_def(N128(domain), N128(t2), {});
+
+    auto t = token_def();
+    extract_db_value(std::string(make_db_value(t1).as_string_view()), t);
+    extract_db_value(std::string(make_db_value(t2).as_string_view()), t);
+    CHECK(t.name == N128(t2));
+    CHECK(t.owner.empty());
+    CHECK(t.metas.empty());
+
+    auto o  = std::optional<std::string>("value");
+    auto ob = fc::raw::pack(std::optional<std::string>());
+    auto ds = fc::datastream<const char*>(ob.data(), ob.size());
+    fc::raw::unpack(ds, o);
+    CHECK(!o.has_value());
+}
+
 TEST_CASE("test_percent_slim", "[types]") {
     auto CHECK_PERCENT_SLIM = [&](auto amount, auto str) {
         auto a = percent_slim(amount);
@@ -411,6 +473,29 @@ TEST_CASE("test_percent_slim", "[types]") {
     CHECK_THROWS_AS(percent_slim::from_string("0.100a"), percent_type_exception);
 }
 
+TEST_CASE("test_percent_slim_floor", "[types]") {
+    // same results as the decimal math used before for bonus
+    auto decimal_floor = [](auto& p, int64_t amount) {
+        return (int64_t)boost::multiprecision::floor(p.value() * real_type(amount));
+    };
+
+    auto rng = std::mt19937_64(42);
+    for(auto i = 0; i < 20000; i++) {
+        auto p      = percent_slim((uint32_t)(rng() % (percent_slim::kMaxAmount + 1)));
+        auto amount = (int64_t)(rng() >> (1 + (i % 4) * 15));
+        INFO(p.raw_value());
+        INFO(amount);
+        CHECK(p.floor_of(amount) == decimal_floor(p, amount));
+        CHECK(p.floor_of(amount) == (int64_t)boost::multiprecision::floor(p.value() * amount));
+    }
+
+    auto one = percent_slim(percent_slim::kMaxAmount);
+    CHECK(one.floor_of(std::numeric_limits<int64_t>::max()) == std::numeric_limits<int64_t>::max());
+    CHECK(percent_slim(1).floor_of(99'999) == 0);
+    CHECK(percent_slim(1).floor_of(100'000) == 1);
+    CHECK(percent_slim(50'000).floor_of(-3) == -2);
+}
+
 
 TEST_CASE("test_make_db_value", "[types]") {
     auto CHECK_MAKE = [](auto sz) {
@@ -426,6 +511,181 @@ TEST_CASE("test_make_db_value", "[types]") {
     }
 }
 
+TEST_CASE("test_property_record", "[types]") {
+    auto p = property {
+        .amount        = 123'456'789,
+        .sym           = symbol(5, 3),
+        .created_at    = 1'550'000'000,
+        .created_index = 42
+    };
+
+    // same bytes as fc::raw
+    auto pr  = property_record(p);
+    auto raw = fc::raw::pack(p);
+    CHECK(raw.size() == property_record::kSize);
+    CHECK(pr.as_string_view() == std::string_view(raw.data(), raw.size()));
+
+    auto p2 = property();
+    property_record::extract(std::string(pr.as_string_view()), p2);
+    CHECK(p2.amount == p.amount);
+    CHECK(p2.sym == p.sym);
+    CHECK(p2.created_at == p.created_at);
+    CHECK(p2.created_index == p.created_index);
+
+    // invalid symbols are still rejected
+    auto bad = std::string(pr.as_string_view());
+    bad[12]  = (char)0xff;
+    CHECK_THROWS(property_record::extract(bad, p2));
+}
+
+TEST_CASE("test_action_cache", "[types]") {
+    auto tf   = transfer();
+    tf.domain = N128(cookie);
+    tf.name   = N128(t1);
+    tf.memo   = "memo";
+
+    auto act = action(N(transfer), N128(cookie), N128(t1), fc::raw::pack(tf));
+    auto& t1 = act.data_as<const transfer&>();
+    CHECK(t1.memo == "memo");
+    CHECK(&act.data_as<const transfer&>() == &t1);
+
+    // copies share the decoded data
+    auto act2 = act;
+    CHECK(&act2.data_as<const transfer&>() == &t1);
+
+    auto act3 = action();
+    act3 = act;
+    CHECK(&act3.data_as<const transfer&>() == &t1);
+
+    CHECK_THROWS_AS(act.data_as<const transferft&>(), action_type_exception);
+
+    // set_data replaces it
+    tf.memo = "memo2";
+    act2.set_data(tf);
+    CHECK(act2.data_as<const transfer&>().memo == "memo2");
+    CHECK(act.data_as<const transfer&>().memo == "memo");
+}
+
+TEST_CASE("test_merkle", "[types]") {
+    CHECK(merkle({}) == digest_type());
+
+    auto ids = std::vector<digest_type>();
+    for(auto i = 0; i < 7; i++) {
+        ids.emplace_back(digest_type::hash(std::to_string(i)));
+    }
+    CHECK(merkle({ ids[0] }) == ids[0]);
+
+    // pairs hashed one by one, the odd one paired with itself
+    auto l01 = digest_type::hash(make_canonical_pair(ids[0], ids[1]));
+    auto l23 = digest_type::hash(make_canonical_pair(ids[2], ids[3]));
+    auto l45 = digest_type::hash(make_canonical_pair(ids[4], ids[5]));
+    auto l66 = digest_type::hash(make_canonical_pair(ids[6], ids[6]));
+    auto l03 = digest_type::hash(make_canonical_pair(l01, l23));
+    auto l46 = digest_type::hash(make_canonical_pair(l45, l66));
+    CHECK(merkle(ids) == digest_type::hash(make_canonical_pair(l03, l46)));
+
+    // wide levels are split into chunks hashed by the workers
+    auto leaves = std::vector<digest_type>();
+    for(auto i = 0; i < 5001; i++) {
+        leaves.emplace_back(digest_type::hash(std::to_string(i)));
+    }
+    auto scheduler = evt::utilities::task_scheduler(2);
+    CHECK(merkle(leaves, scheduler) == merkle(leaves));
+    scheduler.join();
+
+    auto im = incremental_merkle();
+    for(auto i = 0u; i < ids.size(); i++) {
+        im.append(ids[i]);
+    }
+    CHECK(im.get_root() == merkle(ids));
+
+    auto hs = std::vector<digest_type>(2);
+    digest_type::hash_many(ids.front().data(), sizeof(digest_type), 2, hs.data());
+    CHECK(hs[0] == digest_type::hash(ids[0]));
+    CHECK(hs[1] == digest_type::hash(ids[1]));
+}
+
+TEST_CASE("test_recover_keys", "[types]") {
+    auto digest = digest_type::hash(std::string("recover"));
+    auto k1     = private_key_type::generate();
+    auto k2     = private_key_type::generate();
+
+    auto sigs = std::vector<signature_type>{ k1.sign(digest), k2.sign(digest) };
+    sigs.emplace_back(sigs[0]);
+
+    auto keys = std::vector<public_key_type>(sigs.size());
+    public_key_type::recover_keys(sigs.data(), sigs.size(), digest, keys.data());
+    CHECK(keys[0] == k1.get_public_key());
+    CHECK(keys[1] == k2.get_public_key());
+    CHECK(keys[2] == keys[0]);
+    CHECK(public_key_type(sigs[1], digest) == keys[1]);
+}
+
+TEST_CASE("test_recover_keys_r1", "[types]") {
+    auto digest = digest_type::hash(std::string("recover"));
+    auto k1     = private_key_type::generate_r1();
+    auto k2     = private_key_type::generate();
+    auto k3     = private_key_type::generate_r1();
+
+    auto sigs = std::vector<signature_type>{ k1.sign(digest), k2.sign(digest), k3.sign(digest) };
+    sigs.emplace_back(sigs[2]);
+
+    auto keys = std::vector<public_key_type>(sigs.size());
+    public_key_type::recover_keys(sigs.data(), sigs.size(), digest, keys.data());
+    CHECK(keys[0] == k1.get_public_key());
+    CHECK(keys[1] == k2.get_public_key());
+    CHECK(keys[2] == k3.get_public_key());
+    CHECK(keys[3] == keys[2]);
+    CHECK(public_key_type(sigs[0], digest) == keys[0]);
+
+    auto other = digest_type::hash(std::string("other"));
+    CHECK(public_key_type(sigs[0], other) != keys[0]);
+}
+
+TEST_CASE("test_recovery_cache", "[types]") {
+    auto key      = private_key_type::generate();
+    auto chain_id = chain_id_type(std::string("evt"));
+
+    auto trx = signed_transaction();
+    trx.expiration = fc::time_point_sec(fc::time_point::now());
+    trx.sign(key, chain_id);
+
+    auto s1   = transaction::get_recovery_cache_stats();
+    auto keys = trx.get_signature_keys(chain_id);
+    auto s2   = transaction::get_recovery_cache_stats();
+    CHECK(s2.misses == s1.misses + 1);
+    CHECK(trx.get_signature_keys(chain_id) == keys);
+    CHECK(transaction::get_recovery_cache_stats().hits == s2.hits + 1);
+    CHECK(*keys.begin() == key.get_public_key());
+
+    // another chain id signs another digest
+    trx.get_signature_keys(chain_id_type(std::string("evt2")), true);
+    CHECK(transaction::get_recovery_cache_stats().misses == s2.misses + 1);
+}
+
+TEST_CASE("test_packed_transaction_ids", "[types]") {
+    auto key      = private_key_type::generate();
+    auto chain_id = chain_id_type(std::string("evt"));
+
+    auto trx = signed_transaction();
+    trx.expiration = fc::time_point_sec(fc::time_point::now());
+    trx.sign(key, chain_id);
+
+    for(auto c : { packed_transaction::none, packed_transaction::zlib, packed_transaction::zstd }) {
+        auto ptrx = packed_transaction(trx, c);
+        CHECK(ptrx.id() == trx.id());
+        CHECK(ptrx.signed_id() == digest_type::hash(ptrx));
+        CHECK(ptrx.sig_digest(chain_id) == trx.sig_digest(chain_id));
+        CHECK(ptrx.sig_digest(chain_id) == trx.sig_digest(chain_id));
+        CHECK(ptrx.get_signature_keys(chain_id) == trx.get_signature_keys(chain_id));
+
+        auto ptrx2 = fc::raw::unpack<packed_transaction>(fc::raw::pack(ptrx));
+        CHECK(ptrx2.id() == trx.id());
+        CHECK(ptrx2.signed_id() == ptrx.signed_id());
+        CHECK(ptrx2.sig_digest(chain_id_type(std::string("evt2"))) == trx.sig_digest(chain_id_type(std::string("evt2"))));
+    }
+}
+
 TEST_CASE("test_reflector_init", "[types]") {
     auto strx = signed_transaction();
     strx.max_charge = 1000;
@@ -445,3 +705,188 @@ TEST_CASE("test_reflector_init", "[types]") {
     CHECK(trx2.max_charge == 1000);
     CHECK(trx2.actions.size() == 1);
 }
+
+TEST_CASE("test_json_writer", "[types]") {
+    auto pkey = public_key_type(std::string("EVT6bMPrzVm77XSjrTfZxEsbAuWPuJ9hCqGRLEhkTjANWuvWTbwe3"));
+
+    auto domain        = domain_def();
+    domain.name        = N128(.test);
+    domain.creator     = pkey;
+    domain.create_time = fc::time_point_sec(1000);
+
+    domain.issue.name      = N(issue);
+    domain.issue.threshold = 1;
+    domain.issue.authorizers.emplace_back(authorizer_ref(pkey), 1);
+
+    domain.transfer.name      = N(transfer);
+    domain.transfer.threshold = 1;
+    domain.transfer.authorizers.emplace_back(authorizer_ref(N128(.OWNER)), 1);
+
+    domain.manage.name      = N(manage);
+    domain.manage.threshold = 0;
+    domain.metas.emplace_back(N128(key), "quote \" and\nnewline \x01", authorizer_ref(pkey));
+
+    auto w = fc::json_writer();
+    w.write(domain);
+    CHECK(w.str() == fc::json::to_string(fc::variant(domain)));
+
+    // members can be extended with additional fields
+    w.clear();
+    w.begin_object();
+    w.write_members(domain);
+    w.write_member("address", address(N(.domain), domain.name, 0));
+    w.end_object();
+
+    auto mvar = fc::mutable_variant_object(fc::variant(domain));
+    mvar["address"] = address(N(.domain), domain.name, 0);
+    CHECK(w.str() == fc::json::to_string(fc::variant(mvar)));
+
+    w.clear();
+    w.begin_array();
+    w.write(domain.issue);
+    w.write(std::optional<int>());
+    w.write(std::vector<uint32_t>{ 1, 2, 3 });
+    w.end_array();
+    CHECK(w.str() == "[" + fc::json::to_string(fc::variant(domain.issue)) + ",null,[1,2,3]]");
+}
+
+TEST_CASE("test_unpack_members", "[types]") {
+    auto pkey = public_key_type(std::string("EVT6bMPrzVm77XSjrTfZxEsbAuWPuJ9hCqGRLEhkTjANWuvWTbwe3"));
+
+    auto domain        = domain_def();
+    domain.name        = N128(.test);
+    domain.creator     = pkey;
+    domain.create_time = fc::time_point_sec(1000);
+
+    domain.issue.name      = N(issue);
+    domain.issue.threshold = 1;
+    domain.issue.authorizers.emplace_back(authorizer_ref(pkey), 1);
+    domain.metas.emplace_back(N128(key), "value", authorizer_ref(pkey));
+
+    auto data   = fc::raw::pack(domain);
+    auto fields = [](std::string_view name) { return name == "name" || name == "metas"; };
+
+    auto d  = domain_def();
+    auto ds = fc::datastream<const char*>(data.data(), data.size());
+    fc::raw::unpack_members(ds, d, fields);
+    CHECK(ds.remaining() == 0);
+    CHECK(d.name == domain.name);
+    CHECK(d.metas.size() == 1);
+    CHECK(d.issue.authorizers.empty());
+    CHECK(d.create_time == fc::time_point_sec());
+
+    auto w = fc::json_writer();
+    w.begin_object();
+    w.write_members(d, fields);
+    w.end_object();
+
+    auto mvar = fc::mutable_variant_object();
+    mvar["name"]  = domain.name;
+    mvar["metas"] = domain.metas;
+    CHECK(w.str() == fc::json::to_string(fc::variant(mvar)));
+
+    ds = fc::datastream<const char*>(data.data(), data.size());
+    fc::raw::skip<domain_def>(ds);
+    CHECK(ds.remaining() == 0);
+
+    ds = fc::datastream<const char*>(data.data(), data.size() - 1);
+    CHECK_THROWS(fc::raw::unpack_members(ds, d, fields));
+}
+
+TEST_CASE("test_json_minify", "[types]") {
+    auto CHECK_MINIFY = [](auto str) {
+        CHECK(fc::json::minify(str) == fc::json::to_string(fc::json::from_string(str)));
+    };
+
+    CHECK_MINIFY(R"({ "name": "test", "threshold": 1, "nodes": [ { "weight": -3 }, 1.5, null, true ] })");
+    CHECK_MINIFY(R"([ "quote \" and\nnewline", 18446744073709551615, -9223372036854775808 ])");
+    CHECK_MINIFY("{}");
+
+    CHECK_THROWS_AS(fc::json::minify(R"({ "name": )"), fc::parse_error_exception);
+}
+
+TEST_CASE("test_base58", "[types]") {
+    auto CHECK_BASE58 = [](auto bin, auto str) {
+        auto data = std::vector<char>(bin.begin(), bin.end());
+        CHECK(fc::to_base58(data) == str);
+        CHECK(fc::from_base58(str) == data);
+    };
+
+    CHECK_BASE58(std::string(), "");
+    CHECK_BASE58(std::string("\0\0", 2), "11");
+    CHECK_BASE58(std::string("\0\x01", 2), "12");
+    CHECK_BASE58(std::string("hello world"), "StV1DL6CwTryKyV");
+    CHECK_BASE58(std::string("\0\x28\x7f\xb4\xcd", 5), "11233QC4");
+    CHECK_BASE58(std::string("\xff\xff\xff\xff\xff", 5), "VtB5VXc");
+
+    CHECK(fc::from_base58(" 12 ") == std::vector<char>{ 0, 1 });
+    CHECK_THROWS_AS(fc::from_base58("0OIl"), fc::parse_error_exception);
+
+    auto key = private_key_type::generate().get_public_key();
+    CHECK(public_key_type((std::string)key) == key);
+    CHECK((std::string)key == (std::string)key);
+}
+
+TEST_CASE("test_action_costs", "[types]") {
+    auto exec_ctx = evt_execution_context_mock();
+    auto tracker  = action_cost_tracker();
+
+    auto make_trace = [](auto name, auto us, auto reads) {
+        auto at      = action_trace();
+        at.act.name  = name;
+        at.elapsed   = fc::microseconds(us);
+        at.db_reads  = reads;
+        at.db_writes = 1;
+        return at;
+    };
+
+    auto trace = transaction_trace();
+    trace.action_traces.emplace_back(make_trace(N(newdomain), 10, 2));
+    trace.action_traces.emplace_back(make_trace(N(issuetoken), 100, 3));
+    trace.action_traces.emplace_back(make_trace(N(issuetoken), 3000, 5));
+    tracker.record(trace, exec_ctx);
+
+    auto costs = tracker.get_costs();
+    REQUIRE(costs.size() == 2);
+
+    auto& it = (costs[0].name == N(issuetoken)) ? costs[0] : costs[1];
+    CHECK(it.version == exec_ctx.get_current_version(N(issuetoken)));
+    CHECK(it.count == 2);
+    CHECK(it.sum_us == 3100);
+    CHECK(it.max_us == 3000);
+    CHECK(it.p50_us == 128);
+    CHECK(it.p99_us == 3000);
+    CHECK(it.db_reads == 8);
+    CHECK(it.db_writes == 2);
+
+    tracker.reset();
+    CHECK(tracker.get_costs().empty());
+}
+
+TEST_CASE("test_lazy_exception_message", "[types]") {
+    auto caught = std::optional<fc::exception>();
+    {
+        auto buf = std::string("balance");
+        try {
+            EVT_THROW2(balance_exception, "{} of {} is not enough", buf.c_str(), 10);
+        }
+        catch(balance_exception& e) {
+            caught = e;
+        }
+        // arguments are kept by value, the string pointed to is changed before the message is read
+        buf.assign(buf.size(), '-');
+    }
+    REQUIRE(caught.has_value());
+
+    auto& log = caught->get_log();
+    REQUIRE(log.size() == 1);
+    CHECK(log[0].get_format() == "balance of 10 is not enough");
+    CHECK(caught->top_message() == "balance of 10 is not enough");
+
+    // copies share the message formatted already
+    auto copy = *caught;
+    CHECK(&copy.get_log()[0].get_format() == &log[0].get_format());
+
+    auto v = fc::variant(log[0]);
+    CHECK(v["format"].as_string() == "balance of 10 is not enough");
+}